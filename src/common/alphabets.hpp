@@ -20,7 +20,7 @@
  * @ingroup common
  * @author  Patrick Flick
  * @brief   Declares all common alphabets, including DNA, DNA5, RNA, RNA5
- *          AA (IUPAC), DNA_IUPAC, and CUSTOM
+ *          AA (IUPAC), AA_MURPHY10, DNA_IUPAC, and CUSTOM
  *
  */
 #ifndef BLISS_COMMON_ALPHABETS_H
@@ -33,7 +33,6 @@
 // TODO add the following alphabets:
 // D/RNA
 // D/RNA5
-// AA (IUPAC amino acid.)
 // CUSTOM (no definition right now)
 
 // TODO add function calls for auto generation into documentation
@@ -738,6 +737,167 @@ namespace bliss
       template <typename DUMMY>
       constexpr std::array<uint8_t, DNA16_T<DUMMY>::SIZE> DNA16_T<DUMMY>::TO_COMPLEMENT;
 
+      /**
+       * @brief amino acid alphabet:  the 20 standard residues, X, the ambiguity codes B, Z, J, selenocysteine U,
+       *        pyrrolysine O, and the gap ('-' or '.').  5 bits per character, instead of 8 for ASCII.
+       * @details  the standard residues are numbered in the order of their 1 letter codes, so k-mer order of the standard
+       *        residues is lexicographic.  everything that is not a letter or a gap, including the stop '*', is X.
+       *        proteins have no complement:  to_complement is the identity, and reverse_complement is reverse.
+       */
+      template <typename DUMMY = void>
+      struct AA_T : BaseAlphabetChar
+      {
+          // This should make char and AA useable interchangebly
+          AA_T& operator=(const CharType& c){ BaseAlphabetChar::operator=(c); return *this;}
+          AA_T(const CharType& c) : BaseAlphabetChar(c) {}
+          AA_T() : BaseAlphabetChar() {}
+
+          /// alphabet size
+        static constexpr AlphabetSizeType SIZE = 32;
+
+
+        /// ascii to alphabet lookup table
+        static constexpr std::array<uint8_t, 256> FROM_ASCII =
+        {{
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          //                                                    '-' '.'
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 26, 26, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          //    'A' 'B' 'C' 'D' 'E' 'F' 'G' 'H' 'I' 'J' 'K' 'L' 'M' 'N' 'O'
+          20,  0, 21,  1,  2,  3,  4,  5,  6,  7, 23,  8,  9, 10, 11, 25,
+          //'P' 'Q' 'R' 'S' 'T' 'U' 'V' 'W' 'X' 'Y' 'Z'
+          12, 13, 14, 15, 16, 24, 17, 18, 20, 19, 22, 20, 20, 20, 20, 20,
+          //    'a' 'b' 'c' 'd' 'e' 'f' 'g' 'h' 'i' 'j' 'k' 'l' 'm' 'n' 'o'
+          20,  0, 21,  1,  2,  3,  4,  5,  6,  7, 23,  8,  9, 10, 11, 25,
+          //'p' 'q' 'r' 's' 't' 'u' 'v' 'w' 'x' 'y' 'z'
+          12, 13, 14, 15, 16, 24, 17, 18, 20, 19, 22, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+          20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20
+        }};
+
+        /// alphabet to ascii lookup table
+        static constexpr std::array<char, SIZE> TO_ASCII =
+        {{
+          'A', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'K', 'L',   // = 0 - 9
+          'M', 'N', 'P', 'Q', 'R', 'S', 'T', 'V', 'W', 'Y',   // = 10 - 19
+          'X',  // = 20  unknown
+          'B',  // = 21  D or N
+          'Z',  // = 22  E or Q
+          'J',  // = 23  I or L
+          'U',  // = 24  selenocysteine
+          'O',  // = 25  pyrrolysine
+          '.',  // = 26  gap.  choose . instead of -
+          '?', '?', '?', '?', '?'   // = 27 - 31  unused
+        }};
+
+        /// complement lookup table.  identity.
+        static constexpr std::array<uint8_t, SIZE> TO_COMPLEMENT =
+        {{
+           0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+          16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
+        }};
+
+        static inline uint8_t to_complement(uint8_t const & x) {
+        	return x;
+        }
+      };
+
+      template <typename DUMMY>
+      constexpr std::array<uint8_t, 256> AA_T<DUMMY>::FROM_ASCII;
+      template <typename DUMMY>
+      constexpr std::array<char, AA_T<DUMMY>::SIZE> AA_T<DUMMY>::TO_ASCII;
+      template <typename DUMMY>
+      constexpr std::array<uint8_t, AA_T<DUMMY>::SIZE> AA_T<DUMMY>::TO_COMPLEMENT;
+
+
+      /**
+       * @brief reduced amino acid alphabet of Murphy, Wallqvist and Levy (2000), 10 groups:  LVIM, C, A, G, ST, P, FYW,
+       *        EDNQ, KR, H.  4 bits per character, for screening where substitutions within a group should match.
+       * @details  a group is written as its first letter in alphabetical order.  B and Z map to E (EDNQ), J to L (LVIM),
+       *        U to C and O to K.  X is unknown, and everything that is not a letter or a gap is X.  no complement.
+       */
+      template <typename DUMMY = void>
+      struct AA_MURPHY10_T : BaseAlphabetChar
+      {
+          // This should make char and AA_MURPHY10 useable interchangebly
+          AA_MURPHY10_T& operator=(const CharType& c){ BaseAlphabetChar::operator=(c); return *this;}
+          AA_MURPHY10_T(const CharType& c) : BaseAlphabetChar(c) {}
+          AA_MURPHY10_T() : BaseAlphabetChar() {}
+
+          /// alphabet size
+        static constexpr AlphabetSizeType SIZE = 16;
+
+
+        /// ascii to alphabet lookup table
+        static constexpr std::array<uint8_t, 256> FROM_ASCII =
+        {{
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          //                                                    '-' '.'
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          //    'A' 'B' 'C' 'D' 'E' 'F' 'G' 'H' 'I' 'J' 'K' 'L' 'M' 'N' 'O'
+          10,  0,  2,  1,  2,  2,  3,  4,  5,  7,  7,  6,  7,  7,  2,  6,
+          //'P' 'Q' 'R' 'S' 'T' 'U' 'V' 'W' 'X' 'Y' 'Z'
+           8,  2,  6,  9,  9,  1,  7,  3, 10,  3,  2, 10, 10, 10, 10, 10,
+          //    'a' 'b' 'c' 'd' 'e' 'f' 'g' 'h' 'i' 'j' 'k' 'l' 'm' 'n' 'o'
+          10,  0,  2,  1,  2,  2,  3,  4,  5,  7,  7,  6,  7,  7,  2,  6,
+          //'p' 'q' 'r' 's' 't' 'u' 'v' 'w' 'x' 'y' 'z'
+           8,  2,  6,  9,  9,  1,  7,  3, 10,  3,  2, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+          10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10
+        }};
+
+        /// alphabet to ascii lookup table
+        static constexpr std::array<char, SIZE> TO_ASCII =
+        {{
+          'A',  // = 0   A
+          'C',  // = 1   C, U
+          'E',  // = 2   E, D, N, Q, B, Z
+          'F',  // = 3   F, Y, W
+          'G',  // = 4   G
+          'H',  // = 5   H
+          'K',  // = 6   K, R, O
+          'L',  // = 7   L, V, I, M, J
+          'P',  // = 8   P
+          'S',  // = 9   S, T
+          'X',  // = 10  unknown
+          '.',  // = 11  gap.  choose . instead of -
+          '?', '?', '?', '?'   // = 12 - 15  unused
+        }};
+
+        /// complement lookup table.  identity.
+        static constexpr std::array<uint8_t, SIZE> TO_COMPLEMENT =
+        {{
+          0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+        }};
+
+        static inline uint8_t to_complement(uint8_t const & x) {
+        	return x;
+        }
+      };
+
+      template <typename DUMMY>
+      constexpr std::array<uint8_t, 256> AA_MURPHY10_T<DUMMY>::FROM_ASCII;
+      template <typename DUMMY>
+      constexpr std::array<char, AA_MURPHY10_T<DUMMY>::SIZE> AA_MURPHY10_T<DUMMY>::TO_ASCII;
+      template <typename DUMMY>
+      constexpr std::array<uint8_t, AA_MURPHY10_T<DUMMY>::SIZE> AA_MURPHY10_T<DUMMY>::TO_COMPLEMENT;
+
+
 
     } // namespace alphabet
 
@@ -750,6 +910,8 @@ namespace bliss
       using RNA6 = ::bliss::common::alphabet::RNA6_T<>;
       using DNA16 = ::bliss::common::alphabet::DNA16_T<>;
       using DNA_IUPAC = ::bliss::common::alphabet::DNA_IUPAC_T<>;
+      using AA = ::bliss::common::alphabet::AA_T<>;
+      using AA_MURPHY10 = ::bliss::common::alphabet::AA_MURPHY10_T<>;
 
 
   } // namespace common
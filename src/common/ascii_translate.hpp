@@ -0,0 +1,279 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ascii_translate.hpp
+ * @ingroup common
+ * @brief   bulk translation of an ascii character array into alphabet values.
+ * @details the element-wise ASCII2 functor does a table lookup per character.  the functors here
+ *          translate a whole contiguous array.  for DNA, SSSE3 or AVX2 shuffle is used to look up
+ *          16 or 32 characters at a time, indexed by the low nibble, then the upper nibble is verified
+ *          so that the result is identical to the DNA::FROM_ASCII table (non-ACGT maps to 0).
+ *          the DNA translation can also report the non-ACGT (e.g. N) positions as a bit mask, in the same pass.
+ *          DNA5/DNA6, DNA16, DNA_IUPAC, AA and AA_MURPHY10 look up letters by their low 5 bits with 2 shuffles, since their tables
+ *          are case insensitive, all non-letters except the gap characters '-' and '.' share 1 value.
+ *          other alphabets fall back to the lookup table.
+ *          with USE_SIMD_DISPATCH, the SSSE3 and AVX2 kernels are chosen at run time (see utils/cpu_features.hpp).
+ *
+ *          input and output may be the same array (in place translation).
+ */
+#ifndef SRC_COMMON_ASCII_TRANSLATE_HPP_
+#define SRC_COMMON_ASCII_TRANSLATE_HPP_
+
+#include <cstdint>       // uint8_t
+#include <cstddef>       // size_t
+#include <algorithm>     // fill
+
+#include "bliss-config.hpp"
+#include "common/alphabets.hpp"
+#include "utils/cpu_features.hpp"   // x86intrin.h, and runtime dispatch.
+
+#if defined __GNUC__ && __GNUC__>=6
+// disable __m128i and __m256i ignored attribute warning in gcc
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
+namespace bliss
+{
+  namespace common
+  {
+
+    /// bulk ascii to alphabet value conversion, using the alphabet's lookup table.
+    template <typename Alphabet>
+    struct ASCII2Bulk {
+        void operator()(unsigned char const * in, size_t const & count, uint8_t * out) const {
+          for (size_t i = 0; i < count; ++i) {
+            out[i] = Alphabet::FROM_ASCII[in[i]];
+          }
+        }
+    };
+
+
+    namespace detail {
+
+      // DNA lookup is by low nibble:  'a' = 0x?1, 'c' = 0x?3, 't' = 0x?4, 'g' = 0x?7.
+      // the character itself is also looked up, and compared to input with lower case bit set.
+      // entries not in ACGT have 0 as the character, which never matches since case bit is set.
+      // each kernel translates from position i, in full vectors only, and returns where it stopped.
+      // i is a multiple of the vector width, so a vector's non_acgt bits do not straddle 2 mask words.
+
+#if defined(BL_KERNEL_AVX2)
+      BL_TARGET("avx2")
+      inline size_t dna_from_ascii_avx2(unsigned char const * in, size_t const & count, uint8_t * out, uint64_t * non_acgt, size_t i) {
+        __m256i const lo_mask = _mm256_set1_epi8(0x0F);
+        __m256i const case_bit = _mm256_set1_epi8(0x20);
+        // shuffle is per 128 bit lane, so the table is replicated.
+        __m256i const code_lut = _mm256_setr_epi8(0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                  0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0);
+        __m256i const char_lut = _mm256_setr_epi8(0, 'a', 0, 'c', 't', 0, 0, 'g', 0, 0, 0, 0, 0, 0, 0, 0,
+                                                  0, 'a', 0, 'c', 't', 0, 0, 'g', 0, 0, 0, 0, 0, 0, 0, 0);
+        __m256i v, idx, valid;
+        for (; (i + 32) <= count; i += 32) {
+          v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+          idx = _mm256_and_si256(v, lo_mask);
+          valid = _mm256_cmpeq_epi8(_mm256_or_si256(v, case_bit), _mm256_shuffle_epi8(char_lut, idx));
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                              _mm256_and_si256(_mm256_shuffle_epi8(code_lut, idx), valid));
+          if (non_acgt) non_acgt[i >> 6] |= static_cast<uint64_t>(~static_cast<uint32_t>(_mm256_movemask_epi8(valid))) << (i & 63);
+        }
+        return i;
+      }
+#endif
+
+#if defined(BL_KERNEL_SSSE3)
+      BL_TARGET("ssse3")
+      inline size_t dna_from_ascii_ssse3(unsigned char const * in, size_t const & count, uint8_t * out, uint64_t * non_acgt, size_t i) {
+        __m128i const lo_mask = _mm_set1_epi8(0x0F);
+        __m128i const case_bit = _mm_set1_epi8(0x20);
+        __m128i const code_lut = _mm_setr_epi8(0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0);
+        __m128i const char_lut = _mm_setr_epi8(0, 'a', 0, 'c', 't', 0, 0, 'g', 0, 0, 0, 0, 0, 0, 0, 0);
+        __m128i v, idx, valid;
+        for (; (i + 16) <= count; i += 16) {
+          v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+          idx = _mm_and_si128(v, lo_mask);
+          valid = _mm_cmpeq_epi8(_mm_or_si128(v, case_bit), _mm_shuffle_epi8(char_lut, idx));
+          _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                           _mm_and_si128(_mm_shuffle_epi8(code_lut, idx), valid));
+          if (non_acgt) non_acgt[i >> 6] |= static_cast<uint64_t>(~_mm_movemask_epi8(valid) & 0xFFFF) << (i & 63);
+        }
+        return i;
+      }
+#endif
+
+      /// true if c is not one of ACGTacgt.
+      inline bool is_non_acgt(unsigned char const c) {
+        unsigned char const l = c | 0x20;
+        return (l != 'a') && (l != 'c') && (l != 'g') && (l != 't');
+      }
+
+      // letter lookup for alphabets with case insensitive tables:  letters (0x40-0x7F) are looked up by the low 5 bits
+      // in the table entries for 0x40-0x5F, as 2 16 entry shuffles selected by bit 4.  other characters take the value
+      // of '\0', except '-' and '.'.
+
+#if defined(BL_KERNEL_AVX2)
+      template <typename Alphabet>
+      BL_TARGET("avx2")
+      size_t letters_from_ascii_avx2(unsigned char const * in, size_t const & count, uint8_t * out, size_t i) {
+        __m128i const lo128 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Alphabet::FROM_ASCII.data() + 0x40));
+        __m128i const hi128 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Alphabet::FROM_ASCII.data() + 0x50));
+        __m256i const lut_lo = _mm256_inserti128_si256(_mm256_castsi128_si256(lo128), lo128, 1);
+        __m256i const lut_hi = _mm256_inserti128_si256(_mm256_castsi128_si256(hi128), hi128, 1);
+        __m256i const lo_mask = _mm256_set1_epi8(0x0F);
+        __m256i const bit4 = _mm256_set1_epi8(0x10);
+        __m256i const top_mask = _mm256_set1_epi8(static_cast<char>(0xC0));
+        __m256i const letter_bits = _mm256_set1_epi8(0x40);
+        __m256i const other = _mm256_set1_epi8(static_cast<char>(Alphabet::FROM_ASCII[0]));
+        __m256i const dash = _mm256_set1_epi8('-');
+        __m256i const dash_val = _mm256_set1_epi8(static_cast<char>(Alphabet::FROM_ASCII['-']));
+        __m256i const dot = _mm256_set1_epi8('.');
+        __m256i const dot_val = _mm256_set1_epi8(static_cast<char>(Alphabet::FROM_ASCII['.']));
+        __m256i v, idx, r, m;
+        for (; (i + 32) <= count; i += 32) {
+          v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+          idx = _mm256_and_si256(v, lo_mask);
+          r = _mm256_blendv_epi8(_mm256_shuffle_epi8(lut_lo, idx), _mm256_shuffle_epi8(lut_hi, idx),
+                                 _mm256_cmpeq_epi8(_mm256_and_si256(v, bit4), bit4));
+          m = _mm256_cmpeq_epi8(_mm256_and_si256(v, top_mask), letter_bits);
+          r = _mm256_blendv_epi8(other, r, m);
+          r = _mm256_blendv_epi8(r, dash_val, _mm256_cmpeq_epi8(v, dash));
+          r = _mm256_blendv_epi8(r, dot_val, _mm256_cmpeq_epi8(v, dot));
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+        }
+        return i;
+      }
+#endif
+
+#if defined(BL_KERNEL_SSSE3)
+      /// (a & m) | (b & ~m).  blendv is SSE4.1.
+      BL_TARGET("ssse3")
+      inline __m128i select_ssse3(__m128i const & m, __m128i const & a, __m128i const & b) {
+        return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+      }
+
+      template <typename Alphabet>
+      BL_TARGET("ssse3")
+      size_t letters_from_ascii_ssse3(unsigned char const * in, size_t const & count, uint8_t * out, size_t i) {
+        __m128i const lut_lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Alphabet::FROM_ASCII.data() + 0x40));
+        __m128i const lut_hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Alphabet::FROM_ASCII.data() + 0x50));
+        __m128i const lo_mask = _mm_set1_epi8(0x0F);
+        __m128i const bit4 = _mm_set1_epi8(0x10);
+        __m128i const top_mask = _mm_set1_epi8(static_cast<char>(0xC0));
+        __m128i const letter_bits = _mm_set1_epi8(0x40);
+        __m128i const other = _mm_set1_epi8(static_cast<char>(Alphabet::FROM_ASCII[0]));
+        __m128i const dash = _mm_set1_epi8('-');
+        __m128i const dash_val = _mm_set1_epi8(static_cast<char>(Alphabet::FROM_ASCII['-']));
+        __m128i const dot = _mm_set1_epi8('.');
+        __m128i const dot_val = _mm_set1_epi8(static_cast<char>(Alphabet::FROM_ASCII['.']));
+        __m128i v, idx, r;
+        for (; (i + 16) <= count; i += 16) {
+          v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+          idx = _mm_and_si128(v, lo_mask);
+          r = select_ssse3(_mm_cmpeq_epi8(_mm_and_si128(v, bit4), bit4),
+                           _mm_shuffle_epi8(lut_hi, idx), _mm_shuffle_epi8(lut_lo, idx));
+          r = select_ssse3(_mm_cmpeq_epi8(_mm_and_si128(v, top_mask), letter_bits), r, other);
+          r = select_ssse3(_mm_cmpeq_epi8(v, dash), dash_val, r);
+          r = select_ssse3(_mm_cmpeq_epi8(v, dot), dot_val, r);
+          _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+        }
+        return i;
+      }
+#endif
+
+      /// bulk conversion for alphabets with case insensitive tables.  see letters_from_ascii_* above.
+      template <typename Alphabet>
+      struct LettersFromASCII {
+          void operator()(unsigned char const * in, size_t const & count, uint8_t * out) const {
+            size_t i = 0;
+
+#if defined(BL_KERNEL_AVX2)
+            if (::bliss::utils::cpu::use_avx2()) i = letters_from_ascii_avx2<Alphabet>(in, count, out, i);
+#endif
+#if defined(BL_KERNEL_SSSE3)
+            if (::bliss::utils::cpu::use_ssse3()) i = letters_from_ascii_ssse3<Alphabet>(in, count, out, i);
+#endif
+            // remainder
+            for (; i < count; ++i) {
+              out[i] = Alphabet::FROM_ASCII[in[i]];
+            }
+          }
+      };
+
+    } // namespace detail
+
+
+    /// bulk ascii to DNA conversion.  A/a=0, C/c=1, G/g=2, T/t=3, everything else 0, same as DNA::FROM_ASCII.
+    template <>
+    struct ASCII2Bulk<::bliss::common::DNA> {
+        void operator()(unsigned char const * in, size_t const & count, uint8_t * out) const {
+          translate(in, count, out, nullptr);
+        }
+
+        /**
+         * @brief translate, and set bit i of non_acgt if in[i] is not one of ACGTacgt, e.g. N.
+         * @param non_acgt  (count + 63) / 64 words, bit i % 64 of word i / 64 for position i.  overwritten.
+         */
+        void operator()(unsigned char const * in, size_t const & count, uint8_t * out, uint64_t * non_acgt) const {
+          ::std::fill(non_acgt, non_acgt + ((count + 63) >> 6), 0ULL);
+          translate(in, count, out, non_acgt);
+        }
+
+      protected:
+        void translate(unsigned char const * in, size_t const & count, uint8_t * out, uint64_t * non_acgt) const {
+          size_t i = 0;
+
+#if defined(BL_KERNEL_AVX2)
+          if (::bliss::utils::cpu::use_avx2()) i = detail::dna_from_ascii_avx2(in, count, out, non_acgt, i);
+#endif
+#if defined(BL_KERNEL_SSSE3)
+          if (::bliss::utils::cpu::use_ssse3()) i = detail::dna_from_ascii_ssse3(in, count, out, non_acgt, i);
+#endif
+          // remainder
+          for (; i < count; ++i) {
+            if (non_acgt && detail::is_non_acgt(in[i])) non_acgt[i >> 6] |= 1ULL << (i & 63);
+            out[i] = ::bliss::common::DNA::FROM_ASCII[in[i]];
+          }
+        }
+    };
+
+    /// bulk ascii to DNA5/DNA6 conversion, same as DNA6::FROM_ASCII.
+    template <>
+    struct ASCII2Bulk<::bliss::common::DNA6> : public detail::LettersFromASCII<::bliss::common::DNA6> {};
+
+    /// bulk ascii to DNA16 conversion, same as DNA16::FROM_ASCII.
+    template <>
+    struct ASCII2Bulk<::bliss::common::DNA16> : public detail::LettersFromASCII<::bliss::common::DNA16> {};
+
+    /// bulk ascii to DNA_IUPAC conversion, same as DNA_IUPAC::FROM_ASCII.
+    template <>
+    struct ASCII2Bulk<::bliss::common::DNA_IUPAC> : public detail::LettersFromASCII<::bliss::common::DNA_IUPAC> {};
+
+    /// bulk ascii to AA conversion, same as AA::FROM_ASCII.
+    template <>
+    struct ASCII2Bulk<::bliss::common::AA> : public detail::LettersFromASCII<::bliss::common::AA> {};
+
+    /// bulk ascii to AA_MURPHY10 conversion, same as AA_MURPHY10::FROM_ASCII.
+    template <>
+    struct ASCII2Bulk<::bliss::common::AA_MURPHY10> : public detail::LettersFromASCII<::bliss::common::AA_MURPHY10> {};
+
+  } // namespace common
+} // namespace bliss
+
+#if defined __GNUC__ && __GNUC__>=6
+  #pragma GCC diagnostic pop
+#endif
+
+#endif /* SRC_COMMON_ASCII_TRANSLATE_HPP_ */
@@ -173,6 +173,25 @@ namespace bliss
 
     using MACH_WORD_TYPE = size_t;
 
+    /// storage layouts with straight line implementations for shifts and ordered comparisons.
+    /// 1 word (k <= 32 for DNA in 64 bit words), 2 64-bit words as 1 128 bit integer (k <= 64), or general.
+    static constexpr int GENERAL_WORDS = 0;
+    static constexpr int SINGLE_WORD = 1;
+    static constexpr int DOUBLE_WORD = 2;
+    static constexpr int wordLayout = (nWords == 1) ? SINGLE_WORD :
+#if defined(__SIZEOF_INT128__)
+        (((nWords == 2) && ::std::is_same<WORD_TYPE, uint64_t>::value) ? DOUBLE_WORD : GENERAL_WORDS);
+#else
+        GENERAL_WORDS;
+#endif
+    using word_layout = ::std::integral_constant<int, wordLayout>;
+
+    /// SIMD type for the bitwise operators and fixed shifts.  2 word k-mers stay in general purpose registers: a 128 bit store
+    /// followed by word reads (shifts, hashing, getPrefix) stalls on store forwarding.
+    using BitopSIMD = typename ::std::conditional<(wordLayout == DOUBLE_WORD),
+        ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes, ::bliss::utils::bit_ops::BITREV_SWAR>,
+        ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes> >::type;
+
     /// The actual storage of the k-mer
     WORD_TYPE data[nWords]; // alignas is not compatible with mxx datatype stuff - causes size of std::pair to increase greatly because alignment of elements is based on most resitrictive element.
   
@@ -790,7 +809,7 @@ namespace bliss
     KMER_INLINE bool operator==(const Kmer& rhs) const
     {
       // MUST COMPARE ALL BITS, INCLUDING UNUSED
-    	return ::bliss::utils::bit_ops::equal<WORD_TYPE, nWords>(data, rhs.data);
+      return do_equal(rhs, word_layout());
     }
 
     /**
@@ -819,7 +838,7 @@ namespace bliss
      */
     KMER_INLINE bool operator<(const Kmer& rhs) const
     {
-    	return ::bliss::utils::bit_ops::less<WORD_TYPE, nWords>(data, rhs.data);
+      return do_less(rhs, word_layout());
     }
   
     /**
@@ -861,7 +880,7 @@ namespace bliss
   
 
     KMER_INLINE int8_t compare(const Kmer& rhs) const {
-      return ::bliss::utils::bit_ops::compare<WORD_TYPE, nWords>(data, rhs.data);
+      return do_compare(rhs, word_layout());
     }
 
     /* bit operators */
@@ -871,7 +890,7 @@ namespace bliss
      */
     KMER_INLINE Kmer& operator^=(const Kmer& rhs)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::bit_xor<SIMD, WORD_TYPE, nWords>(data, data, rhs.data);
       // synchronization fence to ensure self modification (data) is visible to subsequent operations, particularly for clear linux's cflags.
       std::atomic_thread_fence(std::memory_order_relaxed);
@@ -884,7 +903,7 @@ namespace bliss
     KMER_INLINE Kmer operator^(const Kmer& rhs) const
     {
       Kmer result(false);
-		using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+		using SIMD = BitopSIMD;
 		::bliss::utils::bit_ops::bit_xor<SIMD, WORD_TYPE, nWords>(result.data, data, rhs.data);
 		result.do_sanitize();
       return result;
@@ -892,7 +911,7 @@ namespace bliss
 
     KMER_INLINE void bit_xor(const Kmer& lhs, const Kmer& rhs)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::bit_xor<SIMD, WORD_TYPE, nWords>(data, lhs.data, rhs.data);
     	do_sanitize();
     }
@@ -902,7 +921,7 @@ namespace bliss
      */
     KMER_INLINE Kmer& operator&=(const Kmer& rhs)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::bit_and<SIMD, WORD_TYPE, nWords>(data, data, rhs.data);
       // synchronization fence to ensure self modification (data) is visible to subsequent operations, particularly for clear linux's cflags.
       std::atomic_thread_fence(std::memory_order_relaxed);
@@ -915,7 +934,7 @@ namespace bliss
     KMER_INLINE Kmer operator&(const Kmer& rhs) const
     {
       Kmer result = *this;
-		using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+		using SIMD = BitopSIMD;
 		::bliss::utils::bit_ops::bit_and<SIMD, WORD_TYPE, nWords>(result.data, data, rhs.data);
 		result.do_sanitize();
       return result;
@@ -923,7 +942,7 @@ namespace bliss
 
     KMER_INLINE void bit_and(const Kmer& lhs, const Kmer& rhs)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::bit_and<SIMD, WORD_TYPE, nWords>(data, lhs.data, rhs.data);
     	do_sanitize();
     }
@@ -934,7 +953,7 @@ namespace bliss
      */
     KMER_INLINE Kmer& operator|=(const Kmer& rhs)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::bit_or<SIMD, WORD_TYPE, nWords>(data, data, rhs.data);
       // synchronization fence to ensure self modification (data) is visible to subsequent operations, particularly for clear linux's cflags.
       std::atomic_thread_fence(std::memory_order_relaxed);
@@ -947,7 +966,7 @@ namespace bliss
     KMER_INLINE Kmer operator|(const Kmer& rhs) const
     {
       Kmer result(false);
-		using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+		using SIMD = BitopSIMD;
 		::bliss::utils::bit_ops::bit_or<SIMD, WORD_TYPE, nWords>(result.data, data, rhs.data);
 		result.do_sanitize();
       return result;
@@ -955,7 +974,7 @@ namespace bliss
 
     KMER_INLINE void bit_or(const Kmer& lhs, const Kmer& rhs)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::bit_or<SIMD, WORD_TYPE, nWords>(data, lhs.data, rhs.data);
     	do_sanitize();
     }
@@ -1001,7 +1020,7 @@ namespace bliss
     template <uint16_t shift = bitsPerChar>
     KMER_INLINE void left_shift_bits()
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::left_shift<SIMD, shift, WORD_TYPE, nWords>(data, data);
       // synchronization fence to ensure self modification (data) is visible to subsequent operations, particularly for clear linux's cflags.
       std::atomic_thread_fence(std::memory_order_relaxed);
@@ -1010,7 +1029,7 @@ namespace bliss
     template <uint16_t shift = bitsPerChar>
     KMER_INLINE void left_shift_bits_copy(Kmer const & src)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::left_shift<SIMD, shift, WORD_TYPE, nWords>(data, src.data);
     	do_sanitize();
     }
@@ -1057,7 +1076,7 @@ namespace bliss
     template <uint16_t shift = bitsPerChar>
     KMER_INLINE void right_shift_bits()
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::right_shift<SIMD, shift, WORD_TYPE, nWords>(data, data);
       // synchronization fence to ensure self modification (data) is visible to subsequent operations, particularly for clear linux's cflags.
       std::atomic_thread_fence(std::memory_order_relaxed);
@@ -1065,7 +1084,7 @@ namespace bliss
     template <uint16_t shift = bitsPerChar>
     KMER_INLINE void right_shift_bits_copy(Kmer const & src)
     {
-    	using SIMD = ::bliss::utils::bit_ops::BITREV_AUTO_AGGRESSIVE<nAllocBytes>;
+    	using SIMD = BitopSIMD;
     	::bliss::utils::bit_ops::right_shift<SIMD, shift, WORD_TYPE, nWords>(data, src.data);
     }
   
@@ -1440,9 +1459,14 @@ namespace bliss
       // TODO: replace by single shift operation
       this->template right_shift_bits<shift>();
 
-      // add character to least significant end (requires least shifting)
-      data[nWords - 1] |= (static_cast<WORD_TYPE>(w) &
-          getLeastSignificantBitsMask<WORD_TYPE>(shift)) << (bitstream::invPadBits - shift);
+      // add character to most significant end.  a character can span the last 2 words when bitsPerChar does not
+      // divide the word size, e.g. 5 bit amino acids in 8 bit words.
+      if (bitstream::invPadBits >= shift) {
+        data[nWords - 1] |= (static_cast<WORD_TYPE>(w) &
+            getLeastSignificantBitsMask<WORD_TYPE>(shift)) << ((bitstream::invPadBits >= shift) ? (bitstream::invPadBits - shift) : 0);
+      } else {
+        this->setBitsAtPos(w, nBits - shift, shift);
+      }
 
       std::atomic_thread_fence(std::memory_order_relaxed);
     }
@@ -1471,14 +1495,134 @@ namespace bliss
 
     }
   
+    /// general layouts in up to 64 words of 64 bits compare through word_diff_mask instead of a branch per word.
+    using masked_compare = ::std::integral_constant<bool, ::std::is_same<WORD_TYPE, uint64_t>::value && (nWords <= 64)>;
+
+    /// bit i is set if word i differs from rhs.  with AVX2, 4 words per compare and movemask.
+    KMER_INLINE uint64_t word_diff_mask(Kmer const & rhs) const
+    {
+      uint64_t mask = 0;
+      unsigned int i = 0;
+#if defined(__AVX2__)
+      for (; i + 4 <= nWords; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(rhs.data + i));
+        int eq = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, y)));
+        mask |= static_cast<uint64_t>(~eq & 0xF) << i;
+      }
+#endif
+      for (; i < nWords; ++i) mask |= static_cast<uint64_t>(data[i] != rhs.data[i]) << i;
+      return mask;
+    }
+
+    /// index of the most significant differing word, or 0 if all are equal.
+    KMER_INLINE unsigned int first_diff_word(Kmer const & rhs) const
+    {
+      uint64_t mask = word_diff_mask(rhs);
+      return (mask == 0) ? 0 : (63 - __builtin_clzll(mask));
+    }
+
+    /// ordered comparisons, from MSB to LSB.
+    template <int LAYOUT>
+    KMER_INLINE bool do_less(Kmer const & rhs, ::std::integral_constant<int, LAYOUT> const &) const
+    {
+      return do_less(rhs, masked_compare());
+    }
+    template <int LAYOUT>
+    KMER_INLINE int8_t do_compare(Kmer const & rhs, ::std::integral_constant<int, LAYOUT> const &) const
+    {
+      return do_compare(rhs, masked_compare());
+    }
+
+    KMER_INLINE bool do_less(Kmer const & rhs, ::std::false_type const &) const
+    {
+      return ::bliss::utils::bit_ops::less<WORD_TYPE, nWords>(data, rhs.data);
+    }
+    KMER_INLINE int8_t do_compare(Kmer const & rhs, ::std::false_type const &) const
+    {
+      return ::bliss::utils::bit_ops::compare<WORD_TYPE, nWords>(data, rhs.data);
+    }
+
+    KMER_INLINE bool do_less(Kmer const & rhs, ::std::true_type const &) const
+    {
+      unsigned int i = first_diff_word(rhs);
+      return data[i] < rhs.data[i];
+    }
+    KMER_INLINE int8_t do_compare(Kmer const & rhs, ::std::true_type const &) const
+    {
+      unsigned int i = first_diff_word(rhs);
+      return static_cast<int8_t>(static_cast<int>(rhs.data[i] < data[i]) - static_cast<int>(data[i] < rhs.data[i]));
+    }
+
+    /// equality of all words, as 1 reduction of the word differences.
+    KMER_INLINE bool do_equal(Kmer const & rhs, ::std::integral_constant<int, SINGLE_WORD> const &) const
+    {
+      return data[0] == rhs.data[0];
+    }
+    template <int LAYOUT>
+    KMER_INLINE bool do_equal(Kmer const & rhs, ::std::integral_constant<int, LAYOUT> const &) const
+    {
+      WORD_TYPE diff = 0;
+      for (unsigned int i = 0; i < nWords; ++i) diff |= (data[i] ^ rhs.data[i]);
+      return diff == 0;
+    }
+
+    KMER_INLINE bool do_less(Kmer const & rhs, ::std::integral_constant<int, SINGLE_WORD> const &) const
+    {
+      return data[0] < rhs.data[0];
+    }
+    KMER_INLINE int8_t do_compare(Kmer const & rhs, ::std::integral_constant<int, SINGLE_WORD> const &) const
+    {
+      return static_cast<int8_t>(static_cast<int>(rhs.data[0] < data[0]) - static_cast<int>(data[0] < rhs.data[0]));
+    }
+
+#if defined(__SIZEOF_INT128__)
+    KMER_INLINE bool do_less(Kmer const & rhs, ::std::integral_constant<int, DOUBLE_WORD> const &) const
+    {
+      return ((static_cast<unsigned __int128>(data[1]) << 64) | data[0]) <
+          ((static_cast<unsigned __int128>(rhs.data[1]) << 64) | rhs.data[0]);
+    }
+    KMER_INLINE int8_t do_compare(Kmer const & rhs, ::std::integral_constant<int, DOUBLE_WORD> const &) const
+    {
+      unsigned __int128 x = (static_cast<unsigned __int128>(data[1]) << 64) | data[0];
+      unsigned __int128 y = (static_cast<unsigned __int128>(rhs.data[1]) << 64) | rhs.data[0];
+      return static_cast<int8_t>(static_cast<int>(y < x) - static_cast<int>(x < y));
+    }
+#endif
+
     /**
      * @brief Performs a left shift by `shift` bits on the k-mer data.
      *
      * @param shift   The number of bits to shift by.
      */
-    // TODO template specialization for nWords = 1 (just use base type shift)
     // TODO implement more efficient version doing fixed left shift by BITS_PER_CHAR
     KMER_INLINE void do_left_shift(size_t const & shift)
+    {
+      do_left_shift(shift, word_layout());
+    }
+
+    /// single word left shift.  shifts of a word or more clear the word.
+    KMER_INLINE void do_left_shift(size_t const & shift, ::std::integral_constant<int, SINGLE_WORD> const &)
+    {
+      data[0] = (shift < bitstream::bitsPerWord) ? static_cast<WORD_TYPE>(data[0] << shift) : static_cast<WORD_TYPE>(0);
+    }
+
+#if defined(__SIZEOF_INT128__)
+    /// 2 64-bit words.  the branch on word crossing is well predicted, and is as fast as a 128 bit shift.
+    KMER_INLINE void do_left_shift(size_t const & shift, ::std::integral_constant<int, DOUBLE_WORD> const &)
+    {
+      if (shift == 0) return;
+      if (shift < 64) {
+        data[1] = (data[1] << shift) | (data[0] >> (64 - shift));
+        data[0] <<= shift;
+      } else {
+        data[1] = (shift < 128) ? (data[0] << (shift - 64)) : 0;
+        data[0] = 0;
+      }
+    }
+#endif
+
+    KMER_INLINE void do_left_shift(size_t const & shift, ::std::integral_constant<int, GENERAL_WORDS> const &)
     {
       // inspired by STL bitset implementation
       const int64_t word_shift = shift >> LogWordBits;
@@ -1525,9 +1669,34 @@ namespace bliss
      *
      * @param shift   The number of bits to shift by.
      */
-    // TODO template specialization for nWords = 1 (just use base type shift)
     // TODO implement more efficient version doing fixed right shift by BITS_PER_CHAR
     KMER_INLINE void do_right_shift(size_t const & shift)
+    {
+      do_right_shift(shift, word_layout());
+    }
+
+    /// single word right shift.  shifts of a word or more clear the word.
+    KMER_INLINE void do_right_shift(size_t const & shift, ::std::integral_constant<int, SINGLE_WORD> const &)
+    {
+      data[0] = (shift < bitstream::bitsPerWord) ? static_cast<WORD_TYPE>(data[0] >> shift) : static_cast<WORD_TYPE>(0);
+    }
+
+#if defined(__SIZEOF_INT128__)
+    /// 2 64-bit words.  the branch on word crossing is well predicted, and is as fast as a 128 bit shift.
+    KMER_INLINE void do_right_shift(size_t const & shift, ::std::integral_constant<int, DOUBLE_WORD> const &)
+    {
+      if (shift == 0) return;
+      if (shift < 64) {
+        data[0] = (data[0] >> shift) | (data[1] << (64 - shift));
+        data[1] >>= shift;
+      } else {
+        data[0] = (shift < 128) ? (data[1] >> (shift - 64)) : 0;
+        data[1] = 0;
+      }
+    }
+#endif
+
+    KMER_INLINE void do_right_shift(size_t const & shift, ::std::integral_constant<int, GENERAL_WORDS> const &)
     {
       // inspired by STL bitset implementation
       const size_t word_shift = shift >> LogWordBits;
@@ -1615,7 +1784,8 @@ namespace bliss
     template <typename A = ALPHABET,
         typename ::std::enable_if<::std::is_same<A, DNA>::value ||
                                   ::std::is_same<A, RNA>::value ||
-                                  ::std::is_same<A, DNA16>::value, int>::type = 0>
+                                  ::std::is_same<A, DNA16>::value ||
+                                  ::std::is_same<A, AA_MURPHY10>::value, int>::type = 0>
     KMER_INLINE void do_reverse(Kmer const & src, Kmer & result, int left_shift = 0) const
     {
 
@@ -1719,6 +1889,31 @@ namespace bliss
 
     }
 
+    /// reverse for the 5 bit amino acid alphabet.  5 bit groups may span words, so 1 word k-mers use the sequential
+    /// bitgroup_ops reverse, and longer ones move 1 character at a time.
+    template <typename A = ALPHABET,
+        typename ::std::enable_if<::std::is_same<A, AA>::value, int>::type = 0>
+    KMER_INLINE void do_reverse(Kmer const & src, Kmer & result, int left_shift = 0) const
+    {
+      Kmer temp;
+      if (nWords == 1) {
+        ::bliss::utils::bit_ops::bitgroup_ops<bitsPerChar, ::bliss::utils::bit_ops::BIT_REV_SEQ> op;
+        // reversed groups end at the MSB of the word.
+        temp.data[0] = op.reverse(src.data[0], 0) >> (bitstream::bitsPerWord - nBits);
+      } else {
+        for (unsigned int i = 0; i < size; ++i) {
+          temp.setCharsAtPos(src.getCharsAtPos(i, 1), size - 1 - i, 1);
+        }
+      }
+
+      result = temp;
+      if (left_shift < 0)  // negative means right shift.
+        result.do_right_shift( -(left_shift * bitsPerChar ));
+      else if (left_shift > 0)   // positive == left shift
+        result.do_left_shift(left_shift * bitsPerChar );
+      result.data[nWords - 1] &= getLeastSignificantBitsMask<WORD_TYPE>(bitstream::bitsPerWord - bitstream::padBits);
+    }
+
     /// reverse complement of kmer.  specialzied for DNA/RNA, where the complement is the bitwise negation.
     template <typename A = ALPHABET,
         typename ::std::enable_if<::std::is_same<A, DNA>::value ||
@@ -1913,12 +2108,23 @@ namespace bliss
 
     /// other alphabet types - reverse complement via serial implementation and applies ALPHABET's TO_COMPLEMENT lookup.
     /// if word size is multiple of bits per char (so basically, bits per char is power of 2.
+    /// reverse complement of a protein kmer.  there is no complement, so this is reverse.
+    template <typename A = ALPHABET,
+        typename ::std::enable_if<::std::is_same<A, AA>::value ||
+                                  ::std::is_same<A, AA_MURPHY10>::value, int>::type = 0>
+    KMER_INLINE void do_reverse_complement(Kmer const & src, Kmer & result, int left_shift = 0) const
+    {
+      do_reverse(src, result, left_shift);
+    }
+
     template <typename A = ALPHABET,
         typename ::std::enable_if<!(::std::is_same<A, DNA>::value ||
                                     ::std::is_same<A, RNA>::value ||
                                     ::std::is_same<A, DNA6>::value ||
                                     ::std::is_same<A, RNA6>::value ||
-                                    ::std::is_same<A, DNA16>::value) &&
+                                    ::std::is_same<A, DNA16>::value ||
+                                    ::std::is_same<A, AA>::value ||
+                                    ::std::is_same<A, AA_MURPHY10>::value) &&
                                      ((bitstream::bitsPerWord % bitsPerChar) != 0), int>::type = 0>
     KMER_INLINE void do_reverse_complement(Kmer const & src, Kmer & result, int left_shift = 0) const
     {
@@ -1926,7 +2132,9 @@ namespace bliss
           ::std::is_same<A, RNA>::value ||
           ::std::is_same<A, DNA6>::value ||
           ::std::is_same<A, RNA6>::value ||
-          ::std::is_same<A, DNA16>::value) &&
+          ::std::is_same<A, DNA16>::value ||
+          ::std::is_same<A, AA>::value ||
+          ::std::is_same<A, AA_MURPHY10>::value) &&
            (bitstream::bitsPerWord % bitsPerChar != 0), 
             "do reverse complement is not defined for alphabet with size != 2, 3, 4 and word type not a multiple of bits Per char.");
     }
@@ -1937,7 +2145,9 @@ namespace bliss
                                     ::std::is_same<A, RNA>::value ||
                                     ::std::is_same<A, DNA6>::value ||
                                     ::std::is_same<A, RNA6>::value ||
-                                    ::std::is_same<A, DNA16>::value) &&
+                                    ::std::is_same<A, DNA16>::value ||
+                                    ::std::is_same<A, AA>::value ||
+                                    ::std::is_same<A, AA_MURPHY10>::value) &&
                                      ((bitstream::bitsPerWord % bitsPerChar) == 0) &&
                                      (bitstream::bitsPerWord > bitsPerChar), int>::type = 0>
     KMER_INLINE void do_reverse_complement(Kmer const & src, Kmer & result, int left_shift = 0) const
@@ -2013,7 +2223,9 @@ namespace bliss
                                     ::std::is_same<A, RNA>::value ||
                                     ::std::is_same<A, DNA6>::value ||
                                     ::std::is_same<A, RNA6>::value ||
-                                    ::std::is_same<A, DNA16>::value) &&
+                                    ::std::is_same<A, DNA16>::value ||
+                                    ::std::is_same<A, AA>::value ||
+                                    ::std::is_same<A, AA_MURPHY10>::value) &&
                                      (bitstream::bitsPerWord == bitsPerChar), int>::type = 0>
     KMER_INLINE void do_reverse_complement(Kmer const & src, Kmer & result, int left_shift = 0) const
     {
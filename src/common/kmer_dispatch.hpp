@@ -0,0 +1,145 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    kmer_dispatch.hpp
+ * @ingroup common
+ * @brief   select a Kmer type by a k given at runtime.
+ * @details Kmer<K, ...> needs k at compile time.  a program that is compiled for a list of k values,
+ *          kmer_sizes<15, 21, 31, ...>, can call a functor with the exact-width Kmer type for the k
+ *          of the dataset, instead of rounding k up to that of a prebuilt binary:
+ *
+ *            struct run {
+ *              template <typename KmerType>
+ *              int operator()(std::string const & file) const { ... }
+ *            };
+ *
+ *            int ret = dispatch_kmer_size<kmer_sizes<15, 21, 31>, DNA>(k, run(), file);
+ *
+ *          the functor is instantiated once for each k in the list.  all instantiations must return the same type.
+ *          an unsupported k throws std::invalid_argument with the supported values.
+ */
+#ifndef BLISS_COMMON_KMER_DISPATCH_HPP_
+#define BLISS_COMMON_KMER_DISPATCH_HPP_
+
+#include <stdexcept>
+#include <string>
+#include <utility>   // forward
+
+#include "common/base_types.hpp"
+#include "common/kmer.hpp"
+
+namespace bliss
+{
+  namespace common
+  {
+
+    /// a compile time list of k-mer sizes.
+    template <unsigned int... Ks>
+    struct kmer_sizes {
+        static constexpr unsigned int count = sizeof...(Ks);
+    };
+
+    namespace detail
+    {
+      template <typename Sizes>
+      struct kmer_sizes_impl;
+
+      template <>
+      struct kmer_sizes_impl<kmer_sizes<> > {
+          static bool contains(unsigned int) { return false; }
+          static void append(std::string &) {}
+      };
+
+      /// the last k.  dispatch_kmer_size has checked that k is in the list.
+      template <unsigned int K>
+      struct kmer_sizes_impl<kmer_sizes<K> > {
+          static constexpr unsigned int first = K;
+
+          static bool contains(unsigned int k) { return k == K; }
+
+          static void append(std::string & s) {
+            if (!s.empty()) s.append(", ");
+            s.append(std::to_string(K));
+          }
+
+          template <typename Alphabet, typename Word, typename F, typename... Args>
+          static auto call(unsigned int, F && f, Args &&... args)
+            -> decltype(f.template operator()<Kmer<K, Alphabet, Word> >(std::forward<Args>(args)...)) {
+            return f.template operator()<Kmer<K, Alphabet, Word> >(std::forward<Args>(args)...);
+          }
+      };
+
+      template <unsigned int K, unsigned int K2, unsigned int... Ks>
+      struct kmer_sizes_impl<kmer_sizes<K, K2, Ks...> > {
+          using rest = kmer_sizes_impl<kmer_sizes<K2, Ks...> >;
+          static constexpr unsigned int first = K;
+
+          static bool contains(unsigned int k) { return (k == K) || rest::contains(k); }
+
+          static void append(std::string & s) {
+            if (!s.empty()) s.append(", ");
+            s.append(std::to_string(K));
+            rest::append(s);
+          }
+
+          template <typename Alphabet, typename Word, typename F, typename... Args>
+          static auto call(unsigned int k, F && f, Args &&... args)
+            -> decltype(f.template operator()<Kmer<K, Alphabet, Word> >(std::forward<Args>(args)...)) {
+            if (k == K) return f.template operator()<Kmer<K, Alphabet, Word> >(std::forward<Args>(args)...);
+            return rest::template call<Alphabet, Word>(k, std::forward<F>(f), std::forward<Args>(args)...);
+          }
+      };
+    } // namespace detail
+
+
+    /// true if k is in the list.
+    template <typename Sizes>
+    bool is_supported_kmer_size(unsigned int const k) {
+      return detail::kmer_sizes_impl<Sizes>::contains(k);
+    }
+
+    /// the first k of the list, e.g. for a program's default.
+    template <typename Sizes>
+    constexpr unsigned int default_kmer_size() {
+      return detail::kmer_sizes_impl<Sizes>::first;
+    }
+
+    /// the list as a string, e.g. "15, 21, 31", for usage and error messages.
+    template <typename Sizes>
+    std::string supported_kmer_sizes() {
+      std::string s;
+      detail::kmer_sizes_impl<Sizes>::append(s);
+      return s;
+    }
+
+    /**
+     * @brief call f.operator()<Kmer<k, Alphabet, Word> >(args...) for the runtime k.
+     * @tparam Sizes   kmer_sizes<...>, the k values to instantiate.
+     * @throw std::invalid_argument if k is not in Sizes.
+     */
+    template <typename Sizes, typename Alphabet, typename Word = WordType, typename F, typename... Args>
+    auto dispatch_kmer_size(unsigned int const k, F && f, Args &&... args)
+      -> decltype(detail::kmer_sizes_impl<Sizes>::template call<Alphabet, Word>(k, std::forward<F>(f), std::forward<Args>(args)...)) {
+      if (!is_supported_kmer_size<Sizes>(k))
+        throw std::invalid_argument("kmer size " + std::to_string(k) + " not supported.  compiled for " + supported_kmer_sizes<Sizes>());
+      return detail::kmer_sizes_impl<Sizes>::template call<Alphabet, Word>(k, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+  } // namespace common
+} // namespace bliss
+
+#endif // BLISS_COMMON_KMER_DISPATCH_HPP_
@@ -180,6 +180,80 @@ namespace bliss
   };
   
   
+  /**
+   * @brief The sliding window operator for canonical k-mer generation from character data.
+   * @details  the forward and reverse complement windows are kept together and each is updated incrementally
+   *           with 1 character per step, so canonicalization does not need a full reverse complement per k-mer.
+   *           value is the lexicographically smaller of the 2, same as bliss::kmer::transform::lex_less.
+   *
+   * @tparam BaseIterator Type of the underlying base iterator, which returns
+   *                      characters.
+   * @tparam Kmer         The k-mer type, must be of type bliss::Kmer
+   */
+  template <class BaseIterator, class Kmer>
+  class CanonicalKmerSlidingWindow {};
+
+  template <typename BaseIterator, unsigned int KMER_SIZE,
+            typename ALPHABET, typename word_type>
+  class CanonicalKmerSlidingWindow<BaseIterator, bliss::common::Kmer<KMER_SIZE, ALPHABET, word_type> >
+  {
+  public:
+    /// The Kmer type (same as the `value_type` of this iterator)
+    typedef bliss::common::Kmer<KMER_SIZE, ALPHABET, word_type> kmer_type;
+    typedef BaseIterator  base_iterator_type;
+    /// The value_type of the underlying iterator
+    typedef typename std::iterator_traits<BaseIterator>::value_type base_value_type;
+
+    /**
+     * @brief Initializes the sliding window.
+     *
+     * @param it[in|out]  The current base iterator position. This will be set to
+     *                    the last read position.
+     */
+    inline void init(BaseIterator& it)
+    {
+      base_value_type c;
+      for (unsigned int i = 0; i < KMER_SIZE; ++i) {
+        c = *it;
+        kmer.nextFromChar(c);
+        rev_comp.nextReverseFromChar(ALPHABET::to_complement(c));
+
+        // don't move iterator during last iteration, same as fillFromChars(it, true)
+        if (i < (KMER_SIZE - 1)) ++it;
+      }
+    }
+
+    /**
+     * @brief Slides both windows by one character taken from the given iterator.
+     *
+     * @param it[in|out]  The underlying iterator position, this will be read
+     *                    and then advanced.
+     */
+    inline void next(BaseIterator& it)
+    {
+      base_value_type c = *it;
+      kmer.nextFromChar(c);
+      rev_comp.nextReverseFromChar(ALPHABET::to_complement(c));
+      ++it;
+    }
+
+    /**
+     * @brief Returns the canonical k-mer of the current window, i.e. min(forward, reverse complement).
+     *
+     * @return The current canonical k-mer value.
+     */
+    inline kmer_type getValue()
+    {
+      return (this->kmer < this->rev_comp) ? this->kmer : this->rev_comp;
+    }
+  private:
+    /// The forward kmer buffer
+    kmer_type kmer;
+    /// The reverse complement kmer buffer
+    kmer_type rev_comp;
+  };
+
+
   /**
    * @brief Iterator that generates k-mers from character data.
    *
@@ -276,6 +350,10 @@ namespace bliss
   /// reverse KmerGenerationIterator for generating kmers from a sequence of alphabet characters.  can be used for reverse complements.
   template <class BaseIterator, class Kmer>
   using ReverseKmerGenerationIterator = KmerGenerationIteratorBase<ReverseKmerSlidingWindow<BaseIterator, Kmer > >;
+
+  /// canonical KmerGenerationIterator, generating min(kmer, reverse complement) with rolling updates of both.
+  template <class BaseIterator, class Kmer>
+  using CanonicalKmerGenerationIterator = KmerGenerationIteratorBase<CanonicalKmerSlidingWindow<BaseIterator, Kmer > >;
   
   
   
@@ -60,8 +60,11 @@
 #include <exception>  // for hash - std::system_error
 #include <algorithm>
 #include <type_traits>  // enable_if
+#include <vector>
 
 #include "common/kmer.hpp"
+#include "utils/bitgroup_ops.hpp"
+#include "utils/cpu_features.hpp"
 
 namespace bliss {
 
@@ -70,6 +73,99 @@ namespace bliss {
 
     namespace transform {
 
+      namespace detail {
+
+        /// how the kmer and its reverse complement are combined by the batch kernel.
+        enum class combine_op { XOR, MIN, MAX };
+
+        /**
+         * @brief batch reverse complement for arrays of kmers, several kmers per simd register.
+         * @details  only enabled for AVX2, DNA or RNA (complement is bit negation), and kmers that fit in a single 64 bit word,
+         *          so that 4 kmers are packed in a __m256i.  each 64 bit lane is reversed by 2-bit groups in place.
+         *          combine_op selects how the kmer and its reverse complement are combined.
+         *          with USE_SIMD_DISPATCH the AVX2 kernel is chosen at run time.
+         *          call returns the number of kmers processed.  the caller handles the remainder one at a time.
+         */
+        template <typename KMER, typename Enable = void>
+        struct batch_rev_comp {
+            inline size_t operator()(KMER *, size_t const &, combine_op const &) const {
+              return 0;
+            }
+        };
+
+#if defined(BL_KERNEL_AVX2)
+        /// unsigned 64 bit greater than, via signed compare after flipping the sign bit.
+        BL_TARGET("avx2")
+        inline __m256i cmpgt_epu64(__m256i const & x, __m256i const & y) {
+          __m256i const sign = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ULL));
+          return _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(y, sign));
+        }
+
+        /// reverse complement 4 single word 2 bit kmers per iteration.  returns number of kmers processed.
+        /// each 64 bit lane is reversed by bytes (pshufb), then by 2 bit groups within each byte (nibble lookup),
+        /// complemented, and shifted down by the padding bits.  constants are local so this can be dispatched at runtime.
+        template <combine_op OP>
+        BL_TARGET("avx2")
+        inline size_t batch_rev_comp_2bit_avx2(uint64_t * data, size_t const & count, int const & padding) {
+          __m256i const byte_rev = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+          // reverse 2 bit groups within a nibble.
+          __m256i const nib_rev = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+                                                   0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+          __m256i const lo_mask = _mm256_set1_epi8(0x0F);
+          __m256i const ones = _mm256_set1_epi8(-1);
+          __m128i const shift = _mm_cvtsi32_si128(padding);
+
+          size_t i = 0;
+          __m256i x, v, rc;
+          for (; (i + 4) <= count; i += 4) {
+            x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + i));
+
+            v = _mm256_shuffle_epi8(x, byte_rev);
+            // low nibble goes to high, high nibble to low, each reversed.  nib_rev output is < 16 so the 16 bit shift does not cross bytes.
+            rc = _mm256_or_si256(_mm256_slli_epi16(_mm256_shuffle_epi8(nib_rev, _mm256_and_si256(v, lo_mask)), 4),
+                                 _mm256_shuffle_epi8(nib_rev, _mm256_and_si256(_mm256_srli_epi16(v, 4), lo_mask)));
+            // complement, then remove padding.
+            rc = _mm256_srl_epi64(_mm256_xor_si256(rc, ones), shift);
+
+            switch (OP) {
+              case combine_op::MIN:  // x > rc ? rc : x
+                v = _mm256_blendv_epi8(x, rc, cmpgt_epu64(x, rc));
+                break;
+              case combine_op::MAX:  // rc > x ? rc : x
+                v = _mm256_blendv_epi8(x, rc, cmpgt_epu64(rc, x));
+                break;
+              default:
+                v = _mm256_xor_si256(x, rc);
+                break;
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(data + i), v);
+          }
+          return i;
+        }
+
+        template <typename KMER>
+        struct batch_rev_comp<KMER, typename ::std::enable_if<
+          (KMER::nWords == 1) && (sizeof(typename KMER::KmerWordType) == 8) && (sizeof(KMER) == 8) &&
+          (::std::is_same<typename KMER::KmerAlphabet, ::bliss::common::DNA>::value ||
+           ::std::is_same<typename KMER::KmerAlphabet, ::bliss::common::RNA>::value)>::type> {
+
+            inline size_t operator()(KMER * data, size_t const & count, combine_op const & op) const {
+              if (!::bliss::utils::cpu::use_avx2()) return 0;
+
+              uint64_t * d = reinterpret_cast<uint64_t *>(data);
+              switch (op) {
+                case combine_op::MIN: return batch_rev_comp_2bit_avx2<combine_op::MIN>(d, count, 64 - KMER::nBits);
+                case combine_op::MAX: return batch_rev_comp_2bit_avx2<combine_op::MAX>(d, count, 64 - KMER::nBits);
+                default:              return batch_rev_comp_2bit_avx2<combine_op::XOR>(d, count, 64 - KMER::nBits);
+              }
+            }
+        };
+#endif
+
+      } // namespace detail
+
+
       // QUESTION:  xor of hash, or hash of xor?.  second is faster.  Also if there is GC-AT imbalance, xor of raw sequence kind of flattens the distribution, so hash input is now more even.
 //
 //      template <typename KMER>
@@ -103,6 +199,14 @@ namespace bliss {
           inline ::std::pair<const KMER, VAL> operator()(std::pair<const KMER, VAL> const & x) const {
               return std::pair<const KMER, VAL>(operator()(x.first), x.second);
           }
+          /// batch version, in place.
+          inline void transform_inplace(KMER * data, size_t const & count) const {
+            size_t i = detail::batch_rev_comp<KMER>()(data, count, detail::combine_op::XOR);
+            for (; i < count; ++i) data[i] = operator()(data[i]);
+          }
+          inline void transform_inplace(std::vector<KMER> & x) const {
+            transform_inplace(x.data(), x.size());
+          }
       };
 
       template <typename KMER>
@@ -122,6 +226,14 @@ namespace bliss {
           inline ::std::pair<const KMER, VAL> operator()(std::pair<const KMER, VAL> const & x) const {
               return std::pair<const KMER, VAL>(operator()(x.first), x.second);
           }
+          /// batch version, in place.
+          inline void transform_inplace(KMER * data, size_t const & count) const {
+            size_t i = detail::batch_rev_comp<KMER>()(data, count, detail::combine_op::MIN);
+            for (; i < count; ++i) data[i] = operator()(data[i]);
+          }
+          inline void transform_inplace(std::vector<KMER> & x) const {
+            transform_inplace(x.data(), x.size());
+          }
       };
 
       template <typename KMER>
@@ -141,6 +253,14 @@ namespace bliss {
           inline ::std::pair<const KMER, VAL> operator()(std::pair<const KMER, VAL> const & x) const {
             return std::pair<const KMER, VAL>(operator()(x.first), x.second);
           }
+          /// batch version, in place.
+          inline void transform_inplace(KMER * data, size_t const & count) const {
+            size_t i = detail::batch_rev_comp<KMER>()(data, count, detail::combine_op::MAX);
+            for (; i < count; ++i) data[i] = operator()(data[i]);
+          }
+          inline void transform_inplace(std::vector<KMER> & x) const {
+            transform_inplace(x.data(), x.size());
+          }
 
       };
 
@@ -36,6 +36,7 @@
 #include "common/bit_ops.hpp"
 #include "common/padding.hpp"
 #include "common/kmer.hpp"
+#include "utils/bit_ops.hpp"
 
 #include "iterators/many2one_iterator.hpp"
 #include "iterators/one2many_iterator.hpp"
@@ -107,6 +108,85 @@ namespace bliss
   
       return buffer;
     }
+
+    /**
+     * @brief Packs all characters in [cur, end) into storage words, written to `out`.
+     *
+     * Same words as calling operator() until `cur` reaches `end`.  For random
+     * access iterators, full words are packed with a fixed length inner loop
+     * that the compiler can unroll and vectorize.  Used by
+     * many2one_iterator::copy_to.
+     *
+     * @return The output iterator one past the last written word.
+     */
+    template<typename Iterator, typename OutputIterator>
+    OutputIterator batch(Iterator cur, const Iterator& end, OutputIterator out)
+    {
+      return batch(cur, end, out, typename std::iterator_traits<Iterator>::iterator_category());
+    }
+
+  protected:
+    template<typename Iterator, typename OutputIterator>
+    OutputIterator batch(Iterator cur, const Iterator& end, OutputIterator out, std::random_access_iterator_tag)
+    {
+      for (; (end - cur) >= static_cast<typename std::iterator_traits<Iterator>::difference_type>(m); cur += m)
+      {
+        *out = pack_full<Iterator>(cur);
+        ++out;
+      }
+      // partial last word
+      if (cur != end)
+      {
+        *out = (*this)(cur, end);
+        ++out;
+      }
+      return out;
+    }
+
+    /// true if a full word can be packed 8 byte sized chars at a time, with bit_ops::pack_bytes (BMI2 pext if available).
+    template<typename Iterator>
+    struct packs_bytes : public std::integral_constant<bool,
+      (BITS_PER_CHAR == 2 || BITS_PER_CHAR == 4) && (m % 8 == 0) &&
+      (sizeof(typename std::iterator_traits<Iterator>::value_type) == 1)> {};
+
+    /// pack m chars starting at cur, 8 at a time.
+    template<typename Iterator>
+    static typename std::enable_if<packs_bytes<Iterator>::value, PackedStorageType>::type
+    pack_full(const Iterator& cur)
+    {
+      PackedStorageType buffer = 0;
+      for (unsigned int g = 0; g < m; g += 8)
+      {
+        uint64_t x = 0;
+        for (unsigned int j = 0; j < 8; ++j)
+          x |= static_cast<uint64_t>(static_cast<uint8_t>(cur[g + j])) << (j * 8);
+        buffer |= static_cast<PackedStorageType>(::bliss::utils::bit_ops::pack_bytes<BITS_PER_CHAR>(x)) << (g * padtraits::bits_per_char);
+      }
+      return buffer;
+    }
+
+    /// pack m chars starting at cur, 1 at a time.
+    template<typename Iterator>
+    static typename std::enable_if<!packs_bytes<Iterator>::value, PackedStorageType>::type
+    pack_full(const Iterator& cur)
+    {
+      const PackedStorageType mask = getLeastSignificantBitsMask<PackedStorageType>(padtraits::bits_per_char);
+      PackedStorageType buffer = 0;
+      for (unsigned int i = 0; i < m; ++i)
+        buffer |= (static_cast<PackedStorageType>(cur[i]) & mask) << (i * padtraits::bits_per_char);
+      return buffer;
+    }
+
+    template<typename Iterator, typename OutputIterator>
+    OutputIterator batch(Iterator cur, const Iterator& end, OutputIterator out, std::input_iterator_tag)
+    {
+      while (cur != end)
+      {
+        *out = (*this)(cur, end);
+        ++out;
+      }
+      return out;
+    }
   };
   
   /**
@@ -193,6 +273,66 @@ namespace bliss
       // cast to target type
       return static_cast<unpacked_type>(x);
     }
+
+    /**
+     * @brief Unpacks the characters at offsets [first, last) of `value` to `out`.
+     *
+     * Shifts the word once per character instead of recomputing the shift
+     * from the offset.  Used by one2many_iterator::copy_to.
+     *
+     * @return The output iterator one past the last written character.
+     */
+    template <typename T, typename diff_type, typename OutputIterator>
+    OutputIterator batch(const T& value, diff_type first, const diff_type& last, OutputIterator out)
+    {
+      // a full word, 8 chars at a time.
+      if ((first == 0) && (last == static_cast<diff_type>(PackingTraits<T, bits_per_char>::chars_per_word)))
+        return unpack_full(value, out);
+      return unpack_range(value, first, last, out);
+    }
+
+  protected:
+    /// true if a full word can be unpacked 8 byte sized chars at a time, with bit_ops::unpack_bytes (BMI2 pdep if available).
+    template <typename T>
+    struct unpacks_bytes : public std::integral_constant<bool,
+      (bits_per_char == 2 || bits_per_char == 4) && (PackingTraits<T, bits_per_char>::chars_per_word % 8 == 0) &&
+      (sizeof(unpacked_type) == 1)> {};
+
+    template <typename T, typename OutputIterator>
+    typename std::enable_if<unpacks_bytes<T>::value, OutputIterator>::type
+    unpack_full(const T& value, OutputIterator out)
+    {
+      for (unsigned int g = 0; g < PackingTraits<T, bits_per_char>::chars_per_word; g += 8)
+      {
+        uint64_t x = ::bliss::utils::bit_ops::unpack_bytes<bits_per_char>(static_cast<uint64_t>(value >> (g * bits_per_char)));
+        for (unsigned int j = 0; j < 8; ++j, x >>= 8)
+        {
+          *out = static_cast<unpacked_type>(x & 0xFF);
+          ++out;
+        }
+      }
+      return out;
+    }
+
+    template <typename T, typename OutputIterator>
+    typename std::enable_if<!unpacks_bytes<T>::value, OutputIterator>::type
+    unpack_full(const T& value, OutputIterator out)
+    {
+      return unpack_range(value, 0, PackingTraits<T, bits_per_char>::chars_per_word, out);
+    }
+
+    template <typename T, typename diff_type, typename OutputIterator>
+    OutputIterator unpack_range(const T& value, diff_type first, const diff_type& last, OutputIterator out)
+    {
+      const T mask = getLeastSignificantBitsMask<T>(bits_per_char);
+      T v = value >> (first * bits_per_char);
+      for (; first < last; ++first, v >>= bits_per_char)
+      {
+        *out = static_cast<unpacked_type>(v & mask);
+        ++out;
+      }
+      return out;
+    }
   };
   
   /**
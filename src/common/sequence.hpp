@@ -25,6 +25,11 @@
 #ifndef SEQUENCE_HPP_
 #define SEQUENCE_HPP_
 
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <ostream>
+
 namespace bliss
 {
   namespace common
@@ -303,6 +308,157 @@ namespace bliss
     };
 
 
+    /**
+     * @class     bliss::common::PackedSequenceKmerId
+     * @brief     a Kmer id bit packed into BYTES bytes, with field widths chosen for the input.
+     * @details   the low POS_BITS bits are the position within the record  (identifies kmer within a sequence)
+     *            the next bits are the record's position in the file        (identifies the sequence)
+     *            the top FILE_BITS bits are the file id.
+     *
+     *            with POS_BITS = 0, the record field holds the kmer's position in the file, as in LongSequenceKmerId.
+     *            use fits() to check a layout against the input first.  construction and increment throw when a field overflows.
+     *
+     *            the bytes are stored with alignment 1, so (Kmer, id) pairs are smaller than with the 8 byte ids when the
+     *            Kmer word type is narrower than 64 bits.  e.g. with Kmer<15, DNA, uint32_t> a pair shrinks from 16 to 12 bytes (BYTES = 6)
+     *            or 10 bytes (BYTES = 5).
+     *
+     * @note      byte array and shifts instead of bit fields, for layout independent of compiler, since this is sent via MPI.
+     * @tparam POS_BITS    bits for the position within the record.
+     * @tparam FILE_BITS   bits for the file id.
+     * @tparam BYTES       total size, 5 to 8 bytes.
+     */
+    template <unsigned int POS_BITS = 12, unsigned int FILE_BITS = 4, unsigned int BYTES = 6>
+    class PackedSequenceKmerId
+    {
+        static_assert((BYTES >= 5) && (BYTES <= 8), "PackedSequenceKmerId should be 5 to 8 bytes");
+        static_assert((POS_BITS + FILE_BITS) < (BYTES * 8), "PackedSequenceKmerId has no bits left for the record position");
+
+      public:
+        static constexpr unsigned int TOTAL_BITS = BYTES * 8;
+        static constexpr unsigned int RECORD_BITS = TOTAL_BITS - POS_BITS - FILE_BITS;
+
+        /// packed value, least significant byte first.
+        uint8_t id[BYTES];
+
+      protected:
+        static constexpr uint64_t mask(unsigned int bits) {
+          return (bits >= 64) ? ~(0ULL) : ((1ULL << bits) - 1);
+        }
+
+        inline uint64_t get() const {
+          uint64_t v = 0;
+          for (unsigned int i = BYTES; i > 0; --i) v = (v << 8) | id[i - 1];
+          return v;
+        }
+
+        inline void set(uint64_t v) {
+          for (unsigned int i = 0; i < BYTES; ++i, v >>= 8) id[i] = static_cast<uint8_t>(v);
+        }
+
+        /// the field that operator+= changes.  the record position, if there is no position field.
+        static constexpr uint64_t step_mask() {
+          return (POS_BITS > 0) ? mask(POS_BITS) : mask(RECORD_BITS);
+        }
+
+      public:
+
+        /// true if the layout fits the input.  max_record_size is irrelevant if POS_BITS is 0.
+        static bool fits(size_t max_file_size, size_t max_record_size, size_t num_files) {
+          return (static_cast<uint64_t>(max_file_size) <= (mask(RECORD_BITS) + 1)) &&
+              ((POS_BITS == 0) || (static_cast<uint64_t>(max_record_size) <= (mask(POS_BITS) + 1))) &&
+              (static_cast<uint64_t>(num_files) <= (mask(FILE_BITS) + 1));
+        }
+
+        /**
+         * @brief << operator to write out PackedSequenceKmerId
+         * @param[in/out] ost   output stream to which the content is directed.
+         * @param[in]     seq_id    sequence id object to write out
+         * @return              output stream object
+         */
+        friend std::ostream& operator<<(std::ostream& ost, const PackedSequenceKmerId & seq_id)
+        {
+          ost << " PackedSeqId: file=" << static_cast<uint32_t>(seq_id.get_file_id()) << " id=" << seq_id.get_id() << " pos=" << seq_id.get_pos();
+
+          return ost;
+        }
+
+        PackedSequenceKmerId() { set(0); };
+
+        PackedSequenceKmerId(size_t const & file_pos, uint16_t file_id = 0, size_t const & pos_in_seq = 0) {
+          if ((static_cast<uint64_t>(file_pos) > mask(RECORD_BITS)) ||
+              (static_cast<uint64_t>(file_id) > mask(FILE_BITS)) ||
+              (static_cast<uint64_t>(pos_in_seq) > mask(POS_BITS)))
+            throw std::invalid_argument("PackedSequenceKmerId field overflow.  please choose a layout that fits the input.");
+          set(static_cast<uint64_t>(pos_in_seq) |
+              (static_cast<uint64_t>(file_pos) << POS_BITS) |
+              ((FILE_BITS == 0) ? 0 : (static_cast<uint64_t>(file_id) << (POS_BITS + RECORD_BITS))));
+        }
+        PackedSequenceKmerId(SequenceId const & other) : PackedSequenceKmerId(other.pos_in_file, other.file_id) {}
+        PackedSequenceKmerId(PackedSequenceKmerId const & other) {
+          for (unsigned int i = 0; i < BYTES; ++i) id[i] = other.id[i];
+        }
+
+        PackedSequenceKmerId& operator=(SequenceId const & other) {
+          *this = PackedSequenceKmerId(other);
+          return *this;
+        }
+        PackedSequenceKmerId& operator=(PackedSequenceKmerId const & other) {
+          for (unsigned int i = 0; i < BYTES; ++i) id[i] = other.id[i];
+          return *this;
+        }
+
+        bool operator==(PackedSequenceKmerId const & other) const {
+          return get() == other.get();
+        }
+
+        bool operator>(PackedSequenceKmerId const & other) const {
+          return get() > other.get();
+        }
+
+        bool operator<(PackedSequenceKmerId const & other) const {
+          return get() < other.get();
+        }
+
+
+        void operator+=(size_t dist) {
+          uint64_t v = get();
+          if (((v & step_mask()) + dist) > step_mask())
+            throw std::invalid_argument("PackedSequenceKmerId increment overflow.  please check dist parameter");
+          set(v + dist);
+        }
+
+        void operator-=(size_t dist) {
+          if ((get() & step_mask()) < dist)
+            throw std::invalid_argument("PackedSequenceKmerId decrement underflow.  please check dist parameter");
+          set(get() - dist);
+        }
+
+        std::ptrdiff_t operator-(PackedSequenceKmerId const & other) {
+          uint64_t x = get(), y = other.get();
+          return (x >= y) ? static_cast<std::ptrdiff_t>(x - y) :
+              -(static_cast<std::ptrdiff_t>(y - x));
+        }
+
+
+        /// getter for sequence id  (the record's position in the file)
+        size_t get_id() const { return (get() >> POS_BITS) & mask(RECORD_BITS); }
+
+        /// get position in file
+        size_t get_pos() const { return get_id() + (get() & mask(POS_BITS)); }
+
+        /// getter for file id
+        uint16_t get_file_id() const {
+          return (FILE_BITS == 0) ? 0 : static_cast<uint16_t>((get() >> (POS_BITS + RECORD_BITS)) & mask(FILE_BITS));
+        }
+
+    };
+
+    template <unsigned int POS_BITS, unsigned int FILE_BITS, unsigned int BYTES>
+    constexpr unsigned int PackedSequenceKmerId<POS_BITS, FILE_BITS, BYTES>::TOTAL_BITS;
+    template <unsigned int POS_BITS, unsigned int FILE_BITS, unsigned int BYTES>
+    constexpr unsigned int PackedSequenceKmerId<POS_BITS, FILE_BITS, BYTES>::RECORD_BITS;
+
+
     /**
      * @class     bliss::io::Sequence
      * @brief     represents a biological sequence, and provides iterators for traversing the sequence.
@@ -254,6 +254,15 @@ TYPED_TEST_P(KmerReverseOpTest, reverse_avx2)
 #endif
 }
 
+TYPED_TEST_P(KmerReverseOpTest, reverse_avx512)
+{
+#ifdef __AVX512BW__
+  this->template test<bliss::utils::bit_ops::BITREV_AVX512>();
+#else
+  BL_WARNINGF("AVX512BW is not enabled or not available.");
+#endif
+}
+
 TYPED_TEST_P(KmerReverseOpTest, reverse_auto)
 {
 	constexpr size_t bytes = sizeof(typename TypeParam::KmerWordType) * TypeParam::nWords;
@@ -283,6 +292,15 @@ TYPED_TEST_P(KmerReverseOpTest, revcomp_avx2)
 #endif
 }
 
+TYPED_TEST_P(KmerReverseOpTest, revcomp_avx512)
+{
+#ifdef __AVX512BW__
+  this->template testc<bliss::utils::bit_ops::BITREV_AVX512>();
+#else
+  BL_WARNINGF("AVX512BW is not enabled or not available.");
+#endif
+}
+
 TYPED_TEST_P(KmerReverseOpTest, revcomp_auto)
 {
 	constexpr size_t bytes = sizeof(typename TypeParam::KmerWordType) * TypeParam::nWords;
@@ -291,5 +309,5 @@ TYPED_TEST_P(KmerReverseOpTest, revcomp_auto)
 
 
 
-REGISTER_TYPED_TEST_CASE_P(KmerReverseOpTest,  reverse_swar, reverse_ssse3, reverse_avx2, reverse_auto, revcomp_swar, revcomp_ssse3, revcomp_avx2, revcomp_auto);
+REGISTER_TYPED_TEST_CASE_P(KmerReverseOpTest,  reverse_swar, reverse_ssse3, reverse_avx2, reverse_avx512, reverse_auto, revcomp_swar, revcomp_ssse3, revcomp_avx2, revcomp_avx512, revcomp_auto);
 
@@ -32,6 +32,7 @@
 
 #include <random>
 #include <cstdint>
+#include <vector>
 
 #include "common/kmer.hpp"
 #include "common/alphabets.hpp"
@@ -216,7 +217,41 @@ TYPED_TEST_P(KmerTransformTest, lex_greater)
 
 
 
-REGISTER_TYPED_TEST_CASE_P(KmerTransformTest, identity, trans_xor, lex_less, lex_greater);
+// batch transforms should match the element-wise transforms.  odd count so the simd remainder is exercised.
+TYPED_TEST_P(KmerTransformTest, batch)
+{
+  std::vector<TypeParam> input;
+  auto km = this->kmer;
+  for (size_t i = 0; i < 1023; ++i) {
+    input.push_back(km);
+    km.nextFromChar(rand() % TypeParam::KmerAlphabet::SIZE);
+  }
+
+  bliss::kmer::transform::xor_rev_comp<TypeParam> xop;
+  bliss::kmer::transform::lex_less<TypeParam> lop;
+  bliss::kmer::transform::lex_greater<TypeParam> gop;
+
+  std::vector<TypeParam> output(input);
+  xop.transform_inplace(output);
+  for (size_t i = 0; i < input.size(); ++i) {
+    ASSERT_EQ(xop(input[i]), output[i]) << "xor differs at " << i;
+  }
+
+  output = input;
+  lop.transform_inplace(output);
+  for (size_t i = 0; i < input.size(); ++i) {
+    ASSERT_EQ(lop(input[i]), output[i]) << "lex_less differs at " << i;
+  }
+
+  output = input;
+  gop.transform_inplace(output);
+  for (size_t i = 0; i < input.size(); ++i) {
+    ASSERT_EQ(gop(input[i]), output[i]) << "lex_greater differs at " << i;
+  }
+}
+
+
+REGISTER_TYPED_TEST_CASE_P(KmerTransformTest, identity, trans_xor, lex_less, lex_greater, batch);
 
 //////////////////// RUN the tests with different types.
 
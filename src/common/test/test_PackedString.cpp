@@ -24,6 +24,7 @@
 #include "common/kmer.hpp"
 #include "common/packing_iterators.hpp"
 #include "common/kmer_iterators.hpp"
+#include "iterators/algorithm.hpp"
 #include "utils/logging.h"
 
 class PackingTest : public ::testing::Test
@@ -162,6 +163,34 @@ TEST_F(PackingTest, TestPackingIterator) {
   }
 }
 
+TEST_F(PackingTest, TestBulkPackUnpack) {
+  typedef bliss::common::PackingIterator<std::string::iterator, bliss::common::AlphabetTraits<bliss::common::DNA>::getBitsPerChar(), uint64_t> packit_t;
+  typedef bliss::common::UnpackingIterator<std::vector<uint64_t>::iterator, bliss::common::AlphabetTraits<bliss::common::DNA>::getBitsPerChar()> unpackit_t;
+
+  for (std::string dna : dna_seqs)
+  {
+    bliss::common::AlphabetTraits<bliss::common::DNA>::translateFromAscii(dna.begin(), dna.end(), dna.begin());
+
+    // bulk packing produces the same words as the per word iterator.
+    std::vector<uint64_t> packed;
+    std::copy(packit_t(dna.begin(), dna.end()), packit_t(dna.end()), std::back_inserter(packed));
+    std::vector<uint64_t> bulk_packed;
+    bliss::iterator::algorithm::copy(packit_t(dna.begin(), dna.end()), packit_t(dna.end()), std::back_inserter(bulk_packed));
+    EXPECT_EQ(packed, bulk_packed);
+
+    // bulk unpacking from every start offset to every end offset.
+    for (size_t i = 0; i <= dna.size(); i += 7)
+    {
+      for (size_t j = i; j <= dna.size(); j += 5)
+      {
+        std::string unpacked;
+        bliss::iterator::algorithm::copy(unpackit_t(bulk_packed.begin(), i), unpackit_t(bulk_packed.begin(), j), std::back_inserter(unpacked));
+        EXPECT_EQ(dna.substr(i, j - i), unpacked);
+      }
+    }
+  }
+}
+
 // TODO: put this somewhere else
 template<typename T>
 std::string getTypeName()
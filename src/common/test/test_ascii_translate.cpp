@@ -0,0 +1,109 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+// include C stdlib
+#include <cstdint>
+#include <vector>
+#include <random>
+
+// include files to test
+#include "common/alphabets.hpp"
+#include "common/ascii_translate.hpp"
+
+
+template <typename T>
+class ASCIITranslateTest : public ::testing::Test {};
+
+typedef ::testing::Types<bliss::common::DNA, bliss::common::DNA5, bliss::common::DNA16, bliss::common::DNA_IUPAC,
+                         bliss::common::AA, bliss::common::AA_MURPHY10> ASCIITranslateTestTypes;
+TYPED_TEST_CASE(ASCIITranslateTest, ASCIITranslateTestTypes);
+
+
+// every character, at every offset into the simd word, so that the vector and remainder loops are both exercised.
+TYPED_TEST(ASCIITranslateTest, all_chars)
+{
+  std::vector<unsigned char> input(256 + 64);
+  for (size_t i = 0; i < input.size(); ++i) input[i] = static_cast<unsigned char>(i);
+
+  std::vector<uint8_t> output(input.size());
+
+  ::bliss::common::ASCII2Bulk<TypeParam> translate;
+
+  for (size_t offset = 0; offset < 33; ++offset) {
+    size_t count = input.size() - offset;
+    translate(input.data() + offset, count, output.data());
+
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(TypeParam::FROM_ASCII[input[i + offset]], output[i]) << "offset " << offset << " pos " << i;
+    }
+  }
+}
+
+TYPED_TEST(ASCIITranslateTest, in_place)
+{
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> distribution(0, 255);
+
+  std::vector<unsigned char> input(1001);
+  for (size_t i = 0; i < input.size(); ++i) input[i] = static_cast<unsigned char>(distribution(generator));
+
+  std::vector<unsigned char> output(input);
+
+  ::bliss::common::ASCII2Bulk<TypeParam>()(output.data(), output.size(), output.data());
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    EXPECT_EQ(TypeParam::FROM_ASCII[input[i]], output[i]) << "pos " << i;
+  }
+}
+
+
+// non-ACGT positions reported by the DNA translation, for every offset and for counts that do not fill the last mask word.
+TEST(ASCIITranslateDNAMask, non_acgt)
+{
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> distribution(0, 9);
+  const char chars[] = "ACGTacgtNn";
+
+  std::vector<unsigned char> input(1001);
+  for (size_t i = 0; i < input.size(); ++i) input[i] = static_cast<unsigned char>(chars[distribution(generator)]);
+  input[500] = 0;
+  input[501] = 255;
+
+  std::vector<uint8_t> output(input.size());
+  std::vector<uint64_t> mask((input.size() + 63) / 64, ~0ULL);
+
+  ::bliss::common::ASCII2Bulk<bliss::common::DNA> translate;
+
+  for (size_t offset = 0; offset < 33; ++offset) {
+    size_t count = input.size() - offset * 7;
+    translate(input.data() + offset, count, output.data(), mask.data());
+
+    for (size_t i = 0; i < count; ++i) {
+      unsigned char c = input[i + offset];
+      bool acgt = (c == 'A') || (c == 'C') || (c == 'G') || (c == 'T') ||
+          (c == 'a') || (c == 'c') || (c == 'g') || (c == 't');
+      EXPECT_EQ(bliss::common::DNA::FROM_ASCII[c], output[i]) << "offset " << offset << " pos " << i;
+      EXPECT_EQ(!acgt, ((mask[i / 64] >> (i % 64)) & 1) == 1) << "offset " << offset << " pos " << i;
+    }
+    // bits past count are 0.
+    if ((count % 64) > 0) {
+      EXPECT_EQ(0ULL, mask[count / 64] >> (count % 64)) << "offset " << offset;
+    }
+  }
+}
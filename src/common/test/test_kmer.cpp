@@ -17,6 +17,9 @@
 // include google test
 #include <gtest/gtest.h>
 //#include <boost/concept_check.hpp>
+#include <vector>
+#include <cstring>  // memcpy, memcmp
+#include <cstdlib>  // rand
 
 // include classes to test
 #include "common/kmer.hpp"
@@ -693,6 +696,69 @@ TEST(KmerComparison, TestKmerComparison1)
 
 
 
+/**
+ * single and double word k-mers (straight line shifts and compares), and longer ones (word mask compares), against the
+ * same bits in 8 bit words (general path).
+ */
+template <unsigned int K>
+void test_kmer_word_layouts(unsigned int seed) {
+  typedef MyKmer<K, bliss::common::DNA, uint64_t> wide_type;
+  typedef MyKmer<K, bliss::common::DNA, uint8_t> narrow_type;
+  static_assert(wide_type::nBytes == narrow_type::nBytes, "k-mers should have the same number of bytes");
+
+  srand(seed);
+  std::vector<wide_type> wides;
+  std::vector<narrow_type> narrows;
+  for (int i = 0; i < 64; ++i) {
+    wide_type w;
+    for (unsigned int j = 0; j < wide_type::nWords; ++j) {
+      w.getDataRef()[j] = (static_cast<uint64_t>(rand()) << 40) ^ (static_cast<uint64_t>(rand()) << 20) ^ static_cast<uint64_t>(rand());
+    }
+    // some pairs differ in the low word only.
+    if (i & 1) memcpy(w.getDataRef() + (wide_type::nWords - 1), wides.back().getData() + (wide_type::nWords - 1), sizeof(uint64_t));
+    w.sanitize();
+
+    narrow_type n;
+    memcpy(n.getDataRef(), w.getData(), wide_type::nBytes);
+    wides.push_back(w);
+    narrows.push_back(n);
+  }
+
+  for (size_t i = 0; i < wides.size(); ++i) {
+    for (unsigned int s = 0; s <= 2 * K + 2; ++s) {
+      wide_type w = wides[i];
+      narrow_type n = narrows[i];
+      w.left_shift_bits(s);
+      n.left_shift_bits(s);
+      EXPECT_EQ(0, memcmp(w.getData(), n.getData(), wide_type::nBytes)) << "left shift by " << s << " bits";
+
+      w = wides[i];
+      n = narrows[i];
+      w.right_shift_bits(s);
+      n.right_shift_bits(s);
+      EXPECT_EQ(0, memcmp(w.getData(), n.getData(), wide_type::nBytes)) << "right shift by " << s << " bits";
+    }
+
+    size_t j = (i + 1) % wides.size();
+    EXPECT_EQ(narrows[i] < narrows[j], wides[i] < wides[j]);
+    EXPECT_EQ(narrows[j] < narrows[i], wides[j] < wides[i]);
+    EXPECT_EQ(narrows[i].compare(narrows[j]), wides[i].compare(wides[j]));
+    EXPECT_EQ(0, wides[i].compare(wides[i]));
+    EXPECT_FALSE(wides[i] < wides[i]);
+  }
+}
+
+TEST(KmerComparison, TestKmerWordLayouts)
+{
+  test_kmer_word_layouts<31>(23);
+  test_kmer_word_layouts<32>(29);
+  test_kmer_word_layouts<63>(31);
+  test_kmer_word_layouts<64>(37);
+  test_kmer_word_layouts<95>(41);
+  test_kmer_word_layouts<160>(43);
+}
+
+
 /**
  * Testing kmer reverse
  */
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+// include files to test
+#include "common/kmer_dispatch.hpp"
+#include "common/alphabets.hpp"
+
+
+using test_sizes = bliss::common::kmer_sizes<15, 21, 31, 63>;
+
+// returns the size and storage of the Kmer type it is called with.
+struct kmer_props {
+    template <typename KmerType>
+    std::pair<unsigned int, unsigned int> operator()(unsigned int const offset) const {
+      return std::make_pair(KmerType::size + offset, KmerType::nWords);
+    }
+};
+
+TEST(KmerDispatch, exact_width)
+{
+  unsigned int ks[] = {15, 21, 31, 63};
+  for (unsigned int k : ks) {
+    auto p = bliss::common::dispatch_kmer_size<test_sizes, bliss::common::DNA>(k, kmer_props(), 0);
+    EXPECT_EQ(k, p.first);
+    // the smallest storage that holds k characters.
+    EXPECT_EQ((2 * k + 63) / 64, p.second);
+  }
+  auto p = bliss::common::dispatch_kmer_size<test_sizes, bliss::common::DNA16, uint16_t>(21, kmer_props(), 100);
+  EXPECT_EQ(121U, p.first);
+  EXPECT_EQ(6U, p.second);
+}
+
+TEST(KmerDispatch, unsupported)
+{
+  EXPECT_TRUE(bliss::common::is_supported_kmer_size<test_sizes>(31));
+  EXPECT_FALSE(bliss::common::is_supported_kmer_size<test_sizes>(32));
+  EXPECT_EQ("15, 21, 31, 63", bliss::common::supported_kmer_sizes<test_sizes>());
+
+  EXPECT_THROW((bliss::common::dispatch_kmer_size<test_sizes, bliss::common::DNA>(32, kmer_props(), 0)), std::invalid_argument);
+}
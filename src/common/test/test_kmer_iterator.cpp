@@ -23,6 +23,7 @@
 #include "common/alphabets.hpp"
 #include "iterators/transform_iterator.hpp"
 #include "common/kmer_iterators.hpp"
+#include "common/kmer_transform.hpp"
 #include "utils/kmer_utils.hpp"
 #include "utils/logging.h"
 
@@ -63,6 +64,39 @@ void compute_kmer_iter(std::string input) {
 }
 
 
+template<typename Alphabet, int K>
+void compute_canonical_kmer_iter(std::string input) {
+
+  using KmerType = bliss::common::Kmer<K, Alphabet>;
+
+  using BaseIterator = std::string::const_iterator;
+
+  using Decoder = bliss::common::ASCII2<Alphabet, typename BaseIterator::value_type>;
+  using BaseCharIterator = bliss::iterator::transform_iterator<BaseIterator, Decoder>;
+
+  BaseCharIterator charStart(input.cbegin(), Decoder());
+  BaseCharIterator charEnd  (input.cend(),   Decoder());
+
+  using KmerIterator = bliss::common::KmerGenerationIterator<BaseCharIterator, KmerType>;
+  using CanonicalIterator = bliss::common::CanonicalKmerGenerationIterator<BaseCharIterator, KmerType>;
+
+  KmerIterator start(charStart, true);
+  KmerIterator end(charEnd, false);
+  CanonicalIterator cstart(charStart, true);
+  CanonicalIterator cend(charEnd, false);
+
+  bliss::kmer::transform::lex_less<KmerType> canonical;
+
+  int i = 0;
+  for (; (start != end) && (cstart != cend); ++start, ++cstart, ++i) {
+    EXPECT_EQ(canonical(*start), *cstart) << "canonical kmer differs at " << i;
+  }
+  EXPECT_TRUE(start == end);
+  EXPECT_TRUE(cstart == cend);
+  EXPECT_EQ(static_cast<int>(input.size()) - K + 1, i);
+}
+
+
 /**
  * Test k-mer generation with 2 bits for each character
  */
@@ -120,3 +154,18 @@ TEST(KmerIterator, TestKmerIteratorDNA5MultiWord)
 }
 
 
+/**
+ * Test canonical k-mer generation against lex_less of the forward k-mers
+ */
+TEST(KmerIterator, TestCanonicalKmerIterator)
+{
+  std::string input = "GATTTGGGGTTCAAAGCAGT"
+                         "ATCGATCAAATAGTAAATCC"
+                         "ATTTGTTCAACTCACAGTTT";
+
+  compute_canonical_kmer_iter<bliss::common::DNA, 21>(input);
+  compute_canonical_kmer_iter<bliss::common::DNA, 31>(input);
+  compute_canonical_kmer_iter<bliss::common::DNA, 33>(input);
+  compute_canonical_kmer_iter<bliss::common::DNA5, 21>(input);
+  compute_canonical_kmer_iter<bliss::common::DNA16, 21>(input);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    test_kmer_protein.cpp
+ * @ingroup
+ * @brief   k-mers over the amino acid alphabets:  packing, reverse, and ascii translation.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <random>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "common/alphabet_traits.hpp"
+
+
+template <typename T>
+class KmerProteinTest : public ::testing::Test {
+  protected:
+    /// characters as added, oldest first.
+    std::vector<uint8_t> chars;
+    T kmer;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<unsigned int> distribution(0, 19);  // standard residues, or groups and X.
+
+      for (unsigned int i = 0; i < T::size; ++i) {
+        chars.push_back(distribution(generator) % T::KmerAlphabet::SIZE);
+        kmer.nextFromChar(chars.back());
+      }
+    }
+};
+
+// 1 word, several words, and words that 5 bit characters span.
+typedef ::testing::Types<
+    ::bliss::common::Kmer<12, bliss::common::AA, uint64_t>,
+    ::bliss::common::Kmer< 5, bliss::common::AA, uint64_t>,
+    ::bliss::common::Kmer<31, bliss::common::AA, uint64_t>,
+    ::bliss::common::Kmer<13, bliss::common::AA, uint8_t>,
+    ::bliss::common::Kmer< 9, bliss::common::AA, uint16_t>,
+    ::bliss::common::Kmer<16, bliss::common::AA_MURPHY10, uint64_t>,
+    ::bliss::common::Kmer<21, bliss::common::AA_MURPHY10, uint32_t>
+> KmerProteinTestTypes;
+TYPED_TEST_CASE(KmerProteinTest, KmerProteinTestTypes);
+
+
+TYPED_TEST(KmerProteinTest, packing)
+{
+  constexpr unsigned int bits = ::bliss::common::AlphabetTraits<typename TypeParam::KmerAlphabet>::getBitsPerChar();
+  EXPECT_EQ(bits, static_cast<unsigned int>(TypeParam::bitsPerChar));
+  EXPECT_EQ(TypeParam::size * bits, TypeParam::nBits);
+
+  // the most recent character is at position 0.
+  for (unsigned int i = 0; i < TypeParam::size; ++i) {
+    EXPECT_EQ(this->chars[TypeParam::size - 1 - i], this->kmer.getCharsAtPos(i, 1)) << "pos " << i;
+  }
+}
+
+TYPED_TEST(KmerProteinTest, reverse)
+{
+  TypeParam expected;
+  for (unsigned int i = 0; i < TypeParam::size; ++i) {
+    expected.nextFromChar(this->chars[TypeParam::size - 1 - i]);
+  }
+
+  EXPECT_EQ(expected, this->kmer.reverse());
+  EXPECT_EQ(this->kmer, this->kmer.reverse().reverse());
+
+  // no complement.
+  EXPECT_EQ(expected, this->kmer.reverse_complement());
+
+  // shifted by 1 character either way.
+  TypeParam left = expected;
+  left.nextFromChar(0);
+  EXPECT_EQ(left, this->kmer.reverse_shift(1));
+
+  TypeParam right = expected;
+  right.nextReverseFromChar(0);
+  EXPECT_EQ(right, this->kmer.reverse_shift(-1));
+}
+
+
+TEST(ProteinAlphabetTest, ascii)
+{
+  using AA = ::bliss::common::AA;
+  using MURPHY = ::bliss::common::AA_MURPHY10;
+
+  EXPECT_EQ(5U, ::bliss::common::AlphabetTraits<AA>::getBitsPerChar());
+  EXPECT_EQ(4U, ::bliss::common::AlphabetTraits<MURPHY>::getBitsPerChar());
+
+  std::string residues("ACDEFGHIKLMNPQRSTVWYXBZJUO");
+  for (size_t i = 0; i < residues.size(); ++i) {
+    unsigned char c = residues[i];
+    EXPECT_EQ(c, AA::TO_ASCII[AA::FROM_ASCII[c]]);
+    EXPECT_EQ(AA::FROM_ASCII[c], AA::FROM_ASCII[c | 0x20]);
+    EXPECT_EQ(MURPHY::FROM_ASCII[c], MURPHY::FROM_ASCII[c | 0x20]);
+    if (i < 20) {
+      EXPECT_EQ(i, AA::FROM_ASCII[c]);
+    }
+  }
+  EXPECT_EQ(AA::FROM_ASCII['X'], AA::FROM_ASCII['*']);
+  EXPECT_EQ(AA::FROM_ASCII['-'], AA::FROM_ASCII['.']);
+  EXPECT_EQ('.', AA::TO_ASCII[AA::FROM_ASCII['-']]);
+
+  // groups.
+  std::vector<std::string> groups = {"LVIMJ", "CU", "A", "G", "ST", "P", "FYW", "EDNQBZ", "KRO", "H", "X"};
+  for (auto const & g : groups) {
+    for (char c : g) {
+      EXPECT_EQ(MURPHY::FROM_ASCII[static_cast<unsigned char>(g[0])], MURPHY::FROM_ASCII[static_cast<unsigned char>(c)]) << c;
+    }
+  }
+  EXPECT_EQ('L', MURPHY::TO_ASCII[MURPHY::FROM_ASCII['V']]);
+  EXPECT_EQ('E', MURPHY::TO_ASCII[MURPHY::FROM_ASCII['Q']]);
+}
+
+TEST(ProteinAlphabetTest, kmer_size)
+{
+  // 12 residues in 1 word instead of 2 for ascii.
+  EXPECT_EQ(1U, (::bliss::common::Kmer<12, bliss::common::AA, uint64_t>::nWords));
+  EXPECT_EQ(2U, (::bliss::common::Kmer<12, bliss::common::ASCII, uint64_t>::nWords));
+  EXPECT_EQ(1U, (::bliss::common::Kmer<16, bliss::common::AA_MURPHY10, uint64_t>::nWords));
+
+  // from ascii.
+  std::string seq("MKTAYIAKQR");
+  ::bliss::common::Kmer<10, bliss::common::AA, uint64_t> km(seq);
+  for (size_t i = 0; i < seq.size(); ++i) {
+    EXPECT_EQ(seq[seq.size() - 1 - i], bliss::common::AA::TO_ASCII[km.getCharsAtPos(i, 1)]);
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/sequence.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+
+TEST(PackedSequenceKmerId, size)
+{
+  EXPECT_EQ(6UL, sizeof(::bliss::common::PackedSequenceKmerId<12, 4, 6>));
+  EXPECT_EQ(5UL, sizeof(::bliss::common::PackedSequenceKmerId<0, 2, 5>));
+  EXPECT_EQ(1UL, alignof(::bliss::common::PackedSequenceKmerId<12, 4, 6>));
+
+  using KmerType = ::bliss::common::Kmer<15, ::bliss::common::DNA, uint32_t>;
+  EXPECT_EQ(12UL, (sizeof(std::pair<KmerType, ::bliss::common::PackedSequenceKmerId<12, 4, 6> >)));
+  EXPECT_EQ(16UL, (sizeof(std::pair<KmerType, ::bliss::common::LongSequenceKmerId>)));
+}
+
+TEST(PackedSequenceKmerId, round_trip)
+{
+  using IdType = ::bliss::common::PackedSequenceKmerId<12, 4, 6>;
+  EXPECT_EQ(32UL, IdType::RECORD_BITS);
+
+  ::bliss::common::SequenceId sid;
+  sid.pos_in_file = 0xFFFFFFFFUL;
+  sid.file_id = 15;
+
+  IdType id(sid);
+  EXPECT_EQ(0xFFFFFFFFUL, id.get_id());
+  EXPECT_EQ(0xFFFFFFFFUL, id.get_pos());
+  EXPECT_EQ(15, id.get_file_id());
+
+  id += 4095;
+  EXPECT_EQ(0xFFFFFFFFUL, id.get_id());
+  EXPECT_EQ(0xFFFFFFFFUL + 4095UL, id.get_pos());
+  EXPECT_EQ(15, id.get_file_id());
+
+  id -= 95;
+  EXPECT_EQ(0xFFFFFFFFUL + 4000UL, id.get_pos());
+
+  IdType first(sid);
+  EXPECT_EQ(4000, id - first);
+  EXPECT_EQ(-4000, first - id);
+  EXPECT_TRUE(first < id);
+  EXPECT_TRUE(id > first);
+  EXPECT_FALSE(id == first);
+  IdType copy = id;
+  EXPECT_TRUE(id == copy);
+}
+
+TEST(PackedSequenceKmerId, file_position_only)
+{
+  // no in-record field:  the id holds the kmer's position in the file, as with LongSequenceKmerId.
+  using IdType = ::bliss::common::PackedSequenceKmerId<0, 2, 5>;
+  IdType id(1000, 3);
+  id += 24;
+  EXPECT_EQ(1024UL, id.get_id());
+  EXPECT_EQ(1024UL, id.get_pos());
+  EXPECT_EQ(3, id.get_file_id());
+}
+
+TEST(PackedSequenceKmerId, overflow)
+{
+  using IdType = ::bliss::common::PackedSequenceKmerId<12, 4, 6>;
+
+  EXPECT_THROW(IdType(0x100000000UL, 0), std::invalid_argument);
+  EXPECT_THROW(IdType(0, 16), std::invalid_argument);
+
+  IdType id(10, 1);
+  EXPECT_THROW(id += 4096, std::invalid_argument);
+  EXPECT_THROW(id -= 1, std::invalid_argument);
+  id += 4095;
+  EXPECT_THROW(id += 1, std::invalid_argument);
+
+  EXPECT_TRUE(IdType::fits(0x100000000UL, 4096, 16));
+  EXPECT_FALSE(IdType::fits(0x100000001UL, 4096, 16));
+  EXPECT_FALSE(IdType::fits(1000, 4097, 16));
+  EXPECT_FALSE(IdType::fits(1000, 100, 17));
+}
@@ -0,0 +1,481 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    compact_counting_map.hpp
+ * @ingroup fsc::containers
+ * @brief   counting hash map with 8 bit counters in the table, and an overflow table for large counts.
+ * @details most kmers have small counts, so storing a full 32 or 64 bit count per kmer is wasteful.
+ *          this map stores an 8 bit counter with each key in a ::fsc::soa_hash_map.  counts up to 254 are stored in line.
+ *          a counter value of 255 indicates that the count is in the overflow table, which is a second, much smaller,
+ *          ::fsc::soa_hash_map from key to T.
+ *
+ *          for a 64 bit kmer, a slot is 10 bytes (key, counter, probe distance), compared to 16 bytes for ::std::pair<Kmer, uint32_t>.
+ *
+ *          the template parameters are the same as ::fsc::densehash_map, so this can be used as the Container
+ *          for the ::dsc densehash counting maps.  T is the type of the counts as seen by the user.
+ *
+ *          iterators dereference to ::std::pair<Key const &, count_reference>.  count_reference converts to T,
+ *          and assigning a T to it updates the in line counter or the overflow table.  so
+ *          it->second = it->second + 1  works as with a map of T.   the mapped value cannot be bound to a T&, however,
+ *          so update() reads the count into a T, applies the updater, then writes the count back.
+ */
+#ifndef SRC_CONTAINERS_COMPACT_COUNTING_MAP_HPP_
+#define SRC_CONTAINERS_COMPACT_COUNTING_MAP_HPP_
+
+#include <vector>
+#include <functional>  // hash, equal_to, etc
+#include <utility>   // pair
+#include <iterator>
+#include <type_traits>
+#include <limits>
+#include <cstdint>  // uint8_t
+
+#include "containers/soa_hash_map.hpp"
+#include "containers/fsc_container_utils.hpp"
+#include "utils/transform_utils.hpp"
+
+namespace fsc {  // fast standard container
+
+
+/**
+ * @brief counting map with 8 bit in line counters and an overflow table for counts >= 255.
+ * @details  see file description.  interface follows ::fsc::densehash_map.
+ */
+template <typename Key,
+typename T,
+typename SpecialKeys = ::fsc::soa::no_special_keys,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+bool split = SpecialKeys::need_to_split >
+class compact_counting_map {
+
+    static_assert(::std::is_integral<T>::value && !::std::is_signed<T>::value, "count type has to be unsigned integral");
+
+  protected:
+    using counter_type = uint8_t;
+
+    /// counter value indicating that the count is in the overflow table.
+    static constexpr counter_type overflow_flag = ::std::numeric_limits<counter_type>::max();
+
+    using counter_map_type = ::fsc::soa_hash_map<Key, counter_type, SpecialKeys, Transform, Hash, Equal,
+        typename ::std::allocator_traits<Allocator>::template rebind_alloc<::std::pair<const Key, counter_type> >, split>;
+    using overflow_map_type = ::fsc::soa_hash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split>;
+
+    counter_map_type counts;
+    overflow_map_type overflow;
+
+    /// decode a counter
+    inline T get_count(Key const & k, counter_type const & c) const {
+      return (c == overflow_flag) ? overflow.find(k)->second : static_cast<T>(c);
+    }
+
+    /// encode a count into counter, or to the overflow table.
+    inline void set_count(Key const & k, counter_type & c, T const & v) {
+      if (v < static_cast<T>(overflow_flag)) {
+        if (c == overflow_flag) overflow.erase(&k, &k + 1);
+        c = static_cast<counter_type>(v);
+      } else {
+        c = overflow_flag;
+        auto result = overflow.insert(::std::make_pair(k, v));
+        if (!result.second) result.first->second = v;
+      }
+    }
+
+    /// remove the overflow entry if any.  called before the counter is erased.
+    inline void erase_overflow(Key const & k, counter_type const & c) {
+      if (c == overflow_flag) overflow.erase(&k, &k + 1);
+    }
+
+  public:
+
+    /// proxy for a mapped value.  reads and writes go through the in line counter.
+    class count_reference {
+        friend class compact_counting_map;
+
+        compact_counting_map * m;
+        Key const & k;
+        counter_type & c;
+
+        count_reference(compact_counting_map * _m, Key const & _k, counter_type & _c) : m(_m), k(_k), c(_c) {}
+
+      public:
+        operator T() const {
+          return m->get_count(k, c);
+        }
+        count_reference & operator=(T const & v) {
+          m->set_count(k, c, v);
+          return *this;
+        }
+        count_reference & operator=(count_reference const & other) {
+          return this->operator=(static_cast<T>(other));
+        }
+    };
+
+    using key_type              = Key;
+    using mapped_type           = T;
+    using value_type            = ::std::pair<const Key, T>;
+    using hasher                = Hash;
+    using key_equal             = Equal;
+    using allocator_type        = Allocator;
+    using reference             = ::std::pair<const Key &, count_reference>;
+    using const_reference       = ::std::pair<const Key &, T>;
+    using size_type             = size_t;
+    using difference_type       = ptrdiff_t;
+
+  protected:
+    /// proxy so that it->second works when the iterator dereferences to a temporary pair.
+    template <typename Ref>
+    struct arrow_proxy {
+        Ref r;
+        Ref * operator->() { return &r; }
+    };
+
+    template <bool IS_CONST>
+    class compact_iterator {
+        friend class compact_counting_map;
+        template <bool> friend class compact_iterator;
+
+        using map_ptr = typename ::std::conditional<IS_CONST, compact_counting_map const *, compact_counting_map *>::type;
+        using base_iter = typename ::std::conditional<IS_CONST,
+            typename counter_map_type::const_iterator, typename counter_map_type::iterator>::type;
+
+        map_ptr m;
+        base_iter it;
+
+      public:
+        using iterator_category = ::std::forward_iterator_tag;
+        using value_type = typename compact_counting_map::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = typename ::std::conditional<IS_CONST,
+            typename compact_counting_map::const_reference, typename compact_counting_map::reference>::type;
+        using pointer = arrow_proxy<reference>;
+
+        compact_iterator() : m(nullptr), it() {}
+        compact_iterator(map_ptr _m, base_iter const & _it) : m(_m), it(_it) {}
+
+        /// conversion from non-const to const iterator
+        template <bool C = IS_CONST, typename = typename ::std::enable_if<C>::type>
+        compact_iterator(compact_iterator<false> const & other) : m(other.m), it(other.it) {}
+
+        template <bool C = IS_CONST>
+        typename ::std::enable_if<!C, reference>::type operator*() const {
+          auto x = *it;
+          return reference(x.first, count_reference(m, x.first, x.second));
+        }
+        template <bool C = IS_CONST>
+        typename ::std::enable_if<C, reference>::type operator*() const {
+          auto x = *it;
+          return reference(x.first, m->get_count(x.first, x.second));
+        }
+        pointer operator->() const {
+          return pointer{this->operator*()};
+        }
+
+        compact_iterator & operator++() {
+          ++it;
+          return *this;
+        }
+        compact_iterator operator++(int) {
+          compact_iterator out(*this);
+          ++it;
+          return out;
+        }
+
+        bool operator==(compact_iterator const & other) const {
+          return it == other.it;
+        }
+        bool operator!=(compact_iterator const & other) const {
+          return it != other.it;
+        }
+    };
+
+  public:
+    using iterator              = compact_iterator<false>;
+    using const_iterator        = compact_iterator<true>;
+    using pointer               = typename iterator::pointer;
+    using const_pointer         = typename const_iterator::pointer;
+
+
+    compact_counting_map(size_type bucket_count = 128) :
+      counts(bucket_count), overflow() {};
+
+    template<class InputIt>
+    compact_counting_map(InputIt first, InputIt last) :
+      compact_counting_map(std::distance(first, last)) {
+      this->insert(first, last);
+    };
+
+    virtual ~compact_counting_map() {};
+
+    float get_max_load_factor() const {
+      return counts.get_max_load_factor();
+    }
+
+    iterator begin() {
+      return iterator(this, counts.begin());
+    }
+    const_iterator begin() const {
+      return cbegin();
+    }
+    const_iterator cbegin() const {
+      return const_iterator(this, counts.cbegin());
+    }
+
+    iterator end() {
+      return iterator(this, counts.end());
+    }
+    const_iterator end() const {
+      return cend();
+    }
+    const_iterator cend() const {
+      return const_iterator(this, counts.cend());
+    }
+
+
+    std::vector<Key> keys() const {
+      return counts.keys();
+    }
+    void keys(std::vector<Key> & ks) const {
+      counts.keys(ks);
+    }
+
+    std::vector<std::pair<Key, T> > to_vector() const {
+      std::vector<std::pair<Key, T>> vs;
+
+      to_vector(vs);
+
+      return vs;
+    }
+    void to_vector(  std::vector<std::pair<Key, T> > & vs) const {
+      vs.clear();
+      vs.reserve(size());
+
+      for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        vs.emplace_back((*it).first, get_count((*it).first, (*it).second));
+      }
+    }
+
+    /// number of entries whose count is stored in the overflow table.
+    size_type overflow_size() const {
+      return overflow.size();
+    }
+
+    bool empty() const {
+      return counts.empty();
+    }
+
+    size_type size() const {
+      return counts.size();
+    }
+    size_type unique_size() const {
+      return counts.size();
+    }
+
+    void reset() {
+      counts.reset();
+      overflow.reset();
+    }
+
+    void clear() {
+      counts.clear();
+      overflow.clear();
+    }
+
+    void resize(size_t const n) {
+      counts.resize(n);
+    }
+
+    /// rehash for new count number of BUCKETS.  iterators are invalidated.
+    void rehash(size_type count) {
+      this->resize(count);
+    }
+
+    size_type bucket_count() const {
+      return counts.bucket_count();
+    }
+
+    float load_factor() const {
+      return counts.load_factor();
+    }
+
+
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+      for (; first != last; ++first) {
+        this->insert(*first);
+      }
+    }
+
+    void insert(::std::vector<::std::pair<Key, T> > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    void insert(::std::vector<value_type > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    /// insert if absent.  existing counts are not modified, same as std::unordered_map
+    template <typename K = Key, typename = typename std::enable_if<!std::is_const<Key>::value> >
+    std::pair<iterator, bool> insert(::std::pair<Key, T> const & x) {
+      auto result = counts.insert(::std::make_pair(x.first, static_cast<counter_type>(0)));
+      if (result.second) {
+        auto y = *(result.first);
+        set_count(y.first, y.second, x.second);
+      }
+      return std::make_pair(iterator(this, result.first), result.second);
+    }
+
+    std::pair<iterator, bool> insert(::std::pair<const Key, T> const & x) {
+      return this->insert(::std::pair<Key, T>(x.first, x.second));
+    }
+
+    template <typename V, typename Updater>
+    size_t update(::std::vector<::std::pair<Key, V> > & input, Updater const & op) {
+
+      if (input.size() == 0) return 0;
+
+      size_t count = 0;
+      T val;
+
+      for (auto vv : input) {
+        auto iter = counts.find(vv.first);
+        if (iter == counts.end()) continue;
+
+        // update a copy of the count, then write it back
+        auto x = *iter;
+        val = get_count(x.first, x.second);
+        count += op(val, vv.second );
+        set_count(x.first, x.second, val);
+      }
+
+      return count;
+    }
+
+    // non distributed version
+    template <typename Filter, typename Updater>
+    size_t update(Filter const & fop, Updater const & op) {
+      size_t count = 0;
+
+      for (auto iter = counts.begin(); iter != counts.end(); ++iter) {
+        auto x = *iter;
+        ::std::pair<Key, T> v(x.first, get_count(x.first, x.second));
+        if (fop(v)) {
+          count += op(v.second);
+          set_count(x.first, x.second, v.second);
+        }
+      }
+
+      return count;
+    }
+
+
+    template <typename InputIt, typename Pred>
+    size_t erase(InputIt first, InputIt last, Pred const & pred) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      size_t count = 0;
+
+      for (; first != last; ++first) {
+        auto iter = counts.find(*first);
+        if (iter == counts.end()) continue;
+
+        auto x = *iter;
+        if (pred(::std::pair<Key, T>(x.first, get_count(x.first, x.second)))) {
+          Key const k = x.first;
+          erase_overflow(k, x.second);
+          counts.erase(&k, &k + 1);
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    template <typename InputIt>
+    size_t erase(InputIt first, InputIt last) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      size_t count = 0;
+
+      for (; first != last; ++first) {
+        auto iter = counts.find(*first);
+        if (iter == counts.end()) continue;
+
+        auto x = *iter;
+        Key const k = x.first;
+        erase_overflow(k, x.second);
+        counts.erase(&k, &k + 1);
+        ++count;
+      }
+      return count;
+    }
+
+    template <typename Pred>
+    size_t erase(Pred const & pred) {
+      return counts.erase([this, &pred](typename counter_map_type::reference const & x) {
+        if (pred(::std::pair<Key, T>(x.first, this->get_count(x.first, x.second)))) {
+          this->erase_overflow(x.first, x.second);
+          return true;
+        }
+        return false;
+      });
+    }
+
+    size_type count(Key const & key) const {
+      return counts.count(key);
+    }
+
+
+    ::std::pair<iterator, iterator> equal_range(Key const & key) {
+      auto range = counts.equal_range(key);
+      return ::std::make_pair(iterator(this, range.first), iterator(this, range.second));
+    }
+    ::std::pair<const_iterator, const_iterator> equal_range(Key const & key) const {
+      auto range = counts.equal_range(key);
+      return ::std::make_pair(const_iterator(this, range.first), const_iterator(this, range.second));
+    }
+
+    iterator find(Key const &key) {
+      return iterator(this, counts.find(key));
+    }
+
+    const_iterator find(Key const &key) const {
+      return const_iterator(this, counts.find(key));
+    }
+
+    /// prefetch the home slot of a key, ahead of find/count/equal_range.
+    inline void prefetch(Key const & key) const {
+      counts.prefetch(key);
+    }
+
+    inline bool exists(Key const & key) const {
+      return counts.exists(key);
+    }
+
+};
+
+
+}  // namespace fsc
+
+#endif /* SRC_CONTAINERS_COMPACT_COUNTING_MAP_HPP_ */
@@ -0,0 +1,775 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    concurrent_densehash_map.hpp
+ * @ingroup fsc::containers
+ * @brief   open addressing hash map that multiple threads can insert into and reduce into without locks.
+ * @details ::fsc::thread_partitioned keeps 1 sub-table per thread.  this map is a single table shared by all threads:
+ *          a slot is claimed with a compare-and-swap on a 1 byte state (empty -> busy), the claiming thread writes
+ *          the key and value, then publishes the slot (busy -> full).  threads that probe a busy slot wait for it to be
+ *          published before comparing keys.  an existing value is reduced into with an atomic fetch-add for ::std::plus,
+ *          and with a compare-and-swap loop for other reducers.  no empty or deleted key is needed.
+ *
+ *          linear probing is used (robin hood displacement can not be done with single slot CAS).  the capacity is
+ *          fixed while threads insert.  the bulk insert functions insert in rounds, each round no larger than the
+ *          remaining headroom under the max load factor, and grow the table between rounds.  the rounds are
+ *          distributed to the OpenMP threads in chunks by a ::bliss::partition::DemandDrivenPartitioner.
+ *          threads managed by the caller can use concurrent_insert() directly, after resize() to the expected size.
+ *
+ *          growing the table reinserts the entries with all OpenMP threads once the table is large, claiming the new
+ *          slots with the same compare-and-swap.
+ *
+ *          erase, resize, and iteration are NOT thread safe.  erase shifts the following entries back, so there are
+ *          no tombstones.
+ *
+ *          the template parameters are the same as ::fsc::densehash_map, so this can be used as the Container
+ *          for ::dsc::densehash_map_base.  SpecialKeys is only used to construct the Equal object when that
+ *          requires (empty, deleted) keys, e.g. ::fsc::sparsehash::compare.  the split parameter is ignored.
+ *          the atomic operations require the GCC __atomic builtins, and the mapped type has to be 1, 2, 4, or 8 bytes.
+ */
+#ifndef SRC_CONTAINERS_CONCURRENT_DENSEHASH_MAP_HPP_
+#define SRC_CONTAINERS_CONCURRENT_DENSEHASH_MAP_HPP_
+
+#include <vector>
+#include <functional>  // hash, equal_to, plus
+#include <utility>   // pair
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>   // length_error
+#include <cmath>   // ceil
+#include <cstdint>  // uint8_t
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "containers/fsc_container_utils.hpp"
+#include "containers/soa_hash_map.hpp"   // make_equal, no_special_keys
+#include "partition/range.hpp"
+#include "partition/partitioner.hpp"
+#include "utils/transform_utils.hpp"
+
+namespace fsc {  // fast standard container
+
+  namespace concurrent {
+
+    /// reducers that can be applied with a single atomic fetch-add.
+    template <typename Reducer, typename T>
+    struct is_atomic_add : public ::std::false_type {};
+    template <typename T>
+    struct is_atomic_add<::std::plus<T>, T> : public ::std::integral_constant<bool, ::std::is_integral<T>::value> {};
+
+    /// placeholder reducer for insertion without reduction.
+    struct no_reduce {};
+
+  }  // namespace concurrent
+
+
+/**
+ * @brief open addressing, linear probing hash map with lock free concurrent insertion and reduction.
+ * @details  see file description.  interface follows ::fsc::densehash_map.
+ *           capacity is a power of 2.  max load factor is 0.7.
+ */
+template <typename Key,
+typename T,
+typename SpecialKeys = ::fsc::soa::no_special_keys,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+bool split = SpecialKeys::need_to_split >
+class concurrent_densehash_map {
+
+    static_assert((sizeof(T) == 1) || (sizeof(T) == 2) || (sizeof(T) == 4) || (sizeof(T) == 8),
+                  "concurrent_densehash_map requires a mapped type that can be updated atomically");
+
+  protected:
+    using key_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<Key>;
+    using val_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    using state_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<uint8_t>;
+
+    /// slot states
+    static constexpr uint8_t EMPTY = 0;
+    static constexpr uint8_t BUSY = 1;
+    static constexpr uint8_t FULL = 2;
+
+    /// input elements per chunk handed to a thread in bulk insert.
+    static constexpr size_t chunk_size = 4096;
+    /// old table size from which a rehash is done by all threads.
+    static constexpr size_t parallel_rehash_min = 1UL << 16;
+
+    SpecialKeys specials;
+    Hash hash;
+    Equal eq;
+
+    ::std::vector<Key, key_alloc_type> keys_;
+    ::std::vector<T, val_alloc_type> vals_;
+    ::std::vector<uint8_t, state_alloc_type> state_;
+
+    size_t mask;
+    size_t count_;
+    float max_load;
+
+  public:
+    using key_type              = Key;
+    using mapped_type           = T;
+    using value_type            = ::std::pair<const Key, T>;
+    using hasher                = Hash;
+    using key_equal             = Equal;
+    using allocator_type        = Allocator;
+    using reference             = ::std::pair<const Key &, T &>;
+    using const_reference       = ::std::pair<const Key &, const T &>;
+    using size_type             = size_t;
+    using difference_type       = ptrdiff_t;
+
+  protected:
+    /// proxy so that it->second works when the iterator dereferences to a temporary pair of references.
+    template <typename Ref>
+    struct arrow_proxy {
+        Ref r;
+        Ref * operator->() { return &r; }
+    };
+
+    template <bool IS_CONST>
+    class concurrent_iterator {
+        friend class concurrent_densehash_map;
+        template <bool> friend class concurrent_iterator;
+
+        using map_ptr = typename ::std::conditional<IS_CONST, concurrent_densehash_map const *, concurrent_densehash_map *>::type;
+
+        map_ptr m;
+        size_t pos;
+
+        /// move to the next occupied slot, starting at pos.
+        inline void skip_empty() {
+          size_t const cap = m->state_.size();
+          while ((pos < cap) && (m->state_[pos] != FULL)) ++pos;
+        }
+
+      public:
+        using iterator_category = ::std::forward_iterator_tag;
+        using value_type = typename concurrent_densehash_map::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = typename ::std::conditional<IS_CONST,
+            typename concurrent_densehash_map::const_reference, typename concurrent_densehash_map::reference>::type;
+        using pointer = arrow_proxy<reference>;
+
+        concurrent_iterator() : m(nullptr), pos(0) {}
+        concurrent_iterator(map_ptr _m, size_t _pos) : m(_m), pos(_pos) {}
+
+        /// conversion from non-const to const iterator
+        template <bool C = IS_CONST, typename = typename ::std::enable_if<C>::type>
+        concurrent_iterator(concurrent_iterator<false> const & other) : m(other.m), pos(other.pos) {}
+
+        reference operator*() const {
+          return reference(m->keys_[pos], m->vals_[pos]);
+        }
+        pointer operator->() const {
+          return pointer{this->operator*()};
+        }
+
+        concurrent_iterator & operator++() {
+          ++pos;
+          skip_empty();
+          return *this;
+        }
+        concurrent_iterator operator++(int) {
+          concurrent_iterator out(*this);
+          ++(*this);
+          return out;
+        }
+
+        bool operator==(concurrent_iterator const & other) const {
+          return pos == other.pos;
+        }
+        bool operator!=(concurrent_iterator const & other) const {
+          return pos != other.pos;
+        }
+    };
+
+  public:
+    using iterator              = concurrent_iterator<false>;
+    using const_iterator        = concurrent_iterator<true>;
+    using pointer               = typename iterator::pointer;
+    using const_pointer         = typename const_iterator::pointer;
+
+  protected:
+
+    inline size_t home(Key const & key) const {
+      return hash(key) & mask;
+    }
+
+    /// number of entries allowed at the current capacity.
+    inline size_t max_count() const {
+      return static_cast<size_t>(max_load * static_cast<float>(state_.size()));
+    }
+
+    /// position of key, or capacity if not found.  NOT safe during concurrent insertion.
+    size_t find_pos(Key const & key) const {
+      size_t pos = home(key);
+      for (size_t i = 0; i < state_.size(); ++i) {
+        if (state_[pos] == EMPTY) break;
+        if (eq(keys_[pos], key)) return pos;
+        pos = (pos + 1) & mask;
+      }
+      return state_.size();
+    }
+
+    /**
+     * @brief find or claim the slot for a key.  thread safe against other claim_pos calls.
+     * @return position of the key, and whether this call placed it.  when placed, the value is val.
+     */
+    ::std::pair<size_t, bool> claim_pos(Key const & key, T const & val) {
+      size_t pos = home(key);
+      uint8_t st;
+      for (size_t i = 0; i < state_.size(); ++i) {
+        st = __atomic_load_n(&(state_[pos]), __ATOMIC_ACQUIRE);
+
+        if (st == EMPTY) {
+          uint8_t expected = EMPTY;
+          if (__atomic_compare_exchange_n(&(state_[pos]), &expected, BUSY, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            keys_[pos] = key;
+            vals_[pos] = val;
+            __atomic_store_n(&(state_[pos]), FULL, __ATOMIC_RELEASE);
+            __atomic_fetch_add(&count_, 1, __ATOMIC_RELAXED);
+            return ::std::make_pair(pos, true);
+          }
+          // lost the race.  expected now holds the state set by the other thread.
+          st = expected;
+        }
+
+        // another thread is writing the key.  wait for it to be published.
+        while (st == BUSY) st = __atomic_load_n(&(state_[pos]), __ATOMIC_ACQUIRE);
+
+        if (eq(keys_[pos], key)) return ::std::make_pair(pos, false);
+
+        pos = (pos + 1) & mask;
+      }
+      throw ::std::length_error("concurrent_densehash_map: table is full.  resize before concurrent insertion.");
+    }
+
+    /// reduce into an existing value with a single atomic add.
+    template <typename Reducer>
+    inline typename ::std::enable_if<::fsc::concurrent::is_atomic_add<Reducer, T>::value>::type
+    reduce_at(size_t pos, T const & val, Reducer &) {
+      __atomic_fetch_add(&(vals_[pos]), val, __ATOMIC_RELAXED);
+    }
+
+    /// reduce into an existing value with a compare-and-swap loop.
+    template <typename Reducer>
+    inline typename ::std::enable_if<!::fsc::concurrent::is_atomic_add<Reducer, T>::value>::type
+    reduce_at(size_t pos, T const & val, Reducer & r) {
+      T old_val, new_val;
+      __atomic_load(&(vals_[pos]), &old_val, __ATOMIC_RELAXED);
+      do {
+        new_val = r(old_val, val);
+      } while (!__atomic_compare_exchange(&(vals_[pos]), &old_val, &new_val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+
+    /// remove the entry at pos, shifting back the following entries that probed past it.
+    void erase_pos(size_t pos) {
+      size_t next = (pos + 1) & mask;
+      size_t h;
+      while (state_[next] != EMPTY) {
+        h = home(keys_[next]);
+        // move the entry at next back if its home is not in (pos, next], cyclically.
+        if (((next - h) & mask) >= ((next - pos) & mask)) {
+          keys_[pos] = ::std::move(keys_[next]);
+          vals_[pos] = ::std::move(vals_[next]);
+          pos = next;
+        }
+        next = (next + 1) & mask;
+      }
+      state_[pos] = EMPTY;
+      --count_;
+    }
+
+    /// smallest power of 2 capacity that holds n elements under max load factor.
+    size_t capacity_for(size_t n) const {
+      size_t needed = static_cast<size_t>(::std::ceil(static_cast<double>(n + 1) / max_load));
+      size_t cap = 8;
+      while (cap < needed) cap <<= 1;
+      return cap;
+    }
+
+    /**
+     * @brief move the FULL entries of old slots [first, last) into the current table.
+     * @details  with concurrent set, a slot is claimed with a compare-and-swap (empty -> full), so that threads
+     *           reinserting disjoint old ranges can share the new table.  the keys are unique, so no thread reads a key
+     *           while another writes it, and the slot can be published before its key and value are written.
+     */
+    void reinsert_range(::std::vector<Key, key_alloc_type> & old_keys, ::std::vector<T, val_alloc_type> & old_vals,
+                        ::std::vector<uint8_t, state_alloc_type> const & old_state, size_t first, size_t last,
+                        bool concurrent) {
+      size_t pos;
+      uint8_t expected;
+      for (size_t i = first; i < last; ++i) {
+        if (old_state[i] != FULL) continue;
+
+        pos = home(old_keys[i]);
+        if (concurrent) {
+          while (true) {
+            expected = EMPTY;
+            if ((__atomic_load_n(&(state_[pos]), __ATOMIC_RELAXED) == EMPTY) &&
+                __atomic_compare_exchange_n(&(state_[pos]), &expected, FULL, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+            pos = (pos + 1) & mask;
+          }
+        } else {
+          while (state_[pos] != EMPTY) pos = (pos + 1) & mask;
+          state_[pos] = FULL;
+        }
+        keys_[pos] = ::std::move(old_keys[i]);
+        vals_[pos] = ::std::move(old_vals[i]);
+      }
+    }
+
+    /**
+     * @brief reallocate to new_cap buckets (power of 2) and reinsert all entries.
+     * @details  tables of at least parallel_rehash_min slots are reinserted by all OpenMP threads, each taking a
+     *           contiguous range of the old slots.  entries are claimed as in reinsert_range.
+     */
+    void rehash_to(size_t new_cap) {
+      ::std::vector<Key, key_alloc_type> old_keys(new_cap);
+      ::std::vector<T, val_alloc_type> old_vals(new_cap);
+      ::std::vector<uint8_t, state_alloc_type> old_state(new_cap, EMPTY);
+      old_keys.swap(keys_);
+      old_vals.swap(vals_);
+      old_state.swap(state_);
+      mask = new_cap - 1;
+
+      size_t const n = old_state.size();
+      int nthreads = 1;
+#if defined(USE_OPENMP)
+      if (n >= parallel_rehash_min) nthreads = omp_get_max_threads();
+#endif
+      if (nthreads <= 1) {
+        reinsert_range(old_keys, old_vals, old_state, 0, n, false);
+        return;
+      }
+
+#if defined(USE_OPENMP)
+#pragma omp parallel num_threads(nthreads)
+      {
+        size_t const tid = omp_get_thread_num();
+        size_t const nts = omp_get_num_threads();
+        reinsert_range(old_keys, old_vals, old_state, (n * tid) / nts, (n * (tid + 1)) / nts, true);
+      }
+#endif
+    }
+
+    /// grow so that at least min(remaining, current size) more entries fit, and return the number that fit.
+    size_t make_room(size_t remaining) {
+      size_t room = max_count() - count_;
+      if (room < ::std::min(remaining, ::std::max(count_, chunk_size))) {
+        resize(count_ + ::std::min(remaining, ::std::max(count_, chunk_size)));
+        room = max_count() - count_;
+      }
+      return ::std::min(room, remaining);
+    }
+
+    /**
+     * @brief insert a range with all threads, in rounds that fit the current capacity.
+     * @param op   called as op(element, Reducer &), returns 1 if a new entry was created.
+     */
+    template <typename InputIt, typename Reducer, typename Op>
+    size_t parallel_insert(InputIt first, InputIt last, Reducer const & r, Op const & op) {
+      static_assert(::std::is_same<typename ::std::iterator_traits<InputIt>::iterator_category, ::std::random_access_iterator_tag>::value,
+                    "concurrent_densehash_map bulk insert requires random access iterators");
+
+      size_t before = count_;
+      size_t remaining = ::std::distance(first, last);
+
+      ::bliss::partition::DemandDrivenPartitioner<::bliss::partition::range<size_t> > partitioner;
+      size_t round;
+
+      while (remaining > 0) {
+        // each element creates at most 1 entry, so a round never exceeds the max load.
+        round = make_room(remaining);
+
+        int nthreads = 1;
+#if defined(USE_OPENMP)
+        nthreads = ::std::max(1, ::std::min(omp_get_max_threads(), static_cast<int>((round + chunk_size - 1) / chunk_size)));
+#endif
+        partitioner.configure(::bliss::partition::range<size_t>(0, round), nthreads, chunk_size);
+
+#if defined(USE_OPENMP)
+#pragma omp parallel num_threads(nthreads)
+#endif
+        {
+          int tid = 0;
+#if defined(USE_OPENMP)
+          tid = omp_get_thread_num();
+#endif
+          Reducer local_r(r);   // reducers may have non-const operator().
+
+          for (auto rng = partitioner.getNext(tid); rng.size() > 0; rng = partitioner.getNext(tid)) {
+            for (auto it = first + rng.start, e = first + rng.end; it != e; ++it) {
+              op(*it, local_r);
+            }
+          }
+        }
+
+        first += round;
+        remaining -= round;
+      }
+
+      return count_ - before;
+    }
+
+  public:
+
+    concurrent_densehash_map(size_type bucket_count = 128) :
+      specials(), hash(), eq(::fsc::soa::make_equal<Equal>(specials)),
+      mask(0), count_(0), max_load(0.7) {
+      size_t cap = 8;
+      while (cap < bucket_count) cap <<= 1;
+      keys_.resize(cap);
+      vals_.resize(cap);
+      state_.resize(cap, EMPTY);
+      mask = cap - 1;
+    };
+
+    template<class InputIt>
+    concurrent_densehash_map(InputIt first, InputIt last) :
+      concurrent_densehash_map(std::distance(first, last)) {
+      this->insert(first, last);
+    };
+
+    virtual ~concurrent_densehash_map() {};
+
+    float get_max_load_factor() const {
+      return max_load;
+    }
+
+    iterator begin() {
+      iterator it(this, 0);
+      it.skip_empty();
+      return it;
+    }
+    const_iterator begin() const {
+      return cbegin();
+    }
+    const_iterator cbegin() const {
+      const_iterator it(this, 0);
+      it.skip_empty();
+      return it;
+    }
+
+    iterator end() {
+      return iterator(this, state_.size());
+    }
+    const_iterator end() const {
+      return cend();
+    }
+    const_iterator cend() const {
+      return const_iterator(this, state_.size());
+    }
+
+
+    std::vector<Key> keys() const {
+      std::vector<Key> ks;
+
+      keys(ks);
+
+      return ks;
+    }
+    void keys(std::vector<Key> & ks) const {
+      ks.clear();
+      ks.reserve(size());
+
+      for (size_t i = 0; i < state_.size(); ++i) {
+        if (state_[i] == FULL) ks.emplace_back(keys_[i]);
+      }
+    }
+
+    std::vector<std::pair<Key, T> > to_vector() const {
+      std::vector<std::pair<Key, T>> vs;
+
+      to_vector(vs);
+
+      return vs;
+    }
+    void to_vector(  std::vector<std::pair<Key, T> > & vs) const {
+      vs.clear();
+      vs.reserve(size());
+
+      for (size_t i = 0; i < state_.size(); ++i) {
+        if (state_[i] == FULL) vs.emplace_back(keys_[i], vals_[i]);
+      }
+    }
+
+
+    bool empty() const {
+      return count_ == 0;
+    }
+
+    size_type size() const {
+      return count_;
+    }
+    size_type unique_size() const {
+      return count_;
+    }
+
+    /// clear and release memory, back to the default capacity.
+    void reset() {
+      ::std::vector<Key, key_alloc_type>(128).swap(keys_);
+      ::std::vector<T, val_alloc_type>(128).swap(vals_);
+      ::std::vector<uint8_t, state_alloc_type>(128, EMPTY).swap(state_);
+      mask = 127;
+      count_ = 0;
+    }
+
+    /// clear without releasing memory.
+    void clear() {
+      ::std::fill(state_.begin(), state_.end(), EMPTY);
+      count_ = 0;
+    }
+
+    /// make room for at least n elements.  does not shrink.  call before concurrent_insert.
+    void resize(size_t const n) {
+      size_t cap = capacity_for(::std::max(n, count_));
+      if (cap > state_.size()) rehash_to(cap);
+    }
+
+    /// rehash for new count number of BUCKETS.  iterators are invalidated.
+    void rehash(size_type count) {
+      this->resize(count);
+    }
+
+    /// bucket count.
+    size_type bucket_count() const {
+      return state_.size();
+    }
+
+    float load_factor() const {
+      return  static_cast<float>(count_) / static_cast<float>(state_.size());
+    }
+
+
+    /**
+     * @brief insert if absent, then reduce val into the entry if it already existed.  THREAD SAFE.
+     * @details the table does not grow here.  throws ::std::length_error if no empty slot is found.
+     * @return true if a new entry was created.
+     */
+    template <typename Reducer>
+    bool concurrent_insert(::std::pair<Key, T> const & x, Reducer & r) {
+      auto result = claim_pos(x.first, x.second);
+      if (!result.second) reduce_at(result.first, x.second, r);
+      return result.second;
+    }
+
+    /// insert if absent, keeping the existing value otherwise.  THREAD SAFE.  see above.
+    bool concurrent_insert(::std::pair<Key, T> const & x) {
+      return claim_pos(x.first, x.second).second;
+    }
+
+    /// insert if absent using all threads.  when a key appears more than once, any one of its values is kept.
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+      parallel_insert(first, last, ::fsc::concurrent::no_reduce(), [this](::std::pair<Key, T> const & x, ::fsc::concurrent::no_reduce &) {
+        this->concurrent_insert(x);
+      });
+    }
+
+    /**
+     * @brief insert and reduce using all threads.  reduction order is not defined, so r should be commutative and associative.
+     * @return number of new entries.
+     */
+    template <class InputIt, typename Reducer>
+    size_t insert(InputIt first, InputIt last, Reducer const & r) {
+      return parallel_insert(first, last, r, [this](::std::pair<Key, T> const & x, Reducer & lr) {
+        this->concurrent_insert(x, lr);
+      });
+    }
+
+    void insert(::std::vector<::std::pair<Key, T> > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    void insert(::std::vector<value_type > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    /// insert if absent.  existing entries are not modified, same as std::unordered_map.  NOT thread safe, may grow.
+    template <typename K = Key, typename = typename std::enable_if<!std::is_const<Key>::value> >
+    std::pair<iterator, bool> insert(::std::pair<Key, T> const & x) {
+      size_t pos = find_pos(x.first);
+      if (pos != state_.size()) return std::make_pair(iterator(this, pos), false);
+
+      if ((count_ + 1) > max_count())
+        rehash_to(state_.size() << 1);
+
+      return std::make_pair(iterator(this, claim_pos(x.first, x.second).first), true);
+    }
+
+    std::pair<iterator, bool> insert(::std::pair<const Key, T> const & x) {
+      return this->insert(::std::pair<Key, T>(x.first, x.second));
+    }
+
+    template <typename V, typename Updater>
+    size_t update(::std::vector<::std::pair<Key, V> > & input, Updater const & op) {
+
+      if (input.size() == 0) return 0;
+
+      size_t count = 0;
+      size_t pos;
+
+      for (auto vv : input) {
+        pos = find_pos(vv.first);
+        if (pos == state_.size()) continue;
+
+        // update the entry
+        count += op(vals_[pos], vv.second );
+      }
+
+      return count;
+    }
+
+    // non distributed version
+    template <typename Filter, typename Updater>
+    size_t update(Filter const & fop, Updater const & op) {
+      size_t count = 0;
+
+      for (auto iter = this->begin(); iter != this->end(); ++iter) {
+        if (fop(*iter)) {
+          count += op((*iter).second);
+        }
+      }
+
+      return count;
+    }
+
+
+    template <typename InputIt, typename Pred>
+    size_t erase(InputIt first, InputIt last, Pred const & pred) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      size_t count = 0;
+      size_t pos;
+
+      for (; first != last; ++first) {
+        pos = find_pos(*first);
+        if (pos == state_.size()) continue;
+
+        if (pred(*(iterator(this, pos)))) {
+          erase_pos(pos);
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    template <typename InputIt>
+    size_t erase(InputIt first, InputIt last) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      size_t count = 0;
+      size_t pos;
+
+      for (; first != last; ++first) {
+        pos = find_pos(*first);
+        if (pos == state_.size()) continue;
+
+        erase_pos(pos);
+        ++count;
+      }
+      return count;
+    }
+
+    template <typename Pred>
+    size_t erase(Pred const & pred) {
+      size_t before = count_;
+
+      // erase shifts later entries into the current slot, so check the slot again before moving on.
+      for (size_t i = 0; i < state_.size(); ++i) {
+        while ((state_[i] == FULL) && pred(*(iterator(this, i))))
+          erase_pos(i);
+      }
+
+      return before - count_;
+    }
+
+    size_type count(Key const & key) const {
+      return (find_pos(key) == state_.size()) ? 0 : 1;
+    }
+
+
+    ::std::pair<iterator, iterator> equal_range(Key const & key) {
+      iterator it = find(key);
+      if (it == end()) return ::std::make_pair(it, it);
+      iterator next = it;
+      ++next;
+      return ::std::make_pair(it, next);
+    }
+    ::std::pair<const_iterator, const_iterator> equal_range(Key const & key) const {
+      const_iterator it = find(key);
+      if (it == cend()) return ::std::make_pair(it, it);
+      const_iterator next = it;
+      ++next;
+      return ::std::make_pair(it, next);
+    }
+
+    iterator find(Key const &key) {
+      return iterator(this, find_pos(key));
+    }
+
+    const_iterator find(Key const &key) const {
+      return const_iterator(this, find_pos(key));
+    }
+
+    /// prefetch the home slot of a key in the state and key arrays, ahead of find/count/equal_range.
+    inline void prefetch(Key const & key) const {
+#if defined(__GNUC__)
+      size_t pos = home(key);
+      __builtin_prefetch(state_.data() + pos, 0, 1);
+      __builtin_prefetch(keys_.data() + pos, 0, 1);
+#endif
+    }
+
+    inline bool exists(Key const & key) const {
+      return find_pos(key) != state_.size();
+    }
+
+};
+
+template <typename Key, typename T, typename SpecialKeys, template<typename> class Transform,
+          typename Hash, typename Equal, typename Allocator, bool split>
+constexpr size_t concurrent_densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split>::chunk_size;
+template <typename Key, typename T, typename SpecialKeys, template<typename> class Transform,
+          typename Hash, typename Equal, typename Allocator, bool split>
+constexpr size_t concurrent_densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split>::parallel_rehash_min;
+template <typename Key, typename T, typename SpecialKeys, template<typename> class Transform,
+          typename Hash, typename Equal, typename Allocator, bool split>
+constexpr uint8_t concurrent_densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split>::EMPTY;
+template <typename Key, typename T, typename SpecialKeys, template<typename> class Transform,
+          typename Hash, typename Equal, typename Allocator, bool split>
+constexpr uint8_t concurrent_densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split>::BUSY;
+template <typename Key, typename T, typename SpecialKeys, template<typename> class Transform,
+          typename Hash, typename Equal, typename Allocator, bool split>
+constexpr uint8_t concurrent_densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split>::FULL;
+
+
+}  // namespace fsc
+
+#endif /* SRC_CONTAINERS_CONCURRENT_DENSEHASH_MAP_HPP_ */
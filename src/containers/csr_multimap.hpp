@@ -0,0 +1,538 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    csr_multimap.hpp
+ * @ingroup fsc::containers
+ * @brief   multimap in compressed sparse row form:  a key array, offsets, and 1 contiguous value array.
+ * @details ::fsc::unordered_compact_vecmap keeps an ::std::vector per key, so each key has its own heap block,
+ *          with the vector's 24 bytes and the allocator's overhead on top, and the blocks fragment the heap.
+ *          ::fsc::densehash_multimap stores the key again with every value.
+ *
+ *          this map stores the values of slot i at [offsets[i], offsets[i + 1]) of a single value array, and the key
+ *          of slot i at keys[i].  a ::fsc::soa_hash_map maps a key to its slot.
+ *
+ *          insert is a count-then-scatter over the batch:  each entry's slot is looked up (new keys take the next
+ *          slots), the new and existing values per slot are counted, the offsets are prefix summed, and the values
+ *          are scattered into a new value array of the exact size.  counting and scattering are multithreaded.
+ *          a batch therefore costs O(size()) on top of the batch, so this is meant for indices built once, or in a
+ *          few large batches, e.g. the position index of a distributed multimap.  erase rebuilds the arrays the same way.
+ *          the values of a key are in no particular order when inserted by more than 1 thread.
+ *
+ *          the template parameters are the same as ::fsc::densehash_multimap, so this can be used as the Container
+ *          of ::dsc::densehash_multimap.  SpecialKeys is only passed to the index.  the split parameter is ignored.
+ *
+ *          iterators dereference to ::std::pair<Key const &, T const &>.  values are not modifiable in place.
+ *          iterators are invalidated by insert and erase.
+ */
+#ifndef SRC_CONTAINERS_CSR_MULTIMAP_HPP_
+#define SRC_CONTAINERS_CSR_MULTIMAP_HPP_
+
+#include <vector>
+#include <functional>  // hash, equal_to, etc
+#include <utility>   // pair
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <cstdint>  // uint32_t
+
+#include "containers/soa_hash_map.hpp"
+#include "containers/fsc_container_utils.hpp"
+#include "containers/parallel_for_each.hpp"
+#include "containers/table_stats.hpp"
+#include "utils/transform_utils.hpp"
+
+namespace fsc {  // fast standard container
+
+
+/**
+ * @brief multimap with the values of all keys in 1 array, indexed by per key offsets.
+ * @details  see file description.  interface follows ::fsc::densehash_multimap.
+ */
+template <typename Key,
+typename T,
+typename SpecialKeys = ::fsc::soa::no_special_keys,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+bool split = SpecialKeys::need_to_split >
+class csr_multimap {
+
+  protected:
+    /// slot of a key.  32 bits, since the index holds one per bucket.
+    using slot_type = uint32_t;
+
+    using index_type = ::fsc::soa_hash_map<Key, slot_type, SpecialKeys, Transform, Hash, Equal,
+        typename ::std::allocator_traits<Allocator>::template rebind_alloc<::std::pair<const Key, slot_type> >, split>;
+    using key_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<Key>;
+    using val_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    using offset_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<size_t>;
+
+    using key_array_type = ::std::vector<Key, key_alloc_type>;
+    using value_array_type = ::std::vector<T, val_alloc_type>;
+    using offset_array_type = ::std::vector<size_t, offset_alloc_type>;
+
+    /// key to slot
+    index_type index;
+
+    /// key of each slot
+    key_array_type keys_;
+
+    /// values of slot i are at [offsets_[i], offsets_[i + 1]).  1 more entry than keys_.
+    offset_array_type offsets_;
+
+    /// values of all slots
+    value_array_type values_;
+
+  public:
+    using key_type              = Key;
+    using mapped_type           = T;
+    using value_type            = ::std::pair<const Key, T>;
+    using hasher                = Hash;
+    using key_equal             = Equal;
+    using allocator_type        = Allocator;
+    using reference             = ::std::pair<const Key &, const T &>;
+    using const_reference       = reference;
+    using size_type             = size_t;
+    using difference_type       = ptrdiff_t;
+
+  protected:
+    /// proxy so that it->second works when the iterator dereferences to a temporary pair of references.
+    struct arrow_proxy {
+        reference r;
+        reference * operator->() { return &r; }
+    };
+
+    /**
+     * @brief iterator over the values, with their keys.  an equal_range is the values of 1 slot.
+     * @details  the position in the value array identifies the iterator.  the slot follows the position.
+     */
+    class csr_iterator {
+        friend class csr_multimap;
+
+        csr_multimap const * m;
+        size_t slot;
+        size_t pos;
+
+        /// move to the slot holding pos.  no slot is empty, so this moves at most 1 slot after an increment.
+        inline void find_slot() {
+          while ((slot < m->keys_.size()) && (pos >= m->offsets_[slot + 1])) ++slot;
+        }
+
+      public:
+        using iterator_category = ::std::forward_iterator_tag;
+        using value_type = typename csr_multimap::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = typename csr_multimap::reference;
+        using pointer = arrow_proxy;
+
+        csr_iterator() : m(nullptr), slot(0), pos(0) {}
+        csr_iterator(csr_multimap const * _m, size_t _slot, size_t _pos) : m(_m), slot(_slot), pos(_pos) {
+          find_slot();
+        }
+
+        reference operator*() const {
+          return reference(m->keys_[slot], m->values_[pos]);
+        }
+        pointer operator->() const {
+          return pointer{this->operator*()};
+        }
+
+        csr_iterator & operator++() {
+          ++pos;
+          find_slot();
+          return *this;
+        }
+        csr_iterator operator++(int) {
+          csr_iterator out(*this);
+          ++(*this);
+          return out;
+        }
+
+        bool operator==(csr_iterator const & other) const {
+          return pos == other.pos;
+        }
+        bool operator!=(csr_iterator const & other) const {
+          return pos != other.pos;
+        }
+    };
+
+  public:
+    using iterator              = csr_iterator;
+    using const_iterator        = csr_iterator;
+    using pointer               = typename iterator::pointer;
+    using const_pointer         = pointer;
+
+  protected:
+
+    /// slot of a key, adding the key with the next slot if it is new.
+    inline slot_type slot_of(Key const & key) {
+      if (keys_.size() == static_cast<size_t>(::std::numeric_limits<slot_type>::max()))
+        throw ::std::length_error("csr_multimap has too many keys.");
+
+      auto result = index.insert(::std::make_pair(key, static_cast<slot_type>(keys_.size())));
+      if (result.second) keys_.emplace_back(key);
+      return (*(result.first)).second;
+    }
+
+    /**
+     * @brief drop the values for which drop(slot, pos) is true, and the keys left without values.  renumbers the slots.
+     * @details one pass over the slots, moving the kept values down.  the index is updated for the keys that moved.
+     */
+    template <typename Drop>
+    void remove_values(Drop const & drop) {
+      size_t out = 0;
+      size_t nslots = 0;
+      for (size_t slot = 0; slot < keys_.size(); ++slot) {
+        size_t const first = offsets_[slot];
+        size_t const last = offsets_[slot + 1];
+        size_t const start = out;
+        for (size_t pos = first; pos < last; ++pos) {
+          if (drop(slot, pos)) continue;
+          if (out != pos) values_[out] = ::std::move(values_[pos]);
+          ++out;
+        }
+
+        if (out == start) {
+          index.erase(&(keys_[slot]), &(keys_[slot]) + 1);
+          continue;
+        }
+
+        // slot + 1 is read in the next iteration, and nslots <= slot.
+        offsets_[nslots] = start;
+        if (nslots != slot) {
+          keys_[nslots] = ::std::move(keys_[slot]);
+          (*(index.find(keys_[nslots]))).second = static_cast<slot_type>(nslots);
+        }
+        ++nslots;
+      }
+      offsets_[nslots] = out;
+
+      keys_.resize(nslots);
+      offsets_.resize(nslots + 1);
+      values_.resize(out);
+    }
+
+    /// mark the slots of the keys in [first, last).  @return true if any key is present.
+    template <typename InputIt>
+    bool mark_slots(InputIt first, InputIt last, ::std::vector<bool> & marked) const {
+      marked.assign(keys_.size(), false);
+      bool found = false;
+      for (; first != last; ++first) {
+        auto it = index.find(*first);
+        if (it == index.end()) continue;
+        marked[(*it).second] = true;
+        found = true;
+      }
+      return found;
+    }
+
+  public:
+
+    csr_multimap(size_type bucket_count = 128) : index(bucket_count), offsets_(1, 0) {};
+
+    template<class InputIt>
+    csr_multimap(InputIt first, InputIt last) :
+      csr_multimap(std::distance(first, last)) {
+      this->insert(first, last);
+    };
+
+    virtual ~csr_multimap() {};
+
+
+    std::vector<Key> keys() const {
+      std::vector<Key> ks;
+      keys(ks);
+      return ks;
+    }
+
+    void keys(std::vector<Key> & ks) const {
+      ks.assign(keys_.begin(), keys_.end());
+    }
+
+    std::vector<std::pair<Key, T> > to_vector() const {
+      std::vector<std::pair<Key, T> > vs;
+      to_vector(vs);
+      return vs;
+    }
+
+    void to_vector(std::vector<std::pair<Key, T> > & vs) const {
+      vs.clear();
+      vs.reserve(values_.size());
+      for (size_t slot = 0; slot < keys_.size(); ++slot) {
+        for (size_t pos = offsets_[slot]; pos < offsets_[slot + 1]; ++pos) {
+          vs.emplace_back(keys_[slot], values_[pos]);
+        }
+      }
+    }
+
+    const_iterator begin() const {
+      return const_iterator(this, 0, 0);
+    }
+    const_iterator cbegin() const {
+      return begin();
+    }
+    const_iterator end() const {
+      return const_iterator(this, keys_.size(), values_.size());
+    }
+    const_iterator cend() const {
+      return end();
+    }
+
+    bool empty() const {
+      return values_.empty();
+    }
+
+    /// total number of values
+    size_type size() const {
+      return values_.size();
+    }
+
+    /// number of keys
+    size_type unique_size() const {
+      return keys_.size();
+    }
+
+    float get_max_load_factor() const {
+      return index.get_max_load_factor();
+    }
+
+    void reset() {
+      index.reset();
+      key_array_type().swap(keys_);
+      value_array_type().swap(values_);
+      offsets_.assign(1, 0);
+      offset_array_type(offsets_).swap(offsets_);
+    }
+
+    void clear() {
+      index.clear();
+      keys_.clear();
+      values_.clear();
+      offsets_.assign(1, 0);
+    }
+
+    /// release the unused capacity of the arrays.  there are no tombstones:  erase rebuilds the arrays.
+    void compact() {
+      key_array_type(keys_).swap(keys_);
+      offset_array_type(offsets_).swap(offsets_);
+      value_array_type(values_).swap(values_);
+    }
+
+    /// no effect:  there are no tombstones to compact.  for the densehash_multimap interface.
+    void set_compact_ratio(double const) {}
+    double get_compact_ratio() const {
+      return 0.0;
+    }
+
+    /**
+     * @brief no effect.  the distributed maps reserve for the number of entries, and the index is sized by keys,
+     *        which cannot be told from the entries.  the index grows as keys arrive, and insert sizes the value array exactly.
+     */
+    void resize(size_t const) {}
+
+    void rehash(size_type count) {
+      index.rehash(count);
+    }
+
+    /// bucket count of the index.
+    size_type bucket_count() const {
+      return index.bucket_count();
+    }
+
+    float load_factor() const {
+      return index.load_factor();
+    }
+
+    /// probe lengths of the index.  see containers/table_stats.hpp
+    ::fsc::table_stats get_table_stats() const {
+      return index.get_table_stats();
+    }
+
+    /// visit all entries, split by slot.  fn(reference, thread id).
+    template <typename F>
+    void parallel_for_each(F fn, int const nthreads = 0) const {
+      ::fsc::parallel_for_ranges(keys_.size(), [this, &fn](size_t const first, size_t const last, int const tid) {
+        for (size_t slot = first; slot < last; ++slot) {
+          for (size_t pos = offsets_[slot]; pos < offsets_[slot + 1]; ++pos) {
+            fn(reference(keys_[slot], values_[pos]), tid);
+          }
+        }
+      }, nthreads);
+    }
+
+    /// visit all keys, split by slot.  fn(key, number of values, thread id).
+    template <typename F>
+    void parallel_for_each_key(F fn, int const nthreads = 0) const {
+      ::fsc::parallel_for_ranges(keys_.size(), [this, &fn](size_t const first, size_t const last, int const tid) {
+        for (size_t slot = first; slot < last; ++slot) {
+          fn(keys_[slot], offsets_[slot + 1] - offsets_[slot], tid);
+        }
+      }, nthreads);
+    }
+
+
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+      ::std::vector<::std::pair<Key, T> > input(first, last);
+      insert(input);
+    }
+
+    /**
+     * @brief insert a batch of (key, value) pairs, with a count-then-scatter into a new value array.
+     * @details  the slot lookups are sequential, since the index is not thread safe.  the counts and the scatter
+     *           are split over the threads, with atomic increments on the per slot counters.
+     */
+    void insert(::std::vector<::std::pair<Key, T> > & input) {
+      if (input.empty()) return;
+
+      size_t const n = input.size();
+      size_t const old_slots = keys_.size();
+
+      // slot of each entry.  new keys take the next slots.
+      ::std::vector<slot_type> slots(n);
+      for (size_t i = 0; i < n; ++i) {
+        slots[i] = slot_of(input[i].first);
+      }
+
+      // count the existing and new values of each slot, then prefix sum into the new offsets.
+      offset_array_type offs(keys_.size() + 1, 0);
+      ::fsc::parallel_for_ranges(old_slots, [this, &offs](size_t const first, size_t const last, int const) {
+        for (size_t slot = first; slot < last; ++slot) {
+          offs[slot + 1] = offsets_[slot + 1] - offsets_[slot];
+        }
+      });
+      ::fsc::parallel_for_ranges(n, [&offs, &slots](size_t const first, size_t const last, int const) {
+        for (size_t i = first; i < last; ++i) {
+          __atomic_fetch_add(&(offs[slots[i] + 1]), 1, __ATOMIC_RELAXED);
+        }
+      });
+      for (size_t slot = 0; slot < keys_.size(); ++slot) {
+        offs[slot + 1] += offs[slot];
+      }
+
+      // scatter:  the existing values of each slot first, then the new ones after them.
+      value_array_type vals(offs.back());
+      offset_array_type next(offs.begin(), offs.end() - 1);
+      ::fsc::parallel_for_ranges(old_slots, [this, &offs, &next, &vals](size_t const first, size_t const last, int const) {
+        for (size_t slot = first; slot < last; ++slot) {
+          size_t out = offs[slot];
+          for (size_t pos = offsets_[slot]; pos < offsets_[slot + 1]; ++pos, ++out) {
+            vals[out] = ::std::move(values_[pos]);
+          }
+          next[slot] = out;
+        }
+      });
+      ::fsc::parallel_for_ranges(n, [&input, &slots, &next, &vals](size_t const first, size_t const last, int const) {
+        for (size_t i = first; i < last; ++i) {
+          vals[__atomic_fetch_add(&(next[slots[i]]), 1, __ATOMIC_RELAXED)] = input[i].second;
+        }
+      });
+
+      offsets_.swap(offs);
+      values_.swap(vals);
+    }
+
+    void insert(::std::vector<value_type > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    void insert(::std::pair<Key, T> const & x) {
+      ::std::vector<::std::pair<Key, T> > input(1, x);
+      insert(input);
+    }
+
+
+    /// erase the values of the keys in [first, last) that satisfy pred.  @return number of values erased.
+    template <typename InputIt, typename Pred>
+    size_t erase(InputIt first, InputIt last, Pred const & pred) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      ::std::vector<bool> marked;
+      if (!mark_slots(first, last, marked)) return 0;
+
+      size_t before = values_.size();
+      remove_values([this, &marked, &pred](size_t const slot, size_t const pos) {
+        return marked[slot] && pred(reference(keys_[slot], values_[pos]));
+      });
+      return before - values_.size();
+    }
+
+    /// erase all values of the keys in [first, last).  @return number of values erased.
+    template <typename InputIt>
+    size_t erase(InputIt first, InputIt last) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      ::std::vector<bool> marked;
+      if (!mark_slots(first, last, marked)) return 0;
+
+      size_t before = values_.size();
+      remove_values([&marked](size_t const slot, size_t const) {
+        return marked[slot];
+      });
+      return before - values_.size();
+    }
+
+    /// erase all values that satisfy pred.  @return number of values erased.
+    template <typename Pred>
+    size_t erase(Pred const & pred) {
+      if (values_.empty()) return 0;
+
+      size_t before = values_.size();
+      remove_values([this, &pred](size_t const slot, size_t const pos) {
+        return pred(reference(keys_[slot], values_[pos]));
+      });
+      return before - values_.size();
+    }
+
+
+    /// number of values for a key
+    size_type count(Key const & key) const {
+      auto it = index.find(key);
+      if (it == index.end()) return 0;
+
+      slot_type const slot = (*it).second;
+      return offsets_[slot + 1] - offsets_[slot];
+    }
+
+    /// values of a key.  empty range if the key is absent.
+    ::std::pair<const_iterator, const_iterator> equal_range(Key const & key) const {
+      auto it = index.find(key);
+      if (it == index.end()) return ::std::make_pair(end(), end());
+
+      slot_type const slot = (*it).second;
+      return ::std::make_pair(const_iterator(this, slot, offsets_[slot]),
+                              const_iterator(this, slot, offsets_[slot + 1]));
+    }
+
+    /// prefetch the index slot for a key, ahead of find/count/equal_range.  for batched lookups.
+    inline void prefetch(Key const & key) const {
+      index.prefetch(key);
+    }
+
+    inline bool exists(Key const & key) const {
+      return index.exists(key);
+    }
+
+};
+
+
+}  // namespace fsc
+
+#endif /* SRC_CONTAINERS_CSR_MULTIMAP_HPP_ */
@@ -0,0 +1,407 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    delta_multimap.hpp
+ * @ingroup fsc::containers
+ * @brief   multimap with 1 entry per key and a compressed, sorted value list per key.
+ * @details ::fsc::densehash_multimap and ::fsc::unordered_compact_vecmap store a (key, value) pair per occurrence,
+ *          so a kmer that occurs 1000 times has its key stored 1000 times.  for a position index, the values of a key
+ *          are also close to each other once sorted.
+ *
+ *          this map stores each key once, in a ::fsc::soa_hash_map, with the offset, byte count, and value count of its value list.
+ *          the value lists are sorted (by ::imxx::codec::less) and delta + varint encoded with ::imxx::codec, in a single byte arena.
+ *          a list is decoded lazily by the iterators from equal_range, or in full by find.
+ *
+ *          inserting values for an existing key re-encodes its list at the end of the arena (or in place, if the list is already at the end).
+ *          the old bytes are reclaimed by compact(), which is called when more than half of the arena is unused.
+ *          insertion is therefore meant to be in large batches, as with the distributed maps.
+ *
+ *          T has to be supported by ::imxx::codec::word_view, e.g. unsigned integers, kmers, and the sequence kmer ids.
+ *          values are returned in codec order, not insertion order.
+ *
+ *          the template parameters are the same as ::fsc::soa_hash_map.
+ */
+#ifndef SRC_CONTAINERS_DELTA_MULTIMAP_HPP_
+#define SRC_CONTAINERS_DELTA_MULTIMAP_HPP_
+
+#include <vector>
+#include <functional>  // hash, equal_to, etc
+#include <utility>   // pair
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstdint>  // uint8_t, uint32_t
+
+#include "containers/soa_hash_map.hpp"
+#include "containers/fsc_container_utils.hpp"
+#include "utils/transform_utils.hpp"
+#include "io/delta_codec.hpp"
+
+namespace fsc {  // fast standard container
+
+
+/**
+ * @brief multimap with delta coded value lists.
+ * @details  see file description.
+ */
+template <typename Key,
+typename T,
+typename SpecialKeys = ::fsc::soa::no_special_keys,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+bool split = SpecialKeys::need_to_split >
+class delta_multimap {
+
+    static_assert(::imxx::codec::word_view<T>::value, "value type is not supported by the delta codec");
+
+  protected:
+    /// location of a value list in the arena.
+    struct list_info {
+        size_t offset;
+        uint32_t bytes;
+        uint32_t count;
+
+        list_info() : offset(0), bytes(0), count(0) {}
+    };
+
+    using index_type = ::fsc::soa_hash_map<Key, list_info, SpecialKeys, Transform, Hash, Equal,
+        typename ::std::allocator_traits<Allocator>::template rebind_alloc<::std::pair<const Key, list_info> >, split>;
+    using value_less = ::imxx::codec::less<T>;
+
+    index_type index;
+
+    /// encoded value lists.
+    ::std::vector<uint8_t> arena;
+
+    /// bytes in the arena no longer referenced by any list.
+    size_t garbage;
+
+    /// total number of values.
+    size_t s;
+
+    /// encode sorted vals as the new list of li.
+    void store(list_info & li, ::std::vector<T> const & vals) {
+      if ((vals.size() > ::std::numeric_limits<uint32_t>::max()) ||
+          (::imxx::codec::max_encoded_bytes<T>(vals.size()) > ::std::numeric_limits<uint32_t>::max()))
+        throw ::std::length_error("delta_multimap value list is too long.");
+
+      // reuse the space of the old list if it is at the end of the arena.
+      if ((li.bytes > 0) && ((li.offset + li.bytes) == arena.size())) arena.resize(li.offset);
+      else garbage += li.bytes;
+
+      li.offset = arena.size();
+      li.bytes = static_cast<uint32_t>(::imxx::codec::encode(vals.data(), vals.size(), arena));
+      li.count = static_cast<uint32_t>(vals.size());
+    }
+
+  public:
+    using key_type              = Key;
+    using mapped_type           = T;
+    using value_type            = ::std::pair<const Key, T>;
+    using hasher                = Hash;
+    using key_equal             = Equal;
+    using allocator_type        = Allocator;
+    using size_type             = size_t;
+    using difference_type       = ptrdiff_t;
+
+
+    /**
+     * @brief iterator over the values of 1 key.  decodes as it goes.
+     * @details  dereferences to a T by value.  invalidated by insert, erase, and compact.
+     */
+    class value_iterator : public ::std::iterator<::std::forward_iterator_tag, T, ptrdiff_t, T const *, T const &> {
+      protected:
+        using VIEW = ::imxx::codec::word_view<T>;
+
+        /// next unread byte, and end of the list
+        uint8_t const * pos;
+        uint8_t const * last;
+        /// repeats of the current value remaining after this one.
+        size_t rem;
+        bool valid;
+        T cur;
+
+        void read() {
+          typename VIEW::word_type delta[VIEW::nwords];
+          size_t run[1];
+          pos = ::imxx::codec::detail::get_varint(pos, delta);
+          pos = ::imxx::codec::detail::get_varint(pos, run);
+          ::imxx::codec::detail::add(VIEW::words(cur), delta);
+          rem = run[0];
+        }
+
+      public:
+        /// end iterator
+        value_iterator() : pos(nullptr), last(nullptr), rem(0), valid(false), cur() {}
+
+        value_iterator(uint8_t const * first, uint8_t const * _last) :
+          pos(first), last(_last), rem(0), valid(first < _last), cur() {
+          ::std::fill(VIEW::words(cur), VIEW::words(cur) + VIEW::nwords, static_cast<typename VIEW::word_type>(0));
+          if (valid) read();
+        }
+
+        value_iterator& operator++() {
+          if (rem > 0) --rem;
+          else if (pos < last) read();
+          else valid = false;
+          return *this;
+        }
+
+        value_iterator operator++(int) {
+          value_iterator out(*this);
+          ++(*this);
+          return out;
+        }
+
+        T const & operator*() const { return cur; }
+        T const * operator->() const { return &cur; }
+
+        bool operator==(value_iterator const & other) const {
+          return (valid == other.valid) && (!valid || ((pos == other.pos) && (rem == other.rem)));
+        }
+        bool operator!=(value_iterator const & other) const {
+          return !(*this == other);
+        }
+    };
+
+
+    delta_multimap(size_type bucket_count = 128) : index(bucket_count), garbage(0), s(0) {};
+
+    template<class InputIt>
+    delta_multimap(InputIt first, InputIt last) :
+      delta_multimap(std::distance(first, last)) {
+      this->insert(first, last);
+    };
+
+    virtual ~delta_multimap() {};
+
+
+    std::vector<Key> keys() const {
+      std::vector<Key> ks;
+      keys(ks);
+      return ks;
+    }
+
+    void keys(std::vector<Key> & ks) const {
+      index.keys(ks);
+    }
+
+    std::vector<std::pair<Key, T> > to_vector() const {
+      std::vector<std::pair<Key, T> > vs;
+      to_vector(vs);
+      return vs;
+    }
+
+    void to_vector(std::vector<std::pair<Key, T> > & vs) const {
+      vs.clear();
+      vs.reserve(s);
+      for (auto it = index.begin(); it != index.end(); ++it) {
+        list_info const & li = (*it).second;
+        for (value_iterator v(arena.data() + li.offset, arena.data() + li.offset + li.bytes), e; v != e; ++v) {
+          vs.emplace_back((*it).first, *v);
+        }
+      }
+    }
+
+    bool empty() const {
+      return s == 0;
+    }
+
+    /// total number of values
+    size_type size() const {
+      return s;
+    }
+
+    /// number of keys
+    size_type unique_size() const {
+      return index.size();
+    }
+
+    /// bytes used by the encoded value lists, including unused bytes not yet compacted.
+    size_t arena_bytes() const {
+      return arena.size();
+    }
+
+    void reset() {
+      index.reset();
+      ::std::vector<uint8_t>().swap(arena);
+      garbage = 0;
+      s = 0;
+    }
+
+    void clear() {
+      index.clear();
+      arena.clear();
+      garbage = 0;
+      s = 0;
+    }
+
+    /// make room for n keys.
+    void resize(size_t const n) {
+      index.resize(n);
+    }
+
+    void rehash(size_type count) {
+      index.rehash(count);
+    }
+
+    size_type bucket_count() const {
+      return index.bucket_count();
+    }
+
+    /// move the value lists together, releasing the bytes of replaced and erased lists.
+    void compact() {
+      if (garbage == 0) return;
+
+      ::std::vector<uint8_t> packed;
+      packed.reserve(arena.size() - garbage);
+      for (auto it = index.begin(); it != index.end(); ++it) {
+        list_info & li = (*it).second;
+        size_t offset = packed.size();
+        packed.insert(packed.end(), arena.begin() + li.offset, arena.begin() + li.offset + li.bytes);
+        li.offset = offset;
+      }
+      arena.swap(packed);
+      garbage = 0;
+    }
+
+
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+      ::std::vector<::std::pair<Key, T> > input(first, last);
+      insert(input);
+    }
+
+    /**
+     * @brief insert a batch of (key, value) pairs.
+     * @details  the input is grouped by key and each group is merged into the key's value list, so each list is encoded once per batch.
+     */
+    void insert(::std::vector<::std::pair<Key, T> > & input) {
+      if (input.empty()) return;
+
+      // add the new keys first.  the index does not move after this, so list_info pointers stay valid below.
+      for (auto it = input.begin(); it != input.end(); ++it) {
+        index.insert(::std::make_pair(it->first, list_info()));
+      }
+
+      ::std::vector<::std::pair<list_info *, T> > grouped;
+      grouped.reserve(input.size());
+      for (auto it = input.begin(); it != input.end(); ++it) {
+        grouped.emplace_back(&((*(index.find(it->first))).second), it->second);
+      }
+
+      value_less vless;
+      ::std::sort(grouped.begin(), grouped.end(),
+                  [&vless](::std::pair<list_info *, T> const & x, ::std::pair<list_info *, T> const & y) {
+        return (x.first < y.first) || ((x.first == y.first) && vless(x.second, y.second));
+      });
+
+      ::std::vector<T> vals;
+      for (size_t i = 0; i < grouped.size(); ) {
+        list_info & li = *(grouped[i].first);
+
+        vals.clear();
+        if (li.bytes > 0) ::imxx::codec::decode(arena.data() + li.offset, li.bytes, vals);
+        size_t old = vals.size();
+
+        for (; (i < grouped.size()) && (grouped[i].first == &li); ++i) {
+          vals.push_back(grouped[i].second);
+        }
+        if (old > 0) ::std::inplace_merge(vals.begin(), vals.begin() + old, vals.end(), vless);
+
+        s += vals.size() - old;
+        store(li, vals);
+      }
+
+      if (garbage > (arena.size() >> 1)) compact();
+    }
+
+    void insert(::std::vector<value_type > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    void insert(::std::pair<Key, T> const & x) {
+      ::std::vector<::std::pair<Key, T> > input(1, x);
+      insert(input);
+    }
+
+
+    /// erase all values of the keys in [first, last).  @return number of values erased.
+    template <typename InputIt>
+    size_t erase(InputIt first, InputIt last) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      size_t before = s;
+      for (; first != last; ++first) {
+        Key k = *first;
+        auto it = index.find(k);
+        if (it == index.end()) continue;
+
+        list_info const & li = (*it).second;
+        garbage += li.bytes;
+        s -= li.count;
+        index.erase(&k, &k + 1);
+      }
+
+      if (garbage > (arena.size() >> 1)) compact();
+      return before - s;
+    }
+
+
+    /// number of values for a key
+    size_type count(Key const & key) const {
+      auto it = index.find(key);
+      return (it == index.end()) ? 0 : (*it).second.count;
+    }
+
+    /// values of a key, decoded lazily.  empty range if the key is absent.
+    ::std::pair<value_iterator, value_iterator> equal_range(Key const & key) const {
+      auto it = index.find(key);
+      if (it == index.end()) return ::std::make_pair(value_iterator(), value_iterator());
+
+      list_info const & li = (*it).second;
+      return ::std::make_pair(value_iterator(arena.data() + li.offset, arena.data() + li.offset + li.bytes),
+                              value_iterator());
+    }
+
+    /// decode the values of a key, appending to out.  @return number of values appended.
+    size_t find(Key const & key, ::std::vector<T> & out) const {
+      auto it = index.find(key);
+      if (it == index.end()) return 0;
+
+      list_info const & li = (*it).second;
+      return ::imxx::codec::decode(arena.data() + li.offset, li.bytes, out);
+    }
+
+    inline void prefetch(Key const & key) const {
+      index.prefetch(key);
+    }
+
+    inline bool exists(Key const & key) const {
+      return index.exists(key);
+    }
+
+};
+
+
+}  // namespace fsc
+
+#endif /* SRC_CONTAINERS_DELTA_MULTIMAP_HPP_ */
@@ -40,6 +40,8 @@
 #include "iterators/concatenating_iterator.hpp"
 
 #include "containers/fsc_container_utils.hpp"
+#include "containers/parallel_for_each.hpp"
+#include "containers/table_stats.hpp"
 
 #include "utils/logging.h"
 #include "utils/transform_utils.hpp"
@@ -349,6 +351,106 @@ namespace sparsehash {
 	static constexpr bool need_to_split = false;
   };
 
+
+  /**
+   * @brief prefetch the first probe position of a key in a google dense_hash_map.
+   * @details  dense_hashtable has a power of 2 number of buckets, and the first probe is at hash(key) & (buckets - 1).
+   *         the table address is taken from end(), whose position is one past the last bucket.
+   *         for batched lookups:  prefetch a block of keys, then resolve them, so the dram misses overlap.
+   *         ForWrite = 1 ahead of inserts.
+   */
+  template <int ForWrite = 0, typename DenseHashMap>
+  inline void prefetch_hashed(DenseHashMap const & m, uint64_t const & hash) {
+#if defined(__GNUC__)
+    size_t const buckets = m.bucket_count();
+    auto table = m.end().pos - buckets;
+    __builtin_prefetch(table + (hash & (buckets - 1)), ForWrite, 1);
+#endif
+  }
+
+  template <typename DenseHashMap>
+  inline void prefetch_bucket(DenseHashMap const & m, typename DenseHashMap::key_type const & key) {
+    prefetch_hashed(m, m.hash_funct()(key));
+  }
+
+  /**
+   * @brief prefetch the first probe positions of n keys, hashing them batch_size at a time where the hash has a batched
+   *        version (::fsc::hash_batch).  each key goes to first if in_first(key), else to second.  the 2 maps have the same hash.
+   */
+  template <typename DenseHashMap, typename Select>
+  inline void prefetch_buckets(DenseHashMap const & first, DenseHashMap const & second, Select const & in_first,
+                               typename DenseHashMap::key_type const * keys, size_t const & n) {
+    constexpr size_t block = 16;
+    uint64_t hashes[block];
+    auto hash = first.hash_funct();
+    for (size_t i = 0; i < n; i += block) {
+      size_t len = ::std::min(n - i, block);
+      ::fsc::hash_batch(hash, keys + i, len, hashes);
+      for (size_t j = 0; j < len; ++j) {
+        prefetch_hashed(in_first(keys[i + j]) ? first : second, hashes[j]);
+      }
+    }
+  }
+
+  /**
+   * @brief insert [begin, end) into 2 maps with the same hash, a window of entries at a time:  hash the window's keys,
+   *        grow the tables for the window, prefetch the home buckets for write, then insert the window.
+   * @details the tables grow before the prefetches, so no insert in the window rehashes and strands them.
+   *          the inserts are the maps' own, in input order, so a key repeated within a window is found by its later
+   *          inserts and the first entry is kept, as with 1 at a time inserts.
+   *          each window is read twice, so the input needs to be a forward iterator.
+   */
+  template <typename DenseHashMap, typename Select, typename ForwardIt>
+  inline void insert_prefetched(DenseHashMap & first, DenseHashMap & second, Select const & in_first,
+                                ForwardIt begin, ForwardIt end) {
+    constexpr size_t block = 16;
+    typename DenseHashMap::key_type keys[block];
+    bool to_first[block];
+    uint64_t hashes[block];
+    auto hash = first.hash_funct();
+    while (begin != end) {
+      size_t len = 0, in_first_count = 0;
+      for (auto it = begin; (it != end) && (len < block); ++it, ++len) {
+        keys[len] = (*it).first;
+        to_first[len] = in_first(keys[len]);
+        if (to_first[len]) ++in_first_count;
+      }
+
+      first.resize(first.size() + in_first_count);
+      if (in_first_count < len) second.resize(second.size() + (len - in_first_count));
+
+      ::fsc::hash_batch(hash, keys, len, hashes);
+      for (size_t j = 0; j < len; ++j) {
+        prefetch_hashed<1>(to_first[j] ? first : second, hashes[j]);
+      }
+      for (size_t j = 0; j < len; ++j, ++begin) {
+        static_cast<void>((to_first[j] ? first : second).insert(*begin));
+      }
+    }
+  }
+
+  /**
+   * @brief visit the occupied buckets in [first, last) of a google dense_hash_map, calling fn(*it, tid).
+   * @details the const_iterator is constructed at bucket first, with the table and its end taken from end() as in prefetch_hashed.
+   *          the advance flag moves it past empty and deleted buckets.
+   */
+  template <typename DenseHashMap, typename F>
+  inline void for_each_in_buckets(DenseHashMap const & m, size_t const & first, size_t const & last, F & fn, int const & tid) {
+    auto e = m.end();
+    auto table = e.pos - m.bucket_count();
+    for (typename DenseHashMap::const_iterator it(e.ht, table + first, e.end, true); it.pos < table + last; ++it) {
+      fn(*it, tid);
+    }
+  }
+
+  /// visit all elements of a google dense_hash_map, with its bucket array split into per-thread ranges.
+  template <typename DenseHashMap, typename F>
+  inline void parallel_for_each(DenseHashMap const & m, F & fn, int const & nthreads) {
+    ::fsc::parallel_for_ranges(m.bucket_count(), [&m, &fn](size_t const first, size_t const last, int const tid) {
+      for_each_in_buckets(m, first, last, fn, tid);
+    }, nthreads);
+  }
+
 }  // namespace sparsehash
 
 
@@ -463,7 +565,8 @@ protected:
 	   lower_map(bucket_count / 2, Hash(),
 			   Equal(specials.generate(0), specials.generate(1))),
 	   upper_map(bucket_count / 2, Hash(),
-			   Equal(specials.invert(specials.generate(0)), specials.invert(specials.generate(1))))
+			   Equal(specials.invert(specials.generate(0)), specials.invert(specials.generate(1)))),
+			   erased(0), compact_ratio(0.5)
     {
     	lower_map.set_empty_key(specials.generate(0));
     	lower_map.set_deleted_key(specials.generate(1));
@@ -572,15 +675,59 @@ protected:
     }
 
     void reset() {
+      erased = 0;
     	lower_map.clear();
     	upper_map.clear();
     }
 
     void clear() {
+      erased = 0;
       lower_map.clear_no_resize();
       upper_map.clear_no_resize();
     }
 
+    /**
+     * @brief  rebuild the tables with only the live entries, at the size for them, and free the old storage.
+     * @details erase leaves tombstones that later probes walk through, and does not shrink the table.
+     *          peak memory is the old plus the new table.  iterators are invalidated.
+     */
+    void compact() {
+      { container_type tmp(lower_map);  lower_map.swap(tmp); }
+      { container_type tmp(upper_map);  upper_map.swap(tmp); }
+      erased = 0;
+    }
+
+    /// compact after a bulk erase when tombstones exceed this fraction of the occupied buckets.  0 disables.  default 0.5
+    void set_compact_ratio(double const ratio) {
+      compact_ratio = ratio;
+    }
+    double get_compact_ratio() const {
+      return compact_ratio;
+    }
+
+    /// call fn(value, thread_id) for each element, with the bucket arrays split into per-thread ranges.  see containers/parallel_for_each.hpp
+    template <typename F>
+    void parallel_for_each(F fn, int const nthreads = 0) const {
+      ::fsc::sparsehash::parallel_for_each(lower_map, fn, nthreads);
+      ::fsc::sparsehash::parallel_for_each(upper_map, fn, nthreads);
+    }
+
+  protected:
+    /// keys erased since the last compaction.  each left a tombstone.
+    size_t erased;
+
+    /// see set_compact_ratio
+    double compact_ratio;
+
+    /// count the tombstones of a bulk erase, given the unique size before it, and compact if there are too many.
+    void compact_after_erase(size_t const before) {
+      erased += before - this->unique_size();
+      if ((compact_ratio > 0.0) && (static_cast<double>(erased) > compact_ratio * static_cast<double>(this->unique_size() + erased)))
+        this->compact();
+    }
+
+  public:
+
     void resize(size_t const n) {
       lower_map.resize( n/2 );
       upper_map.resize((n+1)/2 );
@@ -592,7 +739,7 @@ protected:
     }
 
     /// bucket count.  same as underlying buckets
-    size_type bucket_count() {
+    size_type bucket_count() const {
 //      std::cout << " dense hash map - split " << std::endl;
 
       return lower_map.bucket_count() + upper_map.bucket_count();
@@ -603,6 +750,14 @@ protected:
       return  static_cast<float>(size()) / static_cast<float>(bucket_count());
     }
 
+    /// probe lengths and tombstones of both tables.  O(buckets).  see containers/table_stats.hpp
+    ::fsc::table_stats get_table_stats() const {
+      ::fsc::table_stats stats;
+      ::fsc::collect_dense_table_stats(lower_map, stats);
+      ::fsc::collect_dense_table_stats(upper_map, stats);
+      return stats;
+    }
+
 
 
     // choices:  sort first, then insert in ranges, or no sort, insert one by one.  second is O(n) but pays the random access and mem realloc cost
@@ -623,10 +778,8 @@ protected:
 //    	lower_map.resize(static_cast<float>(lower_map.size() + count) ) ;
 //    	upper_map.resize(static_cast<float>(upper_map.size() + (std::distance(first, last) - count)) ) ;
 
-    	for (auto it = first; it != last; ++it) {
-    		static_cast<void>(this->insert(*it));
-    	}
-
+      // one window at a time:  the tables grow by at most a window ahead of the inserts, and the bucket misses overlap.
+      ::fsc::sparsehash::insert_prefetched(lower_map, upper_map, splitter, first, last);
     }
 
     /// inserting a vector
@@ -639,6 +792,26 @@ protected:
     	insert(input.begin(), input.end());
     }
 
+    /**
+     * @brief insert entries whose keys are unique and not yet in the map, e.g. a loaded snapshot or the output of a
+     *        reduction.  each table is sized once for its final count, so the load never grows and rehashes a table.
+     * @details google's dense_hash_map has no insert without the probe's key comparisons, but with unique keys each
+     *          probe ends at the first empty bucket, and tables sized up front keep those probes short.
+     *          duplicate keys are not detected:  the later ones are dropped, as in insert.
+     */
+    template <class ForwardIt>
+    void bulk_load(ForwardIt first, ForwardIt last) {
+      size_t n = 0, lower = 0;
+      for (auto it = first; it != last; ++it, ++n) {
+        if (splitter((*it).first)) ++lower;
+      }
+      if (n == 0) return;
+
+      lower_map.resize(lower_map.size() + lower);
+      upper_map.resize(upper_map.size() + (n - lower));
+      ::fsc::sparsehash::insert_prefetched(lower_map, upper_map, splitter, first, last);
+    }
+
     template <typename K = Key, typename = typename std::enable_if<!std::is_const<Key>::value> >
     std::pair<typename container_type::iterator, bool> insert(::std::pair<Key, T> const & x) {
       if (splitter(x.first)) {
@@ -740,6 +913,7 @@ protected:
     size_t erase(InputIt first, InputIt last, Pred const & pred) {
         static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                       "InputIt value type for erase cannot be converted to key type");
+        size_t const before_unique = this->unique_size();
 
 
       if (first == last) return 0;
@@ -792,6 +966,7 @@ protected:
       }
 
 
+      this->compact_after_erase(before_unique);
       return count;
     }
 
@@ -800,6 +975,7 @@ protected:
 
         static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                       "InputIt value type for erase cannot be converted to key type");
+        size_t const before_unique = this->unique_size();
 
         if (first == last) return 0;
 
@@ -843,11 +1019,13 @@ protected:
       	  }
         }
 
+        this->compact_after_erase(before_unique);
         return count;
     }
 
     template <typename Pred>
     size_t erase(Pred const & pred) {
+      size_t const before_unique = this->unique_size();
     	size_t before = size();
 
     	for (auto it = lower_map.begin(); it != lower_map.end(); ++it) {
@@ -859,6 +1037,7 @@ protected:
     				upper_map.erase(it);
     	}
 
+    	this->compact_after_erase(before_unique);
     	return before - size();
     }
 
@@ -907,6 +1086,19 @@ protected:
     	}
     }
 
+    /// prefetch the bucket for a key, ahead of find/count/equal_range.  for batched lookups.
+    inline void prefetch(Key const & key) const {
+      if (splitter(key)) {
+        ::fsc::sparsehash::prefetch_bucket(lower_map, key);
+      } else {
+        ::fsc::sparsehash::prefetch_bucket(upper_map, key);
+      }
+    }
+    /// prefetch the buckets for n keys, with batched hashing.
+    inline void prefetch(Key const * keys, size_t const & n) const {
+      ::fsc::sparsehash::prefetch_buckets(lower_map, upper_map, splitter, keys, n);
+    }
+
     inline bool exists(Key const & key) const {
       if (splitter(key)) {
         return upper_map.find(key) != upper_map.end();
@@ -960,7 +1152,8 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
     densehash_map(size_type bucket_count = 128) :
 		   specials(),
 		   map(bucket_count, Hash(),
-				   Equal(specials.generate(0), specials.generate(1)))
+				   Equal(specials.generate(0), specials.generate(1))),
+			   erased(0), compact_ratio(0.5)
 		{
 		map.set_empty_key(specials.generate(0));
 		map.set_deleted_key(specials.generate(1));
@@ -1053,13 +1246,55 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
     }
 
     void reset() {
+      erased = 0;
     	map.clear();
     }
 
     void clear() {
+      erased = 0;
       map.clear_no_resize();
     }
 
+    /**
+     * @brief  rebuild the table with only the live entries, at the size for them, and free the old storage.
+     * @details erase leaves tombstones that later probes walk through, and does not shrink the table.
+     *          peak memory is the old plus the new table.  iterators are invalidated.
+     */
+    void compact() {
+      { container_type tmp(map);  map.swap(tmp); }
+      erased = 0;
+    }
+
+    /// compact after a bulk erase when tombstones exceed this fraction of the occupied buckets.  0 disables.  default 0.5
+    void set_compact_ratio(double const ratio) {
+      compact_ratio = ratio;
+    }
+    double get_compact_ratio() const {
+      return compact_ratio;
+    }
+
+    /// call fn(value, thread_id) for each element, with the bucket array split into per-thread ranges.  see containers/parallel_for_each.hpp
+    template <typename F>
+    void parallel_for_each(F fn, int const nthreads = 0) const {
+      ::fsc::sparsehash::parallel_for_each(map, fn, nthreads);
+    }
+
+  protected:
+    /// keys erased since the last compaction.  each left a tombstone.
+    size_t erased;
+
+    /// see set_compact_ratio
+    double compact_ratio;
+
+    /// count the tombstones of a bulk erase, given the unique size before it, and compact if there are too many.
+    void compact_after_erase(size_t const before) {
+      erased += before - this->unique_size();
+      if ((compact_ratio > 0.0) && (static_cast<double>(erased) > compact_ratio * static_cast<double>(this->unique_size() + erased)))
+        this->compact();
+    }
+
+  public:
+
     void resize(size_t const n) {
       map.resize(n);
     }
@@ -1070,7 +1305,7 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
     }
 
     /// bucket count.  same as underlying buckets
-    size_type bucket_count() {
+    size_type bucket_count() const {
 //      std::cout << " dense hash map - single " << map.bucket_count() << " max/min load factors " << map.max_load_factor() << "/" << map.min_load_factor() << std::endl;
       return map.bucket_count();
     }
@@ -1080,6 +1315,13 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
       return  static_cast<float>(map.size()) / static_cast<float>(map.bucket_count());
     }
 
+    /// probe lengths and tombstones of the table.  O(buckets).  see containers/table_stats.hpp
+    ::fsc::table_stats get_table_stats() const {
+      ::fsc::table_stats stats;
+      ::fsc::collect_dense_table_stats(map, stats);
+      return stats;
+    }
+
 
     // choices:  sort first, then insert in ranges, or no sort, insert one by one.  second is O(n) but pays the random access and mem realloc cost
     template <class InputIt>
@@ -1087,7 +1329,8 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
     	// this could waste a lot of space
     	// this->resize(map.size() + std::distance(first, last));
 
-      map.insert(first, last);
+      // one window at a time:  the table grows by at most a window ahead of the inserts, and the bucket misses overlap.
+      ::fsc::sparsehash::insert_prefetched(map, map, [](Key const &){ return true; }, first, last);
     }
 
     /// inserting sorted range
@@ -1099,6 +1342,16 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
       insert(input.begin(), input.end());
     }
 
+    /// insert entries whose keys are unique and not yet in the map, with the table sized once.  see the split map's bulk_load.
+    template <class ForwardIt>
+    void bulk_load(ForwardIt first, ForwardIt last) {
+      size_t n = ::std::distance(first, last);
+      if (n == 0) return;
+
+      map.resize(map.size() + n);
+      ::fsc::sparsehash::insert_prefetched(map, map, [](Key const &){ return true; }, first, last);
+    }
+
     template <typename K = Key, typename = typename std::enable_if<!std::is_const<Key>::value> >
     std::pair<iterator, bool> insert(::std::pair<Key, T> const & x) {
       return map.insert(x);
@@ -1150,6 +1403,7 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
     size_t erase(InputIt first, InputIt last, Pred const & pred) {
       static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                     "InputIt value type for erase cannot be converted to key type");
+      size_t const before_unique = this->unique_size();
 
       if (first == last) return 0;
 
@@ -1165,6 +1419,7 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
           ++count;
         }
       }
+      this->compact_after_erase(before_unique);
       return count;
     }
 
@@ -1172,6 +1427,7 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
     size_t erase(InputIt first, InputIt last) {
         static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                       "InputIt value type for erase cannot be converted to key type");
+        size_t const before_unique = this->unique_size();
 
         if (first == last) return 0;
 
@@ -1185,11 +1441,13 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
             map.erase(iter);
             ++count;
         }
+        this->compact_after_erase(before_unique);
         return count;
     }
 
     template <typename Pred>
     size_t erase(Pred const & pred) {
+      size_t const before_unique = this->unique_size();
       size_t before = map.size();
 
       for (auto it = map.begin(); it != map.end(); ++it) {
@@ -1197,6 +1455,7 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
             map.erase(it);
       }
 
+      this->compact_after_erase(before_unique);
       return before - map.size();
     }
 
@@ -1222,6 +1481,15 @@ class densehash_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, fals
     	return map.find(key);
     }
 
+    /// prefetch the bucket for a key, ahead of find/count/equal_range.  for batched lookups.
+    inline void prefetch(Key const & key) const {
+      ::fsc::sparsehash::prefetch_bucket(map, key);
+    }
+    /// prefetch the buckets for n keys, with batched hashing.
+    inline void prefetch(Key const * keys, size_t const & n) const {
+      ::fsc::sparsehash::prefetch_buckets(map, map, [](Key const &){ return true; }, keys, n);
+    }
+
     inline bool exists(Key const & key) const {
       return map.find(key) != map.end();
     }
@@ -1719,7 +1987,7 @@ class densehash_multimap {
 			   Equal(specials.generate(0), specials.generate(1))),
 	   upper_map(bucket_count / 2, Hash(),
 			   Equal(specials.invert(specials.generate(0)), specials.invert(specials.generate(1)))),
-			   s(0UL)
+			   s(0UL), erased(0), compact_ratio(0.5)
     {
     	lower_map.set_empty_key(specials.generate(0));
     	lower_map.set_deleted_key(specials.generate(1));
@@ -1823,6 +2091,7 @@ class densehash_multimap {
     }
 
     void reset() {
+      erased = 0;
     	decltype(vec1) tmp1;  vec1.swap(tmp1);
     	decltype(vecX) tmpX;  vecX.swap(tmpX);
     	lower_map.clear();
@@ -1831,6 +2100,7 @@ class densehash_multimap {
     }
 
     void clear() {
+      erased = 0;
       vec1.clear();
       vecX.clear();
       lower_map.clear_no_resize();
@@ -1838,6 +2108,71 @@ class densehash_multimap {
       s = 0UL;
     }
 
+    /**
+     * @brief  rebuild the index tables with only the live entries, at the size for them, and free the old storage.
+     * @details erase leaves tombstones that later probes walk through, and does not shrink the table.
+     *          the value vectors are not compacted.
+     *          peak memory is the old plus the new table.  iterators are invalidated.
+     */
+    void compact() {
+      { supercontainer_type tmp(lower_map);  lower_map.swap(tmp); }
+      { supercontainer_type tmp(upper_map);  upper_map.swap(tmp); }
+      erased = 0;
+    }
+
+    /// compact after a bulk erase when tombstones exceed this fraction of the occupied buckets.  0 disables.  default 0.5
+    void set_compact_ratio(double const ratio) {
+      compact_ratio = ratio;
+    }
+    double get_compact_ratio() const {
+      return compact_ratio;
+    }
+
+    /// call fn(const & ::std::pair<Key, T>, thread_id) for each element.  the index buckets are split into per-thread ranges,
+    /// and each thread visits the values of the keys in its range.  see containers/parallel_for_each.hpp
+    template <typename F>
+    void parallel_for_each(F fn, int const nthreads = 0) const {
+      auto visit = [this, &fn](::std::pair<const Key, internal_val_type> const & entry, int const tid) {
+        if (entry.second >= 0) {
+          fn(vec1[entry.second], tid);
+        } else {
+          subcontainer_type const & vec = vecX[entry.second & ::std::numeric_limits<int64_t>::max()];
+          for (auto it = vec.cbegin(); it != vec.cend(); ++it) {
+            fn(*it, tid);
+          }
+        }
+      };
+      ::fsc::sparsehash::parallel_for_each(lower_map, visit, nthreads);
+      ::fsc::sparsehash::parallel_for_each(upper_map, visit, nthreads);
+    }
+
+    /// call fn(key, number of values, thread_id) for each distinct key, with the index buckets split into per-thread ranges.
+    template <typename F>
+    void parallel_for_each_key(F fn, int const nthreads = 0) const {
+      auto visit = [this, &fn](::std::pair<const Key, internal_val_type> const & entry, int const tid) {
+        fn(entry.first, (entry.second >= 0) ? static_cast<size_t>(1) :
+            vecX[entry.second & ::std::numeric_limits<int64_t>::max()].size(), tid);
+      };
+      ::fsc::sparsehash::parallel_for_each(lower_map, visit, nthreads);
+      ::fsc::sparsehash::parallel_for_each(upper_map, visit, nthreads);
+    }
+
+  protected:
+    /// keys erased since the last compaction.  each left a tombstone.
+    size_t erased;
+
+    /// see set_compact_ratio
+    double compact_ratio;
+
+    /// count the tombstones of a bulk erase, given the unique size before it, and compact if there are too many.
+    void compact_after_erase(size_t const before) {
+      erased += before - this->unique_size();
+      if ((compact_ratio > 0.0) && (static_cast<double>(erased) > compact_ratio * static_cast<double>(this->unique_size() + erased)))
+        this->compact();
+    }
+
+  public:
+
     void resize(size_t const n) {
       // densehash map resize takes into account the max_load_factor.
       lower_map.resize(n/2);
@@ -1849,7 +2184,7 @@ class densehash_multimap {
     }
 
     /// bucket count.  same as underlying buckets
-    size_type bucket_count() {
+    size_type bucket_count() const {
 //      std::cout << " dense hash multimap - split " << std::endl;
       return lower_map.bucket_count() + upper_map.bucket_count();
     }
@@ -1859,6 +2194,14 @@ class densehash_multimap {
       return static_cast<float>(size()) / static_cast<float>(bucket_count());
     }
 
+    /// probe lengths and tombstones of both tables.  O(buckets).  see containers/table_stats.hpp
+    ::fsc::table_stats get_table_stats() const {
+      ::fsc::table_stats stats;
+      ::fsc::collect_dense_table_stats(lower_map, stats);
+      ::fsc::collect_dense_table_stats(upper_map, stats);
+      return stats;
+    }
+
 
 
 
@@ -1911,6 +2254,7 @@ class densehash_multimap {
     size_t erase(InputIt first, InputIt last, Pred const & pred) {
       static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                     "InputIt value type for erase cannot be converted to key type");
+      size_t const before_unique = this->unique_size();
 
       if (first == last) return 0;
 
@@ -1926,6 +2270,7 @@ class densehash_multimap {
   		else this->erase1_impl(*it, pred, upper_map);
       }
 
+      this->compact_after_erase(before_unique);
       return before - s;
     }
 
@@ -1933,6 +2278,7 @@ class densehash_multimap {
     size_t erase(InputIt first, InputIt last) {
       static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                     "InputIt value type for erase cannot be converted to key type");
+      size_t const before_unique = this->unique_size();
 
       if (first == last) return 0;
 
@@ -1947,11 +2293,13 @@ class densehash_multimap {
   		else this->erase1_impl(*it, upper_map);
       }
 
+      this->compact_after_erase(before_unique);
       return before - s;
     }
 
     template <typename Pred>
     size_t erase(Pred const & pred) {
+      size_t const before_unique = this->unique_size();
 
       if (this->size() == 0) return 0;
 
@@ -1960,6 +2308,7 @@ class densehash_multimap {
       erase_impl(pred, lower_map);
       erase_impl(pred, upper_map);
 
+      this->compact_after_erase(before_unique);
       return before - s;
     }
 
@@ -1973,6 +2322,19 @@ class densehash_multimap {
 
     }
 
+    /// prefetch the bucket for a key, ahead of find/count/equal_range.  for batched lookups.
+    inline void prefetch(Key const & key) const {
+      if (splitter(key)) {
+        ::fsc::sparsehash::prefetch_bucket(lower_map, key);
+      } else {
+        ::fsc::sparsehash::prefetch_bucket(upper_map, key);
+      }
+    }
+    /// prefetch the buckets for n keys, with batched hashing.
+    inline void prefetch(Key const * keys, size_t const & n) const {
+      ::fsc::sparsehash::prefetch_buckets(lower_map, upper_map, splitter, keys, n);
+    }
+
     inline bool exists(Key const & key) const {
       if (splitter(key)) {
         return upper_map.find(key) != upper_map.end();
@@ -2067,7 +2429,7 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
     densehash_multimap(size_type bucket_count = 128) :
 		   specials(),
 		   map(bucket_count, Hash(),
-				   Equal(specials.generate(0), specials.generate(1))), s(0UL)
+				   Equal(specials.generate(0), specials.generate(1))), s(0UL), erased(0), compact_ratio(0.5)
 		{
 		map.set_empty_key(specials.generate(0));
 		map.set_deleted_key(specials.generate(1));
@@ -2151,6 +2513,7 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
     }
 
     void reset() {
+      erased = 0;
     	decltype(vec1) tmp1;  vec1.swap(tmp1);
     	decltype(vecX) tmpX;  vecX.swap(tmpX);
     	map.clear();
@@ -2158,12 +2521,75 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
     }
 
     void clear() {
+      erased = 0;
       vec1.clear();
       vecX.clear();
       map.clear_no_resize();
       s = 0UL;
     }
 
+    /**
+     * @brief  rebuild the index table with only the live entries, at the size for them, and free the old storage.
+     * @details erase leaves tombstones that later probes walk through, and does not shrink the table.
+     *          the value vectors are not compacted.
+     *          peak memory is the old plus the new table.  iterators are invalidated.
+     */
+    void compact() {
+      { supercontainer_type tmp(map);  map.swap(tmp); }
+      erased = 0;
+    }
+
+    /// compact after a bulk erase when tombstones exceed this fraction of the occupied buckets.  0 disables.  default 0.5
+    void set_compact_ratio(double const ratio) {
+      compact_ratio = ratio;
+    }
+    double get_compact_ratio() const {
+      return compact_ratio;
+    }
+
+    /// call fn(const & ::std::pair<Key, T>, thread_id) for each element.  the index buckets are split into per-thread ranges,
+    /// and each thread visits the values of the keys in its range.  see containers/parallel_for_each.hpp
+    template <typename F>
+    void parallel_for_each(F fn, int const nthreads = 0) const {
+      auto visit = [this, &fn](::std::pair<const Key, internal_val_type> const & entry, int const tid) {
+        if (entry.second >= 0) {
+          fn(vec1[entry.second], tid);
+        } else {
+          subcontainer_type const & vec = vecX[entry.second & ::std::numeric_limits<int64_t>::max()];
+          for (auto it = vec.cbegin(); it != vec.cend(); ++it) {
+            fn(*it, tid);
+          }
+        }
+      };
+      ::fsc::sparsehash::parallel_for_each(map, visit, nthreads);
+    }
+
+    /// call fn(key, number of values, thread_id) for each distinct key, with the index buckets split into per-thread ranges.
+    template <typename F>
+    void parallel_for_each_key(F fn, int const nthreads = 0) const {
+      auto visit = [this, &fn](::std::pair<const Key, internal_val_type> const & entry, int const tid) {
+        fn(entry.first, (entry.second >= 0) ? static_cast<size_t>(1) :
+            vecX[entry.second & ::std::numeric_limits<int64_t>::max()].size(), tid);
+      };
+      ::fsc::sparsehash::parallel_for_each(map, visit, nthreads);
+    }
+
+  protected:
+    /// keys erased since the last compaction.  each left a tombstone.
+    size_t erased;
+
+    /// see set_compact_ratio
+    double compact_ratio;
+
+    /// count the tombstones of a bulk erase, given the unique size before it, and compact if there are too many.
+    void compact_after_erase(size_t const before) {
+      erased += before - this->unique_size();
+      if ((compact_ratio > 0.0) && (static_cast<double>(erased) > compact_ratio * static_cast<double>(this->unique_size() + erased)))
+        this->compact();
+    }
+
+  public:
+
     void resize(size_t const n) {
       map.resize(n );
     }
@@ -2173,7 +2599,7 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
     }
 
     /// bucket count.  same as underlying buckets
-    size_type bucket_count() {
+    size_type bucket_count() const {
 //      std::cout << " dense hash multimap - single " << std::endl;
 
       return map.bucket_count();
@@ -2184,6 +2610,13 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
       return static_cast<float>(map.size()) / static_cast<float>(map.bucket_count());
     }
 
+    /// probe lengths and tombstones of the table.  O(buckets).  see containers/table_stats.hpp
+    ::fsc::table_stats get_table_stats() const {
+      ::fsc::table_stats stats;
+      ::fsc::collect_dense_table_stats(map, stats);
+      return stats;
+    }
+
 
 
     // choices:  sort first, then insert in ranges, or no sort, insert one by one.  second is O(n) but pays the random access and mem realloc cost
@@ -2267,6 +2700,7 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
     size_t erase(InputIt first, InputIt last, Pred const & pred) {
       static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                     "InputIt value type for erase cannot be converted to key type");
+      size_t const before_unique = this->unique_size();
 
       if (first == last) return 0;
 
@@ -2323,6 +2757,7 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
 
       }
 
+      this->compact_after_erase(before_unique);
       return before - s;
     }
 
@@ -2330,6 +2765,7 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
     size_t erase(InputIt first, InputIt last) {
       static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
                     "InputIt value type for erase cannot be converted to key type");
+      size_t const before_unique = this->unique_size();
 
       if (first == last) return 0;
 
@@ -2358,11 +2794,13 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
         map.erase(iter);
       }
 
+      this->compact_after_erase(before_unique);
       return before - s;
     }
 
     template <typename Pred>
     size_t erase(Pred const & pred) {
+      size_t const before_unique = this->unique_size();
 
       if (this->size() == 0) return 0;
 
@@ -2418,6 +2856,7 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
         }
       }
 
+      this->compact_after_erase(before_unique);
       return before - s;
     }
 
@@ -2433,6 +2872,15 @@ class densehash_multimap<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator,
       }
     }
 
+    /// prefetch the bucket for a key, ahead of find/count/equal_range.  for batched lookups.
+    inline void prefetch(Key const & key) const {
+      ::fsc::sparsehash::prefetch_bucket(map, key);
+    }
+    /// prefetch the buckets for n keys, with batched hashing.
+    inline void prefetch(Key const * keys, size_t const & n) const {
+      ::fsc::sparsehash::prefetch_buckets(map, map, [](Key const &){ return true; }, keys, n);
+    }
+
     inline bool exists(Key const & key) const {
       return map.find(key) != map.end();
     }
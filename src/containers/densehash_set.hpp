@@ -0,0 +1,225 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    densehash_set.hpp
+ * @ingroup fsc::containers
+ * @brief   google dense_hash_set with the special key handling of densehash_map, for key only storage.
+ * @details as for densehash_map, keys that span the entire key space (SpecialKeys::need_to_split) are stored in 2 tables,
+ *          split by SpecialKeys::get_splitter(), so that each table has an empty and a deleted key outside of its range.
+ *          otherwise only the lower table is used.
+ *
+ *          elements are immutable, so iterator and const_iterator are the same.
+ */
+#ifndef SRC_CONTAINERS_DENSEHASH_SET_HPP_
+#define SRC_CONTAINERS_DENSEHASH_SET_HPP_
+
+#include <sparsehash/dense_hash_set>
+#include <vector>
+#include <functional>  // hash, equal_to, less
+#include <utility>     // pair
+#include <memory>      // allocator
+#include <algorithm>
+
+#include "iterators/concatenating_iterator.hpp"
+
+#include "containers/fsc_container_utils.hpp"
+#include "containers/densehash_map.hpp"   // sparsehash::special_keys, compare, threshold, parallel_for_each
+
+#include "utils/transform_utils.hpp"
+
+namespace fsc {  // fast standard container
+
+template <typename Key,
+typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::sparsehash::compare<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<Key> >
+class densehash_set {
+
+  protected:
+    using container_type = ::google::dense_hash_set<Key, Hash, Equal, Allocator >;
+
+    using Splitter = ::fsc::sparsehash::threshold<Key, std::less, Transform>;
+    Splitter splitter;
+
+    SpecialKeys specials;
+
+    /// all keys if the key space is not split, else the keys below the splitter.
+    container_type lower_set;
+    /// keys at or above the splitter.  empty if the key space is not split.
+    container_type upper_set;
+
+    using container_const_iterator = typename container_type::const_iterator;
+    using container_const_range = ::std::pair<container_const_iterator, container_const_iterator>;
+
+    inline container_type & table_of(Key const & key) {
+      return (!SpecialKeys::need_to_split || splitter(key)) ? lower_set : upper_set;
+    }
+    inline container_type const & table_of(Key const & key) const {
+      return (!SpecialKeys::need_to_split || splitter(key)) ? lower_set : upper_set;
+    }
+
+  public:
+    using key_type              = Key;
+    using value_type            = Key;
+    using hasher                = Hash;
+    using key_equal             = Equal;
+    using allocator_type        = Allocator;
+    using reference             = value_type const &;
+    using const_reference       = value_type const &;
+    using iterator              = ::bliss::iterator::ConcatenatingIterator<container_const_iterator >;
+    using const_iterator        = ::bliss::iterator::ConcatenatingIterator<container_const_iterator >;
+    using size_type             = size_t;
+    using difference_type       = ptrdiff_t;
+
+    densehash_set(size_type bucket_count = 128) :
+      specials(),
+      lower_set(SpecialKeys::need_to_split ? bucket_count / 2 : bucket_count, Hash(),
+          Equal(specials.generate(0), specials.generate(1))),
+      upper_set(SpecialKeys::need_to_split ? bucket_count / 2 : 0, Hash(),
+          Equal(specials.invert(specials.generate(0)), specials.invert(specials.generate(1))))
+    {
+      lower_set.set_empty_key(specials.generate(0));
+      lower_set.set_deleted_key(specials.generate(1));
+      upper_set.set_empty_key(specials.invert(specials.generate(0)));
+      upper_set.set_deleted_key(specials.invert(specials.generate(1)));
+      splitter.upper_bound = specials.get_splitter();
+
+      lower_set.max_load_factor(0.7);
+      upper_set.max_load_factor(0.7);
+      lower_set.min_load_factor(0.3);
+      upper_set.min_load_factor(0.3);
+    };
+
+    template<class InputIt>
+    densehash_set(InputIt first, InputIt last) :
+      densehash_set(std::distance(first, last)) {
+      this->insert(first, last);
+    };
+
+    virtual ~densehash_set() {};
+
+    const_iterator begin() const {
+      return cbegin();
+    }
+    const_iterator cbegin() const {
+      return const_iterator(std::vector<container_const_range> { container_const_range{lower_set.begin(), lower_set.end()},
+                                                                 container_const_range{upper_set.begin(), upper_set.end()} });
+    }
+    const_iterator end() const {
+      return cend();
+    }
+    const_iterator cend() const {
+      return const_iterator( upper_set.end() );
+    }
+
+    void keys(std::vector<Key> & ks) const {
+      ks.clear();
+      ks.reserve(size());
+      ks.insert(ks.end(), lower_set.begin(), lower_set.end());
+      ks.insert(ks.end(), upper_set.begin(), upper_set.end());
+    }
+
+    bool empty() const {
+      return lower_set.empty() && upper_set.empty();
+    }
+
+    size_type size() const {
+      return lower_set.size() + upper_set.size();
+    }
+
+    /// release the storage.
+    void reset() {
+      lower_set.clear();
+      upper_set.clear();
+    }
+
+    /// remove all keys, keeping the buckets.
+    void clear() {
+      lower_set.clear_no_resize();
+      upper_set.clear_no_resize();
+    }
+
+    void swap(densehash_set & other) {
+      ::std::swap(splitter, other.splitter);
+      lower_set.swap(other.lower_set);
+      upper_set.swap(other.upper_set);
+    }
+
+    size_type bucket_count() const {
+      return lower_set.bucket_count() + upper_set.bucket_count();
+    }
+
+    /// make room for n keys.  with a split key space the keys are assumed to be evenly split.
+    void reserve(size_t const n) {
+      if (SpecialKeys::need_to_split) {
+        lower_set.resize(n / 2);
+        upper_set.resize((n + 1) / 2);
+      } else {
+        lower_set.resize(n);
+      }
+    }
+
+    hasher hash_funct() const {
+      return lower_set.hash_funct();
+    }
+
+    /// call fn(key, thread_id) for each key, with the bucket arrays split into per-thread ranges.  see containers/parallel_for_each.hpp
+    template <typename F>
+    void parallel_for_each(F fn, int const nthreads = 0) const {
+      ::fsc::sparsehash::parallel_for_each(lower_set, fn, nthreads);
+      if (SpecialKeys::need_to_split) ::fsc::sparsehash::parallel_for_each(upper_set, fn, nthreads);
+    }
+
+    /// insert a key.  returns true if it was not present.
+    bool insert(Key const & key) {
+      return table_of(key).insert(key).second;
+    }
+
+    /// insert keys.  returns the number of keys that were not present.
+    template <class InputIt>
+    size_t insert(InputIt first, InputIt last) {
+      size_t before = size();
+      for (auto it = first; it != last; ++it) {
+        table_of(*it).insert(*it);
+      }
+      return size() - before;
+    }
+
+    size_type count(Key const & key) const {
+      return table_of(key).count(key);
+    }
+
+    size_type erase(Key const & key) {
+      return table_of(key).erase(key);
+    }
+
+    /// erase keys.  returns the number removed.
+    template <class InputIt>
+    size_t erase(InputIt first, InputIt last) {
+      size_t before = size();
+      for (auto it = first; it != last; ++it) {
+        table_of(*it).erase(*it);
+      }
+      return before - size();
+    }
+};
+
+} // namespace fsc
+
+#endif /* SRC_CONTAINERS_DENSEHASH_SET_HPP_ */
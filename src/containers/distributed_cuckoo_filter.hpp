@@ -0,0 +1,322 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    distributed_cuckoo_filter.hpp
+ * @ingroup dsc::containers
+ * @brief   distributed approximate membership:  a cuckoo filter per rank, with the distribution and the insert, count,
+ *          and erase interface of the distributed sets.
+ * @details keys are assigned to ranks by the distribution hash of MapParams, as for the hash maps and sets, and each rank
+ *          keeps a bliss::utils::cuckoo_filter of the storage hash of its keys.  a key costs about FP_BITS + 1 bits
+ *          instead of the key itself, with a false positive rate of about 8 / 2^FP_BITS, e.g. 0.1% at the default 13 bits.
+ *          with COUNTER_BITS > 0, each insert of a key increments its counter, and count returns it.
+ *
+ *          the filter does not grow:  reserve the expected number of keys per rank before inserting.  otherwise the first
+ *          insert sizes it for twice its keys.  the keys are not stored, so to_vector and keys, and thus save, throw.
+ */
+#ifndef BLISS_DISTRIBUTED_CUCKOO_FILTER_HPP
+#define BLISS_DISTRIBUTED_CUCKOO_FILTER_HPP
+
+#include <vector>
+#include <utility>    // pair
+#include <stdexcept>  // logic_error
+
+#include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+
+#include "containers/distributed_map_base.hpp"
+#include "containers/dsc_container_utils.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include "utils/cuckoo_filter.hpp"
+#include "utils/hyperloglog.hpp"      // mix64
+#include "utils/benchmark_utils.hpp"  // for timing.
+#include "utils/logging.h"
+
+#include "common/bit_ops.hpp"   // ceilLog2
+
+namespace dsc  // distributed std container
+{
+
+  /**
+   * @brief  distributed cuckoo filter.  count and find may report keys that were not inserted, but never miss one.
+   * @tparam FP_BITS       fingerprint bits, see bliss::utils::cuckoo_filter.
+   * @tparam COUNTER_BITS  per key counter bits, 0 for presence only.  with counters, duplicate keys are not removed before
+   *                       the exchange.
+   */
+  template<typename Key, template <typename> class MapParams, uint8_t FP_BITS = 13, uint8_t COUNTER_BITS = 0>
+  class cuckoo_filter : public ::dsc::map_base<Key, bool, MapParams> {
+
+    protected:
+      using Base = ::dsc::map_base<Key, bool, MapParams>;
+
+      struct KeyToRank {
+          typename Base::DistTransformedFunc proc_trans_hash;
+          const int p;
+
+          KeyToRank(int comm_size) :
+            proc_trans_hash(typename Base::DistFunc(ceilLog2(comm_size)),
+                            typename Base::DistTrans()),
+            p(comm_size) {};
+
+          inline int operator()(Key const & x) const {
+            return proc_trans_hash(x) % p;
+          }
+          template<typename V>
+          inline int operator()(::std::pair<Key, V> const & x) const {
+            return this->operator()(x.first);
+          }
+
+          /// keys per call of the distribution hash's batched version.  see imxx::local::assign_batch.
+          static constexpr uint8_t batch_size = ::fsc::hash_batch_size<typename Base::DistTransformedFunc>::value;
+
+          /// ranks of n keys, hashing batch_size keys at a time.
+          template <typename R>
+          inline void assign(Key const * x, size_t const & n, R * ranks) const {
+            uint64_t hashes[batch_size];
+            size_t i = 0;
+            for (; i + batch_size <= n; i += batch_size) {
+              ::fsc::hash_batch(proc_trans_hash, x + i, batch_size, hashes);
+              for (size_t j = 0; j < batch_size; ++j) ranks[i + j] = hashes[j] % p;
+            }
+            for (; i < n; ++i) ranks[i] = this->operator()(x[i]);
+          }
+      } key_to_rank;
+
+    public:
+      using local_container_type = ::bliss::utils::cuckoo_filter<FP_BITS, COUNTER_BITS>;
+
+      using key_type              = Key;
+      using mapped_type           = bool;
+      using value_type            = Key;
+      using size_type             = size_t;
+
+    protected:
+      local_container_type c;
+
+      /// storage hash of the keys, mixed so that it is independent of the distribution hash.
+      typename Base::StoreTransformedFunc store_hash;
+
+      inline uint64_t filter_hash(Key const & key) const {
+        return ::bliss::utils::mix64(store_hash(key));
+      }
+
+      /// transform the keys, and keep 1 of each unless counting.  collective calls are made by the caller.
+      void prepare_keys(::std::vector<Key> & keys, bool sorted_input) const {
+        this->transform_input(keys);
+        if (COUNTER_BITS == 0)
+          ::fsc::unique(keys, sorted_input,
+                        typename Base::StoreTransformedFunc(),
+                        typename Base::StoreTransformedEqual());
+      }
+
+      virtual void local_reset() noexcept {
+        c.reset();
+      }
+
+      virtual void local_clear() noexcept {
+        c.clear();
+      }
+
+      /// size the local filter for n keys.  an empty filter is resized;  a filter with entries is kept, since it cannot be rehashed.
+      virtual void local_reserve(size_t n) {
+        if (c.empty() && (n > c.capacity() * local_container_type::max_load)) c.resize(n);
+      }
+
+    public:
+      cuckoo_filter(const mxx::comm& _comm) : Base(_comm), key_to_rank(_comm.size()) {}
+
+      virtual ~cuckoo_filter() {};
+
+      /// returns the local filter.  please use sparingly.
+      local_container_type& get_local_container() { return c; }
+      local_container_type const & get_local_container() const { return c; }
+
+      /**
+       * @brief insert keys.  only keys are sent.  collective.
+       * @return number of keys on this rank whose fingerprints were not present.
+       */
+      size_t insert(::std::vector<Key>& input, bool sorted_input = false) {
+        BL_BENCH_INIT(insert);
+
+        if (::dsc::empty(input, this->comm)) {
+          BL_BENCH_REPORT_MPI_NAMED(insert, "cuckoo:insert", this->comm);
+          return 0;
+        }
+
+        BL_BENCH_START(insert);
+        this->prepare_keys(input, sorted_input);
+        BL_BENCH_END(insert, "transform_unique", input.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(insert, "dist_data", this->comm);
+          ::std::vector<size_t> recv_counts;
+          ::std::vector<Key> buffer;
+          this->distribute_keys(input, this->key_to_rank, recv_counts, buffer);
+          input.swap(buffer);
+          BL_BENCH_END(insert, "dist_data", input.size());
+        }
+
+        BL_BENCH_START(insert);
+        if (c.capacity() == 0) this->local_reserve(2 * input.size());
+        size_t count = 0;
+        for (auto it = input.begin(); it != input.end(); ++it) {
+          if (c.insert(this->filter_hash(*it))) ++count;
+        }
+        BL_BENCH_END(insert, "insert", c.size());
+
+        BL_BENCH_REPORT_MPI_NAMED(insert, "cuckoo:insert", this->comm);
+        return count;
+      }
+
+      /**
+       * @brief (key, count) for each key:  0 if not inserted, else 1, or its counter with COUNTER_BITS > 0.  collective.
+       * @details  duplicate queries are answered once.  keys is replaced by the queries this rank answered.
+       */
+      ::std::vector<::std::pair<Key, size_type> > count(::std::vector<Key>& keys, bool sorted_input = false) const {
+        BL_BENCH_INIT(count);
+        ::std::vector<::std::pair<Key, size_type> > results;
+
+        if (::dsc::empty(keys, this->comm)) {
+          BL_BENCH_REPORT_MPI_NAMED(count, "cuckoo:count", this->comm);
+          return results;
+        }
+
+        BL_BENCH_START(count);
+        this->transform_input(keys);
+        ::fsc::unique(keys, sorted_input,
+                      typename Base::StoreTransformedFunc(),
+                      typename Base::StoreTransformedEqual());
+        BL_BENCH_END(count, "transform_unique", keys.size());
+
+        ::std::vector<size_t> recv_counts;
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(count, "dist_query", this->comm);
+          ::std::vector<size_t> i2o;
+          ::std::vector<Key> buffer;
+          this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
+          keys.swap(buffer);
+          BL_BENCH_END(count, "dist_query", keys.size());
+        }
+
+        BL_BENCH_START(count);
+        results.reserve(keys.size());
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+          results.emplace_back(*it, c.count(this->filter_hash(*it)));
+        }
+        BL_BENCH_END(count, "local_count", results.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(count, "a2a2", this->comm);
+          this->all2allv(results, recv_counts).swap(results);
+          BL_BENCH_END(count, "a2a2", results.size());
+        }
+
+        BL_BENCH_REPORT_MPI_NAMED(count, "cuckoo:count", this->comm);
+        return results;
+      }
+
+      /**
+       * @brief count of each key, aligned to keys.  collective.
+       * @details  replies carry the count only, and are put back in query order.  keys is not modified.
+       */
+      ::std::vector<size_type> count_aligned(::std::vector<Key> const & keys) const {
+        return this->template aligned_query<size_type>(keys, this->key_to_rank,
+            [this](typename ::std::vector<Key>::const_iterator first, typename ::std::vector<Key>::const_iterator last,
+                   typename ::std::vector<size_type>::iterator out) {
+              for (; first != last; ++first, ++out) *out = this->c.count(this->filter_hash(*first));
+            });
+      }
+
+      /**
+       * @brief erase keys, decrementing their counters with COUNTER_BITS > 0.  only keys are sent.  collective.
+       * @return number of keys found on this rank.
+       */
+      size_t erase(::std::vector<Key>& keys, bool sorted_input = false) {
+        BL_BENCH_INIT(erase);
+
+        if (this->nothing_to_query(keys)) {
+          BL_BENCH_REPORT_MPI_NAMED(erase, "cuckoo:erase", this->comm);
+          return 0;
+        }
+
+        BL_BENCH_START(erase);
+        this->prepare_keys(keys, sorted_input);
+        BL_BENCH_END(erase, "transform_unique", keys.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(erase, "dist_query", this->comm);
+          ::std::vector<size_t> recv_counts;
+          ::std::vector<Key> buffer;
+          this->distribute_keys(keys, this->key_to_rank, recv_counts, buffer);
+          keys.swap(buffer);
+          BL_BENCH_END(erase, "dist_query", keys.size());
+        }
+
+        BL_BENCH_START(erase);
+        size_t count = 0;
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+          if (c.erase(this->filter_hash(*it))) ++count;
+        }
+        BL_BENCH_END(erase, "erase", count);
+
+        BL_BENCH_REPORT_MPI_NAMED(erase, "cuckoo:erase", this->comm);
+        return count;
+      }
+
+      /// expected false positive rate at the largest local load.  collective.
+      double false_positive_rate() const {
+        double r = c.false_positive_rate();
+        if (this->comm.size() > 1) r = ::mxx::allreduce(r, ::mxx::max<double>(), this->comm);
+        return r;
+      }
+
+      // ================  overrides
+
+      /// not available:  the keys are not stored.
+      virtual void to_vector(std::vector<std::pair<Key, bool> > & result) const {
+        throw ::std::logic_error("ERROR: cuckoo_filter does not store its keys.");
+      }
+
+      /// not available:  the keys are not stored.
+      virtual void keys(std::vector<Key> & result) const {
+        throw ::std::logic_error("ERROR: cuckoo_filter does not store its keys.");
+      }
+
+      using Base::to_vector;
+      using Base::keys;
+
+      virtual bool local_empty() const {
+        return this->c.empty();
+      }
+
+      /// number of fingerprints on this rank.  keys with colliding fingerprints count once.
+      virtual size_t local_size() const {
+        return this->c.size();
+      }
+
+      virtual size_t local_unique_size() const {
+        return this->c.size();
+      }
+
+      virtual float get_multiplicity() const {
+        return 1.0f;
+      }
+  };
+
+} /* namespace dsc */
+
+#endif // BLISS_DISTRIBUTED_CUCKOO_FILTER_HPP
@@ -48,11 +48,16 @@
 //#include <sparsehash/dense_hash_map>  // not a multimap, where we need it most.
 #include <functional> 		// for std::function and std::hash
 #include <algorithm> 		// for sort, stable_sort, unique, is_sorted
+#include <cmath>      // ceil
 #include <iterator>  // advance, distance
 
 #include <cstdint>  // for uint8, etc.
 
 #include <type_traits>
+#include <memory>     // unique_ptr
+#include <limits>
+#include <sstream>
+#include <cstdio>     // remove
 
 #include <mxx/collective.hpp>
 #include <mxx/reduction.hpp>
@@ -60,16 +65,28 @@
 
 #include "containers/distributed_map_base.hpp"
 #include "containers/densehash_map.hpp"
+#include "containers/soa_hash_map.hpp"
+#include "containers/compact_counting_map.hpp"
+#include "containers/csr_multimap.hpp"
+#include "containers/mphf_map.hpp"
+#include "containers/thread_partitioned_map.hpp"
+#include "containers/concurrent_densehash_map.hpp"
+#include "containers/local_combiner.hpp"
+#include "containers/query_cache.hpp"
+#include "containers/node_hot_table.hpp"
 
 #include "utils/benchmark_utils.hpp"  // for timing.
 #include "utils/logging.h"
 #include "utils/transform_utils.hpp"
 #include "utils/filter_utils.hpp"
+#include "utils/hyperloglog.hpp"
+#include "utils/count_min_sketch.hpp"
 
 
 #include "common/kmer_transform.hpp"
 
 #include "containers/dsc_container_utils.hpp"
+#include "containers/parallel_for_each.hpp"
 
 #include "io/incremental_mxx.hpp"
 
@@ -167,6 +184,30 @@ namespace dsc  // distributed std container
           inline int operator()(::std::pair<const Key, V> const & x) const {
             return this->operator()(x.first);
           }
+
+          /// keys per call of the distribution hash's batched version.  see imxx::local::assign_batch.
+          static constexpr uint8_t batch_size = ::fsc::hash_batch_size<typename Base::DistTransformedFunc>::value;
+
+          /// ranks of n keys or (key, value) pairs, hashing batch_size keys at a time.
+          template <typename E, typename R>
+          inline void assign(E const * x, size_t const & n, R * ranks) const {
+            Key keys[batch_size];
+            uint64_t hashes[batch_size];
+            size_t i = 0;
+            for (; i + batch_size <= n; i += batch_size) {
+              for (size_t j = 0; j < batch_size; ++j) keys[j] = key_of(x[i + j]);
+              ::fsc::hash_batch(proc_trans_hash, keys, batch_size, hashes);
+              for (size_t j = 0; j < batch_size; ++j) ranks[i + j] = hashes[j] % p;
+            }
+            for (; i < n; ++i) ranks[i] = this->operator()(x[i]);
+          }
+
+        protected:
+          static inline Key const & key_of(Key const & x) { return x; }
+          template<typename V>
+          static inline Key const & key_of(::std::pair<Key, V> const & x) { return x.first; }
+          template<typename V>
+          static inline Key const & key_of(::std::pair<const Key, V> const & x) { return x.first; }
       } key_to_rank;
 
       /**
@@ -192,12 +233,34 @@ namespace dsc  // distributed std container
               if (query_begin == query_end) return 0;
 
               size_t count = 0;  // before size.
-				for (auto it = query_begin; it != query_end; ++it) {
+
+              // group prefetching: prefetch the buckets for a block of queries, then resolve the block.
+              // the block's keys are hashed together, in batches if the storage hash has a batched version.
+              auto it = query_begin;
+              auto pit = query_begin;
+              auto block_end = query_begin;
+              size_t remaining = ::std::distance(query_begin, query_end);
+              size_t block;
+              Key keys[prefetch_batch_size];
+              while (remaining > 0) {
+                block = ::std::min(remaining, static_cast<size_t>(prefetch_batch_size));
+                ::std::advance(block_end, block);
+                remaining -= block;
+
+                for (size_t i = 0; pit != block_end; ++pit, ++i) {
+                  keys[i] = *pit;
+                }
+                ::fsc::prefetch_batch(db, keys, block);
+				for (; it != block_end; ++it) {
 				  count += op(db, *it, output, pred, trans);
 				}
+              }
               return count;
           }
 
+          /// number of queries whose buckets are prefetched together.
+          static constexpr size_t prefetch_batch_size = 16;
+
       };
 
       template <typename K>
@@ -231,6 +294,124 @@ namespace dsc  // distributed std container
 
       mutable bool local_changed;
 
+      /// cardinality sketch of the keys inserted locally so far.  used to reserve the local table once per insert.
+      ::bliss::utils::hyperloglog<12> key_sketch;
+
+      /// if true, the local table is reserved from key_sketch before local insertion.
+      bool reserve_by_estimate;
+
+      /// if true, find counts the results of each source rank first, and reserves the results exactly.
+      bool exact_find;
+
+      /// a cached answer:  the number of entries of a key, and its value if that is 1 and a find saw it.
+      struct cached_answer {
+          size_type count;
+          bool has_value;
+          T value;
+      };
+      /// requester side answers of recent queries.  disabled unless set_query_cache.  see local_answers_valid.
+      mutable ::fsc::query_cache<Key, cached_answer, typename Base::StoreTransformedFunc, typename Base::StoreTransformedEqual> qcache;
+      /// the hottest entries of all ranks, shared per node.  none unless build_hot_table.  see local_answers_valid.
+      mutable ::std::unique_ptr<::dsc::node_hot_table<Key, T, typename Base::StoreTransformedFunc, typename Base::StoreTransformedEqual> > hot;
+      /// sum of local_writes over the ranks when qcache and hot were last validated.
+      mutable size_t query_writes;
+
+      /// sum of local_writes over the ranks.  collective.
+      size_t total_writes() const {
+        return (this->comm.size() > 1) ? ::mxx::allreduce(this->local_writes, this->comm) : this->local_writes;
+      }
+
+      /**
+       * @brief  true if the query cache or the hot table is on.  clears the cache and drops the hot table if any rank
+       *         wrote to its table since the last query.  collective.
+       * @details  inserts, erases, and updates are collective, but not every rank writes in each, so the write counts are summed.
+       */
+      bool local_answers_valid() const {
+        if (!qcache.enabled() && !hot) return false;
+        size_t writes = total_writes();
+        if (writes != query_writes) {
+          qcache.clear();
+          hot.reset();
+          query_writes = writes;
+        }
+        return qcache.enabled() || hot;
+      }
+
+      /// true if find returns at most 1 entry per query, so that its results can be cached with their values.
+      virtual bool cacheable_find() const { return false; }
+
+      /// move the hot and cached counts of keys to hits.  the other keys stay in keys, in order.
+      void cached_counts(::std::vector<Key> & keys, ::std::vector<::std::pair<Key, size_type> > & hits) const {
+        size_t j = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+          if (hot && (hot->find(keys[i]) != nullptr)) {
+            hits.emplace_back(keys[i], 1);
+            continue;
+          }
+          cached_answer const * a = qcache.get(keys[i]);
+          if (a != nullptr) hits.emplace_back(keys[i], a->count);
+          else keys[j++] = keys[i];
+        }
+        keys.resize(j);
+      }
+
+      /// cache the counts from a count query.  a cached value is kept if the count is unchanged.
+      void cache_counts(::std::vector<::std::pair<Key, size_type> > const & results) const {
+        for (auto const & r : results) {
+          cached_answer * a = qcache.peek(r.first);
+          if ((a != nullptr) && (a->count == r.second)) continue;
+          qcache.put(r.first, cached_answer{r.second, false, T()});
+        }
+      }
+
+      /// move the hot and cached find results of keys to hits.  a key whose value is not cached stays in keys, in order.
+      void cached_finds(::std::vector<Key> & keys, ::std::vector<::std::pair<Key, T> > & hits) const {
+        size_t j = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+          T const * v = hot ? hot->find(keys[i]) : nullptr;
+          if (v != nullptr) {
+            hits.emplace_back(keys[i], *v);
+            continue;
+          }
+          cached_answer const * a = qcache.get(keys[i]);
+          if ((a != nullptr) && ((a->count == 0) || a->has_value)) {
+            if (a->count > 0) hits.emplace_back(keys[i], a->value);
+          } else keys[j++] = keys[i];
+        }
+        keys.resize(j);
+      }
+
+      /// cache the answers of a find:  asked are the queried keys, results what came back.  see cacheable_find.
+      void cache_finds(::std::vector<Key> const & asked, ::std::vector<::std::pair<Key, T> > const & results) const {
+        for (auto const & k : asked) qcache.put(k, cached_answer{0, false, T()});
+        for (auto const & r : results) qcache.put(r.first, cached_answer{1, true, r.second});
+      }
+
+      /// get the key from an input element
+      static inline Key const & get_key(Key const & x) { return x; }
+      template <typename V>
+      static inline Key const & get_key(::std::pair<Key, V> const & x) { return x.first; }
+
+      /**
+       * @brief add the received keys to the cardinality sketch, then reserve the local table for the estimated
+       *        number of distinct keys.   avoids the repeated rehashing as the table grows during insert.
+       * @details  called after distribution, so the sketch counts the keys owned by this rank.  the store hash is
+       *        remixed since it may share bits with the distribution hash.  no-op if reserve_by_estimate is false.
+       */
+      template <typename V>
+      void reserve_from_sketch(::std::vector<V> const & input) {
+        if (!reserve_by_estimate || (input.size() == 0)) return;
+
+        typename Base::StoreTransformedFunc store_hash;
+        for (auto it = input.begin(); it != input.end(); ++it) {
+          key_sketch.update(::bliss::utils::mix64(static_cast<uint64_t>(store_hash(get_key(*it)))));
+        }
+
+        // a little over the estimate, since the estimate has a few percent error.
+        size_t est = static_cast<size_t>(key_sketch.estimate() * 1.05);
+        if (est > c.size()) c.resize(est);
+      }
+
       struct LocalCount {
           // filtered element-wise.
           template<class DB, typename Query, class OutputIter,
@@ -268,6 +449,42 @@ namespace dsc  // distributed std container
           // no filter by range AND elemenet for now.
       } count_element;
 
+      /// output iterator for count_element that only sums the counts.
+      struct count_sum_iterator {
+          size_t total;
+          count_sum_iterator() : total(0) {}
+          count_sum_iterator & operator*() { return *this; }
+          count_sum_iterator & operator++() { return *this; }
+          count_sum_iterator & operator=(::std::pair<Key, size_t> const & x) {
+            total += x.second;
+            return *this;
+          }
+      };
+
+      /**
+       * @brief the count phase of an exact find:  the number of results for the queries from each source rank.  local.
+       * @param keys         received queries, grouped by source rank.
+       * @param recv_counts  number of queries from each source rank.
+       * @param send_counts  output, number of results for each source rank.
+       * @return total number of results.
+       */
+      template <typename Predicate>
+      size_t count_results(::std::vector<Key> & keys, ::std::vector<size_t> const & recv_counts,
+                           ::std::vector<size_t> & send_counts, bool sorted_input, Predicate const & pred) const {
+        send_counts.assign(recv_counts.size(), 0);
+        size_t total = 0;
+        auto start = keys.begin();
+        for (size_t i = 0; i < recv_counts.size(); ++i) {
+          auto end = start + recv_counts[i];
+          count_sum_iterator counter;
+          QueryProcessor::process(c, start, end, counter, this->count_element, sorted_input, pred);
+          send_counts[i] = counter.total;
+          total += counter.total;
+          start = end;
+        }
+        return total;
+      }
+
 
       /**
        * @brief insert new elements in the distributed densehash_multimap.
@@ -276,6 +493,7 @@ namespace dsc  // distributed std container
        */
       template <typename KT>
       size_t local_insert(std::vector<KT> & input) {
+          typename Base::tracked_insert tracked(*this);
           BL_BENCH_INIT(local_insert);
 
 //    	  BL_BENCH_START(local_insert);
@@ -303,6 +521,7 @@ namespace dsc  // distributed std container
        */
       template <class KT, class Predicate>
       size_t local_insert(std::vector<KT> & input, Predicate const &pred) {
+          typename Base::tracked_insert tracked(*this);
 
           if (input.size() == 0) return 0;
 
@@ -330,10 +549,13 @@ namespace dsc  // distributed std container
 				   bool sorted_input = false,
 				   Predicate const& pred = Predicate()) const {
           BL_BENCH_INIT(find);
+          typename Base::tracked_query tracked(*this);
 
           ::std::vector<::std::pair<Key, T> > results;
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          bool const nothing = this->nothing_to_query(keys);
+          tracked.mark(::fsc::query_latency_tracker::exchange);
+          if (nothing) {
             BL_BENCH_REPORT_MPI_NAMED(find, "base_densehash_map:find", this->comm);
             return results;
           }
@@ -354,30 +576,54 @@ namespace dsc  // distributed std container
 
             if (this->comm.size() > 1) {
 
+              // answer the hot and cached keys locally.
+              BL_BENCH_COLLECTIVE_START(find, "query_cache", this->comm);
+              ::std::vector<::std::pair<Key, T> > hits;
+              ::std::vector<Key> asked;
+              bool const cached = ::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value &&
+                  this->cacheable_find() && this->local_answers_valid();
+              if (cached) {
+                this->cached_finds(keys, hits);
+                asked = keys;
+              }
+              BL_BENCH_END(find, "query_cache", hits.size());
+
+              // drop the sure misses.
+              BL_BENCH_COLLECTIVE_START(find, "key_filter", this->comm);
+              if (this->refresh_key_filter(local_changed, c.begin(), c.end(), c.size())) {
+                local_changed = false;
+                std::vector<Key> misses;
+                this->drop_key_filter_misses(keys, misses);
+              }
+              BL_BENCH_END(find, "key_filter", keys.size());
+              tracked.mark(::fsc::query_latency_tracker::bucketing);
+
               BL_BENCH_COLLECTIVE_START(find, "dist_query", this->comm);
               // distribute (communication part)
               std::vector<size_t> recv_counts;
               {
-				  std::vector<size_t> i2o;
-				  std::vector<Key > buffer;
-				  ::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-				  keys.swap(buffer);
+				  this->distribute_queries(keys, this->key_to_rank, recv_counts);
 	  //            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
 	  //            				typename Base::StoreTransformedFunc(),
 	  //            				typename Base::StoreTransformedEqual()).swap(recv_counts);
               }
               BL_BENCH_END(find, "dist_query", keys.size());
+              tracked.mark(::fsc::query_latency_tracker::exchange);
 
 
             // local find. memory utilization a potential problem.
             // do for each src proc one at a time.
 
             BL_BENCH_START(find);
-            results.reserve(keys.size());                   // TODO:  should estimate coverage.
+            std::vector<size_t> send_counts(this->comm.size(), 0);
+            if (exact_find) {
+              results.reserve(this->count_results(keys, recv_counts, send_counts, sorted_input, pred));
+            } else {
+              results.reserve(keys.size());                   // TODO:  should estimate coverage.
+            }
             BL_BENCH_END(find, "reserve", results.capacity());
 
             BL_BENCH_START(find);
-            std::vector<size_t> send_counts(this->comm.size(), 0);
             auto start = keys.begin();
             auto end = start;
             size_t new_est = 0;
@@ -389,12 +635,12 @@ namespace dsc  // distributed std container
 
               // estimate the local intermediate results size after the first 3 iterations.
               //if (i == std::ceil(static_cast<double>(this->comm.size()) * 0.05)) {
-              if (req_sofar > 0) {
+              if (!exact_find && (req_sofar > 0)) {
                 new_est = std::ceil((static_cast<double>(results.size()) /
                     static_cast<double>(req_sofar)) *
                                     static_cast<double>(req_total) * 1.1f);
                 if (new_est > results.capacity()) {
-                  if (this->comm.rank() == 0) printf("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu\n", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
+                  if (this->comm.rank() == 0) BL_DEBUGF("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
                   results.reserve(new_est);  // if new_est is lower than capacity, nothing happens.
                 }
               }
@@ -407,15 +653,35 @@ namespace dsc  // distributed std container
               start = end;
             }
             BL_BENCH_END(find, "local_find", results.size());
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
+            tracked.mark(::fsc::query_latency_tracker::lookup);
 
 
             BL_BENCH_COLLECTIVE_START(find, "a2a2", this->comm);
             // send back using the constructed recv count
-            mxx::all2allv(results, send_counts, this->comm).swap(results);
+            this->all2allv(results, send_counts).swap(results);
+            if (cached) {
+              this->cache_finds(asked, results);
+              results.insert(results.end(), hits.begin(), hits.end());
+            }
             BL_BENCH_END(find, "a2a2", results.size());
+            tracked.mark(::fsc::query_latency_tracker::reply);
+
+          } else if (exact_find) {
+            tracked.mark(::fsc::query_latency_tracker::bucketing);
+
+            BL_BENCH_START(find);
+            std::vector<size_t> send_counts;
+            results.reserve(this->count_results(keys, ::std::vector<size_t>(1, keys.size()), send_counts, sorted_input, pred));
+            BL_BENCH_END(find, "reserve", results.capacity());
+
+            BL_BENCH_START(find);
+            QueryProcessor::process(c, keys.begin(), keys.end(), emplace_iter, find_element, sorted_input, pred);
+            BL_BENCH_END(find, "local_find", results.size());
+            tracked.mark(::fsc::query_latency_tracker::lookup);
 
           } else {
+            tracked.mark(::fsc::query_latency_tracker::bucketing);
 
             BL_BENCH_START(find);
             results.reserve(keys.size());                   // TODO:  should estimate coverage.
@@ -436,8 +702,9 @@ namespace dsc  // distributed std container
             BL_BENCH_START(find);
             QueryProcessor::process(c, keys.begin() + estimating, keys.end(), emplace_iter, find_element, sorted_input, pred);
             BL_BENCH_END(find, "local_find", results.size());
+            tracked.mark(::fsc::query_latency_tracker::lookup);
 
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
 
           }
 
@@ -464,7 +731,7 @@ namespace dsc  // distributed std container
 
           ::std::vector<::std::pair<Key, T> > results;
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(find, "base_densehash_map:find_overlap", this->comm);
             return results;
           }
@@ -488,10 +755,7 @@ namespace dsc  // distributed std container
             // distribute (communication part)
             std::vector<size_t> recv_counts;
             {
-				std::vector<size_t> i2o;
-				std::vector<Key > buffer;
-				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-				keys.swap(buffer);
+				this->distribute_queries(keys, this->key_to_rank, recv_counts);
 	//            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
 	//            				typename Base::StoreTransformedFunc(),
 	//            				typename Base::StoreTransformedEqual()).swap(recv_counts);
@@ -669,7 +933,7 @@ namespace dsc  // distributed std container
 
           ::std::vector<typename ::bliss::functional::function_traits<Transform, std::pair<Key, T> >::return_type > results;
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(find, "base_densehash_map:find", this->comm);
             return results;
           }
@@ -698,10 +962,7 @@ namespace dsc  // distributed std container
                 // distribute (communication part)
                 std::vector<size_t> recv_counts;
                 {
-					std::vector<size_t> i2o;
-					std::vector<Key > buffer;
-					::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-					keys.swap(buffer);
+					this->distribute_queries(keys, this->key_to_rank, recv_counts);
 		//            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
 		//            				typename Base::StoreTransformedFunc(),
 		//            				typename Base::StoreTransformedEqual()).swap(recv_counts);
@@ -713,11 +974,15 @@ namespace dsc  // distributed std container
             // do for each src proc one at a time.
 
             BL_BENCH_START(find);
-            results.reserve(keys.size());                   // TODO:  should estimate coverage.
+            std::vector<size_t> send_counts(this->comm.size(), 0);
+            if (exact_find) {
+              results.reserve(this->count_results(keys, recv_counts, send_counts, sorted_input, pred));
+            } else {
+              results.reserve(keys.size());                   // TODO:  should estimate coverage.
+            }
             BL_BENCH_END(find, "reserve", results.capacity());
 
             BL_BENCH_START(find);
-            std::vector<size_t> send_counts(this->comm.size(), 0);
             auto start = keys.begin();
             auto end = start;
 
@@ -730,12 +995,12 @@ namespace dsc  // distributed std container
 
               // estimate the local intermediate results size after the first 3 iterations.
               //if (i == std::ceil(static_cast<double>(this->comm.size()) * 0.05)) {
-              if (req_sofar > 0) {
+              if (!exact_find && (req_sofar > 0)) {
                 new_est = std::ceil((static_cast<double>(results.size()) /
                     static_cast<double>(req_sofar)) *
                                     static_cast<double>(req_total) * 1.1f);
                 if (new_est > results.capacity()) {
-                  if (this->comm.rank() == 0) printf("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu\n", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
+                  if (this->comm.rank() == 0) BL_DEBUGF("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
                   results.reserve(new_est);  // if new_est is lower than capacity, nothing happens.
                 }
               }
@@ -749,14 +1014,25 @@ namespace dsc  // distributed std container
               start = end;
             }
             BL_BENCH_END(find, "local_find", results.size());
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
 
 
             BL_BENCH_COLLECTIVE_START(find, "a2a2", this->comm);
             // send back using the constructed recv count
-            mxx::all2allv(results, send_counts, this->comm).swap(results);
+            this->all2allv(results, send_counts).swap(results);
             BL_BENCH_END(find, "a2a2", results.size());
 
+          } else if (exact_find) {
+
+            BL_BENCH_START(find);
+            std::vector<size_t> send_counts;
+            results.reserve(this->count_results(keys, ::std::vector<size_t>(1, keys.size()), send_counts, sorted_input, pred));
+            BL_BENCH_END(find, "reserve", results.capacity());
+
+            BL_BENCH_START(find);
+            QueryProcessor::process(c, keys.begin(), keys.end(), emplace_iter, find_element, sorted_input, pred, trans);
+            BL_BENCH_END(find, "local_find", results.size());
+
           } else {
 
 
@@ -780,7 +1056,7 @@ namespace dsc  // distributed std container
             QueryProcessor::process(c, keys.begin() + estimating, keys.end(), emplace_iter, find_element, sorted_input, pred, trans);
             BL_BENCH_END(find, "local_find", results.size());
 
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
 
           }
 
@@ -1046,7 +1322,8 @@ namespace dsc  // distributed std container
 
       densehash_map_base(const mxx::comm& _comm) :
 		    Base(_comm), key_to_rank(_comm.size()),
-		    local_changed(false) {}
+		    local_changed(false), key_sketch(), reserve_by_estimate(false), exact_find(false),
+		    qcache(), hot(), query_writes(::std::numeric_limits<size_t>::max()) {}
 
 
       // ================ local overrides
@@ -1054,22 +1331,106 @@ namespace dsc  // distributed std container
       /// clears the densehash_map and release memory
       virtual void local_reset() noexcept {
         c.reset();
+        key_sketch.clear();
       }
 
 
       /// clears the densehash_map
       virtual void local_clear() noexcept {
         c.clear();
+        key_sketch.clear();
       }
 
 
 
+      /// insert saved entries.  checks that a sample of them hash to this rank, i.e. the distribution function matches.
+      virtual void local_load(::std::pair<Key, T> const * first, size_t count) {
+        size_t sample = ::std::min(count, static_cast<size_t>(1024));
+        for (size_t i = 0; i < sample; ++i) {
+          if (key_to_rank(first[i].first) != this->comm.rank())
+            throw ::std::invalid_argument("ERROR: loaded entries do not belong to this rank.  distribution hash differs from the saved map.");
+        }
+
+        this->load_entries(first, count, 0);
+        local_changed = true;
+      }
+
+      /// saved keys are unique:  containers with bulk_load size their tables once, without a staging copy.
+      template <typename C = local_container_type>
+      auto load_entries(::std::pair<Key, T> const * first, size_t count, int)
+        -> decltype(::std::declval<C &>().bulk_load(first, first), void()) {
+        this->c.bulk_load(first, first + count);
+      }
+      void load_entries(::std::pair<Key, T> const * first, size_t count, long) {
+        ::std::vector<::std::pair<Key, T> > entries(first, first + count);
+        this->local_reserve(count);
+        this->c.insert(entries);
+      }
+
+      /// send loaded entries to their owners under key_to_rank, which need not match the saving map's.  see load_repartition.
+      virtual void repartition_chunk(::std::vector<::std::pair<Key, T> > & chunk) {
+        if (this->comm.size() == 1) {
+          this->local_insert(chunk);
+          return;
+        }
+
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<size_t> i2o;
+        ::std::vector<::std::pair<Key, T> > received;
+        this->distribute(chunk, key_to_rank, recv_counts, i2o, received);
+        this->local_insert(received);
+      }
+
     public:
       /// reserve space.  n is the local container size.  this allows different processes to individually adjust its own size.
       virtual void local_reserve( size_t n) {
         c.resize(n); 
       }
 
+      /// enable or disable reserving the local table from a HyperLogLog estimate of the distinct keys, during insert.
+      void set_reserve_by_estimate(bool enable) {
+        reserve_by_estimate = enable;
+      }
+
+      /**
+       * @brief enable or disable exact find:  the results for each source rank are counted first (count_element), so the
+       *        local results are allocated once at their exact size instead of from a growing estimate.  the exchange
+       *        then receives into a buffer of the exact size.  costs a second table lookup per query.  the multimap's
+       *        find (find_overlap) always counts first.
+       */
+      void set_exact_find(bool enable) {
+        exact_find = enable;
+      }
+
+      /**
+       * @brief cache the answers of find and count on the requesting rank, in up to bytes of memory.  0 turns it off.
+       * @details  repeated keys, e.g. the frequent k-mers of a read mapping loop, are then answered locally and only the
+       *        misses are sent.  filtered queries bypass the cache, and maps with more than 1 entry per key cache only counts.
+       *        any insert, erase, update, or clear empties the cache at the next query.  set the same on all ranks.
+       *        with 1 rank every query is local, and the cache is not used.
+       */
+      void set_query_cache(size_t const bytes) {
+        qcache = decltype(qcache)(bytes);
+      }
+      /// query keys answered from the cache on this rank, and keys looked up in it without an answer.
+      size_t query_cache_hits() const { return qcache.hits(); }
+      size_t query_cache_misses() const { return qcache.misses(); }
+
+      /// rebuild the local table without the tombstones left by erase, and free the old storage.  see densehash_map::compact
+      virtual void local_compact() {
+        c.compact();
+      }
+
+      /// see map_base::release_memory.
+      virtual void local_shrink() {
+        this->local_compact();
+      }
+
+      /// erase compacts the local table when its tombstones exceed this fraction of the occupied buckets.  0 disables.
+      void set_compact_ratio(double const ratio) {
+        c.set_compact_ratio(ratio);
+      }
+
       virtual size_t local_capacity() noexcept {
     	  return c.bucket_count();
       }
@@ -1078,6 +1439,36 @@ namespace dsc  // distributed std container
       }
 
 
+    protected:
+      /// local keys that are (in_other) or are not in the other local container, without duplicates.
+      template <typename OtherContainer>
+      ::std::vector<Key> local_keys_by_membership(OtherContainer const & other, bool const in_other) const {
+        ::std::vector<::std::vector<Key> > parts(::fsc::parallel_for_each_threads(0));
+        ::fsc::parallel_for_each(c, typename Base::template membership_collector<OtherContainer>{other, in_other, parts});
+        ::std::vector<Key> keys = Base::concat(parts);
+        ::fsc::unique(keys, false,
+                      typename Base::StoreTransformedFunc(),
+                      typename Base::StoreTransformedEqual());
+        return keys;
+      }
+
+      /// erase all entries of the given local keys.  returns the number of entries removed.
+      size_t local_erase_keys(::std::vector<Key> const & keys) {
+        if (keys.size() == 0) return 0;
+        size_t before = c.size();
+        c.erase(keys.begin(), keys.end());
+        ++this->local_writes;
+        if (c.size() != before) local_changed = true;
+        return before - c.size();
+      }
+
+      /// insert entries that are already on the right rank.  overridden by the reduction maps to combine values.
+      virtual size_t local_merge(::std::vector<::std::pair<Key, T> > & entries) {
+        return this->local_insert(entries);
+      }
+
+    public:
+
       virtual ~densehash_map_base() {};
 
 
@@ -1085,6 +1476,57 @@ namespace dsc  // distributed std container
       local_container_type& get_local_container() { return c; }
       local_container_type const & get_local_container() const { return c; }
 
+      /// call fn(element, thread_id) for each local element, with the local storage split into per-thread ranges.
+      /// fn is called concurrently.  see containers/parallel_for_each.hpp
+      template <typename F>
+      void parallel_for_each_local(F fn, int const nthreads = 0) const {
+        ::fsc::parallel_for_each(c, fn, nthreads);
+      }
+
+      /**
+       * @brief keep only the keys that are also in other.  collective, but otherwise local:  equal keys of
+       *        co-partitioned maps are on the same rank.
+       * @param other  distributed map with a congruent communicator and the same key to rank assignment.
+       * @return number of local entries removed.
+       * @throw std::invalid_argument if the maps are not co-partitioned.  see map_base::check_copartitioned.
+       */
+      template <typename Other>
+      size_t intersect(Other const & other) {
+        this->check_copartitioned(key_to_rank, other.get_comm(), other.get_local_container());
+        ::std::vector<Key> keys = local_keys_by_membership(other.get_local_container(), false);
+        return local_erase_keys(keys);
+      }
+
+      /**
+       * @brief remove the keys that are in other.  collective, but otherwise local.  see intersect.
+       * @return number of local entries removed.
+       */
+      template <typename Other>
+      size_t subtract(Other const & other) {
+        this->check_copartitioned(key_to_rank, other.get_comm(), other.get_local_container());
+        ::std::vector<Key> keys = local_keys_by_membership(other.get_local_container(), true);
+        return local_erase_keys(keys);
+      }
+
+      /**
+       * @brief insert the entries of other, with the same semantics as insert, e.g. counting maps add the counts.
+       *        collective, but otherwise local.  see intersect.
+       * @return number of local entries added.
+       */
+      template <typename Other>
+      size_t merge(Other const & other) {
+        this->check_copartitioned(key_to_rank, other.get_comm(), other.get_local_container());
+        ::std::vector<::std::vector<::std::pair<Key, T> > > parts(::fsc::parallel_for_each_threads(0));
+        ::fsc::parallel_for_each(other.get_local_container(), typename Base::entry_collector{parts});
+        ::std::vector<::std::pair<Key, T> > entries = Base::concat(parts);
+        return this->local_merge(entries);
+      }
+
+      /// transform that insert applies to the input keys, e.g. to canonical k-mers.
+      using input_transform_type = typename Base::InputTransform;
+      /// rank of a transformed key.  with input_transform_type, lets a producer write keys in send order.  see insert_bucketed.
+      KeyToRank const & get_key_to_rank() const { return key_to_rank; }
+
 //      const_iterator cbegin() const
 //      {
 //        return c.cbegin();
@@ -1105,6 +1547,10 @@ namespace dsc  // distributed std container
         if (c.empty()) return;
         c.to_vector(result);
       }
+      /// k entries of the local table, in 1 pass over it.
+      virtual void local_sample(size_t k, ::std::mt19937_64 & gen, std::vector<std::pair<Key, T> > & result) const {
+        ::fsc::sample(c.begin(), c.size(), k, gen, result);
+      }
       /// extract the unique keys of a map.
       virtual void keys(std::vector<Key> & result) const {
         result.clear();
@@ -1114,6 +1560,19 @@ namespace dsc  // distributed std container
 
 
 
+      /**
+       * @brief number of entries for each key, aligned to keys:  result i is the count of keys[i].  collective.
+       * @details  replies carry counts only, and are put back in query order with the saved bucketing permutation.
+       *           duplicate keys are each counted.  keys is not modified.
+       */
+      ::std::vector<size_type> count_aligned(::std::vector<Key> const & keys) const {
+        return this->template aligned_query<size_type>(keys, this->key_to_rank,
+            [this](typename ::std::vector<Key>::const_iterator first, typename ::std::vector<Key>::const_iterator last,
+                   typename ::std::vector<size_type>::iterator out) {
+              for (; first != last; ++first, ++out) *out = this->c.count(*first);
+            });
+      }
+
       /**
        * @brief count elements with the specified keys in the distributed densehash_multimap.
        * @param first
@@ -1147,18 +1606,27 @@ namespace dsc  // distributed std container
 
           if (this->comm.size() > 1) {
 
-            // distribute (communication part)
-
-
+            // answer the hot and cached keys locally.
+            BL_BENCH_COLLECTIVE_START(count, "query_cache", this->comm);
+            ::std::vector<::std::pair<Key, size_type> > hits;
+            bool const cached = ::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value && this->local_answers_valid();
+            if (cached) this->cached_counts(keys, hits);
+            BL_BENCH_END(count, "query_cache", hits.size());
+
+            // drop the sure misses.  they are counted as 0 here.
+            BL_BENCH_COLLECTIVE_START(count, "key_filter", this->comm);
+            std::vector<Key> misses;
+            if (this->refresh_key_filter(local_changed, c.begin(), c.end(), c.size())) {
+              local_changed = false;
+              this->drop_key_filter_misses(keys, misses);
+            }
+            BL_BENCH_END(count, "key_filter", keys.size());
 
             BL_BENCH_COLLECTIVE_START(count, "dist_query", this->comm);
             // distribute (communication part)
             std::vector<size_t> recv_counts;
             {
-            	std::vector<size_t> i2o;
-                std::vector<Key > buffer;
-                ::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-                keys.swap(buffer);
+            	this->distribute_queries(keys, this->key_to_rank, recv_counts);
             }
 //            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
 //            				typename Base::StoreTransformedFunc(),
@@ -1191,7 +1659,14 @@ namespace dsc  // distributed std container
 
             // send back using the constructed recv count
             BL_BENCH_COLLECTIVE_START(count, "a2a2", this->comm);
-            mxx::all2allv(results, recv_counts, this->comm).swap(results);
+            this->all2allv(results, recv_counts).swap(results);
+            for (auto it = misses.begin(); it != misses.end(); ++it) {
+              results.emplace_back(*it, 0);
+            }
+            if (cached) {
+              this->cache_counts(results);
+              results.insert(results.end(), hits.begin(), hits.end());
+            }
             BL_BENCH_END(count, "a2a2", results.size());
 
 
@@ -1261,10 +1736,7 @@ namespace dsc  // distributed std container
               // distribute (communication part)
               std::vector<size_t> recv_counts;
               {
-				  std::vector<size_t> i2o;
-				  std::vector<Key > buffer;
-				  ::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-				  keys.swap(buffer);
+				  this->distribute_queries(keys, this->key_to_rank, recv_counts);
 	  //            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
 	  //            				typename Base::StoreTransformedFunc(),
 	  //            				typename Base::StoreTransformedEqual()).swap(recv_counts);
@@ -1297,7 +1769,7 @@ namespace dsc  // distributed std container
 
             // send back using the constructed recv count
             BL_BENCH_COLLECTIVE_START(count, "a2a2", this->comm);
-            mxx::all2allv(results, recv_counts, this->comm).swap(results);
+            this->all2allv(results, recv_counts).swap(results);
             BL_BENCH_END(count, "a2a2", results.size());
           } else {
 
@@ -1452,7 +1924,7 @@ namespace dsc  // distributed std container
 //          if (this->comm.size() > 1) {
 //            // send back using the constructed recv count
 //            BL_BENCH_COLLECTIVE_START(exists, "a2a2", this->comm);
-//            mxx::all2allv(results, recv_counts, this->comm).swap(results);
+//            this->all2allv(results, recv_counts).swap(results);
 //            BL_BENCH_END(exists, "a2a2", results.size());
 //          }
 //
@@ -1506,7 +1978,7 @@ namespace dsc  // distributed std container
 
 	            BL_BENCH_COLLECTIVE_START(exists, "dist_query", this->comm);
 	            // distribute (communication part)
-				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, bucketed, this->comm);
+				this->distribute(keys, this->key_to_rank, recv_counts, i2o, bucketed);
 	//            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
 	//            				typename Base::StoreTransformedFunc(),
 	//            				typename Base::StoreTransformedEqual()).swap(recv_counts);
@@ -1560,7 +2032,7 @@ namespace dsc  // distributed std container
 
 				// send back using the constructed recv count
 			  BL_BENCH_START(exists);
-			  auto tmp_results = mxx::all2allv(results, recv_counts, this->comm);
+			  auto tmp_results = this->all2allv(results, recv_counts);
 			  BL_BENCH_END(exists, "a2a2", results.size());
 
 //				std::cout << "rank " << this->comm.rank() << " exists. results size=" << results.size() << " keys2 " << keys2.size() << std::endl;
@@ -1606,7 +2078,7 @@ namespace dsc  // distributed std container
 
           BL_BENCH_INIT(erase);
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(erase, "base_densehash:erase", this->comm);
             return 0;
           }
@@ -1622,11 +2094,7 @@ namespace dsc  // distributed std container
 //            BLISS_UNUSED(recv_counts);
             std::vector<size_t> recv_counts;
             {
-				std::vector<size_t> i2o;
-				std::vector<Key > buffer;
-				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-				//::imxx::destructive_distribute(input, this->key_to_rank, recv_counts, buffer, this->comm);
-				keys.swap(buffer);
+				this->distribute_queries(keys, this->key_to_rank, recv_counts);
             }
             BL_BENCH_END(erase, "dist_query", keys.size());
 
@@ -1657,6 +2125,7 @@ namespace dsc  // distributed std container
 
           BL_BENCH_REPORT_MPI_NAMED(erase, "base_densehash:erase", this->comm);
 
+          ++this->local_writes;
           if (before != this->c.size()) local_changed = true;
 
           return before - this->c.size();
@@ -1679,6 +2148,7 @@ namespace dsc  // distributed std container
 
           if (count > 0) local_changed = true;
         }
+        ++this->local_writes;
 
         if (this->comm.size() > 1) this->comm.barrier();
 
@@ -1707,6 +2177,16 @@ namespace dsc  // distributed std container
         return this->c.unique_size();
       }
 
+      /// buckets of the local table, for the table tracker.
+      virtual size_t local_bucket_count() const {
+        return this->c.bucket_count();
+      }
+
+      /// probe lengths and tombstones of the local table.
+      virtual void local_table_stats(::fsc::table_stats & stats) const {
+        stats.merge(this->c.get_table_stats());
+      }
+
   };
 
 
@@ -1733,16 +2213,19 @@ namespace dsc  // distributed std container
    * @tparam Hash   hash function for local and distribution.  requires a template arugment (Key), and a bool (prefix, chooses the MSBs of hash instead of LSBs)
    * @tparam Equal   default to ::std::equal_to<Key>   equal function for the local storage.
    * @tparam Alloc  default to ::std::allocator< ::std::pair<const Key, T> >    allocator for local storage.
+   * @tparam Container  local map.  default to ::fsc::densehash_map.  ::fsc::soa_hash_map stores keys and values in separate arrays.
    */
   template<typename Key, typename T,
   	  template <typename> class MapParams,
     typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
-	  class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+	  class Alloc = ::std::allocator< ::std::pair<const Key, T> >,
+    template <typename, typename, typename, template <typename> class,
+      typename, typename, typename, bool> class Container = ::fsc::densehash_map
   >
   class densehash_map : 
-    public densehash_map_base<Key, T, ::fsc::densehash_map, MapParams, SpecialKeys, Alloc> {
+    public densehash_map_base<Key, T, Container, MapParams, SpecialKeys, Alloc> {
     protected:
-      using Base = densehash_map_base<Key, T, ::fsc::densehash_map, MapParams, SpecialKeys, Alloc>;
+      using Base = densehash_map_base<Key, T, Container, MapParams, SpecialKeys, Alloc>;
 
 
     public:
@@ -1804,6 +2287,9 @@ namespace dsc  // distributed std container
         		typename Base::Base::StoreTransformedEqual());
       }
 
+      /// keys are unique, so find returns at most 1 entry per query.
+      virtual bool cacheable_find() const { return true; }
+
 
     public:
 
@@ -1820,9 +2306,16 @@ namespace dsc  // distributed std container
       using Base::unique_size;
 
 
+      /// with a memory budget (see set_memory_budget), keys that do not fit are queried in rounds.
       template <bool remove_duplicate = false, class Predicate = ::bliss::filter::TruePredicate>
       ::std::vector<::std::pair<Key, T> > find(::std::vector<Key>& keys, bool sorted_input = false,
                                                           Predicate const& pred = Predicate()) const {
+          ::std::vector<::std::pair<Key, T> > results;
+          if (this->query_within_budget(keys, 1.0, [this, sorted_input, &pred](::std::vector<Key> & batch) {
+                return Base::template find<remove_duplicate>(this->find_element, batch, sorted_input, pred);
+              }, results))
+            return results;
+
           return Base::template find<remove_duplicate>(find_element, keys, sorted_input, pred);
       }
       template <bool remove_duplicate = false, class Transform = ::bliss::transform::identity<Key>, class Predicate = ::bliss::filter::TruePredicate>
@@ -1832,6 +2325,74 @@ namespace dsc  // distributed std container
           return Base::template find<remove_duplicate>(find_element, keys, sorted_input, pred, trans);
       }
 
+      /**
+       * @brief value of each key, aligned to keys:  result i is the value of keys[i], or missing if keys[i] is absent.  collective.
+       * @details  replies carry values only, and are put back in query order with the saved bucketing permutation.
+       *           keys is not modified.  use count_aligned to tell absent keys from stored missing values.
+       */
+      ::std::vector<T> find_aligned(::std::vector<Key> const & keys, T const & missing = T()) const {
+        return this->template aligned_query<T>(keys, this->key_to_rank,
+            [this, &missing](typename ::std::vector<Key>::const_iterator first, typename ::std::vector<Key>::const_iterator last,
+                             typename ::std::vector<T>::iterator out) {
+              for (; first != last; ++first, ++out) {
+                auto range = this->c.equal_range(*first);
+                *out = (range.first == range.second) ? missing : range.first->second;
+              }
+            });
+      }
+
+      /**
+       * @brief copy the n entries with the largest values over all ranks, e.g. the most frequent k-mers of a counting map,
+       *        into a table shared by the ranks of each node (see node_hot_table).  find and count then answer these keys
+       *        before the query exchange.  collective.
+       * @details  each rank scans its table once, keeping its top n in a heap.  any later insert, erase, update, or clear
+       *        drops the table at the next query.  n = 0 drops it now.  with 1 rank the table is not used.
+       * @return number of hot entries.
+       */
+      size_t build_hot_table(size_t const n) {
+        this->hot.reset();
+        if (n == 0) return 0;
+
+        auto greater = [](::std::pair<Key, T> const & x, ::std::pair<Key, T> const & y) {
+          return y.second < x.second;
+        };
+        ::std::vector<::std::pair<Key, T> > top;
+        top.reserve(n);
+        for (auto it = this->c.begin(); it != this->c.end(); ++it) {
+          if (top.size() < n) {
+            top.emplace_back(*it);
+            ::std::push_heap(top.begin(), top.end(), greater);
+          } else if (top.front().second < (*it).second) {
+            ::std::pop_heap(top.begin(), top.end(), greater);
+            top.back() = *it;
+            ::std::push_heap(top.begin(), top.end(), greater);
+          }
+        }
+
+        // the table holds the current content, so earlier writes must not drop it.
+        size_t writes = this->total_writes();
+        if (writes != this->query_writes) {
+          this->qcache.clear();
+          this->query_writes = writes;
+        }
+        this->hot.reset(new typename decltype(this->hot)::element_type(top, n, this->comm));
+        return this->hot->size();
+      }
+
+      /**
+       * @brief find in rounds of at most batch_size keys per rank, handing each round's results to sink.  collective.
+       * @details  sink(::std::vector<::std::pair<Key, T> > & results) is called once per round with the local results,
+       *           so the results are never materialized in full.  keys is not modified.
+       * @return number of results on this rank.
+       */
+      template <bool remove_duplicate = false, class Sink, class Predicate = ::bliss::filter::TruePredicate>
+      size_t find_stream(::std::vector<Key> const & keys, Sink && sink, size_t batch_size,
+                         bool sorted_input = false, Predicate const& pred = Predicate()) const {
+          return this->query_in_rounds(keys, batch_size, [this, sorted_input, &pred](::std::vector<Key> & batch) {
+            return this->template find<remove_duplicate>(batch, sorted_input, pred);
+          }, sink);
+      }
+
       template <class Predicate = ::bliss::filter::TruePredicate>
       ::std::vector<::std::pair<Key, T> > find(Predicate const& pred = Predicate()) const {
           ::std::vector<::std::pair<Key, T> > results;
@@ -1902,6 +2463,14 @@ namespace dsc  // distributed std container
           return results;
       }
 
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert(std::vector<::std::pair<Key, T> >&& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred](std::vector<::std::pair<Key, T> > & owned) {
+          return this->insert(owned, sorted_input, pred);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed densehash_multimap.
        * @param first
@@ -1928,32 +2497,20 @@ namespace dsc  // distributed std container
           // TODO: keep unique only may not be needed - comm speed may be faster than we can compute unique.
 //          auto recv_counts(::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm));
 //          BLISS_UNUSED(recv_counts);
-          std::vector<size_t> recv_counts;
-			  std::vector<size_t> i2o;
-			  std::vector<::std::pair<Key, T> > buffer;
-			  ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-			  input.swap(buffer);
+          this->distribute_insert(input, this->key_to_rank);
           BL_BENCH_END(insert, "dist_data", input.size());
         }
 
 
         BL_BENCH_START(insert);
         // local compute part.  called by the communicator.
-        //this->c.resize(input.size() / 2);
-        if (this->comm.rank() == 0)
-        std::cout << "rank " << this->comm.rank() <<
-          " BEFORE input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
-
+        this->reserve_from_sketch(input);
         size_t count = 0;
         if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
           count = this->Base::local_insert(input, pred);
         else
           count = this->Base::local_insert(input);
 
-        if (this->comm.rank() == 0)
-        std::cout << "rank " << this->comm.rank() <<
-          " AFTER input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
-
         //this->c.resize(0);
 //        std::cout << "rank " << this->comm.rank() <<
 //          " input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
@@ -1976,7 +2533,7 @@ namespace dsc  // distributed std container
         // even if count is 0, still need to participate in mpi calls.  if (input.size() == 0) return;
         BL_BENCH_INIT(update);
 
-        if (this->empty() || ::dsc::empty(input, this->comm)) {
+        if (this->nothing_to_query(input)) {
           BL_BENCH_REPORT_MPI_NAMED(update, "hashmap:update", this->comm);
           return 0;
         }
@@ -1996,7 +2553,7 @@ namespace dsc  // distributed std container
 			std::vector<size_t> recv_counts;
 			  std::vector<size_t> i2o;
 			  std::vector<::std::pair<Key, V> > buffer;
-			  ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+			  this->distribute(input, this->key_to_rank, recv_counts, i2o, buffer);
 			  input.swap(buffer);
 
 			BL_BENCH_END(update, "distribute_(localcnt)", recv_counts[this->comm.rank()]);
@@ -2007,6 +2564,7 @@ namespace dsc  // distributed std container
         BL_BENCH_START(update);
         // local compute part.
         size_t count = this->c.update(input, op);
+        ++this->local_writes;
         BL_BENCH_END(update, "update", count);
 
         BL_BENCH_REPORT_MPI_NAMED(update, "hashmap:update", this->comm);
@@ -2020,6 +2578,7 @@ namespace dsc  // distributed std container
 
         BL_BENCH_START(update);
         size_t count = this->c.update(fop, op);
+        ++this->local_writes;
         BL_BENCH_END(update, "update", count);
 
         BL_BENCH_REPORT_MPI_NAMED(update, "hashmap:update", this->comm);
@@ -2058,16 +2617,19 @@ namespace dsc  // distributed std container
    * @tparam Hash   hash function for local and distribution.  requires a template arugment (Key), and a bool (prefix, chooses the MSBs of hash instead of LSBs)
    * @tparam Equal   default to ::std::equal_to<Key>   equal function for the local storage.
    * @tparam Alloc  default to ::std::allocator< ::std::pair<const Key, T> >    allocator for local storage.
+   * @tparam Container  local multimap.  default to ::fsc::densehash_multimap.  ::fsc::csr_multimap stores the values in 1 array.
    */
   template<typename Key, typename T,
   template <typename> class MapParams,
     typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
-  class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  class Alloc = ::std::allocator< ::std::pair<const Key, T> >,
+    template <typename, typename, typename, template <typename> class,
+      typename, typename, typename, bool> class Container = ::fsc::densehash_multimap
   >
   class densehash_multimap : 
-    public densehash_map_base<Key, T, ::fsc::densehash_multimap, MapParams, SpecialKeys, Alloc> {
+    public densehash_map_base<Key, T, Container, MapParams, SpecialKeys, Alloc> {
     protected:
-      using Base = densehash_map_base<Key, T, ::fsc::densehash_multimap, MapParams, SpecialKeys, Alloc>;
+      using Base = densehash_map_base<Key, T, Container, MapParams, SpecialKeys, Alloc>;
 
 
     public:
@@ -2137,70 +2699,373 @@ namespace dsc  // distributed std container
 
       mutable size_t local_unique_count;
 
+      /// keys whose entries are split across all ranks by rebalance_heavy_keys.  replicated.
+      typename Base::template UniqueKeySetUtilityType<Key> heavy_keys;
 
 
+      /// move the queries for heavy keys from keys to heavy, preserving the order of the rest.
+      void split_heavy_queries(::std::vector<Key> & keys, ::std::vector<Key> & heavy) const {
+        typename Base::InputTransform trans;
+        auto out = keys.begin();
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+          if (heavy_keys.count(trans(*it)) > 0) {
+            heavy.push_back(*it);
+          } else {
+            if (out != it) *out = *it;
+            ++out;
+          }
+        }
+        keys.erase(out, keys.end());
+      }
+
+      /// transform the heavy key queries and gather them from all ranks.  collective.  recv_counts is per source rank.
+      template <bool remove_duplicate>
+      ::std::vector<Key> gather_heavy_queries(::std::vector<Key> & heavy, ::std::vector<size_t> & recv_counts) const {
+        this->transform_input(heavy);
+        if (remove_duplicate)
+          ::fsc::unique(heavy, false,
+                        typename Base::StoreTransformedFunc(),
+                        typename Base::StoreTransformedEqual());
+
+        recv_counts = ::mxx::allgather(heavy.size(), this->comm);
+        return ::mxx::allgatherv(heavy, recv_counts, this->comm);
+      }
+
+      /**
+       * @brief find the entries for heavy keys.  every rank holds a share of them, so all ranks answer.  collective.
+       * @details each rank answers all gathered heavy queries from its share, and the replies are returned with
+       *          an all2allv.  results are appended.
+       */
+      template <bool remove_duplicate, class Predicate, class Transform, typename R>
+      void find_heavy(::std::vector<Key> & heavy, ::std::vector<R> & results,
+                      Predicate const & pred, Transform const & trans) const {
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<Key> queries = gather_heavy_queries<remove_duplicate>(heavy, recv_counts);
+
+        ::std::vector<R> replies;
+        ::fsc::back_emplace_iterator<::std::vector<R> > emplace_iter(replies);
+        ::std::vector<size_t> send_counts(this->comm.size(), 0);
+
+        auto start = queries.begin();
+        auto end = start;
+        for (int i = 0; i < this->comm.size(); ++i) {
+          ::std::advance(end, recv_counts[i]);
+          send_counts[i] = Base::QueryProcessor::process(this->c, start, end, emplace_iter, find_element, false, pred, trans);
+          start = end;
+        }
+
+        replies = this->all2allv(replies, send_counts);
+        results.insert(results.end(), replies.begin(), replies.end());
+      }
+
+      /// count the entries for heavy keys, summing the shares from all ranks.  collective.  results are appended.
+      template <bool remove_duplicate, class Predicate>
+      void count_heavy(::std::vector<Key> & heavy, ::std::vector<::std::pair<Key, size_type> > & results,
+                       Predicate const & pred) const {
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<Key> queries = gather_heavy_queries<remove_duplicate>(heavy, recv_counts);
+
+        // count_element produces exactly one reply per query, in query order.
+        ::std::vector<::std::pair<Key, size_type> > replies;
+        replies.reserve(queries.size());
+        ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, size_type> > > emplace_iter(replies);
+        Base::QueryProcessor::process(this->c, queries.begin(), queries.end(), emplace_iter, this->count_element, false, pred);
+
+        replies = this->all2allv(replies, recv_counts);
+
+        // replies from rank i are the i-th block of heavy.size() entries.
+        for (size_t j = 0; j < heavy.size(); ++j) {
+          size_type total = 0;
+          for (size_t i = 0; i < replies.size(); i += heavy.size()) {
+            total += replies[i + j].second;
+          }
+          results.emplace_back(heavy[j], total);
+        }
+      }
+
 
     public:
 
 
       densehash_multimap(const mxx::comm& _comm) :
-	  	  Base(_comm), local_unique_count(0) {}
+	  	  Base(_comm), local_unique_count(0), heavy_keys() {}
 
 
       virtual ~densehash_multimap() {}
 
-      using Base::count;
       using Base::erase;
       using Base::unique_size;
 
 
+      /// with a memory budget (see set_memory_budget), keys whose results do not fit are queried in rounds.
       template <bool remove_duplicate = false, class Predicate = ::bliss::filter::TruePredicate>
       ::std::vector<::std::pair<Key, T> > find(::std::vector<Key>& keys, bool sorted_input = false,
                                                Predicate const& pred = Predicate()) const {
-          return Base::template find_overlap<remove_duplicate>(find_element, keys, sorted_input, pred);
+          ::std::vector<::std::pair<Key, T> > results;
+          double per_key = this->get_memory_budget().limited() ? this->global_multiplicity() : 1.0;
+          if (this->query_within_budget(keys, per_key, [this, sorted_input, &pred](::std::vector<Key> & batch) {
+                return this->template find_unbudgeted<remove_duplicate>(batch, sorted_input, pred);
+              }, results))
+            return results;
+
+          return this->template find_unbudgeted<remove_duplicate>(keys, sorted_input, pred);
+      }
+    protected:
+      template <bool remove_duplicate, class Predicate>
+      ::std::vector<::std::pair<Key, T> > find_unbudgeted(::std::vector<Key>& keys, bool sorted_input,
+                                                          Predicate const& pred) const {
+          if (heavy_keys.empty())
+            return Base::template find_overlap<remove_duplicate>(find_element, keys, sorted_input, pred);
+
+          ::std::vector<Key> heavy;
+          split_heavy_queries(keys, heavy);
+          ::std::vector<::std::pair<Key, T> > results =
+              Base::template find_overlap<remove_duplicate>(find_element, keys, sorted_input, pred);
+          find_heavy<remove_duplicate>(heavy, results, pred, ::bliss::transform::identity<Key>());
+          return results;
       }
+    public:
       template <bool remove_duplicate = false, class Predicate = ::bliss::filter::TruePredicate, class Transform = ::bliss::transform::identity<Key>>
       ::std::vector<typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type>
       find_transform(::std::vector<Key>& keys, bool sorted_input = false,
     		  Predicate const& pred = Predicate(),
     		  Transform const & trans = Transform()) const {
-          return Base::template find<remove_duplicate>(find_element, keys, sorted_input, pred, trans);
+          if (heavy_keys.empty())
+            return Base::template find<remove_duplicate>(find_element, keys, sorted_input, pred, trans);
+
+          ::std::vector<Key> heavy;
+          split_heavy_queries(keys, heavy);
+          auto results = Base::template find<remove_duplicate>(find_element, keys, sorted_input, pred, trans);
+          find_heavy<remove_duplicate>(heavy, results, pred, trans);
+          return results;
       }
 
+      /**
+       * @brief count elements with the specified keys.  heavy keys are counted on all ranks.
+       */
+      template <bool remove_duplicate = false, class Predicate = ::bliss::filter::TruePredicate>
+      ::std::vector<::std::pair<Key, size_type> > count(::std::vector<Key>& keys, bool sorted_input = false,
+                                                        Predicate const& pred = Predicate() ) const {
+          if (heavy_keys.empty())
+            return Base::template count<remove_duplicate>(keys, sorted_input, pred);
+
+          ::std::vector<Key> heavy;
+          split_heavy_queries(keys, heavy);
+          ::std::vector<::std::pair<Key, size_type> > results =
+              Base::template count<remove_duplicate>(keys, sorted_input, pred);
+          count_heavy<remove_duplicate>(heavy, results, pred);
+          return results;
+      }
 
       template <class Predicate = ::bliss::filter::TruePredicate>
-      ::std::vector<::std::pair<Key, T> > find(Predicate const& pred = Predicate()) const {
-          ::std::vector<::std::pair<Key, T> > results;
-
-          if (this->local_empty()) return results;
+      ::std::vector<::std::pair<Key, size_type> > count(Predicate const & pred = Predicate()) const {
+        return Base::count(pred);
+      }
 
-          ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, T> > > emplace_iter(results);
+      /**
+       * @brief seed hits of reads, binned by diagonal on the owners.  see map_base::seed_hits.  heavy keys are answered by all ranks.  collective.
+       * @param seeds  (k-mer, read id, offset in read) per seed.
+       * @param bin_width  diagonals per bin.
+       * @return  (read id, diagonal, votes) per diagonal bin of this rank's reads, sorted by read id then diagonal.
+       */
+      ::std::vector<::dsc::seed_hit> map_reads(::std::vector<::dsc::read_seed<Key> > const & seeds, size_t const bin_width = 1) const {
+        typename Base::template equal_range_visitor<local_container_type> visit{this->c};
+        return this->seed_hits(seeds, this->key_to_rank, visit, !heavy_keys.empty(),
+                               [this](Key const & k) { return heavy_keys.count(k) > 0; }, bin_width);
+      }
 
-          std::vector<Key> keys;
-          this->keys(keys);
+      /**
+       * @brief erase elements with the specified keys.  heavy keys are erased on all ranks.
+       */
+      template <bool remove_duplicate = false, class Predicate = ::bliss::filter::TruePredicate>
+      size_t erase(::std::vector<Key>& keys, bool sorted_input = false, Predicate const& pred = Predicate() ) {
+          if (heavy_keys.empty())
+            return Base::template erase<remove_duplicate>(keys, sorted_input, pred);
 
-          ::std::vector<::std::pair<Key, size_t> > count_results;
-          count_results.reserve(keys.size() / 2);
-          ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, size_t> > > count_emplace_iter(count_results);
+          ::std::vector<Key> heavy;
+          split_heavy_queries(keys, heavy);
+          size_t count = Base::template erase<remove_duplicate>(keys, sorted_input, pred);
 
-          // count now.
-          Base::QueryProcessor::process(this->c, keys.begin(), keys.end(), count_emplace_iter, this->count_element, false, pred);
-          size_t count = ::std::accumulate(count_results.begin(), count_results.end(), static_cast<size_t>(0),
-                                           [](size_t v, ::std::pair<Key, size_t> const & x) {
-            return v + x.second;
-          });
+          ::std::vector<size_t> recv_counts;
+          ::std::vector<Key> queries = gather_heavy_queries<true>(heavy, recv_counts);
 
-          // then reserve
-          results.reserve(count);                   // TODO:  should estimate coverage.
+          size_t before = this->c.size();
+          if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value) {
+            this->c.erase(queries.begin(), queries.end(), pred);
+          } else {
+            this->c.erase(queries.begin(), queries.end());
+          }
+          if (before != this->c.size()) this->local_changed = true;
 
-          Base::QueryProcessor::process(this->c, keys.begin(), keys.end(), emplace_iter, this->find_element, false, pred);
+          return count + before - this->c.size();
+      }
 
-          return results;
+      /**
+       * @brief find in rounds of at most batch_size keys per rank, handing each round's results to sink.  collective.
+       * @details  for keys with many entries, this bounds the result memory by the results of 1 round instead of all.
+       *           sink(::std::vector<::std::pair<Key, T> > & results) is called once per round with the local results.
+       *           keys is not modified.
+       * @return number of results on this rank.
+       */
+      template <bool remove_duplicate = false, class Sink, class Predicate = ::bliss::filter::TruePredicate>
+      size_t find_stream(::std::vector<Key> const & keys, Sink && sink, size_t batch_size,
+                         bool sorted_input = false, Predicate const& pred = Predicate()) const {
+          return this->query_in_rounds(keys, batch_size, [this, sorted_input, &pred](::std::vector<Key> & batch) {
+            return this->template find<remove_duplicate>(batch, sorted_input, pred);
+          }, sink);
       }
 
+      /**
+       * @brief split the entries of heavy keys across all ranks.  collective.
+       * @details with hash distribution, all entries of a key are on its owner rank, so a key with very many entries
+       *          (e.g. from satellite repeats) makes its owner the slowest rank for inserts and for find replies.
+       *          a key is heavy if its owner has at least load_fraction of the mean number of entries per rank for it,
+       *          and at least 2 * comm.size() of them.  entry j of a heavy key goes to rank (owner + j) % comm.size(),
+       *          so the owner keeps a share.
+       *
+       *          the set of heavy keys is replicated.  find, count and erase send queries for heavy keys to all ranks,
+       *          and find replies come from all ranks.  other keys are not affected.  entries inserted after
+       *          this call go to the owner as usual and are still found; call again after large inserts to split them.
+       *          unique_size does not count the shares of a heavy key twice.  keys() and to_vector() are local,
+       *          so a heavy key appears on every rank with a share.  maps with heavy keys cannot be saved for local_load.
+       * @param load_fraction  fraction of the mean entries per rank above which a key is heavy.
+       * @return  number of keys split by this call.
+       */
+      size_t rebalance_heavy_keys(double load_fraction = 0.01) {
+        int p = this->comm.size();
+        if (p == 1) return 0;
+
+        size_t total = this->size();
+        size_t threshold = static_cast<size_t>(::std::ceil(load_fraction * static_cast<double>(total) / static_cast<double>(p)));
+        if (threshold < static_cast<size_t>(2 * p)) threshold = 2 * p;
+
+        // owners pick their heavy keys.  shares already split elsewhere are left in place.
+        int rank = this->comm.rank();
+        ::std::vector<Key> local_keys;
+        this->keys(local_keys);
+
+        ::std::vector<Key> local_heavy;
+        ::std::vector<size_t> send_counts(p, 0);
+        size_t n;
+        for (auto it = local_keys.begin(); it != local_keys.end(); ++it) {
+          if (this->key_to_rank(*it) != rank) continue;
+          n = this->c.count(*it);
+          if (n < threshold) continue;
+
+          local_heavy.push_back(*it);
+          for (int i = 0; i < p; ++i) {
+            send_counts[(rank + i) % p] += n / p + ((static_cast<size_t>(i) < (n % p)) ? 1 : 0);
+          }
+        }
+        ::std::vector<Key>().swap(local_keys);
+
+        // bucket the entries round robin, starting at the owner.
+        ::std::vector<size_t> offsets = ::mxx::impl::get_displacements(send_counts);
+        ::std::vector<::std::pair<Key, T> > buffer(offsets[p - 1] + send_counts[p - 1]);
+        for (auto it = local_heavy.begin(); it != local_heavy.end(); ++it) {
+          auto range = this->c.equal_range(*it);
+          int dest = rank;
+          for (auto eit = range.first; eit != range.second; ++eit) {
+            buffer[offsets[dest]] = *eit;
+            ++offsets[dest];
+            dest = (dest + 1) % p;
+          }
+        }
+        this->c.erase(local_heavy.begin(), local_heavy.end());
 
-      template <class Transform = ::bliss::transform::identity<Key>, class Predicate = ::bliss::filter::TruePredicate>
-      ::std::vector<typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type>
+        ::std::vector<Key> all_heavy = ::mxx::allgatherv(local_heavy, this->comm);
+        heavy_keys.insert(all_heavy.begin(), all_heavy.end());
+
+        buffer = this->all2allv(buffer, send_counts);
+        this->local_reserve(this->c.size() + buffer.size());
+        this->Base::local_insert(buffer);
+        this->local_changed = true;
+
+        return all_heavy.size();
+      }
+
+      /// number of keys whose entries are split across ranks.
+      size_t heavy_key_count() const {
+        return heavy_keys.size();
+      }
+
+      /**
+       * @brief multiplicity spectrum:  bin i is the number of keys with i values, and bin max_bin the number with max_bin or more.
+       * @details one multithreaded pass over the local index, then one reduction of the bins.  heavy keys are counted
+       *          from the sum of their shares, with one more reduction.  collective.
+       * @return  the global histogram on root.  other ranks get their local histogram without the heavy keys.
+       */
+      ::std::vector<size_t> histogram(size_t const max_bin, int const root = 0) const {
+        ::dsc::local_histogram hist(max_bin);
+        bool const skip_heavy = !heavy_keys.empty();
+        this->c.parallel_for_each_key([this, &hist, skip_heavy](Key const & k, size_t const n, int const tid) {
+          if (!skip_heavy || (heavy_keys.count(k) == 0)) hist.add(n, tid);
+        });
+        ::std::vector<size_t> bins = hist.reduce(root, this->comm);
+        if (!skip_heavy) return bins;
+
+        // heavy keys are replicated, so every rank lists them in the same order.
+        ::std::vector<Key> heavy(heavy_keys.begin(), heavy_keys.end());
+        ::std::sort(heavy.begin(), heavy.end(), typename Base::StoreTransformedLess());
+        ::std::vector<size_t> counts(heavy.size());
+        for (size_t i = 0; i < heavy.size(); ++i) {
+          counts[i] = this->c.count(heavy[i]);
+        }
+        counts = ::mxx::reduce(counts, root, ::std::plus<size_t>(), this->comm);
+        if (this->comm.rank() == root) {
+          for (size_t i = 0; i < counts.size(); ++i) {
+            ++(bins[::std::min(counts[i], max_bin)]);
+          }
+        }
+        return bins;
+      }
+
+      /// clears the local container and the heavy keys.
+      virtual void local_reset() noexcept {
+        Base::local_reset();
+        heavy_keys.clear();
+      }
+
+      /// clears the local container and the heavy keys.
+      virtual void local_clear() noexcept {
+        Base::local_clear();
+        heavy_keys.clear();
+      }
+
+
+      template <class Predicate = ::bliss::filter::TruePredicate>
+      ::std::vector<::std::pair<Key, T> > find(Predicate const& pred = Predicate()) const {
+          ::std::vector<::std::pair<Key, T> > results;
+
+          if (this->local_empty()) return results;
+
+          ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, T> > > emplace_iter(results);
+
+          std::vector<Key> keys;
+          this->keys(keys);
+
+          ::std::vector<::std::pair<Key, size_t> > count_results;
+          count_results.reserve(keys.size() / 2);
+          ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, size_t> > > count_emplace_iter(count_results);
+
+          // count now.
+          Base::QueryProcessor::process(this->c, keys.begin(), keys.end(), count_emplace_iter, this->count_element, false, pred);
+          size_t count = ::std::accumulate(count_results.begin(), count_results.end(), static_cast<size_t>(0),
+                                           [](size_t v, ::std::pair<Key, size_t> const & x) {
+            return v + x.second;
+          });
+
+          // then reserve
+          results.reserve(count);                   // TODO:  should estimate coverage.
+
+          Base::QueryProcessor::process(this->c, keys.begin(), keys.end(), emplace_iter, this->find_element, false, pred);
+
+          return results;
+      }
+
+
+      template <class Transform = ::bliss::transform::identity<Key>, class Predicate = ::bliss::filter::TruePredicate>
+      ::std::vector<typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type>
       find_transform(Predicate const& pred = Predicate(), Transform const & trans = Transform()) const {
 
               ::std::vector<typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type> results;
@@ -2234,7 +3099,7 @@ namespace dsc  // distributed std container
       /// access the current the multiplicity.  only multimap needs to override this.
       virtual float get_multiplicity() const {
         // multimaps would add a collective function to change the multiplicity
-        if (this->comm.rank() == 0) printf("rank %d densehash_multimap get_multiplicity called\n", this->comm.rank());
+        if (this->comm.rank() == 0) BL_DEBUGF("rank %d densehash_multimap get_multiplicity called", this->comm.rank());
 
 
         // one approach is to add up the number of repeats for the key of each entry, then divide by total count.
@@ -2248,6 +3113,8 @@ namespace dsc  // distributed std container
         // This is precise, and is faster than the approach above.  (0.0078125 human: 54 sec.  synth: 57sec.)
         // but the n log(n) sort still grows with the duplicate count
 
+        // the local densehash_multimap keeps 1 entry per unique key, so the unique count is O(1) now, apart from
+        // the few heavy keys.  see global_multiplicity for all ranks.
         size_t n_unique = this->local_unique_size();
         float multiplicity = 1.0f;
         if (n_unique > 0) {
@@ -2321,13 +3188,24 @@ namespace dsc  // distributed std container
       }
 
 
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate, typename Observer = ::dsc::no_observer>
+      size_t insert(std::vector<::std::pair<Key, T> >&& input, bool sorted_input = false, Predicate const & pred = Predicate(),
+                    Observer const & observe = Observer()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred, &observe](std::vector<::std::pair<Key, T> > & owned) {
+          return this->insert(owned, sorted_input, pred, observe);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed densehash_multimap.
-       * @param first
-       * @param last
+       * @param observe  called as observe(entries) on every rank with the transformed entries it received, before they are
+       *                 stored and before pred, e.g. to count the keys into a counting map with the same MapParams
+       *                 (see counting_*_map::insert_owned), so that 1 exchange fills both.
        */
-      template <typename Predicate = ::bliss::filter::TruePredicate>
-      size_t insert(std::vector<::std::pair<Key, T> >& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+      template <typename Predicate = ::bliss::filter::TruePredicate, typename Observer = ::dsc::no_observer>
+      size_t insert(std::vector<::std::pair<Key, T> >& input, bool sorted_input = false, Predicate const & pred = Predicate(),
+                    Observer const & observe = Observer()) {
         // even if count is 0, still need to participate in mpi calls.  if (input.size() == 0) return;
         BL_BENCH_INIT(insert);
 
@@ -2351,11 +3229,7 @@ namespace dsc  // distributed std container
           BL_BENCH_START(insert);
           // first remove duplicates.  sort, then get unique, finally remove the rest.  may not be needed
 
-          std::vector<size_t> recv_counts;
-          std::vector<size_t> i2o;
-          std::vector<::std::pair<Key, T> > buffer;
-          ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-          input.swap(buffer);
+          this->distribute_insert(input, this->key_to_rank);
 
           //auto recv_counts = ::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm);
           //BLISS_UNUSED(recv_counts);
@@ -2363,6 +3237,7 @@ namespace dsc  // distributed std container
         }
 
         //        count_unique(input);
+        observe(input);
 		  BL_BENCH_START(insert);
 		  this->local_reserve(this->c.size() + input.size());  // before branching, because reserve calls collective "empty()"
 		  BL_BENCH_END(insert, "reserve", this->c.size() + input.size());
@@ -2384,9 +3259,14 @@ namespace dsc  // distributed std container
       }
 
 
-      /// get the size of unique keys in the current local container.
+      /// get the size of unique keys in the current local container.  a heavy key is counted only by its owner.
       virtual size_t local_unique_size() const {
-        return this->c.unique_size();
+        size_t n = this->c.unique_size();
+        int rank = this->comm.rank();
+        for (auto it = heavy_keys.begin(); it != heavy_keys.end(); ++it) {
+          if ((this->key_to_rank(*it) != rank) && (this->c.count(*it) > 0)) --n;
+        }
+        return n;
       }
   };
 
@@ -2424,14 +3304,16 @@ namespace dsc  // distributed std container
   template <typename> class MapParams,
     typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
   typename Reduc = ::std::plus<T>,
-  class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  class Alloc = ::std::allocator< ::std::pair<const Key, T> >,
+    template <typename, typename, typename, template <typename> class,
+      typename, typename, typename, bool> class Container = ::fsc::densehash_map
   >
   class reduction_densehash_map : 
-    public densehash_map<Key, T, MapParams, SpecialKeys, Alloc> {
+    public densehash_map<Key, T, MapParams, SpecialKeys, Alloc, Container> {
       //static_assert(::std::is_arithmetic<T>::value, "mapped type has to be arithmetic");
 
     protected:
-      using Base = densehash_map<Key, T, MapParams, SpecialKeys, Alloc>;
+      using Base = densehash_map<Key, T, MapParams, SpecialKeys, Alloc, Container>;
 
     public:
       using local_container_type = typename Base::local_container_type;
@@ -2455,30 +3337,66 @@ namespace dsc  // distributed std container
     protected:
       Reduc r;
 
-      /**
-       * @brief insert new elements in the distributed densehash_multimap.
-       * @param first
-       * @param last
-       */
-      template <class InputIterator>
-      size_t local_insert(InputIterator first, InputIterator last) {
-          size_t before = this->c.size();
+      /// bytes of the per thread combiner that pre-aggregates tuples before distribution.  0 disables it.
+      size_t combiner_bytes;
+
+      /// file prefix of the spilled runs.  empty disables spilling.
+      ::std::string spill_prefix;
+      /// spill the local table when it reaches this many entries.  0 spills when the memory budget is exhausted.
+      size_t spill_entries;
+      /// local spilled runs, each sorted by key, in the map file format (see distributed_map_io.hpp).
+      ::std::vector<::std::string> spill_runs;
+
+      /// spill the local table if it is over its limit.  local.  called at the end of each insert.
+      void maybe_spill() {
+        if (spill_prefix.empty() || this->c.empty()) return;
+        bool over = (spill_entries > 0) ? (this->c.size() >= spill_entries) :
+            (this->get_memory_budget().limited() && (this->get_memory_budget().available() == 0));
+        if (over) this->spill();
+      }
+
+      /// delete the spilled run files.
+      void remove_spill_runs() noexcept {
+        for (auto const & name : spill_runs) ::remove(name.c_str());
+        spill_runs.clear();
+      }
+
+      /// local containers that insert and reduce a whole range, e.g. ::fsc::thread_partitioned, do so in bulk.
+      template <class C, class InputIterator>
+      auto local_reduce_insert(C & cont, InputIterator first, InputIterator last, int)
+        -> decltype(cont.insert(first, last, r), size_t()) {
+          size_t count = cont.insert(first, last, r);
+
+          if (count > 0) this->local_changed = true;
+
+          return count;
+      }
+
+      /// element by element insertion and reduction.
+      template <class C, class InputIterator>
+      size_t local_reduce_insert(C & cont, InputIterator first, InputIterator last, long) {
+          size_t before = cont.size();
 
           //this->local_reserve(before + ::std::distance(first, last));
 
           for (auto it = first; it != last; ++it) {
-            auto v = *it;
-
-            auto result = this->c.insert(v);
-            if (!(result.second)) {
-              // failed insertion - means an entry is already there, so reduce
-              result.first->second = r(result.first->second, v.second);
-            }
+            ::fsc::upsert(cont, (*it).first, (*it).second, r);
           }
 
-          if (this->c.size() != before) this->local_changed = true;
+          if (cont.size() != before) this->local_changed = true;
 
-          return this->c.size() - before;
+          return cont.size() - before;
+      }
+
+      /**
+       * @brief insert new elements in the distributed densehash_multimap.
+       * @param first
+       * @param last
+       */
+      template <class InputIterator>
+      size_t local_insert(InputIterator first, InputIterator last) {
+          typename Base::tracked_insert tracked(*this);
+          return local_reduce_insert(this->c, first, last, 0);
       }
 
       /**
@@ -2488,19 +3406,13 @@ namespace dsc  // distributed std container
        */
       template <class InputIterator, class Predicate>
       size_t local_insert(InputIterator first, InputIterator last, Predicate const & pred) {
+          typename Base::tracked_insert tracked(*this);
           size_t before = this->c.size();
 
           //this->local_reserve(before + ::std::distance(first, last));
 
           for (auto it = first; it != last; ++it) {
-            auto v = *it;
-            if (pred(v)) {
-              auto result = this->c.insert(v);
-              if (!(result.second)) {
-                // failed insertion - means an entry is already there, so reduce
-                result.first->second = r(result.first->second, v.second);
-              }
-            }
+            if (pred(*it)) ::fsc::upsert(this->c, (*it).first, (*it).second, r);
           }
 
           if (this->c.size() != before) this->local_changed = true;
@@ -2509,6 +3421,11 @@ namespace dsc  // distributed std container
 
       }
 
+      /// merge combines the values of equal keys, as insert does.
+      virtual size_t local_merge(::std::vector<::std::pair<Key, T> > & entries) {
+        return this->local_insert(entries.begin(), entries.end());
+      }
+
       /// local reduction via a copy of local container type (i.e. densehash_map).
       /// this takes quite a bit of memory due to use of densehash_map, but is significantly faster than sorting.
       virtual void local_reduction(::std::vector<::std::pair<Key, T> >& input, bool & sorted_input) {
@@ -2525,11 +3442,7 @@ namespace dsc  // distributed std container
         BL_BENCH_START(reduce_tuple);
         auto max = input.end();
         for (auto it = input.begin(); it != max; ++it) {
-          auto result = temp.insert(*it);
-          if (!(result.second)) {
-            // failed insertion - means an entry is already there, so reduce
-            result.first->second = r(result.first->second, (*it).second);
-          }
+          ::fsc::upsert(temp, (*it).first, (*it).second, r);
         }
         BL_BENCH_END(reduce_tuple, "reduce", temp.size());
 
@@ -2546,10 +3459,28 @@ namespace dsc  // distributed std container
 
     public:
       reduction_densehash_map(const mxx::comm& _comm) :
-	  	  Base(_comm) {}
+	  	  Base(_comm), combiner_bytes(0), spill_entries(0) {}
+
+      /**
+       * @brief combine duplicate keys locally in a cache sized table per thread (::fsc::local_combiner) before
+       *        distributing, so fewer tuples are sent and inserted.   worthwhile with high coverage input.
+       * @details  the reduction has to be associative and commutative.  applies to subsequent inserts.
+       * @param _bytes  combiner size per thread, ~L2.  0 disables combining.
+       */
+      void set_local_combiner(size_t _bytes = (1UL << 18)) {
+        combiner_bytes = _bytes;
+      }
+
+      /// combine the transformed input in place, if the combiner is enabled.
+      template <typename V>
+      void local_combine(::std::vector<V> const & input, ::std::vector<::std::pair<Key, T> > & output) {
+        ::fsc::combine(input, output, combiner_bytes, typename Base::StoreTransformedFunc(), r);
+      }
 
 
-      virtual ~reduction_densehash_map() {};
+      virtual ~reduction_densehash_map() {
+        remove_spill_runs();
+      };
 
       using Base::count;
       using Base::find;
@@ -2557,6 +3488,130 @@ namespace dsc  // distributed std container
       using Base::unique_size;
       using Base::update;
 
+      /**
+       * @brief out of core mode.  when the local table reaches max_local_entries, it is sorted, written as a run to
+       *        "<prefix>.<rank>.run<i>", and cleared.  set on all ranks.
+       * @details  for key sets larger than memory.  the run files go to node local storage, e.g. NVMe.
+       *           spilling is local, at the end of an insert, so ranks spill independently.
+       *           find, count, size and to_vector only see the resident table until unspill.  merge_spilled streams the
+       *           reduced entries of the runs and the table instead, without holding them in memory.
+       *           the runs are deleted by unspill, by another set_spill, and by the destructor.
+       * @param prefix  run file prefix.  empty disables spilling.
+       * @param max_local_entries  table entries that trigger a spill.  0 spills when the memory budget
+       *           (see set_memory_budget) is exhausted.
+       */
+      void set_spill(::std::string const & prefix, size_t const max_local_entries = 0) {
+        remove_spill_runs();
+        spill_prefix = prefix;
+        spill_entries = max_local_entries;
+      }
+
+      /// number of local spilled runs.
+      size_t spilled_runs() const {
+        return spill_runs.size();
+      }
+
+      /// sort the local table, write it as a run, and clear it.  local.  no effect if spilling is disabled or the table is empty.
+      void spill() {
+        if (spill_prefix.empty() || this->c.empty()) return;
+
+        BL_BENCH_INIT(spill);
+
+        BL_BENCH_START(spill);
+        ::std::vector<::std::pair<Key, T> > entries;
+        this->to_vector(entries);
+        this->local_clear();
+        ::std::sort(entries.begin(), entries.end(),
+                    [](::std::pair<Key, T> const & x, ::std::pair<Key, T> const & y) { return x.first < y.first; });
+        BL_BENCH_END(spill, "sort", entries.size());
+
+        BL_BENCH_START(spill);
+        ::std::stringstream ss;
+        ss << ::dsc::map_file_name(spill_prefix, this->comm.rank()) << ".run" << spill_runs.size();
+        ::dsc::write_map_file(ss.str(), this->comm.size(), this->comm.rank(), entries.data(), entries.size());
+        spill_runs.push_back(ss.str());
+        BL_BENCH_END(spill, "write", entries.size());
+
+        BL_BENCH_REPORT_NAMED(spill, "reduction_densehash:spill");
+      }
+
+      /**
+       * @brief k-way merge of the spilled runs and the resident table, reducing equal keys.  local.
+       * @details  sink(::std::pair<Key, T> const &) is called once per distinct local key, in increasing key order.
+       *           the runs are memory mapped, so only the sorted copy of the resident table is held in memory.
+       * @return  number of distinct local keys.
+       */
+      template <typename Sink>
+      size_t merge_spilled(Sink && sink) const {
+        using entry_type = ::std::pair<Key, T>;
+
+        ::std::vector<entry_type> resident;
+        this->to_vector(resident);
+        ::std::sort(resident.begin(), resident.end(),
+                    [](entry_type const & x, entry_type const & y) { return x.first < y.first; });
+
+        ::std::vector<::std::unique_ptr<::dsc::mapped_map_file> > files;
+        ::std::vector<::std::pair<entry_type const *, entry_type const *> > runs;
+        for (auto const & name : spill_runs) {
+          files.emplace_back(new ::dsc::mapped_map_file(name));
+          files.back()->template validate<Key, T>(this->comm.size(), this->comm.rank());
+          entry_type const * first = files.back()->template entries<Key, T>();
+          runs.emplace_back(first, first + files.back()->size());
+        }
+        runs.emplace_back(resident.data(), resident.data() + resident.size());
+
+        // min heap of run indices, by the run's current key.
+        auto later = [&runs](size_t x, size_t y) { return runs[y].first->first < runs[x].first->first; };
+        ::std::vector<size_t> heap;
+        for (size_t i = 0; i < runs.size(); ++i)
+          if (runs[i].first != runs[i].second) heap.push_back(i);
+        ::std::make_heap(heap.begin(), heap.end(), later);
+
+        Reduc reduc = r;
+        size_t count = 0;
+        while (!heap.empty()) {
+          ::std::pop_heap(heap.begin(), heap.end(), later);
+          size_t i = heap.back();
+          entry_type current = *(runs[i].first);
+          if (++runs[i].first == runs[i].second) heap.pop_back();
+          else ::std::push_heap(heap.begin(), heap.end(), later);
+
+          // keys are unique within a run, so each further equal key comes from another run.
+          while (!heap.empty() && (runs[heap.front()].first->first == current.first)) {
+            ::std::pop_heap(heap.begin(), heap.end(), later);
+            size_t j = heap.back();
+            current.second = reduc(current.second, runs[j].first->second);
+            if (++runs[j].first == runs[j].second) heap.pop_back();
+            else ::std::push_heap(heap.begin(), heap.end(), later);
+          }
+
+          sink(static_cast<entry_type const &>(current));
+          ++count;
+        }
+        return count;
+      }
+
+      /// merge the spilled runs back into the resident table, e.g. once the key set has shrunk, and delete them.  local.
+      void unspill() {
+        if (spill_runs.empty()) return;
+
+        for (auto const & name : spill_runs) {
+          ::dsc::mapped_map_file run(name);
+          run.template validate<Key, T>(this->comm.size(), this->comm.rank());
+          ::std::pair<Key, T> const * first = run.template entries<Key, T>();
+          this->local_insert(first, first + run.size());
+        }
+        remove_spill_runs();
+      }
+
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert(std::vector<::std::pair<Key, T> >&& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred](std::vector<::std::pair<Key, T> > & owned) {
+          return this->insert(owned, sorted_input, pred);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed densehash_multimap.
        * @param first
@@ -2577,16 +3632,20 @@ namespace dsc  // distributed std container
         this->transform_input(input);
         BL_BENCH_END(insert, "transform_input", input.size());
 
+        if (combiner_bytes > 0) {
+          BL_BENCH_START(insert);
+          ::std::vector<::std::pair<Key, T> > combined;
+          this->local_combine(input, combined);
+          input.swap(combined);
+          BL_BENCH_END(insert, "combine", input.size());
+        }
+
 
         // communication part
         if (this->comm.size() > 1) {
           BL_BENCH_START(insert);
           // first remove duplicates.  sort, then get unique, finally remove the rest.  may not be needed
-          std::vector<size_t> recv_counts;
-          std::vector<size_t> i2o;
-          std::vector<::std::pair<Key, T> > buffer;
-          ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-          input.swap(buffer);
+          this->distribute_insert(input, this->key_to_rank);
 
 //          auto recv_counts = ::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm);
 //          BLISS_UNUSED(recv_counts);
@@ -2599,21 +3658,13 @@ namespace dsc  // distributed std container
 
         // local compute part.  called by the communicator.
         BL_BENCH_START(insert);
-//        this->c.resize(input.size() / 2);
-        if (this->comm.rank() == 0)
-        std::cout << "rank " << this->comm.rank() <<
-          " BEFORE input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
-
+        this->reserve_from_sketch(input);
         size_t count = 0;
         if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
           count = this->local_insert(input.begin(), input.end(), pred);
         else
           count = this->local_insert(input.begin(), input.end());
 
-        if (this->comm.rank() == 0)
-        std::cout << "rank " << this->comm.rank() <<
-          " AFTER input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
-
 //        this->c.resize(0);
 
 //        std::cout << "rank " << this->comm.rank() <<
@@ -2621,6 +3672,7 @@ namespace dsc  // distributed std container
 
         BL_BENCH_END(insert, "local_insert", this->local_size());
 
+        this->maybe_spill();
 
         BL_BENCH_REPORT_MPI_NAMED(insert, "reduction_densehash:insert", this->comm);
 
@@ -2664,14 +3716,54 @@ namespace dsc  // distributed std container
     typename Key, typename T,
     template <typename> class MapParams,
     typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
-    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >,
+    template <typename, typename, typename, template <typename> class,
+      typename, typename, typename, bool> class Container = ::fsc::densehash_map
   >
   class counting_densehash_map : 
-    public reduction_densehash_map<Key, T, MapParams, SpecialKeys, ::std::plus<T>, Alloc> {
+    public reduction_densehash_map<Key, T, MapParams, SpecialKeys, ::std::plus<T>, Alloc, Container> {
       static_assert(::std::is_integral<T>::value, "count type has to be integral");
 
     protected:
-      using Base = reduction_densehash_map<Key, T, MapParams, SpecialKeys, ::std::plus<T>, Alloc>;
+      using Base = reduction_densehash_map<Key, T, MapParams, SpecialKeys, ::std::plus<T>, Alloc, Container>;
+
+      /// occurrence counts of the keys not yet in the local table.  used only when min_count > 1.
+      ::bliss::utils::count_min_sketch<4> pending;
+
+      /// keys enter the local table when they are seen this many times.  1 inserts every key.
+      T min_count;
+
+      /// if true, received keys are counted by sorting and reducing runs, then inserted once per distinct key.
+      bool sort_reduce;
+
+      /**
+       * @brief insert keys that are in the local table, or that reach min_count occurrences according to the sketch.
+       * @details  a key not yet in the table is only counted in the sketch.  when its estimate reaches min_count it is
+       *           inserted with count min_count, its occurrences so far;  after that it is counted exactly.
+       *           the sketch does not undercount, so no key with min_count occurrences is missed.  an overestimate
+       *           admits a key early, with a count higher than its true count at that point.
+       */
+      template <class Predicate>
+      size_t local_insert_min_count(::std::vector<Key> const & input, Predicate const & pred) {
+          typename Base::tracked_insert tracked(*this);
+          size_t before = this->c.size();
+
+          typename Base::StoreTransformedFunc store_hash;
+          for (auto it = input.begin(); it != input.end(); ++it) {
+            ::std::pair<Key, T> v(*it, T(1));
+            if (!pred(v)) continue;
+
+            if (this->c.count(*it) == 0) {
+              if (pending.update(::bliss::utils::mix64(static_cast<uint64_t>(store_hash(*it)))) < min_count) continue;
+              v.second = min_count;
+            }
+            ::fsc::upsert(this->c, v.first, v.second, this->r);
+          }
+
+          if (this->c.size() != before) this->local_changed = true;
+
+          return this->c.size() - before;
+      }
 
     public:
       using local_container_type = typename Base::local_container_type;
@@ -2694,7 +3786,34 @@ namespace dsc  // distributed std container
 
 
       counting_densehash_map(const mxx::comm& _comm) :
-	  	  Base(_comm) {}
+	  	  Base(_comm), pending(1), min_count(1), sort_reduce(false) {}
+
+      /**
+       * @brief only keep keys that occur at least _min_count times.  set the same on all ranks.
+       * @details  keys are held in a count-min sketch until they are seen _min_count times, so the keys that would be
+       *           removed afterwards (e.g. singletons from sequencing errors, with _min_count = 2) never take table space.
+       *           counts of the kept keys are exact unless the sketch overestimates (see local_insert_min_count).
+       *           applies to subsequent inserts.  the table is not pre-reserved from the distinct key estimate in this mode,
+       *           since most distinct keys are not inserted.   _min_count <= 1 disables filtering and frees the sketch.
+       * @param sketch_width  counters per sketch row, per process.  4 rows of 1 byte counters.  a width near the number of
+       *           distinct local keys keeps the overestimates rare.  _min_count needs to be less than 256.
+       */
+      void set_min_count(T _min_count, size_t sketch_width = (1UL << 24)) {
+        if (static_cast<uint64_t>(_min_count) > 255) throw ::std::invalid_argument("ERROR: counting_densehash_map min_count has to be less than 256.");
+        min_count = (_min_count < 1) ? T(1) : _min_count;
+        pending.resize((min_count > 1) ? sketch_width : 1);
+      }
+
+      /**
+       * @brief count the received keys by a radix sort and a reduction of equal runs, then insert 1 (key, count) per run.
+       * @details  the table sees distinct keys only, so with high coverage most of the random table accesses of the insert
+       *           become a sequential pass over the sorted keys, and the sort runs multithreaded (see radix_sort.hpp).
+       *           k-mer and unsigned integer keys are radix sorted, others are compared.  not used with min_count > 1,
+       *           which needs the individual occurrences.  applies to subsequent inserts.  set the same on all ranks.
+       */
+      void set_sort_reduce(bool enable) {
+        sort_reduce = enable;
+      }
 
 
       virtual ~counting_densehash_map() {};
@@ -2706,6 +3825,36 @@ namespace dsc  // distributed std container
       using Base::unique_size;
       using Base::update;
 
+      /**
+       * @brief k-mer abundance spectrum:  bin i is the number of keys with count i, and bin max_bin the number with count >= max_bin.
+       * @details one multithreaded pass over the local table, then one reduction of the bins.  no keys are communicated.  collective.
+       * @return  the global histogram on root.  other ranks get their local histogram.
+       */
+      ::std::vector<size_t> histogram(size_t const max_bin, int const root = 0) const {
+        ::dsc::local_histogram hist(max_bin);
+        this->parallel_for_each_local(::dsc::local_histogram::by_value{hist});
+        return hist.reduce(root, this->comm);
+      }
+
+      /**
+       * @brief the n keys with the largest counts, in decreasing count order, on all ranks.  ties at the n-th count are broken arbitrarily.
+       * @details per-thread heaps in one pass over the local table, then a bisection on the n-th count with scalar allreduces,
+       *          so that at most n entries in total are gathered.  see ::dsc::local_top_n.  collective.
+       */
+      ::std::vector<::std::pair<Key, T> > top_n(size_t const n) const {
+        ::dsc::local_top_n<::std::pair<Key, T> > top(n);
+        this->parallel_for_each_local(typename ::dsc::local_top_n<::std::pair<Key, T> >::by_value{top});
+        return top.reduce(this->comm);
+      }
+
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert(std::vector< Key >&& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred](std::vector< Key > & owned) {
+          return this->insert(owned, sorted_input, pred);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed densehash_multimap.
        * @param first
@@ -2768,16 +3917,46 @@ namespace dsc  // distributed std container
         this->transform_input(input);
         BL_BENCH_END(insert, "transform_input", input.size());
 
+        // pre-aggregate, then send and insert (key, count) tuples instead of the raw k-mers.
+        // the min_count filter needs the individual occurrences, so it does not combine.
+        if ((this->combiner_bytes > 0) && (min_count <= 1)) {
+          BL_BENCH_START(insert);
+          ::std::vector<::std::pair<Key, T> > combined;
+          this->local_combine(input, combined);
+          ::std::vector<Key>().swap(input);
+          BL_BENCH_END(insert, "combine", combined.size());
+
+          if (this->comm.size() > 1) {
+            BL_BENCH_START(insert);
+            std::vector<size_t> recv_counts;
+            std::vector<size_t> i2o;
+            std::vector<::std::pair<Key, T> > buffer;
+            this->distribute(combined, this->key_to_rank, recv_counts, i2o, buffer);
+            combined.swap(buffer);
+            BL_BENCH_END(insert, "dist_data", combined.size());
+          }
+
+          BL_BENCH_START(insert);
+          this->reserve_from_sketch(combined);
+          size_t count = 0;
+          if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
+            count = this->Base::local_insert(combined.begin(), combined.end(), pred);
+          else
+            count = this->Base::local_insert(combined.begin(), combined.end());
+          BL_BENCH_END(insert, "local_insert", this->local_size());
+
+          this->maybe_spill();
+
+          BL_BENCH_REPORT_MPI_NAMED(insert, "count_densehash_map:insert_key", this->comm);
+          return count;
+        }
+
         // then send the raw k-mers.
         // communication part
         if (this->comm.size() > 1) {
           BL_BENCH_START(insert);
           // first remove duplicates.  sort, then get unique, finally remove the rest.  may not be needed
-          std::vector<size_t> recv_counts;
-          std::vector<size_t> i2o;
-          std::vector< Key > buffer;
-          ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-          input.swap(buffer);
+          this->distribute_insert_keys(input, this->key_to_rank);
 
 //          auto recv_counts = ::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm);
 //          BLISS_UNUSED(recv_counts);
@@ -2817,10 +3996,9 @@ namespace dsc  // distributed std container
 //        BL_BENCH_END(insert, "local_insert", this->local_size());
 
 
-          size_t count = 0;
-          auto trans = [](Key const & x) {
-            return ::std::make_pair(x, T(1));
-          };
+        BL_BENCH_START(insert);
+        size_t count = local_insert_keys(input, pred);
+        BL_BENCH_END(insert, "local_insert", this->local_size());
         // ====== estimate is not great.
 //        // once received, transform and locally insert, in 2 parts.  first part takes 1M entry and insert to estimate
 //        // total size.
@@ -2862,40 +4040,118 @@ namespace dsc  // distributed std container
 //        std::cout << "rank " << this->comm.rank() << " step_size=" << step_size << " init count=" << init_count <<
 //            " input=" << input.size() << " estimate=" << estimate << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
 
-          BL_BENCH_START(insert);
-          // preallocate.  easy way out - estimate to be 1/2 of input.  then at the end, resize if significantly less.
-          //this->c.resize(input.size() / 2);
-          if (this->comm.rank() == 0)
-          std::cout << "rank " << this->comm.rank() <<
-            " BEFORE input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
+        this->maybe_spill();
 
-          // then insert all the rest,
-          auto local_start = ::bliss::iterator::make_transform_iterator(input.begin(), trans);
-          auto local_end = ::bliss::iterator::make_transform_iterator(input.end(), trans);
-          // insert
-          if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
-            count += this->Base::local_insert(local_start, local_end, pred);
-          else
-            count += this->Base::local_insert(local_start, local_end);
+        BL_BENCH_REPORT_MPI_NAMED(insert, "count_densehash_map:insert_key", this->comm);
 
-          if (this->comm.rank() == 0)
-          std::cout << "rank " << this->comm.rank() <<
-            " AFTER input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
+        return count;
 
-          // resize further.
-          //this->c.resize(0);
+      }
 
-//          std::cout << "rank " << this->comm.rank() <<
-//            " input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
+      /**
+       * @brief insert keys that are already transformed and grouped by destination rank, e.g. by KmerFileHelper::read_file_bucketed.
+       * @details  skips the transform and the bucketing permutation of insert.  the keys are exchanged as they are.
+       * @param input        keys, transformed by input_transform_type, in rank order of get_key_to_rank().  replaced by the received keys.
+       * @param send_counts  number of keys for each rank.
+       */
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert_bucketed(std::vector< Key >& input, std::vector<size_t> const & send_counts, Predicate const &pred = Predicate()) {
+        BL_BENCH_INIT(insert);
 
-          BL_BENCH_END(insert, "local_insert", this->local_size());
+        if (::dsc::empty(input, this->comm)) {
+          BL_BENCH_REPORT_MPI_NAMED(insert, "count_densehash_map:insert_bucketed", this->comm);
+          return 0;
+        }
 
+        if (this->comm.size() > 1) {
+          BL_BENCH_START(insert);
+          this->all2allv(input, send_counts).swap(input);
+          BL_BENCH_END(insert, "a2a", input.size());
+        }
 
+        BL_BENCH_START(insert);
+        size_t count = local_insert_keys(input, pred);
+        BL_BENCH_END(insert, "local_insert", this->local_size());
 
-        BL_BENCH_REPORT_MPI_NAMED(insert, "count_densehash_map:insert_key", this->comm);
+        this->maybe_spill();
+
+        BL_BENCH_REPORT_MPI_NAMED(insert, "count_densehash_map:insert_bucketed", this->comm);
+
+        return count;
+      }
 
+      /**
+       * @brief count the keys of entries that are already transformed and on this rank, e.g. the entries a multimap with the
+       *        same MapParams received in insert (see densehash_multimap::insert's observe).  no communication.
+       * @return number of new keys.
+       */
+      template <typename V>
+      size_t insert_owned(std::vector<::std::pair<Key, V> > const & entries) {
+        ::std::vector<Key> keys;
+        keys.reserve(entries.size());
+        for (auto it = entries.begin(); it != entries.end(); ++it) keys.emplace_back(it->first);
+
+        size_t count = local_insert_keys(keys, ::bliss::filter::TruePredicate());
+        this->maybe_spill();
         return count;
+      }
+
+    protected:
+      /// sort the keys, and replace equal runs by (key, run length).  input is sorted in place.
+      static void sort_reduce_keys(std::vector< Key > & input, std::vector<::std::pair<Key, T> > & runs) {
+        bool sorted = false;
+        ::fsc::sort(input, sorted, ::std::less<Key>());
+
+        runs.clear();
+        auto it = input.begin();
+        while (it != input.end()) {
+          auto run_end = it + 1;
+          while ((run_end != input.end()) && (*run_end == *it)) ++run_end;
+          runs.emplace_back(*it, static_cast<T>(::std::distance(it, run_end)));
+          it = run_end;
+        }
+      }
+
+      /// insert received keys, counted as 1 each.  with sort_reduce, input is sorted.
+      template <typename Predicate>
+      size_t local_insert_keys(std::vector< Key > & input, Predicate const &pred) {
+          typename Base::tracked_insert tracked(*this);
+          size_t count = 0;
+          auto trans = [](Key const & x) {
+            return ::std::make_pair(x, T(1));
+          };
+
+          if (min_count > 1) {
+            count += this->local_insert_min_count(input, pred);
+          } else if (sort_reduce) {
+            ::std::vector<::std::pair<Key, T> > runs;
+            sort_reduce_keys(input, runs);
+
+            this->reserve_from_sketch(runs);
+            if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
+              count += this->Base::local_insert(runs.begin(), runs.end(), pred);
+            else
+              count += this->Base::local_insert(runs.begin(), runs.end());
+          } else {
+            // preallocate from the distinct key estimate.
+            this->reserve_from_sketch(input);
+            // then insert all the rest,
+            auto local_start = ::bliss::iterator::make_transform_iterator(input.begin(), trans);
+            auto local_end = ::bliss::iterator::make_transform_iterator(input.end(), trans);
+            // insert
+            if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
+              count += this->Base::local_insert(local_start, local_end, pred);
+            else
+              count += this->Base::local_insert(local_start, local_end);
+          }
+
+          // resize further.
+          //this->c.resize(0);
+
+//          std::cout << "rank " << this->comm.rank() <<
+//            " input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
 
+          return count;
       }
   };
 
@@ -2942,15 +4198,17 @@ namespace dsc  // distributed std container
     typename Key, typename T,
     template <typename> class MapParams,
     typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
-    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >,
+    template <typename, typename, typename, template <typename> class,
+      typename, typename, typename, bool> class Container = ::fsc::densehash_map
   >
   class saturating_counting_densehash_map :
-    public reduction_densehash_map<Key, T, MapParams, SpecialKeys, sat_plus<T>, Alloc> {
+    public reduction_densehash_map<Key, T, MapParams, SpecialKeys, sat_plus<T>, Alloc, Container> {
       static_assert(!::std::is_signed<T>::value &&
                     ::std::is_integral<T>::value, "only supports unsigned integer types for count");
 
     protected:
-      using Base = reduction_densehash_map<Key, T, MapParams, SpecialKeys, sat_plus<T>, Alloc>;
+      using Base = reduction_densehash_map<Key, T, MapParams, SpecialKeys, sat_plus<T>, Alloc, Container>;
 
     public:
       using local_container_type = typename Base::local_container_type;
@@ -2985,6 +4243,14 @@ namespace dsc  // distributed std container
       using Base::unique_size;
       using Base::update;
 
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert(std::vector< Key >&& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred](std::vector< Key > & owned) {
+          return this->insert(owned, sorted_input, pred);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed densehash_multimap.
        * @param first
@@ -3015,13 +4281,7 @@ namespace dsc  // distributed std container
         if (this->comm.size() > 1) {
           BL_BENCH_START(insert);
           // first remove duplicates.  sort, then get unique, finally remove the rest.  may not be needed
-          std::vector<size_t> recv_counts;
-          std::vector<size_t> i2o;
-
-          std::vector<Key > buffer;
-          //::imxx::destructive_distribute(input, this->key_to_rank, recv_counts, buffer, this->comm);
-          ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-          input.swap(buffer);
+          this->distribute_insert(input, this->key_to_rank);
 
 //          auto recv_counts = ::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm);
 //          BLISS_UNUSED(recv_counts);
@@ -3034,12 +4294,8 @@ namespace dsc  // distributed std container
           };
 
           BL_BENCH_START(insert);
-          // preallocate.  easy way out - estimate to be 1/2 of input.  then at the end, resize if significantly less.
-          // this->c.resize(input.size() / 2);
-
-          if (this->comm.rank() == 0)
-          std::cout << "rank " << this->comm.rank() <<
-            " BEFORE input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
+          // preallocate from the distinct key estimate.
+          this->reserve_from_sketch(input);
 
 
           // then insert all the rest,
@@ -3051,10 +4307,6 @@ namespace dsc  // distributed std container
           else
             count += this->Base::local_insert(local_start, local_end);
 
-          if (this->comm.rank() == 0)
-          std::cout << "rank " << this->comm.rank() <<
-            " AFTER input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
-
 
           // resize further.
           // this->c.resize(0);
@@ -3069,6 +4321,140 @@ namespace dsc  // distributed std container
   };
 
 
+
+  /// distributed map with keys and values in separate arrays locally.  see ::fsc::soa_hash_map.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using soa_hash_map = densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::soa_hash_map>;
+
+  /// distributed reduction map with keys and values in separate arrays locally.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    typename Reduc = ::std::plus<T>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using reduction_soa_hash_map = reduction_densehash_map<Key, T, MapParams, SpecialKeys, Reduc, Alloc, ::fsc::soa_hash_map>;
+
+  /// distributed counting map with keys and values in separate arrays locally.  for k=31 and 32 bit counts, 13 bytes per slot instead of 16.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using counting_soa_hash_map = counting_densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::soa_hash_map>;
+
+  /// distributed saturating counting map with keys and values in separate arrays locally.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using saturating_counting_soa_hash_map = saturating_counting_densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::soa_hash_map>;
+
+  /// distributed counting map with 8 bit counters in the local table, and a local overflow table for counts >= 255.
+  /// see ::fsc::compact_counting_map.  T is the full count type.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using compact_counting_map = counting_densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::compact_counting_map>;
+
+  /// distributed static map, built once per rank after insert.  the local entries are in dense arrays indexed by a
+  /// minimal perfect hash function, about 4 bits per key over the keys and values.  see ::fsc::mphf_map.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using mphf_map = densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::mphf_map>;
+
+  /// distributed static counting map over a minimal perfect hash function.  counts are reduced, then the function is
+  /// rebuilt once per insert.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using counting_mphf_map = counting_densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::mphf_map>;
+
+  /// same as counting_mphf_map, with an 8 bit fingerprint per key so most absent queries do not read the key array.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using fingerprinted_counting_mphf_map = counting_densehash_map<Key, T, MapParams, SpecialKeys, Alloc,
+      ::fsc::fingerprinted_mphf<8>::map>;
+
+  /// distributed map whose local table is split into per-thread sub-tables, so received entries are inserted by all OpenMP threads.
+  /// see ::fsc::thread_partitioned.  for running 1 process per node or socket instead of 1 per core.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using thread_partitioned_densehash_map = densehash_map<Key, T, MapParams, SpecialKeys, Alloc,
+		  ::fsc::thread_partitioned<::fsc::densehash_map>::map>;
+
+  /// distributed multimap whose local values are in 1 array with per key offsets, for indices built once.
+  /// see ::fsc::csr_multimap.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using csr_multimap = densehash_multimap<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::csr_multimap>;
+
+  /// distributed reduction map with per-thread local sub-tables.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    typename Reduc = ::std::plus<T>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using thread_partitioned_reduction_densehash_map = reduction_densehash_map<Key, T, MapParams, SpecialKeys, Reduc, Alloc,
+		  ::fsc::thread_partitioned<::fsc::densehash_map>::map>;
+
+  /// distributed counting map with per-thread local sub-tables.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using thread_partitioned_counting_densehash_map = counting_densehash_map<Key, T, MapParams, SpecialKeys, Alloc,
+		  ::fsc::thread_partitioned<::fsc::densehash_map>::map>;
+
+  /// distributed map with a single local table that all OpenMP threads insert into, without locks.
+  /// see ::fsc::concurrent_densehash_map.  unlike the thread partitioned maps, keys are not duplicated per thread.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using concurrent_densehash_map = densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::concurrent_densehash_map>;
+
+  /// distributed reduction map with a single concurrently updated local table.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    typename Reduc = ::std::plus<T>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using concurrent_reduction_densehash_map = reduction_densehash_map<Key, T, MapParams, SpecialKeys, Reduc, Alloc, ::fsc::concurrent_densehash_map>;
+
+  /// distributed counting map with a single local table, counts are incremented with atomic adds.
+  template<typename Key, typename T,
+    template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+  >
+  using concurrent_counting_densehash_map = counting_densehash_map<Key, T, MapParams, SpecialKeys, Alloc, ::fsc::concurrent_densehash_map>;
+
 } /* namespace dsc */
 
 
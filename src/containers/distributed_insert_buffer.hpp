@@ -0,0 +1,144 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    distributed_insert_buffer.hpp
+ * @ingroup dsc::containers
+ * @brief   write combining front end for the inserts of a distributed map.
+ * @details a distributed insert costs several collectives (the empty check, the count exchange, the all2allv) whatever its
+ *          size.  with a stream of small batches these dominate.  insert_buffer appends each batch locally, and inserts
+ *          into the map once the buffer reaches a size or an age on some rank, or on flush().
+ *
+ *          ranks decide together whether to flush, with 1 allreduce of a bool per insert() call.  insert() and flush()
+ *          are therefore collective, called the same number of times on all ranks, as the map's insert.
+ *          the tuples are not bucketed while buffered:  the map buckets them in the 1 exchange of the flush.
+ *
+ *          entries are visible to queries only after a flush.  the destructor does not flush, since flush is collective.
+ */
+#ifndef SRC_CONTAINERS_DISTRIBUTED_INSERT_BUFFER_HPP_
+#define SRC_CONTAINERS_DISTRIBUTED_INSERT_BUFFER_HPP_
+
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+#include <mxx/comm.hpp>
+#include <mxx/reduction.hpp>
+
+namespace dsc  // distributed std container
+{
+
+  /**
+   * @brief  buffers the inserts into a distributed map.  see file description.
+   * @tparam Map  distributed map, e.g. counting_densehash_map.
+   * @tparam V    element type of Map::insert, e.g. the key for counting maps, (key, value) for the others.
+   */
+  template <typename Map, typename V>
+  class insert_buffer {
+
+    protected:
+      using clock_type = ::std::chrono::steady_clock;
+
+      Map & map;
+
+      /// tuples inserted since the last flush.
+      ::std::vector<V> buffer;
+
+      /// flush once a rank holds this many tuples.
+      size_t max_size;
+      /// flush once a rank's oldest tuple is this old.  0 for no age limit.
+      double max_seconds;
+
+      /// time of the first insert since the last flush.
+      clock_type::time_point oldest;
+
+      /// number of flushes that inserted into the map.
+      size_t flushes;
+
+      bool local_full() const {
+        if (buffer.size() >= max_size) return true;
+        if ((max_seconds > 0.0) && !buffer.empty()) {
+          return ::std::chrono::duration<double>(clock_type::now() - oldest).count() >= max_seconds;
+        }
+        return false;
+      }
+
+    public:
+      /**
+       * @param _map          the map to insert into.  needs to outlive the buffer.
+       * @param _max_size     tuples per rank that trigger a flush.
+       * @param _max_seconds  age of the buffered tuples on a rank that triggers a flush.  checked at insert().  0 for none.
+       */
+      insert_buffer(Map & _map, size_t const _max_size = (1UL << 20), double const _max_seconds = 0.0) :
+        map(_map), max_size(_max_size), max_seconds(_max_seconds), flushes(0) {
+        buffer.reserve(max_size);
+      }
+
+      insert_buffer(insert_buffer const & other) = delete;
+      insert_buffer & operator=(insert_buffer const & other) = delete;
+
+      /**
+       * @brief  buffer a batch, and flush if any rank reached its size or age limit.  collective.
+       * @param input   tuples to insert.  cleared.
+       * @return number of entries the map inserted, if this call flushed, else 0.
+       */
+      size_t insert(::std::vector<V> & input) {
+        if (buffer.empty() && !input.empty()) oldest = clock_type::now();
+        buffer.insert(buffer.end(), input.begin(), input.end());
+        input.clear();
+
+        bool full = local_full();
+        if (map.get_comm().size() > 1) full = ::mxx::any_of(full, map.get_comm());
+        return full ? flush() : 0;
+      }
+
+      /**
+       * @brief  insert the buffered tuples of all ranks into the map, with 1 map insert.  collective.
+       * @return number of entries the map inserted.
+       */
+      size_t flush() {
+        size_t count = map.insert(buffer);
+        buffer.clear();
+        if (buffer.capacity() > 2 * max_size) {
+          ::std::vector<V>().swap(buffer);
+          buffer.reserve(max_size);
+        }
+        ++flushes;
+        return count;
+      }
+
+      /// number of tuples buffered on this rank.
+      size_t size() const {
+        return buffer.size();
+      }
+
+      bool empty() const {
+        return buffer.empty();
+      }
+
+      /// number of flushes, i.e. collective map inserts, so far.
+      size_t flush_count() const {
+        return flushes;
+      }
+
+      Map & get_map() {
+        return map;
+      }
+  };
+
+} /* namespace dsc */
+
+#endif /* SRC_CONTAINERS_DISTRIBUTED_INSERT_BUFFER_HPP_ */
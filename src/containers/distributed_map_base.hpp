@@ -28,12 +28,36 @@
 #include <functional>
 #include <algorithm>
 #include <iterator>
+#include <utility>   // declval
 #include <vector>
 #include <unordered_set>
+#include <memory>    // unique_ptr
+#include <string>
+#include <exception> // exception_ptr
+#include <stdexcept>
+#include <limits>
+#include <type_traits>
+#include <cmath>     // ceil
+#include <chrono>
+#include <tuple>
+#include <random>    // mt19937_64
 #include "containers/dsc_container_utils.hpp"
+#include "containers/distributed_map_io.hpp"
+#include "containers/distributed_map_export.hpp"
+#include "containers/parallel_for_each.hpp"
+#include "containers/table_stats.hpp"
+#include "containers/query_latency.hpp"
 #include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+#include "io/incremental_mxx.hpp"
+#include "io/hierarchical_mxx.hpp"
+#include "io/compressed_mxx.hpp"
 
 #include "utils/benchmark_utils.hpp"
+#include "utils/logging.h"
+#include "utils/bloom_filter.hpp"
+#include "utils/memory_budget.hpp"
+#include "utils/transform_utils.hpp"
 
 
 
@@ -127,6 +151,34 @@ namespace dsc
 
 	  using StorageTransformedFunction = StoreTransFuncTemplate<Key>;
 	  using StorageTransformedEqual = StoreTransEqualTemplate<Key>;
+
+	  /// distribution transform of canonicalized keys:  none if it is the store transform, which they already went through.
+	  template <typename K>
+	  using CanonicalizedDistTransform = typename ::std::conditional<::std::is_same<DistTrans<Key>, StoreTrans<Key> >::value,
+	      ::bliss::transform::identity<K>, DistTrans<K> >::type;
+
+	  /// same map, with the store transform applied once per key as part of the input transform.  see ::dsc::canonicalize_once.
+	  using CanonicalizeOnce = DistributedMapParams<Key,
+	      ::bliss::transform::compose<InputTrans, StoreTrans>::template on,
+	      CanonicalizedDistTransform, DistFunc, DistEqual,
+	      ::bliss::transform::identity, StoreFunc, StoreEqual,
+	      DistTransFunc, StoreTransFunc>;
+  };
+
+  /**
+   * @brief canonicalize-once storage:  MapParams whose store transform, e.g. lex_less, runs once per key when keys are
+   *        inserted or queried, instead of in every hash and equal call of the local table, i.e. several times per probe.
+   * @details  the local table then uses the plain store hash and equal.  the stored keys, and those returned by find and
+   *           to_vector, are the transformed ones, e.g. the smaller strand instead of the strand inserted first.
+   *           so only for maps whose values do not depend on the key's orientation, e.g. counts, not de Bruijn nodes.
+   *           a distribution transform equal to the store transform is dropped too, so keys stay on the same ranks.
+   *
+   *           usage:  ::dsc::counting_unordered_map<Kmer, uint32_t, ::dsc::canonicalize_once<MapParams>::params>
+   */
+  template <template <typename> class MapParams>
+  struct canonicalize_once {
+      template <typename Key>
+      using params = typename MapParams<Key>::CanonicalizeOnce;
   };
 
   template <typename Key,
@@ -143,6 +195,169 @@ namespace dsc
       ::fsc::TransformedHash, ::fsc::TransformedHash>;
 
 
+  /**
+   * @brief abundance histogram, accumulated per thread during a parallel_for_each_local, then reduced across ranks.
+   * @details bin i counts the keys that occur i times, and the last bin, max_bin, those that occur max_bin or more times.
+   */
+  class local_histogram {
+    protected:
+      ::std::vector<::std::vector<size_t> > parts;
+      size_t max_bin;
+
+    public:
+      /// adds x.second, the count of a counting map entry.
+      struct by_value {
+          local_histogram & h;
+          template <typename V>
+          inline void operator()(V const & x, int const tid) const {
+            h.add(static_cast<size_t>(x.second), tid);
+          }
+      };
+
+      local_histogram(size_t const _max_bin, int const nthreads = 0) :
+        parts(::fsc::parallel_for_each_threads(nthreads), ::std::vector<size_t>(_max_bin + 1, 0)), max_bin(_max_bin) {}
+
+      inline void add(size_t const count, int const tid) {
+        ++(parts[tid][::std::min(count, max_bin)]);
+      }
+
+      /// sum of the thread histograms
+      ::std::vector<size_t> local() const {
+        ::std::vector<size_t> bins(max_bin + 1, 0);
+        for (size_t t = 0; t < parts.size(); ++t) {
+          for (size_t i = 0; i <= max_bin; ++i) bins[i] += parts[t][i];
+        }
+        return bins;
+      }
+
+      /// sum of the local histograms of all ranks, on root.  other ranks get their local histogram.  collective.
+      ::std::vector<size_t> reduce(int const root, ::mxx::comm const & comm) const {
+        ::std::vector<size_t> bins = local();
+        if (comm.size() == 1) return bins;
+        ::std::vector<size_t> total = ::mxx::reduce(bins, root, ::std::plus<size_t>(), comm);
+        return (comm.rank() == root) ? total : bins;
+      }
+  };
+
+  /**
+   * @brief the n entries with the largest counts, x.second, across all ranks.
+   * @details during a parallel_for_each_local each thread keeps its n largest in a min heap.  the heaps are merged into the
+   *          local top n.  the n-th largest count, t, is then found by bisection, with one scalar allreduce per step.
+   *          a rank with more than n entries >= t has n candidates >= t, so the candidates suffice for the count.
+   *          each rank contributes its candidates above t and its share of the ties at t, so at most n entries are gathered.
+   */
+  template <typename V>
+  class local_top_n {
+    protected:
+      using count_type = typename ::std::remove_cv<decltype(::std::declval<V>().second)>::type;
+
+      struct greater {
+          inline bool operator()(V const & x, V const & y) const { return x.second > y.second; }
+      };
+
+      ::std::vector<::std::vector<V> > heaps;
+      size_t n;
+
+    public:
+      /// adds an entry of a counting map.
+      struct by_value {
+          local_top_n & t;
+          template <typename E>
+          inline void operator()(E const & x, int const tid) const {
+            t.add(x, tid);
+          }
+      };
+
+      local_top_n(size_t const _n, int const nthreads = 0) :
+        heaps(::fsc::parallel_for_each_threads(nthreads)), n(_n) {}
+
+      template <typename E>
+      inline void add(E const & x, int const tid) {
+        ::std::vector<V> & h = heaps[tid];
+        if (h.size() < n) {
+          h.emplace_back(x.first, x.second);
+          ::std::push_heap(h.begin(), h.end(), greater());
+        } else if ((n > 0) && (x.second > h.front().second)) {
+          ::std::pop_heap(h.begin(), h.end(), greater());
+          h.back() = V(x.first, x.second);
+          ::std::push_heap(h.begin(), h.end(), greater());
+        }
+      }
+
+      /// the local top n, in decreasing count order.
+      ::std::vector<V> local() const {
+        ::std::vector<V> top;
+        for (size_t t = 0; t < heaps.size(); ++t) {
+          top.insert(top.end(), heaps[t].begin(), heaps[t].end());
+        }
+        size_t const k = ::std::min(n, top.size());
+        ::std::partial_sort(top.begin(), top.begin() + k, top.end(), greater());
+        top.erase(top.begin() + k, top.end());
+        return top;
+      }
+
+      /// the global top n, in decreasing count order, on all ranks.  ties at the n-th count are broken arbitrarily.  collective.
+      ::std::vector<V> reduce(::mxx::comm const & comm) const {
+        ::std::vector<V> top = local();
+        if (comm.size() == 1) return top;
+
+        ::std::vector<V> result;
+        size_t total = ::mxx::allreduce(top.size(), comm);
+        if (total <= n) {
+          result = ::mxx::allgatherv(top, comm);
+          ::std::sort(result.begin(), result.end(), greater());
+          return result;
+        }
+
+        // largest t such that at least n candidates are >= t.
+        count_type lo = ::mxx::allreduce(top.empty() ? ::std::numeric_limits<count_type>::max() : top.back().second,
+                                         ::mxx::min<count_type>(), comm);
+        count_type hi = ::mxx::allreduce(top.empty() ? ::std::numeric_limits<count_type>::lowest() : top.front().second,
+                                         ::mxx::max<count_type>(), comm);
+        while (lo < hi) {
+          count_type mid = lo + (hi - lo + 1) / 2;
+          size_t ge = ::std::distance(top.begin(), ::std::partition_point(top.begin(), top.end(),
+                                                                          [&mid](V const & x) { return x.second >= mid; }));
+          if (::mxx::allreduce(ge, comm) >= n) lo = mid;
+          else hi = mid - 1;
+        }
+
+        // all entries above lo, and the first (n - number above) ties by rank.
+        size_t gt = ::std::distance(top.begin(), ::std::partition_point(top.begin(), top.end(),
+                                                                        [&lo](V const & x) { return x.second > lo; }));
+        size_t eq = ::std::distance(top.begin(), ::std::partition_point(top.begin(), top.end(),
+                                                                        [&lo](V const & x) { return x.second >= lo; })) - gt;
+        size_t need = n - ::mxx::allreduce(gt, comm);
+        size_t before = ::mxx::exscan(eq, ::std::plus<size_t>(), comm);
+        if (comm.rank() == 0) before = 0;
+        size_t take = (before >= need) ? 0 : ::std::min(eq, need - before);
+        top.erase(top.begin() + gt + take, top.end());
+
+        result = ::mxx::allgatherv(top, comm);
+        ::std::sort(result.begin(), result.end(), greater());
+        return result;
+      }
+  };
+
+
+  /// a k-mer of a read, for map_reads:  (k-mer, read id, offset of the k-mer in the read).
+  template <typename Key>
+  using read_seed = ::std::tuple<Key, uint64_t, uint32_t>;
+
+  /// a diagonal bin of a read, from map_reads:  (read id, diagonal, votes).  the diagonal is a reference position less the
+  /// offset of the seed in the read, rounded down to a multiple of the bin width.  votes is the number of seed hits in the bin.
+  using seed_hit = ::std::tuple<uint64_t, int64_t, uint32_t>;
+
+  /// observer of the entries a multimap insert receives, that does nothing.  see e.g. unordered_multimap::insert.
+  struct no_observer {
+      template <typename V>
+      void operator()(::std::vector<V> const &) const {}
+  };
+
+  /// all to all exchange used by the distributed maps.  hierarchical aggregates per node before the inter-node exchange.
+  /// shared_memory lets node local peers read the bucketed data from an MPI-3 shared window instead of receiving a copy.
+  enum class distribute_strategy { direct, hierarchical, shared_memory };
+
   /**
    * KeyTransformParams should be an alias of a specialization of DistributedMapParams.  see subclass for example.
    */
@@ -185,6 +400,596 @@ namespace dsc
       // communication stuff...
       const mxx::comm& comm;
 
+      /// exchange strategy for distribute and all2allv.
+      distribute_strategy strategy;
+      /// node local and cross node communicators.  created when hierarchical strategy is selected.
+      ::std::unique_ptr<::imxx::hierarchical_comm> hcomm;
+      /// scatter_compute_gather variant for one reply per key queries.  automatic picks by input size and free memory.
+      ::imxx::exchange_algorithm exchange;
+      /// ranks on this node, for the per rank share of the free memory.  0 until first needed.
+      mutable size_t node_ranks;
+      /// cap on this process's memory.  queries that would exceed it run in rounds.  none unless BL_MEMORY_BUDGET is set.
+      ::bliss::utils::memory_budget budget;
+      /// delta encode keys on the wire, for exchanges where received order does not matter.
+      bool compress_keys;
+      /// send k-mer keys as super-kmers, in order.  takes precedence over compress_keys for k-mer keys.
+      bool superkmer_keys;
+      /// exchange insert inputs in place, see imxx::distribute_inplace.  on for the inserts that consume their input.
+      bool inplace_insert;
+      /// save k-mer keys bit packed, see distributed_map_io.hpp.
+      bool packed_snapshots;
+
+      /// replicated Bloom filter of the keys on all processes.  find and count drop sure misses before the query exchange.
+      mutable ::bliss::utils::bloom_filter key_filter;
+      /// bits per key for key_filter.  0 disables it.
+      double key_filter_bits;
+
+      /// query exchange buffers, kept across calls so that steady state query rounds reuse their capacity.  see distribute_queries.
+      mutable ::std::vector<Key> scratch_keys;
+      mutable ::std::vector<size_t> scratch_i2o;
+
+      /// rehashes and load factors of the local table across inserts.  off unless set_table_stats(true).
+      ::fsc::table_tracker tracker;
+      /// phases of each find round.  off unless set_query_latency(true).
+      mutable ::fsc::query_latency_tracker query_latency;
+
+      /// number of local writes (inserts, erases, updates, clears, loads) so far.  a query cache is valid while the sum over ranks is unchanged.
+      size_t local_writes;
+
+      /**
+       * @brief  records a local insert with the table tracker, if it is enabled.  construct before the insert.
+       * @details  the bucket count is read before and after, so the cost when disabled is 1 branch.
+       *           a local_insert that calls another is recorded once, by the outer one.
+       */
+      class tracked_insert {
+          map_base & m;
+          bool const on;
+          ::std::chrono::steady_clock::time_point t;
+          size_t before;
+        public:
+          explicit tracked_insert(map_base & _m) : m(_m), on(_m.tracker.enter()), before(0) {
+            ++m.local_writes;
+            if (on) {
+              t = m.tracker.now();
+              before = m.local_bucket_count();
+            }
+          }
+          ~tracked_insert() {
+            if (!on) return;
+            m.tracker.record(t, before, m.local_bucket_count(), m.local_size());
+            m.tracker.leave();
+          }
+      };
+
+      /**
+       * @brief  records a query round with the query latency tracker, if it is enabled.  construct at the start of the round.
+       * @details  mark(p) charges the time since the previous mark to phase p, so the cost when disabled is 1 branch per mark.
+       *           time after the last mark is not recorded.  a query that calls another is recorded once, by the outer one.
+       */
+      class tracked_query {
+          using phase = ::fsc::query_latency_tracker::phase;
+
+          map_base const & m;
+          bool const on;
+          ::fsc::query_latency_tracker::clock_type::time_point last;
+          uint64_t ns[::fsc::query_latency_tracker::phases];
+        public:
+          explicit tracked_query(map_base const & _m) : m(_m), on(_m.query_latency.enter()), ns{0, 0, 0, 0} {
+            if (on) last = ::fsc::query_latency_tracker::clock_type::now();
+          }
+          void mark(phase const p) {
+            if (!on) return;
+            auto t = ::fsc::query_latency_tracker::clock_type::now();
+            ns[p] += ::std::chrono::duration_cast<::std::chrono::nanoseconds>(t - last).count();
+            last = t;
+          }
+          ~tracked_query() {
+            if (!on) return;
+            m.query_latency.record(ns);
+            m.query_latency.leave();
+          }
+      };
+
+      /**
+       * @brief rebuild key_filter if keys were added on any process since it was built.  collective.
+       * @param local_stale   true if keys were added to the local container since the last rebuild.
+       * @param first, last   the local entries.  value_type is a pair with the key as first.
+       * @return  true if key_filter can be used.
+       */
+      template <typename Iter>
+      bool refresh_key_filter(bool local_stale, Iter first, Iter last, size_t local_count) const {
+        if (key_filter_bits <= 0.0) return false;
+
+        bool stale = local_stale || key_filter.empty();
+        if (!::mxx::any_of(stale, comm)) return true;
+
+        size_t global_count = ::mxx::allreduce(local_count, comm);
+        key_filter.resize(static_cast<size_t>(static_cast<double>(global_count) * key_filter_bits),
+                          ::bliss::utils::bloom_filter::optimal_hashes(key_filter_bits));
+
+        StoreTransformedFarmHash hash;
+        for (; first != last; ++first) {
+          key_filter.insert(static_cast<uint64_t>(hash((*first).first)));
+        }
+
+        // union of the local filters.
+        ::std::vector<uint64_t> & words = key_filter.get_words();
+        ::mxx::allreduce(words, ::std::bit_or<uint64_t>(), comm).swap(words);
+        return true;
+      }
+
+      /**
+       * @brief remove the keys that are not in key_filter, preserving the order of the rest.
+       * @param dropped  the removed keys are appended here.
+       */
+      void drop_key_filter_misses(::std::vector<Key> & keys, ::std::vector<Key> & dropped) const {
+        StoreTransformedFarmHash hash;
+        auto out = keys.begin();
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+          if (key_filter.contains(static_cast<uint64_t>(hash(*it)))) {
+            if (out != it) *out = *it;
+            ++out;
+          } else {
+            dropped.push_back(*it);
+          }
+        }
+        keys.erase(out, keys.end());
+      }
+
+      /// bucket input by key_to_rank and exchange, using the current strategy.  same contract as imxx::distribute.
+      template <typename V, typename ToRank, typename SIZE>
+      void distribute(::std::vector<V>& input, ToRank const & to_rank,
+                      ::std::vector<SIZE> & recv_counts,
+                      ::std::vector<SIZE> & i2o,
+                      ::std::vector<V>& output, bool const & preserve_input = false) const {
+        if (strategy == distribute_strategy::hierarchical)
+          ::imxx::hierarchical_distribute(input, to_rank, recv_counts, i2o, output, *hcomm, preserve_input);
+        else if (strategy == distribute_strategy::shared_memory)
+          ::imxx::shared_distribute(input, to_rank, recv_counts, i2o, output, *hcomm, preserve_input);
+        else
+          ::imxx::distribute(input, to_rank, recv_counts, i2o, output, comm, preserve_input);
+      }
+
+      /**
+       * @brief distribute query keys by to_rank, using the scratch buffers.  keys is replaced by the received keys.
+       * @details  the received keys are written into scratch_keys, which is then swapped with keys, so the storage of the
+       *           input keys becomes the scratch buffer for the next call.  no allocation if the buffers are large enough.
+       */
+      template <typename ToRank, typename SIZE>
+      void distribute_queries(::std::vector<Key>& keys, ToRank const & to_rank, ::std::vector<SIZE> & recv_counts) const {
+        scratch_keys.clear();   // distribute leaves the output untouched if all inputs are empty.
+        this->distribute(keys, to_rank, recv_counts, scratch_i2o, scratch_keys);
+        keys.swap(scratch_keys);
+      }
+
+      /**
+       * @brief true if the map or the queries are empty on all ranks.  collective.
+       * @details  same as  empty() || ::dsc::empty(keys, comm)  with 1 reduction instead of 2, which matters for small query batches.
+       */
+      template <typename V>
+      bool nothing_to_query(::std::vector<V> const & keys) const {
+        if (comm.size() == 1) return this->local_empty() || keys.empty();
+
+        // bit 0: some map is not empty.  bit 1: some query vector is not empty.
+        int flags = (this->local_empty() ? 0 : 1) | (keys.empty() ? 0 : 2);
+        flags = ::mxx::allreduce(flags, ::std::bit_or<int>(), comm);
+        return flags != 3;
+      }
+
+      /**
+       * @brief run a collective query in rounds of at most batch_size local keys, handing the results of each round to sink.  collective.
+       * @details  all ranks run the same number of rounds, until every rank has queried all of its keys, so the result
+       *           memory is bounded by 1 round.  duplicate removal by the query, if any, is within a round.
+       * @param query   collective, called as query(std::vector<Key>& batch), returning the results as a vector.  may modify batch.
+       * @param sink    called as sink(results) with each round's local results.  may consume them, e.g. by swap.
+       * @param batch_size  keys per rank per round.  0 for a single round.
+       * @return  number of results handed to sink on this rank.
+       */
+      template <typename Query, typename Sink>
+      size_t query_in_rounds(::std::vector<Key> const & keys, size_t batch_size, Query const & query, Sink && sink) const {
+        size_t const step = (batch_size == 0) ? keys.size() : batch_size;
+
+        ::std::vector<Key> batch;
+        size_t total = 0;
+        size_t pos = 0;
+        size_t n;
+        do {
+          n = ::std::min(step, keys.size() - pos);
+          batch.assign(keys.begin() + pos, keys.begin() + pos + n);
+          pos += n;
+
+          auto results = query(batch);
+          total += results.size();
+          sink(results);
+        } while (!::mxx::all_of(pos >= keys.size(), comm));
+
+        return total;
+      }
+
+      /**
+       * @brief query keys with 1 reply per key, returned at the key's position in keys.  collective.
+       * @details  a copy of keys is transformed and bucketed by to_rank, keeping the i2o mapping of the bucketing.  the owners
+       *           reply with R values only, in the order received, and the replies are sent back with the reverse all2allv
+       *           and scattered to the original positions through i2o.  keys are not echoed, so the replies are about
+       *           half the size of (key, value) results, and the caller needs no join.  duplicates are queried as is.
+       *           with the direct strategy the exchange is scatter_compute_gather, with the variant from set_exchange_algorithm.
+       * @param lookup  called as lookup(first, last, out) with the received keys.  writes 1 R per key to out.
+       */
+      template <typename R, typename ToRank, typename Lookup>
+      ::std::vector<R> aligned_query(::std::vector<Key> const & keys, ToRank const & to_rank, Lookup const & lookup) const {
+        if ((comm.size() > 1) && (strategy == distribute_strategy::direct))
+          return this->template exchange_query<R>(keys, to_rank, lookup);
+
+        BL_BENCH_INIT(aligned);
+
+        BL_BENCH_START(aligned);
+        ::std::vector<Key> query;
+        this->transform_input(keys, query);
+        ::std::vector<R> results(query.size());
+        BL_BENCH_END(aligned, "transform_input", query.size());
+
+        if (comm.size() == 1) {
+          BL_BENCH_START(aligned);
+          lookup(query.cbegin(), query.cend(), results.begin());
+          BL_BENCH_END(aligned, "local_lookup", results.size());
+
+          BL_BENCH_REPORT_MPI_NAMED(aligned, "base_map:aligned_query", comm);
+          return results;
+        }
+
+        BL_BENCH_COLLECTIVE_START(aligned, "dist_query", comm);
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<size_t> i2o;
+        ::std::vector<Key> received;
+        this->distribute(query, to_rank, recv_counts, i2o, received);
+        BL_BENCH_END(aligned, "dist_query", received.size());
+
+        // distribute returns early, with no counts, only if there are no keys on any rank.
+        if (recv_counts.empty()) {
+          BL_BENCH_REPORT_MPI_NAMED(aligned, "base_map:aligned_query", comm);
+          return results;
+        }
+
+        BL_BENCH_START(aligned);
+        ::std::vector<R> replies(received.size());
+        lookup(received.cbegin(), received.cend(), replies.begin());
+        BL_BENCH_END(aligned, "local_lookup", replies.size());
+
+        // back to the senders, in bucketed order, then to the input order.
+        BL_BENCH_COLLECTIVE_START(aligned, "undistribute", comm);
+        ::imxx::undistribute(replies, recv_counts, i2o, results, comm, true);
+        BL_BENCH_END(aligned, "undistribute", results.size());
+
+        BL_BENCH_REPORT_MPI_NAMED(aligned, "base_map:aligned_query", comm);
+        return results;
+      }
+
+      /// reference position of a map value:  get_pos() for the sequence ids of the position indices, else the value itself.
+      template <typename V>
+      static auto seed_position(V const & v, int) -> decltype(static_cast<int64_t>(v.get_pos())) {
+        return static_cast<int64_t>(v.get_pos());
+      }
+      template <typename V>
+      static int64_t seed_position(V const & v, long) {
+        return static_cast<int64_t>(v);
+      }
+
+      /// seed_hits visitor for containers with equal_range.
+      template <typename Container>
+      struct equal_range_visitor {
+          Container const & c;
+          template <typename F>
+          void operator()(Key const & k, F const & f) const {
+            auto range = c.equal_range(k);
+            for (auto it = range.first; it != range.second; ++it) f(it->second);
+          }
+      };
+
+      /// append the diagonal bins of the seeds in [first, last) to hits, 1 vote per value of each seed's k-mer.
+      template <typename Iter, typename Visit>
+      static void add_seed_diagonals(Iter first, Iter last, Visit const & visit, int64_t const bin_width,
+                                     ::std::vector<::std::pair<uint64_t, int64_t> > & hits) {
+        for (; first != last; ++first) {
+          uint64_t const read = ::std::get<1>(*first);
+          int64_t const offset = ::std::get<2>(*first);
+          visit(::std::get<0>(*first), [&hits, read, offset, bin_width](T const & v) {
+            int64_t d = seed_position(v, 0) - offset;
+            // round toward negative infinity, so that a bin holds bin_width diagonals on both sides of 0.
+            int64_t bin = (d >= 0) ? (d / bin_width) : -((-d + bin_width - 1) / bin_width);
+            hits.emplace_back(read, bin * bin_width);
+          });
+        }
+      }
+
+      /// count the equal (read, diagonal) pairs in hits, as seed_hit in (read, diagonal) order.  hits is cleared.
+      static void tally_seed_diagonals(::std::vector<::std::pair<uint64_t, int64_t> > & hits, ::std::vector<seed_hit> & out) {
+        ::std::sort(hits.begin(), hits.end());
+        for (size_t i = 0; i < hits.size(); ) {
+          size_t j = i + 1;
+          while ((j < hits.size()) && (hits[j] == hits[i])) ++j;
+          out.emplace_back(hits[i].first, hits[i].second, static_cast<uint32_t>(j - i));
+          i = j;
+        }
+        hits.clear();
+      }
+
+      /**
+       * @brief diagonal binned seed hits of reads.  collective.
+       * @details  the seeds are bucketed by the owner of their k-mer and sent with their read id and offset.  each owner
+       *           looks up the k-mers, bins the hits by (read id, diagonal), and replies with 1 seed_hit per bin per
+       *           requesting rank, instead of the (k-mer, position) pairs of find.  the requester sums the bins from
+       *           the owners.  for repetitive k-mers the reply is per bin, not per position.
+       *           seeds whose k-mer satisfies replicated(k-mer) are sent to all ranks, which each answer from their share.
+       * @param visit   called as visit(k-mer, f) on the owner, with the transformed k-mer.  calls f(value) for each local value.
+       * @param replicated  called as replicated(k-mer) with the transformed k-mer.  only if any_replicated, same on all ranks.
+       * @param bin_width  diagonals per bin.  at least 1.
+       * @return  1 seed_hit per (read id, diagonal bin) of this rank's seeds, sorted by read id then diagonal.
+       */
+      template <typename ToRank, typename Visit, typename Replicated>
+      ::std::vector<seed_hit> seed_hits(::std::vector<read_seed<Key> > const & seeds, ToRank const & to_rank,
+                                        Visit const & visit, bool const any_replicated, Replicated const & replicated,
+                                        size_t const bin_width) const {
+        BL_BENCH_INIT(seed_hits);
+
+        int64_t const width = ::std::max(bin_width, static_cast<size_t>(1));
+        ::std::vector<seed_hit> results;
+        ::std::vector<::std::pair<uint64_t, int64_t> > hits;
+
+        BL_BENCH_START(seed_hits);
+        ::std::vector<read_seed<Key> > query;
+        ::std::vector<read_seed<Key> > heavy;
+        InputTransform trans;
+        for (auto it = seeds.begin(); it != seeds.end(); ++it) {
+          read_seed<Key> q(trans(::std::get<0>(*it)), ::std::get<1>(*it), ::std::get<2>(*it));
+          if (any_replicated && replicated(::std::get<0>(q))) heavy.emplace_back(q);
+          else query.emplace_back(q);
+        }
+        BL_BENCH_END(seed_hits, "transform_input", query.size());
+
+        if (comm.size() == 1) {
+          BL_BENCH_START(seed_hits);
+          add_seed_diagonals(query.cbegin(), query.cend(), visit, width, hits);
+          add_seed_diagonals(heavy.cbegin(), heavy.cend(), visit, width, hits);
+          tally_seed_diagonals(hits, results);
+          BL_BENCH_END(seed_hits, "local_hits", results.size());
+
+          BL_BENCH_REPORT_MPI_NAMED(seed_hits, "base_map:seed_hits", comm);
+          return results;
+        }
+
+        BL_BENCH_COLLECTIVE_START(seed_hits, "dist_query", comm);
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<size_t> i2o;
+        ::std::vector<read_seed<Key> > received;
+        this->distribute(query, [&to_rank](read_seed<Key> const & q) { return to_rank(::std::get<0>(q)); },
+                         recv_counts, i2o, received);
+        // distribute returns early, with no counts, only if there are no seeds on any rank.
+        if (recv_counts.empty()) recv_counts.assign(comm.size(), 0);
+
+        ::std::vector<size_t> heavy_counts(comm.size(), 0);
+        if (any_replicated) {
+          heavy_counts = ::mxx::allgather(heavy.size(), comm);
+          heavy = ::mxx::allgatherv(heavy, heavy_counts, comm);
+        }
+        BL_BENCH_END(seed_hits, "dist_query", received.size());
+
+        // bin per requesting rank.
+        BL_BENCH_START(seed_hits);
+        ::std::vector<seed_hit> replies;
+        ::std::vector<size_t> send_counts(comm.size(), 0);
+        auto q = received.cbegin();
+        auto h = heavy.cbegin();
+        for (int i = 0; i < comm.size(); ++i) {
+          add_seed_diagonals(q, q + recv_counts[i], visit, width, hits);
+          add_seed_diagonals(h, h + heavy_counts[i], visit, width, hits);
+          q += recv_counts[i];
+          h += heavy_counts[i];
+
+          size_t before = replies.size();
+          tally_seed_diagonals(hits, replies);
+          send_counts[i] = replies.size() - before;
+        }
+        BL_BENCH_END(seed_hits, "local_hits", replies.size());
+
+        BL_BENCH_COLLECTIVE_START(seed_hits, "a2a_hits", comm);
+        replies = this->all2allv(replies, send_counts);
+        BL_BENCH_END(seed_hits, "a2a_hits", replies.size());
+
+        // the same bin may come from several owners.
+        BL_BENCH_START(seed_hits);
+        ::std::sort(replies.begin(), replies.end());
+        for (size_t i = 0; i < replies.size(); ) {
+          results.emplace_back(replies[i]);
+          size_t j = i + 1;
+          for (; (j < replies.size()) && (::std::get<0>(replies[j]) == ::std::get<0>(replies[i])) &&
+                 (::std::get<1>(replies[j]) == ::std::get<1>(replies[i])); ++j)
+            ::std::get<2>(results.back()) += ::std::get<2>(replies[j]);
+          i = j;
+        }
+        BL_BENCH_END(seed_hits, "merge", results.size());
+
+        BL_BENCH_REPORT_MPI_NAMED(seed_hits, "base_map:seed_hits", comm);
+        return results;
+      }
+
+      /// memory available to this rank:  the node's usable memory split over the node's ranks, within the budget.  collective on first call.
+      size_t free_bytes_per_rank() const {
+        if (node_ranks == 0) node_ranks = hcomm ? hcomm->local.size() : comm.split_shared().size();
+        return ::std::min(::plog::MemUsage::get_usable_mem() / node_ranks, budget.available());
+      }
+
+      /**
+       * @brief keys per round so that a query of the local keys stays within the memory budget.  collective if a budget is set.
+       * @param bytes_per_key  transient bytes per query key, e.g. the key copies and the results in both exchange buffers.
+       * @return  0 if all ranks fit their keys in 1 round, else this rank's batch size for query_in_rounds.
+       */
+      size_t budget_batch_size(size_t const local_keys, size_t const bytes_per_key) const {
+        if (!budget.limited()) return 0;
+
+        size_t batch = budget.max_elements(bytes_per_key);
+        bool fits = (local_keys <= batch);
+        if (comm.size() > 1) fits = ::mxx::all_of(fits, comm);
+        return fits ? 0 : batch;
+      }
+
+      /**
+       * @brief run query in rounds of budget_batch_size keys, appending the results, if the keys do not fit the budget.  collective.
+       * @details  bounds the exchange buffers, not the returned results.  each key contributes 2 key copies and
+       *           results_per_key results, each in 2 buffers.
+       * @return  false, with nothing done, if a single round fits.  the caller then runs the query directly.
+       */
+      template <typename R, typename Query>
+      bool query_within_budget(::std::vector<Key> const & keys, double const results_per_key, Query const & query,
+                               ::std::vector<R> & results) const {
+        size_t const bytes_per_key = 2 * sizeof(Key) + static_cast<size_t>(::std::ceil(2.0 * sizeof(R) * results_per_key));
+        size_t batch = this->budget_batch_size(keys.size(), bytes_per_key);
+        if (batch == 0) return false;
+
+        this->query_in_rounds(keys, batch, query, [&results](::std::vector<R> & r) {
+          results.insert(results.end(), r.begin(), r.end());
+        });
+        return true;
+      }
+
+      /**
+       * @brief aligned_query through ::imxx::scatter_compute_gather_auto, with the exchange algorithm.  collective.
+       * @details  automatic picks the lower memory variants only when the full exchange would not fit, see
+       *           ::imxx::select_exchange.  the free memory is only read for automatic.
+       */
+      template <typename R, typename ToRank, typename Lookup>
+      ::std::vector<R> exchange_query(::std::vector<Key> const & keys, ToRank const & to_rank, Lookup const & lookup) const {
+        BL_BENCH_INIT(exch_query);
+
+        BL_BENCH_START(exch_query);
+        ::std::vector<Key> query;
+        this->transform_input(keys, query);
+        ::std::vector<R> results(query.size());
+        size_t free_bytes = (exchange == ::imxx::exchange_algorithm::automatic) ? this->free_bytes_per_rank() : 0;
+        BL_BENCH_END(exch_query, "transform_input", query.size());
+
+        BL_BENCH_COLLECTIVE_START(exch_query, "scat_comp_gath", comm);
+        ::std::vector<size_t> i2o;
+        ::std::vector<Key> in_buffer;
+        ::std::vector<R> out_buffer;
+        ::imxx::scatter_compute_gather_auto(query, to_rank, lookup, i2o, results, in_buffer, out_buffer, comm,
+                                            exchange, free_bytes, true);
+        BL_BENCH_END(exch_query, "scat_comp_gath", results.size());
+
+        BL_BENCH_REPORT_MPI_NAMED(exch_query, "base_map:exchange_query", comm);
+        return results;
+      }
+
+      /// k-mer key exchange with super-kmer wire format.
+      template <typename V, typename ToRank, typename SIZE>
+      void distribute_superkmers(::std::vector<V>& input, ToRank const & to_rank,
+                                 ::std::vector<SIZE> & recv_counts,
+                                 ::std::vector<V>& output, ::std::true_type) const {
+        ::imxx::superkmer_distribute(input, to_rank, recv_counts, output, comm);
+      }
+      /// not a k-mer.  not called.
+      template <typename V, typename ToRank, typename SIZE>
+      void distribute_superkmers(::std::vector<V>&, ToRank const &, ::std::vector<SIZE> &,
+                                 ::std::vector<V>&, ::std::false_type) const {}
+
+      /// key exchange with compressed wire format.
+      template <typename V, typename ToRank, typename SIZE>
+      void distribute_keys_impl(::std::vector<V>& input, ToRank const & to_rank,
+                                ::std::vector<SIZE> & recv_counts,
+                                ::std::vector<V>& output, ::std::true_type) const {
+        if (superkmer_keys && ::bliss::common::is_kmer<V>::value) {
+          distribute_superkmers(input, to_rank, recv_counts, output,
+                                ::std::integral_constant<bool, ::bliss::common::is_kmer<V>::value>());
+        } else if (compress_keys) {
+          ::imxx::compressed_distribute(input, to_rank, recv_counts, output, comm);
+        } else {
+          ::std::vector<SIZE> i2o;
+          this->distribute(input, to_rank, recv_counts, i2o, output);
+        }
+      }
+
+      /// key exchange for types not supported by the codec.
+      template <typename V, typename ToRank, typename SIZE>
+      void distribute_keys_impl(::std::vector<V>& input, ToRank const & to_rank,
+                                ::std::vector<SIZE> & recv_counts,
+                                ::std::vector<V>& output, ::std::false_type) const {
+        ::std::vector<SIZE> i2o;
+        this->distribute(input, to_rank, recv_counts, i2o, output);
+      }
+
+      /// distribute keys when the received order within each source segment does not matter.  no i2o mapping is produced.
+      template <typename V, typename ToRank, typename SIZE>
+      void distribute_keys(::std::vector<V>& input, ToRank const & to_rank,
+                           ::std::vector<SIZE> & recv_counts,
+                           ::std::vector<V>& output) const {
+        distribute_keys_impl(input, to_rank, recv_counts, output,
+                             ::std::integral_constant<bool, ::imxx::codec::word_view<V>::value>());
+      }
+
+      /**
+       * @brief replace the insert input with the elements this rank owns.  collective.
+       * @details  in place with inplace_insert and the direct strategy, else through a second buffer.
+       */
+      template <typename V, typename ToRank>
+      void distribute_insert(::std::vector<V>& input, ToRank const & to_rank) const {
+        if (inplace_insert && (strategy == distribute_strategy::direct)) {
+          ::imxx::distribute_inplace(input, to_rank, comm);
+          return;
+        }
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<size_t> i2o;
+        ::std::vector<V> buffer;
+        this->distribute(input, to_rank, recv_counts, i2o, buffer);
+        input.swap(buffer);
+      }
+
+      /// distribute_insert for struct of arrays input:  keys and values exchanged as separate arrays.  always direct.
+      template <typename V, typename ToRank>
+      void distribute_insert(::fsc::soa_vector<Key, V>& input, ToRank const & to_rank) const {
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<size_t> i2o;
+        ::fsc::soa_vector<Key, V> buffer;
+        ::imxx::distribute(input, to_rank, recv_counts, i2o, buffer, comm);
+        input.swap(buffer);
+      }
+
+      /// distribute_insert for key only inserts.  the compressed wire formats take precedence over inplace_insert.
+      template <typename V, typename ToRank>
+      void distribute_insert_keys(::std::vector<V>& input, ToRank const & to_rank) const {
+        if (inplace_insert && (strategy == distribute_strategy::direct) && !compress_keys && !superkmer_keys) {
+          ::imxx::distribute_inplace(input, to_rank, comm);
+          return;
+        }
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<V> buffer;
+        this->distribute_keys(input, to_rank, recv_counts, buffer);
+        input.swap(buffer);
+      }
+
+      /**
+       * @brief run insert(owned) on the content of input, with inplace_insert on.  input is left empty, and its storage
+       *        is released before returning.  for the rvalue insert overloads.
+       */
+      template <typename V, typename Insert>
+      size_t insert_consumed(::std::vector<V>& input, Insert const & insert) {
+        ::std::vector<V> owned;
+        owned.swap(input);
+        bool const was_inplace = inplace_insert;
+        inplace_insert = true;
+        size_t count = insert(owned);
+        inplace_insert = was_inplace;
+        return count;
+      }
+
+      /// all2allv of bucketed data, using the current strategy.  same contract as mxx::all2allv(vec, counts, comm).
+      /// the shared_memory strategy uses the direct exchange here, since the data is not already in a shared window.
+      template <typename V, typename SIZE>
+      ::std::vector<V> all2allv(::std::vector<V> const & input, ::std::vector<SIZE> const & send_counts) const {
+        if (strategy == distribute_strategy::hierarchical)
+          return ::imxx::hierarchical_all2allv(input, send_counts, *hcomm);
+        else
+          return ::mxx::all2allv(input, send_counts, comm);
+      }
+
       // ============= local modifiers.  not directly accessible publically.  meant to be called via collective calls.
 
       // abstract declarations - need to access the local containers, therefore override in subclases.
@@ -192,11 +997,141 @@ namespace dsc
       virtual void local_clear() = 0;
       virtual void local_reserve(size_t n) = 0;
 
-      map_base(const mxx::comm& _comm) : comm(_comm) {}
+      /// replace the (already cleared) local table with saved entries.  maps that support load override this.
+      virtual void local_load(::std::pair<Key, T> const * first, size_t count) {
+        BLISS_UNUSED(first);
+        BLISS_UNUSED(count);
+        throw ::std::logic_error("ERROR: load is not supported by this map type.");
+      }
+
+      /// append k local entries chosen uniformly without replacement to result, or all if k >= local_size().
+      /// maps that support sample override this.  see ::fsc::sample.
+      virtual void local_sample(size_t k, ::std::mt19937_64 & gen, ::std::vector<::std::pair<Key, T> > & result) const {
+        BLISS_UNUSED(k);
+        BLISS_UNUSED(gen);
+        BLISS_UNUSED(result);
+        throw ::std::logic_error("ERROR: sample is not supported by this map type.");
+      }
+
+      /// rebuild the local table at the size of its entries, dropping slack and tombstones.  maps that can, override this.
+      virtual void local_shrink() {}
+
+      /// buckets of the local table, for the table tracker.  0 for containers without buckets.
+      virtual size_t local_bucket_count() const {
+        return 0;
+      }
+
+      /// add the probe lengths and tombstones of the local table.  hash tables override this.  see containers/table_stats.hpp
+      virtual void local_table_stats(::fsc::table_stats & stats) const {
+        BLISS_UNUSED(stats);
+      }
+
+      /// send a chunk of loaded entries to their owners and insert them.  collective.  see load_repartition.
+      /// maps that support load_repartition override this.
+      virtual void repartition_chunk(::std::vector<::std::pair<Key, T> > & chunk) {
+        BLISS_UNUSED(chunk);
+        throw ::std::logic_error("ERROR: load_repartition is not supported by this map type.");
+      }
+
+      /// run a local step of a collective call.  if it fails on any rank, all ranks throw, instead of the rest waiting forever.
+      template <typename Func>
+      void collective_local_step(Func const & f, const char * what) const {
+        ::std::exception_ptr err;
+        try {
+          f();
+        } catch (...) {
+          err = ::std::current_exception();
+        }
+
+        bool ok = (err == nullptr);
+        if (comm.size() > 1) ok = ::mxx::all_of(ok, comm);
+
+        if (err != nullptr) ::std::rethrow_exception(err);
+        if (!ok) throw ::std::runtime_error(::std::string("ERROR: ") + what + " failed on another rank.");
+      }
+
+      // ================ co-partitioned set operations.  see intersect, subtract and merge in the hash map bases.
+
+      /// counts, per thread, the visited entries that to_rank does not assign to this rank.
+      template <typename ToRank>
+      struct misplaced_counter {
+          ToRank const & to_rank;
+          int const rank;
+          ::std::vector<size_t> & counts;
+          template <typename E>
+          inline void operator()(E const & x, int const tid) const {
+            if (to_rank(x.first) != rank) ++counts[tid];
+          }
+      };
+
+      /// collects, per thread, the keys of the visited entries that are (in_other) or are not in other's local container.
+      template <typename OtherContainer>
+      struct membership_collector {
+          OtherContainer const & other;
+          bool const in_other;
+          ::std::vector<::std::vector<Key> > & parts;
+          template <typename E>
+          inline void operator()(E const & x, int const tid) const {
+            if ((other.count(x.first) > 0) == in_other) parts[tid].push_back(x.first);
+          }
+      };
+
+      /// collects the visited entries, per thread.
+      struct entry_collector {
+          ::std::vector<::std::vector<::std::pair<Key, T> > > & parts;
+          template <typename E>
+          inline void operator()(E const & x, int const tid) const {
+            parts[tid].emplace_back(x.first, x.second);
+          }
+      };
+
+      template <typename V>
+      static ::std::vector<V> concat(::std::vector<::std::vector<V> > & parts) {
+        size_t total = 0;
+        for (size_t i = 0; i < parts.size(); ++i) total += parts[i].size();
+        ::std::vector<V> result;
+        result.reserve(total);
+        for (size_t i = 0; i < parts.size(); ++i) {
+          result.insert(result.end(), parts[i].begin(), parts[i].end());
+          ::std::vector<V>().swap(parts[i]);
+        }
+        return result;
+      }
+
+      /**
+       * @brief check that the local entries of another map belong to this rank under this map's to_rank, so that
+       *        equal keys of the 2 maps are on the same rank and set operations need no communication.  collective.
+       * @details the communicators have to have the same ranks in the same order.  every local key of the other map is checked.
+       * @throw std::invalid_argument on all ranks if any rank fails the check.
+       */
+      template <typename ToRank, typename OtherContainer>
+      void check_copartitioned(ToRank const & to_rank, ::mxx::comm const & other_comm, OtherContainer const & other) const {
+        int result = MPI_UNEQUAL;
+        MPI_Comm_compare(comm, other_comm, &result);
+        bool ok = (result == MPI_IDENT) || (result == MPI_CONGRUENT);
+
+        if (ok) {
+          ::std::vector<size_t> counts(::fsc::parallel_for_each_threads(0), 0);
+          ::fsc::parallel_for_each(other, misplaced_counter<ToRank>{to_rank, comm.rank(), counts});
+          for (size_t i = 0; i < counts.size(); ++i) ok &= (counts[i] == 0);
+        }
+
+        if (comm.size() > 1) ok = ::mxx::all_of(ok, comm);
+        if (!ok) throw ::std::invalid_argument("ERROR: maps are not co-partitioned.  communicators or key to rank assignment differ.");
+      }
+
+      map_base(const mxx::comm& _comm) : comm(_comm), strategy(distribute_strategy::direct),
+          exchange(::imxx::exchange_algorithm::automatic), node_ranks(0), compress_keys(false), superkmer_keys(false), inplace_insert(false),
+          packed_snapshots(false), key_filter_bits(0.0), local_writes(0) {}
 
     public:
       virtual ~map_base() {};
 
+      /// the communicator of this map.
+      ::mxx::comm const & get_comm() const {
+        return comm;
+      }
+
 
       // ================ data access functions
       virtual void to_vector(std::vector<std::pair<Key, T> > & result) const  = 0;
@@ -254,13 +1189,363 @@ namespace dsc
       /// access the current the multiplicity.  only multimap needs to override this.
       virtual float get_multiplicity() const {
         // multimaps would add a collective function to change the multiplicity
-        if (this->comm.rank() == 0) printf("rank %d map_base get_multiplicity called\n", this->comm.rank());
+        if (this->comm.rank() == 0) BL_DEBUGF("rank %d map_base get_multiplicity called", this->comm.rank());
 
         return 1.0f;
       }
 
+      /**
+       * @brief entries per unique key over all ranks.  1 allreduce of the local sizes.  collective.
+       * @details  O(1) locally for maps, and for multimaps that maintain their unique key count.  e.g. to reserve results.
+       */
+      float global_multiplicity() const {
+        ::std::vector<size_t> counts(2);
+        counts[0] = this->local_size();
+        counts[1] = this->local_unique_size();
+        if (comm.size() > 1) ::mxx::allreduce(counts, ::std::plus<size_t>(), comm).swap(counts);
+
+        return (counts[1] == 0) ? 1.0f : (static_cast<float>(counts[0]) / static_cast<float>(counts[1]));
+      }
+
+      /**
+       * @brief n entries chosen uniformly without replacement over all ranks, e.g. as queries or to estimate a
+       *        distribution.  collective.
+       * @details  1 allgather of the local sizes, then each rank's share is drawn from the multivariate hypergeometric
+       *           distribution of n draws over the ranks' entries, so every n-subset of the entries is equally likely.
+       *           the shares are drawn by halving the ranks:  a range of ranks splits its draws between its 2 halves
+       *           with 1 hypergeometric draw, and all ranks in the range draw it with the same generator state, from the
+       *           shared seed, so the shares add up to n with log p draws per rank.  each rank then samples its share
+       *           from its local container, without moving keys.  the result is this rank's share, so the sample stays
+       *           distributed.  all entries if n >= size().  the same seed on the same map gives the same sample.
+       */
+      ::std::vector<::std::pair<Key, T> > sample(size_t n, uint64_t seed = 0) const {
+        size_t const local = this->local_size();
+        ::std::vector<size_t> sizes = (comm.size() == 1) ? ::std::vector<size_t>(1, local) : ::mxx::allgather(local, comm);
+
+        // prefix[i] is the entries of the ranks before i.
+        ::std::vector<size_t> prefix(comm.size() + 1, 0);
+        for (int i = 0; i < comm.size(); ++i) prefix[i + 1] = prefix[i] + sizes[i];
+        if (n > prefix.back()) n = prefix.back();
+
+        // descend to this rank's share.  the ranks in [lo, hi) have taken the same path, so their generators agree.
+        ::std::mt19937_64 gen(seed);
+        int lo = 0, hi = comm.size();
+        size_t k = n;
+        while (hi - lo > 1) {
+          int const mid = lo + (hi - lo) / 2;
+          size_t const left = ::fsc::hypergeometric(prefix[mid] - prefix[lo], prefix[hi] - prefix[mid], k, gen);
+          if (comm.rank() < mid) {
+            hi = mid;
+            k = left;
+          } else {
+            lo = mid;
+            k -= left;
+          }
+        }
+
+        ::std::vector<::std::pair<Key, T> > result;
+        if (k == 0) return result;
+        gen.seed(seed * 0x9E3779B97F4A7C15ULL + comm.rank());
+        this->local_sample(k, gen, result);
+        return result;
+      }
+
       // ============= collective modifiers
 
+      /// select the all to all strategy.  collective.  hierarchical and shared_memory create the node level communicators on first use.
+      void set_distribute_strategy(distribute_strategy s) {
+        if ((s != distribute_strategy::direct) && !hcomm)
+          hcomm.reset(new ::imxx::hierarchical_comm(comm));
+        strategy = s;
+      }
+
+      distribute_strategy get_distribute_strategy() const {
+        return strategy;
+      }
+
+      /// select the scatter_compute_gather variant for find_aligned and count_aligned.  automatic by default.
+      /// the hierarchical and shared_memory strategies use their own exchange and ignore this.
+      void set_exchange_algorithm(::imxx::exchange_algorithm a) {
+        exchange = a;
+      }
+
+      ::imxx::exchange_algorithm get_exchange_algorithm() const {
+        return exchange;
+      }
+
+      /// cap this process's memory at bytes.  0 removes the budget.  the default is from BL_MEMORY_BUDGET, see memory_budget.hpp.
+      /// set on all ranks, since whether a budget is set decides whether queries make the extra collective to plan rounds.
+      void set_memory_budget(size_t const bytes) {
+        budget = ::bliss::utils::memory_budget(bytes);
+      }
+
+      ::bliss::utils::memory_budget const & get_memory_budget() const {
+        return budget;
+      }
+
+      /**
+       * @brief save the map, one file per rank, "<prefix>.<rank>".  collective.
+       * @details  the local entries are written with a header (see distributed_map_io.hpp), for load() with the same
+       *           number of processes, map type, and distribution hash.  k-mer keys are bit packed if set_packed_snapshots.
+       */
+      virtual void save(::std::string const & prefix) const {
+        this->collective_local_step([this, &prefix]() {
+          ::std::vector<::std::pair<Key, T> > entries;
+          this->to_vector(entries);
+          ::dsc::write_map_file(::dsc::map_file_name(prefix, comm.rank()), comm.size(), comm.rank(),
+                                entries.data(), entries.size(), packed_snapshots);
+        }, "save");
+      }
+
+      /**
+       * @brief write all entries to 1 shared file, sorted by key over all ranks.  collective.
+       * @details  a sample sort in rounds of about chunk_bytes per rank, with each round appended to the file by all
+       *           ranks, see distributed_map_export.hpp.  keys are compared as stored, with less.  the local entries are
+       *           copied once.
+       * @return  the number of entries written.
+       */
+      template <typename Less = ::std::less<Key> >
+      size_t export_sorted(::std::string const & filename, size_t const chunk_bytes = (1UL << 26), Less const & less = Less()) const {
+        ::std::vector<::std::pair<Key, T> > entries;
+        this->to_vector(entries);
+        return ::dsc::export_sorted(entries, filename, less, comm, chunk_bytes);
+      }
+
+      /**
+       * @brief replace the map content with what save() wrote.  collective.
+       * @details  each rank mmaps its own file and inserts the entries locally, without communication.  files with packed
+       *           keys are decoded to a temporary array first.
+       *           throws std::invalid_argument if the file was written with a different number of processes or entry type,
+       *           and IOException if the file cannot be read.
+       */
+      virtual void load(::std::string const & prefix) {
+        this->collective_local_step([this, &prefix]() {
+          ::dsc::mapped_map_file f(::dsc::map_file_name(prefix, comm.rank()));
+          f.template validate<Key, T>(comm.size(), comm.rank());
+
+          this->local_clear();
+          if (f.packed()) {
+            ::std::vector<::std::pair<Key, T> > entries(f.size());
+            f.read_entries(0, f.size(), entries.data());
+            this->local_load(entries.data(), entries.size());
+          } else {
+            this->local_load(f.template entries<Key, T>(), f.size());
+          }
+          ++local_writes;
+        }, "load");
+      }
+
+      /**
+       * @brief replace the map content with what save() wrote with any number of processes, e.g. by a larger build job.  collective.
+       * @details  rank r reads saved files r, r + p, r + 2p, ..., and passes their entries in chunks of about chunk_bytes to
+       *           repartition_chunk, which sends them to their owners under this map's distribution.  the files are mmapped
+       *           and unmapped once read, so peak memory is the map plus a few chunks.  nothing is parsed or reduced again.
+       *           throws std::invalid_argument if a file holds a different entry type, and IOException if a file cannot be read.
+       */
+      virtual void load_repartition(::std::string const & prefix, size_t const chunk_bytes = (1UL << 26)) {
+        // number of saved files, from the header of the first one.
+        int saved = 0;
+        this->collective_local_step([this, &prefix, &saved]() {
+          if (comm.rank() == 0) {
+            ::dsc::mapped_map_file f(::dsc::map_file_name(prefix, 0));
+            saved = f.header().comm_size;
+          }
+        }, "load_repartition");
+        if (comm.size() > 1) saved = ::mxx::allreduce(saved, ::mxx::max<int>(), comm);
+
+        ::std::vector<::std::unique_ptr<::dsc::mapped_map_file> > files;
+        size_t local_count = 0;
+        this->collective_local_step([this, &prefix, saved, &files, &local_count]() {
+          for (int i = comm.rank(); i < saved; i += comm.size()) {
+            files.emplace_back(new ::dsc::mapped_map_file(::dsc::map_file_name(prefix, i)));
+            files.back()->template validate<Key, T>(saved, i);
+            local_count += files.back()->size();
+          }
+        }, "load_repartition");
+
+        this->local_clear();
+        ++local_writes;
+        size_t total = (comm.size() > 1) ? ::mxx::allreduce(local_count, comm) : local_count;
+        this->local_reserve((total + comm.size() - 1) / comm.size());
+
+        // same number of rounds on all ranks, since repartition_chunk communicates.
+        size_t const per_chunk = ::std::max(chunk_bytes / sizeof(::std::pair<Key, T>), static_cast<size_t>(1));
+        size_t rounds = (local_count + per_chunk - 1) / per_chunk;
+        if (comm.size() > 1) rounds = ::mxx::allreduce(rounds, ::mxx::max<size_t>(), comm);
+
+        ::std::vector<::std::pair<Key, T> > chunk;
+        chunk.reserve(::std::min(per_chunk, local_count));
+        size_t f = 0;
+        size_t pos = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+          chunk.clear();
+          while ((chunk.size() < per_chunk) && (f < files.size())) {
+            size_t n = ::std::min(per_chunk - chunk.size(), files[f]->size() - pos);
+            size_t const filled = chunk.size();
+            chunk.resize(filled + n);
+            files[f]->read_entries(pos, n, chunk.data() + filled);
+            pos += n;
+            if (pos == files[f]->size()) {   // done with this file.  unmap it.
+              files[f].reset();
+              ++f;
+              pos = 0;
+            }
+          }
+          this->repartition_chunk(chunk);
+        }
+      }
+
+      /// write k-mer keys bit packed in save(), at k * bitsPerChar bits each.  load and load_repartition read either layout.
+      void set_packed_snapshots(bool enable) {
+        packed_snapshots = enable;
+      }
+
+      /// enable the delta encoded wire format for key only exchanges (e.g. counting inserts).  set the same on all ranks.
+      void set_key_compression(bool enable) {
+        compress_keys = enable;
+      }
+
+      /// exchange the inputs of all inserts in place, not only of those that consume their input.  set the same on all ranks.
+      /// lowers the insert peak memory, at the cost of an in place permutation, which is slower than a permuted copy.
+      void set_inplace_insert(bool enable) {
+        inplace_insert = enable;
+      }
+
+      /// enable the super-kmer wire format for k-mer key only exchanges.  received order is preserved.
+      /// effective when consecutive keys go to the same rank, i.e. with the minimizer distribution hash.  set the same on all ranks.
+      void set_superkmer_compression(bool enable) {
+        superkmer_keys = enable;
+      }
+
+      /**
+       * @brief pre-check find and count queries against a replicated Bloom filter of all keys.  set the same on all ranks.
+       * @details  queries that the filter rejects are not sent to their owners; count reports 0 for them locally.
+       *           useful when many queries miss.  the filter is rebuilt by the next find or count after keys are added,
+       *           so it costs bits_per_key bits per key on every process.  about 0.6185^bits_per_key of the misses still
+       *           pass the filter.  0 disables the filter and releases its memory.
+       */
+      void set_query_filter(double bits_per_key) {
+        key_filter_bits = (bits_per_key > 0.0) ? bits_per_key : 0.0;
+        key_filter.reset();
+      }
+
+      /// track the rehashes and load factor of the local table across inserts, from now on.  local.  false stops tracking.
+      void set_table_stats(bool enable) {
+        tracker.enable(enable);
+      }
+
+      /// health of the local table:  a scan for probe lengths and tombstones, with the tracked rehashes and load factors.  local.
+      ::fsc::table_stats get_local_table_stats() const {
+        ::fsc::table_stats stats;
+        this->local_table_stats(stats);
+        tracker.fill(stats);
+        return stats;
+      }
+
+      /**
+       * @brief  report the local table health through BL_BENCH, which gives the min, mean, and max over the ranks, i.e. the
+       *         skew.  the counts are in the element column.  collective.
+       * @return the local stats.
+       */
+      ::fsc::table_stats report_table_stats(::std::string const & name = "map:table_stats") const {
+        BL_BENCH_INIT(table);
+
+        BL_BENCH_START(table);
+        ::fsc::table_stats stats = this->get_local_table_stats();
+        BL_BENCH_END(table, "scan", stats.buckets);
+
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "occupied", stats.occupied);
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "tombstones", stats.tombstones);
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "load_x1000", ::std::round(1000.0 * stats.load_factor()));
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "probe_mean_x100", ::std::round(100.0 * stats.mean_probe()));
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "probe_p99", stats.probe_percentile(0.99));
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "probe_max", stats.max_probe);
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "rehashes", stats.rehashes);
+        BL_BENCH_START(table);
+        BL_BENCH_END(table, "rehash_ms", ::std::round(1000.0 * stats.rehash_seconds));
+
+        BL_BENCH_REPORT_MPI_NAMED(table, name, comm);
+        return stats;
+      }
+
+      /// record the latency and phases of each find round, from now on.  local.  false stops recording.
+      void set_query_latency(bool enable) {
+        query_latency.enable(enable);
+      }
+
+      /// the find rounds of this rank.  local.
+      ::fsc::query_latency_tracker const & get_local_query_latency() const {
+        return query_latency;
+      }
+
+      /**
+       * @brief  percentiles of the find rounds of all ranks, and the rank responsible for the tail.  collective.
+       * @details  the histograms are merged with 1 allreduce, and the local work p99 and slowest round phases of each rank
+       *           are allgathered.  the tail rank is the one with the largest local work p99:  the exchanges of the other
+       *           ranks wait for it.  see containers/query_latency.hpp
+       */
+      ::fsc::query_latency_stats get_query_latency() const {
+        ::fsc::latency_histogram rounds;
+        uint64_t mx = query_latency.get_rounds().max();
+        if (comm.size() > 1) {
+          rounds.assign(::mxx::allreduce(query_latency.get_rounds().get_counts(), ::std::plus<uint64_t>(), comm),
+                        ::mxx::allreduce(mx, ::mxx::max<uint64_t>(), comm));
+        } else {
+          rounds.merge(query_latency.get_rounds());
+        }
+
+        // [work p99, slowest round phases] per rank.
+        ::std::vector<double> local(1 + ::fsc::query_latency_tracker::phases);
+        local[0] = static_cast<double>(query_latency.get_work().percentile(0.99));
+        for (size_t i = 0; i < ::fsc::query_latency_tracker::phases; ++i)
+          local[i + 1] = static_cast<double>(query_latency.get_slowest()[i]);
+        ::std::vector<double> all = (comm.size() == 1) ? local : ::mxx::allgatherv(local, comm);
+
+        ::fsc::query_latency_stats stats;
+        stats.rounds = rounds.count();
+        stats.p50 = static_cast<double>(rounds.percentile(0.5)) * 1e-9;
+        stats.p90 = static_cast<double>(rounds.percentile(0.9)) * 1e-9;
+        stats.p99 = static_cast<double>(rounds.percentile(0.99)) * 1e-9;
+        stats.max = static_cast<double>(rounds.max()) * 1e-9;
+
+        size_t const stride = local.size();
+        for (int r = 1; r < comm.size(); ++r)
+          if (all[r * stride] > all[stats.tail_rank * stride]) stats.tail_rank = r;
+        stats.tail_work_p99 = all[stats.tail_rank * stride] * 1e-9;
+        for (size_t i = 0; i < ::fsc::query_latency_tracker::phases; ++i)
+          stats.tail_phases[i] = all[stats.tail_rank * stride + i + 1] * 1e-9;
+        return stats;
+      }
+
+      /// release the memory held by the query exchange buffers.  local.  reset() also releases them.
+      void release_scratch() {
+        ::std::vector<Key>().swap(scratch_keys);
+        ::std::vector<size_t>().swap(scratch_i2o);
+      }
+
+      /**
+       * @brief  release the memory left over from a build phase, e.g. before a long query phase.  local.
+       * @details  frees the query exchange buffers, optionally rebuilds the local table at the size of its entries (peak is
+       *        the old plus the new table), and returns the free heap pages to the operating system, see trim_heap.
+       *        the entries are unchanged.
+       * @return  bytes by which the resident set shrank.
+       */
+      size_t release_memory(bool const shrink_table = false) {
+        size_t before = ::getCurrentRSS();
+        this->release_scratch();
+        if (shrink_table) this->local_shrink();
+        ::bliss::utils::trim_heap();
+        size_t after = ::getCurrentRSS();
+        return (before > after) ? (before - after) : 0;
+      }
+
       /// reserve space.  n is the local container size.  this allows different processes to individually adjust its own size.
       virtual void reserve( size_t n) {
         // direct reserve + barrier
@@ -270,6 +1555,8 @@ namespace dsc
 
       virtual void reset() {
     	  this->local_reset();
+    	  this->release_scratch();
+    	  ++local_writes;
           if (comm.size() > 1)
             comm.barrier();
 
@@ -279,13 +1566,27 @@ namespace dsc
       virtual void clear() {
         // clear + barrier.
         this->local_clear();
+        ++local_writes;
         if (comm.size() > 1)
           comm.barrier();
       }
 
+      /// batch, in place transform when InputTransform provides one (e.g. the simd kmer canonicalization transforms)
+      template <typename V, typename TR = InputTransform>
+      auto transform_input_impl(std::vector<V> & input, int) const
+        -> decltype(::std::declval<TR const &>().transform_inplace(input), void()) {
+        TR().transform_inplace(input);
+      }
+
+      /// element-wise transform.
+      template <typename V>
+      void transform_input_impl(std::vector<V> & input, long) const {
+        std::transform(input.begin(), input.end(), input.begin(), InputTransform());
+      }
+
       template <typename V>
       void transform_input(std::vector<V> & input) const {
-    	  std::transform(input.begin(), input.end(), input.begin(), InputTransform());
+        transform_input_impl(input, 0);
       }
 
       template <typename V>
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    distributed_map_export.hpp
+ * @ingroup dsc::containers
+ * @brief   export of the entries of a distributed map to 1 shared file, sorted by key over all ranks.
+ * @details the file is a map_file_header, written by rank 0 with comm_rank -1 and the total count, followed by the
+ *          (key, value) entries of all ranks in key order, as in graph_exporter::write_binary.  it can be read back
+ *          with mapped_map_file and validate(p, -1), or by any tool that reads flat records.
+ *
+ *          export_in_rank_order is for entries that are already globally sorted, e.g. a redistributed sorted map:
+ *          each rank writes its own array with mpiio_writer, at the prefix sum of the array sizes.
+ *
+ *          export_sorted is for entries in no particular order, e.g. a hash map.  each rank sorts its own entries,
+ *          and all ranks choose the same rounds * p - 1 splitters from a regular sample.  in round j, the entries in
+ *          buckets j * p .. j * p + p - 1 go to ranks 0 .. p - 1, are merged there, and are appended to the file.  a
+ *          round moves about chunk_bytes per rank, so the exchange buffers stay bounded by the chunk size, not by the
+ *          table, and every rank writes its share of every round.
+ */
+#ifndef SRC_CONTAINERS_DISTRIBUTED_MAP_EXPORT_HPP_
+#define SRC_CONTAINERS_DISTRIBUTED_MAP_EXPORT_HPP_
+
+#include <vector>
+#include <string>
+#include <utility>    // pair
+#include <algorithm>  // sort, upper_bound, max, min
+
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+
+#include "io/mpiio_writer.hpp"
+#include "containers/distributed_map_io.hpp"
+
+namespace dsc  // distributed std container
+{
+
+  /**
+   * @brief  write the local entries of all ranks, in rank order, after a map_file_header.  collective.
+   * @details  the entries should already be sorted within and across ranks.
+   * @return  the number of entries written by all ranks.
+   */
+  template <typename Key, typename T>
+  size_t export_in_rank_order(::std::pair<Key, T> const * entries, size_t const count,
+                              ::std::string const & filename, ::mxx::comm const & comm) {
+    size_t total = (comm.size() > 1) ? ::mxx::allreduce(count, comm) : count;
+
+    ::bliss::io::parallel::mpiio_writer out(filename, comm);
+    ::dsc::map_file_header h = ::dsc::make_map_file_header<Key, T>(comm.size(), -1, total);
+    out.write(reinterpret_cast<char const *>(&h), (comm.rank() == 0) ? sizeof(::dsc::map_file_header) : 0);
+    out.write(reinterpret_cast<char const *>(entries), count * sizeof(::std::pair<Key, T>));
+    return total;
+  }
+
+  /**
+   * @brief  sort the entries of all ranks by key, and write them after a map_file_header.  collective.  see file description.
+   * @param entries     local entries, in any order.  sorted on return.
+   * @param less        key order.  equal keys stay on 1 rank in each round, so their order in the file is unspecified.
+   * @param chunk_bytes about the bytes each rank sends per round.
+   * @return  the number of entries written by all ranks.
+   */
+  template <typename Key, typename T, typename Less>
+  size_t export_sorted(::std::vector<::std::pair<Key, T> > & entries, ::std::string const & filename,
+                       Less const & less, ::mxx::comm const & comm, size_t const chunk_bytes = (1UL << 26)) {
+    using value_type = ::std::pair<Key, T>;
+
+    auto comp = [&less](value_type const & x, value_type const & y) { return less(x.first, y.first); };
+    ::std::sort(entries.begin(), entries.end(), comp);
+
+    if (comm.size() == 1) return export_in_rank_order(entries.data(), entries.size(), filename, comm);
+
+    size_t const p = comm.size();
+    size_t total = ::mxx::allreduce(entries.size(), comm);
+
+    // same number of rounds on all ranks.
+    size_t const per_chunk = ::std::max(chunk_bytes / sizeof(value_type), static_cast<size_t>(1));
+    size_t rounds = (entries.size() + per_chunk - 1) / per_chunk;
+    rounds = ::std::max(::mxx::allreduce(rounds, ::mxx::max<size_t>(), comm), static_cast<size_t>(1));
+    size_t const buckets = rounds * p;
+
+    // regular sample of the sorted local keys, then every (buckets)-th key of the sorted samples of all ranks.
+    size_t const s = ::std::min(entries.size(), buckets);
+    ::std::vector<Key> sample;
+    sample.reserve(s);
+    for (size_t i = 0; i < s; ++i) {
+      sample.emplace_back(entries[(i * entries.size() + entries.size() / 2) / s].first);
+    }
+    ::std::vector<Key> all_samples = ::mxx::allgatherv(sample, comm);
+    ::std::vector<Key>().swap(sample);
+    ::std::sort(all_samples.begin(), all_samples.end(), less);
+
+    // bounds[b] is the first local entry of bucket b.  bucket b holds the keys in (splitter b - 1, splitter b].
+    ::std::vector<size_t> bounds(buckets + 1, 0);
+    bounds[buckets] = entries.size();
+    for (size_t b = 1; b < buckets; ++b) {
+      if (all_samples.empty()) continue;
+      Key const & splitter = all_samples[(b * all_samples.size()) / buckets];
+      bounds[b] = ::std::upper_bound(entries.begin() + bounds[b - 1], entries.end(), splitter,
+                                     [&less](Key const & x, value_type const & y) { return less(x, y.first); }) - entries.begin();
+    }
+    ::std::vector<Key>().swap(all_samples);
+
+    ::bliss::io::parallel::mpiio_writer out(filename, comm);
+    ::dsc::map_file_header h = ::dsc::make_map_file_header<Key, T>(p, -1, total);
+    out.write(reinterpret_cast<char const *>(&h), (comm.rank() == 0) ? sizeof(::dsc::map_file_header) : 0);
+
+    ::std::vector<value_type> send;
+    ::std::vector<value_type> recv;
+    ::std::vector<size_t> send_counts(p, 0);
+    for (size_t r = 0; r < rounds; ++r) {
+      size_t const first = r * p;
+      for (size_t i = 0; i < p; ++i) send_counts[i] = bounds[first + i + 1] - bounds[first + i];
+      send.assign(entries.begin() + bounds[first], entries.begin() + bounds[first + p]);
+
+      recv = ::mxx::all2allv(send, send_counts, comm);
+      // p sorted runs.
+      ::std::sort(recv.begin(), recv.end(), comp);
+
+      out.write(recv);
+    }
+
+    return total;
+  }
+
+} /* namespace dsc */
+
+#endif // SRC_CONTAINERS_DISTRIBUTED_MAP_EXPORT_HPP_
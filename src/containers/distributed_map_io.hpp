@@ -0,0 +1,372 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    distributed_map_io.hpp
+ * @ingroup
+ * @brief   on-disk format for the local tables of a distributed map.
+ * @details each rank writes one file, "<prefix>.<rank>": a fixed size header followed by the local (key, value) entries,
+ *          as a flat array that can be mmapped back.  the header records the entry layout, the kmer size and alphabet,
+ *          the number of processes, and the rank, so that a mismatched load fails instead of returning garbage.
+ *
+ *          kmer tables can instead be written with the keys bit packed (version 2):  the count keys at k * bitsPerChar bits
+ *          each, in whole 64 bit words (see packed_kmer_array.hpp), followed by the count values.  e.g. 12 instead of 16
+ *          bytes per (31-mer, uint32_t) entry.  such files are decoded on read instead of used in place.
+ */
+
+#ifndef SRC_CONTAINERS_DISTRIBUTED_MAP_IO_HPP_
+#define SRC_CONTAINERS_DISTRIBUTED_MAP_IO_HPP_
+
+#include <string>
+#include <cstring>      // memcmp, strerror
+#include <cstdint>
+#include <sstream>
+#include <algorithm>    // min, copy
+#include <stdexcept>
+#include <type_traits>
+#include <utility>      // pair
+#include <vector>
+
+#include <unistd.h>     // write, close
+#include <sys/mman.h>   // mmap
+#include <sys/stat.h>   // fstat
+#include <fcntl.h>      // open
+#include <errno.h>
+
+#include "common/kmer.hpp"
+#include "containers/packed_kmer_array.hpp"
+#include "io/io_exception.hpp"
+#include "utils/exception_handling.hpp"
+
+namespace dsc
+{
+
+  /// fixed size header of a local table file.  all fields are little endian on the platforms we run on; endian_check catches the rest.
+  struct map_file_header {
+      static constexpr uint32_t current_version = 1;
+      /// version of files with bit packed keys, then values.
+      static constexpr uint32_t packed_version = 2;
+      static constexpr uint32_t endian_value = 0x01020304;
+
+      char magic[8];
+      uint32_t version;
+      uint32_t endian_check;
+
+      uint32_t header_bytes;
+      uint32_t entry_bytes;
+      uint32_t key_bytes;
+      uint32_t value_bytes;
+
+      /// kmer size and bits per character.  0 if the key is not a kmer.
+      uint32_t kmer_size;
+      uint32_t kmer_bits_per_char;
+
+      int32_t comm_size;
+      int32_t comm_rank;
+
+      /// number of entries following the header.
+      uint64_t count;
+  };
+
+  /// bytes following the header, by the layout the header records.
+  inline size_t map_file_payload_bytes(map_file_header const & h) {
+    if (h.version != map_file_header::packed_version) return h.count * h.entry_bytes;
+    size_t const key_bits = static_cast<size_t>(h.kmer_size) * h.kmer_bits_per_char;
+    return ((h.count * key_bits + 63) / 64) * sizeof(uint64_t) + h.count * h.value_bytes;
+  }
+
+  /// kmer size, or 0 for non-kmer keys.
+  template <typename Key>
+  constexpr uint32_t kmer_size_of(::std::true_type) { return Key::size; }
+  template <typename Key>
+  constexpr uint32_t kmer_size_of(::std::false_type) { return 0; }
+
+  /// kmer bits per character, or 0 for non-kmer keys.
+  template <typename Key>
+  constexpr uint32_t kmer_bits_of(::std::true_type) { return Key::bitsPerChar; }
+  template <typename Key>
+  constexpr uint32_t kmer_bits_of(::std::false_type) { return 0; }
+
+  /// file name of rank's local table.
+  inline ::std::string map_file_name(::std::string const & prefix, int rank) {
+    ::std::stringstream ss;
+    ss << prefix << "." << rank;
+    return ss.str();
+  }
+
+  /// header for a table of ::std::pair<Key, T> entries.  packed for the bit packed key layout.
+  template <typename Key, typename T>
+  map_file_header make_map_file_header(int comm_size, int comm_rank, size_t count, bool packed = false) {
+    map_file_header h;
+    memset(&h, 0, sizeof(map_file_header));
+    memcpy(h.magic, "BLISSMAP", 8);
+    h.version = packed ? map_file_header::packed_version : map_file_header::current_version;
+    h.endian_check = map_file_header::endian_value;
+    h.header_bytes = sizeof(map_file_header);
+    h.entry_bytes = sizeof(::std::pair<Key, T>);
+    h.key_bytes = sizeof(Key);
+    h.value_bytes = sizeof(T);
+    h.kmer_size = kmer_size_of<Key>(::bliss::common::is_kmer<Key>());
+    h.kmer_bits_per_char = kmer_bits_of<Key>(::bliss::common::is_kmer<Key>());
+    h.comm_size = comm_size;
+    h.comm_rank = comm_rank;
+    h.count = count;
+    return h;
+  }
+
+  /**
+   * @brief write the header and nparts buffers to a new file.
+   * @throw IOException if the file cannot be written.
+   */
+  inline void write_map_file_parts(::std::string const & filename, char const * const * parts, size_t const * sizes, int nparts) {
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1) {
+      int myerr = errno;
+      ::std::stringstream ss;
+      ss << "ERROR in write_map_file open: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+    }
+
+    // write in pieces, since write may be partial.
+    for (int i = 0; i < nparts; ++i) {
+      char const * ptr = parts[i];
+      size_t remaining = sizes[i];
+      while (remaining > 0) {
+        ssize_t written = ::write(fd, ptr, ::std::min(remaining, static_cast<size_t>(1UL << 30)));
+        if (written < 0) {
+          int myerr = errno;
+          if (myerr == EINTR) continue;
+          close(fd);
+          ::std::stringstream ss;
+          ss << "ERROR in write_map_file write: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+        }
+        ptr += written;
+        remaining -= written;
+      }
+    }
+    close(fd);
+  }
+
+  /**
+   * @brief write a local table.
+   * @throw IOException if the file cannot be written.
+   */
+  template <typename Key, typename T>
+  void write_map_file(::std::string const & filename, int comm_size, int comm_rank,
+                      ::std::pair<Key, T> const * entries, size_t count) {
+    map_file_header h = make_map_file_header<Key, T>(comm_size, comm_rank, count);
+
+    char const * parts[2] = { reinterpret_cast<char const *>(&h), reinterpret_cast<char const *>(entries) };
+    size_t sizes[2] = { sizeof(map_file_header), count * sizeof(::std::pair<Key, T>) };
+    write_map_file_parts(filename, parts, sizes, 2);
+  }
+
+  /**
+   * @brief write a local table of kmer keys with the keys bit packed, then the values.
+   * @throw IOException if the file cannot be written.
+   */
+  template <typename Key, typename T>
+  void write_packed_map_file(::std::string const & filename, int comm_size, int comm_rank,
+                             ::std::pair<Key, T> const * entries, size_t count) {
+    static_assert(::bliss::common::is_kmer<Key>::value, "bit packed map files need kmer keys.");
+    map_file_header h = make_map_file_header<Key, T>(comm_size, comm_rank, count, true);
+
+    using packer = ::fsc::packed_kmer_array<Key>;
+    ::std::vector<uint64_t> keys(packer::words_for(count), 0);
+    ::std::vector<T> values;
+    values.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      packer::put(keys.data(), i, entries[i].first);
+      values.emplace_back(entries[i].second);
+    }
+
+    char const * parts[3] = { reinterpret_cast<char const *>(&h), reinterpret_cast<char const *>(keys.data()),
+                              reinterpret_cast<char const *>(values.data()) };
+    size_t sizes[3] = { sizeof(map_file_header), keys.size() * sizeof(uint64_t), count * sizeof(T) };
+    write_map_file_parts(filename, parts, sizes, 3);
+  }
+
+  /// write_map_file with packed, by whether the keys are kmers.
+  template <typename Key, typename T>
+  void write_map_file_impl(::std::string const & filename, int comm_size, int comm_rank,
+                           ::std::pair<Key, T> const * entries, size_t count, bool packed, ::std::true_type) {
+    if (packed) write_packed_map_file(filename, comm_size, comm_rank, entries, count);
+    else write_map_file(filename, comm_size, comm_rank, entries, count);
+  }
+  template <typename Key, typename T>
+  void write_map_file_impl(::std::string const & filename, int comm_size, int comm_rank,
+                           ::std::pair<Key, T> const * entries, size_t count, bool, ::std::false_type) {
+    write_map_file(filename, comm_size, comm_rank, entries, count);
+  }
+
+  /// write a local table, with the keys bit packed if packed and the keys are kmers.
+  template <typename Key, typename T>
+  void write_map_file(::std::string const & filename, int comm_size, int comm_rank,
+                      ::std::pair<Key, T> const * entries, size_t count, bool packed) {
+    write_map_file_impl(filename, comm_size, comm_rank, entries, count, packed, ::bliss::common::is_kmer<Key>());
+  }
+
+  /**
+   * @brief read-only memory map of a local table file.  unpacked entries are used in place.
+   */
+  class mapped_map_file {
+    protected:
+      ::std::string filename;
+      void * data;
+      size_t bytes;
+
+    public:
+      /// @throw IOException if the file cannot be opened or mapped, or is too small to hold its header and entries.
+      mapped_map_file(::std::string const & _filename) : filename(_filename), data(nullptr), bytes(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+          int myerr = errno;
+          ::std::stringstream ss;
+          ss << "ERROR in mapped_map_file open: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+          int myerr = errno;
+          close(fd);
+          ::std::stringstream ss;
+          ss << "ERROR in mapped_map_file fstat: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+        }
+        bytes = st.st_size;
+        if (bytes < sizeof(map_file_header)) {
+          close(fd);
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR in mapped_map_file: [" + filename + "] is too small for a header.");
+        }
+
+        data = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        int myerr = errno;
+        close(fd);
+        if (data == MAP_FAILED) {
+          data = nullptr;
+          ::std::stringstream ss;
+          ss << "ERROR in mapped_map_file mmap: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+        }
+        madvise(data, bytes, MADV_WILLNEED);
+
+        map_file_header const & h = header();
+        if ((memcmp(h.magic, "BLISSMAP", 8) != 0) || (h.header_bytes != sizeof(map_file_header)) ||
+            ((h.version == map_file_header::packed_version) && (h.kmer_size == 0)) ||
+            (bytes < h.header_bytes + map_file_payload_bytes(h))) {
+          munmap(data, bytes);
+          data = nullptr;
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR in mapped_map_file: [" + filename + "] is not a complete map file.");
+        }
+      }
+
+      ~mapped_map_file() {
+        if (data != nullptr) munmap(data, bytes);
+      }
+
+      mapped_map_file(mapped_map_file const & other) = delete;
+      mapped_map_file& operator=(mapped_map_file const & other) = delete;
+
+      map_file_header const & header() const {
+        return *(reinterpret_cast<map_file_header const *>(data));
+      }
+
+      /**
+       * @brief check that the file holds ::std::pair<Key, T> entries written by rank comm_rank of comm_size processes.
+       * @throw std::invalid_argument on mismatch.
+       */
+      template <typename Key, typename T>
+      void validate(int comm_size, int comm_rank) const {
+        map_file_header expected = make_map_file_header<Key, T>(comm_size, comm_rank, 0);
+        map_file_header const & h = header();
+
+        bool ok = true;
+        ::std::stringstream ss;
+        ss << "ERROR in mapped_map_file: [" << filename << "] ";
+        if ((h.version != map_file_header::current_version) && (h.version != map_file_header::packed_version)) {
+          ss << "version " << h.version << " is not " << map_file_header::current_version << " or "
+             << map_file_header::packed_version << ". ";
+          ok = false;
+        }
+        if (h.endian_check != expected.endian_check) {
+          ss << "byte order differs. ";
+          ok = false;
+        }
+        if ((h.entry_bytes != expected.entry_bytes) || (h.key_bytes != expected.key_bytes) || (h.value_bytes != expected.value_bytes)) {
+          ss << "entry layout differs. ";
+          ok = false;
+        }
+        if ((h.kmer_size != expected.kmer_size) || (h.kmer_bits_per_char != expected.kmer_bits_per_char)) {
+          ss << "kmer size " << h.kmer_size << " with " << h.kmer_bits_per_char << " bits per char does not match "
+             << expected.kmer_size << " with " << expected.kmer_bits_per_char << ". ";
+          ok = false;
+        }
+        if ((h.comm_size != comm_size) || (h.comm_rank != comm_rank)) {
+          ss << "written by rank " << h.comm_rank << " of " << h.comm_size << ", loading as rank " << comm_rank << " of " << comm_size << ". ";
+          ok = false;
+        }
+
+        if (!ok) throw ::std::invalid_argument(ss.str());
+      }
+
+      size_t size() const {
+        return header().count;
+      }
+
+      /// true if the keys are bit packed, so entries() is not available.  see read_entries.
+      bool packed() const {
+        return header().version == map_file_header::packed_version;
+      }
+
+      /// the entries, in place.  not for packed files.
+      template <typename Key, typename T>
+      ::std::pair<Key, T> const * entries() const {
+        return reinterpret_cast<::std::pair<Key, T> const *>(reinterpret_cast<char const *>(data) + header().header_bytes);
+      }
+
+      /// copy entries [first, first + n) to out, decoding the keys of packed files.
+      template <typename Key, typename T>
+      void read_entries(size_t const first, size_t const n, ::std::pair<Key, T> * out) const {
+        read_entries_impl(first, n, out, ::bliss::common::is_kmer<Key>());
+      }
+
+    protected:
+      template <typename Key, typename T>
+      void read_entries_impl(size_t const first, size_t const n, ::std::pair<Key, T> * out, ::std::false_type) const {
+        ::std::copy(entries<Key, T>() + first, entries<Key, T>() + first + n, out);
+      }
+
+      template <typename Key, typename T>
+      void read_entries_impl(size_t const first, size_t const n, ::std::pair<Key, T> * out, ::std::true_type) const {
+        if (!packed()) {
+          read_entries_impl(first, n, out, ::std::false_type());
+          return;
+        }
+        using packer = ::fsc::packed_kmer_array<Key>;
+        uint64_t const * keys = reinterpret_cast<uint64_t const *>(reinterpret_cast<char const *>(data) + header().header_bytes);
+        T const * values = reinterpret_cast<T const *>(keys + packer::words_for(size()));
+        for (size_t i = 0; i < n; ++i) {
+          out[i].first = packer::get(keys, first + i);
+          out[i].second = values[first + i];
+        }
+      }
+  };
+
+} /* namespace dsc */
+
+#endif /* SRC_CONTAINERS_DISTRIBUTED_MAP_IO_HPP_ */
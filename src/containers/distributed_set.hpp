@@ -0,0 +1,558 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    distributed_set.hpp
+ * @ingroup dsc::containers
+ * @brief   distributed sets:  key only versions of the distributed hash maps, for presence only workloads.
+ * @details the keys are stored, sent and received without a value, so a set of k-mers takes half the memory and traffic
+ *          of a map with a dummy value.  the sets use the map parameters and the hash distribution of the hash maps
+ *          (HashMapParams), and the exchange machinery of map_base, including key compression.
+ *
+ *          3 local stores are provided:  unordered_set (std::unordered_set), densehash_set (google dense_hash_set, with the
+ *          special keys of densehash_map), and sorted_set (a sorted vector of unique keys, with no empty slots, looked up by
+ *          binary search).
+ *
+ *          to fit the map interface, e.g. for Index, mapped_type is bool, and to_vector, save and load see (key, true) pairs.
+ */
+#ifndef BLISS_DISTRIBUTED_SET_HPP
+#define BLISS_DISTRIBUTED_SET_HPP
+
+#include <unordered_set>  // local storage
+#include <vector>
+#include <utility>        // pair
+#include <functional>     // less
+#include <algorithm>      // sort, unique, inplace_merge, lower_bound
+#include <iterator>       // advance, distance
+#include <cmath>          // ceil
+#include <memory>         // allocator
+
+#include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+
+#include "containers/distributed_map_base.hpp"
+#include "containers/densehash_set.hpp"
+#include "containers/dsc_container_utils.hpp"
+#include "containers/fsc_container_utils.hpp"
+#include "containers/parallel_for_each.hpp"
+
+#include "utils/benchmark_utils.hpp"  // for timing.
+#include "utils/logging.h"
+
+#include "common/bit_ops.hpp"   // ceilLog2
+
+namespace dsc  // distributed std container
+{
+
+  /**
+   * @brief sorted vector of unique keys.  local store of sorted_set.
+   * @details an insert sorts the new keys and merges them in, so bulk inserts are preferred.  lookups are binary searches.
+   */
+  template <typename Key, typename Less, typename Equal, class Alloc = ::std::allocator<Key> >
+  class sorted_key_vector {
+    protected:
+      ::std::vector<Key, Alloc> v;
+
+    public:
+      using key_type        = Key;
+      using value_type      = Key;
+      using size_type       = size_t;
+      using iterator        = typename ::std::vector<Key, Alloc>::const_iterator;
+      using const_iterator  = typename ::std::vector<Key, Alloc>::const_iterator;
+
+      const_iterator begin() const { return v.cbegin(); }
+      const_iterator end() const { return v.cend(); }
+      const_iterator cbegin() const { return v.cbegin(); }
+      const_iterator cend() const { return v.cend(); }
+
+      bool empty() const { return v.empty(); }
+      size_type size() const { return v.size(); }
+      void clear() { v.clear(); }
+      void reserve(size_t const n) { v.reserve(n); }
+      void swap(sorted_key_vector & other) { v.swap(other.v); }
+
+      /// insert keys.  returns the number of keys that were not present.
+      template <class InputIt>
+      size_t insert(InputIt first, InputIt last) {
+        size_t before = v.size();
+        v.insert(v.end(), first, last);
+        auto mid = v.begin() + before;
+        ::std::sort(mid, v.end(), Less());
+        ::std::inplace_merge(v.begin(), mid, v.end(), Less());
+        v.erase(::std::unique(v.begin(), v.end(), Equal()), v.end());
+        return v.size() - before;
+      }
+
+      size_type count(Key const & key) const {
+        auto it = ::std::lower_bound(v.begin(), v.end(), key, Less());
+        return ((it != v.end()) && Equal()(*it, key)) ? 1 : 0;
+      }
+
+      size_type erase(Key const & key) {
+        auto it = ::std::lower_bound(v.begin(), v.end(), key, Less());
+        if ((it == v.end()) || !Equal()(*it, key)) return 0;
+        v.erase(it);
+        return 1;
+      }
+
+      /// erase keys, in 1 pass over the store.  the keys are sorted in place.  returns the number removed.
+      size_t erase(::std::vector<Key> & keys) {
+        ::std::sort(keys.begin(), keys.end(), Less());
+        size_t before = v.size();
+        v.erase(::std::remove_if(v.begin(), v.end(), [&keys](Key const & x) {
+          return ::std::binary_search(keys.begin(), keys.end(), x, Less());
+        }), v.end());
+        return before - v.size();
+      }
+
+      /// call fn(key, thread_id) for each key, split by index.  see containers/parallel_for_each.hpp
+      template <typename F>
+      void parallel_for_each(F fn, int const nthreads = 0) const {
+        ::fsc::parallel_for_each(v, fn, nthreads);
+      }
+  };
+
+
+  /**
+   * @brief  base class of the distributed sets.  keys are assigned to ranks by the distribution hash of MapParams.
+   * @tparam LocalSet  local store of unique keys.  needs insert(first, last), count(key), erase(key), reserve, clear, swap.
+   */
+  template<typename Key, typename LocalSet, template <typename> class MapParams>
+  class set_base : public ::dsc::map_base<Key, bool, MapParams> {
+
+    protected:
+      using Base = ::dsc::map_base<Key, bool, MapParams>;
+
+      struct KeyToRank {
+          typename Base::DistTransformedFunc proc_trans_hash;
+          const int p;
+
+          KeyToRank(int comm_size) :
+            proc_trans_hash(typename Base::DistFunc(ceilLog2(comm_size)),
+                            typename Base::DistTrans()),
+            p(comm_size) {};
+
+          inline int operator()(Key const & x) const {
+            return proc_trans_hash(x) % p;
+          }
+          template<typename V>
+          inline int operator()(::std::pair<Key, V> const & x) const {
+            return this->operator()(x.first);
+          }
+
+          /// keys per call of the distribution hash's batched version.  see imxx::local::assign_batch.
+          static constexpr uint8_t batch_size = ::fsc::hash_batch_size<typename Base::DistTransformedFunc>::value;
+
+          /// ranks of n keys, hashing batch_size keys at a time.
+          template <typename R>
+          inline void assign(Key const * x, size_t const & n, R * ranks) const {
+            uint64_t hashes[batch_size];
+            size_t i = 0;
+            for (; i + batch_size <= n; i += batch_size) {
+              ::fsc::hash_batch(proc_trans_hash, x + i, batch_size, hashes);
+              for (size_t j = 0; j < batch_size; ++j) ranks[i + j] = hashes[j] % p;
+            }
+            for (; i < n; ++i) ranks[i] = this->operator()(x[i]);
+          }
+      } key_to_rank;
+
+    public:
+      using local_container_type = LocalSet;
+
+      using key_type              = Key;
+      using mapped_type           = bool;
+      using value_type            = Key;
+      using size_type             = size_t;
+      using iterator              = typename local_container_type::const_iterator;
+      using const_iterator        = typename local_container_type::const_iterator;
+
+    protected:
+      local_container_type c;
+
+      /// transform the keys, and keep 1 of each.  collective calls are made by the caller.
+      void prepare_keys(::std::vector<Key> & keys, bool sorted_input) const {
+        this->transform_input(keys);
+        ::fsc::unique(keys, sorted_input,
+                      typename Base::StoreTransformedFunc(),
+                      typename Base::StoreTransformedEqual());
+      }
+
+      /// remove keys from the local store.  the keys may be reordered.  returns the number removed.
+      virtual size_t local_erase(::std::vector<Key> & keys) {
+        size_t count = 0;
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+          count += c.erase(*it);
+        }
+        return count;
+      }
+
+      /// insert keys into the local store.  returns the number of new keys.
+      template <class InputIterator>
+      size_t local_insert(InputIterator first, InputIterator last) {
+        size_t before = c.size();
+        this->local_reserve(before + ::std::distance(first, last));
+        c.insert(first, last);
+        return c.size() - before;
+      }
+
+      virtual void local_reset() noexcept {
+        local_container_type tmp; tmp.swap(c);
+      }
+
+      virtual void local_clear() noexcept {
+        c.clear();
+      }
+
+      /// reserve space for n keys.  this allows different processes to individually adjust their own size.
+      virtual void local_reserve(size_t n) {
+        c.reserve(n);
+      }
+
+      /// insert saved keys.
+      virtual void local_load(::std::pair<Key, bool> const * first, size_t count) {
+        ::std::vector<Key> ks;
+        ks.reserve(count);
+        for (size_t i = 0; i < count; ++i) ks.emplace_back(first[i].first);
+        this->local_insert(ks.begin(), ks.end());
+      }
+
+      /// send a chunk of loaded keys to their owners and insert them.  collective.
+      virtual void repartition_chunk(::std::vector<::std::pair<Key, bool> > & chunk) {
+        ::std::vector<Key> ks;
+        ks.reserve(chunk.size());
+        for (auto it = chunk.begin(); it != chunk.end(); ++it) ks.emplace_back(it->first);
+        this->insert(ks);
+      }
+
+    public:
+      set_base(const mxx::comm& _comm) : Base(_comm), key_to_rank(_comm.size()) {}
+
+      virtual ~set_base() {};
+
+      /// returns the local storage.  please use sparingly.
+      local_container_type& get_local_container() { return c; }
+      local_container_type const & get_local_container() const { return c; }
+
+      const_iterator cbegin() const {
+        return c.cbegin();
+      }
+
+      const_iterator cend() const {
+        return c.cend();
+      }
+
+      /// call fn(key, thread_id) for each local key, with the local storage split into per-thread ranges.
+      /// fn is called concurrently.  see containers/parallel_for_each.hpp
+      template <typename F>
+      void parallel_for_each_local(F fn, int const nthreads = 0) const {
+        ::fsc::parallel_for_each(c, fn, nthreads);
+      }
+
+      /**
+       * @brief insert keys.  duplicates are removed before the exchange, and only keys are sent.  collective.
+       * @return number of new keys on this rank.
+       */
+      size_t insert(::std::vector<Key>& input, bool sorted_input = false) {
+        BL_BENCH_INIT(insert);
+
+        if (::dsc::empty(input, this->comm)) {
+          BL_BENCH_REPORT_MPI_NAMED(insert, "set:insert", this->comm);
+          return 0;
+        }
+
+        BL_BENCH_START(insert);
+        this->prepare_keys(input, sorted_input);
+        BL_BENCH_END(insert, "transform_unique", input.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(insert, "dist_data", this->comm);
+          ::std::vector<size_t> recv_counts;
+          ::std::vector<Key> buffer;
+          this->distribute_keys(input, this->key_to_rank, recv_counts, buffer);
+          input.swap(buffer);
+          BL_BENCH_END(insert, "dist_data", input.size());
+        }
+
+        BL_BENCH_START(insert);
+        size_t count = this->local_insert(input.begin(), input.end());
+        BL_BENCH_END(insert, "insert", this->c.size());
+
+        BL_BENCH_REPORT_MPI_NAMED(insert, "set:insert", this->comm);
+        return count;
+      }
+
+      /**
+       * @brief presence of the keys:  (key, 1) if in the set, else (key, 0).  duplicate queries are answered once.  collective.
+       * @details  keys is replaced by the queries this rank answered.
+       */
+      ::std::vector<::std::pair<Key, size_type> > count(::std::vector<Key>& keys, bool sorted_input = false) const {
+        BL_BENCH_INIT(count);
+        ::std::vector<::std::pair<Key, size_type> > results;
+
+        if (::dsc::empty(keys, this->comm)) {
+          BL_BENCH_REPORT_MPI_NAMED(count, "set:count", this->comm);
+          return results;
+        }
+
+        BL_BENCH_START(count);
+        this->prepare_keys(keys, sorted_input);
+        BL_BENCH_END(count, "transform_unique", keys.size());
+
+        ::std::vector<size_t> recv_counts;
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(count, "dist_query", this->comm);
+          ::std::vector<size_t> i2o;
+          ::std::vector<Key> buffer;
+          this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
+          keys.swap(buffer);
+          BL_BENCH_END(count, "dist_query", keys.size());
+        }
+
+        BL_BENCH_START(count);
+        results.reserve(keys.size());
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+          results.emplace_back(*it, c.count(*it));
+        }
+        BL_BENCH_END(count, "local_count", results.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(count, "a2a2", this->comm);
+          this->all2allv(results, recv_counts).swap(results);
+          BL_BENCH_END(count, "a2a2", results.size());
+        }
+
+        BL_BENCH_REPORT_MPI_NAMED(count, "set:count", this->comm);
+        return results;
+      }
+
+      /**
+       * @brief the query keys that are in the set, each once.  only the found keys are sent back.  collective.
+       * @details  keys is replaced by the queries this rank answered.
+       */
+      ::std::vector<Key> find(::std::vector<Key>& keys, bool sorted_input = false) const {
+        BL_BENCH_INIT(find);
+        ::std::vector<Key> results;
+
+        if (this->nothing_to_query(keys)) {
+          BL_BENCH_REPORT_MPI_NAMED(find, "set:find", this->comm);
+          return results;
+        }
+
+        BL_BENCH_START(find);
+        this->prepare_keys(keys, sorted_input);
+        BL_BENCH_END(find, "transform_unique", keys.size());
+
+        ::std::vector<size_t> recv_counts(1, keys.size());
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(find, "dist_query", this->comm);
+          this->distribute_queries(keys, this->key_to_rank, recv_counts);
+          BL_BENCH_END(find, "dist_query", keys.size());
+        }
+
+        // found keys, in the order of the source ranks.
+        BL_BENCH_START(find);
+        ::std::vector<size_t> send_counts(recv_counts.size(), 0);
+        results.reserve(keys.size());
+        auto it = keys.begin();
+        for (size_t i = 0; i < recv_counts.size(); ++i) {
+          for (size_t j = 0; j < recv_counts[i]; ++j, ++it) {
+            if (c.count(*it) > 0) {
+              results.emplace_back(*it);
+              ++send_counts[i];
+            }
+          }
+        }
+        BL_BENCH_END(find, "local_find", results.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(find, "a2a2", this->comm);
+          this->all2allv(results, send_counts).swap(results);
+          BL_BENCH_END(find, "a2a2", results.size());
+        }
+
+        BL_BENCH_REPORT_MPI_NAMED(find, "set:find", this->comm);
+        return results;
+      }
+
+      /**
+       * @brief presence of each key, aligned to keys:  result i is 1 if keys[i] is in the set, else 0.  collective.
+       * @details  replies carry the presence only, and are put back in query order.  keys is not modified.
+       */
+      ::std::vector<size_type> count_aligned(::std::vector<Key> const & keys) const {
+        return this->template aligned_query<size_type>(keys, this->key_to_rank,
+            [this](typename ::std::vector<Key>::const_iterator first, typename ::std::vector<Key>::const_iterator last,
+                   typename ::std::vector<size_type>::iterator out) {
+              for (; first != last; ++first, ++out) *out = this->c.count(*first);
+            });
+      }
+
+      /**
+       * @brief erase keys.  only keys are sent.  collective.
+       * @return number of keys removed on this rank.
+       */
+      size_t erase(::std::vector<Key>& keys, bool sorted_input = false) {
+        BL_BENCH_INIT(erase);
+
+        if (this->nothing_to_query(keys)) {
+          BL_BENCH_REPORT_MPI_NAMED(erase, "set:erase", this->comm);
+          return 0;
+        }
+
+        BL_BENCH_START(erase);
+        this->prepare_keys(keys, sorted_input);
+        BL_BENCH_END(erase, "transform_unique", keys.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_COLLECTIVE_START(erase, "dist_query", this->comm);
+          ::std::vector<size_t> recv_counts;
+          ::std::vector<Key> buffer;
+          this->distribute_keys(keys, this->key_to_rank, recv_counts, buffer);
+          keys.swap(buffer);
+          BL_BENCH_END(erase, "dist_query", keys.size());
+        }
+
+        BL_BENCH_START(erase);
+        size_t count = this->local_erase(keys);
+        BL_BENCH_END(erase, "erase", count);
+
+        BL_BENCH_REPORT_MPI_NAMED(erase, "set:erase", this->comm);
+        return count;
+      }
+
+      // ================  overrides
+
+      /// (key, true) for each local key.
+      virtual void to_vector(std::vector<std::pair<Key, bool> > & result) const {
+        result.clear();
+        result.reserve(c.size());
+        for (auto it = c.begin(); it != c.end(); ++it) {
+          result.emplace_back(*it, true);
+        }
+      }
+
+      /// the local keys.
+      virtual void keys(std::vector<Key> & result) const {
+        result.assign(c.begin(), c.end());
+      }
+
+      using Base::to_vector;
+      using Base::keys;
+
+      virtual bool local_empty() const {
+        return this->c.empty();
+      }
+
+      virtual size_t local_size() const {
+        return this->c.size();
+      }
+
+      virtual size_t local_unique_size() const {
+        return this->c.size();
+      }
+
+      virtual float get_multiplicity() const {
+        return 1.0f;
+      }
+  };
+
+
+  /// distributed set with std::unordered_set as the local store.
+  template<typename Key, template <typename> class MapParams,
+  class Alloc = ::std::allocator<Key> >
+  class unordered_set : public set_base<Key,
+    ::std::unordered_set<Key, typename MapParams<Key>::StorageTransformedFunction, typename MapParams<Key>::StorageTransformedEqual, Alloc>,
+    MapParams> {
+    protected:
+      using Base = set_base<Key,
+          ::std::unordered_set<Key, typename MapParams<Key>::StorageTransformedFunction, typename MapParams<Key>::StorageTransformedEqual, Alloc>,
+          MapParams>;
+
+      /// reserve buckets for n keys.
+      virtual void local_reserve(size_t n) {
+        size_t buckets = std::ceil(static_cast<float>(n) / this->c.max_load_factor());
+        if (this->c.bucket_count() < buckets) this->c.rehash(buckets);
+      }
+
+    public:
+      unordered_set(const mxx::comm& _comm) : Base(_comm) {}
+
+      virtual ~unordered_set() {};
+  };
+
+
+  /// local store types for densehash_set and sorted_set.
+  template <typename Key, template <typename> class MapParams>
+  struct set_storage {
+      template <typename K>
+      using StoreTrans = typename MapParams<Key>::template StorageTransform<K>;
+      template <typename K>
+      using StoreEqual = typename MapParams<Key>::template StorageEqual<K>;
+
+      template <typename SpecialKeys, class Alloc>
+      using densehash = ::fsc::densehash_set<Key, SpecialKeys, StoreTrans,
+          typename MapParams<Key>::StorageTransformedFunction,
+          ::fsc::sparsehash::compare<Key, StoreEqual, StoreTrans>, Alloc>;
+
+      template <class Alloc>
+      using sorted = sorted_key_vector<Key, ::fsc::TransformedComparator<Key, ::std::less, StoreTrans>,
+          typename MapParams<Key>::StorageTransformedEqual, Alloc>;
+  };
+
+
+  /**
+   * @brief distributed set with a google dense_hash_set as the local store.
+   * @tparam SpecialKeys  empty and deleted keys, as for densehash_map, e.g. ::bliss::kmer::hash::sparsehash::special_keys.
+   */
+  template<typename Key, template <typename> class MapParams,
+    typename SpecialKeys = ::fsc::sparsehash::special_keys<Key>,
+    class Alloc = ::std::allocator<Key> >
+  class densehash_set : public set_base<Key,
+    typename set_storage<Key, MapParams>::template densehash<SpecialKeys, Alloc>, MapParams> {
+    protected:
+      using Base = set_base<Key, typename set_storage<Key, MapParams>::template densehash<SpecialKeys, Alloc>, MapParams>;
+
+    public:
+      densehash_set(const mxx::comm& _comm) : Base(_comm) {}
+
+      virtual ~densehash_set() {};
+  };
+
+
+  /**
+   * @brief distributed set with a sorted vector of unique keys as the local store.  the smallest of the 3 sets.
+   * @details  keys are assigned to ranks by hash, as for the other sets.  the local keys are in storage transform order.
+   */
+  template<typename Key, template <typename> class MapParams,
+    class Alloc = ::std::allocator<Key> >
+  class sorted_set : public set_base<Key,
+    typename set_storage<Key, MapParams>::template sorted<Alloc>, MapParams> {
+    protected:
+      using Base = set_base<Key, typename set_storage<Key, MapParams>::template sorted<Alloc>, MapParams>;
+
+      /// 1 pass over the store instead of 1 per key.
+      virtual size_t local_erase(::std::vector<Key> & keys) {
+        return this->c.erase(keys);
+      }
+
+    public:
+      sorted_set(const mxx::comm& _comm) : Base(_comm) {}
+
+      virtual ~sorted_set() {};
+  };
+
+} /* namespace dsc */
+
+#endif // BLISS_DISTRIBUTED_SET_HPP
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    distributed_snapshot_map.hpp
+ * @ingroup dsc::containers
+ * @brief   distributed map that answers queries from the last published generation while the next one is inserted.
+ * @details find and insert of a distributed map are collectives over the same table, so a live index stops answering
+ *          queries while a batch is inserted.  snapshot_map keeps 2 maps of the same type:  the published snapshot, which
+ *          answers the queries, and the pending delta, which receives the inserts.  a query never sees part of a batch.
+ *
+ *          publish() is the collective sync point.  it merges the delta into the snapshot, with the map's merge:  the
+ *          2 maps are co-partitioned, so the merge is local, its cost is that of the delta and not of the index, and
+ *          reduction maps combine the values as insert would.  discard() drops the delta instead.
+ *
+ *          each map has its own copy of the communicator, and all collectives of a map's inserts and queries, including
+ *          the empty checks of the imxx exchanges, run on its communicator.  between publishes, queries and inserts can
+ *          therefore be interleaved on 1 thread in any order, e.g. an insert batch between 2 query windows, or run on 2
+ *          threads if MPI provides MPI_THREAD_MULTIPLE (see concurrent_ok()).  publish() and discard() must not overlap
+ *          a query.
+ */
+#ifndef SRC_CONTAINERS_DISTRIBUTED_SNAPSHOT_MAP_HPP_
+#define SRC_CONTAINERS_DISTRIBUTED_SNAPSHOT_MAP_HPP_
+
+#include <utility>   // forward, declval
+#include <cstddef>
+
+#include <mxx/comm.hpp>
+
+namespace dsc  // distributed std container
+{
+
+  /**
+   * @brief  published snapshot plus pending delta of a distributed map.  see file description.
+   * @tparam Map  distributed map with merge, e.g. densehash_map or counting_unordered_map.
+   */
+  template <typename Map>
+  class snapshot_map {
+
+    protected:
+      /// communicators of the 2 maps.  declared first:  the maps keep references.
+      ::mxx::comm query_comm;
+      ::mxx::comm ingest_comm;
+
+      /// answers the queries.
+      Map published;
+      /// receives the inserts until the next publish.
+      Map pending;
+
+      /// number of publishes so far.
+      size_t gen;
+
+    public:
+      /**
+       * @param _comm  communicator to copy for the 2 maps.
+       * @param args   further constructor arguments of Map, given to both maps.
+       */
+      template <typename... Args>
+      snapshot_map(const ::mxx::comm& _comm, Args const &... args) :
+        query_comm(_comm.copy()), ingest_comm(_comm.copy()),
+        published(query_comm, args...), pending(ingest_comm, args...), gen(0) {}
+
+      snapshot_map(snapshot_map const & other) = delete;
+      snapshot_map & operator=(snapshot_map const & other) = delete;
+
+      /// true if queries and inserts can run on different threads.
+      static bool concurrent_ok() {
+        int provided = MPI_THREAD_SINGLE;
+        MPI_Query_thread(&provided);
+        return provided == MPI_THREAD_MULTIPLE;
+      }
+
+      /// insert into the pending delta, as Map::insert.  collective over the ingest communicator.
+      template <typename... Args>
+      auto insert(Args&&... args) -> decltype(::std::declval<Map &>().insert(::std::forward<Args>(args)...)) {
+        return pending.insert(::std::forward<Args>(args)...);
+      }
+
+      /// query the published snapshot, as Map::find.  collective over the query communicator.
+      template <typename... Args>
+      auto find(Args&&... args) const -> decltype(::std::declval<Map const &>().find(::std::forward<Args>(args)...)) {
+        return published.find(::std::forward<Args>(args)...);
+      }
+
+      /// query the published snapshot, as Map::count.  collective over the query communicator.
+      template <typename... Args>
+      auto count(Args&&... args) const -> decltype(::std::declval<Map const &>().count(::std::forward<Args>(args)...)) {
+        return published.count(::std::forward<Args>(args)...);
+      }
+
+      /**
+       * @brief  make the pending inserts visible to queries.  collective, and not concurrent with a query.
+       * @return number of local entries added to the snapshot.
+       */
+      size_t publish() {
+        size_t added = published.merge(pending);
+        pending.clear();
+        ++gen;
+        return added;
+      }
+
+      /// drop the pending inserts.  collective.
+      void discard() {
+        pending.clear();
+      }
+
+      /// number of publishes so far.
+      size_t generation() const {
+        return gen;
+      }
+
+      /// the published snapshot, for the other queries of Map.
+      Map const & snapshot() const {
+        return published;
+      }
+
+      /// the pending delta, e.g. for an insert_buffer or a build that takes a map.
+      Map & delta() {
+        return pending;
+      }
+  };
+
+} /* namespace dsc */
+
+#endif /* SRC_CONTAINERS_DISTRIBUTED_SNAPSHOT_MAP_HPP_ */
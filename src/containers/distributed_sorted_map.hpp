@@ -22,6 +22,7 @@
  *          data structures.
  *
  *          implementation is sort-based (load balanced).  assumption is that map is built once.
+ *          for repeated appends, see set_merge_insert and set_delta_runs.
  *          distribution is via sort.  local storage is via hash.
  *
  *          for now, input and output via local vectors.
@@ -63,8 +64,12 @@
 #include "utils/filter_utils.hpp"
 
 #include "containers/distributed_map_base.hpp"
+#include "containers/eytzinger_index.hpp"
+#include "containers/radix_index.hpp"
+#include "containers/prefix_block_array.hpp"
 #include "common/kmer_transform.hpp"
 #include "containers/dsc_container_utils.hpp"
+#include "containers/parallel_for_each.hpp"
 #include "io/incremental_mxx.hpp"
 
 
@@ -302,6 +307,49 @@ using SortedMapParams = ::dsc::DistributedMapParams<
               return count;
           }
 
+          /**
+           * @brief as process, for read only operators (find, count).  each query first jumps to its lower bound from
+           *        index, which covers the local container from db_offset positions before range_begin, so the
+           *        operator's own search is a linear step.
+           */
+          template <class Index, class DBIter, class QueryIter, class OutputIter, class Operator, class Predicate = ::bliss::filter::TruePredicate>
+          static size_t process_indexed(Index const & index, size_t const db_offset,
+                                        DBIter range_begin, DBIter range_end,
+                                        QueryIter query_begin, QueryIter query_end,
+                                        OutputIter &output, Operator & op,
+                                        bool sorted_query = false, Predicate const &pred = Predicate()) {
+              if (range_begin == range_end) return 0;
+              if (query_begin == query_end) return 0;  // no input
+
+              if (!sorted_query)
+                ::std::sort(query_begin, query_end, typename Base::StoreTransformedFunc());
+
+              DBIter const db_begin = range_begin - db_offset;
+              size_t const range_last = db_offset + ::std::distance(range_begin, range_end);
+
+              auto el_end = range_begin;
+              size_t count = 0;
+              typename ::std::iterator_traits<QueryIter>::value_type v;
+
+              for (auto it = query_begin; it != query_end;) {
+                v = *it;
+
+                // queries are sorted, so el_end only moves forward.
+                size_t pos = ::std::min(index.lower_bound(db_begin, v), range_last);
+                if (db_begin + pos > el_end) el_end = db_begin + pos;
+
+                if (::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
+                  count += op.template operator()<true>(range_begin, el_end, range_end, v, output);
+                else
+                  count += op.template operator()<true>(range_begin, el_end, range_end, v, output, pred);
+
+                if (skip_duplicate_query) it = ::fsc::upper_bound<true>(it, query_end, v, typename Base::StoreTransformedFunc());
+                else ++it;
+              }
+
+              return count;
+          }
+
       };
 
 
@@ -343,6 +391,40 @@ using SortedMapParams = ::dsc::DistributedMapParams<
        */
       bool sorted;   // this is a local variable.
 
+      /// flag indicating keys were added locally since the query key filter was built.  changed by insert() and find()/count().
+      mutable bool keys_added;
+
+      /// max/mean local size above which a merge insert marks the map unbalanced.  0 disables merge insert.
+      double merge_imbalance;
+
+      /// sorted runs of entries inserted since the last fold, routed by the current splitters.  see set_delta_runs.
+      ::std::vector<local_container_type> deltas;
+      /// number of delta runs above which they are folded into the local container.  0 disables delta runs.
+      size_t max_delta_runs;
+      /// a run is merged into the next older one while that is at most this many times its size.  see compact_delta_runs.
+      static constexpr size_t delta_run_ratio = 2;
+
+      /// Eytzinger tree over every stride-th key of the sorted local container, for find and count.  see set_lookup_index.
+      mutable ::fsc::eytzinger_index<Key, typename Base::StoreTransformedFunc> lookup_index;
+      /// storage that lookup_index was built for.  a different buffer means the container was replaced.
+      mutable ::std::pair<Key, T> const * indexed_data;
+      /// elements per lookup_index sample.  0 disables the index.
+      size_t lookup_stride;
+
+      /// radix keys in radix order:  find and count can predict positions from the top key bits.  see set_radix_lookup.
+      static constexpr bool radix_lookup_supported =
+          ::fsc::detail::radix_sortable<::std::pair<Key, T>, typename Base::StoreTransformedFunc>::value;
+      /// table over the top key bits of the sorted local container.  shares indexed_data with lookup_index.
+      mutable ::fsc::radix_index<Key, typename Base::StoreTransformedFunc, radix_lookup_supported> radix_lookup;
+      /// use radix_lookup instead of lookup_index, with 2^radix_lookup_bits buckets (0: about 4 entries per bucket).
+      bool use_radix_lookup;
+      unsigned int radix_lookup_bits;
+
+      /// the local container as prefix compressed blocks, for static maps.  c is empty while this is not.  see sorted_map::compress.
+      ::fsc::prefix_block_array<Key, T, typename Base::StoreTransformedFunc> packed;
+      /// the block of packed that a query decoded last.
+      mutable local_container_type packed_block;
+
 
       // =========== accessors to change the local state of the container
       void set_balanced(bool v) const {
@@ -498,7 +580,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
           BL_BENCH_INIT(find);
           ::std::vector<::std::pair<Key, T> > results;
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(find, "base_sorted_map:find_overlap", this->comm);
             return results;
           }
@@ -522,13 +604,22 @@ using SortedMapParams = ::dsc::DistributedMapParams<
               this->redistribute();
               BL_BENCH_END(find, "global_sort", this->local_size());
 
+              // drop the sure misses.  order is preserved, so keys stay sorted.
+              BL_BENCH_COLLECTIVE_START(find, "key_filter", this->comm);
+              if (this->refresh_key_filter(this->keys_added, this->c.begin(), this->c.end(), this->c.size())) {
+                this->keys_added = false;
+                std::vector<Key> misses;
+                this->drop_key_filter_misses(keys, misses);
+              }
+              BL_BENCH_END(find, "key_filter", keys.size());
+
               BL_BENCH_COLLECTIVE_START(find, "dist_query", this->comm);
             // distribute (communication part)
             std::vector<size_t> recv_counts;
             {
 				std::vector<size_t> i2o;
 				std::vector<Key > buffer;
-				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+				this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
 				keys.swap(buffer);
 //      		  ::dsc::distribute_sorted_unique(keys, this->key_to_rank, sorted_input, this->comm,
 //      				  typename Base::StoreTransformedFunc(),
@@ -556,7 +647,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
               count_results.clear();
               auto overlap = QueryProcessor<false>::intersect(this->c.begin(), this->c.end(), start, end,
             		  sorted_input);
-              QueryProcessor<false>::process(overlap.first, overlap.second, start, end,
+              this->template local_query<false>(overlap.first, overlap.second, start, end,
             		  count_emplace_iter, count_element, sorted_input, pred);
               send_counts[i] = ::std::accumulate(count_results.begin(), count_results.end(), static_cast<size_t>(0),
                                                  [](size_t v, ::std::pair<Key, size_t> const & x) {
@@ -624,7 +715,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
               // work on query from process i.
               auto overlap = QueryProcessor<false>::intersect(this->c.begin(), this->c.end(),
             		  start, end, sorted_input);
-              found = QueryProcessor<false>::process(overlap.first, overlap.second,
+              found = this->template local_query<false>(overlap.first, overlap.second,
             		  start, end, local_results_iter, lf, sorted_input, pred);
               total += found;
               //== now send the results immediately - minimizing data usage so we need to wait for both send and recv to complete right now.
@@ -671,7 +762,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             // count now.
             auto overlap = QueryProcessor<false>::intersect(this->c.begin(), this->c.end(),
             		keys.begin(), keys.end(), sorted_input);
-            QueryProcessor<false>::process(overlap.first, overlap.second,
+            this->template local_query<false>(overlap.first, overlap.second,
             		keys.begin(), keys.end(), count_emplace_iter, count_element, sorted_input, pred);
             size_t count = ::std::accumulate(count_results.begin(), count_results.end(), static_cast<size_t>(0),
                                           [](size_t v, ::std::pair<Key, size_t> const & x) {
@@ -686,7 +777,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
             BL_BENCH_START(find);
             // within start-end, values are unique, so don't need to set unique to true.
-            QueryProcessor<false>::process(overlap.first, overlap.second,
+            this->template local_query<false>(overlap.first, overlap.second,
             		keys.begin(), keys.end(), emplace_iter, lf, sorted_input, pred);
             BL_BENCH_END(find, "local_find", results.size());
 
@@ -709,9 +800,12 @@ using SortedMapParams = ::dsc::DistributedMapParams<
     		  Predicate const& pred = Predicate() ) const {
 
           BL_BENCH_INIT(find);
+          typename Base::tracked_query tracked(*this);
           ::std::vector<::std::pair<Key, T> > results;
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          bool const nothing = this->nothing_to_query(keys);
+          tracked.mark(::fsc::query_latency_tracker::exchange);
+          if (nothing) {
             BL_BENCH_REPORT_MPI_NAMED(find, "base_sorted_map:find", this->comm);
             return results;
           }
@@ -736,25 +830,36 @@ using SortedMapParams = ::dsc::DistributedMapParams<
               this->redistribute();
               BL_BENCH_END(find, "global_sort", this->local_size());
 
+              // drop the sure misses.  order is preserved, so keys stay sorted.
+              BL_BENCH_COLLECTIVE_START(find, "key_filter", this->comm);
+              if (this->refresh_key_filter(this->keys_added, this->c.begin(), this->c.end(), this->c.size())) {
+                this->keys_added = false;
+                std::vector<Key> misses;
+                this->drop_key_filter_misses(keys, misses);
+              }
+              BL_BENCH_END(find, "key_filter", keys.size());
+              tracked.mark(::fsc::query_latency_tracker::bucketing);
+
               BL_BENCH_COLLECTIVE_START(find, "dist_query", this->comm);
             // distribute (communication part)
             std::vector<size_t> recv_counts;
             {
 				std::vector<size_t> i2o;
 				std::vector<Key > buffer;
-				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+				this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
 				keys.swap(buffer);
 //      		  ::dsc::distribute_sorted_unique(keys, this->key_to_rank, sorted_input, this->comm,
 //      				  typename Base::StoreTransformedFunc(),
 //      				  typename Base::StoreTransformedEqual()).swap(recv_counts);
             }
             BL_BENCH_END(find, "dist_query", keys.size());
+            tracked.mark(::fsc::query_latency_tracker::exchange);
 
             // local find. memory utilization a potential problem.
             // do for each src proc one at a time.
             BL_BENCH_START(find);
             float multi = this->get_multiplicity();
-            if (this->comm.rank() == 0) printf("rank %d multiplicity %f\n", this->comm.rank(), multi);
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d multiplicity %f", this->comm.rank(), multi);
             results.reserve(keys.size() * multi);                   // TODO:  should estimate coverage.
             BL_BENCH_END(find, "reserve", results.capacity());
 
@@ -776,7 +881,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
                     static_cast<double>(req_sofar)) *
                                     static_cast<double>(req_total) * 1.1f);
                 if (new_est > results.capacity()) {
-                  if (this->comm.rank() == 0) printf("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu\n", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
+                  if (this->comm.rank() == 0) BL_DEBUGF("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
                   results.reserve(new_est);  // if new_est is lower than capacity, nothing happens.
                 }
               }
@@ -786,18 +891,20 @@ using SortedMapParams = ::dsc::DistributedMapParams<
               auto overlap = QueryProcessor<false>::intersect(this->c.begin(), this->c.end(), start, end, sorted_input);
 
               // within start-end, values are unique, so don't need to set unique to true.
-              send_counts[i] = QueryProcessor<false>::process(overlap.first, overlap.second,
+              send_counts[i] = this->template local_query<false>(overlap.first, overlap.second,
             		  start, end, emplace_iter, lf, sorted_input, pred);
 
               start = end;
             }
             BL_BENCH_END(find, "local_find", results.size());
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
+            tracked.mark(::fsc::query_latency_tracker::lookup);
 
             // send back using the constructed recv count
             BL_BENCH_COLLECTIVE_START(find, "a2a2", this->comm);
-            mxx::all2allv(results, send_counts, this->comm).swap(results);
+            this->all2allv(results, send_counts).swap(results);
             BL_BENCH_END(find, "a2a2", results.size());
+            tracked.mark(::fsc::query_latency_tracker::reply);
 
           } else {
         	  // ensure data is sorted locally.
@@ -805,6 +912,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
               BL_BENCH_COLLECTIVE_START(find, "local_sort", this->comm);
               this->local_sort();
               BL_BENCH_END(find, "local_sort", this->local_size());
+              tracked.mark(::fsc::query_latency_tracker::bucketing);
 
 //
 //              // keep unique keys
@@ -828,7 +936,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             auto overlap = QueryProcessor<false>::intersect(this->c.begin(), this->c.end(),
             		keys.begin(), keys.begin() + estimating, sorted_input);
 
-            QueryProcessor<false>::process(overlap.first, overlap.second, keys.begin(), keys.begin() + estimating,
+            this->template local_query<false>(overlap.first, overlap.second, keys.begin(), keys.begin() + estimating,
             		emplace_iter, lf, sorted_input, pred);
             BL_BENCH_END(find, "local_find_0.1", estimating);
 
@@ -841,11 +949,12 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             overlap = QueryProcessor<false>::intersect(this->c.begin(), this->c.end(),
             		keys.begin() + estimating, keys.end(), sorted_input);
 
-            QueryProcessor<false>::process(overlap.first, overlap.second, keys.begin() + estimating, keys.end(),
+            this->template local_query<false>(overlap.first, overlap.second, keys.begin() + estimating, keys.end(),
             		emplace_iter, lf, sorted_input, pred);
             BL_BENCH_END(find, "local_find", results.size());
+            tracked.mark(::fsc::query_latency_tracker::lookup);
 
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
 
 
           }
@@ -878,7 +987,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, size_t> > > count_emplace_iter(count_results);
 
             // count now.
-            QueryProcessor<false>::process(this->c.begin(), this->c.end(),
+            this->template local_query<false>(this->c.begin(), this->c.end(),
                 keys.begin(), keys.end(), count_emplace_iter, count_element, true, pred);
             size_t count = ::std::accumulate(count_results.begin(), count_results.end(), static_cast<size_t>(0),
                                              [](size_t v, ::std::pair<Key, size_t> const & x) {
@@ -887,7 +996,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             results.reserve(count);  // 1 result per key.
 
             // within start-end, values are unique, so don't need to set unique to true.
-            QueryProcessor<false>::process(this->c.begin(), this->c.end(),
+            this->template local_query<false>(this->c.begin(), this->c.end(),
                 keys.begin(), keys.end(), emplace_iter, lf, true, pred);
           }
           if (this->comm.size() > 1) this->comm.barrier();
@@ -901,7 +1010,9 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
       /// constructor
       sorted_map_base(const mxx::comm& _comm) : Base(_comm),
-          key_to_rank(_comm.size()), balanced(false), globally_sorted(false), sorted(false) {}
+          key_to_rank(_comm.size()), balanced(false), globally_sorted(false), sorted(false), keys_added(false),
+          merge_imbalance(0.0), max_delta_runs(0), indexed_data(nullptr), lookup_stride(0),
+          use_radix_lookup(false), radix_lookup_bits(0) {}
 
       // ===================  sorted map specific virtual functions
       /// ensures container is globally sorted/organized and balanced, and splitters are capatured.  also ensures local sortedness.
@@ -914,14 +1025,27 @@ using SortedMapParams = ::dsc::DistributedMapParams<
       // clears the sorted map and release memory.
       virtual void local_reset() {
         local_container_type tmp; tmp.swap(c);
+        ::std::vector<local_container_type>().swap(deltas);
+        packed.clear();
+        local_container_type().swap(packed_block);
+        this->invalidate_lookup_index();
 
         this->sorted = true;
         this->set_balanced(false);
       }
 
+      /// drop the spare capacity of the local vector and of the delta runs.  see map_base::release_memory.
+      virtual void local_shrink() {
+        c.shrink_to_fit();
+        for (auto & d : deltas) d.shrink_to_fit();
+      }
+
       /// clears the sorted_map
       virtual void local_clear() {
         c.clear();
+        deltas.clear();
+        packed.clear();
+        this->invalidate_lookup_index();
 
         this->sorted = true;
         this->set_balanced(false);
@@ -933,11 +1057,65 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         c.reserve(n);
       }
 
+      /// copy in saved entries.  global order and balance are recomputed on the next query.  entries saved in order, e.g.
+      /// by a redistributed sorted map, are not sorted again.
+      virtual void local_load(::std::pair<Key, T> const * first, size_t count) {
+        typename Base::StoreTransformedFunc less;
+        bool in_order = true;
+        if (count > 1) {
+          ::std::vector<char> ordered(::fsc::parallel_for_each_threads(0), 1);
+          ::fsc::parallel_for_ranges(count - 1, [first, &less, &ordered](size_t b, size_t e, int tid) {
+            for (; b < e; ++b) {
+              if (less(first[b + 1], first[b])) { ordered[tid] = 0; return; }
+            }
+          });
+          in_order = ::std::all_of(ordered.begin(), ordered.end(), [](char x) { return x != 0; });
+        }
+
+        this->local_bulk_load(first, count);
+        this->sorted = in_order;
+      }
+
+      /**
+       * @brief replace the local entries with count entries, sorted by the store comparator, e.g. the output of a local
+       *        reduction or a snapshot of a sorted map.  local.  the next query does not sort them again.
+       * @details copied in per-thread ranges.  global order and balance are recomputed on the next query.
+       */
+      void local_bulk_load(::std::pair<Key, T> const * first, size_t count) {
+        packed.clear();
+        deltas.clear();
+        this->invalidate_lookup_index();
+
+        c.resize(count);
+        ::fsc::parallel_for_ranges(count, [this, first](size_t b, size_t e, int) {
+          ::std::copy(first + b, first + e, c.begin() + b);
+        });
+
+        this->sorted = true;
+        this->set_balanced(false);
+        this->set_globally_sorted(false);
+        this->keys_added = true;
+      }
+
+      /// loaded entries stay on the rank that read them.  like local_load, balance and global order are restored by
+      /// redistribute on the next query, so nothing is sent twice.  see load_repartition.
+      virtual void repartition_chunk(::std::vector<::std::pair<Key, T> > & chunk) {
+        this->local_decompress();
+        c.insert(c.end(), chunk.begin(), chunk.end());
+
+        this->sorted = false;
+        this->set_balanced(false);
+        this->set_globally_sorted(false);
+        this->keys_added = true;
+      }
+
 
       // ==================== sorted vector specific functions.
 
       /// rehash the local container.  n is the local container size.  this allows different processes to individually adjust its own size.
       void local_sort() {
+        this->local_fold_deltas();
+        if (!sorted) this->invalidate_lookup_index();
         ::fsc::sort(c, sorted, typename Base::StoreTransformedFunc());
       }
 
@@ -946,6 +1124,347 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         const_cast<typename std::remove_cv<typename std::remove_reference<decltype(*this)>::type>::type *>(this)->local_sort();
       }
 
+      /// reduce entries with equal keys.  the multimap keeps all of them.  maps override this.
+      virtual void local_reduction(::std::vector<::std::pair<Key, T> > &input, bool sorted_input = false) {
+        ::fsc::sort(input, sorted_input, typename Base::StoreTransformedFunc());
+      }
+
+      /// drop lookup_index and radix_lookup after the local container changed in place.
+      void invalidate_lookup_index() const {
+        if (!lookup_index.empty()) lookup_index.clear();
+        if (!radix_lookup.empty()) radix_lookup.clear();
+      }
+
+      /// true if lookup_index is enabled and describes the local container, building it if needed.
+      bool refresh_lookup_index() const {
+        if ((lookup_stride == 0) || (radix_lookup_supported && use_radix_lookup) || !this->sorted || c.empty()) return false;
+
+        if ((lookup_index.size() != c.size()) || (indexed_data != c.data())) {
+          lookup_index.build(c.begin(), c.end(), lookup_stride);
+          indexed_data = c.data();
+        }
+        return true;
+      }
+
+      /// true if radix_lookup is enabled and describes the local container, building it if needed.
+      bool refresh_radix_lookup() const {
+        if (!radix_lookup_supported || !use_radix_lookup || !this->sorted || c.empty()) return false;
+
+        if ((radix_lookup.size() != c.size()) || (indexed_data != c.data())) {
+          radix_lookup.build(c.begin(), c.end(), radix_lookup_bits);
+          indexed_data = c.data();
+        }
+        return true;
+      }
+
+      /// QueryProcessor::process over a range of the local container, via radix_lookup or lookup_index if enabled.  read only operators.
+      template <bool skip_duplicate_query, class DBIter, class QueryIter, class OutputIter, class Operator, class Predicate>
+      size_t local_query(DBIter range_begin, DBIter range_end, QueryIter query_begin, QueryIter query_end,
+                         OutputIter &output, Operator & op, bool sorted_query, Predicate const &pred) const {
+        if (!packed.empty())
+          return this->template packed_query<skip_duplicate_query>(query_begin, query_end, output, op, sorted_query, pred);
+
+        if (this->refresh_radix_lookup())
+          return QueryProcessor<skip_duplicate_query>::process_indexed(radix_lookup, ::std::distance(c.cbegin(), typename local_container_type::const_iterator(range_begin)),
+                                                                       range_begin, range_end, query_begin, query_end,
+                                                                       output, op, sorted_query, pred);
+
+        if (this->refresh_lookup_index())
+          return QueryProcessor<skip_duplicate_query>::process_indexed(lookup_index, ::std::distance(c.cbegin(), typename local_container_type::const_iterator(range_begin)),
+                                                                       range_begin, range_end, query_begin, query_end,
+                                                                       output, op, sorted_query, pred);
+
+        return QueryProcessor<skip_duplicate_query>::process(range_begin, range_end, query_begin, query_end,
+                                                             output, op, sorted_query, pred);
+      }
+
+      /**
+       * @brief as local_query, over packed instead of the local container.  each query searches the first keys of the
+       *        blocks, and its block is decoded unless the previous query decoded it.  queries are sorted, so each
+       *        block is decoded at most once per call.
+       */
+      template <bool skip_duplicate_query, class QueryIter, class OutputIter, class Operator, class Predicate>
+      size_t packed_query(QueryIter query_begin, QueryIter query_end,
+                          OutputIter &output, Operator & op, bool sorted_query, Predicate const &pred) const {
+        if (query_begin == query_end) return 0;
+
+        if (!sorted_query)
+          ::std::sort(query_begin, query_end, typename Base::StoreTransformedFunc());
+
+        size_t block = packed.blocks();
+        auto range_begin = packed_block.cbegin();
+        auto el_end = range_begin;
+        auto range_end = packed_block.cend();
+        size_t count = 0;
+        typename ::std::iterator_traits<QueryIter>::value_type v;
+
+        for (auto it = query_begin; it != query_end;) {
+          v = *it;
+
+          size_t b = packed.block_of(v);
+          if (b != block) {
+            packed.decode(b, packed_block);
+            block = b;
+            range_begin = packed_block.cbegin();
+            el_end = range_begin;
+            range_end = packed_block.cend();
+          }
+
+          if (::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
+            count += op.template operator()<false>(range_begin, el_end, range_end, v, output);
+          else
+            count += op.template operator()<false>(range_begin, el_end, range_end, v, output, pred);
+
+          if (skip_duplicate_query) it = ::fsc::upper_bound<true>(it, query_end, v, typename Base::StoreTransformedFunc());
+          else ++it;
+        }
+
+        return count;
+      }
+
+      /// store the sorted local container as prefix compressed blocks, and free it.  local.  see sorted_map::compress.
+      void local_compress(size_t block_size) {
+        this->local_merge_deltas();
+        this->local_sort();
+        packed.build(c.begin(), c.end(), block_size);
+        local_container_type().swap(c);
+        this->invalidate_lookup_index();
+      }
+
+      /// true if inserts can be merged into the current global order.  collective.
+      bool can_merge_insert() const {
+        if ((merge_imbalance <= 0.0) && (max_delta_runs == 0)) return false;
+
+        // splitters are exact only if all ranks have data and the front keys are distinct.
+        bool ok = this->sorted && (this->key_to_rank.map.size() == static_cast<size_t>(this->comm.size() - 1));
+        if (this->comm.size() == 1) return ok;
+        return this->is_globally_sorted() && ::mxx::all_of(ok, this->comm);
+      }
+
+      /**
+       * @brief insert into a globally sorted map without a global sort.  collective.
+       * @details the new entries are routed by the current splitters, sorted, and merged into the sorted local
+       *          container, so the global order is kept.  if the largest local container is then more than
+       *          merge_imbalance times the mean, the map is marked unbalanced, and the next redistribute only
+       *          shifts entries between neighbors and recomputes the splitters.
+       * @return number of entries merged into the local container.
+       */
+      template <class Predicate>
+      size_t merge_insert(::std::vector<::std::pair<Key, T> > &input, Predicate const &pred) {
+        typename Base::StoreTransformedFunc store_comp;
+
+        this->route_sorted(input, pred);
+
+        this->invalidate_lookup_index();
+        size_t before = c.size();
+        this->local_reserve(before + input.size());
+        c.insert(c.end(), ::std::make_move_iterator(input.begin()), ::std::make_move_iterator(input.end()));
+        ::std::inplace_merge(c.begin(), c.begin() + before, c.end(), store_comp);
+        size_t count = c.size() - before;
+
+        this->local_reduction(c, true);
+
+        this->check_merge_balance(c.size());
+
+        return count;
+      }
+
+      /**
+       * @brief insert into a globally sorted map as a new sorted delta run, without touching the local container.  collective.
+       * @details the new entries are routed by the current splitters, sorted and reduced, so an insert costs
+       *          O(batch log batch) instead of O(local size).  runs of similar size are then merged, see compact_delta_runs.
+       *          if there are still more than max_delta_runs runs, they are folded into the local container.  queries and
+       *          other operations fold the runs into the local container first.
+       * @return number of entries in the new run.
+       */
+      template <class Predicate>
+      size_t delta_insert(::std::vector<::std::pair<Key, T> > &input, Predicate const &pred) {
+        this->route_sorted(input, pred);
+        this->local_reduction(input, true);
+
+        size_t count = input.size();
+        if (count > 0) {
+          deltas.emplace_back();
+          deltas.back().swap(input);
+        }
+        this->compact_delta_runs();
+        if (deltas.size() > max_delta_runs) this->local_merge_deltas();
+
+        this->check_merge_balance(this->local_size());
+
+        return count;
+      }
+
+      /// drop entries that fail pred, route the rest by the current splitters, and sort them.
+      template <class Predicate>
+      void route_sorted(::std::vector<::std::pair<Key, T> > &input, Predicate const &pred) {
+        if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value) {
+          input.erase(::std::remove_if(input.begin(), input.end(),
+                                       [&pred](::std::pair<Key, T> const & x) { return !pred(x); }),
+                      input.end());
+        }
+
+        if (this->comm.size() > 1) {
+          std::vector<size_t> recv_counts;
+          std::vector<size_t> i2o;
+          std::vector<::std::pair<Key, T> > buffer;
+          this->distribute(input, this->key_to_rank, recv_counts, i2o, buffer);
+          input.swap(buffer);
+        }
+
+        ::std::sort(input.begin(), input.end(), typename Base::StoreTransformedFunc());
+      }
+
+      /// mark the map unbalanced if the largest local size is more than merge_imbalance times the mean.  collective.
+      void check_merge_balance(size_t const local) {
+        if ((this->comm.size() == 1) || (merge_imbalance <= 0.0)) return;
+
+        size_t max_size = ::mxx::allreduce(local, ::mxx::max<size_t>(), this->comm);
+        size_t total = ::mxx::allreduce(local, this->comm);
+        if (static_cast<double>(max_size) * static_cast<double>(this->comm.size()) >
+            merge_imbalance * static_cast<double>(total))
+          this->set_balanced(false);
+      }
+
+      /// k-way merge of the delta runs into one, with a min heap of the run heads.  equal keys keep the run order.
+      void merge_delta_runs() {
+        if (deltas.size() < 2) return;
+
+        typename Base::StoreTransformedFunc store_comp;
+
+        size_t total = 0;
+        for (size_t i = 0; i < deltas.size(); ++i) total += deltas[i].size();
+        local_container_type merged;
+        merged.reserve(total);
+
+        // heads are (run, position).  std heaps keep the largest on top, so the comparison is reversed.
+        using head_type = ::std::pair<size_t, size_t>;
+        auto after = [this, &store_comp](head_type const & x, head_type const & y) {
+          ::std::pair<Key, T> const & a = deltas[x.first][x.second];
+          ::std::pair<Key, T> const & b = deltas[y.first][y.second];
+          if (store_comp(b, a)) return true;
+          if (store_comp(a, b)) return false;
+          return x.first > y.first;
+        };
+
+        ::std::vector<head_type> heads;
+        for (size_t i = 0; i < deltas.size(); ++i) {
+          if (!deltas[i].empty()) heads.emplace_back(i, 0);
+        }
+        ::std::make_heap(heads.begin(), heads.end(), after);
+        while (!heads.empty()) {
+          ::std::pop_heap(heads.begin(), heads.end(), after);
+          head_type & h = heads.back();
+          merged.emplace_back(::std::move(deltas[h.first][h.second]));
+          if (++h.second < deltas[h.first].size())
+            ::std::push_heap(heads.begin(), heads.end(), after);
+          else
+            heads.pop_back();
+        }
+
+        this->local_reduction(merged, true);
+        deltas.clear();
+        deltas.emplace_back();
+        deltas.back().swap(merged);
+      }
+
+      /**
+       * @brief size tiered merging of the delta runs.  local.
+       * @details the runs are kept oldest first.  the newest run is merged into the one before it while that one is at most
+       *          delta_run_ratio times its size.  the run sizes then grow geometrically from newest to oldest, so there are
+       *          O(log n) runs, and each entry is merged O(log n) times, instead of once per insert when every run is
+       *          merged into the largest.
+       */
+      void compact_delta_runs() {
+        typename Base::StoreTransformedFunc store_comp;
+
+        while ((deltas.size() > 1) && (deltas[deltas.size() - 2].size() <= delta_run_ratio * deltas.back().size())) {
+          local_container_type & older = deltas[deltas.size() - 2];
+          local_container_type merged;
+          merged.reserve(older.size() + deltas.back().size());
+          // std::merge takes equal keys from the first range first, so the run order is kept.
+          ::std::merge(::std::make_move_iterator(older.begin()), ::std::make_move_iterator(older.end()),
+                       ::std::make_move_iterator(deltas.back().begin()), ::std::make_move_iterator(deltas.back().end()),
+                       ::std::back_inserter(merged), store_comp);
+          this->local_reduction(merged, true);
+
+          deltas.pop_back();
+          deltas.back().swap(merged);
+        }
+      }
+
+      /// fold the delta runs into the local container.  local.  the runs are merged into one, then into the container.
+      void local_fold_deltas() {
+        if (deltas.empty()) return;
+
+        this->merge_delta_runs();
+        this->invalidate_lookup_index();
+
+        size_t before = c.size();
+        this->local_reserve(before + deltas.front().size());
+        c.insert(c.end(), ::std::make_move_iterator(deltas.front().begin()), ::std::make_move_iterator(deltas.front().end()));
+        ::std::vector<local_container_type>().swap(deltas);
+
+        if (this->sorted) {
+          ::std::inplace_merge(c.begin(), c.begin() + before, c.end(), typename Base::StoreTransformedFunc());
+          this->local_reduction(c, true);
+        }
+      }
+
+      /// decode packed back into the local container.  local.
+      void local_decompress() {
+        if (packed.empty()) return;
+
+        packed.decode_all(c);
+        packed.clear();
+        local_container_type().swap(packed_block);
+        this->invalidate_lookup_index();
+      }
+
+      /// make the local container hold all local entries:  decode packed, and fold the delta runs.  local.
+      void local_merge_deltas() {
+        this->local_decompress();
+        this->local_fold_deltas();
+      }
+
+      /// const version that decodes and folds into the local container.
+      void local_merge_deltas() const {
+        const_cast<typename std::remove_cv<typename std::remove_reference<decltype(*this)>::type>::type *>(this)->local_merge_deltas();
+      }
+
+      /// append the local entries with keys in [range.first, range.second].  the local container must be sorted.
+      template <typename Predicate>
+      size_t local_find_range(::std::pair<Key, Key> const & range, ::std::vector<::std::pair<Key, T> > & output,
+                              Predicate const & pred) const {
+        typename Base::StoreTransformedFunc store_comp;
+
+        if (!packed.empty()) {  // the blocks from the one of range.first, up to the first one that starts after range.second.
+          size_t before = output.size();
+          for (size_t b = packed.block_of(range.first); (b < packed.blocks()) && !store_comp(range.second, packed.first_key(b)); ++b) {
+            packed.decode(b, packed_block);
+            auto first = ::std::lower_bound(packed_block.begin(), packed_block.end(), range.first, store_comp);
+            auto last = ::std::upper_bound(first, packed_block.end(), range.second, store_comp);
+            if (::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value) {
+              output.insert(output.end(), first, last);
+            } else {
+              ::std::copy_if(first, last, ::std::back_inserter(output), pred);
+            }
+          }
+          return output.size() - before;
+        }
+
+        auto first = ::std::lower_bound(c.begin(), c.end(), range.first, store_comp);
+        auto last = ::std::upper_bound(first, c.end(), range.second, store_comp);
+
+        size_t before = output.size();
+        if (::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value) {
+          output.insert(output.end(), first, last);
+        } else {
+          ::std::copy_if(first, last, ::std::back_inserter(output), pred);
+        }
+        return output.size() - before;
+      }
+
 
 
     public:
@@ -953,33 +1472,134 @@ using SortedMapParams = ::dsc::DistributedMapParams<
       virtual ~sorted_map_base() {};
 
       /// returns the local storage.  please use sparingly.
-      local_container_type& get_local_container() { return c; }
+      local_container_type& get_local_container() {
+        this->local_merge_deltas();
+        return c;
+      }
+
+      /// call fn(element, thread_id) for each local element, with the local storage split into per-thread ranges.
+      /// fn is called concurrently.  see containers/parallel_for_each.hpp
+      template <typename F>
+      void parallel_for_each_local(F fn, int const nthreads = 0) const {
+        this->local_merge_deltas();
+        ::fsc::parallel_for_each(c, fn, nthreads);
+      }
+
+      /**
+       * @brief merge inserts into the existing global order instead of re-sorting.  set the same on all ranks.
+       * @details once the map has been redistributed (e.g. by a query), insert routes new entries by the current
+       *          splitters and merges them into the sorted local containers.  when the largest local container exceeds
+       *          max_imbalance times the mean, the next redistribute rebalances, without a global sort, and recomputes the
+       *          splitters.  0 disables merging, and every insert is followed by a full sort on the next query.
+       * @param max_imbalance  max/mean local size that triggers rebalancing.  e.g. 1.25
+       */
+      void set_merge_insert(double max_imbalance) {
+        merge_imbalance = (max_imbalance > 0.0) ? ::std::max(max_imbalance, 1.0) : 0.0;
+      }
+
+      /**
+       * @brief keep inserts into a globally sorted map in sorted delta runs, LSM style.  set the same on all ranks.
+       * @details once the map has been redistributed, insert routes new entries by the current splitters, and sorts
+       *          them into a new run on the owner rank.  the local container is not touched, so repeated appends cost
+       *          O(batch log batch) each instead of a merge with, or a sort of, the whole local container.  runs of
+       *          similar size are merged, size tiered, so there are O(log n) runs and each entry is merged O(log n) times.
+       *          more than max_runs runs are folded into the local container, as are all runs before the next query or
+       *          iteration, or by merge_deltas().  size and empty do not fold:  until the fold, a key that
+       *          is in several runs of a map counts once per run.  balance is checked as in set_merge_insert, if that
+       *          is enabled.
+       * @param max_runs  most runs kept.  0 disables delta runs.  below about log2(delta entries / batch size), folds
+       *                  into the local container become frequent.  e.g. 16
+       */
+      void set_delta_runs(size_t max_runs) {
+        if (max_runs == 0) this->local_merge_deltas();
+        max_delta_runs = max_runs;
+      }
+
+      /// fold the delta runs into the local containers now, e.g. between append and query phases.  local.
+      void merge_deltas() {
+        this->local_merge_deltas();
+      }
+
+      /**
+       * @brief search the sorted local container through an Eytzinger tree of every stride-th key.  set the same on all ranks.
+       * @details find and count then take one probe into a small, cache friendly tree, prefetched and branchless, and a
+       *          short search over stride adjacent entries, instead of a binary search over the whole local container.
+       *          the tree takes sizeof(Key) + 8 bytes per stride entries, and is rebuilt by the first query after the
+       *          local container changes.  storage stays the sorted vector.  see containers/eytzinger_index.hpp
+       * @param stride  entries per sample.  0 disables the index.  e.g. 16
+       */
+      void set_lookup_index(size_t stride) {
+        lookup_stride = stride;
+        use_radix_lookup = false;
+        this->invalidate_lookup_index();
+      }
+
+      /**
+       * @brief predict find and count positions from the top key bits, instead of searching.  set the same on all ranks.
+       * @details the local key range is cut into 2^bits equal buckets, and a table of bucket start positions is built
+       *          by the first query after the local container changes.  a query reads its bucket's entry and searches
+       *          only that bucket.  for hashed or otherwise uniform keys, e.g. canonical k-mers after a hash transform,
+       *          that is 1 or 2 cache misses per query.  skewed keys make some buckets, and their searches, larger.
+       *          only for k-mer and unsigned integer keys of up to 8 bytes in std::less order, i.e. radix sorted maps.
+       *          other maps ignore this and keep set_lookup_index or the plain binary search.
+       *          see containers/radix_index.hpp
+       * @param enable  use the radix table.  false returns to set_lookup_index's setting.
+       * @param bits    log2 of the bucket count, at most 24.  0 picks about 4 entries per bucket.
+       */
+      void set_radix_lookup(bool enable, unsigned int bits = 0) {
+        use_radix_lookup = enable;
+        radix_lookup_bits = bits;
+        this->invalidate_lookup_index();
+      }
 
       const_iterator cbegin() const
       {
+        this->local_merge_deltas();
         return c.cbegin();
       }
 
       const_iterator cend() const {
+        this->local_merge_deltas();
         return c.cend();
       }
 
       /// convert the map to a vector.
       virtual std::vector<std::pair<Key, T> > to_vector() const {
+        this->local_merge_deltas();
         std::vector<std::pair<Key, T> > result(c.begin(), c.end());
         return result;
       }
 
       /// convert the map to a vector
       virtual void to_vector(std::vector<std::pair<Key, T> > & result) const {
+        this->local_merge_deltas();
         result.clear();
         if (c.empty()) return;
 
         result.assign(c.begin(), c.end());
       }
 
+      /// k entries of the merged local array, by index.
+      virtual void local_sample(size_t k, ::std::mt19937_64 & gen, std::vector<std::pair<Key, T> > & result) const {
+        this->local_merge_deltas();
+        ::fsc::sample(c.begin(), c.size(), k, gen, result);
+      }
+
+      /**
+       * @brief write all entries to 1 shared file, in storage order over all ranks.  collective.
+       * @details  the map is redistributed first if needed, after which each rank's sorted array follows the previous
+       *           rank's, so each rank writes its array in place, without a sort or a copy.  see distributed_map_export.hpp.
+       * @return  the number of entries written.
+       */
+      size_t export_sorted(::std::string const & filename) const {
+        this->redistribute();
+        this->local_merge_deltas();
+        return ::dsc::export_in_rank_order(c.data(), c.size(), filename, this->comm);
+      }
+
       /// extract the unique keys of a map.
       virtual void keys(std::vector<Key> & result) const {
+        this->local_merge_deltas();
         result.clear();
         if (this->local_empty()) return;
 
@@ -999,6 +1619,122 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
 
 
+      /**
+       * @brief find the entries with keys in the closed ranges [lo, hi].  collective.
+       * @details keys are compared in the storage order, without the input transform.  the map is redistributed
+       *          first if needed.  each range is sent only to the ranks whose splitter interval it overlaps, and each
+       *          of those replies with a contiguous slice of its sorted local container, so a range costs one query
+       *          entry per owning rank instead of one per key.  results are grouped by the replying rank.
+       * @param ranges  (lo, hi) pairs.  ranges with hi < lo are ignored.
+       */
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      ::std::vector<::std::pair<Key, T> > find_range(::std::vector<::std::pair<Key, Key> > const & ranges,
+                                                     Predicate const & pred = Predicate()) const {
+        BL_BENCH_INIT(find_range);
+        ::std::vector<::std::pair<Key, T> > results;
+
+        if (this->nothing_to_query(ranges)) {
+          BL_BENCH_REPORT_MPI_NAMED(find_range, "base_sorted_map:find_range", this->comm);
+          return results;
+        }
+
+        BL_BENCH_COLLECTIVE_START(find_range, "global_sort", this->comm);
+        this->redistribute();
+        BL_BENCH_END(find_range, "global_sort", this->local_size());
+
+        typename Base::StoreTransformedFunc store_comp;
+
+        if (this->comm.size() == 1) {
+          BL_BENCH_START(find_range);
+          for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+            if (store_comp(it->second, it->first)) continue;
+            local_find_range(*it, results, pred);
+          }
+          BL_BENCH_END(find_range, "local_find", results.size());
+
+          BL_BENCH_REPORT_MPI_NAMED(find_range, "base_sorted_map:find_range", this->comm);
+          return results;
+        }
+
+        // send each range to the ranks from the owner of lo to the owner of hi.  key_to_rank is monotonic.
+        BL_BENCH_START(find_range);
+        int p = this->comm.size();
+        ::std::vector<size_t> send_counts(p, 0);
+        ::std::vector<::std::pair<int, int> > owners;
+        owners.reserve(ranges.size());
+        for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+          if (store_comp(it->second, it->first)) {
+            owners.emplace_back(0, -1);
+            continue;
+          }
+          owners.emplace_back(this->key_to_rank(it->first), this->key_to_rank(it->second));
+          for (int i = owners.back().first; i <= owners.back().second; ++i) ++send_counts[i];
+        }
+        ::std::vector<size_t> offsets = ::mxx::impl::get_displacements(send_counts);
+        ::std::vector<::std::pair<Key, Key> > queries(offsets[p - 1] + send_counts[p - 1]);
+        for (size_t j = 0; j < ranges.size(); ++j) {
+          for (int i = owners[j].first; i <= owners[j].second; ++i) {
+            queries[offsets[i]] = ranges[j];
+            ++offsets[i];
+          }
+        }
+        ::std::vector<::std::pair<int, int> >().swap(owners);
+        BL_BENCH_END(find_range, "bucket", queries.size());
+
+        BL_BENCH_COLLECTIVE_START(find_range, "dist_query", this->comm);
+        ::std::vector<size_t> recv_counts = ::mxx::all2all(send_counts, this->comm);
+        queries = this->all2allv(queries, send_counts);
+        BL_BENCH_END(find_range, "dist_query", queries.size());
+
+        BL_BENCH_START(find_range);
+        ::std::vector<::std::pair<Key, T> > replies;
+        auto q = queries.begin();
+        for (int i = 0; i < p; ++i) {
+          size_t before = replies.size();
+          for (size_t j = 0; j < recv_counts[i]; ++j, ++q) {
+            local_find_range(*q, replies, pred);
+          }
+          send_counts[i] = replies.size() - before;
+        }
+        BL_BENCH_END(find_range, "local_find", replies.size());
+
+        BL_BENCH_COLLECTIVE_START(find_range, "a2a_reply", this->comm);
+        results = this->all2allv(replies, send_counts);
+        BL_BENCH_END(find_range, "a2a_reply", results.size());
+
+        BL_BENCH_REPORT_MPI_NAMED(find_range, "base_sorted_map:find_range", this->comm);
+        return results;
+      }
+
+      /**
+       * @brief find the entries whose keys share the first (k - suffix_chars) characters with one of the given k-mers.  collective.
+       * @details each k-mer becomes the range with its last suffix_chars characters all 0 to all 1 bits.  e.g. the
+       *          de Bruijn successors of a k-mer x are found from a copy with y.nextFromChar(0) and suffix_chars = 1.
+       *          meaningful when the storage transform keeps the k-mer order, e.g. identity.
+       */
+      template <typename Predicate = ::bliss::filter::TruePredicate, typename K = Key>
+      typename ::std::enable_if<::bliss::common::is_kmer<K>::value, ::std::vector<::std::pair<Key, T> > >::type
+      find_prefix(::std::vector<Key> const & kmers, unsigned int suffix_chars, Predicate const & pred = Predicate()) const {
+        if (suffix_chars > Key::size) suffix_chars = Key::size;
+
+        // characters per setCharsAtPos call.
+        constexpr unsigned int chunk = (sizeof(typename Key::KmerWordType) * 8) / Key::bitsPerChar;
+        constexpr typename Key::KmerWordType ones = ~(static_cast<typename Key::KmerWordType>(0));
+
+        ::std::vector<::std::pair<Key, Key> > ranges;
+        ranges.reserve(kmers.size());
+        for (auto it = kmers.begin(); it != kmers.end(); ++it) {
+          ranges.emplace_back(*it, *it);
+          for (unsigned int pos = 0; pos < suffix_chars; pos += chunk) {
+            unsigned int n = ((suffix_chars - pos) < chunk) ? (suffix_chars - pos) : chunk;
+            ranges.back().first.setCharsAtPos(static_cast<typename Key::KmerWordType>(0), pos, n);
+            ranges.back().second.setCharsAtPos(ones, pos, n);
+          }
+        }
+
+        return find_range(ranges, pred);
+      }
+
       /**
        * @brief count elements with the specified keys in the distributed sorted_multimap.
        * @param first
@@ -1045,13 +1781,22 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             this->redistribute();
             BL_BENCH_END(count, "global_sort", this->local_size());
 
+            // drop the sure misses.  they are counted as 0 here.
+            BL_BENCH_COLLECTIVE_START(count, "key_filter", this->comm);
+            std::vector<Key> misses;
+            if (this->refresh_key_filter(this->keys_added, this->c.begin(), this->c.end(), this->c.size())) {
+              this->keys_added = false;
+              this->drop_key_filter_misses(keys, misses);
+            }
+            BL_BENCH_END(count, "key_filter", keys.size());
+
             BL_BENCH_COLLECTIVE_START(count, "dist_query", this->comm);
           // distribute (communication part)
           std::vector<size_t> recv_counts;
           {
 				std::vector<size_t> i2o;
 				std::vector<Key > buffer;
-				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+				this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
 				keys.swap(buffer);
 //      		  ::dsc::distribute_sorted_unique(keys, this->key_to_rank, sorted_input, this->comm,
 //      				  typename Base::StoreTransformedFunc(),
@@ -1076,7 +1821,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             auto overlap = QueryProcessor<false>::intersect(this->c.begin(), this->c.end(), start, end, sorted_input);
 
             // within start-end, values are unique, so don't need to set unique to true.
-            QueryProcessor<false>::process(overlap.first, overlap.second,
+            this->template local_query<false>(overlap.first, overlap.second,
             		start, end, emplace_iter, count_element, sorted_input, pred);
 
             start = end;
@@ -1085,7 +1830,10 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
           BL_BENCH_COLLECTIVE_START(count, "a2a2", this->comm);
           // send back using the constructed recv count
-          mxx::all2allv(results, recv_counts, this->comm).swap(results);
+          this->all2allv(results, recv_counts).swap(results);
+          for (auto it = misses.begin(); it != misses.end(); ++it) {
+            results.emplace_back(*it, 0);
+          }
           BL_BENCH_END(count, "a2a2", results.size());
 
 
@@ -1113,7 +1861,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         		  keys.begin(), keys.end(), sorted_input);
 
           // within key, values may not be unique,
-          QueryProcessor<true>::process(overlap.first, overlap.second,
+          this->template local_query<true>(overlap.first, overlap.second,
         		  keys.begin(), keys.end(), emplace_iter, count_element, sorted_input, pred);
           BL_BENCH_END(count, "local_count", results.size());
 
@@ -1141,7 +1889,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
           results.reserve(keys.size());
 
           // keys already unique
-          QueryProcessor<false>::process(c.begin(), c.end(), keys.begin(), keys.end(),
+          this->template local_query<false>(c.begin(), c.end(), keys.begin(), keys.end(),
               emplace_iter, count_element, true, pred);
         }
         if (this->comm.size() > 1) this->comm.barrier();
@@ -1191,14 +1939,27 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             return 0;
           }
 
-          this->set_balanced(false);
-          this->set_globally_sorted(false);
+        this->keys_added = true;
+        this->local_decompress();
 
 
           BL_BENCH_START(insert);
           this->transform_input(input);
           BL_BENCH_END(insert, "transform_input", input.size());
 
+          if (this->can_merge_insert()) {
+            BL_BENCH_START(insert);
+            size_t count = (max_delta_runs > 0) ? this->delta_insert(input, pred) : this->merge_insert(input, pred);
+            BL_BENCH_END(insert, "merge_insert", count);
+
+            BL_BENCH_REPORT_MPI_NAMED(insert, "base_sorted_map:insert", this->comm);
+            return count;
+          }
+
+          this->local_merge_deltas();
+          this->set_balanced(false);
+          this->set_globally_sorted(false);
+
 
           size_t before = c.size();
           BL_BENCH_START(insert);
@@ -1243,7 +2004,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         // even if count is 0, still need to participate in mpi calls.  if (keys.size() == 0) return;
           BL_BENCH_INIT(erase);
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(erase, "base_sorted_map:erase", this->comm);
             return 0;
           }
@@ -1252,6 +2013,8 @@ using SortedMapParams = ::dsc::DistributedMapParams<
           this->transform_input(keys);
           BL_BENCH_END(erase, "transform_input", keys.size());
 
+        this->local_merge_deltas();
+        this->invalidate_lookup_index();
         size_t before = c.size();
 
         if (this->comm.size() > 1) {
@@ -1267,7 +2030,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
           {
 				std::vector<size_t> i2o;
 				std::vector<Key > buffer;
-				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+				this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
 				//::imxx::destructive_distribute(input, this->key_to_rank, recv_counts, buffer, this->comm);
 				keys.swap(buffer);
           }
@@ -1325,6 +2088,8 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
       template <typename Predicate>
       size_t erase(Predicate const & pred = Predicate()) {
+        this->local_merge_deltas();
+        this->invalidate_lookup_index();
         size_t before = c.size();
 
         if (! this->local_empty()) {
@@ -1356,12 +2121,18 @@ using SortedMapParams = ::dsc::DistributedMapParams<
       // this is for use by the asynchronous version of communicator as callback for any messages received.
       /// check if empty.
       virtual bool local_empty() const {
-        return c.empty();
+        if (!c.empty() || !packed.empty()) return false;
+        for (size_t i = 0; i < deltas.size(); ++i) {
+          if (!deltas[i].empty()) return false;
+        }
+        return true;
       }
 
-      /// get size of local container
+      /// get size of local container and delta runs.  does not fold the runs, see set_delta_runs.
       virtual size_t local_size() const {
-        return c.size();
+        size_t s = c.size() + packed.size();
+        for (size_t i = 0; i < deltas.size(); ++i) s += deltas[i].size();
+        return s;
       }
 
       /// get the size of unique keys.
@@ -1783,7 +2554,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
 			BL_BENCH_END(rehash, "splitters1", this->key_to_rank.map.size());
 
-			if (this->comm.rank() == 0) printf("split1\n");  fflush(stdout);
+			if (this->comm.rank() == 0) BL_DEBUGF("split1");
 
 
 
@@ -1799,7 +2570,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 //            		::dsc::distribute(this->c, this->key_to_rank, this->sorted, this->comm));
         	BL_BENCH_END(rehash, "dist", this->c.size());
 
-        	if (this->comm.rank() == 0) printf("dist\n");  fflush(stdout);
+        	if (this->comm.rank() == 0) BL_DEBUGF("dist");
 
 
         	// 11. local sort and reduce
@@ -1808,14 +2579,14 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         	this->local_reduction(this->c, this->sorted);
         	BL_BENCH_END(rehash, "reduce", this->c.size());
 
-        	if (this->comm.rank() == 0) printf("reduce\n");  fflush(stdout);
+        	if (this->comm.rank() == 0) BL_DEBUGF("reduce");
 
         	// 12. stable block decomposition
             BL_BENCH_START(rehash);
             ::mxx::stable_distribute(this->c, this->comm).swap(this->c);
             BL_BENCH_END(rehash, "block decomp", this->c.size());
 
-        	if (this->comm.rank() == 0) printf("block\n"); fflush(stdout);
+        	if (this->comm.rank() == 0) BL_DEBUGF("block");
 
         	// 13. record the splitters. first entry of each, except the first bucket
             BL_BENCH_START(rehash);
@@ -1829,7 +2600,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             ::mxx::allgatherv(this->key_to_rank.map, this->comm).swap(this->key_to_rank.map);
             BL_BENCH_END(rehash, "final_splitter", this->key_to_rank.map.size());
 
-        	if (this->comm.rank() == 0) printf("splitters\n"); fflush(stdout);
+        	if (this->comm.rank() == 0) BL_DEBUGF("splitters");
 
 
         } else {
@@ -2012,6 +2783,9 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
         typename Base::Base::StoreTransformedFunc store_comp;
 
+        // a compressed local array is in global order.  it is decoded below only if the map has to be sorted again.
+        this->local_fold_deltas();
+
         bool balanced = this->is_balanced();
         bool gsorted = this->is_globally_sorted();
 
@@ -2028,6 +2802,8 @@ using SortedMapParams = ::dsc::DistributedMapParams<
           BL_BENCH_REPORT_MPI_NAMED(rehash, "sorted_map:rehash", this->comm);
           return;
         }
+        this->local_decompress();
+        this->invalidate_lookup_index();
 
         //printf("c size before: %lu\n", this->c.size());
         BL_BENCH_START(rehash);
@@ -2202,6 +2978,39 @@ using SortedMapParams = ::dsc::DistributedMapParams<
       using Base::erase;
       using Base::count;
 
+      /**
+       * @brief store the local arrays as prefix compressed blocks, for a static map that is mostly queried.  collective.
+       * @details the map is redistributed first.  each block of about block_size entries keeps its first key, and the
+       *          others as the low bits of their xor with it, bit packed.  find, count and find_range search the first
+       *          keys and decode 1 block per query.  for k-mers in k-mer order, a key then takes about
+       *          log2(block_size * local key range / local entries) bits; values are not packed.  anything else that
+       *          needs the local array, e.g. insert, erase, update, iteration or to_vector, decodes it first, on the ranks
+       *          that call it.  set_lookup_index and set_radix_lookup are not used while compressed.
+       *          see containers/prefix_block_array.hpp
+       * @param block_size  entries per block.  0 uses 64.
+       */
+      void compress(size_t block_size = 0) {
+        static_assert(::fsc::prefix_block_array<Key, T, typename Base::StoreTransformedFunc>::supported,
+                      "compress needs k-mer or unsigned integer keys.");
+        this->redistribute();
+
+        // the key filter is built from the local array, so build it before the array is freed.
+        if (this->refresh_key_filter(this->keys_added, this->c.begin(), this->c.end(), this->c.size()))
+          this->keys_added = false;
+
+        this->local_compress(block_size);
+      }
+
+      /// decode the compressed local array, if any.  local.
+      void decompress() {
+        this->local_merge_deltas();
+      }
+
+      /// true if the local array is compressed.  local, and false for an empty local array.
+      bool is_compressed() const {
+        return !this->packed.empty();
+      }
+
       /// update the multiplicity.  only multimap needs to do this.
       virtual float get_multiplicity() const {
         this->redistribute();
@@ -2227,7 +3036,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         // even if count is 0, still need to participate in mpi calls.  if (input.size() == 0) return;
         BL_BENCH_INIT(update);
 
-        if (this->empty() || ::dsc::empty(input, this->comm)) {
+        if (this->nothing_to_query(input)) {
           BL_BENCH_REPORT_MPI_NAMED(update, "sortedmap:update", this->comm);
           return 0;
         }
@@ -2236,6 +3045,8 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         this->transform_input(input);
         BL_BENCH_END(update, "transform_intput", input.size());
 
+        this->local_merge_deltas();
+
         // communication part
 
         if (this->comm.size() > 1) {
@@ -2247,7 +3058,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
             std::vector<size_t> recv_counts;
             std::vector<size_t> i2o;
             std::vector<::std::pair<Key, V> > buffer;
-            ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+            this->distribute(input, this->key_to_rank, recv_counts, i2o, buffer);
             input.swap(buffer);
 
           BL_BENCH_END(update, "distribute", input.size());
@@ -2278,6 +3089,8 @@ using SortedMapParams = ::dsc::DistributedMapParams<
       size_t update(Filter const & fop, Updater const & op ) {
         BL_BENCH_INIT(update);
 
+        this->local_merge_deltas();
+
         BL_BENCH_START(update);
         size_t count = 0;
 
@@ -2351,6 +3164,12 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
       mutable size_t local_unique_count;
 
+      /// keeps all entries.  merge_insert calls this on the local container without a redistribute, so refresh the unique count here.
+      virtual void local_reduction(::std::vector<::std::pair<Key, T> > &input, bool sorted_input = false) {
+        Base::local_reduction(input, sorted_input);
+        local_unique_count = this->local_unique_size();
+      }
+
       struct LocalFind {
           typename Base::Base::StoreTransformedFunc store_comp;
 
@@ -2408,6 +3227,8 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         BL_BENCH_INIT(rehash);
         typename Base::Base::StoreTransformedFunc store_comp;
 
+        this->local_merge_deltas();
+
         bool balanced = this->is_balanced();
         bool gsorted = this->is_globally_sorted();
 
@@ -2424,6 +3245,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
           BL_BENCH_REPORT_MPI_NAMED(rehash, "sorted_multimap:rehash", this->comm);
           return;
         }
+        this->invalidate_lookup_index();
 
 
 
@@ -2503,7 +3325,7 @@ using SortedMapParams = ::dsc::DistributedMapParams<
 
           BL_BENCH_COLLECTIVE_START(rehash, "a2a", this->comm);
           // TODO: readjust boundaries using all2all.  is it better to move the deltas ourselves?
-          mxx::all2allv(this->c, send_counts, this->comm).swap(this->c);
+          this->all2allv(this->c, send_counts).swap(this->c);
           BL_BENCH_END(rehash, "a2a", this->c.size());
 
         } else {
@@ -2622,6 +3444,35 @@ using SortedMapParams = ::dsc::DistributedMapParams<
         return multiplicity;
       }
 
+      /**
+       * @brief multiplicity spectrum:  bin i is the number of keys with i values, and bin max_bin the number with max_bin or more.
+       * @details redistributes so that each key is on 1 rank, then makes one multithreaded pass over the sorted local vector.
+       *          each thread's index range is moved to start and end at key boundaries.  one reduction of the bins.  collective.
+       * @return  the global histogram on root.  other ranks get their local histogram.
+       */
+      ::std::vector<size_t> histogram(size_t const max_bin, int const root = 0) const {
+        this->redistribute();
+        this->local_sort();
+
+        ::dsc::local_histogram hist(max_bin);
+        auto const & c = this->c;
+        ::fsc::parallel_for_ranges(c.size(), [&c, &hist](size_t first, size_t last, int const tid) {
+          typename Base::Base::StoreTransformedFunc store_comp;
+          // a run that crosses a range boundary belongs to the range where it starts.
+          while ((first > 0) && (first < c.size()) && !store_comp(c[first - 1], c[first])) ++first;
+          while ((last > 0) && (last < c.size()) && !store_comp(c[last - 1], c[last])) ++last;
+
+          size_t run = first;
+          for (size_t i = first + 1; i <= last; ++i) {
+            if ((i == last) || store_comp(c[i - 1], c[i])) {
+              if (i > run) hist.add(i - run, tid);
+              run = i;
+            }
+          }
+        });
+        return hist.reduce(root, this->comm);
+      }
+
       /**
        * @brief global unique size
        * @note: calculated differently than local_unique size -
@@ -2850,6 +3701,28 @@ using SortedMapParams = ::dsc::DistributedMapParams<
       using Base::count;
       using Base::find;
 
+      /**
+       * @brief k-mer abundance spectrum:  bin i is the number of keys with count i, and bin max_bin the number with count >= max_bin.
+       * @details one multithreaded pass over the local table, then one reduction of the bins.  no keys are communicated.  collective.
+       * @return  the global histogram on root.  other ranks get their local histogram.
+       */
+      ::std::vector<size_t> histogram(size_t const max_bin, int const root = 0) const {
+        ::dsc::local_histogram hist(max_bin);
+        this->parallel_for_each_local(::dsc::local_histogram::by_value{hist});
+        return hist.reduce(root, this->comm);
+      }
+
+      /**
+       * @brief the n keys with the largest counts, in decreasing count order, on all ranks.  ties at the n-th count are broken arbitrarily.
+       * @details per-thread heaps in one pass over the local table, then a bisection on the n-th count with scalar allreduces,
+       *          so that at most n entries in total are gathered.  see ::dsc::local_top_n.  collective.
+       */
+      ::std::vector<::std::pair<Key, T> > top_n(size_t const n) const {
+        ::dsc::local_top_n<::std::pair<Key, T> > top(n);
+        this->parallel_for_each_local(typename ::dsc::local_top_n<::std::pair<Key, T> >::by_value{top});
+        return top.reduce(this->comm);
+      }
+
       /**
        * @brief insert new elements in the distributed sorted_multimap.  convert from Key to Key-count pair.  LOCAL INSERT
        * @param first
@@ -2858,10 +3731,22 @@ using SortedMapParams = ::dsc::DistributedMapParams<
       template <class Predicate = ::bliss::filter::TruePredicate>
       size_t insert(::std::vector<Key> &input, bool sorted_input = false, Predicate const &pred = Predicate()) {
 
+          // merge insert communicates, so go through the collective pair insert.  it applies the input transform.
+          if ((this->merge_imbalance > 0.0) || (this->max_delta_runs > 0)) {
+            ::std::vector<::std::pair<Key, T> > temp;
+            temp.reserve(input.size());
+            for (auto it = input.begin(); it != input.end(); ++it) {
+              temp.emplace_back(*it, T(1));
+            }
+            return Base::insert(temp, sorted_input, pred);
+          }
+
           if (input.size() == 0) return 0;  // OKAY HERE ONLY BECAUSE NO COMMUNICATION IS HERE.
 
           this->set_balanced(false);
           this->set_globally_sorted(false);
+        this->keys_added = true;
+        this->local_decompress();
 
           typename Base::Base::Base::Base::InputTransform trans;
 
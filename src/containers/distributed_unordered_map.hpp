@@ -64,10 +64,13 @@
 #include "utils/benchmark_utils.hpp"  // for timing.
 #include "utils/logging.h"
 #include "utils/filter_utils.hpp"
+#include "utils/transform_utils.hpp"
+#include "utils/function_traits.hpp"
 
 #include "common/kmer_transform.hpp"
 
 #include "containers/dsc_container_utils.hpp"
+#include "containers/parallel_for_each.hpp"
 
 #include "io/incremental_mxx.hpp"
 
@@ -167,6 +170,30 @@ namespace dsc  // distributed std container
           inline int operator()(::std::pair<const Key, V> const & x) const {
             return this->operator()(x.first);
           }
+
+          /// keys per call of the distribution hash's batched version.  see imxx::local::assign_batch.
+          static constexpr uint8_t batch_size = ::fsc::hash_batch_size<typename Base::DistTransformedFunc>::value;
+
+          /// ranks of n keys or (key, value) pairs, hashing batch_size keys at a time.
+          template <typename E, typename R>
+          inline void assign(E const * x, size_t const & n, R * ranks) const {
+            Key keys[batch_size];
+            uint64_t hashes[batch_size];
+            size_t i = 0;
+            for (; i + batch_size <= n; i += batch_size) {
+              for (size_t j = 0; j < batch_size; ++j) keys[j] = key_of(x[i + j]);
+              ::fsc::hash_batch(proc_trans_hash, keys, batch_size, hashes);
+              for (size_t j = 0; j < batch_size; ++j) ranks[i + j] = hashes[j] % p;
+            }
+            for (; i < n; ++i) ranks[i] = this->operator()(x[i]);
+          }
+
+        protected:
+          static inline Key const & key_of(Key const & x) { return x; }
+          template<typename V>
+          static inline Key const & key_of(::std::pair<Key, V> const & x) { return x.first; }
+          template<typename V>
+          static inline Key const & key_of(::std::pair<const Key, V> const & x) { return x.first; }
       } key_to_rank;
 
 
@@ -299,6 +326,7 @@ namespace dsc  // distributed std container
        */
       template <class InputIterator>
       size_t local_insert(InputIterator first, InputIterator last) {
+          typename Base::tracked_insert tracked(*this);
     	  BL_BENCH_INIT(local_insert);
 
     	  BL_BENCH_START(local_insert);
@@ -331,6 +359,7 @@ namespace dsc  // distributed std container
        */
       template <class InputIterator, class Predicate>
       size_t local_insert(InputIterator first, InputIterator last, Predicate const &pred) {
+          typename Base::tracked_insert tracked(*this);
 
           auto new_end = std::partition(first, last, pred);
 //
@@ -368,7 +397,7 @@ namespace dsc  // distributed std container
 
           ::std::vector<::std::pair<Key, T> > results;
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(find, "base_unordered_map:find_overlap", this->comm);
             return results;
           }
@@ -394,7 +423,7 @@ namespace dsc  // distributed std container
               {
   				std::vector<size_t> i2o;
   				std::vector<Key > buffer;
-  				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+  				this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
   				keys.swap(buffer);
   	//            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
   	//            				typename Base::StoreTransformedFunc(),
@@ -567,7 +596,7 @@ namespace dsc  // distributed std container
 
           ::std::vector<::std::pair<Key, T> > results;
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(find, "base_unordered_map:find", this->comm);
             return results;
           }
@@ -592,7 +621,7 @@ namespace dsc  // distributed std container
                 {
   				  std::vector<size_t> i2o;
   				  std::vector<Key > buffer;
-  				  ::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+  				  this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
   				  keys.swap(buffer);
   	  //            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
   	  //            				typename Base::StoreTransformedFunc(),
@@ -626,7 +655,7 @@ namespace dsc  // distributed std container
                     static_cast<double>(req_sofar)) *
                                     static_cast<double>(req_total) * 1.1f);
                 if (new_est > results.capacity()) {
-                  if (this->comm.rank() == 0) printf("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu\n", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
+                  if (this->comm.rank() == 0) BL_DEBUGF("rank %d nkeys %lu nresuts %lu est result size %lu original estimate %lu", this->comm.rank(), keys.size(), results.size(), new_est, results.capacity());
                   results.reserve(new_est);  // if new_est is lower than capacity, nothing happens.
                 }
               }
@@ -639,12 +668,12 @@ namespace dsc  // distributed std container
               start = end;
             }
             BL_BENCH_END(find, "local_find", results.size());
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
 
 
             BL_BENCH_COLLECTIVE_START(find, "a2a2", this->comm);
             // send back using the constructed recv count
-            mxx::all2allv(results, send_counts, this->comm).swap(results);
+            this->all2allv(results, send_counts).swap(results);
             BL_BENCH_END(find, "a2a2", results.size());
 
           } else {
@@ -676,7 +705,7 @@ namespace dsc  // distributed std container
             QueryProcessor::process(c, keys.begin() + estimating, keys.end(), emplace_iter, find_element, sorted_input, pred);
             BL_BENCH_END(find, "local_find", results.size());
 
-            if (this->comm.rank() == 0) printf("rank %d result size %lu capacity %lu\n", this->comm.rank(), results.size(), results.capacity());
+            if (this->comm.rank() == 0) BL_DEBUGF("rank %d result size %lu capacity %lu", this->comm.rank(), results.size(), results.capacity());
 
           }
 
@@ -686,6 +715,80 @@ namespace dsc  // distributed std container
 
       }
 
+      /**
+       * @brief find elements with the specified keys, and reply with trans(element) instead of the element.
+       * @details  the predicate and the transform are applied on the owner, so only the projected values are sent back,
+       *           e.g. just the value, or a few bits of it.  the projected type needs an mxx datatype.
+       *           the matches for each source rank are transformed before the next rank's are found, so the untransformed
+       *           elements are held for 1 source rank at a time.
+       * @param keys  content will be changed and reordered
+       */
+      template <class LocalFind, typename Predicate = ::bliss::filter::TruePredicate,
+          typename Transform = ::bliss::transform::identity<Key> >
+      ::std::vector<typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type >
+      find_transform(LocalFind & find_element, ::std::vector<Key>& keys, bool sorted_input = false,
+                     Predicate const& pred = Predicate(), Transform const & trans = Transform()) const {
+          using R = typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type;
+          BL_BENCH_INIT(find_transform);
+
+          ::std::vector<R> results;
+
+          if (this->nothing_to_query(keys)) {
+            BL_BENCH_REPORT_MPI_NAMED(find_transform, "base_unordered_map:find_transform", this->comm);
+            return results;
+          }
+
+          BL_BENCH_START(find_transform);
+          this->transform_input(keys);
+          ::fsc::unique(keys, sorted_input,
+                        typename Base::StoreTransformedFunc(),
+                        typename Base::StoreTransformedEqual());
+          BL_BENCH_END(find_transform, "transform_unique", keys.size());
+
+          std::vector<size_t> recv_counts;
+          if (this->comm.size() > 1) {
+            BL_BENCH_COLLECTIVE_START(find_transform, "dist_query", this->comm);
+            std::vector<size_t> i2o;
+            std::vector<Key > buffer;
+            this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
+            keys.swap(buffer);
+            BL_BENCH_END(find_transform, "dist_query", keys.size());
+          } else {
+            recv_counts.push_back(keys.size());
+          }
+
+          BL_BENCH_START(find_transform);
+          results.reserve(keys.size());
+          ::std::vector<::std::pair<Key, T> > found;
+          ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, T> > > emplace_iter(found);
+          std::vector<size_t> send_counts(recv_counts.size(), 0);
+          auto start = keys.begin();
+          auto end = start;
+          for (size_t i = 0; i < recv_counts.size(); ++i) {
+            ::std::advance(end, recv_counts[i]);
+
+            found.clear();
+            QueryProcessor::process(c, start, end, emplace_iter, find_element, sorted_input, pred);
+            send_counts[i] = found.size();
+            for (auto it = found.begin(); it != found.end(); ++it) {
+              results.emplace_back(trans(*it));
+            }
+
+            start = end;
+          }
+          BL_BENCH_END(find_transform, "local_find", results.size());
+
+          if (this->comm.size() > 1) {
+            BL_BENCH_COLLECTIVE_START(find_transform, "a2a2", this->comm);
+            this->all2allv(results, send_counts).swap(results);
+            BL_BENCH_END(find_transform, "a2a2", results.size());
+          }
+
+          BL_BENCH_REPORT_MPI_NAMED(find_transform, "base_unordered_map:find_transform", this->comm);
+
+          return results;
+      }
+
 
       template <class LocalFind, typename Predicate = ::bliss::filter::TruePredicate>
       ::std::vector<::std::pair<Key, T> > find(LocalFind & find_element, Predicate const& pred = Predicate()) const {
@@ -722,7 +825,7 @@ namespace dsc  // distributed std container
           size_t before = this->c.size();
           BL_BENCH_INIT(erase);
 
-          if (this->empty() || ::dsc::empty(keys, this->comm)) {
+          if (this->nothing_to_query(keys)) {
             BL_BENCH_REPORT_MPI_NAMED(erase, "base_unordered_map:erase", this->comm);
             return 0;
           }
@@ -740,7 +843,7 @@ namespace dsc  // distributed std container
               {
   				std::vector<size_t> i2o;
   				std::vector<Key > buffer;
-  				::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+  				this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
   				//::imxx::destructive_distribute(input, this->key_to_rank, recv_counts, buffer, this->comm);
   				keys.swap(buffer);
               }
@@ -826,14 +929,117 @@ namespace dsc  // distributed std container
         if (this->c.bucket_count() < buckets) this->c.rehash(buckets);
       }
 
+      /// insert saved entries.  checks that a sample of them hash to this rank, i.e. the distribution function matches.
+      virtual void local_load(::std::pair<Key, T> const * first, size_t count) {
+        size_t sample = ::std::min(count, static_cast<size_t>(1024));
+        for (size_t i = 0; i < sample; ++i) {
+          if (key_to_rank(first[i].first) != this->comm.rank())
+            throw ::std::invalid_argument("ERROR: loaded entries do not belong to this rank.  distribution hash differs from the saved map.");
+        }
+
+        this->local_reserve(count);
+        this->c.insert(first, first + count);
+        local_changed = true;
+      }
+
+      /// send loaded entries to their owners under key_to_rank, which need not match the saving map's.  see load_repartition.
+      virtual void repartition_chunk(::std::vector<::std::pair<Key, T> > & chunk) {
+        if (this->comm.size() == 1) {
+          this->local_insert(chunk.begin(), chunk.end());
+          return;
+        }
+
+        ::std::vector<size_t> recv_counts;
+        ::std::vector<size_t> i2o;
+        ::std::vector<::std::pair<Key, T> > received;
+        this->distribute(chunk, key_to_rank, recv_counts, i2o, received);
+        this->local_insert(received.begin(), received.end());
+      }
+
 
 
+
+      /// local keys that are (in_other) or are not in the other local container, without duplicates.
+      template <typename OtherContainer>
+      ::std::vector<Key> local_keys_by_membership(OtherContainer const & other, bool const in_other) const {
+        ::std::vector<::std::vector<Key> > parts(::fsc::parallel_for_each_threads(0));
+        ::fsc::parallel_for_each(c, typename Base::template membership_collector<OtherContainer>{other, in_other, parts});
+        ::std::vector<Key> keys = Base::concat(parts);
+        ::fsc::unique(keys, false,
+                      typename Base::StoreTransformedFunc(),
+                      typename Base::StoreTransformedEqual());
+        return keys;
+      }
+
+      /// erase all entries of the given local keys.  returns the number of entries removed.
+      size_t local_erase_keys(::std::vector<Key> const & keys) {
+        if (keys.size() == 0) return 0;
+        size_t before = c.size();
+        for (size_t i = 0; i < keys.size(); ++i) {
+          c.erase(keys[i]);
+        }
+        if (c.size() != before) local_changed = true;
+        return before - c.size();
+      }
+
+      /// insert entries that are already on the right rank.  overridden by the reduction maps to combine values.
+      virtual size_t local_merge(::std::vector<::std::pair<Key, T> > & entries) {
+        return this->local_insert(entries.begin(), entries.end());
+      }
+
     public:
 
       virtual ~unordered_map_base() {};
 
       /// returns the local storage.  please use sparingly.
       local_container_type& get_local_container() { return c; }
+      local_container_type const & get_local_container() const { return c; }
+
+      /// call fn(element, thread_id) for each local element, with the local storage split into per-thread ranges.
+      /// fn is called concurrently.  see containers/parallel_for_each.hpp
+      template <typename F>
+      void parallel_for_each_local(F fn, int const nthreads = 0) const {
+        ::fsc::parallel_for_each(c, fn, nthreads);
+      }
+
+      /**
+       * @brief keep only the keys that are also in other.  collective, but otherwise local:  equal keys of
+       *        co-partitioned maps are on the same rank.
+       * @param other  distributed map with a congruent communicator and the same key to rank assignment.
+       * @return number of local entries removed.
+       * @throw std::invalid_argument if the maps are not co-partitioned.  see map_base::check_copartitioned.
+       */
+      template <typename Other>
+      size_t intersect(Other const & other) {
+        this->check_copartitioned(key_to_rank, other.get_comm(), other.get_local_container());
+        ::std::vector<Key> keys = local_keys_by_membership(other.get_local_container(), false);
+        return local_erase_keys(keys);
+      }
+
+      /**
+       * @brief remove the keys that are in other.  collective, but otherwise local.  see intersect.
+       * @return number of local entries removed.
+       */
+      template <typename Other>
+      size_t subtract(Other const & other) {
+        this->check_copartitioned(key_to_rank, other.get_comm(), other.get_local_container());
+        ::std::vector<Key> keys = local_keys_by_membership(other.get_local_container(), true);
+        return local_erase_keys(keys);
+      }
+
+      /**
+       * @brief insert the entries of other, with the same semantics as insert, e.g. counting maps add the counts.
+       *        collective, but otherwise local.  see intersect.
+       * @return number of local entries added.
+       */
+      template <typename Other>
+      size_t merge(Other const & other) {
+        this->check_copartitioned(key_to_rank, other.get_comm(), other.get_local_container());
+        ::std::vector<::std::vector<::std::pair<Key, T> > > parts(::fsc::parallel_for_each_threads(0));
+        ::fsc::parallel_for_each(other.get_local_container(), typename Base::entry_collector{parts});
+        ::std::vector<::std::pair<Key, T> > entries = Base::concat(parts);
+        return this->local_merge(entries);
+      }
 
       const_iterator cbegin() const
       {
@@ -857,6 +1063,10 @@ namespace dsc  // distributed std container
         ::fsc::back_emplace_iterator<::std::vector<::std::pair<Key, T> > > emplace_iter(result);
         ::std::copy(c.begin(), c.end(), emplace_iter);
       }
+      /// k entries of the local table, in 1 pass over it.
+      virtual void local_sample(size_t k, ::std::mt19937_64 & gen, std::vector<std::pair<Key, T> > & result) const {
+        ::fsc::sample(c.begin(), c.size(), k, gen, result);
+      }
       /// extract the unique keys of a map.
       virtual void keys(std::vector<Key> & result) const {
         result.clear();
@@ -872,6 +1082,19 @@ namespace dsc  // distributed std container
 
 
 
+      /**
+       * @brief number of entries for each key, aligned to keys:  result i is the count of keys[i].  collective.
+       * @details  replies carry counts only, and are put back in query order with the saved bucketing permutation.
+       *           duplicate keys are each counted.  keys is not modified.
+       */
+      ::std::vector<size_type> count_aligned(::std::vector<Key> const & keys) const {
+        return this->template aligned_query<size_type>(keys, this->key_to_rank,
+            [this](typename ::std::vector<Key>::const_iterator first, typename ::std::vector<Key>::const_iterator last,
+                   typename ::std::vector<size_type>::iterator out) {
+              for (; first != last; ++first, ++out) *out = this->c.count(*first);
+            });
+      }
+
       /**
        * @brief count elements with the specified keys in the distributed unordered_multimap.
        * @param first
@@ -919,7 +1142,7 @@ namespace dsc  // distributed std container
               {
 				  std::vector<size_t> i2o;
 				  std::vector<Key > buffer;
-				  ::imxx::distribute(keys, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
+				  this->distribute(keys, this->key_to_rank, recv_counts, i2o, buffer);
 				  keys.swap(buffer);
 	  //            ::dsc::distribute_unique(keys, this->key_to_rank, sorted_input, this->comm,
 	  //            				typename Base::StoreTransformedFunc(),
@@ -952,7 +1175,7 @@ namespace dsc  // distributed std container
 
             // send back using the constructed recv count
             BL_BENCH_COLLECTIVE_START(count, "a2a2", this->comm);
-            mxx::all2allv(results, recv_counts, this->comm).swap(results);
+            this->all2allv(results, recv_counts).swap(results);
             BL_BENCH_END(count, "a2a2", results.size());
           } else {
 
@@ -1038,6 +1261,16 @@ namespace dsc  // distributed std container
         return this->local_size();
       }
 
+      /// buckets of the local table, for the table tracker.
+      virtual size_t local_bucket_count() const {
+        return this->c.bucket_count();
+      }
+
+      /// chain lengths of the local table.
+      virtual void local_table_stats(::fsc::table_stats & stats) const {
+        ::fsc::collect_chained_table_stats(this->c, stats);
+      }
+
 
 
   };
@@ -1165,6 +1398,13 @@ namespace dsc  // distributed std container
                                                           Predicate const& pred = Predicate()) const {
           return Base::find(find_element, keys, sorted_input, pred);
       }
+      /// find, replying with trans(element) computed on the owner.  see unordered_map_base::find_transform.
+      template <class Transform = ::bliss::transform::identity<Key>, class Predicate = ::bliss::filter::TruePredicate>
+      ::std::vector<typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type>
+      find_transform(::std::vector<Key>& keys, bool sorted_input = false,
+                     Predicate const& pred = Predicate(), Transform const & trans = Transform()) const {
+          return Base::find_transform(find_element, keys, sorted_input, pred, trans);
+      }
 //      template <class Predicate = ::bliss::filter::TruePredicate>
 //      ::std::vector<::std::pair<Key, T> > find_sendrecv(::std::vector<Key>& keys, bool sorted_input = false,
 //                                                          Predicate const& pred = Predicate()) const {
@@ -1176,6 +1416,30 @@ namespace dsc  // distributed std container
           return Base::find(find_element, pred);
       }
 
+      /**
+       * @brief value of each key, aligned to keys:  result i is the value of keys[i], or missing if keys[i] is absent.  collective.
+       * @details  replies carry values only, and are put back in query order with the saved bucketing permutation.
+       *           keys is not modified.  use count_aligned to tell absent keys from stored missing values.
+       */
+      ::std::vector<T> find_aligned(::std::vector<Key> const & keys, T const & missing = T()) const {
+        return this->template aligned_query<T>(keys, this->key_to_rank,
+            [this, &missing](typename ::std::vector<Key>::const_iterator first, typename ::std::vector<Key>::const_iterator last,
+                             typename ::std::vector<T>::iterator out) {
+              for (; first != last; ++first, ++out) {
+                auto range = this->c.equal_range(*first);
+                *out = (range.first == range.second) ? missing : range.first->second;
+              }
+            });
+      }
+
+
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert(std::vector<::std::pair<Key, T> >&& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred](std::vector<::std::pair<Key, T> > & owned) {
+          return this->insert(owned, sorted_input, pred);
+        });
+      }
 
       /**
        * @brief insert new elements in the distributed unordered_multimap.
@@ -1203,11 +1467,7 @@ namespace dsc  // distributed std container
           // TODO: keep unique only may not be needed - comm speed may be faster than we can compute unique.
 //          auto recv_counts(::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm));
 //          BLISS_UNUSED(recv_counts);
-          std::vector<size_t> recv_counts;
-			  std::vector<size_t> i2o;
-			  std::vector<::std::pair<Key, T> > buffer;
-			  ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-			  input.swap(buffer);
+          this->distribute_insert(input, this->key_to_rank);
           BL_BENCH_END(insert, "dist_data", input.size());
         }
 
@@ -1226,6 +1486,34 @@ namespace dsc  // distributed std container
         return count;
       }
 
+      /// insert from a struct of arrays buffer, e.g. filled by a parser through ::fsc::back_emplace_iterator.  input is replaced by the entries this rank received.
+      size_t insert(::fsc::soa_vector<Key, T>& input) {
+        BL_BENCH_INIT(insert);
+
+        if (::dsc::empty(input.keys, this->comm)) {
+          BL_BENCH_REPORT_MPI_NAMED(insert, "hashmap:insert_soa", this->comm);
+          return 0;
+        }
+
+        BL_BENCH_START(insert);
+        this->transform_input(input.keys);
+        BL_BENCH_END(insert, "transform_intput", input.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_START(insert);
+          this->distribute_insert(input, this->key_to_rank);
+          BL_BENCH_END(insert, "dist_data", input.size());
+        }
+
+        BL_BENCH_START(insert);
+        size_t count = this->Base::local_insert(input.begin(), input.end());
+        BL_BENCH_END(insert, "insert", this->c.size());
+
+        BL_BENCH_REPORT_MPI_NAMED(insert, "hashmap:insert_soa", this->comm);
+
+        return count;
+      }
+
 
   };
 
@@ -1327,8 +1615,64 @@ namespace dsc  // distributed std container
         // no filter by range AND elemenet for now.
       } find_element;
 
+      /// Base's erase_element, also counting the keys whose last entry it removes.
+      struct UniqueCountingErase {
+          typename Base::LocalErase & erase_element;
+          size_t removed_keys;
+
+          template<class DB, typename Query, class OutputIter>
+          size_t operator()(DB &db, Query const &v, OutputIter & output) {
+              size_t count = erase_element(db, v, output);
+              if (count > 0) ++removed_keys;   // erasing by key removes all of its entries.
+              return count;
+          }
+          template<class DB, typename Query, class OutputIter, class Predicate>
+          size_t operator()(DB &db, Query const &v, OutputIter & output, Predicate const & pred) {
+              size_t count = erase_element(db, v, output, pred);
+              if ((count > 0) && (db.find(v) == db.end())) ++removed_keys;
+              return count;
+          }
+      };
+
+      /// number of unique local keys.  current unless local_changed, i.e. unless the container was modified outside
+      /// local_insert and erase below, in which case local_unique_size recounts.
       mutable size_t local_unique_count;
 
+      /**
+       * @brief insert into the local container.  counts the new keys, if local_unique_count is current.
+       * @details  an entry with a key already present is inserted with that key's position as hint, so the extra find
+       *           replaces the search that emplace would do.
+       */
+      template <class InputIterator>
+      size_t local_insert(InputIterator first, InputIterator last) {
+          typename Base::tracked_insert tracked(*this);
+          this->local_reserve(this->c.size() + ::std::distance(first, last));
+
+          size_t before = this->c.size();
+          if (this->local_changed) {
+            for (auto it = first; it != last; ++it) {
+              this->c.emplace(*it);
+            }
+          } else {
+            for (auto it = first; it != last; ++it) {
+              auto hint = this->c.find((*it).first);
+              if (hint == this->c.end()) {
+                this->c.emplace(*it);
+                ++local_unique_count;
+              } else {
+                this->c.emplace_hint(hint, *it);
+              }
+            }
+          }
+          return this->c.size() - before;
+      }
+
+      template <class InputIterator, class Predicate>
+      size_t local_insert(InputIterator first, InputIterator last, Predicate const &pred) {
+          typename Base::tracked_insert tracked(*this);
+          return this->local_insert(first, ::std::partition(first, last, pred));
+      }
+
     public:
 
 
@@ -1337,15 +1681,71 @@ namespace dsc  // distributed std container
       virtual ~unordered_multimap() {}
 
       using Base::count;
-      using Base::erase;
       using Base::unique_size;
 
+      /**
+       * @brief erase the entries of the keys.  collective.  keeps the local unique key count current.
+       */
+      template <class Predicate = ::bliss::filter::TruePredicate>
+      size_t erase(::std::vector<Key>& keys, bool sorted_input = false, Predicate const& pred = Predicate() ) {
+          bool const current = !this->local_changed;
+          UniqueCountingErase eraser{this->erase_element, 0};
+          size_t count = Base::erase(eraser, keys, sorted_input, pred);
+          if (current) {
+            local_unique_count -= eraser.removed_keys;
+            this->local_changed = false;
+          }
+          return count;
+      }
+      template <typename Predicate>
+      size_t erase(Predicate const & pred = Predicate()) {
+          bool const current = !this->local_changed;
+          UniqueCountingErase eraser{this->erase_element, 0};
+          size_t count = Base::erase(eraser, pred);
+          if (current) {
+            local_unique_count = this->c.empty() ? 0 : (local_unique_count - eraser.removed_keys);
+            this->local_changed = false;
+          }
+          return count;
+      }
+
+      /**
+       * @brief multiplicity spectrum:  bin i is the number of keys with i values, and bin max_bin the number with max_bin or more.
+       * @details one multithreaded pass over the local buckets, then one reduction of the bins.  no keys are communicated.  collective.
+       * @return  the global histogram on root.  other ranks get their local histogram.
+       */
+      ::std::vector<size_t> histogram(size_t const max_bin, int const root = 0) const {
+        ::dsc::local_histogram hist(max_bin);
+        auto const & c = this->c;
+        ::fsc::parallel_for_ranges(c.bucket_count(), [&c, &hist](size_t const first, size_t const last, int const tid) {
+          auto eq = c.key_eq();
+          for (size_t b = first; b < last; ++b) {
+            // entries with equal keys are adjacent in a bucket.
+            auto it = c.cbegin(b);
+            while (it != c.cend(b)) {
+              auto run = it;
+              size_t n = 0;
+              for (; (it != c.cend(b)) && eq(it->first, run->first); ++it) ++n;
+              hist.add(n, tid);
+            }
+          }
+        });
+        return hist.reduce(root, this->comm);
+      }
+
 
       template <class Predicate = ::bliss::filter::TruePredicate>
       ::std::vector<::std::pair<Key, T> > find(::std::vector<Key>& keys, bool sorted_input = false,
                                                Predicate const& pred = Predicate()) const {
           return Base::find_overlap(find_element, keys, sorted_input, pred);
       }
+      /// find, replying with trans(element) computed on the owner.  see unordered_map_base::find_transform.
+      template <class Transform = ::bliss::transform::identity<Key>, class Predicate = ::bliss::filter::TruePredicate>
+      ::std::vector<typename ::bliss::functional::function_traits<Transform, ::std::pair<Key, T> >::return_type>
+      find_transform(::std::vector<Key>& keys, bool sorted_input = false,
+                     Predicate const& pred = Predicate(), Transform const & trans = Transform()) const {
+          return Base::find_transform(find_element, keys, sorted_input, pred, trans);
+      }
 //      template <class Predicate = ::bliss::filter::TruePredicate>
 //      ::std::vector<::std::pair<Key, T> > find(::std::vector<Key>& keys, bool sorted_input = false,
 //                                                          Predicate const& pred = Predicate()) const {
@@ -1362,6 +1762,17 @@ namespace dsc  // distributed std container
 //          return Base::find_sendrecv(find_element, keys, sorted_input, pred);
 //      }
 
+      /**
+       * @brief seed hits of reads, binned by diagonal on the owners.  see map_base::seed_hits.  collective.
+       * @param seeds  (k-mer, read id, offset in read) per seed.
+       * @param bin_width  diagonals per bin.
+       * @return  (read id, diagonal, votes) per diagonal bin of this rank's reads, sorted by read id then diagonal.
+       */
+      ::std::vector<::dsc::seed_hit> map_reads(::std::vector<::dsc::read_seed<Key> > const & seeds, size_t const bin_width = 1) const {
+        typename Base::template equal_range_visitor<local_container_type> visit{this->c};
+        return this->seed_hits(seeds, this->key_to_rank, visit, false, [](Key const &) { return false; }, bin_width);
+      }
+
 
 
       template <class Predicate = ::bliss::filter::TruePredicate>
@@ -1371,7 +1782,7 @@ namespace dsc  // distributed std container
       /// access the current the multiplicity.  only multimap needs to override this.
       virtual float get_multiplicity() const {
         // multimaps would add a collective function to change the multiplicity
-        if (this->comm.rank() == 0) printf("rank %d unordered_multimap get_multiplicity called\n", this->comm.rank());
+        if (this->comm.rank() == 0) BL_DEBUGF("rank %d unordered_multimap get_multiplicity called", this->comm.rank());
 
 
         // one approach is to add up the number of repeats for the key of each entry, then divide by total count.
@@ -1385,6 +1796,7 @@ namespace dsc  // distributed std container
         // This is precise, and is faster than the approach above.  (0.0078125 human: 54 sec.  synth: 57sec.)
         // but the n log(n) sort still grows with the duplicate count
 
+        // now the unique count is maintained by insert and erase, so this is O(1).  see global_multiplicity for all ranks.
         size_t n_unique = this->local_unique_size();
         float multiplicity = 1.0f;
         if (n_unique > 0) {
@@ -1458,13 +1870,24 @@ namespace dsc  // distributed std container
       }
 
 
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate, typename Observer = ::dsc::no_observer>
+      size_t insert(std::vector<::std::pair<Key, T> >&& input, bool sorted_input = false, Predicate const & pred = Predicate(),
+                    Observer const & observe = Observer()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred, &observe](std::vector<::std::pair<Key, T> > & owned) {
+          return this->insert(owned, sorted_input, pred, observe);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed unordered_multimap.
-       * @param first
-       * @param last
+       * @param observe  called as observe(entries) on every rank with the transformed entries it received, before they are
+       *                 stored and before pred, e.g. to count the keys into a counting map with the same MapParams
+       *                 (see counting_*_map::insert_owned), so that 1 exchange fills both.
        */
-      template <typename Predicate = ::bliss::filter::TruePredicate>
-      size_t insert(std::vector<::std::pair<Key, T> >& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+      template <typename Predicate = ::bliss::filter::TruePredicate, typename Observer = ::dsc::no_observer>
+      size_t insert(std::vector<::std::pair<Key, T> >& input, bool sorted_input = false, Predicate const & pred = Predicate(),
+                    Observer const & observe = Observer()) {
         // even if count is 0, still need to participate in mpi calls.  if (input.size() == 0) return;
         BL_BENCH_INIT(insert);
 
@@ -1488,11 +1911,7 @@ namespace dsc  // distributed std container
           BL_BENCH_START(insert);
           // first remove duplicates.  sort, then get unique, finally remove the rest.  may not be needed
 
-          std::vector<size_t> recv_counts;
-          std::vector<size_t> i2o;
-          std::vector<::std::pair<Key, T> > buffer;
-          ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-          input.swap(buffer);
+          this->distribute_insert(input, this->key_to_rank);
 
           //auto recv_counts = ::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm);
           //BLISS_UNUSED(recv_counts);
@@ -1500,14 +1919,15 @@ namespace dsc  // distributed std container
         }
 
         //        count_unique(input);
+        observe(input);
 
         BL_BENCH_START(insert);
         // local compute part.  called by the communicator.
         size_t count = 0;
         if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
-          count = this->Base::local_insert(input.begin(), input.end(), pred);
+          count = this->local_insert(input.begin(), input.end(), pred);
         else
-          count = this->Base::local_insert(input.begin(), input.end());
+          count = this->local_insert(input.begin(), input.end());
         BL_BENCH_END(insert, "insert", this->c.size());
 
         BL_BENCH_REPORT_MPI_NAMED(insert, "hash_multimap:insert", this->comm);
@@ -1515,9 +1935,12 @@ namespace dsc  // distributed std container
       }
 
 
-      /// get the size of unique keys in the current local container.
+      /// get the size of unique keys in the current local container.  O(1) unless modified outside insert and erase.
       virtual size_t local_unique_size() const {
-        if (this->local_changed) {
+        if (this->c.empty()) {
+          local_unique_count = 0;
+          this->local_changed = false;
+        } else if (this->local_changed) {
 
           typename Base::template UniqueKeySetUtilityType<Key> unique_set(this->c.size());
           auto max = this->c.end();
@@ -1602,14 +2025,13 @@ namespace dsc  // distributed std container
        */
       template <class InputIterator>
       size_t local_insert(InputIterator first, InputIterator last) {
+          typename Base::tracked_insert tracked(*this);
           size_t before = this->c.size();
 
           this->local_reserve(before + ::std::distance(first, last));
 
           for (auto it = first; it != last; ++it) {
-            if (this->c.find((*it).first) == this->c.end()) this->c.emplace(*it);
-            else
-              this->c.at((*it).first) = r(this->c.at((*it).first), (*it).second);
+            ::fsc::upsert(this->c, (*it).first, (*it).second, r);
           }
 
           if (this->c.size() != before) this->local_changed = true;
@@ -1624,15 +2046,14 @@ namespace dsc  // distributed std container
        */
       template <class InputIterator, class Predicate>
       size_t local_insert(InputIterator first, InputIterator last, Predicate const & pred) {
+          typename Base::tracked_insert tracked(*this);
           size_t before = this->c.size();
 
           this->local_reserve(before + ::std::distance(first, last));
 
           for (auto it = first; it != last; ++it) {
             if (pred(*it)) {
-              if (this->c.find((*it).first) == this->c.end()) this->c.emplace(*it);
-              else
-                this->c.at((*it).first) = r(this->c.at((*it).first), (*it).second);
+              ::fsc::upsert(this->c, (*it).first, (*it).second, r);
             }
           }
 
@@ -1642,6 +2063,11 @@ namespace dsc  // distributed std container
 
       }
 
+      /// merge combines the values of equal keys, as insert does.
+      virtual size_t local_merge(::std::vector<::std::pair<Key, T> > & entries) {
+        return this->local_insert(entries.begin(), entries.end());
+      }
+
       /// local reduction via a copy of local container type (i.e. unordered_map).
       /// this takes quite a bit of memory due to use of unordered_map, but is significantly faster than sorting.
       virtual void local_reduction(::std::vector<::std::pair<Key, T> >& input, bool & sorted_input) {
@@ -1656,14 +2082,9 @@ namespace dsc  // distributed std container
         BL_BENCH_END(reduce_tuple, "reserve", input.size());
 
         BL_BENCH_START(reduce_tuple);
-        Key k;
-        T v;
         auto end = input.end();
         for (auto it = input.begin(); it != end; ++it) {
-          k = (*it).first;
-          v = (*it).second;
-          if (temp.find(k) == temp.end()) temp.emplace(k, v);  // don't rely on initialization to set T to 0.
-          else temp.at(k) = r(temp.at(k), v);
+          ::fsc::upsert(temp, (*it).first, (*it).second, r);  // don't rely on initialization to set T to 0.
         }
         BL_BENCH_END(reduce_tuple, "reduce", temp.size());
 
@@ -1689,6 +2110,14 @@ namespace dsc  // distributed std container
       using Base::erase;
       using Base::unique_size;
 
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert(std::vector<::std::pair<Key, T> >&& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred](std::vector<::std::pair<Key, T> > & owned) {
+          return this->insert(owned, sorted_input, pred);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed unordered_multimap.
        * @param first
@@ -1714,11 +2143,7 @@ namespace dsc  // distributed std container
         if (this->comm.size() > 1) {
           BL_BENCH_START(insert);
           // first remove duplicates.  sort, then get unique, finally remove the rest.  may not be needed
-          std::vector<size_t> recv_counts;
-          std::vector<size_t> i2o;
-          std::vector<::std::pair<Key, T> > buffer;
-          ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-          input.swap(buffer);
+          this->distribute_insert(input, this->key_to_rank);
 
 //          auto recv_counts = ::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm);
 //          BLISS_UNUSED(recv_counts);
@@ -1744,6 +2169,34 @@ namespace dsc  // distributed std container
         return count;
       }
 
+      /// insert from a struct of arrays buffer, reducing the values of equal keys.  see unordered_map::insert(soa_vector&).
+      size_t insert(::fsc::soa_vector<Key, T>& input) {
+        BL_BENCH_INIT(insert);
+
+        if (::dsc::empty(input.keys, this->comm)) {
+          BL_BENCH_REPORT_MPI_NAMED(insert, "reduction_hashmap:insert_soa", this->comm);
+          return 0;
+        }
+
+        BL_BENCH_START(insert);
+        this->transform_input(input.keys);
+        BL_BENCH_END(insert, "transform_intput", input.size());
+
+        if (this->comm.size() > 1) {
+          BL_BENCH_START(insert);
+          this->distribute_insert(input, this->key_to_rank);
+          BL_BENCH_END(insert, "dist_data", input.size());
+        }
+
+        BL_BENCH_START(insert);
+        size_t count = this->local_insert(input.begin(), input.end());
+        BL_BENCH_END(insert, "local_insert", this->local_size());
+
+        BL_BENCH_REPORT_MPI_NAMED(insert, "reduction_hashmap:insert_soa", this->comm);
+
+        return count;
+      }
+
 
   };
 
@@ -1818,6 +2271,36 @@ namespace dsc  // distributed std container
       using Base::erase;
       using Base::unique_size;
 
+      /**
+       * @brief k-mer abundance spectrum:  bin i is the number of keys with count i, and bin max_bin the number with count >= max_bin.
+       * @details one multithreaded pass over the local table, then one reduction of the bins.  no keys are communicated.  collective.
+       * @return  the global histogram on root.  other ranks get their local histogram.
+       */
+      ::std::vector<size_t> histogram(size_t const max_bin, int const root = 0) const {
+        ::dsc::local_histogram hist(max_bin);
+        this->parallel_for_each_local(::dsc::local_histogram::by_value{hist});
+        return hist.reduce(root, this->comm);
+      }
+
+      /**
+       * @brief the n keys with the largest counts, in decreasing count order, on all ranks.  ties at the n-th count are broken arbitrarily.
+       * @details per-thread heaps in one pass over the local table, then a bisection on the n-th count with scalar allreduces,
+       *          so that at most n entries in total are gathered.  see ::dsc::local_top_n.  collective.
+       */
+      ::std::vector<::std::pair<Key, T> > top_n(size_t const n) const {
+        ::dsc::local_top_n<::std::pair<Key, T> > top(n);
+        this->parallel_for_each_local(typename ::dsc::local_top_n<::std::pair<Key, T> >::by_value{top});
+        return top.reduce(this->comm);
+      }
+
+      /// insert, consuming input:  exchanged in place, and released before returning.  see map_base::insert_consumed.
+      template <typename Predicate = ::bliss::filter::TruePredicate>
+      size_t insert(std::vector< Key >&& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+        return this->insert_consumed(input, [this, sorted_input, &pred](std::vector< Key > & owned) {
+          return this->insert(owned, sorted_input, pred);
+        });
+      }
+
       /**
        * @brief insert new elements in the distributed unordered_multimap.
        * @param first
@@ -1844,11 +2327,7 @@ namespace dsc  // distributed std container
         if (this->comm.size() > 1) {
           BL_BENCH_START(insert);
           // first remove duplicates.  sort, then get unique, finally remove the rest.  may not be needed
-          std::vector<size_t> recv_counts;
-          std::vector<size_t> i2o;
-          std::vector< Key > buffer;
-          ::imxx::distribute(input, this->key_to_rank, recv_counts, i2o, buffer, this->comm);
-          input.swap(buffer);
+          this->distribute_insert_keys(input, this->key_to_rank);
 
           BL_BENCH_END(insert, "dist_data", input.size());
         }
@@ -1862,9 +2341,6 @@ namespace dsc  // distributed std container
           BL_BENCH_START(insert);
           // preallocate.  easy way out - estimate to be 1/2 of input.  then at the end, resize if significantly less.
           //this->c.resize(input.size() / 2);
-          if (this->comm.rank() == 0)
-          std::cout << "rank " << this->comm.rank() <<
-            " BEFORE input=" << input.size() << " size=" << this->local_size() << " buckets=" << this->c.bucket_count() << std::endl;
 
           // then insert all the rest,
           auto local_start = ::bliss::iterator::make_transform_iterator(input.begin(), trans);
@@ -1883,6 +2359,20 @@ namespace dsc  // distributed std container
 
       }
 
+      /**
+       * @brief count the keys of entries that are already transformed and on this rank, e.g. the entries a multimap with the
+       *        same MapParams received in insert (see unordered_multimap::insert's observe).  no communication.
+       * @return number of new keys.
+       */
+      template <typename V>
+      size_t insert_owned(std::vector<::std::pair<Key, V> > const & entries) {
+        auto trans = [](::std::pair<Key, V> const & x) {
+          return ::std::make_pair(x.first, T(1));
+        };
+        return this->Base::local_insert(::bliss::iterator::make_transform_iterator(entries.begin(), trans),
+                                        ::bliss::iterator::make_transform_iterator(entries.end(), trans));
+      }
+
 
   };
 
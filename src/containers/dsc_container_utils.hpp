@@ -33,6 +33,7 @@
 #include "containers/fsc_container_utils.hpp"
 
 #include "utils/benchmark_utils.hpp"
+#include "utils/logging.h"
 
 #include <mxx/distribution.hpp>
 #include <mxx/samplesort.hpp>
@@ -43,11 +44,11 @@ namespace dsc {
 	bool empty(CONTAINER const & c, mxx::comm const & comm) {
 		bool local_empty = (c.size() == 0);
 	  if (comm.size() == 1) {
-			if (local_empty) printf("rank 0/1 input is EMPTY.\n");
+			if (local_empty) BL_DEBUGF("rank 0/1 input is EMPTY.");
 		return local_empty;
 	} else { // all reduce
 		local_empty =  mxx::all_of(local_empty, comm);
-		if (local_empty && comm.rank() == 0) printf("rank ALL/%d inputs are all EMPTY.\n", comm.size());
+		if (local_empty && comm.rank() == 0) BL_DEBUGF("rank ALL/%d inputs are all EMPTY.", comm.size());
 		return local_empty;
 	  }
 	}
@@ -638,7 +639,7 @@ namespace dsc {
       BL_BENCH_INIT(distribute);
         // go for speed.   mxx::bucketing uses extra copy.  okay, since all2all also does.
 
-  	if (_comm.rank() == 0) { printf("start\n");  fflush(stdout); }
+  	if (_comm.rank() == 0) { BL_DEBUGF("start"); }
 
 
         BL_BENCH_START(distribute);
@@ -646,16 +647,16 @@ namespace dsc {
         std::vector<size_t> send_counts = mxx::bucketing_inplace(vals, to_rank, _comm.size());
         BL_BENCH_END(distribute, "bucket", vals.size());
 
-    	if (_comm.rank() == 0) { printf("bucket\n");  fflush(stdout); }
+    	if (_comm.rank() == 0) { BL_DEBUGF("bucket"); }
 
-    	double mean, stdev;
+    	double mean = 0.0, stdev = 0.0;
     	for (auto it = send_counts.begin(), max = send_counts.end(); it != max; ++it) {
     		mean += *it;
     		stdev += (*it) * (*it);
     	}
     	mean /= _comm.size();
     	stdev -= sqrt((stdev / _comm.size()) - (mean * mean));
-    	if (_comm.rank() == 0) { printf("mean: %f, stdev %f\n", mean, stdev); fflush(stdout); }
+    	if (_comm.rank() == 0) { BL_DEBUGF("mean: %f, stdev %f", mean, stdev); }
 
 
         // using set is okay.
@@ -664,7 +665,7 @@ namespace dsc {
         ::fsc::bucket_reduce(vals, send_counts, sorted_input, reducer);
         BL_BENCH_END(distribute, "reduce", vals.size());
 
-    	if (_comm.rank() == 0) { printf("reduce\n");  fflush(stdout); }
+    	if (_comm.rank() == 0) { BL_DEBUGF("reduce"); }
 
 
         // distribute (communication part)
@@ -673,13 +674,13 @@ namespace dsc {
         BL_BENCH_END(distribute, "a2a", vals.size());
 
 
-    	if (_comm.rank() == 0) { printf("a2a\n");  fflush(stdout); }
+    	if (_comm.rank() == 0) { BL_DEBUGF("a2a"); }
 
         BL_BENCH_START(distribute);
         std::vector<size_t> recv_counts= mxx::all2all(send_counts, _comm);
         BL_BENCH_END(distribute, "a2a_counts", vals.size());
 
-    	if (_comm.rank() == 0) { printf("a2acounts\n");  fflush(stdout); }
+    	if (_comm.rank() == 0) { BL_DEBUGF("a2acounts"); }
 
         BL_BENCH_REPORT_MPI_NAMED(distribute, "map_base:distribute_reduce", _comm);
 
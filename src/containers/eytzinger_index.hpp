@@ -0,0 +1,140 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    eytzinger_index.hpp
+ * @ingroup fsc::containers
+ * @brief   read optimized lower_bound over a sorted array:  an Eytzinger (BFS order) tree of every stride-th key.
+ * @details a binary search over a large sorted array takes about 1 cache miss per halving.  here the top of the search
+ *          goes through a small array of sampled keys in BFS order, where the descendants of node k are at 2k and 2k+1,
+ *          so the nodes of the next few levels share cache lines and can be prefetched.  the descent is branchless.
+ *          the last step is a binary search over the stride elements between 2 samples, i.e. a few adjacent cache lines.
+ *          the index holds keys only and does not own the array.  rebuild it after the array changes.
+ */
+#ifndef SRC_CONTAINERS_EYTZINGER_INDEX_HPP_
+#define SRC_CONTAINERS_EYTZINGER_INDEX_HPP_
+
+#include <vector>
+#include <utility>   // pair
+#include <algorithm>  // lower_bound, min
+#include <iterator>  // distance
+#include <cstddef>   // size_t
+
+namespace fsc {  // fast standard container
+
+  /**
+   * @brief lower_bound positions in a sorted array of pairs, by the first element, via an Eytzinger tree of sampled keys.
+   * @tparam Key   key type, i.e. the first element of the array's pairs.
+   * @tparam Less  comparator that accepts (Key, Key) and (pair, Key), e.g. the maps' StoreTransformedFunc.
+   */
+  template <typename Key, typename Less>
+  class eytzinger_index {
+    protected:
+      /// sampled keys in BFS order.  1-based, tree[0] is unused.
+      ::std::vector<Key> tree;
+      /// sample number of each tree node.
+      ::std::vector<size_t> rank;
+      /// array element count between samples.
+      size_t stride;
+      /// size of the indexed array.
+      size_t n;
+
+      Less lt;
+
+      /// fill the subtree at node k with the samples from i on, in order.  returns the next sample.
+      template <typename Iter>
+      size_t fill(Iter first, size_t i, size_t const k) {
+        if (k >= tree.size()) return i;
+        i = fill(first, i, 2 * k);
+        tree[k] = (*(first + i * stride)).first;
+        rank[k] = i;
+        ++i;
+        return fill(first, i, 2 * k + 1);
+      }
+
+    public:
+      /// default stride:  about 4 cache lines of 16 byte entries.
+      static constexpr size_t default_stride = 16;
+
+      eytzinger_index(Less const & _lt = Less()) : stride(default_stride), n(0), lt(_lt) {}
+
+      /// index the sorted range [first, last), with one sample every _stride elements.  0 uses default_stride.
+      template <typename Iter>
+      void build(Iter first, Iter last, size_t const _stride = 0) {
+        stride = (_stride == 0) ? default_stride : _stride;
+        n = ::std::distance(first, last);
+
+        size_t m = (n + stride - 1) / stride;
+        tree.resize(m + 1);
+        rank.resize(m + 1);
+        fill(first, 0, 1);
+      }
+
+      void clear() {
+        ::std::vector<Key>().swap(tree);
+        ::std::vector<size_t>().swap(rank);
+        n = 0;
+      }
+
+      bool empty() const {
+        return n == 0;
+      }
+
+      /// size of the indexed array.
+      size_t size() const {
+        return n;
+      }
+
+      /// index of the first sample not less than v, or the number of samples if there is none.
+      template <typename V>
+      size_t sample_lower_bound(V const & v) const {
+        size_t const m = tree.size() - 1;
+        // about 1 cache line of nodes.  the descendants of k three or four levels down are contiguous from k * line.
+        constexpr size_t line = (sizeof(Key) < 64) ? (64 / sizeof(Key)) : 1;
+
+        size_t k = 1;
+        while (k <= m) {
+#if defined(__GNUC__)
+          __builtin_prefetch(tree.data() + ::std::min(k * line, m));
+#endif
+          k = 2 * k + static_cast<size_t>(lt(tree[k], v));
+        }
+        // undo the right turns after the last left turn.  k is 0 if every turn was right.
+        k >>= __builtin_ffsll(static_cast<long long>(~k));
+        return (k == 0) ? m : rank[k];
+      }
+
+      /// the range [lo, hi) of array positions that contains lower_bound(v).  hi is the lower bound if all of [lo, hi) is less.
+      template <typename V>
+      ::std::pair<size_t, size_t> block(V const & v) const {
+        if (n == 0) return ::std::make_pair(static_cast<size_t>(0), static_cast<size_t>(0));
+
+        size_t j = sample_lower_bound(v);
+        if (j == 0) return ::std::make_pair(static_cast<size_t>(0), static_cast<size_t>(0));
+        return ::std::make_pair((j - 1) * stride + 1, ::std::min(j * stride, n));
+      }
+
+      /// position of the lower bound of v in the indexed array, which starts at first.
+      template <typename Iter, typename V>
+      size_t lower_bound(Iter first, V const & v) const {
+        ::std::pair<size_t, size_t> b = block(v);
+        return ::std::distance(first, ::std::lower_bound(first + b.first, first + b.second, v, lt));
+      }
+  };
+
+}  // namespace fsc
+
+#endif // SRC_CONTAINERS_EYTZINGER_INDEX_HPP_
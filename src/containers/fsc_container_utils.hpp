@@ -28,9 +28,25 @@
 #include <iterator>  // iterator_traits
 #include <unordered_set>
 #include <algorithm>  // upper bound, unique, sort, etc.
+#include <cmath>  // log
+#include <random>  // uniform_int_distribution
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>  // integral_constant, conditional
+#include <utility>  // forward
+#include <memory>   // unique_ptr
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
 
 #include "utils/benchmark_utils.hpp"
 #include "utils/filter_utils.hpp"
+#include "utils/transform_utils.hpp"
+#include "containers/radix_sort.hpp"
+#include "containers/parallel_for_each.hpp"
+#include "utils/task_pool.hpp"
 
 namespace fsc {
 
@@ -63,17 +79,95 @@ namespace fsc {
 
 
 
+  /// number of keys a hash functor hashes per hash_batch call:  its static batch_size, or 1 if it has none (e.g. std::hash).
+  template <typename H, typename = void>
+  struct hash_batch_size : public ::std::integral_constant<uint8_t, 1> {};
+  template <typename H>
+  struct hash_batch_size<H, typename ::std::conditional<false, decltype(H::batch_size), void>::type> :
+    public ::std::integral_constant<uint8_t, H::batch_size> {};
+
+  namespace detail {
+    template <typename Hash, typename Key>
+    inline void hash_batch(Hash const & h, Key const * keys, size_t n, uint64_t * hashes, ::std::true_type) {
+      constexpr size_t batch = hash_batch_size<Hash>::value;
+      size_t i = 0;
+      for (; i + batch <= n; i += batch) {
+        h.hash_batch(keys + i, hashes + i);
+      }
+      for (; i < n; ++i) hashes[i] = h(keys[i]);
+    }
+    template <typename Hash, typename Key>
+    inline void hash_batch(Hash const & h, Key const * keys, size_t n, uint64_t * hashes, ::std::false_type) {
+      for (size_t i = 0; i < n; ++i) hashes[i] = h(keys[i]);
+    }
+  }
+
+  /// hash n keys, batch_size at a time if the hash has a batched (SIMD) version, and 1 at a time otherwise.
+  template <typename Hash, typename Key>
+  inline void hash_batch(Hash const & h, Key const * keys, size_t n, uint64_t * hashes) {
+    detail::hash_batch(h, keys, n, hashes, ::std::integral_constant<bool, (hash_batch_size<Hash>::value > 1)>());
+  }
+
+  namespace detail {
+    template <typename Map, typename Key>
+    inline auto prefetch_batch(Map const & m, Key const * keys, size_t n, int) -> decltype(m.prefetch(keys, n), void()) {
+      m.prefetch(keys, n);
+    }
+    template <typename Map, typename Key>
+    inline void prefetch_batch(Map const & m, Key const * keys, size_t n, long) {
+      for (size_t i = 0; i < n; ++i) m.prefetch(keys[i]);
+    }
+  }
+
+  /// prefetch for n keys, with the map's batched prefetch if it has one, and 1 key at a time otherwise.
+  template <typename Map, typename Key>
+  inline void prefetch_batch(Map const & m, Key const * keys, size_t n) {
+    detail::prefetch_batch(m, keys, n, 0);
+  }
+
+  namespace detail {
+    template <typename Map, typename Key, typename T, typename Reducer>
+    inline auto upsert(Map & m, Key const & k, T const & v, Reducer && r, int) -> decltype(m.upsert(k, v, r)) {
+      return m.upsert(k, v, r);
+    }
+    template <typename Map, typename Key, typename T, typename Reducer>
+    inline bool upsert(Map & m, Key const & k, T const & v, Reducer && r, long) {
+      auto result = m.insert(typename Map::value_type(k, v));
+      // failed insertion returns the existing entry, so reduce into it without probing again.
+      if (!(result.second)) result.first->second = r(result.first->second, v);
+      return result.second;
+    }
+  }
+
+  /// insert (k, v) if k is not in the map, else reduce v into the existing entry as r(existing, v).
+  /// probes the map once.  uses the map's own upsert if it has one, and insert otherwise.  map has to have unique keys.
+  /// @return true if a new entry was inserted.
+  template <typename Map, typename Key, typename T, typename Reducer>
+  inline bool upsert(Map & m, Key const & k, T const & v, Reducer && r) {
+    return detail::upsert(m, k, v, ::std::forward<Reducer>(r), 0);
+  }
+
+
   template <typename Key, template <typename> class Hash, template <typename> class Transform>
   struct TransformedHash {
       Hash<Key> h;
       Transform<Key> trans;
 
+      static constexpr uint8_t batch_size = hash_batch_size<Hash<Key> >::value;
+
       TransformedHash(Hash<Key> const & _hash = Hash<Key>(),
     		  Transform<Key> const &_trans = Transform<Key>()) : h(_hash), trans(_trans) {};
 
       inline uint64_t operator()(Key const& k) const {
         return h(trans(k));
       }
+
+      /// hash batch_size keys.  transforms them first, then hashes them as 1 batch.
+      inline void hash_batch(Key const * keys, uint64_t * hashes) const {
+        Key transformed[batch_size];
+        for (size_t i = 0; i < batch_size; ++i) transformed[i] = trans(keys[i]);
+        ::fsc::hash_batch(h, transformed, batch_size, hashes);
+      }
       template<typename V>
       inline uint64_t operator()(::std::pair<Key, V> const& x) const {
         return this->operator()(x.first);
@@ -85,6 +179,10 @@ namespace fsc {
   };
 
 
+  template <typename Key, template <typename> class Hash, template <typename> class Transform>
+  constexpr uint8_t TransformedHash<Key, Hash, Transform>::batch_size;
+
+
   template <typename Key, template <typename> class Predicate, template <typename> class Transform>
   struct TransformedPredicate {
       Predicate<Key> p;
@@ -195,6 +293,112 @@ namespace fsc {
       return b;
   }
 
+
+  namespace detail {
+    /// random access:  k distinct indices by Floyd's algorithm, O(k) without touching the other elements.
+    template <typename Iterator, typename Out, typename RNG>
+    void sample(Iterator b, size_t const n, size_t const k, RNG & gen, ::std::vector<Out> & out,
+                ::std::random_access_iterator_tag const &) {
+      ::std::unordered_set<size_t> picked(k);
+      for (size_t j = n - k; j < n; ++j) {
+        size_t t = ::std::uniform_int_distribution<size_t>(0, j)(gen);
+        if (!picked.insert(t).second) picked.insert(j);
+      }
+      ::std::vector<size_t> idx(picked.begin(), picked.end());
+      ::std::sort(idx.begin(), idx.end());
+      for (size_t i : idx) out.emplace_back((*(b + i)).first, (*(b + i)).second);
+    }
+
+    /// forward:  reservoir sampling, algorithm L (Li, 1994).  the iterator is advanced over the skipped elements, but
+    /// only O(k log(n / k)) of them are copied or draw random numbers.
+    template <typename Iterator, typename Out, typename RNG>
+    void sample(Iterator b, size_t const n, size_t const k, RNG & gen, ::std::vector<Out> & out,
+                ::std::forward_iterator_tag const &) {
+      size_t const first = out.size();
+      for (size_t i = 0; i < k; ++i, ++b) out.emplace_back((*b).first, (*b).second);
+
+      ::std::uniform_real_distribution<double> u(0.0, 1.0);
+      auto draw = [&u, &gen]() { double x; do { x = u(gen); } while (x <= 0.0); return x; };
+      double w = ::std::exp(::std::log(draw()) / static_cast<double>(k));
+      size_t i = k;   // index of *b.
+      while (true) {
+        double const skip = ::std::floor(::std::log(draw()) / ::std::log1p(-w));
+        if (skip >= static_cast<double>(n - i)) break;
+        ::std::advance(b, static_cast<size_t>(skip));
+        i += static_cast<size_t>(skip);
+        out[first + ::std::uniform_int_distribution<size_t>(0, k - 1)(gen)] = Out((*b).first, (*b).second);
+        ++b;
+        ++i;
+        w *= ::std::exp(::std::log(draw()) / static_cast<double>(k));
+      }
+    }
+  }
+
+  /**
+   * @brief append k entries of [b, b + n) chosen uniformly without replacement to out.  k >= n appends all.
+   * @details  entries are key/value pairs, converted to Out with Out(first, second), so maps whose iterators return
+   *           proxies (e.g. compact_counting_map) work too.  random access ranges draw k indices, others are reservoir
+   *           sampled in 1 pass.
+   */
+  template <typename Iterator, typename Out, typename RNG>
+  void sample(Iterator b, size_t const n, size_t const k, RNG & gen, ::std::vector<Out> & out) {
+    out.reserve(out.size() + ::std::min(k, n));
+    if (k == 0) return;
+    if (k >= n) {
+      for (size_t i = 0; i < n; ++i, ++b) out.emplace_back((*b).first, (*b).second);
+      return;
+    }
+    detail::sample(b, n, k, gen, out, typename ::std::iterator_traits<Iterator>::iterator_category());
+  }
+
+  /**
+   * @brief of m draws without replacement from a + b entries, the number that are among the first a.  hypergeometric.
+   * @details  inversion from the mode, alternately up and down with the pmf ratios, so O(standard deviation) steps.
+   *           the same generator state gives the same draw, e.g. on all ranks with a shared seed.
+   */
+  template <typename RNG>
+  size_t hypergeometric(size_t const a, size_t const b, size_t const m, RNG & gen) {
+    if ((m == 0) || (a == 0)) return 0;
+    if (b == 0) return m;
+    if (m >= a + b) return a;
+
+    size_t const lo = (m > b) ? m - b : 0;
+    size_t const hi = ::std::min(m, a);
+    size_t mode = static_cast<size_t>((static_cast<long double>(m) + 1.0L) * (static_cast<long double>(a) + 1.0L) /
+                                      (static_cast<long double>(a) + static_cast<long double>(b) + 2.0L));
+    mode = ::std::max(lo, ::std::min(hi, mode));
+
+    auto lchoose = [](long double n, long double k) {
+      return ::std::lgamma(n + 1.0L) - ::std::lgamma(k + 1.0L) - ::std::lgamma(n - k + 1.0L);
+    };
+    long double const pmode = ::std::exp(lchoose(a, mode) + lchoose(b, m - mode) - lchoose(a + b, m));
+
+    long double u = ::std::uniform_real_distribution<double>(0.0, 1.0)(gen);
+    u -= pmode;
+    if (u < 0.0L) return mode;
+
+    size_t up = mode, down = mode;
+    long double pup = pmode, pdown = pmode;
+    while (((up < hi) || (down > lo)) && (pup + pdown > 1e-30L)) {
+      if (up < hi) {
+        pup *= static_cast<long double>(a - up) * static_cast<long double>(m - up) /
+               (static_cast<long double>(up + 1) * static_cast<long double>(b + up + 1 - m));
+        ++up;
+        u -= pup;
+        if (u < 0.0L) return up;
+      } else pup = 0.0L;
+      if (down > lo) {
+        pdown *= static_cast<long double>(down) * static_cast<long double>(b + down - m) /
+                 (static_cast<long double>(a - down + 1) * static_cast<long double>(m - down + 1));
+        --down;
+        u -= pdown;
+        if (u < 0.0L) return down;
+      } else pdown = 0.0L;
+    }
+    // what is left of u is rounding.
+    return mode;
+  }
+
 //  ///  keep the unique keys in the input. primarily for reducing comm volume.
 //  ///  when sorted, ordering is unchanged.  when unsorted, ordering is not preserved.
 //  ///  equal operator forces comparison to Key only (not pairs or tuples)
@@ -320,13 +524,106 @@ namespace fsc {
   }
 
 
+  namespace detail {
+    /// comparators that order keys the same way as radix_sort:  std::less, and std::less after the identity transform.
+    /// only for keys of up to 8 bytes (e.g. k <= 32 for DNA).  longer keys take enough passes that a comparison sort is faster.
+    template <typename Less>
+    struct radix_less : public ::std::false_type {};
+    template <typename K>
+    struct radix_less<::std::less<K> > :
+      public ::std::integral_constant<bool, radix_key_traits<K>::value && (radix_key_traits<K>::bytes <= 8)> {
+        using key_type = K;
+    };
+    template <typename K>
+    struct radix_less<TransformedComparator<K, ::std::less, ::bliss::transform::identity> > :
+      public radix_less<::std::less<K> > {};
+
+    /// elements that radix_sort orders by the key of Less:  the key, or a pair with the key as first.
+    template <typename V, typename Less, bool = radix_less<Less>::value>
+    struct radix_sortable : public ::std::false_type {};
+    template <typename V, typename Less>
+    struct radix_sortable<V, Less, true> :
+      public ::std::integral_constant<bool, ::std::is_same<V, typename radix_less<Less>::key_type>::value> {};
+    template <typename K, typename T, typename Less>
+    struct radix_sortable<::std::pair<K, T>, Less, true> :
+      public ::std::is_same<K, typename radix_less<Less>::key_type> {};
+
+    /// the same comparators on k-mers of more than 64 bits in 64 bit words, which are prefix sorted.  see ::fsc::prefix_sort.
+    template <typename Less>
+    struct prefix_less : public ::std::false_type {};
+    template <typename K>
+    struct prefix_less<::std::less<K> > : public ::std::integral_constant<bool, prefix_key_traits<K>::value> {
+        using key_type = K;
+    };
+    template <typename K>
+    struct prefix_less<TransformedComparator<K, ::std::less, ::bliss::transform::identity> > :
+      public prefix_less<::std::less<K> > {};
+
+    template <typename V, typename Less, bool = prefix_less<Less>::value>
+    struct prefix_sortable : public ::std::false_type {};
+    template <typename V, typename Less>
+    struct prefix_sortable<V, Less, true> :
+      public ::std::integral_constant<bool, ::std::is_same<V, typename prefix_less<Less>::key_type>::value> {};
+    template <typename K, typename T, typename Less>
+    struct prefix_sortable<::std::pair<K, T>, Less, true> :
+      public ::std::is_same<K, typename prefix_less<Less>::key_type> {};
+
+    template <typename V, typename Less>
+    inline void comparison_sort(::std::vector<V> & input, Less const & less, ::std::false_type) {
+      ::std::sort(input.begin(), input.end(), less);
+    }
+    template <typename V, typename Less>
+    inline void comparison_sort(::std::vector<V> & input, Less const &, ::std::true_type) {
+      ::fsc::prefix_sort(input);
+    }
+
+    template <typename V, typename Less>
+    inline void sort(::std::vector<V> & input, Less const & less, ::std::false_type) {
+      comparison_sort(input, less, prefix_sortable<V, Less>());
+    }
+    template <typename V, typename Less>
+    inline void sort(::std::vector<V> & input, Less const &, ::std::true_type) {
+      ::fsc::radix_sort(input);
+    }
+
+    template <typename V, typename Less>
+    inline void comparison_sort_range(V * first, V * last, ::std::vector<V> &, Less const & less, ::std::false_type) {
+      ::std::sort(first, last, less);
+    }
+    template <typename V, typename Less>
+    inline void comparison_sort_range(V * first, V * last, ::std::vector<V> & scratch, Less const &, ::std::true_type) {
+      ::fsc::prefix_sort(first, last, scratch);
+    }
+
+    template <typename V, typename Less>
+    inline void sort_range(V * first, V * last, ::std::vector<V> & scratch, Less const & less, ::std::false_type) {
+      comparison_sort_range(first, last, scratch, less, prefix_sortable<V, Less>());
+    }
+    template <typename V, typename Less>
+    inline void sort_range(V * first, V * last, ::std::vector<V> & scratch, Less const &, ::std::true_type) {
+      ::fsc::radix_sort(first, last, scratch);
+    }
+
+    /// radix sort scratch of the calling thread.  kept between calls on the task pool's threads.
+    template <typename V>
+    inline ::std::vector<V> & sort_scratch() {
+      return ::bliss::utils::task_pool::thread_scratch<::std::vector<V> >();
+    }
+    /// free a scratch larger than 64MB instead of keeping it.
+    template <typename V>
+    inline void trim_sort_scratch(::std::vector<V> & scratch) {
+      if (scratch.capacity() * sizeof(V) > (64UL << 20)) ::std::vector<V>().swap(scratch);
+    }
+  }
+
   ///  keep the unique keys in the input. primarily for reducing comm volume.
   /// output is SORTED.  when input is sorted, ordering is unchanged.
   /// equal operator forces comparison to Key only (not pairs or tuples)
+  /// k-mer and unsigned integer keys of up to 8 bytes compared by std::less are radix sorted, longer k-mers prefix sorted.
   template <typename V, typename Less>
   void sort(::std::vector<V> & input, bool & sorted_input,
                    const Less & less = Less()) {
-    if (!sorted_input) ::std::sort(input.begin(), input.end(), less);
+    if (!sorted_input) detail::sort(input, less, detail::radix_sortable<V, Less>());
 
     sorted_input = true;
   }
@@ -339,7 +636,7 @@ namespace fsc {
   void sorted_unique(::std::vector<V> & input, bool & sorted_input,
                    const Less & less = Less(), const Eq & equal = Eq()) {
     if (input.size() == 0) return;
-    if (!sorted_input) ::std::sort(input.begin(), input.end(), less);
+    if (!sorted_input) detail::sort(input, less, detail::radix_sortable<V, Less>());
     // then just get the unique stuff and remove rest.
     auto end = ::std::unique(input.begin(), input.end(), equal);
     input.erase(end, input.end());
@@ -347,80 +644,102 @@ namespace fsc {
     sorted_input = true;
   }
 
+  /// start offset of each bucket, from the bucket sizes.  exclusive prefix sum.
+  template <typename count_t>
+  ::std::vector<size_t> bucket_offsets(std::vector<count_t> const & send_counts) {
+    ::std::vector<size_t> offsets(send_counts.size() + 1, 0);
+    for (size_t i = 0; i < send_counts.size(); ++i) {
+      offsets[i + 1] = offsets[i] + send_counts[i];
+    }
+    return offsets;
+  }
+
+  /// move the first new_counts[i] entries of each bucket i forward so that the buckets are contiguous again,
+  /// then update send_counts and remove the rest.  offsets are the original bucket start positions.
+  /// buckets are moved in order, so this is sequential.  it is a linear pass, vs. the per bucket work done in parallel.
+  template <typename T, typename count_t>
+  void compact_buckets(std::vector<T>& input, std::vector<count_t> &send_counts,
+                       ::std::vector<size_t> const & offsets, std::vector<count_t> const & new_counts) {
+    auto newend = input.begin();
+    for (size_t i = 0; i < send_counts.size(); ++i) {
+      auto start = input.begin() + offsets[i];
+      if (start == newend) newend += new_counts[i];
+      else newend = ::std::move(start, start + new_counts[i], newend);
+
+      send_counts[i] = new_counts[i];
+    }
+
+    // compact.
+    input.erase(newend, input.end());
+  }
+
   /// keep the unique entries within each bucket.  complexity is b * O(N/b), where b is the bucket size, and O(N/b) is complexity of inserting into and copying from set.
   /// when used within bucket, scales with O(N/b), not with b.  this is as good as it gets wrt complexity.
   /// sortedness is MAINTAINED within buckets
+  /// buckets are processed concurrently on the task pool, each thread with its own set.
   template<typename T, typename count_t, typename Hash, typename Eq>
   void bucket_unique(std::vector<T>& input, std::vector<count_t> &send_counts, bool & sorted_input,
                           const Hash & hash = Hash(), const Eq & equal = Eq()) {
 
-    auto newstart = input.begin();
-    auto newend = newstart;
-    auto start = input.begin();
-    auto end = start;
+    if (send_counts.size() == 0) return;
 
+    ::std::vector<size_t> offsets = bucket_offsets(send_counts);
+    ::std::vector<count_t> new_counts(send_counts.size(), 0);
+    long nbuckets = send_counts.size();
 
     if (sorted_input) {
 
-      for (size_t i = 0; i < send_counts.size(); ++i) {
-        end = start + send_counts[i];
-
-        if (i == 0)
-          newend = ::std::unique(start, end, equal);
-        else
-          newend = ::std::unique_copy(start, end, newstart, equal);
-
-        send_counts[i] = ::std::distance(newstart, newend);
+      ::fsc::parallel_for_dynamic(nbuckets, [&](size_t const i, int const) {
+        auto start = input.begin() + offsets[i];
+        auto end = input.begin() + offsets[i + 1];
 
-        start = end;
-        newstart = newend;
-      }
+        new_counts[i] = ::std::distance(start, ::std::unique(start, end, equal));
+      });
 
     } else {
 
       count_t max = *(::std::max_element(send_counts.begin(), send_counts.end()));
-      ::std::unordered_set<T, Hash, Eq> set(max, hash, equal);
 
-      for (size_t i = 0; i < send_counts.size(); ++i) {
-        end = start + send_counts[i];
+      // 1 set per thread, created by the thread on first use.
+      ::std::vector<::std::unique_ptr<::std::unordered_set<T, Hash, Eq> > > sets(::fsc::parallel_for_each_threads(0));
 
-        // sorting is SLOW and not scalable.  use unordered set instead.
-        // unordered_set for large data is memory intensive.  depending on use, bucket per processor first.
-        set.clear();
-        set.insert(start, end);
-        newend = ::std::copy(set.begin(), set.end(), newstart);
+      ::fsc::parallel_for_dynamic(nbuckets, [&](size_t const i, int const tid) {
+        auto start = input.begin() + offsets[i];
+        auto end = input.begin() + offsets[i + 1];
 
-        send_counts[i] = ::std::distance(newstart, newend);
+        if (!sets[tid]) sets[tid].reset(new ::std::unordered_set<T, Hash, Eq>(max, hash, equal));
 
-        start = end;
-        newstart = newend;
-      }
+        // sorting is SLOW and not scalable.  use unordered set instead.
+        // unordered_set for large data is memory intensive.  depending on use, bucket per processor first.
+        sets[tid]->clear();
+        sets[tid]->insert(start, end);
+        new_counts[i] = ::std::distance(start, ::std::copy(sets[tid]->begin(), sets[tid]->end(), start));
+      });
 
     }
 
-    // compact.
-    input.erase(newend, input.end());
+    compact_buckets(input, send_counts, offsets, new_counts);
   }
 
 
   /// keep the unique entries within each bucket.  complexity is b * O(N/b), where b is the bucket size, and O(N/b) is complexity of inserting into and copying from set.
   /// when used within bucket, scales with O(N/b), not with b.  this is as good as it gets wrt complexity.
   /// sortedness is MAINTAINED within buckets
+  /// buckets are sorted concurrently on the task pool, with per thread radix sort scratch kept between calls.
   template<typename T, typename count_t, typename Less>
   void bucket_sort(std::vector<T>& input, std::vector<count_t> &send_counts, bool & sorted_input,
                           const Less & less = Less()) {
 
     if (!sorted_input) {
-      auto start = input.begin();
-      auto end = start;
-
-      for (size_t i = 0; i < send_counts.size(); ++i) {
-        end = start + send_counts[i];
-
-        ::std::sort(start, end, less);
-
-        start = end;
-      }
+      ::std::vector<size_t> offsets = bucket_offsets(send_counts);
+      long nbuckets = send_counts.size();
+
+      ::fsc::parallel_for_dynamic(nbuckets, [&](size_t const i, int const) {
+        ::std::vector<T> & scratch = detail::sort_scratch<T>();  // for radix sort, per thread.
+        detail::sort_range(input.data() + offsets[i], input.data() + offsets[i + 1], scratch, less,
+                           detail::radix_sortable<T, Less>());
+        detail::trim_sort_scratch(scratch);
+      });
       sorted_input = true;
     }
 
@@ -429,36 +748,33 @@ namespace fsc {
   /// keep the unique entries within each bucket.  complexity is b * O(N/b), where b is the bucket size, and O(N/b) is complexity of inserting into and copying from set.
   /// when used within bucket, scales with O(N/b), not with b.  this is as good as it gets wrt complexity.
   /// sortedness is MAINTAINED within buckets
+  /// buckets are sorted and made unique concurrently on the task pool.
   template<typename T, typename count_t, typename Less, typename Eq>
   void bucket_sorted_unique(std::vector<T>& input, std::vector<count_t> &send_counts, bool & sorted_input,
                           const Less & less = Less(), const Eq & equal = Eq()) {
 
-    auto newstart = input.begin();
-    auto newend = newstart;
-    auto start = input.begin();
-    auto end = start;
+    if (send_counts.size() == 0) return;
 
-    for (size_t i = 0; i < send_counts.size(); ++i) {
-      end = start + send_counts[i];
-
-      if (!sorted_input) {
-        ::std::sort(start, end, less);
-      }
+    ::std::vector<size_t> offsets = bucket_offsets(send_counts);
+    ::std::vector<count_t> new_counts(send_counts.size(), 0);
+    long nbuckets = send_counts.size();
+    bool const presorted = sorted_input;
 
-      if (i == 0)
-        newend = ::std::unique(start, end, equal);
-      else
-        newend = ::std::unique_copy(start, end, newstart, equal);
+    ::fsc::parallel_for_dynamic(nbuckets, [&](size_t const i, int const) {
+      auto start = input.begin() + offsets[i];
+      auto end = input.begin() + offsets[i + 1];
 
-      send_counts[i] = ::std::distance(newstart, newend);
-
-      start = end;
-      newstart = newend;
-    }
+      if (!presorted) {
+        ::std::vector<T> & scratch = detail::sort_scratch<T>();  // for radix sort, per thread.
+        detail::sort_range(input.data() + offsets[i], input.data() + offsets[i + 1], scratch, less,
+                           detail::radix_sortable<T, Less>());
+        detail::trim_sort_scratch(scratch);
+      }
 
+      new_counts[i] = ::std::distance(start, ::std::unique(start, end, equal));
+    });
 
-    // compact.
-    input.erase(newend, input.end());
+    compact_buckets(input, send_counts, offsets, new_counts);
 
     sorted_input = true;
   }
@@ -467,36 +783,30 @@ namespace fsc {
   /// keep the unique entries within each bucket.  complexity is b * O(N/b), where b is the bucket size, and O(N/b) is complexity of inserting into and copying from set.
   /// when used within bucket, scales with O(N/b), not with b.  this is as good as it gets wrt complexity.
   /// sortedness is MAINTAINED within buckets
+  /// buckets are reduced concurrently on the task pool, in place, so the reducer has to be safe to call from multiple threads
+  /// on disjoint ranges.
   template<typename T, typename count_t, typename Reduc>
   void bucket_reduce(std::vector<T>& input, std::vector<count_t> &send_counts, bool & sorted_input,
                           const Reduc & reducer = Reduc()) {
 
-	    auto newstart = input.begin();
-	    auto newend = newstart;
-	    auto start = input.begin();
-	    auto end = start;
-
-	    bool sorted = sorted_input;
-
-	    for (size_t i = 0; i < send_counts.size(); ++i) {
-
-	      end = start + send_counts[i];
-
-	      sorted = sorted_input;
-	      if (i == 0)
-	        newend = reducer(start, end, start, sorted);
-	      else
-	        newend = reducer(start, end, newstart, sorted);
+	    if (send_counts.size() == 0) return;
 
-	      send_counts[i] = ::std::distance(newstart, newend);
+	    ::std::vector<size_t> offsets = bucket_offsets(send_counts);
+	    ::std::vector<count_t> new_counts(send_counts.size(), 0);
+	    long nbuckets = send_counts.size();
+	    bool const presorted = sorted_input;
 
-	      start = end;
-	      newstart = newend;
-	    }
+	    ::fsc::parallel_for_dynamic(nbuckets, [&](size_t const i, int const) {
+	      // reducer takes references.
+	      auto start = input.begin() + offsets[i];
+	      auto end = input.begin() + offsets[i + 1];
+	      auto out = start;
+	      bool sorted = presorted;
 
+	      new_counts[i] = ::std::distance(start, reducer(start, end, out, sorted));
+	    });
 
-	    // compact.
-	    input.erase(newend, input.end());
+	    compact_buckets(input, send_counts, offsets, new_counts);
 
 	    sorted_input = true;
   }
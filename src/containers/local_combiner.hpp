@@ -0,0 +1,185 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    local_combiner.hpp
+ * @ingroup fsc::containers
+ * @brief   small, cache sized, lossless pre-aggregation of (key, value) tuples before they are distributed.
+ * @details with high coverage, a key is seen many times within a short stretch of the input.  a combiner that fits in L2
+ *          absorbs these repeats, so fewer tuples are bucketed, sent, and inserted.
+ *
+ *          the combiner is a 4-way set associative table.  a tuple whose key is in its set is reduced in place.  otherwise
+ *          it takes an empty slot in the set, or evicts an occupant to the output.  flush() then outputs the occupied slots.
+ *          every input value ends up in exactly one output tuple, so the result is exact for an associative and
+ *          commutative reduction.  a key may appear more than once in the output (after an eviction).
+ */
+#ifndef SRC_CONTAINERS_LOCAL_COMBINER_HPP_
+#define SRC_CONTAINERS_LOCAL_COMBINER_HPP_
+
+#include <vector>
+#include <functional>  // equal_to, plus
+#include <utility>   // pair
+#include <algorithm>  // max
+#include <cstdint>  // uint8_t
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace fsc {  // fast standard container
+
+
+/**
+ * @brief set associative (key, value) combiner.  see file description.
+ * @tparam Hash    hash functor on Key.  the result is mixed before taking the slot, so the low bits need not be random.
+ * @tparam Reduc   reduction, called as r(existing, new).  needs to be associative and commutative.
+ */
+template <typename Key, typename T,
+  typename Hash = ::std::hash<Key>,
+  typename Reduc = ::std::plus<T>,
+  typename Equal = ::std::equal_to<Key> >
+class local_combiner {
+  public:
+    using value_type = ::std::pair<Key, T>;
+
+    /// slots per set.
+    static constexpr uint8_t ways = 4;
+
+  protected:
+    ::std::vector<value_type> slots;
+    ::std::vector<uint8_t> occupied;
+    size_t mask;
+
+    Hash hash;
+    Reduc r;
+    Equal eq;
+
+  public:
+    /// combiner using up to _bytes of memory.  the slot count is the largest power of 2 that fits, at least 1 set.
+    explicit local_combiner(size_t _bytes = (1UL << 18), Hash const & _hash = Hash(), Reduc const & _r = Reduc(),
+                            Equal const & _eq = Equal()) :
+      mask(0), hash(_hash), r(_r), eq(_eq) {
+      size_t n = ways;
+      while ((n << 1) * (sizeof(value_type) + 1) <= _bytes) n <<= 1;
+      slots.resize(n);
+      occupied.resize(n, 0);
+      mask = n - 1;
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+    /// add a tuple.  an evicted tuple is appended to output.
+    inline void add(Key const & k, T const & v, ::std::vector<value_type> & output) {
+      uint64_t h = ::bliss::utils::mix64(static_cast<uint64_t>(hash(k)));
+      size_t set = (h & mask) & ~(static_cast<size_t>(ways) - 1);
+      for (size_t i = set; i < set + ways; ++i) {
+        if (!occupied[i]) {
+          slots[i].first = k;
+          slots[i].second = v;
+          occupied[i] = 1;
+          return;
+        } else if (eq(slots[i].first, k)) {
+          slots[i].second = r(slots[i].second, v);
+          return;
+        }
+      }
+      // set is full.  evict a slot chosen by the high hash bits.
+      size_t i = set + ((h >> 60) & (ways - 1));
+      output.emplace_back(slots[i]);
+      slots[i].first = k;
+      slots[i].second = v;
+    }
+    inline void add(value_type const & x, ::std::vector<value_type> & output) {
+      add(x.first, x.second, output);
+    }
+    /// add a key, counted as 1.
+    inline void add(Key const & k, ::std::vector<value_type> & output) {
+      add(k, T(1), output);
+    }
+
+    /// append the held tuples to output, and empty the combiner.
+    void flush(::std::vector<value_type> & output) {
+      for (size_t i = 0; i < slots.size(); ++i) {
+        if (occupied[i]) {
+          output.emplace_back(slots[i]);
+          occupied[i] = 0;
+        }
+      }
+    }
+};
+
+
+/**
+ * @brief combine keys (counted as 1 each) or (key, value) tuples.  the combined tuples replace the content of output.
+ * @details  with OpenMP the input is split into contiguous parts, one per thread, each with its own combiner of _bytes.
+ *           keys repeated across parts are combined only within each part.  the combined size is at most the input size.
+ */
+template <typename Key, typename T, typename Hash = ::std::hash<Key>, typename Reduc = ::std::plus<T>, typename Equal = ::std::equal_to<Key>,
+  typename V>
+void combine(::std::vector<V> const & input, ::std::vector<::std::pair<Key, T> > & output,
+             size_t _bytes = (1UL << 18), Hash const & _hash = Hash(), Reduc const & _r = Reduc(),
+             Equal const & _eq = Equal()) {
+  using combiner_type = local_combiner<Key, T, Hash, Reduc, Equal>;
+  output.clear();
+  if (input.size() == 0) return;
+
+  int nthreads = 1;
+#if defined(USE_OPENMP)
+  // each thread needs enough input to amortize its flush.
+  nthreads = omp_get_max_threads();
+  size_t per = (combiner_type(_bytes).capacity() * 4);
+  if (input.size() / per < static_cast<size_t>(nthreads)) nthreads = ::std::max(static_cast<size_t>(1), input.size() / per);
+#endif
+
+  ::std::vector<::std::vector<::std::pair<Key, T> > > parts(nthreads);
+
+#if defined(USE_OPENMP)
+#pragma omp parallel num_threads(nthreads)
+#endif
+  {
+    int tid = 0;
+#if defined(USE_OPENMP)
+    tid = omp_get_thread_num();
+#endif
+    size_t first = input.size() * tid / nthreads;
+    size_t last = input.size() * (tid + 1) / nthreads;
+
+    combiner_type comb(_bytes, _hash, _r, _eq);
+    ::std::vector<::std::pair<Key, T> > & part = (nthreads == 1) ? output : parts[tid];
+    part.reserve((last - first) / 2);
+    for (size_t i = first; i < last; ++i) {
+      comb.add(input[i], part);
+    }
+    comb.flush(part);
+  }
+
+  if (nthreads > 1) {
+    size_t total = 0;
+    for (int i = 0; i < nthreads; ++i) total += parts[i].size();
+    output.reserve(total);
+    for (int i = 0; i < nthreads; ++i) {
+      output.insert(output.end(), parts[i].begin(), parts[i].end());
+      ::std::vector<::std::pair<Key, T> >().swap(parts[i]);
+    }
+  }
+}
+
+
+}  // namespace fsc
+
+#endif // SRC_CONTAINERS_LOCAL_COMBINER_HPP_
@@ -0,0 +1,799 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    mphf_map.hpp
+ * @ingroup fsc::containers
+ * @brief   static map over a minimal perfect hash function, for indices that are built once and then queried.
+ * @details the open addressing maps keep 20% to 50% of the slots empty, plus 2 special keys.  this map keeps the
+ *          entries in dense key and value arrays with no empty slots, and finds the slot of a key with a minimal
+ *          perfect hash function (MPHF) that maps the n keys to 0..n-1.
+ *
+ *          the MPHF is BBHash style (Limasset et al. 2017):  level 0 is a bit array of gamma * n bits.  each key
+ *          sets the bit at its level 0 hash, and bits hit by more than 1 key are cleared.  keys on a bit that stayed
+ *          set are placed;  the rest go to level 1, which has gamma times as many bits as there are keys left, and so on.
+ *          the slot of a key is the rank (number of set bits before it) of its bit in the concatenated levels.
+ *          a lookup hashes the key once with the map's hash, then remixes that hash for each level until it hits a set
+ *          bit, about 1.6 levels on average at gamma = 2.  the function takes about 3.7 bits per key at gamma = 2
+ *          (about 3 at gamma = 1, with more levels), plus 1/7 bit per bit for the rank counts.
+ *
+ *          keys that are not placed after max_levels (e.g. distinct keys with equal 64 bit hashes) are kept in a small
+ *          ::fsc::soa_hash_map from key to slot.  single element insert() also appends to that table, so the usual map
+ *          interface works;  bulk insert and erase rebuild the function over all entries, and build() does so
+ *          explicitly.  a rebuild is O(n), so the intended use is 1 bulk insert per rank (the distributed insert does
+ *          exactly that) followed by queries.
+ *
+ *          this trades lookup time for space.  for 4M 64 bit keys with 32 bit values the map takes 50MB, against 104MB
+ *          for ::fsc::soa_hash_map and 128MB for ::fsc::densehash_map, but a lookup reads the function before the key,
+ *          2 dependent cache misses instead of 1, and is about 3x slower than soa_hash_map.
+ *
+ *          the MPHF maps keys that are not in the map to arbitrary slots, so the key in the slot is compared.  with
+ *          fingerprint bits > 0 (::fsc::fingerprinted_mphf<bits>::map) an 8 or 16 bit fingerprint per slot is compared
+ *          first, and the key only on a fingerprint match, so a miss reads the much smaller fingerprint array instead
+ *          of the key array, except for 1 in 2^bits of them.
+ *
+ *          the template parameters are the same as ::fsc::densehash_map, so this can be used as the Container
+ *          for ::dsc::densehash_map_base.  SpecialKeys is only used to construct the Equal object when that
+ *          requires (empty, deleted) keys, e.g. ::fsc::sparsehash::compare.  the split parameter is ignored.
+ *
+ *          iterators dereference to ::std::pair<Key const &, T &>, which refer into the 2 arrays.
+ *          iterators are invalidated by every insert and erase.
+ */
+#ifndef SRC_CONTAINERS_MPHF_MAP_HPP_
+#define SRC_CONTAINERS_MPHF_MAP_HPP_
+
+#include <vector>
+#include <functional>  // hash, equal_to, etc
+#include <utility>   // pair
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>   // ceil
+#include <cstdint>  // uint8_t
+
+#include "containers/fsc_container_utils.hpp"
+#include "containers/soa_hash_map.hpp"
+#include "utils/transform_utils.hpp"
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace fsc {  // fast standard container
+
+  namespace mphf {
+
+    inline unsigned int popcount(uint64_t x) {
+#if defined(__GNUC__)
+      return __builtin_popcountll(x);
+#else
+      x = x - ((x >> 1) & 0x5555555555555555ULL);
+      x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+      x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+      return static_cast<unsigned int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    /**
+     * @brief BBHash style minimal perfect hash function over 64 bit key hashes.
+     * @details  see file description.  the levels are concatenated into 1 bit array, which is stored 7 words per 64
+     *           byte line, with the number of set bits before the line in the 8th word.  testing a bit and ranking it
+     *           then read the same cache line.
+     */
+    class bbhash {
+      public:
+        static constexpr unsigned int max_levels = 24;
+        static constexpr size_t npos = ~(static_cast<size_t>(0));
+
+      protected:
+        static constexpr unsigned int words_per_line = 7;
+
+        double gamma;
+
+        /// 8 words per line, plus up to 7 words to align the lines to 64 bytes.
+        ::std::vector<uint64_t> storage;
+        /// first bit of each level, plus the total.  all multiples of 64.
+        ::std::vector<size_t> offsets;
+
+        /// independent hash per level, from the key's hash.
+        static inline uint64_t level_hash(uint64_t const & h, unsigned int const & level) {
+          return ::bliss::utils::mix64(h + (level + 1) * 0x9E3779B97F4A7C15ULL);
+        }
+
+        /// maps x to [0, m) without a division.
+        static inline size_t reduce(uint64_t const & x, size_t const & m) {
+#if defined(__SIZEOF_INT128__)
+          return static_cast<size_t>((static_cast<unsigned __int128>(x) * m) >> 64);
+#else
+          return x % m;
+#endif
+        }
+
+        /// first line.  computed on each use, so that copies of the vector need no fixup.
+        inline uint64_t const * lines() const {
+          uintptr_t a = reinterpret_cast<uintptr_t>(storage.data());
+          return storage.data() + (((64 - (a & 63)) & 63) >> 3);
+        }
+
+        /// line that holds bit pos.
+        inline uint64_t const * line_of(size_t const & pos) const {
+          return lines() + ((pos >> 6) / words_per_line) * 8;
+        }
+
+        /// rank of bit pos within its line, plus the count before the line.  no branch.
+        static inline size_t rank(uint64_t const * line, size_t const & pos) {
+          size_t const w = (pos >> 6) % words_per_line;
+          size_t r = line[words_per_line] + popcount(line[w] & ((1ULL << (pos & 63)) - 1));
+          for (size_t j = 0; j < words_per_line; ++j) {
+            r += popcount(line[j] & ((j < w) ? ~0ULL : 0ULL));
+          }
+          return r;
+        }
+
+      public:
+        bbhash(double const & _gamma = 2.0) : gamma(::std::max(_gamma, 1.0)), offsets(1, 0) {}
+
+        /**
+         * @brief build over n hashes.
+         * @param hashes  the hashes of the n distinct keys.
+         * @param unplaced  the indices (into hashes) of the keys that are not placed after max_levels.  the placed keys
+         *                  go to 0..(n - unplaced.size() - 1).
+         */
+        void build(::std::vector<uint64_t> const & hashes, ::std::vector<size_t> & unplaced) {
+          clear();
+
+          ::std::vector<uint64_t> bits;
+          ::std::vector<size_t> active(hashes.size());
+          for (size_t i = 0; i < active.size(); ++i) active[i] = i;
+          ::std::vector<size_t> next;
+          ::std::vector<uint64_t> collide;
+
+          for (unsigned int level = 0; (level < max_levels) && (active.size() > 0); ++level) {
+            size_t m = static_cast<size_t>(::std::ceil(gamma * static_cast<double>(active.size())));
+            m = ((::std::max(m, static_cast<size_t>(64)) + 63) >> 6) << 6;
+
+            size_t start = bits.size();
+            bits.resize(start + (m >> 6), 0);
+            collide.assign(m >> 6, 0);
+            uint64_t * level_bits = bits.data() + start;
+
+            size_t pos;
+            uint64_t b;
+            for (size_t i : active) {
+              pos = reduce(level_hash(hashes[i], level), m);
+              b = 1ULL << (pos & 63);
+              if (level_bits[pos >> 6] & b) collide[pos >> 6] |= b;
+              else level_bits[pos >> 6] |= b;
+            }
+            for (size_t w = 0; w < collide.size(); ++w) level_bits[w] &= ~collide[w];
+
+            next.clear();
+            for (size_t i : active) {
+              pos = reduce(level_hash(hashes[i], level), m);
+              if (((level_bits[pos >> 6] >> (pos & 63)) & 1) == 0) next.push_back(i);
+            }
+            active.swap(next);
+            offsets.push_back(bits.size() << 6);
+          }
+          unplaced.swap(active);
+
+          // pack into lines, with the count before each line.
+          size_t const nlines = (bits.size() + words_per_line - 1) / words_per_line;
+          storage.assign(nlines * 8 + 7, 0);
+          uint64_t * out = const_cast<uint64_t *>(lines());
+          size_t r = 0;
+          for (size_t w = 0; w < bits.size(); ++w) {
+            uint64_t * line = out + (w / words_per_line) * 8;
+            if ((w % words_per_line) == 0) line[words_per_line] = r;
+            line[w % words_per_line] = bits[w];
+            r += popcount(bits[w]);
+          }
+        }
+
+        void clear() {
+          storage.clear();
+          offsets.assign(1, 0);
+        }
+
+        /// slot of a key from its hash, or npos if no level has it.  keys that were not built over get arbitrary slots.
+        size_t lookup(uint64_t const & h) const {
+          size_t const levels = offsets.size() - 1;
+          size_t pos;
+          uint64_t const * line;
+          for (size_t level = 0; level < levels; ++level) {
+            pos = offsets[level] + reduce(level_hash(h, level), offsets[level + 1] - offsets[level]);
+            line = line_of(pos);
+            if ((line[(pos >> 6) % words_per_line] >> (pos & 63)) & 1) return rank(line, pos);
+          }
+          return npos;
+        }
+
+        /// prefetch the level 0 line of a key.
+        inline void prefetch(uint64_t const & h) const {
+#if defined(__GNUC__)
+          if (offsets.size() < 2) return;
+          __builtin_prefetch(line_of(reduce(level_hash(h, 0), offsets[1])), 0, 1);
+#endif
+        }
+
+        size_t levels() const {
+          return offsets.size() - 1;
+        }
+
+        /// bits of the function, including the counts.
+        size_t size_in_bits() const {
+          return storage.size() * 64;
+        }
+    };
+
+  }  // namespace mphf
+
+
+/**
+ * @brief static map with dense key and value arrays, indexed by a minimal perfect hash function.
+ * @details  see file description.  interface follows ::fsc::densehash_map.
+ * @tparam fingerprint_bits  0, 8, or 16.  see ::fsc::fingerprinted_mphf.
+ */
+template <typename Key,
+typename T,
+typename SpecialKeys = ::fsc::soa::no_special_keys,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+bool split = SpecialKeys::need_to_split,
+uint8_t fingerprint_bits = 0 >
+class basic_mphf_map {
+
+    static_assert((fingerprint_bits == 0) || (fingerprint_bits == 8) || (fingerprint_bits == 16),
+                  "mphf map fingerprints are 0, 8, or 16 bits.");
+
+  protected:
+    using key_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<Key>;
+    using val_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    using fingerprint_type = typename ::std::conditional<(fingerprint_bits > 8), uint16_t, uint8_t>::type;
+    using fp_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<fingerprint_type>;
+    using fallback_type = ::fsc::soa_hash_map<Key, size_t, SpecialKeys, Transform, Hash, Equal,
+        typename ::std::allocator_traits<Allocator>::template rebind_alloc<::std::pair<const Key, size_t> > >;
+
+    SpecialKeys specials;
+    Hash hash;
+    Equal eq;
+
+    ::fsc::mphf::bbhash func;
+    /// bits per key of each level of the function.
+    double gamma;
+
+    ::std::vector<Key, key_alloc_type> keys_;
+    ::std::vector<T, val_alloc_type> vals_;
+    /// empty if fingerprint_bits is 0.
+    ::std::vector<fingerprint_type, fp_alloc_type> fps_;
+
+    /// slots of the keys that the function does not place:  single inserts since the last build, and build failures.
+    fallback_type fallback;
+
+  public:
+    using key_type              = Key;
+    using mapped_type           = T;
+    using value_type            = ::std::pair<const Key, T>;
+    using hasher                = Hash;
+    using key_equal             = Equal;
+    using allocator_type        = Allocator;
+    using reference             = ::std::pair<const Key &, T &>;
+    using const_reference       = ::std::pair<const Key &, const T &>;
+    using size_type             = size_t;
+    using difference_type       = ptrdiff_t;
+
+  protected:
+    /// proxy so that it->second works when the iterator dereferences to a temporary pair of references.
+    template <typename Ref>
+    struct arrow_proxy {
+        Ref r;
+        Ref * operator->() { return &r; }
+    };
+
+    template <bool IS_CONST>
+    class mphf_iterator {
+        friend class basic_mphf_map;
+        template <bool> friend class mphf_iterator;
+
+        using map_ptr = typename ::std::conditional<IS_CONST, basic_mphf_map const *, basic_mphf_map *>::type;
+
+        map_ptr m;
+        size_t pos;
+
+      public:
+        using iterator_category = ::std::forward_iterator_tag;
+        using value_type = typename basic_mphf_map::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = typename ::std::conditional<IS_CONST,
+            typename basic_mphf_map::const_reference, typename basic_mphf_map::reference>::type;
+        using pointer = arrow_proxy<reference>;
+
+        mphf_iterator() : m(nullptr), pos(0) {}
+        mphf_iterator(map_ptr _m, size_t _pos) : m(_m), pos(_pos) {}
+
+        /// conversion from non-const to const iterator
+        template <bool C = IS_CONST, typename = typename ::std::enable_if<C>::type>
+        mphf_iterator(mphf_iterator<false> const & other) : m(other.m), pos(other.pos) {}
+
+        reference operator*() const {
+          return reference(m->keys_[pos], m->vals_[pos]);
+        }
+        pointer operator->() const {
+          return pointer{this->operator*()};
+        }
+
+        mphf_iterator & operator++() {
+          ++pos;
+          return *this;
+        }
+        mphf_iterator operator++(int) {
+          mphf_iterator out(*this);
+          ++(*this);
+          return out;
+        }
+
+        bool operator==(mphf_iterator const & other) const {
+          return pos == other.pos;
+        }
+        bool operator!=(mphf_iterator const & other) const {
+          return pos != other.pos;
+        }
+    };
+
+  public:
+    using iterator              = mphf_iterator<false>;
+    using const_iterator        = mphf_iterator<true>;
+    using pointer               = typename iterator::pointer;
+    using const_pointer         = typename const_iterator::pointer;
+
+  protected:
+
+    static inline fingerprint_type fingerprint(uint64_t const & h) {
+      return (fingerprint_bits == 0) ? 0 :
+          static_cast<fingerprint_type>(::bliss::utils::mix64(h) >> (64 - fingerprint_bits));
+    }
+
+    /// slot of key, or size() if not found.
+    size_t find_pos(Key const & key) const {
+      uint64_t h = hash(key);
+      size_t pos = func.lookup(h);
+      if ((pos != ::fsc::mphf::bbhash::npos) &&
+          ((fingerprint_bits == 0) || (fps_[pos] == fingerprint(h))) &&
+          eq(keys_[pos], key)) return pos;
+
+      // not placed by the function.
+      if (fallback.empty()) return keys_.size();
+      auto it = fallback.find(key);
+      return (it == fallback.end()) ? keys_.size() : it->second;
+    }
+
+    /// append an entry whose key is known to be absent.  goes to the fallback table until the next build.
+    size_t append(Key const & key, T const & val) {
+      size_t pos = keys_.size();
+      keys_.push_back(key);
+      vals_.push_back(val);
+      if (fingerprint_bits > 0) fps_.push_back(fingerprint(hash(key)));
+      fallback.insert(::std::make_pair(key, pos));
+      return pos;
+    }
+
+    /// drop the entries marked in remove, then rebuild.  returns the number removed.
+    size_t remove_marked(::std::vector<bool> const & remove) {
+      size_t j = 0;
+      for (size_t i = 0; i < keys_.size(); ++i) {
+        if (remove[i]) continue;
+        if (i != j) {
+          keys_[j] = ::std::move(keys_[i]);
+          vals_[j] = ::std::move(vals_[i]);
+        }
+        ++j;
+      }
+      size_t count = keys_.size() - j;
+      keys_.resize(j);
+      vals_.resize(j);
+      if (count > 0) build();
+      return count;
+    }
+
+  public:
+
+    basic_mphf_map(size_type bucket_count = 128) :
+      specials(), hash(), eq(::fsc::soa::make_equal<Equal>(specials)), func(), gamma(2.0), fallback(8) {
+      keys_.reserve(bucket_count);
+      vals_.reserve(bucket_count);
+    };
+
+    template<class InputIt>
+    basic_mphf_map(InputIt first, InputIt last) :
+      basic_mphf_map(std::distance(first, last)) {
+      this->insert(first, last);
+    };
+
+    virtual ~basic_mphf_map() {};
+
+    /**
+     * @brief rebuild the perfect hash function over all entries, and empty the fallback table.
+     * @details  the entries are permuted to their slots.  called by bulk insert and erase.
+     */
+    void build() {
+      size_t const n = keys_.size();
+
+      ::std::vector<uint64_t> hashes(n);
+      for (size_t i = 0; i < n; ++i) hashes[i] = hash(keys_[i]);
+
+      ::std::vector<size_t> unplaced;
+      func = ::fsc::mphf::bbhash(gamma);
+      func.build(hashes, unplaced);
+
+      // new slot of each entry:  placed keys at their rank, the rest after them.
+      ::std::vector<size_t> slot(n);
+      ::std::vector<bool> placed(n, true);
+      for (size_t i : unplaced) placed[i] = false;
+      size_t next = n - unplaced.size();
+      for (size_t i = 0; i < n; ++i) {
+        slot[i] = placed[i] ? func.lookup(hashes[i]) : next++;
+      }
+
+      ::std::vector<Key, key_alloc_type> new_keys(n);
+      ::std::vector<T, val_alloc_type> new_vals(n);
+      for (size_t i = 0; i < n; ++i) {
+        new_keys[slot[i]] = ::std::move(keys_[i]);
+        new_vals[slot[i]] = ::std::move(vals_[i]);
+      }
+      keys_.swap(new_keys);
+      vals_.swap(new_vals);
+
+      fps_.clear();
+      if (fingerprint_bits > 0) {
+        fps_.resize(n);
+        for (size_t i = 0; i < n; ++i) fps_[slot[i]] = fingerprint(hashes[i]);
+      }
+
+      // release the table that held the single inserts.
+      fallback = fallback_type(8);
+      for (size_t i : unplaced) fallback.insert(::std::make_pair(keys_[slot[i]], slot[i]));
+    }
+
+    /// bits per key of each level, >= 1, for the next build.  larger takes more space and fewer levels per lookup.
+    void set_gamma(double const & _gamma) {
+      gamma = ::std::max(_gamma, 1.0);
+    }
+
+    float get_max_load_factor() const {
+      return 1.0;
+    }
+
+    iterator begin() {
+      return iterator(this, 0);
+    }
+    const_iterator begin() const {
+      return cbegin();
+    }
+    const_iterator cbegin() const {
+      return const_iterator(this, 0);
+    }
+
+    iterator end() {
+      return iterator(this, keys_.size());
+    }
+    const_iterator end() const {
+      return cend();
+    }
+    const_iterator cend() const {
+      return const_iterator(this, keys_.size());
+    }
+
+
+    std::vector<Key> keys() const {
+      std::vector<Key> ks;
+
+      keys(ks);
+
+      return ks;
+    }
+    void keys(std::vector<Key> & ks) const {
+      ks.assign(keys_.begin(), keys_.end());
+    }
+
+    std::vector<std::pair<Key, T> > to_vector() const {
+      std::vector<std::pair<Key, T>> vs;
+
+      to_vector(vs);
+
+      return vs;
+    }
+    void to_vector(  std::vector<std::pair<Key, T> > & vs) const {
+      vs.clear();
+      vs.reserve(size());
+
+      for (size_t i = 0; i < keys_.size(); ++i) {
+        vs.emplace_back(keys_[i], vals_[i]);
+      }
+    }
+
+
+    bool empty() const {
+      return keys_.empty();
+    }
+
+    size_type size() const {
+      return keys_.size();
+    }
+    size_type unique_size() const {
+      return keys_.size();
+    }
+
+    /// entries not placed by the perfect hash function.  0 right after a build, except for rare hash collisions.
+    size_type fallback_size() const {
+      return fallback.size();
+    }
+
+    /// bits per entry used by the function and the fallback table, beyond the key, value, and fingerprint arrays.
+    double overhead_bits_per_key() const {
+      if (keys_.empty()) return 0.0;
+      return static_cast<double>(func.size_in_bits() +
+                                 fallback.bucket_count() * (sizeof(Key) + sizeof(size_t) + 1) * 8) /
+          static_cast<double>(keys_.size());
+    }
+
+    /// clear and release memory.
+    void reset() {
+      ::std::vector<Key, key_alloc_type>().swap(keys_);
+      ::std::vector<T, val_alloc_type>().swap(vals_);
+      ::std::vector<fingerprint_type, fp_alloc_type>().swap(fps_);
+      func = ::fsc::mphf::bbhash(gamma);
+      fallback.reset();
+    }
+
+    /// clear without releasing memory.
+    void clear() {
+      keys_.clear();
+      vals_.clear();
+      fps_.clear();
+      func.clear();
+      fallback.clear();
+    }
+
+    /// make room for at least n elements.  does not shrink.
+    void resize(size_t const n) {
+      keys_.reserve(n);
+      vals_.reserve(n);
+    }
+
+    /// same as resize.  there are no buckets to rehash.
+    void rehash(size_type count) {
+      this->resize(count);
+    }
+
+    /// number of slots, which is the number of entries.
+    size_type bucket_count() const {
+      return keys_.size();
+    }
+
+    float load_factor() const {
+      return keys_.empty() ? 0.0 : 1.0;
+    }
+
+
+    /// bulk insert if absent, then rebuild.
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+      size_t before = keys_.size();
+      for (; first != last; ++first) {
+        this->insert(*first);
+      }
+      if (keys_.size() != before) build();
+    }
+
+    void insert(::std::vector<::std::pair<Key, T> > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    void insert(::std::vector<value_type > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    /**
+     * @brief bulk insert, reducing with the existing entry:  existing = r(existing, new), then rebuild.
+     * @details  used by the reduction and counting maps, so they rebuild once per insert instead of appending each key.
+     * @return number of new entries.
+     */
+    template <class InputIt, class Reducer>
+    size_t insert(InputIt first, InputIt last, Reducer const & r) {
+      size_t before = keys_.size();
+      size_t pos;
+      for (; first != last; ++first) {
+        pos = find_pos((*first).first);
+        if (pos == keys_.size()) append((*first).first, (*first).second);
+        else vals_[pos] = r(vals_[pos], (*first).second);
+      }
+      if (keys_.size() != before) build();
+      return keys_.size() - before;
+    }
+
+    /// insert if absent.  existing entries are not modified, same as std::unordered_map.  a new entry goes to the
+    /// fallback table until the next build.
+    template <typename K = Key, typename = typename std::enable_if<!std::is_const<Key>::value> >
+    std::pair<iterator, bool> insert(::std::pair<Key, T> const & x) {
+      size_t pos = find_pos(x.first);
+      if (pos != keys_.size()) return std::make_pair(iterator(this, pos), false);
+
+      return std::make_pair(iterator(this, append(x.first, x.second)), true);
+    }
+
+    std::pair<iterator, bool> insert(::std::pair<const Key, T> const & x) {
+      return this->insert(::std::pair<Key, T>(x.first, x.second));
+    }
+
+    template <typename V, typename Updater>
+    size_t update(::std::vector<::std::pair<Key, V> > & input, Updater const & op) {
+
+      if (input.size() == 0) return 0;
+
+      size_t count = 0;
+      size_t pos;
+
+      for (auto vv : input) {
+        pos = find_pos(vv.first);
+        if (pos == keys_.size()) continue;
+
+        // update the entry
+        count += op(vals_[pos], vv.second );
+      }
+
+      return count;
+    }
+
+    // non distributed version
+    template <typename Filter, typename Updater>
+    size_t update(Filter const & fop, Updater const & op) {
+      size_t count = 0;
+
+      for (auto iter = this->begin(); iter != this->end(); ++iter) {
+        if (fop(*iter)) {
+          count += op((*iter).second);
+        }
+      }
+
+      return count;
+    }
+
+
+    /// erase the keys for which pred is true of the entry, then rebuild.
+    template <typename InputIt, typename Pred>
+    size_t erase(InputIt first, InputIt last, Pred const & pred) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      ::std::vector<bool> remove(keys_.size(), false);
+      size_t pos;
+      for (; first != last; ++first) {
+        pos = find_pos(*first);
+        if (pos == keys_.size()) continue;
+
+        if (pred(*(iterator(this, pos)))) remove[pos] = true;
+      }
+      return remove_marked(remove);
+    }
+
+    /// erase the keys, then rebuild.
+    template <typename InputIt>
+    size_t erase(InputIt first, InputIt last) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      ::std::vector<bool> remove(keys_.size(), false);
+      size_t pos;
+      for (; first != last; ++first) {
+        pos = find_pos(*first);
+        if (pos != keys_.size()) remove[pos] = true;
+      }
+      return remove_marked(remove);
+    }
+
+    /// erase the entries for which pred is true, then rebuild.
+    template <typename Pred>
+    size_t erase(Pred const & pred) {
+      ::std::vector<bool> remove(keys_.size(), false);
+      for (size_t i = 0; i < keys_.size(); ++i) {
+        if (pred(*(iterator(this, i)))) remove[i] = true;
+      }
+      return remove_marked(remove);
+    }
+
+    size_type count(Key const & key) const {
+      return (find_pos(key) == keys_.size()) ? 0 : 1;
+    }
+
+
+    ::std::pair<iterator, iterator> equal_range(Key const & key) {
+      iterator it = find(key);
+      if (it == end()) return ::std::make_pair(it, it);
+      iterator next = it;
+      ++next;
+      return ::std::make_pair(it, next);
+    }
+    ::std::pair<const_iterator, const_iterator> equal_range(Key const & key) const {
+      const_iterator it = find(key);
+      if (it == cend()) return ::std::make_pair(it, it);
+      const_iterator next = it;
+      ++next;
+      return ::std::make_pair(it, next);
+    }
+
+    iterator find(Key const &key) {
+      return iterator(this, find_pos(key));
+    }
+
+    const_iterator find(Key const &key) const {
+      return const_iterator(this, find_pos(key));
+    }
+
+    /// prefetch the level 0 line of the function for a key, ahead of find/count/equal_range.
+    inline void prefetch(Key const & key) const {
+      func.prefetch(hash(key));
+    }
+
+    /// prefetch the level 0 lines of the function for n keys, with batched hashing.
+    inline void prefetch(Key const * keys, size_t const & n) const {
+      constexpr size_t batch = 16;
+      uint64_t hashes[batch];
+      size_t block;
+      for (size_t i = 0; i < n; i += block) {
+        block = ::std::min(batch, n - i);
+        ::fsc::hash_batch(hash, keys + i, block, hashes);
+        for (size_t j = 0; j < block; ++j) func.prefetch(hashes[j]);
+      }
+    }
+
+    inline bool exists(Key const & key) const {
+      return find_pos(key) != keys_.size();
+    }
+
+};
+
+/// minimal perfect hash map without fingerprints.  same template parameters as ::fsc::densehash_map.
+template <typename Key,
+typename T,
+typename SpecialKeys = ::fsc::soa::no_special_keys,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+bool split = SpecialKeys::need_to_split >
+using mphf_map = basic_mphf_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split, 0>;
+
+/// minimal perfect hash map with 8 or 16 bit fingerprints:  ::fsc::fingerprinted_mphf<bits>::map.
+template <uint8_t bits>
+struct fingerprinted_mphf {
+    template <typename Key,
+    typename T,
+    typename SpecialKeys = ::fsc::soa::no_special_keys,
+    template<typename> class Transform = ::bliss::transform::identity,
+    typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+    typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+    typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+    bool split = SpecialKeys::need_to_split >
+    using map = basic_mphf_map<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split, bits>;
+};
+
+
+}  // namespace fsc
+
+#endif /* SRC_CONTAINERS_MPHF_MAP_HPP_ */
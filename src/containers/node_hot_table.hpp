@@ -0,0 +1,147 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    node_hot_table.hpp
+ * @ingroup dsc::containers
+ * @brief   read only table of the globally hottest entries of a distributed map, stored once per node in MPI shared memory.
+ * @details with skewed data, a few keys (e.g. repeat k-mers) draw a large share of the queries, and all of them go to the
+ *          few ranks that own those keys.  this table holds the n entries with the largest values over all ranks, e.g.
+ *          the n most frequent k-mers of a counting map.  every rank of a node reads the same copy, in a shared window
+ *          allocated by the node's local rank 0, so a query for a hot key is answered without communication.
+ *
+ *          the table is an open addressing array (linear probing, at most half full).  every rank gathers the top n
+ *          candidates of all ranks and selects the same n, so the table is identical on all nodes.
+ *
+ *          construction and destruction are collective.  lookups are not, and need no synchronization:  the table is
+ *          read only once built, and does not see later changes to the map.  keys are compared as stored, so query
+ *          keys need to have been through the map's input transform.  slots are read as raw bytes, so Key and T
+ *          should be trivially copyable in effect, as for any mxx datatype.
+ */
+#ifndef SRC_CONTAINERS_NODE_HOT_TABLE_HPP_
+#define SRC_CONTAINERS_NODE_HOT_TABLE_HPP_
+
+#include <mpi.h>
+
+#include <vector>
+#include <memory>      // unique_ptr
+#include <utility>     // pair
+#include <functional>  // hash, equal_to
+#include <algorithm>   // nth_element
+#include <cstdint>     // uint8_t
+
+#include "mxx/comm.hpp"
+#include "mxx/collective.hpp"
+
+#include "io/hierarchical_mxx.hpp"  // shared_window
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace dsc  // distributed std container
+{
+
+  /**
+   * @brief node shared table of the top n entries by value.  see file description.
+   * @tparam Hash   slot hash of a stored key.  mixed before use, so the map's store hash is fine.
+   */
+  template <typename Key, typename T,
+    typename Hash = ::std::hash<Key>,
+    typename Equal = ::std::equal_to<Key> >
+  class node_hot_table {
+
+    public:
+      using value_type = ::std::pair<Key, T>;
+
+    protected:
+      struct slot {
+          Key key;
+          T value;
+          uint8_t used;
+      };
+
+      Hash hash;
+      Equal eq;
+
+      /// ranks of this node.
+      ::mxx::comm local;
+      /// the node's table, in local rank 0's segment.
+      ::std::unique_ptr<::imxx::shared_window<slot> > window;
+      slot const * table;
+      size_t capacity;
+      size_t entries;
+
+      inline size_t home(Key const & k) const {
+        return ::bliss::utils::mix64(static_cast<uint64_t>(hash(k))) & (capacity - 1);
+      }
+
+      /// keep the n entries with the largest values, in no particular order.  ties are broken the same way on all ranks.
+      static void top(::std::vector<value_type> & v, size_t const n) {
+        if (v.size() <= n) return;
+        ::std::nth_element(v.begin(), v.begin() + n, v.end(), [](value_type const & x, value_type const & y) {
+          return y.second < x.second;
+        });
+        v.resize(n);
+      }
+
+    public:
+      /**
+       * @brief  build from the local entries of a map.  collective.
+       * @param local_entries   candidate entries of this rank, keys as stored, e.g. the map's to_vector.  reordered.
+       * @param n               number of entries to keep over all ranks.
+       */
+      node_hot_table(::std::vector<value_type> & local_entries, size_t const n, const mxx::comm& _comm) :
+        hash(), eq(), local(_comm.split_shared()), table(nullptr), capacity(8), entries(0) {
+
+        // the same global top n on all ranks.
+        top(local_entries, n);
+        ::std::vector<value_type> hot = (_comm.size() > 1) ? ::mxx::allgatherv(local_entries, _comm) : local_entries;
+        top(hot, n);
+        entries = hot.size();
+        while (capacity < 2 * entries) capacity <<= 1;
+
+        window.reset(new ::imxx::shared_window<slot>((local.rank() == 0) ? capacity : 0, local));
+        if (local.rank() == 0) {
+          slot * t = window->data();
+          for (size_t i = 0; i < capacity; ++i) t[i].used = 0;
+          for (auto const & e : hot) {
+            size_t i = home(e.first);
+            while (t[i].used && !eq(t[i].key, e.first)) i = (i + 1) & (capacity - 1);
+            t[i].key = e.first;
+            t[i].value = e.second;
+            t[i].used = 1;
+          }
+        }
+        window->fence();
+        table = window->peer(0);
+      }
+
+      node_hot_table(node_hot_table const & other) = delete;
+      node_hot_table& operator=(node_hot_table const & other) = delete;
+
+      /// number of entries.
+      size_t size() const { return entries; }
+
+      /// the value of a stored key, or nullptr if it is not hot.
+      inline T const * find(Key const & k) const {
+        for (size_t i = home(k); table[i].used; i = (i + 1) & (capacity - 1)) {
+          if (eq(table[i].key, k)) return &(table[i].value);
+        }
+        return nullptr;
+      }
+  };
+
+} /* namespace dsc */
+
+#endif // SRC_CONTAINERS_NODE_HOT_TABLE_HPP_
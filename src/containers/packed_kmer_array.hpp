@@ -0,0 +1,224 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    packed_kmer_array.hpp
+ * @ingroup fsc::containers
+ * @brief   array of keys bit packed end to end, without the padding of their words.
+ * @details a kmer uses k * bitsPerChar bits of its words, e.g. 62 of 64 for a 31-mer, 93 of 128 for a 31-mer over 3 bit
+ *          DNA5.  this array stores key i at bits [i * key_bits, (i + 1) * key_bits) of an array of 64 bit words, so n
+ *          keys take n * key_bits bits.  a key is read with at most 2 word loads per key word and a shift, and written back
+ *          to a full key on access.  keys that are not kmers are stored with all bits of their words.
+ *
+ *          the static put and get work on any word array, e.g. a memory mapped file (see distributed_map_io.hpp).
+ *          keys need a ::imxx::codec::word_view.
+ */
+#ifndef SRC_CONTAINERS_PACKED_KMER_ARRAY_HPP_
+#define SRC_CONTAINERS_PACKED_KMER_ARRAY_HPP_
+
+#include <vector>
+#include <iterator>     // random_access_iterator_tag
+#include <algorithm>    // min
+#include <type_traits>
+#include <cstdint>      // uint64_t
+#include <cstddef>      // size_t, ptrdiff_t
+
+#include "common/kmer.hpp"
+#include "io/delta_codec.hpp"  // word_view
+
+namespace fsc {  // fast standard container
+
+  /// significant bits of a key:  k * bitsPerChar for kmers, all bits of the words otherwise.
+  template <typename Key, bool = ::bliss::common::is_kmer<Key>::value>
+  struct packed_key_bits {
+      static constexpr unsigned int value = ::imxx::codec::word_view<Key>::nwords *
+          sizeof(typename ::imxx::codec::word_view<Key>::word_type) * 8;
+  };
+  template <typename Key>
+  struct packed_key_bits<Key, true> {
+      static constexpr unsigned int value = Key::nBits;
+  };
+
+
+  /**
+   * @brief bit packed array of keys.  append only, read by index or iterator.
+   * @tparam Key   kmer, or another key type with a ::imxx::codec::word_view.
+   */
+  template <typename Key>
+  class packed_kmer_array {
+      static_assert(::imxx::codec::word_view<Key>::value, "packed_kmer_array needs keys with a word_view.");
+
+    protected:
+      using view = ::imxx::codec::word_view<Key>;
+      using word_type = typename view::word_type;
+      static constexpr unsigned int word_bits = sizeof(word_type) * 8;
+
+      /// keys, key_bits each, from the least significant bit of words[0].
+      ::std::vector<uint64_t> words;
+      size_t n;
+
+      /// bits of key word i.
+      static inline unsigned int word_width(size_t const i) {
+        return (key_bits <= i * word_bits) ? 0 : ::std::min(word_bits, static_cast<unsigned int>(key_bits - i * word_bits));
+      }
+
+    public:
+      /// bits per stored key.
+      static constexpr unsigned int key_bits = packed_key_bits<Key>::value;
+
+      /// number of 64 bit words that hold count keys.
+      static constexpr size_t words_for(size_t const count) {
+        return (count * key_bits + 63) / 64;
+      }
+
+      /// or key k into the (zeroed) bits of position i in out.
+      static void put(uint64_t * out, size_t const i, Key const & k) {
+        word_type const * kw = view::words(k);
+        size_t pos = i * key_bits;
+        for (size_t j = 0; j < view::nwords; ++j) {
+          unsigned int const nb = word_width(j);
+          if (nb == 0) break;
+          uint64_t const x = static_cast<uint64_t>(kw[j]) & ((nb == 64) ? ~static_cast<uint64_t>(0) : ((static_cast<uint64_t>(1) << nb) - 1));
+          size_t const w = pos >> 6;
+          unsigned int const s = pos & 63;
+          out[w] |= x << s;
+          if (s + nb > 64) out[w + 1] |= x >> (64 - s);
+          pos += nb;
+        }
+      }
+
+      /// the key at position i of in.  unused bits of the key's words are 0.
+      static inline Key get(uint64_t const * in, size_t const i) {
+        Key k;
+        word_type * kw = view::words(k);
+        size_t pos = i * key_bits;
+        for (size_t j = 0; j < view::nwords; ++j) {
+          unsigned int const nb = word_width(j);
+          if (nb == 0) {
+            kw[j] = 0;
+            continue;
+          }
+          size_t const w = pos >> 6;
+          unsigned int const s = pos & 63;
+          uint64_t x = in[w] >> s;
+          if (s + nb > 64) x |= in[w + 1] << (64 - s);
+          kw[j] = static_cast<word_type>((nb == 64) ? x : (x & ((static_cast<uint64_t>(1) << nb) - 1)));
+          pos += nb;
+        }
+        return k;
+      }
+
+
+      /// random access over the keys, by value.
+      class const_iterator {
+        protected:
+          packed_kmer_array const * arr;
+          size_t i;
+
+        public:
+          using iterator_category = ::std::random_access_iterator_tag;
+          using value_type = Key;
+          using difference_type = ::std::ptrdiff_t;
+          using pointer = Key const *;
+          using reference = Key;
+
+          const_iterator() : arr(nullptr), i(0) {}
+          const_iterator(packed_kmer_array const * _arr, size_t const _i) : arr(_arr), i(_i) {}
+
+          Key operator*() const { return (*arr)[i]; }
+          Key operator[](difference_type const d) const { return (*arr)[i + d]; }
+
+          const_iterator & operator++() { ++i; return *this; }
+          const_iterator operator++(int) { const_iterator out(*this); ++i; return out; }
+          const_iterator & operator--() { --i; return *this; }
+          const_iterator operator--(int) { const_iterator out(*this); --i; return out; }
+          const_iterator & operator+=(difference_type const d) { i += d; return *this; }
+          const_iterator & operator-=(difference_type const d) { i -= d; return *this; }
+          const_iterator operator+(difference_type const d) const { return const_iterator(arr, i + d); }
+          const_iterator operator-(difference_type const d) const { return const_iterator(arr, i - d); }
+          difference_type operator-(const_iterator const & other) const {
+            return static_cast<difference_type>(i) - static_cast<difference_type>(other.i);
+          }
+
+          bool operator==(const_iterator const & other) const { return i == other.i; }
+          bool operator!=(const_iterator const & other) const { return i != other.i; }
+          bool operator<(const_iterator const & other) const { return i < other.i; }
+          bool operator>(const_iterator const & other) const { return i > other.i; }
+          bool operator<=(const_iterator const & other) const { return i <= other.i; }
+          bool operator>=(const_iterator const & other) const { return i >= other.i; }
+      };
+
+
+      packed_kmer_array() : n(0) {}
+
+      template <typename Iter>
+      packed_kmer_array(Iter first, Iter last) : n(0) {
+        assign(first, last);
+      }
+
+      /// replace the content with the keys in [first, last).
+      template <typename Iter>
+      void assign(Iter first, Iter last) {
+        n = ::std::distance(first, last);
+        words.assign(words_for(n), 0);
+        for (size_t i = 0; first != last; ++first, ++i) put(words.data(), i, *first);
+      }
+
+      void push_back(Key const & k) {
+        size_t const nw = words_for(n + 1);
+        if (words.size() < nw) words.resize(nw, 0);
+        put(words.data(), n, k);
+        ++n;
+      }
+
+      void reserve(size_t const count) {
+        words.reserve(words_for(count));
+      }
+
+      void shrink_to_fit() {
+        words.shrink_to_fit();
+      }
+
+      void clear() {
+        ::std::vector<uint64_t>().swap(words);
+        n = 0;
+      }
+
+      Key operator[](size_t const i) const {
+        return get(words.data(), i);
+      }
+
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, n); }
+
+      size_t size() const { return n; }
+      bool empty() const { return n == 0; }
+
+      /// the packed words, words_for(size()) of them.
+      uint64_t const * data() const { return words.data(); }
+
+      /// memory held, in bytes.
+      size_t bytes() const {
+        return words.capacity() * sizeof(uint64_t);
+      }
+  };
+
+  template <typename Key>
+  constexpr unsigned int packed_kmer_array<Key>::key_bits;
+
+} // namespace fsc
+
+#endif // SRC_CONTAINERS_PACKED_KMER_ARRAY_HPP_
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    parallel_for_each.hpp
+ * @ingroup fsc::containers
+ * @brief   multithreaded read-only traversal of a local container.
+ * @details the container's storage (bucket array, or element vector) is split into nthreads contiguous ranges,
+ *          and each OpenMP thread visits the elements in its range.  fn(element, thread_id) is called concurrently
+ *          from different threads, so it should only write to per-thread state, indexed by thread_id.
+ *          element order is not defined.  without OpenMP, the whole container is visited by thread 0.
+ *          the threads are those of the library's persistent task pool (utils/task_pool.hpp), not an OpenMP region,
+ *          so short calls do not pay for starting a region.  OpenMP only sets the default number of threads.
+ *
+ *          ::fsc::parallel_for_each(container, fn, nthreads) uses container.parallel_for_each(fn, nthreads) if
+ *          available (densehash_map, densehash_multimap, unordered_vecmap, unordered_compact_vecmap),
+ *          splits by bucket for std::unordered_map / unordered_multimap, by index for std::vector,
+ *          and otherwise iterates cbegin() to cend() sequentially.
+ */
+#ifndef SRC_CONTAINERS_PARALLEL_FOR_EACH_HPP_
+#define SRC_CONTAINERS_PARALLEL_FOR_EACH_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>   // size_t
+#include <utility>   // declval
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "utils/task_pool.hpp"
+
+namespace fsc {  // fast standard container
+
+  /// number of threads a parallel_for_each uses.  0 or less means all available.
+  inline int parallel_for_each_threads(int const nthreads) {
+#if defined(USE_OPENMP)
+    return (nthreads > 0) ? nthreads : omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  /**
+   * @brief  split [0, n) into nthreads contiguous ranges and call fn(begin, end, thread_id) once per range,
+   *         concurrently on the task pool.  thread_id is the index of the range.
+   */
+  template <typename F>
+  void parallel_for_ranges(size_t const n, F && fn, int const nthreads = 0) {
+    int const nt = parallel_for_each_threads(nthreads);
+    if ((nt <= 1) || (n < static_cast<size_t>(nt))) {
+      fn(static_cast<size_t>(0), n, 0);
+      return;
+    }
+
+    ::bliss::utils::task_pool::instance().run(nt, [n, nt, &fn](int const tid) {
+      size_t const block = n / nt;
+      size_t const rem = n % nt;
+      size_t const first = block * tid + ((static_cast<size_t>(tid) < rem) ? tid : rem);
+      size_t const last = first + block + ((static_cast<size_t>(tid) < rem) ? 1 : 0);
+
+      fn(first, last, tid);
+    });
+  }
+
+  /**
+   * @brief  call fn(i, thread_id) for each i in [0, n), on nthreads threads of the task pool.
+   * @details for items of uneven cost, e.g. buckets:  idle threads steal grain items at a time from busy ones.
+   *          thread_id is that of the thread that runs the item, so per thread state indexed by it, or
+   *          ::bliss::utils::task_pool::thread_scratch, needs no synchronization.
+   */
+  template <typename F>
+  void parallel_for_dynamic(size_t const n, F && fn, int const nthreads = 0, size_t const grain = 1) {
+    ::bliss::utils::task_pool::instance().parallel_for(n, [&fn](size_t const first, size_t const last, int const tid) {
+      for (size_t i = first; i < last; ++i) fn(i, tid);
+    }, parallel_for_each_threads(nthreads), grain);
+  }
+
+  namespace detail {
+
+    // container with its own parallel_for_each
+    template <typename C, typename F>
+    auto parallel_for_each_impl(C const & c, F && fn, int const nthreads, int)
+      -> decltype(c.parallel_for_each(fn, nthreads), void()) {
+      c.parallel_for_each(fn, nthreads);
+    }
+
+    // fallback:  sequential
+    template <typename C, typename F>
+    void parallel_for_each_impl(C const & c, F && fn, int const, long) {
+      for (auto it = c.cbegin(); it != c.cend(); ++it) {
+        fn(*it, 0);
+      }
+    }
+
+  }  // namespace detail
+
+
+  /// visit all elements of a vector, split by index.
+  template <typename V, typename A, typename F>
+  void parallel_for_each(::std::vector<V, A> const & c, F && fn, int const nthreads = 0) {
+    parallel_for_ranges(c.size(), [&c, &fn](size_t const first, size_t const last, int const tid) {
+      for (size_t i = first; i < last; ++i) {
+        fn(c[i], tid);
+      }
+    }, nthreads);
+  }
+
+  /// visit all elements of an std::unordered_map, split by bucket.
+  template <typename K, typename T, typename H, typename E, typename A, typename F>
+  void parallel_for_each(::std::unordered_map<K, T, H, E, A> const & c, F && fn, int const nthreads = 0) {
+    parallel_for_ranges(c.bucket_count(), [&c, &fn](size_t const first, size_t const last, int const tid) {
+      for (size_t b = first; b < last; ++b) {
+        for (auto it = c.cbegin(b); it != c.cend(b); ++it) {
+          fn(*it, tid);
+        }
+      }
+    }, nthreads);
+  }
+
+  /// visit all elements of an std::unordered_multimap, split by bucket.
+  template <typename K, typename T, typename H, typename E, typename A, typename F>
+  void parallel_for_each(::std::unordered_multimap<K, T, H, E, A> const & c, F && fn, int const nthreads = 0) {
+    parallel_for_ranges(c.bucket_count(), [&c, &fn](size_t const first, size_t const last, int const tid) {
+      for (size_t b = first; b < last; ++b) {
+        for (auto it = c.cbegin(b); it != c.cend(b); ++it) {
+          fn(*it, tid);
+        }
+      }
+    }, nthreads);
+  }
+
+  /// visit all elements of a container, via its own parallel_for_each if it has one.
+  template <typename C, typename F>
+  void parallel_for_each(C const & c, F && fn, int const nthreads = 0) {
+    detail::parallel_for_each_impl(c, fn, nthreads, 0);
+  }
+
+}  // namespace fsc
+
+#endif // SRC_CONTAINERS_PARALLEL_FOR_EACH_HPP_
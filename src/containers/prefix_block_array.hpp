@@ -0,0 +1,281 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    prefix_block_array.hpp
+ * @ingroup fsc::containers
+ * @brief   read only sorted array of (key, value) pairs, with the keys prefix compressed in small blocks.
+ * @details the array is cut into blocks of about block_size entries.  a block keeps its first key in full, in a
+ *          separate array used to find the block of a key, bit packed without word padding (packed_kmer_array.hpp).
+ *          the other keys of the block are stored as key xor first key, which in a sorted block of nearby keys is zero
+ *          in the shared high bits, so only the low width bits are kept, bit packed, with width the largest such
+ *          difference in the block.  a lookup searches the first keys, then
+ *          decodes 1 block of a few cache lines.  values are stored unpacked, in key order.
+ *
+ *          for k-mers sorted in the k-mer order, n keys spread over a range of R values need about log2(block_size * R / n)
+ *          bits each, e.g. about 36 instead of 64 for 10^8 31-mers per rank on 64 ranks.  other orders, e.g. after a
+ *          hash transform, give wider blocks but the same lookups.  keys need a ::imxx::codec::word_view.
+ *          equal keys are kept in 1 block, so all entries of a key are in the block found for it.
+ */
+#ifndef SRC_CONTAINERS_PREFIX_BLOCK_ARRAY_HPP_
+#define SRC_CONTAINERS_PREFIX_BLOCK_ARRAY_HPP_
+
+#include <vector>
+#include <utility>    // pair
+#include <algorithm>  // upper_bound, min, max
+#include <iterator>   // distance
+#include <cstdint>    // uint64_t
+#include <cstddef>    // size_t
+
+#include "io/delta_codec.hpp"  // word_view
+#include "containers/packed_kmer_array.hpp"
+
+namespace fsc {  // fast standard container
+
+  /**
+   * @brief keys without a word view:  no compression.  callers check supported.
+   * @tparam Key   key type, i.e. the first element of the array's pairs.
+   * @tparam T     value type.
+   * @tparam Less  comparator that accepts (Key, Key), e.g. the maps' StoreTransformedFunc.
+   */
+  template <typename Key, typename T, typename Less, bool = ::imxx::codec::word_view<Key>::value>
+  class prefix_block_array {
+    public:
+      static constexpr bool supported = false;
+
+      template <typename Iter>
+      void build(Iter, Iter, size_t = 0) {}
+      void clear() {}
+      bool empty() const { return true; }
+      size_t size() const { return 0; }
+      size_t blocks() const { return 0; }
+      size_t bytes() const { return 0; }
+      Key first_key(size_t) const { return dummy; }
+
+      template <typename V>
+      size_t block_of(V const &) const { return 0; }
+      template <typename Container>
+      void decode(size_t, Container &) const {}
+      template <typename Container>
+      void decode_all(Container &) const {}
+
+    protected:
+      Key dummy;
+  };
+
+
+  template <typename Key, typename T, typename Less>
+  class prefix_block_array<Key, T, Less, true> {
+    protected:
+      using view = ::imxx::codec::word_view<Key>;
+      using word_type = typename view::word_type;
+      static constexpr unsigned int word_bits = sizeof(word_type) * 8;
+
+      /// first key of each block.
+      packed_kmer_array<Key> firsts;
+      /// position of the first entry of each block, and the entry count at the end.
+      ::std::vector<size_t> starts;
+      /// bit position of each block's packed keys in packed.
+      ::std::vector<size_t> offsets;
+      /// bits per packed key of each block.
+      ::std::vector<uint16_t> widths;
+      /// keys after the first of each block, as the low width bits of key xor first key, words from least significant.
+      ::std::vector<uint64_t> packed;
+      /// values in key order.
+      ::std::vector<T> values;
+
+      Less lt;
+
+      /// number of significant bits in x.
+      static inline unsigned int bit_length(uint64_t const x) {
+        return (x == 0) ? 0 : (64 - __builtin_clzll(x));
+      }
+
+      /// number of significant bits in x xor y.
+      static unsigned int diff_bits(Key const & x, Key const & y) {
+        word_type const * xw = view::words(x);
+        word_type const * yw = view::words(y);
+        for (size_t i = view::nwords; i > 0; --i) {
+          uint64_t d = static_cast<uint64_t>(xw[i-1] ^ yw[i-1]);
+          if (d != 0) return (i - 1) * word_bits + bit_length(d);
+        }
+        return 0;
+      }
+
+      /// bits of word i of a key packed at the given width.
+      static inline unsigned int word_width(size_t const i, unsigned int const width) {
+        return (width <= i * word_bits) ? 0 : ::std::min(word_bits, static_cast<unsigned int>(width - i * word_bits));
+      }
+
+      /// or the low n bits of x into packed at bit pos.  the higher bits of x are 0.
+      void put(size_t const pos, uint64_t const x, unsigned int const n) {
+        size_t const w = pos >> 6;
+        unsigned int const s = pos & 63;
+        packed[w] |= x << s;
+        if (s + n > 64) packed[w + 1] |= x >> (64 - s);
+      }
+
+      /// n bits at bit pos, 0 < n <= 64.
+      inline uint64_t get(size_t const pos, unsigned int const n) const {
+        size_t const w = pos >> 6;
+        unsigned int const s = pos & 63;
+        uint64_t x = packed[w] >> s;
+        if (s + n > 64) x |= packed[w + 1] << (64 - s);
+        return (n == 64) ? x : (x & ((static_cast<uint64_t>(1) << n) - 1));
+      }
+
+    public:
+      static constexpr bool supported = true;
+
+      /// entries per block when not given.
+      static constexpr size_t default_block_size = 64;
+
+      prefix_block_array(Less const & _lt = Less()) : lt(_lt) {}
+
+      /**
+       * @brief compress the range [first, last) of pairs, sorted by Less on the key.
+       * @param block_size  entries per block, more if a key's entries would span 2 blocks.  0 uses default_block_size.
+       */
+      template <typename Iter>
+      void build(Iter first, Iter last, size_t block_size = 0) {
+        clear();
+        size_t const n = ::std::distance(first, last);
+        if (n == 0) return;
+        if (block_size == 0) block_size = default_block_size;
+
+        // blocks and widths.
+        size_t bits = 0;
+        for (size_t i = 0; i < n; ) {
+          Key const & head = (*(first + i)).first;
+          size_t e = ::std::min(i + block_size, n);
+          while ((e < n) && !lt((*(first + (e - 1))).first, (*(first + e)).first)) ++e;
+
+          unsigned int width = 0;
+          for (size_t j = i + 1; j < e; ++j) width = ::std::max(width, diff_bits((*(first + j)).first, head));
+
+          firsts.push_back(head);
+          starts.emplace_back(i);
+          offsets.emplace_back(bits);
+          widths.emplace_back(static_cast<uint16_t>(width));
+          bits += (e - i - 1) * width;
+          i = e;
+        }
+        starts.emplace_back(n);
+        firsts.shrink_to_fit();
+        starts.shrink_to_fit();
+        offsets.shrink_to_fit();
+        widths.shrink_to_fit();
+
+        // pack.
+        packed.assign((bits + 63) / 64, 0);
+        for (size_t b = 0; b < firsts.size(); ++b) {
+          Key const head = firsts[b];
+          word_type const * hw = view::words(head);
+          size_t pos = offsets[b];
+          for (size_t j = starts[b] + 1; j < starts[b + 1]; ++j) {
+            word_type const * kw = view::words((*(first + j)).first);
+            for (size_t i = 0; i < view::nwords; ++i) {
+              unsigned int const nb = word_width(i, widths[b]);
+              if (nb == 0) break;
+              put(pos, static_cast<uint64_t>(static_cast<word_type>(kw[i] ^ hw[i])), nb);
+              pos += nb;
+            }
+          }
+        }
+
+        values.reserve(n);
+        for (; first != last; ++first) values.emplace_back((*first).second);
+      }
+
+      void clear() {
+        firsts.clear();
+        ::std::vector<size_t>().swap(starts);
+        ::std::vector<size_t>().swap(offsets);
+        ::std::vector<uint16_t>().swap(widths);
+        ::std::vector<uint64_t>().swap(packed);
+        ::std::vector<T>().swap(values);
+      }
+
+      bool empty() const {
+        return values.empty();
+      }
+
+      /// number of entries.
+      size_t size() const {
+        return values.size();
+      }
+
+      size_t blocks() const {
+        return firsts.size();
+      }
+
+      /// memory held, in bytes.
+      size_t bytes() const {
+        return firsts.bytes() + (starts.capacity() + offsets.capacity()) * sizeof(size_t) +
+            widths.capacity() * sizeof(uint16_t) + packed.capacity() * sizeof(uint64_t) + values.capacity() * sizeof(T);
+      }
+
+      Key first_key(size_t const b) const {
+        return firsts[b];
+      }
+
+      /// the block that holds the entries with key v, if any:  the last block whose first key is not after v.  0 if none is.
+      template <typename V>
+      size_t block_of(V const & v) const {
+        size_t b = ::std::distance(firsts.begin(), ::std::upper_bound(firsts.begin(), firsts.end(), v, lt));
+        return (b == 0) ? 0 : (b - 1);
+      }
+
+      /// replace the content of out with the entries of block b, in order.
+      template <typename Container>
+      void decode(size_t const b, Container & out) const {
+        out.clear();
+        size_t const start = starts[b];
+        size_t const end = starts[b + 1];
+        unsigned int const width = widths[b];
+
+        Key const head = firsts[b];
+        out.emplace_back(head, values[start]);
+        size_t pos = offsets[b];
+        for (size_t j = start + 1; j < end; ++j) {
+          Key k = head;
+          word_type * kw = view::words(k);
+          for (size_t i = 0; i < view::nwords; ++i) {
+            unsigned int const nb = word_width(i, width);
+            if (nb == 0) break;
+            kw[i] ^= static_cast<word_type>(get(pos, nb));
+            pos += nb;
+          }
+          out.emplace_back(k, values[j]);
+        }
+      }
+
+      /// replace the content of out with all entries, in order.
+      template <typename Container>
+      void decode_all(Container & out) const {
+        Container block;
+        out.clear();
+        out.reserve(size());
+        for (size_t b = 0; b < blocks(); ++b) {
+          decode(b, block);
+          out.insert(out.end(), block.begin(), block.end());
+        }
+      }
+  };
+
+} // namespace fsc
+
+#endif // SRC_CONTAINERS_PREFIX_BLOCK_ARRAY_HPP_
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    query_cache.hpp
+ * @ingroup fsc::containers
+ * @brief   small, bounded, requester side cache of query answers, for keys that are queried over and over.
+ * @details the cache is a 4-way set associative table with CLOCK replacement within a set:  a hit sets the slot's
+ *          reference bit, and put() into a full set advances the set's hand, clearing reference bits, to the first
+ *          slot without one.  a key that is queried again soon therefore stays, and a key seen once is evicted first.
+ *
+ *          the cache knows nothing of the table it caches.  the owner clears it when the table changes.
+ */
+#ifndef SRC_CONTAINERS_QUERY_CACHE_HPP_
+#define SRC_CONTAINERS_QUERY_CACHE_HPP_
+
+#include <vector>
+#include <functional>  // equal_to, hash
+#include <utility>   // pair
+#include <cstdint>  // uint8_t
+
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace fsc {  // fast standard container
+
+
+/**
+ * @brief set associative key to answer cache with CLOCK replacement.  see file description.
+ * @tparam Hash    hash functor on Key.  the result is mixed before taking the set, so the low bits need not be random.
+ */
+template <typename Key, typename V,
+  typename Hash = ::std::hash<Key>,
+  typename Equal = ::std::equal_to<Key> >
+class query_cache {
+  public:
+    using value_type = ::std::pair<Key, V>;
+
+    /// slots per set.
+    static constexpr uint8_t ways = 4;
+
+  protected:
+    ::std::vector<value_type> slots;
+    /// per slot:  bit 0 occupied, bit 1 referenced.
+    ::std::vector<uint8_t> state;
+    /// per set:  next slot to consider for eviction.
+    ::std::vector<uint8_t> hands;
+    size_t mask;
+
+    size_t hit_count;
+    size_t miss_count;
+
+    Hash hash;
+    Equal eq;
+
+    inline size_t set_of(Key const & k) const {
+      return (::bliss::utils::mix64(static_cast<uint64_t>(hash(k))) & mask) & ~(static_cast<size_t>(ways) - 1);
+    }
+
+  public:
+    /// cache using up to _bytes of memory.  the slot count is the largest power of 2 that fits.  0 bytes, or too few for 1 set, disables it.
+    explicit query_cache(size_t _bytes = 0, Hash const & _hash = Hash(), Equal const & _eq = Equal()) :
+      mask(0), hit_count(0), miss_count(0), hash(_hash), eq(_eq) {
+      size_t const per = sizeof(value_type) + 1;
+      if (_bytes < ways * per + 1) return;
+      size_t n = ways;
+      while ((n << 1) * per + (n << 1) / ways <= _bytes) n <<= 1;
+      slots.resize(n);
+      state.resize(n, 0);
+      hands.resize(n / ways, 0);
+      mask = n - 1;
+    }
+
+    size_t capacity() const { return slots.size(); }
+    bool enabled() const { return slots.size() > 0; }
+
+    /// the cached answer of k, or nullptr.  marks k as recently used.
+    inline V * get(Key const & k) {
+      if (slots.empty()) return nullptr;
+      size_t set = set_of(k);
+      for (size_t i = set; i < set + ways; ++i) {
+        if ((state[i] & 1) && eq(slots[i].first, k)) {
+          state[i] |= 2;
+          ++hit_count;
+          return &(slots[i].second);
+        }
+      }
+      ++miss_count;
+      return nullptr;
+    }
+
+    /// the cached answer of k, or nullptr, without marking it or counting a hit or miss.
+    inline V * peek(Key const & k) {
+      if (slots.empty()) return nullptr;
+      size_t set = set_of(k);
+      for (size_t i = set; i < set + ways; ++i) {
+        if ((state[i] & 1) && eq(slots[i].first, k)) return &(slots[i].second);
+      }
+      return nullptr;
+    }
+
+    /// cache the answer of k, replacing its old answer, or evicting an entry of its set.
+    void put(Key const & k, V const & v) {
+      if (slots.empty()) return;
+      size_t set = set_of(k);
+      size_t empty = set + ways;
+      for (size_t i = set; i < set + ways; ++i) {
+        if (!(state[i] & 1)) {
+          if (empty == set + ways) empty = i;
+        } else if (eq(slots[i].first, k)) {
+          slots[i].second = v;
+          return;
+        }
+      }
+
+      size_t i = empty;
+      if (i == set + ways) {
+        // CLOCK:  give referenced slots a second chance.  ends within 2 turns.
+        uint8_t & hand = hands[set / ways];
+        while (state[set + hand] & 2) {
+          state[set + hand] &= 1;
+          hand = (hand + 1) & (ways - 1);
+        }
+        i = set + hand;
+        hand = (hand + 1) & (ways - 1);
+      }
+      slots[i].first = k;
+      slots[i].second = v;
+      state[i] = 1;
+    }
+
+    /// drop all entries.  the hit and miss counts are kept.
+    void clear() {
+      state.assign(state.size(), 0);
+      hands.assign(hands.size(), 0);
+    }
+
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+};
+
+}  // namespace fsc
+
+#endif // SRC_CONTAINERS_QUERY_CACHE_HPP_
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    query_latency.hpp
+ * @ingroup fsc::containers
+ * @brief   latency of individual query rounds:  a log-linear histogram, and a tracker of the phases of each round.
+ * @details latency_histogram is HDR style:  values below 2^sub_bits have their own bin, and each larger power of 2 is
+ *          split into 2^(sub_bits - 1) bins, so a recorded value is known to within 1/2^(sub_bits - 1), about 3%,
+ *          at any magnitude.  recording is 1 clz and 1 increment, and histograms of different ranks merge by adding bins.
+ *
+ *          query_latency_tracker records the nanoseconds of each round in 4 phases:
+ *            bucketing:  local work before the exchange:  input transform, duplicate removal, query cache and key filter.
+ *            exchange:   the query exchange, including the bucket and permute pass of imxx::distribute, and the
+ *                        emptiness check.
+ *            lookup:     the local lookup of the received queries.
+ *            reply:      the exchange of the results.
+ *          the exchanges wait for the slowest rank, so a rank with long exchanges and short local work is waiting on
+ *          others.  the local work (bucketing + lookup) has its own histogram, for finding the rank responsible for
+ *          the tail, and the phases of the slowest round are kept.
+ *
+ *          tracking is 5 clock reads per round, so it is opt in.
+ */
+#ifndef SRC_CONTAINERS_QUERY_LATENCY_HPP_
+#define SRC_CONTAINERS_QUERY_LATENCY_HPP_
+
+#include <vector>
+#include <algorithm>   // max, min
+#include <chrono>
+#include <cmath>       // ceil
+#include <cstdint>
+#include <cstddef>
+
+namespace fsc {  // fast standard container
+
+  /// log-linear histogram of nanosecond latencies.  see file description.
+  class latency_histogram {
+    public:
+      static constexpr unsigned int sub_bits = 6;
+      static constexpr size_t sub_count = static_cast<size_t>(1) << sub_bits;
+      static constexpr size_t half_count = sub_count >> 1;
+      /// bins for all uint64_t values.
+      static constexpr size_t bins = sub_count + (64 - sub_bits) * half_count;
+
+    protected:
+      ::std::vector<uint64_t> counts;
+      uint64_t total;
+      uint64_t largest;
+
+    public:
+      latency_histogram() : counts(bins, 0), total(0), largest(0) {}
+
+      /// bin of value v.
+      static size_t bin_of(uint64_t const v) {
+        if (v < sub_count) return v;
+        unsigned int shift = (63 - __builtin_clzll(v)) - (sub_bits - 1);   // v >> shift is in [half_count, sub_count)
+        return sub_count + (shift - 1) * half_count + ((v >> shift) - half_count);
+      }
+      /// largest value in bin i.
+      static uint64_t bin_upper(size_t const i) {
+        if (i < sub_count) return i;
+        unsigned int shift = (i - sub_count) / half_count + 1;
+        uint64_t top = (i - sub_count) % half_count + half_count;
+        return ((top + 1) << shift) - 1;
+      }
+
+      void record(uint64_t const ns) {
+        ++counts[bin_of(ns)];
+        ++total;
+        largest = ::std::max(largest, ns);
+      }
+
+      /// add the values of another histogram, e.g. of another rank.
+      void merge(latency_histogram const & other) {
+        for (size_t i = 0; i < bins; ++i) counts[i] += other.counts[i];
+        total += other.total;
+        largest = ::std::max(largest, other.largest);
+      }
+
+      void clear() {
+        ::std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        largest = 0;
+      }
+
+      size_t count() const { return total; }
+      uint64_t max() const { return largest; }
+      /// the bins, for merging across ranks.
+      ::std::vector<uint64_t> const & get_counts() const { return counts; }
+
+      /// set from merged bins and max.
+      void assign(::std::vector<uint64_t> const & _counts, uint64_t const _max) {
+        counts = _counts;
+        counts.resize(bins, 0);
+        total = 0;
+        for (size_t i = 0; i < bins; ++i) total += counts[i];
+        largest = _max;
+      }
+
+      /// nearest rank percentile, q in [0, 1]:  the upper end of the bin of the ceil(q * count())-th value, at most max().  0 if empty.
+      uint64_t percentile(double const q) const {
+        if (total == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(::std::ceil(q * static_cast<double>(total)));
+        target = ::std::max(target, static_cast<uint64_t>(1));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bins; ++i) {
+          seen += counts[i];
+          if (seen >= target) return ::std::min(bin_upper(i), largest);
+        }
+        return largest;
+      }
+  };
+
+
+  /// merged query latencies of all ranks, from map_base::get_query_latency.  times in seconds.
+  struct query_latency_stats {
+      /// rounds over all ranks, i.e. comm size times the rounds of each rank.
+      size_t rounds;
+      /// latency of the rounds of all ranks.
+      double p50;
+      double p90;
+      double p99;
+      double max;
+
+      /// rank with the largest p99 of local work (bucketing + lookup), i.e. the one the others wait for in the tail.
+      int tail_rank;
+      double tail_work_p99;
+      /// phases of the slowest round of tail_rank, in query_latency_tracker::phase order.
+      double tail_phases[4];
+
+      query_latency_stats() : rounds(0), p50(0.0), p90(0.0), p99(0.0), max(0.0), tail_rank(0), tail_work_p99(0.0),
+          tail_phases{0.0, 0.0, 0.0, 0.0} {}
+  };
+
+
+  /// latencies of the query rounds of 1 rank.  see file description.
+  class query_latency_tracker {
+    public:
+      enum phase { bucketing = 0, exchange = 1, lookup = 2, reply = 3 };
+      static constexpr size_t phases = 4;
+
+      using clock_type = ::std::chrono::steady_clock;
+
+    protected:
+      bool enabled;
+      /// true during a tracked round, so that nested queries are recorded once, by the outermost.
+      bool busy;
+
+      latency_histogram rounds;
+      latency_histogram work;
+      uint64_t slowest[phases];
+
+    public:
+      query_latency_tracker() : enabled(false), busy(false), slowest{0, 0, 0, 0} {}
+
+      /// start tracking from scratch, or stop.
+      void enable(bool const on) {
+        enabled = on;
+        rounds.clear();
+        work.clear();
+        ::std::fill(slowest, slowest + phases, 0);
+      }
+      bool is_enabled() const {
+        return enabled;
+      }
+
+      /// start a tracked round.  false if tracking is off or a round is already being tracked.
+      bool enter() {
+        if (!enabled || busy) return false;
+        busy = true;
+        return true;
+      }
+      void leave() {
+        busy = false;
+      }
+
+      /// record a round with the nanoseconds of each phase.
+      void record(uint64_t const (&ns)[phases]) {
+        uint64_t t = ns[bucketing] + ns[exchange] + ns[lookup] + ns[reply];
+        if (rounds.count() == 0 || t > rounds.max()) ::std::copy(ns, ns + phases, slowest);
+        rounds.record(t);
+        work.record(ns[bucketing] + ns[lookup]);
+      }
+
+      latency_histogram const & get_rounds() const { return rounds; }
+      latency_histogram const & get_work() const { return work; }
+      /// phases of the slowest round so far, in nanoseconds.
+      uint64_t const * get_slowest() const { return slowest; }
+  };
+
+} // namespace fsc
+
+#endif // SRC_CONTAINERS_QUERY_LATENCY_HPP_
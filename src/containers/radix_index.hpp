@@ -0,0 +1,170 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    radix_index.hpp
+ * @ingroup fsc::containers
+ * @brief   lower_bound over a sorted array of radix keys (k-mers, unsigned integers), predicted from the key's top bits.
+ * @details the key range [first key, last key] of the array is cut into 2^bits equal buckets, and a table holds the
+ *          array position where each bucket starts.  a lookup reads 1 table entry and searches the bucket, so with
+ *          about uniformly distributed keys, e.g. hashed or random k-mers, it costs 1 or 2 cache misses.  skewed keys
+ *          only make some buckets, and their searches, larger.  the key order must be the radix order, i.e. std::less on
+ *          the keys (see radix_sort.hpp).  the index does not own the array.  rebuild it after the array changes.
+ */
+#ifndef SRC_CONTAINERS_RADIX_INDEX_HPP_
+#define SRC_CONTAINERS_RADIX_INDEX_HPP_
+
+#include <vector>
+#include <utility>   // pair
+#include <algorithm>  // lower_bound, min
+#include <iterator>  // distance
+#include <cstddef>   // size_t
+#include <cstdint>   // uint64_t
+#include <type_traits>  // integral_constant
+
+#include "containers/radix_sort.hpp"   // radix_key_traits
+
+namespace fsc {  // fast standard container
+
+  namespace detail {
+    /// true for radix keys of up to 8 bytes, i.e. keys that fit 1 uint64_t.
+    template <typename Key, bool = radix_key_traits<Key>::value>
+    struct radix_index_key : public ::std::false_type {};
+
+    template <typename Key>
+    struct radix_index_key<Key, true> : public ::std::integral_constant<bool, (radix_key_traits<Key>::bytes <= 8)> {};
+  }
+
+  /**
+   * @brief lower_bound positions in a sorted array of pairs, by the first element, via a table over the top key bits.
+   * @tparam Key   key type, i.e. the first element of the array's pairs.  radix_key_traits<Key> with up to 8 bytes.
+   * @tparam Less  comparator that accepts (pair, Key), and orders the keys as std::less does.
+   */
+  template <typename Key, typename Less, bool = detail::radix_index_key<Key>::value>
+  class radix_index {
+    public:
+      /// other keys:  no index.  callers check supported and use their own search.
+      static constexpr bool supported = false;
+
+      template <typename Iter>
+      void build(Iter, Iter, unsigned int = 0) {}
+      void clear() {}
+      bool empty() const { return true; }
+      size_t size() const { return 0; }
+
+      template <typename Iter, typename V>
+      size_t lower_bound(Iter first, V const &) const { return 0; }
+  };
+
+
+  template <typename Key, typename Less>
+  class radix_index<Key, Less, true> {
+    protected:
+      using traits = radix_key_traits<Key>;
+
+      /// position of the first element of each bucket, and the array size at the end.
+      ::std::vector<size_t> offsets;
+      /// smallest and largest key, as integers.
+      uint64_t lo;
+      uint64_t hi;
+      /// bucket of x is (x - lo) >> shift.
+      unsigned int shift;
+      /// size of the indexed array.
+      size_t n;
+
+      Less lt;
+
+      static inline uint64_t bits_of(Key const & k) {
+        uint64_t x = 0;
+        for (int b = traits::bytes - 1; b >= 0; --b) {
+          x = (x << 8) | traits::digit(k, b);
+        }
+        return x;
+      }
+
+    public:
+      static constexpr bool supported = true;
+
+      /// average elements per bucket when the number of bucket bits is not given.
+      static constexpr size_t default_bucket_size = 4;
+      /// largest table, 2^max_bits entries.
+      static constexpr unsigned int max_bits = 24;
+
+      radix_index(Less const & _lt = Less()) : lo(0), hi(0), shift(0), n(0), lt(_lt) {}
+
+      /// index the sorted range [first, last) with 2^bits buckets.  0 picks about n / default_bucket_size buckets.
+      template <typename Iter>
+      void build(Iter first, Iter last, unsigned int bits = 0) {
+        n = ::std::distance(first, last);
+        if (n == 0) {
+          clear();
+          return;
+        }
+
+        if (bits == 0) {
+          while ((bits < max_bits) && ((static_cast<size_t>(1) << (bits + 1)) * default_bucket_size <= n)) ++bits;
+          if (bits == 0) bits = 1;
+        }
+        bits = ::std::min(bits, max_bits);
+
+        lo = bits_of((*first).first);
+        hi = bits_of((*(first + (n - 1))).first);
+
+        // smallest shift that maps hi - lo into 2^bits buckets.
+        uint64_t range = hi - lo;
+        shift = 0;
+        while ((shift < 64) && ((range >> shift) >= (static_cast<uint64_t>(1) << bits))) ++shift;
+
+        size_t const buckets = static_cast<size_t>(1) << bits;
+        offsets.assign(buckets + 1, n);
+        size_t b = 0;
+        for (size_t i = 0; i < n; ++i) {
+          size_t bucket = static_cast<size_t>((bits_of((*(first + i)).first) - lo) >> shift);
+          for (; b <= bucket; ++b) offsets[b] = i;
+        }
+      }
+
+      void clear() {
+        ::std::vector<size_t>().swap(offsets);
+        n = 0;
+      }
+
+      bool empty() const {
+        return n == 0;
+      }
+
+      /// size of the indexed array.
+      size_t size() const {
+        return n;
+      }
+
+      /// position of the lower bound of v in the indexed array, which starts at first.
+      template <typename Iter>
+      size_t lower_bound(Iter first, Key const & v) const {
+        if (n == 0) return 0;
+
+        uint64_t x = bits_of(v);
+        if (x <= lo) return 0;
+        if (x > hi) return n;
+
+        size_t bucket = static_cast<size_t>((x - lo) >> shift);
+        return ::std::distance(first, ::std::lower_bound(first + offsets[bucket], first + offsets[bucket + 1], v, lt));
+      }
+  };
+
+}  // namespace fsc
+
+#endif // SRC_CONTAINERS_RADIX_INDEX_HPP_
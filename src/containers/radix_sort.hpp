@@ -0,0 +1,337 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    radix_sort.hpp
+ * @ingroup fsc::containers
+ * @brief   radix sort for k-mers (and unsigned integers), and pairs keyed by them.
+ * @details a k-mer compares as an unsigned number of nBits bits, with the last word most significant.  so sorting by bytes,
+ *          least significant first, gives the same order as operator<.
+ *
+ *          the sort first distributes by the most significant byte, in parallel (1 histogram per thread), then sorts
+ *          each of the 256 buckets independently with least significant digit passes.  a pass where all elements of a
+ *          bucket have the same byte is skipped, so unused high bits and low entropy bytes cost only a histogram.
+ *          uses a scratch buffer the size of the input.
+ *
+ *          prefix_sort is for k-mers of more than 64 bits, where a radix sort would take too many passes:  it radix
+ *          sorts (top 64 bits, index) pairs, then gathers, and compares full keys only within runs of equal prefixes.
+ */
+#ifndef SRC_CONTAINERS_RADIX_SORT_HPP_
+#define SRC_CONTAINERS_RADIX_SORT_HPP_
+
+#include <vector>
+#include <utility>   // pair
+#include <algorithm>  // sort, copy
+#include <iterator>  // distance
+#include <type_traits>
+#include <cstdint>  // uint8_t
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+namespace fsc {  // fast standard container
+
+  /// byte digits of a radix sortable key.  byte 0 is least significant.  value is false for other types.
+  template <typename K, typename = void>
+  struct radix_key_traits {
+      static constexpr bool value = false;
+  };
+
+  /// unsigned integers.
+  template <typename K>
+  struct radix_key_traits<K, typename ::std::enable_if<::std::is_integral<K>::value && ::std::is_unsigned<K>::value>::type> {
+      static constexpr bool value = true;
+      static constexpr unsigned int bytes = sizeof(K);
+
+      static inline uint8_t digit(K const & k, unsigned int b) {
+        return static_cast<uint8_t>(k >> (b << 3));
+      }
+  };
+
+  /// k-mers:  words, least significant first, with the bits above nBits set to 0.
+  template <typename K>
+  struct radix_key_traits<K, typename ::std::conditional<false, typename K::KmerWordType, void>::type> {
+      using word_type = typename K::KmerWordType;
+      static constexpr bool value = true;
+      static constexpr unsigned int bytes = (K::nBits + 7) / 8;
+
+      static inline uint8_t digit(K const & k, unsigned int b) {
+        return static_cast<uint8_t>(k.getData()[b / sizeof(word_type)] >> ((b % sizeof(word_type)) << 3));
+      }
+  };
+
+  /// k-mers of more than 64 bits in 64 bit words:  the most significant 64 of the nBits bits, the sort key of prefix_sort.
+  template <typename K, typename = void>
+  struct prefix_key_traits {
+      static constexpr bool value = false;
+  };
+
+  template <typename K>
+  struct prefix_key_traits<K, typename ::std::enable_if<::std::is_same<typename K::KmerWordType, uint64_t>::value &&
+                                                        (K::nBits > 64)>::type> {
+      static constexpr bool value = true;
+      /// used bits in the last word, 1 to 64.
+      static constexpr unsigned int top_bits = K::nBits - 64 * (K::nWords - 1);
+
+      static inline uint64_t prefix(K const & k) {
+        uint64_t const * w = k.getData();
+        return (top_bits == 64) ? w[K::nWords - 1] :
+            ((w[K::nWords - 1] << ((64 - top_bits) % 64)) | (w[K::nWords - 2] >> (top_bits % 64)));
+      }
+  };
+
+
+  namespace detail {
+
+    /// number of elements below which a bucket is sorted by comparison instead.
+    constexpr size_t radix_sort_min_size = 64;
+
+    /// LSD radix sort of [src, src + n) on bytes [0, nbytes), using dst as scratch.  returns src or dst, whichever has the result.
+    template <typename V, typename KeyOf>
+    V * lsd_radix_passes(V * src, V * dst, size_t n, unsigned int nbytes, KeyOf const & key_of) {
+      using K = typename ::std::decay<decltype(key_of(*src))>::type;
+      using traits = radix_key_traits<K>;
+
+      if (n < radix_sort_min_size) {
+        ::std::sort(src, src + n, [&key_of](V const & x, V const & y) { return key_of(x) < key_of(y); });
+        return src;
+      }
+
+      V * in = src;
+      V * out = dst;
+      size_t counts[256];
+      for (unsigned int b = 0; b < nbytes; ++b) {
+        ::std::fill(counts, counts + 256, 0UL);
+        for (size_t i = 0; i < n; ++i) ++counts[traits::digit(key_of(in[i]), b)];
+
+        // all in 1 bucket:  nothing to do for this digit.
+        if (counts[traits::digit(key_of(in[0]), b)] == n) continue;
+
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) {
+          size_t c = counts[d];
+          counts[d] = offset;
+          offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+          out[counts[traits::digit(key_of(in[i]), b)]++] = in[i];
+        }
+        ::std::swap(in, out);
+      }
+
+      return in;
+    }
+
+    /// LSD radix sort of [src, src + n) on bytes [0, nbytes), using dst as scratch.  the result is in src.
+    template <typename V, typename KeyOf>
+    void lsd_radix_sort(V * src, V * dst, size_t n, unsigned int nbytes, KeyOf const & key_of) {
+      V * result = lsd_radix_passes(src, dst, n, nbytes, key_of);
+      if (result != src) ::std::copy(result, result + n, src);
+    }
+
+    /// key of an element:  the element, or the first of a pair.
+    struct radix_identity_key {
+        template <typename K>
+        inline K const & operator()(K const & x) const { return x; }
+        template <typename K, typename T>
+        inline K const & operator()(::std::pair<K, T> const & x) const { return x.first; }
+    };
+  }
+
+
+  /**
+   * @brief sort by the radix sortable key of each element.  see file description.
+   * @param key_of  returns the key of an element.  the order is by key_of(x) as an unsigned number.
+   */
+  template <typename V, typename KeyOf>
+  void radix_sort(::std::vector<V> & input, KeyOf const & key_of) {
+    using K = typename ::std::decay<decltype(key_of(input[0]))>::type;
+    using traits = radix_key_traits<K>;
+    static_assert(traits::value, "radix_sort requires unsigned integer or k-mer keys");
+
+    size_t n = input.size();
+    if (n < detail::radix_sort_min_size) {
+      detail::lsd_radix_sort(input.data(), input.data(), n, traits::bytes, key_of);
+      return;
+    }
+
+    ::std::vector<V> buffer(n);
+    constexpr unsigned int top = traits::bytes - 1;
+
+    // MSD pass on the top byte:  per thread histograms over contiguous parts, then scatter into buffer.
+    int nthreads = 1;
+#if defined(USE_OPENMP)
+    nthreads = ::std::max(1, ::std::min(omp_get_max_threads(), static_cast<int>(n / (1UL << 16))));
+#endif
+    ::std::vector<size_t> counts(nthreads * 256, 0);
+    ::std::vector<size_t> bucket_starts(257, 0);
+
+#if defined(USE_OPENMP)
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+      int tid = 0;
+#if defined(USE_OPENMP)
+      tid = omp_get_thread_num();
+#endif
+      size_t first = n * tid / nthreads;
+      size_t last = n * (tid + 1) / nthreads;
+      size_t * cnt = counts.data() + tid * 256;
+
+      for (size_t i = first; i < last; ++i) ++cnt[traits::digit(key_of(input[i]), top)];
+
+#if defined(USE_OPENMP)
+#pragma omp barrier
+#pragma omp single
+#endif
+      {
+        // bucket major, then thread:  each thread's part of a bucket follows the previous thread's.
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) {
+          bucket_starts[d] = offset;
+          for (int t = 0; t < nthreads; ++t) {
+            size_t c = counts[t * 256 + d];
+            counts[t * 256 + d] = offset;
+            offset += c;
+          }
+        }
+        bucket_starts[256] = offset;
+      }
+      // implicit barrier at the end of single.
+
+      for (size_t i = first; i < last; ++i) {
+        buffer[cnt[traits::digit(key_of(input[i]), top)]++] = input[i];
+      }
+    }
+
+    // then LSD within each bucket, on the remaining bytes.  result goes back to input.
+    long nbuckets = 256;
+#if defined(USE_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+    for (long d = 0; d < nbuckets; ++d) {
+      size_t s = bucket_starts[d];
+      size_t len = bucket_starts[d + 1] - s;
+      if (len == 0) continue;
+      V * result = detail::lsd_radix_passes(buffer.data() + s, input.data() + s, len, top, key_of);
+      if (result != input.data() + s) ::std::copy(result, result + len, input.data() + s);
+    }
+  }
+
+  /// sort elements, or pairs by their first, by the radix sortable key.
+  template <typename V>
+  void radix_sort(::std::vector<V> & input) {
+    radix_sort(input, detail::radix_identity_key());
+  }
+
+  /// serial radix sort of [first, last) by key_of.  scratch is resized as needed, so 1 per thread can be reused across ranges.
+  template <typename V, typename KeyOf>
+  void radix_sort(V * first, V * last, ::std::vector<V> & scratch, KeyOf const & key_of) {
+    using K = typename ::std::decay<decltype(key_of(*first))>::type;
+    static_assert(radix_key_traits<K>::value, "radix_sort requires unsigned integer or k-mer keys");
+
+    size_t n = ::std::distance(first, last);
+    if (scratch.size() < n) scratch.resize(n);
+    detail::lsd_radix_sort(first, scratch.data(), n, radix_key_traits<K>::bytes, key_of);
+  }
+
+  /// serial radix sort of [first, last), elements or pairs by their first.
+  template <typename V>
+  void radix_sort(V * first, V * last, ::std::vector<V> & scratch) {
+    radix_sort(first, last, scratch, detail::radix_identity_key());
+  }
+
+
+  namespace detail {
+    /// gather [first, last) in the order of the radix sorted (prefix, index) pairs, and finish the runs of equal prefixes.
+    template <typename V, typename KeyOf>
+    void prefix_gather(V * first, ::std::vector<::std::pair<uint64_t, size_t> > const & order, ::std::vector<V> & scratch,
+                       KeyOf const & key_of) {
+      size_t n = order.size();
+      if (scratch.size() < n) scratch.resize(n);
+      for (size_t i = 0; i < n; ++i) scratch[i] = first[order[i].second];
+
+      auto less = [&key_of](V const & x, V const & y) { return key_of(x) < key_of(y); };
+      for (size_t i = 0; i < n; ) {
+        size_t j = i + 1;
+        while ((j < n) && (order[j].first == order[i].first)) ++j;
+        if ((j - i) > 1) ::std::sort(scratch.begin() + i, scratch.begin() + j, less);
+        i = j;
+      }
+      ::std::copy(scratch.begin(), scratch.begin() + n, first);
+    }
+  }
+
+  /**
+   * @brief sort k-mers of more than 64 bits, or pairs keyed by them, by key extraction.
+   * @details the top 64 bits of each key are extracted with the element's index, the (prefix, index) pairs are radix
+   *          sorted, and the elements are gathered in that order.  only runs of equal prefixes are then sorted by the full
+   *          key, so most of the work is on 16 byte records with integer keys, not on multi-word compares.
+   *          needs scratch space for the pairs, twice, and for the elements.
+   */
+  template <typename V, typename KeyOf>
+  void prefix_sort(::std::vector<V> & input, KeyOf const & key_of) {
+    using K = typename ::std::decay<decltype(key_of(input[0]))>::type;
+    static_assert(prefix_key_traits<K>::value, "prefix_sort requires k-mers of more than 64 bits in 64 bit words");
+
+    size_t n = input.size();
+    if (n < detail::radix_sort_min_size) {
+      ::std::sort(input.begin(), input.end(), [&key_of](V const & x, V const & y) { return key_of(x) < key_of(y); });
+      return;
+    }
+
+    ::std::vector<::std::pair<uint64_t, size_t> > order(n);
+#if defined(USE_OPENMP)
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < n; ++i) order[i] = ::std::make_pair(prefix_key_traits<K>::prefix(key_of(input[i])), i);
+    radix_sort(order);
+
+    ::std::vector<V> scratch;
+    detail::prefix_gather(input.data(), order, scratch, key_of);
+  }
+
+  /// sort elements, or pairs by their first, by the prefix of their k-mer key.
+  template <typename V>
+  void prefix_sort(::std::vector<V> & input) {
+    prefix_sort(input, detail::radix_identity_key());
+  }
+
+  /// serial prefix sort of [first, last).  scratch is resized as needed.
+  template <typename V>
+  void prefix_sort(V * first, V * last, ::std::vector<V> & scratch) {
+    using K = typename ::std::decay<decltype(detail::radix_identity_key()(*first))>::type;
+    static_assert(prefix_key_traits<K>::value, "prefix_sort requires k-mers of more than 64 bits in 64 bit words");
+
+    size_t n = ::std::distance(first, last);
+    if (n < detail::radix_sort_min_size) {
+      ::std::sort(first, last, [](V const & x, V const & y) {
+        return detail::radix_identity_key()(x) < detail::radix_identity_key()(y); });
+      return;
+    }
+
+    ::std::vector<::std::pair<uint64_t, size_t> > order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = ::std::make_pair(prefix_key_traits<K>::prefix(detail::radix_identity_key()(first[i])), i);
+    ::std::vector<::std::pair<uint64_t, size_t> > order_scratch;
+    radix_sort(order.data(), order.data() + n, order_scratch);
+
+    detail::prefix_gather(first, order, scratch, detail::radix_identity_key());
+  }
+
+}  // namespace fsc
+
+#endif // SRC_CONTAINERS_RADIX_SORT_HPP_
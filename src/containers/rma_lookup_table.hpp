@@ -0,0 +1,274 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    rma_lookup_table.hpp
+ * @ingroup dsc::containers
+ * @brief   read only snapshot of a distributed map, queried with one-sided MPI_Get instead of a collective exchange.
+ * @details the find of the distributed maps is collective:  every rank has to call it, even with no queries, because the
+ *          queries and answers go through all2allv.  for a static index that is queried in small batches by a subset of
+ *          the ranks (e.g. a read mapping service), this table copies each rank's entries into an open addressing array
+ *          (linear probing, at most max_load full) and exposes it through an MPI window.  a querying rank computes the
+ *          owner rank and the home slot of a key itself, and reads probe_width slots at a time with MPI_Get.
+ *          at load 0.5 nearly all keys are resolved by the first read, found or hit an empty slot.
+ *
+ *          construction and destruction are collective.  find is not:  the window stays in a passive target (lock_all)
+ *          epoch for the table's lifetime, so any rank may call find at any time, and the owners do not participate.
+ *          the table does not see later changes to the map.
+ *
+ *          the owner rank must be computed the same way the map distributed the keys, so to_rank is the map's key_to_rank,
+ *          and query keys go through the map's input transform.  keys are compared as stored, so the map's storage
+ *          transform needs to be identity (the default and canonical map parameters).  slots are read as raw bytes, so Key and
+ *          T should be trivially copyable in effect, as for any mxx datatype.
+ */
+#ifndef SRC_CONTAINERS_RMA_LOOKUP_TABLE_HPP_
+#define SRC_CONTAINERS_RMA_LOOKUP_TABLE_HPP_
+
+#include "bliss-config.hpp"
+
+#include <mpi.h>
+
+#include <vector>
+#include <memory>      // unique_ptr
+#include <utility>     // pair
+#include <functional>  // hash, equal_to
+#include <type_traits>
+#include <algorithm>   // max
+#include <cstdint>     // uint8_t
+
+#include "mxx/comm.hpp"
+#include "mxx/collective.hpp"
+
+#include "common/kmer.hpp"
+#include "index/kmer_hash.hpp"
+#include "utils/transform_utils.hpp"
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace dsc  // distributed std container
+{
+
+  /// default slot hash of the table:  farm hash for k-mers, std::hash otherwise.
+  template <typename K>
+  using rma_default_hash = typename ::std::conditional<::bliss::common::is_kmer<K>::value,
+      ::bliss::kmer::hash::farm<K, false>,
+      ::std::hash<K> >::type;
+
+
+  /**
+   * @brief read only distributed hash table queried with MPI_Get.  see file description.
+   * @tparam ToRank      owner rank of a transformed key, e.g. a distributed map's key_to_rank.
+   * @tparam Transform   applied to the query keys, e.g. a distributed map's input transform.
+   * @tparam Hash        slot hash of a transformed key.  mixed before use, so the same hash as ToRank is fine.
+   */
+  template <typename Key, typename T, typename ToRank,
+    typename Transform = ::bliss::transform::identity<Key>,
+    typename Hash = rma_default_hash<Key>,
+    typename Equal = ::std::equal_to<Key> >
+  class rma_lookup_table {
+
+    public:
+      using value_type = ::std::pair<Key, T>;
+
+      /// slots read by 1 MPI_Get.
+      static constexpr size_t probe_width = 8;
+
+    protected:
+      struct slot {
+          Key key;
+          T value;
+          uint8_t used;
+      };
+
+      ToRank to_rank;
+      Transform trans;
+      Hash hash;
+      Equal eq;
+
+      const mxx::comm& comm;
+
+      /// the local table.  the window's memory.
+      ::std::vector<slot> table;
+      /// table size of every rank, a power of 2.
+      ::std::vector<size_t> capacities;
+
+      MPI_Win win;
+
+      inline size_t home(Key const & k, size_t const capacity) const {
+        return ::bliss::utils::mix64(static_cast<uint64_t>(hash(k))) & (capacity - 1);
+      }
+
+    public:
+      /**
+       * @brief build from this rank's entries.  collective.
+       * @param entries   the local entries of the map, keys as stored, e.g. from the map's to_vector.
+       * @param max_load  maximum fraction of occupied slots.
+       */
+      rma_lookup_table(::std::vector<value_type> const & entries, ToRank const & _to_rank, const mxx::comm& _comm,
+                       double const max_load = 0.5) :
+        to_rank(_to_rank), trans(), hash(), eq(), comm(_comm), win(MPI_WIN_NULL) {
+        size_t capacity = probe_width;
+        while (static_cast<double>(capacity) * max_load < static_cast<double>(entries.size())) capacity <<= 1;
+
+        slot empty;
+        empty.key = Key();
+        empty.value = T();
+        empty.used = 0;
+        table.assign(capacity, empty);
+
+        // linear probing.  later duplicates of a key are dropped.
+        for (auto const & e : entries) {
+          size_t i = home(e.first, capacity);
+          while (table[i].used && !eq(table[i].key, e.first)) i = (i + 1) & (capacity - 1);
+          if (table[i].used) continue;
+          table[i].key = e.first;
+          table[i].value = e.second;
+          table[i].used = 1;
+        }
+
+        capacities = ::mxx::allgather(capacity, comm);
+
+        // a single rank reads its own table directly.
+        if (comm.size() > 1) {
+          MPI_Win_create(table.data(), static_cast<MPI_Aint>(capacity * sizeof(slot)), sizeof(slot), MPI_INFO_NULL, comm, &win);
+          MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+        }
+      }
+
+      /// collective.
+      ~rma_lookup_table() {
+        if (win != MPI_WIN_NULL) {
+          MPI_Win_unlock_all(win);
+          MPI_Win_free(&win);
+        }
+      }
+
+      rma_lookup_table(rma_lookup_table const & other) = delete;
+      rma_lookup_table& operator=(rma_lookup_table const & other) = delete;
+
+      /// local table size.
+      size_t local_capacity() const { return table.size(); }
+
+      /**
+       * @brief find the keys, not collective.  found entries are appended to results in query order.
+       * @details  all keys of a round read their next probe_width slots, then 1 flush completes the round.  keys not
+       *           resolved in a round (a full read with no match and no empty slot) continue in the next.  slots of
+       *           this rank are read directly.
+       * @return number of keys found.
+       */
+      size_t find(::std::vector<Key> const & keys, ::std::vector<value_type> & results) const {
+        struct probe {
+            Key key;
+            size_t idx;
+            int rank;
+            size_t pos;    // next slot to read
+            size_t read;   // slots read so far
+        };
+
+        ::std::vector<probe> pending;
+        pending.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+          probe p;
+          p.key = trans(keys[i]);
+          p.idx = i;
+          p.rank = to_rank(p.key);
+          p.pos = home(p.key, capacities[p.rank]);
+          p.read = 0;
+          pending.emplace_back(p);
+        }
+
+        ::std::vector<uint8_t> found(keys.size(), 0);
+        ::std::vector<T> values(keys.size());
+        ::std::vector<slot> buffer;
+
+        int const me = comm.rank();
+        while (pending.size() > 0) {
+          buffer.resize(pending.size() * probe_width);
+
+          // issue the reads of this round.  a read that wraps around the end of the table is split in 2.
+          for (size_t j = 0; j < pending.size(); ++j) {
+            probe const & p = pending[j];
+            size_t const cap = capacities[p.rank];
+            size_t const first = ((cap - p.pos) < probe_width) ? (cap - p.pos) : probe_width;
+            slot * out = buffer.data() + j * probe_width;
+            if (p.rank == me) {
+              ::std::copy(table.data() + p.pos, table.data() + p.pos + first, out);
+              ::std::copy(table.data(), table.data() + (probe_width - first), out + first);
+            } else {
+              MPI_Get(out, static_cast<int>(first * sizeof(slot)), MPI_BYTE, p.rank, static_cast<MPI_Aint>(p.pos),
+                      static_cast<int>(first * sizeof(slot)), MPI_BYTE, win);
+              if (first < probe_width)
+                MPI_Get(out + first, static_cast<int>((probe_width - first) * sizeof(slot)), MPI_BYTE, p.rank, 0,
+                        static_cast<int>((probe_width - first) * sizeof(slot)), MPI_BYTE, win);
+            }
+          }
+          if (win != MPI_WIN_NULL) MPI_Win_flush_all(win);
+
+          // resolve.
+          size_t next = 0;
+          for (size_t j = 0; j < pending.size(); ++j) {
+            probe p = pending[j];
+            slot const * s = buffer.data() + j * probe_width;
+            bool done = false;
+            for (size_t w = 0; w < probe_width; ++w) {
+              if (!s[w].used) {
+                done = true;
+                break;
+              } else if (eq(s[w].key, p.key)) {
+                found[p.idx] = 1;
+                values[p.idx] = s[w].value;
+                done = true;
+                break;
+              }
+            }
+            p.read += probe_width;
+            // a table with fewer than probe_width empty slots is fully read after capacity slots.
+            if (done || (p.read >= capacities[p.rank])) continue;
+            p.pos = (p.pos + probe_width) & (capacities[p.rank] - 1);
+            pending[next++] = p;
+          }
+          pending.resize(next);
+        }
+
+        size_t count = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+          if (found[i]) {
+            results.emplace_back(trans(keys[i]), values[i]);
+            ++count;
+          }
+        }
+        return count;
+      }
+  };
+
+
+  /**
+   * @brief snapshot a distributed densehash map into an rma_lookup_table.  collective.
+   * @param _comm  the map's communicator.
+   */
+  template <typename Map, typename Key = typename Map::key_type, typename T = typename Map::mapped_type,
+    typename ToRank = typename ::std::decay<decltype(::std::declval<Map const &>().get_key_to_rank())>::type,
+    typename Transform = typename Map::input_transform_type>
+  ::std::unique_ptr<rma_lookup_table<Key, T, ToRank, Transform> >
+  make_rma_lookup_table(Map const & map, const mxx::comm& _comm, double const max_load = 0.5) {
+    ::std::vector<::std::pair<Key, T> > entries;
+    map.to_vector(entries);
+    return ::std::unique_ptr<rma_lookup_table<Key, T, ToRank, Transform> >(
+        new rma_lookup_table<Key, T, ToRank, Transform>(entries, map.get_key_to_rank(), _comm, max_load));
+  }
+
+} /* namespace dsc */
+
+#endif // SRC_CONTAINERS_RMA_LOOKUP_TABLE_HPP_
@@ -0,0 +1,598 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    soa_hash_map.hpp
+ * @ingroup fsc::containers
+ * @brief   open addressing hash map with keys and values in separate arrays.
+ * @details densehash_map and unordered_vecmap store ::std::pair<Key, T>.  for a 64 bit kmer and a 32 bit count
+ *          the pair is padded to 16 bytes, and probing drags the values through the cache along with the keys.
+ *          this map keeps keys, values, and a 1 byte probe distance in 3 separate arrays (structure of arrays).
+ *          probing touches the info and key arrays only, and the value array is accessed once per hit.
+ *
+ *          Robin Hood linear probing is used:  an entry with a shorter probe distance yields its slot to one with
+ *          a longer distance, so a lookup can stop as soon as it sees an entry closer to its home than the query would be.
+ *          deletion shifts the following entries back, so there are no tombstones and no deleted key is needed.
+ *          the empty key is also not needed, since occupancy is in the info array.
+ *
+ *          the template parameters are the same as ::fsc::densehash_map, so this can be used as the Container
+ *          for ::dsc::densehash_map_base.  SpecialKeys is only used to construct the Equal object when that
+ *          requires (empty, deleted) keys, e.g. ::fsc::sparsehash::compare.  the split parameter is ignored.
+ *
+ *          iterators dereference to ::std::pair<Key const &, T &>, which refer into the 2 arrays.
+ *          iterators are invalidated by insert (on growth) and erase (entries shift back).
+ */
+#ifndef SRC_CONTAINERS_SOA_HASH_MAP_HPP_
+#define SRC_CONTAINERS_SOA_HASH_MAP_HPP_
+
+#include <vector>
+#include <functional>  // hash, equal_to, etc
+#include <utility>   // pair
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>   // ceil
+#include <cstdint>  // uint8_t
+
+#include "containers/fsc_container_utils.hpp"
+#include "containers/table_stats.hpp"
+#include "utils/transform_utils.hpp"
+
+namespace fsc {  // fast standard container
+
+  namespace soa {
+
+    /// construct Equal with default constructor if possible
+    template <typename Equal, typename SpecialKeys>
+    inline typename ::std::enable_if<::std::is_default_constructible<Equal>::value, Equal>::type
+    make_equal(SpecialKeys & ) {
+      return Equal();
+    }
+
+    /// construct Equal with the (empty, deleted) special keys, e.g. for ::fsc::sparsehash::compare
+    template <typename Equal, typename SpecialKeys>
+    inline typename ::std::enable_if<!::std::is_default_constructible<Equal>::value, Equal>::type
+    make_equal(SpecialKeys & specials) {
+      return Equal(specials.generate(0), specials.generate(1));
+    }
+
+    /// special keys placeholder, for when Equal is default constructible.
+    struct no_special_keys {
+        static constexpr bool need_to_split = false;
+    };
+  }  // namespace soa
+
+
+/**
+ * @brief open addressing, robin hood hashed map, with keys and values stored in separate arrays.
+ * @details  see file description.  interface follows ::fsc::densehash_map.
+ *           capacity is a power of 2.  max load factor is 0.8.  the probe distance is stored in 1 byte, and the
+ *           table is grown if a probe distance would exceed 254.
+ */
+template <typename Key,
+typename T,
+typename SpecialKeys = ::fsc::soa::no_special_keys,
+template<typename> class Transform = ::bliss::transform::identity,
+typename Hash =  ::fsc::TransformedHash<Key, ::std::hash, Transform>,
+typename Equal = ::fsc::TransformedComparator<Key, ::std::equal_to, Transform>,
+typename Allocator = ::std::allocator<::std::pair<const Key, T> >,
+bool split = SpecialKeys::need_to_split >
+class soa_hash_map {
+
+  protected:
+    using key_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<Key>;
+    using val_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    using info_alloc_type = typename ::std::allocator_traits<Allocator>::template rebind_alloc<uint8_t>;
+
+    /// largest probe distance + 1 stored in info.  0 means empty.
+    static constexpr uint8_t max_dist = 254;
+
+    SpecialKeys specials;
+    Hash hash;
+    Equal eq;
+
+    ::std::vector<Key, key_alloc_type> keys_;
+    ::std::vector<T, val_alloc_type> vals_;
+    ::std::vector<uint8_t, info_alloc_type> info_;
+
+    size_t mask;
+    size_t count_;
+    float max_load;
+
+  public:
+    using key_type              = Key;
+    using mapped_type           = T;
+    using value_type            = ::std::pair<const Key, T>;
+    using hasher                = Hash;
+    using key_equal             = Equal;
+    using allocator_type        = Allocator;
+    using reference             = ::std::pair<const Key &, T &>;
+    using const_reference       = ::std::pair<const Key &, const T &>;
+    using size_type             = size_t;
+    using difference_type       = ptrdiff_t;
+
+  protected:
+    /// proxy so that it->second works when the iterator dereferences to a temporary pair of references.
+    template <typename Ref>
+    struct arrow_proxy {
+        Ref r;
+        Ref * operator->() { return &r; }
+    };
+
+    template <bool IS_CONST>
+    class soa_iterator {
+        friend class soa_hash_map;
+        template <bool> friend class soa_iterator;
+
+        using map_ptr = typename ::std::conditional<IS_CONST, soa_hash_map const *, soa_hash_map *>::type;
+
+        map_ptr m;
+        size_t pos;
+
+        /// move to the next occupied slot, starting at pos.
+        inline void skip_empty() {
+          size_t const cap = m->info_.size();
+          while ((pos < cap) && (m->info_[pos] == 0)) ++pos;
+        }
+
+      public:
+        using iterator_category = ::std::forward_iterator_tag;
+        using value_type = typename soa_hash_map::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = typename ::std::conditional<IS_CONST,
+            typename soa_hash_map::const_reference, typename soa_hash_map::reference>::type;
+        using pointer = arrow_proxy<reference>;
+
+        soa_iterator() : m(nullptr), pos(0) {}
+        soa_iterator(map_ptr _m, size_t _pos) : m(_m), pos(_pos) {}
+
+        /// conversion from non-const to const iterator
+        template <bool C = IS_CONST, typename = typename ::std::enable_if<C>::type>
+        soa_iterator(soa_iterator<false> const & other) : m(other.m), pos(other.pos) {}
+
+        reference operator*() const {
+          return reference(m->keys_[pos], m->vals_[pos]);
+        }
+        pointer operator->() const {
+          return pointer{this->operator*()};
+        }
+
+        soa_iterator & operator++() {
+          ++pos;
+          skip_empty();
+          return *this;
+        }
+        soa_iterator operator++(int) {
+          soa_iterator out(*this);
+          ++(*this);
+          return out;
+        }
+
+        bool operator==(soa_iterator const & other) const {
+          return pos == other.pos;
+        }
+        bool operator!=(soa_iterator const & other) const {
+          return pos != other.pos;
+        }
+    };
+
+  public:
+    using iterator              = soa_iterator<false>;
+    using const_iterator        = soa_iterator<true>;
+    using pointer               = typename iterator::pointer;
+    using const_pointer         = typename const_iterator::pointer;
+
+  protected:
+
+    inline size_t home(Key const & key) const {
+      return hash(key) & mask;
+    }
+
+    /// position of key, or capacity if not found.
+    size_t find_pos(Key const & key) const {
+      size_t pos = home(key);
+      uint8_t dist = 1;
+      // robin hood:  stop when the slot is empty or holds an entry closer to its home than we are.
+      while (info_[pos] >= dist) {
+        if ((info_[pos] == dist) && eq(keys_[pos], key)) return pos;
+        pos = (pos + 1) & mask;
+        ++dist;
+      }
+      return info_.size();
+    }
+
+    /// place a key that is known to be absent.  returns the position of the key.  may grow the table.
+    size_t emplace_new(Key key, T val) {
+      Key const orig = key;
+      size_t result = info_.size();
+
+      size_t pos = home(key);
+      uint8_t dist = 1;
+      while (true) {
+        if (info_[pos] == 0) {
+          keys_[pos] = ::std::move(key);
+          vals_[pos] = ::std::move(val);
+          info_[pos] = dist;
+          ++count_;
+          return (result == info_.size()) ? pos : result;
+        }
+        if (info_[pos] < dist) {
+          // take from the rich.  continue placing the displaced entry.
+          ::std::swap(key, keys_[pos]);
+          ::std::swap(val, vals_[pos]);
+          ::std::swap(dist, info_[pos]);
+          if (result == info_.size()) result = pos;
+        }
+        pos = (pos + 1) & mask;
+
+        if (dist == max_dist) {
+          // probe distance too long.  grow, then place the entry still in hand.
+          rehash_to(info_.size() << 1);
+          emplace_new(::std::move(key), ::std::move(val));
+          return find_pos(orig);
+        }
+        ++dist;
+      }
+    }
+
+    /// remove the entry at pos, shifting the following entries back.
+    void erase_pos(size_t pos) {
+      size_t next = (pos + 1) & mask;
+      while (info_[next] > 1) {
+        keys_[pos] = ::std::move(keys_[next]);
+        vals_[pos] = ::std::move(vals_[next]);
+        info_[pos] = info_[next] - 1;
+        pos = next;
+        next = (next + 1) & mask;
+      }
+      info_[pos] = 0;
+      --count_;
+    }
+
+    /// smallest power of 2 capacity that holds n elements under max load factor.
+    size_t capacity_for(size_t n) const {
+      size_t needed = static_cast<size_t>(::std::ceil(static_cast<double>(n) / max_load));
+      size_t cap = 8;
+      while (cap < needed) cap <<= 1;
+      return cap;
+    }
+
+    /// reallocate to new_cap buckets (power of 2) and reinsert all entries
+    void rehash_to(size_t new_cap) {
+      ::std::vector<Key, key_alloc_type> old_keys(new_cap);
+      ::std::vector<T, val_alloc_type> old_vals(new_cap);
+      ::std::vector<uint8_t, info_alloc_type> old_info(new_cap, 0);
+      old_keys.swap(keys_);
+      old_vals.swap(vals_);
+      old_info.swap(info_);
+      mask = new_cap - 1;
+      count_ = 0;
+
+      for (size_t i = 0; i < old_info.size(); ++i) {
+        if (old_info[i] == 0) continue;
+        emplace_new(::std::move(old_keys[i]), ::std::move(old_vals[i]));
+      }
+    }
+
+  public:
+
+    soa_hash_map(size_type bucket_count = 128) :
+      specials(), hash(), eq(::fsc::soa::make_equal<Equal>(specials)),
+      mask(0), count_(0), max_load(0.8) {
+      size_t cap = 8;
+      while (cap < bucket_count) cap <<= 1;
+      keys_.resize(cap);
+      vals_.resize(cap);
+      info_.resize(cap, 0);
+      mask = cap - 1;
+    };
+
+    template<class InputIt>
+    soa_hash_map(InputIt first, InputIt last) :
+      soa_hash_map(std::distance(first, last)) {
+      this->insert(first, last);
+    };
+
+    virtual ~soa_hash_map() {};
+
+    float get_max_load_factor() const {
+      return max_load;
+    }
+
+    iterator begin() {
+      iterator it(this, 0);
+      it.skip_empty();
+      return it;
+    }
+    const_iterator begin() const {
+      return cbegin();
+    }
+    const_iterator cbegin() const {
+      const_iterator it(this, 0);
+      it.skip_empty();
+      return it;
+    }
+
+    iterator end() {
+      return iterator(this, info_.size());
+    }
+    const_iterator end() const {
+      return cend();
+    }
+    const_iterator cend() const {
+      return const_iterator(this, info_.size());
+    }
+
+
+    std::vector<Key> keys() const {
+      std::vector<Key> ks;
+
+      keys(ks);
+
+      return ks;
+    }
+    void keys(std::vector<Key> & ks) const {
+      ks.clear();
+      ks.reserve(size());
+
+      for (size_t i = 0; i < info_.size(); ++i) {
+        if (info_[i] != 0) ks.emplace_back(keys_[i]);
+      }
+    }
+
+    std::vector<std::pair<Key, T> > to_vector() const {
+      std::vector<std::pair<Key, T>> vs;
+
+      to_vector(vs);
+
+      return vs;
+    }
+    void to_vector(  std::vector<std::pair<Key, T> > & vs) const {
+      vs.clear();
+      vs.reserve(size());
+
+      for (size_t i = 0; i < info_.size(); ++i) {
+        if (info_[i] != 0) vs.emplace_back(keys_[i], vals_[i]);
+      }
+    }
+
+
+    bool empty() const {
+      return count_ == 0;
+    }
+
+    size_type size() const {
+      return count_;
+    }
+    size_type unique_size() const {
+      return count_;
+    }
+
+    /// clear and release memory, back to the default capacity.
+    void reset() {
+      ::std::vector<Key, key_alloc_type>(128).swap(keys_);
+      ::std::vector<T, val_alloc_type>(128).swap(vals_);
+      ::std::vector<uint8_t, info_alloc_type>(128, 0).swap(info_);
+      mask = 127;
+      count_ = 0;
+    }
+
+    /// clear without releasing memory.
+    void clear() {
+      ::std::fill(info_.begin(), info_.end(), 0);
+      count_ = 0;
+    }
+
+    /// make room for at least n elements.  does not shrink.
+    void resize(size_t const n) {
+      size_t cap = capacity_for(::std::max(n, count_));
+      if (cap > info_.size()) rehash_to(cap);
+    }
+
+    /// rehash for new count number of BUCKETS.  iterators are invalidated.
+    void rehash(size_type count) {
+      this->resize(count);
+    }
+
+    /// bucket count.
+    size_type bucket_count() const {
+      return info_.size();
+    }
+
+    float load_factor() const {
+      return  static_cast<float>(count_) / static_cast<float>(info_.size());
+    }
+
+    /// probe lengths of the table, read from the info array.  there are no tombstones.  see containers/table_stats.hpp
+    ::fsc::table_stats get_table_stats() const {
+      ::fsc::table_stats stats;
+      stats.buckets = info_.size();
+      for (size_t i = 0; i < info_.size(); ++i) {
+        if (info_[i] == 0) continue;
+        ++stats.occupied;
+        stats.add_probe(info_[i]);
+      }
+      return stats;
+    }
+
+
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+      for (; first != last; ++first) {
+        this->insert(*first);
+      }
+    }
+
+    void insert(::std::vector<::std::pair<Key, T> > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    void insert(::std::vector<value_type > & input) {
+      insert(input.begin(), input.end());
+    }
+
+    /// insert if absent.  existing entries are not modified, same as std::unordered_map
+    template <typename K = Key, typename = typename std::enable_if<!std::is_const<Key>::value> >
+    std::pair<iterator, bool> insert(::std::pair<Key, T> const & x) {
+      size_t pos = find_pos(x.first);
+      if (pos != info_.size()) return std::make_pair(iterator(this, pos), false);
+
+      if ((count_ + 1) > static_cast<size_t>(max_load * static_cast<float>(info_.size())))
+        rehash_to(info_.size() << 1);
+
+      return std::make_pair(iterator(this, emplace_new(x.first, x.second)), true);
+    }
+
+    std::pair<iterator, bool> insert(::std::pair<const Key, T> const & x) {
+      return this->insert(::std::pair<Key, T>(x.first, x.second));
+    }
+
+    template <typename V, typename Updater>
+    size_t update(::std::vector<::std::pair<Key, V> > & input, Updater const & op) {
+
+      if (input.size() == 0) return 0;
+
+      size_t count = 0;
+      size_t pos;
+
+      for (auto vv : input) {
+        pos = find_pos(vv.first);
+        if (pos == info_.size()) continue;
+
+        // update the entry
+        count += op(vals_[pos], vv.second );
+      }
+
+      return count;
+    }
+
+    // non distributed version
+    template <typename Filter, typename Updater>
+    size_t update(Filter const & fop, Updater const & op) {
+      size_t count = 0;
+
+      for (auto iter = this->begin(); iter != this->end(); ++iter) {
+        if (fop(*iter)) {
+          count += op((*iter).second);
+        }
+      }
+
+      return count;
+    }
+
+
+    template <typename InputIt, typename Pred>
+    size_t erase(InputIt first, InputIt last, Pred const & pred) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      size_t count = 0;
+      size_t pos;
+
+      for (; first != last; ++first) {
+        pos = find_pos(*first);
+        if (pos == info_.size()) continue;
+
+        if (pred(*(iterator(this, pos)))) {
+          erase_pos(pos);
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    template <typename InputIt>
+    size_t erase(InputIt first, InputIt last) {
+      static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                    "InputIt value type for erase cannot be converted to key type");
+
+      if (first == last) return 0;
+
+      size_t count = 0;
+      size_t pos;
+
+      for (; first != last; ++first) {
+        pos = find_pos(*first);
+        if (pos == info_.size()) continue;
+
+        erase_pos(pos);
+        ++count;
+      }
+      return count;
+    }
+
+    template <typename Pred>
+    size_t erase(Pred const & pred) {
+      size_t before = count_;
+
+      // erase shifts later entries into the current slot, so check the slot again before moving on.
+      for (size_t i = 0; i < info_.size(); ++i) {
+        while ((info_[i] != 0) && pred(*(iterator(this, i))))
+          erase_pos(i);
+      }
+
+      return before - count_;
+    }
+
+    size_type count(Key const & key) const {
+      return (find_pos(key) == info_.size()) ? 0 : 1;
+    }
+
+
+    ::std::pair<iterator, iterator> equal_range(Key const & key) {
+      iterator it = find(key);
+      if (it == end()) return ::std::make_pair(it, it);
+      iterator next = it;
+      ++next;
+      return ::std::make_pair(it, next);
+    }
+    ::std::pair<const_iterator, const_iterator> equal_range(Key const & key) const {
+      const_iterator it = find(key);
+      if (it == cend()) return ::std::make_pair(it, it);
+      const_iterator next = it;
+      ++next;
+      return ::std::make_pair(it, next);
+    }
+
+    iterator find(Key const &key) {
+      return iterator(this, find_pos(key));
+    }
+
+    const_iterator find(Key const &key) const {
+      return const_iterator(this, find_pos(key));
+    }
+
+    /// prefetch the home slot of a key in the info and key arrays, ahead of find/count/equal_range.
+    inline void prefetch(Key const & key) const {
+#if defined(__GNUC__)
+      size_t pos = home(key);
+      __builtin_prefetch(info_.data() + pos, 0, 1);
+      __builtin_prefetch(keys_.data() + pos, 0, 1);
+#endif
+    }
+
+    inline bool exists(Key const & key) const {
+      return find_pos(key) != info_.size();
+    }
+
+};
+
+
+}  // namespace fsc
+
+#endif /* SRC_CONTAINERS_SOA_HASH_MAP_HPP_ */
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    soa_vector.hpp
+ * @ingroup fsc::containers
+ * @brief   struct of arrays buffer of (key, value) pairs, for tuples moving from the parsers through distribute to insert.
+ * @details a ::std::vector<::std::pair<Kmer, V> > pads each element to the alignment of the k-mer words, e.g. a 31-mer
+ *          with a 4 byte count takes 16 bytes instead of 12, and a pass that needs only the keys, e.g. the rank
+ *          computation of distribute, reads the values too.  soa_vector keeps the keys and the values in 2 vectors:
+ *          no padding, and key only passes read the keys only.
+ *
+ *          begin() and end() zip the 2 vectors into read only iterators of pairs, so code written for pair ranges, e.g.
+ *          the maps' local_insert, reads it unchanged.  emplace_back accepts pairs, so ::fsc::back_emplace_iterator fills
+ *          it from the output of any tuple parser.  ::imxx::distribute has an overload that buckets by the keys and
+ *          exchanges the 2 arrays separately.
+ */
+#ifndef SRC_CONTAINERS_SOA_VECTOR_HPP_
+#define SRC_CONTAINERS_SOA_VECTOR_HPP_
+
+#include <vector>
+#include <utility>    // pair
+#include <cstddef>    // size_t
+
+#include "iterators/zip_iterator.hpp"
+
+namespace fsc {  // fast standard container
+
+  /**
+   * @brief (key, value) pairs stored as a key vector and a value vector of the same size.
+   * @tparam Key   key type, e.g. a k-mer.
+   * @tparam T     value type.
+   */
+  template <typename Key, typename T>
+  class soa_vector {
+    public:
+      using key_type = Key;
+      using mapped_type = T;
+      using value_type = ::std::pair<Key, T>;
+      using const_iterator = ::bliss::iterator::ZipIterator<typename ::std::vector<Key>::const_iterator,
+                                                           typename ::std::vector<T>::const_iterator>;
+
+      /// the keys.  same size as values.
+      ::std::vector<Key> keys;
+      /// the values, aligned to keys.
+      ::std::vector<T> values;
+
+      soa_vector() {}
+
+      /// copy of a range of pairs.
+      template <typename Iter>
+      soa_vector(Iter first, Iter last) {
+        this->assign(first, last);
+      }
+
+      template <typename Iter>
+      void assign(Iter first, Iter last) {
+        this->clear();
+        for (; first != last; ++first) this->emplace_back((*first).first, (*first).second);
+      }
+
+      /// copy out as pairs.
+      void to_pairs(::std::vector<value_type> & out) const {
+        out.clear();
+        out.reserve(this->size());
+        for (size_t i = 0; i < keys.size(); ++i) out.emplace_back(keys[i], values[i]);
+      }
+
+      size_t size() const {
+        return keys.size();
+      }
+
+      bool empty() const {
+        return keys.empty();
+      }
+
+      void clear() {
+        keys.clear();
+        values.clear();
+      }
+
+      void reserve(size_t const n) {
+        keys.reserve(n);
+        values.reserve(n);
+      }
+
+      void resize(size_t const n) {
+        keys.resize(n);
+        values.resize(n);
+      }
+
+      void shrink_to_fit() {
+        keys.shrink_to_fit();
+        values.shrink_to_fit();
+      }
+
+      void swap(soa_vector & other) {
+        keys.swap(other.keys);
+        values.swap(other.values);
+      }
+
+      /// memory held, in bytes.
+      size_t bytes() const {
+        return keys.capacity() * sizeof(Key) + values.capacity() * sizeof(T);
+      }
+
+      void emplace_back(Key const & k, T const & v) {
+        keys.emplace_back(k);
+        values.emplace_back(v);
+      }
+
+      void emplace_back(value_type const & x) {
+        this->emplace_back(x.first, x.second);
+      }
+
+      void push_back(value_type const & x) {
+        this->emplace_back(x.first, x.second);
+      }
+
+      value_type operator[](size_t const i) const {
+        return value_type(keys[i], values[i]);
+      }
+
+      const_iterator begin() const {
+        return const_iterator(keys.cbegin(), values.cbegin());
+      }
+
+      const_iterator end() const {
+        return const_iterator(keys.cend(), values.cend());
+      }
+  };
+
+} // namespace fsc
+
+#endif // SRC_CONTAINERS_SOA_VECTOR_HPP_
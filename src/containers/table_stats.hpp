@@ -0,0 +1,230 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    table_stats.hpp
+ * @ingroup fsc::containers
+ * @brief   hash table health:  load factor, probe lengths, tombstones, and rehashes, for choosing hashes and containers.
+ * @details table_stats is a snapshot of 1 table, collected by a scan of its buckets:
+ *          for a google dense_hash_map (open addressing, triangular probing), the probe length of an entry is the number
+ *          of buckets find() visits to reach it, and deleted buckets are tombstones.
+ *          for a chaining table (std::unordered_map, and the vecmaps built on it), it is the entry's position in its
+ *          bucket's chain.  chaining tables have no tombstones.
+ *
+ *          table_tracker records what a snapshot cannot:  the rehashes during inserts, and the load factor after each.
+ *          rehashes are seen as a change of the bucket count across an insert, and their time is that of the inserts
+ *          that rehashed, since the tables rehash internally.
+ *
+ *          collecting is O(buckets) and tracking is 2 clock reads per insert, so both are opt in.
+ */
+#ifndef SRC_CONTAINERS_TABLE_STATS_HPP_
+#define SRC_CONTAINERS_TABLE_STATS_HPP_
+
+#include <vector>
+#include <utility>     // pair
+#include <algorithm>   // max, min
+#include <chrono>
+#include <cstddef>
+
+namespace fsc {  // fast standard container
+
+  /// snapshot of the health of 1 or more hash tables.  see file description.
+  struct table_stats {
+      /// probe lengths 1 to bins - 1 have their own bin.  the last bin counts longer probes.
+      static constexpr size_t bins = 32;
+
+      size_t buckets;
+      size_t occupied;
+      size_t tombstones;
+
+      /// probes[i - 1] entries have probe length i.
+      ::std::vector<size_t> probes;
+      size_t total_probes;
+      size_t max_probe;
+
+      /// from table_tracker.
+      size_t rehashes;
+      double rehash_seconds;
+      /// (seconds since tracking started, load factor) after each tracked insert.
+      ::std::vector<::std::pair<double, float> > load_history;
+
+      table_stats() : buckets(0), occupied(0), tombstones(0), probes(bins, 0), total_probes(0), max_probe(0),
+          rehashes(0), rehash_seconds(0.0) {}
+
+      inline void add_probe(size_t const len) {
+        ++probes[((len < bins) ? len : bins) - 1];   // not min, which would odr-use bins
+        total_probes += len;
+        max_probe = ::std::max(max_probe, len);
+      }
+
+      /// add the buckets and entries of another table, e.g. the other half of a split table.
+      void merge(table_stats const & other) {
+        buckets += other.buckets;
+        occupied += other.occupied;
+        tombstones += other.tombstones;
+        for (size_t i = 0; i < bins; ++i) probes[i] += other.probes[i];
+        total_probes += other.total_probes;
+        max_probe = ::std::max(max_probe, other.max_probe);
+        rehashes += other.rehashes;
+        rehash_seconds += other.rehash_seconds;
+        load_history.insert(load_history.end(), other.load_history.begin(), other.load_history.end());
+      }
+
+      double load_factor() const {
+        return (buckets == 0) ? 0.0 : static_cast<double>(occupied) / static_cast<double>(buckets);
+      }
+      /// fraction of the used buckets that are tombstones.
+      double tombstone_ratio() const {
+        return (occupied + tombstones == 0) ? 0.0 : static_cast<double>(tombstones) / static_cast<double>(occupied + tombstones);
+      }
+      double mean_probe() const {
+        return (occupied == 0) ? 0.0 : static_cast<double>(total_probes) / static_cast<double>(occupied);
+      }
+      /// smallest probe length that at least fraction q of the entries do not exceed.  capped at bins.
+      size_t probe_percentile(double const q) const {
+        size_t target = static_cast<size_t>(q * static_cast<double>(occupied));
+        size_t seen = 0;
+        for (size_t i = 0; i < bins; ++i) {
+          seen += probes[i];
+          if (seen >= target) return i + 1;
+        }
+        return bins;
+      }
+  };
+
+
+  /**
+   * @brief  add the buckets of a google dense_hash_map to stats.
+   * @details  the table address is taken from end(), as in sparsehash::prefetch_hashed.  a bucket holding the empty key
+   *           is empty, the deleted key a tombstone.  otherwise the probe sequence of its key is followed from
+   *           hash & (buckets - 1), with step i at probe i, as in dense_hashtable::find_position.
+   */
+  template <typename DenseHashMap>
+  void collect_dense_table_stats(DenseHashMap const & m, table_stats & stats) {
+    size_t const n = m.bucket_count();
+    stats.buckets += n;
+    if (n == 0) return;
+
+    auto table = m.end().pos - n;
+    auto eq = m.key_eq();
+    auto hash = m.hash_funct();
+    auto const empty_key = m.empty_key();
+    auto const deleted_key = m.deleted_key();
+    size_t const mask = n - 1;
+
+    for (size_t b = 0; b < n; ++b) {
+      auto const & key = table[b].first;
+      if (eq(key, empty_key)) continue;
+      if (eq(key, deleted_key)) {
+        ++stats.tombstones;
+        continue;
+      }
+
+      ++stats.occupied;
+      size_t pos = hash(key) & mask;
+      size_t len = 1;
+      while ((pos != b) && (len <= n)) {
+        pos = (pos + len) & mask;
+        ++len;
+      }
+      stats.add_probe(len);
+    }
+  }
+
+  /**
+   * @brief  add the buckets of a chaining table with the std bucket interface to stats.  entries are the table's
+   *         elements, e.g. the per key vectors of a vecmap.
+   */
+  template <typename ChainedMap>
+  void collect_chained_table_stats(ChainedMap const & m, table_stats & stats) {
+    size_t const n = m.bucket_count();
+    stats.buckets += n;
+    for (size_t b = 0; b < n; ++b) {
+      size_t const len = m.bucket_size(b);
+      stats.occupied += len;
+      for (size_t i = 1; i <= len; ++i) stats.add_probe(i);
+    }
+  }
+
+
+  /**
+   * @brief  rehashes and load factor over time, from the bucket counts before and after each insert.  see file description.
+   */
+  class table_tracker {
+    protected:
+      using clock_type = ::std::chrono::steady_clock;
+
+      bool enabled;
+      /// true during a tracked insert, so that nested inserts are recorded once, by the outermost.
+      bool busy;
+      clock_type::time_point start;
+
+      size_t rehashes;
+      double rehash_seconds;
+      ::std::vector<::std::pair<double, float> > history;
+
+    public:
+      table_tracker() : enabled(false), busy(false), rehashes(0), rehash_seconds(0.0) {}
+
+      /// start tracking from scratch, or stop.
+      void enable(bool const on) {
+        enabled = on;
+        rehashes = 0;
+        rehash_seconds = 0.0;
+        history.clear();
+        start = clock_type::now();
+      }
+      bool is_enabled() const {
+        return enabled;
+      }
+
+      /// start a tracked insert.  false if tracking is off or an insert is already being tracked.
+      bool enter() {
+        if (!enabled || busy) return false;
+        busy = true;
+        return true;
+      }
+      void leave() {
+        busy = false;
+      }
+
+      /// current time, for a tracked insert.
+      clock_type::time_point now() const {
+        return clock_type::now();
+      }
+
+      /// record an insert that started at t, with the table's bucket count before and after, and its size after.
+      void record(clock_type::time_point const & t, size_t const buckets_before, size_t const buckets_after, size_t const size_after) {
+        clock_type::time_point end = clock_type::now();
+        if (buckets_after != buckets_before) {
+          ++rehashes;
+          rehash_seconds += ::std::chrono::duration<double>(end - t).count();
+        }
+        history.emplace_back(::std::chrono::duration<double>(end - start).count(),
+                             (buckets_after == 0) ? 0.0f : static_cast<float>(size_after) / static_cast<float>(buckets_after));
+      }
+
+      /// copy the tracked rehashes and load factors into stats.
+      void fill(table_stats & stats) const {
+        stats.rehashes += rehashes;
+        stats.rehash_seconds += rehash_seconds;
+        stats.load_history.insert(stats.load_history.end(), history.begin(), history.end());
+      }
+  };
+
+} // namespace fsc
+
+#endif /* SRC_CONTAINERS_TABLE_STATS_HPP_ */
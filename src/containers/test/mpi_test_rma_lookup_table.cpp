@@ -0,0 +1,135 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_rma_lookup_table.cpp
+ *   builds an rma_lookup_table and queries it from 1 rank at a time, without the other ranks participating.
+ */
+
+
+#include "bliss-config.hpp"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "containers/rma_lookup_table.hpp"
+
+
+template <typename K>
+struct ModToRank {
+    int p;
+    explicit ModToRank(int _p) : p(_p) {}
+    inline int operator()(K const & x) const { return static_cast<int>((x.getData()[0] * 0x9E3779B97F4A7C15ULL) >> 40) % p; }
+};
+
+
+class RMALookupTableTest : public ::testing::Test
+{
+  protected:
+    using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+    using TableType = ::dsc::rma_lookup_table<KmerType, uint32_t, ModToRank<KmerType> >;
+
+    /// the k-mer of i.
+    static KmerType make(uint64_t i) {
+      KmerType k;
+      k.getDataRef()[0] = i;
+      return k;
+    }
+
+    /// every rank generates the same n even keys, and keeps the ones it owns.  the value is the key / 2.
+    static std::vector<std::pair<KmerType, uint32_t> > local_entries(size_t n, ModToRank<KmerType> const & to_rank, int rank) {
+      std::vector<std::pair<KmerType, uint32_t> > entries;
+      for (size_t i = 0; i < n; ++i) {
+        KmerType k = make(2 * i);
+        if (to_rank(k) == rank) entries.emplace_back(k, static_cast<uint32_t>(i));
+      }
+      return entries;
+    }
+
+    void check(size_t const n, double const load) {
+      ::mxx::comm comm;
+      ModToRank<KmerType> to_rank(comm.size());
+
+      TableType table(local_entries(n, to_rank, comm.rank()), to_rank, comm, load);
+      EXPECT_LE(static_cast<double>(local_entries(n, to_rank, comm.rank()).size()), load * table.local_capacity());
+
+      // 1 rank at a time queries all keys, present (even) and absent (odd).  the others only wait.
+      for (int q = 0; q < comm.size(); ++q) {
+        if (comm.rank() == q) {
+          std::vector<KmerType> keys;
+          for (size_t i = 0; i < 2 * n; ++i) keys.emplace_back(make(i));
+
+          std::vector<std::pair<KmerType, uint32_t> > results;
+          size_t found = table.find(keys, results);
+          EXPECT_EQ(n, found);
+          ASSERT_EQ(n, results.size());
+          for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(make(2 * i), results[i].first);
+            EXPECT_EQ(i, results[i].second);
+          }
+
+          // empty query.
+          std::vector<KmerType> none;
+          EXPECT_EQ(0UL, table.find(none, results));
+        }
+        comm.barrier();
+      }
+    }
+};
+
+
+TEST_F(RMALookupTableTest, find_half_load)
+{
+  this->check(10000, 0.5);
+}
+
+TEST_F(RMALookupTableTest, find_full_load)
+{
+  // most probes need more than 1 read.
+  this->check(10000, 0.95);
+}
+
+TEST_F(RMALookupTableTest, find_empty)
+{
+  this->check(0, 0.5);
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_snapshot_map.cpp
+ *   inserts into a snapshot_map on 1 thread while another queries it.  needs MPI_THREAD_MULTIPLE, and is skipped without.
+ */
+
+
+#include "bliss-config.hpp"
+
+#include <mpi.h>
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <thread>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_index.hpp"
+#include "containers/distributed_unordered_map.hpp"
+#include "containers/distributed_snapshot_map.hpp"
+
+
+using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::CanonicalHashMapParams<Key>;
+
+using MapType = ::dsc::counting_unordered_map<KmerType, uint32_t, MapParams>;
+using SnapshotType = ::dsc::snapshot_map<MapType>;
+
+namespace {
+  /// the k-mer of i.
+  KmerType make(uint64_t i) {
+    KmerType k;
+    k.getDataRef()[0] = i;
+    return k;
+  }
+}
+
+
+TEST(SnapshotMapThreads, insert_while_query)
+{
+  ::mxx::comm comm;
+  if (!SnapshotType::concurrent_ok()) {
+    if (comm.rank() == 0) printf("MPI_THREAD_MULTIPLE not provided.  skipped.\n");
+    return;
+  }
+
+  size_t const n = 1000;
+  size_t const rounds = 10;
+
+  std::vector<KmerType> published;
+  for (size_t i = 0; i < n; ++i) published.push_back(make(comm.rank() * 1000000UL + i));
+
+  SnapshotType m(comm);
+  std::vector<KmerType> batch(published);
+  m.insert(batch);
+  m.publish();
+
+  std::vector<KmerType> query(published);
+  size_t const expected = m.find(query).size();
+  EXPECT_LT(0UL, ::mxx::allreduce(expected, comm));
+
+  // inserts on the ingest communicator, on their own thread.
+  std::thread ingest([&m, &comm, n, rounds]() {
+    for (size_t r = 0; r < rounds; ++r) {
+      std::vector<KmerType> keys;
+      for (size_t i = 0; i < n; ++i) keys.push_back(make((1UL << 40) + comm.rank() * 1000000UL + r * n + i));
+      m.insert(keys);
+    }
+  });
+
+  // queries on the query communicator meanwhile see the published snapshot only.
+  std::vector<size_t> found;
+  for (size_t r = 0; r < rounds; ++r) {
+    query = published;
+    found.push_back(m.find(query).size());
+  }
+  ingest.join();
+
+  for (size_t r = 0; r < rounds; ++r) EXPECT_EQ(expected, found[r]) << "round " << r;
+
+  size_t pending = m.delta().local_size();
+  EXPECT_LT(0UL, ::mxx::allreduce(pending, comm));
+  EXPECT_EQ(pending, m.publish());
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  // initialized here rather than by mxx::env, to ask for MPI_THREAD_MULTIPLE.
+  int provided = MPI_THREAD_SINGLE;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+  {
+    ::mxx::comm comm;
+
+    result = RUN_ALL_TESTS();
+
+    comm.barrier();
+  }
+
+  MPI_Finalize();
+
+  return result;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint32_t
+#include <vector>
+#include <functional>
+
+
+/// buckets with repeated values.  some buckets are empty.
+class BucketUtilsTest : public ::testing::TestWithParam<size_t>
+{
+  protected:
+
+    ::std::vector<uint32_t> input;
+    ::std::vector<size_t> counts;
+
+    virtual void SetUp()
+    {
+      size_t nbuckets = GetParam();
+
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint32_t> distribution(0, 1000);
+
+      counts.resize(nbuckets, 0);
+      for (size_t i = 0; i < nbuckets; ++i) {
+        if (i % 5 == 3) continue;
+        counts[i] = 100 + (i * 37) % 2000;
+        for (size_t j = 0; j < counts[i]; ++j) {
+          input.emplace_back(distribution(generator));
+        }
+      }
+    }
+
+    /// expected output:  each bucket sorted and unique.
+    void sorted_unique_gold(::std::vector<uint32_t> & gold, ::std::vector<size_t> & gold_counts) {
+      gold.clear();
+      gold_counts.clear();
+      auto start = input.begin();
+      for (auto c : counts) {
+        ::std::vector<uint32_t> b(start, start + c);
+        ::std::sort(b.begin(), b.end());
+        b.erase(::std::unique(b.begin(), b.end()), b.end());
+        gold.insert(gold.end(), b.begin(), b.end());
+        gold_counts.emplace_back(b.size());
+        start += c;
+      }
+    }
+
+    /// sort each bucket in the result, so unordered results can be compared.
+    void sort_buckets(::std::vector<uint32_t> & vals, ::std::vector<size_t> const & cnts) {
+      auto start = vals.begin();
+      for (auto c : cnts) {
+        ::std::sort(start, start + c);
+        start += c;
+      }
+    }
+};
+
+
+TEST_P(BucketUtilsTest, sort)
+{
+  ::std::vector<uint32_t> gold = input;
+  sort_buckets(gold, counts);
+
+  bool sorted = false;
+  ::std::vector<size_t> cnts = counts;
+  ::fsc::bucket_sort(input, cnts, sorted, ::std::less<uint32_t>());
+
+  EXPECT_TRUE(sorted);
+  EXPECT_EQ(counts, cnts);
+  EXPECT_EQ(gold, input);
+}
+
+TEST_P(BucketUtilsTest, sorted_unique)
+{
+  ::std::vector<uint32_t> gold;
+  ::std::vector<size_t> gold_counts;
+  sorted_unique_gold(gold, gold_counts);
+
+  bool sorted = false;
+  ::fsc::bucket_sorted_unique(input, counts, sorted, ::std::less<uint32_t>(), ::std::equal_to<uint32_t>());
+
+  EXPECT_TRUE(sorted);
+  EXPECT_EQ(gold_counts, counts);
+  EXPECT_EQ(gold, input);
+}
+
+TEST_P(BucketUtilsTest, unique)
+{
+  ::std::vector<uint32_t> gold;
+  ::std::vector<size_t> gold_counts;
+  sorted_unique_gold(gold, gold_counts);
+
+  bool sorted = false;
+  ::fsc::bucket_unique(input, counts, sorted, ::std::hash<uint32_t>(), ::std::equal_to<uint32_t>());
+
+  EXPECT_EQ(gold_counts, counts);
+  sort_buckets(input, counts);
+  EXPECT_EQ(gold, input);
+}
+
+TEST_P(BucketUtilsTest, reduce)
+{
+  ::std::vector<uint32_t> gold;
+  ::std::vector<size_t> gold_counts;
+  sorted_unique_gold(gold, gold_counts);
+
+  using Iter = ::std::vector<uint32_t>::iterator;
+  bool sorted = false;
+  ::fsc::bucket_reduce(input, counts, sorted, [](Iter & first, Iter & last, Iter & output, bool & input_sorted) {
+    if (!input_sorted) ::std::sort(first, last);
+    if (first == output) return ::std::unique(first, last);
+    else return ::std::unique_copy(first, last, output);
+  });
+
+  EXPECT_TRUE(sorted);
+  EXPECT_EQ(gold_counts, counts);
+  EXPECT_EQ(gold, input);
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, BucketUtilsTest, ::testing::Values(
+    1UL, 2UL, 7UL, 64UL, 257UL
+    ));
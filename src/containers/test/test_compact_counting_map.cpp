@@ -0,0 +1,162 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/compact_counting_map.hpp"
+
+#include <unordered_map>
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+
+
+/*
+ * test class holding some information.  Also, needed for the typed tests
+ */
+template<typename T>
+class CompactCountingMapTest : public ::testing::Test
+{
+  protected:
+
+    ::std::unordered_map<uint64_t, T> gold;
+    ::std::vector<uint64_t> temp;
+
+    size_t iters = 200000;
+
+    virtual void SetUp()
+    { // generate some inputs.  skewed so that some keys have counts > 255, most do not.
+
+      std::default_random_engine generator;
+      std::geometric_distribution<uint64_t> distribution(0.01);
+
+      for (size_t i=0; i< iters; ++i) {
+        uint64_t key = distribution(generator);
+        ++gold[key];
+        temp.emplace_back(key);
+      }
+    }
+
+    template <typename MAP>
+    void count_all(MAP & test) {
+      // same reduction as the distributed reduction map's local insert.
+      for (auto k : this->temp) {
+        auto result = test.insert(::std::make_pair(k, T(1)));
+        if (!result.second) result.first->second = result.first->second + T(1);
+      }
+    }
+
+    template <typename MAP>
+    void check(MAP const & test) {
+      ::std::vector<::std::pair<uint64_t, T> > test_vals = test.to_vector();
+      ASSERT_EQ(this->gold.size(), test_vals.size());
+
+      for (auto x : test_vals) {
+        EXPECT_EQ(this->gold.at(x.first), x.second) << "key " << x.first;
+      }
+    }
+};
+
+// indicate this is a typed test
+TYPED_TEST_CASE_P(CompactCountingMapTest);
+
+TYPED_TEST_P(CompactCountingMapTest, count)
+{
+  using MAP = ::fsc::compact_counting_map<uint64_t, TypeParam>;
+
+  MAP test(8);
+  this->count_all(test);
+  this->check(test);
+
+  size_t large = 0;
+  for (auto x : this->gold) {
+    if (x.second >= 255) ++large;
+  }
+  EXPECT_LT(0UL, large);
+  EXPECT_EQ(large, test.overflow_size());
+
+  for (auto x : this->gold) {
+    auto it = test.find(x.first);
+    ASSERT_TRUE(it != test.end());
+    EXPECT_EQ(x.second, static_cast<TypeParam>(it->second));
+    EXPECT_EQ(1UL, test.count(x.first));
+  }
+}
+
+TYPED_TEST_P(CompactCountingMapTest, update)
+{
+  using MAP = ::fsc::compact_counting_map<uint64_t, TypeParam>;
+
+  MAP test;
+  this->count_all(test);
+
+  // halve every count, moving some entries out of the overflow table.
+  test.update([](::std::pair<uint64_t, TypeParam> const &) { return true; },
+              [](TypeParam & v) { v /= 2; return 1; });
+  for (auto & x : this->gold) x.second /= 2;
+  this->check(test);
+
+  size_t large = 0;
+  for (auto x : this->gold) {
+    if (x.second >= 255) ++large;
+  }
+  EXPECT_EQ(large, test.overflow_size());
+
+  // add a large amount to specific keys
+  ::std::vector<::std::pair<uint64_t, TypeParam> > input;
+  for (uint64_t k = 0; k < 10; ++k) input.emplace_back(k, 1000);
+  test.update(input, [](TypeParam & v, TypeParam const & x) { v += x; return 1; });
+  for (uint64_t k = 0; k < 10; ++k) {
+    if (this->gold.count(k) > 0) this->gold[k] += 1000;
+  }
+  this->check(test);
+}
+
+TYPED_TEST_P(CompactCountingMapTest, erase)
+{
+  using MAP = ::fsc::compact_counting_map<uint64_t, TypeParam>;
+
+  MAP test;
+  this->count_all(test);
+
+  // erase all large counts by predicate.
+  size_t large = test.overflow_size();
+  EXPECT_EQ(large, test.erase([](::std::pair<uint64_t, TypeParam> const & x) { return x.second >= 255; }));
+  EXPECT_EQ(0UL, test.overflow_size());
+
+  // erase some keys by key.
+  ::std::vector<uint64_t> keys;
+  for (uint64_t k = 300; k < 400; ++k) keys.emplace_back(k);
+  test.erase(keys.begin(), keys.end());
+
+  for (auto it = this->gold.begin(); it != this->gold.end(); ) {
+    if ((it->second >= 255) || ((it->first >= 300) && (it->first < 400))) it = this->gold.erase(it);
+    else ++it;
+  }
+  this->check(test);
+}
+
+// now register the test cases
+REGISTER_TYPED_TEST_CASE_P(CompactCountingMapTest, count, update, erase);
+
+
+//////////////////// RUN the tests with different types.
+
+typedef ::testing::Types<uint16_t, uint32_t, uint64_t> CompactCountingMapTestTypes;
+INSTANTIATE_TYPED_TEST_CASE_P(Bliss, CompactCountingMapTest, CompactCountingMapTestTypes);
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/concurrent_densehash_map.hpp"
+
+#include <unordered_map>
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+#include <functional>
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+
+template <typename Key, typename T>
+using ConcurrentMap = ::fsc::concurrent_densehash_map<Key, T>;
+
+
+class ConcurrentDensehashMapTest : public ::testing::Test
+{
+  protected:
+
+    ::std::unordered_map<uint64_t, uint32_t> counts;
+    ::std::vector<::std::pair<uint64_t, uint32_t> > ones;
+
+    size_t iters = 200000;
+
+    virtual void SetUp()
+    { // generate some inputs with repeats.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution(0, 50000);
+
+      for (size_t i=0; i< iters; ++i) {
+        uint64_t key = distribution(generator);
+        ++counts[key];
+        ones.emplace_back(key, 1);
+      }
+    }
+
+    template <typename MAP>
+    void check(MAP const & test) {
+      ::std::vector<::std::pair<uint64_t, uint32_t> > result = test.to_vector();
+      ASSERT_EQ(this->counts.size(), result.size());
+      for (auto x : result) {
+        EXPECT_EQ(this->counts.at(x.first), x.second) << "key " << x.first;
+      }
+    }
+};
+
+
+TEST_F(ConcurrentDensehashMapTest, count)
+{
+  ConcurrentMap<uint64_t, uint32_t> test;
+  // 2 rounds, to reduce against existing entries too.  starts small so the table grows between rounds.
+  size_t half = ones.size() / 2;
+  size_t added = test.insert(ones.begin(), ones.begin() + half, ::std::plus<uint32_t>());
+  added += test.insert(ones.begin() + half, ones.end(), ::std::plus<uint32_t>());
+  EXPECT_EQ(counts.size(), added);
+  EXPECT_LE(test.load_factor(), test.get_max_load_factor());
+
+  this->check(test);
+
+  for (auto x : this->counts) {
+    auto it = test.find(x.first);
+    ASSERT_TRUE(it != test.end());
+    EXPECT_EQ(x.second, it->second);
+    EXPECT_EQ(1UL, test.count(x.first));
+  }
+  EXPECT_TRUE(test.find(100000) == test.end());
+}
+
+TEST_F(ConcurrentDensehashMapTest, reduce)
+{
+  // max, through the compare and swap path.
+  ::std::unordered_map<uint64_t, uint32_t> gold;
+  ::std::vector<::std::pair<uint64_t, uint32_t> > input;
+  for (size_t i = 0; i < ones.size(); ++i) {
+    uint32_t v = static_cast<uint32_t>((i * 7919) % 10007);
+    auto result = gold.emplace(ones[i].first, v);
+    if (!result.second) result.first->second = ::std::max(result.first->second, v);
+    input.emplace_back(ones[i].first, v);
+  }
+
+  ConcurrentMap<uint64_t, uint32_t> test;
+  EXPECT_EQ(gold.size(), test.insert(input.begin(), input.end(),
+                                     [](uint32_t const & x, uint32_t const & y) { return ::std::max(x, y); }));
+
+  ASSERT_EQ(gold.size(), test.size());
+  for (auto x : gold) {
+    auto it = test.find(x.first);
+    ASSERT_TRUE(it != test.end());
+    EXPECT_EQ(x.second, it->second);
+  }
+}
+
+TEST_F(ConcurrentDensehashMapTest, concurrent_insert)
+{
+  // threads managed outside of the map.
+  ConcurrentMap<uint64_t, uint32_t> test;
+  test.resize(counts.size());
+
+  ::std::plus<uint32_t> r;
+#if defined(USE_OPENMP)
+#pragma omp parallel for firstprivate(r)
+#endif
+  for (size_t i = 0; i < ones.size(); ++i) {
+    test.concurrent_insert(ones[i], r);
+  }
+
+  this->check(test);
+}
+
+TEST_F(ConcurrentDensehashMapTest, erase)
+{
+  ConcurrentMap<uint64_t, uint32_t> test;
+  test.insert(ones.begin(), ones.end(), ::std::plus<uint32_t>());
+
+  ::std::vector<uint64_t> keys;
+  for (uint64_t k = 0; k < 1000; ++k) keys.emplace_back(k);
+  size_t erased = test.erase(keys.begin(), keys.end());
+
+  size_t expected = 0;
+  for (auto k : keys) expected += this->counts.erase(k);
+  EXPECT_EQ(expected, erased);
+
+  erased = test.erase([](::std::pair<uint64_t, uint32_t> const & x) { return (x.second & 1) == 1; });
+  expected = 0;
+  for (auto it = this->counts.begin(); it != this->counts.end(); ) {
+    if ((it->second & 1) == 1) {
+      it = this->counts.erase(it);
+      ++expected;
+    } else ++it;
+  }
+  EXPECT_EQ(expected, erased);
+
+  // remaining entries are still reachable after the backward shifts.
+  this->check(test);
+  for (auto x : this->counts) {
+    EXPECT_TRUE(test.exists(x.first));
+  }
+}
+
+TEST_F(ConcurrentDensehashMapTest, rehash)
+{
+  ConcurrentMap<uint64_t, uint32_t> test;
+  test.insert(ones.begin(), ones.end(), ::std::plus<uint32_t>());
+
+  // large enough for the multithreaded rehash, twice.
+  size_t buckets = test.bucket_count();
+  test.resize(4 * counts.size());
+  EXPECT_LT(buckets, test.bucket_count());
+  this->check(test);
+  test.resize(16 * counts.size());
+  this->check(test);
+
+  // every entry is reachable from its home slot, so erase and reinsertion still work.
+  ::std::vector<uint64_t> keys;
+  for (uint64_t k = 0; k < 1000; ++k) keys.emplace_back(k);
+  size_t expected = 0;
+  for (auto k : keys) expected += this->counts.erase(k);
+  EXPECT_EQ(expected, test.erase(keys.begin(), keys.end()));
+  this->check(test);
+}
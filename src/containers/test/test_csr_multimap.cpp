@@ -0,0 +1,192 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/csr_multimap.hpp"
+
+#include <map>
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+
+
+class CsrMultimapTest : public ::testing::Test
+{
+  protected:
+    using MapType = ::fsc::csr_multimap<uint32_t, uint64_t>;
+
+    ::std::multimap<uint32_t, uint64_t> gold;
+    ::std::vector<std::pair<uint32_t, uint64_t> > temp;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint32_t> key_dist(0, 999);
+      std::uniform_int_distribution<uint64_t> val_dist(0, 1ULL << 40);
+
+      for (size_t i = 0; i < 50000; ++i) {
+        uint32_t key = key_dist(generator);
+        uint64_t val = val_dist(generator);
+        gold.emplace(key, val);
+        temp.emplace_back(key, val);
+      }
+    }
+
+    void check(MapType const & map) {
+      EXPECT_EQ(gold.size(), map.size());
+
+      size_t keys = 0;
+      for (uint32_t k = 0; k < 1000; ++k) {
+        auto range = gold.equal_range(k);
+        std::vector<uint64_t> expected;
+        for (auto it = range.first; it != range.second; ++it) expected.push_back(it->second);
+        std::sort(expected.begin(), expected.end());
+        if (!expected.empty()) ++keys;
+
+        ASSERT_EQ(expected.size(), map.count(k));
+        EXPECT_EQ(!expected.empty(), map.exists(k));
+
+        std::vector<uint64_t> vals;
+        auto found = map.equal_range(k);
+        for (auto it = found.first; it != found.second; ++it) {
+          EXPECT_EQ(k, it->first);
+          vals.push_back(it->second);
+        }
+        std::sort(vals.begin(), vals.end());
+        ASSERT_EQ(expected, vals);
+      }
+      EXPECT_EQ(keys, map.unique_size());
+
+      // full iteration and to_vector see the same entries.
+      std::vector<std::pair<uint32_t, uint64_t> > all(map.begin(), map.end());
+      std::vector<std::pair<uint32_t, uint64_t> > vec = map.to_vector();
+      std::vector<std::pair<uint32_t, uint64_t> > expected(gold.begin(), gold.end());
+      std::sort(all.begin(), all.end());
+      std::sort(vec.begin(), vec.end());
+      std::sort(expected.begin(), expected.end());
+      EXPECT_EQ(expected, all);
+      EXPECT_EQ(expected, vec);
+    }
+};
+
+
+TEST_F(CsrMultimapTest, insert_batch)
+{
+  MapType map;
+  map.insert(temp);
+  EXPECT_EQ(1000UL, map.unique_size());
+  check(map);
+
+  std::vector<size_t> totals(::fsc::parallel_for_each_threads(0), 0);
+  map.parallel_for_each_key([&totals](uint32_t const &, size_t const n, int const tid) {
+    totals[tid] += n;
+  });
+  size_t total = 0;
+  for (size_t t : totals) total += t;
+  EXPECT_EQ(temp.size(), total);
+
+  EXPECT_EQ(map.unique_size(), map.get_table_stats().occupied);
+}
+
+TEST_F(CsrMultimapTest, insert_incremental)
+{
+  MapType map;
+  for (size_t i = 0; i < temp.size(); i += 997) {
+    std::vector<std::pair<uint32_t, uint64_t> > batch(temp.begin() + i, temp.begin() + std::min(i + 997, temp.size()));
+    map.insert(batch);
+  }
+  check(map);
+
+  map.compact();
+  check(map);
+}
+
+TEST_F(CsrMultimapTest, erase)
+{
+  MapType map;
+  map.insert(temp);
+
+  std::vector<uint32_t> ks;
+  for (uint32_t k = 0; k < 1000; k += 2) ks.push_back(k);
+  ks.push_back(2000);  // absent
+
+  size_t erased = map.erase(ks.begin(), ks.end());
+  size_t expected = 0;
+  for (uint32_t k : ks) expected += gold.erase(k);
+  EXPECT_EQ(expected, erased);
+  check(map);
+
+  // the remaining slots were renumbered.  inserting again still finds them.
+  std::vector<std::pair<uint32_t, uint64_t> > more;
+  for (uint32_t k = 0; k < 1000; k += 3) {
+    more.emplace_back(k, 7);
+    gold.emplace(k, 7);
+  }
+  map.insert(more);
+  check(map);
+}
+
+TEST_F(CsrMultimapTest, erase_pred)
+{
+  MapType map;
+  map.insert(temp);
+
+  auto odd = [](std::pair<uint32_t, uint64_t> const & x) { return (x.second & 1) == 1; };
+
+  // odd values of the first 100 keys.
+  std::vector<uint32_t> ks;
+  for (uint32_t k = 0; k < 100; ++k) ks.push_back(k);
+  size_t erased = map.erase(ks.begin(), ks.end(), odd);
+  size_t expected = 0;
+  for (auto it = gold.begin(); it != gold.end(); ) {
+    if ((it->first < 100) && odd(*it)) { it = gold.erase(it); ++expected; }
+    else ++it;
+  }
+  EXPECT_EQ(expected, erased);
+  check(map);
+
+  // all odd values.
+  erased = map.erase(odd);
+  expected = 0;
+  for (auto it = gold.begin(); it != gold.end(); ) {
+    if (odd(*it)) { it = gold.erase(it); ++expected; }
+    else ++it;
+  }
+  EXPECT_EQ(expected, erased);
+  check(map);
+}
+
+TEST_F(CsrMultimapTest, clear)
+{
+  MapType map(temp.begin(), temp.end());
+  check(map);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0UL, map.unique_size());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_EQ(0UL, map.count(temp[0].first));
+
+  map.insert(temp);
+  check(map);
+
+  map.reset();
+  EXPECT_TRUE(map.empty());
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/delta_multimap.hpp"
+#include "common/sequence.hpp"
+
+#include <map>
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+
+
+class DeltaMultimapTest : public ::testing::Test
+{
+  protected:
+    using MapType = ::fsc::delta_multimap<uint32_t, uint64_t>;
+
+    ::std::multimap<uint32_t, uint64_t> gold;
+    ::std::vector<std::pair<uint32_t, uint64_t> > temp;
+
+    virtual void SetUp()
+    {
+      // few keys, many values per key, values drawn from a wide range.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint32_t> key_dist(0, 999);
+      std::uniform_int_distribution<uint64_t> val_dist(0, 1ULL << 40);
+
+      for (size_t i = 0; i < 50000; ++i) {
+        uint32_t key = key_dist(generator);
+        uint64_t val = (i % 7 == 0) ? 12345 : val_dist(generator);   // some duplicate values
+        gold.emplace(key, val);
+        temp.emplace_back(key, val);
+      }
+    }
+
+    void check(MapType const & map) {
+      EXPECT_EQ(gold.size(), map.size());
+
+      std::vector<uint64_t> vals;
+      for (uint32_t k = 0; k < 1000; ++k) {
+        auto range = gold.equal_range(k);
+        std::vector<uint64_t> expected;
+        for (auto it = range.first; it != range.second; ++it) expected.push_back(it->second);
+        std::sort(expected.begin(), expected.end());
+
+        ASSERT_EQ(expected.size(), map.count(k));
+
+        vals.clear();
+        EXPECT_EQ(expected.size(), map.find(k, vals));
+        ASSERT_EQ(expected, vals);
+
+        auto lazy = map.equal_range(k);
+        std::vector<uint64_t> decoded(lazy.first, lazy.second);
+        ASSERT_EQ(expected, decoded);
+      }
+    }
+};
+
+
+TEST_F(DeltaMultimapTest, insert_batch)
+{
+  MapType map;
+  map.insert(temp);
+  EXPECT_EQ(1000UL, map.unique_size());
+  check(map);
+
+  // far smaller than the (key, value) pairs.
+  EXPECT_LT(map.arena_bytes() * 2, temp.size() * sizeof(std::pair<uint32_t, uint64_t>));
+}
+
+TEST_F(DeltaMultimapTest, insert_incremental)
+{
+  MapType map;
+  for (size_t i = 0; i < temp.size(); i += 997) {
+    std::vector<std::pair<uint32_t, uint64_t> > batch(temp.begin() + i, temp.begin() + std::min(i + 997, temp.size()));
+    map.insert(batch);
+  }
+  check(map);
+
+  size_t before = map.arena_bytes();
+  map.compact();
+  EXPECT_LE(map.arena_bytes(), before);
+  check(map);
+}
+
+TEST_F(DeltaMultimapTest, erase)
+{
+  MapType map;
+  map.insert(temp);
+
+  std::vector<uint32_t> ks;
+  for (uint32_t k = 0; k < 1000; k += 2) ks.push_back(k);
+  ks.push_back(2000);  // absent
+
+  size_t erased = map.erase(ks.begin(), ks.end());
+  size_t expected = 0;
+  for (uint32_t k : ks) expected += gold.erase(k);
+  EXPECT_EQ(expected, erased);
+
+  check(map);
+  EXPECT_FALSE(map.exists(0));
+  EXPECT_TRUE(map.exists(1));
+
+  std::vector<std::pair<uint32_t, uint64_t> > all = map.to_vector();
+  EXPECT_EQ(gold.size(), all.size());
+}
+
+TEST(DeltaMultimap, sequence_ids)
+{
+  using IdType = ::bliss::common::LongSequenceKmerId;
+  ::fsc::delta_multimap<uint64_t, IdType> map;
+
+  std::vector<std::pair<uint64_t, IdType> > input;
+  for (size_t i = 0; i < 100; ++i) {
+    IdType id(1000000 + i * 3, static_cast<uint8_t>(2), static_cast<uint16_t>(17));
+    input.emplace_back(i % 3, id);
+  }
+  map.insert(input);
+  EXPECT_EQ(100UL, map.size());
+
+  std::vector<IdType> vals;
+  map.find(1, vals);
+  ASSERT_EQ(33UL, vals.size());
+  for (size_t i = 0; i < vals.size(); ++i) {
+    EXPECT_EQ(1000000UL + (i * 3 + 1) * 3, vals[i].get_pos());
+    EXPECT_EQ(2, vals[i].get_file_id());
+  }
+}
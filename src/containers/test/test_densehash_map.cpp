@@ -131,6 +131,36 @@ TYPED_TEST_P(DenseHashMapPartialTest, insert_partial)
 }
 
 
+TYPED_TEST_P(DenseHashMapPartialTest, upsert_partial)
+{
+  using MAP = ::fsc::densehash_map<TypeParam, TypeParam>;
+
+  // few distinct keys, so most upserts reduce.
+  ::std::unordered_map<TypeParam, TypeParam> gold_sums;
+  ::std::unordered_map<TypeParam, TypeParam> test_std;
+  MAP test;
+  size_t inserted = 0;
+  for (auto it = this->temp.begin(); it != this->temp.end(); ++it) {
+    TypeParam key = this->min_val + (it->first % 1000);
+    TypeParam val = it->second % 16;
+
+    if (gold_sums.find(key) == gold_sums.end()) gold_sums.emplace(key, val);
+    else gold_sums.at(key) += val;
+
+    inserted += ::fsc::upsert(test, key, val, ::std::plus<TypeParam>());
+    ::fsc::upsert(test_std, key, val, ::std::plus<TypeParam>());
+  }
+
+  EXPECT_EQ(gold_sums.size(), inserted);
+  EXPECT_EQ(gold_sums.size(), test.size());
+  EXPECT_EQ(gold_sums.size(), test_std.size());
+  for (auto it = gold_sums.begin(); it != gold_sums.end(); ++it) {
+    EXPECT_EQ(it->second, test.find(it->first)->second);
+    EXPECT_EQ(it->second, test_std.at(it->first));
+  }
+}
+
+
 TYPED_TEST_P(DenseHashMapPartialTest, equal_range_partial)
 {
 	  using MAP = ::fsc::densehash_map<TypeParam, TypeParam>;
@@ -213,7 +243,157 @@ TYPED_TEST_P(DenseHashMapPartialTest, count_partial)
 }
 
 // now register the test cases
-REGISTER_TYPED_TEST_CASE_P(DenseHashMapPartialTest, insert_partial, equal_range_partial, count_partial);
+TYPED_TEST_P(DenseHashMapPartialTest, erase_compact_partial)
+{
+  using MAP = ::fsc::densehash_map<TypeParam, TypeParam>;
+
+  // erase 80% of the keys, with and without the automatic compaction.
+  auto pred = [](::std::pair<const TypeParam, TypeParam> const & x) { return (x.first % 5) != 0; };
+
+  MAP test(this->temp.begin(), this->temp.end());
+  MAP kept(this->temp.begin(), this->temp.end());
+  kept.set_compact_ratio(0.0);
+  size_t buckets = kept.bucket_count();
+
+  size_t erased = test.erase(pred);
+  EXPECT_EQ(erased, kept.erase(pred));
+  EXPECT_EQ(buckets, kept.bucket_count());
+
+  // the automatic compaction shrank the table.
+  EXPECT_LT(test.bucket_count(), buckets);
+
+  kept.compact();
+  EXPECT_EQ(test.bucket_count(), kept.bucket_count());
+
+  size_t remaining = 0;
+  for (auto it = this->gold.begin(); it != this->gold.end(); ++it) {
+    if (pred(*it)) {
+      EXPECT_EQ(0UL, test.count(it->first));
+      EXPECT_EQ(0UL, kept.count(it->first));
+    } else {
+      ++remaining;
+      EXPECT_EQ(it->second, test.find(it->first)->second);
+      EXPECT_EQ(it->second, kept.find(it->first)->second);
+    }
+  }
+  EXPECT_EQ(remaining, test.size());
+  EXPECT_EQ(remaining, kept.size());
+  EXPECT_EQ(this->gold.size() - remaining, erased);
+
+  // the tables are usable after compaction.
+  test.insert(this->temp.begin(), this->temp.end());
+  EXPECT_EQ(this->gold.size(), test.size());
+}
+
+TYPED_TEST_P(DenseHashMapPartialTest, parallel_for_each_partial)
+{
+  using MAP = ::fsc::densehash_map<TypeParam, TypeParam>;
+  using PAIR = ::std::pair<TypeParam, TypeParam>;
+
+  MAP test(this->temp.begin(), this->temp.end());
+
+  // each thread collects its own share.
+  ::std::vector<::std::vector<PAIR> > parts(::fsc::parallel_for_each_threads(0));
+  test.parallel_for_each([&parts](typename MAP::value_type const & x, int const tid) {
+    parts[tid].emplace_back(x.first, x.second);
+  });
+
+  ::std::vector<PAIR> test_vals;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    test_vals.insert(test_vals.end(), parts[i].begin(), parts[i].end());
+  }
+  ::std::vector<PAIR> gold_vals = test.to_vector();
+  EXPECT_EQ(gold_vals.size(), test_vals.size());
+
+  ::std::sort(test_vals.begin(), test_vals.end());
+  ::std::sort(gold_vals.begin(), gold_vals.end());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+}
+
+
+
+TYPED_TEST_P(DenseHashMapPartialTest, table_stats_partial)
+{
+  using MAP = ::fsc::densehash_map<TypeParam, TypeParam>;
+
+  MAP test(this->temp.begin(), this->temp.end());
+  test.set_compact_ratio(0.0);
+
+  ::fsc::table_stats stats = test.get_table_stats();
+  EXPECT_EQ(test.size(), stats.occupied);
+  EXPECT_EQ(test.bucket_count(), stats.buckets);
+  EXPECT_EQ(0UL, stats.tombstones);
+  EXPECT_NEAR(test.load_factor(), stats.load_factor(), 1e-6);
+
+  size_t binned = 0;
+  for (size_t i = 0; i < stats.probes.size(); ++i) binned += stats.probes[i];
+  EXPECT_EQ(stats.occupied, binned);
+  EXPECT_LE(1.0, stats.mean_probe());
+  EXPECT_LE(stats.probe_percentile(0.99), stats.max_probe);
+
+  // erased entries stay as tombstones when compaction is off.
+  auto pred = [](::std::pair<const TypeParam, TypeParam> const & x) { return (x.first % 5) != 0; };
+  size_t erased = test.erase(pred);
+  stats = test.get_table_stats();
+  EXPECT_EQ(test.size(), stats.occupied);
+  EXPECT_EQ(erased, stats.tombstones);
+  EXPECT_LT(0.0, stats.tombstone_ratio());
+}
+
+TYPED_TEST_P(DenseHashMapPartialTest, bulk_load_partial)
+{
+  using MAP = ::fsc::densehash_map<TypeParam, TypeParam>;
+
+  // bulk_load needs unique keys:  the gold map has them.
+  ::std::vector<::std::pair<TypeParam, TypeParam> > gold_vals(this->gold.begin(), this->gold.end());
+
+  MAP test;
+  test.bulk_load(gold_vals.begin(), gold_vals.end());
+  EXPECT_EQ(gold_vals.size(), test.size());
+
+  // sized once, so a second pass over the same keys must not grow the tables.
+  size_t buckets = test.bucket_count();
+  test.insert(gold_vals);
+  EXPECT_EQ(buckets, test.bucket_count());
+  EXPECT_EQ(gold_vals.size(), test.size());
+
+  ::std::vector<::std::pair<TypeParam, TypeParam> > test_vals = test.to_vector();
+  ::std::sort(test_vals.begin(), test_vals.end());
+  ::std::sort(gold_vals.begin(), gold_vals.end());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+}
+
+TYPED_TEST_P(DenseHashMapPartialTest, insert_duplicates_partial)
+{
+  using MAP = ::fsc::densehash_map<TypeParam, TypeParam>;
+
+  // each key repeated in runs of 1 to 20, so repeats fall both within and across the insert windows.
+  ::std::vector<::std::pair<TypeParam, TypeParam> > input;
+  ::std::unordered_map<TypeParam, TypeParam> first_vals;
+  size_t run = 1;
+  for (auto const & x : this->temp) {
+    for (size_t i = 0; i < run; ++i) {
+      input.emplace_back(x.first, static_cast<TypeParam>(x.second + i));
+    }
+    first_vals.emplace(x.first, x.second);
+    run = (run % 20) + 1;
+    if (input.size() > 50000) break;
+  }
+
+  MAP test;
+  test.insert(input);
+  EXPECT_EQ(first_vals.size(), test.size());
+
+  // the first entry for a key is kept.
+  ::std::vector<::std::pair<TypeParam, TypeParam> > test_vals = test.to_vector();
+  ::std::vector<::std::pair<TypeParam, TypeParam> > gold_vals(first_vals.begin(), first_vals.end());
+  ::std::sort(test_vals.begin(), test_vals.end());
+  ::std::sort(gold_vals.begin(), gold_vals.end());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+}
+
+REGISTER_TYPED_TEST_CASE_P(DenseHashMapPartialTest, insert_partial, upsert_partial, equal_range_partial, count_partial, erase_compact_partial,
+                           parallel_for_each_partial, table_stats_partial, bulk_load_partial, insert_duplicates_partial);
 
 
 //////////////////// RUN the tests with different types.
@@ -572,7 +752,33 @@ TYPED_TEST_P(DenseHashMultimapPartialTest, count_partial)
 
 
 // now register the test cases
-REGISTER_TYPED_TEST_CASE_P(DenseHashMultimapPartialTest, insert_partial, equal_range_partial, count_partial);
+TYPED_TEST_P(DenseHashMultimapPartialTest, parallel_for_each_partial)
+{
+  using MAP = ::fsc::densehash_multimap<TypeParam, TypeParam>;
+  using PAIR = ::std::pair<TypeParam, TypeParam>;
+
+  MAP test(this->temp.begin(), this->temp.end());
+
+  // each thread collects its own share.
+  ::std::vector<::std::vector<PAIR> > parts(::fsc::parallel_for_each_threads(0));
+  test.parallel_for_each([&parts](PAIR const & x, int const tid) {
+    parts[tid].emplace_back(x.first, x.second);
+  });
+
+  ::std::vector<PAIR> test_vals;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    test_vals.insert(test_vals.end(), parts[i].begin(), parts[i].end());
+  }
+  ::std::vector<PAIR> gold_vals = test.to_vector();
+  EXPECT_EQ(gold_vals.size(), test_vals.size());
+
+  ::std::sort(test_vals.begin(), test_vals.end());
+  ::std::sort(gold_vals.begin(), gold_vals.end());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+}
+
+
+REGISTER_TYPED_TEST_CASE_P(DenseHashMultimapPartialTest, insert_partial, equal_range_partial, count_partial, parallel_for_each_partial);
 
 
 //////////////////// RUN the tests with different types.
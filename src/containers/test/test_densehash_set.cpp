@@ -0,0 +1,128 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/densehash_set.hpp"
+
+#include <unordered_set>
+#include <random>
+#include <algorithm>
+#include <cstdint>  // uint32_t
+#include <limits>
+#include <vector>
+#include <atomic>
+
+// include files to test
+#include "utils/transform_utils.hpp"
+
+
+  /// empty and deleted keys at the top of the key space, so the keys are split.
+  template <typename Key>
+  struct split_special_keys {
+	inline Key generate(uint8_t id = 0) {
+		return ::std::numeric_limits<Key>::max() - id;
+	}
+
+	inline Key invert(Key const &x) {
+		return static_cast<Key>(~x);
+	}
+
+	inline Key get_splitter() {
+		return static_cast<Key>(~(::std::numeric_limits<Key>::max() >> 1));
+	}
+
+	static constexpr bool need_to_split = true;
+  };
+
+
+/*
+ * test class holding some information.  Also, needed for the typed tests
+ */
+template<typename T>
+class DenseHashSetTest : public ::testing::Test
+{
+    static_assert(std::is_integral<T>::value, "only supporting integral types in tests right now.");
+  protected:
+
+    ::std::unordered_set<T> gold;
+    ::std::vector<T> temp;
+
+    size_t iters = 100000;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<T> distribution(0, ::std::numeric_limits<T>::max() - 2);
+
+      for (size_t i=0; i< iters; ++i) {
+        T key = distribution(generator);
+        gold.emplace(key);
+        temp.emplace_back(key);
+      }
+    }
+
+    /// insert, count, and erase half, against the gold set.
+    template <typename SET>
+    void check() {
+      SET test;
+      EXPECT_EQ(gold.size(), test.insert(this->temp.begin(), this->temp.end()));
+      EXPECT_EQ(gold.size(), test.size());
+      EXPECT_EQ(0UL, test.insert(this->temp.begin(), this->temp.end()));
+
+      ::std::vector<T> test_keys;
+      test.keys(test_keys);
+      ::std::vector<T> iterated(test.begin(), test.end());
+      ::std::vector<T> gold_keys(gold.begin(), gold.end());
+      ::std::sort(test_keys.begin(), test_keys.end());
+      ::std::sort(iterated.begin(), iterated.end());
+      ::std::sort(gold_keys.begin(), gold_keys.end());
+      EXPECT_EQ(gold_keys, test_keys);
+      EXPECT_EQ(gold_keys, iterated);
+
+      ::std::atomic<size_t> visited(0);
+      test.parallel_for_each([&visited](T const &, int) { ++visited; });
+      EXPECT_EQ(gold.size(), visited.load());
+
+      // erase every other key.
+      ::std::vector<T> erased;
+      for (size_t i = 0; i < gold_keys.size(); i += 2) erased.push_back(gold_keys[i]);
+      EXPECT_EQ(erased.size(), test.erase(erased.begin(), erased.end()));
+      EXPECT_EQ(gold_keys.size() - erased.size(), test.size());
+
+      for (size_t i = 0; i < gold_keys.size(); ++i) {
+        EXPECT_EQ((i % 2 == 0) ? 0UL : 1UL, test.count(gold_keys[i]));
+      }
+    }
+};
+
+// indicate this is a typed test
+TYPED_TEST_CASE_P(DenseHashSetTest);
+
+TYPED_TEST_P(DenseHashSetTest, single_table)
+{
+  this->template check<::fsc::densehash_set<TypeParam> >();
+}
+
+TYPED_TEST_P(DenseHashSetTest, split_tables)
+{
+  this->template check<::fsc::densehash_set<TypeParam, split_special_keys<TypeParam> > >();
+}
+
+REGISTER_TYPED_TEST_CASE_P(DenseHashSetTest, single_table, split_tables);
+
+typedef ::testing::Types<uint16_t, uint32_t, uint64_t> DenseHashSetTestTypes;
+INSTANTIATE_TYPED_TEST_CASE_P(Bliss, DenseHashSetTest, DenseHashSetTestTypes);
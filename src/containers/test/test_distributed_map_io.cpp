@@ -0,0 +1,142 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/distributed_map_io.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+
+#include <cstdio>   // remove, fopen
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+#include <stdexcept>
+#include <unistd.h>  // getpid
+#include <sys/stat.h>  // stat
+
+
+using KmerType = ::bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+
+class DistributedMapIOTest : public ::testing::Test
+{
+  protected:
+    ::std::vector<::std::pair<KmerType, uint32_t> > entries;
+    ::std::string prefix;
+
+    virtual void SetUp()
+    {
+      KmerType km;
+      for (uint32_t i = 0; i < 10000; ++i) {
+        km.nextFromChar(i % 4);
+        entries.emplace_back(km, i);
+      }
+
+      ::std::stringstream ss;
+      ss << "/tmp/bliss_map_io_test_" << getpid();
+      prefix = ss.str();
+    }
+
+    virtual void TearDown()
+    {
+      for (int r = 0; r < 4; ++r) remove(::dsc::map_file_name(prefix, r).c_str());
+    }
+};
+
+
+TEST_F(DistributedMapIOTest, roundtrip)
+{
+  ::dsc::write_map_file(::dsc::map_file_name(prefix, 2), 4, 2, entries.data(), entries.size());
+
+  ::dsc::mapped_map_file f(::dsc::map_file_name(prefix, 2));
+  EXPECT_NO_THROW((f.validate<KmerType, uint32_t>(4, 2)));
+  EXPECT_EQ(entries.size(), f.size());
+  EXPECT_EQ(31U, f.header().kmer_size);
+  EXPECT_EQ(2U, f.header().kmer_bits_per_char);
+
+  auto loaded = f.entries<KmerType, uint32_t>();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    EXPECT_EQ(entries[i], loaded[i]);
+  }
+}
+
+TEST_F(DistributedMapIOTest, empty)
+{
+  ::dsc::write_map_file(::dsc::map_file_name(prefix, 0), 4, 0, entries.data(), 0);
+
+  ::dsc::mapped_map_file f(::dsc::map_file_name(prefix, 0));
+  EXPECT_NO_THROW((f.validate<KmerType, uint32_t>(4, 0)));
+  EXPECT_EQ(0UL, f.size());
+}
+
+TEST_F(DistributedMapIOTest, mismatch)
+{
+  ::dsc::write_map_file(::dsc::map_file_name(prefix, 1), 4, 1, entries.data(), entries.size());
+
+  ::dsc::mapped_map_file f(::dsc::map_file_name(prefix, 1));
+  // different process count or rank
+  EXPECT_THROW((f.validate<KmerType, uint32_t>(8, 1)), ::std::invalid_argument);
+  EXPECT_THROW((f.validate<KmerType, uint32_t>(4, 3)), ::std::invalid_argument);
+  // different value type
+  EXPECT_THROW((f.validate<KmerType, uint64_t>(4, 1)), ::std::invalid_argument);
+  // different k
+  EXPECT_THROW((f.validate<::bliss::common::Kmer<21, bliss::common::DNA, uint64_t>, uint32_t>(4, 1)), ::std::invalid_argument);
+}
+
+TEST_F(DistributedMapIOTest, bad_file)
+{
+  EXPECT_THROW(::dsc::mapped_map_file f(::dsc::map_file_name(prefix, 3)), ::bliss::io::IOException);
+
+  // truncated
+  ::dsc::write_map_file(::dsc::map_file_name(prefix, 3), 4, 3, entries.data(), entries.size());
+  ASSERT_EQ(0, truncate(::dsc::map_file_name(prefix, 3).c_str(), sizeof(::dsc::map_file_header) + 100));
+  EXPECT_THROW(::dsc::mapped_map_file f(::dsc::map_file_name(prefix, 3)), ::bliss::io::IOException);
+}
+
+TEST_F(DistributedMapIOTest, roundtrip_packed)
+{
+  ::dsc::write_map_file(::dsc::map_file_name(prefix, 2), 4, 2, entries.data(), entries.size(), true);
+
+  ::dsc::mapped_map_file f(::dsc::map_file_name(prefix, 2));
+  EXPECT_NO_THROW((f.validate<KmerType, uint32_t>(4, 2)));
+  EXPECT_TRUE(f.packed());
+  EXPECT_EQ(entries.size(), f.size());
+
+  // 62 bits per key instead of 64, and no pair padding.
+  struct stat st;
+  ASSERT_EQ(0, stat(::dsc::map_file_name(prefix, 2).c_str(), &st));
+  EXPECT_EQ(sizeof(::dsc::map_file_header) + (entries.size() * 62 + 63) / 64 * 8 + entries.size() * sizeof(uint32_t),
+            static_cast<size_t>(st.st_size));
+
+  ::std::vector<::std::pair<KmerType, uint32_t> > loaded(entries.size());
+  f.read_entries(0, entries.size(), loaded.data());
+  EXPECT_EQ(entries, loaded);
+
+  // a range in the middle.
+  ::std::vector<::std::pair<KmerType, uint32_t> > part(100);
+  f.read_entries(777, 100, part.data());
+  for (size_t i = 0; i < part.size(); ++i) {
+    EXPECT_EQ(entries[777 + i], part[i]);
+  }
+
+  // non-kmer keys are written unpacked.
+  ::std::vector<::std::pair<uint64_t, uint32_t> > plain(10, ::std::make_pair(7UL, 3U));
+  ::dsc::write_map_file(::dsc::map_file_name(prefix, 1), 4, 1, plain.data(), plain.size(), true);
+  ::dsc::mapped_map_file g(::dsc::map_file_name(prefix, 1));
+  EXPECT_FALSE(g.packed());
+  EXPECT_NO_THROW((g.validate<uint64_t, uint32_t>(4, 1)));
+}
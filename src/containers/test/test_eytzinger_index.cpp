@@ -0,0 +1,80 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/eytzinger_index.hpp"
+
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint64_t
+#include <utility>  // pair
+#include <vector>
+
+
+struct FirstLess {
+    bool operator()(uint64_t const & x, uint64_t const & y) const { return x < y; }
+    bool operator()(::std::pair<uint64_t, uint32_t> const & x, uint64_t const & y) const { return x.first < y; }
+};
+
+class EytzingerIndexTest : public ::testing::TestWithParam<size_t>
+{
+  protected:
+    ::std::vector<::std::pair<uint64_t, uint32_t> > entries;
+
+    virtual void SetUp()
+    {  // sorted, with repeats.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution(10, 50000);
+
+      for (size_t i = 0; i < 20000; ++i) {
+        entries.emplace_back(distribution(generator), i);
+        if ((i % 7) == 0) entries.emplace_back(entries.back().first, i);
+      }
+      ::std::sort(entries.begin(), entries.end());
+    }
+
+    void check(size_t const n) {
+      ::fsc::eytzinger_index<uint64_t, FirstLess> index;
+      index.build(entries.begin(), entries.begin() + n, GetParam());
+      ASSERT_EQ(n, index.size());
+
+      FirstLess lt;
+      for (uint64_t v = 0; v < 50020; v += 3) {
+        size_t expected = ::std::distance(entries.begin(), ::std::lower_bound(entries.begin(), entries.begin() + n, v, lt));
+        ASSERT_EQ(expected, index.lower_bound(entries.begin(), v)) << "v " << v << " n " << n;
+      }
+    }
+};
+
+
+TEST_P(EytzingerIndexTest, lower_bound)
+{
+  check(entries.size());
+}
+
+TEST_P(EytzingerIndexTest, lower_bound_small)
+{
+  for (size_t n = 0; n < 40; ++n) check(n);
+}
+
+TEST_P(EytzingerIndexTest, lower_bound_partial_block)
+{
+  check(entries.size() - 5);
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, EytzingerIndexTest, ::testing::Values(0, 1, 3, 16, 100));
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/local_combiner.hpp"
+
+#include <unordered_map>
+#include <random>
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+#include <functional>
+
+
+class LocalCombinerTest : public ::testing::Test
+{
+  protected:
+
+    ::std::unordered_map<uint64_t, uint32_t> gold;
+    ::std::vector<uint64_t> keys;
+
+    size_t iters = 200000;
+
+    virtual void SetUp()
+    { // generate some inputs with repeats.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution(0, 5000);
+
+      for (size_t i=0; i< iters; ++i) {
+        uint64_t key = distribution(generator);
+        ++gold[key];
+        keys.emplace_back(key);
+      }
+    }
+
+    /// sum the combined tuples per key and compare to gold.
+    void check(::std::vector<::std::pair<uint64_t, uint32_t> > const & combined) {
+      ::std::unordered_map<uint64_t, uint32_t> test;
+      for (auto it = combined.begin(); it != combined.end(); ++it) {
+        test[it->first] += it->second;
+      }
+      EXPECT_EQ(gold.size(), test.size());
+      for (auto it = gold.begin(); it != gold.end(); ++it) {
+        EXPECT_EQ(it->second, test[it->first]);
+      }
+    }
+};
+
+
+TEST_F(LocalCombinerTest, combine_keys)
+{
+  ::std::vector<::std::pair<uint64_t, uint32_t> > combined;
+  ::fsc::combine(keys, combined);
+
+  // 5001 distinct keys in 256KB (8192 slots in 4-way sets), so most repeats are absorbed.
+  EXPECT_LT(combined.size(), keys.size() / 4);
+  check(combined);
+}
+
+TEST_F(LocalCombinerTest, combine_pairs)
+{
+  ::std::vector<::std::pair<uint64_t, uint32_t> > pairs;
+  for (auto k : keys) pairs.emplace_back(k, 1);
+
+  ::std::vector<::std::pair<uint64_t, uint32_t> > combined;
+  ::fsc::combine(pairs, combined);
+  check(combined);
+}
+
+TEST_F(LocalCombinerTest, evict)
+{
+  // 16 slots in 4 sets, so most tuples evict an entry.  the sums are still exact.
+  ::fsc::local_combiner<uint64_t, uint32_t> comb(16 * (sizeof(::std::pair<uint64_t, uint32_t>) + 1));
+  EXPECT_EQ(16UL, comb.capacity());
+
+  ::std::vector<::std::pair<uint64_t, uint32_t> > combined;
+  for (auto k : keys) comb.add(k, combined);
+  EXPECT_GT(combined.size(), 0UL);
+  comb.flush(combined);
+  EXPECT_LE(combined.size(), keys.size());
+  check(combined);
+
+  // flushed combiner is empty.
+  size_t s = combined.size();
+  comb.flush(combined);
+  EXPECT_EQ(s, combined.size());
+}
+
+TEST_F(LocalCombinerTest, empty)
+{
+  ::std::vector<uint64_t> none;
+  ::std::vector<::std::pair<uint64_t, uint32_t> > combined(3);
+  ::fsc::combine(none, combined);
+  EXPECT_EQ(0UL, combined.size());
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/packed_kmer_array.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+
+#include <random>
+#include <algorithm>  // for sort, lower_bound
+#include <cstdint>  // uint64_t
+#include <vector>
+
+
+template <typename Kmer>
+class PackedKmerArrayTest : public ::testing::Test
+{
+  protected:
+    ::std::vector<Kmer> kmers;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<unsigned int> distribution(0, Kmer::KmerAlphabet::SIZE - 1);
+
+      Kmer km;
+      for (size_t i = 0; i < 10000; ++i) {
+        km.nextFromChar(distribution(generator));
+        kmers.emplace_back(km);
+      }
+    }
+};
+
+// padding in the last word, multiple words, and narrow words.
+typedef ::testing::Types<
+    ::bliss::common::Kmer<31, bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<21, bliss::common::DNA5, uint64_t>,
+    ::bliss::common::Kmer<63, bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<13, bliss::common::DNA, uint16_t>,
+    ::bliss::common::Kmer<45, bliss::common::DNA16, uint32_t>
+> PackedKmerArrayTestTypes;
+TYPED_TEST_CASE(PackedKmerArrayTest, PackedKmerArrayTestTypes);
+
+
+TYPED_TEST(PackedKmerArrayTest, roundtrip)
+{
+  using ArrayType = ::fsc::packed_kmer_array<TypeParam>;
+  EXPECT_EQ(TypeParam::nBits, ArrayType::key_bits);
+
+  ArrayType array(this->kmers.begin(), this->kmers.end());
+  ASSERT_EQ(this->kmers.size(), array.size());
+  EXPECT_EQ(ArrayType::words_for(this->kmers.size()) * sizeof(uint64_t), array.bytes());
+  EXPECT_GE(this->kmers.size() * sizeof(TypeParam), array.bytes());
+
+  for (size_t i = 0; i < this->kmers.size(); ++i) {
+    ASSERT_EQ(this->kmers[i], array[i]);
+  }
+
+  // appended one at a time.
+  ArrayType appended;
+  for (auto const & k : this->kmers) appended.push_back(k);
+  ASSERT_EQ(this->kmers.size(), appended.size());
+  EXPECT_TRUE(::std::equal(this->kmers.begin(), this->kmers.end(), appended.begin()));
+
+  appended.clear();
+  EXPECT_TRUE(appended.empty());
+  EXPECT_TRUE(appended.begin() == appended.end());
+}
+
+TYPED_TEST(PackedKmerArrayTest, search)
+{
+  ::std::sort(this->kmers.begin(), this->kmers.end());
+  ::fsc::packed_kmer_array<TypeParam> array(this->kmers.begin(), this->kmers.end());
+
+  for (size_t i = 0; i < this->kmers.size(); i += 7) {
+    auto it = ::std::lower_bound(array.begin(), array.end(), this->kmers[i]);
+    ASSERT_TRUE(it != array.end());
+    EXPECT_EQ(this->kmers[i], *it);
+    EXPECT_EQ(::std::lower_bound(this->kmers.begin(), this->kmers.end(), this->kmers[i]) - this->kmers.begin(),
+              it - array.begin());
+  }
+}
+
+TEST(PackedKeyArrayTest, integers)
+{
+  ::fsc::packed_kmer_array<uint32_t> array;
+  EXPECT_EQ(32U, ::fsc::packed_kmer_array<uint32_t>::key_bits);
+  for (uint32_t i = 0; i < 1000; ++i) array.push_back(i * 2654435761U);
+  for (uint32_t i = 0; i < 1000; ++i) EXPECT_EQ(i * 2654435761U, array[i]);
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/prefix_block_array.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+
+#include <random>
+#include <algorithm>  // for sort, unique
+#include <cstdint>  // uint64_t
+#include <functional>  // less
+#include <utility>  // pair
+#include <vector>
+
+
+class PrefixBlockArrayTest : public ::testing::TestWithParam<size_t>
+{
+  protected:
+    using ArrayType = ::fsc::prefix_block_array<uint64_t, uint32_t, ::std::less<uint64_t> >;
+
+    ::std::vector<::std::pair<uint64_t, uint32_t> > entries;
+
+    virtual void SetUp()
+    {  // sorted and unique, offset from 0 like a rank's key range.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution(1ULL << 40, (1ULL << 40) + (1ULL << 32));
+
+      for (uint32_t i = 0; i < 100000; ++i) {
+        entries.emplace_back(distribution(generator), i);
+      }
+      ::std::sort(entries.begin(), entries.end());
+      entries.erase(::std::unique(entries.begin(), entries.end(),
+                                  [](::std::pair<uint64_t, uint32_t> const & x, ::std::pair<uint64_t, uint32_t> const & y) {
+        return x.first == y.first; }), entries.end());
+    }
+
+    /// value of key v found through its block, or false.
+    static bool lookup(ArrayType const & array, uint64_t const v, uint32_t & value) {
+      if (array.empty()) return false;
+      ::std::vector<::std::pair<uint64_t, uint32_t> > block;
+      array.decode(array.block_of(v), block);
+      for (auto const & x : block) {
+        if (x.first == v) {
+          value = x.second;
+          return true;
+        }
+      }
+      return false;
+    }
+};
+
+
+TEST_P(PrefixBlockArrayTest, decode_all)
+{
+  ArrayType array;
+  array.build(entries.begin(), entries.end(), GetParam());
+  ASSERT_EQ(entries.size(), array.size());
+
+  ::std::vector<::std::pair<uint64_t, uint32_t> > decoded;
+  array.decode_all(decoded);
+  EXPECT_EQ(entries, decoded);
+}
+
+TEST_P(PrefixBlockArrayTest, lookup)
+{
+  ArrayType array;
+  array.build(entries.begin(), entries.end(), GetParam());
+
+  uint32_t value = 0;
+  for (size_t i = 0; i < entries.size(); i += 7) {
+    ASSERT_TRUE(lookup(array, entries[i].first, value)) << "i " << i;
+    ASSERT_EQ(entries[i].second, value);
+
+    // misses, between and around the keys.
+    if ((i + 1 < entries.size()) && (entries[i].first + 1 < entries[i + 1].first)) {
+      ASSERT_FALSE(lookup(array, entries[i].first + 1, value));
+    }
+  }
+  EXPECT_FALSE(lookup(array, 0, value));
+  EXPECT_FALSE(lookup(array, 0xFFFFFFFFFFFFFFFFull, value));
+}
+
+TEST_P(PrefixBlockArrayTest, small)
+{
+  for (size_t n = 0; n < 70; ++n) {
+    ArrayType array;
+    array.build(entries.begin(), entries.begin() + n, GetParam());
+    ASSERT_EQ(n, array.size());
+
+    ::std::vector<::std::pair<uint64_t, uint32_t> > decoded;
+    array.decode_all(decoded);
+    ASSERT_TRUE(::std::equal(decoded.begin(), decoded.end(), entries.begin())) << "n " << n;
+    ASSERT_EQ(n, decoded.size());
+  }
+}
+
+TEST_P(PrefixBlockArrayTest, repeated_keys)
+{
+  // equal keys stay in 1 block, so all are in the block found for the key.
+  ::std::vector<::std::pair<uint64_t, uint32_t> > repeated;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    for (uint32_t j = 0; j <= (i % 100); ++j) repeated.emplace_back(1000 + 3 * i, j);
+  }
+
+  ArrayType array;
+  array.build(repeated.begin(), repeated.end(), GetParam());
+
+  ::std::vector<::std::pair<uint64_t, uint32_t> > block;
+  for (uint32_t i = 0; i < 5000; i += 13) {
+    array.decode(array.block_of(1000 + 3 * i), block);
+    EXPECT_EQ(static_cast<long>(i % 100) + 1,
+              ::std::count_if(block.begin(), block.end(),
+                              [i](::std::pair<uint64_t, uint32_t> const & x) { return x.first == 1000 + 3 * i; }));
+  }
+
+  ::std::vector<::std::pair<uint64_t, uint32_t> > decoded;
+  array.decode_all(decoded);
+  EXPECT_EQ(repeated, decoded);
+}
+
+TEST_P(PrefixBlockArrayTest, multiword_kmers)
+{
+  // 2 words per key, and keys whose difference crosses the word boundary.
+  using KmerType = ::bliss::common::Kmer<63, ::bliss::common::DNA, uint64_t>;
+  using KmerArray = ::fsc::prefix_block_array<KmerType, uint32_t, ::std::less<KmerType> >;
+
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> base_dist(0, 3);
+  ::std::vector<::std::pair<KmerType, uint32_t> > kmers;
+  KmerType km;
+  for (uint32_t i = 0; i < 20000; ++i) {
+    km.nextFromChar(base_dist(generator));
+    if (i >= 63) kmers.emplace_back(km, i);
+  }
+  ::std::sort(kmers.begin(), kmers.end(),
+              [](::std::pair<KmerType, uint32_t> const & x, ::std::pair<KmerType, uint32_t> const & y) { return x.first < y.first; });
+
+  KmerArray array;
+  array.build(kmers.begin(), kmers.end(), GetParam());
+
+  ::std::vector<::std::pair<KmerType, uint32_t> > decoded;
+  array.decode_all(decoded);
+  ASSERT_EQ(kmers.size(), decoded.size());
+  EXPECT_TRUE(::std::equal(decoded.begin(), decoded.end(), kmers.begin()));
+
+  ::std::vector<::std::pair<KmerType, uint32_t> > block;
+  for (size_t i = 0; i < kmers.size(); i += 101) {
+    array.decode(array.block_of(kmers[i].first), block);
+    EXPECT_TRUE(::std::any_of(block.begin(), block.end(),
+                              [&kmers, i](::std::pair<KmerType, uint32_t> const & x) { return x == kmers[i]; }));
+  }
+}
+
+TEST(PrefixBlockArraySize, compression)
+{
+  // 2^32 keys over 2^17 entries:  about 20 bits per key in blocks of 64, instead of 64.
+  std::default_random_engine generator;
+  std::uniform_int_distribution<uint64_t> distribution(0, 0xFFFFFFFFull);
+  ::std::vector<::std::pair<uint64_t, uint32_t> > entries;
+  for (uint32_t i = 0; i < (1U << 17); ++i) entries.emplace_back(distribution(generator), i);
+  ::std::sort(entries.begin(), entries.end());
+
+  ::fsc::prefix_block_array<uint64_t, uint32_t, ::std::less<uint64_t> > array;
+  array.build(entries.begin(), entries.end());
+  EXPECT_LT(array.bytes() * 2, entries.size() * sizeof(::std::pair<uint64_t, uint32_t>));
+}
+
+TEST(PrefixBlockArraySupport, key_types)
+{
+  ASSERT_TRUE((::fsc::prefix_block_array<uint64_t, uint32_t, ::std::less<uint64_t> >::supported));
+  ASSERT_TRUE((::fsc::prefix_block_array<::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>, uint32_t,
+                                         ::std::less<::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t> > >::supported));
+  ASSERT_FALSE((::fsc::prefix_block_array<double, uint32_t, ::std::less<double> >::supported));
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, PrefixBlockArrayTest, ::testing::Values(0, 1, 5, 64, 1000));
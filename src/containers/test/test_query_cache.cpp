@@ -0,0 +1,97 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/query_cache.hpp"
+
+#include <random>
+#include <cstdint>  // uint32_t
+#include <vector>
+#include <algorithm>
+
+
+TEST(QueryCacheTest, disabled)
+{
+  ::fsc::query_cache<uint64_t, uint32_t> cache;
+  EXPECT_FALSE(cache.enabled());
+  cache.put(1, 2);
+  EXPECT_EQ(nullptr, cache.get(1));
+}
+
+TEST(QueryCacheTest, get_put)
+{
+  ::fsc::query_cache<uint64_t, uint32_t> cache(1 << 12);
+  ASSERT_TRUE(cache.enabled());
+  EXPECT_GE(static_cast<size_t>(1 << 12), cache.capacity() * (sizeof(std::pair<uint64_t, uint32_t>) + 1) + cache.capacity() / 4);
+
+  EXPECT_EQ(nullptr, cache.get(7));
+  cache.put(7, 70);
+  ASSERT_NE(nullptr, cache.get(7));
+  EXPECT_EQ(70U, *cache.get(7));
+
+  // replace, not duplicate.
+  cache.put(7, 71);
+  EXPECT_EQ(71U, *cache.peek(7));
+
+  EXPECT_EQ(2UL, cache.hits());
+  EXPECT_EQ(1UL, cache.misses());
+
+  cache.clear();
+  EXPECT_EQ(nullptr, cache.get(7));
+}
+
+TEST(QueryCacheTest, hot_keys_stay)
+{
+  // 1 set only, so every key competes.  the hot key is read between the cold puts.
+  ::fsc::query_cache<uint64_t, uint32_t> cache(4 * (sizeof(std::pair<uint64_t, uint32_t>) + 1) + 1);
+  ASSERT_EQ(4UL, cache.capacity());
+
+  cache.put(0, 0);
+  for (uint64_t k = 1; k < 1000; ++k) {
+    ASSERT_NE(nullptr, cache.get(0));
+    cache.put(k, k);
+    // the newest cold key is always there.
+    ASSERT_NE(nullptr, cache.peek(k));
+  }
+}
+
+TEST(QueryCacheTest, bounded)
+{
+  ::fsc::query_cache<uint64_t, uint32_t> cache(1 << 12);
+  std::default_random_engine generator;
+  std::uniform_int_distribution<uint64_t> distribution(0, 100000);
+
+  std::vector<uint64_t> keys;
+  for (size_t i = 0; i < 10000; ++i) {
+    keys.push_back(distribution(generator));
+    cache.put(keys.back(), static_cast<uint32_t>(keys.back()));
+  }
+
+  // at most capacity entries, and every entry holds its own answer.
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  size_t present = 0;
+  for (auto k : keys) {
+    uint32_t * v = cache.peek(k);
+    if (v == nullptr) continue;
+    EXPECT_EQ(static_cast<uint32_t>(k), *v);
+    ++present;
+  }
+  EXPECT_GT(present, 0UL);
+  EXPECT_GE(cache.capacity(), present);
+}
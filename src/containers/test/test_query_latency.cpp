@@ -0,0 +1,128 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/query_latency.hpp"
+
+#include <random>
+#include <cstdint>  // uint64_t
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>     // ceil
+
+
+TEST(LatencyHistogramTest, bins)
+{
+  using H = ::fsc::latency_histogram;
+
+  // exact below sub_count, then contiguous bins with at most 1/half_count relative width.
+  for (uint64_t v = 0; v < 64; ++v) {
+    EXPECT_EQ(v, H::bin_of(v));
+    EXPECT_EQ(v, H::bin_upper(v));
+  }
+  for (size_t i = 64; i < H::bins; ++i) {
+    uint64_t lower = H::bin_upper(i - 1) + 1;
+    EXPECT_EQ(i, H::bin_of(lower)) << "bin " << i;
+    EXPECT_EQ(i, H::bin_of(H::bin_upper(i))) << "bin " << i;
+    EXPECT_LE(static_cast<double>(H::bin_upper(i) - lower), static_cast<double>(lower) / 32.0) << "bin " << i;
+  }
+  EXPECT_EQ(H::bins - 1, H::bin_of(::std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ(::std::numeric_limits<uint64_t>::max(), H::bin_upper(H::bins - 1));
+}
+
+TEST(LatencyHistogramTest, percentile)
+{
+  ::fsc::latency_histogram h;
+  EXPECT_EQ(0UL, h.percentile(0.5));
+
+  std::mt19937_64 gen(3);
+  std::lognormal_distribution<double> dist(12.0, 1.5);
+  std::vector<uint64_t> values;
+  for (size_t i = 0; i < 10000; ++i) {
+    values.push_back(static_cast<uint64_t>(dist(gen)));
+    h.record(values.back());
+  }
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(values.size(), h.count());
+  EXPECT_EQ(values.back(), h.max());
+
+  // within the bin width of the nearest rank value.
+  for (double q : {0.01, 0.5, 0.9, 0.99, 0.999}) {
+    uint64_t exact = values[static_cast<size_t>(std::ceil(q * values.size())) - 1];
+    EXPECT_LE(exact, h.percentile(q)) << "q " << q;
+    EXPECT_GE(static_cast<double>(exact) * (1.0 + 1.0 / 32.0) + 1.0, static_cast<double>(h.percentile(q))) << "q " << q;
+  }
+  EXPECT_EQ(values.back(), h.percentile(1.0));
+}
+
+TEST(LatencyHistogramTest, merge)
+{
+  ::fsc::latency_histogram a, b, all;
+  for (uint64_t v = 1; v < 100000; v *= 3) {
+    a.record(v);
+    all.record(v);
+    b.record(v * 7 + 1);
+    all.record(v * 7 + 1);
+  }
+  a.merge(b);
+  EXPECT_EQ(all.count(), a.count());
+  EXPECT_EQ(all.max(), a.max());
+  EXPECT_EQ(all.get_counts(), a.get_counts());
+
+  ::fsc::latency_histogram c;
+  c.assign(all.get_counts(), all.max());
+  EXPECT_EQ(all.count(), c.count());
+  EXPECT_EQ(all.percentile(0.5), c.percentile(0.5));
+
+  c.clear();
+  EXPECT_EQ(0UL, c.count());
+  EXPECT_EQ(0UL, c.max());
+}
+
+TEST(QueryLatencyTrackerTest, record)
+{
+  ::fsc::query_latency_tracker t;
+  EXPECT_FALSE(t.enter());
+
+  t.enable(true);
+  ASSERT_TRUE(t.enter());
+  EXPECT_FALSE(t.enter());   // nested
+  uint64_t r1[4] = {10, 200, 30, 40};
+  t.record(r1);
+  t.leave();
+
+  uint64_t r2[4] = {500, 20, 600, 10};
+  ASSERT_TRUE(t.enter());
+  t.record(r2);
+  t.leave();
+
+  uint64_t r3[4] = {1, 2, 3, 4};
+  t.record(r3);
+
+  EXPECT_EQ(3UL, t.get_rounds().count());
+  EXPECT_EQ(1130UL, t.get_rounds().max());
+  // local work is bucketing + lookup.
+  EXPECT_EQ(1100UL, t.get_work().max());
+  EXPECT_TRUE(std::equal(r2, r2 + 4, t.get_slowest()));
+
+  t.enable(false);
+  EXPECT_EQ(0UL, t.get_rounds().count());
+  EXPECT_EQ(0UL, t.get_slowest()[0]);
+  EXPECT_FALSE(t.enter());
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/radix_index.hpp"
+
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint64_t
+#include <utility>  // pair
+#include <vector>
+
+
+struct FirstLess {
+    bool operator()(::std::pair<uint64_t, uint32_t> const & x, uint64_t const & y) const { return x.first < y; }
+};
+
+class RadixIndexTest : public ::testing::TestWithParam<unsigned int>
+{
+  protected:
+    ::std::vector<::std::pair<uint64_t, uint32_t> > entries;
+
+    virtual void SetUp()
+    {  // sorted, with repeats, offset from 0 like a rank's key range.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution(1000, 50000);
+
+      for (size_t i = 0; i < 20000; ++i) {
+        entries.emplace_back(distribution(generator), i);
+        if ((i % 7) == 0) entries.emplace_back(entries.back().first, i);
+      }
+      ::std::sort(entries.begin(), entries.end());
+    }
+
+    void check(size_t const n) {
+      ::fsc::radix_index<uint64_t, FirstLess> index;
+      index.build(entries.begin(), entries.begin() + n, GetParam());
+      ASSERT_EQ(n, index.size());
+
+      FirstLess lt;
+      for (uint64_t v = 0; v < 50020; v += 3) {
+        size_t expected = ::std::distance(entries.begin(), ::std::lower_bound(entries.begin(), entries.begin() + n, v, lt));
+        ASSERT_EQ(expected, index.lower_bound(entries.begin(), v)) << "v " << v << " n " << n;
+      }
+    }
+};
+
+
+TEST_P(RadixIndexTest, lower_bound)
+{
+  check(entries.size());
+}
+
+TEST_P(RadixIndexTest, lower_bound_small)
+{
+  for (size_t n = 0; n < 40; ++n) check(n);
+}
+
+TEST_P(RadixIndexTest, lower_bound_skewed)
+{
+  // most keys in a narrow range, and a few far away.
+  entries.clear();
+  for (uint32_t i = 0; i < 5000; ++i) entries.emplace_back(100000 + (i / 3), i);
+  entries.emplace_back(0xFFFFFFFFFFFFull, 0);
+  entries.emplace_back(0xFFFFFFFFFFFFFFFFull, 0);
+
+  ::fsc::radix_index<uint64_t, FirstLess> index;
+  index.build(entries.begin(), entries.end(), GetParam());
+
+  FirstLess lt;
+  for (uint64_t v : {0ull, 99999ull, 100000ull, 101000ull, 101666ull, 101667ull, 0xFFFFFFFFFFFEull, 0xFFFFFFFFFFFFull,
+                     0x1000000000000ull, 0xFFFFFFFFFFFFFFFEull, 0xFFFFFFFFFFFFFFFFull}) {
+    size_t expected = ::std::distance(entries.begin(), ::std::lower_bound(entries.begin(), entries.end(), v, lt));
+    ASSERT_EQ(expected, index.lower_bound(entries.begin(), v)) << "v " << v;
+  }
+}
+
+TEST(RadixIndexSupport, key_types)
+{
+  ASSERT_TRUE((::fsc::radix_index<uint64_t, FirstLess>::supported));
+  ASSERT_TRUE((::fsc::radix_index<uint32_t, FirstLess>::supported));
+  ASSERT_FALSE((::fsc::radix_index<int64_t, FirstLess>::supported));
+  ASSERT_FALSE((::fsc::radix_index<double, FirstLess>::supported));
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, RadixIndexTest, ::testing::Values(0, 1, 4, 12, 24));
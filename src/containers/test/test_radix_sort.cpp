@@ -0,0 +1,210 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/radix_sort.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+#include <functional>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "utils/transform_utils.hpp"
+
+
+template <typename T>
+class RadixSortTest : public ::testing::Test
+{
+  protected:
+
+    using KmerType = T;
+    using PairType = ::std::pair<T, uint32_t>;
+
+    ::std::vector<T> keys;
+
+    virtual void SetUp()
+    { // generate some k-mers with repeats.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint8_t> distribution(0, 3);
+
+      T kmer;
+      for (size_t i = 0; i < T::size; ++i) kmer.nextFromChar(distribution(generator));
+
+      for (size_t i = 0; i < 100000; ++i) {
+        kmer.nextFromChar(distribution(generator));
+        keys.emplace_back(kmer);
+        if ((i % 7) == 0) keys.emplace_back(kmer);
+      }
+    }
+};
+
+// indicate this is a typed test
+TYPED_TEST_CASE_P(RadixSortTest);
+
+
+TYPED_TEST_P(RadixSortTest, sort_keys)
+{
+  ::std::vector<TypeParam> gold(this->keys);
+  ::std::sort(gold.begin(), gold.end());
+
+  for (size_t n : {0UL, 1UL, 63UL, 64UL, 1000UL, this->keys.size()}) {
+    ::std::vector<TypeParam> test(this->keys.begin(), this->keys.begin() + n);
+    ::fsc::radix_sort(test);
+
+    ::std::vector<TypeParam> g(this->keys.begin(), this->keys.begin() + n);
+    ::std::sort(g.begin(), g.end());
+    EXPECT_TRUE(::std::equal(g.begin(), g.end(), test.begin())) << "n=" << n;
+  }
+}
+
+TYPED_TEST_P(RadixSortTest, sort_pairs)
+{
+  using PairType = ::std::pair<TypeParam, uint32_t>;
+  ::std::vector<PairType> test;
+  for (size_t i = 0; i < this->keys.size(); ++i) test.emplace_back(this->keys[i], i);
+
+  ::std::vector<PairType> gold(test);
+  ::std::stable_sort(gold.begin(), gold.end(), [](PairType const & x, PairType const & y) { return x.first < y.first; });
+
+  ::fsc::radix_sort(test);
+
+  // LSD passes are stable, and so is the MSD pass.
+  EXPECT_TRUE(::std::equal(gold.begin(), gold.end(), test.begin()));
+}
+
+TYPED_TEST_P(RadixSortTest, sort_dispatch)
+{
+  using PairType = ::std::pair<TypeParam, uint32_t>;
+  using LessType = ::fsc::TransformedComparator<TypeParam, ::std::less, ::bliss::transform::identity>;
+
+  ::std::vector<PairType> test;
+  for (size_t i = 0; i < this->keys.size(); ++i) test.emplace_back(this->keys[i], 1);
+
+  ::std::vector<PairType> gold(test);
+  ::std::sort(gold.begin(), gold.end(), LessType());
+
+  bool sorted = false;
+  ::fsc::sort(test, sorted, LessType());
+  EXPECT_TRUE(sorted);
+  EXPECT_TRUE(::std::is_sorted(test.begin(), test.end(), LessType()));
+  for (size_t i = 0; i < gold.size(); ++i) {
+    EXPECT_EQ(gold[i].first, test[i].first);
+  }
+
+  // buckets are sorted independently.
+  ::std::vector<PairType> bucketed(gold.size());
+  ::std::reverse_copy(gold.begin(), gold.end(), bucketed.begin());
+  ::std::vector<size_t> counts = {100, 0, 5000, 1, bucketed.size() - 5101};
+  sorted = false;
+  ::fsc::bucket_sort(bucketed, counts, sorted, LessType());
+  EXPECT_TRUE(sorted);
+  size_t offset = 0;
+  for (auto c : counts) {
+    EXPECT_TRUE(::std::is_sorted(bucketed.begin() + offset, bucketed.begin() + offset + c, LessType()));
+    offset += c;
+  }
+}
+
+
+// now register the test cases
+REGISTER_TYPED_TEST_CASE_P(RadixSortTest, sort_keys, sort_pairs, sort_dispatch);
+
+
+//////////////////// RUN the tests with different types.
+
+typedef ::testing::Types<
+    ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<21, ::bliss::common::DNA5, uint64_t>,
+    ::bliss::common::Kmer<13, ::bliss::common::DNA, uint16_t>,
+    ::bliss::common::Kmer<11, ::bliss::common::DNA, uint8_t>,
+    ::bliss::common::Kmer<40, ::bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<95, ::bliss::common::DNA, uint64_t>
+    > RadixSortTestTypes;
+INSTANTIATE_TYPED_TEST_CASE_P(Bliss, RadixSortTest, RadixSortTestTypes);
+
+
+TEST(RadixSortIntTest, sort_uint)
+{
+  std::default_random_engine generator;
+  std::uniform_int_distribution<uint64_t> distribution;
+
+  ::std::vector<uint64_t> test;
+  for (size_t i = 0; i < 200000; ++i) test.emplace_back(distribution(generator) >> (i % 64));
+
+  ::std::vector<uint64_t> gold(test);
+  ::std::sort(gold.begin(), gold.end());
+
+  ::fsc::radix_sort(test);
+  EXPECT_TRUE(::std::equal(gold.begin(), gold.end(), test.begin()));
+
+  // in a range, with a reused scratch.
+  ::std::vector<uint32_t> small(gold.size());
+  for (size_t i = 0; i < gold.size(); ++i) small[i] = static_cast<uint32_t>(gold[gold.size() - 1 - i]);
+  ::std::vector<uint32_t> scratch;
+  ::fsc::radix_sort(small.data(), small.data() + 1000, scratch);
+  ::fsc::radix_sort(small.data() + 1000, small.data() + small.size(), scratch);
+  EXPECT_TRUE(::std::is_sorted(small.begin(), small.begin() + 1000));
+  EXPECT_TRUE(::std::is_sorted(small.begin() + 1000, small.end()));
+}
+
+
+/// prefix sort against std::sort, with many equal prefixes:  the k-mers are random in the low word only, half the time.
+template <unsigned int K>
+void test_prefix_sort() {
+  using KmerType = ::bliss::common::Kmer<K, ::bliss::common::DNA, uint64_t>;
+  using PairType = ::std::pair<KmerType, uint32_t>;
+
+  std::default_random_engine generator;
+  std::uniform_int_distribution<uint64_t> distribution;
+
+  ::std::vector<PairType> test;
+  for (size_t i = 0; i < 100000; ++i) {
+    KmerType kmer;
+    for (unsigned int j = 0; j < KmerType::nWords; ++j) kmer.getDataRef()[j] = (i % 2) ? (j == 0 ? distribution(generator) : j) : distribution(generator);
+    kmer.sanitize();
+    test.emplace_back(kmer, i);
+  }
+
+  ::std::vector<PairType> gold(test);
+  ::std::sort(gold.begin(), gold.end(), [](PairType const & x, PairType const & y) { return x.first < y.first; });
+
+  ::std::vector<PairType> whole(test);
+  ::fsc::prefix_sort(whole);
+  for (size_t i = 0; i < gold.size(); ++i) ASSERT_EQ(gold[i].first, whole[i].first) << "k=" << K << " i=" << i;
+
+  // ranges, with a reused scratch.
+  ::std::vector<PairType> scratch;
+  ::fsc::prefix_sort(test.data(), test.data() + 10, scratch);
+  ::fsc::prefix_sort(test.data() + 10, test.data() + test.size(), scratch);
+  auto less = [](PairType const & x, PairType const & y) { return x.first < y.first; };
+  EXPECT_TRUE(::std::is_sorted(test.begin(), test.begin() + 10, less));
+  EXPECT_TRUE(::std::is_sorted(test.begin() + 10, test.end(), less));
+}
+
+TEST(PrefixSortTest, sort_pairs)
+{
+  test_prefix_sort<33>();
+  test_prefix_sort<64>();
+  test_prefix_sort<95>();
+  test_prefix_sort<128>();
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/soa_hash_map.hpp"
+
+#include <unordered_map>
+#include <random>
+#include <algorithm>  // for sort, unique
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+
+
+/*
+ * test class holding some information.  Also, needed for the typed tests
+ */
+template<typename T>
+class SoAHashMapTest : public ::testing::Test
+{
+    static_assert(std::is_integral<T>::value, "only supporting integral types in tests right now.");
+  protected:
+
+
+    ::std::unordered_map<T, T> gold;
+    ::std::vector<std::pair<T, T>> temp;
+    ::std::vector<T> unique_keys;
+
+
+    size_t iters = 100000;
+    T min_val = 0;
+    T max_val = ::std::numeric_limits<T>::max();
+
+    virtual void SetUp()
+    { // generate some inputs
+
+
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution(min_val, max_val);
+
+      for (size_t i=0; i< iters; ++i) {
+        T key = static_cast<T>(distribution(generator));
+        T val = static_cast<T>(distribution(generator));
+        gold.emplace(key, val);
+        temp.emplace_back(::std::move(key), ::std::move(val));
+      }
+
+      for (auto x : gold) unique_keys.emplace_back(x.first);
+      std::sort(unique_keys.begin(), unique_keys.end());
+    }
+
+    static bool less(::std::pair<T, T> const & x, ::std::pair<T, T> const &y) {
+      return (x.first == y.first) ? (x.second < y.second) : (x.first < y.first);
+    }
+};
+
+// indicate this is a typed test
+TYPED_TEST_CASE_P(SoAHashMapTest);
+
+TYPED_TEST_P(SoAHashMapTest, insert)
+{
+  using MAP = ::fsc::soa_hash_map<TypeParam, TypeParam>;
+
+  // small initial capacity, so that the table grows multiple times.
+  MAP test(8);
+  test.insert(this->temp);
+
+  EXPECT_EQ(this->gold.size(), test.size());
+
+  ::std::vector<::std::pair<TypeParam, TypeParam> > test_vals = test.to_vector();
+  ::std::vector<::std::pair<TypeParam, TypeParam> > gold_vals(this->gold.begin(), this->gold.end());
+
+  ::std::sort(test_vals.begin(), test_vals.end(), &SoAHashMapTest<TypeParam>::less);
+  ::std::sort(gold_vals.begin(), gold_vals.end(), &SoAHashMapTest<TypeParam>::less);
+
+  ASSERT_EQ(gold_vals.size(), test_vals.size());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+
+  // iterating should visit the same entries as to_vector
+  size_t count = 0;
+  for (auto it = test.begin(); it != test.end(); ++it) {
+    EXPECT_EQ(this->gold.at(it->first), it->second);
+    ++count;
+  }
+  EXPECT_EQ(this->gold.size(), count);
+}
+
+
+TYPED_TEST_P(SoAHashMapTest, find)
+{
+  using MAP = ::fsc::soa_hash_map<TypeParam, TypeParam>;
+
+  MAP test(this->temp.begin(), this->temp.end());
+
+  for (auto k : this->unique_keys) {
+    auto test_range = test.equal_range(k);
+    ASSERT_TRUE(test_range.first != test_range.second);
+    EXPECT_EQ(this->gold.at(k), (*(test_range.first)).second);
+
+    auto next = test_range.first;
+    ++next;
+    EXPECT_TRUE(next == test_range.second);
+
+    EXPECT_EQ(1UL, test.count(k));
+    EXPECT_TRUE(test.exists(k));
+  }
+
+  // reduction through the insert result, as the distributed reduction map does.
+  for (auto x : this->temp) {
+    auto result = test.insert(x);
+    if (!result.second) result.first->second = 1;
+  }
+  for (auto k : this->unique_keys) {
+    EXPECT_EQ(1, test.find(k)->second);
+  }
+}
+
+
+TYPED_TEST_P(SoAHashMapTest, erase)
+{
+  using MAP = ::fsc::soa_hash_map<TypeParam, TypeParam>;
+
+  MAP test(this->temp.begin(), this->temp.end());
+
+  // erase every other key by key
+  ::std::vector<TypeParam> to_erase;
+  for (size_t i = 0; i < this->unique_keys.size(); i += 2) to_erase.emplace_back(this->unique_keys[i]);
+  EXPECT_EQ(to_erase.size(), test.erase(to_erase.begin(), to_erase.end()));
+  EXPECT_EQ(this->unique_keys.size() - to_erase.size(), test.size());
+
+  for (size_t i = 0; i < this->unique_keys.size(); ++i) {
+    EXPECT_EQ((i & 1), test.count(this->unique_keys[i]));
+  }
+
+  // erase the rest by predicate on the value
+  size_t before = test.size();
+  size_t odd = 0;
+  for (size_t i = 1; i < this->unique_keys.size(); i += 2) {
+    if ((this->gold.at(this->unique_keys[i]) & 1) == 1) ++odd;
+  }
+  EXPECT_EQ(odd, test.erase([](::std::pair<TypeParam, TypeParam> const & x){
+    return (x.second & 1) == 1;
+  }));
+  EXPECT_EQ(before - odd, test.size());
+
+  for (size_t i = 1; i < this->unique_keys.size(); i += 2) {
+    EXPECT_EQ((this->gold.at(this->unique_keys[i]) & 1) == 1 ? 0UL : 1UL, test.count(this->unique_keys[i]));
+  }
+}
+
+// now register the test cases
+REGISTER_TYPED_TEST_CASE_P(SoAHashMapTest, insert, find, erase);
+
+
+//////////////////// RUN the tests with different types.
+
+typedef ::testing::Types<uint8_t, uint16_t,
+    uint32_t, uint64_t> SoAHashMapTestTypes;
+INSTANTIATE_TYPED_TEST_CASE_P(Bliss, SoAHashMapTest, SoAHashMapTestTypes);
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/soa_vector.hpp"
+#include "containers/fsc_container_utils.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+
+#include <algorithm>  // copy
+#include <cstdint>  // uint32_t
+#include <iterator>  // distance
+#include <utility>  // pair
+#include <vector>
+
+
+TEST(SoaVectorTest, emplace_and_iterate)
+{
+  ::std::vector<::std::pair<uint64_t, uint32_t> > pairs;
+  for (uint32_t i = 0; i < 1000; ++i) pairs.emplace_back(i * 7919ULL, i);
+
+  // filled through back_emplace_iterator, as a parser's output.
+  ::fsc::soa_vector<uint64_t, uint32_t> soa;
+  ::std::copy(pairs.begin(), pairs.end(), ::fsc::back_emplace_iterator<::fsc::soa_vector<uint64_t, uint32_t> >(soa));
+  ASSERT_EQ(pairs.size(), soa.size());
+  ASSERT_EQ(soa.keys.size(), soa.values.size());
+
+  EXPECT_EQ(static_cast<long>(pairs.size()), ::std::distance(soa.begin(), soa.end()));
+  size_t i = 0;
+  for (auto it = soa.begin(); it != soa.end(); ++it, ++i) {
+    EXPECT_EQ(pairs[i].first, (*it).first);
+    EXPECT_EQ(pairs[i].second, (*it).second);
+    EXPECT_EQ(pairs[i], soa[i]);
+  }
+
+  ::std::vector<::std::pair<uint64_t, uint32_t> > out;
+  soa.to_pairs(out);
+  EXPECT_EQ(pairs, out);
+
+  ::fsc::soa_vector<uint64_t, uint32_t> copy(pairs.begin(), pairs.end());
+  EXPECT_EQ(soa.keys, copy.keys);
+  EXPECT_EQ(soa.values, copy.values);
+
+  soa.clear();
+  EXPECT_TRUE(soa.empty());
+  EXPECT_TRUE(soa.begin() == soa.end());
+}
+
+TEST(SoaVectorTest, no_padding)
+{
+  // a 31-mer and a 4 byte count:  padded to 16 bytes as a pair, 12 as 2 arrays.
+  using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+  ::fsc::soa_vector<KmerType, uint32_t> soa;
+  soa.resize(1024);
+  soa.shrink_to_fit();
+  ASSERT_EQ(16UL, sizeof(::std::pair<KmerType, uint32_t>));
+  EXPECT_EQ(1024 * (sizeof(KmerType) + sizeof(uint32_t)), soa.bytes());
+}
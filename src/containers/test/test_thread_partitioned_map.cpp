@@ -0,0 +1,138 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "containers/thread_partitioned_map.hpp"
+#include "containers/soa_hash_map.hpp"
+
+#include <unordered_map>
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint32_t
+#include <utility>  // pair
+#include <vector>
+#include <functional>
+
+
+template <typename Key, typename T>
+using PartitionedMap = ::fsc::thread_partitioned<::fsc::soa_hash_map>::map<Key, T,
+    ::fsc::soa::no_special_keys, ::bliss::transform::identity,
+    ::fsc::TransformedHash<Key, ::std::hash, ::bliss::transform::identity>,
+    ::fsc::TransformedComparator<Key, ::std::equal_to, ::bliss::transform::identity>,
+    ::std::allocator<::std::pair<const Key, T> >, false>;
+
+
+class ThreadPartitionedMapTest : public ::testing::Test
+{
+  protected:
+
+    ::std::unordered_map<uint64_t, uint32_t> gold;
+    ::std::vector<::std::pair<uint64_t, uint32_t> > temp;
+
+    size_t iters = 200000;
+
+    virtual void SetUp()
+    { // generate some inputs with repeats.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution(0, 50000);
+
+      for (size_t i=0; i< iters; ++i) {
+        uint64_t key = distribution(generator);
+        gold.emplace(key, static_cast<uint32_t>(i));
+        temp.emplace_back(key, static_cast<uint32_t>(i));
+      }
+    }
+};
+
+
+TEST_F(ThreadPartitionedMapTest, insert)
+{
+  PartitionedMap<uint64_t, uint32_t> test;
+  test.insert(this->temp);
+
+  EXPECT_EQ(this->gold.size(), test.size());
+
+  // first inserted entry for each key is kept.
+  size_t count = 0;
+  for (auto it = test.begin(); it != test.end(); ++it) {
+    EXPECT_EQ(this->gold.at(it->first), it->second);
+    ++count;
+  }
+  EXPECT_EQ(this->gold.size(), count);
+
+  for (auto x : this->gold) {
+    auto it = test.find(x.first);
+    ASSERT_TRUE(it != test.end());
+    EXPECT_EQ(x.second, it->second);
+
+    auto range = test.equal_range(x.first);
+    EXPECT_TRUE(range.first == it);
+    EXPECT_TRUE(++range.first == range.second);
+  }
+  EXPECT_TRUE(test.find(100000) == test.end());
+  EXPECT_EQ(0UL, test.count(100000));
+}
+
+TEST_F(ThreadPartitionedMapTest, reduce)
+{
+  ::std::unordered_map<uint64_t, uint32_t> counts;
+  ::std::vector<::std::pair<uint64_t, uint32_t> > ones;
+  for (auto x : this->temp) {
+    ++counts[x.first];
+    ones.emplace_back(x.first, 1);
+  }
+
+  PartitionedMap<uint64_t, uint32_t> test;
+  // 2 rounds, to reduce against existing entries too.
+  size_t half = ones.size() / 2;
+  size_t added = test.insert(ones.begin(), ones.begin() + half, ::std::plus<uint32_t>());
+  added += test.insert(ones.begin() + half, ones.end(), ::std::plus<uint32_t>());
+  EXPECT_EQ(counts.size(), added);
+
+  ::std::vector<::std::pair<uint64_t, uint32_t> > result = test.to_vector();
+  ASSERT_EQ(counts.size(), result.size());
+  for (auto x : result) {
+    EXPECT_EQ(counts.at(x.first), x.second);
+  }
+}
+
+TEST_F(ThreadPartitionedMapTest, erase)
+{
+  PartitionedMap<uint64_t, uint32_t> test;
+  test.insert(this->temp);
+
+  ::std::vector<uint64_t> keys;
+  for (uint64_t k = 0; k < 1000; ++k) keys.emplace_back(k);
+  size_t erased = test.erase(keys.begin(), keys.end());
+
+  size_t expected = 0;
+  for (auto k : keys) expected += this->gold.erase(k);
+  EXPECT_EQ(expected, erased);
+
+  // predicate erase in parallel
+  erased = test.erase([](::std::pair<uint64_t, uint32_t> const & x) { return (x.second & 1) == 1; });
+  expected = 0;
+  for (auto it = this->gold.begin(); it != this->gold.end(); ) {
+    if ((it->second & 1) == 1) {
+      it = this->gold.erase(it);
+      ++expected;
+    } else ++it;
+  }
+  EXPECT_EQ(expected, erased);
+  EXPECT_EQ(this->gold.size(), test.size());
+}
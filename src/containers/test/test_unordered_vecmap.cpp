@@ -308,7 +308,29 @@ TYPED_TEST_P(UnorderedCompactVecMapTest, copy)
 
 
 // now register the test cases
-REGISTER_TYPED_TEST_CASE_P(UnorderedCompactVecMapTest, insert, equal_range_value_only, equal_range, count, iterator, rand_iterator, copy);
+TYPED_TEST_P(UnorderedCompactVecMapTest, parallel_for_each)
+{
+  using PAIR = ::std::pair<TypeParam, TypeParam>;
+
+  // each thread collects its own share.
+  ::std::vector<::std::vector<PAIR> > parts(::fsc::parallel_for_each_threads(0));
+  this->test.parallel_for_each([&parts](::std::pair<const TypeParam, TypeParam> const & x, int const tid) {
+    parts[tid].emplace_back(x.first, x.second);
+  });
+
+  ::std::vector<PAIR> test_vals;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    test_vals.insert(test_vals.end(), parts[i].begin(), parts[i].end());
+  }
+  ::std::vector<PAIR> gold_vals(this->gold.begin(), this->gold.end());
+  EXPECT_EQ(gold_vals.size(), test_vals.size());
+
+  ::std::sort(test_vals.begin(), test_vals.end());
+  ::std::sort(gold_vals.begin(), gold_vals.end());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+}
+
+REGISTER_TYPED_TEST_CASE_P(UnorderedCompactVecMapTest, insert, equal_range_value_only, equal_range, count, iterator, rand_iterator, copy, parallel_for_each);
 
 
 //////////////////// RUN the tests with different types.
@@ -563,7 +585,61 @@ TYPED_TEST_P(UnorderedVecMapTest, copy)
 
 
 // now register the test cases
-REGISTER_TYPED_TEST_CASE_P(UnorderedVecMapTest, insert, equal_range, count, iterator, rand_iterator, copy);
+TYPED_TEST_P(UnorderedVecMapTest, parallel_for_each)
+{
+  using PAIR = ::std::pair<TypeParam, TypeParam>;
+
+  // each thread collects its own share.
+  ::std::vector<::std::vector<PAIR> > parts(::fsc::parallel_for_each_threads(0));
+  this->test.parallel_for_each([&parts](PAIR const & x, int const tid) {
+    parts[tid].emplace_back(x.first, x.second);
+  });
+
+  ::std::vector<PAIR> test_vals;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    test_vals.insert(test_vals.end(), parts[i].begin(), parts[i].end());
+  }
+  ::std::vector<PAIR> gold_vals(this->gold.begin(), this->gold.end());
+  EXPECT_EQ(gold_vals.size(), test_vals.size());
+
+  ::std::sort(test_vals.begin(), test_vals.end());
+  ::std::sort(gold_vals.begin(), gold_vals.end());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+}
+
+TYPED_TEST_P(UnorderedVecMapTest, table_stats)
+{
+  // 1 chained entry per key.
+  ::fsc::table_stats stats = this->test.get_table_stats();
+  EXPECT_EQ(this->test.unique_size(), stats.occupied);
+  EXPECT_EQ(this->test.bucket_count(), stats.buckets);
+  EXPECT_EQ(0UL, stats.tombstones);
+
+  size_t binned = 0;
+  for (size_t i = 0; i < stats.probes.size(); ++i) binned += stats.probes[i];
+  EXPECT_EQ(stats.occupied, binned);
+  EXPECT_LE(1.0, stats.mean_probe());
+  EXPECT_LE(stats.probe_percentile(0.5), stats.probe_percentile(0.99));
+}
+
+TYPED_TEST_P(UnorderedVecMapTest, bulk_load)
+{
+  // one entry per key, as bulk_load expects.
+  ::std::unordered_map<TypeParam, TypeParam> uniq(this->gold.begin(), this->gold.end());
+  ::std::vector<::std::pair<TypeParam, TypeParam> > gold_vals(uniq.begin(), uniq.end());
+
+  ::fsc::unordered_vecmap<TypeParam, TypeParam> test2;
+  test2.bulk_load(gold_vals.begin(), gold_vals.end());
+  EXPECT_EQ(gold_vals.size(), test2.size());
+  EXPECT_EQ(gold_vals.size(), test2.unique_size());
+
+  ::std::vector<::std::pair<TypeParam, TypeParam> > test_vals(test2.begin(), test2.end());
+  ::std::sort(test_vals.begin(), test_vals.end());
+  ::std::sort(gold_vals.begin(), gold_vals.end());
+  EXPECT_TRUE(::std::equal(test_vals.begin(), test_vals.end(), gold_vals.begin()));
+}
+
+REGISTER_TYPED_TEST_CASE_P(UnorderedVecMapTest, insert, equal_range, count, iterator, rand_iterator, copy, parallel_for_each, table_stats, bulk_load);
 
 
 //////////////////// RUN the tests with different types.
@@ -0,0 +1,554 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    thread_partitioned_map.hpp
+ * @ingroup fsc::containers
+ * @brief   local hash map made of per-thread sub-tables, for multithreaded local insertion.
+ * @details as described in index/kmer_hash.hpp, with N = p * t * l total buckets, a key goes to process hash / (t * l),
+ *          then thread (hash / l) % t, then local bucket hash % l.  the distributed maps already assign the process,
+ *          and the local container assigns the bucket.  this container does the thread level:  it holds t sub-tables
+ *          of the Inner container type, and a key always lives in sub-table  mix64(hash(key)) % t.
+ *          the hash is remixed so that the sub-table choice does not reuse the bits of the process or bucket assignment.
+ *
+ *          bulk insertion groups the input by sub-table, then each OpenMP thread inserts into its own sub-tables.
+ *          there is no locking since a sub-table is only ever modified by 1 thread.  single element operations are routed
+ *          to the sub-table serially.
+ *
+ *          the parallel loops use schedule(static, 1), so sub-table i is always resized and filled by thread i.  with
+ *          threads pinned (e.g. OMP_PROC_BIND=true), first touch then places each sub-table on the NUMA node of its thread.
+ *          the sub-tables are sized evenly by the remixed hash, so the static schedule costs little load balance.
+ *
+ *          the number of sub-tables is omp_get_max_threads() at construction time, or 1 if OpenMP is not enabled.
+ *
+ *          the container type is  ::fsc::thread_partitioned<Inner>::map, which has the same template parameters as
+ *          ::fsc::densehash_map, so it can be used as the Container for ::dsc::densehash_map_base.
+ */
+#ifndef SRC_CONTAINERS_THREAD_PARTITIONED_MAP_HPP_
+#define SRC_CONTAINERS_THREAD_PARTITIONED_MAP_HPP_
+
+#include <vector>
+#include <functional>  // hash, equal_to, etc
+#include <utility>   // pair
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "containers/fsc_container_utils.hpp"
+#include "utils/transform_utils.hpp"
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace fsc {  // fast standard container
+
+
+  /**
+   * @brief  wraps an Inner map type, e.g. ::fsc::densehash_map, in per-thread sub-tables.
+   * @tparam Inner  local map template with the ::fsc::densehash_map template parameters.
+   */
+  template <template <typename, typename, typename, template <typename> class,
+      typename, typename, typename, bool> class Inner>
+  struct thread_partitioned {
+
+    template <typename Key,
+    typename T,
+    typename SpecialKeys,
+    template<typename> class Transform,
+    typename Hash,
+    typename Equal,
+    typename Allocator,
+    bool split>
+    class map {
+
+      protected:
+        using subtable_type = Inner<Key, T, SpecialKeys, Transform, Hash, Equal, Allocator, split>;
+
+        ::std::vector<subtable_type> subtables;
+        Hash hash;
+
+        /// sub-table id for a key
+        inline size_t part(Key const & key) const {
+          return ::bliss::utils::mix64(static_cast<uint64_t>(hash(key))) % subtables.size();
+        }
+
+        static size_t default_parts() {
+#if defined(USE_OPENMP)
+          return static_cast<size_t>(omp_get_max_threads());
+#else
+          return 1;
+#endif
+        }
+
+      public:
+        using key_type              = Key;
+        using mapped_type           = T;
+        using value_type            = typename subtable_type::value_type;
+        using hasher                = Hash;
+        using key_equal             = Equal;
+        using allocator_type        = Allocator;
+        using reference             = typename subtable_type::reference;
+        using const_reference       = typename subtable_type::const_reference;
+        using pointer               = typename subtable_type::pointer;
+        using const_pointer         = typename subtable_type::const_pointer;
+        using size_type             = size_t;
+        using difference_type       = ptrdiff_t;
+
+      protected:
+
+        /// iterates through the sub-tables in order.  an iterator at the end of a sub-table is moved to the start of the next.
+        template <bool IS_CONST>
+        class partitioned_iterator {
+            friend class map;
+            template <bool> friend class partitioned_iterator;
+
+            using map_ptr = typename ::std::conditional<IS_CONST, map const *, map *>::type;
+            using inner_iter = typename ::std::conditional<IS_CONST,
+                typename subtable_type::const_iterator, typename subtable_type::iterator>::type;
+
+            map_ptr m;
+            size_t sub;
+            inner_iter it;
+
+            inline void skip_empty() {
+              while ((sub + 1) < m->subtables.size() && (it == m->subtables[sub].end())) {
+                ++sub;
+                it = subtable_begin(sub);
+              }
+            }
+
+            template <bool C = IS_CONST>
+            typename ::std::enable_if<C, inner_iter>::type subtable_begin(size_t i) const {
+              return m->subtables[i].cbegin();
+            }
+            template <bool C = IS_CONST>
+            typename ::std::enable_if<!C, inner_iter>::type subtable_begin(size_t i) const {
+              return m->subtables[i].begin();
+            }
+
+          public:
+            using iterator_category = ::std::forward_iterator_tag;
+            using value_type = typename ::std::iterator_traits<inner_iter>::value_type;
+            using difference_type = ptrdiff_t;
+            using reference = decltype(*(::std::declval<inner_iter>()));
+            using pointer = decltype(::std::declval<inner_iter>().operator->());
+
+            partitioned_iterator() : m(nullptr), sub(0), it() {}
+            partitioned_iterator(map_ptr _m, size_t _sub, inner_iter const & _it) : m(_m), sub(_sub), it(_it) {
+              skip_empty();
+            }
+
+            /// conversion from non-const to const iterator
+            template <bool C = IS_CONST, typename = typename ::std::enable_if<C>::type>
+            partitioned_iterator(partitioned_iterator<false> const & other) : m(other.m), sub(other.sub), it(other.it) {}
+
+            reference operator*() const {
+              return *it;
+            }
+            pointer operator->() const {
+              return it.operator->();
+            }
+
+            partitioned_iterator & operator++() {
+              ++it;
+              skip_empty();
+              return *this;
+            }
+            partitioned_iterator operator++(int) {
+              partitioned_iterator out(*this);
+              ++(*this);
+              return out;
+            }
+
+            bool operator==(partitioned_iterator const & other) const {
+              return (sub == other.sub) && (it == other.it);
+            }
+            bool operator!=(partitioned_iterator const & other) const {
+              return !(this->operator==(other));
+            }
+        };
+
+      public:
+        using iterator              = partitioned_iterator<false>;
+        using const_iterator        = partitioned_iterator<true>;
+
+      protected:
+        /// group the input by sub-table.  returns offsets of each sub-table's group (size is #subtables + 1)
+        template <typename InputIt>
+        ::std::vector<size_t> group(InputIt first, InputIt last, ::std::vector<::std::pair<Key, T> > & grouped) const {
+          size_t const parts = subtables.size();
+          size_t const n = ::std::distance(first, last);
+
+          ::std::vector<size_t> offsets(parts + 1, 0);
+          ::std::vector<uint32_t> ids(n);
+
+          size_t i = 0;
+          for (auto it = first; it != last; ++it, ++i) {
+            ids[i] = part((*it).first);
+            ++offsets[ids[i] + 1];
+          }
+          for (size_t j = 1; j <= parts; ++j) {
+            offsets[j] += offsets[j - 1];
+          }
+
+          // stable, so the first of duplicate entries still wins.
+          grouped.resize(n);
+          ::std::vector<size_t> pos(offsets.begin(), offsets.end() - 1);
+          i = 0;
+          for (auto it = first; it != last; ++it, ++i) {
+            grouped[pos[ids[i]]++] = *it;
+          }
+
+          return offsets;
+        }
+
+      public:
+
+        map(size_type bucket_count = 128) :
+          subtables(), hash() {
+          size_t parts = default_parts();
+          subtables.reserve(parts);
+          for (size_t i = 0; i < parts; ++i) {
+            subtables.emplace_back((bucket_count + parts - 1) / parts);
+          }
+        };
+
+        template<class InputIt>
+        map(InputIt first, InputIt last) :
+          map(std::distance(first, last)) {
+          this->insert(first, last);
+        };
+
+        virtual ~map() {};
+
+        /// number of sub-tables.
+        size_t get_partition_count() const {
+          return subtables.size();
+        }
+
+        float get_max_load_factor() const {
+          return subtables[0].get_max_load_factor();
+        }
+
+        iterator begin() {
+          return iterator(this, 0, subtables[0].begin());
+        }
+        const_iterator begin() const {
+          return cbegin();
+        }
+        const_iterator cbegin() const {
+          return const_iterator(this, 0, subtables[0].cbegin());
+        }
+
+        iterator end() {
+          return iterator(this, subtables.size() - 1, subtables.back().end());
+        }
+        const_iterator end() const {
+          return cend();
+        }
+        const_iterator cend() const {
+          return const_iterator(this, subtables.size() - 1, subtables.back().cend());
+        }
+
+
+        std::vector<Key> keys() const {
+          std::vector<Key> ks;
+
+          keys(ks);
+
+          return ks;
+        }
+        void keys(std::vector<Key> & ks) const {
+          ks.clear();
+          ks.reserve(size());
+
+          std::vector<Key> temp;
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            subtables[i].keys(temp);
+            ks.insert(ks.end(), temp.begin(), temp.end());
+          }
+        }
+
+        std::vector<std::pair<Key, T> > to_vector() const {
+          std::vector<std::pair<Key, T>> vs;
+
+          to_vector(vs);
+
+          return vs;
+        }
+        void to_vector(  std::vector<std::pair<Key, T> > & vs) const {
+          vs.clear();
+          vs.reserve(size());
+
+          std::vector<std::pair<Key, T> > temp;
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            subtables[i].to_vector(temp);
+            vs.insert(vs.end(), temp.begin(), temp.end());
+          }
+        }
+
+
+        bool empty() const {
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            if (!subtables[i].empty()) return false;
+          }
+          return true;
+        }
+
+        size_type size() const {
+          size_t s = 0;
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            s += subtables[i].size();
+          }
+          return s;
+        }
+        size_type unique_size() const {
+          size_t s = 0;
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            s += subtables[i].unique_size();
+          }
+          return s;
+        }
+
+        void reset() {
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            subtables[i].reset();
+          }
+        }
+
+        void clear() {
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            subtables[i].clear();
+          }
+        }
+
+        /// resize each sub-table for an even share of n.
+        void resize(size_t const n) {
+          size_t const parts = subtables.size();
+#if defined(USE_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+          for (size_t i = 0; i < parts; ++i) {
+            subtables[i].resize((n + parts - 1) / parts);
+          }
+        }
+
+        /// rehash for new count number of BUCKETS.  iterators are invalidated.
+        void rehash(size_type count) {
+          this->resize(count);
+        }
+
+        size_type bucket_count() const {
+          size_t s = 0;
+          for (size_t i = 0; i < subtables.size(); ++i) {
+            s += subtables[i].bucket_count();
+          }
+          return s;
+        }
+
+        float load_factor() const {
+          return static_cast<float>(size()) / static_cast<float>(bucket_count());
+        }
+
+
+        /// insert a range.  grouped by sub-table, then each thread inserts into its sub-tables.
+        template <class InputIt>
+        void insert(InputIt first, InputIt last) {
+          if (first == last) return;
+
+          ::std::vector<::std::pair<Key, T> > grouped;
+          ::std::vector<size_t> offsets = group(first, last, grouped);
+
+          size_t const parts = subtables.size();
+#if defined(USE_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+          for (size_t i = 0; i < parts; ++i) {
+            subtables[i].insert(grouped.begin() + offsets[i], grouped.begin() + offsets[i + 1]);
+          }
+        }
+
+        /**
+         * @brief insert a range, reducing with the existing entry:  existing = r(existing, new).
+         * @details  grouped by sub-table, then each thread inserts into its sub-tables.  used by the reduction and counting maps.
+         *           r is copied per thread.
+         * @return number of new entries.
+         */
+        template <class InputIt, class Reducer>
+        size_t insert(InputIt first, InputIt last, Reducer const & r) {
+          if (first == last) return 0;
+
+          ::std::vector<::std::pair<Key, T> > grouped;
+          ::std::vector<size_t> offsets = group(first, last, grouped);
+
+          size_t const parts = subtables.size();
+          size_t before = size();
+#if defined(USE_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+          for (size_t i = 0; i < parts; ++i) {
+            Reducer rr(r);
+            subtable_type & sub = subtables[i];
+            for (size_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+              auto result = sub.insert(grouped[j]);
+              if (!(result.second)) {
+                result.first->second = rr(result.first->second, grouped[j].second);
+              }
+            }
+          }
+          return size() - before;
+        }
+
+        void insert(::std::vector<::std::pair<Key, T> > & input) {
+          insert(input.begin(), input.end());
+        }
+
+        void insert(::std::vector<value_type > & input) {
+          insert(input.begin(), input.end());
+        }
+
+        template <typename K = Key, typename = typename std::enable_if<!std::is_const<Key>::value> >
+        std::pair<iterator, bool> insert(::std::pair<Key, T> const & x) {
+          size_t i = part(x.first);
+          auto result = subtables[i].insert(x);
+          return std::make_pair(iterator(this, i, result.first), result.second);
+        }
+
+        std::pair<iterator, bool> insert(::std::pair<const Key, T> const & x) {
+          return this->insert(::std::pair<Key, T>(x.first, x.second));
+        }
+
+        template <typename V, typename Updater>
+        size_t update(::std::vector<::std::pair<Key, V> > & input, Updater const & op) {
+
+          if (input.size() == 0) return 0;
+
+          size_t count = 0;
+          ::std::vector<::std::pair<Key, V> > one(1);
+          for (auto vv : input) {
+            one[0] = vv;
+            count += subtables[part(vv.first)].update(one, op);
+          }
+
+          return count;
+        }
+
+        // non distributed version
+        template <typename Filter, typename Updater>
+        size_t update(Filter const & fop, Updater const & op) {
+          size_t count = 0;
+          size_t const parts = subtables.size();
+#if defined(USE_OPENMP)
+#pragma omp parallel for schedule(static, 1) reduction(+ : count)
+#endif
+          for (size_t i = 0; i < parts; ++i) {
+            count += subtables[i].update(fop, op);
+          }
+
+          return count;
+        }
+
+
+        template <typename InputIt, typename Pred>
+        size_t erase(InputIt first, InputIt last, Pred const & pred) {
+          static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                        "InputIt value type for erase cannot be converted to key type");
+
+          size_t count = 0;
+          Key k;
+          for (; first != last; ++first) {
+            k = *first;
+            count += subtables[part(k)].erase(&k, &k + 1, pred);
+          }
+          return count;
+        }
+
+        template <typename InputIt>
+        size_t erase(InputIt first, InputIt last) {
+          static_assert(::std::is_convertible<Key, typename ::std::iterator_traits<InputIt>::value_type>::value,
+                        "InputIt value type for erase cannot be converted to key type");
+
+          size_t count = 0;
+          Key k;
+          for (; first != last; ++first) {
+            k = *first;
+            count += subtables[part(k)].erase(&k, &k + 1);
+          }
+          return count;
+        }
+
+        template <typename Pred>
+        size_t erase(Pred const & pred) {
+          size_t count = 0;
+          size_t const parts = subtables.size();
+#if defined(USE_OPENMP)
+#pragma omp parallel for schedule(static, 1) reduction(+ : count)
+#endif
+          for (size_t i = 0; i < parts; ++i) {
+            count += subtables[i].erase(pred);
+          }
+          return count;
+        }
+
+        size_type count(Key const & key) const {
+          return subtables[part(key)].count(key);
+        }
+
+
+        ::std::pair<iterator, iterator> equal_range(Key const & key) {
+          size_t i = part(key);
+          auto range = subtables[i].equal_range(key);
+          if (range.first == range.second) return ::std::make_pair(end(), end());
+          return ::std::make_pair(iterator(this, i, range.first), iterator(this, i, range.second));
+        }
+        ::std::pair<const_iterator, const_iterator> equal_range(Key const & key) const {
+          size_t i = part(key);
+          auto range = subtables[i].equal_range(key);
+          if (range.first == range.second) return ::std::make_pair(cend(), cend());
+          return ::std::make_pair(const_iterator(this, i, range.first), const_iterator(this, i, range.second));
+        }
+
+        iterator find(Key const &key) {
+          size_t i = part(key);
+          auto it = subtables[i].find(key);
+          if (it == subtables[i].end()) return end();
+          return iterator(this, i, it);
+        }
+
+        const_iterator find(Key const &key) const {
+          size_t i = part(key);
+          auto it = subtables[i].find(key);
+          if (it == subtables[i].cend()) return cend();
+          return const_iterator(this, i, it);
+        }
+
+        inline void prefetch(Key const & key) const {
+          subtables[part(key)].prefetch(key);
+        }
+
+        inline bool exists(Key const & key) const {
+          return subtables[part(key)].exists(key);
+        }
+
+    };
+  };
+
+
+}  // namespace fsc
+
+#endif /* SRC_CONTAINERS_THREAD_PARTITIONED_MAP_HPP_ */
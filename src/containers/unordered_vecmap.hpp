@@ -35,6 +35,8 @@
 //#include "ext/pool_allocator.h"
 
 #include "utils/logging.h"
+#include "containers/parallel_for_each.hpp"
+#include "containers/table_stats.hpp"
 
 namespace fsc {  // fast standard container
 
@@ -549,6 +551,16 @@ using allocator = std::allocator<T>;
         map.clear();
       }
 
+      /// call fn(value_type(key, value), thread_id) for each element, with the buckets split into per-thread ranges.  see containers/parallel_for_each.hpp
+      template <typename F>
+      void parallel_for_each(F fn, int const nthreads = 0) const {
+        ::fsc::parallel_for_each(map, [&fn](typename supercontainer_type::value_type const & entry, int const tid) {
+          for (auto it = entry.second.cbegin(); it != entry.second.cend(); ++it) {
+            fn(value_type(entry.first, *it), tid);
+          }
+        }, nthreads);
+      }
+
       /// rehash for new count number of BUCKETS.  iterators are invalidated.  side effect is multiplicity is updated.
       void rehash(size_type count) {
         // only rehash if new bucket count is greater than old bucket count
@@ -557,7 +569,14 @@ using allocator = std::allocator<T>;
       }
 
       /// bucket count.  same as underlying buckets
-      size_type bucket_count() { return map.bucket_count(); }
+      size_type bucket_count() const { return map.bucket_count(); }
+
+      /// chain lengths of the buckets, with 1 entry per key.  O(buckets).  see containers/table_stats.hpp
+      ::fsc::table_stats get_table_stats() const {
+        ::fsc::table_stats stats;
+        ::fsc::collect_chained_table_stats(map, stats);
+        return stats;
+      }
 
       /// max load factor.  this is the map's max load factor (vectors per bucket) x multiplicity = elements per bucket.  side effect is multiplicity is updated.
       float max_load_factor() {
@@ -1293,6 +1312,16 @@ using allocator = std::allocator<T>;
         map.clear();
       }
 
+      /// call fn(const & ::std::pair<Key, T>, thread_id) for each element, with the buckets split into per-thread ranges.  see containers/parallel_for_each.hpp
+      template <typename F>
+      void parallel_for_each(F fn, int const nthreads = 0) const {
+        ::fsc::parallel_for_each(map, [&fn](typename supercontainer_type::value_type const & entry, int const tid) {
+          for (auto it = entry.second.cbegin(); it != entry.second.cend(); ++it) {
+            fn(*it, tid);
+          }
+        }, nthreads);
+      }
+
       /// rehash for new count number of BUCKETS.  iterators are invalidated.  side effect is multiplicity is updated.
       void rehash(size_type count) {
         // only rehash if new bucket count is greater than old bucket count
@@ -1301,7 +1330,14 @@ using allocator = std::allocator<T>;
       }
 
       /// bucket count.  same as underlying buckets
-      size_type bucket_count() { return map.bucket_count(); }
+      size_type bucket_count() const { return map.bucket_count(); }
+
+      /// chain lengths of the buckets, with 1 entry per key.  O(buckets).  see containers/table_stats.hpp
+      ::fsc::table_stats get_table_stats() const {
+        ::fsc::table_stats stats;
+        ::fsc::collect_chained_table_stats(map, stats);
+        return stats;
+      }
 
       /// max load factor.  this is the map's max load factor (vectors per bucket) x multiplicity = elements per bucket.  side effect is multiplicity is updated.
       float max_load_factor() {
@@ -1394,6 +1430,22 @@ using allocator = std::allocator<T>;
           }
       }
 
+      /**
+       * @brief insert entries whose keys are unique and not yet in the map, e.g. a loaded snapshot.
+       * @details the key table is sized once, and each key gets a vector of exactly 1 entry, so there is no rehash
+       *          and no vector growth.  duplicate keys are not detected:  the later ones are dropped, unlike insert.
+       */
+      template <class ForwardIt>
+      void bulk_load(ForwardIt first, ForwardIt last) {
+          size_t n = std::distance(first, last);
+          if (n == 0) return;
+
+          map.reserve(map.size() + n);
+          for (; first != last; ++first) {
+            if (map.emplace(first->first, subcontainer_type(1, *first)).second) ++s;
+          }
+      }
+
 
       template <typename Pred>
       size_t erase(const key_type& key, Pred const & pred) {
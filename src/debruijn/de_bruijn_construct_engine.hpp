@@ -157,7 +157,8 @@ namespace bliss
 		 }
 	 };
 
-	 /*generate de Brujin graph nodes and edges, which each node associated with base quality scores*/
+	 /*generate de Brujin graph nodes and edges, which each node associated with base quality scores.
+	  QualType may be float, double, or a bliss::index::QuantizedQuality, which is computed in double and then quantized.*/
     template <typename KmerType, typename QualType=double, typename EdgeEncoder = bliss::common::DNA16, template<typename> class QualityEncoder = bliss::index::Illumina18QualityScoreCodec>
 	 struct de_bruijn_quality_parser {
 
@@ -193,11 +194,16 @@ namespace bliss
           using EdgeIterType = bliss::de_bruijn::iterator::edge_iterator<CharIter, EdgeEncoder>;
 
           // also remove eol from quality score
+          using ComputeQualType = typename bliss::index::QualityComputeType<QualType>::type;
           using QualIterType =
-              bliss::index::QualityScoreGenerationIterator<bliss::index::kmer::NonEOLIter<typename SeqType::IteratorType>, KmerType::size, QualityEncoder<QualType> >;
+              bliss::index::QualityScoreGenerationIterator<bliss::index::kmer::NonEOLIter<typename SeqType::IteratorType>, KmerType::size, QualityEncoder<ComputeQualType> >;
+          // quantize, if QualType is not the computed type.
+          using StoredQualIterType = typename std::conditional<std::is_same<QualType, ComputeQualType>::value,
+              QualIterType,
+              bliss::iterator::transform_iterator<QualIterType, bliss::index::QualityQuantizer<QualType> > >::type;
 
           // combine kmer iterator and position iterator to create an index iterator type.
-          using KmerInfoIterType = bliss::iterator::ZipIterator<EdgeIterType, QualIterType>;
+          using KmerInfoIterType = bliss::iterator::ZipIterator<EdgeIterType, StoredQualIterType>;
 
           using KmerIndexIterType = bliss::iterator::ZipIterator<KmerIter, KmerInfoIterType>;
 
@@ -223,8 +229,8 @@ namespace bliss
            QualIterType qual_start(CharIter(neol, read.qual_begin, read.qual_end));
             QualIterType qual_end(CharIter(neol, read.qual_end));
 
-            KmerInfoIterType info_start(edge_start, qual_start);
-            KmerInfoIterType info_end(edge_end, qual_end);
+            KmerInfoIterType info_start(edge_start, StoredQualIterType(qual_start));
+            KmerInfoIterType info_end(edge_end, StoredQualIterType(qual_end));
 
 
 
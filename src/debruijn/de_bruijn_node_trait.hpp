@@ -40,6 +40,8 @@
 #include <tuple>        // tuple and utility functions
 #include <utility>      // pair and utility functions.
 #include <type_traits>
+#include <array>
+#include <limits>       // numeric_limits
 
 #include "utils/logging.h"
 #include "common/alphabets.hpp"
@@ -58,6 +60,14 @@ namespace bliss
       class node_utils {
         public:
 
+          /// the neighbor across edge idx, whether or not the edge exists.  idx as in edge_exists::counts:  [out A C G T; in A C G T].
+          static Kmer get_neighbor(Kmer const & kmer, uint8_t idx) {
+            Kmer neighbor(kmer);
+            if (idx < 4) neighbor.nextFromChar(idx);
+            else neighbor.nextReverseFromChar(idx - 4);
+            return neighbor;
+          }
+
           // construct a new kmer from a known edge, if that edge's count is non-zero
           static void get_out_neighbors(Kmer const & kmer, EdgeType const & edge, std::vector<Kmer> & neighbors) {
             neighbors.clear();
@@ -163,6 +173,15 @@ namespace bliss
           void clamped_add_1(C &target, uint8_t flag) {
             if (flag > 0) ++target;
           }
+          // 32 bit and 64 bit do not clamp.
+          template <typename C = COUNT, typename std::enable_if<sizeof(C) < 4, int>::type = 0 >
+          void clamped_add(C &target, C const & value) {
+            target = (value > (std::numeric_limits<C>::max() - target)) ? std::numeric_limits<C>::max() : (target + value);
+          }
+          template <typename C = COUNT, typename std::enable_if<sizeof(C) >= 4, int>::type = 0  >
+          void clamped_add(C &target, C const & value) {
+            target += value;
+          }
 
 
 			  public:
@@ -256,12 +275,28 @@ namespace bliss
           }
 				}
 
+				/**
+				 * @brief add the counts of another node of the same k-mer, e.g. one pre-reduced on another process.
+				 * @details same as applying the updates of both nodes to one.  the counts clamp as in update.
+				 */
+				void merge(edge_counts const & other)
+				{
+				  for (size_t i = 0; i < counts.size(); ++i) {
+				    clamped_add(counts[i], other.counts[i]);
+				  }
+				}
+
 				COUNT get_edge_frequency(uint8_t idx) const {
 				  if (idx >= 8) return 0;
 
 				  return counts[idx];
 				}
 
+				/// remove an edge, e.g. to a node that was removed from the graph.
+				void clear_edge(uint8_t idx) {
+				  if (idx < 8) counts[idx] = 0;
+				}
+
 			};
 
 
@@ -326,15 +361,167 @@ namespace bliss
           counts |= temp;
         }
 
+        /// combine the edges of another node of the same k-mer, e.g. one pre-reduced on another process.
+        void merge(edge_exists const & other)
+        {
+          counts |= other.counts;
+        }
+
         uint8_t get_edge_frequency(uint8_t idx) const {
           if (idx >= 8) return 0;
 
           return (counts >> idx) & 0x1;
         }
 
+        /// remove an edge, e.g. to a node that was removed from the graph.
+        void clear_edge(uint8_t idx) {
+          if (idx < 8) counts &= static_cast<uint8_t>(~(1 << idx));
+        }
+
 
       };
 
+      /**
+       * @brief kmer metadata holding the incoming and outgoing edge counts with BITS bit saturating counters in 1 word.
+       * @details  the 8 counters are packed as lanes, [out A C G T; in A C G T] from the lowest bits, in DNA16 order.
+       *           4 bit counters fit in 32 bits, and 8 bit counters in 64 bits, instead of 9 full integers for edge_counts.
+       *           the k-mer's own count is not kept.  counters saturate at 2^BITS - 1.
+       *           update and merge add all lanes at once, with carries masked out at the lane boundaries (SWAR).
+       */
+      template<typename ALPHA, unsigned int BITS = 4>
+      class packed_edge_counts {
+          static_assert((BITS == 4) || (BITS == 8), "packed edge counts support 4 or 8 bit counters.");
+
+        public:
+          using Alphabet = ALPHA;
+          using CountType = uint8_t;
+          using WordType = typename std::conditional<BITS == 4, uint32_t, uint64_t>::type;
+
+        protected:
+          static constexpr WordType lane_max = (static_cast<WordType>(1) << BITS) - 1;
+          /// 1 in each lane.
+          static constexpr WordType lane_ones = ~static_cast<WordType>(0) / lane_max;
+          /// high bit of each lane.
+          static constexpr WordType lane_high = lane_ones << (BITS - 1);
+
+          /// lane wise saturating add.
+          static WordType saturating_add(WordType const & x, WordType const & y) {
+            // add without the high bits so that no carry crosses a lane, then put the high bits back.
+            WordType low = (x & ~lane_high) + (y & ~lane_high);
+            WordType sum = low ^ ((x ^ y) & lane_high);
+            // carry out of a lane is the majority of the two high bits and the carry into the high bit.
+            WordType carry = ((x & y) | ((x ^ y) & low)) & lane_high;
+            return sum | ((carry >> (BITS - 1)) * lane_max);
+          }
+
+          /// 1 in the lane of each set bit of an 8 bit [in, out] DNA16 flag.
+          static WordType spread(uint8_t flags) {
+            WordType lanes = 0;
+            for (unsigned int i = 0; i < 8; ++i) {
+              lanes |= static_cast<WordType>((flags >> i) & 1) << (i * BITS);
+            }
+            return lanes;
+          }
+
+        public:
+          friend std::ostream& operator<<(std::ostream& ost, const packed_edge_counts<ALPHA, BITS> & node)
+          {
+            // friend keyword signals that this overrides an externally declared function
+            ost << " dBGr node: in = [";
+            for (int i = 4; i < 8; ++i) ost << static_cast<uint32_t>(node.get_edge_frequency(i)) << ",";
+            ost << "], out = [";
+            for (int i = 0; i < 4; ++i) ost << static_cast<uint32_t>(node.get_edge_frequency(i)) << ",";
+            ost << "]";
+            return ost;
+          }
+
+          /// packed counters.  lane i is bits [i * BITS, (i+1) * BITS).
+          WordType counts;
+
+        /*constructor*/
+        packed_edge_counts() : counts(0) {};
+
+        /*destructor.  not virtual, so that we don't have virtual lookup table pointer in the structure as well.*/
+        ~packed_edge_counts() {}
+
+        /**
+         * @brief update the current counts from the input left and right chars, same as edge_counts::update.
+         * @param exts            2 4bits in 1 uchar.  ordered as [out, in], lower bits being out.
+         */
+        void update(uint8_t exts)
+        {
+          uint8_t flags;
+          if (std::is_same<ALPHA, bliss::common::DNA>::value ||
+              std::is_same<ALPHA, bliss::common::RNA>::value) {
+            // value encodes only 1 possible character, 0 1 2 3 for ACGT
+            flags = static_cast<uint8_t>((1 << (exts & 0x3)) | (1 << (((exts >> 4) & 0x3) + 4)));
+          } else if (std::is_same<ALPHA, bliss::common::DNA5>::value ||
+                     std::is_same<ALPHA, bliss::common::RNA5>::value) {
+            // skip the characters marked as unknown.
+            flags = 0;
+            if ((exts & 0x0C) == 0) flags |= static_cast<uint8_t>(1 << (exts & 0x3));
+            if ((exts & 0xC0) == 0) flags |= static_cast<uint8_t>(1 << (((exts >> 4) & 0x3) + 4));
+          } else if (std::is_same<ALPHA, bliss::common::DNA16>::value) {
+            flags = exts;
+          } else {
+            flags = (bliss::common::DNA16::FROM_ASCII[ALPHA::TO_ASCII[exts >> 4]] << 4) | bliss::common::DNA16::FROM_ASCII[ALPHA::TO_ASCII[exts & 0xF]];
+          }
+
+          counts = saturating_add(counts, spread(flags));
+        }
+
+        /**
+         * @brief update the current counts from the input left and right chars (not encoded in exts).
+         * @param exts              2 byte chars, in [out, in] lower byte being out.
+         */
+        void update(uint16_t exts)
+        {
+          uint8_t flags = (bliss::common::DNA16::FROM_ASCII[exts >> 8] << 4) | bliss::common::DNA16::FROM_ASCII[exts & 0xFF];
+          counts = saturating_add(counts, spread(flags));
+        }
+
+        /// add the counts of another node of the same k-mer, all lanes at once.
+        void merge(packed_edge_counts const & other)
+        {
+          counts = saturating_add(counts, other.counts);
+        }
+
+        CountType get_edge_frequency(uint8_t idx) const {
+          if (idx >= 8) return 0;
+
+          return static_cast<CountType>((counts >> (idx * BITS)) & lane_max);
+        }
+
+        /// remove an edge, e.g. to a node that was removed from the graph.
+        void clear_edge(uint8_t idx) {
+          if (idx < 8) counts &= ~(lane_max << (idx * BITS));
+        }
+
+      };
+
+      template<typename ALPHA, unsigned int BITS>
+      constexpr typename packed_edge_counts<ALPHA, BITS>::WordType packed_edge_counts<ALPHA, BITS>::lane_max;
+      template<typename ALPHA, unsigned int BITS>
+      constexpr typename packed_edge_counts<ALPHA, BITS>::WordType packed_edge_counts<ALPHA, BITS>::lane_ones;
+      template<typename ALPHA, unsigned int BITS>
+      constexpr typename packed_edge_counts<ALPHA, BITS>::WordType packed_edge_counts<ALPHA, BITS>::lane_high;
+
+      /**
+       * @brief projection of a (k-mer, node) tuple to (k-mer, edge flags), for queries that need only the graph structure.
+       * @details  bit i is set if edge i has a nonzero count, in the layout of edge_exists::counts.  works for all node types.
+       */
+      struct project_edge_bits {
+          template <typename Key, typename Node>
+          ::std::pair<Key, uint8_t> operator()(::std::pair<Key, Node> const & x) const {
+            uint8_t bits = 0;
+            for (uint8_t i = 0; i < 8; ++i) {
+              if (x.second.get_edge_frequency(i) > 0) bits |= static_cast<uint8_t>(1 << i);
+            }
+            return ::std::make_pair(x.first, bits);
+          }
+      };
+
+
 
 
 //      /*define the strand*/
@@ -0,0 +1,511 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * de_bruijn_nodes_distributed.hpp
+ *
+ *  Created on: Aug 6, 2015
+ *      Author: yongchao
+ */
+
+#ifndef DE_BRUIJN_NODES_DISTRIBUTED_HPP_
+#define DE_BRUIJN_NODES_DISTRIBUTED_HPP_
+
+#include "bliss-config.hpp"
+
+#include <unordered_map>  // local storage hash table  // for multimap
+#include <unordered_set>  // local storage hash table  // for multimap
+#include <utility> 			  // for std::pair
+
+//#include <sparsehash/dense_hash_map>  // not a multimap, where we need it most.
+#include <functional> 		// for std::function and std::hash
+#include <algorithm> 		// for sort, stable_sort, unique, is_sorted
+#include <iterator>  // advance, distance
+
+#include <cstdint>  // for uint8, etc.
+
+#include <type_traits>
+#include "debruijn/de_bruijn_node_trait.hpp"	//node trait data structure storing the linkage information to the node
+#include "debruijn/debruijn_mxx_support.hpp"  // for exchanging combined nodes
+#include "debruijn/unitig_compaction.hpp"
+#include "debruijn/graph_cleaning.hpp"
+#include "debruijn/graph_export.hpp"
+#include "debruijn/succinct_graph.hpp"
+#include "containers/distributed_map_base.hpp"
+#include "containers/distributed_unordered_map.hpp"
+#include "io/incremental_mxx.hpp"
+
+#include "utils/benchmark_utils.hpp"  // for timing.
+#include "utils/logging.h"
+#include "utils/filter_utils.hpp"
+#include "utils/transform_utils.hpp"
+
+
+namespace bliss{
+	namespace de_bruijn{
+
+
+	// NOTE:  DOES NOT work with canonicalized. in other words, input transform should be Identity.
+
+		template<typename Key, typename T,
+			template <typename> class MapParams,
+		class Alloc = ::std::allocator< ::std::pair<const Key, T> >
+		  >
+		  class de_bruijn_nodes_distributed : public ::dsc::unordered_map<Key, T, MapParams, Alloc> {
+			  using Base = ::dsc::unordered_map<Key, T, MapParams, Alloc>;
+
+			public:
+			  using local_container_type = typename Base::local_container_type;
+
+			  // std::unordered_multimap public members.
+			  using key_type              = typename local_container_type::key_type;
+			  using mapped_type           = typename local_container_type::mapped_type;
+			  using value_type            = typename local_container_type::value_type;
+			  using hasher                = typename local_container_type::hasher;
+			  using key_equal             = typename local_container_type::key_equal;
+			  using allocator_type        = typename local_container_type::allocator_type;
+			  using reference             = typename local_container_type::reference;
+			  using const_reference       = typename local_container_type::const_reference;
+			  using pointer               = typename local_container_type::pointer;
+			  using const_pointer         = typename local_container_type::const_pointer;
+			  using iterator              = typename local_container_type::iterator;
+			  using const_iterator        = typename local_container_type::const_iterator;
+			  using size_type             = typename local_container_type::size_type;
+			  using difference_type       = typename local_container_type::difference_type;
+
+			protected:
+
+
+			  /**
+			   * @brief insert new elements in the distributed unordered_multimap.
+			   * @param first
+			   * @param last
+			   */
+			  template <class InputIterator>
+			  size_t local_insert(InputIterator first, InputIterator last) {
+				  
+          if (first == last) return 0;
+          
+          int32_t relative_strand;
+				  size_t before = this->c.size();
+
+          
+
+				  /*reserve space*/
+				  this->local_reserve(before + ::std::distance(first, last));
+
+				  // allocate a node
+          auto node = this->c.find(first->first);
+
+          using EdgeType = decltype(node->second);
+          using Alphabet = typename EdgeType::Alphabet;
+
+				  /*iterate each input tuple*/
+				  for (auto it = first; it != last; ++it) {
+
+				    node = this->c.find(it->first);
+
+				    /*tranform from <key, int> to <node, node_info>*/
+					  if(node == this->c.end()){
+						  /*create a new node*/
+						  auto ret = this->c.emplace(::std::make_pair(it->first, T()));
+						  if(ret.second == false){
+							  cerr << "Insertion failed at line " << __LINE__ << " in file " << __FILE__ << endl;
+							  exit(-1);
+						  }
+
+#if 0
+              ::std::cerr << "Not exist in the hash table" << ::std::endl;
+              ::std::cerr << bliss::utils::KmerUtils::toASCIIString(ret.first->first)  << ::std::endl;
+              ::std::cerr << "0x" << std::hex << it->second << ::std::endl;
+              ::std::cerr << bliss::utils::KmerUtils::toASCIIString(it->first) << ::std::endl << ::std::endl;
+#endif
+						  node = ret.first;  // now use it.
+
+	            // determine if the node in the graph has the same orientation as the one being inserted.
+						  relative_strand = bliss::de_bruijn::node::SENSE;
+					  } else {
+#if 0
+             /*update the node*/
+              ::std::cerr << "Exist in the hash table" << ::std::endl;
+              ::std::cerr << bliss::utils::KmerUtils::toASCIIString(node->first)  << ::std::endl;
+              ::std::cerr << "0x" << std::hex << it->second << ::std::endl;
+              ::std::cerr << bliss::utils::KmerUtils::toASCIIString(it->first) << ::std::endl << ::std::endl;
+#endif
+
+              // determine if the node in the graph has the same orientation as the one being inserted.
+              relative_strand = (node->first == it->first) ? bliss::de_bruijn::node::SENSE : bliss::de_bruijn::node::ANTI_SENSE;
+
+					  }
+
+
+					  // if different, swap and reverse complement the edges.  else, use as is.
+					  if (relative_strand == bliss::de_bruijn::node::ANTI_SENSE) {
+              node->second.update(bliss::de_bruijn::node::input_edge_utils::reverse_complement_edges<Alphabet>(it->second));
+
+					  } else {
+              node->second.update(it->second);
+					  }
+
+				  }
+				  return this->c.size() - before;
+			  }
+
+			  /**
+			   * @brief insert new elements in the distributed unordered_multimap.
+			   * @param first
+			   * @param last
+			   */
+			  template <class InputIterator, class Predicate>
+			  size_t local_insert(InputIterator first, InputIterator last, Predicate const & pred) {
+
+
+          if (first == last) return 0;
+				  int32_t relative_strand;
+				  size_t before = this->c.size();
+
+				  this->local_reserve(before + ::std::distance(first, last));
+				  auto node = this->c.find(first->first);
+
+          using EdgeType = decltype(node->second);
+          using Alphabet = typename EdgeType::Alphabet;
+
+				  for (auto it = first; it != last; ++it) {
+					if (pred(*it)) {
+
+					  node = this->c.find(it->first);
+
+					  /*tranform from <key, int> to <node, node_info*/
+					  if(node == this->c.end()){
+						  /*create a new node*/
+						  auto ret = this->c.emplace(::std::make_pair(it->first, T()));
+						  if(ret.second == false){
+							  cerr << "Insertion failed at line " << __LINE__ << " in file " << __FILE__ << endl;
+							  exit(-1);
+						  }
+
+						  node = ret.first;  // now use it.
+
+						  /*update the node*/
+						  relative_strand = bliss::de_bruijn::node::SENSE;
+					  }else{
+						 /*update the node*/
+						  relative_strand = (node->first == it->first) ? bliss::de_bruijn::node::SENSE : bliss::de_bruijn::node::ANTI_SENSE;
+					  }
+
+            // if different, swap and reverse complement the edges.  else, use as is.
+            if (relative_strand == bliss::de_bruijn::node::ANTI_SENSE) {
+              node->second.update(bliss::de_bruijn::node::input_edge_utils::reverse_complement_edges<Alphabet>(it->second));
+
+            } else {
+              node->second.update(it->second);
+            }
+
+
+					}
+				  }
+				  return this->c.size() - before;
+
+			  }
+
+			  /// pre-reduce the input tuples into 1 node per k-mer before the exchange.
+			  bool combine_input;
+
+			  /**
+			   * @brief combiner.  reduce the (k-mer, edge) tuples into 1 (k-mer, node) per k-mer, in order of first occurrence.
+			   * @details  same as local_insert into an empty table, so high coverage k-mers cross the network once per block.
+			   */
+			  template <typename InputEdgeType, class Predicate>
+			  void local_combine(::std::vector<::std::pair<Key, InputEdgeType> > const & input,
+			                     ::std::vector<::std::pair<Key, T> > & output, Predicate const & pred) const {
+				  output.clear();
+
+				  ::std::unordered_map<Key, size_t, hasher, key_equal> pos;
+				  pos.reserve(input.size());
+
+				  bool filtered = !::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value;
+				  for (auto it = input.begin(); it != input.end(); ++it) {
+					  if (filtered && !pred(*it)) continue;
+
+					  auto ret = pos.emplace(it->first, output.size());
+					  if (ret.second) output.emplace_back(it->first, T());
+					  output[ret.first->second].second.update(it->second);
+				  }
+			  }
+
+			  /// insert pre-reduced nodes, merging with the existing nodes of the same k-mers.
+			  size_t local_merge(::std::vector<::std::pair<Key, T> > const & input) {
+				  size_t before = this->c.size();
+				  this->local_reserve(before + input.size());
+
+				  for (auto it = input.begin(); it != input.end(); ++it) {
+					  auto node = this->c.find(it->first);
+					  if (node == this->c.end()) this->c.emplace(*it);
+					  else node->second.merge(it->second);
+				  }
+				  return this->c.size() - before;
+			  }
+
+			  /// the bits of mask whose neighbors of node are in the local table.
+			  uint8_t local_neighbor_exists(Key const & node, uint8_t const & mask) const {
+				  using NodeUtils = ::bliss::de_bruijn::node::node_utils<Key, T>;
+
+				  uint8_t found = 0;
+				  for (uint8_t i = 0; i < 8; ++i) {
+					  if (((mask >> i) & 1) && (this->c.find(NodeUtils::get_neighbor(node, i)) != this->c.end()))
+						  found |= static_cast<uint8_t>(1 << i);
+				  }
+				  return found;
+			  }
+
+			public:
+			  de_bruijn_nodes_distributed(const mxx::comm& _comm) : Base(_comm), combine_input(true) {/*do nothing*/}
+
+			  virtual ~de_bruijn_nodes_distributed() {/*do nothing*/};
+
+			  /**
+			   * @brief pre-reduce the input tuples per k-mer before distributing them (default).
+			   * @details  the combined nodes are merged with edge_counts::merge or edge_exists::merge on the receiving side, so
+			   *           the result is the same.  only used with more than 1 process.  disable for inputs with few repeated k-mers.
+			   */
+			  void set_combine_input(bool const & combine) {
+				  combine_input = combine;
+			  }
+			  bool get_combine_input() const {
+				  return combine_input;
+			  }
+
+			  /*transform function*/
+
+			  /**
+				* @brief insert new elements in the distributed unordered_multimap.
+				* @param first
+				* @param last
+				*/
+			   template <typename InputEdgeType, typename Predicate = ::bliss::filter::TruePredicate>
+			   size_t insert(std::vector<::std::pair<Key, InputEdgeType> >& input, bool sorted_input = false, Predicate const & pred = Predicate()) {
+				 // even if count is 0, still need to participate in mpi calls.  if (input.size() == 0) return;
+				 BL_BENCH_INIT(insert);
+
+//				 BL_BENCH_START(insert);
+//				 this->transform_input(input);
+//				 BL_BENCH_END(insert, "start", input.size());
+				 static_assert(std::is_same<typename Base::Base::Base::InputTransform, ::bliss::transform::identity<Key>>::value,
+						 "de bruijn graph does not support transform of input Kmers. (e.g. canonicalizing).  Hash can use transformed values, though.");
+
+
+				 // combine, then exchange the nodes.  the predicate is applied by the combiner.
+				 if ((this->comm.size() > 1) && combine_input) {
+				   BL_BENCH_START(insert);
+				   ::std::vector<::std::pair<Key, T> > nodes;
+				   this->local_combine(input, nodes, pred);
+				   BL_BENCH_END(insert, "combine", nodes.size());
+
+				   BL_BENCH_COLLECTIVE_START(insert, "distribute", this->comm);
+				   bool sorted_nodes = false;
+				   ::std::vector<size_t> recv_counts =
+						   ::dsc::distribute(nodes, this->key_to_rank, sorted_nodes, this->comm);
+				   BLISS_UNUSED(recv_counts);
+				   BL_BENCH_END(insert, "distribute", nodes.size());
+
+				   BL_BENCH_START(insert);
+				   size_t count = this->local_merge(nodes);
+				   BL_BENCH_END(insert, "merge", this->c.size());
+
+				   BL_BENCH_REPORT_MPI(insert, this->comm.rank(), this->comm);
+
+				   return count;
+				 }
+
+				 // communication part
+				 if (this->comm.size() > 1) {
+					 BL_BENCH_COLLECTIVE_START(insert, "distribute", this->comm);
+				   ::std::vector<size_t> recv_counts =
+						   ::dsc::distribute(input, this->key_to_rank, sorted_input, this->comm);
+				   BLISS_UNUSED(recv_counts);
+				   BL_BENCH_END(insert, "distribute", input.size());
+
+				 }
+
+				 BL_BENCH_START(insert);
+				 // local compute part.  called by the communicator.
+				 size_t count = 0;
+				 if (!::std::is_same<Predicate, ::bliss::filter::TruePredicate>::value)
+				   count = this->local_insert(input.begin(), input.end(), pred);
+				 else
+				   count = this->local_insert(input.begin(), input.end());
+				 BL_BENCH_END(insert, "insert", this->c.size());
+
+				 BL_BENCH_REPORT_MPI(insert, this->comm.rank(), this->comm);
+
+				 return count;
+			   }
+
+			   /**
+			    * @brief which of the up to 8 neighbors of each node are in the graph.  collective.
+			    * @details  result i has bit j set if node_utils::get_neighbor(nodes[i], j) is stored, in the layout of
+			    *           edge_exists::counts.  the nodes need not be in the graph.  each node is sent once to each distinct
+			    *           owner of its neighbors, with the mask of the neighbors on that owner, and the owner replies with the
+			    *           mask of those it has.  so each request is 1 k-mer and 1 byte instead of 1 k-mer per neighbor for find,
+			    *           and with a key_to_rank that keeps neighbors together, there is 1 request per node.
+			    */
+			   ::std::vector<uint8_t> neighbor_exists(::std::vector<Key> const & nodes) const {
+				 using NodeUtils = ::bliss::de_bruijn::node::node_utils<Key, T>;
+				 using request_type = ::std::pair<Key, uint8_t>;
+
+				 BL_BENCH_INIT(neighbor);
+
+				 ::std::vector<uint8_t> results(nodes.size(), 0);
+				 if (this->comm.size() == 1) {
+				   BL_BENCH_START(neighbor);
+				   for (size_t i = 0; i < nodes.size(); ++i) results[i] = this->local_neighbor_exists(nodes[i], 0xFF);
+				   BL_BENCH_END(neighbor, "local_lookup", results.size());
+
+				   BL_BENCH_REPORT_MPI_NAMED(neighbor, "debruijn:neighbor_exists", this->comm);
+				   return results;
+				 }
+
+				 // group the neighbors of each node by owner.
+				 BL_BENCH_START(neighbor);
+				 ::std::vector<request_type> requests;
+				 ::std::vector<size_t> request_node;
+				 requests.reserve(nodes.size() * 2);
+				 request_node.reserve(nodes.size() * 2);
+				 int owners[8];
+				 for (size_t i = 0; i < nodes.size(); ++i) {
+				   for (uint8_t j = 0; j < 8; ++j) owners[j] = this->key_to_rank(NodeUtils::get_neighbor(nodes[i], j));
+
+				   uint8_t grouped = 0;
+				   for (uint8_t j = 0; j < 8; ++j) {
+					 if ((grouped >> j) & 1) continue;
+					 uint8_t mask = 0;
+					 for (uint8_t l = j; l < 8; ++l) {
+					   if (owners[l] == owners[j]) mask |= static_cast<uint8_t>(1 << l);
+					 }
+					 grouped |= mask;
+					 requests.emplace_back(nodes[i], mask);
+					 request_node.push_back(i);
+				   }
+				 }
+				 BL_BENCH_END(neighbor, "group", requests.size());
+
+				 // the owner of a request is the owner of its first neighbor.
+				 auto request_to_rank = [this](request_type const & x) {
+				   uint8_t j = 0;
+				   while (((x.second >> j) & 1) == 0) ++j;
+				   return this->key_to_rank(NodeUtils::get_neighbor(x.first, j));
+				 };
+
+				 BL_BENCH_COLLECTIVE_START(neighbor, "distribute", this->comm);
+				 ::std::vector<size_t> recv_counts;
+				 ::std::vector<size_t> i2o;
+				 ::std::vector<request_type> received;
+				 ::imxx::distribute(requests, request_to_rank, recv_counts, i2o, received, this->comm);
+				 BL_BENCH_END(neighbor, "distribute", received.size());
+
+				 // distribute returns early, with no counts, only if there are no nodes on any rank.
+				 if (recv_counts.empty()) {
+				   BL_BENCH_REPORT_MPI_NAMED(neighbor, "debruijn:neighbor_exists", this->comm);
+				   return results;
+				 }
+
+				 BL_BENCH_START(neighbor);
+				 ::std::vector<uint8_t> replies(received.size());
+				 for (size_t i = 0; i < received.size(); ++i) replies[i] = this->local_neighbor_exists(received[i].first, received[i].second);
+				 BL_BENCH_END(neighbor, "local_lookup", replies.size());
+
+				 BL_BENCH_COLLECTIVE_START(neighbor, "undistribute", this->comm);
+				 ::std::vector<uint8_t> found;
+				 ::imxx::undistribute(replies, recv_counts, i2o, found, this->comm, true);
+				 for (size_t i = 0; i < found.size(); ++i) results[request_node[i]] |= found[i];
+				 BL_BENCH_END(neighbor, "undistribute", results.size());
+
+				 BL_BENCH_REPORT_MPI_NAMED(neighbor, "debruijn:neighbor_exists", this->comm);
+				 return results;
+			   }
+
+			   /**
+			    * @brief compact the non-branching paths into unitigs.  collective.  see unitig_compactor.
+			    * @return the unitigs whose first k-mer is stored on this process.
+			    */
+			   ::std::vector<::std::string> compact_unitigs() const {
+			     ::bliss::de_bruijn::unitig_compactor<Key, decltype(this->key_to_rank)> compactor(this->key_to_rank, this->comm);
+			     return compactor(this->c);
+			   }
+
+			   /**
+			    * @brief build a read only succinct copy of the graph, about 11 bits per node.  collective.  see succinct_graph.
+			    * @details  the copy refers to this map's communicator and key_to_rank, so it should not outlive the map.  the map can be cleared.
+			    */
+			   ::bliss::de_bruijn::succinct_graph<Key, decltype(this->key_to_rank)> to_succinct() const {
+			     ::bliss::de_bruijn::succinct_graph<Key, decltype(this->key_to_rank)> graph(this->key_to_rank, this->comm);
+			     graph.build(this->c);
+			     return graph;
+			   }
+
+			   /**
+			    * @brief write the unitigs and their links to 1 shared GFA 1.0 file.  collective.  see graph_exporter.
+			    * @return the global number of unitigs.
+			    */
+			   size_t write_gfa(::std::string const & filename) const {
+			     ::bliss::de_bruijn::graph_exporter<Key, decltype(this->key_to_rank)> exporter(this->key_to_rank, this->comm);
+			     return exporter.write_gfa(this->c, filename);
+			   }
+
+			   /**
+			    * @brief write the nodes of all processes to 1 shared binary file.  collective.  see graph_exporter.
+			    * @return the global number of nodes.
+			    */
+			   size_t write_binary(::std::string const & filename) const {
+			     ::bliss::de_bruijn::graph_exporter<Key, decltype(this->key_to_rank)> exporter(this->key_to_rank, this->comm);
+			     return exporter.write_binary(this->c, filename);
+			   }
+
+			   /**
+			    * @brief remove the edges seen fewer than min_count times.  collective.  see graph_cleaner.
+			    * @return the global number of edges removed, counting both ends.
+			    */
+			   size_t prune_edges(typename T::CountType const & min_count) {
+			     ::bliss::de_bruijn::graph_cleaner<Key, decltype(this->key_to_rank)> cleaner(this->key_to_rank, this->comm);
+			     return cleaner.prune_edges(this->c, min_count);
+			   }
+
+			   /**
+			    * @brief remove the tips shorter than max_len k-mers, repeating while new tips appear.  collective.  see graph_cleaner.
+			    * @return the global number of nodes removed.
+			    */
+			   size_t clip_tips(size_t const & max_len, size_t const & max_iterations = 8) {
+			     ::bliss::de_bruijn::graph_cleaner<Key, decltype(this->key_to_rank)> cleaner(this->key_to_rank, this->comm);
+			     size_t removed = cleaner.clip_tips(this->c, max_len, max_iterations);
+			     if (removed > 0) this->local_changed = true;
+			     return removed;
+			   }
+
+			   /**
+			    * @brief remove all but the best covered path of each bubble with paths of at most max_len k-mers.  collective.  see graph_cleaner.
+			    * @return the global number of paths removed.
+			    */
+			   size_t pop_bubbles(size_t const & max_len) {
+			     ::bliss::de_bruijn::graph_cleaner<Key, decltype(this->key_to_rank)> cleaner(this->key_to_rank, this->comm);
+			     size_t removed = cleaner.pop_bubbles(this->c, max_len);
+			     if (removed > 0) this->local_changed = true;
+			     return removed;
+			   }
+		};
+	}/*de_bruijn*/
+}/*bliss*/
+
+#endif /* DE_BRUIJN_NODES_DISTRIBUTED_HPP_ */
@@ -95,6 +95,38 @@ namespace mxx {
         return baseType::num_basic_elements();
       }
     };
+
+
+  template<typename A, unsigned int BITS>
+    struct datatype_builder<bliss::de_bruijn::node::packed_edge_counts<A, BITS> > :
+    public datatype_builder<decltype(bliss::de_bruijn::node::packed_edge_counts<A, BITS>::counts) > {
+
+      typedef datatype_builder<decltype(bliss::de_bruijn::node::packed_edge_counts<A, BITS>::counts) > baseType;
+
+      static MPI_Datatype get_type(){
+        return baseType::get_type();
+      }
+
+      static size_t num_basic_elements() {
+        return baseType::num_basic_elements();
+      }
+    };
+
+
+  template<typename A, unsigned int BITS>
+    struct datatype_builder<const bliss::de_bruijn::node::packed_edge_counts<A, BITS> > :
+    public datatype_builder<decltype(bliss::de_bruijn::node::packed_edge_counts<A, BITS>::counts) > {
+
+      typedef datatype_builder<decltype(bliss::de_bruijn::node::packed_edge_counts<A, BITS>::counts) > baseType;
+
+      static MPI_Datatype get_type(){
+        return baseType::get_type();
+      }
+
+      static size_t num_basic_elements() {
+        return baseType::num_basic_elements();
+      }
+    };
 }  // namespace mxx
 
 
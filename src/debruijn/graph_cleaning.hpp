@@ -0,0 +1,258 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    graph_cleaning.hpp
+ * @ingroup debruijn
+ * @brief   distributed de Bruijn graph cleaning:  low coverage edge pruning, tip clipping, and bubble popping.
+ * @details all passes are bulk operations over the local nodes.  the chains (unitigs) are found with unitig_compactor's
+ *          pointer jumping, and gathered with their nodes' edges on the owners of their heads.  the neighbors outside a chain
+ *          are generated from the edges with node_utils.  removals are then applied with 1 exchange of the nodes to erase
+ *          and 1 of the edges to clear at the neighbors, so the graph stays consistent.
+ *
+ *          a tip is a chain shorter than max_len k-mers with a dead end on exactly 1 side.
+ *          a bubble is a set of chains of at most max_len k-mers that all start after the same node and end before the same node.
+ *          all but the one with the highest mean edge coverage are removed.
+ */
+#ifndef SRC_DEBRUIJN_GRAPH_CLEANING_HPP_
+#define SRC_DEBRUIJN_GRAPH_CLEANING_HPP_
+
+#include <vector>
+#include <utility>    // pair
+#include <algorithm>  // sort, binary_search
+#include <cstdint>    // uint64_t
+
+#include <mxx/reduction.hpp>
+
+#include "debruijn/de_bruijn_node_trait.hpp"
+#include "debruijn/debruijn_mxx_support.hpp"
+#include "debruijn/unitig_compaction.hpp"
+
+namespace bliss {
+  namespace de_bruijn {
+
+    /**
+     * @brief graph cleaning passes over the local nodes of a distributed de Bruijn graph.  all passes are collective.
+     * @tparam Kmer    node type.
+     * @tparam ToRank  maps a node to the rank that stores it.  same as the node map's key_to_rank.
+     */
+    template <typename Kmer, typename ToRank>
+    class graph_cleaner : public unitig_compactor<Kmer, ToRank> {
+
+      protected:
+        using Base = unitig_compactor<Kmer, ToRank>;
+
+        template <typename V>
+        using chain_piece = typename Base::template chain_piece<V>;
+
+        /// an edge to remove:  (node, edge index).  index is [out A C G T; in A C G T].
+        using edge_ref = ::std::pair<Kmer, uint8_t>;
+
+        /// chain with a single node before and after it, sent to the owner of the node before:  ((before, after), (head, (length, coverage)))
+        using bubble_path = ::std::pair<::std::pair<Kmer, Kmer>, ::std::pair<Kmer, ::std::pair<uint64_t, uint64_t> > >;
+
+        static constexpr size_t char_mask = (1UL << Kmer::bitsPerChar) - 1;
+
+        /// the character appended by the edge into this node.
+        static uint8_t last_char(Kmer const & k) {
+          return static_cast<uint8_t>(k.getData()[0] & char_mask);
+        }
+        /// the character dropped by the edge out of this node.
+        static uint8_t first_char(Kmer const & k) {
+          Kmer c(k);
+          c >>= (Kmer::size - 1);
+          return static_cast<uint8_t>(c.getData()[0] & char_mask);
+        }
+
+        /// erase the nodes of the chain [first, last), and the edges into it from the nodes before and after it.
+        template <typename Iter>
+        static void remove_chain(Iter first, Iter last, ::std::vector<Kmer> & erase, ::std::vector<edge_ref> & clear) {
+          using EdgeType = typename ::std::iterator_traits<Iter>::value_type::second_type::second_type::second_type;
+          using NodeUtils = ::bliss::de_bruijn::node::node_utils<Kmer, EdgeType>;
+
+          for (Iter it = first; it != last; ++it) erase.push_back(it->second.second.first);
+
+          ::std::vector<Kmer> neighbors;
+          Kmer const & head = first->second.second.first;
+          NodeUtils::get_in_neighbors(head, first->second.second.second, neighbors);
+          for (auto const & p : neighbors) clear.emplace_back(p, last_char(head));
+
+          Iter tail = last - 1;
+          NodeUtils::get_out_neighbors(tail->second.second.first, tail->second.second.second, neighbors);
+          for (auto const & s : neighbors) clear.emplace_back(s, 4 + first_char(tail->second.second.first));
+        }
+
+        /// apply the removals on the owners of the nodes.  @return the number of local nodes erased.
+        template <typename LocalMap>
+        size_t apply(LocalMap & map, ::std::vector<Kmer> & erase, ::std::vector<edge_ref> & clear) const {
+          this->exchange(erase, this->to_rank);
+          this->exchange(clear, [this](edge_ref const & x){ return this->to_rank(x.first); });
+
+          size_t removed = 0;
+          for (auto const & k : erase) removed += map.erase(k);
+          for (auto const & e : clear) {
+            auto it = map.find(e.first);
+            if (it != map.end()) it->second.clear_edge(e.second);
+          }
+          return removed;
+        }
+
+      public:
+        graph_cleaner(ToRank const & _to_rank, const mxx::comm & _comm) : Base(_to_rank, _comm) {}
+
+        /**
+         * @brief remove the edges seen fewer than min_count times.  local, since both ends of an edge count it.
+         * @note  edge_exists frequencies are 0 or 1, so any min_count above 1 removes all its edges.
+         * @return the global number of edges removed, counting each end.
+         */
+        template <typename LocalMap>
+        size_t prune_edges(LocalMap & map, typename LocalMap::mapped_type::CountType const & min_count) const {
+          size_t pruned = 0;
+          for (auto it = map.begin(); it != map.end(); ++it) {
+            for (uint8_t i = 0; i < 8; ++i) {
+              auto f = it->second.get_edge_frequency(i);
+              if ((f > 0) && (f < min_count)) {
+                it->second.clear_edge(i);
+                ++pruned;
+              }
+            }
+          }
+          return ::mxx::allreduce(pruned, this->comm);
+        }
+
+        /**
+         * @brief remove the tips shorter than max_len k-mers, until none are left or max_iterations.
+         * @details  removing a tip can make its branch node non-branching and expose a new tip, so each iteration
+         *           ranks the chains again.
+         * @return the global number of nodes removed.
+         */
+        template <typename LocalMap>
+        size_t clip_tips(LocalMap & map, size_t const & max_len, size_t const & max_iterations = 8) {
+          using EdgeType = typename LocalMap::mapped_type;
+          using NodeUtils = ::bliss::de_bruijn::node::node_utils<Kmer, EdgeType>;
+
+          ::std::vector<chain_piece<::std::pair<Kmer, EdgeType> > > pieces;
+          ::std::vector<Kmer> erase;
+          ::std::vector<edge_ref> clear;
+          ::std::vector<Kmer> in, out;
+
+          size_t total = 0;
+          for (size_t iter = 0; iter < max_iterations; ++iter) {
+            this->gather_chains(map, pieces);
+
+            erase.clear();
+            clear.clear();
+            for (size_t i = 0; i < pieces.size(); ) {
+              size_t j = i + 1;
+              while ((j < pieces.size()) && (pieces[j].first == pieces[i].first)) ++j;
+
+              if ((j - i) < max_len) {
+                NodeUtils::get_in_neighbors(pieces[i].second.second.first, pieces[i].second.second.second, in);
+                NodeUtils::get_out_neighbors(pieces[j - 1].second.second.first, pieces[j - 1].second.second.second, out);
+                // attached on 1 side only.  isolated chains are kept.
+                if (in.empty() != out.empty()) remove_chain(pieces.begin() + i, pieces.begin() + j, erase, clear);
+              }
+              i = j;
+            }
+
+            size_t removed = ::mxx::allreduce(this->apply(map, erase, clear), this->comm);
+            total += removed;
+            if (removed == 0) break;
+          }
+          return total;
+        }
+
+        /**
+         * @brief remove the weaker paths of the bubbles whose paths are at most max_len k-mers.
+         * @return the global number of paths removed.
+         */
+        template <typename LocalMap>
+        size_t pop_bubbles(LocalMap & map, size_t const & max_len) {
+          using EdgeType = typename LocalMap::mapped_type;
+          using NodeUtils = ::bliss::de_bruijn::node::node_utils<Kmer, EdgeType>;
+
+          ::std::vector<chain_piece<::std::pair<Kmer, EdgeType> > > pieces;
+          this->gather_chains(map, pieces);
+
+          // candidate paths:  a single node before and a single node after.
+          ::std::vector<bubble_path> paths;
+          ::std::vector<Kmer> in, out;
+          for (size_t i = 0; i < pieces.size(); ) {
+            size_t j = i + 1;
+            while ((j < pieces.size()) && (pieces[j].first == pieces[i].first)) ++j;
+
+            if ((j - i) <= max_len) {
+              NodeUtils::get_in_neighbors(pieces[i].second.second.first, pieces[i].second.second.second, in);
+              NodeUtils::get_out_neighbors(pieces[j - 1].second.second.first, pieces[j - 1].second.second.second, out);
+              if ((in.size() == 1) && (out.size() == 1)) {
+                uint64_t coverage = 0;
+                for (size_t k = i; k < j; ++k) {
+                  for (uint8_t e = 0; e < 4; ++e) coverage += pieces[k].second.second.second.get_edge_frequency(e);
+                }
+                paths.emplace_back(::std::make_pair(in.front(), out.front()),
+                                   ::std::make_pair(pieces[i].first, ::std::make_pair(static_cast<uint64_t>(j - i), coverage)));
+              }
+            }
+            i = j;
+          }
+
+          // group by the end nodes on the owner of the node before, highest mean coverage first.
+          this->exchange(paths, [this](bubble_path const & x){ return this->to_rank(x.first.first); });
+          ::std::sort(paths.begin(), paths.end(), [](bubble_path const & x, bubble_path const & y){
+            if (!(x.first.first == y.first.first)) return x.first.first < y.first.first;
+            if (!(x.first.second == y.first.second)) return x.first.second < y.first.second;
+            // x.coverage / x.length > y.coverage / y.length
+            uint64_t xc = x.second.second.second * y.second.second.first;
+            uint64_t yc = y.second.second.second * x.second.second.first;
+            if (xc != yc) return xc > yc;
+            return x.second.first < y.second.first;
+          });
+
+          ::std::vector<Kmer> popped;
+          for (size_t i = 0; i < paths.size(); ) {
+            size_t j = i + 1;
+            for (; (j < paths.size()) && (paths[j].first == paths[i].first); ++j) popped.push_back(paths[j].second.first);
+            i = j;
+          }
+          size_t count = ::mxx::allreduce(popped.size(), this->comm);
+          if (count == 0) return 0;
+
+          // back to the owners of the heads, which have the chains.
+          this->exchange(popped, this->to_rank);
+          ::std::sort(popped.begin(), popped.end());
+
+          ::std::vector<Kmer> erase;
+          ::std::vector<edge_ref> clear;
+          for (size_t i = 0; i < pieces.size(); ) {
+            size_t j = i + 1;
+            while ((j < pieces.size()) && (pieces[j].first == pieces[i].first)) ++j;
+            if (::std::binary_search(popped.begin(), popped.end(), pieces[i].first))
+              remove_chain(pieces.begin() + i, pieces.begin() + j, erase, clear);
+            i = j;
+          }
+          this->apply(map, erase, clear);
+
+          return count;
+        }
+    };
+
+    template <typename Kmer, typename ToRank>
+    constexpr size_t graph_cleaner<Kmer, ToRank>::char_mask;
+
+  } /* namespace de_bruijn */
+} /* namespace bliss */
+
+#endif /* SRC_DEBRUIJN_GRAPH_CLEANING_HPP_ */
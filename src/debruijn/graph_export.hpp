@@ -0,0 +1,167 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    graph_export.hpp
+ * @ingroup debruijn
+ * @brief   parallel export of a distributed de Bruijn graph to 1 shared file, as GFA or as binary nodes.
+ * @details every rank formats its own part and writes it with mpiio_writer at the exclusive prefix sum of the byte
+ *          counts, so nothing is funneled through 1 rank.
+ *
+ *          GFA 1.0:  1 S line per unitig, and 1 L line per edge between unitigs, with a k-1 overlap.  the unitigs are
+ *          numbered from 1 in rank order of the owners of their heads.  the tail of a unitig only links to heads, so each
+ *          link is sent to the owner of the head it ends in, which knows the id.
+ *
+ *          binary:  a map_file_header from rank 0, then the (k-mer, edges) entries of all ranks.  comm_rank in the
+ *          header is -1, and count is the total, so the file can be read back with mapped_map_file and validate(p, -1).
+ */
+#ifndef SRC_DEBRUIJN_GRAPH_EXPORT_HPP_
+#define SRC_DEBRUIJN_GRAPH_EXPORT_HPP_
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <utility>    // pair
+#include <algorithm>  // sort, lower_bound
+#include <cstdint>    // uint64_t
+
+#include <mxx/comm.hpp>
+#include <mxx/reduction.hpp>
+
+#include "io/mpiio_writer.hpp"
+#include "containers/distributed_map_io.hpp"
+#include "utils/kmer_utils.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+#include "debruijn/unitig_compaction.hpp"
+
+namespace bliss {
+  namespace de_bruijn {
+
+    /**
+     * @brief writes the local nodes of a distributed de Bruijn graph to 1 shared file.  collective.
+     * @tparam Kmer    node type.
+     * @tparam ToRank  maps a node to the rank that stores it.  same as the node map's key_to_rank.
+     */
+    template <typename Kmer, typename ToRank>
+    class graph_exporter : public unitig_compactor<Kmer, ToRank> {
+
+      protected:
+        using Base = unitig_compactor<Kmer, ToRank>;
+
+        template <typename V>
+        using chain_piece = typename Base::template chain_piece<V>;
+
+        /// a unitig link, sent to the owner of the head it ends in:  (head, id of the unitig it starts from)
+        using gfa_link = ::std::pair<Kmer, uint64_t>;
+
+        static constexpr size_t char_mask = (1UL << Kmer::bitsPerChar) - 1;
+
+      public:
+        graph_exporter(ToRank const & _to_rank, const mxx::comm & _comm) : Base(_to_rank, _comm) {}
+
+        /**
+         * @brief write the unitigs and the links between them as GFA 1.0.
+         * @return the global number of unitigs.
+         */
+        template <typename LocalMap>
+        size_t write_gfa(LocalMap const & map, ::std::string const & filename) {
+          using EdgeType = typename LocalMap::mapped_type;
+          using NodeUtils = ::bliss::de_bruijn::node::node_utils<Kmer, EdgeType>;
+
+          ::std::vector<chain_piece<::std::pair<Kmer, EdgeType> > > pieces;
+          this->gather_chains(map, pieces);
+
+          // (head, id) of the local unitigs, in head order.
+          ::std::vector<gfa_link> heads;
+          for (size_t i = 0; i < pieces.size(); ++i) {
+            if ((i == 0) || !(pieces[i].first == pieces[i - 1].first)) heads.emplace_back(pieces[i].first, 0);
+          }
+          uint64_t first_id = ::mxx::exscan(static_cast<uint64_t>(heads.size()),
+                                            [](uint64_t const & x, uint64_t const & y) { return x + y; }, this->comm);
+          if (this->comm.rank() == 0) first_id = 0;
+          ++first_id;
+          for (size_t i = 0; i < heads.size(); ++i) heads[i].second = first_id + i;
+
+          // segments, and the links out of each tail.
+          ::std::stringstream ss;
+          if (this->comm.rank() == 0) ss << "H\tVN:Z:1.0\n";
+
+          ::std::vector<gfa_link> links;
+          ::std::vector<Kmer> neighbors;
+          size_t id = 0;
+          for (size_t i = 0; i < pieces.size(); ++id) {
+            ss << "S\t" << heads[id].second << "\t" << ::bliss::utils::KmerUtils::toASCIIString(pieces[i].second.second.first);
+            size_t j = i + 1;
+            for (; (j < pieces.size()) && (pieces[j].first == pieces[i].first); ++j) {
+              ss << Kmer::KmerAlphabet::TO_ASCII[static_cast<size_t>(pieces[j].second.second.first.getData()[0] & char_mask)];
+            }
+            ss << "\n";
+
+            NodeUtils::get_out_neighbors(pieces[j - 1].second.second.first, pieces[j - 1].second.second.second, neighbors);
+            for (auto const & s : neighbors) links.emplace_back(s, heads[id].second);
+            i = j;
+          }
+          ::std::vector<chain_piece<::std::pair<Kmer, EdgeType> > >().swap(pieces);
+
+          ::bliss::io::parallel::mpiio_writer out(filename, this->comm);
+          out.write(ss.str());
+
+          // links, on the owners of their target heads.
+          this->exchange(links, [this](gfa_link const & x){ return this->to_rank(x.first); });
+          ss.str(::std::string());
+          for (auto const & l : links) {
+            auto it = ::std::lower_bound(heads.begin(), heads.end(), l, [](gfa_link const & x, gfa_link const & y){
+              return x.first < y.first;
+            });
+            // edges to nodes that are not stored, e.g. after a partial erase, are dropped.
+            if ((it == heads.end()) || !(it->first == l.first)) continue;
+            ss << "L\t" << l.second << "\t+\t" << it->second << "\t+\t" << (Kmer::size - 1) << "M\n";
+          }
+          out.write(ss.str());
+          out.close();
+
+          return ::mxx::allreduce(heads.size(), this->comm);
+        }
+
+        /**
+         * @brief write a map_file_header and the local (k-mer, edges) entries of all ranks, in rank order.
+         * @return the global number of entries.
+         */
+        template <typename LocalMap>
+        size_t write_binary(LocalMap const & map, ::std::string const & filename) const {
+          using EdgeType = typename LocalMap::mapped_type;
+
+          ::std::vector<::std::pair<Kmer, EdgeType> > entries(map.begin(), map.end());
+          size_t count = ::mxx::allreduce(entries.size(), this->comm);
+
+          ::dsc::map_file_header h = ::dsc::make_map_file_header<Kmer, EdgeType>(this->comm.size(), -1, count);
+
+          ::bliss::io::parallel::mpiio_writer out(filename, this->comm);
+          out.write(reinterpret_cast<char const *>(&h), (this->comm.rank() == 0) ? sizeof(::dsc::map_file_header) : 0);
+          out.write(entries);
+          out.close();
+
+          return count;
+        }
+    };
+
+    template <typename Kmer, typename ToRank>
+    constexpr size_t graph_exporter<Kmer, ToRank>::char_mask;
+
+  } /* namespace de_bruijn */
+} /* namespace bliss */
+
+#endif /* SRC_DEBRUIJN_GRAPH_EXPORT_HPP_ */
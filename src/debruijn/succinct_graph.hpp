@@ -0,0 +1,666 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    succinct_graph.hpp
+ * @ingroup debruijn
+ * @brief   read only, distributed BOSS style succinct de Bruijn graph, for graphs that are built once and then traversed.
+ * @details the node map keeps a full k-mer and an edge count record per node in a hash table, well over 100 bits per node.
+ *          this keeps about 11 bits per node, after Bowe, Onodera, Sadakane and Shibuya (2012):  the nodes are sorted in
+ *          colexicographic order, i.e. by their labels read backward, and each node keeps only
+ *            - 4 out edge flags,
+ *            - 4 "first" flags:  edge u -c-> is first if no node before u with the same last k-1 characters has an out
+ *              edge c.  the first c edges, in node order, enter the nodes that end in c, in node order.
+ *            - a flag for the first node of each such group of nodes, and a flag for the dummy nodes below.
+ *          the first flags have rank and select support.  the node labels are not stored:  the target of u -c-> is the
+ *          j-th node ending in c, where j is the rank of u's first c edge, and backward, the first predecessor of the
+ *          j-th node ending in c is the node with the j-th first c edge.  a label is read off k nodes of a backward walk,
+ *          and a k-mer is found by k forward range steps from the nodes ending in its first character.  every node but the
+ *          root needs an in edge for these bijections, so a node without one gets dummy predecessors $^d v[0, k-d),
+ *          1 <= d <= k, shared between nodes.  a fragmented graph has more dummies, up to k per source node.
+ *
+ *          the nodes are partitioned over the processes in colex order, a contiguous range of global node ids per
+ *          process, with the groups not split.  a step on a node id goes to the process that has it, so a batch of steps
+ *          is 1 all-to-all round, and a k-mer or label query is k - 1 rounds for the whole batch.  all queries are
+ *          collective.  edges to k-mers that are not in the map are dropped on construction.
+ *
+ *          the nodes are used as stored, as in unitig_compactor:  1 node per strand k-mer.
+ */
+#ifndef SRC_DEBRUIJN_SUCCINCT_GRAPH_HPP_
+#define SRC_DEBRUIJN_SUCCINCT_GRAPH_HPP_
+
+#include <vector>
+#include <array>
+#include <utility>    // pair
+#include <algorithm>  // sort, lower_bound, upper_bound, max
+#include <limits>
+#include <cstdint>    // uint64_t
+
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+#include <mxx/sort.hpp>
+
+#include "io/mxx_support.hpp"
+#include "io/incremental_mxx.hpp"
+
+namespace bliss {
+  namespace de_bruijn {
+
+    /**
+     * @brief read only bit array with rank and select.
+     * @details  lines of 7 data words, each followed by the number of set bits before the line, so a rank reads 1 cache line.
+     */
+    class rank_select_bits {
+      protected:
+        static constexpr size_t words_per_line = 7;
+        static constexpr size_t bits_per_line = words_per_line * 64;
+
+        ::std::vector<uint64_t> lines;
+        size_t n;
+        size_t ones;
+
+        static inline unsigned int popcount(uint64_t const x) {
+          return __builtin_popcountll(x);
+        }
+
+      public:
+        rank_select_bits() : n(0), ones(0) {}
+
+        /// build from n bits, bit i at bit (i % 64) of words[i / 64].
+        void build(::std::vector<uint64_t> const & words, size_t const bits) {
+          n = bits;
+          // 1 line more than needed for rank(n).
+          size_t const nlines = bits / bits_per_line + 1;
+          lines.assign(nlines * 8, 0);
+          ones = 0;
+          for (size_t l = 0; l < nlines; ++l) {
+            lines[l * 8 + words_per_line] = ones;
+            for (size_t w = 0; w < words_per_line; ++w) {
+              size_t const i = l * words_per_line + w;
+              if (i >= words.size()) break;
+              lines[l * 8 + w] = words[i];
+              ones += popcount(words[i]);
+            }
+          }
+        }
+
+        size_t size() const {
+          return n;
+        }
+
+        /// number of set bits.
+        size_t count() const {
+          return ones;
+        }
+
+        size_t bytes() const {
+          return lines.capacity() * sizeof(uint64_t);
+        }
+
+        bool operator[](size_t const i) const {
+          return (lines[(i / bits_per_line) * 8 + (i % bits_per_line) / 64] >> (i & 63)) & 1;
+        }
+
+        /// set bits in [0, i), i <= size().
+        size_t rank(size_t const i) const {
+          uint64_t const * line = lines.data() + (i / bits_per_line) * 8;
+          size_t const w = (i % bits_per_line) / 64;
+          size_t r = line[words_per_line];
+          for (size_t j = 0; j < w; ++j) r += popcount(line[j]);
+          return r + popcount(line[w] & ((1ULL << (i & 63)) - 1));
+        }
+
+        /// position of the set bit with rank j, j < count().
+        size_t select(size_t const j) const {
+          // last line with at most j set bits before it.
+          size_t lo = 0, hi = lines.size() / 8;
+          while (hi - lo > 1) {
+            size_t const mid = (lo + hi) / 2;
+            if (lines[mid * 8 + words_per_line] <= j) lo = mid;
+            else hi = mid;
+          }
+          uint64_t const * line = lines.data() + lo * 8;
+          size_t r = j - line[words_per_line];
+          size_t w = 0;
+          for (; popcount(line[w]) <= r; ++w) r -= popcount(line[w]);
+          uint64_t x = line[w];
+          for (; r > 0; --r) x &= x - 1;
+          return lo * bits_per_line + w * 64 + __builtin_ctzll(x);
+        }
+    };
+
+
+    /**
+     * @brief distributed succinct de Bruijn graph.  see file description.
+     * @tparam Kmer    node type.
+     * @tparam ToRank  maps a node to the rank that stores it in the node map.  used on construction only.
+     */
+    template <typename Kmer, typename ToRank>
+    class succinct_graph {
+      public:
+        /// no such node.
+        static constexpr uint64_t npos = ::std::numeric_limits<uint64_t>::max();
+        /// flag of the dummy nodes in the out_edges result.  the low 4 bits are the out edges.
+        static constexpr uint8_t dummy_flag = 0x10;
+
+      protected:
+        static constexpr unsigned int k = Kmer::size;
+
+        /// node on construction:  (colex key, (d << 4) | out edge flags) for the label $^d v[0, k-d).
+        /// the key is the label reversed, with the d $ as the low (last) characters, set to 0.
+        using record_type = ::std::pair<Kmer, uint16_t>;
+        /// per process totals:  nodes, first edges for A C G T, and nodes ending in $ A C G T.
+        using totals_type = ::std::array<uint64_t, 10>;
+
+        ToRank const & to_rank;
+        const mxx::comm & comm;
+
+        /// local nodes:  4 out edge flags per node, the first edge flags, the group start and dummy flags.
+        ::std::vector<uint64_t> outs;
+        rank_select_bits firsts[4];
+        ::std::vector<uint64_t> group_starts;
+        ::std::vector<uint64_t> dummies;
+
+        /// global id of the first node of each process, and the total at the end.
+        ::std::vector<uint64_t> node_offsets;
+        /// first c edges before each process, at [4 * rank + c], and the totals at the end.
+        ::std::vector<uint64_t> first_offsets;
+        /// global id of the first node ending in $, A, C, G, T, and the total at the end.
+        uint64_t ends[6];
+
+        static Kmer clear_low(Kmer const & x, unsigned int const d) {
+          if (d == 0) return x;
+          if (d >= k) return Kmer();
+          return (x >> d) << d;
+        }
+
+        static inline unsigned int dollars(record_type const & x) {
+          return x.second >> 4;
+        }
+
+        /// colexicographic order.  $ is before all characters.
+        static bool colex_less(record_type const & x, record_type const & y) {
+          unsigned int const dx = dollars(x), dy = dollars(y);
+          if (dx == dy) return x.first < y.first;
+          if (dx > dy) return !(clear_low(y.first, dx) < x.first);
+          return clear_low(x.first, dy) < y.first;
+        }
+
+        /// same last k-1 characters.
+        static bool same_group(record_type const & x, record_type const & y) {
+          unsigned int const dx = ::std::max(dollars(x), 1U), dy = ::std::max(dollars(y), 1U);
+          return (dx == dy) && (clear_low(x.first, dx) == clear_low(y.first, dy));
+        }
+
+        static inline bool get_bit(::std::vector<uint64_t> const & bits, size_t const i) {
+          return (bits[i >> 6] >> (i & 63)) & 1;
+        }
+
+        static inline void set_bit(::std::vector<uint64_t> & bits, size_t const i) {
+          bits[i >> 6] |= 1ULL << (i & 63);
+        }
+
+        inline uint8_t out_flags(size_t const i) const {
+          return (outs[i >> 4] >> ((i & 15) * 4)) & 0xF;
+        }
+
+        /// local index of a global id on this process.
+        inline size_t local(uint64_t const id) const {
+          return id - node_offsets[comm.rank()];
+        }
+
+        int owner_of(uint64_t const id) const {
+          return ::std::distance(node_offsets.begin(), ::std::upper_bound(node_offsets.begin(), node_offsets.end(), id)) - 1;
+        }
+
+        /// 0 for the root, 1 to 4 for the nodes ending in A, C, G, T, 5 past the last node.
+        unsigned int last_of(uint64_t const id) const {
+          return ::std::distance(ends, ::std::upper_bound(ends, ends + 6, id)) - 1;
+        }
+
+        /// first c edges before local node i, and up to and including it, over all processes.
+        inline ::std::pair<uint64_t, uint64_t> ranks(size_t const i, unsigned int const c) const {
+          uint64_t const before = first_offsets[4 * comm.rank() + c] + firsts[c].rank(i);
+          return ::std::make_pair(before, before + (firsts[c][i] ? 1 : 0));
+        }
+
+        /// send each element to the rank given by rank_of.  input is replaced by the received elements.
+        template <typename V, typename RankOf>
+        void exchange(::std::vector<V> & input, RankOf const & rank_of) const {
+          if (comm.size() == 1) return;
+
+          ::std::vector<size_t> recv_counts(comm.size(), 0);
+          ::std::vector<size_t> i2o;
+          ::std::vector<V> buffer;
+          ::imxx::distribute(input, rank_of, recv_counts, i2o, buffer, comm);
+          input.swap(buffer);
+        }
+
+        /**
+         * @brief answer each query on the rank given by rank_of.  1 round.  collective.
+         * @return the answers, aligned to queries.
+         */
+        template <typename A, typename Q, typename RankOf, typename Answer>
+        ::std::vector<A> query(::std::vector<Q> queries, RankOf const & rank_of, Answer const & answer) const {
+          ::std::vector<A> answers;
+          if (comm.size() == 1) {
+            answers.reserve(queries.size());
+            for (auto const & q : queries) answers.emplace_back(answer(q));
+            return answers;
+          }
+
+          ::std::vector<size_t> recv_counts(comm.size(), 0);
+          ::std::vector<size_t> i2o;
+          ::std::vector<Q> buffer;
+          ::imxx::distribute(queries, rank_of, recv_counts, i2o, buffer, comm);
+
+          answers.reserve(buffer.size());
+          for (auto const & q : buffer) answers.emplace_back(answer(q));
+          answers = ::mxx::all2allv(answers, recv_counts, comm);
+
+          ::std::vector<A> results(i2o.size());
+          for (size_t j = 0; j < i2o.size(); ++j) results[j] = answers[i2o[j]];
+          return results;
+        }
+
+        /// first predecessor of each node, npos for the root and for npos.  1 round.  collective.
+        ::std::vector<uint64_t> first_predecessors(::std::vector<uint64_t> const & ids) const {
+          // the node with the j-th first c edge, from the j of each node.  all ranks know the node ranges.
+          ::std::vector<::std::pair<uint64_t, uint64_t> > queries;  // (j, c)
+          ::std::vector<size_t> pos;
+          for (size_t i = 0; i < ids.size(); ++i) {
+            unsigned int const e = last_of(ids[i]);
+            if ((e == 0) || (e > 4)) continue;
+            queries.emplace_back(ids[i] - ends[e], e - 1);
+            pos.emplace_back(i);
+          }
+
+          ::std::vector<uint64_t> answers = this->template query<uint64_t>(queries,
+              [this](::std::pair<uint64_t, uint64_t> const & q) { return this->first_owner(q.first, q.second); },
+              [this](::std::pair<uint64_t, uint64_t> const & q) {
+            return node_offsets[comm.rank()] + firsts[q.second].select(q.first - first_offsets[4 * comm.rank() + q.second]);
+          });
+
+          ::std::vector<uint64_t> preds(ids.size(), npos);
+          for (size_t j = 0; j < pos.size(); ++j) preds[pos[j]] = answers[j];
+          return preds;
+        }
+
+        /// rank that has the j-th first c edge.
+        int first_owner(uint64_t const j, unsigned int const c) const {
+          int lo = 0, hi = comm.size();
+          while (hi - lo > 1) {
+            int const mid = (lo + hi) / 2;
+            if (first_offsets[4 * mid + c] <= j) lo = mid;
+            else hi = mid;
+          }
+          return lo;
+        }
+
+        /// local nodes with valid out edges, sorted by k-mer, and the nodes without an in edge.  2 exchanges.
+        template <typename LocalMap>
+        void collect(LocalMap const & map, ::std::vector<record_type> & nodes, ::std::vector<Kmer> & sources) const {
+          nodes.clear();
+          nodes.reserve(map.size());
+          for (auto it = map.begin(); it != map.end(); ++it) {
+            uint16_t out = 0;
+            for (int c = 0; c < 4; ++c) {
+              if (it->second.get_edge_frequency(c) > 0) out |= static_cast<uint16_t>(1 << c);
+            }
+            nodes.emplace_back(it->first, out);
+          }
+          ::std::sort(nodes.begin(), nodes.end(), [](record_type const & x, record_type const & y){
+            return x.first < y.first;
+          });
+
+          ::std::vector<Kmer> targets;
+          for (auto const & x : nodes) {
+            for (int c = 0; c < 4; ++c) {
+              if ((x.second >> c) & 1) {
+                targets.emplace_back(x.first);
+                targets.back().nextFromChar(c);
+              }
+            }
+          }
+
+          // the owner of each target marks it as entered, and answers whether it exists.
+          ::std::vector<bool> entered(nodes.size(), false);
+          ::std::vector<uint8_t> found = this->template query<uint8_t>(targets, to_rank,
+              [&nodes, &entered](Kmer const & v) {
+            auto it = ::std::lower_bound(nodes.begin(), nodes.end(), v, [](record_type const & x, Kmer const & y){
+              return x.first < y;
+            });
+            if ((it == nodes.end()) || !(it->first == v)) return static_cast<uint8_t>(0);
+            entered[::std::distance(nodes.begin(), it)] = true;
+            return static_cast<uint8_t>(1);
+          });
+
+          size_t t = 0;
+          for (auto & x : nodes) {
+            for (int c = 0; c < 4; ++c) {
+              if ((x.second >> c) & 1) {
+                if (found[t] == 0) x.second &= static_cast<uint16_t>(~(1 << c));
+                ++t;
+              }
+            }
+          }
+
+          sources.clear();
+          for (size_t i = 0; i < nodes.size(); ++i) {
+            if (!entered[i]) sources.emplace_back(nodes[i].first);
+          }
+        }
+
+        /// the dummy predecessors of the sources, merged over all processes.  1 exchange.
+        void make_dummies(::std::vector<Kmer> const & sources, ::std::vector<record_type> & out) const {
+          ::std::vector<record_type> dummy;
+          dummy.reserve(sources.size() * k);
+          for (auto const & v : sources) {
+            // $^d v[0, k-d) -> $^(d-1) v[0, k-d+1), with edge v[k-d].  v[k-d] is at character position d-1.
+            Kmer const rev = v.reverse();
+            for (unsigned int d = 1; d <= k; ++d) {
+              dummy.emplace_back((d < k) ? (rev << d) : Kmer(),
+                                 static_cast<uint16_t>((d << 4) | (1 << v.getCharsAtPos(d - 1, 1))));
+            }
+          }
+
+          this->exchange(dummy, [this](record_type const & x){ return this->to_rank(x.first); });
+
+          ::std::sort(dummy.begin(), dummy.end(), [](record_type const & x, record_type const & y){
+            return (x.first < y.first) || ((x.first == y.first) && (dollars(x) < dollars(y)));
+          });
+          for (size_t i = 0; i < dummy.size(); ) {
+            record_type x = dummy[i];
+            for (++i; (i < dummy.size()) && (dummy[i].first == x.first) && (dollars(dummy[i]) == dollars(x)); ++i) {
+              x.second |= dummy[i].second;
+            }
+            out.emplace_back(x);
+          }
+        }
+
+        /// move the nodes of a group that starts on an earlier process to that process.  1 exchange.
+        void align_groups(::std::vector<record_type> & nodes) const {
+          if (comm.size() == 1) return;
+
+          uint8_t const has = nodes.empty() ? 0 : 1;
+          ::std::vector<uint8_t> all_has = ::mxx::allgather(has, comm);
+          ::std::vector<record_type> fronts = ::mxx::allgather(has ? nodes.front() : record_type(), comm);
+          ::std::vector<record_type> backs = ::mxx::allgather(has ? nodes.back() : record_type(), comm);
+
+          int owner = comm.rank();
+          if (has) {
+            for (int j = comm.rank() - 1; j >= 0; --j) {
+              if (all_has[j] == 0) continue;
+              if (!same_group(backs[j], nodes.front())) break;
+              owner = j;
+              if (!same_group(fronts[j], nodes.front())) break;
+            }
+          }
+
+          record_type const lead = has ? nodes.front() : record_type();
+          int const rank = comm.rank();
+          this->exchange(nodes, [owner, rank, &lead](record_type const & x){
+            return ((owner != rank) && same_group(x, lead)) ? owner : rank;
+          });
+          ::std::sort(nodes.begin(), nodes.end(), colex_less);
+        }
+
+        /// the flags and rank structures of the local nodes, and the global offsets.
+        void index(::std::vector<record_type> const & nodes) {
+          size_t const n = nodes.size();
+          size_t const nwords = (n + 63) / 64;
+          outs.assign((n + 15) / 16, 0);
+          group_starts.assign(nwords, 0);
+          dummies.assign(nwords, 0);
+          ::std::vector<uint64_t> first_bits[4];
+          for (int c = 0; c < 4; ++c) first_bits[c].assign(nwords, 0);
+
+          totals_type totals;
+          totals.fill(0);
+          totals[0] = n;
+          uint16_t seen = 0;
+          for (size_t i = 0; i < n; ++i) {
+            uint16_t const out = nodes[i].second & 0xF;
+            if ((i == 0) || !same_group(nodes[i - 1], nodes[i])) {
+              set_bit(group_starts, i);
+              seen = 0;
+            }
+            if (dollars(nodes[i]) > 0) set_bit(dummies, i);
+            outs[i >> 4] |= static_cast<uint64_t>(out) << ((i & 15) * 4);
+            for (int c = 0; c < 4; ++c) {
+              if (((out & ~seen) >> c) & 1) {
+                set_bit(first_bits[c], i);
+                ++totals[1 + c];
+              }
+            }
+            seen |= out;
+            ++totals[5 + ((dollars(nodes[i]) >= k) ? 0 : (1 + nodes[i].first.getCharsAtPos(k - 1, 1)))];
+          }
+          for (int c = 0; c < 4; ++c) firsts[c].build(first_bits[c], n);
+
+          ::std::vector<totals_type> all;
+          if (comm.size() == 1) all.assign(1, totals);
+          else all = ::mxx::allgather(totals, comm);
+
+          int const p = comm.size();
+          node_offsets.assign(p + 1, 0);
+          first_offsets.assign(4 * (p + 1), 0);
+          for (int r = 0; r < p; ++r) {
+            node_offsets[r + 1] = node_offsets[r] + all[r][0];
+            for (int c = 0; c < 4; ++c) first_offsets[4 * (r + 1) + c] = first_offsets[4 * r + c] + all[r][1 + c];
+          }
+          ends[0] = 0;
+          for (int e = 0; e < 5; ++e) {
+            uint64_t count = 0;
+            for (int r = 0; r < p; ++r) count += all[r][5 + e];
+            ends[e + 1] = ends[e] + count;
+          }
+        }
+
+      public:
+        succinct_graph(ToRank const & _to_rank, const mxx::comm & _comm) : to_rank(_to_rank), comm(_comm) {
+          node_offsets.assign(comm.size() + 1, 0);
+          first_offsets.assign(4 * (comm.size() + 1), 0);
+          ::std::fill(ends, ends + 6, 0);
+        }
+
+        /**
+         * @brief build from the local nodes.  collective.
+         * @param map  the local nodes, a map from k-mer to edge_counts or edge_exists.  the neighbors of a node are on
+         *             the ranks given by to_rank.  not needed after this.
+         */
+        template <typename LocalMap>
+        void build(LocalMap const & map) {
+          ::std::vector<record_type> nodes;
+          ::std::vector<Kmer> sources;
+          this->collect(map, nodes, sources);
+
+          for (auto & x : nodes) x.first = x.first.reverse();
+          this->make_dummies(sources, nodes);
+          ::std::vector<Kmer>().swap(sources);
+
+          if (comm.size() > 1) ::mxx::sort(nodes.begin(), nodes.end(), colex_less, comm);
+          else ::std::sort(nodes.begin(), nodes.end(), colex_less);
+          this->align_groups(nodes);
+
+          this->index(nodes);
+        }
+
+        /// global number of nodes, including the dummy nodes.
+        uint64_t size() const {
+          return ends[5];
+        }
+
+        /// number of local nodes.
+        size_t local_size() const {
+          return node_offsets[comm.rank() + 1] - node_offsets[comm.rank()];
+        }
+
+        /// local memory, in bytes.
+        size_t bytes() const {
+          size_t b = (outs.capacity() + group_starts.capacity() + dummies.capacity() + node_offsets.capacity() +
+              first_offsets.capacity()) * sizeof(uint64_t);
+          for (int c = 0; c < 4; ++c) b += firsts[c].bytes();
+          return b;
+        }
+
+        /**
+         * @brief global ids of k-mers, npos for those that are not nodes.  k - 1 rounds.  collective.
+         * @details  the nodes ending in the first i characters of a k-mer are a range, which an edge maps to the range
+         *          ending in the first i + 1.  a range of nodes ending in fewer than k characters holds whole groups, so the
+         *          first edges of the range are exactly the edges into the next range.
+         */
+        ::std::vector<uint64_t> find(::std::vector<Kmer> const & kmers) const {
+          // [lo, hi) per k-mer
+          ::std::vector<::std::pair<uint64_t, uint64_t> > ranges;
+          ranges.reserve(kmers.size());
+          for (auto const & x : kmers) {
+            unsigned int const c = x.getCharsAtPos(k - 1, 1);
+            ranges.emplace_back(ends[c + 1], ends[c + 2]);
+          }
+
+          ::std::vector<::std::pair<uint64_t, uint64_t> > queries;  // (node, c)
+          ::std::vector<size_t> pos;
+          for (unsigned int s = 1; s < k; ++s) {
+            // the first c edges before lo, and up to hi - 1.
+            queries.clear();
+            pos.clear();
+            for (size_t i = 0; i < kmers.size(); ++i) {
+              if (ranges[i].first >= ranges[i].second) continue;
+              unsigned int const c = kmers[i].getCharsAtPos(k - 1 - s, 1);
+              queries.emplace_back(ranges[i].first, c);
+              queries.emplace_back(ranges[i].second - 1, c);
+              pos.emplace_back(i);
+            }
+
+            ::std::vector<::std::pair<uint64_t, uint64_t> > answers =
+                this->template query<::std::pair<uint64_t, uint64_t> >(queries,
+                [this](::std::pair<uint64_t, uint64_t> const & q) { return this->owner_of(q.first); },
+                [this](::std::pair<uint64_t, uint64_t> const & q) { return this->ranks(this->local(q.first), q.second); });
+
+            for (size_t j = 0; j < pos.size(); ++j) {
+              uint64_t const start = ends[queries[2 * j].second + 1];
+              ranges[pos[j]].first = start + answers[2 * j].first;
+              ranges[pos[j]].second = start + answers[2 * j + 1].second;
+            }
+          }
+
+          ::std::vector<uint64_t> ids(kmers.size(), npos);
+          for (size_t i = 0; i < kmers.size(); ++i) {
+            if (ranges[i].first + 1 == ranges[i].second) ids[i] = ranges[i].first;
+          }
+          return ids;
+        }
+
+        /// out edge flags of nodes, with dummy_flag for the dummy nodes.  ids are node ids, not npos.  1 round.  collective.
+        ::std::vector<uint8_t> out_edges(::std::vector<uint64_t> const & ids) const {
+          return this->template query<uint8_t>(ids,
+              [this](uint64_t const & id) { return this->owner_of(id); },
+              [this](uint64_t const & id) {
+            size_t const i = this->local(id);
+            return static_cast<uint8_t>(this->out_flags(i) | (get_bit(dummies, i) ? dummy_flag : 0));
+          });
+        }
+
+        /// targets of the out edges (ids[i], chars[i]), npos if there is no such edge.  ids are node ids.  1 round.  collective.
+        ::std::vector<uint64_t> forward(::std::vector<uint64_t> const & ids, ::std::vector<uint8_t> const & chars) const {
+          ::std::vector<::std::pair<uint64_t, uint64_t> > queries;  // (node, c)
+          queries.reserve(ids.size());
+          for (size_t i = 0; i < ids.size(); ++i) queries.emplace_back(ids[i], chars[i]);
+
+          return this->template query<uint64_t>(queries,
+              [this](::std::pair<uint64_t, uint64_t> const & q) { return this->owner_of(q.first); },
+              [this](::std::pair<uint64_t, uint64_t> const & q) {
+            size_t const i = this->local(q.first);
+            unsigned int const c = q.second;
+            if (((this->out_flags(i) >> c) & 1) == 0) return npos;
+            // the edge's first c edge is the last one up to i.
+            return ends[c + 1] + this->ranks(i, c).second - 1;
+          });
+        }
+
+        /**
+         * @brief predecessors of nodes, including dummy nodes.  none for the root and npos.  1 round.  collective.
+         * @details  the predecessors of a node ending in c are the first c edge of rank j and the other c edges of its group.
+         */
+        ::std::vector<::std::vector<uint64_t> > predecessors(::std::vector<uint64_t> const & ids) const {
+          ::std::vector<::std::pair<uint64_t, uint64_t> > queries;  // (j, c)
+          ::std::vector<size_t> pos;
+          for (size_t i = 0; i < ids.size(); ++i) {
+            unsigned int const e = last_of(ids[i]);
+            if ((e == 0) || (e > 4)) continue;
+            queries.emplace_back(ids[i] - ends[e], e - 1);
+            pos.emplace_back(i);
+          }
+
+          // (first predecessor, flags of the predecessors among the next 4 nodes of its group)
+          ::std::vector<::std::pair<uint64_t, uint64_t> > answers =
+              this->template query<::std::pair<uint64_t, uint64_t> >(queries,
+              [this](::std::pair<uint64_t, uint64_t> const & q) { return this->first_owner(q.first, q.second); },
+              [this](::std::pair<uint64_t, uint64_t> const & q) {
+            unsigned int const c = q.second;
+            size_t const i = firsts[c].select(q.first - first_offsets[4 * comm.rank() + c]);
+            uint64_t more = 0;
+            for (size_t j = i + 1; (j < this->local_size()) && !get_bit(group_starts, j); ++j) {
+              if ((this->out_flags(j) >> c) & 1) more |= 1ULL << (j - i - 1);
+            }
+            return ::std::make_pair(node_offsets[comm.rank()] + i, more);
+          });
+
+          ::std::vector<::std::vector<uint64_t> > preds(ids.size());
+          for (size_t j = 0; j < pos.size(); ++j) {
+            auto & out = preds[pos[j]];
+            out.emplace_back(answers[j].first);
+            for (uint64_t m = answers[j].second; m != 0; m &= m - 1) {
+              out.emplace_back(answers[j].first + 1 + __builtin_ctzll(m));
+            }
+          }
+          return preds;
+        }
+
+        /**
+         * @brief labels of nodes, from the last characters of the nodes of a backward walk.  k - 1 rounds.  collective.
+         * @details  the $ of dummy nodes are A (0).  npos gives all A.
+         */
+        ::std::vector<Kmer> labels(::std::vector<uint64_t> const & ids) const {
+          ::std::vector<Kmer> out(ids.size());
+          ::std::vector<uint64_t> walk(ids);
+          for (unsigned int s = 0; s < k; ++s) {
+            // character k-1-s of the label is at position s.
+            for (size_t i = 0; i < ids.size(); ++i) {
+              unsigned int const e = last_of(walk[i]);
+              if ((e > 0) && (e < 5)) out[i].setCharsAtPos(e - 1, s, 1);
+            }
+            if (s + 1 < k) walk = this->first_predecessors(walk);
+          }
+          return out;
+        }
+    };
+
+    template <typename Kmer, typename ToRank>
+    constexpr uint64_t succinct_graph<Kmer, ToRank>::npos;
+
+    template <typename Kmer, typename ToRank>
+    constexpr uint8_t succinct_graph<Kmer, ToRank>::dummy_flag;
+
+    template <typename Kmer, typename ToRank>
+    constexpr unsigned int succinct_graph<Kmer, ToRank>::k;
+
+  } /* namespace de_bruijn */
+} /* namespace bliss */
+
+#endif /* SRC_DEBRUIJN_SUCCINCT_GRAPH_HPP_ */
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_graph_cleaning.cpp
+ *   test tip clipping, bubble popping, and edge pruning on small graphs with a known clean sequence.
+ *
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#if defined(USE_MPI)
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#endif
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint> // for uint64_t, etc.
+#include <string>
+#include <vector>
+#include <random>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+#include "debruijn/debruijn_mxx_support.hpp"
+#include "debruijn/de_bruijn_nodes_distributed.hpp"
+
+using KmerType = bliss::common::Kmer<15, bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::BimoleculeHashMapParams<Key>;
+
+using NodeMapType = bliss::de_bruijn::de_bruijn_nodes_distributed<
+    KmerType, bliss::de_bruijn::node::edge_counts<bliss::common::DNA16, uint32_t>, MapParams >;
+
+class GraphCleaningTest : public ::testing::Test
+{
+  protected:
+    /// same on all ranks.
+    static std::string random_seq(size_t len, unsigned seed) {
+      std::mt19937 gen(seed);
+      std::string s;
+      for (size_t i = 0; i < len; ++i) s.push_back("ACGT"[gen() % 4]);
+      return s;
+    }
+
+    /// nodes of a read, with the in and out characters as DNA16 [in, out].
+    static void add_read(std::string const & s, std::vector<std::pair<KmerType, uint8_t> > & nodes) {
+      using DNA = bliss::common::DNA;
+      using DNA16 = bliss::common::DNA16;
+
+      for (size_t i = 0; i + KmerType::size <= s.size(); ++i) {
+        KmerType k;
+        for (size_t j = 0; j < KmerType::size; ++j) k.nextFromChar(DNA::FROM_ASCII[static_cast<size_t>(s[i + j])]);
+
+        uint8_t out = (i + KmerType::size < s.size()) ? DNA16::FROM_ASCII[static_cast<size_t>(s[i + KmerType::size])] : 0;
+        uint8_t in = (i > 0) ? DNA16::FROM_ASCII[static_cast<size_t>(s[i - 1])] : 0;
+        nodes.emplace_back(k, static_cast<uint8_t>((in << 4) | out));
+      }
+    }
+
+    /// insert on rank 0 only.
+    static void build(NodeMapType & nodes, std::vector<std::pair<KmerType, uint8_t> > & input, mxx::comm const & comm) {
+      if (comm.rank() != 0) input.clear();
+      nodes.insert(input);
+    }
+
+    /// true if the graph is exactly the sequence.
+    static bool is_sequence(NodeMapType const & nodes, std::string const & s, mxx::comm const & comm) {
+      std::vector<std::string> unitigs = nodes.compact_unitigs();
+      bool found = false;
+      for (auto const & u : unitigs) found |= (u == s);
+
+      return (::mxx::allreduce(unitigs.size(), comm) == 1) && ::mxx::any_of(found, comm);
+    }
+};
+
+
+TEST_F(GraphCleaningTest, clip_tips)
+{
+  mxx::comm comm;
+
+  // 3x coverage of the sequence, and a read that branches off it into a dead end.
+  std::string s = random_seq(1000, 41);
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  for (int i = 0; i < 3; ++i) add_read(s, input);
+  add_read(s.substr(400, 20) + random_seq(10, 43), input);
+
+  NodeMapType nodes(comm);
+  build(nodes, input, comm);
+  size_t extra = nodes.size() - (s.size() - KmerType::size + 1);
+  EXPECT_LT(0UL, extra);
+
+  EXPECT_EQ(extra, nodes.clip_tips(2 * KmerType::size));
+  EXPECT_EQ(s.size() - KmerType::size + 1, nodes.size());
+  EXPECT_TRUE(is_sequence(nodes, s, comm));
+
+  // nothing left to clip.
+  EXPECT_EQ(0UL, nodes.clip_tips(2 * KmerType::size));
+}
+
+TEST_F(GraphCleaningTest, pop_bubbles)
+{
+  mxx::comm comm;
+
+  // a read with 1 substitution forms a bubble of 2 paths of k k-mers.
+  std::string s = random_seq(1000, 47);
+  std::string v = s;
+  v[500] = (v[500] == 'A') ? 'C' : 'A';
+
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  for (int i = 0; i < 3; ++i) add_read(s, input);
+  add_read(v.substr(450, 100), input);
+
+  NodeMapType nodes(comm);
+  build(nodes, input, comm);
+  EXPECT_FALSE(is_sequence(nodes, s, comm));
+
+  EXPECT_EQ(1UL, nodes.pop_bubbles(2 * KmerType::size));
+  EXPECT_TRUE(is_sequence(nodes, s, comm));
+}
+
+TEST_F(GraphCleaningTest, prune_edges)
+{
+  mxx::comm comm;
+
+  std::string s = random_seq(1000, 53);
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  for (int i = 0; i < 3; ++i) add_read(s, input);
+  add_read(s.substr(400, 20) + random_seq(10, 59), input);
+
+  NodeMapType nodes(comm);
+  build(nodes, input, comm);
+
+  // the edges of the single read are cut off, which leaves the tip nodes disconnected from the sequence.
+  EXPECT_LT(0UL, nodes.prune_edges(2));
+
+  std::vector<std::string> unitigs = nodes.compact_unitigs();
+  bool found = false;
+  for (auto const & u : unitigs) found |= (u == s);
+  EXPECT_TRUE(::mxx::any_of(found, comm));
+}
+
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
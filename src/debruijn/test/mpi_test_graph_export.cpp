@@ -0,0 +1,181 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_graph_export.cpp
+ *   test the shared GFA and binary files written by all ranks.
+ *
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#if defined(USE_MPI)
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#endif
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint> // for uint64_t, etc.
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <cstdio>  // remove
+#include <algorithm>  // sort, unique
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+#include "debruijn/debruijn_mxx_support.hpp"
+#include "debruijn/de_bruijn_nodes_distributed.hpp"
+#include "containers/distributed_map_io.hpp"
+
+using KmerType = bliss::common::Kmer<15, bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::BimoleculeHashMapParams<Key>;
+
+using EdgeType = bliss::de_bruijn::node::edge_counts<bliss::common::DNA16, uint32_t>;
+using NodeMapType = bliss::de_bruijn::de_bruijn_nodes_distributed<KmerType, EdgeType, MapParams >;
+
+class GraphExportTest : public ::testing::Test
+{
+  protected:
+    /// same on all ranks.
+    static std::string random_seq(size_t len, unsigned seed) {
+      std::mt19937 gen(seed);
+      std::string s;
+      for (size_t i = 0; i < len; ++i) s.push_back("ACGT"[gen() % 4]);
+      return s;
+    }
+
+    /// nodes of a read, with the in and out characters as DNA16 [in, out].
+    static void add_read(std::string const & s, std::vector<std::pair<KmerType, uint8_t> > & nodes) {
+      using DNA = bliss::common::DNA;
+      using DNA16 = bliss::common::DNA16;
+
+      for (size_t i = 0; i + KmerType::size <= s.size(); ++i) {
+        KmerType k;
+        for (size_t j = 0; j < KmerType::size; ++j) k.nextFromChar(DNA::FROM_ASCII[static_cast<size_t>(s[i + j])]);
+
+        uint8_t out = (i + KmerType::size < s.size()) ? DNA16::FROM_ASCII[static_cast<size_t>(s[i + KmerType::size])] : 0;
+        uint8_t in = (i > 0) ? DNA16::FROM_ASCII[static_cast<size_t>(s[i - 1])] : 0;
+        nodes.emplace_back(k, static_cast<uint8_t>((in << 4) | out));
+      }
+    }
+
+    /// 2 sequences sharing a 20 character prefix:  3 unitigs, and 2 links from the shared one.  inserted on rank 0 only.
+    static void build(NodeMapType & nodes, mxx::comm const & comm) {
+      std::string prefix = random_seq(20, 23);
+      std::vector<std::pair<KmerType, uint8_t> > input;
+      add_read(prefix + "A" + random_seq(300, 29), input);
+      add_read(prefix + "C" + random_seq(300, 31), input);
+
+      if (comm.rank() != 0) input.clear();
+      nodes.insert(input);
+    }
+};
+
+
+TEST_F(GraphExportTest, gfa)
+{
+  mxx::comm comm;
+
+  NodeMapType nodes(comm);
+  build(nodes, comm);
+
+  std::string filename("test_graph_export.gfa");
+  EXPECT_EQ(3UL, nodes.write_gfa(filename));
+  comm.barrier();
+
+  if (comm.rank() == 0) {
+    std::ifstream f(filename);
+    std::vector<std::string> segments;
+    size_t headers = 0, links = 0;
+    std::string line;
+    while (std::getline(f, line)) {
+      if (line[0] == 'H') ++headers;
+      else if (line[0] == 'S') segments.push_back(line);
+      else if (line[0] == 'L') {
+        ++links;
+        EXPECT_NE(std::string::npos, line.find("\t+\t")) << line;
+        EXPECT_EQ(line.size() - 4, line.find("\t14M")) << line;
+      }
+    }
+    EXPECT_EQ(1UL, headers);
+    EXPECT_EQ(3UL, segments.size());
+    EXPECT_EQ(2UL, links);
+
+    // every node is in exactly 1 segment.
+    size_t kmers = 0;
+    for (auto const & s : segments) kmers += s.size() - s.find('\t', 2) - 1 - KmerType::size + 1;
+    EXPECT_EQ(nodes.size(), kmers);
+  }
+  comm.barrier();
+  if (comm.rank() == 0) std::remove(filename.c_str());
+}
+
+TEST_F(GraphExportTest, binary)
+{
+  mxx::comm comm;
+
+  NodeMapType nodes(comm);
+  build(nodes, comm);
+
+  std::string filename("test_graph_export.bin");
+  EXPECT_EQ(nodes.size(), nodes.write_binary(filename));
+  comm.barrier();
+
+  if (comm.rank() == 0) {
+    dsc::mapped_map_file f(filename);
+    f.validate<KmerType, EdgeType>(comm.size(), -1);
+    ASSERT_EQ(nodes.size(), f.size());
+
+    // no duplicates, so each entry is 1 distinct node.
+    std::vector<KmerType> kmers;
+    std::pair<KmerType, EdgeType> const * entries = f.entries<KmerType, EdgeType>();
+    for (size_t i = 0; i < f.size(); ++i) kmers.push_back(entries[i].first);
+    std::sort(kmers.begin(), kmers.end());
+    EXPECT_TRUE(std::unique(kmers.begin(), kmers.end()) == kmers.end());
+  }
+  comm.barrier();
+  if (comm.rank() == 0) std::remove(filename.c_str());
+}
+
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_neighbor_exists.cpp
+ *   test that the batched neighbor query gives the same masks as looking up each of the 8 neighbors.
+ *
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#if defined(USE_MPI)
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#endif
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint> // for uint64_t, etc.
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+#include "debruijn/debruijn_mxx_support.hpp"
+#include "debruijn/de_bruijn_nodes_distributed.hpp"
+
+using KmerType = bliss::common::Kmer<15, bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::BimoleculeHashMapParams<Key>;
+
+using EdgeType = bliss::de_bruijn::node::edge_exists<bliss::common::DNA16>;
+using NodeMapType = bliss::de_bruijn::de_bruijn_nodes_distributed<KmerType, EdgeType, MapParams>;
+using NodeUtils = bliss::de_bruijn::node::node_utils<KmerType, EdgeType>;
+
+class NeighborExistsTest : public ::testing::Test
+{
+  protected:
+    /// same on all ranks.
+    static std::string random_seq(size_t len, unsigned seed) {
+      std::mt19937 gen(seed);
+      std::string s;
+      for (size_t i = 0; i < len; ++i) s.push_back("ACGT"[gen() % 4]);
+      return s;
+    }
+
+    static KmerType kmer_at(std::string const & s, size_t pos) {
+      KmerType k;
+      for (size_t j = 0; j < KmerType::size; ++j) k.nextFromChar(bliss::common::DNA::FROM_ASCII[static_cast<size_t>(s[pos + j])]);
+      return k;
+    }
+
+    /// nodes of a read, with the in and out characters as DNA16 [in, out].
+    static void add_read(std::string const & s, std::vector<std::pair<KmerType, uint8_t> > & nodes) {
+      using DNA16 = bliss::common::DNA16;
+
+      for (size_t i = 0; i + KmerType::size <= s.size(); ++i) {
+        uint8_t out = (i + KmerType::size < s.size()) ? DNA16::FROM_ASCII[static_cast<size_t>(s[i + KmerType::size])] : 0;
+        uint8_t in = (i > 0) ? DNA16::FROM_ASCII[static_cast<size_t>(s[i - 1])] : 0;
+        nodes.emplace_back(kmer_at(s, i), static_cast<uint8_t>((in << 4) | out));
+      }
+    }
+
+    /// the masks by lookups of the 8 neighbors in all keys of the graph.
+    static std::vector<uint8_t> expected(NodeMapType const & graph, std::vector<KmerType> const & query, mxx::comm const & comm) {
+      std::vector<KmerType> all = mxx::allgatherv(graph.keys(), comm);
+      std::sort(all.begin(), all.end());
+
+      std::vector<uint8_t> masks;
+      for (auto const & q : query) {
+        uint8_t m = 0;
+        for (uint8_t j = 0; j < 8; ++j) {
+          if (std::binary_search(all.begin(), all.end(), NodeUtils::get_neighbor(q, j))) m |= static_cast<uint8_t>(1 << j);
+        }
+        masks.push_back(m);
+      }
+      return masks;
+    }
+};
+
+
+TEST_F(NeighborExistsTest, matches_lookup)
+{
+  mxx::comm comm;
+
+  // a sequence, and a branch off it, inserted on rank 0.
+  std::string s = random_seq(2000, 7);
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  add_read(s, input);
+  std::string branch_seq = s.substr(700, 30);
+  branch_seq.push_back((s[730] == 'A') ? 'C' : 'A');
+  add_read(branch_seq + random_seq(20, 9), input);
+  if (comm.rank() != 0) input.clear();
+
+  NodeMapType graph(comm);
+  graph.insert(input);
+
+  // a different part of the graph on each rank, and k-mers that are not in it.
+  std::vector<KmerType> query;
+  for (size_t i = comm.rank(); i + KmerType::size <= s.size(); i += 3 * comm.size()) query.push_back(kmer_at(s, i));
+  std::string other = random_seq(200, 11 + comm.rank());
+  for (size_t i = 0; i + KmerType::size <= other.size(); i += 5) query.push_back(kmer_at(other, i));
+
+  std::vector<uint8_t> masks = graph.neighbor_exists(query);
+  std::vector<uint8_t> gold = expected(graph, query, comm);
+  ASSERT_EQ(gold.size(), masks.size());
+  for (size_t i = 0; i < gold.size(); ++i) EXPECT_EQ(gold[i], masks[i]) << "node " << i;
+
+  // the nodes of the sequence have their successor and predecessor.
+  EXPECT_EQ(1, (masks[1] >> bliss::common::DNA::FROM_ASCII[static_cast<size_t>(s[comm.rank() + 3 * comm.size() + KmerType::size])]) & 1);
+  EXPECT_EQ(1, (masks[1] >> (4 + bliss::common::DNA::FROM_ASCII[static_cast<size_t>(s[comm.rank() + 3 * comm.size() - 1])])) & 1);
+
+  // the branch point has 2 successors.
+  std::vector<KmerType> branch;
+  if (comm.rank() == 0) branch.push_back(kmer_at(s, 700 + 30 - KmerType::size));
+  masks = graph.neighbor_exists(branch);
+  EXPECT_EQ(expected(graph, branch, comm), masks);
+  if (comm.rank() == 0) {
+    ASSERT_EQ(1UL, masks.size());
+    EXPECT_EQ(2, __builtin_popcount(masks[0] & 0x0F));
+  }
+
+  // no queries anywhere.
+  EXPECT_TRUE(graph.neighbor_exists(std::vector<KmerType>()).empty());
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_succinct_graph.cpp
+ *   test the succinct de Bruijn graph against the edges of the sequences it is built from.
+ *
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#if defined(USE_MPI)
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#endif
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint> // for uint64_t, etc.
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <random>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+#include "debruijn/debruijn_mxx_support.hpp"
+#include "debruijn/de_bruijn_nodes_distributed.hpp"
+#include "debruijn/succinct_graph.hpp"
+
+using KmerType = bliss::common::Kmer<15, bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::BimoleculeHashMapParams<Key>;
+
+using NodeMapType = bliss::de_bruijn::de_bruijn_nodes_distributed<
+    KmerType, bliss::de_bruijn::node::edge_exists<bliss::common::DNA16>, MapParams >;
+
+class SuccinctGraphTest : public ::testing::Test
+{
+  protected:
+    /// out and in edge flags, bit c for character c.
+    using edge_flags = std::pair<uint8_t, uint8_t>;
+
+    /// same on all ranks.
+    static std::string random_seq(size_t len, unsigned seed) {
+      std::mt19937 gen(seed);
+      std::string s;
+      for (size_t i = 0; i < len; ++i) s.push_back("ACGT"[gen() % 4]);
+      return s;
+    }
+
+    /// nodes of a sequence, as node map input and as expected edges.  circular wraps around the end.
+    static void add_nodes(std::string const & s, bool circular,
+                          std::vector<std::pair<KmerType, uint8_t> > & nodes, std::map<KmerType, edge_flags> & edges) {
+      using DNA = bliss::common::DNA;
+      using DNA16 = bliss::common::DNA16;
+
+      std::string t = circular ? s + s.substr(0, KmerType::size) : s;
+      size_t n = circular ? s.size() : s.size() - KmerType::size + 1;
+      for (size_t i = 0; i < n; ++i) {
+        KmerType k;
+        for (size_t j = 0; j < KmerType::size; ++j) k.nextFromChar(DNA::FROM_ASCII[static_cast<size_t>(t[i + j])]);
+
+        char out = (i + KmerType::size < t.size()) ? t[i + KmerType::size] : 0;
+        char in = (i > 0) ? t[i - 1] : (circular ? s.back() : 0);
+        nodes.emplace_back(k, static_cast<uint8_t>((DNA16::FROM_ASCII[static_cast<size_t>(in)] << 4) |
+                                                   DNA16::FROM_ASCII[static_cast<size_t>(out)]));
+
+        edge_flags & e = edges[k];
+        if (out != 0) e.first |= static_cast<uint8_t>(1 << DNA::FROM_ASCII[static_cast<size_t>(out)]);
+        if (in != 0) e.second |= static_cast<uint8_t>(1 << DNA::FROM_ASCII[static_cast<size_t>(in)]);
+      }
+    }
+
+    /// build the graph from the nodes, inserted on rank 0, and check the queries of a different subset of nodes on each rank.
+    static void check(std::vector<std::pair<KmerType, uint8_t> > & input, std::map<KmerType, edge_flags> & edges,
+                      mxx::comm const & comm) {
+      NodeMapType nodes(comm);
+      if (comm.rank() != 0) input.clear();
+      nodes.insert(input);
+
+      auto graph = nodes.to_succinct();
+      EXPECT_LE(edges.size(), graph.size());
+
+      std::vector<KmerType> kmers;
+      size_t i = 0;
+      for (auto const & x : edges) {
+        if ((i++ % comm.size()) == static_cast<size_t>(comm.rank())) kmers.push_back(x.first);
+      }
+
+      // find, and back to the k-mers.
+      std::vector<uint64_t> ids = graph.find(kmers);
+      std::set<uint64_t> distinct;
+      for (auto id : ids) {
+        ASSERT_LT(id, graph.size());
+        distinct.insert(id);
+      }
+      EXPECT_EQ(ids.size(), distinct.size());
+      EXPECT_EQ(kmers, graph.labels(ids));
+
+      // out edges, and their targets.
+      std::vector<uint8_t> outs = graph.out_edges(ids);
+      std::vector<uint64_t> from;
+      std::vector<uint8_t> chars;
+      std::vector<KmerType> to;
+      for (size_t j = 0; j < ids.size(); ++j) {
+        EXPECT_EQ(edges[kmers[j]].first, outs[j]);
+        for (uint8_t c = 0; c < 4; ++c) {
+          from.push_back(ids[j]);
+          chars.push_back(c);
+          to.push_back(kmers[j]);
+          to.back().nextFromChar(c);
+        }
+      }
+      std::vector<uint64_t> targets = graph.forward(from, chars);
+      std::vector<uint64_t> expected = graph.find(to);
+      for (size_t j = 0; j < targets.size(); ++j) {
+        if ((outs[j / 4] >> chars[j]) & 1) EXPECT_EQ(expected[j], targets[j]);
+        else EXPECT_EQ(graph.npos, targets[j]);
+      }
+
+      // predecessors.  a node without an in edge has dummy predecessors only.
+      std::vector<std::vector<uint64_t> > preds = graph.predecessors(ids);
+      std::vector<uint64_t> flat;
+      for (auto const & p : preds) flat.insert(flat.end(), p.begin(), p.end());
+      std::vector<uint8_t> flags = graph.out_edges(flat);
+      std::vector<KmerType> labels = graph.labels(flat);
+      size_t t = 0;
+      for (size_t j = 0; j < ids.size(); ++j) {
+        std::set<KmerType> exp, got;
+        for (uint8_t c = 0; c < 4; ++c) {
+          if ((edges[kmers[j]].second >> c) & 1) {
+            KmerType u = kmers[j];
+            u.nextReverseFromChar(c);
+            exp.insert(u);
+          }
+        }
+        bool dummy = false;
+        for (size_t l = 0; l < preds[j].size(); ++l, ++t) {
+          if (flags[t] & graph.dummy_flag) dummy = true;
+          else got.insert(labels[t]);
+        }
+        EXPECT_EQ(exp, got);
+        EXPECT_EQ(exp.empty(), dummy);
+      }
+
+      // k-mers that are not nodes.
+      std::mt19937 gen(comm.rank() + 5);
+      std::vector<KmerType> others;
+      for (size_t j = 0; j < 200; ++j) {
+        KmerType k;
+        for (size_t l = 0; l < KmerType::size; ++l) k.nextFromChar(gen() % 4);
+        if (edges.count(k) == 0) others.push_back(k);
+      }
+      for (auto id : graph.find(others)) EXPECT_EQ(graph.npos, id);
+
+      // much smaller than the map entries.
+      EXPECT_LT(::mxx::allreduce(graph.bytes(), comm) * 4,
+                edges.size() * sizeof(std::pair<KmerType, bliss::de_bruijn::node::edge_exists<bliss::common::DNA16> >));
+    }
+};
+
+
+TEST_F(SuccinctGraphTest, linear)
+{
+  mxx::comm comm;
+
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  std::map<KmerType, edge_flags> edges;
+  add_nodes(random_seq(2000, 17), false, input, edges);
+
+  check(input, edges, comm);
+}
+
+TEST_F(SuccinctGraphTest, branch)
+{
+  mxx::comm comm;
+
+  // 2 sequences sharing a 20 character prefix, and 2 more sharing a 20 character suffix.
+  std::string prefix = random_seq(20, 23);
+  std::string suffix = random_seq(20, 41);
+
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  std::map<KmerType, edge_flags> edges;
+  add_nodes(prefix + "A" + random_seq(1000, 29), false, input, edges);
+  add_nodes(prefix + "C" + random_seq(1000, 31), false, input, edges);
+  add_nodes(random_seq(1000, 43) + "G" + suffix, false, input, edges);
+  add_nodes(random_seq(1000, 47) + "T" + suffix, false, input, edges);
+
+  check(input, edges, comm);
+}
+
+TEST_F(SuccinctGraphTest, cycle)
+{
+  mxx::comm comm;
+
+  // no node without an in edge, so no dummy node.
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  std::map<KmerType, edge_flags> edges;
+  add_nodes(random_seq(2000, 37), true, input, edges);
+
+  check(input, edges, comm);
+}
+
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_unitig_compaction.cpp
+ *   test distributed unitig compaction on small graphs with known unitigs.
+ *
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#if defined(USE_MPI)
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#endif
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint> // for uint64_t, etc.
+#include <string>
+#include <vector>
+#include <random>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+#include "debruijn/debruijn_mxx_support.hpp"
+#include "debruijn/de_bruijn_nodes_distributed.hpp"
+
+using KmerType = bliss::common::Kmer<15, bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::BimoleculeHashMapParams<Key>;
+
+using NodeMapType = bliss::de_bruijn::de_bruijn_nodes_distributed<
+    KmerType, bliss::de_bruijn::node::edge_exists<bliss::common::DNA16>, MapParams >;
+
+class UnitigCompactionTest : public ::testing::Test
+{
+  protected:
+    /// same on all ranks.
+    static std::string random_seq(size_t len, unsigned seed) {
+      std::mt19937 gen(seed);
+      std::string s;
+      for (size_t i = 0; i < len; ++i) s.push_back("ACGT"[gen() % 4]);
+      return s;
+    }
+
+    /// nodes of a sequence, with the in and out characters as DNA16 [in, out].  circular wraps around the end.
+    static void add_nodes(std::string const & s, bool circular,
+                          std::vector<std::pair<KmerType, uint8_t> > & nodes) {
+      using DNA = bliss::common::DNA;
+      using DNA16 = bliss::common::DNA16;
+
+      std::string t = circular ? s + s.substr(0, KmerType::size) : s;
+      size_t n = circular ? s.size() : s.size() - KmerType::size + 1;
+      for (size_t i = 0; i < n; ++i) {
+        KmerType k;
+        for (size_t j = 0; j < KmerType::size; ++j) k.nextFromChar(DNA::FROM_ASCII[static_cast<size_t>(t[i + j])]);
+
+        uint8_t out = (i + KmerType::size < t.size()) ? DNA16::FROM_ASCII[static_cast<size_t>(t[i + KmerType::size])] : 0;
+        uint8_t in = (i > 0) ? DNA16::FROM_ASCII[static_cast<size_t>(t[i - 1])] :
+            (circular ? DNA16::FROM_ASCII[static_cast<size_t>(s.back())] : 0);
+        nodes.emplace_back(k, static_cast<uint8_t>((in << 4) | out));
+      }
+    }
+
+    /// compact the nodes, which are inserted on rank 0.  checks the local unitigs against the sources, and returns the global unitig count.
+    static size_t compact(std::vector<std::pair<KmerType, uint8_t> > & input, std::vector<std::string> const & sources,
+                          mxx::comm const & comm) {
+      NodeMapType nodes(comm);
+      if (comm.rank() != 0) input.clear();
+      nodes.insert(input);
+
+      std::vector<std::string> unitigs = nodes.compact_unitigs();
+
+      size_t kmers = 0;
+      for (auto const & u : unitigs) {
+        EXPECT_GE(u.size(), KmerType::size);
+        kmers += u.size() - KmerType::size + 1;
+
+        bool found = false;
+        for (auto const & s : sources) found |= (s.find(u) != std::string::npos);
+        EXPECT_TRUE(found) << "unitig " << u << " is not in the input";
+      }
+
+      // every node is in exactly 1 unitig.
+      EXPECT_EQ(nodes.size(), ::mxx::allreduce(kmers, comm));
+
+      return ::mxx::allreduce(unitigs.size(), comm);
+    }
+};
+
+
+TEST_F(UnitigCompactionTest, linear)
+{
+  mxx::comm comm;
+
+  std::string s = random_seq(1000, 17);
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  add_nodes(s, false, input);
+
+  EXPECT_EQ(1UL, compact(input, std::vector<std::string>(1, s), comm));
+}
+
+TEST_F(UnitigCompactionTest, branch)
+{
+  mxx::comm comm;
+
+  // 2 sequences sharing a 20 character prefix.  the shared k-mers form 1 unitig, and each branch another.
+  std::string prefix = random_seq(20, 23);
+  std::string a = prefix + "A" + random_seq(300, 29);
+  std::string b = prefix + "C" + random_seq(300, 31);
+
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  add_nodes(a, false, input);
+  add_nodes(b, false, input);
+
+  std::vector<std::string> sources;
+  sources.push_back(a);
+  sources.push_back(b);
+  EXPECT_EQ(3UL, compact(input, sources, comm));
+}
+
+TEST_F(UnitigCompactionTest, cycle)
+{
+  mxx::comm comm;
+
+  // a circular sequence has no head.  it is cut at its smallest k-mer, and reported as 1 unitig.
+  std::string s = random_seq(500, 37);
+  std::vector<std::pair<KmerType, uint8_t> > input;
+  add_nodes(s, true, input);
+
+  EXPECT_EQ(1UL, compact(input, std::vector<std::string>(1, s + s), comm));
+}
+
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_de_bruijn_node_trait.cpp
+ *   test that merging pre-reduced nodes gives the same node as updating with all the edges,
+ *   and that the packed counters match edge_counts up to saturation.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <algorithm>  // min
+#include <type_traits>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+
+template <typename Node>
+class DeBruijnNodeMergeTest : public ::testing::Test {
+  protected:
+    /// random [in, out] DNA16 edges of single characters, or 0 for a sequence end.
+    static std::vector<uint8_t> random_edges(size_t n, unsigned seed) {
+      std::mt19937 gen(seed);
+      std::vector<uint8_t> edges;
+      for (size_t i = 0; i < n; ++i) {
+        uint8_t in = (gen() % 5 == 0) ? 0 : (1 << (gen() % 4));
+        uint8_t out = (gen() % 5 == 0) ? 0 : (1 << (gen() % 4));
+        edges.push_back(static_cast<uint8_t>((in << 4) | out));
+      }
+      return edges;
+    }
+
+    static void check(size_t n, size_t split) {
+      std::vector<uint8_t> edges = random_edges(n, 13 + n);
+
+      Node all, first, second;
+      for (size_t i = 0; i < edges.size(); ++i) {
+        all.update(edges[i]);
+        if (i < split) first.update(edges[i]);
+        else second.update(edges[i]);
+      }
+      first.merge(second);
+
+      for (uint8_t j = 0; j < 8; ++j) {
+        EXPECT_EQ(all.get_edge_frequency(j), first.get_edge_frequency(j)) << "edge " << static_cast<int>(j);
+      }
+    }
+};
+
+typedef ::testing::Types<
+    bliss::de_bruijn::node::edge_counts<bliss::common::DNA16, uint32_t>,
+    bliss::de_bruijn::node::edge_counts<bliss::common::DNA16, uint16_t>,
+    bliss::de_bruijn::node::edge_counts<bliss::common::DNA16, uint8_t>,
+    bliss::de_bruijn::node::edge_exists<bliss::common::DNA16>,
+    bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA16, 4>,
+    bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA16, 8>
+> DeBruijnNodeTypes;
+
+TYPED_TEST_CASE(DeBruijnNodeMergeTest, DeBruijnNodeTypes);
+
+TYPED_TEST(DeBruijnNodeMergeTest, merge)
+{
+  this->check(100, 30);
+  this->check(100, 0);
+  this->check(100, 100);
+}
+
+TYPED_TEST(DeBruijnNodeMergeTest, merge_saturated)
+{
+  // more than 255 of each edge.  8 bit counts clamp in both update and merge.
+  this->check(5000, 2000);
+}
+
+
+template <typename Packed>
+class PackedEdgeCountsTest : public ::testing::Test {};
+
+typedef ::testing::Types<
+    bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA16, 4>,
+    bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA16, 8>
+> PackedEdgeCountsTypes;
+
+TYPED_TEST_CASE(PackedEdgeCountsTest, PackedEdgeCountsTypes);
+
+TYPED_TEST(PackedEdgeCountsTest, matches_edge_counts)
+{
+  uint32_t max_count = std::is_same<typename TypeParam::WordType, uint32_t>::value ? 15 : 255;
+
+  std::mt19937 gen(7);
+  TypeParam packed;
+  bliss::de_bruijn::node::edge_counts<bliss::common::DNA16, uint32_t> full;
+
+  // check as the counters fill up and saturate.
+  for (size_t i = 0; i < 3000; ++i) {
+    uint8_t exts = static_cast<uint8_t>(gen() & 0xFF);  // multiple chars per edge, as in DNA16
+    packed.update(exts);
+    full.update(exts);
+
+    if ((i % 100) != 0) continue;
+    for (uint8_t j = 0; j < 8; ++j) {
+      EXPECT_EQ(std::min(full.get_edge_frequency(j), max_count), static_cast<uint32_t>(packed.get_edge_frequency(j)));
+    }
+  }
+}
+
+TEST(PackedEdgeCounts, size)
+{
+  EXPECT_EQ(4UL, sizeof(bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA16, 4>));
+  EXPECT_EQ(8UL, sizeof(bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA16, 8>));
+}
+
+TEST(PackedEdgeCounts, dna)
+{
+  // DNA edges are single characters, 0 1 2 3 for ACGT.
+  bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA, 4> packed;
+  packed.update(static_cast<uint8_t>((2 << 4) | 1));  // in G, out C
+  packed.update(static_cast<uint8_t>((2 << 4) | 3));  // in G, out T
+
+  EXPECT_EQ(0, packed.get_edge_frequency(0));
+  EXPECT_EQ(1, packed.get_edge_frequency(1));
+  EXPECT_EQ(1, packed.get_edge_frequency(3));
+  EXPECT_EQ(2, packed.get_edge_frequency(6));
+}
+
+TEST(ProjectEdgeBits, matches_edge_exists)
+{
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> distribution(0, 255);
+
+  bliss::de_bruijn::node::edge_counts<bliss::common::DNA16, uint32_t> counts;
+  bliss::de_bruijn::node::packed_edge_counts<bliss::common::DNA16, 4> packed;
+  bliss::de_bruijn::node::edge_exists<bliss::common::DNA16> exists;
+  bliss::de_bruijn::node::project_edge_bits proj;
+
+  EXPECT_EQ(0, proj(std::make_pair(1, counts)).second);
+  for (int i = 0; i < 5; ++i) {
+    uint8_t exts = static_cast<uint8_t>(distribution(generator)) & 0x35;  // some edges never set
+    counts.update(exts);
+    packed.update(exts);
+    exists.update(exts);
+
+    auto x = proj(std::make_pair(i, counts));
+    EXPECT_EQ(i, x.first);
+    EXPECT_EQ(exists.counts, x.second);
+    EXPECT_EQ(exists.counts, proj(std::make_pair(i, packed)).second);
+    EXPECT_EQ(exists.counts, proj(std::make_pair(i, exists)).second);
+  }
+}
+
+TEST(NodeUtils, get_neighbor)
+{
+  using KmerType = bliss::common::Kmer<11, bliss::common::DNA, uint64_t>;
+  using EdgeType = bliss::de_bruijn::node::edge_exists<bliss::common::DNA16>;
+  using NodeUtils = bliss::de_bruijn::node::node_utils<KmerType, EdgeType>;
+
+  KmerType k;
+  for (unsigned int i = 0; i < KmerType::size; ++i) k.nextFromChar(i % 4);
+
+  // all edges set:  the neighbors are the out neighbors then the in neighbors.
+  EdgeType all;
+  all.counts = 0xFF;
+  std::vector<KmerType> out, in;
+  NodeUtils::get_out_neighbors(k, all, out);
+  NodeUtils::get_in_neighbors(k, all, in);
+  ASSERT_EQ(4UL, out.size());
+  ASSERT_EQ(4UL, in.size());
+  for (uint8_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(out[i], NodeUtils::get_neighbor(k, i));
+    EXPECT_EQ(in[i], NodeUtils::get_neighbor(k, i + 4));
+  }
+}
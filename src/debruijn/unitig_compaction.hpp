@@ -0,0 +1,314 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    unitig_compaction.hpp
+ * @ingroup debruijn
+ * @brief   distributed compaction of the non-branching paths of a de Bruijn graph into unitigs.
+ * @details u -> v is a unitig link if u has exactly 1 out edge, to v, and v has exactly 1 in edge, from u.
+ *          links are found with 1 exchange.  every node then finds the head of its chain and its distance from the head
+ *          by pointer jumping (list ranking), 1 query round per doubling of the jump length, so O(log n) all-to-all rounds
+ *          in total instead of a walk per chain.  chains that are cycles never reach a head.  they are cut at their smallest
+ *          k-mer, which is also found during the jumping, and ranked again.
+ *          finally each node sends its last character to the owner of its head, which assembles the unitig.  the unitigs
+ *          are returned on the owners of their heads, so the output is spread over the processes.
+ *
+ *          the nodes are used as stored, i.e. 1 node per strand k-mer (de_bruijn_nodes_distributed does not canonicalize).
+ *          if both strands of a k-mer are stored, the reverse complement of a unitig is reported as a separate unitig.
+ */
+#ifndef SRC_DEBRUIJN_UNITIG_COMPACTION_HPP_
+#define SRC_DEBRUIJN_UNITIG_COMPACTION_HPP_
+
+#include <vector>
+#include <string>
+#include <utility>    // pair
+#include <algorithm>  // sort, lower_bound, min
+#include <cstdint>    // uint64_t
+#include <cassert>
+
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+
+#include "io/mxx_support.hpp"
+#include "io/incremental_mxx.hpp"
+#include "utils/kmer_utils.hpp"
+#include "debruijn/de_bruijn_node_trait.hpp"
+
+namespace bliss {
+  namespace de_bruijn {
+
+    /**
+     * @brief compacts the local nodes of a distributed de Bruijn graph into unitigs.  collective.
+     * @tparam Kmer    node type.
+     * @tparam ToRank  maps a node to the rank that stores it.  same as the node map's key_to_rank.
+     */
+    template <typename Kmer, typename ToRank>
+    class unitig_compactor {
+
+      protected:
+        /// pointer jumping state of a local node.
+        struct chain_node {
+            Kmer kmer;
+            /// the in neighbor, if the node has exactly one.  a chain link if has_pred.
+            Kmer pred;
+            /// current jump target, toward the head of the chain.
+            Kmer anc;
+            /// smallest k-mer from anc to this node.  the smallest in the cycle for cycle nodes after enough rounds.
+            Kmer min_kmer;
+            /// number of links from anc to this node.
+            uint64_t dist;
+            bool single_in;
+            bool has_pred;
+            /// anc is the head of the chain.
+            bool done;
+        };
+
+        /// reply to a jump query:  ((anc, min_kmer), (dist << 1) | done)
+        using jump_type = ::std::pair<::std::pair<Kmer, Kmer>, uint64_t>;
+        /// node data sent to the owner of its chain's head:  (head, (dist, V))
+        template <typename V>
+        using chain_piece = ::std::pair<Kmer, ::std::pair<uint64_t, V> >;
+        using piece_type = chain_piece<Kmer>;
+
+        ToRank const & to_rank;
+        const mxx::comm & comm;
+
+        /// local nodes, sorted by k-mer.
+        ::std::vector<chain_node> nodes;
+
+        size_t index_of(Kmer const & k) const {
+          auto it = ::std::lower_bound(nodes.begin(), nodes.end(), k, [](chain_node const & x, Kmer const & y){
+            return x.kmer < y;
+          });
+          return ((it != nodes.end()) && (it->kmer == k)) ? ::std::distance(nodes.begin(), it) : nodes.size();
+        }
+
+        /// send each element to the rank given by rank_of.  input is replaced by the received elements.
+        template <typename V, typename RankOf>
+        void exchange(::std::vector<V> & input, RankOf const & rank_of) const {
+          if (comm.size() == 1) return;
+
+          ::std::vector<size_t> recv_counts;
+          ::std::vector<size_t> i2o;
+          ::std::vector<V> buffer;
+          ::imxx::distribute(input, rank_of, recv_counts, i2o, buffer, comm);
+          input.swap(buffer);
+        }
+
+        /// set the jump state from the links.  a node without a link is its own head.
+        static void start(chain_node & x) {
+          x.anc = x.has_pred ? x.pred : x.kmer;
+          x.min_kmer = (x.has_pred && (x.pred < x.kmer)) ? x.pred : x.kmer;
+          x.dist = x.has_pred ? 1 : 0;
+          x.done = !x.has_pred;
+        }
+
+        /// collect the local nodes and the unitig links, with 1 exchange.
+        template <typename LocalMap>
+        void link(LocalMap const & map) {
+          using EdgeType = typename LocalMap::mapped_type;
+          using NodeUtils = ::bliss::de_bruijn::node::node_utils<Kmer, EdgeType>;
+
+          nodes.clear();
+          nodes.reserve(map.size());
+
+          ::std::vector<::std::pair<Kmer, Kmer> > links;  // (v, u) for the out edge u -> v
+          ::std::vector<Kmer> neighbors;
+          for (auto it = map.begin(); it != map.end(); ++it) {
+            chain_node x = chain_node();
+            x.kmer = it->first;
+
+            NodeUtils::get_in_neighbors(it->first, it->second, neighbors);
+            x.single_in = (neighbors.size() == 1) && !(neighbors.front() == it->first);
+            if (x.single_in) x.pred = neighbors.front();
+            x.has_pred = false;
+            nodes.push_back(x);
+
+            // self loops are not chain links.
+            NodeUtils::get_out_neighbors(it->first, it->second, neighbors);
+            if ((neighbors.size() == 1) && !(neighbors.front() == it->first))
+              links.emplace_back(neighbors.front(), it->first);
+          }
+          ::std::sort(nodes.begin(), nodes.end(), [](chain_node const & x, chain_node const & y){
+            return x.kmer < y.kmer;
+          });
+
+          this->exchange(links, [this](::std::pair<Kmer, Kmer> const & x){ return this->to_rank(x.first); });
+
+          // v accepts u as its predecessor if u is also its only in neighbor.
+          for (auto const & l : links) {
+            size_t i = index_of(l.first);
+            if ((i < nodes.size()) && nodes[i].single_in && (nodes[i].pred == l.second)) nodes[i].has_pred = true;
+          }
+        }
+
+        /**
+         * @brief pointer jumping, until all nodes reached their heads or max_rounds.  each round doubles the jump length.
+         * @details  queries are answered from the state of the previous round, then all pending nodes are updated.
+         */
+        void jump(size_t max_rounds) {
+          ::std::vector<size_t> pending;
+          ::std::vector<Kmer> queries;
+          ::std::vector<Kmer> buffer;
+          ::std::vector<size_t> recv_counts;
+          ::std::vector<size_t> i2o;
+          ::std::vector<jump_type> answers;
+
+          bool remote = comm.size() > 1;
+
+          for (size_t round = 0; round < max_rounds; ++round) {
+            pending.clear();
+            queries.clear();
+            for (size_t i = 0; i < nodes.size(); ++i) {
+              if (nodes[i].done) continue;
+              pending.push_back(i);
+              queries.push_back(nodes[i].anc);
+            }
+            if (remote) {
+              if (!::mxx::any_of(!pending.empty(), comm)) break;
+            } else if (pending.empty()) break;
+
+            if (remote) ::imxx::distribute(queries, to_rank, recv_counts, i2o, buffer, comm);
+            else buffer.swap(queries);
+
+            answers.clear();
+            answers.reserve(buffer.size());
+            for (auto const & q : buffer) {
+              size_t i = index_of(q);
+              assert((i < nodes.size()) && "jump target is not a local node");
+              chain_node const & a = nodes[i];
+              answers.emplace_back(::std::make_pair(a.anc, a.min_kmer), (a.dist << 1) | (a.done ? 1 : 0));
+            }
+            if (remote) answers = ::mxx::all2allv(answers, recv_counts, comm);
+
+            for (size_t j = 0; j < pending.size(); ++j) {
+              jump_type const & r = answers[remote ? i2o[j] : j];
+              chain_node & x = nodes[pending[j]];
+              x.anc = r.first.first;
+              if (r.first.second < x.min_kmer) x.min_kmer = r.first.second;
+              x.dist += (r.second >> 1);
+              x.done = (r.second & 1) == 1;
+            }
+          }
+        }
+
+        /// send the pieces to the owners of their heads, and sort them by head, then by distance.  each chain is then contiguous and in order.
+        template <typename V>
+        void gather(::std::vector<chain_piece<V> > & pieces) const {
+          this->exchange(pieces, [this](chain_piece<V> const & x){ return this->to_rank(x.first); });
+
+          ::std::sort(pieces.begin(), pieces.end(), [](chain_piece<V> const & x, chain_piece<V> const & y){
+            return (x.first < y.first) || ((x.first == y.first) && (x.second.first < y.second.first));
+          });
+        }
+
+        /**
+         * @brief find the head of the chain of each local node, and the distance from it.  collective.
+         * @details  after this, nodes[i].anc is the head and nodes[i].dist the distance, for all nodes.
+         */
+        template <typename LocalMap>
+        void rank(LocalMap const & map) {
+          this->link(map);
+          for (auto & x : nodes) start(x);
+
+          // the longest chain has at most n links.  1 more round so that the min k-mer covers the longest cycle.
+          size_t n = ::mxx::allreduce(nodes.size(), comm);
+          size_t rounds = 1;
+          while ((rounds < 64) && ((1ULL << rounds) < n)) ++rounds;
+          ++rounds;
+
+          this->jump(rounds);
+
+          // nodes still not at a head are on cycles.  cut each cycle before its smallest k-mer and rank again.
+          bool cycles = false;
+          for (auto & x : nodes) {
+            if (x.done) continue;
+            cycles = true;
+            if (x.kmer == x.min_kmer) x.has_pred = false;
+          }
+          if ((comm.size() > 1) ? ::mxx::any_of(cycles, comm) : cycles) {
+            for (auto & x : nodes) {
+              if (!x.done) start(x);
+            }
+            this->jump(rounds);
+          }
+        }
+
+        /// rank the chains, and gather them with their nodes' edges on the owners of their heads.  nodes is released.
+        template <typename LocalMap>
+        void gather_chains(LocalMap const & map,
+                           ::std::vector<chain_piece<::std::pair<Kmer, typename LocalMap::mapped_type> > > & pieces) {
+          this->rank(map);
+
+          pieces.clear();
+          pieces.reserve(nodes.size());
+          for (auto const & x : nodes) {
+            pieces.emplace_back(x.anc, ::std::make_pair(x.dist, ::std::make_pair(x.kmer, map.find(x.kmer)->second)));
+          }
+          ::std::vector<chain_node>().swap(nodes);
+
+          this->gather(pieces);
+        }
+
+        /// assemble the unitigs whose heads are local.  the nodes are exchanged to the owners of their heads.
+        ::std::vector<::std::string> assemble() const {
+          ::std::vector<piece_type> pieces;
+          pieces.reserve(nodes.size());
+          for (auto const & x : nodes) {
+            pieces.emplace_back(x.anc, ::std::make_pair(x.dist, x.kmer));
+          }
+          this->gather(pieces);
+
+          constexpr size_t char_mask = (1UL << Kmer::bitsPerChar) - 1;
+          ::std::vector<::std::string> unitigs;
+          for (size_t i = 0; i < pieces.size(); ) {
+            // the head is at distance 0.
+            assert((pieces[i].second.first == 0) && "unitig does not start at its head");
+            ::std::string s = ::bliss::utils::KmerUtils::toASCIIString(pieces[i].second.second);
+            size_t j = i + 1;
+            for (; (j < pieces.size()) && (pieces[j].first == pieces[i].first); ++j) {
+              s.push_back(Kmer::KmerAlphabet::TO_ASCII[static_cast<size_t>(pieces[j].second.second.getData()[0] & char_mask)]);
+            }
+            unitigs.push_back(::std::move(s));
+            i = j;
+          }
+          return unitigs;
+        }
+
+      public:
+        unitig_compactor(ToRank const & _to_rank, const mxx::comm & _comm) : to_rank(_to_rank), comm(_comm) {}
+
+        /**
+         * @brief compact the graph.  collective.
+         * @param map  the local nodes, a map from k-mer to edge_counts or edge_exists.  the neighbors of a node are on
+         *             the ranks given by to_rank.
+         * @return the unitigs whose first k-mer is stored locally, as ASCII strings.
+         */
+        template <typename LocalMap>
+        ::std::vector<::std::string> operator()(LocalMap const & map) {
+          this->rank(map);
+
+          ::std::vector<::std::string> unitigs = this->assemble();
+          ::std::vector<chain_node>().swap(nodes);
+          return unitigs;
+        }
+    };
+
+  } /* namespace de_bruijn */
+} /* namespace bliss */
+
+#endif /* SRC_DEBRUIJN_UNITIG_COMPACTION_HPP_ */
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    build_checkpoint.hpp
+ * @ingroup index
+ * @brief   progress records for checkpointing the streaming index build.
+ * @details a checkpoint of generation g lives in slot g % 2, so the previous checkpoint stays intact while the next is written.
+ *          a slot holds the saved map, "<prefix>.<slot>.<rank>" (see distributed_map_io.hpp), and one progress record per rank,
+ *          "<prefix>.<slot>.progress.<rank>".  the progress record is written last, through a temporary file and a rename,
+ *          so a record that reads back as valid always describes a complete map file.
+ */
+
+#ifndef SRC_INDEX_BUILD_CHECKPOINT_HPP_
+#define SRC_INDEX_BUILD_CHECKPOINT_HPP_
+
+#include <string>
+#include <cstring>      // memcmp, strerror
+#include <cstdint>
+#include <cstdio>       // rename
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>     // read, write, close
+#include <sys/stat.h>   // stat
+#include <fcntl.h>      // open
+#include <errno.h>
+
+#include "io/io_exception.hpp"
+#include "utils/exception_handling.hpp"
+
+namespace bliss
+{
+namespace index
+{
+
+  /// per-rank position of the streaming build at a checkpoint.
+  struct build_progress_record {
+      static constexpr uint32_t current_version = 1;
+      static constexpr uint32_t endian_value = 0x01020304;
+
+      char magic[8];
+      uint32_t version;
+      uint32_t endian_check;
+
+      int32_t comm_size;
+      int32_t comm_rank;
+
+      /// checkpoint generation, starting from 1.
+      uint64_t generation;
+
+      /// identifies the input file.
+      uint64_t file_bytes;
+      uint64_t file_name_hash;
+
+      /// chunks consumed, collectively the same on all ranks.
+      uint64_t chunks;
+      /// sequence records consumed in the local partition.  skipped on resume.
+      uint64_t steps;
+      /// kmers inserted from the local partition.
+      uint64_t kmers;
+      /// file offset of the first record not consumed.
+      uint64_t next_offset;
+  };
+
+  /// FNV-1a hash of a string.
+  inline uint64_t checkpoint_hash(::std::string const & s) {
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : s) {
+      h ^= static_cast<uint8_t>(c);
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  /// size of the input file in bytes, or 0 if it cannot be stat'ed.
+  inline uint64_t checkpoint_file_bytes(::std::string const & filename) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) == -1) return 0;
+    return st.st_size;
+  }
+
+  /// progress record for the input file, without the position fields.
+  inline build_progress_record make_build_progress_record(::std::string const & input, int comm_size, int comm_rank) {
+    build_progress_record r;
+    memset(&r, 0, sizeof(build_progress_record));
+    memcpy(r.magic, "BLISSCKP", 8);
+    r.version = build_progress_record::current_version;
+    r.endian_check = build_progress_record::endian_value;
+    r.comm_size = comm_size;
+    r.comm_rank = comm_rank;
+    r.file_bytes = checkpoint_file_bytes(input);
+    r.file_name_hash = checkpoint_hash(input);
+    return r;
+  }
+
+  /// progress record for a list of input files read as one.
+  inline build_progress_record make_build_progress_record(::std::vector<::std::string> const & inputs, int comm_size, int comm_rank) {
+    ::std::string names;
+    for (auto const & input : inputs) names.append(input).append("\n");
+    build_progress_record r = make_build_progress_record(names, comm_size, comm_rank);
+    r.file_bytes = 0;
+    for (auto const & input : inputs) r.file_bytes += checkpoint_file_bytes(input);
+    return r;
+  }
+
+  /// map file prefix of the slot holding generation gen.
+  inline ::std::string checkpoint_slot_prefix(::std::string const & prefix, uint64_t gen) {
+    ::std::stringstream ss;
+    ss << prefix << "." << (gen % 2);
+    return ss.str();
+  }
+
+  /// progress record file of rank for generation gen.
+  inline ::std::string checkpoint_progress_file_name(::std::string const & prefix, uint64_t gen, int rank) {
+    ::std::stringstream ss;
+    ss << checkpoint_slot_prefix(prefix, gen) << ".progress." << rank;
+    return ss.str();
+  }
+
+  /**
+   * @brief write a progress record atomically:  to "<filename>.tmp", then renamed.
+   * @throw IOException if the record cannot be written.
+   */
+  inline void write_build_progress_record(::std::string const & filename, build_progress_record const & r) {
+    ::std::string tmp = filename + ".tmp";
+
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1) {
+      int myerr = errno;
+      ::std::stringstream ss;
+      ss << "ERROR in write_build_progress_record open: [" << tmp << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+    }
+
+    char const * ptr = reinterpret_cast<char const *>(&r);
+    size_t remaining = sizeof(build_progress_record);
+    while (remaining > 0) {
+      ssize_t written = ::write(fd, ptr, remaining);
+      if (written < 0) {
+        int myerr = errno;
+        if (myerr == EINTR) continue;
+        close(fd);
+        ::std::stringstream ss;
+        ss << "ERROR in write_build_progress_record write: [" << tmp << "] error " << myerr << ": " << strerror(myerr);
+        throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+      }
+      ptr += written;
+      remaining -= written;
+    }
+
+    // the map file and the record must be durable before the rename publishes the record.
+    fsync(fd);
+    close(fd);
+
+    if (::rename(tmp.c_str(), filename.c_str()) == -1) {
+      int myerr = errno;
+      ::std::stringstream ss;
+      ss << "ERROR in write_build_progress_record rename: [" << tmp << "] to [" << filename << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+    }
+  }
+
+  /**
+   * @brief read a progress record and check it against expected (from make_build_progress_record).
+   * @return false if the file is missing, truncated, or written for a different input, process count, or rank.
+   */
+  inline bool read_build_progress_record(::std::string const & filename, build_progress_record const & expected,
+                                         build_progress_record & r) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+
+    char * ptr = reinterpret_cast<char *>(&r);
+    size_t remaining = sizeof(build_progress_record);
+    while (remaining > 0) {
+      ssize_t got = ::read(fd, ptr, remaining);
+      if (got < 0 && errno == EINTR) continue;
+      if (got <= 0) break;
+      ptr += got;
+      remaining -= got;
+    }
+    close(fd);
+
+    return (remaining == 0) &&
+        (memcmp(r.magic, expected.magic, 8) == 0) &&
+        (r.version == expected.version) &&
+        (r.endian_check == expected.endian_check) &&
+        (r.comm_size == expected.comm_size) &&
+        (r.comm_rank == expected.comm_rank) &&
+        (r.file_bytes == expected.file_bytes) &&
+        (r.file_name_hash == expected.file_name_hash) &&
+        (r.generation > 0);
+  }
+
+} /* namespace index */
+} /* namespace bliss */
+
+#endif /* SRC_INDEX_BUILD_CHECKPOINT_HPP_ */
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    index_selector.hpp
+ * @ingroup index
+ * @brief   choose the backend of a k-mer count index at runtime, from a profile of the input.
+ * @details the best count map depends on the data:  sorting is balanced and compact, and below a few million entries
+ *          per rank builds faster than hashing, but every lookup is a binary search (see test/benchmark/hash_vs_sort.cpp).
+ *          the densehash map is the fastest to query.  the compact counting map (8 bit counters, see
+ *          compact_counting_map.hpp) is slower than densehash but has about 2/3 of its footprint when most counts are
+ *          small.
+ *
+ *          profile_kmers makes an index_profile of the parsed k-mers:  the global count, the distinct canonical count
+ *          from a HyperLogLog, the key size and the number of queries expected.  choose_count_backend applies the rules
+ *          below, with the thresholds of selector_params, in order:
+ *
+ *            SORTED     distinct k-mers per rank <= sorted_max_per_rank, and queries per distinct k-mer
+ *                       <= sorted_max_query_ratio.
+ *            COUNTING   the densehash table would need more than memory_per_rank bytes per rank, and the mean
+ *                       multiplicity is <= counting_max_multiplicity, so that few counts overflow the 8 bit counters.
+ *            DENSEHASH  otherwise.
+ *
+ *          dispatch_count_backend then calls a functor with the CountIndex type of the chosen backend, as
+ *          dispatch_kmer_size does with the Kmer type of the runtime k.  all backends are canonical count indices with
+ *          the same KmerParser, so k-mers parsed before the choice can be inserted into any of them:
+ *
+ *            struct run {
+ *              template <typename IndexType>
+ *              int operator()(std::vector<typename IndexType::KmerType> & kmers, mxx::comm const & comm) const { ... }
+ *            };
+ *
+ *            auto profile = profile_kmers(kmers, queries, comm);
+ *            int ret = dispatch_count_backend<KmerType>(choose_count_backend(profile), run(), kmers, comm);
+ */
+#ifndef SRC_INDEX_INDEX_SELECTOR_HPP_
+#define SRC_INDEX_INDEX_SELECTOR_HPP_
+
+#include "bliss-config.hpp"
+
+#include "mpi.h"
+
+#include <vector>
+#include <string>
+#include <stdexcept>  // invalid_argument
+#include <utility>    // forward
+#include <algorithm>  // max
+#include <cstdint>    // uint8_t
+
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+#include "common/kmer_transform.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "containers/distributed_densehash_map.hpp"
+#include "containers/distributed_sorted_map.hpp"
+#include "utils/hyperloglog.hpp"
+
+namespace bliss
+{
+namespace index
+{
+namespace kmer
+{
+
+  /// backend of a count index.
+  enum class CountBackend : int { DENSEHASH = 0, SORTED = 1, COUNTING = 2 };
+
+  inline std::string to_string(CountBackend const b) {
+    switch (b) {
+      case CountBackend::SORTED: return "sorted";
+      case CountBackend::COUNTING: return "counting";
+      default: return "densehash";
+    }
+  }
+
+  /// parse "densehash", "sorted" or "counting".  throws std::invalid_argument otherwise.
+  inline CountBackend parse_count_backend(std::string const & name) {
+    if (name == "densehash") return CountBackend::DENSEHASH;
+    if (name == "sorted") return CountBackend::SORTED;
+    if (name == "counting") return CountBackend::COUNTING;
+    throw std::invalid_argument("unknown count index backend " + name + ".  expected densehash, sorted, or counting");
+  }
+
+
+  /// what the choice is based on.  global values, the same on all ranks.
+  struct index_profile {
+      /// k-mers to be inserted.
+      size_t kmers;
+      /// estimated distinct canonical k-mers.
+      double distinct;
+      /// k-mers expected to be queried (count or find) after the build.
+      size_t queries;
+      /// sizeof the k-mer type.
+      size_t key_bytes;
+      int ranks;
+
+      double distinct_per_rank() const { return distinct / static_cast<double>(std::max(ranks, 1)); }
+
+      /// fraction of the k-mers that repeat an earlier one.
+      double duplicate_rate() const { return (kmers == 0) ? 0.0 : std::max(0.0, 1.0 - distinct / static_cast<double>(kmers)); }
+
+      /// mean count of a distinct k-mer.
+      double multiplicity() const { return (distinct < 1.0) ? 0.0 : static_cast<double>(kmers) / distinct; }
+
+      double query_ratio() const { return (distinct < 1.0) ? 0.0 : static_cast<double>(queries) / distinct; }
+  };
+
+
+  /// thresholds of choose_count_backend.  the defaults are from the hash_vs_sort and BenchmarkKmerIndex runs.
+  struct selector_params {
+      /// largest local table for which sorting beats hashing.
+      double sorted_max_per_rank;
+      /// most queries per distinct k-mer for which the binary searches do not outweigh the faster sorted build.
+      double sorted_max_query_ratio;
+      /// densehash footprint per rank above which the compact counting map is used.
+      double memory_per_rank;
+      /// largest mean multiplicity for the compact counting map.
+      double counting_max_multiplicity;
+
+      selector_params() : sorted_max_per_rank(8.0 * 1024 * 1024), sorted_max_query_ratio(0.25),
+          memory_per_rank(4.0 * 1024 * 1024 * 1024), counting_max_multiplicity(32.0) {}
+  };
+
+
+  /// estimated densehash footprint per rank:  (key, 32 bit count) slots at the default max load factor of 0.5.
+  inline double densehash_bytes_per_rank(index_profile const & p) {
+    return p.distinct_per_rank() * static_cast<double>(p.key_bytes + sizeof(uint32_t)) * 2.0;
+  }
+
+  /// the backend for the profile.  see file description.
+  inline CountBackend choose_count_backend(index_profile const & p, selector_params const & params = selector_params()) {
+    if ((p.distinct_per_rank() <= params.sorted_max_per_rank) && (p.query_ratio() <= params.sorted_max_query_ratio))
+      return CountBackend::SORTED;
+    if ((densehash_bytes_per_rank(p) > params.memory_per_rank) && (p.multiplicity() <= params.counting_max_multiplicity))
+      return CountBackend::COUNTING;
+    return CountBackend::DENSEHASH;
+  }
+
+
+  /**
+   * @brief profile the k-mers of this rank and the number of queries expected on this rank.  collective.
+   * @details the k-mers are made canonical and hashed into a HyperLogLog, whose registers are merged with 1 allreduce.
+   *          1 pass over the k-mers, much cheaper than the build.
+   */
+  template <typename KmerType, uint8_t PRECISION = 12>
+  index_profile profile_kmers(std::vector<KmerType> const & kmers, size_t const local_queries, mxx::comm const & comm) {
+    ::bliss::kmer::transform::lex_less<KmerType> canonical;
+    ::bliss::kmer::hash::murmur64<KmerType, false> hash;
+    ::bliss::utils::hyperloglog<PRECISION> hll;
+    for (auto it = kmers.begin(); it != kmers.end(); ++it) {
+      hll.update(hash(canonical(*it)));
+    }
+
+    std::vector<uint8_t> & regs = hll.get_registers();
+    if (comm.size() > 1)
+      MPI_Allreduce(MPI_IN_PLACE, regs.data(), static_cast<int>(regs.size()), MPI_UINT8_T, MPI_MAX, comm);
+
+    index_profile p;
+    p.kmers = ::mxx::allreduce(kmers.size(), comm);
+    p.queries = ::mxx::allreduce(local_queries, comm);
+    p.distinct = std::min(hll.estimate(), static_cast<double>(p.kmers));
+    p.key_bytes = sizeof(KmerType);
+    p.ranks = comm.size();
+    return p;
+  }
+
+
+  /// the canonical count index types of each backend.
+  template <typename KmerType>
+  struct count_backends {
+      using special_keys = ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true>;
+
+      using densehash = CountIndex<::dsc::counting_densehash_map<KmerType, uint32_t,
+          CanonicalHashMapParams<KmerType>, special_keys> >;
+      using sorted = CountIndex<::dsc::counting_sorted_map<KmerType, uint32_t,
+          CanonicalSortedMapParams<KmerType> > >;
+      using counting = CountIndex<::dsc::compact_counting_map<KmerType, uint32_t,
+          CanonicalHashMapParams<KmerType>, special_keys> >;
+  };
+
+  /**
+   * @brief call f.operator()<IndexType>(args...) with the count index type of backend b, see count_backends.
+   * @details all 3 are instantiated.  they must return the same type.
+   */
+  template <typename KmerType, typename F, typename... Args>
+  auto dispatch_count_backend(CountBackend const b, F && f, Args &&... args)
+    -> decltype(f.template operator()<typename count_backends<KmerType>::densehash>(std::forward<Args>(args)...)) {
+    switch (b) {
+      case CountBackend::SORTED:
+        return f.template operator()<typename count_backends<KmerType>::sorted>(std::forward<Args>(args)...);
+      case CountBackend::COUNTING:
+        return f.template operator()<typename count_backends<KmerType>::counting>(std::forward<Args>(args)...);
+      default:
+        return f.template operator()<typename count_backends<KmerType>::densehash>(std::forward<Args>(args)...);
+    }
+  }
+
+} // namespace kmer
+} // namespace index
+} // namespace bliss
+
+#endif // SRC_INDEX_INDEX_SELECTOR_HPP_
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    job_packing.hpp
+ * @ingroup index
+ * @brief   runs many small independent jobs, e.g. 1 index build per sample, concurrently on groups of ranks.
+ * @details a small sample built on all ranks of a large job spends most of its time in collective latency, and 1 MPI job
+ *          per sample pays the startup each time.  job_packer splits a communicator into groups of consecutive ranks
+ *          (usually on the same nodes), and hands out the jobs through a shared counter:  when a group finishes a job,
+ *          its first rank takes the next one with an MPI_Fetch_and_op on rank 0 of the communicator, and broadcasts it
+ *          to the group.  so a group that drew small samples runs more of them, and no rank coordinates.
+ *
+ *          jobs can be given costs, e.g. file sizes.  they are then handed out largest first, so the last jobs to
+ *          start are the small ones and the groups finish at about the same time.
+ *
+ *          construction and run are collective on the whole communicator.  the job function is called by all ranks of a
+ *          group with the group communicator, and may call any collective on it, e.g. Index::build_mmap.  it must not
+ *          use the whole communicator.
+ */
+#ifndef SRC_INDEX_JOB_PACKING_HPP_
+#define SRC_INDEX_JOB_PACKING_HPP_
+
+#include "bliss-config.hpp"
+
+#include <mpi.h>
+
+#include <vector>
+#include <algorithm>   // sort, min, max
+#include <numeric>     // iota
+#include <cstdint>     // uint64_t
+#include <cstddef>     // size_t
+
+#include "mxx/comm.hpp"
+
+namespace bliss
+{
+namespace index
+{
+
+  /**
+   * @brief ranks per group for a sample of sample_bytes, at about bytes_per_rank each.
+   * @details the smallest power of 2 that fits, at most max_ranks, so that groups of it tile a power of 2 sized job.
+   */
+  inline int ranks_for_bytes(size_t const sample_bytes, size_t const bytes_per_rank, int const max_ranks) {
+    int p = 1;
+    size_t const per = ::std::max(bytes_per_rank, static_cast<size_t>(1));
+    while (((p << 1) <= max_ranks) && (static_cast<size_t>(p) * per < sample_bytes)) p <<= 1;
+    return p;
+  }
+
+
+  /**
+   * @brief splits a communicator into groups and runs independent jobs on them, see file description.
+   */
+  class job_packer {
+
+    protected:
+      /// the communicator that is split.  the job counter lives on its rank 0.
+      ::mxx::comm world;
+      /// this rank's group.
+      ::mxx::comm group;
+
+      int group_id;
+      int ngroups;
+
+    public:
+      /**
+       * @brief split _comm into groups of ranks_per_group consecutive ranks.  collective.
+       * @details the last group is smaller if ranks_per_group does not divide the size of _comm.
+       */
+      job_packer(::mxx::comm const & _comm, int const ranks_per_group) :
+        world(_comm.copy()),
+        group(_comm.split(_comm.rank() / ::std::max(ranks_per_group, 1))),
+        group_id(_comm.rank() / ::std::max(ranks_per_group, 1)),
+        ngroups((_comm.size() + ::std::max(ranks_per_group, 1) - 1) / ::std::max(ranks_per_group, 1)) {
+      }
+
+      job_packer(job_packer const &) = delete;
+      job_packer & operator=(job_packer const &) = delete;
+
+      /// the communicator of this rank's group.  jobs run on it.
+      ::mxx::comm const & get_group_comm() const { return group; }
+
+      /// this rank's group, in [0, get_num_groups()).
+      int get_group_id() const { return group_id; }
+
+      int get_num_groups() const { return ngroups; }
+
+      /**
+       * @brief run jobs 0 .. njobs-1, in order, each on the first group that is free.  collective.
+       * @param f   called as f(job, group_comm) by all ranks of the group that runs the job.
+       * @return the jobs this rank's group ran, in the order it ran them.
+       */
+      template <typename F>
+      ::std::vector<size_t> run(size_t const njobs, F f) {
+        ::std::vector<size_t> order(njobs);
+        ::std::iota(order.begin(), order.end(), 0);
+        return run_ordered(order, f);
+      }
+
+      /**
+       * @brief run jobs 0 .. costs.size()-1, largest cost first, each on the first group that is free.  collective.
+       * @details costs must be the same on all ranks.  ties keep the job order.
+       * @param f   called as f(job, group_comm) by all ranks of the group that runs the job.
+       * @return the jobs this rank's group ran, in the order it ran them.
+       */
+      template <typename F>
+      ::std::vector<size_t> run(::std::vector<size_t> const & costs, F f) {
+        ::std::vector<size_t> order(costs.size());
+        ::std::iota(order.begin(), order.end(), 0);
+        ::std::stable_sort(order.begin(), order.end(), [&costs](size_t const & x, size_t const & y) {
+          return costs[x] > costs[y];
+        });
+        return run_ordered(order, f);
+      }
+
+    protected:
+
+      /// hand out order[0], order[1], ... through the shared counter.
+      template <typename F>
+      ::std::vector<size_t> run_ordered(::std::vector<size_t> const & order, F f) {
+        // the next position in order.  exposed only on rank 0, the others expose an empty window.
+        uint64_t next = 0;
+        MPI_Win win;
+        MPI_Win_create(&next, (world.rank() == 0) ? sizeof(uint64_t) : 0, sizeof(uint64_t), MPI_INFO_NULL, world, &win);
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+        ::std::vector<size_t> ran;
+        uint64_t const one = 1;
+        uint64_t pos = 0;
+        while (true) {
+          if (group.rank() == 0) {
+            MPI_Fetch_and_op(&one, &pos, MPI_UINT64_T, 0, 0, MPI_SUM, win);
+            MPI_Win_flush(0, win);
+          }
+          MPI_Bcast(&pos, 1, MPI_UINT64_T, 0, group);
+          if (pos >= order.size()) break;
+
+          f(order[pos], static_cast<::mxx::comm const &>(group));
+          ran.emplace_back(order[pos]);
+        }
+
+        MPI_Win_unlock_all(win);
+        MPI_Win_free(&win);   // collective on world:  returns when all groups are out of jobs.
+
+        return ran;
+      }
+  };
+
+} // namespace index
+} // namespace bliss
+
+#endif // SRC_INDEX_JOB_PACKING_HPP_
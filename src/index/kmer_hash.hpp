@@ -46,6 +46,13 @@
  *            we restrict our hash() functions to return 64 bits, and make suffix hash() to be the same as hash().
  *
  *
+ *          in practice the distribution hash and the storage hash are separate functors, and the 2 are computed on different
+ *          ranks (sender and owner), so each kmer is hashed in full twice.  carrying the hash through the all-to-all would
+ *          cost another 8 bytes per element and the google hash tables cannot take a precomputed hash, so murmur_fold instead
+ *          makes the second hash cheap:  the prefix version is the 128 bit murmur hash, as for murmur, and the suffix version
+ *          is 1 finalizer on the xor-folded words of the kmer.  the suffix only needs to spread the kmers that the prefix
+ *          already sent to this rank, so this is sufficient, and costs the same for all k.  see DistHashMurmur / StoreHashFold.
+ *
  *          namespace bliss::hash::kmer has a generic hash function that can work with kmer, kmer xor rev comp, computed or provided.
  *          the generic hash function also allows customization via bliss::hash::kmer::detail::{std,identity,murmur,farm} specializations
  *
@@ -59,7 +66,14 @@
 #include <tuple>  // for hash - std::pair
 #include <exception>  // for hash - std::system_error
 #include <algorithm>
+#include <limits>
 #include <type_traits>  // enable_if
+#include <cstring>  // memcpy
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "utils/cpu_features.hpp"  // _mm_crc32_u64, and runtime dispatch.
 
 #include "common/alphabets.hpp"
 #include "common/kmer.hpp"
@@ -313,6 +327,458 @@ namespace bliss {
       constexpr uint8_t farm<KMER, Prefix>::batch_size;
 
 
+      /**
+       * @brief  Kmer hash with the murmur3 64 bit finalizer, chained over the 64 bit words of the kmer.  64 bit.
+       * @details 1 multiply-xorshift chain per word, so it is cheaper than murmur and farm for short kmers, and vectorizes:
+       *          hash_batch hashes batch_size kmers at once, 8 with AVX-512DQ and 4 with AVX2 (64 bit multiplies
+       *          emulated with 32 bit ones), with the same results as operator().  without either, batch_size is 1.
+       *          the prefix version uses a different seed, as for farm.
+       */
+      template <typename KMER, bool Prefix = false>
+      class murmur64 {
+
+        protected:
+          static constexpr unsigned int nBytes = (KMER::nBits + 7) / 8;
+          static constexpr unsigned int nWords = (nBytes + 7) / 8;
+
+          uint64_t seed;
+
+          static constexpr uint64_t c1 = 0xff51afd7ed558ccdULL;
+          static constexpr uint64_t c2 = 0xc4ceb9fe1a85ec53ULL;
+
+          static inline uint64_t mix(uint64_t h) {
+            h ^= h >> 33;
+            h *= c1;
+            h ^= h >> 33;
+            h *= c2;
+            h ^= h >> 33;
+            return h;
+          }
+
+          /// i-th 64 bit word of the kmer's bytes, zero padded.
+          static inline uint64_t word(KMER const & kmer, unsigned int const & i) {
+            uint64_t w = 0;
+            memcpy(&w, reinterpret_cast<const char*>(kmer.getData()) + i * 8, ((i + 1) * 8 <= nBytes) ? 8 : (nBytes - i * 8));
+            return w;
+          }
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+          static inline __m512i mix(__m512i h) {
+            h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 33));
+            h = _mm512_mullo_epi64(h, _mm512_set1_epi64(c1));
+            h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 33));
+            h = _mm512_mullo_epi64(h, _mm512_set1_epi64(c2));
+            return _mm512_xor_si512(h, _mm512_srli_epi64(h, 33));
+          }
+#elif defined(__AVX2__)
+          /// low 64 bits of a * b, per lane, from 3 32x32 bit multiplies.
+          static inline __m256i mullo(__m256i a, __m256i b) {
+            __m256i lo = _mm256_mul_epu32(a, b);
+            __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                             _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+            return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+          }
+          static inline __m256i mix(__m256i h) {
+            h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+            h = mullo(h, _mm256_set1_epi64x(c1));
+            h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+            h = mullo(h, _mm256_set1_epi64x(c2));
+            return _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+          }
+#endif
+
+        public:
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+          static constexpr uint8_t batch_size = 8;
+#elif defined(__AVX2__)
+          static constexpr uint8_t batch_size = 4;
+#else
+          static constexpr uint8_t batch_size = 1;
+#endif
+
+          static const unsigned int default_init_value = 24U;   // ignored, as for murmur.
+
+          murmur64(const unsigned int prefix_bits = default_init_value, uint32_t const & _seed = 42 ) :
+            seed(Prefix ? (static_cast<uint64_t>(_seed) << 1) - 1 : _seed) {};
+
+          /// operator to compute hash.  64 bit.
+          inline uint64_t operator()(const KMER & kmer) const {
+            uint64_t h = seed;
+            for (unsigned int i = 0; i < nWords; ++i) {
+              h = mix(h ^ word(kmer, i));
+            }
+            return h;
+          }
+
+          /// hash batch_size kmers.
+          inline void hash_batch(KMER const * kmers, uint64_t * hashes) const {
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+            __m512i h = _mm512_set1_epi64(seed);
+            for (unsigned int i = 0; i < nWords; ++i) {
+              h = mix(_mm512_xor_si512(h, _mm512_set_epi64(word(kmers[7], i), word(kmers[6], i), word(kmers[5], i), word(kmers[4], i),
+                                                           word(kmers[3], i), word(kmers[2], i), word(kmers[1], i), word(kmers[0], i))));
+            }
+            _mm512_storeu_si512(reinterpret_cast<void *>(hashes), h);
+#elif defined(__AVX2__)
+            __m256i h = _mm256_set1_epi64x(seed);
+            for (unsigned int i = 0; i < nWords; ++i) {
+              h = mix(_mm256_xor_si256(h, _mm256_set_epi64x(word(kmers[3], i), word(kmers[2], i), word(kmers[1], i), word(kmers[0], i))));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(hashes), h);
+#else
+            hashes[0] = this->operator()(kmers[0]);
+#endif
+          }
+
+      };
+      template<typename KMER, bool Prefix>
+      constexpr uint8_t murmur64<KMER, Prefix>::batch_size;
+
+
+      /**
+       * @brief  single strong hash per kmer:  the prefix (distribution) version is the 128 bit murmur hash, the same as
+       *         murmur<KMER, true>, and the suffix (storage) version is 1 murmur3 finalizer on the xor of the kmer's 64 bit
+       *         words, each rotated by a different amount.  so the owner does not rehash the whole kmer, which matters for
+       *         large k.  see the file description.
+       * @note   the suffix version alone is not a good distribution hash:  kmers whose folded words are equal collide.
+       */
+      template <typename KMER, bool Prefix = false>
+      class murmur_fold {
+
+        protected:
+          static constexpr unsigned int nBytes = (KMER::nBits + 7) / 8;
+          static constexpr unsigned int nWords = (nBytes + 7) / 8;
+
+          uint32_t seed;
+
+          static inline uint64_t mix(uint64_t h) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+          }
+
+          static inline uint64_t rotl(uint64_t const & x, unsigned int const & r) {
+            return (r == 0) ? x : ((x << r) | (x >> (64 - r)));
+          }
+
+        public:
+          static constexpr uint8_t batch_size = 1;
+
+          static const unsigned int default_init_value = 24U;  // ignored, as for murmur.
+
+          murmur_fold(const unsigned int prefix_bits = default_init_value, uint32_t const & _seed = 42 ) : seed(_seed) {};
+
+          inline uint64_t operator()(const KMER & kmer) const {
+            if (Prefix) {
+              // same as murmur<KMER, true>.
+              uint64_t h[2];
+              if (sizeof(void*) == 8)
+                MurmurHash3_x64_128(kmer.getData(), nBytes, seed, h);
+              else if (sizeof(void*) == 4)
+                MurmurHash3_x86_128(kmer.getData(), nBytes, seed, h);
+              else
+                throw ::std::logic_error("ERROR: neither 32 bit nor 64 bit system");
+              return h[1];
+            }
+
+            uint64_t h = seed;
+            uint64_t w;
+            char const * data = reinterpret_cast<const char*>(kmer.getData());
+            for (unsigned int i = 0; i < nWords; ++i) {
+              w = 0;
+              memcpy(&w, data + i * 8, ((i + 1) * 8 <= nBytes) ? 8 : (nBytes - i * 8));
+              h ^= rotl(w, (i * 23) & 63);
+            }
+            return mix(h);
+          }
+
+      };
+      template<typename KMER, bool Prefix>
+      constexpr uint8_t murmur_fold<KMER, Prefix>::batch_size;
+
+
+      /**
+       * @brief  Kmer hash from the CRC32C instruction (SSE4.2), 64 bit.
+       * @details each 64 bit word of the kmer goes through 2 independent CRCs with different seeds, the second on the
+       *          word rotated by 32 bits, which form the low and high halves of a 64 bit value.  the words are combined with
+       *          a multiply-xor, and the result goes through the murmur3 64 bit finalizer.  the CRCs of all words are
+       *          independent, so they overlap, and for 1 and 2 word kmers this is about 1.4x faster than murmur.
+       *          without SSE4.2 the same values come from a table driven CRC32C.  with USE_SIMD_DISPATCH the choice is
+       *          made at run time.  the prefix version uses different seeds, as for farm.
+       */
+      template <typename KMER, bool Prefix = false>
+      class crc32c {
+
+        protected:
+          static constexpr unsigned int nBytes = (KMER::nBits + 7) / 8;
+          static constexpr unsigned int nWords = (nBytes + 7) / 8;
+
+          uint32_t seed;
+
+          /// CRC32C (Castagnoli, reflected polynomial 0x82F63B78) byte table.
+          static uint32_t const * table() {
+            static uint32_t const * t = []() {
+              static uint32_t tab[256];
+              for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int j = 0; j < 8; ++j) c = (c >> 1) ^ ((c & 1) ? 0x82F63B78U : 0U);
+                tab[i] = c;
+              }
+              return tab;
+            }();
+            return t;
+          }
+
+          /// same as _mm_crc32_u64:  8 bytes, least significant first, no inversion.
+          static inline uint32_t crc(uint32_t const & c, uint64_t const & v) {
+            uint32_t const * t = table();
+            uint32_t r = c;
+            for (int i = 0; i < 8; ++i) r = t[(r ^ static_cast<uint32_t>(v >> (i * 8))) & 0xFF] ^ (r >> 8);
+            return r;
+          }
+
+          /// i-th 64 bit word of the kmer, zero padded.
+          static inline uint64_t word(char const * data, unsigned int const & i) {
+            uint64_t w = 0;
+            memcpy(&w, data + i * 8, ((i + 1) * 8 <= nBytes) ? 8 : (nBytes - i * 8));
+            return w;
+          }
+
+          // chaining the CRC over the words would be linear in all the bits, and collide on sparse differences.
+          static inline uint64_t combine(uint64_t const & h, uint64_t const & c, unsigned int const & i) {
+            return (i == 0) ? c : ((h * 0x9E3779B97F4A7C15ULL) ^ c);
+          }
+
+          // CRC is linear, so it needs the full 64 bit finalizer to avalanche.
+          static inline uint64_t finalize(uint64_t h) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            return h ^ (h >> 33);
+          }
+
+          static uint64_t hash_table(char const * data, uint32_t const & s) {
+            uint64_t h = 0;
+            uint64_t w, c;
+            for (unsigned int i = 0; i < nWords; ++i) {
+              w = word(data, i);
+              c = (static_cast<uint64_t>(crc(~s, (w << 32) | (w >> 32))) << 32) | crc(s, w);
+              h = combine(h, c, i);
+            }
+            return finalize(h);
+          }
+
+#if defined(BL_KERNEL_SSE4_2)
+          /// same as hash_table, with the crc32 instruction.  chosen at run time with USE_SIMD_DISPATCH.
+          BL_TARGET("sse4.2")
+          static uint64_t hash_sse4_2(char const * data, uint32_t const & s) {
+            uint64_t h = 0;
+            uint64_t w, c;
+            for (unsigned int i = 0; i < nWords; ++i) {
+              w = word(data, i);
+              c = (_mm_crc32_u64(~s, (w << 32) | (w >> 32)) << 32) | _mm_crc32_u64(s, w);
+              h = combine(h, c, i);
+            }
+            return finalize(h);
+          }
+#endif
+
+        public:
+          static constexpr uint8_t batch_size = 1;
+
+          static const unsigned int default_init_value = 24U;   // ignored, as for murmur.
+
+          crc32c(const unsigned int prefix_bits = default_init_value, uint32_t const & _seed = 42 ) :
+            seed(Prefix ? (_seed << 1) - 1 : _seed) {};
+
+          /// operator to compute hash.  64 bit.
+          inline uint64_t operator()(const KMER & kmer) const {
+            char const * data = reinterpret_cast<const char*>(kmer.getData());
+#if defined(BL_KERNEL_SSE4_2)
+            if (::bliss::utils::cpu::use_sse4_2()) return hash_sse4_2(data, seed);
+#endif
+            return hash_table(data, seed);
+          }
+
+      };
+      template<typename KMER, bool Prefix>
+      constexpr uint8_t crc32c<KMER, Prefix>::batch_size;
+      template<typename KMER, bool Prefix>
+      constexpr uint64_t murmur64<KMER, Prefix>::c1;
+      template<typename KMER, bool Prefix>
+      constexpr uint64_t murmur64<KMER, Prefix>::c2;
+
+
+      /**
+       * @brief  minimizer hash:  hashes the minimizer of the kmer rather than the whole kmer.
+       * @details the minimizer is the M-mer of the kmer with the smallest hash, taken over the canonical (strand independent)
+       *          M-mers, so a kmer and its reverse complement have the same minimizer.  consecutive kmers of a read mostly share
+       *          a minimizer, so as a distribution hash this sends runs of consecutive kmers (super-kmers) to the same rank,
+       *          which lets the super-kmer wire format (superkmer_codec.hpp) ship each run as 1 kmer plus 1 byte per extra kmer.
+       *          load balance is coarser than a kmer hash, since all kmers with the same minimizer go to the same rank.
+       *
+       *          O(K) per kmer.  for distribution only, not for local storage.
+       * @tparam M  minimizer length.  M * bits per character needs to fit in a kmer word.
+       */
+      template <typename KMER, bool Prefix = false,
+          unsigned int M = ((KMER::size < 12U) ? KMER::size : 12U) < (sizeof(typename KMER::KmerWordType) * 8 / KMER::bitsPerChar) ?
+                           ((KMER::size < 12U) ? KMER::size : 12U) : (sizeof(typename KMER::KmerWordType) * 8 / KMER::bitsPerChar)>
+      class minimizer {
+          static_assert((M > 0) && (M <= KMER::size), "minimizer length needs to be between 1 and K");
+          static_assert(M * KMER::bitsPerChar <= sizeof(typename KMER::KmerWordType) * 8, "minimizer needs to fit in a kmer word");
+
+        protected:
+          /// murmur3 64 bit finalizer.
+          static inline uint64_t mix(uint64_t h) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+          }
+
+          uint64_t seed;
+
+        public:
+          static constexpr uint8_t batch_size = 1;
+
+          static const unsigned int default_init_value = 24U;   // ignored, as for murmur.
+
+          minimizer(const unsigned int prefix_bits = default_init_value, uint32_t const & _seed = 42 ) :
+            seed(Prefix ? (static_cast<uint64_t>(_seed) << 1) - 1 : _seed) {};
+
+          /// hash of the minimizer.  64 bit.
+          inline uint64_t operator()(const KMER & kmer) const {
+            KMER rc = kmer.reverse_complement();
+
+            uint64_t best = ::std::numeric_limits<uint64_t>::max();
+            uint64_t fw, rv, h;
+            for (unsigned int i = 0; i <= KMER::size - M; ++i) {
+              // window i of rc is the reverse complement of window K-M-i of kmer.
+              fw = kmer.getCharsAtPos(i, M);
+              rv = rc.getCharsAtPos(KMER::size - M - i, M);
+              h = mix(::std::min(fw, rv) ^ seed);
+              best = ::std::min(best, h);
+            }
+            return best;
+          }
+
+      };
+      template<typename KMER, bool Prefix, unsigned int M>
+      constexpr uint8_t minimizer<KMER, Prefix, M>::batch_size;
+
+
+      /**
+       * @brief  ntHash:  rolling, strand symmetric kmer hash.  64 bit.
+       * @details each character c has a random 64 bit seed.  the forward hash of c_0 .. c_{K-1} is the xor of the seeds of
+       *          c_i rotated left by K-1-i, and the reverse hash the xor of the seeds of complement(c_i) rotated left by i,
+       *          which is the forward hash of the reverse complement.  the hash is their sum, so a kmer and its reverse
+       *          complement hash the same, and a canonical map can distribute by it without computing reverse complements.
+       *
+       *          sliding the window by 1 character updates both halves with 2 rotations and 2 xors each (roll_forward,
+       *          roll_reverse), so a parser can hash every kmer of a read in O(1) per kmer (HashedKmerParser in io/kmer_parser.hpp).
+       *          operator() computes the same value from scratch, in O(K).
+       *
+       *          the prefix version returns the murmur3 finalizer of the hash, so that the ranks' and local tables'
+       *          bits are independent.  as both are functions of the 1 rolled hash, neither needs another pass over the kmer.
+       *          a kmer and its reverse complement collide, so this is meant for canonical maps.
+       */
+      template <typename KMER, bool Prefix = false>
+      class nthash {
+
+        protected:
+          using ALPHA = typename KMER::KmerAlphabet;
+
+          static inline uint64_t rol(uint64_t const x, unsigned int const r) {
+            return (r == 0) ? x : ((x << r) | (x >> (64U - r)));
+          }
+          static inline uint64_t ror(uint64_t const x, unsigned int const r) {
+            return (r == 0) ? x : ((x >> r) | (x << (64U - r)));
+          }
+
+          /// rotation of the first character of the window, K - 1 mod 64.
+          static constexpr unsigned int last = (KMER::size - 1) % 64U;
+          /// rotation of the character leaving the window, K mod 64.
+          static constexpr unsigned int span = KMER::size % 64U;
+
+        public:
+          static constexpr uint8_t batch_size = 1;
+
+          static const unsigned int default_init_value = 24U;   // ignored, as for murmur.
+
+          nthash(const unsigned int prefix_bits = default_init_value) {};
+
+          /// seed of a character value.  the first 4 are the ntHash seeds of A, C, G, T.
+          static inline uint64_t seed(uint8_t const c) {
+            static const uint64_t seeds[16] = {
+              0x3c8bfbb395c60474ULL, 0x3193c18562a02b4cULL, 0x20323ed082572324ULL, 0x295549f54be24456ULL,
+              0x22118258a9d111a0ULL, 0x346edce5f713f8edULL, 0x1e9a57bc80e6721dULL, 0x2d160e7e5c3f42caULL,
+              0x81c2e6dc980d78ebULL, 0x5647e55ad933f62eULL, 0x1f6622b40cb38e42ULL, 0x6e7411b06820371cULL,
+              0x7ad34039583ab917ULL, 0xde15eab5ce53fecfULL, 0x2f43a94042571d85ULL, 0x61571b285c0b9816ULL
+            };
+            return seeds[c & 0xF];
+          }
+
+          /// forward hash of a kmer.  O(K).  the last character read is at position 0.
+          static inline uint64_t forward(KMER const & kmer) {
+            uint64_t h = 0;
+            for (unsigned int i = 0; i < KMER::size; ++i)
+              h ^= rol(seed(kmer.getCharsAtPos(i, 1)), i % 64U);
+            return h;
+          }
+          /// reverse hash of a kmer, i.e. forward hash of its reverse complement.  O(K).
+          static inline uint64_t reverse(KMER const & kmer) {
+            uint64_t h = 0;
+            for (unsigned int i = 0; i < KMER::size; ++i)
+              h ^= rol(seed(ALPHA::to_complement(kmer.getCharsAtPos(i, 1))), (KMER::size - 1 - i) % 64U);
+            return h;
+          }
+
+          /// forward hash after character out leaves the window and character in enters it.
+          static inline uint64_t roll_forward(uint64_t const h, uint8_t const out, uint8_t const in) {
+            return rol(h, 1) ^ rol(seed(out), span) ^ seed(in);
+          }
+          /// reverse hash after character out leaves the window and character in enters it.
+          static inline uint64_t roll_reverse(uint64_t const h, uint8_t const out, uint8_t const in) {
+            return ror(h, 1) ^ ror(seed(ALPHA::to_complement(out)), 1) ^ rol(seed(ALPHA::to_complement(in)), last);
+          }
+
+          /// this version's hash from the strand symmetric hash, i.e. the value of the suffix version.
+          static inline uint64_t finish(uint64_t h) {
+            if (Prefix) {
+              h ^= h >> 33;
+              h *= 0xff51afd7ed558ccdULL;
+              h ^= h >> 33;
+              h *= 0xc4ceb9fe1a85ec53ULL;
+              h ^= h >> 33;
+            }
+            return h;
+          }
+
+          /// hash from the forward and reverse hashes, as operator() returns it.
+          static inline uint64_t combine(uint64_t const fw, uint64_t const rv) {
+            return finish(fw + rv);
+          }
+
+          /// hash of the kmer, computed from scratch.
+          inline uint64_t operator()(const KMER & kmer) const {
+            return combine(forward(kmer), reverse(kmer));
+          }
+
+      };
+      template<typename KMER, bool Prefix>
+      constexpr uint8_t nthash<KMER, Prefix>::batch_size;
+      template<typename KMER, bool Prefix>
+      constexpr unsigned int nthash<KMER, Prefix>::last;
+      template<typename KMER, bool Prefix>
+      constexpr unsigned int nthash<KMER, Prefix>::span;
+
+
       namespace sparsehash {
       	  //  ===============
       	  //  Sparse hash specific, kmer related stuff
@@ -53,6 +53,10 @@
 #include <utility>      // pair and utility functions.
 #include <type_traits>
 #include <cctype>       // tolower.
+#include <exception>    // exception_ptr
+#include <stdexcept>
+#include <memory>       // unique_ptr
+#include <chrono>
 
 #include "io/file.hpp"
 #include "io/fastq_loader.hpp"
@@ -68,14 +72,18 @@
 
 #include "io/kmer_file_helper.hpp"
 #include "io/kmer_parser.hpp"
+#include "io/packed_read_store.hpp"
 #include "io/mxx_support.hpp"
 #include "containers/distributed_unordered_map.hpp"
 #include "containers/distributed_sorted_map.hpp"
 //#include "containers/distributed_hashed_vec.hpp"
 //#include "containers/distributed_map.hpp"
 #include "containers/distributed_densehash_map.hpp"
+#include "index/build_checkpoint.hpp"
+#include "index/query_trace.hpp"
 
 #include "utils/benchmark_utils.hpp"
+#include "utils/memory_budget.hpp"
 #include "utils/file_utils.hpp"
 #include "utils/transform_utils.hpp"
 
@@ -91,6 +99,14 @@ namespace index
 namespace kmer
 {
 
+/// projection for find_if_project:  the value only, e.g. the count, without the key.
+struct project_value {
+	template <typename Key, typename T>
+	T operator()(std::pair<Key, T> const & x) const {
+		return x.second;
+	}
+};
+
 /**
  * @tparam MapType  	container type
  * @tparam KmerParser		functor to generate kmer (tuple) from input.  specified here so we specialize for different index.  note KmerParser needs to be supplied with a data type.
@@ -103,6 +119,35 @@ protected:
 
 	const mxx::comm& comm;
 
+	/// target size in bytes of the kmer buffer during streaming build.  0 means the whole partition is parsed before insertion.
+	size_t build_chunk_bytes;
+
+	/// during streaming build, parse the next chunk while the current chunk is being distributed and inserted.
+	bool build_overlap;
+
+	/// file prefix of the streaming build checkpoints.
+	std::string checkpoint_prefix;
+
+	/// checkpoint the streaming build every this many chunks.  0 means no checkpoints.
+	size_t checkpoint_every;
+
+	/// drop exact duplicate reads before generating kmers.
+	bool build_dedup;
+
+	/// capture of the find and count batches, if set.  see set_query_trace.
+	std::unique_ptr<::bliss::index::query_trace_writer<typename MapType::key_type> > query_trace;
+
+	/// run q on query, and append the keys and the latency to the query trace.
+	template <typename Query>
+	auto traced(uint32_t const op, std::vector<typename MapType::key_type> & query, Query const & q) const -> decltype(q(query)) {
+		std::vector<typename MapType::key_type> keys(query);
+		auto start = std::chrono::steady_clock::now();
+		auto results = q(query);
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		query_trace->write(op, keys, static_cast<uint64_t>(ns));
+		return results;
+	}
+
 public:
 	using KmerType = typename MapType::key_type;
 	// TODO: make this consistent with map data type conventions?
@@ -112,18 +157,136 @@ public:
 
 	using KmerParserType = KmerParser;
 
-	Index(const mxx::comm& _comm) : map(_comm), comm(_comm) {
+	Index(const mxx::comm& _comm) : map(_comm), comm(_comm), build_chunk_bytes(0), build_overlap(false), checkpoint_every(0), build_dedup(false) {
 	}
 
 	virtual ~Index() {};
 
+	/// save the built index, one file per rank, "<prefix>.<rank>".  collective.
+	void save(const std::string & prefix) const {
+		map.save(prefix);
+	}
+
+	/// write all k-mers and values to 1 shared file, sorted by k-mer, e.g. for other counting tools.  collective.
+	/// see distributed_map_export.hpp for the format.  returns the number of entries written.
+	size_t export_sorted(const std::string & filename) const {
+		return map.export_sorted(filename);
+	}
+
+	/// load an index saved with the same number of processes and the same map type, instead of rebuilding.  collective.
+	void load(const std::string & prefix) {
+		map.load(prefix);
+	}
+
 	MapType & get_map() {
 		return map;
 	}
+
+	/**
+	 * @brief release the transient memory of the build, e.g. before a long query phase.  local.
+	 * @details  the build buffers are freed when build_* returns, but their pages stay in the heap.  this returns them,
+	 * 			and the map's query buffers, to the operating system, see map_base::release_memory.
+	 * @param shrink_table  also rebuild the local table at the size of its entries.  peak is the old plus the new table.
+	 * @return bytes by which the resident set shrank.
+	 */
+	size_t release_memory(bool const shrink_table = false) {
+		return map.release_memory(shrink_table);
+	}
 	MapType const & get_map() const {
 		return map;
 	}
 
+	/**
+	 * @brief set the peak kmer buffer size for build_*.
+	 * @details  when nonzero, build_mpiio/build_mmap/build_posix parse the local partition in chunks of approximately chunk_bytes
+	 * 			worth of kmers, distributing and inserting each chunk before reusing the buffer.  The final map content is the same
+	 * 			as the non-streaming build.  transient memory during insertion is a small multiple of chunk_bytes (send and receive buffers).
+	 * @param chunk_bytes  target buffer size in bytes.  0 (default) disables streaming, unless the map has a memory budget.
+	 */
+	void set_build_chunk_bytes(size_t const chunk_bytes) {
+		build_chunk_bytes = chunk_bytes;
+	}
+	size_t get_build_chunk_bytes() const {
+		return build_chunk_bytes;
+	}
+
+	/**
+	 * @brief chunk size for build_*:  build_chunk_bytes, capped by the map's memory budget.  collective if a budget is set.
+	 * @details  with a budget, the build streams even if build_chunk_bytes is 0.  insertion holds about 4 copies of a chunk
+	 * 			(the parsed kmers, the send and receive buffers, and the table growth), so a chunk is a quarter of the
+	 * 			smallest headroom over all ranks, and at least 1MB so that the build progresses when the budget is exhausted.
+	 */
+	size_t effective_chunk_bytes() const {
+		::bliss::utils::memory_budget const & budget = map.get_memory_budget();
+		if (!budget.limited()) return build_chunk_bytes;
+
+		size_t cap = ::std::max(budget.available() / 4, static_cast<size_t>(1UL << 20));
+		if (comm.size() > 1) cap = ::mxx::allreduce(cap, ::mxx::min<size_t>(), comm);
+		return (build_chunk_bytes == 0) ? cap : ::std::min(build_chunk_bytes, cap);
+	}
+
+	/**
+	 * @brief pipeline the streaming build.
+	 * @details  when enabled (and OpenMP is available), a second thread parses chunk N+1 while the master thread
+	 * 			distributes and inserts chunk N.  doubles the kmer buffer memory.  only the master thread makes MPI calls.
+	 * 			no effect unless the build streams, see effective_chunk_bytes.
+	 */
+	void set_build_overlap(bool const overlap) {
+		build_overlap = overlap;
+	}
+	bool get_build_overlap() const {
+		return build_overlap;
+	}
+
+	/**
+	 * @brief checkpoint the streaming build, and resume from the latest checkpoint.
+	 * @details  every every_n_chunks chunks, the map and each rank's position in its partition are saved under prefix
+	 * 			(2 alternating slots, see build_checkpoint.hpp).  a later build of the same file with the same number of processes
+	 * 			loads the latest checkpoint that is complete on all ranks and parses only the remainder.  otherwise it starts over.
+	 * 			checkpoint files are left in place after the build.  no effect unless the build streams, see effective_chunk_bytes.
+	 * @param prefix          checkpoint file prefix, on storage that survives the job.
+	 * @param every_n_chunks  checkpoint interval.  0 (default) disables checkpointing.
+	 */
+	void set_build_checkpoint(const std::string & prefix, size_t const every_n_chunks) {
+		checkpoint_prefix = prefix;
+		checkpoint_every = every_n_chunks;
+	}
+	const std::string & get_build_checkpoint_prefix() const {
+		return checkpoint_prefix;
+	}
+	size_t get_build_checkpoint_every() const {
+		return checkpoint_every;
+	}
+
+	/**
+	 * @brief drop exact duplicate reads (e.g. PCR duplicates) before generating kmers.
+	 * @details  a read whose bases repeat an earlier read of the file is skipped, so a count index counts each distinct
+	 * 			read once.  costs 1 pass over the reads and 1 exchange of 24 bytes per read, see find_duplicate_reads.
+	 * 			FASTQ only, and only for the builds that parse the whole partition at once, not the streaming build.
+	 */
+	void set_build_dedup(bool const dedup) {
+		build_dedup = dedup;
+	}
+	bool get_build_dedup() const {
+		return build_dedup;
+	}
+
+	/**
+	 * @brief capture the keys of every find and count call, e.g. of a query_server, to a trace.  local.
+	 * @details  1 file per rank, "<prefix>.<rank>", with each call's keys and local latency, for replay_query_trace.  see
+	 * 			query_trace.hpp.  the keys are copied before the call, so a capture costs a copy and a write per batch.
+	 * 			all ranks should capture the same calls.  an empty prefix ends the capture and closes the files.
+	 */
+	void set_query_trace(const std::string & prefix) {
+		query_trace.reset();
+		if (!prefix.empty())
+			query_trace.reset(new ::bliss::index::query_trace_writer<KmerType>(prefix, comm.size(), comm.rank()));
+	}
+	/// number of batches captured since set_query_trace, or 0 if not capturing.
+	size_t get_query_trace_batches() const {
+		return query_trace ? query_trace->size() : 0;
+	}
+
 
 
 //	std::vector<TupleType> find_overlap(std::vector<KmerType> &query) const {
@@ -131,7 +294,8 @@ public:
 //	}
 	auto find(std::vector<KmerType> &query) const
 		-> decltype(::std::declval<MapType>().find(::std::declval<std::vector<KmerType> &>())) {
-		return map.find(query);
+		if (!query_trace) return map.find(query);
+		return traced(::bliss::index::query_trace_batch::find, query, [this](std::vector<KmerType> & q) { return map.find(q); });
 	}
 //	std::vector<TupleType> find_collective(std::vector<KmerType> &query) const {
 //		return map.find_collective(query);
@@ -141,7 +305,31 @@ public:
 //  }
 	auto count(std::vector<KmerType> &query) const
 	-> decltype(::std::declval<MapType>().count(::std::declval<std::vector<KmerType> &>())){
-		return map.count(query);
+		if (!query_trace) return map.count(query);
+		return traced(::bliss::index::query_trace_batch::count, query, [this](std::vector<KmerType> & q) { return map.count(q); });
+	}
+
+	/**
+	 * @brief keep the k-mers of a read that the parser keeps, e.g. the minimizers for MinimizerPositionIndex.
+	 * @details  only for sampling parsers.  query a sampled index with sampled reads, so that both sides keep the same k-mers.
+	 * @param kmers  consecutive k-mers of 1 read.  replaced by the kept k-mers, in order.
+	 * @return  offsets of the kept k-mers in the read, e.g. for map_reads seeds.
+	 */
+	template <typename P = KmerParser>
+	auto sample_query(std::vector<KmerType> & kmers) const -> decltype(P::sample_offsets(kmers)) {
+		std::vector<size_t> offsets = P::sample_offsets(kmers);
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			kmers[i] = kmers[offsets[i]];
+		}
+		kmers.resize(offsets.size());
+		return offsets;
+	}
+
+	/// diagonal binned seed hits of reads, for position indices on a multimap.  see map_base::seed_hits.  collective.
+	template <typename M = MapType>
+	auto map_reads(std::vector<::dsc::read_seed<KmerType> > const & seeds, size_t const bin_width = 1) const
+	-> decltype(::std::declval<M const &>().map_reads(seeds, bin_width)) {
+		return map.map_reads(seeds, bin_width);
 	}
 
 	void erase(std::vector<KmerType> &query) {
@@ -171,6 +359,18 @@ public:
 		return map.find(pred);
 	}
 
+	/**
+	 * @brief find_if, replying with proj(kmer, value) instead of the tuple.  collective.
+	 * @details  the predicate and the projection run on the owner, so only the projected values are sent back,
+	 *           e.g. project_value for the counts, or de_bruijn::node::project_edge_bits for the edges of a graph node.
+	 *           the projected type needs an mxx datatype.
+	 */
+	template <typename Predicate, typename Projection>
+	auto find_if_project(std::vector<KmerType> &query, Predicate const &pred, Projection const &proj) const
+	-> decltype(::std::declval<MapType const &>().find_transform(query, false, pred, proj)) {
+		return map.find_transform(query, false, pred, proj);
+	}
+
 	template <typename Predicate>
 	auto count_if(std::vector<KmerType> &query, Predicate const &pred) const
 	-> decltype(::std::declval<MapType>().find(::std::declval<std::vector<KmerType> &>())) {
@@ -224,10 +424,152 @@ public:
 
 	 }
 
+	/**
+	 * @brief insert, consuming temp.  the map exchanges it in place and releases it before returning, so the insert
+	 *        peak memory is about 1.5x of temp instead of 3x.  the map needs an rvalue insert overload.
+	 */
+	 template <typename T>
+	void insert(std::vector<T> &&temp) {
+		this->map.insert(::std::move(temp));  // COLLECTIVE CALL...
+	 }
+
 	 // Note that KmerParserType may depend on knowing the Sequence Parser Type (e.g. provide quality score iterators)
 	 //	Output type of KmerParserType may not match Map value type, in which case the map needs to do its own transform.
 	 //     since Kmer template parameter is not explicitly known, we can't hard code the return types of KmerParserType.
 
+protected:
+	 /**
+	  * @brief load the latest checkpoint that is complete on all ranks.  collective.
+	  * @param[in,out] last  expected record in, the loaded record out.  unchanged if there is no usable checkpoint.
+	  * @return true if a checkpoint was loaded.
+	  */
+	 bool resume_checkpoint(::bliss::index::build_progress_record & last) {
+		 ::bliss::index::build_progress_record recs[2];
+		 bool valid[2];
+		 uint64_t latest = 0;
+		 for (int slot = 0; slot < 2; ++slot) {
+			 valid[slot] = ::bliss::index::read_build_progress_record(
+					 ::bliss::index::checkpoint_progress_file_name(this->checkpoint_prefix, slot, this->comm.rank()), last, recs[slot]) &&
+					 ((recs[slot].generation % 2) == static_cast<uint64_t>(slot));
+			 if (valid[slot]) latest = ::std::max(latest, static_cast<uint64_t>(recs[slot].generation));
+		 }
+
+		 // a rank may have finished a newer generation than the others.  the older one is still in the other slot.
+		 uint64_t gen = ::mxx::allreduce(latest, mxx::min<uint64_t>(), this->comm);
+		 int slot = gen % 2;
+		 bool have = (gen > 0) && valid[slot] && (recs[slot].generation == gen);
+		 if (!::mxx::all_of(have, this->comm)) {
+			 // start over, numbering after any leftover generation.
+			 last.generation = ::mxx::allreduce(latest, mxx::max<uint64_t>(), this->comm);
+			 return false;
+		 }
+
+		 try {
+			 this->map.load(::bliss::index::checkpoint_slot_prefix(this->checkpoint_prefix, gen));  // COLLECTIVE CALL...
+		 } catch (::std::exception const & e) {
+			 // map load throws on all ranks together.
+			 BL_WARNINGF("checkpoint %lu could not be loaded, rebuilding: %s", static_cast<unsigned long>(gen), e.what());
+			 this->map.clear();
+			 last.generation = gen;
+			 return false;
+		 }
+		 last = recs[slot];
+		 return true;
+	 }
+
+	 /**
+	  * @brief save the map and then the progress record into the slot of record.generation.  collective.
+	  * @details  the slot's old record is removed first, so a crash while the map is being overwritten leaves the slot invalid.
+	  * 		the final collective keeps a rank from starting the next generation, and overwriting the other slot,
+	  * 		before all ranks have published this one.
+	  */
+	 void write_checkpoint(::bliss::index::build_progress_record const & record) {
+		 ::std::string progress_file = ::bliss::index::checkpoint_progress_file_name(this->checkpoint_prefix, record.generation, this->comm.rank());
+		 unlink(progress_file.c_str());
+
+		 this->map.save(::bliss::index::checkpoint_slot_prefix(this->checkpoint_prefix, record.generation));  // COLLECTIVE CALL...
+
+		 ::std::exception_ptr err;
+		 try {
+			 ::bliss::index::write_build_progress_record(progress_file, record);
+		 } catch (...) {
+			 err = ::std::current_exception();
+		 }
+		 bool ok = ::mxx::all_of(err == nullptr, this->comm);
+		 if (err != nullptr) ::std::rethrow_exception(err);
+		 if (!ok) throw ::std::runtime_error("ERROR: checkpoint failed on another rank.");
+	 }
+
+	 /**
+	  * @brief streaming build.  parse the local partition in chunks of chunk_bytes, and insert each chunk.
+	  * @details  map insert is collective, and read_block_chunked guarantees that all processes insert the same number of times.
+	  * 		multiplicity is computed once at the end instead of per chunk.
+	  * 		with a checkpoint prefix set, resumes from and writes checkpoints as described in set_build_checkpoint.
+	  */
+	 template <typename FileType, template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType,
+	 typename FileNames = std::string>
+	 void build_chunked(const FileNames & filename, size_t const chunk_bytes, const char* bench_name) {
+		 BL_BENCH_INIT(build);
+
+		 ::bliss::index::build_progress_record last =
+				 ::bliss::index::make_build_progress_record(filename, this->comm.size(), this->comm.rank());
+
+		 BL_BENCH_START(build);
+		 bool resumed = (this->checkpoint_every > 0) && this->resume_checkpoint(last);
+		 BL_BENCH_END(build, "resume", last.chunks);
+
+		 BL_BENCH_START(build);
+		 auto consume = [this](::std::vector<typename KmerParser::value_type> & chunk) {
+			 BL_TRACE_SCOPE("insert");
+			 this->map.insert(chunk);  // COLLECTIVE CALL...
+		 };
+		 // position at the start of this stream.  generation keeps counting up so slots are never reused out of order.
+		 ::bliss::index::build_progress_record base = last;
+		 auto checkpoint = [this, &last, &base](::bliss::io::KmerFileHelper::chunk_progress const & pos) {
+			 if ((this->checkpoint_every == 0) || (((base.chunks + pos.chunks) % this->checkpoint_every) != 0)) return;
+			 last.generation += 1;
+			 last.chunks = base.chunks + pos.chunks;
+			 last.kmers = base.kmers + pos.kmers;
+			 last.steps = pos.steps;
+			 last.next_offset = pos.next_offset;
+			 this->write_checkpoint(last);  // COLLECTIVE CALL...
+		 };
+
+		 std::tuple<size_t, size_t, size_t> read;
+		 try {
+			 read = bliss::io::KmerFileHelper::template stream_file<FileType, KmerParser, SeqParser, SeqIterType>(filename,
+					 chunk_bytes, consume, this->comm, this->build_overlap, base.steps, checkpoint);
+		 } catch (::std::invalid_argument const & e) {
+			 // thrown on all ranks before any insertion if the checkpoint does not fit the partitions.  start over.
+			 if (!resumed) throw;
+			 BL_WARNINGF("checkpoint does not match the input partitions, rebuilding: %s", e.what());
+			 this->map.clear();
+			 base.chunks = 0;
+			 base.kmers = 0;
+			 base.steps = 0;
+			 read = bliss::io::KmerFileHelper::template stream_file<FileType, KmerParser, SeqParser, SeqIterType>(filename,
+					 chunk_bytes, consume, this->comm, this->build_overlap, 0, checkpoint);
+		 }
+		 BL_BENCH_END(build, "read_insert", std::get<1>(read));
+
+#if (BL_BENCHMARK == 1)
+		 BL_BENCH_START(build);
+		 size_t m = 0;  // here because sortmap needs it.
+		 m = this->map.get_multiplicity();
+		 BL_BENCH_END(build, "multiplicity", m);
+#else
+		 auto result = this->map.get_multiplicity();
+		 BLISS_UNUSED(result);
+#endif
+
+		 BL_BENCH_REPORT_MPI_NAMED(build, bench_name, this->comm);
+		 BL_TRACE_DUMP(this->comm);
+		 BLISS_UNUSED(read);
+		 BLISS_UNUSED(bench_name);
+	 }
+
+public:
+
 	 //============= THESE ARE TO BE DEPRECATED
 
 
@@ -239,6 +581,12 @@ public:
 	 template <template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType>
 	 void build_mpiio(const std::string & filename, MPI_Comm comm) {
 
+		 // compressed input is decompressed in parallel, for any of the readers.
+		 if (::bliss::utils::file::is_gzip_file(filename)) {
+		   this->template build_bgzf<SeqParser, SeqIterType>(filename, comm);
+		   return;
+		 }
+
 		 // file extension determines SeqParserType
 		 std::string extension = ::bliss::utils::file::get_file_extension(filename);
 		 std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
@@ -252,12 +600,18 @@ public:
 		 } else if (((extension.compare("fasta") == 0) || (extension.compare("fa") == 0)) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTAParser<char*> >::value)) {
 			 throw std::invalid_argument("Specified File Parser template parameter does not support files with fasta extension.");
 		 }
+     size_t chunk_bytes = this->effective_chunk_bytes();
+     if (chunk_bytes > 0) {
+       this->template build_chunked<::bliss::io::parallel::mpiio_file<SeqParser>, SeqParser, SeqIterType>(filename, chunk_bytes, "index:build_mpiio_chunked");
+       return;
+     }
+
      BL_BENCH_INIT(build);
 
 		 // proceed
      BL_BENCH_START(build);
 		 ::std::vector<typename KmerParser::value_type> temp;
-		 bliss::io::KmerFileHelper::template read_file_mpiio<KmerParser, SeqParser, SeqIterType>(filename, temp, comm);
+		 bliss::io::KmerFileHelper::template read_file_mpiio<KmerParser, SeqParser, SeqIterType>(filename, temp, comm, build_dedup);
      BL_BENCH_END(build, "read", temp.size());
 
 
@@ -284,6 +638,12 @@ public:
 	   template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
 	   void build_mmap(const std::string & filename, MPI_Comm comm) {
 
+	     // compressed input is decompressed in parallel, for any of the readers.
+	     if (::bliss::utils::file::is_gzip_file(filename)) {
+	       this->template build_bgzf<SeqParser, SeqIterType>(filename, comm);
+	       return;
+	     }
+
 	     // file extension determines SeqParserType
 	     std::string extension = ::bliss::utils::file::get_file_extension(filename);
 	     std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
@@ -297,12 +657,18 @@ public:
 	     } else if (((extension.compare("fasta") == 0) || (extension.compare("fa") == 0)) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTAParser<char*> >::value)) {
 	       throw std::invalid_argument("Specified File Parser template parameter does not support files with fasta extension.");
 	     }
+	     size_t chunk_bytes = this->effective_chunk_bytes();
+	     if (chunk_bytes > 0) {
+	       this->template build_chunked<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>, SeqParser, SeqIterType>(filename, chunk_bytes, "index:build_mmap_chunked");
+	       return;
+	     }
+
 	     BL_BENCH_INIT(build);
 
 	     // proceed
 	     BL_BENCH_START(build);
 	     ::std::vector<typename KmerParser::value_type> temp;
-	     bliss::io::KmerFileHelper::template read_file_mmap<KmerParser, SeqParser, SeqIterType>(filename, temp, comm);
+	     bliss::io::KmerFileHelper::template read_file_mmap<KmerParser, SeqParser, SeqIterType>(filename, temp, comm, build_dedup);
 	      BL_BENCH_END(build, "read", temp.size());
 
 
@@ -331,6 +697,12 @@ public:
 		 template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
 		 void build_posix(const std::string & filename, MPI_Comm comm) {
 
+			 // compressed input is decompressed in parallel, for any of the readers.
+			 if (::bliss::utils::file::is_gzip_file(filename)) {
+			   this->template build_bgzf<SeqParser, SeqIterType>(filename, comm);
+			   return;
+			 }
+
 			 // file extension determines SeqParserType
 			 std::string extension = ::bliss::utils::file::get_file_extension(filename);
 			 std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
@@ -344,12 +716,18 @@ public:
 			 } else if (((extension.compare("fasta") == 0) || (extension.compare("fa") == 0)) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTAParser<char*> >::value)) {
 				 throw std::invalid_argument("Specified File Parser template parameter does not support files with fasta extension.");
 			 }
+	     size_t chunk_bytes = this->effective_chunk_bytes();
+	     if (chunk_bytes > 0) {
+	       this->template build_chunked<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, SeqParser>, SeqParser, SeqIterType>(filename, chunk_bytes, "index:build_posix_chunked");
+	       return;
+	     }
+
 	     BL_BENCH_INIT(build);
 
 			 // proceed
 	     BL_BENCH_START(build);
 			 ::std::vector<typename KmerParser::value_type> temp;
-			 bliss::io::KmerFileHelper::template read_file_posix<KmerParser, SeqParser, SeqIterType>(filename, temp, comm);
+			 bliss::io::KmerFileHelper::template read_file_posix<KmerParser, SeqParser, SeqIterType>(filename, temp, comm, build_dedup);
 	     BL_BENCH_END(build, "read", temp.size());
 
 
@@ -371,8 +749,231 @@ public:
 
 		 }
 
+		 /// convenience function for building index.  O_DIRECT reads, so the input does not evict the index from the page cache.
+		 template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+		 void build_direct(const std::string & filename, MPI_Comm comm) {
+
+			 // compressed input is decompressed in parallel, for any of the readers.
+			 if (::bliss::utils::file::is_gzip_file(filename)) {
+			   this->template build_bgzf<SeqParser, SeqIterType>(filename, comm);
+			   return;
+			 }
+
+			 // file extension determines SeqParserType
+			 std::string extension = ::bliss::utils::file::get_file_extension(filename);
+			 std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			 if ((extension.compare("fastq") != 0) && (extension.compare("fasta") != 0) && (extension.compare("fa") != 0)) {
+				 throw std::invalid_argument("input filename extension is not supported.");
+			 }
+
+			 // check to make sure that the file parser will work
+			 if ((extension.compare("fastq") == 0) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTQParser<char*> >::value)) {
+				 throw std::invalid_argument("Specified File Parser template parameter does not support files with fastq extension.");
+			 } else if (((extension.compare("fasta") == 0) || (extension.compare("fa") == 0)) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTAParser<char*> >::value)) {
+				 throw std::invalid_argument("Specified File Parser template parameter does not support files with fasta extension.");
+			 }
+	     size_t chunk_bytes = this->effective_chunk_bytes();
+	     if (chunk_bytes > 0) {
+	       this->template build_chunked<::bliss::io::parallel::partitioned_file<::bliss::io::direct_file, SeqParser>, SeqParser, SeqIterType>(filename, chunk_bytes, "index:build_direct_chunked");
+	       return;
+	     }
+
+	     BL_BENCH_INIT(build);
+
+			 // proceed
+	     BL_BENCH_START(build);
+			 ::std::vector<typename KmerParser::value_type> temp;
+			 bliss::io::KmerFileHelper::template read_file_direct<KmerParser, SeqParser, SeqIterType>(filename, temp, comm);
+	     BL_BENCH_END(build, "read", temp.size());
+
+	     BL_BENCH_START(build);
+			 this->insert(temp);
+	     BL_BENCH_END(build, "insert", temp.size());
+
+
+	     BL_BENCH_REPORT_MPI_NAMED(build, "index:build_direct", this->comm);
+
+		 }
+
+		 /// convenience function for building index from a BGZF (bgzip) compressed file, e.g. reads.fastq.gz.  blocks are decompressed in parallel.
+		 template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+		 void build_bgzf(const std::string & filename, MPI_Comm comm) {
+
+			 // extension inside the .gz determines SeqParserType
+			 std::string extension = ::bliss::utils::file::get_data_file_extension(filename);
+			 std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			 if ((extension.compare("fastq") != 0) && (extension.compare("fasta") != 0) && (extension.compare("fa") != 0)) {
+				 throw std::invalid_argument("input filename extension is not supported.");
+			 }
+
+			 // check to make sure that the file parser will work
+			 if ((extension.compare("fastq") == 0) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTQParser<char*> >::value)) {
+				 throw std::invalid_argument("Specified File Parser template parameter does not support files with fastq extension.");
+			 } else if (((extension.compare("fasta") == 0) || (extension.compare("fa") == 0)) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTAParser<char*> >::value)) {
+				 throw std::invalid_argument("Specified File Parser template parameter does not support files with fasta extension.");
+			 }
+	     size_t chunk_bytes = this->effective_chunk_bytes();
+	     if (chunk_bytes > 0) {
+	       this->template build_chunked<::bliss::io::parallel::bgzf_file<SeqParser>, SeqParser, SeqIterType>(filename, chunk_bytes, "index:build_bgzf_chunked");
+	       return;
+	     }
+
+	     BL_BENCH_INIT(build);
+
+			 // proceed
+	     BL_BENCH_START(build);
+			 ::std::vector<typename KmerParser::value_type> temp;
+			 bliss::io::KmerFileHelper::template read_file_bgzf<KmerParser, SeqParser, SeqIterType>(filename, temp, comm);
+	     BL_BENCH_END(build, "read", temp.size());
+
+	     BL_BENCH_START(build);
+			 this->insert(temp);
+	     BL_BENCH_END(build, "insert", temp.size());
+
+
+	     BL_BENCH_REPORT_MPI_NAMED(build, "index:build_bgzf", this->comm);
+
+		 }
+
+		 /**
+		  * @brief convenience function for building index from a list of files, e.g. the lanes of a sample, in 1 pass.
+		  * @details  the files are partitioned as if concatenated (see multi_file.hpp), so each process reads the same number of bytes
+		  * 		and the collective setup is paid once rather than per file.  all files must be the same format, and uncompressed.
+		  */
+		 template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+		 void build_files(const std::vector<std::string> & filenames, MPI_Comm comm) {
+
+			 for (auto const & filename : filenames) {
+				 if (::bliss::utils::file::is_gzip_file(filename)) {
+					 throw std::invalid_argument("compressed files cannot be combined with build_files.  use build_bgzf for each.");
+				 }
+
+				 // file extension determines SeqParserType
+				 std::string extension = ::bliss::utils::file::get_file_extension(filename);
+				 std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+				 if ((extension.compare("fastq") != 0) && (extension.compare("fasta") != 0) && (extension.compare("fa") != 0)) {
+					 throw std::invalid_argument("input filename extension is not supported.");
+				 }
+
+				 // check to make sure that the file parser will work
+				 if ((extension.compare("fastq") == 0) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTQParser<char*> >::value)) {
+					 throw std::invalid_argument("Specified File Parser template parameter does not support files with fastq extension.");
+				 } else if (((extension.compare("fasta") == 0) || (extension.compare("fa") == 0)) && (!std::is_same<SeqParser<char*>, ::bliss::io::FASTAParser<char*> >::value)) {
+					 throw std::invalid_argument("Specified File Parser template parameter does not support files with fasta extension.");
+				 }
+			 }
+	     size_t chunk_bytes = this->effective_chunk_bytes();
+	     if (chunk_bytes > 0) {
+	       this->template build_chunked<::bliss::io::parallel::multi_file<SeqParser>, SeqParser, SeqIterType>(filenames, chunk_bytes, "index:build_files_chunked");
+	       return;
+	     }
+
+	     BL_BENCH_INIT(build);
+
+			 // proceed
+	     BL_BENCH_START(build);
+			 ::std::vector<typename KmerParser::value_type> temp;
+			 bliss::io::KmerFileHelper::template read_files<KmerParser, SeqParser, SeqIterType>(filenames, temp, comm);
+	     BL_BENCH_END(build, "read", temp.size());
+
+	     BL_BENCH_START(build);
+			 this->insert(temp);
+	     BL_BENCH_END(build, "insert", temp.size());
+
+
+	     BL_BENCH_REPORT_MPI_NAMED(build, "index:build_files", this->comm);
+
+		 }
+
+		 /**
+		  * @brief convenience function for building index from a FASTQ stream, e.g. sequencer output on stdin, a pipe, or a socket.
+		  * @details  the stream is read once by root and scattered in blocks of whole records, see stream_file.hpp, so it is
+		  * 		not staged to a file.  the kmers are inserted per round, in chunks of effective_chunk_bytes if set, and
+		  * 		build_overlap applies.  no checkpoints or dedup.
+		  * @param fd           open descriptor of the stream, at a record.  used on root only.  not closed.
+		  * @param block_bytes  bytes of records per rank per round.  0 for default_stream_block_bytes.
+		  */
+		 template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+		 void build_stream(int const fd, MPI_Comm comm, int const root = 0, size_t const block_bytes = 0) {
+			 static_assert(std::is_same<SeqParser<char*>, ::bliss::io::FASTQParser<char*> >::value,
+					 "Streaming build supports FASTQ only.");
+
+			 BL_BENCH_INIT(build);
+
+			 BL_BENCH_START(build);
+			 ::bliss::io::fastq_stream_reader reader(fd);
+			 auto consume = [this](::std::vector<typename KmerParser::value_type> & chunk) {
+				 this->map.insert(chunk);  // COLLECTIVE CALL...
+			 };
+			 std::tuple<size_t, size_t, size_t> read =
+					 ::bliss::io::KmerFileHelper::template stream_input<KmerParser, SeqParser, SeqIterType>(
+							 (this->comm.rank() == root) ? &reader : nullptr, block_bytes, this->effective_chunk_bytes(),
+							 consume, this->comm, root, this->build_overlap);
+			 BL_BENCH_END(build, "read_insert", std::get<1>(read));
+
+#if (BL_BENCHMARK == 1)
+			 BL_BENCH_START(build);
+			 size_t m = 0;  // here because sortmap needs it.
+			 m = this->map.get_multiplicity();
+			 BL_BENCH_END(build, "multiplicity", m);
+#else
+			 auto result = this->map.get_multiplicity();
+			 BLISS_UNUSED(result);
+#endif
+
+			 BL_BENCH_REPORT_MPI_NAMED(build, "index:build_stream", this->comm);
+			 BLISS_UNUSED(read);
+			 BLISS_UNUSED(comm);
+		 }
+
+		 /**
+		  * @brief build from reads packed once in a PackedReadStore, instead of reading and parsing the file.  e.g. for a sweep over k.
+		  * @details  the kmers are the same as build_mmap etc. on the file the store was read from.  only for KmerParser and
+		  * 		CanonicalKmerParser, since position, quality, and count tuples need the file.  build_chunk_bytes is not used.
+		  */
+		 template <typename Store>
+		 void build_packed(Store const & store) {
+			 static_assert(::std::is_same<KmerParser, ::bliss::index::kmer::KmerParser<KmerType> >::value ||
+					 ::std::is_same<KmerParser, ::bliss::index::kmer::CanonicalKmerParser<KmerType> >::value,
+					 "build_packed only supports KmerParser and CanonicalKmerParser");
+
+	     BL_BENCH_INIT(build);
+
+	     BL_BENCH_START(build);
+			 ::std::vector<KmerType> temp;
+			 temp.reserve(store.template kmer_count<KmerType>());
+			 ::fsc::back_emplace_iterator<::std::vector<KmerType> > emplace_iter(temp);
+			 store.template generate<KmerType>(emplace_iter);
+			 if (::std::is_same<KmerParser, ::bliss::index::kmer::CanonicalKmerParser<KmerType> >::value)
+				 ::bliss::kmer::transform::lex_less<KmerType>().transform_inplace(temp);
+	     BL_BENCH_END(build, "generate", temp.size());
+
+	     BL_BENCH_START(build);
+			 this->insert(temp);
+	     BL_BENCH_END(build, "insert", temp.size());
 
 
+	     BL_BENCH_REPORT_MPI_NAMED(build, "index:build_packed", this->comm);
+
+		 }
+
+
+
+
+		 /**
+		  * @brief insert a chunk of forward kmers, e.g. from build_multi_k.  canonicalized first for CanonicalKmerParser.  collective.
+		  * @details  only for KmerParser and CanonicalKmerParser, as build_packed.
+		  */
+		 void insert_kmers(::std::vector<KmerType> & kmers) {
+			 static_assert(::std::is_same<KmerParser, ::bliss::index::kmer::KmerParser<KmerType> >::value ||
+					 ::std::is_same<KmerParser, ::bliss::index::kmer::CanonicalKmerParser<KmerType> >::value,
+					 "insert_kmers only supports KmerParser and CanonicalKmerParser");
+
+			 if (::std::is_same<KmerParser, ::bliss::index::kmer::CanonicalKmerParser<KmerType> >::value)
+				 ::bliss::kmer::transform::lex_less<KmerType>().transform_inplace(kmers);
+			 this->map.insert(kmers);  // COLLECTIVE CALL...
+		 }
+
 
    typename MapType::const_iterator cbegin() const
    {
@@ -383,6 +984,12 @@ public:
      return map.cend();
    }
 
+   /// multithreaded alternative to cbegin/cend:  fn(entry, thread_id) is called concurrently for each local entry.
+   template <typename F>
+   void parallel_for_each_local(F fn, int const nthreads = 0) const {
+     map.parallel_for_each_local(fn, nthreads);
+   }
+
    size_t size() const {
      return map.size();
    }
@@ -399,26 +1006,178 @@ public:
 template <typename MapType>
 using KmerIndex = Index<MapType, KmerParser<typename MapType::key_type> >;
 
+/// kmer index with canonical kmers generated directly by the parser.  pair with a map that does not canonicalize its input, e.g. SingleStrandHashMapParams.
+template <typename MapType>
+using CanonicalKmerIndex = Index<MapType, CanonicalKmerParser<typename MapType::key_type> >;
+
+/// kmer index that only inserts kmers passing the quality thresholds.  FASTQ input only.  see QualityFilteredKmerParser.
+template <typename MapType, unsigned char MinBasePhred = 20, unsigned char MinKmerPhred = 0>
+using QualityFilteredKmerIndex = Index<MapType, QualityFilteredKmerParser<typename MapType::key_type, MinBasePhred, MinKmerPhred> >;
+
 template <typename MapType>
 using PositionIndex = Index<MapType, KmerPositionTupleParser<std::pair<typename MapType::key_type, typename MapType::mapped_type> > >;
 
+/// position index of the (W,k)-minimizers only, about 2/(W+1) of the entries of PositionIndex.  sample reads with sample_query.
+template <typename MapType, unsigned int W = 10>
+using MinimizerPositionIndex = Index<MapType, KmerPositionMinimizerTupleParser<std::pair<typename MapType::key_type, typename MapType::mapped_type>, W> >;
+
 template <typename MapType>
 using PositionQualityIndex = Index<MapType, KmerPositionQualityTupleParser<std::pair<typename MapType::key_type, typename MapType::mapped_type> > >;
 
+/// k-mer count index.  the parser emits bare k-mers and the counting map adds 1 per received key, so only keys are
+/// moved and distributed.  for counting maps, i.e. maps with insert(std::vector<key_type>&).
+template <typename MapType>
+using CountIndex = Index<MapType, KmerParser<typename MapType::key_type> >;
+/// same as CountIndex.
 template <typename MapType>
-using CountIndex = Index<MapType, KmerCountTupleParser<std::pair<typename MapType::key_type, typename MapType::mapped_type> > >;
+using CountIndex2 = CountIndex<MapType>;
+/// count index of spaced seeds, with care positions Mask, in a map keyed by kmers of the seed's weight.  see SpacedSeedKmerParser.
+template <typename MapType, uint64_t Mask>
+using SpacedSeedCountIndex = Index<MapType, SpacedSeedKmerParser<typename MapType::key_type, Mask> >;
+/// k-mer count index that emits (k-mer, 1) pairs, for maps that only insert pairs, e.g. reduction maps with other operators.
 template <typename MapType>
-using CountIndex2 = Index<MapType, KmerParser<typename MapType::key_type> >;
+using CountTupleIndex = Index<MapType, KmerCountTupleParser<std::pair<typename MapType::key_type, typename MapType::mapped_type> > >;
+
+
+namespace detail {
+	/// consumer for KmerFileHelper::stream_file_multi_k:  inserts the kmers of the I-th kmer type into the I-th index, in order.
+	template <typename... Indices>
+	struct multi_k_inserter {
+		::std::tuple<Indices &...> indices;
+
+		multi_k_inserter(Indices &... _indices) : indices(_indices...) {}
+
+		template <typename Buffers>
+		void operator()(Buffers & buffers) {
+			insert(buffers, ::bliss::utils::make_index_sequence<sizeof...(Indices)>());
+		}
+
+		/// the collective inserts are made in the same order on all ranks, as braced lists are evaluated left to right.
+		template <typename Buffers, size_t... I>
+		void insert(Buffers & buffers, ::bliss::utils::index_sequence<I...>) {
+			int dummy[] = {0, (::std::get<I>(indices).insert_kmers(::std::get<I>(buffers)), 0)...};
+			BLISS_UNUSED(dummy);
+		}
+
+		template <size_t... I>
+		void multiplicity(::bliss::utils::index_sequence<I...>) {
+			int dummy[] = {0, (::std::get<I>(indices).get_map().get_multiplicity(), 0)...};
+			BLISS_UNUSED(dummy);
+		}
+	};
+}
+
+/**
+ * @brief build several KmerIndex or CanonicalKmerIndex instances, e.g. 1 per k of a parameter sweep, from 1 pass over a file.  collective.
+ * @details  the file is opened, split into records, and each record translated once (MultiKmerParser), and the kmers of
+ * 			each k are inserted into its index, with the same content as build_mmap of each index.  with chunk_bytes > 0,
+ * 			the kmers of all k are bounded by chunk_bytes, and each chunk is inserted into the indices one after the other.
+ * 			every index's map makes its own exchange per chunk.  the partition overlap is for the largest k.
+ * @param chunk_bytes  kmer buffer bytes over all k.  0 to parse the whole partition before inserting.
+ * @return  number of kmers of all k on this rank.
+ */
+template <template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType, typename... Indices>
+size_t build_multi_k(const std::string & filename, size_t const chunk_bytes, const mxx::comm & comm, Indices &... indices) {
+	using MultiParser = MultiKmerParser<typename Indices::KmerType...>;
+
+	BL_BENCH_INIT(build);
+
+	BL_BENCH_START(build);
+	detail::multi_k_inserter<Indices...> consume(indices...);
+	::std::tuple<size_t, size_t, size_t> read = ::bliss::io::KmerFileHelper::template stream_file_multi_k<
+			::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>, MultiParser, SeqParser, SeqIterType>(
+					filename, chunk_bytes, consume, comm);
+	BL_BENCH_END(build, "read_insert", ::std::get<1>(read));
+
+	BL_BENCH_START(build);
+	consume.multiplicity(::bliss::utils::make_index_sequence<sizeof...(Indices)>());
+	BL_BENCH_END(build, "multiplicity", sizeof...(Indices));
+
+	BL_BENCH_REPORT_MPI_NAMED(build, "index:build_multi_k", comm);
+	return ::std::get<1>(read);
+}
+
+
+namespace detail {
+	/// observer for a multimap insert:  counts the keys each rank receives into a counting map.  see build_positions_and_counts.
+	template <typename CountMap>
+	struct owned_key_counter {
+		CountMap & counts;
+
+		template <typename V>
+		void operator()(::std::vector<V> const & entries) const {
+			counts.insert_owned(entries);
+		}
+	};
+}
+
+/**
+ * @brief build a position index and a count index of the same file from 1 parse and 1 exchange.  collective.
+ * @details  the position tuples are distributed by the position multimap's insert, and each rank counts the keys it
+ * 			receives into the counting map (see the multimaps' insert observer and counting_*_map::insert_owned), instead of
+ * 			distributing the kmers again.  so the counting map needs the same key type, MapParams and communicator as the
+ * 			position map, for the same owners.  the content is the same as build_mmap of each index.
+ * @param chunk_bytes  position tuple buffer bytes.  0 to parse the whole partition before inserting.
+ */
+template <template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType,
+	typename PositionIndexType, typename CountIndexType>
+void build_positions_and_counts(const std::string & filename, size_t const chunk_bytes, const mxx::comm & comm,
+		PositionIndexType & positions, CountIndexType & counts) {
+	using PositionParser = typename PositionIndexType::KmerParserType;
+	using CountMap = typename ::std::remove_reference<decltype(counts.get_map())>::type;
+	static_assert(::std::is_same<typename PositionIndexType::KmerType, typename CountIndexType::KmerType>::value,
+			"position and count indices need the same kmer type");
+
+	BL_BENCH_INIT(build);
+
+	detail::owned_key_counter<CountMap> counter{counts.get_map()};
+	auto consume = [&positions, &counter](::std::vector<typename PositionParser::value_type> & chunk) {
+		positions.get_map().insert(chunk, false, ::bliss::filter::TruePredicate(), counter);  // COLLECTIVE CALL...
+	};
+
+	BL_BENCH_START(build);
+	size_t kmers = 0;
+	if (chunk_bytes > 0) {
+		kmers = ::std::get<1>(::bliss::io::KmerFileHelper::template stream_file_mmap<PositionParser, SeqParser, SeqIterType>(
+				filename, chunk_bytes, consume, comm));
+	} else {
+		::std::vector<typename PositionParser::value_type> temp;
+		::bliss::io::KmerFileHelper::template read_file_mmap<PositionParser, SeqParser, SeqIterType>(filename, temp, comm);
+		kmers = temp.size();
+		consume(temp);
+	}
+	BL_BENCH_END(build, "read_insert", kmers);
+	BLISS_UNUSED(kmers);
+
+	BL_BENCH_START(build);
+	positions.get_map().get_multiplicity();
+	counts.get_map().get_multiplicity();
+	BL_BENCH_END(build, "multiplicity", 2);
+
+	BL_BENCH_REPORT_MPI_NAMED(build, "index:build_positions_and_counts", comm);
+}
 
 // template aliases for hash to be used as distribution hash
 template <typename Key>
 using DistHashFarm = ::bliss::kmer::hash::farm<Key, true>;
 template <typename Key>
 using DistHashMurmur = ::bliss::kmer::hash::murmur<Key, true>;
+/// batched (SIMD) hash, for the distribution of large inputs.
+template <typename Key>
+using DistHashMurmur64 = ::bliss::kmer::hash::murmur64<Key, true>;
+/// CRC32C instruction based hash.
+template <typename Key>
+using DistHashCRC = ::bliss::kmer::hash::crc32c<Key, true>;
 template <typename Key>
 using DistHashStd = ::bliss::kmer::hash::cpp_std<Key, true>;
 template <typename Key>
 using DistHashIdentity = ::bliss::kmer::hash::identity<Key, true>;
+/// distributes by minimizer, so consecutive kmers of a read go to the same rank.  pair with set_superkmer_compression(true).
+template <typename Key>
+using DistHashMinimizer = ::bliss::kmer::hash::minimizer<Key, true>;
+/// rolling, strand symmetric hash.  a kmer and its reverse complement go to the same rank without a lex_less DistTrans.
+template <typename Key>
+using DistHashNt = ::bliss::kmer::hash::nthash<Key, true>;
 
 
 template <typename Key>
@@ -426,9 +1185,19 @@ using StoreHashFarm = ::bliss::kmer::hash::farm<Key, false>;
 template <typename Key>
 using StoreHashMurmur = ::bliss::kmer::hash::murmur<Key, false>;
 template <typename Key>
+using StoreHashMurmur64 = ::bliss::kmer::hash::murmur64<Key, false>;
+/// cheap storage hash for use with DistHashMurmur:  the owner does not rehash the whole kmer.
+template <typename Key>
+using StoreHashFold = ::bliss::kmer::hash::murmur_fold<Key, false>;
+template <typename Key>
+using StoreHashCRC = ::bliss::kmer::hash::crc32c<Key, false>;
+template <typename Key>
 using StoreHashStd = ::bliss::kmer::hash::cpp_std<Key, false>;
 template <typename Key>
 using StoreHashIdentity = ::bliss::kmer::hash::identity<Key, false>;
+/// the value HashedKmerParser emits with each kmer.
+template <typename Key>
+using StoreHashNt = ::bliss::kmer::hash::nthash<Key, false>;
 
 // =================  Partially defined aliases for MapParams, for distributed_xxx_maps.
 // NOTE: when using this, need to further alias so that only Key param remains.
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    kmer_sketch.hpp
+ * @ingroup index
+ * @brief   distributed MinHash and HyperLogLog sketches of the canonical k-mer set of a file, without building an index.
+ * @details the file is streamed in chunks as for a streaming Index build (see KmerFileHelper::stream_file), with the
+ *          canonical k-mer parser.  each rank hashes its k-mers into a bottom-s MinHash and an HLL register array, and
+ *          the ranks merge them with 1 allreduce of a packed buffer.  memory is the sketches plus 1 chunk of k-mers.
+ *
+ *          both merges are idempotent, so sketching more files into the same object accumulates the union.
+ *          the MinHash gives the Jaccard index and mash distance between 2 sketches of the same k, s and hash.
+ *          the HLL gives the number of distinct canonical k-mers.
+ */
+#ifndef SRC_INDEX_KMER_SKETCH_HPP_
+#define SRC_INDEX_KMER_SKETCH_HPP_
+
+#include "bliss-config.hpp"
+
+#include "mpi.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>    // uint8_t, uint64_t
+#include <cstring>    // memcpy
+#include <cmath>      // log
+#include <algorithm>  // max, min
+#include <tuple>
+
+#include "mxx/comm.hpp"
+
+#include "io/file.hpp"
+#include "io/kmer_file_helper.hpp"
+#include "io/kmer_parser.hpp"
+#include "index/kmer_hash.hpp"
+#include "utils/hyperloglog.hpp"
+#include "utils/minhash.hpp"
+#include "utils/benchmark_utils.hpp"
+
+namespace bliss
+{
+namespace index
+{
+namespace kmer
+{
+
+  /**
+   * @brief  MPI reduction of packed sketches, in place in inout.
+   * @details  a packed sketch is 1 element of a contiguous type of uint64_t words:  s, the number of hashes n, s hash
+   *           slots of which the first n are used and ascending, then the HLL registers, 8 per word.  the sizes are
+   *           read from the buffer and the datatype, so 1 op serves all sketch sizes.  commutative.
+   */
+  inline void reduce_packed_sketch(void * in, void * inout, int * len, MPI_Datatype * datatype) {
+    int bytes = 0;
+    MPI_Type_size(*datatype, &bytes);
+    size_t words = static_cast<size_t>(bytes) / sizeof(uint64_t);
+
+    uint64_t const * a = reinterpret_cast<uint64_t const *>(in);
+    uint64_t * b = reinterpret_cast<uint64_t *>(inout);
+    std::vector<uint64_t> merged;
+
+    for (int e = 0; e < *len; ++e, a += words, b += words) {
+      size_t s = a[0];
+
+      // bottom s of the union of the 2 ascending lists.
+      merged.clear();
+      uint64_t const * x = a + 2, * x_end = x + a[1];
+      uint64_t const * y = b + 2, * y_end = y + b[1];
+      while ((merged.size() < s) && ((x != x_end) || (y != y_end))) {
+        if ((y == y_end) || ((x != x_end) && (*x < *y))) merged.push_back(*(x++));
+        else if ((x == x_end) || (*y < *x)) merged.push_back(*(y++));
+        else { merged.push_back(*x); ++x; ++y; }
+      }
+      b[1] = merged.size();
+      std::copy(merged.begin(), merged.end(), b + 2);
+
+      // register max, bytewise.
+      uint8_t const * ra = reinterpret_cast<uint8_t const *>(a + 2 + s);
+      uint8_t * rb = reinterpret_cast<uint8_t *>(b + 2 + s);
+      size_t reg_bytes = (words - 2 - s) * sizeof(uint64_t);
+      for (size_t i = 0; i < reg_bytes; ++i) {
+        rb[i] = ::std::max(ra[i], rb[i]);
+      }
+    }
+  }
+
+
+  /**
+   * @brief MinHash and HyperLogLog sketches of the canonical k-mers of files.
+   * @tparam KmerType   kmer type.  the k-mers are made canonical by the parser.
+   * @tparam PRECISION  HLL precision, see hyperloglog.
+   * @tparam Hash       kmer hash functor from kmer_hash.hpp.  sketches are comparable only with the same hash.
+   */
+  template <typename KmerType, uint8_t PRECISION = 12,
+      template <typename, bool> class Hash = ::bliss::kmer::hash::murmur64>
+  class KmerSketch {
+    public:
+      using kmer_type = KmerType;
+      using KmerParser = ::bliss::io::CanonicalKmerParser<KmerType>;
+
+      /// default chunk size for streaming the file.
+      static constexpr size_t default_chunk_bytes = 16UL * 1024UL * 1024UL;
+
+    protected:
+      const mxx::comm& comm;
+
+      Hash<KmerType, false> hash;
+      ::bliss::utils::bottom_minhash minhash;
+      ::bliss::utils::hyperloglog<PRECISION> hll;
+
+      size_t chunk_bytes;
+
+      /// hash the k-mers into the local sketches.
+      void update(std::vector<KmerType> const & kmers) {
+        for (auto it = kmers.begin(); it != kmers.end(); ++it) {
+          uint64_t h = hash(*it);
+          minhash.update(h);
+          hll.update(h);
+        }
+      }
+
+      /// stream the k-mers of a file into the local sketches, then merge across ranks.  collective.
+      template <typename FileType, template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType>
+      void sketch(const std::string & filename) {
+        BL_BENCH_INIT(sketch);
+
+        BL_BENCH_START(sketch);
+        auto consume = [this](std::vector<KmerType> & chunk) {
+          this->update(chunk);
+        };
+        auto read = ::bliss::io::KmerFileHelper::template stream_file<FileType, KmerParser, SeqParser, SeqIterType>(filename,
+            chunk_bytes, consume, comm);
+        BL_BENCH_END(sketch, "stream_hash", std::get<1>(read));
+
+        BL_BENCH_START(sketch);
+        reduce();
+        BL_BENCH_END(sketch, "reduce", minhash.get_hashes().size());
+
+        BL_BENCH_REPORT_MPI_NAMED(sketch, "index:sketch", comm);
+      }
+
+    public:
+      /**
+       * @param _s            number of hashes in the MinHash.  the Jaccard index has standard error about 1/sqrt(s).
+       * @param _chunk_bytes  k-mer buffer size for streaming the file.
+       */
+      KmerSketch(const mxx::comm& _comm, size_t const _s = 1000, size_t const _chunk_bytes = default_chunk_bytes) :
+        comm(_comm), hash(), minhash(_s), hll(), chunk_bytes(::std::max(_chunk_bytes, static_cast<size_t>(1))) {}
+
+      virtual ~KmerSketch() {}
+
+      /// sketch a file via mpiio.  collective.
+      template <template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType>
+      void sketch_mpiio(const std::string & filename) {
+        this->template sketch<::bliss::io::parallel::mpiio_file<SeqParser >, SeqParser, SeqIterType>(filename);
+      }
+
+      /// sketch a file via mmap.  collective.
+      template <template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType>
+      void sketch_mmap(const std::string & filename) {
+        this->template sketch<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser >, SeqParser, SeqIterType>(filename);
+      }
+
+      /// sketch a file via posix read.  collective.
+      template <template <typename> class SeqParser, template <typename, template <typename> class> class SeqIterType>
+      void sketch_posix(const std::string & filename) {
+        this->template sketch<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, SeqParser >, SeqParser, SeqIterType>(filename);
+      }
+
+      /// add k-mers from this rank, e.g. parsed elsewhere.  local.  they should be canonical.  call reduce after.
+      void insert(std::vector<KmerType> const & kmers) {
+        update(kmers);
+      }
+
+      /// merge the sketches of all ranks, so that every rank has the global ones.  1 allreduce.  collective.
+      void reduce() {
+        std::vector<uint64_t> const & h = minhash.get_hashes();
+        size_t s = minhash.get_sketch_size();
+        size_t reg_words = hll.get_registers().size() / sizeof(uint64_t);   // 2^PRECISION bytes, PRECISION >= 4.
+
+        std::vector<uint64_t> packed(2 + s + reg_words, 0);
+        packed[0] = s;
+        packed[1] = h.size();
+        std::copy(h.begin(), h.end(), packed.begin() + 2);
+        memcpy(packed.data() + 2 + s, hll.get_registers().data(), hll.get_registers().size());
+
+        MPI_Datatype dt;
+        MPI_Type_contiguous(static_cast<int>(packed.size()), MPI_UINT64_T, &dt);
+        MPI_Type_commit(&dt);
+        MPI_Op op;
+        MPI_Op_create(&reduce_packed_sketch, 1, &op);
+
+        MPI_Allreduce(MPI_IN_PLACE, packed.data(), 1, dt, op, comm);
+
+        MPI_Op_free(&op);
+        MPI_Type_free(&dt);
+
+        minhash.set_hashes(std::vector<uint64_t>(packed.begin() + 2, packed.begin() + 2 + packed[1]));
+        memcpy(hll.get_registers().data(), packed.data() + 2 + s, hll.get_registers().size());
+      }
+
+      /// estimated number of distinct canonical k-mers, from the HLL.  local, valid after reduce.
+      double cardinality() const {
+        return hll.estimate();
+      }
+
+      /// estimated Jaccard index of the k-mer sets of this and other, from the MinHash.  local, valid after reduce.
+      double jaccard(KmerSketch const & other) const {
+        return minhash.jaccard(other.minhash);
+      }
+
+      /// mash distance, an estimate of the per base mutation rate:  -1/k ln(2j / (1 + j)).  1 if nothing is shared.
+      double distance(KmerSketch const & other) const {
+        double j = jaccard(other);
+        if (j <= 0.0) return 1.0;
+        return -::std::log(2.0 * j / (1.0 + j)) / static_cast<double>(KmerType::size);
+      }
+
+      ::bliss::utils::bottom_minhash const & get_minhash() const { return minhash; }
+      ::bliss::utils::hyperloglog<PRECISION> const & get_hll() const { return hll; }
+
+      void clear() {
+        minhash.clear();
+        hll.clear();
+      }
+  };
+
+  template <typename KmerType, uint8_t PRECISION, template <typename, bool> class Hash>
+  constexpr size_t KmerSketch<KmerType, PRECISION, Hash>::default_chunk_bytes;
+
+} // namespace kmer
+} // namespace index
+} // namespace bliss
+
+#endif /* SRC_INDEX_KMER_SKETCH_HPP_ */
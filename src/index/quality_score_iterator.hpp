@@ -28,10 +28,23 @@
 #define BLISS_INDEX_QUALITY_SCORE_ITERATOR_HPP
 
 #include <vector>
+#include <cmath>       // exp2
+#include <cstdint>
 
+#include "bliss-config.hpp"
 #include "index/quality_scores.hpp"
 #include "iterators/sliding_window_iterator.hpp"
 
+#if defined(__AVX__)
+#include <x86intrin.h>   // all intrinsics.  will be enabled based on compiler flag such as __AVX__ internally.
+#endif
+
+#if defined __GNUC__ && __GNUC__>=6
+// disable __m256d ignored attribute warning in gcc
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
 namespace bliss
 {
 namespace index
@@ -318,7 +331,90 @@ protected:
 
 
 
+/**
+ * @brief bulk version of QualityScoreGenerationIterator:  computes the quality of all kmers in a contiguous array of quality characters.
+ * @details the characters are decoded by the Encoder's table into prefix sums of log2(p_correct) and of the number of incorrect bases,
+ *          with the same definition of incorrect as QualityScoreSlidingWindow.  the kmer at position i then has log2 quality
+ *          prefix[i + k] - prefix[i], computed 4 (doubles) or 8 (floats) kmers at a time with AVX, and is 0 if it has an incorrect base.
+ *          the EOL characters, if any, should be removed first.
+ *
+ *          the result can differ from the sliding window in the last bits, since the sums are taken in a different order.
+ * @tparam KMER_SIZE  number of characters in a kmer
+ * @tparam Encoder    quality score codec.
+ */
+template <unsigned int KMER_SIZE, typename Encoder = bliss::index::Illumina18QualityScoreCodec<double> >
+class QualityScoreBulk
+{
+  public:
+    typedef typename Encoder::value_type QualityType;
+
+  protected:
+    /// reusable prefix sum buffers.
+    std::vector<QualityType> sums;
+    std::vector<uint32_t> incorrect;
+
+    /// out[i] = sums[i + KMER_SIZE] - sums[i]
+    static void window_diff(double const * s, size_t const & count, double * out) {
+      size_t i = 0;
+#if defined(__AVX__)
+      for (; (i + 4) <= count; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(s + i + KMER_SIZE), _mm256_loadu_pd(s + i)));
+      }
+#endif
+      for (; i < count; ++i) out[i] = s[i + KMER_SIZE] - s[i];
+    }
+    static void window_diff(float const * s, size_t const & count, float * out) {
+      size_t i = 0;
+#if defined(__AVX__)
+      for (; (i + 8) <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_loadu_ps(s + i + KMER_SIZE), _mm256_loadu_ps(s + i)));
+      }
+#endif
+      for (; i < count; ++i) out[i] = s[i + KMER_SIZE] - s[i];
+    }
+
+  public:
+    /**
+     * @brief compute the probability that each kmer is correct.
+     * @param in     quality characters, without EOL
+     * @param count  number of characters
+     * @param out    output, with space for count - KMER_SIZE + 1 values.
+     * @return       number of kmers, count - KMER_SIZE + 1, or 0 if count < KMER_SIZE.
+     */
+    size_t operator()(unsigned char const * in, size_t const & count, QualityType * out) {
+      if (count < KMER_SIZE) return 0;
+      size_t kmers = count - KMER_SIZE + 1;
+
+      sums.resize(count + 1);
+      incorrect.resize(count + 1);
+      sums[0] = 0;
+      incorrect[0] = 0;
+      QualityType v;
+      for (size_t i = 0; i < count; ++i) {
+        v = Encoder::decode(in[i]);
+        if ((v > Encoder::DecodeLUT[0]) && (v < Encoder::DecodeLUT[95])) {
+          sums[i + 1] = sums[i] + v;
+          incorrect[i + 1] = incorrect[i];
+        } else {
+          sums[i + 1] = sums[i];
+          incorrect[i + 1] = incorrect[i] + 1;
+        }
+      }
+
+      window_diff(sums.data(), kmers, out);
+
+      for (size_t i = 0; i < kmers; ++i) {
+        out[i] = (incorrect[i + KMER_SIZE] != incorrect[i]) ? 0.0 : std::exp2(out[i]);
+      }
+      return kmers;
+    }
+};
+
 } // namespace index
 } // namespace bliss
 
+#if defined __GNUC__ && __GNUC__>=6
+  #pragma GCC diagnostic pop
+#endif
+
 #endif // BLISS_INDEX_QUALITY_SCORE_ITERATOR_HPP
@@ -33,6 +33,8 @@
 #include <array>
 #include <limits>
 #include <algorithm>
+#include <cstdint>
+#include <type_traits>
 
 #include "utils/constexpr_array.hpp"
 
@@ -541,10 +543,141 @@ using Illumina13QualityScoreCodec = QualityScoreCodec<OutT, 64, 126, 0>;
 template<typename OutT>
 using Illumina15QualityScoreCodec = QualityScoreCodec<OutT, 64, 126, 3>;  // special Q val of 2 indicate bases should not be used, not a quality measurement
 
+/**
+ * @brief quality score codec that decodes scores below MinPhred as incorrect (probability 0 of being correct, same as phred 0).
+ * @details used to filter kmers with any low quality base:  the sliding window kmer quality (QualityScoreSlidingWindow) is then 0.
+ *          the threshold is the decoded value of phred score MinPhred, DecodeLUT[MinPhred].
+ * @tparam Codec     the underlying codec.  one of the codecs above.
+ * @tparam MinPhred  the minimum phred score of a correct base.
+ */
+template <typename Codec, unsigned char MinPhred>
+struct MinPhredQualityScoreCodec : public Codec
+{
+    static_assert(MinPhred < 96, "MinPhred is outside of the phred score table.");
+
+    inline static typename Codec::value_type decode(const unsigned char score)
+    {
+      typename Codec::value_type v = Codec::decode(score);
+      return (v < Codec::DecodeLUT[MinPhred]) ? Codec::DecodeLUT[0] : v;
+    }
+};
+
 // illumina 1.0/Solexa uses a different quality score measurement (-10 log_10(p/1-p)), not phred score.  for now, disable.
 //template<typename OutT>
 //using SolexaQualityScoreCodec = QualityScoreCodec<OutT, 59, 126, -5>;
 
+/**
+ * @brief kmer quality, the probability p that a kmer is correct, quantized to fixed point -log2(p) in an 8 or 16 bit integer.
+ * @details a smaller replacement for the double quality of pos-qual and de bruijn quality tuples, in memory and on the wire.
+ *          code = round(-log2(p) * 2^FracBits), saturating at max - 1.  max is reserved for p = 0, i.e. a kmer with an
+ *          incorrect base.  the relative error in p is at most ln(2) * 2^-(FracBits + 1).
+ *
+ *          reductions work on the codes without decoding:  the product of probabilities is the saturating sum of the codes,
+ *          and the comparisons (higher probability is greater), hence min and max, compare the codes.
+ *
+ *          conversions from and to floating point are explicit, so that mixed expressions do not silently decode.
+ * @tparam StorageT  unsigned integer type of the code.
+ * @tparam FracBits  fractional bits of -log2(p).
+ */
+template <typename StorageT, unsigned int FracBits>
+struct QuantizedQuality
+{
+    static_assert(std::is_integral<StorageT>::value && std::is_unsigned<StorageT>::value, "quantized quality needs an unsigned integer code");
+    static_assert(FracBits < sizeof(StorageT) * 8, "quantized quality needs at least 1 integer bit");
+
+    using storage_type = StorageT;
+
+    /// code of p = 0.
+    static constexpr StorageT incorrect = std::numeric_limits<StorageT>::max();
+    /// largest code of p > 0, i.e. p = 2^-(saturated / 2^FracBits).  smaller p are rounded up to it.
+    static constexpr StorageT saturated = std::numeric_limits<StorageT>::max() - 1;
+
+    StorageT code;
+
+    /// p = 1
+    QuantizedQuality() : code(0) {}
+    explicit QuantizedQuality(double const p) : code(encode(p)) {}
+
+    static constexpr double scale() {
+      return static_cast<double>(1ULL << FracBits);
+    }
+
+    /// code of probability p, in [0, 1].
+    inline static StorageT encode(double const p) {
+      if (!(p > 0.0)) return incorrect;   // also nan
+      if (p >= 1.0) return 0;
+      double c = -std::log2(p) * scale() + 0.5;
+      return (c >= static_cast<double>(saturated)) ? saturated : static_cast<StorageT>(c);
+    }
+
+    /// probability of code c.
+    inline static double decode(StorageT const c) {
+      return (c == incorrect) ? 0.0 : std::exp2(-static_cast<double>(c) / scale());
+    }
+
+    inline double probability() const {
+      return decode(code);
+    }
+    explicit operator double() const {
+      return decode(code);
+    }
+    explicit operator float() const {
+      return static_cast<float>(decode(code));
+    }
+
+    /// product of the probabilities.  saturating, and p = 0 absorbs.
+    inline QuantizedQuality & operator*=(QuantizedQuality const & other) {
+      if ((code == incorrect) || (other.code == incorrect)) {
+        code = incorrect;
+      } else {
+        uint64_t c = static_cast<uint64_t>(code) + static_cast<uint64_t>(other.code);
+        code = (c >= saturated) ? saturated : static_cast<StorageT>(c);
+      }
+      return *this;
+    }
+    inline friend QuantizedQuality operator*(QuantizedQuality x, QuantizedQuality const & y) {
+      return x *= y;
+    }
+
+    inline friend bool operator==(QuantizedQuality const & x, QuantizedQuality const & y) { return x.code == y.code; }
+    inline friend bool operator!=(QuantizedQuality const & x, QuantizedQuality const & y) { return x.code != y.code; }
+    /// lower probability is less, i.e. a larger code.
+    inline friend bool operator<(QuantizedQuality const & x, QuantizedQuality const & y) { return x.code > y.code; }
+    inline friend bool operator>(QuantizedQuality const & x, QuantizedQuality const & y) { return x.code < y.code; }
+    inline friend bool operator<=(QuantizedQuality const & x, QuantizedQuality const & y) { return x.code >= y.code; }
+    inline friend bool operator>=(QuantizedQuality const & x, QuantizedQuality const & y) { return x.code <= y.code; }
+};
+
+template <typename StorageT, unsigned int FracBits>
+constexpr StorageT QuantizedQuality<StorageT, FracBits>::incorrect;
+template <typename StorageT, unsigned int FracBits>
+constexpr StorageT QuantizedQuality<StorageT, FracBits>::saturated;
+
+/// 1 byte.  steps of 1/64 bit, i.e. p within 0.55%, down to p = 2^-3.97, about 0.064.
+using QuantizedQuality8 = QuantizedQuality<uint8_t, 6>;
+/// 2 bytes.  steps of 1/4096 bit, i.e. p within 0.009%, down to p = 2^-16.
+using QuantizedQuality16 = QuantizedQuality<uint16_t, 12>;
+
+
+/// floating point type that a quality type is computed in by the codecs.  itself for float and double, double for quantized.
+template <typename QualType>
+struct QualityComputeType {
+    static_assert(std::is_floating_point<QualType>::value, "quality type needs to be floating point or QuantizedQuality");
+    using type = QualType;
+};
+template <typename StorageT, unsigned int FracBits>
+struct QualityComputeType<QuantizedQuality<StorageT, FracBits> > {
+    using type = double;
+};
+
+/// converts the computed kmer probability to the quality type.  for transform_iterator.
+template <typename QualType>
+struct QualityQuantizer
+{
+    inline QualType operator()(typename QualityComputeType<QualType>::type const & p) const {
+      return QualType(p);
+    }
+};
 
 
 } // namespace index
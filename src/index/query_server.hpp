@@ -0,0 +1,364 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    query_server.hpp
+ * @ingroup index
+ * @brief   long running k-mer query server over a built index, for local client processes.
+ * @details every rank listens on a unix domain stream socket, "<prefix>.<rank>" in the abstract namespace (see
+ *          unix_domain_socket.h).  a client connects to any rank, usually one on its node, and sends requests:  a
+ *          query_message_header with op find or count and the number of keys, followed by the keys.  the reply is a
+ *          header with the number of results, followed by the (key, value) results of find or (key, count) of count,
+ *          as the index returns them.  keys in the results are as stored, e.g. canonical.  a connection can carry any
+ *          number of requests.
+ *
+ *          the server works in batch windows.  during a window each rank collects the requests that arrive from its
+ *          clients.  at the end of the window the ranks agree on whether any of them has find or count requests, and run
+ *          at most 1 collective find and 1 collective count for all of them together.  so the cost of a round is shared
+ *          by all the clients of the window.  an idle window costs 1 allreduce.
+ *
+ *          a shutdown request from any client stops all ranks at the end of the window.
+ *          key and result types are sent as raw bytes, so clients must use the same types as the server.
+ */
+#ifndef SRC_INDEX_QUERY_SERVER_HPP_
+#define SRC_INDEX_QUERY_SERVER_HPP_
+
+#include "bliss-config.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>      // pair
+#include <algorithm>    // sort, equal_range
+#include <functional>   // bit_or
+#include <type_traits>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+
+#include <unistd.h>     // close
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+#include "io/io_exception.hpp"
+#include "io/unix_domain_socket.h"
+#include "utils/transform_utils.hpp"
+
+namespace bliss
+{
+namespace index
+{
+
+  /// request types of the query server.
+  struct query_op {
+      enum : uint32_t { find = 1, count = 2, shutdown = 3 };
+  };
+
+  /// request and reply header of the query server.
+  struct query_message_header {
+      static constexpr uint32_t magic_value = 0x424c5153;  // "BLQS"
+
+      uint32_t magic;
+      /// a query_op
+      uint32_t op;
+      /// number of keys in a request, number of results in a reply.
+      uint64_t count;
+  };
+
+  /// socket name of the query server on rank.  the leading '#' is replaced by the abstract namespace marker.
+  inline ::std::string query_socket_name(::std::string const & prefix, int const rank) {
+    ::std::stringstream ss;
+    ss << "#" << prefix << "." << rank;
+    return ss.str();
+  }
+
+  namespace detail {
+    /// the input transform of a map that has one, e.g. ::dsc::densehash_map_base.  identity otherwise.
+    template <typename Map>
+    typename Map::input_transform_type query_transform(int);
+    template <typename Map>
+    ::bliss::transform::identity<typename Map::key_type> query_transform(long);
+  }
+
+
+  /**
+   * @brief batching query server over an index.  see file description.
+   * @tparam IndexType   provides KmerType, find, count, and get_map, e.g. ::bliss::index::kmer::Index.
+   */
+  template <typename IndexType>
+  class query_server {
+
+    public:
+      using KmerType = typename IndexType::KmerType;
+      using MapType = typename ::std::decay<decltype(::std::declval<IndexType &>().get_map())>::type;
+      using FindResultType = typename ::std::decay<decltype(::std::declval<IndexType &>().find(
+          ::std::declval<::std::vector<KmerType> &>()))>::type::value_type;
+      using CountResultType = typename ::std::decay<decltype(::std::declval<IndexType &>().count(
+          ::std::declval<::std::vector<KmerType> &>()))>::type::value_type;
+
+    protected:
+      using Transform = decltype(detail::query_transform<MapType>(0));
+
+      /// a connected client, and its request if it has one.
+      struct client {
+          int fd;
+          uint32_t op;   // 0 if no request
+          ::std::vector<KmerType> keys;
+      };
+
+      IndexType & index;
+      const mxx::comm& comm;
+
+      int listen_fd;
+      ::std::vector<client> clients;
+
+      /// batch window in milliseconds
+      int window_ms;
+
+      Transform trans;
+
+      /// close and drop client i.
+      void drop(size_t i) {
+        close(clients[i].fd);
+        clients[i] = ::std::move(clients.back());
+        clients.pop_back();
+      }
+
+      /// read a request from client i, whose socket is readable.  returns false if the client is gone or sent garbage.
+      bool read_request(client & c, bool & shutdown) {
+        query_message_header h;
+        if (!::bliss::io::util::recv_all(c.fd, &h, sizeof(h))) return false;
+        if (h.magic != query_message_header::magic_value) return false;
+
+        if (h.op == query_op::shutdown) {
+          shutdown = true;
+          return false;
+        }
+        if ((h.op != query_op::find) && (h.op != query_op::count)) return false;
+
+        c.keys.resize(h.count);
+        if (!::bliss::io::util::recv_all(c.fd, c.keys.data(), h.count * sizeof(KmerType))) return false;
+        c.op = h.op;
+        return true;
+      }
+
+      /// collect requests until the window closes.  returns true if a shutdown was requested.
+      bool collect(int const timeout_ms) {
+        bool shutdown = false;
+        auto deadline = ::std::chrono::steady_clock::now() + ::std::chrono::milliseconds(timeout_ms);
+
+        ::std::vector<struct pollfd> fds;
+        while (true) {
+          int remaining = static_cast<int>(::std::chrono::duration_cast<::std::chrono::milliseconds>(
+              deadline - ::std::chrono::steady_clock::now()).count());
+          if (remaining < 0) break;
+
+          // listen socket, then the clients without a pending request.
+          fds.clear();
+          struct pollfd p;
+          p.fd = listen_fd;
+          p.events = POLLIN;
+          p.revents = 0;
+          fds.emplace_back(p);
+          ::std::vector<size_t> idx;
+          for (size_t i = 0; i < clients.size(); ++i) {
+            if (clients[i].op != 0) continue;
+            p.fd = clients[i].fd;
+            fds.emplace_back(p);
+            idx.emplace_back(i);
+          }
+
+          int ready = poll(fds.data(), fds.size(), remaining);
+          if (ready <= 0) continue;   // timeout or EINTR.  loop checks the deadline.
+
+          // requests first:  dropping reorders clients, so go from the back.
+          for (size_t j = fds.size() - 1; j > 0; --j) {
+            if (fds[j].revents == 0) continue;
+            if (!read_request(clients[idx[j - 1]], shutdown)) drop(idx[j - 1]);
+          }
+
+          if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd >= 0) {
+              client c;
+              c.fd = fd;
+              c.op = 0;
+              clients.emplace_back(::std::move(c));
+            }
+          }
+        }
+        return shutdown;
+      }
+
+      /// answer the clients with requests of type op from the results of 1 collective call.
+      template <typename Result, typename Query>
+      void round(uint32_t const op, Query const & query) {
+        ::std::vector<KmerType> batch;
+        for (auto const & c : clients) {
+          if (c.op == op) batch.insert(batch.end(), c.keys.begin(), c.keys.end());
+        }
+
+        // collective
+        ::std::vector<Result> results = query(batch);
+        ::std::sort(results.begin(), results.end(), [](Result const & x, Result const & y) {
+          return x.first < y.first;
+        });
+
+        // the results of each client's keys.  query keys are transformed to match the stored keys.
+        ::std::vector<Result> reply;
+        for (size_t i = clients.size(); i > 0; --i) {
+          client & c = clients[i - 1];
+          if (c.op != op) continue;
+
+          reply.clear();
+          for (auto const & k : c.keys) {
+            KmerType tk = trans(k);
+            auto range = ::std::equal_range(results.begin(), results.end(), Result(tk, typename Result::second_type()),
+                                            [](Result const & x, Result const & y) { return x.first < y.first; });
+            reply.insert(reply.end(), range.first, range.second);
+          }
+
+          query_message_header h;
+          h.magic = query_message_header::magic_value;
+          h.op = op;
+          h.count = reply.size();
+          c.op = 0;
+          ::std::vector<KmerType>().swap(c.keys);
+          if (!::bliss::io::util::send_all(c.fd, &h, sizeof(h)) ||
+              !::bliss::io::util::send_all(c.fd, reply.data(), reply.size() * sizeof(Result))) drop(i - 1);
+        }
+      }
+
+    public:
+      /**
+       * @brief start listening.  collective, and only after the listening sockets of all ranks exist.
+       * @param prefix      socket name prefix.  rank r listens at query_socket_name(prefix, r).
+       * @param _window_ms  batch window.
+       */
+      query_server(IndexType & _index, const mxx::comm& _comm, ::std::string const & prefix, int const _window_ms = 10) :
+        index(_index), comm(_comm), listen_fd(-1), window_ms(_window_ms), trans() {
+        listen_fd = ::bliss::io::util::listen_stream(query_socket_name(prefix, comm.rank()));
+        comm.barrier();
+      }
+
+      ~query_server() {
+        for (auto & c : clients) close(c.fd);
+        if (listen_fd >= 0) close(listen_fd);
+      }
+
+      query_server(query_server const & other) = delete;
+      query_server& operator=(query_server const & other) = delete;
+
+      /**
+       * @brief serve requests until a client asks for shutdown.  collective.
+       * @return number of rounds with queries.
+       */
+      size_t serve() {
+        size_t rounds = 0;
+        while (true) {
+          bool shutdown = collect(window_ms);
+
+          int flags = shutdown ? 4 : 0;
+          for (auto const & c : clients) {
+            if (c.op == query_op::find) flags |= 1;
+            else if (c.op == query_op::count) flags |= 2;
+          }
+          flags = ::mxx::allreduce(flags, ::std::bit_or<int>(), comm);
+
+          if (flags & 1) {
+            round<FindResultType>(query_op::find, [this](::std::vector<KmerType> & q) { return index.find(q); });
+          }
+          if (flags & 2) {
+            round<CountResultType>(query_op::count, [this](::std::vector<KmerType> & q) { return index.count(q); });
+          }
+          if (flags & 3) ++rounds;
+
+          if (flags & 4) break;
+        }
+        return rounds;
+      }
+  };
+
+
+  /**
+   * @brief client of query_server.  not thread safe.
+   * @tparam FindResultType, CountResultType   as the server's.
+   */
+  template <typename KmerType, typename FindResultType, typename CountResultType = ::std::pair<KmerType, size_t> >
+  class query_client {
+
+    protected:
+      int fd;
+
+      template <typename Result>
+      void request(uint32_t const op, ::std::vector<KmerType> const & keys, ::std::vector<Result> & results) {
+        query_message_header h;
+        h.magic = query_message_header::magic_value;
+        h.op = op;
+        h.count = keys.size();
+        if (!::bliss::io::util::send_all(fd, &h, sizeof(h)) ||
+            !::bliss::io::util::send_all(fd, keys.data(), keys.size() * sizeof(KmerType)))
+          throw ::bliss::io::IOException("ERROR: query server connection lost while sending");
+
+        if (!::bliss::io::util::recv_all(fd, &h, sizeof(h)) || (h.magic != query_message_header::magic_value) || (h.op != op))
+          throw ::bliss::io::IOException("ERROR: bad reply from query server");
+        results.resize(h.count);
+        if (!::bliss::io::util::recv_all(fd, results.data(), h.count * sizeof(Result)))
+          throw ::bliss::io::IOException("ERROR: query server connection lost while receiving");
+      }
+
+    public:
+      /// connect to the server of rank.  throws if there is none.
+      query_client(::std::string const & prefix, int const rank) : fd(-1) {
+        fd = ::bliss::io::util::connect_stream(query_socket_name(prefix, rank));
+        if (fd < 0) throw ::bliss::io::IOException("ERROR: unable to connect to query server");
+      }
+
+      ~query_client() {
+        if (fd >= 0) close(fd);
+      }
+
+      query_client(query_client const & other) = delete;
+      query_client& operator=(query_client const & other) = delete;
+
+      /// the entries of the keys, as the index's find.  results is replaced.
+      void find(::std::vector<KmerType> const & keys, ::std::vector<FindResultType> & results) {
+        request(query_op::find, keys, results);
+      }
+
+      /// the counts of the keys, as the index's count.  results is replaced.
+      void count(::std::vector<KmerType> const & keys, ::std::vector<CountResultType> & results) {
+        request(query_op::count, keys, results);
+      }
+
+      /// stop the servers on all ranks.  the connection is closed.
+      void shutdown() {
+        query_message_header h;
+        h.magic = query_message_header::magic_value;
+        h.op = query_op::shutdown;
+        h.count = 0;
+        ::bliss::io::util::send_all(fd, &h, sizeof(h));
+        close(fd);
+        fd = -1;
+      }
+  };
+
+} // namespace index
+} // namespace bliss
+
+#endif // SRC_INDEX_QUERY_SERVER_HPP_
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    query_trace.hpp
+ * @ingroup index
+ * @brief   capture of the find and count batches of an index, and their replay with latency percentiles.
+ * @details a trace is 1 file per rank, "<prefix>.<rank>":  a fixed size header, then 1 record per collective find or
+ *          count call, in call order.  a record is a batch header (op, number of keys, and the local latency of the
+ *          original call) followed by the rank's query keys as passed to the call, as raw bytes.  so a trace holds the
+ *          real key mix, with its hit rate, repeats and skew, and the batching, in about the size of the keys.
+ *
+ *          Index::set_query_trace starts a capture, e.g. while a query_server runs.  replay_query_trace re-issues the
+ *          batches against an index, e.g. 1 loaded with Index::load, with the same batches on every rank, and reports
+ *          the latency percentiles per op.  the index needs the same key type and number of ranks as the captured one.
+ */
+#ifndef SRC_INDEX_QUERY_TRACE_HPP_
+#define SRC_INDEX_QUERY_TRACE_HPP_
+
+#include <string>
+#include <vector>
+#include <cstring>      // memcpy, memset, strerror
+#include <cstdint>
+#include <sstream>
+#include <algorithm>    // sort, min
+#include <chrono>
+
+#include <unistd.h>     // read, write, close
+#include <fcntl.h>      // open
+#include <errno.h>
+
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+#include "io/io_exception.hpp"
+
+namespace bliss
+{
+namespace index
+{
+
+  /// fixed size header of a query trace file.
+  struct query_trace_header {
+      static constexpr uint32_t current_version = 1;
+      static constexpr uint32_t endian_value = 0x01020304;
+
+      char magic[8];
+      uint32_t version;
+      uint32_t endian_check;
+      uint32_t key_bytes;
+      int32_t comm_size;
+      int32_t comm_rank;
+      uint32_t reserved;
+  };
+
+  /// header of 1 captured batch, followed by nkeys keys.
+  struct query_trace_batch {
+      /// ops of the batches.
+      enum : uint32_t { find = 1, count = 2 };
+
+      uint32_t op;
+      uint32_t reserved;
+      uint64_t nkeys;
+      /// local wall time of the original call, in nanoseconds.
+      uint64_t nanoseconds;
+  };
+
+  /// name of an op, for reports.
+  inline ::std::string query_trace_op_name(uint32_t const op) {
+    return (op == query_trace_batch::find) ? "find" : ((op == query_trace_batch::count) ? "count" : "unknown");
+  }
+
+  /// file name of rank's trace.
+  inline ::std::string query_trace_file_name(::std::string const & prefix, int const rank) {
+    ::std::stringstream ss;
+    ss << prefix << "." << rank;
+    return ss.str();
+  }
+
+  namespace detail {
+    inline void trace_error(::std::string const & what, ::std::string const & filename, int const myerr) {
+      ::std::stringstream ss;
+      ss << "ERROR: query trace " << what << ": [" << filename << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::io::IOException(ss.str());
+    }
+  }
+
+
+  /**
+   * @brief writes the batches of 1 rank to its trace file.  local.
+   * @tparam Key  key type, written as raw bytes.
+   */
+  template <typename Key>
+  class query_trace_writer {
+    protected:
+      ::std::string filename;
+      int fd;
+      size_t batches;
+
+      void write_all(void const * data, size_t bytes) {
+        char const * p = static_cast<char const *>(data);
+        while (bytes > 0) {
+          ssize_t n = ::write(fd, p, bytes);
+          if (n < 0) {
+            if (errno == EINTR) continue;
+            detail::trace_error("write", filename, errno);
+          }
+          p += n;
+          bytes -= n;
+        }
+      }
+
+    public:
+      /// create "<prefix>.<rank>", replacing an older trace.  throws IOException if it cannot be created.
+      query_trace_writer(::std::string const & prefix, int const comm_size, int const comm_rank) :
+        filename(query_trace_file_name(prefix, comm_rank)), fd(-1), batches(0) {
+        fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd < 0) detail::trace_error("open", filename, errno);
+
+        query_trace_header h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, "BLISSQTR", 8);
+        h.version = query_trace_header::current_version;
+        h.endian_check = query_trace_header::endian_value;
+        h.key_bytes = sizeof(Key);
+        h.comm_size = comm_size;
+        h.comm_rank = comm_rank;
+        write_all(&h, sizeof(h));
+      }
+
+      query_trace_writer(query_trace_writer const &) = delete;
+      query_trace_writer & operator=(query_trace_writer const &) = delete;
+
+      ~query_trace_writer() {
+        if (fd >= 0) close(fd);
+      }
+
+      /// append a batch of keys, with the local latency of the call that answered it.
+      void write(uint32_t const op, ::std::vector<Key> const & keys, uint64_t const nanoseconds) {
+        query_trace_batch b;
+        b.op = op;
+        b.reserved = 0;
+        b.nkeys = keys.size();
+        b.nanoseconds = nanoseconds;
+        write_all(&b, sizeof(b));
+        write_all(keys.data(), keys.size() * sizeof(Key));
+        ++batches;
+      }
+
+      size_t size() const { return batches; }
+      ::std::string const & get_filename() const { return filename; }
+  };
+
+
+  /**
+   * @brief reads the batches of 1 rank's trace file, in order.  local.
+   * @tparam Key  key type.  has to have the size recorded in the trace.
+   */
+  template <typename Key>
+  class query_trace_reader {
+    protected:
+      ::std::string filename;
+      int fd;
+      query_trace_header header;
+
+      /// false at the end of the file, throws on a partial read.
+      bool read_all(void * data, size_t const bytes) {
+        char * p = static_cast<char *>(data);
+        size_t got = 0;
+        while (got < bytes) {
+          ssize_t n = ::read(fd, p + got, bytes - got);
+          if (n < 0) {
+            if (errno == EINTR) continue;
+            detail::trace_error("read", filename, errno);
+          }
+          if (n == 0) break;
+          got += n;
+        }
+        if ((got > 0) && (got < bytes)) throw ::bliss::io::IOException("ERROR: query trace is truncated: " + filename);
+        return got == bytes;
+      }
+
+    public:
+      /// open rank's trace, and check its header against Key and the number of ranks.  throws IOException on mismatch.
+      query_trace_reader(::std::string const & prefix, int const comm_size, int const comm_rank) :
+        filename(query_trace_file_name(prefix, comm_rank)), fd(-1) {
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) detail::trace_error("open", filename, errno);
+
+        bool valid = false;
+        try {
+          valid = read_all(&header, sizeof(header));
+        } catch (::bliss::io::IOException const &) {}
+        if (!valid || (memcmp(header.magic, "BLISSQTR", 8) != 0) ||
+            (header.version != query_trace_header::current_version) ||
+            (header.endian_check != query_trace_header::endian_value)) {
+          close(fd);
+          fd = -1;
+          throw ::bliss::io::IOException("ERROR: not a query trace file: " + filename);
+        }
+        if ((header.key_bytes != sizeof(Key)) || (header.comm_size != comm_size) || (header.comm_rank != comm_rank)) {
+          ::std::stringstream ss;
+          ss << "ERROR: query trace " << filename << " has " << header.key_bytes << " byte keys from rank " << header.comm_rank
+             << " of " << header.comm_size << ", expected " << sizeof(Key) << " byte keys from rank " << comm_rank << " of " << comm_size;
+          close(fd);
+          fd = -1;
+          throw ::bliss::io::IOException(ss.str());
+        }
+      }
+
+      query_trace_reader(query_trace_reader const &) = delete;
+      query_trace_reader & operator=(query_trace_reader const &) = delete;
+
+      ~query_trace_reader() {
+        if (fd >= 0) close(fd);
+      }
+
+      /// the next batch.  returns false at the end of the trace.
+      bool next(query_trace_batch & batch, ::std::vector<Key> & keys) {
+        if (!read_all(&batch, sizeof(batch))) return false;
+        keys.resize(batch.nkeys);
+        if ((batch.nkeys > 0) && !read_all(keys.data(), batch.nkeys * sizeof(Key)))
+          throw ::bliss::io::IOException("ERROR: query trace is truncated: " + filename);
+        return true;
+      }
+
+      query_trace_header const & get_header() const { return header; }
+  };
+
+
+  /// latency percentiles of the replayed batches of 1 op, over the ranks' max per batch.  in seconds.
+  struct query_replay_stats {
+      uint32_t op;
+      size_t batches;
+      /// total keys over all ranks.
+      size_t keys;
+      double total;
+      double p50;
+      double p90;
+      double p99;
+      double max;
+      /// same percentiles of the captured latencies, for comparison.
+      double captured_p50;
+      double captured_p99;
+  };
+
+  namespace detail {
+    /// the q-th quantile of sorted values, nearest rank.
+    inline double quantile(::std::vector<double> const & sorted, double const q) {
+      if (sorted.empty()) return 0.0;
+      size_t i = static_cast<size_t>(q * static_cast<double>(sorted.size()));
+      return sorted[::std::min(i, sorted.size() - 1)];
+    }
+  }
+
+  /**
+   * @brief re-issue the batches of a trace against an index, and time them.  collective.
+   * @details  every rank replays its own batches, so each collective call gets the same keys as the captured one.  the
+   *           latency of a batch is its slowest rank's.  the ranks have to have the same number of batches, with the same
+   *           ops, as any capture of collective calls does.
+   * @tparam IndexType  provides KmerType, find, and count, e.g. ::bliss::index::kmer::Index.
+   * @return  stats for find and count, in that order, on all ranks.  an op without batches has 0 batches.
+   */
+  template <typename IndexType>
+  ::std::vector<query_replay_stats> replay_query_trace(IndexType & index, ::std::string const & prefix, mxx::comm const & comm) {
+    using KmerType = typename IndexType::KmerType;
+
+    query_trace_reader<KmerType> reader(prefix, comm.size(), comm.rank());
+
+    ::std::vector<double> replayed[2], captured[2];
+    size_t keys[2] = {0, 0};
+    query_trace_batch batch;
+    ::std::vector<KmerType> query;
+    while (true) {
+      bool more = reader.next(batch, query);
+      // all ranks at the same batch, with the same op.
+      uint32_t op = more ? batch.op : 0;
+      uint32_t lo = ::mxx::allreduce(op, ::mxx::min<uint32_t>(), comm);
+      uint32_t hi = ::mxx::allreduce(op, ::mxx::max<uint32_t>(), comm);
+      if (lo != hi) throw ::bliss::io::IOException("ERROR: the ranks' query traces have different batches: " + prefix);
+      if (!more) break;
+      if ((op != query_trace_batch::find) && (op != query_trace_batch::count))
+        throw ::bliss::io::IOException("ERROR: unknown op in query trace: " + prefix);
+
+      size_t const n = query.size();
+      comm.barrier();
+      auto start = ::std::chrono::steady_clock::now();
+      if (op == query_trace_batch::find) index.find(query);
+      else index.count(query);
+      double t = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - start).count();
+
+      int const i = (op == query_trace_batch::find) ? 0 : 1;
+      replayed[i].push_back(::mxx::allreduce(t, ::mxx::max<double>(), comm));
+      captured[i].push_back(::mxx::allreduce(static_cast<double>(batch.nanoseconds) * 1e-9, ::mxx::max<double>(), comm));
+      keys[i] += ::mxx::allreduce(n, comm);
+    }
+
+    ::std::vector<query_replay_stats> stats;
+    for (int i = 0; i < 2; ++i) {
+      query_replay_stats s;
+      s.op = (i == 0) ? query_trace_batch::find : query_trace_batch::count;
+      s.batches = replayed[i].size();
+      s.keys = keys[i];
+      s.total = 0.0;
+      for (double t : replayed[i]) s.total += t;
+      ::std::sort(replayed[i].begin(), replayed[i].end());
+      ::std::sort(captured[i].begin(), captured[i].end());
+      s.p50 = detail::quantile(replayed[i], 0.5);
+      s.p90 = detail::quantile(replayed[i], 0.9);
+      s.p99 = detail::quantile(replayed[i], 0.99);
+      s.max = replayed[i].empty() ? 0.0 : replayed[i].back();
+      s.captured_p50 = detail::quantile(captured[i], 0.5);
+      s.captured_p99 = detail::quantile(captured[i], 0.99);
+      stats.push_back(s);
+    }
+    return stats;
+  }
+
+} // namespace index
+} // namespace bliss
+
+#endif // SRC_INDEX_QUERY_TRACE_HPP_
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    read_correction.hpp
+ * @ingroup index
+ * @brief   k-mer spectrum substitution correction of a batch of reads, with 2 count queries per pass.
+ * @details a k-mer is solid if its count in the counting map is at least the threshold, and weak otherwise.  a single
+ *          substitution at position i makes exactly the k-mers that cover i weak, so the suspect positions of a read
+ *          are those covered by weak k-mers only.  a read with no solid k-mer, or no weak one, is left alone.
+ *
+ *          instead of querying the k-mers of each edited read as it is tried, a pass works on the whole batch:
+ *            1. the k-mers of all reads are deduplicated and counted with 1 find_aligned.
+ *            2. for each suspect position and each other base, the k-mers covering the position in the edited read
+ *               are generated.  all candidate k-mers of the batch are deduplicated and counted with 1 find_aligned.
+ *            3. in each run of consecutive suspect positions, the edit whose covering k-mers are all solid and whose
+ *               minimum count is the largest is applied.  ties are ambiguous and are not applied.
+ *          each pass fixes at most 1 substitution per run, so a few passes correct errors that mask each other.
+ *          passes stop when no rank changes a base.  all ranks call correct the same number of times.
+ *
+ *          the reads are ASCII sequences.  the candidate bases are A, C, G and T, so an N can be replaced too.
+ */
+#ifndef SRC_INDEX_READ_CORRECTION_HPP_
+#define SRC_INDEX_READ_CORRECTION_HPP_
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>  // sort, unique, lower_bound, min
+
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+#include "utils/benchmark_utils.hpp"
+
+namespace bliss
+{
+namespace index
+{
+namespace kmer
+{
+
+  /**
+   * @brief batched spectrum corrector over a distributed counting map.  see file description.
+   * @tparam MapType  a map with count values and find_aligned, e.g. counting_unordered_map, or the get_map() of a CountIndex.
+   */
+  template <typename MapType>
+  class SpectrumCorrector {
+    public:
+      using kmer_type = typename MapType::key_type;
+      using count_type = typename MapType::mapped_type;
+      using Alphabet = typename kmer_type::KmerAlphabet;
+
+      static constexpr size_t k = kmer_type::size;
+
+    protected:
+      /// 1 candidate edit.  its k-mers are cand_kmers[first, first + n).
+      struct candidate {
+          size_t read;
+          size_t run;     // first suspect position of the run
+          size_t pos;
+          size_t first;
+          size_t n;
+          char base;
+      };
+
+      MapType const & map;
+      count_type const solid;
+      size_t const max_passes;
+
+      /// deduplicated k-mers of the last lookup, and their counts.
+      std::vector<kmer_type> uniq;
+      std::vector<count_type> uniq_counts;
+
+      /// append the k-mers of s that start at [first, last).
+      static void kmers_of(std::string const & s, size_t const first, size_t const last, std::vector<kmer_type> & out) {
+        if (first >= last) return;
+        kmer_type km;
+        for (size_t i = first; i < first + k - 1; ++i) km.nextFromChar(Alphabet::FROM_ASCII[static_cast<unsigned char>(s[i])]);
+        for (size_t j = first; j < last; ++j) {
+          km.nextFromChar(Alphabet::FROM_ASCII[static_cast<unsigned char>(s[j + k - 1])]);
+          out.push_back(km);
+        }
+      }
+
+      /// counts of kmers, aligned to kmers.  each distinct k-mer is queried once.  collective.
+      std::vector<count_type> lookup(std::vector<kmer_type> const & kmers) {
+        uniq.assign(kmers.begin(), kmers.end());
+        std::sort(uniq.begin(), uniq.end());
+        uniq.erase(std::unique(uniq.begin(), uniq.end()), uniq.end());
+
+        uniq_counts = map.find_aligned(uniq, count_type(0));
+
+        std::vector<count_type> counts(kmers.size());
+        for (size_t i = 0; i < kmers.size(); ++i) {
+          counts[i] = uniq_counts[std::lower_bound(uniq.begin(), uniq.end(), kmers[i]) - uniq.begin()];
+        }
+        return counts;
+      }
+
+      /// 1 pass over the batch.  returns the number of local edits.  collective.
+      size_t pass(std::vector<std::string> & reads) {
+        BL_BENCH_INIT(correct);
+
+        BL_BENCH_START(correct);
+        std::vector<kmer_type> kmers;
+        std::vector<size_t> offsets(reads.size() + 1, 0);
+        for (size_t r = 0; r < reads.size(); ++r) {
+          offsets[r] = kmers.size();
+          if (reads[r].size() >= k) kmers_of(reads[r], 0, reads[r].size() - k + 1, kmers);
+        }
+        offsets[reads.size()] = kmers.size();
+        BL_BENCH_END(correct, "read_kmers", kmers.size());
+
+        BL_BENCH_COLLECTIVE_START(correct, "count_reads", comm);
+        std::vector<count_type> counts = lookup(kmers);
+        std::vector<kmer_type>().swap(kmers);
+        BL_BENCH_END(correct, "count_reads", uniq.size());
+
+        // suspect positions, and the k-mers of their edits.
+        BL_BENCH_START(correct);
+        std::vector<candidate> cands;
+        std::vector<kmer_type> cand_kmers;
+        std::vector<size_t> solid_prefix;
+        for (size_t r = 0; r < reads.size(); ++r) {
+          size_t const nk = offsets[r + 1] - offsets[r];
+          if (nk == 0) continue;
+
+          // solid_prefix[j] is the number of solid k-mers before k-mer j.
+          solid_prefix.assign(nk + 1, 0);
+          for (size_t j = 0; j < nk; ++j) solid_prefix[j + 1] = solid_prefix[j] + ((counts[offsets[r] + j] >= solid) ? 1 : 0);
+          if ((solid_prefix[nk] == 0) || (solid_prefix[nk] == nk)) continue;
+
+          std::string & s = reads[r];
+          size_t run = std::numeric_limits<size_t>::max();
+          for (size_t i = 0; i < s.size(); ++i) {
+            size_t const lo = (i >= k - 1) ? (i - k + 1) : 0;
+            size_t const hi = std::min(i + 1, nk);
+            if (solid_prefix[hi] != solid_prefix[lo]) {
+              run = std::numeric_limits<size_t>::max();
+              continue;
+            }
+            if (run == std::numeric_limits<size_t>::max()) run = i;
+
+            char const orig = s[i];
+            for (char b : {'A', 'C', 'G', 'T'}) {
+              if (b == orig) continue;
+              s[i] = b;
+              cands.push_back(candidate{r, run, i, cand_kmers.size(), hi - lo, b});
+              kmers_of(s, lo, hi, cand_kmers);
+            }
+            s[i] = orig;
+          }
+        }
+        BL_BENCH_END(correct, "candidates", cands.size());
+
+        BL_BENCH_COLLECTIVE_START(correct, "count_edits", comm);
+        std::vector<count_type> cand_counts = lookup(cand_kmers);
+        std::vector<kmer_type>().swap(cand_kmers);
+        BL_BENCH_END(correct, "count_edits", uniq.size());
+
+        // best unambiguous edit of each run.  the candidates of a run are consecutive.
+        BL_BENCH_START(correct);
+        size_t edits = 0;
+        for (size_t c = 0; c < cands.size(); ) {
+          size_t best = cands.size();
+          count_type best_score = 0, second_score = 0;
+          size_t e = c;
+          for (; (e < cands.size()) && (cands[e].read == cands[c].read) && (cands[e].run == cands[c].run); ++e) {
+            count_type score = std::numeric_limits<count_type>::max();
+            for (size_t j = cands[e].first; j < cands[e].first + cands[e].n; ++j) score = std::min(score, cand_counts[j]);
+            if (score < solid) continue;
+
+            if ((best == cands.size()) || (score > best_score)) {
+              second_score = best_score;
+              best_score = score;
+              best = e;
+            } else if (score > second_score) {
+              second_score = score;
+            }
+          }
+          if ((best < cands.size()) && (best_score > second_score)) {
+            reads[cands[best].read][cands[best].pos] = cands[best].base;
+            ++edits;
+          }
+          c = e;
+        }
+        std::vector<kmer_type>().swap(uniq);
+        std::vector<count_type>().swap(uniq_counts);
+        BL_BENCH_END(correct, "apply", edits);
+
+        BL_BENCH_REPORT_MPI_NAMED(correct, "spectrum_corrector:pass", comm);
+        return edits;
+      }
+
+    public:
+      const mxx::comm& comm;
+
+      /**
+       * @param _map         counting map, already built.  not modified.
+       * @param threshold    k-mers with count >= threshold are solid.
+       * @param passes       maximum number of passes per batch.
+       */
+      SpectrumCorrector(MapType const & _map, count_type const threshold, const mxx::comm& _comm, size_t const passes = 2) :
+        map(_map), solid(std::max(threshold, count_type(1))), max_passes(passes), comm(_comm) {}
+
+      /**
+       * @brief correct substitutions in a batch of reads, in place.  collective.
+       * @return the number of bases changed on this rank.
+       */
+      size_t correct(std::vector<std::string> & reads) {
+        size_t total = 0;
+        for (size_t p = 0; p < max_passes; ++p) {
+          size_t edits = pass(reads);
+          total += edits;
+          if (::mxx::allreduce(edits, comm) == 0) break;
+        }
+        return total;
+      }
+  };
+
+  template <typename MapType>
+  constexpr size_t SpectrumCorrector<MapType>::k;
+
+} // namespace kmer
+} // namespace index
+} // namespace bliss
+
+#endif // SRC_INDEX_READ_CORRECTION_HPP_
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_index_selector.cpp
+ *   the profile of distributed k-mers, the backend rules, and the dispatch to the chosen index type.
+ */
+
+
+#include "bliss-config.hpp"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <type_traits>
+#include <cstdint>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/index_selector.hpp"
+
+using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+using namespace ::bliss::index::kmer;
+
+namespace {
+  /// the j-th of a fixed sequence of random k-mers.
+  KmerType nth_kmer(size_t const j) {
+    std::mt19937_64 gen(j * 2654435761ULL + 1);
+    KmerType km;
+    for (unsigned int i = 0; i < KmerType::size; ++i) km.nextFromChar(static_cast<unsigned char>(gen() & 0x3));
+    return km;
+  }
+
+  index_profile make_profile(size_t kmers, double distinct, size_t queries, int ranks) {
+    index_profile p;
+    p.kmers = kmers;
+    p.distinct = distinct;
+    p.queries = queries;
+    p.key_bytes = sizeof(KmerType);
+    p.ranks = ranks;
+    return p;
+  }
+
+  struct which_backend {
+      template <typename IndexType>
+      CountBackend operator()(int const x) const {
+        EXPECT_EQ(7, x);
+        using B = count_backends<KmerType>;
+        if (std::is_same<IndexType, typename B::sorted>::value) return CountBackend::SORTED;
+        if (std::is_same<IndexType, typename B::counting>::value) return CountBackend::COUNTING;
+        return CountBackend::DENSEHASH;
+      }
+  };
+}
+
+
+TEST(IndexSelector, names)
+{
+  for (auto b : {CountBackend::DENSEHASH, CountBackend::SORTED, CountBackend::COUNTING}) {
+    EXPECT_EQ(b, parse_count_backend(to_string(b)));
+  }
+  EXPECT_THROW(parse_count_backend("btree"), std::invalid_argument);
+}
+
+TEST(IndexSelector, rules)
+{
+  selector_params params;
+
+  // small table, few queries:  sorted.
+  EXPECT_EQ(CountBackend::SORTED, choose_count_backend(make_profile(10000000, 4e6, 100000, 1), params));
+  // same table, queried heavily:  densehash.
+  EXPECT_EQ(CountBackend::DENSEHASH, choose_count_backend(make_profile(10000000, 4e6, 10000000, 1), params));
+  // large table on few ranks:  over the memory threshold, low multiplicity, so counting.
+  EXPECT_EQ(CountBackend::COUNTING, choose_count_backend(make_profile(4000000000UL, 1e9, 0, 2), params));
+  // the same on more ranks fits:  densehash.
+  EXPECT_EQ(CountBackend::DENSEHASH, choose_count_backend(make_profile(4000000000UL, 1e9, 0, 64), params));
+  // high coverage overflows the 8 bit counters:  densehash.
+  EXPECT_EQ(CountBackend::DENSEHASH, choose_count_backend(make_profile(100000000000UL, 1e9, 0, 2), params));
+
+  // thresholds are parameters.
+  params.sorted_max_query_ratio = 10.0;
+  EXPECT_EQ(CountBackend::SORTED, choose_count_backend(make_profile(10000000, 4e6, 10000000, 1), params));
+  params.memory_per_rank = 1e20;
+  EXPECT_EQ(CountBackend::DENSEHASH, choose_count_backend(make_profile(4000000000UL, 1e9, 0, 2), params));
+
+  // derived values.
+  index_profile p = make_profile(1000, 250, 500, 2);
+  EXPECT_DOUBLE_EQ(0.75, p.duplicate_rate());
+  EXPECT_DOUBLE_EQ(4.0, p.multiplicity());
+  EXPECT_DOUBLE_EQ(2.0, p.query_ratio());
+  EXPECT_DOUBLE_EQ(125.0, p.distinct_per_rank());
+}
+
+TEST(IndexSelector, profile)
+{
+  ::mxx::comm comm;
+
+  // 20000 distinct k-mers, split over the ranks, plus every rank repeats the first 1000 3 times.
+  size_t const n = 20000;
+  std::vector<KmerType> kmers;
+  for (size_t j = comm.rank(); j < n; j += comm.size()) kmers.push_back(nth_kmer(j));
+  for (int r = 0; r < 3; ++r) {
+    // reverse complements count as the same k-mer.
+    for (size_t j = 0; j < 1000; ++j) kmers.push_back((r == 1) ? nth_kmer(j).reverse_complement() : nth_kmer(j));
+  }
+
+  index_profile p = profile_kmers(kmers, 10, comm);
+  EXPECT_EQ(n + 3000UL * comm.size(), p.kmers);
+  EXPECT_EQ(10UL * comm.size(), p.queries);
+  EXPECT_EQ(comm.size(), p.ranks);
+  EXPECT_EQ(sizeof(KmerType), p.key_bytes);
+  EXPECT_NEAR(static_cast<double>(n), p.distinct, 0.05 * n);
+
+  // no k-mers at all.
+  index_profile e = profile_kmers(std::vector<KmerType>(), 0, comm);
+  EXPECT_EQ(0UL, e.kmers);
+  EXPECT_DOUBLE_EQ(0.0, e.distinct);
+  EXPECT_EQ(CountBackend::SORTED, choose_count_backend(e));
+}
+
+TEST(IndexSelector, dispatch)
+{
+  for (auto b : {CountBackend::DENSEHASH, CountBackend::SORTED, CountBackend::COUNTING}) {
+    EXPECT_EQ(b, dispatch_count_backend<KmerType>(b, which_backend(), 7));
+  }
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_job_packing.cpp
+ *   independent jobs on groups of ranks:  every job runs once, on 1 whole group, in cost order.
+ */
+
+
+#include "bliss-config.hpp"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <functional>  // plus
+
+#include "index/job_packing.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_index.hpp"
+#include "containers/distributed_unordered_map.hpp"
+
+
+template <typename Key>
+using JobMapParams = ::bliss::index::kmer::CanonicalHashMapParams<Key>;
+
+class JobPackingTest : public ::testing::TestWithParam<int> {};
+
+
+TEST_P(JobPackingTest, each_job_once)
+{
+  ::mxx::comm comm;
+  int const per = std::min(GetParam(), comm.size());
+
+  ::bliss::index::job_packer packer(comm, per);
+  EXPECT_EQ((comm.size() + per - 1) / per, packer.get_num_groups());
+  EXPECT_EQ(comm.rank() / per, packer.get_group_id());
+
+  size_t const njobs = 37;
+
+  // times each job ran, counted by the first rank of its group.
+  std::vector<size_t> runs(njobs, 0);
+  std::vector<size_t> ran = packer.run(njobs, [&runs, per, &comm](size_t const job, ::mxx::comm const & group) {
+    // the whole group is in the job, and can run collectives on it.
+    int expected = std::min(per, comm.size() - (comm.rank() / per) * per);
+    EXPECT_EQ(expected, group.size());
+    EXPECT_EQ(static_cast<size_t>(group.size()), ::mxx::allreduce(static_cast<size_t>(1), group));
+    // all ranks of the group see the same job.
+    EXPECT_EQ(job, ::mxx::allreduce(job, [](size_t x, size_t y) { return x > y ? x : y; }, group));
+    if (group.rank() == 0) ++runs[job];
+  });
+  EXPECT_TRUE(std::is_sorted(ran.begin(), ran.end()));
+
+  for (size_t i = 0; i < njobs; ++i) {
+    EXPECT_EQ(1UL, ::mxx::allreduce(runs[i], comm)) << "job " << i;
+  }
+}
+
+TEST_P(JobPackingTest, largest_first)
+{
+  ::mxx::comm comm;
+  int const per = std::min(GetParam(), comm.size());
+
+  ::bliss::index::job_packer packer(comm, per);
+
+  std::vector<size_t> costs = {5, 100, 7, 7, 40, 1, 0, 99, 3, 100};
+  std::vector<size_t> ran = packer.run(costs, [](size_t const, ::mxx::comm const &) {});
+
+  // each group takes jobs in non increasing cost.
+  for (size_t i = 1; i < ran.size(); ++i) {
+    EXPECT_GE(costs[ran[i - 1]], costs[ran[i]]);
+  }
+
+  // a single group runs all of them in order, stable for ties.
+  if (packer.get_num_groups() == 1) {
+    std::vector<size_t> expected = {1, 9, 7, 4, 2, 3, 0, 8, 5, 6};
+    EXPECT_EQ(expected, ran);
+  }
+
+  size_t total = ::mxx::allreduce(packer.get_group_comm().rank() == 0 ? ran.size() : 0, comm);
+  EXPECT_EQ(costs.size(), total);
+
+  // no jobs is fine.
+  EXPECT_EQ(0UL, packer.run(0, [](size_t const, ::mxx::comm const &) {}).size());
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, JobPackingTest, ::testing::Values(1, 2, 3, 1024));
+
+TEST(JobPackingIndex, build_per_group)
+{
+  using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+  using MapType = ::dsc::counting_unordered_map<KmerType, uint32_t, JobMapParams>;
+  using IndexType = ::bliss::index::kmer::CountIndex<MapType>;
+
+  ::mxx::comm comm;
+  if (comm.size() < 2) return;   // needs 2 groups.
+
+  std::string fileName(PROJ_SRC_DIR);
+  fileName.append("/test/data/test.fastq");
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  size_t const distinct = gold.get_map().size();
+
+  // groups of different sizes run builds and queries at the same time, and out of step:  the inserts and queries
+  // must not use the whole communicator.
+  ::bliss::index::job_packer packer(comm, (comm.size() + 1) / 2);
+  ASSERT_EQ(2, packer.get_num_groups());
+
+  size_t const njobs = 5;
+  std::vector<size_t> sizes(njobs, 0);
+  packer.run(njobs, [&sizes, &fileName](size_t const job, ::mxx::comm const & group) {
+    IndexType idx(group);
+    idx.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, group);
+
+    std::vector<std::pair<KmerType, uint32_t> > local;
+    idx.get_map().to_vector(local);
+    for (size_t i = 0; i < job; ++i) {
+      std::vector<KmerType> query;
+      for (auto const & e : local) query.push_back(e.first);
+      EXPECT_EQ(local.size(), idx.find(query).size());
+    }
+
+    size_t n = idx.get_map().size();
+    if (group.rank() == 0) sizes[job] = n;
+  });
+
+  ::mxx::allreduce(sizes, ::std::plus<size_t>(), comm).swap(sizes);
+  for (size_t i = 0; i < njobs; ++i) EXPECT_EQ(distinct, sizes[i]) << "job " << i;
+}
+
+
+TEST(JobPackingSizing, ranks_for_bytes)
+{
+  EXPECT_EQ(1, ::bliss::index::ranks_for_bytes(0, 100, 16));
+  EXPECT_EQ(1, ::bliss::index::ranks_for_bytes(100, 100, 16));
+  EXPECT_EQ(2, ::bliss::index::ranks_for_bytes(101, 100, 16));
+  EXPECT_EQ(8, ::bliss::index::ranks_for_bytes(800, 100, 16));
+  EXPECT_EQ(16, ::bliss::index::ranks_for_bytes(1000000, 100, 16));
+  EXPECT_EQ(1, ::bliss::index::ranks_for_bytes(1000000, 100, 0));
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
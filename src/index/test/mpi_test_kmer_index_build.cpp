@@ -0,0 +1,1729 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_kmer_index_build.cpp
+ *   test that the different index build modes produce the same distributed map.
+ *
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#if defined(USE_MPI)
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#endif
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint> // for uint64_t, etc.
+#include <string>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <functional>  // plus
+#include <iterator>  // back_inserter
+#include <fcntl.h>   // open
+#include <unistd.h>  // close
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_index.hpp"
+#include "index/kmer_sketch.hpp"
+#include "containers/distributed_unordered_map.hpp"
+#include "containers/distributed_set.hpp"
+#include "containers/distributed_cuckoo_filter.hpp"
+#include "containers/distributed_insert_buffer.hpp"
+#include "containers/distributed_snapshot_map.hpp"
+#include "containers/distributed_sorted_map.hpp"
+#include "containers/distributed_map_io.hpp"
+#include "containers/node_hot_table.hpp"
+
+using KmerType = bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::CanonicalHashMapParams<Key>;
+
+using MapType = ::dsc::counting_unordered_map<KmerType, uint32_t, MapParams>;
+using IndexType = ::bliss::index::kmer::CountIndex<MapType>;
+
+
+class KmerIndexBuildTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    std::string fileName;
+
+    virtual void SetUp()
+    {
+      fileName.assign(PROJ_SRC_DIR);
+      fileName.append(GetParam());
+    }
+
+    template <typename Idx>
+    static std::vector<std::pair<KmerType, uint32_t> > local_content(Idx const & idx) {
+      std::vector<std::pair<KmerType, uint32_t> > result;
+      idx.get_map().to_vector(result);
+      std::sort(result.begin(), result.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+        return x.first < y.first;
+      });
+      return result;
+    }
+
+    /// build a set from the file, and check it against the keys of the gold map, then its queries and erase.
+    template <typename SetType>
+    void check_set(std::vector<KmerType> const & gold_keys, mxx::comm const & comm) {
+      ::bliss::index::kmer::KmerIndex<SetType> idx(comm);
+      idx.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+      // same distribution hash as the gold map, so the same local keys.
+      std::vector<KmerType> keys;
+      idx.get_map().keys(keys);
+      std::sort(keys.begin(), keys.end());
+      EXPECT_EQ(gold_keys, keys);
+      EXPECT_EQ(gold_keys.size(), idx.get_map().local_size());
+
+      std::vector<KmerType> again(gold_keys);
+      EXPECT_EQ(0UL, idx.get_map().insert(again));
+
+      std::vector<KmerType> query(gold_keys);
+      auto counts = idx.get_map().count(query);
+      EXPECT_EQ(gold_keys.size(), counts.size());
+      for (auto const & c : counts) EXPECT_EQ(1UL, c.second);
+
+      // erase every other key.
+      std::vector<KmerType> erased, kept;
+      for (size_t i = 0; i < gold_keys.size(); ++i) {
+        if (i % 2 == 0) erased.push_back(gold_keys[i]);
+        else kept.push_back(gold_keys[i]);
+      }
+      query = erased;
+      EXPECT_EQ(erased.size(), idx.get_map().erase(query));
+      EXPECT_EQ(kept.size(), idx.get_map().local_size());
+
+      std::vector<size_t> present = idx.get_map().count_aligned(gold_keys);
+      ASSERT_EQ(gold_keys.size(), present.size());
+      for (size_t i = 0; i < gold_keys.size(); ++i) {
+        EXPECT_EQ((i % 2 == 0) ? 0UL : 1UL, present[i]);
+      }
+
+      query = gold_keys;
+      std::vector<KmerType> found = idx.get_map().find(query);
+      std::sort(found.begin(), found.end());
+      EXPECT_EQ(kept, found);
+    }
+};
+
+
+TEST_P(KmerIndexBuildTest, chunked_mmap)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // small chunks, so that there are many rounds of insertion.
+  IndexType streamed(comm);
+  streamed.set_build_chunk_bytes(4096);
+  streamed.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  ASSERT_EQ(gold.size(), streamed.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(streamed);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, keys_only_count)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // (k-mer, 1) pairs through the reduction insert.
+  ::bliss::index::kmer::CountTupleIndex<MapType> tuples(comm);
+  tuples.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  ASSERT_EQ(gold.size(), tuples.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(tuples);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, chunked_posix)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_posix<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // larger than the partition, so there is just 1 round
+  IndexType streamed(comm);
+  streamed.set_build_chunk_bytes(1UL << 30);
+  streamed.template build_posix<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  ASSERT_EQ(gold.size(), streamed.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(streamed);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, stream)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_posix<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // the file read as a stream by the last rank, in 64KB blocks of records per rank.
+  int const root = comm.size() - 1;
+  int fd = (comm.rank() == root) ? open(fileName.c_str(), O_RDONLY) : -1;
+  IndexType streamed(comm);
+  streamed.template build_stream<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fd, comm, root, 1UL << 16);
+  if (fd >= 0) close(fd);
+
+  ASSERT_EQ(gold.size(), streamed.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(streamed);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, chunked_overlap_mpiio)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mpiio<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // parse and insert concurrently.
+  IndexType streamed(comm);
+  streamed.set_build_chunk_bytes(8192);
+  streamed.set_build_overlap(true);
+  streamed.template build_mpiio<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  ASSERT_EQ(gold.size(), streamed.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(streamed);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+
+#if defined(USE_OPENMP)
+TEST_P(KmerIndexBuildTest, chunked_overlap_one_thread)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mpiio<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // nested in an active parallel region with nesting off, the overlap gets 1 thread and has to parse serially.
+  IndexType streamed(comm);
+  streamed.set_build_chunk_bytes(8192);
+  streamed.set_build_overlap(true);
+  int const levels = omp_get_max_active_levels();
+  omp_set_max_active_levels(1);
+#pragma omp parallel num_threads(2)
+  {
+#pragma omp master
+    streamed.template build_mpiio<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  }
+  omp_set_max_active_levels(levels);
+
+  ASSERT_EQ(gold.size(), streamed.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(streamed);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+#endif
+
+TEST_P(KmerIndexBuildTest, checkpoint_resume)
+{
+  mxx::comm comm;
+  std::string prefix(PROJ_BIN_DIR);
+  prefix.append("/kmer_index_build_checkpoint");
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // checkpoint every other chunk.
+  {
+    IndexType first(comm);
+    first.set_build_chunk_bytes(4096);
+    first.set_build_checkpoint(prefix, 2);
+    first.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+    ASSERT_EQ(gold.size(), first.size());
+  }
+
+  // resume from the last checkpoint, which leaves up to 1 chunk to parse.
+  IndexType resumed(comm);
+  resumed.set_build_chunk_bytes(4096);
+  resumed.set_build_checkpoint(prefix, 2);
+  resumed.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  for (int slot = 0; slot < 2; ++slot) {
+    remove(::dsc::map_file_name(::bliss::index::checkpoint_slot_prefix(prefix, slot), comm.rank()).c_str());
+    remove(::bliss::index::checkpoint_progress_file_name(prefix, slot, comm.rank()).c_str());
+  }
+
+  ASSERT_EQ(gold.size(), resumed.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(resumed);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, packed_reads)
+{
+  mxx::comm comm;
+  std::string prefix(PROJ_BIN_DIR);
+  prefix.append("/kmer_index_build_packed");
+
+  using PackedIndexType = ::bliss::index::kmer::CountIndex2<MapType>;
+
+  PackedIndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // pack for a larger k, then save and reload, as for a sweep over k.
+  {
+    ::bliss::index::kmer::PackedReadStore<bliss::common::DNA, 63> store;
+    store.template read_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+    store.save(prefix, comm);
+  }
+  ::bliss::index::kmer::PackedReadStore<bliss::common::DNA, 63> store;
+  store.load(prefix, comm);
+  remove(::dsc::map_file_name(prefix, comm.rank()).c_str());
+
+  PackedIndexType packed(comm);
+  packed.build_packed(store);
+
+  ASSERT_EQ(gold.size(), packed.size());
+
+  auto g = local_content(gold);
+  auto s = local_content(packed);
+
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, multi_k)
+{
+  mxx::comm comm;
+
+  using SmallKmerType = bliss::common::Kmer<21, bliss::common::DNA, uint64_t>;
+  using SmallMapType = ::dsc::counting_unordered_map<SmallKmerType, uint32_t, MapParams>;
+  using SmallIndexType = ::bliss::index::kmer::CountIndex<SmallMapType>;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  SmallIndexType small_gold(comm);
+  small_gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // 1 pass for both k, whole partition and in small chunks.
+  for (size_t chunk_bytes : {0UL, 4096UL}) {
+    IndexType large(comm);
+    SmallIndexType small(comm);
+    size_t kmers = ::bliss::index::kmer::build_multi_k<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(
+        fileName, chunk_bytes, comm, large, small);
+
+    ASSERT_EQ(gold.size(), large.size());
+    ASSERT_EQ(small_gold.size(), small.size());
+    EXPECT_GT(kmers, large.local_size());
+
+    auto g = local_content(gold);
+    auto l = local_content(large);
+    EXPECT_TRUE(g == l);
+
+    std::vector<std::pair<SmallKmerType, uint32_t> > sg, sl;
+    small_gold.get_map().to_vector(sg);
+    small.get_map().to_vector(sl);
+    std::sort(sg.begin(), sg.end());
+    std::sort(sl.begin(), sl.end());
+    EXPECT_TRUE(sg == sl);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, histogram)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  size_t const max_bin = 20;
+  std::vector<size_t> hist = gold.get_map().histogram(max_bin);
+  ASSERT_EQ(max_bin + 1, hist.size());
+
+  // same histogram from the local contents, reduced by hand.
+  std::vector<size_t> expected(max_bin + 1, 0);
+  auto g = local_content(gold);
+  for (size_t i = 0; i < g.size(); ++i) {
+    ++expected[std::min(static_cast<size_t>(g[i].second), max_bin)];
+  }
+  expected = mxx::reduce(expected, 0, std::plus<size_t>(), comm);
+
+  size_t unique = gold.get_map().unique_size();
+  if (comm.rank() == 0) {
+    EXPECT_EQ(0UL, hist[0]);
+    size_t total = 0;
+    for (size_t i = 0; i <= max_bin; ++i) {
+      EXPECT_EQ(expected[i], hist[i]);
+      total += hist[i];
+    }
+    EXPECT_EQ(unique, total);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, top_n)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  size_t const n = 100;
+  auto top = gold.get_map().top_n(n);
+
+  // compare the counts against all entries, gathered.
+  auto all = mxx::allgatherv(local_content(gold), comm);
+  std::sort(all.begin(), all.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.second > y.second;
+  });
+
+  ASSERT_EQ(std::min(n, all.size()), top.size());
+  for (size_t i = 0; i < top.size(); ++i) {
+    EXPECT_EQ(all[i].second, top[i].second);
+  }
+
+  // and the keys go with those counts.  rank 0 queries them all.
+  std::vector<KmerType> keys;
+  if (comm.rank() == 0) {
+    for (size_t i = 0; i < top.size(); ++i) keys.push_back(top[i].first);
+  }
+  auto found = gold.get_map().find(keys);
+  if (comm.rank() != 0) return;
+
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  std::sort(found.begin(), found.end(), by_key);
+  std::sort(top.begin(), top.end(), by_key);
+  ASSERT_EQ(top.size(), found.size());
+  for (size_t i = 0; i < top.size(); ++i) {
+    EXPECT_EQ(top[i].first, found[i].first);
+    EXPECT_EQ(top[i].second, found[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, set_operations)
+{
+  mxx::comm comm;
+
+  IndexType a(comm);
+  a.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  std::string otherName(PROJ_SRC_DIR);
+  otherName.append("/test/data/test.fastq");
+  IndexType b(comm);
+  b.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(otherName, comm);
+
+  // same map type and communicator, so equal keys are on the same rank.  expected results from the local contents.
+  auto ga = local_content(a);
+  auto gb = local_content(b);
+  auto less = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  std::vector<std::pair<KmerType, uint32_t> > both;
+  std::set_intersection(ga.begin(), ga.end(), gb.begin(), gb.end(), std::back_inserter(both), less);
+
+  // a and b:  keeps a's counts.
+  a.get_map().intersect(b.get_map());
+  auto s = local_content(a);
+  ASSERT_EQ(both.size(), s.size());
+  for (size_t i = 0; i < both.size(); ++i) {
+    EXPECT_EQ(both[i].first, s[i].first);
+    EXPECT_EQ(both[i].second, s[i].second);
+  }
+
+  // (a and b) + b:  all of b's keys, counts added for the shared ones.
+  a.get_map().merge(b.get_map());
+  s = local_content(a);
+  ASSERT_EQ(gb.size(), s.size());
+  for (size_t i = 0, j = 0; i < gb.size(); ++i) {
+    EXPECT_EQ(gb[i].first, s[i].first);
+    uint32_t expected = gb[i].second;
+    if ((j < both.size()) && (both[j].first == gb[i].first)) expected += both[j++].second;
+    EXPECT_EQ(expected, s[i].second);
+  }
+
+  // minus b:  nothing left.
+  a.get_map().subtract(b.get_map());
+  EXPECT_EQ(0UL, a.size());
+}
+
+TEST_P(KmerIndexBuildTest, aligned_queries)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  auto all = mxx::allgatherv(local_content(gold), comm);
+  std::sort(all.begin(), all.end(), by_key);
+
+  // a rank dependent slice, backwards, with reverse complements and repeats.
+  std::vector<KmerType> keys;
+  for (size_t i = all.size(); i > 0; i -= std::min(i, static_cast<size_t>(comm.rank() + 1))) {
+    keys.push_back(all[i - 1].first);
+    if ((i % 3) == 0) keys.push_back(all[i - 1].first.reverse_complement());
+    if ((i % 5) == 0) keys.push_back(all[i - 1].first);
+  }
+  // and poly-A, which is canonical, and likely not in the data.
+  KmerType absent;
+  keys.push_back(absent);
+  auto absent_pos = std::lower_bound(all.begin(), all.end(), std::make_pair(absent, 0U), by_key);
+  uint32_t absent_count = ((absent_pos != all.end()) && (absent_pos->first == absent)) ? absent_pos->second : 0;
+
+  std::vector<KmerType> const original(keys);
+
+  // same answers with every exchange variant.
+  for (auto algo : {::imxx::exchange_algorithm::automatic, ::imxx::exchange_algorithm::full,
+                    ::imxx::exchange_algorithm::two_part, ::imxx::exchange_algorithm::lowmem}) {
+    gold.get_map().set_exchange_algorithm(algo);
+    ASSERT_EQ(algo, gold.get_map().get_exchange_algorithm());
+
+    auto counts = gold.get_map().count_aligned(keys);
+    auto values = gold.get_map().find_aligned(keys, 0);
+
+    ASSERT_TRUE(std::equal(original.begin(), original.end(), keys.begin()));
+    ASSERT_EQ(keys.size(), counts.size());
+    ASSERT_EQ(keys.size(), values.size());
+    for (size_t i = 0; i + 1 < keys.size(); ++i) {
+      KmerType canonical = std::min(keys[i], keys[i].reverse_complement());
+      auto it = std::lower_bound(all.begin(), all.end(), std::make_pair(canonical, 0U), by_key);
+      ASSERT_TRUE((it != all.end()) && (it->first == canonical));
+      EXPECT_EQ(1UL, counts[i]);
+      EXPECT_EQ(it->second, values[i]);
+    }
+    EXPECT_EQ(absent_count > 0 ? 1UL : 0UL, counts.back());
+    EXPECT_EQ(absent_count, values.back());
+  }
+}
+
+TEST_P(KmerIndexBuildTest, load_repartition)
+{
+  mxx::comm comm;
+  std::string prefix(PROJ_BIN_DIR);
+  prefix.append("/kmer_index_build_repartition");
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  gold.get_map().save(prefix);
+
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  auto g = mxx::allgatherv(local_content(gold), comm);
+  std::sort(g.begin(), g.end(), by_key);
+
+  // load on half of the ranks, in small chunks so that there are several rounds.  the other half loads too.
+  mxx::comm half = comm.split(comm.rank() < (comm.size() + 1) / 2);
+  {
+    MapType loaded(half);
+    loaded.load_repartition(prefix, 4096);
+    ASSERT_EQ(gold.size(), loaded.size());
+
+    std::vector<std::pair<KmerType, uint32_t> > l;
+    loaded.to_vector(l);
+    auto s = mxx::allgatherv(l, half);
+    std::sort(s.begin(), s.end(), by_key);
+
+    ASSERT_EQ(g.size(), s.size());
+    for (size_t i = 0; i < g.size(); ++i) {
+      EXPECT_EQ(g[i].first, s[i].first);
+      EXPECT_EQ(g[i].second, s[i].second);
+    }
+  }
+
+  comm.barrier();
+  remove(::dsc::map_file_name(prefix, comm.rank()).c_str());
+}
+
+TEST_P(KmerIndexBuildTest, load_packed)
+{
+  mxx::comm comm;
+  std::string prefix(PROJ_BIN_DIR);
+  prefix.append("/kmer_index_build_packed");
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  gold.get_map().set_packed_snapshots(true);
+  gold.get_map().save(prefix);
+
+  {
+    ::dsc::mapped_map_file f(::dsc::map_file_name(prefix, comm.rank()));
+    EXPECT_TRUE(f.packed());
+    EXPECT_EQ(gold.local_size(), f.size());
+  }
+
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  auto g = mxx::allgatherv(local_content(gold), comm);
+  std::sort(g.begin(), g.end(), by_key);
+
+  // same ranks, then repartitioned on half of them.
+  {
+    IndexType loaded(comm);
+    loaded.load(prefix);
+    auto l = local_content(loaded);
+    auto e = local_content(gold);
+    std::sort(l.begin(), l.end(), by_key);
+    std::sort(e.begin(), e.end(), by_key);
+    ASSERT_EQ(e.size(), l.size());
+    for (size_t i = 0; i < e.size(); ++i) {
+      EXPECT_EQ(e[i].first, l[i].first);
+      EXPECT_EQ(e[i].second, l[i].second);
+    }
+  }
+
+  mxx::comm half = comm.split(comm.rank() < (comm.size() + 1) / 2);
+  {
+    MapType loaded(half);
+    loaded.load_repartition(prefix, 4096);
+
+    std::vector<std::pair<KmerType, uint32_t> > l;
+    loaded.to_vector(l);
+    auto s = mxx::allgatherv(l, half);
+    std::sort(s.begin(), s.end(), by_key);
+
+    ASSERT_EQ(g.size(), s.size());
+    for (size_t i = 0; i < g.size(); ++i) {
+      EXPECT_EQ(g[i].first, s[i].first);
+      EXPECT_EQ(g[i].second, s[i].second);
+    }
+  }
+
+  comm.barrier();
+  remove(::dsc::map_file_name(prefix, comm.rank()).c_str());
+}
+
+TEST_P(KmerIndexBuildTest, memory_budget)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // a budget below the current usage leaves no headroom, so the build streams in the smallest chunks.
+  IndexType budgeted(comm);
+  budgeted.get_map().set_memory_budget(1);
+  ASSERT_TRUE(budgeted.get_map().get_memory_budget().limited());
+  EXPECT_EQ(1UL << 20, budgeted.effective_chunk_bytes());
+  budgeted.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  ASSERT_EQ(gold.size(), budgeted.size());
+  auto g = local_content(gold);
+  auto s = local_content(budgeted);
+  ASSERT_EQ(g.size(), s.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, s[i].first);
+    EXPECT_EQ(g[i].second, s[i].second);
+  }
+
+  // densehash find with little headroom runs in rounds, with the same results.
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  std::vector<KmerType> keys;
+  for (size_t i = 0; i < g.size(); ++i) keys.push_back(g[i].first);
+
+  std::vector<KmerType> query(keys);
+  auto expected = dense.get_map().find(query);
+
+  dense.get_map().set_memory_budget(::getCurrentRSS() + (1UL << 16));
+  query = keys;
+  auto found = dense.get_map().find(query);
+  dense.get_map().set_memory_budget(0);
+
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  std::sort(expected.begin(), expected.end(), by_key);
+  std::sort(found.begin(), found.end(), by_key);
+  ASSERT_EQ(expected.size(), found.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].first, found[i].first);
+    EXPECT_EQ(expected[i].second, found[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, spill)
+{
+  mxx::comm comm;
+  std::string prefix(PROJ_BIN_DIR);
+  prefix.append("/kmer_index_build_spill");
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  auto g = mxx::allgatherv(local_content(gold), comm);
+  std::sort(g.begin(), g.end(), by_key);
+
+  // small tables and small chunks, so that there are several runs per rank.
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.get_map().set_spill(prefix, 256);
+  dense.set_build_chunk_bytes(4096);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  EXPECT_TRUE(mxx::any_of(dense.get_map().spilled_runs() > 1, comm));
+
+  // the merge sees every key once, in order, with the total count.
+  std::vector<std::pair<KmerType, uint32_t> > merged;
+  size_t distinct = dense.get_map().merge_spilled([&merged](std::pair<KmerType, uint32_t> const & x) {
+    merged.push_back(x);
+  });
+  EXPECT_EQ(merged.size(), distinct);
+  EXPECT_TRUE(std::is_sorted(merged.begin(), merged.end(), by_key));
+  EXPECT_TRUE(std::adjacent_find(merged.begin(), merged.end(), [](std::pair<KmerType, uint32_t> const & x,
+      std::pair<KmerType, uint32_t> const & y) { return x.first == y.first; }) == merged.end());
+
+  auto m = mxx::allgatherv(merged, comm);
+  std::sort(m.begin(), m.end(), by_key);
+  ASSERT_EQ(g.size(), m.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, m[i].first);
+    EXPECT_EQ(g[i].second, m[i].second);
+  }
+
+  // back in memory, the table has the same content.
+  dense.get_map().unspill();
+  EXPECT_EQ(0UL, dense.get_map().spilled_runs());
+  EXPECT_EQ(gold.size(), dense.size());
+  auto u = mxx::allgatherv(local_content(dense), comm);
+  std::sort(u.begin(), u.end(), by_key);
+  ASSERT_EQ(g.size(), u.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, u[i].first);
+    EXPECT_EQ(g[i].second, u[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, sort_reduce)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // same distribution hash as the gold map, so the same local entries.
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.get_map().set_sort_reduce(true);
+  dense.set_build_chunk_bytes(4096);   // several inserts, so counts are added to existing entries.
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  auto g = local_content(gold);
+  auto d = local_content(dense);
+  ASSERT_EQ(g.size(), d.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, d[i].first);
+    EXPECT_EQ(g[i].second, d[i].second);
+  }
+}
+
+/// seed hits of the seeds against all index entries, by brute force.  entries sorted by k-mer.
+static std::vector<::dsc::seed_hit> expected_seed_hits(
+    std::vector<std::pair<KmerType, ::bliss::common::ShortSequenceKmerId> > const & entries,
+    std::vector<::dsc::read_seed<KmerType> > const & seeds, int64_t const width) {
+  std::vector<std::pair<uint64_t, int64_t> > hits;
+  for (auto const & s : seeds) {
+    KmerType canonical = std::min(std::get<0>(s), std::get<0>(s).reverse_complement());
+    for (auto it = std::lower_bound(entries.begin(), entries.end(), canonical,
+                                    [](std::pair<KmerType, ::bliss::common::ShortSequenceKmerId> const & x, KmerType const & k) {
+                                      return x.first < k; });
+         (it != entries.end()) && (it->first == canonical); ++it) {
+      int64_t d = static_cast<int64_t>(it->second.get_pos()) - static_cast<int64_t>(std::get<2>(s));
+      int64_t bin = (d >= 0) ? (d / width) : -((-d + width - 1) / width);
+      hits.emplace_back(std::get<1>(s), bin * width);
+    }
+  }
+  std::sort(hits.begin(), hits.end());
+  std::vector<::dsc::seed_hit> result;
+  for (size_t i = 0; i < hits.size(); ) {
+    size_t j = i + 1;
+    while ((j < hits.size()) && (hits[j] == hits[i])) ++j;
+    result.emplace_back(hits[i].first, hits[i].second, static_cast<uint32_t>(j - i));
+    i = j;
+  }
+  return result;
+}
+
+template <typename PosIndexType>
+static void check_map_reads(PosIndexType const & idx, mxx::comm const & comm) {
+  using Entry = std::pair<KmerType, ::bliss::common::ShortSequenceKmerId>;
+  std::vector<Entry> local;
+  idx.get_map().to_vector(local);
+  auto all = mxx::allgatherv(local, comm);
+  std::sort(all.begin(), all.end(), [](Entry const & x, Entry const & y) { return x.first < y.first; });
+
+  // reads of 20 seeds from a rank dependent slice of the entries, some reverse complemented.  read ids are per rank.
+  std::vector<::dsc::read_seed<KmerType> > seeds;
+  for (size_t i = comm.rank(), j = 0; i < all.size(); i += comm.size(), ++j) {
+    KmerType k = ((j % 3) == 0) ? all[i].first.reverse_complement() : all[i].first;
+    seeds.emplace_back(k, (static_cast<uint64_t>(comm.rank()) << 32) | (j / 20), static_cast<uint32_t>(j % 20));
+  }
+
+  for (size_t width : {1UL, 16UL}) {
+    auto found = idx.map_reads(seeds, width);
+    auto expected = expected_seed_hits(all, seeds, width);
+    EXPECT_EQ(expected, found);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, map_reads)
+{
+  mxx::comm comm;
+
+  using DensePosMapType = ::dsc::densehash_multimap<KmerType, ::bliss::common::ShortSequenceKmerId, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::PositionIndex<DensePosMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  check_map_reads(dense, comm);
+
+  // a repeat with 4 entries per rank, split across ranks.  heavy keys are answered by all ranks, with the same bins.
+  std::vector<std::pair<KmerType, ::bliss::common::ShortSequenceKmerId> > repeat;
+  KmerType polya;
+  if (comm.rank() == 0) {
+    for (int i = 0; i < 4 * comm.size(); ++i) repeat.emplace_back(polya, ::bliss::common::ShortSequenceKmerId(1000 + 37 * i));
+  }
+  dense.get_map().insert(repeat);
+  dense.get_map().rebalance_heavy_keys(0.0);
+  if (comm.size() > 1) EXPECT_LE(1UL, dense.get_map().heavy_key_count());
+  check_map_reads(dense, comm);
+
+  // same index with the values in 1 array per rank.
+  using CsrPosMapType = ::dsc::csr_multimap<KmerType, ::bliss::common::ShortSequenceKmerId, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::PositionIndex<CsrPosMapType> csr(comm);
+  csr.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  check_map_reads(csr, comm);
+
+  using PosMapType = ::dsc::unordered_multimap<KmerType, ::bliss::common::ShortSequenceKmerId, MapParams>;
+  ::bliss::index::kmer::PositionIndex<PosMapType> unordered(comm);
+  unordered.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  check_map_reads(unordered, comm);
+}
+
+TEST_P(KmerIndexBuildTest, positions_and_counts)
+{
+  mxx::comm comm;
+
+  using DensePosMapType = ::dsc::densehash_multimap<KmerType, ::bliss::common::ShortSequenceKmerId, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  using PosMapType = ::dsc::unordered_multimap<KmerType, ::bliss::common::ShortSequenceKmerId, MapParams>;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(gold);
+
+  ::bliss::index::kmer::PositionIndex<DensePosMapType> dense_gold(comm);
+  dense_gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // 1 parse and 1 exchange for both, whole partition and in small chunks.
+  for (size_t chunk_bytes : {0UL, 4096UL}) {
+    ::bliss::index::kmer::PositionIndex<DensePosMapType> dense_pos(comm);
+    ::bliss::index::kmer::CountIndex<DenseMapType> dense_counts(comm);
+    ::bliss::index::kmer::build_positions_and_counts<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(
+        fileName, chunk_bytes, comm, dense_pos, dense_counts);
+
+    EXPECT_EQ(dense_gold.local_size(), dense_pos.local_size());
+    EXPECT_TRUE(g == local_content(dense_counts));
+
+    ::bliss::index::kmer::PositionIndex<PosMapType> pos(comm);
+    IndexType counts(comm);
+    ::bliss::index::kmer::build_positions_and_counts<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(
+        fileName, chunk_bytes, comm, pos, counts);
+
+    EXPECT_EQ(dense_gold.local_size(), pos.local_size());
+    EXPECT_TRUE(g == local_content(counts));
+  }
+}
+
+TEST_P(KmerIndexBuildTest, minimizer_positions)
+{
+  mxx::comm comm;
+  using Entry = std::pair<KmerType, ::bliss::common::ShortSequenceKmerId>;
+  using PosMapType = ::dsc::unordered_multimap<KmerType, ::bliss::common::ShortSequenceKmerId, MapParams>;
+
+  ::bliss::index::kmer::PositionIndex<PosMapType> full(comm);
+  full.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  ::bliss::index::kmer::MinimizerPositionIndex<PosMapType, 10> sampled(comm);
+  sampled.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // the sampled entries are full entries, about 2/11 of them.
+  size_t n = full.size();
+  size_t m = sampled.size();
+  EXPECT_LT(m, n / 3);
+  EXPECT_GT(m, n / 10);
+
+  auto by_entry = [](Entry const & x, Entry const & y) {
+    return (x.first < y.first) || ((x.first == y.first) && (x.second.get_pos() < y.second.get_pos()));
+  };
+  std::vector<Entry> f, s;
+  full.get_map().to_vector(f);
+  sampled.get_map().to_vector(s);
+  std::sort(f.begin(), f.end(), by_entry);
+  std::sort(s.begin(), s.end(), by_entry);
+  EXPECT_TRUE(std::includes(f.begin(), f.end(), s.begin(), s.end(), by_entry));
+
+  // sampled queries keep the kmers the index kept:  a stretch of a reference read, from its indexed kmers.
+  std::vector<Entry> all = mxx::allgatherv(f, comm);
+  std::sort(all.begin(), all.end(), [](Entry const & x, Entry const & y) { return x.second.get_pos() < y.second.get_pos(); });
+  std::vector<KmerType> read;
+  for (size_t i = 0; (i < all.size()) && (read.size() < 30); ++i) {
+    if ((i > 0) && (all[i].second.get_id() != all[0].second.get_id())) break;
+    read.push_back(all[i].first);
+  }
+  std::vector<size_t> offsets = sampled.sample_query(read);
+  ASSERT_EQ(offsets.size(), read.size());
+  EXPECT_TRUE(std::is_sorted(offsets.begin(), offsets.end()));
+  EXPECT_LT(0UL, offsets.size());
+}
+
+TEST_P(KmerIndexBuildTest, sketch)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  size_t unique = gold.get_map().unique_size();
+
+  // small chunks, so that the stream has several.
+  using SketchType = ::bliss::index::kmer::KmerSketch<KmerType>;
+  SketchType a(comm, 1000, 4096);
+  a.template sketch_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName);
+
+  // HLL standard error is 1.6% at the default precision.
+  EXPECT_LT(std::fabs(a.cardinality() - static_cast<double>(unique)), 0.05 * static_cast<double>(unique)) << "estimate " << a.cardinality();
+  // same global sketch on all ranks.
+  std::vector<uint64_t> h = a.get_minhash().get_hashes();
+  std::vector<uint64_t> all = mxx::allgatherv(h, comm);
+  ASSERT_EQ(h.size() * comm.size(), all.size());
+  for (int i = 0; i < comm.size(); ++i) {
+    EXPECT_TRUE(std::equal(h.begin(), h.end(), all.begin() + i * h.size()));
+  }
+  EXPECT_EQ(1.0, a.jaccard(a));
+  EXPECT_EQ(0.0, a.distance(a));
+
+  // posix read gives the same sketch, and sketching the same file again changes nothing.
+  SketchType b(comm, 1000, 4096);
+  b.template sketch_posix<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName);
+  EXPECT_EQ(h, b.get_minhash().get_hashes());
+  EXPECT_EQ(a.get_hll().get_registers(), b.get_hll().get_registers());
+  b.template sketch_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName);
+  EXPECT_EQ(h, b.get_minhash().get_hashes());
+
+  // the index's kmers, inserted from wherever they are stored, give the same sketch.
+  std::vector<std::pair<KmerType, uint32_t> > content;
+  gold.get_map().to_vector(content);
+  std::vector<KmerType> kmers;
+  for (auto const & kv : content) kmers.push_back(kv.first);
+  SketchType c(comm, 1000);
+  c.insert(kmers);
+  c.reduce();
+  EXPECT_EQ(h, c.get_minhash().get_hashes());
+  EXPECT_EQ(a.get_hll().get_registers(), c.get_hll().get_registers());
+
+  // test.fastq's kmers are a subset of the other test files'.
+  std::string otherName(PROJ_SRC_DIR);
+  otherName.append("/test/data/test.fastq");
+  SketchType o(comm, 1000);
+  o.template sketch_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(otherName);
+  double j = a.jaccard(o);
+  EXPECT_LT(0.0, j);
+  EXPECT_GE(1.0, j);
+  EXPECT_LE(0.0, a.distance(o));
+}
+
+TEST_P(KmerIndexBuildTest, sets)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto content = local_content(gold);
+  std::vector<KmerType> gold_keys;
+  for (auto const & kv : content) gold_keys.push_back(kv.first);
+
+  check_set<::dsc::unordered_set<KmerType, MapParams> >(gold_keys, comm);
+  check_set<::dsc::densehash_set<KmerType, MapParams, ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> > >(gold_keys, comm);
+  check_set<::dsc::sorted_set<KmerType, MapParams> >(gold_keys, comm);
+}
+
+TEST_P(KmerIndexBuildTest, cuckoo_filter)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto content = local_content(gold);
+  std::vector<KmerType> gold_keys, kept;
+  for (size_t i = 0; i < content.size(); ++i) {
+    gold_keys.push_back(content[i].first);
+    if (i % 2 == 1) kept.push_back(content[i].first);
+  }
+
+  // presence only, with every other key.  the others are negatives.
+  ::dsc::cuckoo_filter<KmerType, MapParams> filter(comm);
+  filter.reserve(kept.size());
+  std::vector<KmerType> query(kept);
+  filter.insert(query);
+  EXPECT_GE(filter.local_size() + kept.size() / 200, kept.size());   // keys with colliding fingerprints count once.
+
+  std::vector<size_t> present = filter.count_aligned(gold_keys);
+  ASSERT_EQ(gold_keys.size(), present.size());
+  size_t fp = 0;
+  for (size_t i = 0; i < gold_keys.size(); ++i) {
+    if (i % 2 == 1) EXPECT_EQ(1UL, present[i]);
+    else fp += present[i];
+  }
+  EXPECT_LT(fp, gold_keys.size() / 200 + 2);
+
+  query = kept;
+  auto counts = filter.count(query);
+  EXPECT_EQ(kept.size(), counts.size());
+  for (auto const & c : counts) EXPECT_EQ(1UL, c.second);
+
+  std::vector<std::pair<KmerType, bool> > entries;
+  EXPECT_THROW(filter.to_vector(entries), std::logic_error);
+
+  // with counters:  each key twice, then erased once.
+  ::dsc::cuckoo_filter<KmerType, MapParams, 12, 4> counter(comm);
+  counter.reserve(gold_keys.size());
+  query = gold_keys;
+  query.insert(query.end(), gold_keys.begin(), gold_keys.end());
+  counter.insert(query);
+
+  present = counter.count_aligned(gold_keys);
+  for (size_t i = 0; i < gold_keys.size(); ++i) EXPECT_LE(2UL, present[i]);
+
+  query = gold_keys;
+  EXPECT_EQ(gold_keys.size(), counter.erase(query));
+  present = counter.count_aligned(gold_keys);
+  for (size_t i = 0; i < gold_keys.size(); ++i) EXPECT_LE(1UL, present[i]);
+}
+
+TEST_P(KmerIndexBuildTest, insert_buffer)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(gold);
+
+  // the local kmers, each repeated by its count, as a stream of small batches.  the same number of batches on all ranks.
+  std::vector<KmerType> stream;
+  for (auto const & e : g) stream.insert(stream.end(), e.second, e.first);
+  size_t const batch = 50;
+  size_t batches = mxx::allreduce((stream.size() + batch - 1) / batch, mxx::max<size_t>(), comm);
+
+  for (double max_seconds : {0.0, 1e-6}) {
+    MapType streamed(comm);
+    ::dsc::insert_buffer<MapType, KmerType> buffer(streamed, 1000, max_seconds);
+    for (size_t b = 0; b < batches; ++b) {
+      size_t first = std::min(b * batch, stream.size());
+      std::vector<KmerType> input(stream.begin() + first, stream.begin() + std::min(first + batch, stream.size()));
+      buffer.insert(input);
+      EXPECT_TRUE(input.empty());
+    }
+    buffer.flush();
+    EXPECT_TRUE(buffer.empty());
+    if (max_seconds == 0.0) EXPECT_GT(batches / 10 + 2, buffer.flush_count());
+
+    std::vector<std::pair<KmerType, uint32_t> > s;
+    streamed.to_vector(s);
+    std::sort(s.begin(), s.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+      return x.first < y.first;
+    });
+    ASSERT_EQ(g.size(), s.size());
+    for (size_t i = 0; i < g.size(); ++i) {
+      EXPECT_EQ(g[i].first, s[i].first);
+      EXPECT_EQ(g[i].second, s[i].second);
+    }
+  }
+}
+
+TEST_P(KmerIndexBuildTest, table_stats)
+{
+  mxx::comm comm;
+
+  IndexType idx(comm);
+  idx.get_map().set_table_stats(true);
+  idx.set_build_chunk_bytes(4096);   // several inserts, for a load history.
+  idx.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  ::fsc::table_stats stats = idx.get_map().report_table_stats("test:table_stats");
+  EXPECT_EQ(idx.get_map().local_size(), stats.occupied);
+  EXPECT_EQ(0UL, stats.tombstones);
+  EXPECT_LE(stats.occupied, stats.buckets * 8);
+  if (stats.occupied > 0) {
+    EXPECT_LE(1UL, stats.rehashes);
+    EXPECT_LE(1.0, stats.mean_probe());
+  }
+  EXPECT_LT(1UL, stats.load_history.size());
+  for (size_t i = 1; i < stats.load_history.size(); ++i) {
+    EXPECT_LE(stats.load_history[i - 1].first, stats.load_history[i].first);
+  }
+
+  // stopping clears the tracked part, not the scan.
+  idx.get_map().set_table_stats(false);
+  ::fsc::table_stats after = idx.get_map().get_local_table_stats();
+  EXPECT_EQ(stats.occupied, after.occupied);
+  EXPECT_EQ(0UL, after.rehashes);
+  EXPECT_TRUE(after.load_history.empty());
+}
+
+TEST_P(KmerIndexBuildTest, exact_find)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(gold);
+
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // every local kmer, plus a few absent ones, queried with the estimated and the exact result allocation.
+  std::vector<KmerType> keys;
+  for (auto const & e : g) keys.push_back(e.first.reverse_complement());
+  for (size_t i = 0; i < 10; ++i) {
+    KmerType absent;
+    for (size_t j = 0; j < KmerType::size; ++j) absent.nextFromChar(((i >> (j % 4)) + comm.rank()) & 0x1);
+    keys.push_back(absent);
+  }
+
+  std::vector<std::pair<KmerType, uint32_t> > results[2];
+  for (int exact = 0; exact < 2; ++exact) {
+    dense.get_map().set_exact_find(exact == 1);
+    std::vector<KmerType> query(keys);
+    results[exact] = dense.get_map().find(query);
+    std::sort(results[exact].begin(), results[exact].end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+      return x.first < y.first;
+    });
+  }
+  EXPECT_EQ(results[0].size(), results[1].size());
+  EXPECT_TRUE(std::equal(results[0].begin(), results[0].end(), results[1].begin()));
+  if (comm.size() == 1) {
+    EXPECT_EQ(results[1].capacity(), results[1].size());
+  }
+
+  // the queries were distributed, so compare the totals.
+  size_t total = mxx::allreduce(results[1].size(), comm);
+  size_t gold_total = mxx::allreduce(g.size(), comm);
+  EXPECT_LE(gold_total, total);
+  EXPECT_GE(gold_total + 10 * comm.size(), total);
+}
+
+TEST_P(KmerIndexBuildTest, query_cache)
+{
+  mxx::comm comm;
+
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(dense);
+
+  // every local kmer, plus a few absent ones.
+  std::vector<KmerType> keys;
+  for (auto const & e : g) keys.push_back(e.first.reverse_complement());
+  for (size_t i = 0; i < 10; ++i) {
+    KmerType absent;
+    for (size_t j = 0; j < KmerType::size; ++j) absent.nextFromChar(((i >> (j % 4)) + comm.rank()) & 0x1);
+    keys.push_back(absent);
+  }
+
+  auto find = [&dense, &keys]() {
+    std::vector<KmerType> query(keys);
+    auto r = dense.get_map().find(query);
+    std::sort(r.begin(), r.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+      return x.first < y.first;
+    });
+    return r;
+  };
+  auto count = [&dense, &keys]() {
+    std::vector<KmerType> query(keys);
+    auto r = dense.get_map().count(query);
+    std::sort(r.begin(), r.end(), [](std::pair<KmerType, size_t> const & x, std::pair<KmerType, size_t> const & y){
+      return x.first < y.first;
+    });
+    return r;
+  };
+
+  auto found = find();
+  auto counted = count();
+
+  // repeated queries are answered from the cache, with the same results.
+  dense.get_map().set_query_cache(1UL << 20);
+  for (int round = 0; round < 2; ++round) {
+    EXPECT_EQ(found, find());
+    EXPECT_EQ(counted, count());
+  }
+  if (comm.size() > 1) {
+    EXPECT_GT(dense.get_map().query_cache_hits(), 0UL);
+  }
+
+  // an insert invalidates the cache:  every count is doubled.
+  std::vector<KmerType> again;
+  for (auto const & e : g) again.insert(again.end(), e.second, e.first);
+  dense.insert(again);
+  auto doubled = find();
+  ASSERT_EQ(found.size(), doubled.size());
+  for (size_t i = 0; i < found.size(); ++i) {
+    EXPECT_EQ(found[i].first, doubled[i].first);
+    EXPECT_EQ(2 * found[i].second, doubled[i].second);
+  }
+  EXPECT_EQ(counted, count());
+
+  // and so does an erase.
+  std::vector<KmerType> erased(keys);
+  dense.get_map().erase(erased);
+  EXPECT_EQ(0UL, find().size());
+}
+
+TEST_P(KmerIndexBuildTest, hot_table)
+{
+  mxx::comm comm;
+
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(dense);
+  auto all = mxx::allgatherv(g, comm);
+
+  // the table holds exactly the n largest counts.
+  size_t const n = 50;
+  std::vector<std::pair<KmerType, uint32_t> > entries(g);
+  ::dsc::node_hot_table<KmerType, uint32_t, ::bliss::kmer::hash::farm<KmerType, false> > table(entries, n, comm);
+  EXPECT_EQ(std::min(n, all.size()), table.size());
+  std::vector<uint32_t> counts;
+  for (auto const & e : all) counts.push_back(e.second);
+  std::sort(counts.begin(), counts.end(), std::greater<uint32_t>());
+  uint32_t threshold = (all.size() > n) ? counts[n - 1] : 0;
+  size_t hot = 0;
+  for (auto const & e : all) {
+    uint32_t const * v = table.find(e.first);
+    if (e.second > threshold) {
+      ASSERT_NE(nullptr, v);
+    } else if (e.second < threshold) {
+      EXPECT_EQ(nullptr, v);
+    }
+    if (v != nullptr) {
+      EXPECT_EQ(e.second, *v);
+      ++hot;
+    }
+  }
+  EXPECT_EQ(table.size(), hot);
+
+  // queries answered from the map's hot table are the same.
+  std::vector<KmerType> keys;
+  for (auto const & e : g) keys.push_back(e.first.reverse_complement());
+  auto find = [&dense, &keys]() {
+    std::vector<KmerType> query(keys);
+    auto r = dense.get_map().find(query);
+    std::sort(r.begin(), r.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+      return x.first < y.first;
+    });
+    return r;
+  };
+  auto found = find();
+  std::vector<KmerType> query(keys);
+  auto counted = dense.get_map().count(query);
+
+  EXPECT_EQ(table.size(), dense.get_map().build_hot_table(n));
+  EXPECT_EQ(found, find());
+  query = keys;
+  auto hot_counted = dense.get_map().count(query);
+  EXPECT_EQ(counted.size(), hot_counted.size());
+  for (auto const & c : hot_counted) EXPECT_EQ(1UL, c.second);
+
+  // an insert drops the hot table:  every count is doubled.
+  std::vector<KmerType> again;
+  for (auto const & e : g) again.insert(again.end(), e.second, e.first);
+  dense.insert(again);
+  auto doubled = find();
+  ASSERT_EQ(found.size(), doubled.size());
+  for (size_t i = 0; i < found.size(); ++i) {
+    EXPECT_EQ(2 * found[i].second, doubled[i].second);
+  }
+}
+
+TEST_P(KmerIndexBuildTest, insert_consumed)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(gold);
+
+  // every local kmer, reverse complemented, as many times as it was counted.
+  std::vector<KmerType> kmers;
+  for (auto const & e : g) kmers.insert(kmers.end(), e.second, e.first.reverse_complement());
+  std::vector<KmerType> copy(kmers);
+
+  IndexType consumed(comm);
+  consumed.insert(std::move(kmers));
+  EXPECT_TRUE(kmers.empty());
+  EXPECT_EQ(0UL, kmers.capacity());
+  EXPECT_EQ(g, local_content(consumed));
+
+  // in place exchange of a kept input.
+  IndexType inplace(comm);
+  inplace.get_map().set_inplace_insert(true);
+  inplace.insert(copy);
+  EXPECT_EQ(g, local_content(inplace));
+}
+
+TEST_P(KmerIndexBuildTest, release_memory)
+{
+  mxx::comm comm;
+
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(dense);
+
+  // erase half, so that the shrink has tombstones to drop.
+  std::vector<KmerType> erased;
+  for (size_t i = 0; i < g.size(); i += 2) erased.push_back(g[i].first);
+  std::vector<KmerType> query(erased);
+  dense.erase(query);
+  auto kept = local_content(dense);
+  size_t buckets = dense.get_map().local_capacity();
+
+  dense.release_memory(false);
+  EXPECT_EQ(kept, local_content(dense));
+  EXPECT_EQ(buckets, dense.get_map().local_capacity());
+
+  dense.release_memory(true);
+  EXPECT_EQ(kept, local_content(dense));
+  EXPECT_GE(buckets, dense.get_map().local_capacity());
+
+  // queries still work.
+  query = erased;
+  auto counts = dense.get_map().count(query);
+  for (auto const & c : counts) EXPECT_EQ(0UL, c.second);
+
+  // and for a map that does not shrink its table.
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  gold.release_memory(true);
+  EXPECT_EQ(g, local_content(gold));
+}
+
+TEST_P(KmerIndexBuildTest, snapshot_map)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(gold);
+  std::vector<KmerType> keys;
+  for (auto const & e : g) keys.push_back(e.first);
+
+  // the local kmers, each repeated by its count, in 2 batches.
+  std::vector<KmerType> first, second;
+  for (auto const & e : g) {
+    first.push_back(e.first);
+    second.insert(second.end(), e.second - 1, e.first);
+  }
+  std::vector<KmerType> dropped(first);
+
+  auto found = [&keys](::dsc::snapshot_map<MapType> const & m) {
+    std::vector<KmerType> query(keys);
+    auto f = m.find(query);
+    std::sort(f.begin(), f.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+      return x.first < y.first;
+    });
+    return f;
+  };
+
+  ::dsc::snapshot_map<MapType> m(comm);
+  m.insert(first);
+  EXPECT_EQ(0UL, found(m).size());
+
+  EXPECT_EQ(g.size(), m.publish());
+  EXPECT_EQ(1UL, m.generation());
+  EXPECT_EQ(0UL, m.delta().local_size());
+
+  // the second batch is not visible until published, and a discarded batch never is.
+  m.insert(second);
+  auto f = found(m);
+  ASSERT_EQ(g.size(), f.size());
+  for (auto const & x : f) EXPECT_EQ(1U, x.second);
+
+  m.publish();
+  m.insert(dropped);
+  m.discard();
+
+  EXPECT_EQ(g, found(m));
+  EXPECT_EQ(2UL, m.generation());
+}
+
+/// kmers seen more than once.  the maps call predicates on entries, and on the range of entries of a key.
+struct repeated_kmer {
+    template <typename T>
+    bool operator()(T const & x) const { return x.second > 1; }
+    template <typename Iter>
+    bool operator()(Iter, Iter) const { return true; }
+};
+
+TEST_P(KmerIndexBuildTest, find_if_project)
+{
+  mxx::comm comm;
+
+  IndexType idx(comm);
+  idx.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(idx);
+
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  std::vector<KmerType> keys;
+  for (auto const & e : g) keys.push_back(e.first);
+  repeated_kmer pred;
+
+  // the projected replies hold the values of the full replies.
+  std::vector<KmerType> query(keys);
+  auto full = idx.find_if(query, pred);
+  std::vector<uint32_t> expected;
+  for (auto const & e : full) expected.push_back(e.second);
+  std::sort(expected.begin(), expected.end());
+
+  query = keys;
+  std::vector<uint32_t> values = idx.find_if_project(query, pred, ::bliss::index::kmer::project_value());
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(expected, values);
+
+  query = keys;
+  values = dense.find_if_project(query, pred, ::bliss::index::kmer::project_value());
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(expected, values);
+}
+
+TEST_P(KmerIndexBuildTest, export_sorted)
+{
+  mxx::comm comm;
+  std::string filename(PROJ_BIN_DIR);
+  filename.append("/kmer_index_build_export.bin");
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  auto g = mxx::allgatherv(local_content(gold), comm);
+  std::sort(g.begin(), g.end(), by_key);
+
+  // the file holds all entries of all ranks, in key order.
+  auto check = [&comm, &filename, &g]() {
+    comm.barrier();
+    if (comm.rank() == 0) {
+      ::dsc::mapped_map_file f(filename);
+      f.template validate<KmerType, uint32_t>(comm.size(), -1);
+      ASSERT_EQ(g.size(), f.size());
+      std::pair<KmerType, uint32_t> const * e = f.template entries<KmerType, uint32_t>();
+      for (size_t i = 0; i < g.size(); ++i) {
+        EXPECT_EQ(g[i].first, e[i].first);
+        EXPECT_EQ(g[i].second, e[i].second);
+      }
+    }
+    comm.barrier();
+  };
+
+  // hash map:  sample sort, in small chunks so that there are several rounds.
+  EXPECT_EQ(g.size(), gold.get_map().export_sorted(filename, 4096));
+  check();
+  EXPECT_EQ(g.size(), gold.export_sorted(filename));
+  check();
+
+  // sorted map:  the local arrays in rank order.
+  using SortedMapType = ::dsc::counting_sorted_map<KmerType, uint32_t, ::bliss::index::kmer::CanonicalSortedMapParams>;
+  ::bliss::index::kmer::CountIndex<SortedMapType> sorted(comm);
+  sorted.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  EXPECT_EQ(g.size(), sorted.export_sorted(filename));
+  check();
+
+  if (comm.rank() == 0) remove(filename.c_str());
+}
+
+template <typename Key>
+using BimoleculeParams = ::bliss::index::kmer::BimoleculeHashMapParams<Key>;
+
+TEST_P(KmerIndexBuildTest, canonicalize_once)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(gold);
+
+  // bimolecule map, canonicalized at insert and query instead of in the table's hash and equal.
+  using OnceMapType = ::dsc::counting_unordered_map<KmerType, uint32_t, ::dsc::canonicalize_once<BimoleculeParams>::params>;
+  static_assert(::std::is_same<::dsc::canonicalize_once<BimoleculeParams>::params<KmerType>::StorageTransformedFunction,
+                ::fsc::TransformedHash<KmerType, ::bliss::index::kmer::StoreHashMurmur, ::bliss::transform::identity> >::value,
+                "canonicalize_once should store with the plain hash");
+  ::bliss::index::kmer::CountIndex<OnceMapType> once(comm);
+  once.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+
+  // canonical keys, on the same ranks as the canonical map.
+  auto o = local_content(once);
+  ASSERT_EQ(g.size(), o.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, o[i].first);
+    EXPECT_EQ(g[i].second, o[i].second);
+  }
+
+  // queries by the other strand find the canonical entries.
+  std::vector<KmerType> query;
+  for (auto const & e : g) query.push_back(e.first.reverse_complement());
+  auto found = once.get_map().find(query);
+  std::sort(found.begin(), found.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  });
+  ASSERT_EQ(g.size(), found.size());
+  for (size_t i = 0; i < g.size(); ++i) {
+    EXPECT_EQ(g[i].first, found[i].first);
+    EXPECT_EQ(g[i].second, found[i].second);
+  }
+}
+
+/// check a sample of map:  n entries over all ranks, distinct, local, with their counts, each rank's share within 6
+/// standard deviations of its hypergeometric mean, and the same for the same seed.
+template <typename Map>
+void check_sample(Map const & map, std::vector<std::pair<KmerType, uint32_t> > const & local, size_t const n, mxx::comm const & comm) {
+  auto by_key = [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first < y.first;
+  };
+  size_t const total = mxx::allreduce(local.size(), comm);
+
+  auto s = map.sample(n, 17);
+  EXPECT_EQ(std::min(n, total), mxx::allreduce(s.size(), comm));
+  double const m = std::min(n, total);
+  double const f = static_cast<double>(local.size()) / total;
+  double const sd = (total > 1) ? std::sqrt(m * f * (1.0 - f) * (total - m) / (total - 1)) : 0.0;
+  EXPECT_NEAR(m * f, static_cast<double>(s.size()), 6.0 * sd + 1.0);
+
+  std::sort(s.begin(), s.end(), by_key);
+  EXPECT_TRUE(std::adjacent_find(s.begin(), s.end(), [](std::pair<KmerType, uint32_t> const & x, std::pair<KmerType, uint32_t> const & y){
+    return x.first == y.first;
+  }) == s.end());
+  for (auto const & e : s) {
+    auto it = std::lower_bound(local.begin(), local.end(), e, by_key);
+    ASSERT_TRUE((it != local.end()) && (it->first == e.first));
+    EXPECT_EQ(it->second, e.second);
+  }
+
+  auto again = map.sample(n, 17);
+  std::sort(again.begin(), again.end(), by_key);
+  ASSERT_EQ(s.size(), again.size());
+  for (size_t i = 0; i < s.size(); ++i) EXPECT_EQ(s[i].first, again[i].first);
+}
+
+TEST_P(KmerIndexBuildTest, sample)
+{
+  mxx::comm comm;
+
+  IndexType gold(comm);
+  gold.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  auto g = local_content(gold);
+  size_t const total = mxx::allreduce(g.size(), comm);
+
+  // a few, a third, and more than all of the entries.
+  for (size_t n : {static_cast<size_t>(7), total / 3, total + 5}) {
+    check_sample(gold.get_map(), g, n, comm);
+  }
+  EXPECT_EQ(0UL, mxx::allreduce(gold.get_map().sample(0).size(), comm));
+
+  // a different seed gives a different sample.
+  auto x = gold.get_map().sample(total / 2, 1);
+  auto y = gold.get_map().sample(total / 2, 2);
+  EXPECT_TRUE(mxx::any_of(!std::equal(x.begin(), x.end(), y.begin(), [](std::pair<KmerType, uint32_t> const & a, std::pair<KmerType, uint32_t> const & b){
+    return a.first == b.first;
+  }), comm));
+
+  // densehash:  reservoir sampled, as unordered.  sorted:  by index.  the local entries differ from the gold map's,
+  // as the distribution differs.
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  check_sample(dense.get_map(), local_content(dense), total / 3, comm);
+
+  using SortedMapType = ::dsc::counting_sorted_map<KmerType, uint32_t, ::bliss::index::kmer::CanonicalSortedMapParams>;
+  ::bliss::index::kmer::CountIndex<SortedMapType> sorted(comm);
+  sorted.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  check_sample(sorted.get_map(), local_content(sorted), total / 3, comm);
+}
+
+template <typename Index>
+void check_query_latency(Index & idx, std::vector<std::pair<KmerType, uint32_t> > const & local, mxx::comm const & comm) {
+  std::vector<KmerType> keys;
+  for (auto const & e : local) keys.push_back(e.first);
+
+  idx.get_map().set_query_latency(true);
+  size_t const rounds = 5;
+  for (size_t i = 0; i < rounds; ++i) {
+    std::vector<KmerType> query(keys.begin(), keys.begin() + (keys.size() * (i + 1)) / rounds);
+    idx.find(query);
+  }
+  EXPECT_EQ(rounds, idx.get_map().get_local_query_latency().get_rounds().count());
+  EXPECT_EQ(rounds, idx.get_map().get_local_query_latency().get_work().count());
+
+  ::fsc::query_latency_stats stats = idx.get_map().get_query_latency();
+  EXPECT_EQ(rounds * comm.size(), stats.rounds);
+  EXPECT_LT(0.0, stats.max);
+  EXPECT_LE(stats.p50, stats.p90);
+  EXPECT_LE(stats.p90, stats.p99);
+  EXPECT_LE(stats.p99, stats.max);
+  EXPECT_LE(0, stats.tail_rank);
+  EXPECT_GT(comm.size(), stats.tail_rank);
+
+  // the tail rank's slowest round, and its local work, are within the rounds.
+  double slowest = 0.0;
+  for (size_t i = 0; i < ::fsc::query_latency_tracker::phases; ++i) slowest += stats.tail_phases[i];
+  EXPECT_LE(slowest, stats.max * (1.0 + 1e-9));
+  EXPECT_LE(stats.tail_work_p99, stats.max * (1.0 + 1e-9));
+  // the same on all ranks.
+  EXPECT_EQ(stats.tail_rank, mxx::allreduce(stats.tail_rank, mxx::max<int>(), comm));
+  EXPECT_EQ(stats.tail_rank, mxx::allreduce(stats.tail_rank, mxx::min<int>(), comm));
+
+  // stopping clears, and rounds are no longer recorded.
+  idx.get_map().set_query_latency(false);
+  std::vector<KmerType> query(keys);
+  idx.find(query);
+  EXPECT_EQ(0UL, idx.get_map().get_local_query_latency().get_rounds().count());
+  EXPECT_EQ(0UL, idx.get_map().get_query_latency().rounds);
+}
+
+TEST_P(KmerIndexBuildTest, query_latency)
+{
+  mxx::comm comm;
+
+  using DenseMapType = ::dsc::counting_densehash_map<KmerType, uint32_t, MapParams,
+      ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+  ::bliss::index::kmer::CountIndex<DenseMapType> dense(comm);
+  dense.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  check_query_latency(dense, local_content(dense), comm);
+
+  using SortedMapType = ::dsc::counting_sorted_map<KmerType, uint32_t, ::bliss::index::kmer::CanonicalSortedMapParams>;
+  ::bliss::index::kmer::CountIndex<SortedMapType> sorted(comm);
+  sorted.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, comm);
+  check_query_latency(sorted, local_content(sorted), comm);
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, KmerIndexBuildTest, ::testing::Values(
+    std::string("/test/data/test.fastq"),
+    std::string("/test/data/test.medium.fastq")
+    ));
+
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_query_server.cpp
+ *   clients on rank 0 query the servers of all ranks concurrently, then shut them down.
+ *   the ranks must share a host, as the sockets are local.
+ */
+
+
+#include "bliss-config.hpp"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <unistd.h>  // getpid
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/query_server.hpp"
+
+
+using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+
+/// the k-mer of i.
+KmerType make(uint64_t i) {
+  KmerType k;
+  k.getDataRef()[0] = i;
+  return k;
+}
+
+/// stand-in for a distributed index:  the even k-mers, with value i / 2 and count i % 5 + 1.
+/// find and count are collective, as the real ones.
+struct MockIndex {
+    using KmerType = ::KmerType;
+    struct map_type { using key_type = ::KmerType; };
+
+    const mxx::comm& comm;
+    size_t calls;
+
+    explicit MockIndex(const mxx::comm& _comm) : comm(_comm), calls(0) {}
+
+    map_type & get_map() { static map_type m; return m; }
+
+    std::vector<std::pair<KmerType, uint32_t> > find(std::vector<KmerType> & query) {
+      ++calls;
+      ::mxx::allreduce(query.size(), comm);
+      std::vector<std::pair<KmerType, uint32_t> > results;
+      for (auto const & k : query) {
+        if ((k.getData()[0] % 2) == 0) results.emplace_back(k, static_cast<uint32_t>(k.getData()[0] / 2));
+      }
+      return results;
+    }
+
+    std::vector<std::pair<KmerType, size_t> > count(std::vector<KmerType> & query) {
+      ++calls;
+      ::mxx::allreduce(query.size(), comm);
+      std::vector<std::pair<KmerType, size_t> > results;
+      for (auto const & k : query) {
+        results.emplace_back(k, ((k.getData()[0] % 2) == 0) ? (k.getData()[0] % 5 + 1) : 0);
+      }
+      return results;
+    }
+};
+
+using ClientType = ::bliss::index::query_client<KmerType, std::pair<KmerType, uint32_t>, std::pair<KmerType, size_t> >;
+
+
+TEST(QueryServerTest, find_count)
+{
+  ::mxx::comm comm;
+
+  std::stringstream ss;
+  ss << "bliss_query_test." << ::mxx::allreduce(static_cast<int>(getpid()), [](int x, int y) { return x > y ? x : y; }, comm);
+  std::string prefix = ss.str();
+
+  MockIndex index(comm);
+  ::bliss::index::query_server<MockIndex> server(index, comm, prefix, 20);
+
+  std::vector<std::thread> clients;
+  int errors = 0;
+  if (comm.rank() == 0) {
+    // 2 clients per rank, each with its own range of keys.
+    for (int c = 0; c < 2 * comm.size(); ++c) {
+      clients.emplace_back([&prefix, c, &errors]() {
+        ClientType client(prefix, c / 2);
+        for (int rep = 0; rep < 3; ++rep) {
+          std::vector<KmerType> keys;
+          for (uint64_t i = 0; i < 1000; ++i) keys.emplace_back(make(c * 1000 + i));
+
+          std::vector<std::pair<KmerType, uint32_t> > found;
+          client.find(keys, found);
+          if (found.size() != 500) ++errors;
+          for (size_t i = 0; i < found.size(); ++i) {
+            if ((found[i].first != make(c * 1000 + 2 * i)) || (found[i].second != (c * 1000 + 2 * i) / 2)) ++errors;
+          }
+
+          std::vector<std::pair<KmerType, size_t> > counts;
+          client.count(keys, counts);
+          if (counts.size() != keys.size()) ++errors;
+          for (size_t i = 0; i < counts.size(); ++i) {
+            uint64_t v = c * 1000 + i;
+            if ((counts[i].first != keys[i]) || (counts[i].second != (((v % 2) == 0) ? (v % 5 + 1) : 0))) ++errors;
+          }
+        }
+      });
+    }
+  }
+
+  std::thread stopper;
+  if (comm.rank() == 0) {
+    stopper = std::thread([&clients, &prefix]() {
+      for (auto & t : clients) t.join();
+      ClientType client(prefix, 0);
+      client.shutdown();
+    });
+  }
+
+  size_t rounds = server.serve();
+
+  if (comm.rank() == 0) {
+    stopper.join();
+    EXPECT_EQ(0, errors);
+  }
+
+  // all ranks take part in every round, and the clients' requests share rounds.
+  EXPECT_EQ(index.calls, ::mxx::allreduce(index.calls, [](size_t x, size_t y) { return x > y ? x : y; }, comm));
+  EXPECT_GT(rounds, 0UL);
+  EXPECT_LE(index.calls, 2 * rounds);
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_query_trace.cpp
+ *   test that query traces read back as written, reject mismatched or damaged files, and replay the same batches.
+ */
+
+
+#include "bliss-config.hpp"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdio>     // remove
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <unistd.h>   // getpid, truncate
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/query_trace.hpp"
+
+
+using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+using namespace ::bliss::index;
+
+namespace {
+  /// the k-mer of i.
+  KmerType make(uint64_t i) {
+    KmerType k;
+    k.getDataRef()[0] = i;
+    return k;
+  }
+
+  /// stand-in for a distributed index, that records the queries it gets.  find and count are collective, as the real ones.
+  struct RecordingIndex {
+      using KmerType = ::KmerType;
+
+      const mxx::comm& comm;
+      std::vector<std::pair<uint32_t, std::vector<KmerType> > > calls;
+
+      explicit RecordingIndex(const mxx::comm& _comm) : comm(_comm) {}
+
+      std::vector<std::pair<KmerType, uint32_t> > find(std::vector<KmerType> & query) {
+        calls.emplace_back(query_trace_batch::find, query);
+        ::mxx::allreduce(query.size(), comm);
+        return std::vector<std::pair<KmerType, uint32_t> >();
+      }
+
+      std::vector<std::pair<KmerType, size_t> > count(std::vector<KmerType> & query) {
+        calls.emplace_back(query_trace_batch::count, query);
+        ::mxx::allreduce(query.size(), comm);
+        return std::vector<std::pair<KmerType, size_t> >();
+      }
+  };
+}
+
+class QueryTraceTest : public ::testing::Test
+{
+  protected:
+    std::string prefix;
+    /// batches of this rank:  (op, keys).  rank dependent keys and sizes, including an empty batch.
+    std::vector<std::pair<uint32_t, std::vector<KmerType> > > batches;
+
+    virtual void SetUp()
+    {
+      ::mxx::comm comm;
+      std::stringstream ss;
+      ss << "/tmp/bliss_query_trace_test_" << ::mxx::allreduce(static_cast<int>(getpid()), ::mxx::max<int>(), comm);
+      prefix = ss.str();
+
+      for (size_t b = 0; b < 7; ++b) {
+        std::vector<KmerType> keys;
+        size_t n = (b == 3) ? 0 : (b + 1) * 100 + comm.rank();
+        for (size_t i = 0; i < n; ++i) keys.push_back(make(b * 100000 + comm.rank() * 1000 + (i % 37)));
+        batches.emplace_back((b % 3 == 1) ? query_trace_batch::count : query_trace_batch::find, keys);
+      }
+    }
+
+    virtual void TearDown()
+    {
+      ::mxx::comm comm;
+      comm.barrier();
+      remove(query_trace_file_name(prefix, comm.rank()).c_str());
+    }
+
+    void write(::mxx::comm const & comm) {
+      query_trace_writer<KmerType> writer(prefix, comm.size(), comm.rank());
+      for (size_t b = 0; b < batches.size(); ++b) writer.write(batches[b].first, batches[b].second, 1000 * (b + 1));
+      EXPECT_EQ(batches.size(), writer.size());
+    }
+};
+
+
+TEST_F(QueryTraceTest, roundtrip)
+{
+  ::mxx::comm comm;
+  write(comm);
+
+  query_trace_reader<KmerType> reader(prefix, comm.size(), comm.rank());
+  EXPECT_EQ(sizeof(KmerType), reader.get_header().key_bytes);
+
+  query_trace_batch batch;
+  std::vector<KmerType> keys;
+  for (size_t b = 0; b < batches.size(); ++b) {
+    ASSERT_TRUE(reader.next(batch, keys));
+    EXPECT_EQ(batches[b].first, batch.op);
+    EXPECT_EQ(1000 * (b + 1), batch.nanoseconds);
+    EXPECT_EQ(batches[b].second, keys);
+  }
+  EXPECT_FALSE(reader.next(batch, keys));
+}
+
+TEST_F(QueryTraceTest, mismatch)
+{
+  ::mxx::comm comm;
+  write(comm);
+
+  // other number of ranks, other key size, missing file.
+  EXPECT_THROW(query_trace_reader<KmerType>(prefix, comm.size() + 1, comm.rank()), ::bliss::io::IOException);
+  EXPECT_THROW(query_trace_reader<uint32_t>(prefix, comm.size(), comm.rank()), ::bliss::io::IOException);
+  EXPECT_THROW(query_trace_reader<KmerType>(prefix + ".none", comm.size(), comm.rank()), ::bliss::io::IOException);
+
+  // cut in the middle of the last batch.
+  std::string name = query_trace_file_name(prefix, comm.rank());
+  FILE * f = fopen(name.c_str(), "rb");
+  ASSERT_TRUE(f != nullptr);
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fclose(f);
+  ASSERT_EQ(0, truncate(name.c_str(), size - 5));
+
+  query_trace_reader<KmerType> reader(prefix, comm.size(), comm.rank());
+  query_trace_batch batch;
+  std::vector<KmerType> keys;
+  for (size_t b = 0; b + 1 < batches.size(); ++b) ASSERT_TRUE(reader.next(batch, keys));
+  EXPECT_THROW(reader.next(batch, keys), ::bliss::io::IOException);
+
+  // not a trace.
+  ASSERT_EQ(0, truncate(name.c_str(), 10));
+  EXPECT_THROW(query_trace_reader<KmerType>(prefix, comm.size(), comm.rank()), ::bliss::io::IOException);
+}
+
+TEST_F(QueryTraceTest, replay)
+{
+  ::mxx::comm comm;
+  write(comm);
+
+  RecordingIndex index(comm);
+  std::vector<query_replay_stats> stats = replay_query_trace(index, prefix, comm);
+
+  // the same calls, in the same order, with the same keys.
+  ASSERT_EQ(batches.size(), index.calls.size());
+  for (size_t b = 0; b < batches.size(); ++b) {
+    EXPECT_EQ(batches[b].first, index.calls[b].first);
+    EXPECT_EQ(batches[b].second, index.calls[b].second);
+  }
+
+  ASSERT_EQ(2UL, stats.size());
+  size_t nbatches[2] = {0, 0}, nkeys[2] = {0, 0};
+  for (auto const & b : batches) {
+    int i = (b.first == query_trace_batch::find) ? 0 : 1;
+    ++nbatches[i];
+    nkeys[i] += ::mxx::allreduce(b.second.size(), comm);
+  }
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ((i == 0) ? query_trace_batch::find : query_trace_batch::count, stats[i].op);
+    EXPECT_EQ(nbatches[i], stats[i].batches);
+    EXPECT_EQ(nkeys[i], stats[i].keys);
+    EXPECT_LE(stats[i].p50, stats[i].p90);
+    EXPECT_LE(stats[i].p90, stats[i].p99);
+    EXPECT_LE(stats[i].p99, stats[i].max);
+    EXPECT_LE(stats[i].max, stats[i].total);
+    EXPECT_LE(stats[i].captured_p50, stats[i].captured_p99);
+  }
+  // the captured latencies are the recorded 1000 * (b + 1) ns.
+  EXPECT_DOUBLE_EQ(7e-6, stats[0].captured_p99);
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
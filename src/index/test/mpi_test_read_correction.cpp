@@ -0,0 +1,153 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_read_correction.cpp
+ *   reads sampled from a random genome, counted in a distributed counting map, then corrected after substitutions.
+ */
+
+#include "bliss-config.hpp"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <random>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_index.hpp"
+#include "index/read_correction.hpp"
+#include "containers/distributed_unordered_map.hpp"
+
+using KmerType = bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+
+template <typename Key>
+using MapParams = ::bliss::index::kmer::CanonicalHashMapParams<Key>;
+
+using MapType = ::dsc::counting_unordered_map<KmerType, uint32_t, MapParams>;
+using CorrectorType = ::bliss::index::kmer::SpectrumCorrector<MapType>;
+
+namespace {
+  /// the same genome on all ranks.
+  std::string random_genome(size_t const n) {
+    std::default_random_engine generator(17);
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::string g;
+    for (size_t i = 0; i < n; ++i) g.push_back("ACGT"[base_dist(generator)]);
+    return g;
+  }
+
+  /// reads of length len at random positions, half of them reverse complemented.
+  std::vector<std::string> sample_reads(std::string const & genome, size_t const count, size_t const len, unsigned const seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<size_t> pos_dist(0, genome.size() - len);
+    std::vector<std::string> reads;
+    for (size_t i = 0; i < count; ++i) {
+      std::string r = genome.substr(pos_dist(generator), len);
+      if (i % 2) {
+        std::string rc(r.rbegin(), r.rend());
+        for (char & c : rc) c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+        r.swap(rc);
+      }
+      reads.push_back(r);
+    }
+    return reads;
+  }
+
+  std::vector<KmerType> kmers_of(std::vector<std::string> const & reads) {
+    std::vector<KmerType> kmers;
+    for (auto const & r : reads) {
+      KmerType km;
+      for (size_t i = 0; i < r.size(); ++i) {
+        km.nextFromChar(KmerType::KmerAlphabet::FROM_ASCII[static_cast<unsigned char>(r[i])]);
+        if (i + 1 >= KmerType::size) kmers.push_back(km);
+      }
+    }
+    return kmers;
+  }
+
+  char other_base(char c) {
+    return (c == 'A') ? 'G' : (c == 'C') ? 'T' : (c == 'G') ? 'A' : 'C';
+  }
+}
+
+
+TEST(SpectrumCorrector, substitutions)
+{
+  ::mxx::comm comm;
+
+  std::string genome = random_genome(4000);
+  // about 10x coverage per rank.
+  std::vector<std::string> reads = sample_reads(genome, 400, 100, 100 + comm.rank());
+
+  // errors:  1 in the middle, 1 near the start, 2 far apart in 1 read, and an N.
+  std::vector<std::string> clean(reads.begin(), reads.begin() + 5);
+  std::vector<std::string> noisy = clean;
+  noisy[0][50] = other_base(noisy[0][50]);
+  noisy[1][2] = other_base(noisy[1][2]);
+  noisy[2][10] = other_base(noisy[2][10]);
+  noisy[2][80] = other_base(noisy[2][80]);
+  noisy[3][40] = 'N';
+  // noisy[4] has no error.
+
+  // the noisy reads are part of the input, as they would be.
+  std::vector<KmerType> kmers = kmers_of(reads);
+  std::vector<KmerType> noisy_kmers = kmers_of(noisy);
+  kmers.insert(kmers.end(), noisy_kmers.begin(), noisy_kmers.end());
+
+  MapType map(comm);
+  map.insert(kmers);
+
+  CorrectorType corrector(map, 3, comm);
+  size_t edits = corrector.correct(noisy);
+
+  EXPECT_EQ(5UL, edits);
+  EXPECT_EQ(clean, noisy);
+
+  // reads that share no k-mer with the genome are left alone.
+  std::vector<std::string> foreign(1, std::string(100, 'A'));
+  foreign[0][50] = 'C';
+  std::vector<std::string> before = foreign;
+  EXPECT_EQ(0UL, corrector.correct(foreign));
+  EXPECT_EQ(before, foreign);
+}
+
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
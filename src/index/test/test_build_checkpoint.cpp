@@ -0,0 +1,136 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"    // for location of data.
+#include "index/build_checkpoint.hpp"
+
+#include <cstdio>   // remove
+#include <string>
+#include <sstream>
+#include <vector>
+#include <unistd.h>  // getpid, truncate
+
+
+class BuildCheckpointTest : public ::testing::Test
+{
+  protected:
+    ::std::string input;
+    ::std::string prefix;
+
+    virtual void SetUp()
+    {
+      input.assign(PROJ_SRC_DIR);
+      input.append("/test/data/test.fastq");
+
+      ::std::stringstream ss;
+      ss << "/tmp/bliss_build_checkpoint_test_" << getpid();
+      prefix = ss.str();
+    }
+
+    virtual void TearDown()
+    {
+      for (int slot = 0; slot < 2; ++slot) {
+        for (int r = 0; r < 4; ++r) remove(::bliss::index::checkpoint_progress_file_name(prefix, slot, r).c_str());
+      }
+    }
+};
+
+
+TEST_F(BuildCheckpointTest, names)
+{
+  EXPECT_EQ(prefix + ".1", ::bliss::index::checkpoint_slot_prefix(prefix, 3));
+  EXPECT_EQ(prefix + ".0", ::bliss::index::checkpoint_slot_prefix(prefix, 4));
+  EXPECT_EQ(prefix + ".1.progress.2", ::bliss::index::checkpoint_progress_file_name(prefix, 5, 2));
+}
+
+TEST_F(BuildCheckpointTest, roundtrip)
+{
+  ::bliss::index::build_progress_record expected = ::bliss::index::make_build_progress_record(input, 4, 2);
+  EXPECT_LT(0UL, expected.file_bytes);
+
+  ::bliss::index::build_progress_record r = expected;
+  r.generation = 3;
+  r.chunks = 6;
+  r.steps = 1234;
+  r.kmers = 56789;
+  r.next_offset = 98765;
+  ::std::string name = ::bliss::index::checkpoint_progress_file_name(prefix, r.generation, 2);
+  ::bliss::index::write_build_progress_record(name, r);
+
+  ::bliss::index::build_progress_record loaded;
+  ASSERT_TRUE(::bliss::index::read_build_progress_record(name, expected, loaded));
+  EXPECT_EQ(3UL, loaded.generation);
+  EXPECT_EQ(6UL, loaded.chunks);
+  EXPECT_EQ(1234UL, loaded.steps);
+  EXPECT_EQ(56789UL, loaded.kmers);
+  EXPECT_EQ(98765UL, loaded.next_offset);
+
+  // the temporary file is gone after the rename.
+  EXPECT_NE(0, access((name + ".tmp").c_str(), F_OK));
+}
+
+TEST_F(BuildCheckpointTest, mismatch)
+{
+  ::bliss::index::build_progress_record r = ::bliss::index::make_build_progress_record(input, 4, 1);
+  r.generation = 1;
+  ::std::string name = ::bliss::index::checkpoint_progress_file_name(prefix, r.generation, 1);
+  ::bliss::index::write_build_progress_record(name, r);
+
+  ::bliss::index::build_progress_record loaded;
+  // different process count, rank, or input
+  EXPECT_FALSE(::bliss::index::read_build_progress_record(name, ::bliss::index::make_build_progress_record(input, 8, 1), loaded));
+  EXPECT_FALSE(::bliss::index::read_build_progress_record(name, ::bliss::index::make_build_progress_record(input, 4, 3), loaded));
+  EXPECT_FALSE(::bliss::index::read_build_progress_record(name,
+      ::bliss::index::make_build_progress_record(::std::string(PROJ_SRC_DIR) + "/test/data/test.medium.fastq", 4, 1), loaded));
+  EXPECT_TRUE(::bliss::index::read_build_progress_record(name, ::bliss::index::make_build_progress_record(input, 4, 1), loaded));
+}
+
+TEST_F(BuildCheckpointTest, bad_file)
+{
+  ::bliss::index::build_progress_record expected = ::bliss::index::make_build_progress_record(input, 4, 0);
+  ::bliss::index::build_progress_record loaded;
+  ::std::string name = ::bliss::index::checkpoint_progress_file_name(prefix, 2, 0);
+
+  // missing
+  EXPECT_FALSE(::bliss::index::read_build_progress_record(name, expected, loaded));
+
+  // truncated
+  ::bliss::index::build_progress_record r = expected;
+  r.generation = 2;
+  ::bliss::index::write_build_progress_record(name, r);
+  ASSERT_EQ(0, truncate(name.c_str(), sizeof(::bliss::index::build_progress_record) - 8));
+  EXPECT_FALSE(::bliss::index::read_build_progress_record(name, expected, loaded));
+
+  // generation 0 is never written by a build.
+  r.generation = 0;
+  ::bliss::index::write_build_progress_record(name, r);
+  EXPECT_FALSE(::bliss::index::read_build_progress_record(name, expected, loaded));
+}
+
+TEST_F(BuildCheckpointTest, file_list)
+{
+  ::std::vector<::std::string> inputs = { input, ::std::string(PROJ_SRC_DIR) + "/test/data/test.medium.fastq" };
+  ::bliss::index::build_progress_record r = ::bliss::index::make_build_progress_record(inputs, 4, 1);
+  EXPECT_EQ(::bliss::index::checkpoint_file_bytes(inputs[0]) + ::bliss::index::checkpoint_file_bytes(inputs[1]), r.file_bytes);
+
+  // order matters
+  ::std::vector<::std::string> reversed = { inputs[1], inputs[0] };
+  EXPECT_NE(r.file_name_hash, ::bliss::index::make_build_progress_record(reversed, 4, 1).file_name_hash);
+  EXPECT_NE(r.file_name_hash, ::bliss::index::make_build_progress_record(input, 4, 1).file_name_hash);
+}
@@ -30,6 +30,7 @@
 // include google test
 #include <gtest/gtest.h>
 #include "index/kmer_hash.hpp"
+#include "containers/fsc_container_utils.hpp"
 
 #include <random>
 #include <cstdint>
@@ -37,6 +38,7 @@
 #include <unordered_set>
 #include <set>
 #include <cmath>
+#include <algorithm>
 
 #include "common/kmer.hpp"
 #include "common/alphabets.hpp"
@@ -107,6 +109,24 @@ class KmerHashTest : public ::testing::Test {
       EXPECT_TRUE(same);
 
     }
+
+    /// the batched version gives the same hashes as the scalar one.
+    template <template <typename, bool> class H, bool Prefix>
+    void hash_batch(std::string name) {
+      H<T, Prefix> op;
+
+      std::vector<uint64_t> hashes(this->iterations);
+      ::fsc::hash_batch(op, this->kmers.data(), this->iterations, hashes.data());
+
+      size_t mismatches = 0;
+      for (size_t i = 0; i < this->iterations; ++i) {
+        if (hashes[i] != op(this->kmers[i])) ++mismatches;
+      }
+      if (mismatches > 0)
+        BL_DEBUGF("ERROR: batched hash %s differs for %lu of %lu kmers.", name.c_str(), mismatches, this->iterations);
+
+      EXPECT_EQ(0UL, mismatches);
+    }
 };
 
 template <typename T>
@@ -127,14 +147,33 @@ TYPED_TEST_P(KmerHashTest, hash)
 	this->template hash_vector<bliss::kmer::hash::identity>(std::string("identity"));
 	this->template hash_vector<bliss::kmer::hash::murmur  >(std::string("murmur"));
 	this->template hash_vector<bliss::kmer::hash::farm    >(std::string("farm"));
+	this->template hash_vector<bliss::kmer::hash::murmur64>(std::string("murmur64"));
+	this->template hash_vector<bliss::kmer::hash::murmur_fold>(std::string("murmur_fold"));
+	this->template hash_vector<bliss::kmer::hash::crc32c  >(std::string("crc32c"));
 }
 
+TYPED_TEST_P(KmerHashTest, fold_prefix)
+{
+  // the distribution half of murmur_fold is the murmur distribution hash.
+  bliss::kmer::hash::murmur_fold<TypeParam, true> fold;
+  bliss::kmer::hash::murmur<TypeParam, true> murmur;
+  for (size_t i = 0; i < this->iterations; i += 97) {
+    EXPECT_EQ(murmur(this->kmers[i]), fold(this->kmers[i]));
+  }
+}
 
+TYPED_TEST_P(KmerHashTest, batch)
+{
+	this->template hash_batch<bliss::kmer::hash::murmur64, false>(std::string("murmur64"));
+	this->template hash_batch<bliss::kmer::hash::murmur64, true >(std::string("murmur64 prefix"));
+	this->template hash_batch<bliss::kmer::hash::farm,     false>(std::string("farm"));
+}
 
 
 
 
-REGISTER_TYPED_TEST_CASE_P(KmerHashTest, hash);
+
+REGISTER_TYPED_TEST_CASE_P(KmerHashTest, hash, batch, fold_prefix);
 
 //////////////////// RUN the tests with different types.
 
@@ -193,3 +232,111 @@ typedef ::testing::Types<
 > KmerHashTestTypes;
 INSTANTIATE_TYPED_TEST_CASE_P(Bliss, KmerHashTest, KmerHashTestTypes);
 
+
+
+TEST(CRC32CHash, known_value)
+{
+  // the same with and without SSE4.2.
+  using KmerType = ::bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+  using KmerType2 = ::bliss::common::Kmer<63, bliss::common::DNA, uint64_t>;
+  KmerType k;
+  for (int i = 0; i < 31; ++i) k.nextFromChar(i % 4);
+  KmerType2 k2;
+  for (int i = 0; i < 63; ++i) k2.nextFromChar((i * 7) % 4);
+
+  EXPECT_EQ(0x456ef5cd767b387fULL, (bliss::kmer::hash::crc32c<KmerType, false>()(k)));
+  EXPECT_EQ(0x52c8926c0bff71b8ULL, (bliss::kmer::hash::crc32c<KmerType, true>()(k)));
+  EXPECT_EQ(0x15e27a439922465dULL, (bliss::kmer::hash::crc32c<KmerType2, false>()(k2)));
+}
+
+TEST(CRC32CHash, rank_balance)
+{
+  // as in KeyToRank:  hash % p.
+  using KmerType = ::bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+  bliss::kmer::hash::crc32c<KmerType, true> op;
+
+  KmerType k;
+  srand(1);
+  for (int i = 0; i < 31; ++i) k.nextFromChar(rand() % 4);
+
+  size_t const n = 1 << 18;
+  for (size_t p : {7UL, 64UL, 1000UL}) {
+    std::vector<size_t> counts(p, 0);
+    KmerType x = k;
+    for (size_t i = 0; i < n; ++i) {
+      x.nextFromChar(rand() % 4);
+      ++counts[op(x) % p];
+    }
+    double mean = static_cast<double>(n) / p;
+    double mx = static_cast<double>(*std::max_element(counts.begin(), counts.end()));
+    // 5 sigma of a binomial count.
+    EXPECT_LT(mx, mean + 5.0 * std::sqrt(mean)) << "p = " << p;
+  }
+}
+
+TEST(MinimizerHash, strand_independent)
+{
+  using KmerType = ::bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+  ::bliss::kmer::hash::minimizer<KmerType, true> op;
+
+  KmerType kmer;
+  srand(0);
+  for (unsigned int i = 0; i < KmerType::size; ++i) kmer.nextFromChar(rand() % 4);
+
+  // a kmer and its reverse complement have the same minimizer.  consecutive kmers mostly share it.
+  size_t changes = 0;
+  uint64_t prev = op(kmer);
+  for (size_t i = 0; i < 10000; ++i) {
+    kmer.nextFromChar(rand() % 4);
+    uint64_t h = op(kmer);
+    EXPECT_EQ(h, op(kmer.reverse_complement()));
+    if (h != prev) ++changes;
+    prev = h;
+  }
+  EXPECT_LT(changes, 10000UL / 4);
+}
+
+template <typename KmerType>
+void check_nthash() {
+  using Hash = ::bliss::kmer::hash::nthash<KmerType, false>;
+  using DistHash = ::bliss::kmer::hash::nthash<KmerType, true>;
+  using Alphabet = typename KmerType::KmerAlphabet;
+  Hash op;
+  DistHash dist_op;
+
+  std::vector<uint8_t> chars;
+  srand(0);
+  for (size_t i = 0; i < 10000 + KmerType::size; ++i) chars.push_back(rand() % Alphabet::SIZE);
+
+  KmerType kmer;
+  for (size_t i = 0; i < KmerType::size; ++i) kmer.nextFromChar(chars[i]);
+  uint64_t fw = Hash::forward(kmer);
+  uint64_t rv = Hash::reverse(kmer);
+
+  std::unordered_set<uint64_t> hashes;
+  for (size_t i = KmerType::size; i < chars.size(); ++i) {
+    // the rolled hash is the hash from scratch, and a kmer and its reverse complement hash the same.
+    uint64_t h = Hash::combine(fw, rv);
+    EXPECT_EQ(op(kmer), h);
+    EXPECT_EQ(h, op(kmer.reverse_complement()));
+    EXPECT_EQ(Hash::forward(kmer.reverse_complement()), rv);
+    EXPECT_EQ(dist_op(kmer), DistHash::finish(h));
+    hashes.insert(h);
+
+    kmer.nextFromChar(chars[i]);
+    fw = Hash::roll_forward(fw, chars[i - KmerType::size], chars[i]);
+    rv = Hash::roll_reverse(rv, chars[i - KmerType::size], chars[i]);
+  }
+  EXPECT_GT(hashes.size(), 9990UL);
+}
+
+TEST(NtHash, rolling_strand_symmetric)
+{
+  check_nthash<::bliss::common::Kmer<31, bliss::common::DNA, uint64_t> >();
+  check_nthash<::bliss::common::Kmer<21, bliss::common::DNA, uint16_t> >();
+  // longer than 64 characters, so the rotations wrap.
+  check_nthash<::bliss::common::Kmer<70, bliss::common::DNA, uint64_t> >();
+  check_nthash<::bliss::common::Kmer<64, bliss::common::DNA, uint64_t> >();
+  check_nthash<::bliss::common::Kmer<31, bliss::common::DNA16, uint64_t> >();
+  check_nthash<::bliss::common::Kmer<21, bliss::common::DNA5, uint64_t> >();
+}
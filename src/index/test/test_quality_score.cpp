@@ -435,3 +435,42 @@ TEST(QualityScoreGeneration, TestIllunima15QualityScoreFloat)
 
 }
 
+
+
+template <typename Q>
+void testQuantizedQuality(double const rel_err) {
+  EXPECT_EQ(sizeof(typename Q::storage_type), sizeof(Q));
+
+  // round trip within the relative error, down to the saturation probability.
+  double min_p = Q::decode(Q::saturated);
+  for (double p = 1.0; p > min_p; p *= 0.97) {
+    Q q(p);
+    EXPECT_NEAR(1.0, q.probability() / p, rel_err);
+  }
+  EXPECT_EQ(0, Q(1.0).code);
+  EXPECT_EQ(Q::saturated, Q(min_p * 0.5).code);
+  EXPECT_EQ(Q::incorrect, Q(0.0).code);
+  EXPECT_EQ(0.0, Q(0.0).probability());
+
+  // product as a sum of codes, saturating, with 0 absorbing.
+  Q a(0.9), b(0.8);
+  EXPECT_NEAR(0.72, (a * b).probability(), 2 * 0.72 * rel_err);
+  EXPECT_EQ(Q::saturated, (Q(min_p) * a).code);
+  EXPECT_EQ(Q::incorrect, (Q(0.0) * a).code);
+
+  // ordered by probability.
+  EXPECT_TRUE(b < a);
+  EXPECT_TRUE(Q(0.0) < b);
+  EXPECT_EQ(a, std::max(a, b));
+  EXPECT_EQ(b, std::min(a, b));
+}
+
+TEST(QuantizedQualityTest, Quality8)
+{
+  testQuantizedQuality<bliss::index::QuantizedQuality8>(0.0055);
+}
+
+TEST(QuantizedQualityTest, Quality16)
+{
+  testQuantizedQuality<bliss::index::QuantizedQuality16>(0.00009);
+}
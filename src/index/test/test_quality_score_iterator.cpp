@@ -30,6 +30,7 @@
 
 // include classes to test
 #include "index/quality_score_iterator.hpp"
+#include "iterators/transform_iterator.hpp"
 #include <vector>
 #include <algorithm>
 #include <cassert>
@@ -177,6 +178,18 @@ void iter_decode(const std::vector<unsigned char>& data, // quality score value
 }
 
 
+// templated test function
+template<typename CODEC, unsigned int K>
+void bulk_decode(const std::vector<unsigned char>& data, // quality score value
+                           std::vector<typename CODEC::value_type>& output) {
+
+  bliss::index::QualityScoreBulk<K, CODEC> bulk;
+
+  output.resize(data.size());
+  output.resize(bulk(data.data(), data.size(), output.data()));
+}
+
+
 // templated test function
 template<typename CODEC, unsigned int K>
 void codec_decode(const std::vector<unsigned char> & data, // quality score value
@@ -337,6 +350,24 @@ void testQualityIterator(const std::string & strdata) {
   EXPECT_TRUE(same);
 
 
+  std::vector<OT> bulkDecoded;
+  bulk_decode< Encoder, K >(gold, bulkDecoded);
+  same = compare_vectors<OT>(bulkDecoded, goldDecoded);
+
+  if (!same) {
+    BL_ERROR( "bulk decode: result not same" << std::endl );
+
+    BL_ERROR( "GOLD decoded: size: " << goldDecoded.size() );
+    std::copy(goldDecoded.begin() , goldDecoded.end(), std::ostream_iterator<OT>(std::cout, ","));
+    std::cout << std::endl;
+    BL_ERROR( "bulk decoded: size: " << bulkDecoded.size());
+    std::copy(bulkDecoded.begin() , bulkDecoded.end(), std::ostream_iterator<OT>(std::cout, ","));
+    std::cout << std::endl;
+  }
+
+  EXPECT_TRUE(same);
+
+
 }
 
 
@@ -439,3 +470,33 @@ TEST(QualityScoreGenerationIteratorTest, TestIllunima18QualityScoreFloat)
 //
 //}
 //
+
+
+/**
+ * Test quantizing the generated kmer qualities, as the pos-qual and de bruijn quality parsers do for QuantizedQuality.
+ */
+TEST(QualityScoreGenerationIteratorTest, TestIllunima18QualityScoreQuantized)
+{
+  std::string strdata = "IIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIII5555555555555555555555555555555555555555!+5?IIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIII";
+  std::vector<unsigned char> data(strdata.begin(), strdata.end());
+
+  using CODEC = bliss::index::Illumina18QualityScoreCodec<double>;
+  using Q = bliss::index::QuantizedQuality16;
+  using QualIter = bliss::index::QualityScoreGenerationIterator<std::vector<unsigned char>::const_iterator, 21, CODEC>;
+  using QuantIter = bliss::iterator::transform_iterator<QualIter, bliss::index::QualityQuantizer<Q> >;
+
+  static_assert(std::is_same<typename std::iterator_traits<QuantIter>::value_type, Q>::value, "quantized iterator value type should be Q");
+
+  std::vector<double> gold;
+  iter_decode<CODEC, 21>(data, gold);
+
+  QuantIter it(QualIter(data.begin(), true));
+  QuantIter end(QualIter(data.end(), false));
+  std::vector<Q> output(it, end);
+
+  ASSERT_EQ(gold.size(), output.size());
+  for (size_t i = 0; i < gold.size(); ++i) {
+    if (gold[i] == 0.0) EXPECT_EQ(Q::incorrect, output[i].code);
+    else EXPECT_NEAR(gold[i], output[i].probability(), gold[i] * 0.0001);
+  }
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    bgzf_file.hpp
+ * @ingroup io
+ * @brief   parallel reader for BGZF (blocked gzip, as written by bgzip) compressed FASTQ and FASTA files.
+ * @details a BGZF file is a series of gzip members of at most 64KB each, with the compressed member size recorded in a
+ *          "BC" extra field.  the compressed file is block partitioned across processes, and each process decompresses the
+ *          members that start in its partition, in parallel with OpenMP.  partitions are then in uncompressed coordinates,
+ *          and record boundaries are fixed up the same way as partitioned_file does for uncompressed files,
+ *          so FASTQParser and FASTAParser see the same file_data as for the uncompressed file.
+ *
+ *          plain (single member) gzip cannot be split, and is rejected.  recompress with bgzip.
+ *
+ *          decompression, and bgzf::inflate_block and bgzf::compress_block, need zlib (USE_ZLIB).
+ */
+
+#ifndef BGZF_FILE_HPP_
+#define BGZF_FILE_HPP_
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>    // memset, memcpy
+#include <algorithm>
+#include <stdexcept>
+
+#include "io/file.hpp"
+
+#if defined(USE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+
+namespace bliss
+{
+namespace io
+{
+
+namespace bgzf
+{
+
+  /// maximum size of a BGZF member, compressed or not.
+  constexpr size_t max_block_bytes = 65536UL;
+
+  /// bytes of a BGZF member header, beyond the extra field.  the gzip header is 12 bytes plus XLEN.
+  constexpr size_t min_header_bytes = 18UL;
+
+  /// bytes of the gzip footer:  CRC32 and ISIZE.
+  constexpr size_t footer_bytes = 8UL;
+
+  /// uncompressed bytes per member used by bgzip.  leaves room for incompressible data.
+  constexpr size_t max_input_bytes = 65280UL;
+
+  inline uint16_t get_u16(unsigned char const * p) {
+    return static_cast<uint16_t>(p[0]) | (static_cast<uint16_t>(p[1]) << 8);
+  }
+  inline uint32_t get_u32(unsigned char const * p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  }
+
+  /// a BGZF member:  position in the file, compressed size, and gzip header size.
+  struct block {
+      size_t offset;
+      size_t bytes;
+      size_t header_bytes;
+  };
+
+  /**
+   * @brief parse the member header at p, where avail bytes are readable.
+   * @return true if p starts a BGZF member.  b.offset is not set.
+   */
+  inline bool parse_header(unsigned char const * p, size_t const avail, block & b) {
+    if (avail < min_header_bytes) return false;
+    // gzip magic, deflate, FEXTRA
+    if ((p[0] != 0x1f) || (p[1] != 0x8b) || (p[2] != 8) || ((p[3] & 4) == 0)) return false;
+
+    size_t xlen = get_u16(p + 10);
+    if (avail < 12 + xlen) return false;
+
+    // find the BC subfield
+    size_t x = 0;
+    while (x + 4 <= xlen) {
+      unsigned char const * sf = p + 12 + x;
+      size_t slen = get_u16(sf + 2);
+      if ((sf[0] == 'B') && (sf[1] == 'C') && (slen == 2) && (x + 6 <= xlen)) {
+        b.bytes = static_cast<size_t>(get_u16(sf + 4)) + 1;
+        b.header_bytes = 12 + xlen;
+        return b.bytes >= b.header_bytes + footer_bytes;
+      }
+      x += 4 + slen;
+    }
+    return false;
+  }
+
+  /// uncompressed size of a member, from its footer.
+  inline size_t uncompressed_size(unsigned char const * member, block const & b) {
+    return get_u32(member + b.bytes - 4);
+  }
+
+#if defined(USE_ZLIB)
+  /**
+   * @brief decompress one member into out, which has exactly the size from uncompressed_size.
+   * @return false if the member is corrupt.
+   */
+  inline bool inflate_block(unsigned char const * member, block const & b, unsigned char * out, size_t const out_bytes) {
+    if (out_bytes == 0) return true;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(z_stream));
+    if (inflateInit2(&zs, -15) != Z_OK) return false;   // raw deflate:  the gzip header and footer are handled here.
+
+    zs.next_in = const_cast<unsigned char *>(member + b.header_bytes);
+    zs.avail_in = static_cast<uInt>(b.bytes - b.header_bytes - footer_bytes);
+    zs.next_out = out;
+    zs.avail_out = static_cast<uInt>(out_bytes);
+
+    int ret = inflate(&zs, Z_FINISH);
+    bool ok = (ret == Z_STREAM_END) && (zs.avail_out == 0);
+    inflateEnd(&zs);
+
+    return ok && (crc32(crc32(0L, Z_NULL, 0), out, static_cast<uInt>(out_bytes)) == get_u32(member + b.bytes - footer_bytes));
+  }
+
+  /**
+   * @brief compress in[0, count) as one member and append it to out, as bgzip does.  an empty input gives the EOF member.
+   * @param count  at most max_input_bytes, so that the member fits in 64KB even if the data does not compress.
+   * @param level  zlib compression level.
+   */
+  inline void compress_block(unsigned char const * in, size_t const count, ::std::vector<unsigned char> & out, int const level = Z_DEFAULT_COMPRESSION) {
+    if (count > max_input_bytes) throw ::std::invalid_argument("ERROR: bgzf member input must be at most 65280 bytes.");
+
+    size_t start = out.size();
+    out.resize(start + max_block_bytes);
+    unsigned char * p = out.data() + start;
+
+    // header, with BSIZE filled in below.
+    unsigned char const header[min_header_bytes] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0 };
+    memcpy(p, header, min_header_bytes);
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(z_stream));
+    if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      throw ::std::runtime_error("ERROR: bgzf deflateInit2 failed.");
+    zs.next_in = const_cast<unsigned char *>(in);
+    zs.avail_in = static_cast<uInt>(count);
+    zs.next_out = p + min_header_bytes;
+    zs.avail_out = static_cast<uInt>(max_block_bytes - min_header_bytes - footer_bytes);
+    int ret = deflate(&zs, Z_FINISH);
+    size_t compressed = zs.total_out;
+    deflateEnd(&zs);
+    if (ret != Z_STREAM_END) throw ::std::runtime_error("ERROR: bgzf member does not fit in 64KB.");
+
+    size_t bytes = min_header_bytes + compressed + footer_bytes;
+    p[16] = (bytes - 1) & 0xFF;
+    p[17] = ((bytes - 1) >> 8) & 0xFF;
+
+    uint32_t crc = crc32(crc32(0L, Z_NULL, 0), in, static_cast<uInt>(count));
+    uint32_t isize = count;
+    unsigned char * f = p + min_header_bytes + compressed;
+    for (int i = 0; i < 4; ++i) {
+      f[i] = (crc >> (8 * i)) & 0xFF;
+      f[4 + i] = (isize >> (8 * i)) & 0xFF;
+    }
+
+    out.resize(start + bytes);
+  }
+#endif
+
+  /**
+   * @brief find the first member that starts in data[from, to).
+   * @details a candidate must be followed by another member or by the end of file, so a header-like byte pattern inside
+   *          compressed data is not mistaken for a member.
+   * @param data        buffer holding file bytes [data_offset, data_offset + data_bytes)
+   * @param file_bytes  size of the file.
+   * @return  file offset of the member, or to if there is none.
+   */
+  inline size_t find_first_block(unsigned char const * data, size_t const data_offset, size_t const data_bytes,
+                                 size_t const from, size_t const to, size_t const file_bytes) {
+    block b, next;
+    size_t data_end = data_offset + data_bytes;
+    for (size_t pos = from; pos < to; ++pos) {
+      unsigned char const * p = data + (pos - data_offset);
+      if (!parse_header(p, data_end - pos, b)) continue;
+
+      size_t n = pos + b.bytes;
+      if (n == file_bytes) return pos;
+      if ((n < data_end) && parse_header(data + (n - data_offset), data_end - n, next)) return pos;
+    }
+    return to;
+  }
+
+} // namespace bgzf
+
+
+#if defined(USE_MPI)
+namespace parallel
+{
+
+/**
+ * @brief  BGZF compressed file, partitioned by member across the processes of a communicator.
+ * @details  same constructor and read_file interface as partitioned_file, so it can be used as the FileType of
+ *          KmerFileHelper::read_file and stream_file.  size() is the compressed size;  the file_data ranges are uncompressed.
+ * @tparam FileParser  FASTQParser, FASTAParser, or BaseFileParser.
+ */
+template <template <typename> class FileParser = ::bliss::io::BaseFileParser>
+class bgzf_file : public ::bliss::io::parallel::base_file {
+
+protected:
+	using BASE = ::bliss::io::parallel::base_file;
+
+	using range_type = typename ::bliss::io::base_file::range_type;
+	using FileParserType = FileParser<typename ::bliss::io::file_data::const_iterator >;
+
+	/// reads the compressed bytes.
+	::bliss::io::posix_file reader;
+
+	/// overlap amount, in uncompressed bytes.
+	const size_t overlap;
+
+	/// partitioner for the compressed bytes.
+	::bliss::partition::BlockPartitioner<range_type> partitioner;
+
+	/// throw on all ranks if it failed on any.
+	void check_all(bool const ok, std::string const & msg) {
+		if (!::mxx::all_of(ok, this->comm)) {
+			throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR: bgzf_file [" + this->filename + "]: " + msg);
+		}
+	}
+
+	/**
+	 * @brief  decompress the members that start in this rank's partition of the compressed file, appending to out.
+	 */
+	void decompress_partition(::bliss::io::file_data::container & out) {
+		range_type compressed = this->file_range_bytes;
+		if (this->comm.size() > 1) {
+			partitioner.configure(this->file_range_bytes, this->comm.size());
+			compressed = partitioner.getNext(this->comm.rank());
+		}
+
+		// members starting in the partition may extend 1 member past it.  read enough to also check the next header.
+		range_type window(compressed.start, compressed.end + ::bliss::io::bgzf::max_block_bytes + ::bliss::io::bgzf::min_header_bytes);
+		window.intersect(this->file_range_bytes);
+		::bliss::io::file_data::container cdata;
+		if (window.size() > 0) window = reader.read_range(cdata, window);
+		cdata.resize(window.size());
+
+		// the first member starts at 0.  elsewhere, search.
+		size_t first = compressed.end;
+		::bliss::io::bgzf::block b;
+		if (compressed.size() > 0) {
+			if (compressed.start == 0)
+				first = ::bliss::io::bgzf::parse_header(cdata.data(), cdata.size(), b) ? 0 : compressed.end;
+			else
+				first = ::bliss::io::bgzf::find_first_block(cdata.data(), window.start, cdata.size(),
+						compressed.start, compressed.end, this->file_range_bytes.end);
+		}
+		check_all((this->comm.rank() != 0) || (compressed.size() == 0) || (first == 0),
+				"not a BGZF file.  gzip files must be compressed with bgzip to be read in parallel.");
+
+		// walk the member chain.
+		std::vector<::bliss::io::bgzf::block> blocks;
+		std::vector<size_t> offsets(1, 0);
+		bool ok = true;
+		for (size_t pos = first; pos < compressed.end; pos += b.bytes) {
+			size_t avail = window.end - pos;
+			if (!::bliss::io::bgzf::parse_header(cdata.data() + (pos - window.start), avail, b) || (b.bytes > avail)) {
+				ok = false;
+				break;
+			}
+			b.offset = pos;
+			blocks.push_back(b);
+			offsets.push_back(offsets.back() + ::bliss::io::bgzf::uncompressed_size(cdata.data() + (pos - window.start), b));
+		}
+		check_all(ok, "truncated or corrupt BGZF member.");
+
+		// decompress in parallel.  each member has a known output position.
+		size_t start = out.size();
+		out.resize(start + offsets.back());
+
+#if defined(USE_ZLIB)
+		int good = 1;
+		int const nblocks = blocks.size();
+#if defined(USE_OPENMP)
+#pragma omp parallel for schedule(dynamic, 16) reduction(&:good)
+#endif
+		for (int i = 0; i < nblocks; ++i) {
+			good &= ::bliss::io::bgzf::inflate_block(cdata.data() + (blocks[i].offset - window.start), blocks[i],
+					out.data() + start + offsets[i], offsets[i + 1] - offsets[i]) ? 1 : 0;
+		}
+		check_all(good != 0, "BGZF member failed to decompress or failed its CRC.");
+#else
+		check_all(blocks.size() == 0, "compiled without zlib (USE_ZLIB), cannot decompress.");
+#endif
+	}
+
+	/**
+	 * @brief  append the count uncompressed bytes that follow this rank's range.  they are held by the following ranks.  collective.
+	 * @param sizes  uncompressed bytes held by each rank.
+	 * @param starts uncompressed start of each rank's range.
+	 */
+	void fetch_following(::bliss::io::file_data::container & data, std::vector<size_t> const & sizes,
+			std::vector<size_t> const & starts, size_t const count) {
+		int p = this->comm.size();
+		int rank = this->comm.rank();
+
+		// bytes this rank sends to each rank r, from the front of the data:  [end_r, end_r + count) intersected with this rank's range.
+		std::vector<size_t> send_counts(p, 0);
+		::bliss::io::file_data::container send;
+		range_type mine(starts[rank], starts[rank] + sizes[rank]);
+		for (int r = 0; r < rank; ++r) {
+			range_type want(starts[r] + sizes[r], starts[r] + sizes[r] + count);
+			want.intersect(mine);
+			if (want.size() == 0) continue;
+			send_counts[r] = want.size();
+			send.insert(send.end(), data.begin() + (want.start - mine.start), data.begin() + (want.end - mine.start));
+		}
+
+		// received in rank order, i.e. in file order.
+		::bliss::io::file_data::container recv = ::mxx::all2allv(send, send_counts, this->comm);
+		data.insert(data.end(), recv.begin(), recv.end());
+	}
+
+public:
+	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+	using BASE::read_range;
+
+	/// uncompressed ranges cannot be located without reading the preceding members.  use read_file.
+	virtual range_type read_range(typename ::bliss::io::file_data::container & output,
+                                range_type const & range_bytes) {
+		BLISS_UNUSED(output);
+		BLISS_UNUSED(range_bytes);
+		throw ::std::logic_error("ERROR: bgzf_file does not support read_range.  use read_file.");
+	}
+
+	/**
+	 * @brief constructor
+	 * @param _filename 		name of file to open
+	 * @param _overlap			overlap between partitions, in uncompressed bytes.  ignored for FASTQ, as for partitioned_file.
+	 * @param _comm				MPI communicator to use.
+	 */
+	bgzf_file(std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm()) :
+		BASE(_filename, _comm),
+		reader(this->fd, this->file_range_bytes.end),
+		overlap(std::is_same<FileParserType, ::bliss::io::FASTQParser<typename ::bliss::io::file_data::const_iterator> >::value ? 0UL : _overlap) {};
+
+	/// destructor
+	virtual ~bgzf_file() {};
+
+	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+	using BASE::read_file;
+
+	/**
+	 * @brief  read and decompress this rank's partition.  collective.
+	 * @param output 		file_data object containing data and various ranges, in uncompressed coordinates.
+	 */
+	virtual void read_file(::bliss::io::file_data & output) {
+		output.data.clear();
+		decompress_partition(output.data);
+
+		// uncompressed position of the partition.
+		std::vector<size_t> sizes = ::mxx::allgather(output.data.size(), this->comm);
+		std::vector<size_t> starts(sizes.size() + 1, 0);
+		for (size_t i = 0; i < sizes.size(); ++i) starts[i + 1] = starts[i] + sizes[i];
+
+		range_type file_range(0, starts.back());
+		range_type partition_range(starts[this->comm.rank()], starts[this->comm.rank() + 1]);
+		output.parent_range_bytes = file_range;
+
+		if (std::is_same<FileParserType, ::bliss::io::FASTQParser<typename ::bliss::io::file_data::const_iterator> >::value) {
+			// same as partitioned_file<FASTQParser>:  move the partial record at the start of each partition to the rank before.
+			FileParserType parser;
+			size_t real_start = parser.init_parser(output.in_mem_cbegin(), file_range,
+					partition_range, partition_range, this->comm);
+
+			bool not_found = (real_start >= partition_range.end);  // if real start is outside of partition, not found
+			real_start = std::min(real_start, partition_range.end);
+			int target_rank = not_found ? 0 : this->comm.rank();
+			target_rank = ::mxx::exscan(target_rank, [](int const & x, int const & y) {
+				return (x < y) ? y : x;
+			}, this->comm);
+
+			std::vector<size_t> send_counts(this->comm.size(), 0);
+			if (this->comm.rank() > 0) send_counts[target_rank] = real_start - partition_range.start;
+
+			typename ::bliss::io::file_data::container shifted =
+					::mxx::all2allv(output.data, send_counts, this->comm);
+			output.data.insert(output.data.end(), shifted.begin(), shifted.end());
+
+			output.in_mem_range_bytes = partition_range;
+			output.in_mem_range_bytes.end = partition_range.start + output.data.size();
+
+			output.valid_range_bytes.start = real_start;
+			output.valid_range_bytes.end =
+					not_found ? partition_range.end : output.in_mem_range_bytes.end;
+			return;
+		}
+
+		// FASTA and plain bytes:  append the overlap from the following ranks, as partitioned_file reads it.
+		bool is_fasta = std::is_same<FileParserType, ::bliss::io::FASTAParser<typename ::bliss::io::file_data::const_iterator> >::value;
+		fetch_following(output.data, sizes, starts, overlap);
+
+		output.valid_range_bytes = partition_range;
+		output.in_mem_range_bytes = range_type(partition_range.start, partition_range.start + output.data.size());
+
+		if (is_fasta) {
+			FileParserType parser;
+			size_t overlap_end = parser.find_overlap_end(output.in_mem_cbegin(), output.parent_range_bytes,
+					output.in_mem_range_bytes, output.valid_range_bytes.end, overlap);
+
+			output.in_mem_range_bytes.end = overlap_end;
+			output.data.erase(output.data.begin() + output.in_mem_range_bytes.size(), output.data.end());
+		}
+	}
+
+};
+
+} // namespace parallel
+#endif
+
+} // namespace io
+} // namespace bliss
+
+#endif /* BGZF_FILE_HPP_ */
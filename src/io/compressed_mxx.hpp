@@ -0,0 +1,221 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    compressed_mxx.hpp
+ * @ingroup
+ * @brief   distribute with delta encoded buckets.
+ * @details for key only exchanges where the order of the received keys does not matter, e.g. k-mer counting.
+ *          each bucket is sorted and delta + varint encoded (see delta_codec.hpp) before the all2allv, and decoded after.
+ *          superkmer_distribute instead keeps the k-mer order and encodes runs of overlapping k-mers (see superkmer_codec.hpp).
+ */
+
+#ifndef COMPRESSED_MXX_HPP
+#define COMPRESSED_MXX_HPP
+
+#include <vector>
+#include <algorithm>
+#include <numeric>   // accumulate
+#include <cstdint>
+
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
+
+#include "utils/benchmark_utils.hpp"
+#include "io/incremental_mxx.hpp"
+#include "io/delta_codec.hpp"
+#include "io/superkmer_codec.hpp"
+
+namespace imxx
+{
+
+  namespace detail
+  {
+    /// exchange element counts, encoded byte counts, and the encoded bytes of each bucket.
+    template <typename SIZE>
+    void exchange_encoded(::std::vector<SIZE> const & send_counts,
+                          ::std::vector<uint8_t> const & send_bytes, ::std::vector<size_t> const & send_byte_counts,
+                          ::std::vector<SIZE> & recv_counts,
+                          ::std::vector<uint8_t> & recv_bytes, ::std::vector<size_t> & recv_byte_counts,
+                          ::mxx::comm const &_comm) {
+      int p = _comm.size();
+      recv_counts.resize(p);
+      mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
+      recv_byte_counts.resize(p);
+      mxx::all2all(send_byte_counts.data(), 1, recv_byte_counts.data(), _comm);
+
+      recv_bytes.resize(std::accumulate(recv_byte_counts.begin(), recv_byte_counts.end(), static_cast<size_t>(0)));
+      mxx::all2allv(send_bytes.data(), send_byte_counts, recv_bytes.data(), recv_byte_counts, _comm);
+    }
+  } // namespace detail
+
+  /**
+   * @brief distribute keys with a compressed wire format.
+   * @details  output holds the same keys as imxx::distribute, grouped by source rank in rank order,
+   *           but sorted (codec::less) within each source segment rather than in send order.  recv_counts are element counts.
+   *           input is not modified.
+   */
+  template <typename V, typename ToRank, typename SIZE>
+  void compressed_distribute(::std::vector<V> const & input, ToRank const & to_rank,
+                             ::std::vector<SIZE> & recv_counts,
+                             ::std::vector<V>& output,
+                             ::mxx::comm const &_comm) {
+    static_assert(::imxx::codec::word_view<V>::value, "compressed_distribute requires a key type supported by the delta codec");
+
+    BL_BENCH_INIT(distribute);
+
+    BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
+    bool empty = input.size() == 0;
+    empty = mxx::all_of(empty, _comm);
+    BL_BENCH_END(distribute, "empty", input.size());
+
+    if (empty) {
+      BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:compressed_distribute", _comm);
+      return;
+    }
+
+    int p = _comm.size();
+
+    // bucketing
+    BL_BENCH_START(distribute);
+    std::vector<SIZE> send_counts(p, 0);
+    std::vector<SIZE> i2o(input.size());
+    imxx::local::assign_to_buckets(input, to_rank, p, send_counts, i2o, 0, input.size());
+    imxx::local::bucket_to_permutation(send_counts, i2o, 0, input.size());
+    BL_BENCH_END(distribute, "bucket", input.size());
+
+    BL_BENCH_START(distribute);
+    if (output.capacity() < input.size()) output.clear();
+    output.resize(input.size());
+    imxx::local::bucket_permute(input.begin(), input.end(), i2o.begin(), output.begin(), 0, p);
+    std::vector<SIZE>().swap(i2o);
+    BL_BENCH_END(distribute, "permute", output.size());
+
+    // sort and encode each bucket.
+    BL_BENCH_START(distribute);
+    std::vector<uint8_t> send_bytes;
+    send_bytes.reserve(input.size() * sizeof(V) / 2);
+    std::vector<size_t> send_byte_counts(p, 0);
+    size_t offset = 0;
+    for (int i = 0; i < p; ++i) {
+      std::sort(output.begin() + offset, output.begin() + offset + send_counts[i], ::imxx::codec::less<V>());
+      send_byte_counts[i] = ::imxx::codec::encode(output.data() + offset, send_counts[i], send_bytes);
+      offset += send_counts[i];
+    }
+    BL_BENCH_END(distribute, "encode", send_bytes.size());
+
+    BL_BENCH_COLLECTIVE_START(distribute, "a2a", _comm);
+    std::vector<size_t> recv_byte_counts;
+    std::vector<uint8_t> recv_bytes;
+    detail::exchange_encoded(send_counts, send_bytes, send_byte_counts, recv_counts, recv_bytes, recv_byte_counts, _comm);
+    BL_BENCH_END(distribute, "a2a", recv_bytes.size());
+
+    // decode in rank order.
+    BL_BENCH_START(distribute);
+    std::vector<uint8_t>().swap(send_bytes);
+    output.clear();
+    output.reserve(std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0)));
+    offset = 0;
+    for (int i = 0; i < p; ++i) {
+      ::imxx::codec::decode(recv_bytes.data() + offset, recv_byte_counts[i], output);
+      offset += recv_byte_counts[i];
+    }
+    BL_BENCH_END(distribute, "decode", output.size());
+
+    BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:compressed_distribute", _comm);
+  }
+
+
+  /**
+   * @brief distribute k-mers with the super-kmer wire format (superkmer_codec.hpp).
+   * @details  output holds the same k-mers as imxx::distribute, in the same order:  grouped by source rank in rank order,
+   *           in send order within each source segment.  recv_counts are element counts.  input is not modified.
+   *           compresses well when consecutive input k-mers overlap and go to the same rank,
+   *           e.g. k-mers of reads distributed with the minimizer hash.
+   */
+  template <typename KMER, typename ToRank, typename SIZE>
+  void superkmer_distribute(::std::vector<KMER> const & input, ToRank const & to_rank,
+                            ::std::vector<SIZE> & recv_counts,
+                            ::std::vector<KMER>& output,
+                            ::mxx::comm const &_comm) {
+    static_assert(::bliss::common::is_kmer<KMER>::value, "superkmer_distribute requires a kmer type");
+
+    BL_BENCH_INIT(distribute);
+
+    BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
+    bool empty = input.size() == 0;
+    empty = mxx::all_of(empty, _comm);
+    BL_BENCH_END(distribute, "empty", input.size());
+
+    if (empty) {
+      BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:superkmer_distribute", _comm);
+      return;
+    }
+
+    int p = _comm.size();
+
+    // bucketing.  stable, so runs of consecutive k-mers stay together.
+    BL_BENCH_START(distribute);
+    std::vector<SIZE> send_counts(p, 0);
+    std::vector<SIZE> i2o(input.size());
+    imxx::local::assign_to_buckets(input, to_rank, p, send_counts, i2o, 0, input.size());
+    imxx::local::bucket_to_permutation(send_counts, i2o, 0, input.size());
+    BL_BENCH_END(distribute, "bucket", input.size());
+
+    BL_BENCH_START(distribute);
+    if (output.capacity() < input.size()) output.clear();
+    output.resize(input.size());
+    imxx::local::bucket_permute(input.begin(), input.end(), i2o.begin(), output.begin(), 0, p);
+    std::vector<SIZE>().swap(i2o);
+    BL_BENCH_END(distribute, "permute", output.size());
+
+    // encode each bucket, in order.
+    BL_BENCH_START(distribute);
+    std::vector<uint8_t> send_bytes;
+    send_bytes.reserve(input.size() * 2);
+    std::vector<size_t> send_byte_counts(p, 0);
+    size_t offset = 0;
+    for (int i = 0; i < p; ++i) {
+      send_byte_counts[i] = ::imxx::codec::superkmer::encode(output.data() + offset, send_counts[i], send_bytes);
+      offset += send_counts[i];
+    }
+    BL_BENCH_END(distribute, "encode", send_bytes.size());
+
+    BL_BENCH_COLLECTIVE_START(distribute, "a2a", _comm);
+    std::vector<size_t> recv_byte_counts;
+    std::vector<uint8_t> recv_bytes;
+    detail::exchange_encoded(send_counts, send_bytes, send_byte_counts, recv_counts, recv_bytes, recv_byte_counts, _comm);
+    BL_BENCH_END(distribute, "a2a", recv_bytes.size());
+
+    // decode in rank order.
+    BL_BENCH_START(distribute);
+    std::vector<uint8_t>().swap(send_bytes);
+    output.clear();
+    output.reserve(std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0)));
+    offset = 0;
+    for (int i = 0; i < p; ++i) {
+      ::imxx::codec::superkmer::decode(recv_bytes.data() + offset, recv_byte_counts[i], output);
+      offset += recv_byte_counts[i];
+    }
+    BL_BENCH_END(distribute, "decode", output.size());
+
+    BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:superkmer_distribute", _comm);
+  }
+
+} // namespace imxx
+
+
+#endif // COMPRESSED_MXX_HPP
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    delta_codec.hpp
+ * @ingroup io
+ * @brief   delta + varint wire format for sorted k-mers and unsigned integers.
+ * @details a key is viewed as a multi-word unsigned integer, word 0 least significant.
+ *          a sorted run is encoded as (delta from previous, repeat count - 1) pairs, each as LEB128 varint.
+ *          duplicates cost nothing beyond the repeat count, and dense runs need only a few bytes per key.
+ *
+ *          the sort order is the codec's own (multi-word unsigned), not the key's operator<.
+ *          sequence kmer ids are also supported, as their packed integer ids.
+ */
+
+#ifndef DELTA_CODEC_HPP
+#define DELTA_CODEC_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+
+#include "common/kmer.hpp"
+#include "common/sequence.hpp"
+
+namespace imxx
+{
+
+  namespace codec
+  {
+
+    /// word level view of a key.  value is false for unsupported types.
+    template <typename T, typename Enable = void>
+    struct word_view {
+        static constexpr bool value = false;
+    };
+
+    /// unsigned integers: a single word.
+    template <typename T>
+    struct word_view<T, typename ::std::enable_if<::std::is_integral<T>::value && ::std::is_unsigned<T>::value>::type> {
+        static constexpr bool value = true;
+        using word_type = T;
+        static constexpr size_t nwords = 1;
+
+        static word_type const * words(T const & x) { return &x; }
+        static word_type * words(T & x) { return &x; }
+    };
+
+    /// kmers: the data words.
+    template <unsigned int K, typename ALPHA, typename WORD>
+    struct word_view<::bliss::common::Kmer<K, ALPHA, WORD>, void> {
+        static constexpr bool value = true;
+        using word_type = WORD;
+        static constexpr size_t nwords = ::bliss::common::Kmer<K, ALPHA, WORD>::nWords;
+
+        static word_type const * words(::bliss::common::Kmer<K, ALPHA, WORD> const & x) { return x.getData(); }
+        static word_type * words(::bliss::common::Kmer<K, ALPHA, WORD> & x) { return x.getDataRef(); }
+    };
+
+
+    /// sequence kmer ids:  the packed id.
+    template <typename T>
+    struct word_view<T, typename ::std::enable_if<::std::is_same<T, ::bliss::common::LongSequenceKmerId>::value ||
+                                                  ::std::is_same<T, ::bliss::common::ShortSequenceKmerId>::value>::type> {
+        static constexpr bool value = true;
+        using word_type = size_t;
+        static constexpr size_t nwords = 1;
+
+        static word_type const * words(T const & x) { return &(x.id); }
+        static word_type * words(T & x) { return &(x.id); }
+    };
+
+    /// bit packed sequence kmer ids:  the bytes, least significant first.
+    template <unsigned int POS_BITS, unsigned int FILE_BITS, unsigned int BYTES>
+    struct word_view<::bliss::common::PackedSequenceKmerId<POS_BITS, FILE_BITS, BYTES>, void> {
+        static constexpr bool value = true;
+        using word_type = uint8_t;
+        static constexpr size_t nwords = BYTES;
+
+        static word_type const * words(::bliss::common::PackedSequenceKmerId<POS_BITS, FILE_BITS, BYTES> const & x) { return x.id; }
+        static word_type * words(::bliss::common::PackedSequenceKmerId<POS_BITS, FILE_BITS, BYTES> & x) { return x.id; }
+    };
+
+    /// ordering used by the codec.  compares from the most significant word.
+    template <typename T>
+    struct less {
+        using VIEW = word_view<T>;
+
+        bool operator()(T const & x, T const & y) const {
+          typename VIEW::word_type const * xw = VIEW::words(x);
+          typename VIEW::word_type const * yw = VIEW::words(y);
+          for (size_t i = VIEW::nwords; i > 0; --i) {
+            if (xw[i-1] != yw[i-1]) return xw[i-1] < yw[i-1];
+          }
+          return false;
+        }
+    };
+
+    /// upper bound on the encoded size of n keys.
+    template <typename T>
+    constexpr size_t max_encoded_bytes(size_t n) {
+      return n * ((word_view<T>::nwords * sizeof(typename word_view<T>::word_type) * 8 + 6) / 7 +
+          (sizeof(size_t) * 8 + 6) / 7);
+    }
+
+    namespace detail {
+
+      /// LEB128 encode a multi-word unsigned integer.  w is consumed.
+      template <typename W, size_t N>
+      uint8_t * put_varint(W (&w)[N], uint8_t * out) {
+        constexpr size_t wbits = sizeof(W) * 8;
+        while (true) {
+          uint8_t byte = static_cast<uint8_t>(w[0] & 0x7F);
+
+          // shift right by 7 bits.  words narrower than 7 bits do not exist.
+          bool more = false;
+          for (size_t i = 0; i < N; ++i) {
+            W hi = (i + 1 < N) ? w[i+1] : 0;
+            w[i] = static_cast<W>((wbits > 7) ? ((w[i] >> 7) | static_cast<W>(hi << (wbits - 7))) : hi);
+            more |= (w[i] != 0);
+          }
+
+          if (!more) {
+            *out = byte;
+            return ++out;
+          }
+          *out = byte | 0x80;
+          ++out;
+        }
+      }
+
+      template <typename W, size_t N>
+      uint8_t const * get_varint(uint8_t const * in, W (&w)[N]) {
+        constexpr size_t wbits = sizeof(W) * 8;
+        ::std::fill(w, w + N, static_cast<W>(0));
+
+        size_t bitpos = 0;
+        uint8_t byte;
+        do {
+          byte = *in;
+          ++in;
+          uint64_t v = byte & 0x7F;
+          size_t idx = bitpos / wbits;
+          size_t off = bitpos % wbits;
+          if (idx < N) {
+            w[idx] |= static_cast<W>(v << off);
+            if ((off + 7 > wbits) && (idx + 1 < N)) w[idx + 1] |= static_cast<W>(v >> (wbits - off));
+          }
+          bitpos += 7;
+        } while (byte & 0x80);
+
+        return in;
+      }
+
+      /// z = x - y, with borrow.  requires x >= y.
+      template <typename W, size_t N>
+      void subtract(W const * x, W const * y, W (&z)[N]) {
+        W borrow = 0;
+        for (size_t i = 0; i < N; ++i) {
+          W d = static_cast<W>(x[i] - y[i]);
+          W b = (x[i] < y[i]) ? 1 : 0;
+          z[i] = static_cast<W>(d - borrow);
+          borrow = b | ((d < borrow) ? 1 : 0);
+        }
+      }
+
+      /// x += y, with carry.
+      template <typename W, size_t N>
+      void add(W * x, W const (&y)[N]) {
+        W carry = 0;
+        for (size_t i = 0; i < N; ++i) {
+          W s = static_cast<W>(x[i] + y[i]);
+          W c = (s < x[i]) ? 1 : 0;
+          x[i] = static_cast<W>(s + carry);
+          carry = c | ((x[i] < s) ? 1 : 0);
+        }
+      }
+
+    } // namespace detail
+
+
+    /**
+     * @brief encode a run of keys, sorted by codec::less, appending to out.
+     * @return number of bytes appended.
+     */
+    template <typename T>
+    size_t encode(T const * sorted, size_t n, ::std::vector<uint8_t> & out) {
+      static_assert(word_view<T>::value, "type is not supported by the delta codec");
+      using VIEW = word_view<T>;
+      using W = typename VIEW::word_type;
+      constexpr size_t N = VIEW::nwords;
+
+      size_t start = out.size();
+      if (n == 0) return 0;
+
+      out.resize(start + max_encoded_bytes<T>(n));
+      uint8_t * o = out.data() + start;
+
+      W prev[N];
+      ::std::fill(prev, prev + N, static_cast<W>(0));
+      W delta[N];
+      size_t run[1];
+
+      for (size_t i = 0; i < n; ) {
+        W const * cur = VIEW::words(sorted[i]);
+
+        size_t j = i + 1;
+        while ((j < n) && ::std::equal(cur, cur + N, VIEW::words(sorted[j]))) ++j;
+
+        detail::subtract(cur, prev, delta);
+        o = detail::put_varint(delta, o);
+        run[0] = j - i - 1;
+        o = detail::put_varint(run, o);
+
+        ::std::copy(cur, cur + N, prev);
+        i = j;
+      }
+
+      out.resize(o - out.data());
+      return out.size() - start;
+    }
+
+    /**
+     * @brief decode bytes produced by encode, appending keys to out.
+     * @return number of keys appended.
+     */
+    template <typename T>
+    size_t decode(uint8_t const * in, size_t bytes, ::std::vector<T> & out) {
+      static_assert(word_view<T>::value, "type is not supported by the delta codec");
+      using VIEW = word_view<T>;
+      using W = typename VIEW::word_type;
+      constexpr size_t N = VIEW::nwords;
+
+      size_t start = out.size();
+      uint8_t const * end = in + bytes;
+
+      T cur = T();
+      ::std::fill(VIEW::words(cur), VIEW::words(cur) + N, static_cast<W>(0));
+      W delta[N];
+      size_t run[1];
+
+      while (in < end) {
+        in = detail::get_varint(in, delta);
+        in = detail::get_varint(in, run);
+        detail::add(VIEW::words(cur), delta);
+        out.insert(out.end(), run[0] + 1, cur);
+      }
+
+      return out.size() - start;
+    }
+
+  } // namespace codec
+
+} // namespace imxx
+
+
+#endif // DELTA_CODEC_HPP
@@ -0,0 +1,474 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    direct_file.hpp
+ * @ingroup io
+ * @brief   file reader that bypasses the page cache.
+ * @details direct_file reads with O_DIRECT into aligned blocks, keeping up to queue_depth block reads in flight through io_uring,
+ *          and copies the requested bytes out.  reading a multi-hundred-GB input then does not evict the application's memory
+ *          (e.g. the hash table) from the page cache.
+ *
+ *          drop-in for posix_file, including as the FileReader of parallel::partitioned_file.
+ *          falls back to synchronous O_DIRECT reads if io_uring is not available (kernel, headers, or seccomp),
+ *          and to buffered reads if the file system does not support O_DIRECT (e.g. tmpfs).
+ */
+
+#ifndef DIRECT_FILE_HPP_
+#define DIRECT_FILE_HPP_
+
+#include "io/file.hpp"
+
+#include <cstdlib>      // posix_memalign, free
+#include <cstdint>
+#include <memory>       // unique_ptr
+#include <vector>
+#include <algorithm>
+
+#include <sys/uio.h>    // iovec
+#include <sys/syscall.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BLISS_HAVE_IO_URING 1
+#endif
+#endif
+
+
+namespace bliss
+{
+namespace io
+{
+
+namespace detail
+{
+
+#if defined(BLISS_HAVE_IO_URING) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+  /**
+   * @brief  minimal io_uring over the raw syscalls, for batched reads.  single threaded use.
+   * @details  valid() is false if the ring could not be set up, in which case the caller reads synchronously.
+   */
+  class uring {
+    protected:
+      int ring_fd;
+
+      void * sq_ptr;
+      size_t sq_bytes;
+      void * cq_ptr;
+      size_t cq_bytes;
+      struct io_uring_sqe * sqes;
+      size_t sqes_bytes;
+
+      unsigned * sq_tail;
+      unsigned sq_mask;
+      unsigned * sq_array;
+      unsigned sq_entries;
+      unsigned queued;
+
+      unsigned * cq_head;
+      unsigned * cq_tail;
+      unsigned cq_mask;
+      struct io_uring_cqe * cqes;
+
+      void unmap() {
+        if (sqes != nullptr) munmap(sqes, sqes_bytes);
+        if ((cq_ptr != nullptr) && (cq_ptr != sq_ptr)) munmap(cq_ptr, cq_bytes);
+        if (sq_ptr != nullptr) munmap(sq_ptr, sq_bytes);
+        sqes = nullptr;  cq_ptr = nullptr;  sq_ptr = nullptr;
+      }
+
+    public:
+      explicit uring(unsigned const entries) :
+        ring_fd(-1), sq_ptr(nullptr), sq_bytes(0), cq_ptr(nullptr), cq_bytes(0), sqes(nullptr), sqes_bytes(0),
+        sq_tail(nullptr), sq_mask(0), sq_array(nullptr), sq_entries(0), queued(0),
+        cq_head(nullptr), cq_tail(nullptr), cq_mask(0), cqes(nullptr) {
+
+        struct io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        ring_fd = syscall(__NR_io_uring_setup, entries, &p);
+        if (ring_fd < 0) {
+          ring_fd = -1;
+          return;
+        }
+
+        sq_bytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_bytes = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sq_bytes = cq_bytes = ::std::max(sq_bytes, cq_bytes);
+
+        sq_ptr = mmap(nullptr, sq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) { sq_ptr = nullptr;  close(ring_fd);  ring_fd = -1;  return; }
+
+        cq_ptr = single ? sq_ptr :
+            mmap(nullptr, cq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) { cq_ptr = nullptr;  unmap();  close(ring_fd);  ring_fd = -1;  return; }
+
+        sqes_bytes = p.sq_entries * sizeof(struct io_uring_sqe);
+        sqes = reinterpret_cast<struct io_uring_sqe *>(
+            mmap(nullptr, sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) { sqes = nullptr;  unmap();  close(ring_fd);  ring_fd = -1;  return; }
+
+        char * sq = reinterpret_cast<char *>(sq_ptr);
+        sq_tail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+        sq_entries = p.sq_entries;
+
+        char * cq = reinterpret_cast<char *>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe *>(cq + p.cq_off.cqes);
+      }
+
+      ~uring() {
+        unmap();
+        if (ring_fd >= 0) close(ring_fd);
+      }
+
+      uring(uring const & other) = delete;
+      uring& operator=(uring const & other) = delete;
+
+      bool valid() const { return ring_fd >= 0; }
+
+      unsigned capacity() const { return sq_entries; }
+
+      /// queue a read of iov at offset.  not visible to the kernel until submit.
+      void prep_read(int const fd, struct iovec * iov, uint64_t const offset, uint64_t const user_data) {
+        unsigned tail = *sq_tail + queued;
+        unsigned idx = tail & sq_mask;
+
+        struct io_uring_sqe * sqe = sqes + idx;
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(iov);
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = user_data;
+
+        sq_array[idx] = idx;
+        ++queued;
+      }
+
+      /**
+       * @brief publish the queued reads, and wait for at least min_complete completions.
+       * @return 0, or -errno.
+       */
+      int submit_and_wait(unsigned const min_complete) {
+        __atomic_store_n(sq_tail, *sq_tail + queued, __ATOMIC_RELEASE);
+        unsigned to_submit = queued;
+        queued = 0;
+
+        while (true) {
+          int ret = syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0);
+          if (ret >= 0) return 0;
+          if (errno != EINTR) return -errno;
+          to_submit = 0;   // submitted before the interrupt.
+        }
+      }
+
+      /// pop a completion.  false if there is none.
+      bool pop(uint64_t & user_data, int & res) {
+        unsigned head = *cq_head;
+        if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) return false;
+
+        struct io_uring_cqe const & cqe = cqes[head & cq_mask];
+        user_data = cqe.user_data;
+        res = cqe.res;
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+      }
+  };
+#else
+  /// io_uring is not available at compile time.  readers fall back to synchronous reads.
+  class uring {
+    public:
+      explicit uring(unsigned const entries) { BLISS_UNUSED(entries); }
+      bool valid() const { return false; }
+      unsigned capacity() const { return 0; }
+      void prep_read(int const, struct iovec *, uint64_t const, uint64_t const) {}
+      int submit_and_wait(unsigned const) { return -ENOSYS; }
+      bool pop(uint64_t &, int &) { return false; }
+  };
+#endif
+
+  /// free() deleter for posix_memalign buffers.
+  struct aligned_free {
+      void operator()(unsigned char * p) const { free(p); }
+  };
+
+} // namespace detail
+
+
+/**
+ * @brief    file reader with O_DIRECT and io_uring batched reads.  same interface as posix_file.
+ */
+class direct_file : public ::bliss::io::base_file {
+
+protected:
+
+  using BASE = ::bliss::io::base_file;
+
+  /// O_DIRECT descriptor for the same file.  -1 if O_DIRECT is not supported, in which case fd is read instead.
+  int dfd;
+
+  /// offset, length, and buffer alignment for O_DIRECT.  covers both 512 and 4096 byte logical blocks.
+  static constexpr size_t alignment = 4096UL;
+
+  /// bytes per read request.  multiple of alignment.
+  size_t block_bytes;
+
+  /// maximum number of read requests in flight.
+  unsigned queue_depth;
+
+  /// open a second, O_DIRECT, description of the file.  through /proc when constructed from a descriptor.
+  void open_direct() {
+    std::string path = this->filename;
+    if (path.length() == 0) {
+      if (this->fd == -1) return;
+      std::stringstream ss;
+      ss << "/proc/self/fd/" << this->fd;
+      path = ss.str();
+    }
+
+    dfd = open64(path.c_str(), O_RDONLY | O_DIRECT);
+    if (dfd == -1) {
+      int myerr = errno;
+      std::cout << "WARNING: direct_file: O_DIRECT open of [" << path << "] failed with error " << myerr << ": " << strerror(myerr)
+          << ".  using buffered reads." << std::endl;
+    }
+  }
+
+  /// buffered read of [start, end) of the file into out.
+  void read_buffered(unsigned char * out, size_t const start, size_t const end) {
+    size_t s = 0;
+    while (start + s < end) {
+      long count = pread64(this->fd, out + s, std::min(1UL << 30, end - start - s), static_cast<__off64_t>(start + s));
+      if (count < 0) {
+        int myerr = errno;
+        if (myerr == EINTR) continue;
+        std::stringstream ss;
+        ss << "ERROR: direct_file pread64: file " << this->filename << " error " << myerr << ": " << strerror(myerr);
+        throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
+      }
+      if (count == 0) {
+        std::stringstream ss;
+        ss << "ERROR: direct_file pread64: file " << this->filename << " read " << s << " less than range: " << (end - start);
+        throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
+      }
+      s += count;
+    }
+  }
+
+  /**
+   * @brief  copy the part of a block read from the file at [block_start, block_start + got) that falls in target,
+   *          and read any part of the block that a short read missed.
+   */
+  void finish_block(unsigned char const * buf, size_t const block_start, size_t const block_end, size_t const got,
+                    range_type const & target, unsigned char * out) {
+    size_t s = std::max(block_start, target.start);
+    size_t e = std::min(block_start + got, target.end);
+    if (s < e) memcpy(out + (s - target.start), buf + (s - block_start), e - s);
+
+    // short read before the end of the target.  rare:  finish with buffered reads.
+    size_t want = std::min(block_end, target.end);
+    size_t have = std::max(s, std::min(block_start + got, want));
+    if (have < want) read_buffered(out + (have - target.start), have, want);
+  }
+
+public:
+
+  // this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+  using BASE::read_range;
+
+  /**
+   * @brief  bulk load all the data and return it in a newly constructed vector.  reuse vector
+   * @param range_bytes range to read, in bytes
+   * @param output    vector containing data as bytes.
+   * @return  the range for the read data.
+   */
+  virtual range_type read_range(typename ::bliss::io::file_data::container & output, range_type const & range_bytes) {
+    if (this->fd == -1) {
+      throw ::bliss::utils::make_exception<std::logic_error>("ERROR: read_range: file pointer is null");
+    }
+
+    range_type target = BASE::range_type::intersect(this->file_range_bytes, range_bytes);
+
+    if (target.size() == 0) {
+      std::cout << "WARNING: read_range: requested " << range_bytes << " not in file " << this->file_range_bytes << std::endl;
+      output.clear();
+      return target;
+    }
+
+    output.resize(target.size());
+
+    if (dfd == -1) {
+      read_buffered(output.data(), target.start, target.end);
+      return target;
+    }
+
+    // aligned blocks covering the target.  the last may extend past the end of file, and is then short.
+    size_t const start = target.start - (target.start % alignment);
+    size_t const end = ((target.end + alignment - 1) / alignment) * alignment;
+    size_t const nblocks = (end - start + block_bytes - 1) / block_bytes;
+
+    unsigned const slots = static_cast<unsigned>(std::min(static_cast<size_t>(std::max(queue_depth, 1U)), nblocks));
+    unsigned char * raw = nullptr;
+    if (posix_memalign(reinterpret_cast<void **>(&raw), alignment, slots * block_bytes) != 0) {
+      throw ::bliss::utils::make_exception<bliss::io::IOException>("ERROR: direct_file: cannot allocate aligned read buffers.");
+    }
+    std::unique_ptr<unsigned char, ::bliss::io::detail::aligned_free> buffers(raw);
+
+    std::vector<struct iovec> iovs(slots);
+    std::vector<size_t> slot_block(slots);
+    auto block_range = [&](size_t b) {
+      return range_type(start + b * block_bytes, std::min(start + (b + 1) * block_bytes, end));
+    };
+
+    ::bliss::io::detail::uring ring(slots);
+
+    if (!ring.valid() || (ring.capacity() < slots)) {
+      // synchronous O_DIRECT reads, 1 block at a time.
+      for (size_t b = 0; b < nblocks; ++b) {
+        range_type br = block_range(b);
+        long count;
+        do {
+          count = pread64(dfd, raw, br.size(), static_cast<__off64_t>(br.start));
+        } while ((count < 0) && (errno == EINTR));
+        if (count < 0) {
+          int myerr = errno;
+          std::stringstream ss;
+          ss << "ERROR: direct_file pread64: file " << this->filename << " error " << myerr << ": " << strerror(myerr);
+          throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
+        }
+        finish_block(raw, br.start, br.end, count, target, output.data());
+      }
+      return target;
+    }
+
+    // fill all slots, then refill each slot as its read completes.
+    size_t next = 0;
+    unsigned in_flight = 0;
+    int error = 0;
+    for (unsigned i = 0; i < slots; ++i, ++next) {
+      range_type br = block_range(next);
+      iovs[i].iov_base = raw + i * block_bytes;
+      iovs[i].iov_len = br.size();
+      slot_block[i] = next;
+      ring.prep_read(dfd, &(iovs[i]), br.start, i);
+      ++in_flight;
+    }
+
+    while (in_flight > 0) {
+      int ret = ring.submit_and_wait(1);
+      if (ret < 0) {
+        // cannot wait on the ring.  the buffers may still be written, so they must outlive the kernel's use.  give up on the ring.
+        std::stringstream ss;
+        ss << "ERROR: direct_file io_uring_enter: file " << this->filename << " error " << -ret << ": " << strerror(-ret);
+        buffers.release();
+        throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
+      }
+
+      uint64_t slot;
+      int res;
+      while (ring.pop(slot, res)) {
+        --in_flight;
+        range_type br = block_range(slot_block[slot]);
+        if (res < 0) {
+          if (error == 0) error = -res;
+        } else if (error == 0) {
+          finish_block(raw + slot * block_bytes, br.start, br.end, res, target, output.data());
+        }
+
+        // after an error, just drain the in flight reads.
+        if ((error == 0) && (next < nblocks)) {
+          br = block_range(next);
+          iovs[slot].iov_len = br.size();
+          slot_block[slot] = next;
+          ring.prep_read(dfd, &(iovs[slot]), br.start, slot);
+          ++in_flight;
+          ++next;
+        }
+      }
+    }
+
+    if (error != 0) {
+      std::stringstream ss;
+      ss << "ERROR: direct_file read: file " << this->filename << " error " << error << ": " << strerror(error);
+      throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
+    }
+
+    return target;
+  }
+
+  /**
+   * initializes a file for reading
+   * @param _filename   name of file to open
+   */
+  direct_file(std::string const & _filename) : ::bliss::io::base_file(_filename),
+      dfd(-1), block_bytes(4UL << 20), queue_depth(8) {
+    this->open_direct();
+  };
+
+  /**
+   * initializes a file for reading.  for use by a parallel file (composition pattern)
+   * @param _filename   name of file to open
+   * @param _file_size  previously computed file size.
+   */
+  direct_file(std::string const & _filename, size_t const & _file_size, size_t const & delay_ms) :
+    ::bliss::io::base_file(_filename, _file_size, delay_ms),
+      dfd(-1), block_bytes(4UL << 20), queue_depth(8) {
+    this->open_direct();
+  };
+
+  /**
+   * initializes a file for reading.  for use by a parallel file (composition pattern)
+   * @param _fd   previously opened file descriptor
+   * @param _file_size  previously computed file size.
+   */
+  direct_file(int const & _fd, size_t const & _file_size) :
+    ::bliss::io::base_file(_fd, _file_size),
+      dfd(-1), block_bytes(4UL << 20), queue_depth(8) {
+    this->open_direct();
+  };
+
+  /// destructor
+  virtual ~direct_file() {
+    if (dfd >= 0) close(dfd);
+  };
+
+  /// set the read request size, rounded up to the alignment, and the number of requests in flight.
+  void set_queue(size_t const _block_bytes, unsigned const _queue_depth) {
+    block_bytes = std::max(static_cast<size_t>(alignment), ((_block_bytes + alignment - 1) / alignment) * alignment);
+    queue_depth = std::max(_queue_depth, 1U);
+  }
+
+  /// true if reads bypass the page cache.
+  bool is_direct() const {
+    return dfd >= 0;
+  }
+
+  // this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+  using BASE::read_file;
+
+};
+
+} // namespace io
+} // namespace bliss
+
+#endif /* DIRECT_FILE_HPP_ */
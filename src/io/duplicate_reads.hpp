@@ -0,0 +1,219 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    duplicate_reads.hpp
+ * @ingroup io
+ * @brief   distributed removal of exact duplicate reads, before k-mers are generated.
+ * @details PCR and optical duplicates repeat a read base for base, and each copy adds the same k-mers again.
+ *          find_duplicate_reads fingerprints each read of a FASTQ partition with 2 independent 64 bit hashes of its bases,
+ *          and sends (fingerprint, read offset) to the rank that owns the fingerprint.  the owner sorts what it receives,
+ *          keeps the first occurrence in the file, i.e. the smallest offset, and flags the others.  the flags go back in
+ *          send order, so each rank gets the sorted offsets of its reads to drop.  the result does not depend on the number
+ *          of ranks.  a read is identified by the file offset of its sequence, Sequence::seq_global_offset().
+ *
+ *          the exchange is 16 bytes of fingerprint plus 8 of offset per read, and 1 byte back.  fingerprints are exact up
+ *          to a 128 bit hash collision.  a Bloom filter would send less, but its false positives would drop unique reads.
+ *
+ *          with mates, e.g. from paired_file, the 2 fingerprints of a pair are combined, so a pair is dropped only if both
+ *          mates repeat another pair.  only FASTQ reads are deduplicated:  FASTA records can be split across ranks.
+ */
+#ifndef SRC_IO_DUPLICATE_READS_HPP_
+#define SRC_IO_DUPLICATE_READS_HPP_
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <tuple>
+#include <algorithm>   // sort, binary_search
+#include <type_traits> // is_same
+#include <stdexcept>   // invalid_argument
+#include <cstdint>     // uint64_t, uint8_t
+
+#include "io/sequence_iterator.hpp"
+#include "io/fastq_loader.hpp"
+#include "utils/file_utils.hpp"   // NotEOL
+#include "utils/hyperloglog.hpp"  // mix64
+
+#if defined(USE_MPI)
+#include "mxx/comm.hpp"
+#include "mxx/collective.hpp"
+#endif
+
+namespace bliss
+{
+namespace io
+{
+
+  /// read filter for KmerFileHelper::read_block_old_into that keeps every read.
+  struct keep_all_reads {
+      template <typename SEQ>
+      inline bool operator()(SEQ const &) const { return true; }
+  };
+
+  /// read filter that drops the reads at the given offsets, e.g. from find_duplicate_reads.
+  struct drop_reads_at {
+      /// sorted seq_global_offset() of the reads to drop.  not owned.
+      ::std::vector<size_t> const * offsets;
+
+      explicit drop_reads_at(::std::vector<size_t> const & _offsets) : offsets(&_offsets) {}
+
+      template <typename SEQ>
+      inline bool operator()(SEQ const & seq) const {
+        return !::std::binary_search(offsets->begin(), offsets->end(), seq.seq_global_offset());
+      }
+  };
+
+  /// 128 bit fingerprint of the bases of a read.  line breaks are skipped, so a wrapped read has the fingerprint of its bases.
+  template <typename SEQ>
+  ::std::pair<uint64_t, uint64_t> read_fingerprint(SEQ const & seq) {
+    ::bliss::utils::file::NotEOL not_eol;
+    uint64_t h1 = 0xcbf29ce484222325ULL;   // FNV-1a
+    uint64_t h2 = 0x9e3779b97f4a7c15ULL;   // multiply-rotate, with a different constant
+    uint64_t len = 0;
+    for (auto it = seq.seq_begin; it != seq.seq_end; ++it) {
+      if (!not_eol(*it)) continue;
+      uint64_t c = static_cast<uint8_t>(*it);
+      h1 = (h1 ^ c) * 0x100000001b3ULL;
+      h2 = (h2 + c) * 0xff51afd7ed558ccdULL;
+      h2 = (h2 << 31) | (h2 >> 33);
+      ++len;
+    }
+    return ::std::make_pair(::bliss::utils::mix64(h1 ^ len), ::bliss::utils::mix64(h2 + len));
+  }
+
+  /**
+   * @brief  fingerprint and offset of each read that the k-mer parser would take from this partition.
+   * @details  same reads as read_block_old_into:  not empty, and starting before the end of the valid range.
+   */
+  template <template <typename> class SeqParser, typename BlockType>
+  ::std::vector<::std::tuple<uint64_t, uint64_t, uint64_t> >
+  read_fingerprints(BlockType const & partition, SeqParser<typename BlockType::const_iterator> const & seq_parser) {
+    using CharIterType = typename BlockType::const_iterator;
+
+    ::std::vector<::std::tuple<uint64_t, uint64_t, uint64_t> > prints;
+    if (partition.getRange().size() == 0) return prints;
+
+    ::bliss::io::SequencesIterator<CharIterType, SeqParser> seqs_start(seq_parser, partition.cbegin(), partition.in_mem_cend(), partition.getRange().start);
+    ::bliss::io::SequencesIterator<CharIterType, SeqParser> seqs_end(partition.in_mem_cend());
+
+    for (; seqs_start != seqs_end; ++seqs_start) {
+      auto seq = *seqs_start;
+      if (seq.seq_size() == 0) continue;
+      size_t offset = seq.seq_global_offset();
+      if (offset >= partition.valid_range_bytes.end) continue;
+
+      ::std::pair<uint64_t, uint64_t> fp = read_fingerprint(seq);
+      prints.emplace_back(fp.first, fp.second, offset);
+    }
+    return prints;
+  }
+
+#if defined(USE_MPI)
+
+  /**
+   * @brief  offsets of the reads in prints that repeat an earlier read.  collective.  see file description.
+   * @param prints  (fingerprint, fingerprint, offset) of the local reads.  reordered.
+   * @return  sorted offsets of the local reads to drop.
+   */
+  inline ::std::vector<size_t> find_duplicate_prints(::std::vector<::std::tuple<uint64_t, uint64_t, uint64_t> > & prints,
+                                                     const ::mxx::comm & _comm) {
+    using print_type = ::std::tuple<uint64_t, uint64_t, uint64_t>;
+    size_t const p = _comm.size();
+
+    // group by owner rank.
+    ::std::sort(prints.begin(), prints.end(), [p](print_type const & x, print_type const & y) {
+      return (::std::get<0>(x) % p) < (::std::get<0>(y) % p);
+    });
+    ::std::vector<size_t> send_counts(p, 0);
+    for (auto const & x : prints) ++send_counts[::std::get<0>(x) % p];
+
+    ::std::vector<size_t> recv_counts = ::mxx::all2all(send_counts, _comm);
+    ::std::vector<print_type> recv = ::mxx::all2allv(prints, send_counts, _comm);
+
+    // owner:  flag all but the first occurrence of each fingerprint.
+    ::std::vector<size_t> order(recv.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    ::std::sort(order.begin(), order.end(), [&recv](size_t const x, size_t const y) {
+      return recv[x] < recv[y];
+    });
+    ::std::vector<uint8_t> dup(recv.size(), 0);
+    for (size_t i = 1; i < order.size(); ++i) {
+      print_type const & x = recv[order[i - 1]];
+      print_type const & y = recv[order[i]];
+      if ((::std::get<0>(x) == ::std::get<0>(y)) && (::std::get<1>(x) == ::std::get<1>(y))) dup[order[i]] = 1;
+    }
+    ::std::vector<print_type>().swap(recv);
+
+    // flags return in the order sent.
+    ::std::vector<uint8_t> flags = ::mxx::all2allv(dup, recv_counts, _comm);
+
+    ::std::vector<size_t> drop;
+    for (size_t i = 0; i < prints.size(); ++i) {
+      if (flags[i]) drop.emplace_back(::std::get<2>(prints[i]));
+    }
+    ::std::sort(drop.begin(), drop.end());
+    return drop;
+  }
+
+  /**
+   * @brief  offsets of the reads of a partition that repeat an earlier read in the file.  collective.
+   * @return  sorted seq_global_offset() of the local reads to drop, for drop_reads_at.  empty for FASTA.
+   */
+  template <template <typename> class SeqParser, typename BlockType>
+  ::std::vector<size_t> find_duplicate_reads(BlockType const & partition,
+                                             SeqParser<typename BlockType::const_iterator> const & seq_parser,
+                                             const ::mxx::comm & _comm) {
+    using CharIterType = typename BlockType::const_iterator;
+    if (!::std::is_same<SeqParser<CharIterType>, ::bliss::io::FASTQParser<CharIterType> >::value) return ::std::vector<size_t>();
+
+    ::std::vector<::std::tuple<uint64_t, uint64_t, uint64_t> > prints = read_fingerprints<SeqParser>(partition, seq_parser);
+    return find_duplicate_prints(prints, _comm);
+  }
+
+  /**
+   * @brief  offsets of the read pairs that repeat an earlier pair, with the mates of partition in mates, e.g. R1 and R2 from
+   *         paired_file.  collective.
+   * @return  sorted seq_global_offset() of the local R1 reads to drop.  the i-th R2 read goes with the i-th R1 read.
+   */
+  template <template <typename> class SeqParser, typename BlockType>
+  ::std::vector<size_t> find_duplicate_pairs(BlockType const & partition,
+                                             SeqParser<typename BlockType::const_iterator> const & seq_parser,
+                                             BlockType const & mates,
+                                             SeqParser<typename BlockType::const_iterator> const & mate_parser,
+                                             const ::mxx::comm & _comm) {
+    using CharIterType = typename BlockType::const_iterator;
+    static_assert(::std::is_same<SeqParser<CharIterType>, ::bliss::io::FASTQParser<CharIterType> >::value,
+                  "read pairs are FASTQ.");
+
+    ::std::vector<::std::tuple<uint64_t, uint64_t, uint64_t> > prints = read_fingerprints<SeqParser>(partition, seq_parser);
+    ::std::vector<::std::tuple<uint64_t, uint64_t, uint64_t> > mate_prints = read_fingerprints<SeqParser>(mates, mate_parser);
+    if (prints.size() != mate_prints.size()) throw ::std::invalid_argument("R1 and R2 partitions have different read counts.");
+
+    // order matters within a pair:  (a, b) is not (b, a).
+    for (size_t i = 0; i < prints.size(); ++i) {
+      ::std::get<0>(prints[i]) = ::bliss::utils::mix64(::std::get<0>(prints[i]) + 0x9e3779b97f4a7c15ULL * ::std::get<0>(mate_prints[i]));
+      ::std::get<1>(prints[i]) ^= ::bliss::utils::mix64(::std::get<1>(mate_prints[i]));
+    }
+    return find_duplicate_prints(prints, _comm);
+  }
+
+#endif
+
+} /* namespace io */
+} /* namespace bliss */
+
+#endif /* SRC_IO_DUPLICATE_READS_HPP_ */
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    eol_search.hpp
+ * @ingroup io
+ * @brief   search a contiguous character array for the first end of line ('\n' or '\r'), or for the first of (or first
+ *          not of) any 2 characters, e.g. the ends of the N runs that split a read.
+ * @details the file parsers spend most of their record boundary search and record iteration time in the
+ *          per-character EOL scan.  here 32 (AVX2) or 16 (SSE2) characters are compared to '\n' and '\r' at once,
+ *          the comparison is turned into a bit mask with movemask, and the position of the first set bit is the
+ *          EOL position.  the remainder is scanned one character at a time.  find_neither inverts the mask.
+ *
+ *          also has a trait to identify the iterators (pointers and std::vector iterators of char) for which
+ *          the data is contiguous, so that BaseFileParser can use the array version.
+ */
+#ifndef SRC_IO_EOL_SEARCH_HPP_
+#define SRC_IO_EOL_SEARCH_HPP_
+
+#include <cstddef>       // size_t
+#include <vector>
+#include <type_traits>
+
+#include "bliss-config.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <x86intrin.h>   // all intrinsics.  will be enabled based on compiler flag such as __SSE2__ internally.
+#endif
+
+#if defined __GNUC__ && __GNUC__>=6
+// disable __m128i and __m256i ignored attribute warning in gcc
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
+namespace bliss
+{
+  namespace io
+  {
+
+    /// true if IT is a pointer or a std::vector iterator to char or unsigned char, i.e. the data is contiguous.
+    template <typename IT>
+    struct is_contiguous_char_iterator {
+        using V = typename ::std::remove_cv<typename ::std::iterator_traits<IT>::value_type>::type;
+        static constexpr bool value =
+            (::std::is_same<V, char>::value || ::std::is_same<V, unsigned char>::value) &&
+            (::std::is_pointer<IT>::value ||
+             ::std::is_same<IT, typename ::std::vector<V>::iterator>::value ||
+             ::std::is_same<IT, typename ::std::vector<V>::const_iterator>::value);
+    };
+
+
+    /**
+     * @brief  find the first occurrence of a or b (match = true), or the first character that is neither (match = false).
+     * @param in     start of the array
+     * @param count  number of characters in the array
+     * @return       position of the first such character, or count if there is none.
+     */
+    template <bool match>
+    inline size_t find_pair(unsigned char const * in, size_t const & count, unsigned char const a, unsigned char const b) {
+      size_t i = 0;
+
+#if defined(__AVX2__)
+      {
+        __m256i const va = _mm256_set1_epi8(static_cast<char>(a));
+        __m256i const vb = _mm256_set1_epi8(static_cast<char>(b));
+        __m256i v;
+        unsigned int mask;
+        for (; (i + 32) <= count; i += 32) {
+          v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i));
+          mask = static_cast<unsigned int>(_mm256_movemask_epi8(
+              _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb))));
+          if (!match) mask = ~mask;
+          if (mask != 0) return i + __builtin_ctz(mask);
+        }
+      }
+#endif
+#if defined(__SSE2__)
+      {
+        __m128i const va = _mm_set1_epi8(static_cast<char>(a));
+        __m128i const vb = _mm_set1_epi8(static_cast<char>(b));
+        __m128i v;
+        unsigned int mask;
+        for (; (i + 16) <= count; i += 16) {
+          v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i));
+          mask = static_cast<unsigned int>(_mm_movemask_epi8(
+              _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb))));
+          if (!match) mask = ~mask & 0xFFFF;
+          if (mask != 0) return i + __builtin_ctz(mask);
+        }
+      }
+#endif
+      // remainder
+      for (; i < count; ++i) {
+        if (((in[i] == a) || (in[i] == b)) == match) return i;
+      }
+      return count;
+    }
+
+    /// position of the first a or b in a character array, or count if there is none.
+    inline size_t find_either(unsigned char const * in, size_t const & count, unsigned char const a, unsigned char const b) {
+      return find_pair<true>(in, count, a, b);
+    }
+
+    /// position of the first character that is neither a nor b, or count if there is none.
+    inline size_t find_neither(unsigned char const * in, size_t const & count, unsigned char const a, unsigned char const b) {
+      return find_pair<false>(in, count, a, b);
+    }
+
+    /**
+     * @brief  find the first '\n' or '\r' in a character array.
+     * @param in     start of the array
+     * @param count  number of characters in the array
+     * @return       position of the first EOL character, or count if there is none.
+     */
+    inline size_t find_eol(unsigned char const * in, size_t const & count) {
+      return find_pair<true>(in, count, '\n', '\r');
+    }
+
+  } // namespace io
+} // namespace bliss
+
+#if defined __GNUC__ && __GNUC__>=6
+  #pragma GCC diagnostic pop
+#endif
+
+#endif /* SRC_IO_EOL_SEARCH_HPP_ */
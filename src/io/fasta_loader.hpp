@@ -76,6 +76,11 @@ namespace bliss
      *    Also, this parser needs to store global information for entire file, so is only compatible with block partitioner for L1.
      *    L1 partitioner's result needs to be stored.
      *
+     *    ranks are cut at arbitrary bytes, not at record boundaries, so a long record (chromosome, PacBio/ONT read) is split
+     *    across all the ranks it covers.  init_parser spreads the header position to the ranks that have no header, and each
+     *    rank's partition is extended by k-1 non-EOL characters, so a rank parses the k-mers that start in its partition
+     *    with positions in file coordinates.
+     *
      * @tparam Iterator   The underlying iterator to be traversed to generate a Sequence
      */
     template <typename Iterator>
@@ -48,6 +48,13 @@
 #include <fcntl.h>      // for open64 and close
 #include <sstream>      // stringstream
 #include <exception>    // std exception
+#include <limits>       // numeric_limits
+#include <cstdlib>      // getenv, strtoul
+#include <algorithm>    // sort, upper_bound
+#include <vector>
+#include <thread>       // prefault threads
+#include <atomic>
+#include <memory>       // shared_ptr
 
 #if defined(USE_MPI)
 #include <mpi.h>
@@ -62,6 +69,7 @@
 #include <io/file_loader.hpp>
 #include <io/fastq_loader.hpp>
 #include <io/fasta_loader.hpp>
+#include <io/record_index.hpp>
 #include <io/unix_domain_socket.h>
 #include <partition/range.hpp>
 
@@ -138,8 +146,12 @@
 //
 
 // DONE:  open/lseek/read instead of fopen/fseek/fread
+// DONE:  readahead.  posix_file and mmap_file read in readahead_bytes windows, and posix_fadvise(WILLNEED) the next window
+//        before waiting on the current one, so storage latency (e.g. lustre) overlaps with the copy.  prefetch() exposes the same hint.
 // DONE:  refactored mmap_file with a mapped_data object
 // DONE:  remove 1 extra mmap from FASTQParser partitioned_file
+// DONE:  FASTQ record index sidecar (record_index.hpp).  partitions align to sampled record starts, without boundary search.
+// DONE:  FASTQ partitions balanced by estimated k-mers, from the character counts in the record index (BL_PARTITION_BY_KMERS).
 // TODO:  move file open/close to closer to actual reading
 //          close right after map, before unmap
 // DONE:  copy file descriptor to processes - only 1 on each node opens.
@@ -222,6 +234,15 @@ struct file_data {
 
 
 
+/**
+ * @brief how mapped_data faults in its pages.
+ * @details none:      the reader takes the page faults, 1 at a time.
+ *          populate:  MAP_POPULATE.  mmap returns after the whole range is faulted in.
+ *          threads:   helper threads touch the pages from the start of the range, ahead of the reader, while mmap
+ *                     returns immediately.  the reader stalls only if it catches up with the helpers.
+ */
+enum class prefault_mode { none, populate, threads };
+
 /**
  * mmapped data.  wrapper for moving it around.
  */
@@ -238,6 +259,37 @@ class mapped_data {
 
     const size_t page_size;
 
+    /// threads touching the pages, for prefault_mode::threads
+    std::vector<std::thread> touchers;
+
+    /// tells the touchers to stop early.  shared so it stays put when this object is moved.
+    std::shared_ptr<std::atomic<bool> > stop_touch;
+
+    /// touch 1 byte per page of every nthreads-th 2MB chunk, from chunk id, so the threads move through the range together.
+    static void touch_pages(unsigned char const * data, size_t const bytes, size_t const page_size,
+                            size_t const id, size_t const nthreads, std::atomic<bool> const * stop) {
+      constexpr size_t chunk = 2UL << 20;
+      unsigned char sum = 0;
+      for (size_t c = id * chunk; c < bytes; c += nthreads * chunk) {
+        if (stop->load(std::memory_order_relaxed)) break;
+        size_t const end = std::min(bytes, c + chunk);
+        for (size_t i = c; i < end; i += page_size) sum += *(static_cast<unsigned char const volatile *>(data + i));
+      }
+      (void)sum;
+    }
+
+    /// stop the touchers and unmap.
+    void unmap() {
+      if (stop_touch) stop_touch->store(true);
+      wait_prefault();
+
+      if ((data != nullptr) && (range_bytes.size() > 0)) {
+        munmap(data, range_bytes.size());
+      }
+      data = nullptr;
+      range_bytes.start = range_bytes.end;
+    }
+
   public:
 
 
@@ -245,8 +297,11 @@ class mapped_data {
      * @brief   map the specified portion of the file to memory.
      * @note    AGNOSTIC of overlaps
      * @param range_bytes    range specifying the portion of the file to map.
+     * @param prefault       how to fault in the pages.  see prefault_mode
+     * @param nthreads       number of helper threads for prefault_mode::threads.
      */
-    mapped_data(int const & _fd, range_type const & target) :
+    mapped_data(int const & _fd, range_type const & target,
+                prefault_mode const prefault = prefault_mode::none, size_t const nthreads = 2) :
       data(nullptr), range_bytes(0, 0),
       page_size(sysconf(_SC_PAGE_SIZE))
     {
@@ -267,13 +322,13 @@ class mapped_data {
       range_bytes.start = range_type::align_to_page(target, page_size);
       range_bytes.end = target.end;  // okay for end not to align - made 0.
 
-      // NOT using MAP_POPULATE. (SLOW)  no need to prefault the entire range - use read ahead from madvice.
+      // NOT using MAP_POPULATE unless asked for, see prefault_mode. (SLOW)  no need to prefault the entire range - use read ahead from madvice.
       // NOTE HUGETLB not supported for file mapping, only anonymous.  also, kernel has to enable it and system has to have it reserved,
       // MAP_SHARED so that we don't have CoW (no private instance) (potential sharing between processes?)  slightly slower by 1%?
       // MAP_NORESERVE so that swap is not allocated.
       data = (unsigned char*)mmap64(nullptr, range_bytes.size(),
                                    PROT_READ,
-                                   MAP_SHARED | MAP_NORESERVE, _fd,
+                                   MAP_SHARED | MAP_NORESERVE | ((prefault == prefault_mode::populate) ? MAP_POPULATE : 0), _fd,
                                    range_bytes.start);
 
       // if mmap failed,
@@ -298,16 +353,19 @@ class mapped_data {
       }
       // for testing
       //std::cout << "serial fd=" << _fd << " mapped region = " << range_bytes << " pointer is " << (const void*)data << ::std::endl;
+
+      if ((prefault == prefault_mode::threads) && (nthreads > 0)) {
+        stop_touch = std::make_shared<std::atomic<bool> >(false);
+        touchers.reserve(nthreads);
+        for (size_t i = 0; i < nthreads; ++i) {
+          touchers.emplace_back(touch_pages, data, range_bytes.size(), page_size, i, nthreads, stop_touch.get());
+        }
+      }
     }
 
     ~mapped_data() {
       // unmap it.
-      if ((data != nullptr) && (range_bytes.size() > 0)) {
-        munmap(data, range_bytes.size());
-
-        data = nullptr;
-        range_bytes.start = range_bytes.end;
-      }
+      unmap();
     }
 
     // copy constructor and assignment operators are deleted.
@@ -315,23 +373,33 @@ class mapped_data {
     mapped_data& operator=(mapped_data const & other) = delete;
 
     mapped_data(mapped_data && other) :
-      data(other.data), range_bytes(other.range_bytes), page_size(other.page_size) {
+      data(other.data), range_bytes(other.range_bytes), page_size(other.page_size),
+      touchers(std::move(other.touchers)), stop_touch(std::move(other.stop_touch)) {
 
       other.data = nullptr;
       other.range_bytes.start = other.range_bytes.end;
     }
     mapped_data& operator=(mapped_data && other) {
       // first unmap
-      if ((data != nullptr) && (range_bytes.size() > 0))
-        munmap(data, range_bytes.size());
+      unmap();
 
       // then move other to here.
       data = other.data;      other.data = nullptr;
       range_bytes = other.range_bytes;   other.range_bytes.start = other.range_bytes.end;
+      touchers = std::move(other.touchers);
+      stop_touch = std::move(other.stop_touch);
 
       return *this;
     }
 
+    /// wait for the prefault threads to finish.  the whole range is then in memory.
+    void wait_prefault() {
+      for (auto & t : touchers) {
+        if (t.joinable()) t.join();
+      }
+      touchers.clear();
+    }
+
 
 
     /// accessor for mapped data
@@ -383,6 +451,9 @@ protected:
 	/// size of file in bytes
 	range_type file_range_bytes;
 
+	/// read_range reads in windows of this many bytes, and asks for the next window while the current one is read.  0 reads in 1 step.
+	size_t readahead_bytes;
+
 	/// virtual function for computing the size of a file.
 	size_t get_file_size() {
 
@@ -451,7 +522,7 @@ protected:
    * @param _file_size  size of file, previously obtained.
    */
   base_file(std::string const & _filename, size_t const & _file_size, size_t const & delay_ms = 0) :
-    filename(_filename), fd(-1), file_range_bytes(0, _file_size) {
+    filename(_filename), fd(-1), file_range_bytes(0, _file_size), readahead_bytes(64UL << 20) {
 
     if (delay_ms > 0) usleep(delay_ms * 1000UL);
 
@@ -464,7 +535,7 @@ protected:
    * @param _file_size  size of file, previously obtained.
    */
   base_file(int const & _fd, size_t const & _file_size) :
-    filename(::std::string()), fd(dup(_fd)), file_range_bytes(0, _file_size) {};
+    filename(::std::string()), fd(dup(_fd)), file_range_bytes(0, _file_size), readahead_bytes(64UL << 20) {};
 
 public:
 
@@ -500,7 +571,7 @@ public:
 	 * @param _filename 	name of file to open
 	 */
 	base_file(std::string const & _filename) :
-		filename(_filename), fd(-1), file_range_bytes(0, 0) {
+		filename(_filename), fd(-1), file_range_bytes(0, 0), readahead_bytes(64UL << 20) {
 		this->file_range_bytes.end = this->get_file_size();
 	  this->open_file();
 	};
@@ -542,6 +613,25 @@ public:
 
 	/// get file name
 	::std::string const & get_filename() const { return filename; };
+
+	/**
+	 * @brief  start reading a range into the page cache without waiting for it, e.g. the next block while the current one is parsed.
+	 * @note   a hint only.  errors are ignored.
+	 */
+	void prefetch(range_type const & range_bytes) const {
+		range_type target = range_type::intersect(range_bytes, file_range_bytes);
+		if ((this->fd == -1) || (target.size() == 0)) return;
+
+		posix_fadvise64(this->fd, target.start, target.size(), POSIX_FADV_WILLNEED);
+	}
+
+	/// set the read_range window size.  0 disables readahead.  virtual so that composite files can pass it to their reader.
+	virtual void set_readahead_bytes(size_t const bytes) {
+		readahead_bytes = bytes;
+	}
+	size_t get_readahead_bytes() const {
+		return readahead_bytes;
+	}
 };
 
 
@@ -556,6 +646,24 @@ protected:
 	/// BASE type
 	using BASE = ::bliss::io::base_file;
 
+	/// how the mapped pages are faulted in
+	prefault_mode prefault;
+
+	/// helper threads for prefault_mode::threads
+	size_t prefault_threads;
+
+	static prefault_mode prefault_from_env() {
+		char const * v = ::std::getenv("BL_MMAP_PREFAULT");
+		if (v == nullptr) return prefault_mode::none;
+		if (strcmp(v, "populate") == 0) return prefault_mode::populate;
+		if (strcmp(v, "threads") == 0) return prefault_mode::threads;
+		return prefault_mode::none;
+	}
+	static size_t prefault_threads_from_env() {
+		char const * v = ::std::getenv("BL_MMAP_PREFAULT_THREADS");
+		return (v == nullptr) ? 2UL : ::std::strtoul(v, nullptr, 10);
+	}
+
 public:
 
 	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
@@ -577,7 +685,7 @@ public:
 	  }
 
 		// map
-		mapped_data md(this->fd, file_range);
+		mapped_data md(this->fd, file_range, prefault, prefault_threads);
 
 		//
 		unsigned char * md_data = md.get_data();
@@ -605,7 +713,16 @@ public:
 		if (output.capacity() < target.size()) output.resize(target.size());
 
 		// copy the data into memory.  vector is contiguous, so this is okay.
-		memmove(output.data(), md_data + (target.start - mapped_range.start), target.size());
+		// one window at a time, so that the next window is read from disk while the current one is faulted in and copied.
+		unsigned char const * src = md_data + (target.start - mapped_range.start);
+		size_t const window = (this->readahead_bytes == 0) ? target.size() : this->readahead_bytes;
+		for (size_t s = 0; s < target.size(); s += window) {
+			size_t const len = std::min(window, target.size() - s);
+			if (s + len < target.size())
+				this->prefetch(typename BASE::range_type(target.start + s + len, target.start + s + 2 * len));
+
+			memmove(output.data() + s, src + s, len);
+		}
 
 		return target;
 
@@ -613,7 +730,19 @@ public:
 	}
 
 	inline mapped_data map(typename BASE::range_type const & range_bytes) {
-	  return mapped_data(this->fd, BASE::range_type::intersect(range_bytes, this->file_range_bytes));
+	  return mapped_data(this->fd, BASE::range_type::intersect(range_bytes, this->file_range_bytes), prefault, prefault_threads);
+	}
+
+	/**
+	 * @brief  fault in mapped pages ahead of the reader.  see prefault_mode.
+	 * @note   default from BL_MMAP_PREFAULT (none, populate, or threads) and BL_MMAP_PREFAULT_THREADS (default 2).
+	 */
+	void set_prefault(prefault_mode const mode, size_t const nthreads = 2) {
+		prefault = mode;
+		prefault_threads = nthreads;
+	}
+	prefault_mode get_prefault() const {
+		return prefault;
 	}
 
 	/**
@@ -621,7 +750,7 @@ public:
 	 * @param _filename 	name of file to open
 	 */
 	mmap_file(std::string const & _filename) :
-		::bliss::io::base_file(_filename) {
+		::bliss::io::base_file(_filename), prefault(prefault_from_env()), prefault_threads(prefault_threads_from_env()) {
 
 //    // for testing:  multiple processes on the same node maps to the same ptr address
 //    map(this->file_range_bytes);
@@ -635,7 +764,7 @@ public:
    * @param _file_size  previously determined file size.
    */
   mmap_file(std::string const & _filename, size_t const & _file_size, size_t const & delay_ms = 0) :
-    ::bliss::io::base_file(_filename, _file_size, delay_ms) {}
+    ::bliss::io::base_file(_filename, _file_size, delay_ms), prefault(prefault_from_env()), prefault_threads(prefault_threads_from_env()) {}
 
   /**
    * initializes a file for reading/writing via memmap.  for use by parallel file (composition)
@@ -643,7 +772,7 @@ public:
    * @param _file_size  previously determined file size.
    */
   mmap_file(int const & _fd, size_t const & _file_size) :
-    ::bliss::io::base_file(_fd, _file_size) {}
+    ::bliss::io::base_file(_fd, _file_size), prefault(prefault_from_env()), prefault_threads(prefault_threads_from_env()) {}
 
 	/// default destructor
 	virtual ~mmap_file() {
@@ -852,9 +981,17 @@ public:
     size_t s = 0;
     long count;
 
-    //pread64 can only read 2GB at a time
+    // sequential access doubles the kernel's readahead window.  a hint, so errors are ignored.
+    posix_fadvise64(this->fd, target.start, target.size(), POSIX_FADV_SEQUENTIAL);
+
+    //pread64 can only read 2GB at a time.  read a window at a time, and ask for the next window before waiting on the current one.
+    size_t const window = ((this->readahead_bytes == 0) || (this->readahead_bytes > (1UL << 30))) ? (1UL << 30) : this->readahead_bytes;
     for (; s < target.size(); ) {
-     	count = pread64(this->fd, output.data() + s, std::min(1UL << 30, target.size() - s ),
+        size_t const len = std::min(window, target.size() - s);
+        if (s + len < target.size())
+          this->prefetch(range_type(target.start + s + len, target.start + s + 2 * len));
+
+     	count = pread64(this->fd, output.data() + s, len,
     			static_cast<__off64_t>(target.start + s));
 
         if (count < 0) {
@@ -864,6 +1001,7 @@ public:
 
           throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
         }
+        if (count == 0) break;  // end of file.  reported below.
 
     	s += count;
     }
@@ -930,6 +1068,56 @@ protected:
 	/// communicator used.  object instead of being a reference - lifetime of a src comm temp object in constructor is just that of the constructor call.
 	const ::mxx::comm comm;
 
+	/// get the overlap from the next process instead of reading it.  see set_overlap_exchange.
+	bool overlap_exchange;
+
+	/// BL_OVERLAP_EXCHANGE=1 turns on overlap exchange by default.
+	static bool overlap_exchange_from_env() {
+		char const * v = ::std::getenv("BL_OVERLAP_EXCHANGE");
+		return (v != nullptr) && (::std::strtoul(v, nullptr, 10) != 0);
+	}
+
+	/**
+	 * @brief  true if every process can get `bytes` of overlap from the next process' partition alone.  collective.
+	 * @details a partition shorter than `bytes` is fine only if it ends the file, else the overlap spans 2 processes.
+	 */
+	bool can_exchange_overlap(range_type const & partition, size_t const bytes) {
+		int ok = ((partition.size() >= bytes) || (partition.end >= this->file_range_bytes.end)) ? 1 : 0;
+		ok = ::mxx::allreduce(ok, [](int const & x, int const & y) {
+			return (x < y) ? x : y;
+		}, this->comm);
+		return ok == 1;
+	}
+
+	/**
+	 * @brief  append the first `bytes` bytes of the next process' partition to output.  collective.
+	 * @details each process sends the head of its partition to the previous process in 1 MPI_Sendrecv, so the file
+	 *          is read exactly once, instead of each process reading the overlap again.  the last process gets nothing.
+	 *          output should hold exactly this process' partition.  check can_exchange_overlap first.
+	 * @return  number of bytes appended.
+	 */
+	size_t append_next_overlap(typename ::bliss::io::file_data::container & output, size_t const bytes) {
+		if (comm.size() == 1) return 0;
+
+		int prev = (comm.rank() == 0) ? MPI_PROC_NULL : comm.rank() - 1;
+		int next = (comm.rank() == comm.size() - 1) ? MPI_PROC_NULL : comm.rank() + 1;
+
+		size_t old_size = output.size();
+		int send_count = static_cast<int>(::std::min(old_size, bytes));
+		output.resize(old_size + bytes);
+
+		MPI_Status status;
+		MPI_Sendrecv(output.data(), send_count, MPI_BYTE, prev, 0,
+				output.data() + old_size, static_cast<int>(bytes), MPI_BYTE, next, 0, comm, &status);
+
+		int received = 0;
+		MPI_Get_count(&status, MPI_BYTE, &received);
+		if (next == MPI_PROC_NULL) received = 0;
+		output.resize(old_size + received);
+
+		return received;
+	}
+
 		/// compute file size in parallel (1 proc, then broadcast.
 	size_t get_file_size() {
 
@@ -949,7 +1137,7 @@ protected:
 
   base_file(::mxx::comm const & _comm = ::mxx::comm()) :
     ::bliss::io::base_file(static_cast<int>(-1), static_cast<size_t>(0)), // will find real size very soon
-     comm(_comm.copy()) {  // _comm could be a temporary constructed from MPI_Comm.
+     comm(_comm.copy()), overlap_exchange(overlap_exchange_from_env()) {  // _comm could be a temporary constructed from MPI_Comm.
   };
 
 
@@ -969,7 +1157,7 @@ public:
 	 */
 	base_file(std::string const & _filename, ::mxx::comm const & _comm = ::mxx::comm()) :
 		::bliss::io::base_file(static_cast<int>(-1), static_cast<size_t>(0)), // will find real size very soon
-		 comm(_comm.copy()) {  // _comm could be a temporary constructed from MPI_Comm.  std::move not needed.  copy elision is in effect.
+		 comm(_comm.copy()), overlap_exchange(overlap_exchange_from_env()) {  // _comm could be a temporary constructed from MPI_Comm.  std::move not needed.  copy elision is in effect.
 	  this->filename = _filename;
 		this->file_range_bytes.end = this->get_file_size();
 		this->BASE::open_file();
@@ -983,6 +1171,29 @@ public:
 	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
 	using BASE::read_file;
 
+	/**
+	 * @brief  read only this process' partition, and get the overlap from the next process with 1 MPI_Sendrecv,
+	 *         so each byte of the file is read once.  set the same on all processes.
+	 * @note   falls back to reading the overlap when a partition is shorter than the overlap.  no effect on FASTQ,
+	 *         which reads no overlap.
+	 */
+	void set_overlap_exchange(bool const exchange) {
+		overlap_exchange = exchange;
+	}
+	bool get_overlap_exchange() const {
+		return overlap_exchange;
+	}
+
+	/**
+	 * @brief  read this process' partition with the reader of a partitioned_file.
+	 * @note   a BaseType can hide this to read differently, e.g. base_node_shared_file.  called by all processes.
+	 */
+	template <typename Reader>
+	range_type read_partition(Reader & reader, typename ::bliss::io::file_data::container & output,
+	                          range_type const & range_bytes) {
+		return reader.read_range(output, range_bytes);
+	}
+
 };
 
 
@@ -1060,6 +1271,152 @@ public:
 
 
 
+/**
+ * @brief  1 process per node opens and reads the file.  the other processes on the node get their partitions through
+ *         an MPI-3 shared memory window.
+ * @details  the partitions of a node's processes are merged into contiguous runs, 1 for consecutive ranks, and local rank 0
+ *           reads each run with large preads into the window.  a parallel filesystem then sees 1 open and a few large reads
+ *           per node instead of per process.  each process copies its partition out of the window into its file_data,
+ *           since file_data owns its bytes, and the window is freed.
+ *           use as the BaseType of partitioned_file.  the FileReader is not used.
+ *           peak memory on a node is twice the node's data, until the window is freed.
+ */
+class base_node_shared_file : public ::bliss::io::parallel::base_file {
+protected:
+  using BASE = ::bliss::io::parallel::base_file;
+
+  using range_type = typename BASE::range_type;
+
+  /// processes on the same node.
+  ::mxx::comm shared;
+
+  /// only local rank 0 opens the file.
+  void open_file() {
+    if (shared.rank() == 0) this->::bliss::io::base_file::open_file();
+  }
+
+  /// read range_bytes to dest with pread.  throws IOException if short.
+  void pread_range(unsigned char * dest, range_type const & range_bytes) {
+    posix_fadvise64(this->fd, range_bytes.start, range_bytes.size(), POSIX_FADV_SEQUENTIAL);
+
+    // pread64 reads up to 2GB at a time.
+    size_t s = 0;
+    while (s < range_bytes.size()) {
+      long count = pread64(this->fd, dest + s, std::min(range_bytes.size() - s, 1UL << 30),
+                           static_cast<__off64_t>(range_bytes.start + s));
+      if (count < 0) {
+        std::stringstream ss;
+        int myerr = errno;
+        ss << "ERROR: pread64: file " << this->filename << " error " << myerr << ": " << strerror(myerr);
+        throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
+      }
+      if (count == 0) break;
+      s += count;
+    }
+    if (s != range_bytes.size()) {
+      std::stringstream ss;
+      ss << "ERROR: pread64: file " << this->filename << " read " << s << " less than range: " << range_bytes.size();
+      throw ::bliss::utils::make_exception<bliss::io::IOException>(ss.str());
+    }
+  }
+
+public:
+
+  // this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+  using BASE::read_range;
+
+  /**
+   * @brief constructor.  collective.
+   * @param _filename     name of file to open
+   * @param _comm       MPI communicator to use.
+   */
+  base_node_shared_file(std::string const & _filename, ::mxx::comm const & _comm = ::mxx::comm()) :
+    ::bliss::io::parallel::base_file(_comm), shared(this->comm.split_shared()) {
+    this->filename = _filename;
+    this->file_range_bytes.end = this->BASE::get_file_size();
+    this->open_file();
+  };
+
+  /// destructor
+  virtual ~base_node_shared_file() {
+    this->close_file();
+  };
+
+  // this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+  using BASE::read_file;
+
+  /**
+   * @brief  read this process' partition through the node's shared memory window.  collective over the node.
+   * @param output      this process' bytes.
+   * @return the range read.
+   */
+  template <typename Reader>
+  range_type read_partition(Reader &, typename ::bliss::io::file_data::container & output,
+                            range_type const & range_bytes) {
+    range_type target = range_type::intersect(range_bytes, this->file_range_bytes);
+
+    // the node's partitions, merged into runs.
+    std::vector<size_t> starts = ::mxx::allgather(target.start, shared);
+    std::vector<size_t> ends = ::mxx::allgather(target.end, shared);
+
+    std::vector<int> order(shared.size());
+    for (int i = 0; i < shared.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&starts](int const & x, int const & y){ return starts[x] < starts[y]; });
+
+    std::vector<range_type> runs;
+    for (int i : order) {
+      if (ends[i] <= starts[i]) continue;
+      if (!runs.empty() && (starts[i] <= runs.back().end)) runs.back().end = std::max(runs.back().end, ends[i]);
+      else runs.emplace_back(starts[i], ends[i]);
+    }
+    std::vector<size_t> offsets(runs.size() + 1, 0);
+    for (size_t i = 0; i < runs.size(); ++i) offsets[i + 1] = offsets[i] + runs[i].size();
+
+    // the window is all on local rank 0.
+    MPI_Win win;
+    unsigned char * base = nullptr;
+    MPI_Win_allocate_shared(static_cast<MPI_Aint>(shared.rank() == 0 ? offsets.back() : 0), 1, MPI_INFO_NULL, shared, &base, &win);
+
+    // read.  report errors to the whole node, so no process waits forever.
+    std::string error;
+    if (shared.rank() == 0) {
+      try {
+        for (size_t i = 0; i < runs.size(); ++i) pread_range(base + offsets[i], runs[i]);
+      } catch (std::exception & e) {
+        error = e.what();
+      }
+    }
+    MPI_Win_fence(0, win);
+
+    int failed = error.empty() ? 0 : 1;
+    MPI_Bcast(&failed, 1, MPI_INT, 0, shared);
+    if (failed) {
+      MPI_Win_free(&win);
+      throw ::bliss::utils::make_exception<bliss::io::IOException>(error.empty() ? "ERROR: node shared read failed on local rank 0" : error);
+    }
+
+    // copy out this process' part.
+    if (shared.rank() != 0) {
+      MPI_Aint bytes;
+      int disp_unit;
+      MPI_Win_shared_query(win, 0, &bytes, &disp_unit, &base);
+    }
+    output.clear();
+    if (target.size() > 0) {
+      size_t r = std::upper_bound(runs.begin(), runs.end(), target.start,
+                                  [](size_t const & x, range_type const & y){ return x < y.start; }) - runs.begin() - 1;
+      unsigned char const * src = base + offsets[r] + (target.start - runs[r].start);
+      output.assign(src, src + target.size());
+    }
+
+    MPI_Win_free(&win);
+
+    return target;
+  }
+
+};
+
+
 template <typename FileReader,
           template <typename> class FileParser = ::bliss::io::BaseFileParser,
           typename BaseType = ::bliss::io::parallel::base_file >
@@ -1161,7 +1518,7 @@ public:
 	  typename BASE::range_type target = partition(range_bytes);
 
 		// then read the range via sequential version
-		reader.read_range(output, target);
+		this->read_partition(reader, output, target);
 
 		return target;
 	}
@@ -1178,6 +1535,12 @@ public:
 	/// destructor
 	virtual ~partitioned_file() {};  // will call super's unmap.
 
+	/// the reader does the reading, so it gets the window size.
+	virtual void set_readahead_bytes(size_t const bytes) {
+		BASE::set_readahead_bytes(bytes);
+		reader.set_readahead_bytes(bytes);
+	}
+
 
 	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
 	using BASE::read_file;
@@ -1198,8 +1561,15 @@ public:
 //		std::cout << " rank " << this->comm.rank() << " PRIMARY : in mem " << output.in_mem_range_bytes << " valid " << output.valid_range_bytes << std::endl;
 
 
-		// then read the range via sequential version
-		output.in_mem_range_bytes = reader.read_range(output.data, in_mem_partitioned);
+		if (this->overlap_exchange && (overlap > 0) && (this->comm.size() > 1) &&
+				this->can_exchange_overlap(valid_partitioned, overlap)) {
+			// read the valid range only, then get the overlap from the next process.
+			output.in_mem_range_bytes = this->read_partition(reader, output.data, valid_partitioned);
+			output.in_mem_range_bytes.end += this->append_next_overlap(output.data, overlap);
+		} else {
+			// then read the range via sequential version
+			output.in_mem_range_bytes = this->read_partition(reader, output.data, in_mem_partitioned);
+		}
 
 		output.valid_range_bytes = valid_partitioned;
 		output.parent_range_bytes = this->file_range_bytes;
@@ -1230,6 +1600,37 @@ protected:
 	/// partitioner to use.
 	::bliss::partition::BlockPartitioner<typename BASE::range_type> partitioner;
 
+	/// record index stride.  0 disables the record index.  see record_index.hpp
+	size_t record_index_stride;
+
+	/// record index, when used by the last read_file.
+	::bliss::io::record_index rindex;
+
+	/// k - 1 of the k-mers the caller will parse, from the overlap argument.  for partitioning by k-mers.
+	const size_t kmer_overlap;
+
+	/// balance indexed partitions by estimated k-mers rather than bytes.  see record_index::balance.
+	bool by_kmers;
+
+	/// ordinal of the first record in the partition, when known.
+	size_t first_record;
+
+	/// read the partition aligned to the sampled record starts in rindex.  no communication.
+	void read_file_indexed(::bliss::io::file_data & output) {
+		range_type target = (by_kmers && (this->comm.size() > 1)) ?
+				rindex.balance(this->file_range_bytes, this->comm.rank(), this->comm.size(), kmer_overlap) :
+				rindex.align(partition(this->file_range_bytes), this->file_range_bytes);
+
+		this->read_partition(reader, output.data, target);
+
+		output.in_mem_range_bytes = target;
+		output.in_mem_range_bytes.end = target.start + output.data.size();
+		output.valid_range_bytes = output.in_mem_range_bytes;
+		output.parent_range_bytes = this->file_range_bytes;
+
+		first_record = rindex.record_id(target.start, this->file_range_bytes);
+	}
+
 	/**
 	 * @brief partitions the specified range by the number of processes in communicator
 	 * @note  does not add overlap.  this is strictly for block partitioning a range.
@@ -1312,7 +1713,7 @@ public:
 
 
 		// then read the range via sequential version
-		reader.read_range(output, target);
+		this->read_partition(reader, output, target);
 
 		return target;
 	}
@@ -1324,11 +1725,41 @@ public:
 	 */
 	partitioned_file(std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm()) :
 		BaseType(_filename, _comm),
-		 reader(this->fd, this->file_range_bytes.end), overlap(0UL) {};
+		 reader(this->fd, this->file_range_bytes.end), overlap(0UL),
+		 record_index_stride(::bliss::io::record_index_stride_from_env()),
+		 kmer_overlap(_overlap), by_kmers(::bliss::io::partition_by_kmers_from_env()),
+		 first_record(::std::numeric_limits<size_t>::max()) {};
 
 	/// destructor
 	virtual ~partitioned_file() {};  // will call super's unmap.
 
+	/// use the record index "<file>.bri", writing it on first read.  stride 0 disables.  set the same on all ranks.
+	void set_record_index_stride(size_t const stride) {
+		record_index_stride = stride;
+	}
+	size_t get_record_index_stride() const {
+		return record_index_stride;
+	}
+
+	/// with the record index, balance the partitions by estimated k-mers of length overlap + 1, not bytes.  set the same on all ranks.
+	void set_partition_by_kmers(bool const enable) {
+		by_kmers = enable;
+	}
+	bool get_partition_by_kmers() const {
+		return by_kmers;
+	}
+
+	/// ordinal of the first record of the partition read by read_file, or max size_t if unknown.  known when the record index is used.
+	size_t first_record_id() const {
+		return first_record;
+	}
+
+	/// the reader does the reading, so it gets the window size.
+	virtual void set_readahead_bytes(size_t const bytes) {
+		BASE::set_readahead_bytes(bytes);
+		reader.set_readahead_bytes(bytes);
+	}
+
 
 	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
 	using BASE::read_file;
@@ -1343,6 +1774,20 @@ public:
 
 //		std::cout << " rank " << this->comm.rank() << " FASTQ: in mem " << output.in_mem_range_bytes << " valid " << output.valid_range_bytes << std::endl;
 
+		first_record = ::std::numeric_limits<size_t>::max();
+		if (record_index_stride > 0) {
+			// all ranks use the index, or none, so the partitions are consistent.
+			int loaded = rindex.load(this->filename) ? 1 : 0;
+			loaded = ::mxx::allreduce(loaded, [](int const & x, int const & y) {
+				return (x < y) ? x : y;
+			}, this->comm);
+			if (loaded == 1) {
+				read_file_indexed(output);
+				return;
+			}
+			rindex.clear();
+		}
+
 		// overlap is set to page size, so output will have sufficient space.
 		// note that this is same behavior as the serial mmap_file
 
@@ -1423,6 +1868,10 @@ public:
 
 //		std::cout << "rank " << this->comm.rank() << " file  " << output.parent_range_bytes << std::endl;
 
+		// first read:  write the index for the next.
+		if (record_index_stride > 0) {
+			::bliss::io::build_fastq_record_index(output, this->filename, record_index_stride, this->comm);
+		}
 	}
 
 
@@ -1534,7 +1983,7 @@ public:
 
 
 		// then read the range via sequential version
-		reader.read_range(output, target);
+		this->read_partition(reader, output, target);
 
 		return target;
 	}
@@ -1551,6 +2000,12 @@ public:
 	/// destructor
 	virtual ~partitioned_file() {};  // will call super's unmap.
 
+	/// the reader does the reading, so it gets the window size.
+	virtual void set_readahead_bytes(size_t const bytes) {
+		BASE::set_readahead_bytes(bytes);
+		reader.set_readahead_bytes(bytes);
+	}
+
 
 	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
 	using BASE::read_file;
@@ -1572,8 +2027,15 @@ public:
 
 //		std::cout << " rank " << this->comm.rank() << " FASTA: in mem " << output.in_mem_range_bytes << " valid " << output.valid_range_bytes << std::endl;
 
-		// then read the range via sequential version
-		output.in_mem_range_bytes = reader.read_range(output.data, output.in_mem_range_bytes);
+		if (this->overlap_exchange && (overlap > 0) && (this->comm.size() > 1) &&
+				this->can_exchange_overlap(output.valid_range_bytes, 2 * overlap)) {
+			// read the valid range only, then get the overlap from the next process.
+			output.in_mem_range_bytes = this->read_partition(reader, output.data, output.valid_range_bytes);
+			output.in_mem_range_bytes.end += this->append_next_overlap(output.data, 2 * overlap);
+		} else {
+			// then read the range via sequential version
+			output.in_mem_range_bytes = this->read_partition(reader, output.data, output.in_mem_range_bytes);
+		}
 
 		output.parent_range_bytes = this->file_range_bytes;
 
@@ -1630,6 +2092,54 @@ class partitioned_file<::bliss::io::stdio_file, FileParser, ::bliss::io::paralle
 
 
 // multilevel parallel file io relies on MPIIO.
+/**
+ * @brief MPI-IO hints for mpiio_file, for Lustre and GPFS.  0 or empty leaves the MPI library's default.
+ * @details striping_factor and striping_unit take effect only when a file is created, so for reading they are
+ *          passed through, and striping_unit sets the alignment of the partition boundaries.
+ *          romio_cb_read ("enable", "disable", "automatic"), cb_nodes and cb_buffer_size control the collective
+ *          buffering (two-phase I/O) of the MPI_File_read_at_all calls.
+ *          default constructed from the environment:  BL_MPIIO_STRIPING_FACTOR, BL_MPIIO_STRIPING_UNIT,
+ *          BL_MPIIO_CB_NODES, BL_MPIIO_CB_BUFFER_SIZE, BL_MPIIO_CB_READ, and BL_MPIIO_ALIGN (0 to not align).
+ */
+struct mpiio_hints {
+	size_t striping_factor;
+	size_t striping_unit;
+	size_t cb_nodes;
+	size_t cb_buffer_size;
+	std::string romio_cb_read;
+	/// align partition boundaries to stripes:  striping_unit if set, else the file's striping_unit as reported by MPI.
+	bool align_to_stripe;
+
+	mpiio_hints() :
+		striping_factor(from_env("BL_MPIIO_STRIPING_FACTOR", 0)),
+		striping_unit(from_env("BL_MPIIO_STRIPING_UNIT", 0)),
+		cb_nodes(from_env("BL_MPIIO_CB_NODES", 0)),
+		cb_buffer_size(from_env("BL_MPIIO_CB_BUFFER_SIZE", 0)),
+		romio_cb_read(::std::getenv("BL_MPIIO_CB_READ") == nullptr ? "" : ::std::getenv("BL_MPIIO_CB_READ")),
+		align_to_stripe(from_env("BL_MPIIO_ALIGN", 1) != 0) {}
+
+	static size_t from_env(char const * name, size_t const default_value) {
+		char const * v = ::std::getenv(name);
+		if (v == nullptr) return default_value;
+		return ::std::strtoul(v, nullptr, 10);
+	}
+
+	/// the hints as an MPI_Info, or MPI_INFO_NULL if none are set.  caller frees a non-null info.
+	MPI_Info make_info() const {
+		if ((striping_factor == 0) && (striping_unit == 0) && (cb_nodes == 0) &&
+				(cb_buffer_size == 0) && romio_cb_read.empty()) return MPI_INFO_NULL;
+
+		MPI_Info info;
+		MPI_Info_create(&info);
+		if (striping_factor > 0) MPI_Info_set(info, const_cast<char *>("striping_factor"), const_cast<char *>(std::to_string(striping_factor).c_str()));
+		if (striping_unit > 0) MPI_Info_set(info, const_cast<char *>("striping_unit"), const_cast<char *>(std::to_string(striping_unit).c_str()));
+		if (cb_nodes > 0) MPI_Info_set(info, const_cast<char *>("cb_nodes"), const_cast<char *>(std::to_string(cb_nodes).c_str()));
+		if (cb_buffer_size > 0) MPI_Info_set(info, const_cast<char *>("cb_buffer_size"), const_cast<char *>(std::to_string(cb_buffer_size).c_str()));
+		if (!romio_cb_read.empty()) MPI_Info_set(info, const_cast<char *>("romio_cb_read"), const_cast<char *>(romio_cb_read.c_str()));
+		return info;
+	}
+};
+
 template <template <typename> class FileParser = ::bliss::io::BaseFileParser >
 class mpiio_base_file : public ::bliss::io::base_file {
 
@@ -1650,6 +2160,12 @@ protected:
 	/// partitioner to use.
 	::bliss::partition::BlockPartitioner<range_type> partitioner;
 
+	/// hints to open the file with.
+	const mpiio_hints hints;
+
+	/// stripe size to align partition boundaries to.  0 to not align.
+	size_t stripe_bytes;
+
 	std::string get_error_string(std::string const & op_name, int const & return_val) {
 		char error_string[BUFSIZ];
 		int length_of_error_string, error_class;
@@ -1713,7 +2229,9 @@ protected:
 		close_file();
 
 		// open the file
-		int res = MPI_File_open(this->comm, const_cast<char *>(this->filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+		MPI_Info info = hints.make_info();
+		int res = MPI_File_open(this->comm, const_cast<char *>(this->filename.c_str()), MPI_MODE_RDONLY, info, &fh);
+		if (info != MPI_INFO_NULL) MPI_Info_free(&info);
 
 		if (res != MPI_SUCCESS) {
 			throw ::bliss::utils::make_exception<::bliss::io::IOException>(get_error_string("open", res));
@@ -1721,6 +2239,36 @@ protected:
 
 		// ensure atomicity is turned off
 		MPI_File_set_atomicity(fh, 0);
+
+		stripe_bytes = hints.align_to_stripe ? (hints.striping_unit > 0 ? hints.striping_unit : get_striping_unit()) : 0;
+	}
+
+	/// striping_unit of the open file as reported by the MPI library (e.g. ROMIO on Lustre or GPFS), 0 if not reported.
+	size_t get_striping_unit() {
+		MPI_Info info;
+		if (MPI_File_get_info(fh, &info) != MPI_SUCCESS) return 0;
+
+		char value[MPI_MAX_INFO_VAL + 1];
+		int flag = 0;
+		MPI_Info_get(info, const_cast<char *>("striping_unit"), MPI_MAX_INFO_VAL, value, &flag);
+		MPI_Info_free(&info);
+
+		return flag ? ::std::strtoul(value, nullptr, 10) : 0;
+	}
+
+	/**
+	 * @brief move the internal boundaries of a block partition down to stripe boundaries, so that each stripe is read by 1 process.
+	 * @details  adjacent partitions move their shared boundary the same way, so the partitions still cover whole.
+	 */
+	range_type align_to_stripes(range_type const & part, range_type const & whole) const {
+		if (stripe_bytes == 0) return part;
+
+		range_type result = part;
+		if (result.start > whole.start)
+			result.start = ::std::max(whole.start, range_type::align_to_page(result.start, stripe_bytes));
+		if (result.end < whole.end)
+			result.end = ::std::max(whole.start, range_type::align_to_page(result.end, stripe_bytes));
+		return result;
 	}
 
 	/// funciton for closing a file
@@ -1761,10 +2309,10 @@ public:
 		range_type target =
 				BASE::range_type::intersect(range_bytes, this->file_range_bytes);
 
-		// do equal partition
+		// do equal partition, with boundaries at stripes.
 		if (comm.size() > 1) {
 			partitioner.configure(target, comm.size());
-			target = partitioner.getNext(comm.rank());
+			target = align_to_stripes(partitioner.getNext(comm.rank()), target);
 		}
 
 		// compute the size to read.
@@ -1909,10 +2457,11 @@ public:
 	}
 
 
-	mpiio_base_file(::std::string const & _filename, size_t const _overlap = 0UL,  ::mxx::comm const & _comm = ::mxx::comm()) :
+	mpiio_base_file(::std::string const & _filename, size_t const _overlap = 0UL,  ::mxx::comm const & _comm = ::mxx::comm(),
+			mpiio_hints const & _hints = mpiio_hints()) :
 	  BASE(static_cast<int>(-1), static_cast<size_t>(0)),
 	 	 overlap(_overlap),
-				  comm(_comm.copy()), fh(MPI_FILE_NULL) {
+				  comm(_comm.copy()), fh(MPI_FILE_NULL), hints(_hints), stripe_bytes(0) {
 		this->filename = _filename;
 	  this->open_file();
 		this->file_range_bytes.end = this->get_file_size();  // call after opening file
@@ -1943,8 +2492,9 @@ public:
 		using FileParserType = typename BASE::FileParserType;
 
 
-		mpiio_file(::std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm()) :
-			BASE(_filename, _overlap, _comm) {};
+		mpiio_file(::std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm(),
+				mpiio_hints const & _hints = mpiio_hints()) :
+			BASE(_filename, _overlap, _comm, _hints) {};
 
 		~mpiio_file() {};
 
@@ -1998,8 +2548,9 @@ public:
 		using FileParserType = typename BASE::FileParserType;
 
 
-		mpiio_file(::std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm()) :
-			BASE(_filename, 0UL, _comm) {};      // specify 1 page worth as overlap
+		mpiio_file(::std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm(),
+				mpiio_hints const & _hints = mpiio_hints()) :
+			BASE(_filename, 0UL, _comm, _hints) {};      // specify 1 page worth as overlap
 
 		~mpiio_file() { };
 
@@ -2121,8 +2672,9 @@ public:
 		using FileParserType = typename BASE::FileParserType;
 
 
-		mpiio_file(::std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm()) :
-			BASE(_filename, _overlap, _comm) {};      // specify 1 page worth as overlap
+		mpiio_file(::std::string const & _filename, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm(),
+				mpiio_hints const & _hints = mpiio_hints()) :
+			BASE(_filename, _overlap, _comm, _hints) {};      // specify 1 page worth as overlap
 
 		~mpiio_file() { };
 
@@ -54,6 +54,7 @@
 #include "partition/partitioner.hpp"
 //#include "io/data_block.hpp"
 #include "io/io_exception.hpp"
+#include "io/eol_search.hpp"
 #include "utils/logging.h"
 #include "common/sequence.hpp"
 #include <mxx/comm.hpp> // for mxx::comm
@@ -164,6 +165,12 @@ namespace io
                                                 ::std::is_same<typename ::std::iterator_traits<IT>::value_type, unsigned char>::value)
                                                >::type >
        inline IT findEOL(IT& iter, const IT& end, size_t &offset) const {
+         return findEOL(iter, end, offset, ::std::integral_constant<bool, ::bliss::io::is_contiguous_char_iterator<IT>::value>());
+       }
+
+       /// scan one char at a time, for iterators that are not known to be contiguous.
+       template <typename IT>
+       inline IT findEOL(IT& iter, const IT& end, size_t &offset, ::std::false_type const &) const {
          while ((iter != end) && ((*iter != eol) && (*iter != cr) ) ) {
            ++iter;
            ++offset;
@@ -171,6 +178,16 @@ namespace io
          return iter;
        }
 
+       /// contiguous data:  vectorized search, see eol_search.hpp
+       template <typename IT>
+       inline IT findEOL(IT& iter, const IT& end, size_t &offset, ::std::true_type const &) const {
+         if (iter == end) return iter;
+         size_t pos = ::bliss::io::find_eol(reinterpret_cast<unsigned char const *>(&(*iter)), static_cast<size_t>(end - iter));
+         iter += pos;
+         offset += pos;
+         return iter;
+       }
+
 
        /**
         * @brief constructs an IOException object with the relevant debug data.
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    header_resolver.hpp
+ * @ingroup io
+ * @brief   reads FASTQ/FASTA record headers on demand, from record start offsets.
+ * @details the sequence parsers do not extract headers:  a record's id is its start offset in the file
+ *          (SequenceId::get_pos(), ShortSequenceKmerId::get_id() for the k-mers of a FASTQ record), and the header line is
+ *          skipped by the EOL search.  when a query result needs read names, header_resolver reads them afterwards,
+ *          with pread on the original file.
+ *
+ *          resolve(offsets) sorts the distinct offsets, and reads them in windows of window_bytes:  1 pread serves all
+ *          offsets in the window whose header line ends in it, and a header that does not fit is read by itself with a
+ *          larger buffer.  names are returned in the order of the offsets.  a name is the header line without the
+ *          leading '@' or '>' and the line end, or only its first word (up to a space or tab) with first_word_only.
+ *
+ *          each rank reads the headers of its own results.  not for LongSequenceKmerId, whose id is a position inside the
+ *          record.
+ */
+#ifndef SRC_IO_HEADER_RESOLVER_HPP_
+#define SRC_IO_HEADER_RESOLVER_HPP_
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>   // sort, min
+#include <numeric>     // iota
+#include <cstring>     // memchr, strerror
+#include <cerrno>
+
+#include <unistd.h>    // pread, close
+#include <fcntl.h>     // open
+#include <sys/stat.h>  // fstat
+
+#include "common/sequence.hpp"
+#include "io/io_exception.hpp"
+
+namespace bliss
+{
+namespace io
+{
+
+  /// record start offset of an id, for header_resolver.
+  inline size_t record_offset(::bliss::common::SequenceId const & id) { return id.get_pos(); }
+  inline size_t record_offset(::bliss::common::ShortSequenceKmerId const & id) { return id.get_id(); }
+
+
+  class header_resolver {
+    protected:
+      ::std::string filename;
+      int fd;
+      size_t file_size;
+      size_t window_bytes;
+      bool first_word_only;
+
+      /// read [offset, offset + bytes) into buf, clipped at the file end.  returns the bytes read.
+      size_t read_at(size_t const offset, size_t const bytes, ::std::vector<char> & buf) const {
+        size_t const n = (offset >= file_size) ? 0 : ::std::min(bytes, file_size - offset);
+        buf.resize(n);
+        size_t s = 0;
+        while (s < n) {
+          ssize_t count = pread(fd, buf.data() + s, n - s, static_cast<off_t>(offset + s));
+          if (count < 0) {
+            if (errno == EINTR) continue;
+            int myerr = errno;
+            ::std::stringstream ss;
+            ss << "ERROR: header_resolver pread: file " << filename << " error " << myerr << ": " << strerror(myerr);
+            throw IOException(ss.str());
+          }
+          if (count == 0) break;
+          s += count;
+        }
+        buf.resize(s);
+        return s;
+      }
+
+      /// the name of the header line at data[0 ..), which ends before len.  false if the line end is not in data.
+      bool parse(char const * data, size_t const len, bool const at_eof, size_t const offset, ::std::string & name) const {
+        if (len == 0) {
+          ::std::stringstream ss;
+          ss << "ERROR: header_resolver: offset " << offset << " is past the end of " << filename;
+          throw IOException(ss.str());
+        }
+        if ((data[0] != '@') && (data[0] != '>')) {
+          ::std::stringstream ss;
+          ss << "ERROR: header_resolver: offset " << offset << " in " << filename << " is not the start of a record";
+          throw IOException(ss.str());
+        }
+        char const * eol = static_cast<char const *>(memchr(data, '\n', len));
+        if ((eol == nullptr) && !at_eof) return false;
+
+        char const * e = (eol == nullptr) ? data + len : eol;
+        if ((e > data + 1) && (*(e - 1) == '\r')) --e;
+        if (first_word_only) {
+          char const * w = data + 1;
+          while ((w < e) && (*w != ' ') && (*w != '\t')) ++w;
+          e = w;
+        }
+        name.assign(data + 1, e);
+        return true;
+      }
+
+    public:
+      /// default window, a few hundred FASTQ records.
+      static constexpr size_t default_window_bytes = 64UL * 1024UL;
+
+      /// open the file.  throws IOException if it cannot be opened.
+      header_resolver(::std::string const & _filename, bool const _first_word_only = false,
+                      size_t const _window_bytes = default_window_bytes) :
+        filename(_filename), fd(-1), file_size(0),
+        window_bytes(::std::max(_window_bytes, static_cast<size_t>(16))), first_word_only(_first_word_only) {
+        fd = open(filename.c_str(), O_RDONLY);
+        struct stat st;
+        if ((fd < 0) || (fstat(fd, &st) != 0)) {
+          int myerr = errno;
+          if (fd >= 0) close(fd);
+          ::std::stringstream ss;
+          ss << "ERROR: header_resolver: cannot open " << filename << " error " << myerr << ": " << strerror(myerr);
+          throw IOException(ss.str());
+        }
+        file_size = st.st_size;
+      }
+
+      header_resolver(header_resolver const &) = delete;
+      header_resolver & operator=(header_resolver const &) = delete;
+
+      ~header_resolver() {
+        if (fd >= 0) close(fd);
+      }
+
+      /// the name of the record that starts at offset.
+      ::std::string resolve(size_t const offset) const {
+        return resolve(::std::vector<size_t>(1, offset)).front();
+      }
+
+      /// the names of the records that start at offsets, in the same order.  see file description.
+      ::std::vector<::std::string> resolve(::std::vector<size_t> const & offsets) const {
+        ::std::vector<::std::string> names(offsets.size());
+        if (offsets.empty()) return names;
+
+        ::std::vector<size_t> order(offsets.size());
+        ::std::iota(order.begin(), order.end(), 0);
+        ::std::sort(order.begin(), order.end(), [&offsets](size_t x, size_t y) { return offsets[x] < offsets[y]; });
+
+        ::std::vector<char> buf;
+        size_t buf_start = 0, buf_len = 0;
+        bool have = false;
+        for (size_t i = 0; i < order.size(); ++i) {
+          size_t const off = offsets[order[i]];
+          if ((i > 0) && (off == offsets[order[i - 1]])) {
+            names[order[i]] = names[order[i - 1]];
+            continue;
+          }
+
+          // the window, if off is in the current one and its line ends there.
+          if (have && (off >= buf_start) && (off < buf_start + buf_len) &&
+              parse(buf.data() + (off - buf_start), buf_len - (off - buf_start), buf_start + buf_len >= file_size, off, names[order[i]]))
+            continue;
+
+          // a new window at off.
+          buf_start = off;
+          buf_len = read_at(off, window_bytes, buf);
+          have = true;
+          if (parse(buf.data(), buf_len, off + buf_len >= file_size, off, names[order[i]])) continue;
+
+          // a header longer than the window.
+          ::std::vector<char> big;
+          size_t bytes = window_bytes;
+          size_t len = 0;
+          do {
+            bytes *= 2;
+            len = read_at(off, bytes, big);
+          } while (!parse(big.data(), len, off + len >= file_size, off, names[order[i]]));
+        }
+        return names;
+      }
+
+      /// the names of the records of ids, e.g. the positions of a query result.  see record_offset.
+      template <typename IdType>
+      ::std::vector<::std::string> resolve_ids(::std::vector<IdType> const & ids) const {
+        ::std::vector<size_t> offsets;
+        offsets.reserve(ids.size());
+        for (auto const & id : ids) offsets.push_back(record_offset(id));
+        return resolve(offsets);
+      }
+
+      ::std::string const & get_filename() const { return filename; }
+  };
+
+} // namespace io
+} // namespace bliss
+
+#endif // SRC_IO_HEADER_RESOLVER_HPP_
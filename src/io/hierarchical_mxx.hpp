@@ -0,0 +1,547 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    hierarchical_mxx.hpp
+ * @ingroup
+ * @brief   node aware (2 level) all to all exchange and distribute.
+ * @details a flat all2allv has every rank sending to every other rank, p^2 messages that are small at scale.
+ *          here the exchange is done in 2 steps.  with L ranks per node and N nodes,
+ *          1. within each node, data is exchanged so that local rank l holds all of the node's data
+ *             destined for local rank l on every node.  this goes through shared memory.
+ *          2. ranks with the same local rank (1 per node) exchange the aggregated buffers.
+ *          each rank sends L + N messages instead of N * L, and the inter-node messages are L times larger.
+ *          every rank acts as the aggregator for its lane, so there is no single node leader bottleneck.
+ *
+ *          the result is the same as mxx::all2allv:  received data is grouped by source rank, in rank order,
+ *          and within each source the order of the send buffer is preserved.
+ *
+ *          requires the same number of ranks on every node.  otherwise (and for single node or single rank per node)
+ *          the exchange falls back to mxx::all2allv.
+ *
+ *          shared_distribute is a separate 1 level variant:  the bucketed send buffer lives in an MPI-3 shared memory
+ *          window, so node local peers copy their data straight out of it, and only off-node data goes through MPI.
+ */
+
+#ifndef HIERARCHICAL_MXX_HPP
+#define HIERARCHICAL_MXX_HPP
+
+#include <vector>
+#include <algorithm>
+#include <numeric>   // accumulate
+#include <cassert>
+
+#include <mpi.h>
+
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+#include <mxx/datatypes.hpp>
+
+#include "bliss-config.hpp"
+#include "utils/benchmark_utils.hpp"
+#include "io/incremental_mxx.hpp"
+
+namespace imxx
+{
+
+  /**
+   * @brief node-local and cross-node communicators, and the rank layout, for 2 level exchanges.
+   * @details construction is collective over the global communicator.
+   */
+  class hierarchical_comm {
+
+    protected:
+      /// node id from the rank of the node's lowest rank among all local rank 0s.  same on all ranks of a node.
+      static int compute_node_id(::mxx::comm const & global, ::mxx::comm const & local) {
+        ::mxx::comm leaders = global.split(local.rank() == 0 ? 0 : 1);
+        std::vector<int> ids = ::mxx::allgather(leaders.rank(), local);
+        return ids[0];
+      }
+
+    public:
+      /// global communicator
+      ::mxx::comm const & global;
+      /// ranks on the same node.
+      ::mxx::comm local;
+
+    protected:
+      /// this rank's node.
+      int node_id;
+
+    public:
+      /// ranks with the same local rank, 1 per node, ordered by node id.
+      ::mxx::comm cross;
+
+    protected:
+      /// number of nodes.
+      int nnodes;
+      /// ranks per node.
+      int ppn;
+      /// true if all nodes have the same number of ranks.
+      bool uniform;
+      /// true if global rank == node id * ppn + local rank, i.e. no reordering needed after exchange.
+      bool node_major;
+
+      /// global rank of (node, local rank), at [node * ppn + local rank]
+      std::vector<int> rank_at;
+
+      /// global rank of each local rank on this node.
+      std::vector<int> local_ranks;
+      /// local rank of each global rank, -1 if on a different node.
+      std::vector<int> local_of;
+
+    public:
+      hierarchical_comm(::mxx::comm const & _comm) :
+        global(_comm), local(_comm.split_shared()),
+        node_id(compute_node_id(_comm, local)),
+        cross(_comm.split(local.rank(), node_id)),
+        nnodes(cross.size()), ppn(local.size()), uniform(true), node_major(true) {
+
+        local_ranks = ::mxx::allgather(global.rank(), local);
+        local_of.assign(global.size(), -1);
+        for (int l = 0; l < ppn; ++l) local_of[local_ranks[l]] = l;
+
+        uniform = ::mxx::all_same(ppn, global);
+        if (!uniform) return;
+
+        std::vector<int> nodes = ::mxx::allgather(node_id, global);
+        std::vector<int> lanes = ::mxx::allgather(local.rank(), global);
+
+        rank_at.resize(global.size());
+        for (int r = 0; r < global.size(); ++r) {
+          rank_at[nodes[r] * ppn + lanes[r]] = r;
+          node_major &= (r == nodes[r] * ppn + lanes[r]);
+        }
+      }
+
+      /// whether the 2 level exchange applies.
+      bool is_hierarchical() const {
+        return uniform && (nnodes > 1) && (ppn > 1);
+      }
+
+      int num_nodes() const { return nnodes; }
+      int ranks_per_node() const { return ppn; }
+      int node() const { return node_id; }
+
+      /// global rank of local rank l on node n.
+      int rank_of(int n, int l) const { return rank_at[n * ppn + l]; }
+      bool is_node_major() const { return node_major; }
+
+      /// global rank of local rank l on this node.
+      int local_rank_to_global(int l) const { return local_ranks[l]; }
+      /// local rank of global rank r, or -1 if r is on another node.
+      int global_rank_to_local(int r) const { return local_of[r]; }
+  };
+
+
+  namespace local {
+
+    /**
+     * @brief  copy count-delimited segments into a new order.   segments are indexed by [outer][inner] in the input,
+     *         and written in [inner][outer] order, i.e. a block transpose.
+     * @param counts   segment sizes, [outer * ninner + inner]
+     */
+    template <typename T, typename SIZE>
+    void transpose_segments(T const * in, std::vector<SIZE> const & counts, size_t nouter, size_t ninner, T * out) {
+      assert(counts.size() == nouter * ninner);
+
+      // input offsets
+      std::vector<size_t> offsets(counts.size() + 1, 0);
+      for (size_t i = 0; i < counts.size(); ++i) offsets[i + 1] = offsets[i] + counts[i];
+
+      for (size_t j = 0; j < ninner; ++j) {
+        for (size_t i = 0; i < nouter; ++i) {
+          size_t s = i * ninner + j;
+          out = std::copy(in + offsets[s], in + offsets[s + 1], out);
+        }
+      }
+    }
+
+  } // local namespace
+
+
+  /**
+   * @brief  2 level all2allv.  same semantics as mxx::all2allv(send, send_counts, recv, recv_counts, comm).
+   * @details recv_counts is computed here.  recv is resized.  send is bucketed by destination global rank.
+   *          uses temporary buffers of about 2x the send and receive sizes.
+   */
+  template <typename V, typename SIZE>
+  void hierarchical_all2allv(std::vector<V> const & send, std::vector<SIZE> const & send_counts,
+                             std::vector<V> & recv, std::vector<SIZE> & recv_counts,
+                             hierarchical_comm const & hc) {
+    BL_BENCH_INIT(h_a2a);
+
+    ::mxx::comm const & comm = hc.global;
+    size_t p = comm.size();
+    assert(send_counts.size() == p);
+
+    // flat exchange.
+    if (!hc.is_hierarchical()) {
+      BL_BENCH_START(h_a2a);
+      recv_counts.resize(p);
+      mxx::all2all(send_counts.data(), 1, recv_counts.data(), comm);
+      recv.resize(std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0)));
+      mxx::all2allv(send.data(), send_counts, recv.data(), recv_counts, comm);
+      BL_BENCH_END(h_a2a, "flat_a2a", recv.size());
+
+      BL_BENCH_REPORT_MPI_NAMED(h_a2a, "imxx:hierarchical_all2allv", comm);
+      return;
+    }
+
+    size_t N = hc.num_nodes();
+    size_t L = hc.ranks_per_node();
+
+    // ==== step 1:  within node.  send to local rank l everything for (n, l), for all n.
+    BL_BENCH_START(h_a2a);
+    // counts in [lane][node] order
+    std::vector<size_t> c1(p);
+    {
+      // send offsets by global rank
+      std::vector<size_t> offsets(p + 1, 0);
+      for (size_t r = 0; r < p; ++r) offsets[r + 1] = offsets[r] + send_counts[r];
+
+      for (size_t l = 0; l < L; ++l) {
+        for (size_t n = 0; n < N; ++n) {
+          c1[l * N + n] = send_counts[hc.rank_of(n, l)];
+        }
+      }
+
+      // reorder send buffer to [lane][node]
+      recv.resize(send.size());
+      V * out = recv.data();
+      for (size_t l = 0; l < L; ++l) {
+        for (size_t n = 0; n < N; ++n) {
+          int r = hc.rank_of(n, l);
+          out = std::copy(send.data() + offsets[r], send.data() + offsets[r + 1], out);
+        }
+      }
+    }
+    BL_BENCH_END(h_a2a, "reorder_local", recv.size());
+
+    BL_BENCH_COLLECTIVE_START(h_a2a, "local_a2a", comm);
+    // per node counts for each local peer:  N counts per peer.
+    std::vector<size_t> c1_recv(p);
+    mxx::all2all(c1.data(), N, c1_recv.data(), hc.local);
+
+    std::vector<size_t> lsend(L, 0), lrecv(L, 0);
+    for (size_t l = 0; l < L; ++l) {
+      lsend[l] = std::accumulate(c1.begin() + l * N, c1.begin() + (l + 1) * N, static_cast<size_t>(0));
+      lrecv[l] = std::accumulate(c1_recv.begin() + l * N, c1_recv.begin() + (l + 1) * N, static_cast<size_t>(0));
+    }
+    std::vector<V> buffer(std::accumulate(lrecv.begin(), lrecv.end(), static_cast<size_t>(0)));
+    mxx::all2allv(recv.data(), lsend, buffer.data(), lrecv, hc.local);
+    BL_BENCH_END(h_a2a, "local_a2a", buffer.size());
+
+    // ==== step 2:  across nodes.  buffer is [source lane][dest node].  reorder to [dest node][source lane].
+    BL_BENCH_START(h_a2a);
+    recv.resize(buffer.size());
+    ::imxx::local::transpose_segments(buffer.data(), c1_recv, L, N, recv.data());
+
+    // counts in [dest node][source lane] order
+    std::vector<size_t> c2(p);
+    for (size_t n = 0; n < N; ++n) {
+      for (size_t s = 0; s < L; ++s) {
+        c2[n * L + s] = c1_recv[s * N + n];
+      }
+    }
+    BL_BENCH_END(h_a2a, "reorder_cross", recv.size());
+
+    BL_BENCH_COLLECTIVE_START(h_a2a, "cross_a2a", comm);
+    // per source lane counts for each node:  L counts per node.
+    std::vector<size_t> c2_recv(p);
+    mxx::all2all(c2.data(), L, c2_recv.data(), hc.cross);
+
+    std::vector<size_t> csend(N, 0), crecv(N, 0);
+    for (size_t n = 0; n < N; ++n) {
+      csend[n] = std::accumulate(c2.begin() + n * L, c2.begin() + (n + 1) * L, static_cast<size_t>(0));
+      crecv[n] = std::accumulate(c2_recv.begin() + n * L, c2_recv.begin() + (n + 1) * L, static_cast<size_t>(0));
+    }
+    buffer.resize(std::accumulate(crecv.begin(), crecv.end(), static_cast<size_t>(0)));
+    mxx::all2allv(recv.data(), csend, buffer.data(), crecv, hc.cross);
+    BL_BENCH_END(h_a2a, "cross_a2a", buffer.size());
+
+    // ==== step 3:  buffer is [source node][source lane].  reorder to global source rank.
+    BL_BENCH_START(h_a2a);
+    recv_counts.resize(p);
+    for (size_t n = 0; n < N; ++n) {
+      for (size_t s = 0; s < L; ++s) {
+        recv_counts[hc.rank_of(n, s)] = c2_recv[n * L + s];
+      }
+    }
+
+    if (hc.is_node_major()) {
+      recv.swap(buffer);
+    } else {
+      std::vector<size_t> offsets(p + 1, 0);
+      for (size_t i = 0; i < p; ++i) offsets[i + 1] = offsets[i] + c2_recv[i];
+
+      recv.resize(buffer.size());
+      V * out = recv.data();
+      std::vector<size_t> pos(p);   // [node * L + lane] for each global rank
+      for (size_t n = 0; n < N; ++n) {
+        for (size_t s = 0; s < L; ++s) {
+          pos[hc.rank_of(n, s)] = n * L + s;
+        }
+      }
+      for (size_t r = 0; r < p; ++r) {
+        out = std::copy(buffer.data() + offsets[pos[r]], buffer.data() + offsets[pos[r] + 1], out);
+      }
+    }
+    BL_BENCH_END(h_a2a, "reorder_recv", recv.size());
+
+    BL_BENCH_REPORT_MPI_NAMED(h_a2a, "imxx:hierarchical_all2allv", comm);
+  }
+
+  /// 2 level all2allv, returning the received vector.  recv counts are computed internally.
+  template <typename V, typename SIZE>
+  std::vector<V> hierarchical_all2allv(std::vector<V> const & send, std::vector<SIZE> const & send_counts,
+                                       hierarchical_comm const & hc) {
+    std::vector<V> recv;
+    std::vector<SIZE> recv_counts;
+    hierarchical_all2allv(send, send_counts, recv, recv_counts, hc);
+    return recv;
+  }
+
+
+  /**
+   * @brief distribute function using the 2 level exchange.  same contract as imxx::distribute with i2o.
+   * @details input is bucketed and permuted locally, exactly as in imxx::distribute, then exchanged with
+   *          hierarchical_all2allv.  output and recv_counts are the same as imxx::distribute's.
+   */
+  template <typename V, typename ToRank, typename SIZE>
+  void hierarchical_distribute(::std::vector<V>& input, ToRank const & to_rank,
+                  ::std::vector<SIZE> & recv_counts,
+                  ::std::vector<SIZE> & i2o,
+                  ::std::vector<V>& output,
+                  hierarchical_comm const & hc, bool const & preserve_input = false) {
+    BL_BENCH_INIT(distribute);
+
+    ::mxx::comm const & _comm = hc.global;
+
+    BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
+    bool empty = input.size() == 0;
+    empty = mxx::all_of(empty, _comm);
+    BL_BENCH_END(distribute, "empty", input.size());
+
+    if (empty) {
+      BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:hierarchical_distribute", _comm);
+      return;
+    }
+
+    BL_BENCH_START(distribute);
+    std::vector<SIZE> send_counts(_comm.size(), 0);
+    i2o.resize(input.size());
+    BL_BENCH_END(distribute, "alloc_map", input.size());
+
+    // bucketing
+    BL_BENCH_START(distribute);
+    imxx::local::assign_to_buckets(input, to_rank, _comm.size(), send_counts, i2o, 0, input.size());
+    BL_BENCH_END(distribute, "bucket", input.size());
+
+    BL_BENCH_START(distribute);
+    imxx::local::bucket_to_permutation(send_counts, i2o, 0, input.size());
+    BL_BENCH_END(distribute, "to_pos", input.size());
+
+    BL_BENCH_START(distribute);
+    if (output.capacity() < input.size()) output.clear();
+    output.resize(input.size());
+    output.swap(input);  // swap the 2.
+    BL_BENCH_END(distribute, "alloc_permute", output.size());
+
+    BL_BENCH_START(distribute);
+    imxx::local::bucket_permute(output.begin(), output.end(), i2o.begin(), input.begin(), 0, _comm.size());  // input now holds permuted entries.
+    BL_BENCH_END(distribute, "permute", input.size());
+
+    // communication part
+    BL_BENCH_COLLECTIVE_START(distribute, "a2a", _comm);
+    hierarchical_all2allv(input, send_counts, output, recv_counts, hc);
+    BL_BENCH_END(distribute, "a2a", output.size());
+
+    if (preserve_input) {
+      BL_BENCH_START(distribute);
+      imxx::local::unpermute_inplace(input, i2o, 0, input.size());
+      BL_BENCH_END(distribute, "unpermute_inplace", input.size());
+    }
+    BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:hierarchical_distribute", _comm);
+  }
+
+
+  /**
+   * @brief MPI-3 shared memory window over a node local communicator, holding count elements per rank.
+   * @details  the memory is raw storage, so T should be trivially copyable, as for any mxx datatype.
+   *           construction and destruction are collective over the local communicator.
+   */
+  template <typename T>
+  class shared_window {
+
+    protected:
+      MPI_Win win;
+      T * base;
+
+    public:
+      shared_window(size_t const & count, ::mxx::comm const & local) : base(nullptr) {
+        MPI_Win_allocate_shared(static_cast<MPI_Aint>(count * sizeof(T)), sizeof(T), MPI_INFO_NULL, local, &base, &win);
+      }
+
+      ~shared_window() {
+        MPI_Win_free(&win);
+      }
+
+      shared_window(shared_window const & other) = delete;
+      shared_window& operator=(shared_window const & other) = delete;
+
+      /// this rank's segment.
+      T * data() { return base; }
+
+      /// local rank l's segment.  only valid to read after a fence following l's writes.
+      T const * peer(int l) const {
+        MPI_Aint bytes;
+        int disp_unit;
+        T * ptr = nullptr;
+        MPI_Win_shared_query(win, l, &bytes, &disp_unit, &ptr);
+        return ptr;
+      }
+
+      /// collective synchronization.  makes local stores visible to node peers.
+      void fence(int mode = 0) {
+        MPI_Win_fence(mode, win);
+      }
+  };
+
+
+  /**
+   * @brief distribute function that skips the MPI copy for node local destinations.  same contract as imxx::distribute with i2o,
+   *        except that input is never modified.
+   * @details input is bucketed directly into a shared memory window.  node local peers copy their segments out of the window,
+   *          and the remaining, off-node segments, are exchanged with MPI_Alltoallv.   output is identical to imxx::distribute's.
+   *          if counts or displacements exceed int range, all segments are sent with mxx::all2allv from the window instead.
+   * @param preserve_input   ignored.  input is left in its original order.
+   */
+  template <typename V, typename ToRank, typename SIZE>
+  void shared_distribute(::std::vector<V>& input, ToRank const & to_rank,
+                  ::std::vector<SIZE> & recv_counts,
+                  ::std::vector<SIZE> & i2o,
+                  ::std::vector<V>& output,
+                  hierarchical_comm const & hc, bool const & preserve_input = false) {
+    BL_BENCH_INIT(distribute);
+    BLISS_UNUSED(preserve_input);
+
+    ::mxx::comm const & _comm = hc.global;
+    int p = _comm.size();
+
+    BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
+    bool empty = input.size() == 0;
+    empty = mxx::all_of(empty, _comm);
+    BL_BENCH_END(distribute, "empty", input.size());
+
+    if (empty) {
+      BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:shared_distribute", _comm);
+      return;
+    }
+
+    BL_BENCH_START(distribute);
+    std::vector<SIZE> send_counts(p, 0);
+    i2o.resize(input.size());
+    BL_BENCH_END(distribute, "alloc_map", input.size());
+
+    // bucketing
+    BL_BENCH_START(distribute);
+    imxx::local::assign_to_buckets(input, to_rank, p, send_counts, i2o, 0, input.size());
+    BL_BENCH_END(distribute, "bucket", input.size());
+
+    BL_BENCH_START(distribute);
+    imxx::local::bucket_to_permutation(send_counts, i2o, 0, input.size());
+    BL_BENCH_END(distribute, "to_pos", input.size());
+
+    // permute straight into shared memory.  send offsets are published as well, for the peers to find their segments.
+    BL_BENCH_COLLECTIVE_START(distribute, "alloc_window", _comm);
+    shared_window<V> send_win(input.size(), hc.local);
+    shared_window<size_t> offset_win(p + 1, hc.local);
+    BL_BENCH_END(distribute, "alloc_window", input.size());
+
+    BL_BENCH_START(distribute);
+    imxx::local::bucket_permute(input.begin(), input.end(), i2o.begin(), send_win.data(), 0, p);
+    size_t * send_offsets = offset_win.data();
+    send_offsets[0] = 0;
+    for (int i = 0; i < p; ++i) send_offsets[i + 1] = send_offsets[i] + send_counts[i];
+    BL_BENCH_END(distribute, "permute", input.size());
+
+    BL_BENCH_COLLECTIVE_START(distribute, "a2a_count", _comm);
+    recv_counts.resize(p);
+    mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
+
+    std::vector<size_t> recv_offsets(p + 1, 0);
+    for (int i = 0; i < p; ++i) recv_offsets[i + 1] = recv_offsets[i] + recv_counts[i];
+
+    if (output.capacity() < recv_offsets[p]) output.clear();
+    output.resize(recv_offsets[p]);
+
+    // MPI_Alltoallv takes int counts and displacements.
+    bool fits = (input.size() < static_cast<size_t>(mxx::max_int)) && (output.size() < static_cast<size_t>(mxx::max_int));
+    fits = mxx::all_of(fits, _comm);
+    BL_BENCH_END(distribute, "a2a_count", output.size());
+
+    // now visible to the node peers.
+    send_win.fence();
+    offset_win.fence();
+
+    if (fits) {
+      // off node part
+      BL_BENCH_COLLECTIVE_START(distribute, "a2a_remote", _comm);
+      std::vector<int> scounts(p, 0), sdispls(p, 0), rcounts(p, 0), rdispls(p, 0);
+      for (int i = 0; i < p; ++i) {
+        sdispls[i] = send_offsets[i];
+        rdispls[i] = recv_offsets[i];
+        if (hc.global_rank_to_local(i) >= 0) continue;
+        scounts[i] = send_counts[i];
+        rcounts[i] = recv_counts[i];
+      }
+      mxx::datatype dt = mxx::get_datatype<V>();
+      MPI_Alltoallv(send_win.data(), scounts.data(), sdispls.data(), dt.type(),
+                    output.data(), rcounts.data(), rdispls.data(), dt.type(), _comm);
+      BL_BENCH_END(distribute, "a2a_remote", output.size());
+
+      // node local part, 1 copy direct from peer memory.
+      BL_BENCH_START(distribute);
+      size_t local_count = 0;
+      int rank = _comm.rank();
+      for (int l = 0; l < hc.local.size(); ++l) {
+        int r = hc.local_rank_to_global(l);
+        if (recv_counts[r] == 0) continue;
+
+        V const * src = send_win.peer(l) + offset_win.peer(l)[rank];
+        std::copy(src, src + recv_counts[r], output.begin() + recv_offsets[r]);
+        local_count += recv_counts[r];
+      }
+      BL_BENCH_END(distribute, "copy_local", local_count);
+    } else {
+      BL_BENCH_COLLECTIVE_START(distribute, "a2a", _comm);
+      mxx::all2allv(send_win.data(), send_counts, output.data(), recv_counts, _comm);
+      BL_BENCH_END(distribute, "a2a", output.size());
+    }
+
+    // peers must be done reading before the windows are freed.
+    send_win.fence(MPI_MODE_NOSUCCEED);
+    offset_win.fence(MPI_MODE_NOSUCCEED);
+
+    BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:shared_distribute", _comm);
+  }
+
+} // namespace imxx
+
+
+#endif // HIERARCHICAL_MXX_HPP
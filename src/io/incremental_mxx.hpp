@@ -28,15 +28,25 @@
 
 
 #include <algorithm>
+#include <memory>  // allocator, uninitialized_copy
+#include <limits>  // numeric_limits
+#include <cstdlib>  // getenv, strtoul
 #include <mxx/datatypes.hpp>
 #include <mxx/comm.hpp>
 #include <mxx/collective.hpp>
 #include <mxx/samplesort.hpp>
 
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
 #include "utils/benchmark_utils.hpp"
 #include "utils/function_traits.hpp"
+#include "io/mpi_progress.hpp"
+#include "io/mxx_support.hpp"
 
 #include "containers/fsc_container_utils.hpp"
+#include "containers/soa_vector.hpp"
 
 namespace imxx
 {
@@ -70,6 +80,27 @@ namespace imxx
 
 
 
+    namespace detail {
+      template <typename T, typename Func, typename ASSIGN_TYPE>
+      inline void assign_batch(T const * input, size_t const & n, Func const & key_func, ASSIGN_TYPE * assignments, ::std::true_type) {
+        key_func.assign(input, n, assignments);
+      }
+      template <typename T, typename Func, typename ASSIGN_TYPE>
+      inline void assign_batch(T const * input, size_t const & n, Func const & key_func, ASSIGN_TYPE * assignments, ::std::false_type) {
+        for (size_t i = 0; i < n; ++i) assignments[i] = key_func(input[i]);
+      }
+    }
+
+    /**
+     * @brief  bucket ids of n elements.  if key_func has a batch_size > 1 (e.g. a KeyToRank over a SIMD hash), its
+     *         assign(input, n, assignments) hashes batch_size keys per call.  otherwise key_func is called per element.
+     */
+    template <typename T, typename Func, typename ASSIGN_TYPE>
+    inline void assign_batch(T const * input, size_t const & n, Func const & key_func, ASSIGN_TYPE * assignments) {
+      detail::assign_batch(input, n, key_func, assignments,
+                           ::std::integral_constant<bool, (::fsc::hash_batch_size<Func>::value > 1)>());
+    }
+
     /**
      * @brief   implementation function for use by assign_and_bucket
      * @details uses the smallest data type (ASSIGN_TYPE) given the number of buckets.
@@ -114,18 +145,14 @@ namespace imxx
       }
 
       // output to input mapping
-      std::vector<ASSIGN_TYPE> i2o;
-      i2o.reserve(len);
+      std::vector<ASSIGN_TYPE> i2o(len);
 
       // [1st pass]: compute bucket counts and input to bucket assignment.
-      ASSIGN_TYPE p;
-      for (size_t i = f; i < l; ++i) {
-          p = key_func(input[i]);
+      assign_batch(input.data() + f, len, key_func, i2o.data());
+      for (size_t i = 0; i < len; ++i) {
+          assert(((0 <= i2o[i]) && ((size_t)i2o[i] < num_buckets)) && "assigned bucket id is not valid");
 
-          assert(((0 <= p) && ((size_t)p < num_buckets)) && "assigned bucket id is not valid");
-
-          i2o.emplace_back(p);
-          ++bucket_sizes[p];
+          ++bucket_sizes[i2o[i]];
       }
 
       // get offsets of where buckets start (= exclusive prefix sum)
@@ -198,18 +225,14 @@ namespace imxx
       }
 
       // output to input mapping
-      std::vector<ASSIGN_TYPE> i2o;
-      i2o.reserve(len);
+      std::vector<ASSIGN_TYPE> i2o(len);
 
       // [1st pass]: compute bucket counts and input to bucket assignment.
-      ASSIGN_TYPE p;
-      for (size_t i = f; i < l; ++i) {
-          p = key_func(input[i]);
+      assign_batch(input.data() + f, len, key_func, i2o.data());
+      for (size_t i = 0; i < len; ++i) {
+          assert(((0 <= i2o[i]) && ((size_t)i2o[i] < num_buckets)) && "assigned bucket id is not valid");
 
-          assert(((0 <= p) && ((size_t)p < num_buckets)) && "assigned bucket id is not valid");
-
-          i2o.emplace_back(p);
-          ++bucket_sizes[p];
+          ++bucket_sizes[i2o[i]];
       }
 
       // get offsets of where buckets start (= exclusive prefix sum)
@@ -240,6 +263,178 @@ namespace imxx
 
 
 
+    /// number of buckets above which the distribute functions use the 2 pass (radix) bucketing and permute.
+    /// with more buckets than this, a single pass scatter has too many active write streams for the cache and TLB.
+    /// the crossover depends on cache, TLB, and page size.  see the radix cases in benchmark_bucketing.cpp to tune.
+    constexpr size_t radix_bucketing_threshold = 1UL << 20;
+
+    /// max number of groups in the first pass of the 2 pass permute.  keeps the write-combining buffers within L2.
+    constexpr size_t radix_max_groups = 1024;
+
+    /**
+     * @brief software write-combining buffers for scattering into many groups.
+     * @details  each group has a small buffer (about 4 cache lines).  pushed elements are collected in the
+     *           buffer and copied to the group's output position when the buffer is full, so the output is
+     *           written in short sequential runs instead of 1 element at a time to random locations.
+     *           ordering within a group is preserved, so the scatter is stable.
+     *
+     *           the output is treated as uninitialized storage:  elements are copy constructed into it.
+     */
+    template <typename E>
+    class write_combining_scatter {
+        static constexpr size_t buffer_bytes = 256;
+
+      public:
+        static constexpr size_t capacity = (sizeof(E) >= buffer_bytes) ? 1 : (buffer_bytes / sizeof(E));
+
+      protected:
+        std::vector<E> buffers;
+        std::vector<size_t> fill;
+        std::vector<size_t> positions;
+        E* out;
+
+      public:
+        /// offsets[g] is the output position of group g.
+        write_combining_scatter(std::vector<size_t> const & offsets, E* _out) :
+          buffers(offsets.size() * capacity), fill(offsets.size(), 0), positions(offsets), out(_out) {}
+
+        inline void push(size_t const & g, E const & x) {
+          size_t & c = fill[g];
+          buffers[g * capacity + c] = x;
+          if (++c == capacity) {
+            std::uninitialized_copy(buffers.begin() + g * capacity, buffers.begin() + (g + 1) * capacity, out + positions[g]);
+            positions[g] += capacity;
+            c = 0;
+          }
+        }
+
+        /// copy out the partially filled buffers.
+        void flush() {
+          for (size_t g = 0; g < fill.size(); ++g) {
+            if (fill[g] == 0) continue;
+            std::uninitialized_copy(buffers.begin() + g * capacity, buffers.begin() + g * capacity + fill[g], out + positions[g]);
+            positions[g] += fill[g];
+            fill[g] = 0;
+          }
+        }
+    };
+
+    /// uninitialized temporary array for write_combining_scatter output.  avoids initializing O(n) elements that are overwritten.
+    template <typename E>
+    class scatter_buffer {
+        std::allocator<E> alloc;
+        E* ptr;
+        size_t len;
+
+      public:
+        explicit scatter_buffer(size_t const & _len) : alloc(), ptr(alloc.allocate(_len)), len(_len) {}
+        ~scatter_buffer() {
+          if (!std::is_trivially_destructible<E>::value)
+            for (size_t i = 0; i < len; ++i) (ptr + i)->~E();
+          alloc.deallocate(ptr, len);
+        }
+        scatter_buffer(scatter_buffer const &) = delete;
+        scatter_buffer & operator=(scatter_buffer const &) = delete;
+
+        E* data() { return ptr; }
+        E & operator[](size_t const & i) { return ptr[i]; }
+    };
+
+    template <typename E>
+    constexpr size_t write_combining_scatter<E>::capacity;
+    template <typename E>
+    constexpr size_t write_combining_scatter<E>::buffer_bytes;
+
+
+    /**
+     * @brief   2 pass (most significant digit radix style) version of bucketing_impl, for large number of buckets.
+     * @details the bucket id is split into a high and a low half.  the first pass scatters the elements (with
+     *          their bucket ids) into the high digit groups through write-combining buffers.  the second pass
+     *          scatters each group into its buckets.  each pass has about sqrt(num_buckets) active write streams,
+     *          vs num_buckets for bucketing_impl, at the cost of an additional O(n) temporary and 1 more data movement.
+     *
+     *          stable.  same output contract as bucketing_impl:  results and bucket_sizes are for the range [first, last).
+     */
+    template <typename T, typename Func, typename ASSIGN_TYPE, typename SIZE>
+    void
+    bucketing_radix_impl(std::vector<T>const & input,
+                           Func const & key_func,
+                           ASSIGN_TYPE const num_buckets,
+                           std::vector<SIZE> & bucket_sizes,
+                           std::vector<T> & results,
+                           size_t first = 0,
+                           size_t last = std::numeric_limits<size_t>::max()) {
+
+      static_assert(::std::is_integral<ASSIGN_TYPE>::value, "ASSIGN_TYPE should be integral, preferably unsigned");
+      assert(((input.size() == 0) || (input.data() != results.data())) &&
+          "input and output should not be the same.");
+
+      bucket_sizes.clear();
+
+      // no bucket.
+      if (num_buckets == 0) return;
+
+      // ensure valid range
+      size_t f = std::min(first, input.size());
+      size_t l = std::min(last, input.size());
+      assert((f <= l) && "first should not exceed last" );
+
+      // few buckets:  single pass is better.
+      if ((num_buckets <= 2) || (f == l)) {
+        bucketing_impl(input, key_func, num_buckets, bucket_sizes, results, first, last);
+        return;
+      }
+
+      bucket_sizes.resize(num_buckets, 0);
+      size_t len = l - f;
+
+      // split the bucket id bits in half.
+      size_t bits = 0;
+      while ((1UL << bits) < static_cast<size_t>(num_buckets)) ++bits;
+      size_t const shift = bits >> 1;
+      size_t const ngroups = ((static_cast<size_t>(num_buckets) - 1) >> shift) + 1;
+
+      // [1st pass]: compute bucket counts and input to bucket assignment.
+      std::vector<ASSIGN_TYPE> i2o(len);
+      assign_batch(input.data() + f, len, key_func, i2o.data());
+      for (size_t i = 0; i < len; ++i) {
+          assert(((0 <= i2o[i]) && ((size_t)i2o[i] < num_buckets)) && "assigned bucket id is not valid");
+
+          ++bucket_sizes[i2o[i]];
+      }
+      ASSIGN_TYPE p;
+
+      // bucket offsets (exclusive prefix sum), relative to f.  group offset is that of its first bucket.
+      std::vector<size_t> offsets(num_buckets, 0);
+      for (size_t i = 1; i < static_cast<size_t>(num_buckets); ++i) {
+        offsets[i] = offsets[i-1] + bucket_sizes[i-1];
+      }
+      std::vector<size_t> group_offsets(ngroups, 0);
+      for (size_t g = 0; g < ngroups; ++g) {
+        group_offsets[g] = offsets[g << shift];
+      }
+
+      // [2nd pass]: scatter to the high digit groups.
+      using E = std::pair<ASSIGN_TYPE, T>;
+      scatter_buffer<E> tmp(len);
+      {
+        write_combining_scatter<E> scatter(group_offsets, tmp.data());
+        for (size_t i = f; i < l; ++i) {
+          p = i2o[i - f];
+          scatter.push(static_cast<size_t>(p) >> shift, E(p, input[i]));
+        }
+        scatter.flush();
+      }
+      std::vector<ASSIGN_TYPE>().swap(i2o);
+
+      // [3rd pass]: scatter each group into its buckets.  writes are confined to the group's output range.
+      results.resize(input.size());
+      T* out = results.data() + f;
+      for (size_t i = 0; i < len; ++i) {
+        out[offsets[tmp[i].first]++] = tmp[i].second;
+      }
+    }
+
     /**
      * @brief   compute the element index mapping between input and bucketed output.
      *
@@ -308,14 +503,11 @@ namespace imxx
 
         // [1st pass]: compute bucket counts and input2bucket assignment.
         // store input2bucket assignment in i2o temporarily.
-        size_t p;
+        assign_batch(input.data() + f, l - f, key_func, i2o.data() + f);
         for (size_t i = f; i < l; ++i) {
-            p = key_func(input[i]);
-
-            assert(((0 <= p) && ((size_t)p < num_buckets)) && "assigned bucket id is not valid");
+            assert(((0 <= i2o[i]) && ((size_t)i2o[i] < num_buckets)) && "assigned bucket id is not valid");
 
-            i2o[i] = p;
-            ++bucket_sizes[p];
+            ++bucket_sizes[i2o[i]];
         }
 
     }
@@ -620,6 +812,82 @@ namespace imxx
 
 
 
+    /**
+     * @brief  2 pass (radix style) version of permute, for large ranges.
+     * @details  permute writes each element to a random position in the whole output range, so each write is
+     *       likely a cache and TLB miss.  here the output range is divided into contiguous windows.  the first pass
+     *       scatters the elements, with their positions, into the windows through write-combining buffers.  the
+     *       second pass writes each window's elements to their positions, which are within a small region.
+     *       uses a temporary of len * (sizeof(size_t) + sizeof(T)).
+     *
+     *       same contract as permute:  the range maps to itself.
+     */
+    template <typename IT, typename OT, typename MT>
+    void permute_radix(IT unbucketed, IT unbucketed_end,
+        MT i2o, OT bucketed,
+        size_t const & bucketed_pos_offset) {
+
+      static_assert(std::is_same<typename std::iterator_traits<IT>::value_type,
+          typename std::iterator_traits<OT>::value_type>::value,
+        "ERROR: IT and OT should be iterators with same value types");
+      static_assert(std::is_integral<typename std::iterator_traits<MT>::value_type>::value,
+        "ERROR: MT should be an iterator of integral type value");
+
+      using T = typename std::iterator_traits<IT>::value_type;
+
+      size_t len = std::distance(unbucketed, unbucketed_end);
+        // if input is empty, simply return
+        if (len == 0) return;
+
+        assert((*(std::min_element(i2o, i2o + len)) == bucketed_pos_offset) &&
+            (*(std::max_element(i2o, i2o + len)) == ( bucketed_pos_offset + len - 1)) &&
+        "ERROR, i2o [first, last) does not map to itself");
+
+        // window size:  about sqrt(len) windows, at most radix_max_groups, and at least 1 WC buffer per window.
+        using E = std::pair<size_t, T>;
+        size_t const min_window = write_combining_scatter<E>::capacity;
+        size_t shift = 0;
+        while (((len >> shift) > radix_max_groups) ||
+               (((1UL << shift) < min_window) && ((1UL << shift) < len)) ||
+               ((1UL << (2 * shift)) < len)) ++shift;
+        size_t const ngroups = ((len - 1) >> shift) + 1;
+
+        // window offsets are known directly, since the mapping is a permutation.
+        std::vector<size_t> group_offsets(ngroups, 0);
+        for (size_t g = 0; g < ngroups; ++g) {
+          group_offsets[g] = g << shift;
+        }
+
+        // [1st pass]: scatter to the windows.
+        scatter_buffer<E> tmp(len);
+        {
+          write_combining_scatter<E> scatter(group_offsets, tmp.data());
+          size_t pos;
+          for (; unbucketed != unbucketed_end; ++unbucketed, ++i2o) {
+            pos = *i2o - bucketed_pos_offset;
+            scatter.push(pos >> shift, E(pos, *unbucketed));
+          }
+          scatter.flush();
+        }
+
+        // [2nd pass]: write each window.
+        for (size_t i = 0; i < len; ++i) {
+          *(bucketed + tmp[i].first) = tmp[i].second;
+        }
+    }
+
+    /// permute for bucketed communication.  uses permute_radix when there are more than radix_bucketing_threshold buckets.
+    template <typename IT, typename OT, typename MT>
+    void bucket_permute(IT unbucketed, IT unbucketed_end,
+        MT i2o, OT bucketed,
+        size_t const & bucketed_pos_offset, size_t const & num_buckets) {
+      if (num_buckets > radix_bucketing_threshold)
+        permute_radix(unbucketed, unbucketed_end, i2o, bucketed, bucketed_pos_offset);
+      else
+        permute(unbucketed, unbucketed_end, i2o, bucketed, bucketed_pos_offset);
+    }
+
+
     /**
      * @brief inplace permute.  at most 2n steps, as we need to check each entry for completion.
      * @details	also need i2o to be a signed integer, so we can use the sign bit to check
@@ -977,17 +1245,26 @@ namespace imxx
                      size_t send_offset = 0, size_t recv_offset = 0, mxx::comm const & comm = mxx::comm()) {
 
 	    bool empty = ((input.size() == 0) || (send_count == 0));
-	    empty = mxx::all_of(empty);
+	    empty = mxx::all_of(empty, comm);
 	    if (empty) {
 	      return;
 	    }
+    BL_COMM_INIT(block_a2a);
+    BL_COMM_START(block_a2a);
 
     // ensure enough space
     assert((input.size() >= (send_offset + send_count * comm.size())) && "input for block_all2all not big enough");
     assert((output.size() >= (recv_offset + send_count * comm.size())) && "output for block_all2all not big enough");
 
     // send via mxx all2all - leverage any large message support from mxx.  (which uses datatype.contiguous() to increase element size and reduce element count to 1)
+    BL_COMM_MPI_START(block_a2a);
+    BL_TRACE_BEGIN("all2all");
     ::mxx::all2all(&(input[send_offset]), send_count, &(output[recv_offset]), comm);
+    BL_TRACE_END("all2all");
+    BL_COMM_MPI_END(block_a2a);
+
+    BL_COMM_END_TOTALS(block_a2a, "a2a", send_count * comm.size(), send_count * comm.size(), send_count, send_count, sizeof(T));
+    BL_COMM_REPORT_MPI_NAMED(block_a2a, "imxx:block_all2all", comm);
   }
 
   /**
@@ -1005,11 +1282,13 @@ namespace imxx
                      size_t offset = 0, mxx::comm const & comm = mxx::comm()) {
 
 	    bool empty = ((input.size() == 0) || (send_count == 0));
-	    empty = mxx::all_of(empty);
+	    empty = mxx::all_of(empty, comm);
 	    if (empty) {
 	      return;
 	    }
-
+    BL_COMM_INIT(block_a2a);
+    BL_COMM_START(block_a2a);
+    size_t block_count = send_count;
 
     // ensure enough space
     assert((input.size() >= (offset + send_count * comm.size())) && "input for block_all2all not big enough");
@@ -1021,13 +1300,357 @@ namespace imxx
     if ((send_count * comm.size()) < mxx::max_int) {
       dt = mxx::get_datatype<T>();
     } else {
-      // create a contiguous data type to support large messages (send_count * comm.size() > mxx::max_int).
-      dt = mxx::get_datatype<T>().contiguous(send_count);
-      send_count = 1;
+        // create a contiguous data type to support large messages (send_count * comm.size() > mxx::max_int).
+        dt = mxx::get_datatype<T>().contiguous(send_count);
+        send_count = 1;
     }
 
     // send using special mpi keyword MPI_IN_PLACE. should work for MPI_Alltoall.
+    BL_COMM_MPI_START(block_a2a);
     MPI_Alltoall(MPI_IN_PLACE, send_count, dt.type(), const_cast<T*>(&(input[offset])), send_count, dt.type(), comm);
+    BL_COMM_MPI_END(block_a2a);
+
+    BL_COMM_END_TOTALS(block_a2a, "a2a_inplace", block_count * comm.size(), block_count * comm.size(), block_count, block_count, sizeof(T));
+    BL_COMM_REPORT_MPI_NAMED(block_a2a, "imxx:block_all2all_inplace", comm);
+  }
+
+  /// smallest and largest per rank message sizes, in bytes, swept by tune_block_all2all_chunk_bytes.  4x apart.
+  constexpr size_t block_a2a_chunk_min_bytes = 1UL << 10;
+  constexpr size_t block_a2a_chunk_max_bytes = 1UL << 22;
+  /// the knee is the smallest message size that reaches this fraction of the best measured bandwidth.
+  constexpr double block_a2a_knee_fraction = 0.8;
+
+  /// BL_A2A_CHUNK_BYTES sets the per rank chunk size of block_all2all_pipelined, in bytes.  0 if not set:  tuned.
+  inline size_t block_a2a_chunk_bytes_from_env() {
+    char const * v = ::std::getenv("BL_A2A_CHUNK_BYTES");
+    if (v == nullptr) return 0;
+    return ::std::strtoul(v, nullptr, 10);
+  }
+
+  /**
+   * @brief sweep all2all message sizes and return the per rank size at the latency/bandwidth knee.
+   * @details  sizes from block_a2a_chunk_min_bytes to block_a2a_chunk_max_bytes, 4x apart, with the total send buffer capped
+   *           at 64MB.  each size is timed as the best of 3 MPI_Alltoall, max over ranks so all ranks pick the same size.  collective.
+   */
+  inline size_t tune_block_all2all_chunk_bytes(::mxx::comm const & comm) {
+    size_t p = comm.size();
+    size_t max_bytes = ::std::max(block_a2a_chunk_min_bytes, ::std::min(block_a2a_chunk_max_bytes, (64UL << 20) / p));
+
+    ::std::vector<char> sendbuf(max_bytes * p, 0);
+    ::std::vector<char> recvbuf(max_bytes * p);
+
+    ::std::vector<size_t> sizes;
+    for (size_t s = block_a2a_chunk_min_bytes; s <= max_bytes; s <<= 2) sizes.emplace_back(s);
+
+    ::std::vector<double> times(sizes.size(), ::std::numeric_limits<double>::max());
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      for (int rep = 0; rep < 3; ++rep) {
+        comm.barrier();
+        double t = MPI_Wtime();
+        MPI_Alltoall(sendbuf.data(), sizes[i], MPI_BYTE, recvbuf.data(), sizes[i], MPI_BYTE, comm);
+        times[i] = ::std::min(times[i], MPI_Wtime() - t);
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, times.data(), times.size(), MPI_DOUBLE, MPI_MAX, comm);
+
+    // bandwidth per size, then the smallest size near the best.
+    ::std::vector<double> bw(sizes.size());
+    double best = 0.0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      bw[i] = static_cast<double>(sizes[i]) / ::std::max(times[i], 1e-9);
+      best = ::std::max(best, bw[i]);
+    }
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      if (bw[i] >= block_a2a_knee_fraction * best) return sizes[i];
+    }
+    return sizes.back();
+  }
+
+  /// frees the chunk size cached by block_all2all_chunk_bytes when the communicator is freed.
+  inline int free_block_a2a_chunk_bytes(MPI_Comm, int, void * attr, void *) {
+    delete static_cast<size_t *>(attr);
+    return MPI_SUCCESS;
+  }
+
+  /**
+   * @brief per rank chunk size, in bytes, for block_all2all_pipelined on comm.
+   * @details  BL_A2A_CHUNK_BYTES if set.  otherwise tuned by tune_block_all2all_chunk_bytes on the first call and cached
+   *           as an attribute of comm, so only the first call on a communicator is collective.
+   */
+  inline size_t block_all2all_chunk_bytes(::mxx::comm const & comm) {
+    size_t env = block_a2a_chunk_bytes_from_env();
+    if (env > 0) return env;
+
+    static int keyval = MPI_KEYVAL_INVALID;
+    if (keyval == MPI_KEYVAL_INVALID)
+      MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, free_block_a2a_chunk_bytes, &keyval, nullptr);
+
+    void * attr = nullptr;
+    int found = 0;
+    MPI_Comm_get_attr(comm, keyval, &attr, &found);
+    if (found) return *(static_cast<size_t *>(attr));
+
+    size_t * bytes = new size_t(tune_block_all2all_chunk_bytes(comm));
+    MPI_Comm_set_attr(comm, keyval, bytes);
+    return *bytes;
+  }
+
+  /**
+   * @brief block_all2all in chunks, calling compute on each received chunk while the next is in flight.
+   * @details  each chunk carries chunk_count elements of every bucket, chunk_count from block_all2all_chunk_bytes.
+   *           chunks are strided MPI_Ialltoall into the final positions, so output is laid out as by block_all2all.
+   *           compute(offset, count) is called once per chunk, in order:  elements [offset, offset + count) of every
+   *           received bucket, i.e. output[recv_offset + r * send_count + offset ...] for each rank r, are ready.
+   *           at most 2 chunks are in flight.
+   *
+   * @param input     bucketed as p blocks of send_count, starting at send_offset.
+   * @param send_count   number to send to each processor
+   * @param output    buffer to store the result
+   * @param compute   called as compute(offset, count) for each chunk that has arrived.
+   * @param send_offset    offset in input from which to start sending.
+   * @param recv_offset    offset in output from which to start writing.
+   * @param comm    communicator
+   * @param chunk_bytes    per rank chunk size in bytes.  0 for block_all2all_chunk_bytes(comm).
+   */
+  template <typename T, typename Compute>
+  void block_all2all_pipelined(std::vector<T> const & input, size_t send_count, std::vector<T> & output,
+                               Compute const & compute,
+                               size_t send_offset = 0, size_t recv_offset = 0, mxx::comm const & comm = mxx::comm(),
+                               size_t chunk_bytes = 0) {
+
+    bool empty = ((input.size() == 0) || (send_count == 0));
+    empty = mxx::all_of(empty, comm);
+    if (empty) {
+      return;
+    }
+
+    if (chunk_bytes == 0) chunk_bytes = block_all2all_chunk_bytes(comm);
+    size_t chunk_count = ::std::max(chunk_bytes / sizeof(T), static_cast<size_t>(1));
+    // elements per MPI message must fit an int.
+    chunk_count = ::std::min(chunk_count, static_cast<size_t>(::std::numeric_limits<int>::max()));
+
+    // 1 chunk:  nothing to overlap.
+    if (chunk_count >= send_count) {
+      block_all2all(input, send_count, output, send_offset, recv_offset, comm);
+      compute(0, send_count);
+      return;
+    }
+
+    BL_COMM_INIT(block_a2a);
+    BL_COMM_START(block_a2a);
+
+    assert((input.size() >= (send_offset + send_count * comm.size())) && "input for block_all2all_pipelined not big enough");
+    assert((output.size() >= (recv_offset + send_count * comm.size())) && "output for block_all2all_pipelined not big enough");
+
+    ::mxx::datatype dt = ::mxx::get_datatype<T>();
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(dt.type(), &lb, &extent);
+
+    // chunk_count elements per bucket, buckets send_count apart.  the last chunk may be shorter.
+    auto make_type = [&dt, &extent, &send_count](size_t count) {
+      MPI_Datatype contig, strided;
+      MPI_Type_contiguous(count, dt.type(), &contig);
+      MPI_Type_create_resized(contig, 0, extent * send_count, &strided);
+      MPI_Type_commit(&strided);
+      MPI_Type_free(&contig);
+      return strided;
+    };
+    size_t nchunks = (send_count + chunk_count - 1) / chunk_count;
+    size_t last_count = send_count - (nchunks - 1) * chunk_count;
+    MPI_Datatype full_type = make_type(chunk_count);
+    MPI_Datatype last_type = (last_count == chunk_count) ? full_type : make_type(last_count);
+
+    BL_COMM_MPI_START(block_a2a);
+    BL_TRACE_BEGIN("all2all_pipelined");
+    MPI_Request reqs[2];
+    auto post = [&](size_t j) {
+      MPI_Ialltoall(&(input[send_offset + j * chunk_count]), 1, (j + 1 == nchunks) ? last_type : full_type,
+                    &(output[recv_offset + j * chunk_count]), 1, (j + 1 == nchunks) ? last_type : full_type,
+                    comm, &(reqs[j & 1]));
+    };
+    post(0);
+    for (size_t j = 0; j < nchunks; ++j) {
+      if ((j + 1) < nchunks) post(j + 1);
+      MPI_Wait(&(reqs[j & 1]), MPI_STATUS_IGNORE);
+      compute(j * chunk_count, (j + 1 == nchunks) ? last_count : chunk_count);
+    }
+    BL_TRACE_END("all2all_pipelined");
+    BL_COMM_MPI_END(block_a2a);
+
+    if (last_type != full_type) MPI_Type_free(&last_type);
+    MPI_Type_free(&full_type);
+
+    BL_COMM_END_TOTALS(block_a2a, "a2a_pipelined", send_count * comm.size(), send_count * comm.size(), send_count, send_count, sizeof(T));
+    BL_COMM_REPORT_MPI_NAMED(block_a2a, "imxx:block_all2all_pipelined", comm);
+  }
+
+
+  /// ranks below which the dense all2all is always used.
+  constexpr int sparse_exchange_min_ranks = 16;
+  /// the sparse exchange is used when every rank sends to at most 1 in this many ranks.
+  constexpr size_t sparse_exchange_ratio = 8;
+
+  /// BL_SPARSE_EXCHANGE=0 disables the sparse exchange, 1 forces it.  -1 if not set:  chosen by use_sparse_exchange.
+  inline int sparse_exchange_from_env() {
+    char const * v = ::std::getenv("BL_SPARSE_EXCHANGE");
+    if (v == nullptr) return -1;
+    return (::std::strtoul(v, nullptr, 10) != 0) ? 1 : 0;
+  }
+
+  /// duplicate communicator of sparse_all2allv, and the number of exchanges on it so far.
+  struct sparse_exchange_state {
+      MPI_Comm comm;
+      unsigned int epoch;
+  };
+
+  /// frees the duplicate communicator cached by sparse_exchange_comm when the original is freed.
+  inline int free_sparse_exchange_comm(MPI_Comm, int, void * attr, void *) {
+    sparse_exchange_state * state = static_cast<sparse_exchange_state *>(attr);
+    MPI_Comm_free(&(state->comm));
+    delete state;
+    return MPI_SUCCESS;
+  }
+
+  /**
+   * @brief a duplicate of comm for the point to point messages of sparse_all2allv, so they never match the caller's messages.
+   * @details  cached as an attribute of comm, so only the first call on a communicator makes the collective MPI_Comm_dup.
+   *           the attribute also counts the exchanges, so that each one can use its own tag.
+   */
+  inline sparse_exchange_state & sparse_exchange_comm(::mxx::comm const & comm) {
+    static int const keyval = []() {
+      int k = MPI_KEYVAL_INVALID;
+      MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, free_sparse_exchange_comm, &k, nullptr);
+      return k;
+    }();
+
+    void * attr = nullptr;
+    int found = 0;
+    MPI_Comm_get_attr(comm, keyval, &attr, &found);
+    if (found) return *(static_cast<sparse_exchange_state *>(attr));
+
+    sparse_exchange_state * state = new sparse_exchange_state();
+    MPI_Comm_dup(comm, &(state->comm));
+    state->epoch = 0;
+    MPI_Comm_set_attr(comm, keyval, state);
+    return *state;
+  }
+
+  /**
+   * @brief tag of the next exchange on state's communicator, in [1, MPI_TAG_UB].
+   * @details  a rank can leave an exchange and send the messages of the next one while a slower rank still probes for
+   *           the current one, so consecutive exchanges must not share a tag.  exchanges are collective, so all ranks
+   *           count the same epochs.  a rank is at most 1 exchange ahead, so the wrap around is safe.
+   */
+  inline int next_sparse_exchange_tag(sparse_exchange_state & state) {
+    static int const tag_ub = []() {
+      void * attr = nullptr;
+      int found = 0;
+      MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_TAG_UB, &attr, &found);
+      return found ? *(static_cast<int *>(attr)) : 32767;   // 32767 is the least the standard allows.
+    }();
+    int tag = 1 + static_cast<int>(state.epoch % static_cast<unsigned int>(tag_ub));
+    ++state.epoch;
+    return tag;
+  }
+
+  /**
+   * @brief true if all ranks send to few enough ranks for sparse_all2allv to beat the dense all2all of counts and all2allv.
+   * @details  1 allreduce of the largest number of destinations, vs the O(p) all2all of counts.  BL_SPARSE_EXCHANGE overrides.
+   *           counts that do not fit an int message keep the dense exchange.  collective.
+   */
+  template <typename SIZE>
+  bool use_sparse_exchange(::std::vector<SIZE> const & send_counts, ::mxx::comm const & comm) {
+    if (comm.size() == 1) return false;
+    int mode = sparse_exchange_from_env();
+    if (mode >= 0) return mode == 1;
+    if (comm.size() < sparse_exchange_min_ranks) return false;
+
+    size_t nnz = 0;
+    bool fits = true;
+    for (auto c : send_counts) {
+      nnz += (c > 0) ? 1 : 0;
+      fits &= (static_cast<size_t>(c) < static_cast<size_t>(mxx::max_int));
+    }
+    if (!fits) nnz = comm.size();
+    nnz = ::mxx::allreduce(nnz, ::mxx::max<size_t>(), comm);
+    return (nnz * sparse_exchange_ratio) <= static_cast<size_t>(comm.size());
+  }
+
+  /**
+   * @brief all2allv that only communicates with the ranks that have data, by nonblocking consensus (NBX, Hoefler et al. 2010).
+   * @details  each rank sends its nonempty buckets with MPI_Issend and receives whatever arrives, by MPI_Iprobe.  a rank
+   *           whose sends are all matched enters an MPI_Ibarrier.  the barrier completes when all sends everywhere are
+   *           matched, i.e. all messages have been received.  the cost is proportional to the number of messages,
+   *           plus a barrier, instead of to the number of ranks.
+   *           output and recv_counts are as from all2all of the counts and all2allv:  received data in source rank order.
+   * @param input        send_counts[i] elements for rank i, in rank order.
+   * @param send_counts  elements for each rank.  each less than mxx::max_int.
+   */
+  template <typename V, typename SIZE, typename RSIZE>
+  void sparse_all2allv(V const * input, ::std::vector<SIZE> const & send_counts,
+                       ::std::vector<V> & output, ::std::vector<RSIZE> & recv_counts, ::mxx::comm const & comm) {
+    sparse_exchange_state & state = sparse_exchange_comm(comm);
+    MPI_Comm c = state.comm;
+    int const tag = next_sparse_exchange_tag(state);
+    ::mxx::datatype dt = ::mxx::get_datatype<V>();
+
+    ::std::vector<MPI_Request> sends;
+    size_t offset = 0;
+    for (int i = 0; i < comm.size(); ++i) {
+      if (send_counts[i] > 0) {
+        assert((static_cast<size_t>(send_counts[i]) < static_cast<size_t>(mxx::max_int)) && "send count too large for sparse_all2allv");
+        sends.emplace_back();
+        MPI_Issend(const_cast<V*>(input + offset), static_cast<int>(send_counts[i]), dt.type(), i, tag, c, &(sends.back()));
+      }
+      offset += send_counts[i];
+    }
+
+    // (source, data) of the messages, in arrival order.
+    ::std::vector<::std::pair<int, ::std::vector<V> > > received;
+    MPI_Request barrier = MPI_REQUEST_NULL;
+    bool in_barrier = false;
+    int done = 0;
+    while (!done) {
+      int arrived = 0;
+      MPI_Status status;
+      MPI_Iprobe(MPI_ANY_SOURCE, tag, c, &arrived, &status);
+      if (arrived) {
+        int n = 0;
+        MPI_Get_count(&status, dt.type(), &n);
+        received.emplace_back(status.MPI_SOURCE, ::std::vector<V>(n));
+        MPI_Recv(received.back().second.data(), n, dt.type(), status.MPI_SOURCE, tag, c, MPI_STATUS_IGNORE);
+      }
+
+      if (in_barrier) {
+        MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+      } else {
+        int sent = 0;
+        MPI_Testall(static_cast<int>(sends.size()), sends.data(), &sent, MPI_STATUSES_IGNORE);
+        if (sent) {
+          MPI_Ibarrier(c, &barrier);
+          in_barrier = true;
+        }
+      }
+    }
+
+    // at most 1 message per source.  place them in source order.
+    ::std::sort(received.begin(), received.end(),
+                [](::std::pair<int, ::std::vector<V> > const & x, ::std::pair<int, ::std::vector<V> > const & y) {
+      return x.first < y.first;
+    });
+    recv_counts.assign(comm.size(), 0);
+    size_t total = 0;
+    for (auto const & r : received) {
+      recv_counts[r.first] = r.second.size();
+      total += r.second.size();
+    }
+    if (output.capacity() < total) output.clear();
+    output.resize(total);
+    offset = 0;
+    for (auto const & r : received) {
+      ::std::copy(r.second.begin(), r.second.end(), output.begin() + offset);
+      offset += r.second.size();
+    }
   }
 
 
@@ -1046,7 +1669,7 @@ namespace imxx
 
     BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
     bool empty = input.size() == 0;
-    empty = mxx::all_of(empty);
+    empty = mxx::all_of(empty, _comm);
     BL_BENCH_END(distribute, "empty", input.size());
 
     if (empty) {
@@ -1055,6 +1678,9 @@ namespace imxx
     }
     // speed over mem use.  mxx all2allv already has to double memory usage. same as stable distribute.
 
+    BL_COMM_INIT(distribute);
+    BL_COMM_START(distribute);
+
     BL_BENCH_START(distribute);
     std::vector<SIZE> send_counts(_comm.size(), 0);
     i2o.resize(input.size());
@@ -1062,7 +1688,9 @@ namespace imxx
 
     // bucketing
     BL_BENCH_START(distribute);
+    BL_TRACE_BEGIN("bucket");
     imxx::local::assign_to_buckets(input, to_rank, _comm.size(), send_counts, i2o, 0, input.size());
+    BL_TRACE_END("bucket");
     BL_BENCH_COLLECTIVE_END(distribute, "bucket", input.size(), _comm);
 
     BL_BENCH_START(distribute);
@@ -1078,25 +1706,42 @@ namespace imxx
 
     BL_BENCH_START(distribute);
     // distribute (communication part)
-    imxx::local::permute(output.begin(), output.end(), i2o.begin(), input.begin(), 0);  // input now holds permuted entries.
+    imxx::local::bucket_permute(output.begin(), output.end(), i2o.begin(), input.begin(), 0, _comm.size());  // input now holds permuted entries.
     BL_BENCH_COLLECTIVE_END(distribute, "permute", input.size(), _comm);
 
-    // distribute (communication part)
-    BL_BENCH_START(distribute);
-    recv_counts.resize(_comm.size());
-    mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
-    size_t total = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
-    BL_BENCH_COLLECTIVE_END(distribute, "a2a_count", recv_counts.size(), _comm);
+    if (use_sparse_exchange(send_counts, _comm)) {
+      // few destinations:  exchange with those only, and learn the recv counts from the messages.
+      BL_BENCH_START(distribute);
+      BL_COMM_MPI_START(distribute);
+      BL_TRACE_BEGIN("sparse_all2all");
+      sparse_all2allv(input.data(), send_counts, output, recv_counts, _comm);
+      BL_TRACE_END("sparse_all2all");
+      BL_COMM_MPI_END(distribute);
+      BL_BENCH_END(distribute, "sparse_a2a", output.size());
+    } else {
+      // distribute (communication part)
+      BL_BENCH_START(distribute);
+      recv_counts.resize(_comm.size());
+      BL_COMM_MPI_START(distribute);
+      mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
+      BL_COMM_MPI_END(distribute);
+      size_t total = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
+      BL_BENCH_COLLECTIVE_END(distribute, "a2a_count", recv_counts.size(), _comm);
 
-    BL_BENCH_START(distribute);
-    // now resize output
-    if (output.capacity() < total) output.clear();
-    output.resize(total);
-    BL_BENCH_COLLECTIVE_END(distribute, "realloc_out", output.size(), _comm);
+      BL_BENCH_START(distribute);
+      // now resize output
+      if (output.capacity() < total) output.clear();
+      output.resize(total);
+      BL_BENCH_COLLECTIVE_END(distribute, "realloc_out", output.size(), _comm);
 
-    BL_BENCH_START(distribute);
-    mxx::all2allv(input.data(), send_counts, output.data(), recv_counts, _comm);
-    BL_BENCH_END(distribute, "a2a", output.size());
+      BL_BENCH_START(distribute);
+      BL_COMM_MPI_START(distribute);
+      BL_TRACE_BEGIN("all2all");
+      exchange_all2allv(input.data(), send_counts, output.data(), recv_counts, _comm);
+      BL_TRACE_END("all2all");
+      BL_COMM_MPI_END(distribute);
+      BL_BENCH_END(distribute, "a2a", output.size());
+    }
 
     if (preserve_input) {
       BL_BENCH_START(distribute);
@@ -1104,10 +1749,67 @@ namespace imxx
       imxx::local::unpermute_inplace(input, i2o, 0, input.size());
       BL_BENCH_END(distribute, "unpermute_inplace", input.size());
     }
+    BL_COMM_END(distribute, "distribute", send_counts, recv_counts, sizeof(V));
+    BL_COMM_REPORT_MPI_NAMED(distribute, "imxx:distribute", _comm);
     BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:distribute", _comm);
 
   }
 
+  /**
+   * @brief distribute a struct of arrays buffer.  to_rank is called on the keys only, and the keys and the values are
+   *        permuted and exchanged as 2 arrays, so neither carries the padding of a (key, value) pair.
+   * @details  input is left in the permuted, bucketed order.  output is cleared if all inputs are empty.
+   */
+  template <typename K, typename T, typename ToRank, typename SIZE>
+  void distribute(::fsc::soa_vector<K, T>& input, ToRank const & to_rank,
+                  ::std::vector<SIZE> & recv_counts,
+                  ::std::vector<SIZE> & i2o,
+                  ::fsc::soa_vector<K, T>& output,
+                  ::mxx::comm const &_comm) {
+    BL_BENCH_INIT(distribute);
+
+    BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
+    bool empty = input.size() == 0;
+    empty = mxx::all_of(empty, _comm);
+    BL_BENCH_END(distribute, "empty", input.size());
+
+    if (empty) {
+      output.clear();
+      recv_counts.assign(_comm.size(), 0);
+      BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:distribute_soa", _comm);
+      return;
+    }
+
+    BL_BENCH_START(distribute);
+    std::vector<SIZE> send_counts(_comm.size(), 0);
+    i2o.resize(input.size());
+    imxx::local::assign_to_buckets(input.keys, to_rank, _comm.size(), send_counts, i2o, 0, input.size());
+    imxx::local::bucket_to_permutation(send_counts, i2o, 0, input.size());
+    BL_BENCH_COLLECTIVE_END(distribute, "bucket", input.size(), _comm);
+
+    BL_BENCH_START(distribute);
+    output.resize(input.size());
+    output.swap(input);
+    imxx::local::bucket_permute(output.keys.begin(), output.keys.end(), i2o.begin(), input.keys.begin(), 0, _comm.size());
+    imxx::local::bucket_permute(output.values.begin(), output.values.end(), i2o.begin(), input.values.begin(), 0, _comm.size());
+    BL_BENCH_COLLECTIVE_END(distribute, "permute", input.size(), _comm);
+
+    BL_BENCH_START(distribute);
+    recv_counts.resize(_comm.size());
+    mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
+    size_t total = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
+    output.clear();
+    output.resize(total);
+    BL_BENCH_COLLECTIVE_END(distribute, "a2a_count", recv_counts.size(), _comm);
+
+    BL_BENCH_START(distribute);
+    exchange_all2allv(input.keys.data(), send_counts, output.keys.data(), recv_counts, _comm);
+    exchange_all2allv(input.values.data(), send_counts, output.values.data(), recv_counts, _comm);
+    BL_BENCH_END(distribute, "a2a", output.size());
+
+    BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:distribute_soa", _comm);
+  }
+
   template <typename V, typename ToRank, typename SIZE>
   void distribute(::std::vector<V>& input, ToRank const & to_rank,
                   ::std::vector<SIZE> & recv_counts,
@@ -1117,7 +1819,7 @@ namespace imxx
 
     BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
     bool empty = input.size() == 0;
-    empty = mxx::all_of(empty);
+    empty = mxx::all_of(empty, _comm);
     BL_BENCH_END(distribute, "empty", input.size());
 
     if (empty) {
@@ -1126,6 +1828,9 @@ namespace imxx
     }
     // speed over mem use.  mxx all2allv already has to double memory usage. same as stable distribute.
 
+    BL_COMM_INIT(distribute);
+    BL_COMM_START(distribute);
+
     BL_BENCH_START(distribute);
     std::vector<SIZE> send_counts(_comm.size(), 0);
     BL_BENCH_END(distribute, "alloc_map", input.size());
@@ -1138,36 +1843,66 @@ namespace imxx
 
     // bucketing
     BL_BENCH_START(distribute);
+    BL_TRACE_BEGIN("bucket");
     size_t comm_size = _comm.size();
     if (comm_size <= std::numeric_limits<uint8_t>::max()) {
       imxx::local::bucketing_impl(output, to_rank, static_cast< uint8_t>(comm_size), send_counts, input, 0, output.size());
     } else if (comm_size <= std::numeric_limits<uint16_t>::max()) {
-      imxx::local::bucketing_impl(output, to_rank, static_cast<uint16_t>(comm_size), send_counts, input, 0, output.size());
+      if (comm_size > imxx::local::radix_bucketing_threshold)
+        imxx::local::bucketing_radix_impl(output, to_rank, static_cast<uint16_t>(comm_size), send_counts, input, 0, output.size());
+      else
+        imxx::local::bucketing_impl(output, to_rank, static_cast<uint16_t>(comm_size), send_counts, input, 0, output.size());
     } else if (comm_size <= std::numeric_limits<uint32_t>::max()) {
-      imxx::local::bucketing_impl(output, to_rank, static_cast<uint32_t>(comm_size), send_counts, input, 0, output.size());
+      if (comm_size > imxx::local::radix_bucketing_threshold)
+        imxx::local::bucketing_radix_impl(output, to_rank, static_cast<uint32_t>(comm_size), send_counts, input, 0, output.size());
+      else
+        imxx::local::bucketing_impl(output, to_rank, static_cast<uint32_t>(comm_size), send_counts, input, 0, output.size());
     } else {
-      imxx::local::bucketing_impl(output, to_rank, static_cast<uint64_t>(comm_size), send_counts, input, 0, output.size());
+      if (comm_size > imxx::local::radix_bucketing_threshold)
+        imxx::local::bucketing_radix_impl(output, to_rank, static_cast<uint64_t>(comm_size), send_counts, input, 0, output.size());
+      else
+        imxx::local::bucketing_impl(output, to_rank, static_cast<uint64_t>(comm_size), send_counts, input, 0, output.size());
     }
+    BL_TRACE_END("bucket");
     BL_BENCH_COLLECTIVE_END(distribute, "bucket", input.size(), _comm);
 
 
-    // distribute (communication part)
-    BL_BENCH_START(distribute);
-    recv_counts.resize(_comm.size());
-    mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
-    size_t total = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
-    BL_BENCH_COLLECTIVE_END(distribute, "a2a_count", recv_counts.size(), _comm);
+    if (use_sparse_exchange(send_counts, _comm)) {
+      // few destinations:  exchange with those only, and learn the recv counts from the messages.
+      BL_BENCH_START(distribute);
+      BL_COMM_MPI_START(distribute);
+      BL_TRACE_BEGIN("sparse_all2all");
+      sparse_all2allv(input.data(), send_counts, output, recv_counts, _comm);
+      BL_TRACE_END("sparse_all2all");
+      BL_COMM_MPI_END(distribute);
+      BL_BENCH_END(distribute, "sparse_a2a", output.size());
+    } else {
+      // distribute (communication part)
+      BL_BENCH_START(distribute);
+      recv_counts.resize(_comm.size());
+      BL_COMM_MPI_START(distribute);
+      mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
+      BL_COMM_MPI_END(distribute);
+      size_t total = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
+      BL_BENCH_COLLECTIVE_END(distribute, "a2a_count", recv_counts.size(), _comm);
 
-    BL_BENCH_START(distribute);
-    // now resize output
-    if (output.capacity() < total) output.clear();
-    output.resize(total);
-    BL_BENCH_COLLECTIVE_END(distribute, "realloc_out", output.size(), _comm);
+      BL_BENCH_START(distribute);
+      // now resize output
+      if (output.capacity() < total) output.clear();
+      output.resize(total);
+      BL_BENCH_COLLECTIVE_END(distribute, "realloc_out", output.size(), _comm);
 
-    BL_BENCH_START(distribute);
-    mxx::all2allv(input.data(), send_counts, output.data(), recv_counts, _comm);
-    BL_BENCH_END(distribute, "a2a", output.size());
+      BL_BENCH_START(distribute);
+      BL_COMM_MPI_START(distribute);
+      BL_TRACE_BEGIN("all2all");
+      exchange_all2allv(input.data(), send_counts, output.data(), recv_counts, _comm);
+      BL_TRACE_END("all2all");
+      BL_COMM_MPI_END(distribute);
+      BL_BENCH_END(distribute, "a2a", output.size());
+    }
 
+    BL_COMM_END(distribute, "distribute", send_counts, recv_counts, sizeof(V));
+    BL_COMM_REPORT_MPI_NAMED(distribute, "imxx:distribute_bucket", _comm);
     BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:distribute_bucket", _comm);
 
   }
@@ -1182,29 +1917,47 @@ namespace imxx
 
     BL_BENCH_COLLECTIVE_START(undistribute, "empty", _comm);
     bool empty = input.size() == 0;
-    empty = mxx::all_of(empty);
+    empty = mxx::all_of(empty, _comm);
     BL_BENCH_END(undistribute, "empty", input.size());
 
     if (empty) {
       BL_BENCH_REPORT_MPI_NAMED(undistribute, "imxx:undistribute", _comm);
       return;
     }
+    BL_COMM_INIT(undistribute);
+    BL_COMM_START(undistribute);
 
 
-    BL_BENCH_START(undistribute);
     std::vector<size_t> send_counts(recv_counts.size());
-    mxx::all2all(recv_counts.data(), 1, send_counts.data(), _comm);
-    size_t total = std::accumulate(send_counts.begin(), send_counts.end(), static_cast<size_t>(0));
-    BL_BENCH_END(undistribute, "recv_counts", input.size());
+    if (use_sparse_exchange(recv_counts, _comm)) {
+      BL_BENCH_START(undistribute);
+      BL_COMM_MPI_START(undistribute);
+      BL_TRACE_BEGIN("sparse_all2all");
+      sparse_all2allv(input.data(), recv_counts, output, send_counts, _comm);
+      BL_TRACE_END("sparse_all2all");
+      BL_COMM_MPI_END(undistribute);
+      BL_BENCH_END(undistribute, "sparse_a2a", input.size());
+    } else {
+      BL_BENCH_START(undistribute);
+      BL_COMM_MPI_START(undistribute);
+      mxx::all2all(recv_counts.data(), 1, send_counts.data(), _comm);
+      BL_COMM_MPI_END(undistribute);
+      size_t total = std::accumulate(send_counts.begin(), send_counts.end(), static_cast<size_t>(0));
+      BL_BENCH_END(undistribute, "recv_counts", input.size());
 
-    BL_BENCH_START(undistribute);
-    if (output.capacity() < total) output.clear();
-    output.resize(total);
-    BL_BENCH_COLLECTIVE_END(undistribute, "realloc_out", output.size(), _comm);
+      BL_BENCH_START(undistribute);
+      if (output.capacity() < total) output.clear();
+      output.resize(total);
+      BL_BENCH_COLLECTIVE_END(undistribute, "realloc_out", output.size(), _comm);
 
-    BL_BENCH_START(undistribute);
-    mxx::all2allv(input.data(), recv_counts, output.data(), send_counts, _comm);
-    BL_BENCH_END(undistribute, "a2av", input.size());
+      BL_BENCH_START(undistribute);
+      BL_COMM_MPI_START(undistribute);
+      BL_TRACE_BEGIN("all2all");
+      exchange_all2allv(input.data(), recv_counts, output.data(), send_counts, _comm);
+      BL_TRACE_END("all2all");
+      BL_COMM_MPI_END(undistribute);
+      BL_BENCH_END(undistribute, "a2av", input.size());
+    }
 
     if (restore_order) {
       BL_BENCH_START(undistribute);
@@ -1213,6 +1966,9 @@ namespace imxx
       BL_BENCH_END(undistribute, "unpermute_inplace", output.size());
 
     }
+    // sends back what was received.
+    BL_COMM_END(undistribute, "undistribute", recv_counts, send_counts, sizeof(V));
+    BL_COMM_REPORT_MPI_NAMED(undistribute, "imxx:undistribute", _comm);
     BL_BENCH_REPORT_MPI_NAMED(undistribute, "imxx:undistribute", _comm);
 
   }
@@ -1232,7 +1988,7 @@ namespace imxx
       // speed over mem use.  mxx all2allv already has to double memory usage. same as stable distribute.
     BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
     bool empty = input.size() == 0;
-    empty = mxx::all_of(empty);
+    empty = mxx::all_of(empty, _comm);
     BL_BENCH_END(distribute, "empty", input.size());
 
     if (empty) {
@@ -1279,7 +2035,7 @@ namespace imxx
 
       // permute
       BL_BENCH_START(distribute);
-      imxx::local::permute(output.begin(), output.end(), i2o.begin(), input.begin(), 0);
+      imxx::local::bucket_permute(output.begin(), output.end(), i2o.begin(), input.begin(), 0, _comm.size());
       BL_BENCH_COLLECTIVE_END(distribute, "permute", input.size(), _comm);
 
       BL_BENCH_START(distribute);
@@ -1293,8 +2049,8 @@ namespace imxx
 
 
       BL_BENCH_START(distribute);
-      mxx::all2allv(input.data() + first_part, send_counts,
-                    output.data() + first_part, recv_counts, _comm);
+      exchange_all2allv(input.data() + first_part, send_counts,
+                        output.data() + first_part, recv_counts, _comm);
       BL_BENCH_END(distribute, "a2av", total - first_part);
 
       // permute
@@ -1308,6 +2064,69 @@ namespace imxx
   }
 
 
+  /**
+   * @brief distribute in place:  input is bucketed in place and replaced by the received elements.  for consumed inputs.
+   * @details  as distribute_2part, the first min bucket size elements of every bucket are exchanged with 1 in place
+   *           all2all, and the remainders with an all2allv into a buffer that is then appended.  there is no permuted copy
+   *           of the input and no full size receive buffer, so the peak memory is the input, the i2o map (released before
+   *           the exchange), and the remainders.  with well balanced buckets the remainders are small.
+   *
+   *           the received elements are not grouped by source rank:  the blocks come first, then the remainders.
+   *           the input is not recoverable, so there is no preserve_input.
+   */
+  template <typename V, typename ToRank>
+  void distribute_inplace(::std::vector<V>& input, ToRank const & to_rank, ::mxx::comm const &_comm) {
+    BL_BENCH_INIT(distribute);
+
+    BL_BENCH_COLLECTIVE_START(distribute, "empty", _comm);
+    bool empty = input.size() == 0;
+    empty = mxx::all_of(empty, _comm);
+    BL_BENCH_END(distribute, "empty", input.size());
+
+    if (empty) {
+      BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:distribute_inplace", _comm);
+      return;
+    }
+
+      BL_BENCH_START(distribute);
+      std::vector<size_t> send_counts(_comm.size(), 0);
+      std::vector<size_t> i2o(input.size());
+      imxx::local::assign_to_buckets(input, to_rank, _comm.size(), send_counts, i2o, 0, input.size());
+      BL_BENCH_COLLECTIVE_END(distribute, "bucket", input.size(), _comm);
+
+      BL_BENCH_START(distribute);
+      size_t min_bucket_size = *(::std::min_element(send_counts.begin(), send_counts.end()));
+      min_bucket_size = ::mxx::allreduce(min_bucket_size, mxx::min<size_t>(), _comm);
+      ::imxx::local::bucket_to_block_permutation(min_bucket_size, 1UL, send_counts, i2o, 0, input.size());
+      size_t first_part = _comm.size() * min_bucket_size;
+      BL_BENCH_COLLECTIVE_END(distribute, "to_pos", first_part, _comm);
+
+      BL_BENCH_START(distribute);
+      imxx::local::permute_inplace(input, i2o, 0, input.size());
+      ::std::vector<size_t>().swap(i2o);
+      BL_BENCH_COLLECTIVE_END(distribute, "permute_inplace", input.size(), _comm);
+
+      BL_BENCH_START(distribute);
+      block_all2all_inplace(input, min_bucket_size, 0, _comm);
+      BL_BENCH_COLLECTIVE_END(distribute, "a2a_inplace", first_part, _comm);
+
+      BL_BENCH_START(distribute);
+      std::vector<size_t> recv_counts(_comm.size());
+      mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
+      size_t second_part = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
+      std::vector<V> remainder(second_part);
+      exchange_all2allv(input.data() + first_part, send_counts, remainder.data(), recv_counts, _comm);
+      BL_BENCH_END(distribute, "a2av", second_part);
+
+      BL_BENCH_START(distribute);
+      input.resize(first_part);
+      input.insert(input.end(), remainder.begin(), remainder.end());
+      BL_BENCH_END(distribute, "append", input.size());
+
+      BL_BENCH_REPORT_MPI_NAMED(distribute, "imxx:distribute_inplace", _comm);
+  }
+
+
   /**
    * @param recv_counts  counts for each bucket that is NOT PART OF FIRST BLOCK.
    */
@@ -1321,7 +2140,7 @@ namespace imxx
 
     BL_BENCH_COLLECTIVE_START(undistribute, "empty", _comm);
     bool empty = input.size() == 0;
-    empty = mxx::all_of(empty);
+    empty = mxx::all_of(empty, _comm);
     BL_BENCH_END(undistribute, "empty", input.size());
 
     if (empty) {
@@ -1350,7 +2169,7 @@ namespace imxx
     BL_BENCH_END(undistribute, "a2a", first_part);
 
     BL_BENCH_START(undistribute);
-    mxx::all2allv(input.data() + first_part, recv_counts, output.data() + first_part, send_counts, _comm);
+    exchange_all2allv(input.data() + first_part, recv_counts, output.data() + first_part, send_counts, _comm);
     BL_BENCH_END(undistribute, "a2av", second_part);
 
     if (restore_order) {
@@ -1385,13 +2204,15 @@ namespace imxx
       // speed over mem use.  mxx all2allv already has to double memory usage. same as stable distribute.
       BL_BENCH_COLLECTIVE_START(scat_comp_gath, "empty", _comm);
       bool empty = input.size() == 0;
-      empty = mxx::all_of(empty);
+      empty = mxx::all_of(empty, _comm);
       BL_BENCH_END(scat_comp_gath, "empty", input.size());
 
       if (empty) {
         BL_BENCH_REPORT_MPI_NAMED(scat_comp_gath, "imxx:scat_comp_gath", _comm);
         return;
       }
+      BL_COMM_INIT(scat_comp_gath);
+      BL_COMM_START(scat_comp_gath);
 
       // do assignment.
       BL_BENCH_START(scat_comp_gath);
@@ -1401,7 +2222,9 @@ namespace imxx
 
       // distribute
       BL_BENCH_START(scat_comp_gath);
+      BL_COMM_MPI_START(scat_comp_gath);
       distribute(input, to_rank, recv_counts, i2o, in_buffer, _comm, false);
+      BL_COMM_MPI_END(scat_comp_gath);
       BL_BENCH_END(scat_comp_gath, "distribute", in_buffer.size());
 
       // allocate out_buffer - output is same size as input
@@ -1423,20 +2246,30 @@ namespace imxx
 
       // distribute data back to source
       BL_BENCH_START(scat_comp_gath);
+      BL_COMM_MPI_START(scat_comp_gath);
       undistribute(out_buffer, recv_counts, i2o, output, _comm, false);
+      BL_COMM_MPI_END(scat_comp_gath);
       BL_BENCH_END(scat_comp_gath, "undistribute", output.size());
 
 
       // permute
       if (preserve_input) {
         BL_BENCH_START(scat_comp_gath);
+        // the buffers hold the received entries, which can be fewer or more than the local input.
+        in_buffer.resize(input.size());
         ::imxx::local::unpermute(input.begin(), input.end(), i2o.begin(), in_buffer.begin(), 0);
         in_buffer.swap(input);
+        out_buffer.resize(output.size());
         ::imxx::local::unpermute(output.begin(), output.end(), i2o.begin(), out_buffer.begin(), 0);
         out_buffer.swap(output);
         BL_BENCH_END(scat_comp_gath, "unpermute_inplace", output.size());
       }
 
+      // the queries out and the results back, so the bytes count both.  the send buckets are inside distribute, so report the received ones.
+      BL_COMM_END_TOTALS(scat_comp_gath, "query", input.size(), in_buffer.size(),
+                         *(::std::max_element(recv_counts.begin(), recv_counts.end())),
+                         *(::std::min_element(recv_counts.begin(), recv_counts.end())), sizeof(V) + sizeof(T));
+      BL_COMM_REPORT_MPI_NAMED(scat_comp_gath, "imxx:scat_comp_gath", _comm);
       BL_BENCH_REPORT_MPI_NAMED(scat_comp_gath, "imxx:scat_comp_gath", _comm);
   }
 
@@ -1460,7 +2293,7 @@ namespace imxx
       // speed over mem use.  mxx all2allv already has to double memory usage. same as stable scat_comp_gath_2.
       BL_BENCH_COLLECTIVE_START(scat_comp_gath_2, "empty", _comm);
       bool empty = input.size() == 0;
-      empty = mxx::all_of(empty);
+      empty = mxx::all_of(empty, _comm);
       BL_BENCH_END(scat_comp_gath_2, "empty", input.size());
 
       if (empty) {
@@ -1507,7 +2340,7 @@ namespace imxx
 
       // permute
       BL_BENCH_START(scat_comp_gath_2);
-      imxx::local::permute(input.begin(), input.end(), i2o.begin(), in_buffer.begin(), 0);
+      imxx::local::bucket_permute(input.begin(), input.end(), i2o.begin(), in_buffer.begin(), 0, _comm.size());
       in_buffer.swap(input);       // input is now permuted.
 //      in_buffer.resize(second_part);
       BL_BENCH_END(scat_comp_gath_2, "permute", input.size());
@@ -1519,15 +2352,16 @@ namespace imxx
       output.resize(input.size());
       BL_BENCH_END(scat_comp_gath_2, "alloc_out", output.size());
 
-      //== process first part.  communicate in place
-      BL_BENCH_START(scat_comp_gath_2);
-      block_all2all(input, min_bucket_size, in_buffer, 0, 0, _comm);
-      BL_BENCH_END(scat_comp_gath_2, "a2a_inplace", first_part);
-
-      // process
+      //== process first part.  communicate in chunks, computing on each chunk while the next is in flight.
       BL_BENCH_START(scat_comp_gath_2);
-      op(in_buffer.begin(), in_buffer.begin() + first_part, output.begin());
-      BL_BENCH_END(scat_comp_gath_2, "compute1", first_part);
+      block_all2all_pipelined(input, min_bucket_size, in_buffer,
+                              [&op, &in_buffer, &output, &min_bucket_size, &_comm](size_t offset, size_t count) {
+        for (int r = 0; r < _comm.size(); ++r) {
+          size_t pos = r * min_bucket_size + offset;
+          op(in_buffer.begin() + pos, in_buffer.begin() + pos + count, output.begin() + pos);
+        }
+      }, 0, 0, _comm);
+      BL_BENCH_END(scat_comp_gath_2, "a2a_compute1", first_part);
 
       // send the results back.  and reverse the input
       // undo a2a, so that result data matches.
@@ -1564,7 +2398,8 @@ namespace imxx
       // permute
       if (preserve_input) {
         BL_BENCH_START(scat_comp_gath_2);
-        // in_buffer was already allocated to be same size as input.
+        // in_buffer was shrunk to the second part above.
+        in_buffer.resize(input.size());
         ::imxx::local::unpermute(input.begin(), input.end(), i2o.begin(), in_buffer.begin(), 0);
         in_buffer.swap(input);
         // out_buffer is small, so should do this inplace.
@@ -1657,7 +2492,7 @@ namespace imxx
 
       BL_BENCH_COLLECTIVE_START(scat_comp_gath_lm, "empty", _comm);
       bool empty = input.size() == 0;
-      empty = mxx::all_of(empty);
+      empty = mxx::all_of(empty, _comm);
       BL_BENCH_END(scat_comp_gath_lm, "empty", input.size());
 
       if (empty) {
@@ -1783,8 +2618,8 @@ namespace imxx
 
       // permute
       if (preserve_input) {
-        // in_buffer was already allocated to be same size as input.
-        ::imxx::local::unpermute_inplace(input, i2o, 0, input.size());
+        BL_BENCH_START(scat_comp_gath_lm);
+        // input was only read through the permutation, so it is still in its original order.
         // out_buffer is small, so should do this inplace.
         ::imxx::local::unpermute_inplace(output, i2o, 0, output.size());
         BL_BENCH_END(scat_comp_gath_lm, "unpermute_inplace", output.size());
@@ -1793,6 +2628,69 @@ namespace imxx
       BL_BENCH_REPORT_MPI_NAMED(scat_comp_gath_lm, "imxx:scat_comp_gath_lm", _comm);
   }
 
+  /// one to one scatter_compute_gather variants.  automatic picks one per call, see select_exchange.
+  enum class exchange_algorithm { automatic, full, two_part, lowmem };
+
+  /**
+   * @brief pick the scatter_compute_gather variant for a call from the input size and the free memory.  collective.
+   * @details  full keeps input, received, results, and their buffers at once, about 2 (sizeof(V) + sizeof(T)) + sizeof(SIZE)
+   *           bytes per element.  two_part does its first part in place and needs about half of that extra, and lowmem
+   *           streams the first part in 2 blocks.  the largest rank's need is compared to the smallest rank's free
+   *           memory, so all ranks pick the same variant.  small inputs use full, as the others add local passes.
+   * @param local_count   number of elements on this rank.
+   * @param free_bytes    memory available to this rank.
+   */
+  template <typename V, typename T, typename SIZE = size_t>
+  exchange_algorithm select_exchange(size_t const & local_count, size_t const & free_bytes, ::mxx::comm const & _comm) {
+    // below this many elements per rank the exchange is latency bound, and the full version is fastest.
+    constexpr size_t small_count = 1UL << 16;
+    constexpr size_t bytes_per_element = 2 * (sizeof(V) + sizeof(T)) + sizeof(SIZE);
+
+    // 1 allreduce for both:  max need, and max of (max - free), i.e. min free.
+    ::std::vector<size_t> stats(2);
+    stats[0] = local_count;
+    stats[1] = ::std::numeric_limits<size_t>::max() - free_bytes;
+    if (_comm.size() > 1) stats = ::mxx::allreduce(stats, ::mxx::max<size_t>(), _comm);
+
+    size_t need = stats[0] * bytes_per_element;
+    size_t avail = ::std::numeric_limits<size_t>::max() - stats[1];
+
+    if (stats[0] <= small_count) return exchange_algorithm::full;
+    if (need < avail / 2) return exchange_algorithm::full;
+    if (need < avail) return exchange_algorithm::two_part;
+    return exchange_algorithm::lowmem;
+  }
+
+  /**
+   * @brief scatter_compute_gather with the variant given by algo.  automatic uses select_exchange with free_bytes.
+   * @details  same contract as the variants.  with preserve_input, input and output are in the original order.
+   */
+  template <typename V, typename ToRank, typename Operation, typename SIZE = size_t,
+      typename T = typename bliss::functional::function_traits<Operation, V>::return_type>
+  void scatter_compute_gather_auto(::std::vector<V>& input, ToRank const & to_rank,
+                              Operation const & op,
+                              ::std::vector<SIZE> & i2o,
+                              ::std::vector<T>& output,
+                              ::std::vector<V>& in_buffer, std::vector<T>& out_buffer,
+                              ::mxx::comm const &_comm,
+                              exchange_algorithm algo, size_t const & free_bytes,
+                              bool const & preserve_input = false) {
+    if (algo == exchange_algorithm::automatic)
+      algo = select_exchange<V, T, SIZE>(input.size(), free_bytes, _comm);
+
+    switch (algo) {
+      case exchange_algorithm::two_part:
+        scatter_compute_gather_2part(input, to_rank, op, i2o, output, in_buffer, out_buffer, _comm, preserve_input);
+        break;
+      case exchange_algorithm::lowmem:
+        scatter_compute_gather_lowmem(input, to_rank, op, i2o, output, in_buffer, out_buffer, _comm, preserve_input);
+        break;
+      default:
+        scatter_compute_gather(input, to_rank, op, i2o, output, in_buffer, out_buffer, _comm, preserve_input);
+        break;
+    }
+  }
+
   // TODO: non-one-to-one version.
 
   /**
@@ -1815,7 +2713,7 @@ namespace imxx
       // speed over mem use.  mxx all2allv already has to double memory usage. same as stable distribute.
       BL_BENCH_COLLECTIVE_START(scat_comp_gath_v, "empty", _comm);
       bool empty = input.size() == 0;
-      empty = mxx::all_of(empty);
+      empty = mxx::all_of(empty, _comm);
       BL_BENCH_END(scat_comp_gath_v, "empty", input.size());
 
       if (empty) {
@@ -1880,6 +2778,426 @@ namespace imxx
       BL_BENCH_REPORT_MPI_NAMED(scat_comp_gath_v, "imxx:scat_comp_gath_v", _comm);
   }
 
+
+  /**
+   * @brief handle for a non-blocking distribute.  tracks per-rank receives and sends.
+   * @details  receives are indexed by source rank, so callers can process the data from a source as soon as it arrives via wait_any,
+   *          while data from other sources are still in flight.  Zero-sized messages are not posted.
+   *
+   *          the send and receive buffers passed to idistribute must remain valid until wait() returns (or the handle is destroyed,
+   *          which waits for any outstanding requests).
+   *
+   *          the messages go over a private duplicate of the caller's communicator, so their tags cannot match the caller's
+   *          own point to point messages.
+   *
+   *          with set_progress(true), or BL_MPI_PROGRESS_THREAD=1, a progress_thread polls the exchange from when idistribute
+   *          posts it until wait(), so that it completes while the caller computes.  needs MPI_THREAD_MULTIPLE, else ignored.
+   */
+  template <typename V, typename SIZE = size_t>
+  class distribute_request {
+    protected:
+      template <typename VV, typename ToRank, typename SS>
+      friend void idistribute(::std::vector<VV>& input, ToRank const & to_rank,
+                    ::std::vector<SS> & recv_counts,
+                    ::std::vector<SS> & i2o,
+                    ::std::vector<VV>& output,
+                    distribute_request<VV, SS> & req,
+                    ::mxx::comm const &_comm);
+
+      /// receive requests, 1 per source rank
+      ::std::vector<MPI_Request> recv_reqs;
+      /// send requests, 1 per destination rank
+      ::std::vector<MPI_Request> send_reqs;
+
+      /// receive offsets for each source rank
+      ::std::vector<size_t> recv_displs;
+
+      /// receive counts for each source rank
+      ::std::vector<SIZE> recv_counts;
+
+      /// send counts for each destination rank
+      ::std::vector<SIZE> send_counts;
+
+      /// number of receive requests not yet returned by wait_any
+      int pending;
+
+      /// duplicate of the caller's communicator, for the exchange's messages.
+      ::mxx::comm comm;
+
+      /// drive the exchange from a helper thread.
+      bool use_progress;
+      progress_thread progress;
+
+    public:
+      distribute_request() : pending(0), use_progress(progress_thread_from_env()) {}
+
+      ~distribute_request() {
+        wait();
+      }
+
+      // requests are not copyable.
+      distribute_request(distribute_request const & other) = delete;
+      distribute_request& operator=(distribute_request const & other) = delete;
+
+      /// check if all sends and receives have completed.  does not block.
+      bool test() {
+        int recv_done = 1, send_done = 1;
+        if (recv_reqs.size() > 0) MPI_Testall(recv_reqs.size(), recv_reqs.data(), &recv_done, MPI_STATUSES_IGNORE);
+        if (send_reqs.size() > 0) MPI_Testall(send_reqs.size(), send_reqs.data(), &send_done, MPI_STATUSES_IGNORE);
+
+        if (recv_done) pending = 0;
+        return recv_done && send_done;
+      }
+
+      /// block until all sends and receives have completed.
+      void wait() {
+        if (recv_reqs.size() > 0) MPI_Waitall(recv_reqs.size(), recv_reqs.data(), MPI_STATUSES_IGNORE);
+        if (send_reqs.size() > 0) MPI_Waitall(send_reqs.size(), send_reqs.data(), MPI_STATUSES_IGNORE);
+        pending = 0;
+        progress.stop();
+      }
+
+      /// drive the next exchanges from a helper thread.  see class description.
+      void set_progress(bool const on) {
+        use_progress = on;
+      }
+      /// true if a helper thread is driving the current exchange.
+      bool progress_active() const {
+        return progress.active();
+      }
+
+      /**
+       * @brief block until data from any one source rank has arrived.
+       * @return  the source rank, or -1 if all receives have been returned already.
+       */
+      int wait_any() {
+        if (pending == 0) return -1;
+
+        int idx = MPI_UNDEFINED;
+        MPI_Waitany(recv_reqs.size(), recv_reqs.data(), &idx, MPI_STATUS_IGNORE);
+        if (idx == MPI_UNDEFINED) {
+          pending = 0;
+          return -1;
+        }
+        --pending;
+        return idx;
+      }
+
+      /// wait for the sends only, e.g. before reusing the send buffer.
+      void wait_send() {
+        if (send_reqs.size() > 0) MPI_Waitall(send_reqs.size(), send_reqs.data(), MPI_STATUSES_IGNORE);
+      }
+
+      /// offset in the output buffer of data received from src
+      size_t recv_offset(int const & src) const {
+        return recv_displs[src];
+      }
+      /// number of elements received from src
+      SIZE recv_count(int const & src) const {
+        return recv_counts[src];
+      }
+      /// number of elements sent to dest
+      SIZE send_count(int const & dest) const {
+        return send_counts[dest];
+      }
+      /// the private communicator of the exchange.  follow up messages, e.g. replies, can use it with a tag other than 0.
+      ::mxx::comm const & get_comm() const {
+        return comm;
+      }
+  };
+
+
+  /**
+   * @brief non-blocking version of distribute.  bucket and permute locally, then post all sends and receives and return.
+   * @details  element counts are exchanged with a (small, blocking) all2all, so that output can be allocated before returning.
+   *          data exchange uses per-rank Isend/Irecv so that received blocks can be processed individually via req.wait_any()
+   *          while others are still in flight.  Use req.wait() to wait for everything.
+   *
+   *          input is permuted in place and is the send buffer; it and output must not be modified or deallocated until req completes.
+   *          the data messages use tag 0 on a duplicate of _comm, kept in req.  the duplication makes this call collective.
+   *          unlike distribute, preserving the input order is left to the caller (via local::unpermute_inplace after req.wait()).
+   *
+   * @param recv_counts   output: number of elements received from each rank.
+   * @param i2o           output: input to send buffer position mapping (for undistribute or unpermute)
+   * @param output        receive buffer.  resized here.
+   * @param req           handle for the outstanding communication.
+   */
+  template <typename V, typename ToRank, typename SIZE>
+  void idistribute(::std::vector<V>& input, ToRank const & to_rank,
+                  ::std::vector<SIZE> & recv_counts,
+                  ::std::vector<SIZE> & i2o,
+                  ::std::vector<V>& output,
+                  distribute_request<V, SIZE> & req,
+                  ::mxx::comm const &_comm) {
+    BL_BENCH_INIT(idistribute);
+
+    // make sure any previous use of the request is done.
+    req.wait();
+
+    BL_BENCH_START(idistribute);
+    std::vector<SIZE> send_counts(_comm.size(), 0);
+    i2o.resize(input.size());
+    BL_BENCH_END(idistribute, "alloc_map", input.size());
+
+    // bucketing
+    BL_BENCH_START(idistribute);
+    imxx::local::assign_to_buckets(input, to_rank, _comm.size(), send_counts, i2o, 0, input.size());
+    imxx::local::bucket_to_permutation(send_counts, i2o, 0, input.size());
+    BL_BENCH_END(idistribute, "bucket", input.size());
+
+    BL_BENCH_START(idistribute);
+    if (output.capacity() < input.size()) output.clear();
+    output.resize(input.size());
+    output.swap(input);  // swap the 2.
+    imxx::local::bucket_permute(output.begin(), output.end(), i2o.begin(), input.begin(), 0, _comm.size());  // input now holds permuted entries.
+    BL_BENCH_END(idistribute, "permute", input.size());
+
+    // exchange counts (blocking, p elements)
+    BL_BENCH_START(idistribute);
+    recv_counts.resize(_comm.size());
+    mxx::all2all(send_counts.data(), 1, recv_counts.data(), _comm);
+    size_t total = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
+    BL_BENCH_END(idistribute, "a2a_count", recv_counts.size());
+
+    BL_BENCH_START(idistribute);
+    if (output.capacity() < total) output.clear();
+    output.resize(total);
+    BL_BENCH_END(idistribute, "realloc_out", output.size());
+
+    // post the receives, then the sends.  ordered by distance from self to reduce contention.
+    BL_BENCH_START(idistribute);
+    auto send_displs = mxx::impl::get_displacements(send_counts);
+    req.recv_displs = mxx::impl::get_displacements(recv_counts);
+    req.recv_counts = recv_counts;
+    req.send_counts = send_counts;
+    req.recv_reqs.assign(_comm.size(), MPI_REQUEST_NULL);
+    req.send_reqs.assign(_comm.size(), MPI_REQUEST_NULL);
+    req.pending = 0;
+    req.comm = _comm.copy();
+
+    mxx::datatype dt = mxx::get_datatype<V>();
+    int src, dest;
+    for (int i = 0; i < _comm.size(); ++i) {
+      src = (_comm.rank() + (_comm.size() - i)) % _comm.size();
+      if (recv_counts[src] == 0) continue;
+
+      assert((recv_counts[src] < static_cast<SIZE>(mxx::max_int)) && "idistribute: message from 1 rank exceeds max int.");
+      MPI_Irecv(output.data() + req.recv_displs[src], recv_counts[src], dt.type(), src, 0, req.comm, &(req.recv_reqs[src]));
+      ++req.pending;
+    }
+    for (int i = 0; i < _comm.size(); ++i) {
+      dest = (_comm.rank() + i) % _comm.size();
+      if (send_counts[dest] == 0) continue;
+
+      assert((send_counts[dest] < static_cast<SIZE>(mxx::max_int)) && "idistribute: message to 1 rank exceeds max int.");
+      MPI_Isend(input.data() + send_displs[dest], send_counts[dest], dt.type(), dest, 0, req.comm, &(req.send_reqs[dest]));
+    }
+    if (req.use_progress) req.progress.start(req.comm);
+    BL_BENCH_END(idistribute, "post", total);
+
+    BL_BENCH_REPORT_MPI_NAMED(idistribute, "imxx:idistribute", _comm);
+  }
+
+
+  /**
+   * @brief distribute, compute, send back.  one to one.  result matching input in order at then end.
+   * @details  communication overlapped version of scatter_compute_gather.  uses idistribute for the queries, then computes
+   *          on each source rank's block as soon as it arrives, and immediately sends the results back with a non-blocking send.
+   *          compute therefore proceeds while the rest of the query and response exchanges are in flight.
+   *
+   *          memory use is the same as scatter_compute_gather.
+   */
+  template <typename V, typename ToRank, typename Operation, typename SIZE = size_t,
+      typename T = typename bliss::functional::function_traits<Operation, V>::return_type>
+  void scatter_compute_gather_overlap(::std::vector<V>& input, ToRank const & to_rank,
+                              Operation const & op,
+                              ::std::vector<SIZE> & i2o,
+                              ::std::vector<T>& output,
+                              ::std::vector<V>& in_buffer, std::vector<T>& out_buffer,
+                              ::mxx::comm const &_comm,
+                              bool const & preserve_input = false) {
+      BL_BENCH_INIT(scat_comp_gath_o);
+
+      BL_BENCH_COLLECTIVE_START(scat_comp_gath_o, "empty", _comm);
+      bool empty = input.size() == 0;
+      empty = mxx::all_of(empty, _comm);
+      BL_BENCH_END(scat_comp_gath_o, "empty", input.size());
+
+      if (empty) {
+        BL_BENCH_REPORT_MPI_NAMED(scat_comp_gath_o, "imxx:scat_comp_gath_o", _comm);
+        return;
+      }
+
+      // start the query exchange.  input becomes the permuted send buffer.
+      BL_BENCH_START(scat_comp_gath_o);
+      std::vector<SIZE> recv_counts(_comm.size(), 0);
+      distribute_request<V, SIZE> query_req;
+      idistribute(input, to_rank, recv_counts, i2o, in_buffer, query_req, _comm);
+      BL_BENCH_END(scat_comp_gath_o, "idistribute", in_buffer.size());
+
+      // allocate and post receives for the responses.  response sizes are the same as query sizes.
+      BL_BENCH_START(scat_comp_gath_o);
+      if (out_buffer.capacity() < (in_buffer.size())) out_buffer.clear();
+      out_buffer.resize(in_buffer.size());
+      if (output.capacity() < (input.size())) output.clear();
+      output.resize(input.size());
+
+      std::vector<SIZE> send_counts(_comm.size(), 0);
+      for (int i = 0; i < _comm.size(); ++i) send_counts[i] = query_req.send_count(i);
+      auto send_displs = mxx::impl::get_displacements(send_counts);
+
+      // responses use tag 1 on the query exchange's private communicator.
+      mxx::datatype dt = mxx::get_datatype<T>();
+      std::vector<MPI_Request> resp_recv_reqs(_comm.size(), MPI_REQUEST_NULL);
+      std::vector<MPI_Request> resp_send_reqs(_comm.size(), MPI_REQUEST_NULL);
+      for (int i = 0; i < _comm.size(); ++i) {
+        if (send_counts[i] == 0) continue;
+        MPI_Irecv(output.data() + send_displs[i], send_counts[i], dt.type(), i, 1, query_req.get_comm(), &(resp_recv_reqs[i]));
+      }
+      BL_BENCH_END(scat_comp_gath_o, "alloc_out", output.size());
+
+      // compute on each block as it arrives, and send back right away.
+      BL_BENCH_START(scat_comp_gath_o);
+      int src;
+      size_t offset;
+      while ((src = query_req.wait_any()) >= 0) {
+        offset = query_req.recv_offset(src);
+        op(in_buffer.begin() + offset, in_buffer.begin() + offset + recv_counts[src], out_buffer.begin() + offset);
+        MPI_Isend(out_buffer.data() + offset, recv_counts[src], dt.type(), src, 1, query_req.get_comm(), &(resp_send_reqs[src]));
+      }
+      BL_BENCH_END(scat_comp_gath_o, "compute", out_buffer.size());
+
+      BL_BENCH_START(scat_comp_gath_o);
+      // responses first:  a progress thread, if any, runs until query_req.wait().
+      MPI_Waitall(_comm.size(), resp_recv_reqs.data(), MPI_STATUSES_IGNORE);
+      MPI_Waitall(_comm.size(), resp_send_reqs.data(), MPI_STATUSES_IGNORE);
+      query_req.wait();
+      BL_BENCH_END(scat_comp_gath_o, "wait", output.size());
+
+      // permute
+      if (preserve_input) {
+        BL_BENCH_START(scat_comp_gath_o);
+        // the buffers hold the received entries, which can be fewer or more than the local input.
+        in_buffer.resize(input.size());
+        ::imxx::local::unpermute(input.begin(), input.end(), i2o.begin(), in_buffer.begin(), 0);
+        in_buffer.swap(input);
+        out_buffer.resize(output.size());
+        ::imxx::local::unpermute(output.begin(), output.end(), i2o.begin(), out_buffer.begin(), 0);
+        out_buffer.swap(output);
+        BL_BENCH_END(scat_comp_gath_o, "unpermute_inplace", output.size());
+      }
+
+      BL_BENCH_REPORT_MPI_NAMED(scat_comp_gath_o, "imxx:scat_comp_gath_o", _comm);
+  }
+
+  /**
+   * @brief the channels of a multi channel exchange:  1 duplicate of a communicator per thread.
+   * @details  MPI matches the messages of concurrent collectives by communicator, so each thread needs its own.
+   *          construction and destruction are collective.
+   */
+  class channel_comms {
+    protected:
+      ::std::vector<::mxx::comm> comms;
+
+    public:
+      channel_comms(::mxx::comm const & _comm, size_t const nchannels) {
+        comms.reserve(nchannels);
+        for (size_t i = 0; i < nchannels; ++i) comms.emplace_back(_comm.copy());
+      }
+
+      size_t size() const { return comms.size(); }
+      ::mxx::comm const & operator[](size_t const i) const { return comms[i]; }
+
+      /// true if the channels can exchange concurrently, i.e. MPI provides MPI_THREAD_MULTIPLE.
+      static bool concurrent() {
+        int provided = MPI_THREAD_SINGLE;
+        MPI_Query_thread(&provided);
+        return provided == MPI_THREAD_MULTIPLE;
+      }
+  };
+
+  /**
+   * @brief distribute over several channels at once, 1 thread per channel.
+   * @details  each element goes to rank to_rank(x) on channel to_channel(x).  the input is bucketed once by (channel, rank),
+   *          the counts are exchanged once for all channels, and then each channel runs its own all2allv on its own
+   *          communicator, on its own OpenMP thread, so that a hybrid rank drives several rails of the network at the same time.
+   *          with a key hash sub-range per channel, e.g. the sub-table of ::fsc::thread_partitioned, the receiving thread c
+   *          can insert outputs[c] into its own sub-table without locking.
+   *
+   *          without MPI_THREAD_MULTIPLE or OpenMP, the channels exchange 1 after the other on the calling thread, with the
+   *          same result.
+   *
+   * @param input       permuted in place into send order, i.e. by channel, then by rank.
+   * @param to_channel  channel of an element, in [0, channels.size()).
+   * @param outputs     output:  outputs[c] is what this rank received on channel c, grouped by source rank.
+   */
+  template <typename V, typename ToRank, typename ToChannel>
+  void distribute_channels(::std::vector<V>& input, ToRank const & to_rank, ToChannel const & to_channel,
+                           channel_comms const & channels,
+                           ::std::vector<::std::vector<V> > & outputs,
+                           ::mxx::comm const &_comm) {
+    BL_BENCH_INIT(distribute_channels);
+
+    size_t const p = _comm.size();
+    size_t const nch = channels.size();
+    outputs.resize(nch);
+
+    // bucket by (channel, rank).
+    BL_BENCH_START(distribute_channels);
+    ::std::vector<size_t> send_counts;
+    ::std::vector<size_t> i2o;
+    imxx::local::assign_to_buckets(input, [&to_rank, &to_channel, p](V const & x) {
+      return to_channel(x) * p + to_rank(x);
+    }, nch * p, send_counts, i2o, 0, input.size());
+    imxx::local::bucket_to_permutation(send_counts, i2o, 0, input.size());
+    ::std::vector<V> buffer(input.size());
+    imxx::local::bucket_permute(input.begin(), input.end(), i2o.begin(), buffer.begin(), 0, nch * p);
+    buffer.swap(input);
+    ::std::vector<V>().swap(buffer);
+    ::std::vector<size_t>().swap(i2o);
+    BL_BENCH_END(distribute_channels, "bucket", input.size());
+
+    // 1 count exchange for all channels:  nch counts per destination.
+    BL_BENCH_START(distribute_channels);
+    ::std::vector<size_t> by_rank(nch * p);
+    for (size_t c = 0; c < nch; ++c) {
+      for (size_t r = 0; r < p; ++r) by_rank[r * nch + c] = send_counts[c * p + r];
+    }
+    ::std::vector<size_t> recv_by_rank(nch * p);
+    ::mxx::all2all(by_rank.data(), nch, recv_by_rank.data(), _comm);
+    BL_BENCH_END(distribute_channels, "a2a_count", recv_by_rank.size());
+
+    // each channel's slice of the send buffer, and its receive counts.
+    ::std::vector<size_t> send_offsets(nch + 1, 0);
+    ::std::vector<::std::vector<size_t> > channel_send(nch, ::std::vector<size_t>(p));
+    ::std::vector<::std::vector<size_t> > channel_recv(nch, ::std::vector<size_t>(p));
+    for (size_t c = 0; c < nch; ++c) {
+      size_t total = 0;
+      for (size_t r = 0; r < p; ++r) {
+        channel_send[c][r] = send_counts[c * p + r];
+        send_offsets[c + 1] += channel_send[c][r];
+        channel_recv[c][r] = recv_by_rank[r * nch + c];
+        total += channel_recv[c][r];
+      }
+      send_offsets[c + 1] += send_offsets[c];
+      if (outputs[c].capacity() < total) outputs[c].clear();
+      outputs[c].resize(total);
+    }
+
+    BL_BENCH_START(distribute_channels);
+#if defined(USE_OPENMP)
+    int const nthreads = channel_comms::concurrent() ? static_cast<int>(nch) : 1;
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+#endif
+    for (size_t c = 0; c < nch; ++c) {
+      ::mxx::all2allv(input.data() + send_offsets[c], channel_send[c], outputs[c].data(), channel_recv[c], channels[c]);
+    }
+    BL_BENCH_END(distribute_channels, "a2av", input.size());
+
+    BL_BENCH_REPORT_MPI_NAMED(distribute_channels, "imxx:distribute_channels", _comm);
+  }
+
+
   //TODO:
 //
 //  /**
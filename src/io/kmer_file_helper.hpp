@@ -42,9 +42,9 @@
 #include "mpi.h"
 #endif
 
-//#if defined(USE_OPENMP)
-//#include "omp.h"
-//#endif
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
 
 #include <unistd.h>     // sysconf
 #include <sys/stat.h>   // block size.
@@ -52,16 +52,28 @@
 #include <utility>      // pair and utility functions.
 #include <type_traits>
 #include <cctype>       // tolower.
+#include <stdexcept>
+#include <exception>    // exception_ptr
+#include <numeric>      // accumulate
+#include <limits>       // numeric_limits
 
 #include "io/file.hpp"
+#include "io/direct_file.hpp"
+#include "io/bgzf_file.hpp"
+#include "io/multi_file.hpp"
+#include "io/stream_file.hpp"
 #include "io/fastq_loader.hpp"
 #include "io/fasta_loader.hpp"
 //#include "io/fasta_iterator.hpp"
 
 #include "iterators/container_concatenating_iterator.hpp"
+#include "iterators/algorithm.hpp"
+#include "partition/partitioner.hpp"
 
 #include "utils/logging.h"
 #include "utils/file_utils.hpp"
+#include "utils/numa_utils.hpp"
+#include "utils/event_trace.hpp"
 #include "common/kmer.hpp"
 #include "common/base_types.hpp"
 #include "common/sequence.hpp"
@@ -74,6 +86,7 @@
 #include "io/mxx_support.hpp"
 
 #include "io/sequence_iterator.hpp"
+#include "io/duplicate_reads.hpp"
 
 #include "utils/benchmark_utils.hpp"
 #include "utils/file_utils.hpp"
@@ -96,6 +109,17 @@ namespace io
  */
 struct KmerFileHelper {
 
+  /**
+   * @brief  estimate the number of k-mers in a partition of bytes, from the average record size and sequence length.
+   * @details  scaled by the fraction of a record that the partition covers, not rounded up to whole records:  a FASTA record
+   *        longer than a partition (e.g. a chromosome or a long read) is split across ranks, and each rank only gets its share.
+   */
+  static size_t estimate_kmer_count(size_t const bytes, size_t const record_size, size_t const seq_len, size_t const k) {
+    if ((record_size == 0) || (seq_len < k)) return 0;
+    size_t const per_record = seq_len - k + 1;  // number of kmers in a record
+    return (bytes / record_size) * per_record + ((bytes % record_size) * per_record + record_size - 1) / record_size;
+  }
+
 
   /**
    * @brief  generate kmers or kmer tuples for 1 block of raw data.
@@ -104,13 +128,16 @@ struct KmerFileHelper {
    * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.  template template parameter, param is iterator
    * @tparam KmerParser           parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
    * @tparam BlockType    input partition type, supports in memory (vector) vs memmapped.
+   * @tparam Keep         read filter, e.g. drop_reads_at for the duplicates from find_duplicate_reads.
    * @param partition
-   * @param result        output vector.  should be pre allocated.
+   * @param emplace_iter  output iterator.  advanced past the generated kmers.
+   * @return number of sequences
    */
-  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType, typename BlockType>
-  static std::pair<size_t, size_t> read_block_old(BlockType const & partition,
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType, typename BlockType,
+  typename OutputIter, typename Keep = ::bliss::io::keep_all_reads>
+  static size_t read_block_old_into(BlockType const & partition,
       SeqParser<typename BlockType::iterator> const &seq_parser,
-      std::vector<typename KmerParser::value_type>& result) {
+      OutputIter & emplace_iter, Keep const & keep = Keep()) {
 
     // from FileLoader type, get the block iter type and range type
     using CharIterType = typename BlockType::const_iterator;
@@ -123,30 +150,22 @@ struct KmerFileHelper {
 
     //== process the chunk of data
 
-    //==  and wrap the chunk inside an iterator that emits Reads.
-    SeqIterType<CharIterType, SeqParser> seqs_start(seq_parser, partition.cbegin(), partition.in_mem_cend(), partition.getRange().start);
-    SeqIterType<CharIterType, SeqParser> seqs_end(partition.in_mem_cend());
-
-    ::fsc::back_emplace_iterator<std::vector<typename KmerParser::value_type> > emplace_iter(result);
-
-    size_t before = result.size();
     size_t seqs = 0;
 
-    //== loop over the reads
-    for (; seqs_start != seqs_end; ++seqs_start)
-    {
-      auto seq = *seqs_start;
-      if (seq.seq_size() == 0) continue;
-      //      std::cout << "** seq: " << (*seqs_start).id.id << ", ";
+    using SeqType = typename SeqParser<CharIterType>::SequenceType;
+    auto process = [&](SeqType & seq) {
+      if (seq.seq_size() == 0) return;
+      if (!keep(seq)) return;
+      //      std::cout << "** seq: " << seq.id.id << ", ";
       //      ostream_iterator<typename std::iterator_traits<typename SeqType::IteratorType>::value_type> osi(std::cout);
-      //      std::copy((*seqs_start).seq_begin, (*seqs_start).seq_end, osi);
+      //      std::copy(seq.seq_begin, seq.seq_end, osi);
       //      std::cout << std::endl;
 
       size_t start_offset = seq.seq_global_offset();
 
       // if seq data starts outside of valid, then skip
       if (start_offset >= partition.valid_range_bytes.end) {
-        continue;
+        return;
       }
 
       // check if last.  if yes, and seqParser is a FASTAParser, then inspect and change if needed
@@ -177,15 +196,148 @@ struct KmerFileHelper {
           (start_offset >= partition.valid_range_bytes.start)) ++seqs;
 
       //      std::cout << "Last: pos - kmer " << result.back() << std::endl;
+    };
 
+    if (::bliss::io::has_record_cursor<SeqIterType>::value) {
+      //== same records as SeqIterType, parsed a batch at a time into a reused array.
+      ::bliss::io::SequenceRecordCursor<CharIterType, SeqParser> cursor(seq_parser, partition.cbegin(), partition.in_mem_cend(), partition.getRange().start);
+      ::std::vector<SeqType> records(::bliss::io::SequenceRecordCursor<CharIterType, SeqParser>::default_batch_size);
+
+      size_t n;
+      while ((n = cursor.next_batch(records)) > 0) {
+        for (size_t i = 0; i < n; ++i) process(records[i]);
+      }
+    } else {
+      //==  wrap the chunk inside an iterator that emits Reads.
+      SeqIterType<CharIterType, SeqParser> seqs_start(seq_parser, partition.cbegin(), partition.in_mem_cend(), partition.getRange().start);
+      SeqIterType<CharIterType, SeqParser> seqs_end(partition.in_mem_cend());
+
+      //== loop over the reads
+      for (; seqs_start != seqs_end; ++seqs_start)
+      {
+        auto seq = *seqs_start;
+        process(seq);
+      }
     }
 
+    return seqs;
+  }
+
+  /**
+   * @brief  generate kmers or kmer tuples for 1 block of raw data.  see read_block_old_into.
+   * @param result        output vector.  should be pre allocated.
+   * @return number of sequences, number of kmers
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType, typename BlockType,
+  typename Keep = ::bliss::io::keep_all_reads>
+  static std::pair<size_t, size_t> read_block_old(BlockType const & partition,
+      SeqParser<typename BlockType::iterator> const &seq_parser,
+      std::vector<typename KmerParser::value_type>& result, Keep const & keep = Keep()) {
+
+    ::fsc::back_emplace_iterator<std::vector<typename KmerParser::value_type> > emplace_iter(result);
+
+    size_t before = result.size();
+    size_t seqs = read_block_old_into<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, emplace_iter, keep);
+
     //std::cout << "number of sequences " << seqs << " number of total entries " << result.size() << " before insertion " << before << std::endl;
 
     return std::make_pair(seqs, result.size() - before);
   }
 
 
+  /// output iterator that counts the bucket of each transformed value, without storing it.  pass 1 of read_block_bucketed.
+  template <typename V, typename Trans, typename ToBucket>
+  class bucket_count_iterator : public std::iterator<std::output_iterator_tag, V, void, void, void> {
+    protected:
+      Trans const * trans;
+      ToBucket const * to_bucket;
+      size_t * counts;
+    public:
+      bucket_count_iterator(Trans const & _trans, ToBucket const & _to_bucket, size_t * _counts) :
+        trans(&_trans), to_bucket(&_to_bucket), counts(_counts) {}
+
+      bucket_count_iterator& operator=(V const & x) {
+        ++counts[(*to_bucket)((*trans)(x))];
+        return *this;
+      }
+
+      bucket_count_iterator& operator*() { return *this; }
+      bucket_count_iterator& operator++() { return *this; }
+      bucket_count_iterator& operator++(int) { return *this; }
+  };
+
+  /// output iterator that writes each transformed value at the next offset of its bucket.  pass 2 of read_block_bucketed.
+  template <typename V, typename Trans, typename ToBucket>
+  class bucket_fill_iterator : public std::iterator<std::output_iterator_tag, V, void, void, void> {
+    protected:
+      Trans const * trans;
+      ToBucket const * to_bucket;
+      size_t * offsets;
+      V * output;
+    public:
+      bucket_fill_iterator(Trans const & _trans, ToBucket const & _to_bucket, size_t * _offsets, V * _output) :
+        trans(&_trans), to_bucket(&_to_bucket), offsets(_offsets), output(_output) {}
+
+      bucket_fill_iterator& operator=(V const & x) {
+        V y = (*trans)(x);
+        output[offsets[(*to_bucket)(y)]++] = y;
+        return *this;
+      }
+
+      bucket_fill_iterator& operator*() { return *this; }
+      bucket_fill_iterator& operator++() { return *this; }
+      bucket_fill_iterator& operator++(int) { return *this; }
+  };
+
+  /**
+   * @brief  generate kmers or kmer tuples for 1 block of raw data, written directly in bucket order.
+   * @details  read_block_old followed by bucketing sweeps the kmers 3 times:  written by the parser, read and written again by
+   *        the bucketing permutation, then read by the all2allv.  here the block is parsed twice instead.  the first pass only
+   *        counts the kmers per bucket, the second writes each transformed kmer at its final position, so the kmers are
+   *        written once and the intermediate vector and the permutation are not needed.  parsing is compute bound, so for large
+   *        blocks the second parse is cheaper than the memory traffic it saves.
+   *
+   *        the kmers of each bucket are in the same order as read_block_old produces them.
+   * @param trans       applied to each kmer before it is bucketed and stored, e.g. a map's input transform.
+   * @param to_bucket   bucket of a transformed kmer, in [0, nbuckets), e.g. a map's key_to_rank.
+   * @param result      output, replaced by the bucketed kmers.
+   * @param counts      output, number of kmers per bucket.  resized to nbuckets.
+   * @return number of sequences, number of kmers
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType, typename BlockType,
+  typename Trans, typename ToBucket>
+  static std::pair<size_t, size_t> read_block_bucketed(BlockType const & partition,
+      SeqParser<typename BlockType::iterator> const &seq_parser,
+      Trans const & trans, ToBucket const & to_bucket, size_t const nbuckets,
+      std::vector<typename KmerParser::value_type>& result,
+      std::vector<size_t> & counts) {
+    using V = typename KmerParser::value_type;
+
+    counts.clear();
+    counts.resize(nbuckets, 0);
+
+    // pass 1:  count.
+    bucket_count_iterator<V, Trans, ToBucket> count_iter(trans, to_bucket, counts.data());
+    size_t seqs = read_block_old_into<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, count_iter);
+
+    // exclusive prefix sum for the bucket offsets.
+    std::vector<size_t> offsets(nbuckets, 0);
+    size_t total = 0;
+    for (size_t i = 0; i < nbuckets; ++i) {
+      offsets[i] = total;
+      total += counts[i];
+    }
+
+    // pass 2:  fill.  no value initialization needed if the capacity is already there.
+    if (result.capacity() < total) std::vector<V>().swap(result);
+    result.resize(total);
+    bucket_fill_iterator<V, Trans, ToBucket> fill_iter(trans, to_bucket, offsets.data(), result.data());
+    read_block_old_into<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, fill_iter);
+
+    return std::make_pair(seqs, total);
+  }
+
+
   template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType, typename BlockType>
   static std::pair<size_t, size_t> read_block(BlockType const & partition,
       SeqParser<typename BlockType::iterator> const &seq_parser,
@@ -235,7 +387,8 @@ struct KmerFileHelper {
 	Iter concat_start(kmer_parser, seqs_start, seqs_end);
 	Iter concat_end(kmer_parser, seqs_end);
 
-	std::copy(concat_start, concat_end, emplace_iter);
+	// copies each read's kmers without the per kmer read boundary checks.
+	::bliss::iterator::algorithm::copy(concat_start, concat_end, emplace_iter);
 
     return std::make_pair(seqs, result.size() - before);
   }
@@ -268,8 +421,7 @@ struct KmerFileHelper {
         size_t record_size = 0;
         size_t seq_len = 0;
         std::tie(record_size, seq_len) = seq_parser.get_record_size(partition.cbegin(), partition.parent_range_bytes, partition.getRange(), partition.getRange(), 10);
-        size_t est_size = (record_size == 0) ? 0 : (partition.getRange().size() + record_size - 1) / record_size;  // number of records
-        est_size *= (seq_len < kmer_size) ? 0 : (seq_len - kmer_size + 1) ;  // number of kmers in a record
+        size_t est_size = estimate_kmer_count(partition.getRange().size(), record_size, seq_len, kmer_size);
         result.reserve(result.size() + est_size + (est_size >> 4));
         BL_BENCH_END(file, "reserve", est_size + (est_size >> 4));
 
@@ -313,8 +465,7 @@ struct KmerFileHelper {
         size_t record_size = 0;
         size_t seq_len = 0;
         std::tie(record_size, seq_len) = seq_parser.get_record_size(partition.cbegin(), partition.parent_range_bytes, partition.getRange(), partition.getRange(), 10);
-        size_t est_size = (record_size == 0) ? 0 : (partition.getRange().size() + record_size - 1) / record_size;  // number of records
-        est_size *= (seq_len < kmer_size) ? 0 : (seq_len - kmer_size + 1) ;  // number of kmers in a record
+        size_t est_size = estimate_kmer_count(partition.getRange().size(), record_size, seq_len, kmer_size);
         result.reserve(result.size() + est_size  + (est_size >> 4) );
         BL_BENCH_END(file, "reserve", est_size + (est_size >> 4));
 
@@ -335,7 +486,7 @@ struct KmerFileHelper {
   template <typename FileType>
   static ::bliss::io::file_data open_file(const std::string & filename, const size_t overlap) {
         // file extension determines SeqParserType
-        std::string extension = ::bliss::utils::file::get_file_extension(filename);
+        std::string extension = ::bliss::utils::file::get_data_file_extension(filename);
         std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
         if ((extension.compare("fastq") != 0) && (extension.compare("fasta") != 0) && (extension.compare("fa") != 0)) {
           throw std::invalid_argument("input filename extension is not supported.");
@@ -437,10 +588,12 @@ struct KmerFileHelper {
 
   /**
    * @brief initialize the sequence parser, estimate capacity and reserver, and then call read_block to parse the actual data.
+   * @param dedup   drop the reads that repeat an earlier read, see find_duplicate_reads.  collective either way.
    */
   template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType, typename BlockType>
   static  ::std::pair<size_t, size_t> parse_file_data_old(const BlockType & partition,
-                         std::vector<typename KmerParser::value_type>& result, const mxx::comm & _comm) {
+                         std::vector<typename KmerParser::value_type>& result, const mxx::comm & _comm,
+                         bool const dedup = false) {
       ::std::pair<size_t, size_t> read = {0,0};
 
      constexpr int kmer_size = KmerParser::window_size;
@@ -462,15 +615,22 @@ struct KmerFileHelper {
         size_t record_size = 0;
         size_t seq_len = 0;
         std::tie(record_size, seq_len) = seq_parser.get_record_size(partition.cbegin(), partition.parent_range_bytes, partition.getRange(), partition.getRange(), _comm, 10);
-        size_t est_size = (record_size == 0) ? 0 : (partition.getRange().size() + record_size - 1) / record_size;  // number of records
-        est_size *= (seq_len < kmer_size) ? 0 : (seq_len - kmer_size + 1) ;  // number of kmers in a record
+        size_t est_size = estimate_kmer_count(partition.getRange().size(), record_size, seq_len, kmer_size);
         result.reserve(result.size() + est_size / 2);
         BL_BENCH_END(file, "reserve", est_size);
 
+        BL_BENCH_START(file);
+        ::std::vector<size_t> drop;
+        if (dedup) drop = ::bliss::io::find_duplicate_reads<SeqParser>(partition, seq_parser, _comm);
+        BL_BENCH_END(file, "dedup", drop.size());
+
         BL_BENCH_START(file);
         //=== copy into array
         if (partition.getRange().size() > 0) {
-          read = read_block_old<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, result);
+          if (drop.empty())
+            read = read_block_old<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, result);
+          else
+            read = read_block_old<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, result, ::bliss::io::drop_reads_at(drop));
         }
         BL_BENCH_END(file, "read_seqs", read.first);
         // std::cout << "Last: pos - kmer " << result.back() << std::endl;
@@ -508,8 +668,7 @@ struct KmerFileHelper {
         size_t record_size = 0;
         size_t seq_len = 0;
         std::tie(record_size, seq_len) = seq_parser.get_record_size(partition.cbegin(), partition.parent_range_bytes, partition.getRange(), partition.getRange(), _comm, 10);
-        size_t est_size = (record_size == 0) ? 0 : (partition.getRange().size() + record_size - 1) / record_size;  // number of records
-        est_size *= (seq_len < kmer_size) ? 0 : (seq_len - kmer_size + 1) ;  // number of kmers in a record
+        size_t est_size = estimate_kmer_count(partition.getRange().size(), record_size, seq_len, kmer_size);
         result.reserve(result.size() + est_size / 2);
         BL_BENCH_END(file, "reserve", est_size);
 
@@ -531,7 +690,7 @@ struct KmerFileHelper {
   template <typename FileType>
   static ::bliss::io::file_data open_file(const std::string & filename, const size_t overlap, const mxx::comm & _comm) {
         // file extension determines SeqParserType
-        std::string extension = ::bliss::utils::file::get_file_extension(filename);
+        std::string extension = ::bliss::utils::file::get_data_file_extension(filename);
         std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
         if ((extension.compare("fastq") != 0) && (extension.compare("fasta") != 0)) {
           throw std::invalid_argument("input filename extension is not supported.");
@@ -541,16 +700,34 @@ struct KmerFileHelper {
         return fobj.read_file();
   }
 
+  /// open a list of files as one, e.g. with parallel::multi_file.  every file must have a supported extension.
+  template <typename FileType>
+  static ::bliss::io::file_data open_file(const std::vector<std::string> & filenames, const size_t overlap, const mxx::comm & _comm) {
+        for (auto const & filename : filenames) {
+          std::string extension = ::bliss::utils::file::get_data_file_extension(filename);
+          std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+          if ((extension.compare("fastq") != 0) && (extension.compare("fasta") != 0)) {
+            throw std::invalid_argument("input filename extension is not supported.");
+          }
+        }
+
+        FileType fobj(filenames, overlap, _comm);
+        return fobj.read_file();
+  }
+
   /**
    * @brief read a file's content and generate kmers, place in a vector as return result.
    * @note  static so can be used without instantiating a internal map.
    * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.   template template parameter, param is iterator
    * @tparam KmerParser   parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
+   * @tparam FileNames    a file name, or a vector of file names for a FileType that reads a list.
+   * @param dedup         drop exact duplicate reads before generating kmers.  FASTQ only.  see find_duplicate_reads.
    */
-  template <typename FileType, typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
-  static  ::std::pair<size_t, size_t> read_file(const std::string & filename,
+  template <typename FileType, typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename FileNames = std::string>
+  static  ::std::pair<size_t, size_t> read_file(const FileNames & filename,
                          std::vector<typename KmerParser::value_type>& result,
-                         const mxx::comm & _comm) {
+                         const mxx::comm & _comm, bool const dedup = false) {
 
       ::std::pair<size_t, size_t> read = {0, 0};
 
@@ -568,7 +745,7 @@ struct KmerFileHelper {
 
         // not reusing the SeqParser in loader.  instead, reinitializing one.
         BL_BENCH_START(file);
-        read = parse_file_data_old<KmerParser, SeqParser, SeqIterType>(partition, result, _comm);
+        read = parse_file_data_old<KmerParser, SeqParser, SeqIterType>(partition, result, _comm, dedup);
         BL_BENCH_END(file, "read_kmers", read.second);
         // std::cout << "Last: pos - kmer " << result.back() << std::endl;
       }
@@ -578,6 +755,736 @@ struct KmerFileHelper {
       return read;
   }
 
+  /**
+   * @brief read a file's content and generate kmers directly in bucket order, ready for all2allv.  see read_block_bucketed.
+   * @details  for a distributed map, trans is its input transform and to_bucket its key_to_rank, with comm.size() buckets.
+   *        the result can then be given to the map's insert_bucketed without another transform or bucketing pass.
+   * @param counts    output, number of kmers per bucket, i.e. the send counts.
+   * @return number of sequences, number of kmers
+   */
+  template <typename FileType, typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename Trans, typename ToBucket, typename FileNames = std::string>
+  static  ::std::pair<size_t, size_t> read_file_bucketed(const FileNames & filename,
+                         Trans const & trans, ToBucket const & to_bucket, size_t const nbuckets,
+                         std::vector<typename KmerParser::value_type>& result,
+                         std::vector<size_t> & counts,
+                         const mxx::comm & _comm) {
+
+      ::std::pair<size_t, size_t> read = {0, 0};
+
+      constexpr int kmer_size = KmerParser::window_size;
+
+      BL_BENCH_INIT(file);
+      {  // ensure that fileloader is closed at the end.
+
+        BL_BENCH_START(file);
+        ::bliss::io::file_data partition = open_file<FileType>(filename, kmer_size - 1, _comm);
+        BL_BENCH_END(file, "open", partition.getRange().size());
+
+        // not reusing the SeqParser in loader.  instead, reinitializing one.  collective.
+        BL_BENCH_START(file);
+        SeqParser<typename ::bliss::io::file_data::const_iterator> seq_parser;
+        seq_parser.init_parser(partition.in_mem_cbegin(), partition.parent_range_bytes, partition.in_mem_range_bytes, partition.getRange(), _comm);
+        BL_BENCH_END(file, "mark_seqs", partition.getRange().size());
+
+        // no reserve:  the first pass gives the exact size.
+        BL_BENCH_START(file);
+        if (partition.getRange().size() > 0) {
+          read = read_block_bucketed<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, trans, to_bucket, nbuckets, result, counts);
+        } else {
+          result.clear();
+          counts.assign(nbuckets, 0);
+        }
+        BL_BENCH_END(file, "read_kmers", read.second);
+      }
+
+      BL_BENCH_REPORT_MPI_NAMED(file, "io:read_file_bucketed", _comm);
+      return read;
+  }
+
+
+  /// iterator over the per thread kmer vectors of read_file_threaded, as 1 sequence.  no copies.
+  template <typename T>
+  using concat_iterator = ::bliss::iterator::ContainerConcatenatingIterator<typename std::vector<std::vector<T> >::const_iterator,
+      ::bliss::iterator::ConcatenatingIteratorContainerAdapter<void> >;
+
+  /// start of the concatenated view of per thread kmer vectors
+  template <typename T>
+  static concat_iterator<T> concat_begin(std::vector<std::vector<T> > const & results) {
+    return concat_iterator<T>(::bliss::iterator::ConcatenatingIteratorContainerAdapter<void>(), results.cbegin(), results.cend());
+  }
+
+  /// end of the concatenated view of per thread kmer vectors
+  template <typename T>
+  static concat_iterator<T> concat_end(std::vector<std::vector<T> > const & results) {
+    return concat_iterator<T>(::bliss::iterator::ConcatenatingIteratorContainerAdapter<void>(), results.cend());
+  }
+
+  /**
+   * @brief  generate kmers or kmer tuples for 1 block of raw data with multiple threads, 1 output vector per thread.
+   * @details  the partition is cut into blocks of block_bytes, which are dealt to the threads by a WorkStealingPartitioner:
+   *        each thread parses a contiguous run of blocks, and a thread that finishes early steals half of the remaining
+   *        blocks of another.  this keeps all threads busy when reads have uneven lengths or N runs.
+   *
+   *        FASTQ blocks are aligned to the next record start (find_first_record), and a block parses the records that start in it.
+   *        FASTA blocks are cut at arbitrary offsets, the same way the ranks are, and a block parses the k-mers that start in it.
+   *        the union of k-mers and the sequence count are identical to read_block_old; the order is not.
+   *
+   *        use concat_begin/concat_end to traverse the results as 1 sequence.
+   * @note  a SequencesIterator is created per block, which copies the sequence parser.  for FASTA files with many sequences
+   *        per rank, use larger blocks.
+   * @param results     per thread output.  resized to nthreads, existing content is kept.
+   * @param nthreads    number of threads.  blocks are parsed serially if OpenMP is not enabled.
+   * @param block_bytes size of a block
+   * @return number of sequences, number of kmers
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType, typename BlockType>
+  static std::pair<size_t, size_t> read_block_threaded(BlockType const & partition,
+      SeqParser<typename BlockType::const_iterator> const &seq_parser,
+      std::vector<std::vector<typename KmerParser::value_type> >& results,
+      size_t const nthreads, size_t const block_bytes) {
+
+    // from FileLoader type, get the block iter type and range type
+    using CharIterType = typename BlockType::const_iterator;
+    using RangeType = ::bliss::partition::range<size_t>;
+    constexpr bool is_fasta = ::std::is_same<SeqParser<CharIterType>, ::bliss::io::FASTAParser<CharIterType> >::value;
+
+    size_t const nt = ::std::max(nthreads, static_cast<size_t>(1));
+    results.resize(nt);
+
+    if (partition.getRange().size() == 0) return std::make_pair(0UL, 0UL);
+
+    RangeType const valid = partition.valid_range_bytes;
+
+    ::bliss::partition::WorkStealingPartitioner<RangeType> blocks;
+    blocks.configure(valid, nt, ::std::max(block_bytes, static_cast<size_t>(1)));
+
+    std::vector<size_t> seqs(nt, 0);
+    std::vector<size_t> kmers(nt, 0);
+    std::vector<std::exception_ptr> errors(nt);
+
+    auto work = [&](size_t const tid) {
+      BL_TRACE_SCOPE("parse_blocks");
+
+      SeqParser<CharIterType> parser(seq_parser);
+      ::bliss::utils::file::NotEOL not_eol;
+      ::fsc::back_emplace_iterator<std::vector<typename KmerParser::value_type> > emplace_iter(results[tid]);
+      size_t before = results[tid].size();
+
+      try {
+        for (RangeType r = blocks.getNext(tid); r.size() > 0; r = blocks.getNext(tid)) {
+
+          // FASTQ:  start at the first record in the block, and keep the k-mers of the whole record.
+          // FASTA:  start at the block, and keep the k-mers that start in the block.
+          // find_first_record skips the line at the start of the search unless the search starts at the parent's start,
+          // so search from 1 before the block to catch a record that starts exactly at the block.
+          size_t start = r.start;
+          if (!is_fasta && (r.start > valid.start)) {
+            size_t search = (r.start - 1 > partition.parent_range_bytes.start) ? r.start - 1 : r.start;
+            start = parser.find_first_record(partition.in_mem_cbegin(), partition.parent_range_bytes, partition.in_mem_range_bytes,
+                                             RangeType(search, partition.in_mem_range_bytes.end));
+          }
+          if (start >= r.end) continue;
+
+          KmerParser kmer_parser(is_fasta ? r : valid);
+
+          SeqIterType<CharIterType, SeqParser> seqs_start(parser, partition.in_mem_cbegin() + (start - partition.in_mem_range_bytes.start),
+                                                          partition.in_mem_cend(), start);
+          SeqIterType<CharIterType, SeqParser> seqs_end(partition.in_mem_cend());
+
+          for (; seqs_start != seqs_end; ++seqs_start) {
+            auto seq = *seqs_start;
+
+            // records (FASTQ) or k-mers (FASTA) after the block belong to the next block.
+            if ((is_fasta ? seq.seq_global_offset() : seq.id.get_pos()) >= r.end) break;
+            if (seq.seq_size() == 0) continue;
+
+            size_t start_offset = seq.seq_global_offset();
+
+            // if seq data starts outside of valid, then skip
+            if (start_offset >= valid.end) {
+              continue;
+            }
+
+            // same as read_block_old:  if seq data ends in overlap region, then go at most k-1 characters from end of valid range.
+            if (is_fasta && ((start_offset + seq.seq_size()) >= valid.end)) {
+              auto endd = seq.seq_begin + (valid.end - start_offset);
+              size_t steps = KmerParser::window_size - 1;
+              size_t count = 0;
+
+              while ((endd != seq.seq_end) && (count < steps)) {
+                if (not_eol(*endd)) {
+                  ++count;
+                }
+
+                ++endd;
+              }
+
+              seq.seq_end = endd;
+            }
+
+            emplace_iter = kmer_parser(seq, emplace_iter);
+
+            // a FASTA sequence split by a block boundary is counted by the block where it starts.
+            bool continued = is_fasta && (start_offset == r.start) && (r.start > valid.start) && (seq.seq_offset != seq.seq_begin_offset);
+            if (!continued && ((seq.seq_offset == seq.seq_begin_offset) ||
+                (start_offset >= valid.start))) ++seqs[tid];
+          }
+        }
+      } catch (...) {
+        errors[tid] = std::current_exception();
+      }
+
+      kmers[tid] = results[tid].size() - before;
+    };
+
+#if defined(USE_OPENMP)
+#pragma omp parallel num_threads(nt)
+    {
+      // fewer threads than requested is okay:  the blocks of the missing ones are stolen.
+      work(omp_get_thread_num());
+    }
+#else
+    // serially, thread 0 steals all the other blocks.
+    work(0);
+#endif
+
+    for (size_t t = 0; t < nt; ++t) {
+      if (errors[t]) std::rethrow_exception(errors[t]);
+    }
+
+    return std::make_pair(std::accumulate(seqs.begin(), seqs.end(), static_cast<size_t>(0)),
+                          std::accumulate(kmers.begin(), kmers.end(), static_cast<size_t>(0)));
+  }
+
+  /**
+   * @brief read a file's content and generate kmers with multiple threads, 1 vector per thread.  see read_block_threaded.
+   * @details  the per thread vectors can be traversed as 1 sequence, without copying, with concat_begin and concat_end.
+   * @tparam FileNames    a file name, or a vector of file names for a FileType that reads a list.
+   * @param nthreads      number of parsing threads.  default is the OpenMP max threads.
+   * @param block_bytes   size of the blocks that are dealt to the threads.
+   * @return number of sequences, number of kmers
+   */
+  template <typename FileType, typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename FileNames = std::string>
+  static  ::std::pair<size_t, size_t> read_file_threaded(const FileNames & filename,
+                         std::vector<std::vector<typename KmerParser::value_type> >& results,
+                         const mxx::comm & _comm,
+#if defined(USE_OPENMP)
+                         size_t const nthreads = omp_get_max_threads(),
+#else
+                         size_t const nthreads = 1,
+#endif
+                         size_t const block_bytes = (1UL << 20)) {
+
+      ::std::pair<size_t, size_t> read = {0, 0};
+
+      constexpr int kmer_size = KmerParser::window_size;
+      size_t const nt = ::std::max(nthreads, static_cast<size_t>(1));
+
+      BL_BENCH_INIT(file);
+      {  // ensure that fileloader is closed at the end.
+
+        BL_BENCH_START(file);
+        ::bliss::io::file_data partition = open_file<FileType>(filename, kmer_size - 1, _comm);
+        BL_BENCH_END(file, "open", partition.getRange().size());
+
+        // not reusing the SeqParser in loader.  instead, reinitializing one.  collective.
+        BL_BENCH_START(file);
+        SeqParser<typename ::bliss::io::file_data::const_iterator> seq_parser;
+        seq_parser.init_parser(partition.in_mem_cbegin(), partition.parent_range_bytes, partition.in_mem_range_bytes, partition.getRange(), _comm);
+        BL_BENCH_END(file, "mark_seqs", partition.getRange().size());
+
+        //== reserve, spread over the threads.
+        BL_BENCH_START(file);
+        size_t record_size = 0;
+        size_t seq_len = 0;
+        std::tie(record_size, seq_len) = seq_parser.get_record_size(partition.cbegin(), partition.parent_range_bytes, partition.getRange(), partition.getRange(), _comm, 10);
+        size_t est_size = estimate_kmer_count(partition.getRange().size(), record_size, seq_len, kmer_size);
+        est_size = (est_size + (est_size >> 4) + nt - 1) / nt;
+        results.resize(nt);
+        for (auto & r : results) r.reserve(r.size() + est_size);
+        BL_BENCH_END(file, "reserve", est_size * nt);
+
+        BL_BENCH_START(file);
+        read = read_block_threaded<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, results, nt, block_bytes);
+        BL_BENCH_END(file, "read_kmers", read.second);
+      }
+
+      BL_BENCH_REPORT_MPI_NAMED(file, "io:read_file_threaded", _comm);
+      return read;
+  }
+
+
+  /**
+   * @brief  parse sequences starting at seqs_start into buffer, until buffer has at least target entries or sequences run out.
+   * @details  k-mers produced are identical to read_block_old, including the FASTA valid range trimming.
+   *        a chunk can exceed target by the k-mers of 1 sequence, since a sequence is not split between chunks.
+   *        seqs_start is advanced, so repeated calls resume where the previous left off.
+   * @param steps  incremented for every sequence record advanced past, including skipped ones.
+   * @return true if all sequences in the block have been parsed.
+   */
+  template <typename KmerParser, template <typename> class SeqParser, typename SeqIter, typename BlockType>
+  static bool parse_chunk(BlockType const & partition, KmerParser & kmer_parser,
+      SeqIter & seqs_start, SeqIter const & seqs_end,
+      std::vector<typename KmerParser::value_type>& buffer,
+      size_t const target, size_t & seqs, size_t & steps) {
+    BL_TRACE_SCOPE("parse_chunk");
+
+    using CharIterType = typename BlockType::const_iterator;
+    constexpr bool is_fasta = ::std::is_same<SeqParser<CharIterType>, ::bliss::io::FASTAParser<CharIterType> >::value;
+
+    ::bliss::utils::file::NotEOL not_eol;
+    ::fsc::back_emplace_iterator<std::vector<typename KmerParser::value_type> > emplace_iter(buffer);
+
+    buffer.clear();
+
+    //== loop over the reads until the chunk is full
+    for (; (seqs_start != seqs_end) && (buffer.size() < target); ++seqs_start, ++steps)
+    {
+      auto seq = *seqs_start;
+      if (seq.seq_size() == 0) continue;
+
+      size_t start_offset = seq.seq_global_offset();
+
+      // if seq data starts outside of valid, then skip
+      if (start_offset >= partition.valid_range_bytes.end) {
+        continue;
+      }
+
+      // check if last.  if yes, and seqParser is a FASTAParser, then inspect and change if needed
+      if (is_fasta) {
+        // if seq data ends in overlap region, then go at most k-1 characters from end of valid range.
+        if ((start_offset + seq.seq_size()) >= partition.valid_range_bytes.end) {
+          // scan for k-1 characters, from the valid range end.
+          auto endd = seq.seq_begin + (partition.valid_range_bytes.end - start_offset);
+          size_t steps = KmerParser::window_size - 1;
+          size_t count = 0;
+
+          // iterate and find the windows size - 1 chars in overlap, starting from valid end.  should be less than current seq end.
+          while ((endd != seq.seq_end) && (count < steps)) {
+            if (not_eol(*endd)) {
+              ++count;
+            }
+
+            ++endd;
+          }
+
+          seq.seq_end = endd;
+        }
+      }
+
+      emplace_iter = kmer_parser(seq, emplace_iter);
+      if ((seq.seq_offset == seq.seq_begin_offset) ||
+          (start_offset >= partition.valid_range_bytes.start)) ++seqs;
+    }
+
+    return seqs_start == seqs_end;
+  }
+
+  /// position of a chunked read after a consumed chunk.  see read_block_chunked.
+  struct chunk_progress {
+      /// number of chunks consumed in this call.
+      size_t chunks;
+      /// number of kmers consumed in this call.
+      size_t kmers;
+      /// number of sequence records advanced past, including skipped ones.  pass as skip_steps to resume.
+      size_t steps;
+      /// file offset of the first record not yet consumed.  end of the partition if all are consumed.
+      size_t next_offset;
+  };
+
+  /// default progress callback for read_block_chunked.
+  struct no_progress {
+      void operator()(chunk_progress const &) const {}
+  };
+
+  /// file offset of the record at seqs_start
+  template <typename SeqIter, typename BlockType>
+  static size_t next_record_offset(BlockType const & partition, SeqIter const & seqs_start, SeqIter const & seqs_end) {
+    return (seqs_start == seqs_end) ? partition.getRange().end : (*seqs_start).id.get_pos();
+  }
+
+  /**
+   * @brief  generate kmers or kmer tuples for 1 block of raw data, in bounded size chunks.
+   * @details  sequences are parsed into buffer until buffer contains at least chunk_size entries, then consumer is called
+   *        with the buffer and the buffer is cleared (capacity retained) for the next chunk.
+   *        consumer is assumed to be COLLECTIVE (e.g. distributed map insert), so all processes call it the same number of times:
+   *        processes that run out of sequences continue to call consumer with an empty buffer until all processes are done.
+   *
+   *        if overlap is true and OpenMP is enabled, the next chunk is parsed by a second thread while the consumer
+   *        processes the current chunk, using a second buffer of the same size.  consumer is always called from the master thread,
+   *        so MPI_THREAD_FUNNELED is sufficient.
+   *
+   * @tparam Consumer     functor with signature void(std::vector<typename KmerParser::value_type>&).  may modify the vector.
+   * @param partition
+   * @param seq_parser    initialized sequence parser
+   * @param buffer        work buffer for the kmers.  should be pre allocated.
+   * @param chunk_size    number of kmers to accumulate before calling consumer.
+   * @param consume       collective consumer of each chunk
+   * @param overlap       parse the next chunk concurrently with consuming the current one.
+   * @param skip_steps    number of sequence records to skip before parsing, from the chunk_progress of an earlier call.
+   *                      throws std::invalid_argument on all ranks if any partition is too short.
+   * @param progress      collective callback, void(chunk_progress const &), called after each chunk is consumed.
+   *                      reports only what has been consumed, also when overlapping.
+   * @return  number of sequences, number of kmers, and number of chunks.
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename BlockType, typename Consumer, typename Progress = no_progress>
+  static std::tuple<size_t, size_t, size_t> read_block_chunked(BlockType const & partition,
+      SeqParser<typename BlockType::iterator> const &seq_parser,
+      std::vector<typename KmerParser::value_type>& buffer,
+      size_t const chunk_size,
+      Consumer & consume,
+      const mxx::comm & _comm,
+      bool overlap = false,
+      size_t const skip_steps = 0,
+      Progress const & progress = Progress()) {
+
+    // from FileLoader type, get the block iter type and range type
+    using CharIterType = typename BlockType::const_iterator;
+
+    //== sequence parser type
+    KmerParser kmer_parser(partition.valid_range_bytes);
+
+    //==  and wrap the chunk inside an iterator that emits Reads.  empty partition has start == end.
+    SeqIterType<CharIterType, SeqParser> seqs_start(partition.in_mem_cend());
+    if (partition.getRange().size() > 0)
+      seqs_start = SeqIterType<CharIterType, SeqParser>(seq_parser, partition.cbegin(), partition.in_mem_cend(), partition.getRange().start);
+    SeqIterType<CharIterType, SeqParser> seqs_end(partition.in_mem_cend());
+
+    size_t seqs = 0;
+    size_t kmers = 0;
+    size_t chunks = 0;
+    size_t const target = ::std::max(chunk_size, static_cast<size_t>(1));
+
+    // resume:  skip the records that were consumed before.
+    size_t steps = 0;
+    for (; (steps < skip_steps) && (seqs_start != seqs_end); ++seqs_start, ++steps) {}
+    if (!::mxx::all_of(steps == skip_steps, _comm))  // collective, so all ranks throw together.
+      throw ::std::invalid_argument("ERROR: read_block_chunked: a partition has fewer records than the number to skip.");
+
+    // position after the chunk in buffer.
+    chunk_progress pos;
+
+    bool exhausted = parse_chunk<KmerParser, SeqParser>(partition, kmer_parser, seqs_start, seqs_end, buffer, target, seqs, steps);
+    pos.steps = steps;
+    pos.next_offset = next_record_offset(partition, seqs_start, seqs_end);
+
+#if defined(USE_OPENMP)
+    if (overlap) {
+      std::vector<typename KmerParser::value_type> next;
+      next.reserve(buffer.capacity());
+      // next is filled by the parsing thread but read by this one, so place its pages (still untouched) on this thread's node.
+      ::bliss::utils::numa::prefer_current(next.data(), next.capacity() * sizeof(typename KmerParser::value_type));
+
+      bool done = false;
+      while (!done) {
+        kmers += buffer.size();
+
+        bool next_exhausted = exhausted;
+        if (exhausted) next.clear();
+
+        // thread 0 (master) consumes, which is collective.  thread 1 parses the next chunk.  serial if nothing left to parse.
+#pragma omp parallel num_threads(2) if (!exhausted)
+        {
+          if (omp_get_thread_num() == 0) {
+            consume(buffer);
+            // 1 thread only, e.g. nested in another parallel region or limited by OMP_THREAD_LIMIT:  parse after consuming.
+            if (!exhausted && (omp_get_num_threads() < 2))
+              next_exhausted = parse_chunk<KmerParser, SeqParser>(partition, kmer_parser, seqs_start, seqs_end, next, target, seqs, steps);
+          } else {
+            next_exhausted = parse_chunk<KmerParser, SeqParser>(partition, kmer_parser, seqs_start, seqs_end, next, target, seqs, steps);
+          }
+        }
+        ++chunks;
+
+        // report the consumed chunk, then move on to the one parsed concurrently.
+        pos.chunks = chunks;
+        pos.kmers = kmers;
+        progress(pos);
+        pos.steps = steps;
+        pos.next_offset = next_record_offset(partition, seqs_start, seqs_end);
+
+        exhausted = next_exhausted;
+        buffer.swap(next);
+
+        done = ::mxx::all_of(exhausted && buffer.empty(), _comm);
+      }
+      buffer.clear();
+
+      return std::make_tuple(seqs, kmers, chunks);
+    }
+#else
+    BLISS_UNUSED(overlap);
+#endif
+
+    bool done = false;
+    while (!done) {
+      kmers += buffer.size();
+
+      // collective.  consumer may swap or modify the buffer.
+      consume(buffer);
+      ++chunks;
+
+      pos.chunks = chunks;
+      pos.kmers = kmers;
+      progress(pos);
+
+      if (exhausted) buffer.clear();
+      else {
+        exhausted = parse_chunk<KmerParser, SeqParser>(partition, kmer_parser, seqs_start, seqs_end, buffer, target, seqs, steps);
+        pos.steps = steps;
+        pos.next_offset = next_record_offset(partition, seqs_start, seqs_end);
+      }
+
+      done = ::mxx::all_of(exhausted && buffer.empty(), _comm);
+    }
+    buffer.clear();
+
+    return std::make_tuple(seqs, kmers, chunks);
+  }
+
+
+  /**
+   * @brief read a file's content and generate kmers in bounded size chunks, each of which is handed to a collective consumer.
+   * @details  Used for building an index without materializing all kmers of the local partition.  The raw partition is still
+   *        loaded in its entirety, but the kmer buffer is bounded by chunk_bytes (plus the kmers of 1 sequence).
+   *        All processes call consume the same number of times.
+   * @note  static so can be used without instantiating a internal map.
+   * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.   template template parameter, param is iterator
+   * @tparam KmerParser   parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
+   * @param chunk_bytes   target size in bytes of the kmer buffer.
+   * @param overlap       parse the next chunk while the current one is consumed.  uses 2 buffers.  requires OpenMP.
+   * @param skip_steps    records to skip, to resume an earlier stream.  see read_block_chunked.
+   * @param progress      collective callback after each consumed chunk.  see read_block_chunked.
+   * @tparam FileNames    a file name, or a vector of file names for a FileType that reads a list.
+   * @return  number of sequences, number of kmers, and number of chunks.
+   */
+  template <typename FileType, typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename Consumer, typename Progress = no_progress, typename FileNames = std::string>
+  static  ::std::tuple<size_t, size_t, size_t> stream_file(const FileNames & filename,
+                         size_t const chunk_bytes,
+                         Consumer & consume,
+                         const mxx::comm & _comm,
+                         bool overlap = false,
+                         size_t const skip_steps = 0,
+                         Progress const & progress = Progress()) {
+
+      ::std::tuple<size_t, size_t, size_t> read = std::make_tuple(0, 0, 0);
+
+      constexpr int kmer_size = KmerParser::window_size;
+      size_t chunk_size = ::std::max(chunk_bytes / sizeof(typename KmerParser::value_type), static_cast<size_t>(1));
+
+      BL_BENCH_INIT(file);
+      {  // ensure that fileloader is closed at the end.
+
+        BL_BENCH_START(file);
+        ::bliss::io::file_data partition = open_file<FileType>(filename, kmer_size - 1, _comm);
+        BL_BENCH_END(file, "open", partition.getRange().size());
+
+        // not reusing the SeqParser in loader.  instead, reinitializing one.  collective.
+        BL_BENCH_START(file);
+        SeqParser<typename ::bliss::io::file_data::const_iterator> seq_parser;
+        seq_parser.init_parser(partition.in_mem_cbegin(), partition.parent_range_bytes, partition.in_mem_range_bytes, partition.getRange(), _comm);
+        BL_BENCH_END(file, "mark_seqs", partition.getRange().size());
+
+        //== reserve.  at most 1 chunk worth.
+        BL_BENCH_START(file);
+        size_t record_size = 0;
+        size_t seq_len = 0;
+        std::tie(record_size, seq_len) = seq_parser.get_record_size(partition.cbegin(), partition.parent_range_bytes, partition.getRange(), partition.getRange(), _comm, 10);
+        size_t est_size = estimate_kmer_count(partition.getRange().size(), record_size, seq_len, kmer_size);
+        est_size = ::std::min(est_size, chunk_size + seq_len);
+        std::vector<typename KmerParser::value_type> buffer;
+        buffer.reserve(est_size);
+        BL_BENCH_END(file, "reserve", est_size);
+
+        BL_BENCH_START(file);
+        read = read_block_chunked<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, buffer, chunk_size, consume, _comm, overlap,
+            skip_steps, progress);
+        BL_BENCH_END(file, "stream_kmers", std::get<1>(read));
+      }
+
+      BL_BENCH_REPORT_MPI_NAMED(file, "io:stream_file", _comm);
+      return read;
+  }
+
+
+  /// stream kmers from file via mpiio.  see stream_file
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename Consumer>
+  static  ::std::tuple<size_t, size_t, size_t> stream_file_mpiio(const std::string & filename,
+                         size_t const chunk_bytes, Consumer & consume,
+                         const mxx::comm & _comm, bool overlap = false) {
+      return stream_file<::bliss::io::parallel::mpiio_file<SeqParser >,
+          KmerParser, SeqParser, SeqIterType>(filename, chunk_bytes, consume, _comm, overlap);
+  }
+
+  /// stream kmers from file via mmap.  see stream_file
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename Consumer>
+  static  ::std::tuple<size_t, size_t, size_t> stream_file_mmap(const std::string & filename,
+                         size_t const chunk_bytes, Consumer & consume,
+                         const mxx::comm & _comm, bool overlap = false) {
+      return stream_file<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser >,
+          KmerParser, SeqParser, SeqIterType>(filename, chunk_bytes, consume, _comm, overlap);
+  }
+
+  /// stream kmers from file via posix read.  see stream_file
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename Consumer>
+  static  ::std::tuple<size_t, size_t, size_t> stream_file_posix(const std::string & filename,
+                         size_t const chunk_bytes, Consumer & consume,
+                         const mxx::comm & _comm, bool overlap = false) {
+      return stream_file<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, SeqParser >,
+          KmerParser, SeqParser, SeqIterType>(filename, chunk_bytes, consume, _comm, overlap);
+  }
+
+  /**
+   * @brief generate kmers from a FASTQ stream (stdin, a pipe, or a socket) in bounded size chunks, for a collective consumer.
+   * @details  the stream is read by root only, without staging it to a file.  each round, root scatters 1 block of whole
+   *        records to each rank (see stream_file.hpp), and the blocks are parsed as read_block_chunked does for a file
+   *        partition.  All processes call consume the same number of times.  no checkpoints, since a stream cannot be reread.
+   * @param reader        the stream.  used on root only, may be null on the other ranks.
+   * @param block_bytes   bytes of records per rank per round.  0 for default_stream_block_bytes.
+   * @param chunk_bytes   target size in bytes of the kmer buffer.  0 to consume each round's block at once.
+   * @param overlap       parse the next chunk of a block while the current one is consumed.  requires OpenMP.
+   * @return  number of sequences, number of kmers, and number of chunks.
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename Consumer>
+  static  ::std::tuple<size_t, size_t, size_t> stream_input(::bliss::io::fastq_stream_reader * reader,
+                         size_t const block_bytes, size_t const chunk_bytes,
+                         Consumer & consume,
+                         const mxx::comm & _comm,
+                         int const root = 0,
+                         bool overlap = false) {
+      static_assert(::std::is_same<SeqParser<char*>, ::bliss::io::FASTQParser<char*> >::value,
+                    "stream_input supports FASTQ only:  its blocks are cut at 4 line records.");
+
+      ::std::tuple<size_t, size_t, size_t> read = std::make_tuple(0, 0, 0);
+
+      size_t const block = (block_bytes == 0) ? ::bliss::io::default_stream_block_bytes(_comm.size()) : block_bytes;
+      size_t const chunk_size = (chunk_bytes == 0) ? ::std::numeric_limits<size_t>::max() :
+          ::std::max(chunk_bytes / sizeof(typename KmerParser::value_type), static_cast<size_t>(1));
+
+      std::vector<typename KmerParser::value_type> buffer;
+
+      BL_BENCH_INIT(file);
+      BL_BENCH_START(file);
+      while (true) {
+        ::bliss::io::file_data partition = ::bliss::io::scatter_stream_block(reader, block, _comm, root);
+        if (partition.parent_range_bytes.size() == 0) break;  // same on all ranks.
+
+        // blocks are record aligned and consecutive in rank order, as a block partitioned file.  collective.
+        SeqParser<typename ::bliss::io::file_data::const_iterator> seq_parser;
+        seq_parser.init_parser(partition.in_mem_cbegin(), partition.parent_range_bytes, partition.in_mem_range_bytes, partition.getRange(), _comm);
+
+        ::std::tuple<size_t, size_t, size_t> r =
+            read_block_chunked<KmerParser, SeqParser, SeqIterType>(partition, seq_parser, buffer, chunk_size, consume, _comm, overlap);
+        ::std::get<0>(read) += ::std::get<0>(r);
+        ::std::get<1>(read) += ::std::get<1>(r);
+        ::std::get<2>(read) += ::std::get<2>(r);
+      }
+      BL_BENCH_END(file, "stream_kmers", std::get<1>(read));
+
+      BL_BENCH_REPORT_MPI_NAMED(file, "io:stream_input", _comm);
+      return read;
+  }
+
+  /**
+   * @brief read a file's content once and generate the kmers of several k, in bounded size chunks, for a collective consumer.
+   * @details  as stream_file, with a MultiKmerParser:  each chunk holds the kmers of every k for the same records, and is
+   *        handed to consume as a MultiKmerParser::buffer_type, so the records are read, split, and translated once for all k.
+   *        All processes call consume the same number of times.  no overlap or checkpoints.
+   * @tparam MultiParser  MultiKmerParser type.
+   * @tparam Consumer     functor with signature void(typename MultiParser::buffer_type &).  may modify the vectors.
+   * @param chunk_bytes   target size in bytes of the kmers of all k in a chunk.  0 for the whole partition in 1 chunk.
+   * @return  number of sequences, number of kmers of all k, and number of chunks.
+   */
+  template <typename FileType, typename MultiParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+  typename Consumer>
+  static  ::std::tuple<size_t, size_t, size_t> stream_file_multi_k(const std::string & filename,
+                         size_t const chunk_bytes,
+                         Consumer & consume,
+                         const mxx::comm & _comm) {
+
+      size_t seqs = 0;
+      size_t kmers = 0;
+      size_t chunks = 0;
+
+      BL_BENCH_INIT(file);
+      {  // ensure that fileloader is closed at the end.
+
+        BL_BENCH_START(file);
+        ::bliss::io::file_data partition = open_file<FileType>(filename, MultiParser::window_size - 1, _comm);
+        BL_BENCH_END(file, "open", partition.getRange().size());
+
+        BL_BENCH_START(file);
+        SeqParser<typename ::bliss::io::file_data::const_iterator> seq_parser;
+        seq_parser.init_parser(partition.in_mem_cbegin(), partition.parent_range_bytes, partition.in_mem_range_bytes, partition.getRange(), _comm);
+        BL_BENCH_END(file, "mark_seqs", partition.getRange().size());
+
+        BL_BENCH_START(file);
+        using CharIterType = typename ::bliss::io::file_data::const_iterator;
+        constexpr bool is_fasta = ::std::is_same<SeqParser<CharIterType>, ::bliss::io::FASTAParser<CharIterType> >::value;
+
+        MultiParser kmer_parser(partition.valid_range_bytes);
+        typename MultiParser::buffer_type buffers;
+        ::bliss::utils::file::NotEOL not_eol;
+
+        //==  empty partition has start == end.
+        SeqIterType<CharIterType, SeqParser> seqs_start(partition.in_mem_cend());
+        if (partition.getRange().size() > 0)
+          seqs_start = SeqIterType<CharIterType, SeqParser>(seq_parser, partition.cbegin(), partition.in_mem_cend(), partition.getRange().start);
+        SeqIterType<CharIterType, SeqParser> seqs_end(partition.in_mem_cend());
+
+        bool done = false;
+        while (!done) {
+          MultiParser::clear(buffers);
+
+          // same record handling as parse_chunk, with the chunk measured in bytes over all k.
+          for (; (seqs_start != seqs_end) && ((chunk_bytes == 0) || (MultiParser::bytes(buffers) < chunk_bytes)); ++seqs_start) {
+            auto seq = *seqs_start;
+            if (seq.seq_size() == 0) continue;
+
+            size_t start_offset = seq.seq_global_offset();
+            if (start_offset >= partition.valid_range_bytes.end) continue;
+
+            if (is_fasta && ((start_offset + seq.seq_size()) >= partition.valid_range_bytes.end)) {
+              // go at most largest k - 1 characters from end of valid range.
+              auto endd = seq.seq_begin + (partition.valid_range_bytes.end - start_offset);
+              size_t count = 0;
+              while ((endd != seq.seq_end) && (count < MultiParser::window_size - 1)) {
+                if (not_eol(*endd)) ++count;
+                ++endd;
+              }
+              seq.seq_end = endd;
+            }
+
+            kmer_parser(seq, buffers);
+            if ((seq.seq_offset == seq.seq_begin_offset) ||
+                (start_offset >= partition.valid_range_bytes.start)) ++seqs;
+          }
+
+          kmers += MultiParser::size(buffers);
+
+          // collective.
+          consume(buffers);
+          ++chunks;
+
+          done = ::mxx::all_of(seqs_start == seqs_end, _comm);
+        }
+        MultiParser::clear(buffers);
+        BL_BENCH_END(file, "stream_kmers", kmers);
+      }
+
+      BL_BENCH_REPORT_MPI_NAMED(file, "io:stream_file_multi_k", _comm);
+      return ::std::make_tuple(seqs, kmers, chunks);
+  }
+
+
 
   /**
    * @brief read a file's content and generate kmers, place in a vector as return result.
@@ -588,10 +1495,10 @@ struct KmerFileHelper {
   template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
   static  ::std::pair<size_t, size_t> read_file_mpiio(const std::string & filename,
                          std::vector<typename KmerParser::value_type>& result,
-                         const mxx::comm & _comm) {
+                         const mxx::comm & _comm, bool const dedup = false) {
 
       return read_file<::bliss::io::parallel::mpiio_file<SeqParser >,
-          KmerParser, SeqParser, SeqIterType>(filename, result, _comm);
+          KmerParser, SeqParser, SeqIterType>(filename, result, _comm, dedup);
   }
 
 
@@ -604,11 +1511,11 @@ struct KmerFileHelper {
   template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
   static  ::std::pair<size_t, size_t> read_file_mmap(const std::string & filename,
                         std::vector<typename KmerParser::value_type>& result,
-                        const mxx::comm & _comm) {
+                        const mxx::comm & _comm, bool const dedup = false) {
 
       // partitioned file with mmap or posix is only slightly faster than mpiio and may result in more jitter when congested.
       return read_file<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser >,
-          KmerParser, SeqParser, SeqIterType>(filename, result, _comm);
+          KmerParser, SeqParser, SeqIterType>(filename, result, _comm, dedup);
 
   }
 
@@ -622,15 +1529,79 @@ struct KmerFileHelper {
   template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
   static ::std::pair<size_t, size_t> read_file_posix(const std::string & filename,
                          std::vector<typename KmerParser::value_type>& result,
-                         const mxx::comm & _comm) {
+                         const mxx::comm & _comm, bool const dedup = false) {
 
 
 
       // partitioned file with mmap or posix do not seem to be much faster than mpiio and may result in more jitter when congested.
       return read_file<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, SeqParser >,
+          KmerParser, SeqParser, SeqIterType>(filename, result, _comm, dedup);
+
+  }
+
+  /**
+   * @brief read a file's content and generate kmers, place in a vector as return result.  1 process per node reads, see base_node_shared_file.
+   * @note  static so can be used wihtout instantiating a internal map.
+   * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.   template template parameter, param is iterator
+   * @tparam KmerParser   parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+  static ::std::pair<size_t, size_t> read_file_node_shared(const std::string & filename,
+                         std::vector<typename KmerParser::value_type>& result,
+                         const mxx::comm & _comm) {
+
+      return read_file<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, SeqParser, ::bliss::io::parallel::base_node_shared_file >,
+          KmerParser, SeqParser, SeqIterType>(filename, result, _comm);
+
+  }
+
+  /**
+   * @brief read a file's content and generate kmers, place in a vector as return result.  reads bypass the page cache.
+   * @note  static so can be used wihtout instantiating a internal map.
+   * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.   template template parameter, param is iterator
+   * @tparam KmerParser   parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+  static ::std::pair<size_t, size_t> read_file_direct(const std::string & filename,
+                         std::vector<typename KmerParser::value_type>& result,
+                         const mxx::comm & _comm) {
+
+      return read_file<::bliss::io::parallel::partitioned_file<::bliss::io::direct_file, SeqParser >,
           KmerParser, SeqParser, SeqIterType>(filename, result, _comm);
 
   }
+
+  /**
+   * @brief read a BGZF (bgzip) compressed file's content and generate kmers, place in a vector as return result.
+   * @note  static so can be used wihtout instantiating a internal map.
+   * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.   template template parameter, param is iterator
+   * @tparam KmerParser   parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+  static ::std::pair<size_t, size_t> read_file_bgzf(const std::string & filename,
+                         std::vector<typename KmerParser::value_type>& result,
+                         const mxx::comm & _comm) {
+
+      return read_file<::bliss::io::parallel::bgzf_file<SeqParser >,
+          KmerParser, SeqParser, SeqIterType>(filename, result, _comm);
+
+  }
+
+  /**
+   * @brief read a list of files' content as one input, partitioned evenly by bytes across all files, and generate kmers.
+   * @note  static so can be used wihtout instantiating a internal map.
+   * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.   template template parameter, param is iterator
+   * @tparam KmerParser   parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
+   */
+  template <typename KmerParser, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+  static ::std::pair<size_t, size_t> read_files(const std::vector<std::string> & filenames,
+                         std::vector<typename KmerParser::value_type>& result,
+                         const mxx::comm & _comm, bool const dedup = false) {
+
+      return read_file<::bliss::io::parallel::multi_file<SeqParser >,
+          KmerParser, SeqParser, SeqIterType>(filenames, result, _comm, dedup);
+
+  }
 #endif
 
 
@@ -20,7 +20,7 @@
  * @author  Tony Pan <tpan7@gatech.edu>
  * @brief kmer parsers definitions
  * @details 4 primary Kmer Parser classes are currently provided:
- *      Kmer
+ *      Kmer (also canonical, and quality filtered)
  *      Kmer Count tuple,
  *      Kmer Position tuple, and
  *      Kmer Position + Quality score tuple.
@@ -44,6 +44,16 @@
 #include <utility>      // pair and utility functions.
 #include <type_traits>
 #include <cctype>       // tolower.
+#include <vector>
+#include <iterator>     // back_inserter
+#include <algorithm>    // copy_if
+#include <cmath>        // pow
+#include <deque>
+#include <numeric>      // accumulate
+
+#if defined(__BMI2__)
+#include <immintrin.h>  // pext
+#endif
 
 #include "utils/logging.h"
 #include "utils/file_utils.hpp"
@@ -53,6 +63,7 @@
 #include "common/sequence.hpp"
 #include "utils/kmer_utils.hpp"
 #include "utils/filter_utils.hpp"
+#include "utils/integer_sequence.hpp"
 
 #include "index/kmer_hash.hpp"
 #include "common/kmer_transform.hpp"
@@ -61,7 +72,9 @@
 #include "io/sequence_id_iterator.hpp"
 #include "iterators/transform_iterator.hpp"
 #include "common/kmer_iterators.hpp"
+#include "common/ascii_translate.hpp"
 #include "iterators/zip_iterator.hpp"
+#include "iterators/filter_iterator.hpp"
 #include "iterators/unzip_iterator.hpp"
 #include "iterators/constant_iterator.hpp"
 #include "index/quality_score_iterator.hpp"
@@ -286,10 +299,49 @@ public:
 ////      else
 ////        return ::std::copy_if(start, end, output_iter, pred);
 //    }
-    iterator_type<SeqType> istart = begin(read, window_size);
-    iterator_type<SeqType> iend = end(read, window_size);
+    // bulk path:  translate the whole read at once (simd for DNA),
+    // then slide the window over the contiguous alphabet values.  same output as begin()/end() iterators.
+    size_t count = load_codes(read);
+    if (count == 0) return output_iter;
 
-    return std::copy(istart, iend, output_iter);
+    uint8_t const * it = codes.data();
+    uint8_t const * it_end = codes.data() + count;
+
+    kmer_type kmer;
+    kmer.fillFromChars(it, false);
+    *output_iter = kmer;
+    ++output_iter;
+
+    for (; it != it_end; ++it, ++output_iter) {
+      kmer.nextFromChar(*it);
+      *output_iter = kmer;
+    }
+
+    return output_iter;
+  }
+
+protected:
+  /// reusable buffer for the translated characters of a read, used by operator().
+  std::vector<uint8_t> codes;
+
+  /// compact out the EOL characters of the valid part of the read into codes, and translate to alphabet values.
+  /// returns number of characters, or 0 if there are fewer than window characters.
+  template <typename SeqType>
+  size_t load_codes(SeqType const & read, size_t const window = window_size) {
+    typename SeqType::IteratorType seq_begin;
+    typename SeqType::IteratorType seq_end;
+    bool has_window = false;
+
+    std::tie(seq_begin, seq_end, has_window) =
+        ::bliss::index::kmer::KmerParser<kmer_type>::get_valid_iterator_range(read, valid_range, window);
+
+    if (!has_window) return 0;
+
+    codes.clear();
+    std::copy_if(seq_begin, seq_end, std::back_inserter(codes), bliss::utils::file::NotEOL());
+
+    ::bliss::common::ASCII2Bulk<Alphabet>()(codes.data(), codes.size(), codes.data());
+    return codes.size();
   }
 };
 
@@ -297,6 +349,496 @@ template <typename KmerType>
 constexpr size_t KmerParser<KmerType>::window_size;
 
 
+/**
+ * @brief kmer parser that generates canonical kmers, i.e. min(kmer, reverse complement), directly.
+ * @details the forward and reverse complement kmers are both updated incrementally, 1 character per step,
+ *          instead of computing the reverse complement of every kmer.  use with a map whose input transform
+ *          is identity (e.g. SingleStrandHashMapParams), since the kmers are already canonical.
+ * @tparam KmerType       output value type of this parser.
+ */
+template <typename KmerType>
+class CanonicalKmerParser : public KmerParser<KmerType> {
+
+protected:
+  using BaseType = KmerParser<KmerType>;
+  using Alphabet = typename BaseType::Alphabet;
+
+  // filter out EOL characters
+  template <typename SeqType>
+  using CharIter = bliss::index::kmer::NonEOLIter<typename SeqType::IteratorType>;
+
+  // converter from ascii to alphabet values
+  template <typename SeqType>
+  using BaseCharIterator = bliss::iterator::transform_iterator<CharIter<SeqType>, bliss::common::ASCII2<Alphabet> >;
+
+public:
+  using value_type = typename BaseType::value_type;
+  using kmer_type = typename BaseType::kmer_type;
+  static constexpr size_t window_size = BaseType::window_size;
+
+  // canonical kmer generation iterator
+  template <typename SeqType>
+  using iterator_type = bliss::common::CanonicalKmerGenerationIterator<BaseCharIterator<SeqType>, kmer_type>;
+
+
+  CanonicalKmerParser(::bliss::partition::range<size_t> const & _valid_range) : BaseType(_valid_range) {};
+
+
+  template <typename SeqType>
+  iterator_type<SeqType> begin(SeqType const & read, size_t const & window = window_size) const {
+      typename SeqType::IteratorType seq_begin;
+      typename SeqType::IteratorType seq_end;
+      bool has_window = false;
+
+      std::tie(seq_begin, seq_end, has_window) =
+          BaseType::get_valid_iterator_range(read, this->valid_range, window);
+
+      //== set up the kmer generating iterators.
+      bliss::utils::file::NotEOL neol;
+
+      if (has_window) {
+        return iterator_type<SeqType>(BaseCharIterator<SeqType>(
+            CharIter<SeqType>(neol, seq_begin, seq_end),
+            bliss::common::ASCII2<Alphabet>()),
+            true);
+      } else {
+        return iterator_type<SeqType>(BaseCharIterator<SeqType>(
+            CharIter<SeqType>(neol, seq_end),
+            bliss::common::ASCII2<Alphabet>()),
+            false);
+      }
+  }
+
+  template <typename SeqType>
+  iterator_type<SeqType> end(SeqType const & read, size_t const & window = window_size) const {
+      typename SeqType::IteratorType seq_begin;
+      typename SeqType::IteratorType seq_end;
+      bool has_window = false;
+
+      std::tie(seq_begin, seq_end, has_window) =
+          BaseType::get_valid_iterator_range(read, this->valid_range, window);
+
+      //== set up the kmer generating iterators.
+      bliss::utils::file::NotEOL neol;
+
+      return iterator_type<SeqType>(BaseCharIterator<SeqType>(
+          CharIter<SeqType>(neol, seq_end),
+          bliss::common::ASCII2<Alphabet>()),
+          false);
+  }
+
+
+  /**
+   * @brief generate canonical kmers from 1 sequence.  result inserted into output_iter, which may be preallocated.
+   * @param read          sequence object, which has pointers to the raw byte array.
+   * @param output_iter   output iterator pointing to insertion point for underlying container.
+   * @return new position for output_iter
+   * @tparam SeqType      type of sequence.  inferred.
+   * @tparam OutputIt     output iterator type, inferred.
+   */
+  template <typename SeqType, typename OutputIt, typename Predicate = ::bliss::filter::TruePredicate>
+  OutputIt operator()(SeqType const & read, OutputIt output_iter, Predicate const & pred = Predicate()) {
+
+    static_assert(std::is_same<KmerType, typename ::std::iterator_traits<OutputIt>::value_type>::value,
+            "output type and output container value type are not the same");
+
+    size_t count = this->load_codes(read);
+    if (count == 0) return output_iter;
+
+    uint8_t const * it = this->codes.data();
+    uint8_t const * it_end = this->codes.data() + count;
+
+    kmer_type kmer;
+    kmer_type rev_comp;
+    for (size_t i = 0; i < window_size; ++i, ++it) {
+      kmer.nextFromChar(*it);
+      rev_comp.nextReverseFromChar(Alphabet::to_complement(*it));
+    }
+    *output_iter = (kmer < rev_comp) ? kmer : rev_comp;
+    ++output_iter;
+
+    for (; it != it_end; ++it, ++output_iter) {
+      kmer.nextFromChar(*it);
+      rev_comp.nextReverseFromChar(Alphabet::to_complement(*it));
+      *output_iter = (kmer < rev_comp) ? kmer : rev_comp;
+    }
+
+    return output_iter;
+  }
+};
+
+template <typename KmerType>
+constexpr size_t CanonicalKmerParser<KmerType>::window_size;
+
+
+/**
+ * @brief kmer parser that emits each kmer with its ntHash (index/kmer_hash.hpp), rolled 1 character at a time.
+ * @details the hash is the value of nthash<kmer_type, false>, i.e. StoreHashNt, and the distribution hash
+ *          nthash<kmer_type, true> is nthash<kmer_type, true>::finish of it, so code that buckets or stores the kmers
+ *          itself does not hash them again, and needs no reverse complement for canonical distribution.
+ *          the kmers are the forward kmers, as KmerParser's.  only the bulk operator() is provided.
+ * @tparam TupleType       output value type of this parser, (kmer, 64 bit hash).
+ */
+template <typename TupleType>
+class HashedKmerParser : public KmerParser<typename ::std::tuple_element<0, TupleType>::type> {
+
+protected:
+  using BaseType = KmerParser<typename ::std::tuple_element<0, TupleType>::type>;
+  using Alphabet = typename BaseType::Alphabet;
+
+public:
+  using value_type = TupleType;
+  using kmer_type = typename BaseType::kmer_type;
+  using hash_type = ::bliss::kmer::hash::nthash<kmer_type, false>;
+  static constexpr size_t window_size = BaseType::window_size;
+
+  static_assert(::std::is_integral<typename ::std::tuple_element<1, TupleType>::type>::value &&
+                (sizeof(typename ::std::tuple_element<1, TupleType>::type) == sizeof(uint64_t)),
+                "hashed kmer parser emits 64 bit hashes");
+
+  HashedKmerParser(::bliss::partition::range<size_t> const & _valid_range) : BaseType(_valid_range) {};
+
+  /**
+   * @brief generate (kmer, hash) pairs from 1 sequence.  result inserted into output_iter, which may be preallocated.
+   * @param read          sequence object, which has pointers to the raw byte array.
+   * @param output_iter   output iterator pointing to insertion point for underlying container.
+   * @return new position for output_iter
+   * @tparam SeqType      type of sequence.  inferred.
+   * @tparam OutputIt     output iterator type, inferred.
+   */
+  template <typename SeqType, typename OutputIt, typename Predicate = ::bliss::filter::TruePredicate>
+  OutputIt operator()(SeqType const & read, OutputIt output_iter, Predicate const & pred = Predicate()) {
+
+    static_assert(std::is_same<TupleType, typename ::std::iterator_traits<OutputIt>::value_type>::value,
+            "output type and output container value type are not the same");
+
+    size_t count = this->load_codes(read);
+    if (count == 0) return output_iter;
+
+    uint8_t const * first = this->codes.data();   // first character of the window
+    uint8_t const * it = first;
+    uint8_t const * it_end = first + count;
+
+    kmer_type kmer;
+    kmer.fillFromChars(it, false);
+    uint64_t fw = hash_type::forward(kmer);
+    uint64_t rv = hash_type::reverse(kmer);
+    *output_iter = TupleType(kmer, hash_type::combine(fw, rv));
+    ++output_iter;
+
+    for (; it != it_end; ++it, ++first, ++output_iter) {
+      kmer.nextFromChar(*it);
+      fw = hash_type::roll_forward(fw, *first, *it);
+      rv = hash_type::roll_reverse(rv, *first, *it);
+      *output_iter = TupleType(kmer, hash_type::combine(fw, rv));
+    }
+
+    return output_iter;
+  }
+};
+
+template <typename TupleType>
+constexpr size_t HashedKmerParser<TupleType>::window_size;
+
+
+/// number of care positions of a spaced seed mask.
+constexpr size_t spaced_seed_weight(uint64_t const mask) {
+  return (mask == 0) ? 0 : ((mask & 1) + spaced_seed_weight(mask >> 1));
+}
+
+/// span of a spaced seed mask:  1 + the last care position.
+constexpr size_t spaced_seed_span(uint64_t const mask) {
+  return (mask == 0) ? 0 : (1 + spaced_seed_span(mask >> 1));
+}
+
+/**
+ * @brief kmer parser for a spaced seed:  slides a window of span characters and keeps only the "care" positions.
+ * @details bit i of Mask is set if the i-th character of the window is a care position.  the first position is always a
+ *          care position, and the span is the last one + 1.  the weight, i.e. the number of care positions, is
+ *          KmerType::size, so a seed of weight w over span k is stored in a Kmer<w> table instead of a Kmer<k> one, and
+ *          a sequencing error at a don't care position leaves the seed intact.  e.g. 0b11011011 is the codon seed
+ *          "11011011", of weight 6 and span 8.
+ *
+ *          the span window is a Kmer<span>, rolled 1 character at a time.  each seed is the window bit-and a constant
+ *          Kmer with the care characters' bits set, with the care characters then packed together, in window order
+ *          (with pext when BMI2 is available, otherwise 1 shift per run of care positions).  the window must fit in 1
+ *          64 bit word, i.e. span up to 32 for DNA, 21 for DNA5.
+ *
+ *          the seeds are forward seeds.  a map that canonicalizes its keys, e.g. CanonicalHashMapParams, gives strand
+ *          independent seeds only for a palindromic mask, for which the reverse complement of a seed is the seed of the
+ *          reverse complement.  only the bulk operator() is provided.
+ * @tparam KmerType       output value type of this parser, a kmer of the seed's weight.
+ * @tparam Mask           care positions.
+ */
+template <typename KmerType, uint64_t Mask>
+class SpacedSeedKmerParser : public KmerParser<KmerType> {
+
+protected:
+  using BaseType = KmerParser<KmerType>;
+  using Alphabet = typename BaseType::Alphabet;
+
+public:
+  using value_type = typename BaseType::value_type;
+  using kmer_type = typename BaseType::kmer_type;
+  static constexpr size_t span = spaced_seed_span(Mask);
+  static constexpr size_t weight = spaced_seed_weight(Mask);
+  /// characters needed for 1 seed.  also the overlap between partitions, + 1.
+  static constexpr size_t window_size = span;
+
+  using window_type = ::bliss::common::Kmer<span, Alphabet, uint64_t>;
+
+  static_assert((Mask & 1) == 1, "the first position of a spaced seed is a care position.");
+  static_assert(weight == kmer_type::size, "the kmer size is the weight of the spaced seed.");
+  static_assert(window_type::nWords == 1, "spaced seed window must fit in 1 64 bit word.");
+  static_assert(kmer_type::nWords == 1, "spaced seed kmer must fit in 1 word.");
+
+protected:
+  /// the bits of the care characters, in the window's layout:  the first character is the most significant.
+  static uint64_t care_bits() {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < span; ++i) {
+      if ((Mask >> i) & 1) {
+        bits |= ((static_cast<uint64_t>(1) << window_type::bitsPerChar) - 1) << ((span - 1 - i) * window_type::bitsPerChar);
+      }
+    }
+    return bits;
+  }
+
+  /// the window as a kmer with care_bits set, for bit_and.
+  static window_type care_kmer() {
+    window_type care;
+    care.getDataRef()[0] = care_bits();
+    return care;
+  }
+
+  /// (source shift, bits) of each run of care characters, least significant first, for packing without pext.
+  std::vector<std::pair<unsigned int, uint64_t> > runs;
+  window_type care;
+
+  inline uint64_t pack(uint64_t const masked) const {
+#if defined(__BMI2__)
+    return _pext_u64(masked, care.getData()[0]);
+#else
+    uint64_t packed = 0;
+    unsigned int dest = 0;
+    for (auto const & r : runs) {
+      packed |= ((masked >> r.first) & r.second) << dest;
+      dest += __builtin_popcountll(r.second);
+    }
+    return packed;
+#endif
+  }
+
+public:
+  SpacedSeedKmerParser(::bliss::partition::range<size_t> const & _valid_range) : BaseType(_valid_range), care(care_kmer()) {
+    uint64_t bits = care.getData()[0];
+    unsigned int pos = 0;
+    while (bits != 0) {
+      unsigned int start = __builtin_ctzll(bits);
+      bits >>= start;
+      pos += start;
+      unsigned int len = (~bits == 0) ? 64 : __builtin_ctzll(~bits);
+      runs.emplace_back(pos, (len == 64) ? ~static_cast<uint64_t>(0) : ((static_cast<uint64_t>(1) << len) - 1));
+      bits = (len == 64) ? 0 : (bits >> len);
+      pos += len;
+    }
+  };
+
+  /**
+   * @brief generate the seeds of 1 sequence.  result inserted into output_iter, which may be preallocated.
+   * @param read          sequence object, which has pointers to the raw byte array.
+   * @param output_iter   output iterator pointing to insertion point for underlying container.
+   * @return new position for output_iter
+   * @tparam SeqType      type of sequence.  inferred.
+   * @tparam OutputIt     output iterator type, inferred.
+   */
+  template <typename SeqType, typename OutputIt, typename Predicate = ::bliss::filter::TruePredicate>
+  OutputIt operator()(SeqType const & read, OutputIt output_iter, Predicate const & pred = Predicate()) {
+
+    static_assert(std::is_same<KmerType, typename ::std::iterator_traits<OutputIt>::value_type>::value,
+            "output type and output container value type are not the same");
+
+    size_t count = this->load_codes(read, window_size);
+    if (count == 0) return output_iter;
+
+    uint8_t const * it = this->codes.data();
+    uint8_t const * it_end = this->codes.data() + count;
+
+    window_type window;
+    window.fillFromChars(it, false);
+    kmer_type seed;
+    seed.getDataRef()[0] = static_cast<typename kmer_type::KmerWordType>(pack((window & care).getData()[0]));
+    *output_iter = seed;
+    ++output_iter;
+
+    for (; it != it_end; ++it, ++output_iter) {
+      window.nextFromChar(*it);
+      seed.getDataRef()[0] = static_cast<typename kmer_type::KmerWordType>(pack((window & care).getData()[0]));
+      *output_iter = seed;
+    }
+
+    return output_iter;
+  }
+};
+
+template <typename KmerType, uint64_t Mask>
+constexpr size_t SpacedSeedKmerParser<KmerType, Mask>::window_size;
+
+
+/**
+ * @brief kmer parser that drops low quality kmers as they are generated, so they are never distributed or stored.
+ * @details a kmer is emitted only if every base has phred score >= MinBasePhred, and the probability that the kmer is correct,
+ *          prod(p_correct), is at least that of phred score MinKmerPhred.  kmers with a base of zero probability of being correct
+ *          (phred 0) are always dropped.  the kmer quality is the sliding window product of QualityScoreGenerationIterator, as in
+ *          KmerPositionQualityTupleParser, with bases below MinBasePhred decoded as incorrect (MinPhredQualityScoreCodec).
+ * @tparam KmerType       output value type of this parser.
+ * @tparam MinBasePhred   minimum phred score of each base in a kmer.  0 disables.
+ * @tparam MinKmerPhred   minimum phred score of the kmer.  0 disables.
+ * @tparam QualityEncoder quality score codec, for decoding the quality characters.
+ */
+template <typename KmerType, unsigned char MinBasePhred = 20, unsigned char MinKmerPhred = 0,
+    template<typename> class QualityEncoder = bliss::index::Illumina18QualityScoreCodec>
+class QualityFilteredKmerParser {
+
+public:
+  /// type of element generated by this parser.
+  using value_type = KmerType;
+  using kmer_type = KmerType;
+  static constexpr size_t window_size = kmer_type::size;
+
+protected:
+  using Alphabet = typename kmer_type::KmerAlphabet;
+  using Codec = bliss::index::MinPhredQualityScoreCodec<QualityEncoder<double>, MinBasePhred>;
+
+  // filter out EOL characters
+  template <typename SeqType>
+  using CharIter = bliss::index::kmer::NonEOLIter<typename SeqType::IteratorType>;
+
+  // converter from ascii to alphabet values
+  template <typename SeqType>
+  using BaseCharIterator = bliss::iterator::transform_iterator<CharIter<SeqType>, bliss::common::ASCII2<Alphabet> >;
+
+  // kmer generation iterator
+  template <typename SeqType>
+  using KmerIter = bliss::common::KmerGenerationIterator<BaseCharIterator<SeqType>, kmer_type>;
+
+  // kmer quality (probability of being correct), with eol removed.
+  template <typename SeqType>
+  using QualIterType = bliss::index::QualityScoreGenerationIterator<CharIter<SeqType>, kmer_type::size, Codec>;
+
+  template <typename SeqType>
+  using KmerQualIterType = bliss::iterator::ZipIterator<KmerIter<SeqType>, QualIterType<SeqType> >;
+
+  /// predicate on (kmer, quality) pairs
+  struct quality_filter {
+      double min_prob;
+      quality_filter(double const & _min_prob = 0.0) : min_prob(_min_prob) {};
+
+      template <typename Pair>
+      inline bool operator()(Pair const & kq) const {
+        return (kq.second > 0.0) && (kq.second >= min_prob);
+      }
+  };
+
+  template <typename SeqType>
+  using FilteredIterType = bliss::iterator::filter_iterator<quality_filter, KmerQualIterType<SeqType> >;
+
+  /// drops the quality from the (kmer, quality) pair
+  struct select_kmer {
+      template <typename Pair>
+      inline kmer_type operator()(Pair const & kq) const {
+        return kq.first;
+      }
+  };
+
+  ::bliss::partition::range<size_t> valid_range;
+
+  /// probability of being correct for a kmer with phred score MinKmerPhred
+  quality_filter filter;
+
+public:
+  template <typename SeqType>
+  using iterator_type = bliss::iterator::transform_iterator<FilteredIterType<SeqType>, select_kmer>;
+
+
+  QualityFilteredKmerParser(::bliss::partition::range<size_t> const & _valid_range) :
+    valid_range(_valid_range), filter(1.0 - std::pow(10.0, static_cast<double>(MinKmerPhred) / -10.0)) {};
+
+  template <typename SeqType>
+  iterator_type<SeqType> begin(SeqType const & read, size_t const & window = window_size) const {
+      static_assert(SeqType::has_quality(), "Sequence Parser needs to support quality scores");
+      static_assert(std::is_same<typename std::iterator_traits<iterator_type<SeqType> >::value_type,
+                    value_type>::value,
+                    "Generating iterator value type differs from expected");
+
+      typename SeqType::IteratorType seq_begin;
+      typename SeqType::IteratorType seq_end;
+      bool has_window = false;
+
+      std::tie(seq_begin, seq_end, has_window) =
+          ::bliss::index::kmer::KmerParser<kmer_type>::get_valid_iterator_range(read, valid_range, window);
+
+      if (!has_window) return end(read, window);
+
+      typename SeqType::IteratorType qual_begin = read.qual_begin;
+      std::advance(qual_begin, std::distance(read.seq_begin, seq_begin));
+      typename SeqType::IteratorType qual_end = qual_begin;
+      std::advance(qual_end, std::distance(seq_begin, seq_end));
+
+      bliss::utils::file::NotEOL neol;
+      KmerQualIterType<SeqType> start(
+          KmerIter<SeqType>(BaseCharIterator<SeqType>(CharIter<SeqType>(neol, seq_begin, seq_end), bliss::common::ASCII2<Alphabet>()), true),
+          QualIterType<SeqType>(CharIter<SeqType>(neol, qual_begin, qual_end)));
+      KmerQualIterType<SeqType> stop(
+          KmerIter<SeqType>(BaseCharIterator<SeqType>(CharIter<SeqType>(neol, seq_end), bliss::common::ASCII2<Alphabet>()), false),
+          QualIterType<SeqType>(CharIter<SeqType>(neol, qual_end)));
+
+      return iterator_type<SeqType>(FilteredIterType<SeqType>(filter, start, stop), select_kmer());
+  }
+
+  template <typename SeqType>
+  iterator_type<SeqType> end(SeqType const & read, size_t const & window = window_size) const {
+      static_assert(SeqType::has_quality(), "Sequence Parser needs to support quality scores");
+
+      typename SeqType::IteratorType seq_begin;
+      typename SeqType::IteratorType seq_end;
+      bool has_window = false;
+
+      std::tie(seq_begin, seq_end, has_window) =
+          ::bliss::index::kmer::KmerParser<kmer_type>::get_valid_iterator_range(read, valid_range, window);
+
+      typename SeqType::IteratorType qual_end = read.qual_begin;
+      std::advance(qual_end, std::distance(read.seq_begin, seq_end));
+
+      bliss::utils::file::NotEOL neol;
+      KmerQualIterType<SeqType> stop(
+          KmerIter<SeqType>(BaseCharIterator<SeqType>(CharIter<SeqType>(neol, seq_end), bliss::common::ASCII2<Alphabet>()), false),
+          QualIterType<SeqType>(CharIter<SeqType>(neol, qual_end)));
+
+      return iterator_type<SeqType>(FilteredIterType<SeqType>(filter, stop), select_kmer());
+  }
+
+  /**
+   * @brief generate the kmers that pass the quality thresholds from 1 sequence.  result inserted into output_iter.
+   * @param read          sequence object with quality scores.
+   * @param output_iter   output iterator pointing to insertion point for underlying container.
+   * @return new position for output_iter
+   * @tparam SeqType      type of sequence.  inferred.
+   * @tparam OutputIt     output iterator type, inferred.
+   */
+  template <typename SeqType, typename OutputIt, typename Predicate = ::bliss::filter::TruePredicate>
+  OutputIt operator()(SeqType const & read, OutputIt output_iter, Predicate const & pred = Predicate()) {
+    static_assert(std::is_same<KmerType, typename ::std::iterator_traits<OutputIt>::value_type>::value,
+            "output type and output container value type are not the same");
+
+    return std::copy(begin(read, window_size), end(read, window_size), output_iter);
+  }
+};
+
+template <typename KmerType, unsigned char MinBasePhred, unsigned char MinKmerPhred, template<typename> class QualityEncoder>
+constexpr size_t QualityFilteredKmerParser<KmerType, MinBasePhred, MinKmerPhred, QualityEncoder>::window_size;
+
+
 /**
  * @tparam TupleType       output value type of this parser.  not necessarily the same as the map's final storage type.
  */
@@ -571,8 +1113,104 @@ public:
 template <typename TupleType>
 constexpr size_t KmerPositionTupleParser<TupleType>::window_size;
 
+
+/**
+ * @brief position tuples of the (w,k)-minimizers of each sequence, for a sampled position index.
+ * @details  of every W consecutive k-mers, the one with the smallest hash is kept, the leftmost on ties.  adjacent windows
+ *           mostly share their minimizer, so about 2/(W+1) of the k-mers are kept.  the hash is of the canonical k-mer, so a
+ *           sequence and its reverse complement keep the same k-mers.  sample queries with sample_offsets, so that a read
+ *           keeps the minimizers it shares with its reference locus.  a sequence shorter than W k-mers keeps its minimum.
+ *           sampling starts over at each sequence and partition boundary, which may keep a few more k-mers there.
+ * @tparam TupleType   output value type of this parser, (k-mer, position).
+ * @tparam W           window, in k-mers.  1 keeps every k-mer.
+ */
+template <typename TupleType, unsigned int W = 10>
+class KmerPositionMinimizerTupleParser : public KmerPositionTupleParser<TupleType> {
+    static_assert(W > 0, "minimizer window needs at least 1 kmer");
+
+  protected:
+    using BaseType = KmerPositionTupleParser<TupleType>;
+
+    /// all position tuples of the current sequence, before sampling.
+    ::std::vector<TupleType> buffer;
+
+  public:
+    using value_type = typename BaseType::value_type;
+    using kmer_type = typename BaseType::kmer_type;
+    static constexpr size_t window_size = BaseType::window_size;
+    /// window of the minimizers, in kmers.
+    static constexpr unsigned int window = W;
+
+    KmerPositionMinimizerTupleParser(::bliss::partition::range<size_t> const & _valid_range) : BaseType(_valid_range) {};
+
+    /**
+     * @brief offsets of the (W,k)-minimizers among consecutive k-mers, in increasing order.
+     * @param first, last   consecutive k-mers, e.g. of a read.  random access.
+     * @param get_kmer      the k-mer of an element, for tuples.
+     */
+    template <typename Iter, typename GetKmer>
+    static ::std::vector<size_t> sample_offsets(Iter first, Iter last, GetKmer const & get_kmer) {
+      ::std::vector<size_t> picked;
+      size_t n = ::std::distance(first, last);
+      if (n == 0) return picked;
+
+      ::bliss::kmer::hash::murmur64<kmer_type, false> hash;
+      ::std::vector<uint64_t> h(n);
+      for (size_t i = 0; i < n; ++i) {
+        kmer_type const & k = get_kmer(*(first + i));
+        h[i] = hash(::std::min(k, k.reverse_complement()));
+      }
+
+      // monotone deque of the window's candidates, increasing hash.  equal hashes stay, so the front is the leftmost minimum.
+      size_t w = ::std::min(static_cast<size_t>(W), n);
+      ::std::deque<size_t> q;
+      for (size_t i = 0; i < n; ++i) {
+        while (!q.empty() && (h[q.back()] > h[i])) q.pop_back();
+        q.push_back(i);
+        while (q.front() + w <= i) q.pop_front();
+
+        if ((i + 1 >= w) && (picked.empty() || (picked.back() != q.front()))) picked.push_back(q.front());
+      }
+      return picked;
+    }
+
+    /// offsets of the (W,k)-minimizers of consecutive k-mers.
+    static ::std::vector<size_t> sample_offsets(::std::vector<kmer_type> const & kmers) {
+      return sample_offsets(kmers.begin(), kmers.end(), [](kmer_type const & k) -> kmer_type const & { return k; });
+    }
+
+    /**
+     * @brief generate the position tuples of the minimizers of 1 sequence.  result inserted into output_iter.
+     * @param read          sequence object, which has pointers to the raw byte array.
+     * @param output_iter   output iterator pointing to insertion point for underlying container.
+     * @return new position for output_iter
+     */
+    template <typename SeqType, typename OutputIt, typename Predicate = ::bliss::filter::TruePredicate>
+    OutputIt operator()(SeqType const & read, OutputIt output_iter, Predicate const & pred = Predicate()) {
+      static_assert(std::is_same<TupleType, typename ::std::iterator_traits<OutputIt>::value_type>::value,
+              "output type and output container value type are not the same");
+
+      buffer.clear();
+      ::std::copy(this->begin(read, window_size), this->end(read, window_size), ::std::back_inserter(buffer));
+
+      ::std::vector<size_t> picked = sample_offsets(buffer.begin(), buffer.end(),
+          [](TupleType const & t) -> kmer_type const & { return ::std::get<0>(t); });
+      for (size_t i = 0; i < picked.size(); ++i, ++output_iter) {
+        *output_iter = buffer[picked[i]];
+      }
+      return output_iter;
+    }
+};
+
+template <typename TupleType, unsigned int W>
+constexpr size_t KmerPositionMinimizerTupleParser<TupleType, W>::window_size;
+template <typename TupleType, unsigned int W>
+constexpr unsigned int KmerPositionMinimizerTupleParser<TupleType, W>::window;
+
 /**
  * @tparam TupleType       output value type of this parser.  not necessarily the same as the map's final storage type.
+ *                         the quality may be float, double, or a bliss::index::QuantizedQuality, which is computed in double
+ *                         and then quantized.
  */
 template <typename TupleType, template<typename> class QualityEncoder = bliss::index::Illumina18QualityScoreCodec>
 class KmerPositionQualityTupleParser {
@@ -589,6 +1227,9 @@ public:
 protected:
   using Alphabet = typename kmer_type::KmerAlphabet;
 
+  /// floating point type the quality score iterator computes in.
+  using ComputeQualType = typename bliss::index::QualityComputeType<QualType>::type;
+
   static_assert(::std::tuple_size<mapped_type>::value == 2, "pos-qual index data type should be a pair");
 
   // filter out EOL characters
@@ -622,11 +1263,17 @@ protected:
   // also remove eol from quality score
   template <typename SeqType>
   using QualIterType =
-      bliss::index::QualityScoreGenerationIterator<NonEOLIter<typename SeqType::IteratorType>, kmer_type::size, QualityEncoder<QualType> >;
+      bliss::index::QualityScoreGenerationIterator<NonEOLIter<typename SeqType::IteratorType>, kmer_type::size, QualityEncoder<ComputeQualType> >;
+
+  // quality score iterator with QualType values.  quantizes, if QualType is not the computed type.
+  template <typename SeqType>
+  using StoredQualIterType = typename std::conditional<std::is_same<QualType, ComputeQualType>::value,
+      QualIterType<SeqType>,
+      bliss::iterator::transform_iterator<QualIterType<SeqType>, bliss::index::QualityQuantizer<QualType> > >::type;
 
   /// combine kmer iterator and position iterator to create an index iterator type.
   template <typename SeqType>
-  using KmerInfoIterType = bliss::iterator::ZipIterator<IdIter<SeqType>, QualIterType<SeqType> >;
+  using KmerInfoIterType = bliss::iterator::ZipIterator<IdIter<SeqType>, StoredQualIterType<SeqType> >;
 
 
   ::bliss::partition::range<size_t> valid_range;
@@ -689,7 +1336,7 @@ public:
     			  bliss::common::ASCII2<Alphabet>()), true);
           //CharPosIter<SeqType> cp_begin(neol, pp_begin, pp_end);
           QualIterType<SeqType> qual_start(CharIter<SeqType>(neol, qual_begin, qual_end));
-          KmerInfoIterType<SeqType> info_start(IdIter<SeqType>(std::make_shared<CharPosIter<SeqType> >(neol, pp_begin, pp_end) ), qual_start);
+          KmerInfoIterType<SeqType> info_start(IdIter<SeqType>(std::make_shared<CharPosIter<SeqType> >(neol, pp_begin, pp_end) ), StoredQualIterType<SeqType>(qual_start));
     	  return iterator_type<SeqType>(start, info_start);
       } else {
           KmerIter<SeqType> end(BaseCharIterator<SeqType>(
@@ -697,7 +1344,7 @@ public:
     			  bliss::common::ASCII2<Alphabet>()), false);
 //          CharPosIter<SeqType> cp_end(neol, pp_end);
           QualIterType<SeqType> qual_end_iter(CharIter<SeqType>(neol, qual_end));
-          KmerInfoIterType<SeqType> info_end(IdIter<SeqType>(std::make_shared<CharPosIter<SeqType> >(neol, pp_end)), qual_end_iter);
+          KmerInfoIterType<SeqType> info_end(IdIter<SeqType>(std::make_shared<CharPosIter<SeqType> >(neol, pp_end)), StoredQualIterType<SeqType>(qual_end_iter));
           return iterator_type<SeqType>(end, info_end);
       }
   }
@@ -751,7 +1398,7 @@ public:
       // filter eol and generate quality scores
       QualIterType<SeqType> qual_end_iter(CharIter<SeqType>(neol, qual_end));
 
-      KmerInfoIterType<SeqType> info_end(IdIter<SeqType>(std::make_shared<CharPosIter<SeqType> >(neol, pp_end)), qual_end_iter);
+      KmerInfoIterType<SeqType> info_end(IdIter<SeqType>(std::make_shared<CharPosIter<SeqType> >(neol, pp_end)), StoredQualIterType<SeqType>(qual_end_iter));
 
 
       // ==== set up the zip iterators
@@ -1085,6 +1732,149 @@ template <typename TupleType>
 constexpr size_t KmerCountTupleParser<TupleType>::window_size;
 
 
+/**
+ * @brief kmer parser for several k at once, e.g. for a parameter sweep over k.
+ * @details each read is compacted and translated to alphabet values once, and the kmers of every kmer type are generated
+ *          from the shared values:  for each type, the same kmers as KmerParser of that type on the read.
+ *          the output is a tuple of vectors, 1 per kmer type, so this is not a drop in kmer parser.
+ *          KmerFileHelper::stream_file_multi_k drives it, and build_multi_k in kmer_index.hpp builds indices with it.
+ *          window_size is the largest k, which sets the overlap of the partitions.
+ * @tparam KmerTypes   kmer types, all of the same alphabet.
+ */
+template <typename... KmerTypes>
+class MultiKmerParser {
+
+protected:
+  template <typename... Ks>
+  struct max_size;
+  template <typename K>
+  struct max_size<K> {
+      static constexpr size_t value = K::size;
+  };
+  template <typename K, typename... Ks>
+  struct max_size<K, Ks...> {
+      static constexpr size_t value = (K::size > max_size<Ks...>::value) ? K::size : max_size<Ks...>::value;
+  };
+
+  using kmer_tuple_type = ::std::tuple<KmerTypes...>;
+
+public:
+  /// 1 vector of kmers per kmer type.
+  using buffer_type = ::std::tuple<::std::vector<KmerTypes>...>;
+  using Alphabet = typename ::std::tuple_element<0, kmer_tuple_type>::type::KmerAlphabet;
+  static constexpr size_t window_size = max_size<KmerTypes...>::value;
+
+  static_assert(sizeof...(KmerTypes) > 0, "multi kmer parser needs at least 1 kmer type");
+
+  MultiKmerParser(::bliss::partition::range<size_t> const & _valid_range) : valid_range(_valid_range), valid_codes(0) {};
+
+  /**
+   * @brief generate the kmers of every kmer type from 1 sequence, appended to the vectors in buffers.
+   * @param read          sequence object, which has pointers to the raw byte array.
+   * @tparam SeqType      type of sequence.  inferred.
+   */
+  template <typename SeqType>
+  void operator()(SeqType const & read, buffer_type & buffers) {
+    if (load_codes(read) == 0) return;
+    generate(buffers, ::bliss::utils::make_index_sequence<sizeof...(KmerTypes)>());
+  }
+
+  /// total number of kmers in buffers.
+  static size_t size(buffer_type const & buffers) {
+    return size_of(buffers, ::bliss::utils::make_index_sequence<sizeof...(KmerTypes)>());
+  }
+  /// total bytes of the kmers in buffers.
+  static size_t bytes(buffer_type const & buffers) {
+    return bytes_of(buffers, ::bliss::utils::make_index_sequence<sizeof...(KmerTypes)>());
+  }
+  static void clear(buffer_type & buffers) {
+    clear_all(buffers, ::bliss::utils::make_index_sequence<sizeof...(KmerTypes)>());
+  }
+
+protected:
+  ::bliss::partition::range<size_t> valid_range;
+
+  /// reusable buffer for the translated characters of a read, shared by all kmer types.
+  std::vector<uint8_t> codes;
+  /// number of characters in codes that are in the valid range.  the rest are the overlap for the largest k.
+  size_t valid_codes;
+
+  /// compact out the EOL characters of the valid part of the read and the largest k's overlap into codes, and translate.
+  /// returns number of characters.
+  template <typename SeqType>
+  size_t load_codes(SeqType const & read) {
+    using first_kmer_type = typename ::std::tuple_element<0, kmer_tuple_type>::type;
+
+    typename SeqType::IteratorType seq_begin;
+    typename SeqType::IteratorType seq_end;
+    bool has_window = false;
+
+    // has_window is for the largest k.  the others are checked in generate_k.
+    std::tie(seq_begin, seq_end, has_window) =
+        ::bliss::index::kmer::KmerParser<first_kmer_type>::get_valid_iterator_range(read, valid_range, window_size);
+
+    ::bliss::partition::range<size_t> seq_range(read.seq_global_offset(), read.seq_global_offset() + read.seq_size());
+    typename SeqType::IteratorType valid_end = seq_begin;
+    std::advance(valid_end, ::bliss::partition::range<size_t>::intersect(seq_range, valid_range).size());
+
+    codes.clear();
+    std::copy_if(seq_begin, valid_end, std::back_inserter(codes), bliss::utils::file::NotEOL());
+    valid_codes = codes.size();
+    std::copy_if(valid_end, seq_end, std::back_inserter(codes), bliss::utils::file::NotEOL());
+
+    ::bliss::common::ASCII2Bulk<Alphabet>()(codes.data(), codes.size(), codes.data());
+    return codes.size();
+  }
+
+  /// kmers of the I-th type, from the valid characters and k - 1 characters of overlap.
+  template <size_t I>
+  void generate_k(buffer_type & buffers) const {
+    using kmer_type = typename ::std::tuple_element<I, kmer_tuple_type>::type;
+    static_assert(::std::is_same<typename kmer_type::KmerAlphabet, Alphabet>::value,
+                  "multi kmer parser's kmer types need to have the same alphabet");
+
+    size_t const count = ::std::min(codes.size(), valid_codes + kmer_type::size - 1);
+    if (count < kmer_type::size) return;
+
+    ::std::vector<kmer_type> & output = ::std::get<I>(buffers);
+    uint8_t const * it = codes.data();
+    uint8_t const * it_end = codes.data() + count;
+
+    kmer_type kmer;
+    kmer.fillFromChars(it, false);
+    output.emplace_back(kmer);
+    for (; it != it_end; ++it) {
+      kmer.nextFromChar(*it);
+      output.emplace_back(kmer);
+    }
+  }
+
+  template <size_t... I>
+  void generate(buffer_type & buffers, ::bliss::utils::index_sequence<I...>) const {
+    int dummy[] = {0, (generate_k<I>(buffers), 0)...};
+    BLISS_UNUSED(dummy);
+  }
+  template <size_t... I>
+  static size_t size_of(buffer_type const & buffers, ::bliss::utils::index_sequence<I...>) {
+    size_t sizes[] = {::std::get<I>(buffers).size()...};
+    return ::std::accumulate(sizes, sizes + sizeof...(I), static_cast<size_t>(0));
+  }
+  template <size_t... I>
+  static size_t bytes_of(buffer_type const & buffers, ::bliss::utils::index_sequence<I...>) {
+    size_t bytes[] = {(::std::get<I>(buffers).size() * sizeof(typename ::std::tuple_element<I, kmer_tuple_type>::type))...};
+    return ::std::accumulate(bytes, bytes + sizeof...(I), static_cast<size_t>(0));
+  }
+  template <size_t... I>
+  static void clear_all(buffer_type & buffers, ::bliss::utils::index_sequence<I...>) {
+    int dummy[] = {0, (::std::get<I>(buffers).clear(), 0)...};
+    BLISS_UNUSED(dummy);
+  }
+};
+
+template <typename... KmerTypes>
+constexpr size_t MultiKmerParser<KmerTypes...>::window_size;
+
+
 } /* namespace kmer */
 
 } /* namespace index */
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    mpi_progress.hpp
+ * @ingroup io
+ * @brief   helper thread that drives MPI progress while the calling thread computes.
+ * @details most MPI libraries move the data of a non-blocking exchange only inside MPI calls, so an Isend/Irecv posted
+ *          before a long computation mostly completes in the wait after it.  progress_thread polls MPI_Iprobe on the
+ *          exchange's communicator from a second thread until stopped:  each poll runs the library's progress engine,
+ *          and the requests complete during the computation.  the probe matches nothing it consumes, and the thread
+ *          never touches the caller's requests, so test, wait and wait_any stay with the calling thread.
+ *
+ *          a second thread may only call MPI with MPI_THREAD_MULTIPLE.  otherwise start() does nothing, and progress
+ *          depends on the caller testing its requests, as before.
+ */
+#ifndef SRC_IO_MPI_PROGRESS_HPP_
+#define SRC_IO_MPI_PROGRESS_HPP_
+
+#include <mpi.h>
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>  // getenv, strtoul
+
+namespace imxx
+{
+
+  /// BL_MPI_PROGRESS_THREAD=1 turns on the progress thread of the non-blocking exchanges by default.
+  inline bool progress_thread_from_env() {
+    char const * v = ::std::getenv("BL_MPI_PROGRESS_THREAD");
+    if (v == nullptr) return false;
+    return ::std::strtoul(v, nullptr, 10) != 0;
+  }
+
+  /**
+   * @brief  polls the MPI progress engine from a helper thread.  see file description.
+   */
+  class progress_thread {
+    protected:
+      ::std::thread worker;
+      ::std::atomic<bool> running;
+      /// pause between polls, so that the helper does not take a core away from the computation.
+      ::std::chrono::microseconds interval;
+
+      static void poll(MPI_Comm comm, ::std::atomic<bool> * running, ::std::chrono::microseconds interval) {
+        int flag;
+        while (running->load(::std::memory_order_acquire)) {
+          MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &flag, MPI_STATUS_IGNORE);
+          if (interval.count() > 0) ::std::this_thread::sleep_for(interval);
+          else ::std::this_thread::yield();
+        }
+      }
+
+    public:
+      explicit progress_thread(size_t const interval_us = 20) : running(false), interval(interval_us) {}
+
+      ~progress_thread() {
+        stop();
+      }
+
+      progress_thread(progress_thread const & other) = delete;
+      progress_thread & operator=(progress_thread const & other) = delete;
+
+      /// true if MPI allows a helper thread to call it.
+      static bool supported() {
+        int provided = MPI_THREAD_SINGLE;
+        MPI_Query_thread(&provided);
+        return provided == MPI_THREAD_MULTIPLE;
+      }
+
+      /**
+       * @brief  start polling comm, e.g. the communicator of the outstanding requests.  not collective.
+       * @return true if the thread runs.  false if MPI_THREAD_MULTIPLE is not available.
+       */
+      bool start(MPI_Comm comm) {
+        stop();
+        if (!supported()) return false;
+        running.store(true, ::std::memory_order_release);
+        worker = ::std::thread(poll, comm, &running, interval);
+        return true;
+      }
+
+      /// stop polling and join the thread.  comm can be freed afterwards.
+      void stop() {
+        if (!worker.joinable()) return;
+        running.store(false, ::std::memory_order_release);
+        worker.join();
+      }
+
+      bool active() const {
+        return worker.joinable();
+      }
+  };
+
+} // namespace imxx
+
+#endif /* SRC_IO_MPI_PROGRESS_HPP_ */
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    mpiio_writer.hpp
+ * @ingroup io
+ * @brief   collective output to 1 shared file with MPI-IO.
+ * @details each write call appends 1 block per rank, in rank order.  the offset of a rank's block is the exclusive
+ *          prefix sum of the block sizes, so no rank needs the data of another, and the blocks go out with
+ *          MPI_File_write_at_all in 1GB steps, the same way mpiio_base_file reads.
+ */
+#ifndef SRC_IO_MPIIO_WRITER_HPP_
+#define SRC_IO_MPIIO_WRITER_HPP_
+
+#include "bliss-config.hpp"
+
+#include <string>
+#include <vector>
+#include <sstream>      // stringstream
+#include <algorithm>    // max
+#include <cstdio>       // BUFSIZ
+
+#include <mpi.h>
+
+#include <mxx/comm.hpp>
+#include <mxx/reduction.hpp>
+
+#include "io/io_exception.hpp"
+#include "utils/exception_handling.hpp"
+
+namespace bliss {
+  namespace io {
+    namespace parallel {
+
+      /**
+       * @brief write-only MPI-IO file shared by all ranks of a communicator.  the file is truncated on open.
+       * @note  all write calls are collective.  the file handle is managed as in mpiio_base_file.
+       */
+      class mpiio_writer {
+
+          static_assert(sizeof(MPI_Offset) > 4, "ERROR: MPI_Offset is defined as an integer 4 bytes or less.  Do not use mpiio_writer ");
+
+        protected:
+          ::std::string filename;
+
+          /// communicator used.  object instead of being a reference - lifetime of a src comm temp object in constructor is just that of the constructor call.
+          const ::mxx::comm comm;
+
+          /// MPI file handle
+          MPI_File fh;
+
+          /// bytes written so far, by all ranks.  the next block starts here.
+          size_t total_bytes;
+
+          std::string get_error_string(std::string const & op_name, int const & return_val) {
+            char error_string[BUFSIZ];
+            int length_of_error_string, error_class;
+            std::stringstream ss;
+
+            MPI_Error_class(return_val, &error_class);
+            MPI_Error_string(error_class, error_string, &length_of_error_string);
+
+            ss << "ERROR in mpiio: rank " << comm.rank() << " " << op_name << " " << this->filename << " error: " << error_string << std::endl;
+            return ss.str();
+          }
+
+          std::string get_error_string(std::string const & op_name, int const & return_val, MPI_Status const & stat) {
+            char error_string[BUFSIZ];
+            int length_of_error_string, error_class;
+            std::stringstream ss;
+
+            MPI_Error_class(return_val, &error_class);
+            MPI_Error_string(error_class, error_string, &length_of_error_string);
+
+            ss << "ERROR in mpiio: rank " << comm.rank() << " " << op_name << " " << this->filename << " error: " << return_val << " [" << error_string << "]";
+            ss << " MPI_Status error: [" << stat.MPI_ERROR << "]" << std::endl;
+
+            return ss.str();
+          }
+
+          /// opens the file for writing, and truncates it.
+          void open_file() {
+            close_file();
+
+            int res = MPI_File_open(this->comm, const_cast<char *>(this->filename.c_str()), MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh);
+            if (res != MPI_SUCCESS) {
+              throw ::bliss::utils::make_exception<::bliss::io::IOException>(get_error_string("open", res));
+            }
+
+            // collective.  an existing longer file would otherwise keep its tail.
+            res = MPI_File_set_size(fh, 0);
+            if (res != MPI_SUCCESS) {
+              throw ::bliss::utils::make_exception<::bliss::io::IOException>(get_error_string("truncate", res));
+            }
+
+            // ensure atomicity is turned off.  the blocks do not overlap.
+            MPI_File_set_atomicity(fh, 0);
+          }
+
+          /// funciton for closing a file
+          void close_file() {
+            if (fh != MPI_FILE_NULL) {
+              int res = MPI_File_close(&fh);
+              if (res != MPI_SUCCESS) {
+                throw ::bliss::utils::make_exception<::bliss::io::IOException>(get_error_string("close", res));
+              }
+              fh = MPI_FILE_NULL;
+            }
+          }
+
+        public:
+          mpiio_writer(::std::string const & _filename, ::mxx::comm const & _comm = ::mxx::comm()) :
+            filename(_filename), comm(_comm.copy()), fh(MPI_FILE_NULL), total_bytes(0) {
+            this->open_file();
+          }
+
+          ~mpiio_writer() { this->close_file(); }
+
+          mpiio_writer(mpiio_writer const & other) = delete;
+          mpiio_writer& operator=(mpiio_writer const & other) = delete;
+
+          /// collective.  flushes and closes the file.
+          void close() { this->close_file(); }
+
+          /// bytes written so far, by all ranks.
+          size_t size() const { return total_bytes; }
+
+          /**
+           * @brief append 1 block per rank, in rank order.  collective; a rank with nothing to write passes 0 bytes.
+           * @return the total bytes written by all ranks in this call.
+           */
+          size_t write(char const * data, size_t const & bytes) {
+            if (fh == MPI_FILE_NULL) {
+              std::stringstream ss;
+              ss << "ERROR in mpiio: rank " << comm.rank() << " file " << this->filename << " not yet open " << std::endl;
+
+              throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+            }
+
+            // offset of this rank's block.  exscan is undefined on rank 0.
+            size_t offset = ::mxx::exscan(bytes, [](size_t const & x, size_t const & y) { return x + y; }, this->comm);
+            if (comm.rank() == 0) offset = 0;
+            offset += total_bytes;
+
+            size_t total = ::mxx::allreduce(bytes, this->comm);
+
+            // number of elements has type int, so write in steps.  since collective, all ranks make the same number of calls.
+            size_t step_size = 1UL << 30;
+            size_t max_bytes = ::mxx::allreduce(bytes, [](size_t const & x, size_t const & y){
+              return ::std::max(x, y);
+            }, this->comm);
+            size_t steps = (max_bytes + step_size - 1) >> 30;
+            size_t local_full_steps = bytes >> 30;
+            size_t rem = bytes % step_size;
+
+            MPI_Status stat;
+            int count = 0;
+            int res = MPI_SUCCESS;
+            size_t pos = 0;
+            size_t iter_step_size;
+            for (size_t s = 0; s < steps; ++s) {
+              iter_step_size = (s < local_full_steps) ? step_size :
+                  (s == local_full_steps) ? rem : 0;
+
+              res = MPI_File_write_at_all(fh, offset + pos, const_cast<char *>(data + pos), iter_step_size, MPI_BYTE, &stat);
+              pos += iter_step_size;
+
+              if (res != MPI_SUCCESS)
+                throw ::bliss::utils::make_exception<::bliss::io::IOException>(get_error_string("write", res, stat));
+
+              res = MPI_Get_count(&stat, MPI_BYTE, &count);
+              if (res != MPI_SUCCESS)
+                throw ::bliss::utils::make_exception<::bliss::io::IOException>(get_error_string("write count", res, stat));
+
+              if (static_cast<size_t>(count) != iter_step_size) {
+                std::stringstream ss;
+                ss << "ERROR in mpiio: rank " << comm.rank() << " write error. request " << iter_step_size << " bytes wrote " << count << " bytes" << std::endl;
+
+                throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+              }
+            }
+
+            total_bytes += total;
+            return total;
+          }
+
+          /// collective.  append the local elements, as raw bytes.
+          template <typename T>
+          size_t write(::std::vector<T> const & data) {
+            return this->write(reinterpret_cast<char const *>(data.data()), data.size() * sizeof(T));
+          }
+
+          /// collective.  append the local string.
+          size_t write(::std::string const & data) {
+            return this->write(data.data(), data.size());
+          }
+      };
+
+    } /* namespace parallel */
+  } /* namespace io */
+} /* namespace bliss */
+
+#endif /* SRC_IO_MPIIO_WRITER_HPP_ */
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    multi_file.hpp
+ * @ingroup io
+ * @brief   parallel reader for a list of FASTQ or FASTA files, partitioned as if they were one file.
+ * @details the files are laid end to end in one byte offset space, and the BlockPartitioner splits the total, so each
+ *          process reads the same number of bytes regardless of the file sizes, and partitions cross file boundaries.
+ *          since every file but the last ends in a newline and starts with a record, the concatenation is itself a valid FASTQ or FASTA
+ *          file, and the record boundary fix up is exactly that of partitioned_file.  sequence ids are offsets in the
+ *          combined space, so they are unique across the files.
+ */
+
+#ifndef MULTI_FILE_HPP_
+#define MULTI_FILE_HPP_
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <unistd.h>     // pread
+#include <sys/stat.h>   // stat
+#include <fcntl.h>      // open
+
+#include "io/file.hpp"
+
+
+namespace bliss
+{
+namespace io
+{
+
+#if defined(USE_MPI)
+namespace parallel
+{
+
+/**
+ * @brief  list of files, read as their concatenation and partitioned across the processes of a communicator.
+ * @details  same read_file interface as partitioned_file;  the file_data ranges are in the combined offset space.
+ * @tparam FileParser  FASTQParser, FASTAParser, or BaseFileParser.
+ */
+template <template <typename> class FileParser = ::bliss::io::BaseFileParser>
+class multi_file : public ::bliss::io::parallel::base_file {
+
+protected:
+	using BASE = ::bliss::io::parallel::base_file;
+
+	using range_type = typename ::bliss::io::base_file::range_type;
+	using FileParserType = FileParser<typename ::bliss::io::file_data::const_iterator >;
+
+	/// the files, in order.
+	std::vector<std::string> filenames;
+
+	/// start of each file in the combined offset space.  last entry is the total size.
+	std::vector<size_t> offsets;
+
+	/// overlap amount
+	const size_t overlap;
+
+	/// partitioner for the combined range.
+	::bliss::partition::BlockPartitioner<range_type> partitioner;
+
+	/**
+	 * @brief  size of each file, and whether it ends in a newline.  rank 0 checks and broadcasts, so every rank fails together.
+	 * @throw  IOException  if a file cannot be opened, or a file other than the last does not end in a newline.
+	 */
+	void get_file_sizes() {
+		size_t n = filenames.size();
+		std::vector<size_t> sizes(n + 1, 0);   // last entry is the index of the first bad file, or n.
+		std::string error;
+
+		if (this->comm.rank() == 0) {
+			size_t bad = n;
+			for (size_t i = 0; (i < n) && (bad == n); ++i) {
+				struct stat st;
+				st.st_size = 0;
+				int fd = -1;
+				char last = '\n';
+				if ((stat(filenames[i].c_str(), &st) == -1) || ((fd = open(filenames[i].c_str(), O_RDONLY)) == -1)) {
+					bad = i;
+					error = "cannot be opened.";
+				} else if ((i + 1 < n) && (st.st_size > 0) && ((pread(fd, &last, 1, st.st_size - 1) != 1) || (last != '\n'))) {
+					bad = i;
+					error = "does not end in a newline.  records would run across the file boundary.";
+				}
+				if (fd != -1) close(fd);
+				sizes[i] = st.st_size;
+			}
+			sizes[n] = bad;
+		}
+		if (this->comm.size() > 1)
+			MPI_Bcast(sizes.data(), n + 1, MPI_UNSIGNED_LONG, 0, this->comm);
+
+		if (sizes[n] < n) {
+			if (this->comm.rank() != 0) error = "cannot be used.  see rank 0.";
+			throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR: multi_file [" + filenames[sizes[n]] + "] " + error);
+		}
+
+		offsets.assign(n + 1, 0);
+		for (size_t i = 0; i < n; ++i) offsets[i + 1] = offsets[i] + sizes[i];
+	}
+
+public:
+	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+	using BASE::read_range;
+
+	/**
+	 * @brief  read a range of the combined offset space, opening the files that it covers.  not partitioned.
+	 * @param range_bytes	range to read, in bytes
+	 * @param output		vector containing data as bytes.
+	 */
+	virtual range_type read_range(typename ::bliss::io::file_data::container & output,
+                                range_type const & range_bytes) {
+		range_type target = range_type::intersect(range_bytes, this->file_range_bytes);
+		output.resize(target.size());
+		if (target.size() == 0) return target;
+
+		// first file that ends after the start.
+		size_t i = std::upper_bound(offsets.begin(), offsets.end(), target.start) - offsets.begin() - 1;
+		typename ::bliss::io::file_data::container piece;
+		for (; (i < filenames.size()) && (offsets[i] < target.end); ++i) {
+			range_type file_part = range_type::intersect(target, range_type(offsets[i], offsets[i + 1]));
+			if (file_part.size() == 0) continue;
+
+			::bliss::io::posix_file reader(filenames[i]);
+			reader.set_readahead_bytes(this->readahead_bytes);
+
+			piece.resize(file_part.size());
+			reader.read_range(piece, range_type(file_part.start - offsets[i], file_part.end - offsets[i]));
+			std::copy(piece.begin(), piece.begin() + file_part.size(), output.begin() + (file_part.start - target.start));
+		}
+		return target;
+	}
+
+	/**
+	 * @brief constructor.  collective.
+	 * @param _filenames 		names of files to open, in order.
+	 * @param _overlap			overlap between partitions.  ignored for FASTQ, as for partitioned_file.
+	 * @param _comm				MPI communicator to use.
+	 */
+	multi_file(std::vector<std::string> const & _filenames, size_t const & _overlap = 0UL, ::mxx::comm const & _comm = ::mxx::comm()) :
+		BASE(_comm), filenames(_filenames),
+		overlap(std::is_same<FileParserType, ::bliss::io::FASTQParser<typename ::bliss::io::file_data::const_iterator> >::value ? 0UL : _overlap) {
+		if (filenames.size() == 0) throw ::std::invalid_argument("ERROR: multi_file needs at least 1 file.");
+
+		std::stringstream ss;
+		for (size_t i = 0; i < filenames.size(); ++i) ss << (i == 0 ? "" : ",") << filenames[i];
+		this->filename = ss.str();
+
+		get_file_sizes();
+		this->file_range_bytes.end = offsets.back();
+	};
+
+	/// destructor
+	virtual ~multi_file() {};
+
+	/// the files, in order.
+	std::vector<std::string> const & get_filenames() const { return filenames; }
+
+	/// start of each file in the combined offset space.  last entry is the total size.
+	std::vector<size_t> const & get_offsets() const { return offsets; }
+
+	// this is needed to prevent overload name hiding.  see http://stackoverflow.com/questions/888235/overriding-a-bases-overloaded-function-in-c/888337#888337
+	using BASE::read_file;
+
+	/**
+	 * @brief  read this rank's partition of the combined files.  collective.
+	 * @param output 		file_data object containing data and various ranges, in the combined offset space.
+	 */
+	virtual void read_file(::bliss::io::file_data & output) {
+		range_type partition_range = this->file_range_bytes;
+		if (this->comm.size() > 1) {
+			partitioner.configure(this->file_range_bytes, this->comm.size());
+			partition_range = partitioner.getNext(this->comm.rank());
+		}
+		output.parent_range_bytes = this->file_range_bytes;
+
+		if (std::is_same<FileParserType, ::bliss::io::FASTQParser<typename ::bliss::io::file_data::const_iterator> >::value) {
+			// same as partitioned_file<FASTQParser>:  move the partial record at the start of each partition to the rank before.
+			read_range(output.data, partition_range);
+
+			FileParserType parser;
+			size_t real_start = parser.init_parser(output.in_mem_cbegin(), this->file_range_bytes,
+					partition_range, partition_range, this->comm);
+
+			bool not_found = (real_start >= partition_range.end);  // if real start is outside of partition, not found
+			real_start = std::min(real_start, partition_range.end);
+			int target_rank = not_found ? 0 : this->comm.rank();
+			target_rank = ::mxx::exscan(target_rank, [](int const & x, int const & y) {
+				return (x < y) ? y : x;
+			}, this->comm);
+
+			std::vector<size_t> send_counts(this->comm.size(), 0);
+			if (this->comm.rank() > 0) send_counts[target_rank] = real_start - partition_range.start;
+
+			typename ::bliss::io::file_data::container shifted =
+					::mxx::all2allv(output.data, send_counts, this->comm);
+			output.data.insert(output.data.end(), shifted.begin(), shifted.end());
+
+			output.in_mem_range_bytes = partition_range;
+			output.in_mem_range_bytes.end = partition_range.start + output.data.size();
+
+			output.valid_range_bytes.start = real_start;
+			output.valid_range_bytes.end =
+					not_found ? partition_range.end : output.in_mem_range_bytes.end;
+			return;
+		}
+
+		// FASTA and plain bytes:  read with overlap, as partitioned_file does.
+		output.valid_range_bytes = partition_range;
+		output.in_mem_range_bytes = read_range(output.data, range_type(partition_range.start, partition_range.end + overlap));
+
+		if (std::is_same<FileParserType, ::bliss::io::FASTAParser<typename ::bliss::io::file_data::const_iterator> >::value) {
+			FileParserType parser;
+			size_t overlap_end = parser.find_overlap_end(output.in_mem_cbegin(), output.parent_range_bytes,
+					output.in_mem_range_bytes, output.valid_range_bytes.end, overlap);
+
+			output.in_mem_range_bytes.end = overlap_end;
+			output.data.erase(output.data.begin() + output.in_mem_range_bytes.size(), output.data.end());
+		}
+	}
+
+};
+
+} // namespace parallel
+#endif
+
+} // namespace io
+} // namespace bliss
+
+#endif /* MULTI_FILE_HPP_ */
@@ -26,17 +26,24 @@
 #define SRC_IO_MXX_SUPPORT_HPP_
 
 #include <mxx/datatypes.hpp>
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
 
 #include "common/kmer.hpp"
 
 //#include "utils/system_utils.hpp"
 
 #include <algorithm>  // for std::min
+#include <type_traits>
+#include <tuple>
+#include <vector>
+#include <cstdlib>    // getenv, strtoul
 
 #include <unistd.h>   // for gethostname
 
 #include "partition/range.hpp"
 #include "common/sequence.hpp"
+#include "index/quality_scores.hpp"
 
 namespace mxx {
 
@@ -108,6 +115,38 @@ namespace mxx {
     };
 
 
+  template<unsigned int POS_BITS, unsigned int FILE_BITS, unsigned int BYTES>
+    struct datatype_builder<bliss::common::PackedSequenceKmerId<POS_BITS, FILE_BITS, BYTES> > :
+    public datatype_contiguous<uint8_t, BYTES> {
+
+      typedef datatype_contiguous<uint8_t, BYTES> baseType;
+
+      static MPI_Datatype get_type(){
+        return baseType::get_type();
+      }
+
+      static size_t num_basic_elements() {
+        return baseType::num_basic_elements();
+      }
+    };
+
+
+  template<unsigned int POS_BITS, unsigned int FILE_BITS, unsigned int BYTES>
+    struct datatype_builder<const bliss::common::PackedSequenceKmerId<POS_BITS, FILE_BITS, BYTES> > :
+    public datatype_contiguous<uint8_t, BYTES> {
+
+      typedef datatype_contiguous<uint8_t, BYTES> baseType;
+
+      static MPI_Datatype get_type(){
+        return baseType::get_type();
+      }
+
+      static size_t num_basic_elements() {
+        return baseType::num_basic_elements();
+      }
+    };
+
+
   template<>
     struct datatype_builder<bliss::common::ShortSequenceKmerId> : 
     public datatype_builder<decltype(bliss::common::ShortSequenceKmerId::id)> {
@@ -177,9 +216,97 @@ namespace mxx {
     };
 
 
+  template<typename StorageT, unsigned int FracBits>
+    struct datatype_builder<bliss::index::QuantizedQuality<StorageT, FracBits> > :
+    public datatype_builder<StorageT> {
+
+      typedef datatype_builder<StorageT> baseType;
+
+      static MPI_Datatype get_type(){
+        return baseType::get_type();
+      }
+
+      static size_t num_basic_elements() {
+        return baseType::num_basic_elements();
+      }
+    };
+
+
+  template<typename StorageT, unsigned int FracBits>
+    struct datatype_builder<const bliss::index::QuantizedQuality<StorageT, FracBits> > :
+    public datatype_builder<StorageT> {
+
+      typedef datatype_builder<StorageT> baseType;
+
+      static MPI_Datatype get_type(){
+        return baseType::get_type();
+      }
+
+      static size_t num_basic_elements() {
+        return baseType::num_basic_elements();
+      }
+    };
+
+
 }  // namespace mxx
 
 
+namespace imxx {
+
+  /**
+   * @brief true if T is exchanged as sizeof(T) raw bytes instead of through its MPI datatype.
+   * @details  standard layout classes with a trivial destructor:  k-mers, ids, ranges, and pairs of them.  their
+   *           datatypes are struct types that some MPI implementations pack element by element, padding or not.
+   *           the padding bytes of e.g. std::pair<uint64_t, uint32_t> are sent as is and never read.
+   *           std::is_trivially_copyable is not used, since Kmer and std::pair have user defined assignments.
+   *           builtin types already have contiguous datatypes and are excluded.
+   *           specialize to false_type for a type whose byte layout differs between ranks.
+   */
+  template <typename T>
+  struct is_raw_exchangeable : public ::std::integral_constant<bool,
+    ::std::is_class<T>::value && ::std::is_standard_layout<T>::value && ::std::is_trivially_destructible<T>::value> {};
+
+  /// tuples are not standard layout.  a tuple of raw exchangeable or arithmetic members is.
+  template <>
+  struct is_raw_exchangeable<::std::tuple<> > : public ::std::true_type {};
+  template <typename T, typename... Ts>
+  struct is_raw_exchangeable<::std::tuple<T, Ts...> > : public ::std::integral_constant<bool,
+    (is_raw_exchangeable<T>::value || ::std::is_arithmetic<T>::value) && is_raw_exchangeable<::std::tuple<Ts...> >::value> {};
+
+  /// BL_RAW_BYTES_EXCHANGE=0 sends raw exchangeable types through their MPI datatypes.  on by default.
+  inline bool raw_bytes_exchange_from_env() {
+    char const * v = ::std::getenv("BL_RAW_BYTES_EXCHANGE");
+    return (v == nullptr) || (::std::strtoul(v, nullptr, 10) != 0);
+  }
+
+  /**
+   * @brief all2allv of sizeof(V) byte elements as MPI_BYTE.  counts are in elements, as in mxx::all2allv.  collective.
+   */
+  template <typename V>
+  void all2allv_raw(V const * input, ::std::vector<size_t> const & send_counts,
+                    V * output, ::std::vector<size_t> const & recv_counts, ::mxx::comm const & comm) {
+    ::std::vector<size_t> send_bytes(send_counts.size());
+    ::std::vector<size_t> recv_bytes(recv_counts.size());
+    for (size_t i = 0; i < send_counts.size(); ++i) send_bytes[i] = send_counts[i] * sizeof(V);
+    for (size_t i = 0; i < recv_counts.size(); ++i) recv_bytes[i] = recv_counts[i] * sizeof(V);
+
+    ::mxx::all2allv(reinterpret_cast<uint8_t const *>(input), send_bytes,
+                    reinterpret_cast<uint8_t *>(output), recv_bytes, comm);
+  }
+
+  /// the element exchange of the distribute functions:  raw bytes if is_raw_exchangeable<V> and not disabled.  collective.
+  template <typename V>
+  void exchange_all2allv(V const * input, ::std::vector<size_t> const & send_counts,
+                         V * output, ::std::vector<size_t> const & recv_counts, ::mxx::comm const & comm) {
+    if (is_raw_exchangeable<V>::value && raw_bytes_exchange_from_env())
+      all2allv_raw(input, send_counts, output, recv_counts, comm);
+    else
+      ::mxx::all2allv(input, send_counts, output, recv_counts, comm);
+  }
+
+}  // namespace imxx
+
+
 //std::ostream &operator<<(std::ostream &os, uint8_t const &t) {
 //  return os << static_cast<uint32_t>(t);
 //}
@@ -0,0 +1,476 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    packed_read_store.hpp
+ * @ingroup io
+ * @brief   reads of the local partition, packed once, for generating kmers of several k without re-reading the file.
+ * @details the file is read and parsed once with PackedReadParser, whose window is KMAX.  each read keeps the characters from
+ *          the start of its valid range to KMAX - 1 characters past the end, the same characters KmerParser uses for k = KMAX.
+ *          for any k <= KMAX, the kmers starting in the valid range are then exactly the kmers KmerParser would generate for k.
+ *
+ *          the store is a flat array of words, 1 record per read:  a header word, (owned << 32) | length, followed by
+ *          ceil(length / chars_per_word) words of characters, packed as for PackedKmerSlidingWindow (see padding.hpp).
+ *          length is the number of characters stored, owned is the number of kmer start positions in the valid range.
+ *          with DNA and 64 bit words, this is about 1/4 byte per character, versus 8 bytes per kmer for the kmer vector.
+ *
+ *          save() writes the array, one file per rank, "<prefix>.<rank>", and load() mmaps it back in place.
+ */
+#ifndef PACKED_READ_STORE_HPP_
+#define PACKED_READ_STORE_HPP_
+
+#include "bliss-config.hpp"
+
+#include <string>
+#include <cstring>      // memcmp, strerror
+#include <cstdint>
+#include <sstream>
+#include <algorithm>    // min
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <limits>
+#include <utility>      // move
+
+#include <unistd.h>     // write, close
+#include <sys/mman.h>   // mmap
+#include <sys/stat.h>   // fstat
+#include <fcntl.h>      // open
+#include <errno.h>
+
+#include "common/alphabets.hpp"
+#include "common/alphabet_traits.hpp"
+#include "common/padding.hpp"
+#include "common/kmer.hpp"
+#include "common/kmer_iterators.hpp"
+#include "common/ascii_translate.hpp"
+#include "io/kmer_parser.hpp"
+#include "io/kmer_file_helper.hpp"
+#include "io/io_exception.hpp"
+#include "containers/distributed_map_io.hpp"   // map_file_name
+#include "utils/exception_handling.hpp"
+
+namespace bliss
+{
+namespace index
+{
+namespace kmer
+{
+
+/**
+ * @brief  packs reads for PackedReadStore instead of generating kmers.  used with KmerFileHelper::read_file.
+ * @details  emits 1 record per read that has a kmer start position in the valid range, see packed_read_store.hpp.
+ *           window_size is KMAX, so the file is read with KMAX - 1 overlap, and the FASTA trimming in read_block_old keeps
+ *           KMAX - 1 characters past the valid range.
+ */
+template <typename ALPHABET, unsigned int KMAX, typename WordType = uint64_t>
+class PackedReadParser {
+
+public:
+  /// type of element generated by this parser:  header and packed words.
+  using value_type = WordType;
+  static constexpr size_t window_size = KMAX;
+
+  using padtraits = ::bliss::common::PackingTraits<WordType, bliss::common::AlphabetTraits<ALPHABET>::getBitsPerChar()>;
+
+  static_assert(::std::numeric_limits<WordType>::digits == 64, "record header needs 64 bit words");
+
+protected:
+  /// kmer type with the largest window.  only for the valid range computation.
+  using max_kmer_type = bliss::common::Kmer<KMAX, ALPHABET, WordType>;
+
+  ::bliss::partition::range<size_t> valid_range;
+
+  /// reusable buffers for the characters of a read.
+  std::vector<unsigned char> chars;
+  std::vector<uint8_t> codes;
+
+public:
+  PackedReadParser(::bliss::partition::range<size_t> const & _valid_range) : valid_range(_valid_range) {};
+
+  /**
+   * @brief pack 1 sequence.  record inserted into output_iter.
+   * @return new position for output_iter
+   */
+  template <typename SeqType, typename OutputIt, typename Predicate = ::bliss::filter::TruePredicate>
+  OutputIt operator()(SeqType const & read, OutputIt output_iter, Predicate const & pred = Predicate()) {
+
+    static_assert(std::is_same<WordType, typename ::std::iterator_traits<OutputIt>::value_type>::value,
+            "output type and output container value type are not the same");
+
+    typename SeqType::IteratorType seq_begin;
+    typename SeqType::IteratorType seq_end;
+    bool has_window = false;
+
+    // same characters as KmerParser with k = KMAX, but kept even if there are fewer than KMAX, for smaller k.
+    std::tie(seq_begin, seq_end, has_window) =
+        KmerParser<max_kmer_type>::get_valid_iterator_range(read, valid_range, window_size);
+
+    ::bliss::partition::range<size_t> seq_range(read.seq_global_offset(), read.seq_global_offset() + read.seq_size());
+    size_t valid_bytes = ::bliss::partition::range<size_t>::intersect(seq_range, valid_range).size();
+    if (valid_bytes == 0) return output_iter;
+
+    // compact out the EOL characters, counting the ones in the valid range.
+    chars.clear();
+    size_t owned = 0;
+    size_t j = 0;
+    ::bliss::utils::file::NotEOL not_eol;
+    for (auto it = seq_begin; it != seq_end; ++it, ++j) {
+      if (!not_eol(*it)) continue;
+      chars.push_back(static_cast<unsigned char>(*it));
+      if (j < valid_bytes) ++owned;
+    }
+    size_t length = chars.size();
+    if (owned == 0) return output_iter;
+    if (length > ::std::numeric_limits<uint32_t>::max())
+      throw ::std::length_error("PackedReadParser: read is longer than 2^32 characters.");
+
+    codes.resize(length);
+    ::bliss::common::ASCII2Bulk<ALPHABET>()(chars.data(), length, codes.data());
+
+    *output_iter = (static_cast<WordType>(owned) << 32) | static_cast<WordType>(length);
+    ++output_iter;
+
+    // pack, first character in the low bits.
+    WordType w = 0;
+    unsigned int offset = 0;
+    for (size_t i = 0; i < length; ++i) {
+      w |= static_cast<WordType>(codes[i]) << offset;
+      offset += padtraits::bits_per_char;
+      if (offset >= padtraits::data_bits) {
+        *output_iter = w;
+        ++output_iter;
+        w = 0;
+        offset = 0;
+      }
+    }
+    if (offset > 0) {
+      *output_iter = w;
+      ++output_iter;
+    }
+
+    return output_iter;
+  }
+};
+
+template <typename ALPHABET, unsigned int KMAX, typename WordType>
+constexpr size_t PackedReadParser<ALPHABET, KMAX, WordType>::window_size;
+
+
+/// fixed size header of a packed read file.
+struct packed_read_file_header {
+    static constexpr uint32_t current_version = 1;
+    static constexpr uint32_t endian_value = 0x01020304;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_check;
+
+    uint32_t header_bytes;
+    uint32_t word_bytes;
+    uint32_t bits_per_char;
+    uint32_t kmax;
+
+    int32_t comm_size;
+    int32_t comm_rank;
+
+    /// number of reads, and number of words following the header.
+    uint64_t reads;
+    uint64_t count;
+};
+
+
+/**
+ * @brief  the packed reads of the local partition.  see packed_read_store.hpp.
+ * @details  built by read() from a file, or by load() from a previous save().  generate() produces the kmers for
+ *           any k <= KMAX.  with Index::build_packed, a sweep over k reads the file once.
+ * @tparam KMAX   largest k that can be generated.
+ */
+template <typename ALPHABET, unsigned int KMAX, typename WordType = uint64_t>
+class PackedReadStore {
+
+public:
+  using parser_type = PackedReadParser<ALPHABET, KMAX, WordType>;
+  using padtraits = typename parser_type::padtraits;
+  using word_type = WordType;
+  static constexpr unsigned int max_k = KMAX;
+
+protected:
+  /// words when read from a file.
+  std::vector<WordType> words;
+
+  /// memory map when loaded.
+  void * mapped;
+  size_t mapped_bytes;
+
+  /// the records, either in words or in the memory map.
+  WordType const * data;
+  size_t count;
+  size_t nreads;
+
+  void unmap() {
+    if (mapped != nullptr) munmap(mapped, mapped_bytes);
+    mapped = nullptr;
+    mapped_bytes = 0;
+  }
+
+  /// number of words holding length characters.
+  static size_t words_for(size_t const & length) {
+    return (length + padtraits::chars_per_word - 1) / padtraits::chars_per_word;
+  }
+
+  packed_read_file_header make_header(int comm_size, int comm_rank) const {
+    packed_read_file_header h;
+    memset(&h, 0, sizeof(packed_read_file_header));
+    memcpy(h.magic, "BLISSPRS", 8);
+    h.version = packed_read_file_header::current_version;
+    h.endian_check = packed_read_file_header::endian_value;
+    h.header_bytes = sizeof(packed_read_file_header);
+    h.word_bytes = sizeof(WordType);
+    h.bits_per_char = padtraits::bits_per_char;
+    h.kmax = KMAX;
+    h.comm_size = comm_size;
+    h.comm_rank = comm_rank;
+    h.reads = nreads;
+    h.count = count;
+    return h;
+  }
+
+public:
+  PackedReadStore() : mapped(nullptr), mapped_bytes(0), data(nullptr), count(0), nreads(0) {};
+
+  ~PackedReadStore() {
+    unmap();
+  }
+
+  PackedReadStore(PackedReadStore const & other) = delete;
+  PackedReadStore& operator=(PackedReadStore const & other) = delete;
+
+  /// release the reads.
+  void clear() {
+    unmap();
+    ::std::vector<WordType>().swap(words);
+    data = nullptr;
+    count = 0;
+    nreads = 0;
+  }
+
+  /// take the records produced by parser_type, e.g. from reads that are already in memory.
+  void assign(::std::vector<WordType> && packed) {
+    clear();
+    words.swap(packed);
+
+    data = words.data();
+    count = words.size();
+    for (size_t i = 0; i < count; i += 1 + words_for(static_cast<uint32_t>(data[i]))) ++nreads;
+  }
+
+  /**
+   * @brief  read and pack the local partition of a file.  collective.
+   * @tparam FileType   as for KmerFileHelper::read_file, e.g. ::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>.
+   */
+  template <typename FileType, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+    typename FileNames = std::string>
+  void read(const FileNames & filename, const mxx::comm & comm) {
+    ::std::vector<WordType> packed;
+    ::bliss::io::KmerFileHelper::template read_file<FileType, parser_type, SeqParser, SeqIterType>(filename, packed, comm);
+    // the reserve in read_file is estimated for kmers.
+    packed.shrink_to_fit();
+    assign(::std::move(packed));
+  }
+
+  /// read and pack the local partition of a file, with mmap.  collective.
+  template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+  void read_mmap(const std::string & filename, const mxx::comm & comm) {
+    this->template read<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>, SeqParser, SeqIterType>(filename, comm);
+  }
+
+  /**
+   * @brief  save the packed reads, one file per rank, "<prefix>.<rank>".
+   * @throw IOException if the file cannot be written.
+   */
+  void save(const std::string & prefix, const mxx::comm & comm) const {
+    ::std::string filename = ::dsc::map_file_name(prefix, comm.rank());
+    packed_read_file_header h = make_header(comm.size(), comm.rank());
+
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1) {
+      int myerr = errno;
+      ::std::stringstream ss;
+      ss << "ERROR in PackedReadStore save open: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+    }
+
+    // write in pieces, since write may be partial.
+    char const * parts[2] = { reinterpret_cast<char const *>(&h), reinterpret_cast<char const *>(data) };
+    size_t sizes[2] = { sizeof(packed_read_file_header), count * sizeof(WordType) };
+    for (int i = 0; i < 2; ++i) {
+      char const * ptr = parts[i];
+      size_t remaining = sizes[i];
+      while (remaining > 0) {
+        ssize_t written = ::write(fd, ptr, ::std::min(remaining, static_cast<size_t>(1UL << 30)));
+        if (written < 0) {
+          int myerr = errno;
+          if (myerr == EINTR) continue;
+          close(fd);
+          ::std::stringstream ss;
+          ss << "ERROR in PackedReadStore save write: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+        }
+        ptr += written;
+        remaining -= written;
+      }
+    }
+    close(fd);
+  }
+
+  /**
+   * @brief  mmap the packed reads written by save() with the same number of processes.  the words are used in place.
+   * @throw  IOException if the file cannot be read, std::invalid_argument if it was written with a different KMAX,
+   *         alphabet, or number of processes.
+   */
+  void load(const std::string & prefix, const mxx::comm & comm) {
+    clear();
+    ::std::string filename = ::dsc::map_file_name(prefix, comm.rank());
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+      int myerr = errno;
+      ::std::stringstream ss;
+      ss << "ERROR in PackedReadStore load open: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+      int myerr = errno;
+      close(fd);
+      ::std::stringstream ss;
+      ss << "ERROR in PackedReadStore load fstat: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+    }
+    size_t bytes = st.st_size;
+    if (bytes < sizeof(packed_read_file_header)) {
+      close(fd);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR in PackedReadStore load: [" + filename + "] is too small for a header.");
+    }
+
+    void * p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    int myerr = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+      ::std::stringstream ss;
+      ss << "ERROR in PackedReadStore load mmap: [" << filename << "] error " << myerr << ": " << strerror(myerr);
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+    }
+    mapped = p;
+    mapped_bytes = bytes;
+    madvise(mapped, mapped_bytes, MADV_WILLNEED);
+
+    packed_read_file_header const & h = *(reinterpret_cast<packed_read_file_header const *>(mapped));
+    if ((memcmp(h.magic, "BLISSPRS", 8) != 0) || (h.header_bytes != sizeof(packed_read_file_header)) ||
+        (bytes < h.header_bytes + h.count * h.word_bytes)) {
+      unmap();
+      throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR in PackedReadStore load: [" + filename + "] is not a complete packed read file.");
+    }
+
+    packed_read_file_header expected = make_header(comm.size(), comm.rank());
+    if ((h.version != expected.version) || (h.endian_check != expected.endian_check) ||
+        (h.word_bytes != expected.word_bytes) || (h.bits_per_char != expected.bits_per_char) || (h.kmax != expected.kmax) ||
+        (h.comm_size != expected.comm_size) || (h.comm_rank != expected.comm_rank)) {
+      ::std::stringstream ss;
+      ss << "ERROR in PackedReadStore load: [" << filename << "] written with kmax " << h.kmax << ", " << h.bits_per_char
+         << " bits per char, by rank " << h.comm_rank << " of " << h.comm_size << ".  loading with kmax " << KMAX << ", "
+         << expected.bits_per_char << " bits per char, as rank " << comm.rank() << " of " << comm.size() << ".";
+      unmap();
+      throw ::std::invalid_argument(ss.str());
+    }
+
+    data = reinterpret_cast<WordType const *>(reinterpret_cast<char const *>(mapped) + h.header_bytes);
+    count = h.count;
+    nreads = h.reads;
+  }
+
+  /// number of reads.
+  size_t reads() const {
+    return nreads;
+  }
+
+  /// number of words, including record headers.
+  size_t size() const {
+    return count;
+  }
+
+  /// number of kmers generate<KmerType>() produces.
+  template <typename KmerType>
+  size_t kmer_count() const {
+    static_assert(KmerType::size <= KMAX, "k is larger than the KMAX of the packed reads");
+    size_t total = 0;
+    size_t length, owned;
+    for (size_t i = 0; i < count; i += 1 + words_for(length)) {
+      length = static_cast<uint32_t>(data[i]);
+      owned = data[i] >> 32;
+      if (length >= KmerType::size) total += ::std::min(owned, length - KmerType::size + 1);
+    }
+    return total;
+  }
+
+  /**
+   * @brief  generate the kmers of all reads, in read order.  same kmers as KmerParser<KmerType> on the original file.
+   * @return new position for output_iter
+   */
+  template <typename KmerType, typename OutputIt>
+  OutputIt generate(OutputIt output_iter) const {
+    static_assert(KmerType::size <= KMAX, "k is larger than the KMAX of the packed reads");
+    static_assert(::std::is_same<typename KmerType::KmerAlphabet, ALPHABET>::value, "kmer alphabet differs from the packed reads");
+
+    using window_type = ::bliss::common::PackedKmerSlidingWindow<WordType const *, KmerType>;
+
+    size_t length, owned, n;
+    WordType const * it;
+    unsigned int offset;
+    window_type window;
+
+    for (size_t i = 0; i < count; i += 1 + words_for(length)) {
+      length = static_cast<uint32_t>(data[i]);
+      owned = data[i] >> 32;
+      if (length < KmerType::size) continue;
+      n = ::std::min(owned, length - KmerType::size + 1);
+
+      it = data + i + 1;
+      offset = 0;
+      window.init(it, offset);   // leaves (it, offset) on the last character of the first kmer.
+      *output_iter = window.getValue();
+      ++output_iter;
+
+      window.skip(it, offset, 1U);
+      for (size_t j = 1; j < n; ++j, ++output_iter) {
+        window.next(it, offset);
+        *output_iter = window.getValue();
+      }
+    }
+
+    return output_iter;
+  }
+
+};
+
+
+} // namespace kmer
+} // namespace index
+} // namespace bliss
+
+#endif /* PACKED_READ_STORE_HPP_ */
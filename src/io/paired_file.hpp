@@ -0,0 +1,193 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    paired_file.hpp
+ * @ingroup io
+ * @brief   parallel reader for paired-end FASTQ files (R1 and R2), with both mates of every pair on the same process.
+ * @details R1 is partitioned by bytes, as by partitioned_file<FASTQParser>.  R2 is also read by bytes, and then its records
+ *          are moved so that each process has the mates of its R1 records:  the record counts are prefix summed to give
+ *          each process its R1 record index range, and each process sends the R2 records in those ranges to their owners.
+ *          records stay in file order, so no sort by read id is needed.  the i-th record in R1 is paired with the i-th in R2.
+ *
+ *          FASTQ records are assumed to be 4 lines, as in FASTQParser.  trailing blank lines are not records.
+ */
+
+#ifndef PAIRED_FILE_HPP_
+#define PAIRED_FILE_HPP_
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <utility>
+#include <algorithm>
+
+#include "io/file.hpp"
+
+
+namespace bliss
+{
+namespace io
+{
+
+#if defined(USE_MPI)
+namespace parallel
+{
+
+/**
+ * @brief  pair of FASTQ files, R1 and R2, partitioned so that mates are on the same process.
+ * @tparam FileReader  serial reader for the files, as in partitioned_file.
+ */
+template <typename FileReader = ::bliss::io::posix_file>
+class paired_file {
+
+protected:
+	using range_type = typename ::bliss::io::base_file::range_type;
+	using FileType = ::bliss::io::parallel::partitioned_file<FileReader, ::bliss::io::FASTQParser>;
+
+	/// R1 and R2
+	std::string filename1;
+	std::string filename2;
+
+	/// communicator used.
+	const ::mxx::comm comm;
+
+public:
+	/**
+	 * @brief  file offsets of the starts of the records in the valid range of a FASTQ partition.
+	 * @return record start offsets, followed by the end of the valid range.
+	 */
+	static std::vector<size_t> record_offsets(::bliss::io::file_data const & data) {
+		std::vector<size_t> offsets;
+		range_type valid = data.valid_range_bytes;
+		offsets.reserve(valid.size() / 64 + 2);
+
+		if (valid.size() > 0) {
+			offsets.push_back(valid.start);
+
+			// a record follows every 4th newline, unless it is trailing blank lines.
+			auto it = data.data.cbegin() + (valid.start - data.in_mem_range_bytes.start);
+			size_t lines = 0;
+			for (size_t pos = valid.start; pos + 1 < valid.end; ++pos, ++it) {
+				if ((*it != '\n') || ((++lines & 3) != 0)) continue;
+				if (*(it + 1) != '@') break;
+				offsets.push_back(pos + 1);
+			}
+		}
+		offsets.push_back(valid.end);
+		return offsets;
+	}
+
+	/**
+	 * @brief constructor
+	 * @param _filename1 		R1 file
+	 * @param _filename2 		R2 file
+	 * @param _comm				MPI communicator to use.
+	 */
+	paired_file(std::string const & _filename1, std::string const & _filename2, ::mxx::comm const & _comm = ::mxx::comm()) :
+		filename1(_filename1), filename2(_filename2), comm(_comm.copy()) {};
+
+	/// destructor
+	virtual ~paired_file() {};
+
+	/**
+	 * @brief  read both files.  collective.
+	 * @param output1  this process' partition of R1, as from partitioned_file<FASTQParser>.
+	 * @param output2  the mates of the records in output1.valid_range_bytes, in the same order.  in memory range == valid range.
+	 * @throw IOException  on all processes if the files have different numbers of records.
+	 */
+	void read_file(::bliss::io::file_data & output1, ::bliss::io::file_data & output2) {
+		{
+			FileType f1(filename1, 0, this->comm);
+			f1.read_file(output1);
+		}
+		::bliss::io::file_data r2;
+		{
+			FileType f2(filename2, 0, this->comm);
+			f2.read_file(r2);
+		}
+
+		std::vector<size_t> offsets1 = record_offsets(output1);
+		std::vector<size_t> offsets2 = record_offsets(r2);
+		size_t count1 = offsets1.size() - 1;
+		size_t count2 = offsets2.size() - 1;
+
+		// global record index ranges.
+		size_t start1 = ::mxx::exscan(count1, [](size_t const & x, size_t const & y) { return x + y; }, this->comm);
+		size_t start2 = ::mxx::exscan(count2, [](size_t const & x, size_t const & y) { return x + y; }, this->comm);
+		if (this->comm.rank() == 0) {
+			start1 = 0;
+			start2 = 0;
+		}
+		std::vector<size_t> starts1 = ::mxx::allgather(start1, this->comm);
+		size_t total1 = ::mxx::allreduce(count1, this->comm);
+		size_t total2 = ::mxx::allreduce(count2, this->comm);
+		if (total1 != total2) {
+			std::stringstream ss;
+			ss << "ERROR: paired_file: [" << filename1 << "] has " << total1 << " records, [" << filename2 << "] has " << total2;
+			throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+		}
+		starts1.push_back(total1);
+
+		// send each process the R2 records matching its R1 records.  targets are in record order, so the send buffer is the valid data.
+		int p = this->comm.size();
+		std::vector<size_t> send_counts(p, 0);
+		std::vector<size_t> first_offset;
+		std::vector<size_t> first_counts(p, 0);
+		for (int r = 0; r < p; ++r) {
+			size_t s = std::max(starts1[r], start2);
+			size_t e = std::min(starts1[r + 1], start2 + count2);
+			if (s >= e) continue;
+			send_counts[r] = offsets2[e - start2] - offsets2[s - start2];
+			if (s == starts1[r]) {   // this process has the first mate for r.
+				first_offset.push_back(offsets2[s - start2]);
+				first_counts[r] = 1;
+			}
+		}
+		typename ::bliss::io::file_data::container send(r2.data.begin() + (offsets2.front() - r2.in_mem_range_bytes.start),
+				r2.data.begin() + (offsets2.back() - r2.in_mem_range_bytes.start));
+		r2.data.clear();
+
+		output2.data = ::mxx::all2allv(send, send_counts, this->comm);
+		std::vector<size_t> first = ::mxx::all2allv(first_offset, first_counts, this->comm);
+
+		output2.parent_range_bytes = r2.parent_range_bytes;
+		size_t start = first.empty() ? r2.parent_range_bytes.end : first.front();
+		output2.in_mem_range_bytes = range_type(start, start + output2.data.size());
+		output2.valid_range_bytes = output2.in_mem_range_bytes;
+	}
+
+	/**
+	 * @brief  read both files.  collective.
+	 * @return  R1 partition and the matching R2 records.  see read_file(file_data&, file_data&).
+	 */
+	std::pair<::bliss::io::file_data, ::bliss::io::file_data> read_file() {
+		std::pair<::bliss::io::file_data, ::bliss::io::file_data> out;
+		read_file(out.first, out.second);
+		return out;
+	}
+
+};
+
+} // namespace parallel
+#endif
+
+} // namespace io
+} // namespace bliss
+
+#endif /* PAIRED_FILE_HPP_ */
@@ -0,0 +1,386 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    read_partition.hpp
+ * @ingroup io
+ * @brief   whole reads binned by minimizer:  each rank gets the reads whose minimizer it owns, for local assembly or error
+ *          correction without a global kmer table.
+ * @details a read's minimizer is the canonical M-mer of the read with the smallest hash, so a read and its reverse
+ *          complement go to the same rank, and reads that overlap by a long enough stretch mostly do too.
+ *          the owner rank is the minimizer hash modulo the number of processes.
+ *
+ *          ReadBinParser packs each read into a record of words:  a header word, (quality flag << 32) | length, the minimizer
+ *          hash, ceil(length / chars_per_word) words of characters, packed as in PackedReadStore, then, for FASTQ,
+ *          ceil(length / 8) words of the raw quality characters.  reads shorter than K have no kmer and are dropped.
+ *          MinimizerReadPartition buckets the records by owner and exchanges them with 1 all2allv.
+ *
+ *          reads are kept whole, so this is for files whose records do not span partitions, e.g. FASTQ.
+ *          as in PackedReadStore, characters outside of the alphabet (N) are packed as the alphabet maps them.
+ */
+#ifndef READ_PARTITION_HPP_
+#define READ_PARTITION_HPP_
+
+#include "bliss-config.hpp"
+
+#include <string>
+#include <cstdint>
+#include <algorithm>    // min, copy
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <limits>
+#include <utility>      // move
+
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
+
+#include "common/alphabets.hpp"
+#include "common/alphabet_traits.hpp"
+#include "common/padding.hpp"
+#include "common/kmer.hpp"
+#include "common/ascii_translate.hpp"
+#include "io/kmer_parser.hpp"
+#include "io/kmer_file_helper.hpp"
+
+namespace bliss
+{
+namespace index
+{
+namespace kmer
+{
+
+/**
+ * @brief  packs whole reads with their minimizer, for MinimizerReadPartition.  used with KmerFileHelper::read_file.
+ * @details  emits 1 record per read that starts in the valid range and has at least K characters.  see read_partition.hpp.
+ * @tparam KmerType  kmer type of the downstream assembly.  sets the alphabet and the shortest read kept.
+ * @tparam M         minimizer length.  M * bits per character needs to fit in a word.
+ */
+template <typename KmerType,
+    unsigned int M = ((KmerType::size < 12U) ? KmerType::size : 12U),
+    typename WordType = uint64_t>
+class ReadBinParser {
+    static_assert((M > 0) && (M <= KmerType::size), "minimizer length needs to be between 1 and K");
+
+public:
+  using alphabet_type = typename KmerType::KmerAlphabet;
+
+  /// type of element generated by this parser:  header and packed words.
+  using value_type = WordType;
+  /// reads are taken whole, so there is no overlap to read.
+  static constexpr size_t window_size = 1;
+
+  using padtraits = ::bliss::common::PackingTraits<WordType, bliss::common::AlphabetTraits<alphabet_type>::getBitsPerChar()>;
+  using mmer_type = ::bliss::common::Kmer<M, alphabet_type, WordType>;
+
+  static_assert(::std::numeric_limits<WordType>::digits == 64, "record header needs 64 bit words");
+  static_assert(mmer_type::nWords == 1, "minimizer needs to fit in a word");
+
+  /// header flag for records with quality characters.
+  static constexpr WordType quality_flag = static_cast<WordType>(1) << 32;
+
+protected:
+  ::bliss::partition::range<size_t> valid_range;
+
+  /// reusable buffers for the characters of a read.
+  std::vector<unsigned char> chars;
+  std::vector<unsigned char> quals;
+  std::vector<uint8_t> codes;
+
+  /// murmur3 64 bit finalizer, as for kmer::hash::minimizer.
+  static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  template <typename SeqType>
+  void get_quality(SeqType const & read, ::std::true_type) {
+    ::bliss::utils::file::NotEOL not_eol;
+    for (auto it = read.qual_begin; it != read.qual_end; ++it) {
+      if (not_eol(*it)) quals.push_back(static_cast<unsigned char>(*it));
+    }
+  }
+  template <typename SeqType>
+  void get_quality(SeqType const & read, ::std::false_type) {}
+
+public:
+  ReadBinParser(::bliss::partition::range<size_t> const & _valid_range) : valid_range(_valid_range) {};
+
+  /**
+   * @brief  hash of the minimizer of alphabet codes, the smallest hash of the canonical M-mers.
+   * @return max value if there are fewer than M codes.
+   */
+  static uint64_t minimizer(uint8_t const * first, size_t const & length, uint64_t const & seed = 42) {
+    uint64_t best = ::std::numeric_limits<uint64_t>::max();
+    mmer_type fw, rv;
+    for (size_t i = 0; i < length; ++i) {
+      fw.nextFromChar(first[i]);
+      rv.nextReverseFromChar(alphabet_type::TO_COMPLEMENT[first[i]]);
+      if (i + 1 < M) continue;
+      best = ::std::min(best, mix(::std::min(fw, rv).getData()[0] ^ seed));
+    }
+    return best;
+  }
+
+  /**
+   * @brief pack 1 read.  record inserted into output_iter.
+   * @return new position for output_iter
+   */
+  template <typename SeqType, typename OutputIt, typename Predicate = ::bliss::filter::TruePredicate>
+  OutputIt operator()(SeqType const & read, OutputIt output_iter, Predicate const & pred = Predicate()) {
+
+    static_assert(std::is_same<WordType, typename ::std::iterator_traits<OutputIt>::value_type>::value,
+            "output type and output container value type are not the same");
+
+    // the read belongs to the partition where it starts.
+    if (!valid_range.contains(read.seq_global_offset())) return output_iter;
+
+    chars.clear();
+    ::bliss::utils::file::NotEOL not_eol;
+    for (auto it = read.seq_begin; it != read.seq_end; ++it) {
+      if (not_eol(*it)) chars.push_back(static_cast<unsigned char>(*it));
+    }
+    size_t length = chars.size();
+    if (length < KmerType::size) return output_iter;
+    if (length > ::std::numeric_limits<uint32_t>::max())
+      throw ::std::length_error("ReadBinParser: read is longer than 2^32 characters.");
+
+    quals.clear();
+    get_quality(read, ::std::integral_constant<bool, SeqType::has_quality()>());
+    bool has_qual = SeqType::has_quality();
+    if (has_qual && (quals.size() != length))
+      throw ::std::invalid_argument("ReadBinParser: read and quality lengths differ.");
+
+    codes.resize(length);
+    ::bliss::common::ASCII2Bulk<alphabet_type>()(chars.data(), length, codes.data());
+
+    *output_iter = (has_qual ? quality_flag : 0) | static_cast<WordType>(length);
+    ++output_iter;
+    *output_iter = minimizer(codes.data(), length);
+    ++output_iter;
+
+    // pack, first character in the low bits.
+    WordType w = 0;
+    unsigned int offset = 0;
+    for (size_t i = 0; i < length; ++i) {
+      w |= static_cast<WordType>(codes[i]) << offset;
+      offset += padtraits::bits_per_char;
+      if (offset >= padtraits::data_bits) {
+        *output_iter = w;
+        ++output_iter;
+        w = 0;
+        offset = 0;
+      }
+    }
+    if (offset > 0) {
+      *output_iter = w;
+      ++output_iter;
+    }
+
+    // quality characters, 8 per word, first in the low byte.
+    if (has_qual) {
+      for (size_t i = 0; i < length; i += sizeof(WordType)) {
+        w = 0;
+        for (size_t j = 0; (j < sizeof(WordType)) && (i + j < length); ++j) {
+          w |= static_cast<WordType>(quals[i + j]) << (8 * j);
+        }
+        *output_iter = w;
+        ++output_iter;
+      }
+    }
+
+    return output_iter;
+  }
+};
+
+template <typename KmerType, unsigned int M, typename WordType>
+constexpr size_t ReadBinParser<KmerType, M, WordType>::window_size;
+template <typename KmerType, unsigned int M, typename WordType>
+constexpr WordType ReadBinParser<KmerType, M, WordType>::quality_flag;
+
+
+/**
+ * @brief  the reads of the local minimizer bin.  see read_partition.hpp.
+ * @details  built by read() from a file, or by distribute() from records packed by parser_type.  records are addressed by
+ *           their index in [0, reads()), in received order, i.e. by source rank.
+ */
+template <typename KmerType,
+    unsigned int M = ((KmerType::size < 12U) ? KmerType::size : 12U),
+    typename WordType = uint64_t>
+class MinimizerReadPartition {
+
+public:
+  using parser_type = ReadBinParser<KmerType, M, WordType>;
+  using alphabet_type = typename parser_type::alphabet_type;
+  using padtraits = typename parser_type::padtraits;
+  using word_type = WordType;
+
+protected:
+  /// the records.
+  std::vector<WordType> words;
+  /// start of each record in words.
+  std::vector<size_t> starts;
+
+  /// number of words holding length characters.
+  static size_t words_for(size_t const & length) {
+    return (length + padtraits::chars_per_word - 1) / padtraits::chars_per_word;
+  }
+
+public:
+  /// number of words in the record with this header.
+  static size_t record_words(WordType const & header) {
+    size_t length = static_cast<uint32_t>(header);
+    return 2 + words_for(length) +
+        (((header & parser_type::quality_flag) == 0) ? 0 : (length + sizeof(WordType) - 1) / sizeof(WordType));
+  }
+
+  /// rank that owns a minimizer hash.
+  static int owner(WordType const & minimizer, int const & comm_size) {
+    return static_cast<int>(minimizer % static_cast<WordType>(comm_size));
+  }
+
+  MinimizerReadPartition() {};
+
+  /// release the reads.
+  void clear() {
+    ::std::vector<WordType>().swap(words);
+    ::std::vector<size_t>().swap(starts);
+  }
+
+  /// take records produced by parser_type, without redistributing them.
+  void assign(::std::vector<WordType> && packed) {
+    clear();
+    words.swap(packed);
+    for (size_t i = 0; i < words.size(); i += record_words(words[i])) starts.push_back(i);
+  }
+
+  /**
+   * @brief  send each record to the rank that owns its minimizer, and keep the records received.  collective.
+   * @param packed   records produced by parser_type on this rank.  cleared.
+   */
+  void distribute(::std::vector<WordType> & packed, const mxx::comm & comm) {
+    int p = comm.size();
+    if (p == 1) {
+      assign(::std::move(packed));
+      packed.clear();
+      return;
+    }
+
+    // count the words to each rank, then bucket the records.
+    ::std::vector<size_t> send_counts(p, 0);
+    ::std::vector<int> dest;
+    for (size_t i = 0, n; i < packed.size(); i += n) {
+      n = record_words(packed[i]);
+      dest.push_back(owner(packed[i + 1], p));
+      send_counts[dest.back()] += n;
+    }
+    ::std::vector<size_t> offsets(p, 0);
+    for (int r = 1; r < p; ++r) offsets[r] = offsets[r - 1] + send_counts[r - 1];
+
+    ::std::vector<WordType> buffer(packed.size());
+    size_t j = 0;
+    for (size_t i = 0, n; i < packed.size(); i += n, ++j) {
+      n = record_words(packed[i]);
+      ::std::copy(packed.begin() + i, packed.begin() + i + n, buffer.begin() + offsets[dest[j]]);
+      offsets[dest[j]] += n;
+    }
+    ::std::vector<WordType>().swap(packed);
+    ::std::vector<int>().swap(dest);
+
+    assign(mxx::all2allv(buffer, send_counts, comm));
+  }
+
+  /**
+   * @brief  read the local partition of a file, and bin the reads by minimizer.  collective.
+   * @tparam FileType   as for KmerFileHelper::read_file, e.g. ::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>.
+   */
+  template <typename FileType, template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType,
+    typename FileNames = std::string>
+  void read(const FileNames & filename, const mxx::comm & comm) {
+    ::std::vector<WordType> packed;
+    ::bliss::io::KmerFileHelper::template read_file<FileType, parser_type, SeqParser, SeqIterType>(filename, packed, comm);
+    distribute(packed, comm);
+  }
+
+  /// read the local partition of a file with mmap, and bin the reads by minimizer.  collective.
+  template <template <typename> class SeqParser, template <typename,  template <typename> class> class SeqIterType>
+  void read_mmap(const std::string & filename, const mxx::comm & comm) {
+    this->template read<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>, SeqParser, SeqIterType>(filename, comm);
+  }
+
+  /// number of reads.
+  size_t reads() const {
+    return starts.size();
+  }
+
+  /// number of words, including record headers.
+  size_t size() const {
+    return words.size();
+  }
+
+  /// number of characters of read i.
+  size_t length(size_t const & i) const {
+    return static_cast<uint32_t>(words[starts[i]]);
+  }
+
+  /// minimizer hash of read i.
+  WordType minimizer(size_t const & i) const {
+    return words[starts[i] + 1];
+  }
+
+  bool has_quality(size_t const & i) const {
+    return (words[starts[i]] & parser_type::quality_flag) != 0;
+  }
+
+  /// characters of read i, in ASCII.
+  std::string sequence(size_t const & i) const {
+    size_t len = length(i);
+    WordType const * it = words.data() + starts[i] + 2;
+    WordType mask = (static_cast<WordType>(1) << padtraits::bits_per_char) - 1;
+
+    std::string result(len, ' ');
+    for (size_t j = 0; j < len; ++j) {
+      result[j] = alphabet_type::TO_ASCII[(it[j / padtraits::chars_per_word] >>
+                                           ((j % padtraits::chars_per_word) * padtraits::bits_per_char)) & mask];
+    }
+    return result;
+  }
+
+  /// quality characters of read i.  empty if the file had none.
+  std::string quality(size_t const & i) const {
+    if (!has_quality(i)) return std::string();
+
+    size_t len = length(i);
+    WordType const * it = words.data() + starts[i] + 2 + words_for(len);
+
+    std::string result(len, ' ');
+    for (size_t j = 0; j < len; ++j) {
+      result[j] = static_cast<char>((it[j / sizeof(WordType)] >> (8 * (j % sizeof(WordType)))) & 0xFF);
+    }
+    return result;
+  }
+};
+
+
+} // namespace kmer
+} // namespace index
+} // namespace bliss
+
+#endif /* READ_PARTITION_HPP_ */
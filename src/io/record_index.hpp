@@ -0,0 +1,446 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    record_index.hpp
+ * @ingroup io
+ * @brief   sidecar index of FASTQ record start offsets, "<file>.bri".
+ * @details the start offset of every stride-th record (records 0, stride, 2 * stride, ...), the number of sequence
+ *          characters before each of them, and the numbers of records and of sequence characters.
+ *          with the index, partitioned_file<..., FASTQParser> moves each block boundary forward to the next sampled record
+ *          start, and reads exactly that range:  no record boundary search, and no shifting of partial records between
+ *          processes.  partitions are unbalanced by at most stride records.  the first record of each partition is a sampled
+ *          record, so its ordinal in the file is known (first_record_id), without a prefix sum over the processes.
+ *
+ *          the index is written by the first read of the file, after the usual boundary search, and mmapped by later reads.
+ *          it records the data file size and modification time, and is ignored when either changes.
+ *          enable by setting the environment variable BL_FASTQ_RECORD_INDEX to the stride, e.g. 1024,
+ *          or with partitioned_file::set_record_index_stride.
+ *
+ *          equal bytes are not equal work when read lengths or header lengths vary.  with BL_PARTITION_BY_KMERS=1, or
+ *          partitioned_file::set_partition_by_kmers, an indexed read chooses the sampled record starts that balance the
+ *          estimated k-mers per process instead (see balance):  a record of n characters has n - k + 1 k-mers, so the
+ *          k-mers between 2 samples are their characters minus (k - 1) per record.
+ */
+#ifndef SRC_IO_RECORD_INDEX_HPP_
+#define SRC_IO_RECORD_INDEX_HPP_
+
+#include "bliss-config.hpp"
+
+#include <string>
+#include <cstring>      // memcmp, strerror
+#include <cstdint>
+#include <cstdlib>      // getenv, strtoul
+#include <vector>
+#include <algorithm>    // lower_bound, min, max
+#include <iterator>     // distance
+#include <utility>      // move
+
+#include <unistd.h>     // write, close
+#include <sys/mman.h>   // mmap
+#include <sys/stat.h>   // stat
+#include <fcntl.h>      // open
+#include <errno.h>
+
+#include <mxx/comm.hpp>
+#include <mxx/collective.hpp>
+#include <mxx/reduction.hpp>
+
+#include "partition/range.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/sequence_iterator.hpp"
+#include "utils/logging.h"
+
+namespace bliss
+{
+namespace io
+{
+
+  /// fixed size header of a record index file, followed by the sampled offsets as uint64_t.
+  struct record_index_header {
+      static constexpr uint32_t current_version = 2;
+      static constexpr uint32_t endian_value = 0x01020304;
+
+      char magic[8];
+      uint32_t version;
+      uint32_t endian_check;
+
+      uint32_t header_bytes;
+      uint32_t stride;
+
+      /// data file size and modification time, to detect a stale index.
+      uint64_t file_size;
+      int64_t mtime_sec;
+      int64_t mtime_nsec;
+
+      /// number of records in the data file, and of sampled offsets.
+      uint64_t records;
+      uint64_t samples;
+
+      /// number of sequence characters in the data file.  the samples are followed by the characters before each sample.
+      uint64_t bases;
+  };
+
+  /// name of the index of a data file.
+  inline ::std::string record_index_file_name(::std::string const & filename) {
+    return filename + ".bri";
+  }
+
+  /// stride from the BL_FASTQ_RECORD_INDEX environment variable, 0 if not set.
+  inline size_t record_index_stride_from_env() {
+    char const * v = ::std::getenv("BL_FASTQ_RECORD_INDEX");
+    if (v == nullptr) return 0;
+    return ::std::strtoul(v, nullptr, 10);
+  }
+
+  /// BL_PARTITION_BY_KMERS=1 balances indexed partitions by estimated k-mers instead of bytes.
+  inline bool partition_by_kmers_from_env() {
+    char const * v = ::std::getenv("BL_PARTITION_BY_KMERS");
+    if (v == nullptr) return false;
+    return ::std::strtoul(v, nullptr, 10) != 0;
+  }
+
+
+  /**
+   * @brief  sampled record start offsets of a data file.  mmapped when loaded.
+   */
+  class record_index {
+    public:
+      using range_type = ::bliss::partition::range<size_t>;
+
+    protected:
+      /// offsets and characters before each, when built.
+      ::std::vector<uint64_t> own;
+      ::std::vector<uint64_t> own_bases;
+
+      void * mapped;
+      size_t mapped_bytes;
+
+      uint64_t const * offsets;
+      uint64_t const * bases_before;
+      size_t nsamples;
+      size_t nrecords;
+      size_t nbases;
+      size_t stride;
+
+      void unmap() {
+        if (mapped != nullptr) munmap(mapped, mapped_bytes);
+        mapped = nullptr;
+        mapped_bytes = 0;
+      }
+
+      /// size and modification time of a file.  false if it cannot be stat'ed.
+      static bool stat_file(::std::string const & filename, record_index_header & h) {
+        struct stat st;
+        if (stat(filename.c_str(), &st) == -1) return false;
+        h.file_size = st.st_size;
+        h.mtime_sec = st.st_mtim.tv_sec;
+        h.mtime_nsec = st.st_mtim.tv_nsec;
+        return true;
+      }
+
+    public:
+      record_index() : mapped(nullptr), mapped_bytes(0), offsets(nullptr), bases_before(nullptr),
+        nsamples(0), nrecords(0), nbases(0), stride(0) {};
+
+      ~record_index() {
+        unmap();
+      }
+
+      record_index(record_index const & other) = delete;
+      record_index& operator=(record_index const & other) = delete;
+
+      /// true if loaded or assigned.
+      bool valid() const {
+        return stride > 0;
+      }
+
+      void clear() {
+        unmap();
+        ::std::vector<uint64_t>().swap(own);
+        ::std::vector<uint64_t>().swap(own_bases);
+        offsets = nullptr;
+        bases_before = nullptr;
+        nsamples = 0;
+        nrecords = 0;
+        nbases = 0;
+        stride = 0;
+      }
+
+      /// take the offsets of records 0, _stride, 2 * _stride, ... of _records records, and the sequence characters before each.
+      void assign(::std::vector<uint64_t> && samples, ::std::vector<uint64_t> && sample_bases,
+                  size_t const & _records, size_t const & _bases, size_t const & _stride) {
+        clear();
+        own.swap(samples);
+        own_bases.swap(sample_bases);
+        offsets = own.data();
+        bases_before = own_bases.data();
+        nsamples = own.size();
+        nrecords = _records;
+        nbases = _bases;
+        stride = _stride;
+      }
+
+      /**
+       * @brief  mmap the index of data_filename.
+       * @return false if there is no index, or it is malformed, or stale:  the data file size or modification time changed.
+       */
+      bool load(::std::string const & data_filename) {
+        clear();
+
+        record_index_header expected;
+        memset(&expected, 0, sizeof(record_index_header));
+        if (!stat_file(data_filename, expected)) return false;
+
+        ::std::string filename = record_index_file_name(data_filename);
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1) return false;
+
+        struct stat st;
+        if ((fstat(fd, &st) == -1) || (static_cast<size_t>(st.st_size) < sizeof(record_index_header))) {
+          close(fd);
+          return false;
+        }
+        size_t bytes = st.st_size;
+
+        void * p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return false;
+        mapped = p;
+        mapped_bytes = bytes;
+
+        record_index_header const & h = *(reinterpret_cast<record_index_header const *>(mapped));
+        if ((memcmp(h.magic, "BLISSRIX", 8) != 0) || (h.version != record_index_header::current_version) ||
+            (h.endian_check != record_index_header::endian_value) || (h.header_bytes != sizeof(record_index_header)) ||
+            (h.stride == 0) || (bytes < h.header_bytes + 2 * h.samples * sizeof(uint64_t))) {
+          BL_WARNINGF("record index %s is malformed.  ignored.", filename.c_str());
+          unmap();
+          return false;
+        }
+        if ((h.file_size != expected.file_size) || (h.mtime_sec != expected.mtime_sec) || (h.mtime_nsec != expected.mtime_nsec)) {
+          BL_WARNINGF("record index %s is older than the data file.  ignored.", filename.c_str());
+          unmap();
+          return false;
+        }
+
+        offsets = reinterpret_cast<uint64_t const *>(reinterpret_cast<char const *>(mapped) + h.header_bytes);
+        bases_before = offsets + h.samples;
+        nsamples = h.samples;
+        nrecords = h.records;
+        nbases = h.bases;
+        stride = h.stride;
+        return true;
+      }
+
+      /**
+       * @brief  write the index of data_filename, "<data_filename>.bri".
+       * @return false if it cannot be written, e.g. read only directory.  a partial file is removed.
+       */
+      bool save(::std::string const & data_filename) const {
+        record_index_header h;
+        memset(&h, 0, sizeof(record_index_header));
+        if (!stat_file(data_filename, h)) return false;
+        memcpy(h.magic, "BLISSRIX", 8);
+        h.version = record_index_header::current_version;
+        h.endian_check = record_index_header::endian_value;
+        h.header_bytes = sizeof(record_index_header);
+        h.stride = stride;
+        h.records = nrecords;
+        h.samples = nsamples;
+        h.bases = nbases;
+
+        ::std::string filename = record_index_file_name(data_filename);
+        int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd == -1) return false;
+
+        // write in pieces, since write may be partial.
+        char const * parts[3] = { reinterpret_cast<char const *>(&h), reinterpret_cast<char const *>(offsets),
+                                  reinterpret_cast<char const *>(bases_before) };
+        size_t sizes[3] = { sizeof(record_index_header), nsamples * sizeof(uint64_t), nsamples * sizeof(uint64_t) };
+        for (int i = 0; i < 3; ++i) {
+          char const * ptr = parts[i];
+          size_t remaining = sizes[i];
+          while (remaining > 0) {
+            ssize_t written = ::write(fd, ptr, ::std::min(remaining, static_cast<size_t>(1UL << 30)));
+            if (written < 0) {
+              if (errno == EINTR) continue;
+              close(fd);
+              unlink(filename.c_str());
+              return false;
+            }
+            ptr += written;
+            remaining -= written;
+          }
+        }
+        close(fd);
+        return true;
+      }
+
+      size_t get_stride() const {
+        return stride;
+      }
+
+      /// number of records in the data file.
+      size_t records() const {
+        return nrecords;
+      }
+
+      /// number of sampled offsets.
+      size_t size() const {
+        return nsamples;
+      }
+
+      uint64_t const * samples() const {
+        return offsets;
+      }
+
+      /// number of sequence characters in the data file.
+      size_t bases() const {
+        return nbases;
+      }
+
+      /// number of sequence characters before each sample.
+      uint64_t const * sample_bases() const {
+        return bases_before;
+      }
+
+      /// first sampled record start at or after offset, or file_range.end.
+      size_t next_record(size_t const & offset, range_type const & file_range) const {
+        uint64_t const * it = ::std::lower_bound(offsets, offsets + nsamples, static_cast<uint64_t>(offset));
+        return (it == offsets + nsamples) ? file_range.end : static_cast<size_t>(*it);
+      }
+
+      /**
+       * @brief  move the boundaries of a block partition of file_range forward to the next sampled record starts.
+       * @details  the blocks of adjacent processes share a boundary, so the aligned blocks still cover the file exactly.
+       */
+      range_type align(range_type const & block, range_type const & file_range) const {
+        range_type result = block;
+        if (result.start > file_range.start) result.start = next_record(result.start, file_range);
+        if (result.end < file_range.end) result.end = next_record(result.end, file_range);
+        if (result.end < result.start) result.end = result.start;
+        return result;
+      }
+
+      /**
+       * @brief  partition of file_range for rank of p, at sampled record starts, with about equal estimated k-mers.
+       * @details  the k-mers between samples i and i + 1 are estimated as their characters - overlap per record, at
+       *           least 0, with overlap = k - 1.  rank r starts at the first sample with at least r / p of the estimated
+       *           k-mers before it.  the boundaries are the same on all ranks, so the partitions cover the file exactly.
+       *           no communication.  off by at most stride records from the balance.
+       */
+      range_type balance(range_type const & file_range, int const rank, int const p, size_t const overlap) const {
+        // cumulative estimated k-mers before each sample, and in total.
+        ::std::vector<uint64_t> before(nsamples + 1, 0);
+        for (size_t i = 0; i < nsamples; ++i) {
+          bool last = (i + 1 == nsamples);
+          uint64_t chars = (last ? nbases : bases_before[i + 1]) - bases_before[i];
+          uint64_t recs = last ? (nrecords - i * stride) : stride;
+          uint64_t excess = recs * overlap;
+          before[i + 1] = before[i] + ((chars > excess) ? (chars - excess) : 0);
+        }
+
+        auto boundary = [this, &before, &file_range, p](int const r) -> size_t {
+          if (r <= 0) return file_range.start;
+          if (r >= p) return file_range.end;
+          uint64_t target = static_cast<uint64_t>(static_cast<double>(before[nsamples]) * r / p);
+          size_t i = ::std::lower_bound(before.begin(), before.begin() + nsamples, target) - before.begin();
+          return (i < nsamples) ? ::std::max(static_cast<size_t>(offsets[i]), file_range.start) : file_range.end;
+        };
+
+        return range_type(boundary(rank), boundary(rank + 1));
+      }
+
+      /// ordinal in the file of the record starting at an aligned block start.
+      size_t record_id(size_t const & aligned_start, range_type const & file_range) const {
+        if (aligned_start <= file_range.start) return 0;
+        uint64_t const * it = ::std::lower_bound(offsets, offsets + nsamples, static_cast<uint64_t>(aligned_start));
+        return ::std::min(static_cast<size_t>(it - offsets) * stride, nrecords);
+      }
+  };
+
+
+  /**
+   * @brief  build the record index from a FASTQ partition whose valid range starts at a record, and save it.  collective.
+   * @details  each process lists the records starting in its valid range.  the sampled offsets are gathered to all
+   *           processes, and rank 0 writes the index.
+   * @return   true if the index was written.
+   */
+  template <typename FileData>
+  bool build_fastq_record_index(FileData const & part, ::std::string const & data_filename,
+                                size_t const & stride, ::mxx::comm const & comm) {
+    using CharIterType = typename FileData::const_iterator;
+
+    // record starts in the valid range, and their sequence lengths.
+    ::std::vector<uint64_t> starts;
+    ::std::vector<uint64_t> lengths;
+    if (part.valid_range_bytes.size() > 0) {
+      ::bliss::io::FASTQParser<CharIterType> parser;
+      parser.init_parser(part.in_mem_cbegin(), part.parent_range_bytes, part.in_mem_range_bytes, part.valid_range_bytes);
+
+      ::bliss::io::SequencesIterator<CharIterType, ::bliss::io::FASTQParser> it(parser, part.cbegin(), part.in_mem_cend(), part.valid_range_bytes.start);
+      ::bliss::io::SequencesIterator<CharIterType, ::bliss::io::FASTQParser> end(part.in_mem_cend());
+      for (; it != end; ++it) {
+        size_t pos = (*it).id.get_pos();
+        if (pos >= part.valid_range_bytes.end) break;
+        starts.push_back(pos);
+        lengths.push_back(::std::distance((*it).seq_begin, (*it).seq_end));
+      }
+    }
+
+    // ordinal of the first local record.
+    uint64_t first = ::mxx::exscan(static_cast<uint64_t>(starts.size()),
+                                   [](uint64_t const & x, uint64_t const & y) { return x + y; }, comm);
+    if (comm.rank() == 0) first = 0;
+    uint64_t total = ::mxx::allreduce(static_cast<uint64_t>(starts.size()), comm);
+
+    // sequence characters before the first local record.
+    uint64_t local_bases = 0;
+    for (auto l : lengths) local_bases += l;
+    uint64_t first_bases = ::mxx::exscan(local_bases, [](uint64_t const & x, uint64_t const & y) { return x + y; }, comm);
+    if (comm.rank() == 0) first_bases = 0;
+    uint64_t total_bases = ::mxx::allreduce(local_bases, comm);
+
+    ::std::vector<uint64_t> local;
+    ::std::vector<uint64_t> local_before;
+    uint64_t before = first_bases;
+    size_t next = (first % stride == 0) ? 0 : stride - (first % stride);
+    for (size_t i = 0; i < starts.size(); ++i) {
+      if (i == next) {
+        local.push_back(starts[i]);
+        local_before.push_back(before);
+        next += stride;
+      }
+      before += lengths[i];
+    }
+    ::std::vector<uint64_t> samples = ::mxx::allgatherv(local, comm);
+    ::std::vector<uint64_t> sample_bases = ::mxx::allgatherv(local_before, comm);
+
+    int ok = 0;
+    if (comm.rank() == 0) {
+      record_index index;
+      index.assign(::std::move(samples), ::std::move(sample_bases), total, total_bases, stride);
+      ok = index.save(data_filename) ? 1 : 0;
+      if (ok == 0) BL_WARNINGF("record index %s could not be written.", record_index_file_name(data_filename).c_str());
+    }
+    // visible to all before any process opens the file again.
+    return ::mxx::allreduce(ok, comm) > 0;
+  }
+
+} // namespace io
+} // namespace bliss
+
+#endif /* SRC_IO_RECORD_INDEX_HPP_ */
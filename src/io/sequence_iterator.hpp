@@ -38,6 +38,7 @@
 #include <algorithm>
 #include <sstream>
 #include <type_traits>
+#include <vector>
 
 // own includes
 #include "common/sequence.hpp"
@@ -361,6 +362,81 @@ namespace bliss
 
     };
 
+
+    /**
+     * @class bliss::io::SequenceRecordCursor
+     * @brief parses a block of data into caller owned record descriptors, a batch at a time.
+     * @details  a lighter alternative to SequencesIterator for loops that visit every record once:  there is no cached
+     *           record, no iterator copies, and no per record end checks by the caller.  records are written into the
+     *           caller's array, e.g. a reused vector of default_batch_size entries that stays in cache, by the same
+     *           Parser::get_next_record as SequencesIterator, so the records are the same, in the same order.
+     *
+     *           records with an empty sequence, e.g. a FASTA header only block, are returned as well, as by SequencesIterator.
+     *
+     * @tparam Iterator	  Base iterator type to be parsed into sequences
+     * @tparam Parser     Functoid type to parse data pointed by Iterator into sequence objects.
+     */
+    template<typename Iterator, template<typename> class Parser>
+    class SequenceRecordCursor {
+      public:
+        using SequenceType = typename Parser<Iterator>::SequenceType;
+
+        /// records per batch for callers without a preference.  about 80KB of FASTQ descriptors.
+        static constexpr size_t default_batch_size = 1024;
+
+      protected:
+        /// where the next record is parsed from.
+        Iterator _next;
+        /// end of the input data, not to go beyond.
+        Iterator _end;
+        /// parser functoid, as for SequencesIterator.
+        Parser<Iterator> parser;
+        /// offset of _next from the start of the file.
+        size_t file_offset;
+
+      public:
+        /**
+         * @param f       parser functoid for parsing the data.
+         * @param start   beginning of the data to be parsed
+         * @param end     end of the data to be parsed.
+         * @param _offset offset of start from the beginning of the file.
+         */
+        SequenceRecordCursor(const Parser<Iterator> & f, Iterator start, Iterator end, const size_t &_offset)
+            : _next(start), _end(end), parser(f), file_offset(_offset) {}
+
+        /// true if all records have been returned.
+        bool at_end() const {
+          return _next == _end;
+        }
+
+        /**
+         * @brief parse up to max_records records into out.
+         * @return the number of records written.  0 at the end of the data.
+         */
+        size_t next_batch(SequenceType * out, size_t const max_records) {
+          size_t n = 0;
+          for (; (n < max_records) && (_next != _end); ++n) {
+            out[n] = parser.get_next_record(_next, _end, file_offset);
+          }
+          return n;
+        }
+
+        /// parse up to out.size() records into out, which is not resized.  returns the number of records written.
+        size_t next_batch(::std::vector<SequenceType> & out) {
+          return next_batch(out.data(), out.size());
+        }
+    };
+
+    template<typename Iterator, template<typename> class Parser>
+    constexpr size_t SequenceRecordCursor<Iterator, Parser>::default_batch_size;
+
+
+    /// true for the sequence iterator types whose records a SequenceRecordCursor produces too, e.g. to parse them in batches instead.
+    template <template <typename, template <typename> class> class SeqIterType>
+    struct has_record_cursor : public ::std::false_type {};
+    template <>
+    struct has_record_cursor<SequencesIterator> : public ::std::true_type {};
+
   } // iterator
 } // bliss
 #endif /* SequencesIterator_HPP_ */
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    stream_file.hpp
+ * @ingroup io
+ * @brief   FASTQ input from a stream (stdin, a pipe, or a socket) without staging it to a file.
+ * @details the readers in file.hpp need a seekable file of known size.  a stream is read once, in order, by 1 rank:
+ *          fastq_stream_reader cuts it into blocks of whole records, and scatter_stream_block sends 1 block to each
+ *          rank per round, in rank order.  the blocks of a round are consecutive in the stream, so a round looks like a
+ *          block partitioned file to FASTQParser, and the ranges are stream offsets, so sequence ids are unique.
+ */
+
+#ifndef STREAM_FILE_HPP_
+#define STREAM_FILE_HPP_
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstring>      // memchr, strerror
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+
+#include <unistd.h>     // read
+
+#include "mpi.h"
+#include "mxx/comm.hpp"
+
+#include "io/file.hpp"
+#include "io/io_exception.hpp"
+#include "utils/exception_handling.hpp"
+
+
+namespace bliss
+{
+namespace io
+{
+
+/// default bytes of records per round of a streamed input, over all ranks.  root holds 1 round at a time.
+constexpr size_t stream_round_bytes = 256UL << 20;
+
+/// default bytes of records per rank per round:  an even share of stream_round_bytes, at least 64KB.
+inline size_t default_stream_block_bytes(int const p) {
+  return ::std::max(stream_round_bytes / static_cast<size_t>(::std::max(p, 1)), static_cast<size_t>(64UL << 10));
+}
+
+/**
+ * @brief reads whole FASTQ records from a file descriptor, e.g. 0 for stdin, a pipe, or a connected socket.
+ * @details  the stream starts at a record, and records are 4 lines, as FASTQParser assumes.  counting newlines from
+ *          the start is then exact, so the @ and + search that FASTQParser::find_first_record needs at an arbitrary
+ *          file offset is not needed.  bytes after the last complete record are kept for the next call.  the last
+ *          record may lack its final newline, and blank lines after it are dropped.  the descriptor is not closed.
+ */
+class fastq_stream_reader {
+  protected:
+    /// source
+    int fd;
+    /// bytes per read call
+    size_t read_bytes;
+    /// read returned 0
+    bool eof;
+
+    /// bytes read but not returned yet.
+    std::vector<unsigned char> pending;
+    /// stream offset of pending[0]
+    size_t offset;
+    /// pending[0, scanned) has been searched for newlines.
+    size_t scanned;
+    /// newlines in pending[record_end, scanned)
+    size_t lines;
+    /// end of the last complete record found in pending.
+    size_t record_end;
+
+    /// append up to read_bytes from fd to pending.
+    void fill() {
+      size_t old = pending.size();
+      pending.resize(old + read_bytes);
+      ssize_t count;
+      do {
+        count = ::read(fd, pending.data() + old, read_bytes);
+      } while ((count < 0) && (errno == EINTR));
+      if (count < 0) {
+        int myerr = errno;
+        pending.resize(old);
+        ::std::stringstream ss;
+        ss << "ERROR: fastq_stream_reader read: fd " << fd << " error " << myerr << ": " << strerror(myerr);
+        throw ::bliss::utils::make_exception<::bliss::io::IOException>(ss.str());
+      }
+      pending.resize(old + count);
+      eof = (count == 0);
+    }
+
+    /// search the new bytes for the first record end at or after min_end.  true if found.
+    bool scan(size_t const min_end) {
+      while (scanned < pending.size()) {
+        unsigned char const * nl = static_cast<unsigned char const *>(
+            memchr(pending.data() + scanned, '\n', pending.size() - scanned));
+        if (nl == nullptr) {
+          scanned = pending.size();
+          break;
+        }
+        scanned = (nl - pending.data()) + 1;
+        if (++lines == 4) {
+          lines = 0;
+          record_end = scanned;
+          if (record_end >= min_end) return true;
+        }
+      }
+      return false;
+    }
+
+  public:
+    /**
+     * @param _fd          open descriptor, positioned at the start of a record.
+     * @param _read_bytes  bytes per read call.
+     */
+    explicit fastq_stream_reader(int const _fd, size_t const _read_bytes = 1UL << 20) :
+      fd(_fd), read_bytes(::std::max(_read_bytes, static_cast<size_t>(1))), eof(false),
+      offset(0), scanned(0), lines(0), record_end(0) {}
+
+    /**
+     * @brief append the next whole records to out, at least min_bytes of them unless the stream ends.
+     * @details  stops at the first record end at or after min_bytes, so a block exceeds min_bytes by less than 1 record.
+     * @return  stream offset of the appended bytes.  nothing is appended once the stream is done.
+     */
+    size_t next(size_t const min_bytes, std::vector<unsigned char> & out) {
+      size_t const start = offset;
+      size_t const min_end = ::std::max(min_bytes, static_cast<size_t>(1));
+
+      while (!scan(min_end) && !eof) fill();
+
+      // at the end of the stream, the rest is the last records.
+      size_t const cut = ((record_end >= min_end) || !eof) ? record_end : pending.size();
+
+      // and blank lines after them are dropped, rather than sent as a block without a record.
+      if ((cut == pending.size()) && eof &&
+          ::std::all_of(pending.begin(), pending.end(), [](unsigned char c){ return (c == '\n') || (c == '\r'); })) {
+        offset += cut;
+        pending.clear();
+        scanned = 0;
+        record_end = 0;
+        lines = 0;
+        return offset;
+      }
+
+      out.insert(out.end(), pending.begin(), pending.begin() + cut);
+      pending.erase(pending.begin(), pending.begin() + cut);
+      offset += cut;
+      scanned -= ::std::min(scanned, cut);
+      record_end = 0;
+      if (pending.empty()) lines = 0;
+      return start;
+    }
+
+    /// true after the last record was returned.
+    bool done() const {
+      return eof && pending.empty();
+    }
+
+    /// bytes returned so far.
+    size_t position() const {
+      return offset;
+    }
+};
+
+
+#if defined(USE_MPI)
+
+/**
+ * @brief 1 round of a streamed input:  root reads 1 block of at least block_bytes of whole records per rank and scatters them.  collective.
+ * @details  rank i gets the i-th block of the round, so the blocks are round robin over the ranks, and consecutive
+ *          in rank order.  root holds a round (about p * block_bytes) at a time.
+ * @param reader       the stream.  used on root only, may be null on the other ranks.
+ * @param block_bytes  same on all ranks.  a block must fit an int count.
+ * @return  the block of this rank.  the parent range is the round, and is empty on all ranks once the stream is done.
+ */
+inline ::bliss::io::file_data scatter_stream_block(fastq_stream_reader * reader, size_t const block_bytes,
+                                                    ::mxx::comm const & comm, int const root = 0) {
+  if (block_bytes > static_cast<size_t>(::std::numeric_limits<int>::max() / 2))
+    throw ::std::invalid_argument("ERROR: scatter_stream_block: block_bytes does not fit an int count.");
+
+  int const p = comm.size();
+  std::vector<unsigned char> round;
+  // start and end of each rank's block, then of the round, then 1 if root failed.
+  std::vector<size_t> ranges(2 * p + 3, 0);
+  std::vector<int> counts;
+  std::vector<int> displs;
+  std::string error;
+
+  if (comm.rank() == root) {
+    counts.resize(p, 0);
+    displs.resize(p, 0);
+    try {
+      for (int i = 0; i < p; ++i) {
+        displs[i] = static_cast<int>(round.size());
+        ranges[2 * i] = reader->next(block_bytes, round);
+        ranges[2 * i + 1] = ranges[2 * i] + (round.size() - displs[i]);
+        if (round.size() > static_cast<size_t>(::std::numeric_limits<int>::max()))
+          throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR: scatter_stream_block: a round of blocks exceeds an int count.  use a smaller block_bytes.");
+        counts[i] = static_cast<int>(round.size() - displs[i]);
+      }
+    } catch (::std::exception const & e) {
+      error = e.what();
+      ranges[2 * p + 2] = 1;
+    }
+    ranges[2 * p] = ranges[0];
+    ranges[2 * p + 1] = ranges[2 * p - 1];
+  }
+
+  // all ranks throw if root could not read.
+  MPI_Bcast(ranges.data(), 2 * p + 3, MPI_UNSIGNED_LONG, root, comm);
+  if (ranges[2 * p + 2] != 0) {
+    if (comm.rank() == root) throw ::bliss::utils::make_exception<::bliss::io::IOException>(error);
+    throw ::bliss::utils::make_exception<::bliss::io::IOException>("ERROR: scatter_stream_block: reading the stream failed on the root rank.");
+  }
+
+  ::bliss::io::file_data block;
+  block.parent_range_bytes = ::bliss::partition::range<size_t>(ranges[2 * p], ranges[2 * p + 1]);
+  block.in_mem_range_bytes = ::bliss::partition::range<size_t>(ranges[2 * comm.rank()], ranges[2 * comm.rank() + 1]);
+  block.valid_range_bytes = block.in_mem_range_bytes;
+  block.data.resize(block.in_mem_range_bytes.size());
+
+  MPI_Scatterv(round.data(), counts.data(), displs.data(), MPI_UNSIGNED_CHAR,
+               block.data.data(), static_cast<int>(block.data.size()), MPI_UNSIGNED_CHAR, root, comm);
+
+  return block;
+}
+
+#endif  // USE_MPI
+
+} // namespace io
+} // namespace bliss
+
+#endif /* STREAM_FILE_HPP_ */
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    superkmer_codec.hpp
+ * @ingroup io
+ * @brief   super-kmer wire format for k-mers in read order.
+ * @details consecutive k-mers of a read overlap by K-1 characters.  when they are sent to the same rank, as with
+ *          the minimizer distribution hash, a run of them (a super-kmer) can be sent as the first k-mer plus
+ *          1 byte per following k-mer, instead of a full k-mer each.
+ *
+ *          a run is encoded as varint(number of steps), the raw words of the first k-mer, then 1 byte per step.
+ *          a step byte is (op | char << 2), with op one of
+ *            0: shift char in at the low end  (next k-mer on the forward strand)
+ *            1: shift char in at the high end (previous k-mer on the forward strand)
+ *            2, 3: as 0 and 1, applied to the reverse complement of the previous k-mer.
+ *          ops 2 and 3 cover canonical k-mers, which switch strands within a read.
+ *          the runs are found by the encoder, so any k-mer sequence can be encoded; the order is preserved.
+ */
+
+#ifndef SUPERKMER_CODEC_HPP
+#define SUPERKMER_CODEC_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>   // memcpy
+#include <vector>
+
+#include "common/kmer.hpp"
+#include "io/delta_codec.hpp"
+
+namespace imxx
+{
+
+  namespace codec
+  {
+
+    namespace superkmer
+    {
+
+      namespace detail {
+
+        /// step byte from prev to next.  false if next does not follow from prev.
+        template <typename KMER>
+        inline bool find_step(KMER const & prev, KMER const & next, uint8_t & step) {
+          uint8_t lo = static_cast<uint8_t>(next.getCharsAtPos(0, 1));
+          uint8_t hi = static_cast<uint8_t>(next.getCharsAtPos(KMER::size - 1, 1));
+
+          KMER t = prev;
+          t.nextFromChar(lo);
+          if (t == next) { step = static_cast<uint8_t>(0 | (lo << 2)); return true; }
+          t = prev;
+          t.nextReverseFromChar(hi);
+          if (t == next) { step = static_cast<uint8_t>(1 | (hi << 2)); return true; }
+
+          KMER rc = prev.reverse_complement();
+          t = rc;
+          t.nextFromChar(lo);
+          if (t == next) { step = static_cast<uint8_t>(2 | (lo << 2)); return true; }
+          t = rc;
+          t.nextReverseFromChar(hi);
+          if (t == next) { step = static_cast<uint8_t>(3 | (hi << 2)); return true; }
+          return false;
+        }
+
+        /// apply a step byte to k-mer.
+        template <typename KMER>
+        inline void apply_step(KMER & kmer, uint8_t step) {
+          if ((step & 0x2) != 0) kmer = kmer.reverse_complement();
+          if ((step & 0x1) == 0) kmer.nextFromChar(step >> 2);
+          else kmer.nextReverseFromChar(step >> 2);
+        }
+
+      } // namespace detail
+
+
+      /// upper bound on the encoded size of n k-mers.  reached when no two are consecutive.
+      template <typename KMER>
+      constexpr size_t max_encoded_bytes(size_t n) {
+        return n * (KMER::nWords * sizeof(typename KMER::KmerWordType) + (sizeof(size_t) * 8 + 6) / 7);
+      }
+
+      /**
+       * @brief encode k-mers in order, appending to out.
+       * @return number of bytes appended.
+       */
+      template <typename KMER>
+      size_t encode(KMER const * kmers, size_t n, ::std::vector<uint8_t> & out) {
+        static_assert(::bliss::common::is_kmer<KMER>::value, "super-kmer codec requires a kmer type");
+        static_assert(KMER::bitsPerChar <= 6, "super-kmer step byte holds at most 6 bits per character");
+        constexpr size_t kmer_bytes = KMER::nWords * sizeof(typename KMER::KmerWordType);
+
+        size_t start = out.size();
+        if (n == 0) return 0;
+
+        out.resize(start + max_encoded_bytes<KMER>(n));
+        uint8_t * o = out.data() + start;
+
+        std::vector<uint8_t> steps;
+        size_t len[1];
+        uint8_t step;
+
+        for (size_t i = 0; i < n; ) {
+          steps.clear();
+          size_t j = i + 1;
+          for (; j < n; ++j) {
+            if (!detail::find_step(kmers[j - 1], kmers[j], step)) break;
+            steps.push_back(step);
+          }
+
+          len[0] = steps.size();
+          o = ::imxx::codec::detail::put_varint(len, o);
+          memcpy(o, kmers[i].getData(), kmer_bytes);
+          o += kmer_bytes;
+          if (!steps.empty()) memcpy(o, steps.data(), steps.size());
+          o += steps.size();
+
+          i = j;
+        }
+
+        out.resize(o - out.data());
+        return out.size() - start;
+      }
+
+      /**
+       * @brief decode bytes produced by encode, appending k-mers to out in the original order.
+       * @return number of k-mers appended.
+       */
+      template <typename KMER>
+      size_t decode(uint8_t const * in, size_t bytes, ::std::vector<KMER> & out) {
+        static_assert(::bliss::common::is_kmer<KMER>::value, "super-kmer codec requires a kmer type");
+        constexpr size_t kmer_bytes = KMER::nWords * sizeof(typename KMER::KmerWordType);
+
+        size_t start = out.size();
+        uint8_t const * end = in + bytes;
+
+        KMER cur;
+        size_t len[1];
+
+        while (in < end) {
+          in = ::imxx::codec::detail::get_varint(in, len);
+          memcpy(cur.getDataRef(), in, kmer_bytes);
+          in += kmer_bytes;
+          out.push_back(cur);
+
+          for (size_t s = 0; s < len[0]; ++s, ++in) {
+            detail::apply_step(cur, *in);
+            out.push_back(cur);
+          }
+        }
+
+        return out.size() - start;
+      }
+
+    } // namespace superkmer
+
+  } // namespace codec
+
+} // namespace imxx
+
+
+#endif // SUPERKMER_CODEC_HPP
@@ -171,6 +171,22 @@ TEST_P(BucketBenchmark, bucket)
                                    this->p.first, this->p.last);
 }
 
+TEST_P(BucketBenchmark, radix_bucket)
+{
+	this->bcounts.clear();
+	this->unbucketed.clear();
+  this->mapping.clear();
+
+  // allocate.
+  this->bucketed.resize(this->p.input_size);
+
+  BucketBenchmarkInfo pp = this->p;
+
+  imxx::local::bucketing_radix_impl(this->data, [&pp](std::pair<size_t, size_t> const & x){ return x.first % pp.bucket_count; },
+		  this->p.bucket_count, this->bcounts,   this->bucketed,
+                                   this->p.first, this->p.last);
+}
+
 TEST_P(BucketBenchmark, mxx_inplace_bucket)
 {
   this->unbucketed.clear();
@@ -238,6 +254,37 @@ TEST_P(BucketBenchmark, permute)
   }
 }
 
+TEST_P(BucketBenchmark, radix_permute)
+{
+	this->unbucketed.clear();
+  this->mapping.clear();
+  this->bucketed.clear();
+
+  BucketBenchmarkInfo pp = this->p;
+
+  // allocate.
+  this->mapping.reserve(this->p.input_size);
+
+  imxx::local::assign_to_buckets(this->data, [&pp](std::pair<size_t, size_t> const & x){ return x.first % pp.bucket_count; },
+		  this->p.bucket_count,
+                                 this->bcounts, this->mapping, this->p.first, this->p.last);
+
+  imxx::local::bucket_to_permutation(this->bcounts, this->mapping, this->p.first, this->p.last);
+
+
+  if (pp.bucket_count > 0) {
+
+	  // allocate.
+	  this->bucketed.resize(this->p.input_size);
+
+	  imxx::local::permute_radix(this->data.begin() + this->p.first, this->data.begin() + this->p.last,
+						   this->mapping.begin() + this->p.first,
+							  this->bucketed.begin() + this->p.first,
+						   this->p.first);
+
+  }
+}
+
 TEST_P(BucketBenchmark, inplace_permute)
 {
 	this->unbucketed.clear();
@@ -357,6 +404,7 @@ TEST_P(BucketBenchmark, inplace_unpermute)
 
 
 INSTANTIATE_TEST_CASE_P(Bliss, BucketBenchmark, ::testing::Values(
+    BucketBenchmarkInfo((1UL << 22), 1UL << 12, 0, (1UL << 22)),  // 0, full, at the radix threshold
     BucketBenchmarkInfo((1UL << 22), 1UL << 16, 0, (1UL << 22))  // 1, full
 
 ));
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    benchmark_mmap_prefault.cpp
+ * @ingroup
+ * @brief   a parse-like pass over a cold mmap, with and without prefaulting.  see prefault_mode in io/file.hpp
+ * @details the file is BL_PREFAULT_FILE if set, else a generated 256MB file in /tmp.  its pages are dropped from the
+ *          page cache before each run.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include "io/file.hpp"
+#include "utils/cache_utils.hpp"
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>   // getenv
+#include <chrono>
+#include <utility>   // pair
+#include <vector>
+#include <unistd.h>  // getpid
+
+using prefault_param = std::pair<::bliss::io::prefault_mode, size_t>;
+
+class MmapPrefaultBenchmark : public ::testing::TestWithParam<prefault_param>
+{
+  protected:
+    static std::string fileName;
+    static bool generated;
+    static size_t expected;
+
+    static void SetUpTestCase() {
+      char const * v = ::std::getenv("BL_PREFAULT_FILE");
+      generated = (v == nullptr);
+      if (!generated) {
+        fileName.assign(v);
+      } else {
+        fileName = "/tmp/bliss_prefault_" + std::to_string(getpid()) + ".txt";
+
+        // 100 char lines.
+        std::string line(99, 'A');
+        line.push_back('\n');
+        FILE * fp = fopen(fileName.c_str(), "w");
+        ASSERT_TRUE(fp != NULL);
+        for (size_t i = 0; i < (256UL << 20) / line.size(); ++i) fputs(line.c_str(), fp);
+        fclose(fp);
+      }
+
+      // count with the plain path, as the reference.
+      ::bliss::io::mmap_file f(fileName);
+      f.set_prefault(::bliss::io::prefault_mode::none);
+      ::bliss::io::mapped_data md = f.map(::bliss::io::base_file::range_type(0, f.size()));
+      expected = count_lines(md.get_data(), md.size());
+    }
+
+    static void TearDownTestCase() {
+      if (generated) remove(fileName.c_str());
+    }
+
+    static size_t count_lines(unsigned char const * data, size_t const bytes) {
+      size_t count = 0;
+      for (size_t i = 0; i < bytes; ++i) count += (data[i] == '\n') ? 1 : 0;
+      return count;
+    }
+};
+
+std::string MmapPrefaultBenchmark::fileName;
+bool MmapPrefaultBenchmark::generated = false;
+size_t MmapPrefaultBenchmark::expected = 0;
+
+
+TEST_P(MmapPrefaultBenchmark, parse)
+{
+  prefault_param p = GetParam();
+
+  ::bliss::utils::cache::drop_file_cache(fileName);
+
+  ::bliss::io::mmap_file f(fileName);
+  f.set_prefault(p.first, p.second);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  ::bliss::io::mapped_data md = f.map(::bliss::io::base_file::range_type(0, f.size()));
+  auto mapped = std::chrono::high_resolution_clock::now();
+  size_t count = count_lines(md.get_data(), md.size());
+  auto end = std::chrono::high_resolution_clock::now();
+
+  double map_s = std::chrono::duration<double>(mapped - start).count();
+  double total_s = std::chrono::duration<double>(end - start).count();
+  printf("prefault %d threads %lu: %lu bytes, map %f s, map + parse %f s, %f GB/s\n",
+         static_cast<int>(p.first), p.second, md.size(), map_s, total_s,
+         static_cast<double>(md.size()) / total_s * 1.0e-9);
+
+  EXPECT_EQ(expected, count);
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, MmapPrefaultBenchmark, ::testing::Values(
+    prefault_param(::bliss::io::prefault_mode::none, 0),
+    prefault_param(::bliss::io::prefault_mode::populate, 0),
+    prefault_param(::bliss::io::prefault_mode::threads, 1),
+    prefault_param(::bliss::io::prefault_mode::threads, 2),
+    prefault_param(::bliss::io::prefault_mode::threads, 4)
+));
@@ -46,9 +46,13 @@
 #include <cstdint>  // uint32_t
 #include <utility>  // pair
 #include <vector>
+#include <numeric>  // accumulate
 
 #include "io/incremental_mxx.hpp"
+#include "io/hierarchical_mxx.hpp"
+#include "io/compressed_mxx.hpp"
 #include "containers/dsc_container_utils.hpp"
+#include "utils/kmer_generator.hpp"
 
 // includ the murmurhash code.
 #ifndef _MURMURHASH3_H_
@@ -329,14 +333,13 @@ class DistributeBenchmark : public ::testing::TestWithParam<DistributeBenchmarkI
 
     void init(mxx::comm const & comm) {
 
-      // populate data with random numbers
-      srand((comm.rank() + 1) * (comm.rank() + 1) - 1);
-      size_t val;
-      for (size_t i = 0; i < p.input_size; ++i) {
-        val = rand();
-        val <<= 32;
-        val |= rand();
-        data.emplace_back(val, comm.rank());
+      // populate data with skewed values, as k-mers of real data:  zipf multiplicities over input_size / 2 distinct
+      // values shared by all ranks, with some adjacent repeats.
+      std::vector<size_t> vals;
+      ::bliss::utils::generate_zipf(vals, p.input_size, std::max(p.input_size / 2, static_cast<size_t>(1)), 1.0, 0.01,
+                                    (comm.rank() + 1) * (comm.rank() + 1) - 1);
+      for (size_t i = 0; i < vals.size(); ++i) {
+        data.emplace_back(vals[i], comm.rank());
       }
 
     }
@@ -415,6 +418,109 @@ TEST_P(DistributeBenchmark, distribute)
   this->roundtripped.clear();
 }
 
+TEST_P(DistributeBenchmark, distribute_shared)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  ::imxx::hierarchical_comm hcomm(comm);
+
+  // copy data into roundtripped.
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  if (this->p.hash_type == 0)
+	  imxx::shared_distribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+					   recv_counts, mapping, this->distributed, hcomm, false);
+  else {
+	  murmurhash hs;
+	  imxx::shared_distribute(this->roundtripped, [&p, &hs](T const & x ){ return hs(x.first) % p; },
+					   recv_counts, mapping, this->distributed, hcomm, false);
+  }
+
+  this->roundtripped.clear();
+}
+
+TEST_P(DistributeBenchmark, distribute_hierarchical)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  ::imxx::hierarchical_comm hcomm(comm);
+
+  // copy data into roundtripped.
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  if (this->p.hash_type == 0)
+	  imxx::hierarchical_distribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+					   recv_counts, mapping, this->distributed, hcomm, false);
+  else {
+	  murmurhash hs;
+	  imxx::hierarchical_distribute(this->roundtripped, [&p, &hs](T const & x ){ return hs(x.first) % p; },
+					   recv_counts, mapping, this->distributed, hcomm, false);
+  }
+
+  this->roundtripped.clear();
+}
+
+TEST_P(DistributeBenchmark, distribute_keys)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  // key only, with repeats as in k-mer counting
+  std::vector<size_t> keys(this->data.size());
+  std::transform(this->data.begin(), this->data.end(), keys.begin(), [](T const & x){ return x.first & 0xFFFFFF; });
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+  std::vector<size_t> out;
+
+  murmurhash hs;
+  imxx::distribute(keys, [&p, &hs](size_t const & x ){ return hs(x) % p; },
+				   recv_counts, mapping, out, comm, false);
+}
+
+TEST_P(DistributeBenchmark, compressed_distribute_keys)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  // key only, with repeats as in k-mer counting
+  std::vector<size_t> keys(this->data.size());
+  std::transform(this->data.begin(), this->data.end(), keys.begin(), [](T const & x){ return x.first & 0xFFFFFF; });
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> out;
+
+  murmurhash hs;
+  imxx::compressed_distribute(keys, [&p, &hs](size_t const & x ){ return hs(x) % p; },
+				   recv_counts, out, comm);
+}
+
 TEST_P(DistributeBenchmark, dsc_distribute)
 {
 
@@ -541,6 +647,67 @@ TEST_P(DistributeBenchmark, dsc_distribute_rt)
 }
 
 
+/// data grouped by destination rank, and the send and receive counts, for the exchange only benchmarks.
+template <typename T, typename ToRank>
+void bucket_by_rank(std::vector<T> const & data, ToRank const & to_rank, std::vector<T> & buckets,
+                    std::vector<size_t> & send_counts, std::vector<size_t> & recv_counts, mxx::comm const & comm) {
+  send_counts.assign(comm.size(), 0);
+  for (size_t i = 0; i < data.size(); ++i) ++send_counts[to_rank(data[i])];
+
+  std::vector<size_t> offsets(comm.size(), 0);
+  for (int i = 1; i < comm.size(); ++i) offsets[i] = offsets[i - 1] + send_counts[i - 1];
+  buckets.resize(data.size());
+  for (size_t i = 0; i < data.size(); ++i) buckets[offsets[to_rank(data[i])]++] = data[i];
+
+  recv_counts.resize(comm.size());
+  mxx::all2all(send_counts.data(), 1, recv_counts.data(), comm);
+}
+
+// the element exchange alone, through the struct datatype of the padded pair.
+TEST_P(DistributeBenchmark, a2av_datatype)
+{
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  int p = comm.size();
+  murmurhash hs;
+  std::vector<size_t> send_counts, recv_counts;
+  bucket_by_rank(this->data, [&p, &hs](T const & x){ return hs(x.first) % p; }, this->roundtripped, send_counts, recv_counts, comm);
+  this->distributed.resize(std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0)));
+
+  mxx::all2allv(this->roundtripped.data(), send_counts, this->distributed.data(), recv_counts, comm);
+}
+
+// the element exchange alone, as raw bytes, padding included.
+TEST_P(DistributeBenchmark, a2av_raw_bytes)
+{
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  int p = comm.size();
+  murmurhash hs;
+  std::vector<size_t> send_counts, recv_counts;
+  bucket_by_rank(this->data, [&p, &hs](T const & x){ return hs(x.first) % p; }, this->roundtripped, send_counts, recv_counts, comm);
+  this->distributed.resize(std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0)));
+
+  static_assert(imxx::is_raw_exchangeable<T>::value, "padded pairs are exchanged as raw bytes");
+  imxx::all2allv_raw(this->roundtripped.data(), send_counts, this->distributed.data(), recv_counts, comm);
+
+  // received entries belong here, and came from the rank they name.
+  size_t wrong = 0;
+  size_t offset = 0;
+  for (int r = 0; r < p; ++r) {
+    for (size_t i = offset; i < offset + recv_counts[r]; ++i) {
+      if ((static_cast<int>(hs(this->distributed[i].first) % p) != comm.rank()) || (this->distributed[i].second != r)) ++wrong;
+    }
+    offset += recv_counts[r];
+  }
+  EXPECT_EQ(0UL, wrong);
+}
+
+
 TEST_P(DistributeBenchmark, scatter_compute_gather)
 {
 
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_bgzf_file.cpp
+ *   reads BGZF compressed copies of the test data in parallel, and compares to the uncompressed files.
+ *   the compressed copies are written by rank 0 with bgzf::compress_block, with small members so every rank gets some.
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdio>   // remove
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+
+#include "io/file_loader.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/fasta_loader.hpp"
+#include "io/file.hpp"
+#include "io/bgzf_file.hpp"
+
+#if defined(USE_ZLIB)
+
+template <typename file_loader>
+class BGZFFileTest : public ::testing::Test
+{
+  protected:
+    std::string fileName;
+    std::string gzName;
+    std::vector<unsigned char> ref;
+
+    virtual void SetUp()
+    {
+      fileName.assign(PROJ_SRC_DIR);
+      gzName.assign(PROJ_BIN_DIR);
+      if (std::is_same<file_loader, ::bliss::io::parallel::bgzf_file<::bliss::io::FASTAParser> >::value) {
+        fileName.append("/test/data/test.medium.fasta");
+        gzName.append("/test.bgzf.medium.fasta.gz");
+      } else {
+        fileName.append("/test/data/test.fastq");
+        gzName.append("/test.bgzf.fastq.gz");
+      }
+
+      std::ifstream ifs(fileName, std::ios::binary);
+      ref.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+      ::mxx::comm comm;
+      if (comm.rank() == 0) {
+        std::vector<unsigned char> gz;
+        for (size_t i = 0; i < ref.size(); i += 8000) {
+          ::bliss::io::bgzf::compress_block(ref.data() + i, std::min(static_cast<size_t>(8000), ref.size() - i), gz);
+        }
+        ::bliss::io::bgzf::compress_block(nullptr, 0, gz);
+
+        std::ofstream ofs(gzName, std::ios::binary);
+        ofs.write(reinterpret_cast<char const *>(gz.data()), gz.size());
+      }
+      comm.barrier();
+    }
+
+    virtual void TearDown()
+    {
+      ::mxx::comm comm;
+      comm.barrier();
+      if (comm.rank() == 0) remove(gzName.c_str());
+    }
+};
+
+// indicate this is a typed test
+TYPED_TEST_CASE_P(BGZFFileTest);
+
+
+TYPED_TEST_P(BGZFFileTest, read)
+{
+  ::mxx::comm comm;
+  TypeParam fobj(this->gzName, 30, comm);
+  ::bliss::io::file_data fdata = fobj.read_file();
+
+  // uncompressed coordinates
+  EXPECT_EQ(this->ref.size(), fdata.parent_range_bytes.size());
+
+  // data matches the uncompressed file
+  ASSERT_EQ(fdata.in_mem_range_bytes.size(), fdata.data.size());
+  ASSERT_LE(fdata.in_mem_range_bytes.end, this->ref.size());
+  EXPECT_TRUE(std::equal(fdata.data.begin(), fdata.data.end(), this->ref.begin() + fdata.in_mem_range_bytes.start));
+
+  // complete coverage, no double counting
+  EXPECT_EQ(this->ref.size(), ::mxx::allreduce(fdata.valid_range_bytes.size(), comm));
+  EXPECT_LE(fdata.in_mem_range_bytes.start, fdata.valid_range_bytes.start);
+  EXPECT_LE(fdata.valid_range_bytes.end, fdata.in_mem_range_bytes.end);
+
+  // fastq partitions start at a record.
+  if (std::is_same<TypeParam, ::bliss::io::parallel::bgzf_file<::bliss::io::FASTQParser> >::value) {
+    if (fdata.valid_range_bytes.size() > 0) {
+      EXPECT_EQ('@', this->ref[fdata.valid_range_bytes.start]);
+    }
+  }
+}
+
+TYPED_TEST_P(BGZFFileTest, not_bgzf)
+{
+  ::mxx::comm comm;
+  // the uncompressed file is not BGZF.  all ranks throw.
+  TypeParam fobj(this->fileName, 30, comm);
+  EXPECT_THROW(fobj.read_file(), ::bliss::io::IOException);
+}
+
+
+// now register the test cases
+REGISTER_TYPED_TEST_CASE_P(BGZFFileTest, read, not_bgzf);
+
+
+typedef ::testing::Types<
+    ::bliss::io::parallel::bgzf_file<::bliss::io::BaseFileParser>,
+    ::bliss::io::parallel::bgzf_file<::bliss::io::FASTQParser>,
+    ::bliss::io::parallel::bgzf_file<::bliss::io::FASTAParser>
+> BGZFFileTestTypes;
+INSTANTIATE_TYPED_TEST_CASE_P(Bliss, BGZFFileTest, BGZFFileTestTypes);
+
+#endif
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
@@ -37,6 +37,11 @@
 #include <type_traits>  // for integral_constant
 
 #include <io/incremental_mxx.hpp>
+#include <io/hierarchical_mxx.hpp>
+#include <io/compressed_mxx.hpp>
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
 
 #include <string>
 #include <unordered_map>
@@ -48,6 +53,11 @@
 #include <cstdint>  // uint32_t
 #include <utility>  // pair
 #include <vector>
+#include <functional>  // function
+#include <cstdlib>  // setenv
+#include <numeric>  // accumulate
+#include <tuple>
+#include <unistd.h>  // usleep
 
 
 //===============  BLOCK All2All tests
@@ -219,6 +229,35 @@ TEST_P(A2ADistributeTest, block_a2a_inplace)
 
 
 
+TEST_P(A2ADistributeTest, block_a2a_pipelined)
+{
+  ::mxx::comm comm;
+
+  this->init(comm);
+  this->roundtripped.clear();
+
+  // allocate.
+  A2ADistributeTestInfo pp = this->p;
+
+  this->distributed.clear();
+  this->distributed.resize(pp.output_size);
+
+  // 3 elements per chunk, so most blocks take several chunks.  chunks arrive in order and cover the block.
+  size_t next = 0;
+  bool in_order = true;
+  imxx::block_all2all_pipelined(this->data, pp.block_size, this->distributed,
+                      [&next, &in_order](size_t offset, size_t count) {
+                        in_order &= (offset == next) && (count > 0);
+                        next = offset + count;
+                      },
+                      pp.input_offset, pp.output_offset, comm, 3 * sizeof(T));
+
+  bool empty = mxx::all_of((pp.input_size == 0) || (pp.block_size == 0), comm);
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ((empty ? 0 : pp.block_size), next);
+}
+
+
 TEST_P(A2ADistributeTest, block_roundtrip)
 {
   ::mxx::comm comm;
@@ -473,6 +512,167 @@ TEST_P(DistributeTest, distribute)
   this->roundtripped.clear();
 }
 
+TEST_P(DistributeTest, soa_distribute)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  ::fsc::soa_vector<size_t, int> input(this->data.begin(), this->data.end());
+  ::fsc::soa_vector<size_t, int> output;
+
+  // distribute, ranked by the key alone.
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  imxx::distribute(input, [&p](size_t const & x ){ return x % p; },
+                   recv_counts, mapping, output, comm);
+  EXPECT_EQ(output.size(), std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0)));
+
+  output.to_pairs(this->distributed);
+  this->roundtripped.clear();
+}
+
+
+
+TEST_P(DistributeTest, hierarchical_distribute_preserve_input)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  ::imxx::hierarchical_comm hcomm(comm);
+
+  // copy data into roundtripped.
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  imxx::hierarchical_distribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+                   recv_counts, mapping, this->distributed, hcomm, true);
+
+}
+
+TEST_P(DistributeTest, hierarchical_distribute)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  ::imxx::hierarchical_comm hcomm(comm);
+
+  // copy data into roundtripped.
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  imxx::hierarchical_distribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+                   recv_counts, mapping, this->distributed, hcomm, false);
+
+  this->roundtripped.clear();
+}
+
+
+TEST_P(DistributeTest, shared_distribute)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  ::imxx::hierarchical_comm hcomm(comm);
+
+  // copy data into roundtripped.  shared_distribute leaves input unchanged.
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  imxx::shared_distribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+                   recv_counts, mapping, this->distributed, hcomm, false);
+
+}
+
+
+TEST_P(DistributeTest, compressed_distribute)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  // keys only, with repeats.
+  std::vector<size_t> keys(this->data.size());
+  std::transform(this->data.begin(), this->data.end(), keys.begin(), [](T const & x){ return x.first & 0xFFFF; });
+
+  int p = comm.size();
+  std::vector<size_t> send_counts = ::mxx::bucketing(keys, [&p](size_t const & x ){ return x % p; }, p);
+  std::vector<size_t> gold_keys = ::mxx::all2allv(keys, send_counts, comm);
+
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> result;
+  imxx::compressed_distribute(keys, [&p](size_t const & x ){ return x % p; },
+                   recv_counts, result, comm);
+
+  // same keys per source, sorted within each source segment.
+  ASSERT_EQ(gold_keys.size(), result.size());
+  auto it = gold_keys.begin();
+  for (int i = 0; i < p; ++i) {
+    std::sort(it, it + recv_counts[i]);
+    it += recv_counts[i];
+  }
+  EXPECT_TRUE(std::equal(gold_keys.begin(), gold_keys.end(), result.begin()));
+}
+
+
+TEST_P(DistributeTest, superkmer_distribute)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  // kmers of a sequence in order, canonical, distributed by minimizer.
+  using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+  std::vector<KmerType> kmers;
+  KmerType km;
+  for (size_t i = 0; (this->data.size() > 0) && (i < this->data.size() + KmerType::size - 1); ++i) {
+    km.nextFromChar(this->data[i % this->data.size()].first & 0x3);
+    if ((i + 1) < KmerType::size) continue;
+    KmerType rc = km.reverse_complement();
+    kmers.push_back((rc < km) ? rc : km);
+  }
+  ::bliss::kmer::hash::minimizer<KmerType, true> hash;
+
+  int p = comm.size();
+  auto to_rank = [&p, &hash](KmerType const & x ){ return hash(x) % p; };
+  std::vector<KmerType> bucketed(kmers);
+  std::vector<size_t> send_counts = ::mxx::bucketing(bucketed, to_rank, p);
+  std::vector<KmerType> gold = ::mxx::all2allv(bucketed, send_counts, comm);
+
+  std::vector<size_t> recv_counts;
+  std::vector<KmerType> result;
+  imxx::superkmer_distribute(kmers, to_rank, recv_counts, result, comm);
+
+  // same kmers in the same order.
+  ASSERT_EQ(gold.size(), result.size());
+  EXPECT_TRUE(std::equal(gold.begin(), gold.end(), result.begin()));
+}
 
 
 TEST_P(DistributeTest, distribute_preserve_input_rt)
@@ -558,6 +758,489 @@ TEST_P(DistributeTest, scatter_compute_gather)
 
 
 
+// with preserve_input, input comes back unchanged and output is aligned to it.  also with all keys sent to rank 0, so that
+// most ranks receive fewer elements than they send, and rank 0 more.
+template <typename T, typename ToRank, typename SCG>
+void check_preserve_input(std::vector<T> const & data, ToRank const & to_rank, SCG const & scg, ::mxx::comm const & comm) {
+  std::vector<T> input(data);
+  std::vector<T> output;
+  std::vector<size_t> mapping;
+  std::vector<T> inbuf;
+  std::vector<T> outbuf;
+
+  scg(input, to_rank, copy<typename std::vector<T>::const_iterator, typename std::vector<T>::iterator>(),
+      mapping, output, inbuf, outbuf, comm, true);
+
+  bool same = (input == data);
+  if (data.size() > 0) same &= (output == data);
+  EXPECT_TRUE(same);
+}
+
+TEST_P(DistributeTest, scatter_compute_gather_preserve_input)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+  this->roundtripped.clear();
+
+  int p = comm.size();
+  auto scg = [](std::vector<T> & in, std::function<int(T const &)> const & to_rank,
+                copy<typename std::vector<T>::const_iterator, typename std::vector<T>::iterator> const & op,
+                std::vector<size_t> & i2o, std::vector<T> & out, std::vector<T> & inbuf, std::vector<T> & outbuf,
+                ::mxx::comm const & c, bool preserve) {
+    imxx::scatter_compute_gather(in, to_rank, op, i2o, out, inbuf, outbuf, c, preserve);
+  };
+  check_preserve_input(this->data, std::function<int(T const &)>([&p](T const & x){ return x.first % p; }), scg, comm);
+  check_preserve_input(this->data, std::function<int(T const &)>([](T const &){ return 0; }), scg, comm);
+}
+
+TEST_P(DistributeTest, scatter_compute_gather_auto)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+  this->roundtripped.clear();
+
+  int p = comm.size();
+  // free memory from ample to none, for automatic.
+  std::vector<std::pair<imxx::exchange_algorithm, size_t> > settings = {
+    {imxx::exchange_algorithm::full, 0UL}, {imxx::exchange_algorithm::two_part, 0UL},
+    {imxx::exchange_algorithm::lowmem, 0UL}, {imxx::exchange_algorithm::automatic, (1UL << 40)},
+    {imxx::exchange_algorithm::automatic, 0UL}
+  };
+  for (auto setting : settings) {
+    auto scg = [&setting](std::vector<T> & in, std::function<int(T const &)> const & to_rank,
+                  copy<typename std::vector<T>::const_iterator, typename std::vector<T>::iterator> const & op,
+                  std::vector<size_t> & i2o, std::vector<T> & out, std::vector<T> & inbuf, std::vector<T> & outbuf,
+                  ::mxx::comm const & c, bool preserve) {
+      imxx::scatter_compute_gather_auto(in, to_rank, op, i2o, out, inbuf, outbuf, c, setting.first, setting.second, preserve);
+    };
+    check_preserve_input(this->data, std::function<int(T const &)>([&p](T const & x){ return x.first % p; }), scg, comm);
+    check_preserve_input(this->data, std::function<int(T const &)>([](T const &){ return 0; }), scg, comm);
+  }
+}
+
+// thresholds of the automatic choice.  V and T are 16 bytes and SIZE is 8, so 72 bytes per element.
+TEST(SelectExchange, thresholds)
+{
+  ::mxx::comm comm;
+  using T = std::pair<size_t, int>;
+  size_t const n = 1UL << 20;
+  size_t const need = n * 72;
+
+  // small inputs use the full exchange even without free memory.
+  EXPECT_EQ(imxx::exchange_algorithm::full, (imxx::select_exchange<T, T>(1000, 0, comm)));
+
+  EXPECT_EQ(imxx::exchange_algorithm::full, (imxx::select_exchange<T, T>(n, 4 * need, comm)));
+  EXPECT_EQ(imxx::exchange_algorithm::two_part, (imxx::select_exchange<T, T>(n, need + need / 2, comm)));
+  EXPECT_EQ(imxx::exchange_algorithm::lowmem, (imxx::select_exchange<T, T>(n, need / 2, comm)));
+
+  // the largest input and the smallest free memory decide, on all ranks.
+  EXPECT_EQ(imxx::exchange_algorithm::lowmem,
+            (imxx::select_exchange<T, T>(n, (comm.rank() == 0) ? need / 2 : 4 * need, comm)));
+  EXPECT_EQ(imxx::exchange_algorithm::two_part,
+            (imxx::select_exchange<T, T>((comm.rank() == comm.size() - 1) ? n : 0, need + need / 2, comm)));
+}
+
+TEST(SparseExchange, matches_dense)
+{
+  ::mxx::comm comm;
+  int p = comm.size();
+  using T = std::pair<int, size_t>;
+
+  // each rank sends to at most 2 ranks.
+  std::vector<size_t> send_counts(p, 0);
+  send_counts[(comm.rank() + 1) % p] += 3;
+  send_counts[(comm.rank() * 3) % p] += comm.rank() % 2;
+  std::vector<T> input;
+  for (int i = 0; i < p; ++i)
+    for (size_t j = 0; j < send_counts[i]; ++j) input.emplace_back(comm.rank(), i * 100 + j);
+
+  std::vector<T> sparse;
+  std::vector<size_t> sparse_counts;
+  imxx::sparse_all2allv(input.data(), send_counts, sparse, sparse_counts, comm);
+
+  std::vector<size_t> recv_counts = mxx::all2all(send_counts, comm);
+  std::vector<T> dense = mxx::all2allv(input, send_counts, comm);
+
+  EXPECT_EQ(recv_counts, sparse_counts);
+  EXPECT_EQ(dense, sparse);
+
+  // again on the same communicator, with the cached duplicate, and nothing to send.
+  std::vector<size_t> none(p, 0);
+  imxx::sparse_all2allv(input.data(), none, sparse, sparse_counts, comm);
+  EXPECT_TRUE(sparse.empty());
+  EXPECT_EQ(std::vector<size_t>(p, 0), sparse_counts);
+}
+
+TEST(SparseExchange, back_to_back)
+{
+  ::mxx::comm comm;
+  int p = comm.size();
+  using T = std::pair<int, size_t>;
+
+  // rank s sends (s, it * 1000 + j) to rank (s + 1) % p and to rank (s + it) % p.  1 slow rank per round, so the others
+  // start the next exchange while it is still receiving.
+  auto counts_of = [p](int s, size_t it) {
+    std::vector<size_t> c(p, 0);
+    c[(s + 1) % p] += 1 + (s + it) % 3;
+    c[(s + it) % p] += it % 2;
+    return c;
+  };
+
+  std::vector<T> received;
+  std::vector<size_t> recv_counts;
+  for (size_t it = 0; it < 50; ++it) {
+    if (comm.rank() == static_cast<int>(it % p)) usleep(2000 + 1000 * (it % 3));
+
+    std::vector<size_t> send_counts = counts_of(comm.rank(), it);
+    std::vector<T> input;
+    for (int i = 0; i < p; ++i)
+      for (size_t j = 0; j < send_counts[i]; ++j) input.emplace_back(comm.rank(), it * 1000 + i * 10 + j);
+
+    imxx::sparse_all2allv(input.data(), send_counts, received, recv_counts, comm);
+
+    std::vector<T> expected;
+    std::vector<size_t> expected_counts(p, 0);
+    for (int s = 0; s < p; ++s) {
+      expected_counts[s] = counts_of(s, it)[comm.rank()];
+      for (size_t j = 0; j < expected_counts[s]; ++j) expected.emplace_back(s, it * 1000 + comm.rank() * 10 + j);
+    }
+    ASSERT_EQ(expected_counts, recv_counts) << "round " << it;
+    ASSERT_EQ(expected, received) << "round " << it;
+  }
+}
+
+TEST(SparseExchange, selection)
+{
+  ::mxx::comm comm;
+  int p = comm.size();
+  std::vector<size_t> one(p, 0);
+  one[(comm.rank() + 1) % p] = 1;
+  std::vector<size_t> all(p, 1);
+
+  unsetenv("BL_SPARSE_EXCHANGE");
+  EXPECT_FALSE(imxx::use_sparse_exchange(all, comm));
+  EXPECT_EQ(p >= imxx::sparse_exchange_min_ranks, imxx::use_sparse_exchange(one, comm));
+  // 1 dense rank makes all ranks use the dense exchange.
+  EXPECT_FALSE(imxx::use_sparse_exchange((comm.rank() == 0) ? all : one, comm));
+
+  setenv("BL_SPARSE_EXCHANGE", "1", 1);
+  EXPECT_EQ(p > 1, imxx::use_sparse_exchange(all, comm));
+  setenv("BL_SPARSE_EXCHANGE", "0", 1);
+  EXPECT_FALSE(imxx::use_sparse_exchange(one, comm));
+  unsetenv("BL_SPARSE_EXCHANGE");
+}
+
+TEST(BlockAll2AllPipelined, chunk_bytes)
+{
+  ::mxx::comm comm;
+
+  // tuned once per communicator, same on all ranks.
+  unsetenv("BL_A2A_CHUNK_BYTES");
+  size_t tuned = imxx::block_all2all_chunk_bytes(comm);
+  EXPECT_GE(tuned, imxx::block_a2a_chunk_min_bytes);
+  EXPECT_LE(tuned, imxx::block_a2a_chunk_max_bytes);
+  EXPECT_EQ(tuned, mxx::allreduce(tuned, mxx::max<size_t>(), comm));
+  EXPECT_EQ(tuned, imxx::block_all2all_chunk_bytes(comm));
+
+  setenv("BL_A2A_CHUNK_BYTES", "4096", 1);
+  EXPECT_EQ(4096UL, imxx::block_all2all_chunk_bytes(comm));
+  unsetenv("BL_A2A_CHUNK_BYTES");
+  EXPECT_EQ(tuned, imxx::block_all2all_chunk_bytes(comm));
+}
+
+TEST(BlockAll2AllPipelined, scatter_compute_gather_2part)
+{
+  ::mxx::comm comm;
+  int p = comm.size();
+  using T = std::pair<size_t, int>;
+
+  // 1000 per rank plus an uneven remainder, so the first part takes several 64 byte chunks.
+  std::vector<T> input;
+  for (size_t i = 0; i < 1000 + comm.rank() * 7; ++i) input.emplace_back(i * (comm.rank() + 1), comm.rank());
+
+  std::vector<size_t> i2o;
+  std::vector<size_t> output;
+  std::vector<T> in_buffer;
+  std::vector<size_t> out_buffer;
+  std::vector<T> query(input);
+
+  setenv("BL_A2A_CHUNK_BYTES", "64", 1);
+  imxx::scatter_compute_gather_2part(query, [&p](T const & x){ return (x.first / 3) % p; },
+                                     [&comm](std::vector<T>::iterator b, std::vector<T>::iterator e, std::vector<size_t>::iterator o){
+                                        for (; b != e; ++b, ++o) *o = b->first * 2 + comm.rank();
+                                     },
+                                     i2o, output, in_buffer, out_buffer, comm, false);
+  unsetenv("BL_A2A_CHUNK_BYTES");
+
+  ASSERT_EQ(input.size(), output.size());
+  bool same = true;
+  for (size_t i = 0; i < input.size(); ++i) {
+    same &= (output[i] == input[i].first * 2 + (input[i].first / 3) % p);
+  }
+  EXPECT_TRUE(same);
+}
+
+TEST_P(DistributeTest, sparse_distribute_rt)
+{
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // forced through the sparse exchange both ways.  the fixture checks against the dense results.
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  setenv("BL_SPARSE_EXCHANGE", "1", 1);
+  imxx::distribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+                   recv_counts, mapping, this->distributed, comm, false);
+  imxx::undistribute(this->distributed, recv_counts, mapping, this->roundtripped, comm, true);
+  unsetenv("BL_SPARSE_EXCHANGE");
+}
+
+TEST_P(DistributeTest, datatype_distribute_rt)
+{
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // through the struct datatype instead of raw bytes, both ways.
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  setenv("BL_RAW_BYTES_EXCHANGE", "0", 1);
+  imxx::distribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+                   recv_counts, mapping, this->distributed, comm, false);
+  imxx::undistribute(this->distributed, recv_counts, mapping, this->roundtripped, comm, true);
+  unsetenv("BL_RAW_BYTES_EXCHANGE");
+}
+
+TEST(RawBytesExchange, traits)
+{
+  using KmerType = bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+
+  EXPECT_TRUE((imxx::is_raw_exchangeable<std::pair<size_t, int> >::value));
+  EXPECT_TRUE((imxx::is_raw_exchangeable<std::pair<KmerType, uint32_t> >::value));
+  EXPECT_TRUE((imxx::is_raw_exchangeable<std::tuple<KmerType, uint8_t, uint32_t> >::value));
+  EXPECT_TRUE((imxx::is_raw_exchangeable<bliss::partition::range<size_t> >::value));
+  // builtin datatypes are already contiguous, and strings own memory.
+  EXPECT_FALSE((imxx::is_raw_exchangeable<size_t>::value));
+  EXPECT_FALSE((imxx::is_raw_exchangeable<std::string>::value));
+  EXPECT_FALSE((imxx::is_raw_exchangeable<std::tuple<KmerType, std::string> >::value));
+}
+
+TEST(RawBytesExchange, matches_datatype)
+{
+  ::mxx::comm comm;
+  int p = comm.size();
+  using KmerType = bliss::common::Kmer<31, bliss::common::DNA, uint64_t>;
+  using T = std::pair<KmerType, uint32_t>;
+
+  // a different count to each rank, none to the last.
+  std::vector<size_t> send_counts(p, 0);
+  std::vector<T> input;
+  for (int i = 0; i < p - 1; ++i) {
+    send_counts[i] = i + comm.rank() + 1;
+    for (size_t j = 0; j < send_counts[i]; ++j) {
+      KmerType km;
+      for (size_t c = 0; c < 2 * j + i + 1; ++c) km.nextFromChar(c % 4);
+      input.emplace_back(km, comm.rank() * 1000 + i * 10 + j);
+    }
+  }
+  std::vector<size_t> recv_counts = mxx::all2all(send_counts, comm);
+  size_t total = std::accumulate(recv_counts.begin(), recv_counts.end(), static_cast<size_t>(0));
+
+  std::vector<T> raw(total);
+  imxx::all2allv_raw(input.data(), send_counts, raw.data(), recv_counts, comm);
+
+  std::vector<T> dense(total);
+  mxx::all2allv(input.data(), send_counts, dense.data(), recv_counts, comm);
+
+  EXPECT_EQ(dense, raw);
+}
+
+TEST_P(DistributeTest, idistribute)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+
+  // copy data into roundtripped.
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  imxx::distribute_request<T, size_t> req;
+  imxx::idistribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+                   recv_counts, mapping, this->distributed, req, comm);
+
+  // every source block should be reported exactly once.
+  std::vector<int> seen(comm.size(), 0);
+  int src;
+  while ((src = req.wait_any()) >= 0) {
+    ++seen[src];
+    ASSERT_EQ(recv_counts[src], req.recv_count(src));
+  }
+  req.wait();
+
+  for (int i = 0; i < comm.size(); ++i) {
+    EXPECT_EQ((recv_counts[i] > 0) ? 1 : 0, seen[i]);
+  }
+
+  imxx::local::unpermute_inplace(this->roundtripped, mapping);
+
+}
+
+TEST_P(DistributeTest, idistribute_progress)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  this->roundtripped.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->roundtripped.begin());
+
+  int p = comm.size();
+  std::vector<size_t> recv_counts;
+  std::vector<size_t> mapping;
+
+  // the helper thread runs only with MPI_THREAD_MULTIPLE.  either way the exchange completes the same.
+  imxx::distribute_request<T, size_t> req;
+  req.set_progress(true);
+  imxx::idistribute(this->roundtripped, [&p](T const & x ){ return x.first % p; },
+                   recv_counts, mapping, this->distributed, req, comm);
+  EXPECT_EQ(imxx::progress_thread::supported(), req.progress_active());
+
+  size_t received = 0;
+  int src;
+  while ((src = req.wait_any()) >= 0) received += req.recv_count(src);
+  req.wait();
+  EXPECT_FALSE(req.progress_active());
+  EXPECT_EQ(this->distributed.size(), received);
+
+  for (size_t i = 0; i < this->distributed.size(); ++i) {
+    EXPECT_EQ(comm.rank(), static_cast<int>(this->distributed[i].first % p));
+  }
+
+  imxx::local::unpermute_inplace(this->roundtripped, mapping);
+  EXPECT_TRUE(std::equal(this->data.begin(), this->data.end(), this->roundtripped.begin()));
+}
+
+TEST_P(DistributeTest, distribute_channels)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  int p = comm.size();
+  auto to_rank = [&p](T const & x ){ return x.first % p; };
+
+  for (size_t nch : { 1UL, 3UL }) {
+    std::vector<T> input(this->data.begin(), this->data.end());
+    auto to_channel = [&p, nch](T const & x ){ return (x.first / p) % nch; };
+
+    imxx::channel_comms channels(comm, nch);
+    std::vector<std::vector<T> > outputs;
+    imxx::distribute_channels(input, to_rank, to_channel, channels, outputs, comm);
+    ASSERT_EQ(nch, outputs.size());
+
+    // each element arrives once, at its rank, on its channel.
+    size_t received = 0;
+    for (size_t c = 0; c < nch; ++c) {
+      for (auto const & x : outputs[c]) {
+        EXPECT_EQ(comm.rank(), static_cast<int>(to_rank(x)));
+        EXPECT_EQ(c, static_cast<size_t>(to_channel(x)));
+      }
+      received += outputs[c].size();
+    }
+    EXPECT_EQ(::mxx::allreduce(this->data.size(), comm), ::mxx::allreduce(received, comm));
+
+    // same elements as distribute.
+    std::vector<T> all;
+    for (auto const & o : outputs) all.insert(all.end(), o.begin(), o.end());
+    std::vector<T> gold(this->data.begin(), this->data.end());
+    std::vector<size_t> recv_counts;
+    std::vector<size_t> mapping;
+    std::vector<T> distributed;
+    imxx::distribute(gold, to_rank, recv_counts, mapping, distributed, comm);
+    std::sort(all.begin(), all.end());
+    std::sort(distributed.begin(), distributed.end());
+    EXPECT_TRUE(all == distributed);
+  }
+}
+
+TEST_P(DistributeTest, scatter_compute_gather_overlap)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+
+  // copy data into roundtripped.
+  this->roundtripped.resize(this->data.size());
+
+  this->distributed.resize(this->data.size());
+  std::copy(this->data.begin(), this->data.end(), this->distributed.begin());
+
+
+  // distribute
+  int p = comm.size();
+  std::vector<size_t> mapping;
+
+  std::vector<T> inbuf;
+  std::vector<T> outbuf;
+
+  imxx::scatter_compute_gather_overlap(this->distributed, [&p](T const & x ){ return x.first % p; },
+                               copy<typename std::vector<T>::const_iterator,
+                                    typename std::vector<T>::iterator>(),
+                   mapping, this->roundtripped, inbuf, outbuf, comm, false);
+
+  this->distributed.clear();
+
+  imxx::local::unpermute_inplace(this->roundtripped, mapping);
+
+}
+
+TEST_P(DistributeTest, scatter_compute_gather_overlap_preserve_input)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+  this->roundtripped.clear();
+
+  int p = comm.size();
+  auto scg = [](std::vector<T> & in, std::function<int(T const &)> const & to_rank,
+                copy<typename std::vector<T>::const_iterator, typename std::vector<T>::iterator> const & op,
+                std::vector<size_t> & i2o, std::vector<T> & out, std::vector<T> & inbuf, std::vector<T> & outbuf,
+                ::mxx::comm const & c, bool preserve) {
+    imxx::scatter_compute_gather_overlap(in, to_rank, op, i2o, out, inbuf, outbuf, c, preserve);
+  };
+  check_preserve_input(this->data, std::function<int(T const &)>([&p](T const & x){ return x.first % p; }), scg, comm);
+  check_preserve_input(this->data, std::function<int(T const &)>([](T const &){ return 0; }), scg, comm);
+}
+
+
 INSTANTIATE_TEST_CASE_P(Bliss, DistributeTest, ::testing::Values(
     // base cases
     DistributeTestInfo(0UL),   //  0, boundary case
@@ -771,6 +1454,23 @@ TEST_P(Distribute2PartTest, distribute_2part)
 
 
 
+TEST_P(Distribute2PartTest, distribute_inplace)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+
+  // same blocks and remainders as distribute_2part, without a second buffer.
+  this->distributed.assign(this->data.begin(), this->data.end());
+
+  int p = comm.size();
+  imxx::distribute_inplace(this->distributed, [&p](T const & x ){ return x.first % p; }, comm);
+
+  this->roundtripped.clear();
+}
+
+
 TEST_P(Distribute2PartTest, distribute_preserve_input_2part_rt)
 {
 
@@ -885,6 +1585,45 @@ TEST_P(Distribute2PartTest, scatter_compute_gather_lowmem)
 
 
 
+TEST_P(Distribute2PartTest, scatter_compute_gather_2part_preserve_input)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+  this->roundtripped.clear();
+
+  int p = comm.size();
+  auto scg = [](std::vector<T> & in, std::function<int(T const &)> const & to_rank,
+                copy<typename std::vector<T>::const_iterator, typename std::vector<T>::iterator> const & op,
+                std::vector<size_t> & i2o, std::vector<T> & out, std::vector<T> & inbuf, std::vector<T> & outbuf,
+                ::mxx::comm const & c, bool preserve) {
+    imxx::scatter_compute_gather_2part(in, to_rank, op, i2o, out, inbuf, outbuf, c, preserve);
+  };
+  check_preserve_input(this->data, std::function<int(T const &)>([&p](T const & x){ return x.first % p; }), scg, comm);
+  check_preserve_input(this->data, std::function<int(T const &)>([](T const &){ return 0; }), scg, comm);
+}
+
+TEST_P(Distribute2PartTest, scatter_compute_gather_lowmem_preserve_input)
+{
+
+  ::mxx::comm comm;
+
+  this->init(comm);
+  this->roundtripped.clear();
+
+  int p = comm.size();
+  auto scg = [](std::vector<T> & in, std::function<int(T const &)> const & to_rank,
+                copy<typename std::vector<T>::const_iterator, typename std::vector<T>::iterator> const & op,
+                std::vector<size_t> & i2o, std::vector<T> & out, std::vector<T> & inbuf, std::vector<T> & outbuf,
+                ::mxx::comm const & c, bool preserve) {
+    imxx::scatter_compute_gather_lowmem(in, to_rank, op, i2o, out, inbuf, outbuf, c, preserve);
+  };
+  check_preserve_input(this->data, std::function<int(T const &)>([&p](T const & x){ return x.first % p; }), scg, comm);
+  check_preserve_input(this->data, std::function<int(T const &)>([](T const &){ return 0; }), scg, comm);
+}
+
+
 INSTANTIATE_TEST_CASE_P(Bliss, Distribute2PartTest, ::testing::Values(
     // base cases
     Distribute2PartTestInfo(0UL),   //  0, boundary case
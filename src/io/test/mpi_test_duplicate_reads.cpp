@@ -0,0 +1,146 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_duplicate_reads.cpp
+ *   reads a FASTQ file twice as one input with duplicate removal, and compares to the file read once.
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "io/kmer_parser.hpp"
+#include "io/kmer_file_helper.hpp"
+#include "io/sequence_iterator.hpp"
+#include "io/duplicate_reads.hpp"
+
+
+class DuplicateReadsTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA5, uint64_t>;
+    using KmerParserType = ::bliss::index::kmer::KmerParser<KmerType>;
+    using FileType = ::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, ::bliss::io::FASTQParser>;
+
+    std::string fileName;
+
+    virtual void SetUp()
+    {
+      fileName.assign(PROJ_SRC_DIR);
+      fileName.append(GetParam());
+    }
+
+    /// order independent checksum of the kmers of all ranks.
+    static uint64_t checksum(std::vector<KmerType> const & kmers, ::mxx::comm const & comm) {
+      uint64_t sum = 0;
+      for (auto const & k : kmers) sum += ::bliss::utils::mix64(k.getData()[0]);
+      return ::mxx::allreduce(sum, comm);
+    }
+};
+
+
+TEST_P(DuplicateReadsTest, repeated_file)
+{
+  ::mxx::comm comm;
+
+  std::vector<KmerType> once;
+  std::pair<size_t, size_t> read_once =
+      ::bliss::io::KmerFileHelper::read_file_mmap<KmerParserType, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, once, comm, true);
+
+  std::vector<KmerType> all;
+  std::pair<size_t, size_t> read_all =
+      ::bliss::io::KmerFileHelper::read_file_mmap<KmerParserType, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(fileName, all, comm);
+
+  // dedup only removes.
+  EXPECT_LE(::mxx::allreduce(read_once.first, comm), ::mxx::allreduce(read_all.first, comm));
+  EXPECT_LE(::mxx::allreduce(read_once.second, comm), ::mxx::allreduce(read_all.second, comm));
+
+  // the second copy of the file is all duplicates.
+  std::vector<std::string> twice = { fileName, fileName };
+  std::vector<KmerType> dedup;
+  std::pair<size_t, size_t> read_twice =
+      ::bliss::io::KmerFileHelper::read_files<KmerParserType, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(twice, dedup, comm, true);
+
+  EXPECT_EQ(::mxx::allreduce(read_once.first, comm), ::mxx::allreduce(read_twice.first, comm));
+  EXPECT_EQ(::mxx::allreduce(read_once.second, comm), ::mxx::allreduce(read_twice.second, comm));
+  EXPECT_EQ(checksum(once, comm), checksum(dedup, comm));
+
+  // and without dedup, all are kept.
+  std::vector<KmerType> both;
+  std::pair<size_t, size_t> read_both =
+      ::bliss::io::KmerFileHelper::read_files<KmerParserType, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(twice, both, comm);
+  EXPECT_EQ(2 * ::mxx::allreduce(read_all.second, comm), ::mxx::allreduce(read_both.second, comm));
+}
+
+TEST_P(DuplicateReadsTest, pairs)
+{
+  ::mxx::comm comm;
+
+  FileType fobj(fileName, KmerType::size - 1, comm);
+  ::bliss::io::file_data partition = fobj.read_file();
+
+  ::bliss::io::FASTQParser<typename ::bliss::io::file_data::const_iterator> seq_parser;
+  seq_parser.init_parser(partition.in_mem_cbegin(), partition.parent_range_bytes, partition.in_mem_range_bytes, partition.getRange(), comm);
+
+  std::vector<size_t> reads = ::bliss::io::find_duplicate_reads<::bliss::io::FASTQParser>(partition, seq_parser, comm);
+
+  // each read as its own mate:  a pair repeats exactly when its read does.
+  std::vector<size_t> pairs = ::bliss::io::find_duplicate_pairs<::bliss::io::FASTQParser>(partition, seq_parser, partition, seq_parser, comm);
+  EXPECT_EQ(reads, pairs);
+
+  // the offsets are those of local reads.
+  for (size_t offset : reads) {
+    EXPECT_LE(partition.getRange().start, offset);
+    EXPECT_GT(partition.valid_range_bytes.end, offset);
+  }
+}
+
+
+INSTANTIATE_TEST_CASE_P(Bliss, DuplicateReadsTest, ::testing::Values(
+    std::string("/test/data/natural.fastq"),
+    std::string("/test/data/test.debruijn.tiny.fastq"),
+    std::string("/test/data/test.medium.fastq")
+    ));
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
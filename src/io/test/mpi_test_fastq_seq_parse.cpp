@@ -35,6 +35,8 @@
 #include <string>
 #include <limits>
 #include <chrono>
+#include <vector>
+#include <algorithm>
 
 #include "common/sequence.hpp"
 #include "io/sequence_iterator.hpp"
@@ -47,6 +49,7 @@
 
 #include "io/fastq_loader.hpp"
 #include "io/file.hpp"
+#include "io/read_partition.hpp"
 
 #include "utils/benchmark_utils.hpp"
 
@@ -394,6 +397,52 @@ TEST_P(FASTQParseTest, parse_posix)
 
 }
 
+// the record cursor returns the records of SequencesIterator, in batches that do not divide the record count.
+TEST_P(FASTQParseTest, record_cursor)
+{
+#ifdef USE_MPI
+	  ::mxx::comm comm;
+	if (comm.rank() == 0) {
+#endif
+
+    bliss::io::mmap_file fobj(this->fileName);
+    bliss::io::file_data fdata = fobj.read_file();
+
+    using BlockIterType = typename ::bliss::io::file_data::const_iterator;
+    using SeqIterType = ::bliss::io::SequencesIterator<BlockIterType, bliss::io::FASTQParser >;
+    using CursorType = ::bliss::io::SequenceRecordCursor<BlockIterType, bliss::io::FASTQParser >;
+
+    ParserType<BlockIterType> l1parser;
+    size_t offset = l1parser.init_parser(fdata.in_mem_cbegin(), fdata.parent_range_bytes, fdata.in_mem_range_bytes, fdata.valid_range_bytes);
+
+    std::vector<typename CursorType::SequenceType> gold;
+    SeqIterType seqs_start(l1parser, fdata.begin(), fdata.in_mem_end(), offset);
+    SeqIterType seqs_end(fdata.in_mem_end());
+    for (; seqs_start != seqs_end; ++seqs_start) gold.push_back(*seqs_start);
+    ASSERT_LT(7UL, gold.size());
+
+    CursorType cursor(l1parser, fdata.begin(), fdata.in_mem_end(), offset);
+    std::vector<typename CursorType::SequenceType> records(7);
+    size_t i = 0, n;
+    while ((n = cursor.next_batch(records)) > 0) {
+      for (size_t j = 0; j < n; ++j, ++i) {
+        ASSERT_LT(i, gold.size());
+        EXPECT_EQ(gold[i].id.get_pos(), records[j].id.get_pos());
+        EXPECT_EQ(gold[i].seq_global_offset(), records[j].seq_global_offset());
+        EXPECT_EQ(gold[i].seq_size(), records[j].seq_size());
+        EXPECT_TRUE(gold[i].qual_begin == records[j].qual_begin);
+      }
+    }
+    EXPECT_EQ(gold.size(), i);
+    EXPECT_TRUE(cursor.at_end());
+    EXPECT_EQ(0UL, cursor.next_batch(records));
+
+#ifdef USE_MPI
+	}
+#endif
+
+}
+
 #ifdef USE_MPI
 TEST_P(FASTQParseTest, parse_mmap_mpi)
 {
@@ -438,6 +487,52 @@ TEST_P(FASTQParseTest, parse_mpiio_mpi)
 
 	  comm.barrier();
 }
+
+TEST_P(FASTQParseTest, read_partition_mpi)
+{
+  ::mxx::comm comm;
+  using KmerType = bliss::common::Kmer<21, bliss::common::DNA, uint64_t>;
+  using PartitionType = ::bliss::index::kmer::MinimizerReadPartition<KmerType>;
+
+  // gold:  the reads of the whole file that this rank owns, as sequence and quality.
+  bliss::io::mmap_file fobj(this->fileName);
+  bliss::io::file_data fdata = fobj.read_file();
+
+  using BlockIterType = typename ::bliss::io::file_data::const_iterator;
+  using SeqIterType = ::bliss::io::SequencesIterator<BlockIterType, bliss::io::FASTQParser >;
+
+  ParserType<BlockIterType> l1parser;
+  size_t offset = l1parser.init_parser(fdata.in_mem_cbegin(), fdata.parent_range_bytes, fdata.in_mem_range_bytes, fdata.valid_range_bytes);
+
+  PartitionType::parser_type parser(fdata.valid_range_bytes);
+  std::vector<uint64_t> packed;
+  ::fsc::back_emplace_iterator<std::vector<uint64_t> > emplace_iter(packed);
+  SeqIterType seqs_start(l1parser, fdata.begin(), fdata.in_mem_end(), offset);
+  SeqIterType seqs_end(fdata.in_mem_end());
+  for (; seqs_start != seqs_end; ++seqs_start) emplace_iter = parser(*seqs_start, emplace_iter);
+
+  PartitionType all;
+  all.assign(std::move(packed));
+  std::vector<std::string> gold;
+  for (size_t i = 0; i < all.reads(); ++i) {
+    if (PartitionType::owner(all.minimizer(i), comm.size()) == comm.rank()) gold.push_back(all.sequence(i) + all.quality(i));
+  }
+  std::sort(gold.begin(), gold.end());
+
+  PartitionType part;
+  part.template read_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(this->fileName, comm);
+
+  std::vector<std::string> binned;
+  for (size_t i = 0; i < part.reads(); ++i) {
+    EXPECT_EQ(comm.rank(), PartitionType::owner(part.minimizer(i), comm.size()));
+    EXPECT_TRUE(part.has_quality(i));
+    binned.push_back(part.sequence(i) + part.quality(i));
+  }
+  std::sort(binned.begin(), binned.end());
+
+  EXPECT_EQ(all.reads(), mxx::allreduce(part.reads(), comm));
+  EXPECT_EQ(gold, binned);
+}
 #endif
 
 
@@ -44,6 +44,7 @@
 #include "io/fastq_loader.hpp"
 #include "io/fasta_loader.hpp"
 #include "io/file.hpp"
+#include "io/direct_file.hpp"
 
 
 
@@ -138,7 +139,8 @@ REGISTER_TYPED_TEST_CASE_P(FileSequentialLoadTest,
 typedef ::testing::Types<
 		bliss::io::mmap_file,
 		bliss::io::stdio_file,
-		bliss::io::posix_file
+		bliss::io::posix_file,
+		bliss::io::direct_file
 > FileSequentialLoadTestTypes;
 
 //typedef ::testing::Types< FileLoader<unsigned char, 0, bliss::io::BaseFileParser, false, false> > FileSequentialLoadTestTypes;
@@ -245,20 +247,63 @@ typedef ::testing::Types<
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file,  ::bliss::io::BaseFileParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::stdio_file, ::bliss::io::BaseFileParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::BaseFileParser >, std::integral_constant<size_t, 0> >,
+	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::direct_file, ::bliss::io::BaseFileParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file,  ::bliss::io::BaseFileParser , ::bliss::io::parallel::base_shared_fd_file>, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::BaseFileParser , ::bliss::io::parallel::base_shared_fd_file>, std::integral_constant<size_t, 0> >,
+	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::BaseFileParser , ::bliss::io::parallel::base_node_shared_file>, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::mpiio_file<::bliss::io::BaseFileParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file,  ::bliss::io::FASTAParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::stdio_file, ::bliss::io::FASTAParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTAParser >, std::integral_constant<size_t, 0> >,
+	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::direct_file, ::bliss::io::FASTAParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file,  ::bliss::io::FASTAParser , ::bliss::io::parallel::base_shared_fd_file>,  std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTAParser , ::bliss::io::parallel::base_shared_fd_file>,  std::integral_constant<size_t, 0> >,
+	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTAParser , ::bliss::io::parallel::base_node_shared_file>,  std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::mpiio_file<::bliss::io::FASTAParser >, std::integral_constant<size_t, 0> >
 > FileMPILoadTestTypes;
 
 INSTANTIATE_TYPED_TEST_CASE_P(Bliss, FileMPILoadTest, FileMPILoadTestTypes);
 
 
+// overlap from the next process should give the same data as reading the overlap.
+template <typename file_type>
+void compare_overlap_exchange(std::string const & fileName, size_t const overlap) {
+  ::mxx::comm comm;
+
+  file_type fread(fileName, overlap, comm);
+  fread.set_overlap_exchange(false);
+  ::bliss::io::file_data expected = fread.read_file();
+
+  file_type fexch(fileName, overlap, comm);
+  fexch.set_overlap_exchange(true);
+  ::bliss::io::file_data exchanged = fexch.read_file();
+
+  EXPECT_EQ(expected.valid_range_bytes, exchanged.valid_range_bytes);
+  EXPECT_EQ(expected.in_mem_range_bytes, exchanged.in_mem_range_bytes);
+  EXPECT_TRUE(expected.data == exchanged.data);
+
+  comm.barrier();
+}
+
+TEST(FileMPIOverlapExchange, base)
+{
+  std::string fileName(PROJ_SRC_DIR);
+  fileName.append("/test/data/test.medium.fasta");
+
+  compare_overlap_exchange<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::BaseFileParser > >(fileName, 30);
+  compare_overlap_exchange<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::BaseFileParser , ::bliss::io::parallel::base_shared_fd_file> >(fileName, 30);
+}
+
+TEST(FileMPIOverlapExchange, fasta)
+{
+  std::string fileName(PROJ_SRC_DIR);
+  fileName.append("/test/data/test.medium.fasta");
+
+  compare_overlap_exchange<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTAParser > >(fileName, 30);
+  compare_overlap_exchange<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTAParser , ::bliss::io::parallel::base_node_shared_file> >(fileName, 30);
+}
+
+
 
 template <typename file_loader>
 class FASTQMPILoadTest : public FileLoaderTest
@@ -347,8 +392,10 @@ typedef ::testing::Types<
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file,  ::bliss::io::FASTQParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::stdio_file, ::bliss::io::FASTQParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTQParser >, std::integral_constant<size_t, 0> >,
+	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::direct_file, ::bliss::io::FASTQParser >, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file,  ::bliss::io::FASTQParser , ::bliss::io::parallel::base_shared_fd_file>, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTQParser , ::bliss::io::parallel::base_shared_fd_file>, std::integral_constant<size_t, 0> >,
+	std::pair<::bliss::io::parallel::partitioned_file<::bliss::io::posix_file, ::bliss::io::FASTQParser , ::bliss::io::parallel::base_node_shared_file>, std::integral_constant<size_t, 0> >,
 	std::pair<::bliss::io::parallel::mpiio_file<::bliss::io::FASTQParser >, std::integral_constant<size_t, 0> >
 > FASTQMPILoadTestTypes;
 
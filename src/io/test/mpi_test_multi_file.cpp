@@ -0,0 +1,150 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_multi_file.cpp
+ *   reads lists of test files as one input, and compares to their concatenation.
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+
+#include "io/file_loader.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/fasta_loader.hpp"
+#include "io/file.hpp"
+#include "io/multi_file.hpp"
+
+
+template <typename file_loader>
+class MultiFileTest : public ::testing::Test
+{
+  protected:
+    std::vector<std::string> fileNames;
+    std::vector<unsigned char> ref;
+
+    virtual void SetUp()
+    {
+      // different sizes, so the partitions cross file boundaries.
+      std::vector<std::string> names;
+      if (std::is_same<file_loader, ::bliss::io::parallel::multi_file<::bliss::io::FASTAParser> >::value) {
+        names = { "test.fasta", "natural.fasta", "test2.fasta", "test.medium.fasta" };
+      } else {
+        names = { "test.small.fastq", "test.medium.fastq", "test.debruijn.tiny.fastq", "test.unitiq1.fastq", "natural.fastq" };
+      }
+
+      for (auto const & name : names) {
+        fileNames.push_back(std::string(PROJ_SRC_DIR) + "/test/data/" + name);
+
+        std::ifstream ifs(fileNames.back(), std::ios::binary);
+        ref.insert(ref.end(), std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+      }
+    }
+};
+
+// indicate this is a typed test
+TYPED_TEST_CASE_P(MultiFileTest);
+
+
+TYPED_TEST_P(MultiFileTest, read)
+{
+  ::mxx::comm comm;
+  TypeParam fobj(this->fileNames, 30, comm);
+  EXPECT_EQ(this->ref.size(), fobj.size());
+  EXPECT_EQ(this->fileNames.size() + 1, fobj.get_offsets().size());
+
+  ::bliss::io::file_data fdata = fobj.read_file();
+  EXPECT_EQ(this->ref.size(), fdata.parent_range_bytes.size());
+
+  // data matches the concatenated files
+  ASSERT_EQ(fdata.in_mem_range_bytes.size(), fdata.data.size());
+  ASSERT_LE(fdata.in_mem_range_bytes.end, this->ref.size());
+  EXPECT_TRUE(std::equal(fdata.data.begin(), fdata.data.end(), this->ref.begin() + fdata.in_mem_range_bytes.start));
+
+  // complete coverage, no double counting
+  EXPECT_EQ(this->ref.size(), ::mxx::allreduce(fdata.valid_range_bytes.size(), comm));
+  EXPECT_LE(fdata.in_mem_range_bytes.start, fdata.valid_range_bytes.start);
+  EXPECT_LE(fdata.valid_range_bytes.end, fdata.in_mem_range_bytes.end);
+
+  // fastq partitions start at a record.
+  if (std::is_same<TypeParam, ::bliss::io::parallel::multi_file<::bliss::io::FASTQParser> >::value) {
+    if (fdata.valid_range_bytes.size() > 0) {
+      EXPECT_EQ('@', this->ref[fdata.valid_range_bytes.start]);
+    }
+  }
+}
+
+TYPED_TEST_P(MultiFileTest, bad_files)
+{
+  ::mxx::comm comm;
+
+  // missing file.  all ranks throw.
+  std::vector<std::string> names = this->fileNames;
+  names.push_back(std::string(PROJ_SRC_DIR) + "/test/data/no_such_file.fastq");
+  EXPECT_THROW(TypeParam(names, 30, comm), ::bliss::io::IOException);
+
+  // a file without a final newline cannot be followed by another.
+  names = this->fileNames;
+  names.insert(names.begin(), std::string(PROJ_SRC_DIR) + "/test/data/test.unitiqs.fasta");
+  EXPECT_THROW(TypeParam(names, 30, comm), ::bliss::io::IOException);
+
+  // but can be last.
+  names = this->fileNames;
+  names.push_back(std::string(PROJ_SRC_DIR) + "/test/data/test.unitiqs.fasta");
+  EXPECT_NO_THROW(TypeParam(names, 30, comm));
+}
+
+
+// now register the test cases
+REGISTER_TYPED_TEST_CASE_P(MultiFileTest, read, bad_files);
+
+
+typedef ::testing::Types<
+    ::bliss::io::parallel::multi_file<::bliss::io::BaseFileParser>,
+    ::bliss::io::parallel::multi_file<::bliss::io::FASTQParser>,
+    ::bliss::io::parallel::multi_file<::bliss::io::FASTAParser>
+> MultiFileTestTypes;
+INSTANTIATE_TYPED_TEST_CASE_P(Bliss, MultiFileTest, MultiFileTestTypes);
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_paired_file.cpp
+ *   reads a pair of FASTQ files and checks that every rank has both mates of its reads.
+ *   R2 is written by rank 0 from R1, with reads of varying lengths so that the byte partitions of R1 and R2 differ.
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdio>   // remove
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+
+#include "io/file_loader.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/file.hpp"
+#include "io/paired_file.hpp"
+
+
+class PairedFileTest : public ::testing::Test
+{
+  protected:
+    std::string fileName1;
+    std::string fileName2;
+    std::vector<unsigned char> ref2;
+
+    virtual void SetUp()
+    {
+      fileName1.assign(PROJ_SRC_DIR);
+      fileName1.append("/test/data/test.medium.fastq");
+      fileName2.assign(PROJ_BIN_DIR);
+      fileName2.append("/test.paired.medium_2.fastq");
+
+      ::mxx::comm comm;
+      if (comm.rank() == 0) {
+        std::ifstream ifs(fileName1);
+        std::ofstream ofs(fileName2);
+        std::string lines[4];
+        for (size_t k = 0; std::getline(ifs, lines[0]) && std::getline(ifs, lines[1]) &&
+                           std::getline(ifs, lines[2]) && std::getline(ifs, lines[3]); ++k) {
+          size_t len = (k % 40) + 10;
+          ofs << lines[0] << "\n" << lines[1].substr(0, len) << "\n+\n" << lines[3].substr(0, len) << "\n";
+        }
+      }
+      comm.barrier();
+
+      std::ifstream ifs(fileName2, std::ios::binary);
+      ref2.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+
+    virtual void TearDown()
+    {
+      ::mxx::comm comm;
+      comm.barrier();
+      if (comm.rank() == 0) remove(fileName2.c_str());
+    }
+};
+
+
+TEST_F(PairedFileTest, read)
+{
+  ::mxx::comm comm;
+  ::bliss::io::parallel::paired_file<> fobj(this->fileName1, this->fileName2, comm);
+  std::pair<::bliss::io::file_data, ::bliss::io::file_data> fdata = fobj.read_file();
+
+  std::vector<size_t> offsets1 = ::bliss::io::parallel::paired_file<>::record_offsets(fdata.first);
+  std::vector<size_t> offsets2 = ::bliss::io::parallel::paired_file<>::record_offsets(fdata.second);
+  ASSERT_EQ(offsets1.size(), offsets2.size());
+
+  // R2 data is contiguous in the file
+  ASSERT_EQ(fdata.second.data.size(), fdata.second.valid_range_bytes.size());
+  ASSERT_LE(fdata.second.valid_range_bytes.end, this->ref2.size());
+  EXPECT_TRUE(std::equal(fdata.second.data.begin(), fdata.second.data.end(), this->ref2.begin() + fdata.second.valid_range_bytes.start));
+
+  // every read and its mate have the same name.
+  for (size_t i = 0; i + 1 < offsets1.size(); ++i) {
+    auto it1 = fdata.first.data.cbegin() + (offsets1[i] - fdata.first.in_mem_range_bytes.start);
+    auto it2 = fdata.second.data.cbegin() + (offsets2[i] - fdata.second.in_mem_range_bytes.start);
+    std::string name1(it1, std::find(it1, fdata.first.data.cend(), '\n'));
+    std::string name2(it2, std::find(it2, fdata.second.data.cend(), '\n'));
+    EXPECT_EQ(name1, name2);
+  }
+
+  // all reads are assigned.
+  EXPECT_EQ(this->ref2.size(), ::mxx::allreduce(fdata.second.valid_range_bytes.size(), comm));
+}
+
+TEST_F(PairedFileTest, mismatched)
+{
+  ::mxx::comm comm;
+  // different number of reads.  all ranks throw.
+  ::bliss::io::parallel::paired_file<> fobj(this->fileName1, std::string(PROJ_SRC_DIR) + "/test/data/test.small.fastq", comm);
+  EXPECT_THROW(fobj.read_file(), ::bliss::io::IOException);
+}
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_record_index.cpp
+ *   reads FASTQ files with the record index, and compares the records to the boundary search.
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/collective.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <cstdio>      // remove
+#include <algorithm>   // lower_bound, is_sorted, max_element
+
+#include "io/fastq_loader.hpp"
+#include "io/sequence_iterator.hpp"
+#include "io/file.hpp"
+#include "io/record_index.hpp"
+
+using FileType = ::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, ::bliss::io::FASTQParser>;
+
+
+class RecordIndexTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    std::string fileName;
+
+    /// copy of the data file in the build directory, so the index can be written.
+    virtual void SetUp()
+    {
+      ::mxx::comm comm;
+      std::string src(PROJ_SRC_DIR);
+      src.append(GetParam());
+      fileName.assign(PROJ_BIN_DIR);
+      fileName.append("/record_index_test.fastq");
+
+      if (comm.rank() == 0) {
+        std::ifstream ifs(src, std::ios::binary);
+        std::ofstream ofs(fileName, std::ios::binary | std::ios::trunc);
+        ofs << ifs.rdbuf();
+      }
+      comm.barrier();
+    }
+
+    virtual void TearDown()
+    {
+      ::mxx::comm comm;
+      comm.barrier();
+      if (comm.rank() == 0) {
+        remove(::bliss::io::record_index_file_name(fileName).c_str());
+        remove(fileName.c_str());
+      }
+    }
+
+    /// start offsets of the records in the valid range, and optionally their sequence lengths.
+    static std::vector<size_t> local_records(::bliss::io::file_data const & part, std::vector<size_t> * lengths = nullptr) {
+      using CharIterType = ::bliss::io::file_data::const_iterator;
+
+      std::vector<size_t> starts;
+      if (part.valid_range_bytes.size() == 0) return starts;
+
+      ::bliss::io::FASTQParser<CharIterType> parser;
+      parser.init_parser(part.in_mem_cbegin(), part.parent_range_bytes, part.in_mem_range_bytes, part.valid_range_bytes);
+      ::bliss::io::SequencesIterator<CharIterType, ::bliss::io::FASTQParser> it(parser, part.cbegin(), part.in_mem_cend(), part.valid_range_bytes.start);
+      ::bliss::io::SequencesIterator<CharIterType, ::bliss::io::FASTQParser> end(part.in_mem_cend());
+      for (; it != end; ++it) {
+        if ((*it).id.get_pos() >= part.valid_range_bytes.end) break;
+        starts.push_back((*it).id.get_pos());
+        if (lengths != nullptr) lengths->push_back(std::distance((*it).seq_begin, (*it).seq_end));
+      }
+      return starts;
+    }
+
+    /// read with the given stride, and check that the records are the same as gold.
+    static void check(std::string const & filename, size_t stride, std::vector<size_t> const & gold, bool indexed) {
+      ::mxx::comm comm;
+      FileType fobj(filename, 0, comm);
+      fobj.set_record_index_stride(stride);
+      ::bliss::io::file_data part = fobj.read_file();
+
+      std::vector<size_t> local = local_records(part);
+      std::vector<size_t> all = ::mxx::allgatherv(local, comm);
+
+      ASSERT_EQ(gold.size(), all.size());
+      for (size_t i = 0; i < gold.size(); ++i) {
+        EXPECT_EQ(gold[i], all[i]);
+      }
+
+      if (indexed) {
+        // partitions start at records, and the first record id is the global ordinal.
+        if (local.size() > 0) {
+          EXPECT_EQ(part.valid_range_bytes.start, (comm.rank() == 0) ? 0 : local.front());
+          size_t id = std::lower_bound(gold.begin(), gold.end(), local.front()) - gold.begin();
+          EXPECT_EQ(id, fobj.first_record_id());
+        }
+      } else {
+        EXPECT_EQ(std::numeric_limits<size_t>::max(), fobj.first_record_id());
+      }
+    }
+};
+
+
+TEST_P(RecordIndexTest, build_and_use)
+{
+  ::mxx::comm comm;
+
+  std::vector<size_t> gold;
+  {
+    FileType fobj(fileName, 0, comm);
+    fobj.set_record_index_stride(0);
+    ::bliss::io::file_data part = fobj.read_file();
+    gold = ::mxx::allgatherv(local_records(part), comm);
+  }
+  ASSERT_GT(gold.size(), 0UL);
+
+  // first read writes the index.
+  check(fileName, 7, gold, false);
+
+  ::bliss::io::record_index index;
+  ASSERT_TRUE(index.load(fileName));
+  EXPECT_EQ(gold.size(), index.records());
+  EXPECT_EQ(7UL, index.get_stride());
+  ASSERT_EQ((gold.size() + 6) / 7, index.size());
+  for (size_t i = 0; i < index.size(); ++i) {
+    EXPECT_EQ(gold[i * 7], index.samples()[i]);
+  }
+  EXPECT_EQ(0UL, index.sample_bases()[0]);
+  EXPECT_TRUE(std::is_sorted(index.sample_bases(), index.sample_bases() + index.size()));
+  EXPECT_GE(index.bases(), index.sample_bases()[index.size() - 1]);
+
+  // second read uses it.
+  check(fileName, 7, gold, true);
+}
+
+TEST_P(RecordIndexTest, stale)
+{
+  ::mxx::comm comm;
+
+  std::vector<size_t> gold;
+  {
+    FileType fobj(fileName, 0, comm);
+    fobj.set_record_index_stride(5);
+    ::bliss::io::file_data part = fobj.read_file();
+    gold = ::mxx::allgatherv(local_records(part), comm);
+  }
+
+  // append a record.  the index no longer matches the file size.
+  comm.barrier();
+  if (comm.rank() == 0) {
+    std::ofstream ofs(fileName, std::ios::binary | std::ios::app);
+    ofs << "@extra\nACGT\n+\nIIII\n";
+  }
+  comm.barrier();
+
+  ::bliss::io::record_index index;
+  EXPECT_FALSE(index.load(fileName));
+
+  std::vector<size_t> updated;
+  {
+    FileType fobj(fileName, 0, comm);
+    fobj.set_record_index_stride(0);
+    ::bliss::io::file_data part = fobj.read_file();
+    updated = ::mxx::allgatherv(local_records(part), comm);
+  }
+  EXPECT_EQ(gold.size() + 1, updated.size());
+
+  // rebuilt, then used.
+  check(fileName, 5, updated, false);
+  check(fileName, 5, updated, true);
+}
+
+
+TEST_P(RecordIndexTest, partition_by_kmers)
+{
+  ::mxx::comm comm;
+  size_t const overlap = 30;
+
+  std::vector<size_t> gold;
+  std::vector<size_t> gold_lengths;
+  {
+    FileType fobj(fileName, 0, comm);
+    fobj.set_record_index_stride(3);
+    ::bliss::io::file_data part = fobj.read_file();
+    std::vector<size_t> lengths;
+    gold = ::mxx::allgatherv(local_records(part, &lengths), comm);
+    gold_lengths = ::mxx::allgatherv(lengths, comm);
+  }
+
+  ::bliss::io::record_index index;
+  ASSERT_TRUE(index.load(fileName));
+  size_t total_bases = 0;
+  for (size_t l : gold_lengths) total_bases += l;
+  EXPECT_EQ(total_bases, index.bases());
+
+  FileType fobj(fileName, overlap, comm);
+  fobj.set_record_index_stride(3);
+  fobj.set_partition_by_kmers(true);
+  ::bliss::io::file_data part = fobj.read_file();
+
+  // all records, once, in order.
+  std::vector<size_t> lengths;
+  std::vector<size_t> local = local_records(part, &lengths);
+  std::vector<size_t> all = ::mxx::allgatherv(local, comm);
+  ASSERT_EQ(gold, all);
+  if (local.size() > 0) {
+    size_t id = std::lower_bound(gold.begin(), gold.end(), local.front()) - gold.begin();
+    EXPECT_EQ(id, fobj.first_record_id());
+  }
+
+  // within 1 sample interval of an equal share of the k-mers.
+  auto kmers = [overlap](std::vector<size_t> const & ls) {
+    size_t n = 0;
+    for (size_t l : ls) n += (l > overlap) ? (l - overlap) : 0;
+    return n;
+  };
+  size_t max_len = *std::max_element(gold_lengths.begin(), gold_lengths.end());
+  size_t share = kmers(gold_lengths) / comm.size();
+  EXPECT_LE(kmers(lengths), share + 2 * 3 * max_len);
+}
+
+
+/// boundaries from the estimated k-mers, on a synthetic index:  1 long record among short ones.
+TEST(RecordIndexBalance, balance)
+{
+  // 8 records of 10 characters at offsets 0, 100, ...;  record 2 has 1000 characters.
+  std::vector<uint64_t> offsets = {0, 100, 200, 1300, 1400, 1500, 1600, 1700};
+  std::vector<uint64_t> before = {0, 10, 20, 1020, 1030, 1040, 1050, 1060};
+  ::bliss::io::record_index index;
+  index.assign(std::move(offsets), std::move(before), 8, 1070, 1);
+
+  ::bliss::partition::range<size_t> file(0, 1800);
+
+  // k = 5:  6 k-mers per short record, 996 in the long one, 1038 in total.
+  auto r0 = index.balance(file, 0, 2, 4);
+  auto r1 = index.balance(file, 1, 2, 4);
+  EXPECT_EQ(0UL, r0.start);
+  EXPECT_EQ(r0.end, r1.start);
+  EXPECT_EQ(1800UL, r1.end);
+  // rank 0 takes records 0 to 2, which hold more than half of the k-mers;  by bytes it would end at 900.
+  EXPECT_EQ(1300UL, r0.end);
+
+  // short records count as 0 k-mers when k exceeds their length.
+  auto s0 = index.balance(file, 0, 2, 20);
+  EXPECT_EQ(1300UL, s0.end);
+
+  // 1 rank gets the whole file.
+  auto w = index.balance(file, 0, 1, 4);
+  EXPECT_EQ(0UL, w.start);
+  EXPECT_EQ(1800UL, w.end);
+}
+
+
+INSTANTIATE_TEST_CASE_P(Bliss, RecordIndexTest, ::testing::Values(
+    std::string("/test/data/test.fastq"),
+    std::string("/test/data/test.medium.fastq")
+    ));
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
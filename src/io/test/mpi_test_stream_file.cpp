@@ -0,0 +1,265 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_stream_file.cpp
+ *   FASTQ read through a pipe in small writes, cut into blocks of records, scattered, and parsed into the same k-mers as the file.
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+#include "mxx/collective.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <algorithm>
+#include <memory>     // unique_ptr
+#include <tuple>
+
+#include <unistd.h>   // pipe, write, close
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "io/stream_file.hpp"
+#include "io/kmer_file_helper.hpp"
+#include "io/kmer_parser.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/sequence_iterator.hpp"
+
+
+namespace {
+  std::string file_name() {
+    return std::string(PROJ_SRC_DIR) + "/test/data/test.medium.fastq";
+  }
+
+  std::vector<unsigned char> file_content(std::string const & name) {
+    std::ifstream ifs(name, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+
+  /// a pipe fed with content in writes of step bytes by a thread, as a sequencer would.
+  struct feeder {
+      int fds[2];
+      std::thread writer;
+
+      feeder(std::vector<unsigned char> const & content, size_t const step) {
+        if (pipe(fds) != 0) throw std::runtime_error("pipe failed");
+        int wfd = fds[1];
+        writer = std::thread([&content, step, wfd]() {
+          for (size_t i = 0; i < content.size(); i += step) {
+            size_t n = std::min(step, content.size() - i);
+            size_t done = 0;
+            while (done < n) {
+              ssize_t w = write(wfd, content.data() + i + done, n - done);
+              if (w <= 0) return;
+              done += w;
+            }
+          }
+          close(wfd);
+        });
+      }
+
+      int fd() const { return fds[0]; }
+
+      ~feeder() {
+        writer.join();
+        close(fds[0]);
+      }
+  };
+}
+
+
+TEST(FastqStreamReader, blocks)
+{
+  std::vector<unsigned char> ref = file_content(file_name());
+  ASSERT_GT(ref.size(), 0UL);
+
+  // writes and reads that do not line up with each other or with the records.
+  feeder f(ref, 1000);
+  ::bliss::io::fastq_stream_reader reader(f.fd(), 97);
+
+  std::vector<unsigned char> all;
+  std::vector<unsigned char> block;
+  while (true) {
+    block.clear();
+    size_t offset = reader.next(500, block);
+    if (block.empty()) break;
+    EXPECT_EQ(all.size(), offset);
+
+    // whole records.  the file ends with a blank line, which goes with the last block.
+    EXPECT_EQ('@', block.front());
+    EXPECT_EQ('\n', block.back());
+    if (!reader.done()) {
+      EXPECT_EQ(0L, std::count(block.begin(), block.end(), '\n') % 4);
+      EXPECT_GE(block.size(), 500UL);
+    }
+
+    all.insert(all.end(), block.begin(), block.end());
+  }
+  EXPECT_TRUE(reader.done());
+  EXPECT_EQ(ref.size(), reader.position());
+
+  // the blank line at the end may be dropped.
+  ASSERT_LE(ref.size() - 1, all.size());
+  EXPECT_TRUE(std::equal(all.begin(), all.end(), ref.begin()));
+}
+
+TEST(FastqStreamReader, no_final_newline)
+{
+  std::string text("@r1\nACGT\n+\nIIII\n@r2\nTTTT\n+\nIIII");
+  std::vector<unsigned char> content(text.begin(), text.end());
+  feeder f(content, 7);
+  ::bliss::io::fastq_stream_reader reader(f.fd(), 5);
+
+  std::vector<unsigned char> first, second, third;
+  reader.next(1, first);
+  EXPECT_EQ(std::string("@r1\nACGT\n+\nIIII\n"), std::string(first.begin(), first.end()));
+  reader.next(1, second);
+  EXPECT_EQ(std::string("@r2\nTTTT\n+\nIIII"), std::string(second.begin(), second.end()));
+  EXPECT_EQ(content.size(), reader.next(1, third));
+  EXPECT_TRUE(third.empty());
+  EXPECT_TRUE(reader.done());
+}
+
+TEST(FastqStreamReader, trailing_blank_lines)
+{
+  std::string text("@r1\nACGT\n+\nIIII\n\n\n");
+  std::vector<unsigned char> content(text.begin(), text.end());
+  feeder f(content, 3);
+  ::bliss::io::fastq_stream_reader reader(f.fd(), 2);
+
+  // the blank lines are read after the record is returned, and are not a block.
+  std::vector<unsigned char> first, second;
+  reader.next(1, first);
+  EXPECT_EQ(std::string("@r1\nACGT\n+\nIIII\n"), std::string(first.begin(), first.end()));
+  EXPECT_EQ(content.size(), reader.next(1, second));
+  EXPECT_TRUE(second.empty());
+  EXPECT_EQ(content.size(), reader.position());
+}
+
+TEST(StreamScatter, rounds)
+{
+  ::mxx::comm comm;
+  std::vector<unsigned char> ref = file_content(file_name());
+
+  int const root = comm.size() / 2;
+  std::unique_ptr<feeder> f;
+  std::unique_ptr<::bliss::io::fastq_stream_reader> reader;
+  if (comm.rank() == root) {
+    f.reset(new feeder(ref, 333));
+    reader.reset(new ::bliss::io::fastq_stream_reader(f->fd(), 4096));
+  }
+
+  size_t bytes = 0;
+  size_t rounds = 0;
+  size_t round_start = 0;
+  while (true) {
+    ::bliss::io::file_data block = ::bliss::io::scatter_stream_block(reader.get(), 300, comm, root);
+    if (block.parent_range_bytes.size() == 0) break;
+    ++rounds;
+
+    // rounds are consecutive, and a block is where the file has it.
+    EXPECT_EQ(round_start, block.parent_range_bytes.start);
+    round_start = block.parent_range_bytes.end;
+    EXPECT_TRUE(block.parent_range_bytes.contains(block.valid_range_bytes));
+    ASSERT_EQ(block.valid_range_bytes.size(), block.data.size());
+    ASSERT_LE(block.valid_range_bytes.end, ref.size());
+    EXPECT_TRUE(std::equal(block.data.begin(), block.data.end(), ref.begin() + block.valid_range_bytes.start));
+    if (block.data.size() > 0) EXPECT_EQ('@', block.data.front());
+
+    bytes += block.data.size();
+  }
+  f.reset();
+
+  // the blank line at the end of the file may be dropped.
+  EXPECT_LE(ref.size() - 1, round_start);
+  EXPECT_LE(round_start, ref.size());
+  EXPECT_EQ(round_start, ::mxx::allreduce(bytes, comm));
+  EXPECT_GT(rounds, 1UL);
+}
+
+TEST(StreamInput, kmers_match_file)
+{
+  ::mxx::comm comm;
+  using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA, uint64_t>;
+  using KmerParser = ::bliss::index::kmer::KmerParser<KmerType>;
+
+  std::vector<KmerType> gold;
+  ::bliss::io::KmerFileHelper::template read_file_posix<KmerParser, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(
+      file_name(), gold, comm);
+
+  std::vector<unsigned char> ref = file_content(file_name());
+  std::unique_ptr<feeder> f;
+  std::unique_ptr<::bliss::io::fastq_stream_reader> reader;
+  if (comm.rank() == 0) {
+    f.reset(new feeder(ref, 4096));
+    reader.reset(new ::bliss::io::fastq_stream_reader(f->fd()));
+  }
+
+  // small blocks and chunks, so there are several rounds, and several chunks per block.
+  std::vector<KmerType> streamed;
+  size_t calls = 0;
+  auto consume = [&streamed, &calls](std::vector<KmerType> & chunk) {
+    streamed.insert(streamed.end(), chunk.begin(), chunk.end());
+    ++calls;
+  };
+  std::tuple<size_t, size_t, size_t> read =
+      ::bliss::io::KmerFileHelper::template stream_input<KmerParser, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(
+          reader.get(), 1000, 64 * sizeof(KmerType), consume, comm);
+  f.reset();
+
+  EXPECT_EQ(streamed.size(), std::get<1>(read));
+  EXPECT_EQ(calls, std::get<2>(read));
+  // consume is collective.
+  EXPECT_EQ(calls, ::mxx::allreduce(calls, ::mxx::max<size_t>(), comm));
+
+  // the same k-mers over all ranks.  the blocks are round robin, so not on the same ranks.
+  std::vector<KmerType> all_gold = ::mxx::allgatherv(gold, comm);
+  std::vector<KmerType> all_streamed = ::mxx::allgatherv(streamed, comm);
+  std::sort(all_gold.begin(), all_gold.end());
+  std::sort(all_streamed.begin(), all_streamed.end());
+  EXPECT_EQ(all_gold, all_streamed);
+}
+
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+#if defined(USE_MPI)
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+#endif
+
+  result = RUN_ALL_TESTS();
+
+#if defined(USE_MPI)
+  comm.barrier();
+#endif
+
+  return result;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * mpi_test_threaded_parse.cpp
+ *   parses FASTQ and FASTA files with the work stealing threaded parser and the bucketed parser, and compares to the serial parser.
+ */
+
+
+#include "bliss-config.hpp"    // for location of data.
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+
+// include google test
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "io/kmer_parser.hpp"
+#include "io/kmer_file_helper.hpp"
+#include "io/sequence_iterator.hpp"
+#include "utils/transform_utils.hpp"
+
+
+class ThreadedParseTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA5, uint64_t>;
+    using KmerParserType = ::bliss::index::kmer::KmerParser<KmerType>;
+
+    std::string fileName;
+
+    virtual void SetUp()
+    {
+      fileName.assign(PROJ_SRC_DIR);
+      fileName.append(GetParam());
+    }
+
+    /// parse serially and with threads, and compare the sorted k-mers and the counts.
+    template <template <typename> class SeqParser>
+    void check(size_t const nthreads, size_t const block_bytes) {
+      ::mxx::comm comm;
+      using FileType = ::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>;
+
+      std::vector<KmerType> gold;
+      std::pair<size_t, size_t> gold_counts =
+          ::bliss::io::KmerFileHelper::read_file<FileType, KmerParserType, SeqParser, ::bliss::io::SequencesIterator>(fileName, gold, comm);
+
+      std::vector<std::vector<KmerType> > results;
+      std::pair<size_t, size_t> counts =
+          ::bliss::io::KmerFileHelper::read_file_threaded<FileType, KmerParserType, SeqParser, ::bliss::io::SequencesIterator>(fileName, results, comm,
+              nthreads, block_bytes);
+
+      EXPECT_EQ(gold_counts.first, counts.first);
+      EXPECT_EQ(gold_counts.second, counts.second);
+      EXPECT_EQ(nthreads, results.size());
+
+      // traverse the per thread vectors as one.
+      std::vector<KmerType> all(::bliss::io::KmerFileHelper::concat_begin(results), ::bliss::io::KmerFileHelper::concat_end(results));
+
+      ASSERT_EQ(gold.size(), all.size());
+      std::sort(gold.begin(), gold.end());
+      std::sort(all.begin(), all.end());
+      for (size_t i = 0; i < gold.size(); ++i) {
+        EXPECT_EQ(gold[i], all[i]) << "kmer " << i << " of " << gold.size();
+      }
+    }
+
+    /// parse directly into buckets, and compare to the serial parser and to the bucket function.
+    template <template <typename> class SeqParser>
+    void check_bucketed(size_t const nbuckets) {
+      ::mxx::comm comm;
+      using FileType = ::bliss::io::parallel::partitioned_file<::bliss::io::mmap_file, SeqParser>;
+
+      std::vector<KmerType> gold;
+      std::pair<size_t, size_t> gold_counts =
+          ::bliss::io::KmerFileHelper::read_file<FileType, KmerParserType, SeqParser, ::bliss::io::SequencesIterator>(fileName, gold, comm);
+
+      ::bliss::transform::identity<KmerType> trans;
+      auto to_bucket = [nbuckets](KmerType const & x) { return x.getData()[0] % nbuckets; };
+
+      std::vector<KmerType> bucketed;
+      std::vector<size_t> counts;
+      std::pair<size_t, size_t> read =
+          ::bliss::io::KmerFileHelper::read_file_bucketed<FileType, KmerParserType, SeqParser, ::bliss::io::SequencesIterator>(fileName,
+              trans, to_bucket, nbuckets, bucketed, counts, comm);
+
+      EXPECT_EQ(gold_counts.first, read.first);
+      EXPECT_EQ(gold_counts.second, read.second);
+      ASSERT_EQ(nbuckets, counts.size());
+      ASSERT_EQ(gold.size(), bucketed.size());
+
+      size_t offset = 0;
+      for (size_t b = 0; b < nbuckets; ++b) {
+        for (size_t i = offset; i < offset + counts[b]; ++i) {
+          EXPECT_EQ(b, to_bucket(bucketed[i])) << "kmer " << i << " in bucket " << b;
+        }
+        offset += counts[b];
+      }
+      EXPECT_EQ(bucketed.size(), offset);
+
+      std::sort(gold.begin(), gold.end());
+      std::sort(bucketed.begin(), bucketed.end());
+      EXPECT_TRUE(std::equal(gold.begin(), gold.end(), bucketed.begin()));
+    }
+
+    template <template <typename> class SeqParser>
+    void check_all() {
+      check<SeqParser>(1, 1UL << 20);
+      check<SeqParser>(4, 997);
+      check<SeqParser>(3, 64);
+      check<SeqParser>(8, 1);
+    }
+};
+
+
+class ThreadedFASTQParseTest : public ThreadedParseTest {};
+class ThreadedFASTAParseTest : public ThreadedParseTest {};
+
+
+TEST_P(ThreadedFASTQParseTest, parse_mmap)
+{
+  this->check_all<::bliss::io::FASTQParser>();
+}
+
+TEST_P(ThreadedFASTAParseTest, parse_mmap)
+{
+  this->check_all<::bliss::io::FASTAParser>();
+}
+
+TEST_P(ThreadedFASTQParseTest, parse_bucketed)
+{
+  this->check_bucketed<::bliss::io::FASTQParser>(1);
+  this->check_bucketed<::bliss::io::FASTQParser>(7);
+}
+
+TEST_P(ThreadedFASTAParseTest, parse_bucketed)
+{
+  this->check_bucketed<::bliss::io::FASTAParser>(1);
+  this->check_bucketed<::bliss::io::FASTAParser>(7);
+}
+
+
+INSTANTIATE_TEST_CASE_P(Bliss, ThreadedFASTQParseTest, ::testing::Values(
+    std::string("/test/data/natural.fastq"),
+    std::string("/test/data/natural.withN.fastq"),
+    std::string("/test/data/test.debruijn.tiny.fastq"),
+    std::string("/test/data/test.medium.fastq"),
+    std::string("/test/data/test.unitiqs.fastq")
+    ));
+
+INSTANTIATE_TEST_CASE_P(Bliss, ThreadedFASTAParseTest, ::testing::Values(
+    std::string("/test/data/natural.fasta"),
+    std::string("/test/data/natural.withN.fasta"),
+    std::string("/test/data/test.fasta"),
+    std::string("/test/data/test2.fasta")
+    ));
+
+
+//////////////////// RUN the tests with mpi support.
+
+int main(int argc, char* argv[])
+{
+  int result = 0;
+
+  ::testing::InitGoogleTest(&argc, argv);
+
+  ::mxx::env e(argc, argv);
+  ::mxx::comm comm;
+
+  result = RUN_ALL_TESTS();
+
+  comm.barrier();
+
+  return result;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+#include "io/bgzf_file.hpp"
+#include "utils/file_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+
+#if defined(USE_ZLIB)
+
+class BGZFTest : public ::testing::Test
+{
+  protected:
+    std::vector<unsigned char> input;
+    std::vector<unsigned char> compressed;
+    std::vector<size_t> offsets;
+
+    virtual void SetUp()
+    {
+      // sequence like text, compressible, in 3 members with an EOF member.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<int> distribution(0, 3);
+      char const * alpha = "ACGT";
+      input.resize(150000);
+      for (size_t i = 0; i < input.size(); ++i) input[i] = ((i % 101) == 100) ? '\n' : alpha[distribution(generator)];
+
+      for (size_t i = 0; i < input.size(); i += ::bliss::io::bgzf::max_input_bytes) {
+        offsets.push_back(compressed.size());
+        ::bliss::io::bgzf::compress_block(input.data() + i, std::min(::bliss::io::bgzf::max_input_bytes, input.size() - i), compressed);
+      }
+      offsets.push_back(compressed.size());
+      ::bliss::io::bgzf::compress_block(nullptr, 0, compressed);
+    }
+};
+
+
+TEST_F(BGZFTest, roundtrip)
+{
+  std::vector<unsigned char> output;
+  ::bliss::io::bgzf::block b;
+  size_t pos = 0;
+  while (pos < compressed.size()) {
+    ASSERT_TRUE(::bliss::io::bgzf::parse_header(compressed.data() + pos, compressed.size() - pos, b));
+    size_t n = ::bliss::io::bgzf::uncompressed_size(compressed.data() + pos, b);
+    EXPECT_LE(n, ::bliss::io::bgzf::max_input_bytes);
+
+    size_t start = output.size();
+    output.resize(start + n);
+    EXPECT_TRUE(::bliss::io::bgzf::inflate_block(compressed.data() + pos, b, output.data() + start, n));
+    pos += b.bytes;
+  }
+  EXPECT_EQ(compressed.size(), pos);
+  EXPECT_TRUE(input == output);
+}
+
+TEST_F(BGZFTest, incompressible)
+{
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> distribution(0, 255);
+  std::vector<unsigned char> data(::bliss::io::bgzf::max_input_bytes);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = distribution(generator);
+
+  std::vector<unsigned char> member;
+  ::bliss::io::bgzf::compress_block(data.data(), data.size(), member);
+  EXPECT_LE(member.size(), ::bliss::io::bgzf::max_block_bytes);
+
+  ::bliss::io::bgzf::block b;
+  ASSERT_TRUE(::bliss::io::bgzf::parse_header(member.data(), member.size(), b));
+  EXPECT_EQ(member.size(), b.bytes);
+
+  std::vector<unsigned char> output(data.size());
+  EXPECT_TRUE(::bliss::io::bgzf::inflate_block(member.data(), b, output.data(), output.size()));
+  EXPECT_TRUE(data == output);
+
+  EXPECT_THROW(::bliss::io::bgzf::compress_block(data.data(), data.size() + 1, member), std::invalid_argument);
+}
+
+TEST_F(BGZFTest, corrupt)
+{
+  ::bliss::io::bgzf::block b;
+  ASSERT_TRUE(::bliss::io::bgzf::parse_header(compressed.data(), compressed.size(), b));
+  size_t n = ::bliss::io::bgzf::uncompressed_size(compressed.data(), b);
+  std::vector<unsigned char> output(n);
+
+  // bad crc
+  compressed[b.bytes - 8] ^= 0xFF;
+  EXPECT_FALSE(::bliss::io::bgzf::inflate_block(compressed.data(), b, output.data(), n));
+  compressed[b.bytes - 8] ^= 0xFF;
+
+  // bad deflate data
+  compressed[b.header_bytes + 1] ^= 0xFF;
+  EXPECT_FALSE(::bliss::io::bgzf::inflate_block(compressed.data(), b, output.data(), n));
+  compressed[b.header_bytes + 1] ^= 0xFF;
+
+  // plain gzip header, no BC field.
+  unsigned char plain[20] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+  EXPECT_FALSE(::bliss::io::bgzf::parse_header(plain, 20, b));
+}
+
+TEST_F(BGZFTest, find_first_block)
+{
+  size_t end = compressed.size();
+
+  // from every offset in a member, find the next member.
+  for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+    EXPECT_EQ(offsets[i], ::bliss::io::bgzf::find_first_block(compressed.data(), 0, end, offsets[i], end, end));
+    EXPECT_EQ(offsets[i + 1], ::bliss::io::bgzf::find_first_block(compressed.data(), 0, end, offsets[i] + 1, end, end));
+  }
+  // the EOF member is found, up to the end of file.
+  EXPECT_EQ(offsets.back(), ::bliss::io::bgzf::find_first_block(compressed.data(), 0, end, offsets.back(), end, end));
+  // nothing in the search range
+  EXPECT_EQ(offsets[1], ::bliss::io::bgzf::find_first_block(compressed.data(), 0, end, 1, offsets[1], end));
+
+  // buffer not starting at 0.
+  EXPECT_EQ(offsets[2], ::bliss::io::bgzf::find_first_block(compressed.data() + offsets[1], offsets[1], end - offsets[1],
+                                                            offsets[1] + 1, end, end));
+}
+
+TEST_F(BGZFTest, find_first_block_false_header)
+{
+  // stored (uncompressed) members contain their input verbatim, so a header-like pattern in the input
+  // appears in the compressed stream.  it is not followed by a member, so it is skipped.
+  std::vector<unsigned char> data(1000, 'A');
+  unsigned char fake[18] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 50, 0 };
+  std::copy(fake, fake + 18, data.begin() + 100);
+
+  std::vector<unsigned char> stored;
+  ::bliss::io::bgzf::compress_block(data.data(), data.size(), stored, 0);
+  size_t second = stored.size();
+  ::bliss::io::bgzf::compress_block(data.data(), data.size(), stored, 0);
+
+  ::bliss::io::bgzf::block b;
+  size_t fake_pos = std::search(stored.begin(), stored.begin() + second, fake, fake + 18) - stored.begin();
+  ASSERT_LT(fake_pos, second);
+  ASSERT_TRUE(::bliss::io::bgzf::parse_header(stored.data() + fake_pos, stored.size() - fake_pos, b));
+
+  EXPECT_EQ(second, ::bliss::io::bgzf::find_first_block(stored.data(), 0, stored.size(), 1, stored.size(), stored.size()));
+}
+
+#endif
+
+TEST(BGZFFileName, extension)
+{
+  EXPECT_TRUE(::bliss::utils::file::is_gzip_file("reads.fastq.gz"));
+  EXPECT_TRUE(::bliss::utils::file::is_gzip_file("reads.FASTA.BGZ"));
+  EXPECT_FALSE(::bliss::utils::file::is_gzip_file("reads.fastq"));
+
+  EXPECT_EQ(std::string("fastq"), ::bliss::utils::file::get_data_file_extension("reads.fastq.gz"));
+  EXPECT_EQ(std::string("fasta"), ::bliss::utils::file::get_data_file_extension("a.b/reads.fasta"));
+  EXPECT_EQ(std::string(), ::bliss::utils::file::get_data_file_extension("reads.gz"));
+}
@@ -229,6 +229,22 @@ TEST_P(BucketTest, bucket)
                                    this->p.first, this->p.last);
 }
 
+TEST_P(BucketTest, radix_bucket)
+{
+	this->bcounts.clear();
+	this->unbucketed.clear();
+  this->mapping.clear();
+
+  // allocate.
+  this->bucketed.resize(this->p.input_size);
+
+  BucketTestInfo pp = this->p;
+
+  imxx::local::bucketing_radix_impl(this->data, [&pp](std::pair<size_t, size_t> const & x){ return x.first % pp.bucket_count; },
+		  this->p.bucket_count, this->bcounts,   this->bucketed,
+                                   this->p.first, this->p.last);
+}
+
 TEST_P(BucketTest, mxx_bucket)
 {
 	this->bcounts.clear();
@@ -284,6 +300,38 @@ TEST_P(BucketTest, permute )
   }
 }
 
+TEST_P(BucketTest, radix_permute )
+{
+	this->unbucketed.clear();
+  this->mapping.clear();
+  this->bucketed.clear();
+
+  BucketTestInfo pp = this->p;
+
+  // allocate.
+  this->mapping.reserve(this->p.input_size);
+
+
+  imxx::local::assign_to_buckets(this->data, [&pp](std::pair<size_t, size_t> const & x){ return x.first % pp.bucket_count; },
+		  this->p.bucket_count,
+                                 this->bcounts, this->mapping, this->p.first, this->p.last);
+
+  imxx::local::bucket_to_permutation(this->bcounts, this->mapping, this->p.first, this->p.last);
+
+
+  if ((pp.bucket_count > 0) && (this->p.last <= this->p.input_size) && (this->p.first <= this->p.last) ) {
+
+	  // allocate.
+	  this->bucketed.resize(this->p.input_size);
+
+
+	  imxx::local::permute_radix(this->data.begin() + this->p.first, this->data.begin() + this->p.last,
+						   this->mapping.begin() + this->p.first,
+						   this->bucketed.begin() + this->p.first,
+						   this->p.first);
+  }
+}
+
 TEST_P(BucketTest, inplace_permute)
 {
 	this->unbucketed.clear();
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "io/delta_codec.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+
+#include <random>
+#include <algorithm>  // for sort
+#include <cstdint>  // uint64_t
+#include <vector>
+
+
+template <typename T>
+class DeltaCodecTest : public ::testing::Test
+{
+  protected:
+    std::vector<T> sorted;
+
+    virtual void SetUp()
+    {
+      // random keys with repeats, including 0.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<uint64_t> distribution;
+
+      sorted.resize(10000);
+      T km = make(0, 0);
+      for (size_t i = 0; i < sorted.size(); ++i) {
+        if ((i & 3) == 0) km = make(distribution(generator), distribution(generator));
+        sorted[i] = km;
+      }
+      sorted[0] = make(0, 0);
+      std::sort(sorted.begin(), sorted.end(), ::imxx::codec::less<T>());
+    }
+
+    template <typename U = T>
+    static typename std::enable_if<std::is_integral<U>::value, U>::type make(uint64_t x, uint64_t) {
+      return static_cast<U>(x);
+    }
+
+    template <typename U = T>
+    static typename std::enable_if<!std::is_integral<U>::value, U>::type make(uint64_t x, uint64_t y) {
+      U km;
+      for (size_t i = 0; i < U::nWords; ++i) {
+        km.getDataRef()[i] = static_cast<typename U::KmerWordType>((i & 1) ? y : x);
+        x = (x >> 11) | (x << 53);
+      }
+      km.sanitize();
+      return km;
+    }
+};
+
+// k = 31 (1 word), k = 21 (16 bit words), k = 63 (2 words), k = 96 (3 words)
+typedef ::testing::Types<uint8_t, uint32_t, uint64_t,
+    ::bliss::common::Kmer<31, bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<21, bliss::common::DNA, uint16_t>,
+    ::bliss::common::Kmer<63, bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<96, bliss::common::DNA, uint64_t> > DeltaCodecTestTypes;
+TYPED_TEST_CASE(DeltaCodecTest, DeltaCodecTestTypes);
+
+
+TYPED_TEST(DeltaCodecTest, roundtrip)
+{
+  std::vector<uint8_t> bytes;
+  size_t nbytes = ::imxx::codec::encode(this->sorted.data(), this->sorted.size(), bytes);
+  EXPECT_EQ(bytes.size(), nbytes);
+  EXPECT_LE(nbytes, ::imxx::codec::max_encoded_bytes<TypeParam>(this->sorted.size()));
+
+  std::vector<TypeParam> decoded;
+  size_t n = ::imxx::codec::decode(bytes.data(), bytes.size(), decoded);
+  EXPECT_EQ(this->sorted.size(), n);
+  EXPECT_TRUE(std::equal(this->sorted.begin(), this->sorted.end(), decoded.begin()));
+}
+
+TYPED_TEST(DeltaCodecTest, segments)
+{
+  // several runs appended to the same buffer, decoded separately.
+  std::vector<uint8_t> bytes;
+  std::vector<size_t> sizes;
+  size_t step = this->sorted.size() / 3;
+  for (size_t i = 0; i < this->sorted.size(); i += step) {
+    size_t n = std::min(step, this->sorted.size() - i);
+    sizes.push_back(::imxx::codec::encode(this->sorted.data() + i, n, bytes));
+  }
+  // empty segment
+  EXPECT_EQ(0UL, ::imxx::codec::encode(this->sorted.data(), 0, bytes));
+
+  std::vector<TypeParam> decoded;
+  size_t offset = 0;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    size_t n = ::imxx::codec::decode(bytes.data() + offset, sizes[i], decoded);
+    EXPECT_EQ(std::min(step, this->sorted.size() - i * step), n);
+    offset += sizes[i];
+  }
+  EXPECT_EQ(bytes.size(), offset);
+
+  ASSERT_EQ(this->sorted.size(), decoded.size());
+  EXPECT_TRUE(std::equal(this->sorted.begin(), this->sorted.end(), decoded.begin()));
+}
+
+TEST(DeltaCodec, compression)
+{
+  // dense, sorted keys with duplicates need far fewer bytes than raw.
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 100000; ++i) {
+    keys.push_back(i * 37);
+    keys.push_back(i * 37);
+  }
+  std::vector<uint8_t> bytes;
+  ::imxx::codec::encode(keys.data(), keys.size(), bytes);
+  EXPECT_LT(bytes.size() * 4, keys.size() * sizeof(uint64_t));
+}
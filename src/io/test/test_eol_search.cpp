@@ -0,0 +1,102 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+#include "io/eol_search.hpp"
+
+#include <random>
+#include <vector>
+#include <list>
+#include <string>
+#include <algorithm>
+
+
+TEST(EOLSearch, trait)
+{
+  EXPECT_TRUE(::bliss::io::is_contiguous_char_iterator<unsigned char const *>::value);
+  EXPECT_TRUE(::bliss::io::is_contiguous_char_iterator<char *>::value);
+  EXPECT_TRUE((::bliss::io::is_contiguous_char_iterator<std::vector<unsigned char>::const_iterator>::value));
+  EXPECT_TRUE((::bliss::io::is_contiguous_char_iterator<std::vector<char>::iterator>::value));
+  EXPECT_FALSE((::bliss::io::is_contiguous_char_iterator<std::list<char>::iterator>::value));
+  EXPECT_FALSE((::bliss::io::is_contiguous_char_iterator<std::vector<int>::iterator>::value));
+}
+
+TEST(EOLSearch, matches_scalar)
+{
+  // lines of random length, some with \r\n, so that EOLs fall at every position within a vector.
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> len_dist(0, 100);
+  std::uniform_int_distribution<int> char_dist(0, 3);
+  char const * alpha = "ACGT";
+  std::vector<unsigned char> input;
+  while (input.size() < 20000) {
+    int len = len_dist(generator);
+    for (int i = 0; i < len; ++i) input.push_back(alpha[char_dist(generator)]);
+    if ((len % 3) == 0) input.push_back('\r');
+    input.push_back('\n');
+  }
+
+  auto is_eol = [](unsigned char c) { return (c == '\n') || (c == '\r'); };
+  for (size_t start = 0; start < input.size(); ++start) {
+    size_t expected = std::find_if(input.begin() + start, input.end(), is_eol) - (input.begin() + start);
+    ASSERT_EQ(expected, ::bliss::io::find_eol(input.data() + start, input.size() - start));
+  }
+}
+
+TEST(EOLSearch, no_eol)
+{
+  std::vector<unsigned char> input(1000, 'A');
+  for (size_t count = 0; count <= input.size(); ++count) {
+    ASSERT_EQ(count, ::bliss::io::find_eol(input.data(), count));
+  }
+
+  // eol just past the count is not seen.
+  input[64] = '\n';
+  EXPECT_EQ(64UL, ::bliss::io::find_eol(input.data(), 64));
+  EXPECT_EQ(64UL, ::bliss::io::find_eol(input.data(), 65));
+}
+
+TEST(EOLSearch, n_runs)
+{
+  // runs of N and n of random length between runs of bases, so that run ends fall at every position within a vector.
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> len_dist(0, 80);
+  std::uniform_int_distribution<int> char_dist(0, 3);
+  char const * alpha = "ACGT";
+  std::vector<unsigned char> input;
+  while (input.size() < 20000) {
+    int len = len_dist(generator);
+    for (int i = 0; i < len; ++i) input.push_back(alpha[char_dist(generator)]);
+    len = len_dist(generator) / 4;
+    for (int i = 0; i < len; ++i) input.push_back((i & 1) ? 'n' : 'N');
+  }
+
+  auto is_n = [](unsigned char c) { return (c == 'N') || (c == 'n'); };
+  for (size_t start = 0; start < input.size(); ++start) {
+    size_t expected = std::find_if(input.begin() + start, input.end(), is_n) - (input.begin() + start);
+    ASSERT_EQ(expected, ::bliss::io::find_either(input.data() + start, input.size() - start, 'N', 'n'));
+    expected = std::find_if_not(input.begin() + start, input.end(), is_n) - (input.begin() + start);
+    ASSERT_EQ(expected, ::bliss::io::find_neither(input.data() + start, input.size() - start, 'N', 'n'));
+  }
+
+  // all N.
+  std::vector<unsigned char> gap(100, 'N');
+  EXPECT_EQ(100UL, ::bliss::io::find_neither(gap.data(), gap.size(), 'N', 'n'));
+  EXPECT_EQ(0UL, ::bliss::io::find_either(gap.data(), gap.size(), 'N', 'n'));
+}
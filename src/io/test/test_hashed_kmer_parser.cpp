@@ -0,0 +1,72 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "common/sequence.hpp"
+#include "io/kmer_parser.hpp"
+#include "index/kmer_hash.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+#include <utility>
+
+
+TEST(HashedKmerParser, rolled_hash)
+{
+  using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+  using TupleType = ::std::pair<KmerType, uint64_t>;
+  using SeqType = ::bliss::common::Sequence<std::string::const_iterator>;
+
+  // 300 bases, in lines of 60.
+  std::string seq;
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> base_dist(0, 3);
+  char const * alpha = "ACGT";
+  for (size_t i = 0; i < 300; ++i) {
+    seq.push_back(alpha[base_dist(generator)]);
+    if ((i % 60) == 59) seq.push_back('\n');
+  }
+
+  SeqType read(::bliss::common::SequenceId(0, 0), seq.size(), 0, 0, seq.cbegin(), seq.cend());
+  ::bliss::partition::range<size_t> valid(0, seq.size());
+
+  std::vector<KmerType> kmers;
+  ::fsc::back_emplace_iterator<std::vector<KmerType> > kmer_iter(kmers);
+  ::bliss::index::kmer::KmerParser<KmerType> kmer_parser(valid);
+  kmer_parser(read, kmer_iter);
+
+  std::vector<TupleType> hashed;
+  ::fsc::back_emplace_iterator<std::vector<TupleType> > hashed_iter(hashed);
+  ::bliss::index::kmer::HashedKmerParser<TupleType> parser(valid);
+  parser(read, hashed_iter);
+
+  // the same kmers as KmerParser, each with its store hash.
+  ::bliss::kmer::hash::nthash<KmerType, false> hash;
+  ASSERT_EQ(300UL - KmerType::size + 1, hashed.size());
+  ASSERT_EQ(kmers.size(), hashed.size());
+  for (size_t i = 0; i < hashed.size(); ++i) {
+    EXPECT_EQ(kmers[i], hashed[i].first);
+    EXPECT_EQ(hash(kmers[i]), hashed[i].second);
+  }
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_header_resolver.cpp
+ *   test that the record offsets of the FASTQ parser resolve to the record names, in batches and windows of any size.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/sequence.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/header_resolver.hpp"
+
+#include <cstdio>   // remove
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+class HeaderResolverTest : public ::testing::Test
+{
+  protected:
+    std::string filename;
+    std::string data;
+    std::vector<std::string> names;
+
+    virtual void SetUp()
+    {
+      filename = "test_header_resolver.fastq";
+      // names of varying length, 1 much longer than a small window, with descriptions and a CRLF line.
+      for (size_t i = 0; i < 200; ++i) {
+        std::stringstream ss;
+        ss << "read" << i;
+        if (i % 7 == 3) ss << " len=" << (50 + i) << "\tsample=A";
+        if (i == 150) ss << " " << std::string(300, 'x');
+        names.push_back(ss.str());
+
+        data.append("@").append(names.back()).append((i == 20) ? "\r\n" : "\n");
+        std::string seq(50 + i % 13, "ACGT"[i % 4]);
+        data.append(seq).append("\n+\n").append(std::string(seq.size(), 'I')).append("\n");
+      }
+      std::ofstream out(filename, std::ios::binary);
+      out << data;
+    }
+
+    virtual void TearDown()
+    {
+      std::remove(filename.c_str());
+    }
+
+    /// the record ids, as the k-mer parsers see them.
+    std::vector<::bliss::common::SequenceId> parse_ids() {
+      std::vector<::bliss::common::SequenceId> ids;
+      ::bliss::io::SequentialFASTQParser<char const *> parser;
+      char const * it = data.data();
+      char const * end = data.data() + data.size();
+      size_t offset = 0;
+      while (it != end) {
+        auto seq = parser.get_next_record(it, end, offset);
+        if (seq.record_size == 0) break;
+        ids.push_back(seq.id);
+      }
+      return ids;
+    }
+
+    std::string first_word(std::string const & s) {
+      return s.substr(0, s.find_first_of(" \t"));
+    }
+};
+
+
+TEST_F(HeaderResolverTest, parsed_ids)
+{
+  std::vector<::bliss::common::SequenceId> ids = parse_ids();
+  ASSERT_EQ(names.size(), ids.size());
+
+  for (size_t window : {16UL, 100UL, 4096UL, ::bliss::io::header_resolver::default_window_bytes}) {
+    ::bliss::io::header_resolver resolver(filename, false, window);
+    std::vector<std::string> found = resolver.resolve_ids(ids);
+    ASSERT_EQ(names.size(), found.size());
+    for (size_t i = 0; i < names.size(); ++i) EXPECT_EQ(names[i], found[i]) << "window " << window << " record " << i;
+
+    ::bliss::io::header_resolver words(filename, true, window);
+    found = words.resolve_ids(ids);
+    for (size_t i = 0; i < names.size(); ++i) EXPECT_EQ(first_word(names[i]), found[i]);
+  }
+}
+
+TEST_F(HeaderResolverTest, query_order)
+{
+  std::vector<::bliss::common::SequenceId> ids = parse_ids();
+
+  // k-mer ids of a query result:  unordered, repeated.
+  std::vector<::bliss::common::ShortSequenceKmerId> kids;
+  std::vector<size_t> expected;
+  for (size_t i = 0; i < 500; ++i) {
+    size_t r = (i * 37) % names.size();
+    ::bliss::common::ShortSequenceKmerId k(ids[r]);
+    k += i % 20;   // position in the read does not matter.
+    kids.push_back(k);
+    expected.push_back(r);
+  }
+
+  ::bliss::io::header_resolver resolver(filename, false, 256);
+  std::vector<std::string> found = resolver.resolve_ids(kids);
+  ASSERT_EQ(kids.size(), found.size());
+  for (size_t i = 0; i < kids.size(); ++i) EXPECT_EQ(names[expected[i]], found[i]);
+
+  EXPECT_EQ(names.back(), resolver.resolve(ids.back().get_pos()));
+  EXPECT_TRUE(resolver.resolve(std::vector<size_t>()).empty());
+}
+
+TEST_F(HeaderResolverTest, errors)
+{
+  EXPECT_THROW(::bliss::io::header_resolver("no_such_file.fastq"), ::bliss::io::IOException);
+
+  ::bliss::io::header_resolver resolver(filename);
+  EXPECT_THROW(resolver.resolve(1), ::bliss::io::IOException);            // inside a header
+  EXPECT_THROW(resolver.resolve(data.size()), ::bliss::io::IOException);  // past the end
+
+  // FASTA headers, last one without a line end.
+  std::string fa("test_header_resolver.fasta");
+  {
+    std::ofstream out(fa, std::ios::binary);
+    out << ">chr1 first\nACGT\nACGT\n>chr2";
+  }
+  ::bliss::io::header_resolver fasta(fa);
+  EXPECT_EQ("chr1 first", fasta.resolve(0));
+  EXPECT_EQ("chr2", fasta.resolve(22));
+  std::remove(fa.c_str());
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "common/sequence.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/kmer_parser.hpp"
+#include "index/kmer_hash.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+#include <set>
+#include <algorithm>
+
+
+class MinimizerPositionParserTest : public ::testing::Test
+{
+  protected:
+    using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA, uint64_t>;
+    using TupleType = ::std::pair<KmerType, ::bliss::common::ShortSequenceKmerId>;
+    using SeqType = ::bliss::io::FASTQSequence<std::string::const_iterator>;
+
+    std::string seq;
+    std::string qual;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<int> base_dist(0, 3);
+      char const * alpha = "ACGT";
+      for (size_t i = 0; i < 500; ++i) {
+        seq.push_back(alpha[base_dist(generator)]);
+        qual.push_back('I');
+      }
+    }
+
+    template <typename Parser>
+    std::vector<TupleType> parse() {
+      SeqType read(::bliss::common::SequenceId(), seq.size(), 0, seq.cbegin(), seq.cend(), qual.cbegin(), qual.cend());
+      Parser parser(::bliss::partition::range<size_t>(0, seq.size()));
+
+      std::vector<TupleType> out;
+      ::fsc::back_emplace_iterator<std::vector<TupleType> > emplace_iter(out);
+      parser(read, emplace_iter);
+      return out;
+    }
+
+    /// leftmost minimum of each window of w kmers, by brute force, without repeats.
+    static std::vector<size_t> expected(std::vector<TupleType> const & all, size_t w) {
+      ::bliss::kmer::hash::murmur64<KmerType, false> hash;
+      std::vector<size_t> out;
+      w = std::min(w, all.size());
+      for (size_t s = 0; s + w <= all.size(); ++s) {
+        size_t best = s;
+        for (size_t i = s; i < s + w; ++i) {
+          KmerType ki = std::min(all[i].first, all[i].first.reverse_complement());
+          KmerType kb = std::min(all[best].first, all[best].first.reverse_complement());
+          if (hash(ki) < hash(kb)) best = i;
+        }
+        if (out.empty() || (out.back() != best)) out.push_back(best);
+      }
+      return out;
+    }
+};
+
+
+TEST_F(MinimizerPositionParserTest, window_minimizers)
+{
+  std::vector<TupleType> all = parse<::bliss::index::kmer::KmerPositionTupleParser<TupleType> >();
+  std::vector<TupleType> sampled = parse<::bliss::index::kmer::KmerPositionMinimizerTupleParser<TupleType, 10> >();
+  ASSERT_EQ(seq.size() - KmerType::size + 1, all.size());
+
+  std::vector<size_t> gold = expected(all, 10);
+  ASSERT_EQ(gold.size(), sampled.size());
+  for (size_t i = 0; i < gold.size(); ++i) {
+    EXPECT_EQ(all[gold[i]].first, sampled[i].first);
+    EXPECT_EQ(all[gold[i]].second.get_pos(), sampled[i].second.get_pos());
+  }
+
+  // about 2/(w+1) of the kmers.
+  EXPECT_LT(sampled.size(), all.size() / 3);
+  EXPECT_GT(sampled.size(), all.size() / 10);
+}
+
+TEST_F(MinimizerPositionParserTest, every_kmer)
+{
+  std::vector<TupleType> all = parse<::bliss::index::kmer::KmerPositionTupleParser<TupleType> >();
+  std::vector<TupleType> sampled = parse<::bliss::index::kmer::KmerPositionMinimizerTupleParser<TupleType, 1> >();
+  ASSERT_EQ(all.size(), sampled.size());
+  for (size_t i = 0; i < all.size(); ++i) {
+    EXPECT_EQ(all[i].first, sampled[i].first);
+  }
+}
+
+TEST_F(MinimizerPositionParserTest, strand_independent)
+{
+  using Parser = ::bliss::index::kmer::KmerPositionMinimizerTupleParser<TupleType, 10>;
+  std::vector<TupleType> all = parse<::bliss::index::kmer::KmerPositionTupleParser<TupleType> >();
+
+  // the kmers of the reverse complement, in order.
+  std::vector<KmerType> fwd, rev;
+  for (auto const & t : all) fwd.push_back(t.first);
+  for (auto it = fwd.rbegin(); it != fwd.rend(); ++it) rev.push_back(it->reverse_complement());
+
+  std::set<KmerType> a, b;
+  for (size_t o : Parser::sample_offsets(fwd)) a.insert(std::min(fwd[o], fwd[o].reverse_complement()));
+  for (size_t o : Parser::sample_offsets(rev)) b.insert(std::min(rev[o], rev[o].reverse_complement()));
+  EXPECT_EQ(a, b);
+
+  // a short read keeps its minimum.
+  std::vector<KmerType> few(fwd.begin(), fwd.begin() + 4);
+  EXPECT_EQ(1UL, Parser::sample_offsets(few).size());
+  EXPECT_TRUE(Parser::sample_offsets(std::vector<KmerType>()).empty());
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "common/sequence.hpp"
+#include "io/kmer_parser.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+#include <tuple>
+
+
+class MultiKmerParserTest : public ::testing::Test
+{
+  protected:
+    using Kmer15 = ::bliss::common::Kmer<15, ::bliss::common::DNA, uint64_t>;
+    using Kmer31 = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+    using Kmer41 = ::bliss::common::Kmer<41, ::bliss::common::DNA, uint64_t>;
+    using ParserType = ::bliss::index::kmer::MultiKmerParser<Kmer31, Kmer15, Kmer41>;
+    using SeqType = ::bliss::common::Sequence<std::string::const_iterator>;
+
+    /// reads of 200 (in lines of 60) and 35 characters.
+    std::string data;
+    std::vector<std::pair<size_t, size_t> > reads;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<int> base_dist(0, 3);
+      char const * alpha = "ACGT";
+
+      size_t lengths[] = {200, 35};
+      for (size_t r = 0; r < 2; ++r) {
+        size_t start = data.size();
+        for (size_t i = 0; i < lengths[r]; ++i) {
+          data.push_back(alpha[base_dist(generator)]);
+          if ((i % 60) == 59) data.push_back('\n');
+        }
+        reads.emplace_back(start, data.size());
+        data.push_back('\n');
+      }
+    }
+
+    SeqType read(size_t i) const {
+      return SeqType(::bliss::common::SequenceId(reads[i].first, i), reads[i].second - reads[i].first, 0, 0,
+                     data.cbegin() + reads[i].first, data.cbegin() + reads[i].second);
+    }
+
+    template <typename KmerType>
+    std::vector<KmerType> gold(::bliss::partition::range<size_t> const & valid) const {
+      std::vector<KmerType> out;
+      ::fsc::back_emplace_iterator<std::vector<KmerType> > emplace_iter(out);
+      ::bliss::index::kmer::KmerParser<KmerType> parser(valid);
+      for (size_t i = 0; i < reads.size(); ++i) emplace_iter = parser(read(i), emplace_iter);
+      return out;
+    }
+
+    void check(::bliss::partition::range<size_t> const & valid) const {
+      ParserType parser(valid);
+      ParserType::buffer_type buffers;
+      for (size_t i = 0; i < reads.size(); ++i) parser(read(i), buffers);
+
+      EXPECT_EQ(gold<Kmer31>(valid), std::get<0>(buffers));
+      EXPECT_EQ(gold<Kmer15>(valid), std::get<1>(buffers));
+      EXPECT_EQ(gold<Kmer41>(valid), std::get<2>(buffers));
+      EXPECT_FALSE(std::get<2>(buffers).empty());
+
+      size_t n = std::get<0>(buffers).size() + std::get<1>(buffers).size() + std::get<2>(buffers).size();
+      EXPECT_EQ(n, ParserType::size(buffers));
+      EXPECT_EQ(std::get<0>(buffers).size() * sizeof(Kmer31) + std::get<1>(buffers).size() * sizeof(Kmer15) +
+                std::get<2>(buffers).size() * sizeof(Kmer41), ParserType::bytes(buffers));
+      ParserType::clear(buffers);
+      EXPECT_EQ(0UL, ParserType::size(buffers));
+    }
+};
+
+
+TEST_F(MultiKmerParserTest, same_as_kmer_parser)
+{
+  EXPECT_EQ(41UL, ParserType::window_size);
+  // whole reads.  the short read has kmers for k = 15 and 31 only.
+  check(::bliss::partition::range<size_t>(0, data.size()));
+  // the first read crosses the end of the valid range, so each k keeps its own k - 1 characters of overlap.
+  check(::bliss::partition::range<size_t>(0, 100));
+  check(::bliss::partition::range<size_t>(30, 150));
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "common/sequence.hpp"
+#include "io/kmer_parser.hpp"
+#include "io/packed_read_store.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+#include <utility>
+
+
+class PackedReadStoreTest : public ::testing::Test
+{
+  protected:
+    using SeqType = ::bliss::common::Sequence<std::string::const_iterator>;
+    using StoreType = ::bliss::index::kmer::PackedReadStore<::bliss::common::DNA, 63>;
+
+    /// 2 reads, the second in lines of 60 characters, with an N.
+    std::string data;
+    std::vector<std::pair<size_t, size_t> > reads;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<int> base_dist(0, 3);
+      char const * alpha = "ACGT";
+
+      size_t start = data.size();
+      for (size_t i = 0; i < 150; ++i) data.push_back(alpha[base_dist(generator)]);
+      reads.emplace_back(start, data.size());
+
+      data.push_back('\n');
+      start = data.size();
+      for (size_t i = 0; i < 400; ++i) {
+        data.push_back((i == 97) ? 'N' : alpha[base_dist(generator)]);
+        if ((i % 60) == 59) data.push_back('\n');
+      }
+      reads.emplace_back(start, data.size());
+    }
+
+    SeqType read(size_t i) const {
+      return SeqType(::bliss::common::SequenceId(reads[i].first, i), reads[i].second - reads[i].first, 0, 0,
+                     data.cbegin() + reads[i].first, data.cbegin() + reads[i].second);
+    }
+
+    template <typename KmerType>
+    std::vector<KmerType> parse(::bliss::partition::range<size_t> const & valid) const {
+      ::bliss::index::kmer::KmerParser<KmerType> parser(valid);
+      std::vector<KmerType> out;
+      ::fsc::back_emplace_iterator<std::vector<KmerType> > emplace_iter(out);
+      for (size_t i = 0; i < reads.size(); ++i) emplace_iter = parser(read(i), emplace_iter);
+      return out;
+    }
+
+    void pack(::bliss::partition::range<size_t> const & valid, StoreType & store) const {
+      StoreType::parser_type parser(valid);
+      std::vector<uint64_t> out;
+      ::fsc::back_emplace_iterator<std::vector<uint64_t> > emplace_iter(out);
+      for (size_t i = 0; i < reads.size(); ++i) emplace_iter = parser(read(i), emplace_iter);
+      store.assign(std::move(out));
+    }
+
+    template <typename KmerType>
+    void check(::bliss::partition::range<size_t> const & valid) {
+      StoreType store;
+      pack(valid, store);
+
+      std::vector<KmerType> expected = parse<KmerType>(valid);
+      std::vector<KmerType> result;
+      ::fsc::back_emplace_iterator<std::vector<KmerType> > emplace_iter(result);
+      store.template generate<KmerType>(emplace_iter);
+
+      EXPECT_EQ(expected.size(), store.template kmer_count<KmerType>());
+      ASSERT_EQ(expected.size(), result.size());
+      for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], result[i]) << "kmer " << i << " of " << expected.size();
+      }
+    }
+};
+
+
+TEST_F(PackedReadStoreTest, whole)
+{
+  ::bliss::partition::range<size_t> valid(0, data.size());
+
+  check<::bliss::common::Kmer<21, ::bliss::common::DNA, uint64_t> >(valid);
+  check<::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t> >(valid);
+  check<::bliss::common::Kmer<32, ::bliss::common::DNA, uint64_t> >(valid);
+  check<::bliss::common::Kmer<63, ::bliss::common::DNA, uint64_t> >(valid);
+  check<::bliss::common::Kmer<5, ::bliss::common::DNA, uint8_t> >(valid);
+
+  StoreType store;
+  pack(valid, store);
+  EXPECT_EQ(2UL, store.reads());
+}
+
+TEST_F(PackedReadStoreTest, partitioned)
+{
+  // split inside the first read, and inside the second read near a line end.
+  size_t splits[] = {0, 100, 300, data.size()};
+  for (size_t p = 0; p < 3; ++p) {
+    ::bliss::partition::range<size_t> valid(splits[p], splits[p + 1]);
+
+    check<::bliss::common::Kmer<21, ::bliss::common::DNA, uint64_t> >(valid);
+    check<::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t> >(valid);
+    check<::bliss::common::Kmer<63, ::bliss::common::DNA, uint64_t> >(valid);
+  }
+}
+
+TEST_F(PackedReadStoreTest, dna16)
+{
+  using Store16 = ::bliss::index::kmer::PackedReadStore<::bliss::common::DNA16, 31>;
+  using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA16, uint64_t>;
+  ::bliss::partition::range<size_t> valid(50, 400);
+
+  Store16::parser_type parser(valid);
+  std::vector<uint64_t> packed;
+  ::fsc::back_emplace_iterator<std::vector<uint64_t> > emplace_iter(packed);
+  for (size_t i = 0; i < reads.size(); ++i) emplace_iter = parser(read(i), emplace_iter);
+  Store16 store;
+  store.assign(std::move(packed));
+
+  std::vector<KmerType> expected = parse<KmerType>(valid);
+  std::vector<KmerType> result;
+  ::fsc::back_emplace_iterator<std::vector<KmerType> > out_iter(result);
+  store.template generate<KmerType>(out_iter);
+
+  ASSERT_EQ(expected.size(), result.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], result[i]);
+  }
+}
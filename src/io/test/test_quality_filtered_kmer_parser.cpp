@@ -0,0 +1,143 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "io/fastq_loader.hpp"
+#include "io/kmer_parser.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <iterator>
+
+
+class QualityFilteredKmerParserTest : public ::testing::Test
+{
+  protected:
+    using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA, uint64_t>;
+    using SeqType = ::bliss::io::FASTQSequence<std::string::const_iterator>;
+
+    std::string seq;
+    std::string qual;
+
+    virtual void SetUp()
+    {
+      // mostly high quality, with some low quality bases and a Q0 base.
+      std::default_random_engine generator;
+      std::uniform_int_distribution<int> base_dist(0, 3);
+      std::uniform_int_distribution<int> qual_dist(2, 41);
+      char const * alpha = "ACGT";
+      for (size_t i = 0; i < 300; ++i) {
+        seq.push_back(alpha[base_dist(generator)]);
+        int q = ((i % 50) < 40) ? 38 : qual_dist(generator);
+        if (i == 250) q = 0;
+        qual.push_back(static_cast<char>(33 + q));
+      }
+    }
+
+    /// kmers of seq that pass the thresholds, computed directly.
+    std::vector<KmerType> expected(int min_base, int min_kmer) {
+      std::vector<KmerType> out;
+      double min_prob = 1.0 - std::pow(10.0, min_kmer / -10.0);
+      for (size_t i = 0; i + KmerType::size <= seq.size(); ++i) {
+        bool ok = true;
+        double prob = 1.0;
+        for (size_t j = i; j < i + KmerType::size; ++j) {
+          int q = qual[j] - 33;
+          ok &= (q >= min_base) && (q > 0);
+          prob *= 1.0 - std::pow(10.0, q / -10.0);
+        }
+        if (!ok || (prob < min_prob * (1.0 + 1e-9))) continue;  // stay away from the rounding boundary
+
+        KmerType kmer;
+        for (size_t j = i; j < i + KmerType::size; ++j) kmer.nextFromChar(::bliss::common::DNA::FROM_ASCII[static_cast<unsigned char>(seq[j])]);
+        out.push_back(kmer);
+      }
+      return out;
+    }
+
+    template <typename Parser>
+    std::vector<KmerType> parse() {
+      SeqType read(::bliss::common::SequenceId(), seq.size(), 0, seq.cbegin(), seq.cend(), qual.cbegin(), qual.cend());
+      Parser parser(::bliss::partition::range<size_t>(0, seq.size()));
+
+      std::vector<KmerType> out;
+      ::fsc::back_emplace_iterator<std::vector<KmerType> > emplace_iter(out);
+      parser(read, emplace_iter);
+      return out;
+    }
+};
+
+
+TEST_F(QualityFilteredKmerParserTest, min_base)
+{
+  std::vector<KmerType> out = parse<::bliss::index::kmer::QualityFilteredKmerParser<KmerType, 20> >();
+  std::vector<KmerType> gold = expected(20, 0);
+  EXPECT_GT(gold.size(), 0UL);
+  EXPECT_LT(gold.size(), seq.size() - KmerType::size + 1);
+  EXPECT_EQ(gold, out);
+}
+
+TEST_F(QualityFilteredKmerParserTest, min_base_and_kmer)
+{
+  std::vector<KmerType> out = parse<::bliss::index::kmer::QualityFilteredKmerParser<KmerType, 10, 15> >();
+  std::vector<KmerType> gold = expected(10, 15);
+  EXPECT_GT(gold.size(), 0UL);
+  EXPECT_EQ(gold, out);
+}
+
+TEST_F(QualityFilteredKmerParserTest, no_threshold)
+{
+  // only the kmers with the Q0 base are dropped.
+  std::vector<KmerType> out = parse<::bliss::index::kmer::QualityFilteredKmerParser<KmerType, 0, 0> >();
+  EXPECT_EQ(seq.size() - KmerType::size + 1 - KmerType::size, out.size());
+  EXPECT_EQ(expected(0, 0), out);
+}
+
+TEST_F(QualityFilteredKmerParserTest, quantized_pos_qual)
+{
+  // the pos-qual parser with quantized qualities gives the same kmers and positions, and qualities within the quantization error.
+  using IdType = ::bliss::common::ShortSequenceKmerId;
+  SeqType read(::bliss::common::SequenceId(), seq.size(), 0, seq.cbegin(), seq.cend(), qual.cbegin(), qual.cend());
+  ::bliss::partition::range<size_t> range(0, seq.size());
+
+  using GoldTuple = std::pair<KmerType, std::pair<IdType, double> >;
+  std::vector<GoldTuple> gold;
+  ::fsc::back_emplace_iterator<std::vector<GoldTuple> > gold_iter(gold);
+  ::bliss::index::kmer::KmerPositionQualityTupleParser<GoldTuple>(range)(read, gold_iter);
+
+  using Q = ::bliss::index::QuantizedQuality8;
+  using Tuple = std::pair<KmerType, std::pair<IdType, Q> >;
+  std::vector<Tuple> out;
+  ::fsc::back_emplace_iterator<std::vector<Tuple> > emplace_iter(out);
+  ::bliss::index::kmer::KmerPositionQualityTupleParser<Tuple>(range)(read, emplace_iter);
+
+  ASSERT_EQ(gold.size(), out.size());
+  for (size_t i = 0; i < gold.size(); ++i) {
+    EXPECT_EQ(gold[i].first, out[i].first);
+    EXPECT_EQ(gold[i].second.first, out[i].second.first);
+    if (gold[i].second.second == 0.0) EXPECT_EQ(Q::incorrect, out[i].second.second.code);
+    else EXPECT_NEAR(1.0, out[i].second.second.probability() / gold[i].second.second, 0.0055);
+  }
+}
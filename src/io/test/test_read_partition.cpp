@@ -0,0 +1,185 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "common/sequence.hpp"
+#include "io/read_partition.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+
+
+class ReadPartitionTest : public ::testing::Test
+{
+  protected:
+    using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA, uint64_t>;
+    using PartitionType = ::bliss::index::kmer::MinimizerReadPartition<KmerType>;
+
+    /// a sequence with quality characters, as FASTQSequence.
+    struct QualSeqType : public ::bliss::common::Sequence<std::string::const_iterator> {
+      using BaseType = ::bliss::common::Sequence<std::string::const_iterator>;
+      std::string::const_iterator qual_begin;
+      std::string::const_iterator qual_end;
+
+      QualSeqType(BaseType const & seq, std::string::const_iterator const & _qual_begin, std::string::const_iterator const & _qual_end) :
+        BaseType(seq), qual_begin(_qual_begin), qual_end(_qual_end) {}
+
+      static constexpr bool has_quality() { return true; }
+    };
+
+    /// reads of 150, 400 (in lines of 60), 15 (too short for k = 21), and 100 characters.  quality in the same layout.
+    std::string data;
+    std::string qual;
+    std::vector<std::pair<size_t, size_t> > reads;
+
+    virtual void SetUp()
+    {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<int> base_dist(0, 3);
+      std::uniform_int_distribution<int> qual_dist(33, 73);
+      char const * alpha = "ACGT";
+
+      size_t lengths[] = {150, 400, 15, 100};
+      for (size_t r = 0; r < 4; ++r) {
+        size_t start = data.size();
+        for (size_t i = 0; i < lengths[r]; ++i) {
+          data.push_back(alpha[base_dist(generator)]);
+          qual.push_back(static_cast<char>(qual_dist(generator)));
+          if ((r == 1) && ((i % 60) == 59)) {
+            data.push_back('\n');
+            qual.push_back('\n');
+          }
+        }
+        reads.emplace_back(start, data.size());
+        data.push_back('\n');
+        qual.push_back('\n');
+      }
+    }
+
+    ::bliss::common::Sequence<std::string::const_iterator> read(size_t i) const {
+      return ::bliss::common::Sequence<std::string::const_iterator>(::bliss::common::SequenceId(reads[i].first, i),
+                     reads[i].second - reads[i].first, 0, 0, data.cbegin() + reads[i].first, data.cbegin() + reads[i].second);
+    }
+
+    QualSeqType qual_read(size_t i) const {
+      return QualSeqType(read(i), qual.cbegin() + reads[i].first, qual.cbegin() + reads[i].second);
+    }
+
+    static std::string no_eol(std::string const & s) {
+      std::string result;
+      for (char c : s) if (c != '\n') result.push_back(c);
+      return result;
+    }
+
+    std::string expected_seq(size_t i) const {
+      return no_eol(data.substr(reads[i].first, reads[i].second - reads[i].first));
+    }
+    std::string expected_qual(size_t i) const {
+      return no_eol(qual.substr(reads[i].first, reads[i].second - reads[i].first));
+    }
+
+    static std::string reverse_complement(std::string const & s) {
+      std::string result(s.rbegin(), s.rend());
+      for (char & c : result) c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+      return result;
+    }
+};
+
+
+TEST_F(ReadPartitionTest, pack)
+{
+  PartitionType::parser_type parser(::bliss::partition::range<size_t>(0, data.size()));
+  std::vector<uint64_t> packed;
+  ::fsc::back_emplace_iterator<std::vector<uint64_t> > emplace_iter(packed);
+  for (size_t i = 0; i < reads.size(); ++i) emplace_iter = parser(qual_read(i), emplace_iter);
+
+  PartitionType part;
+  part.assign(std::move(packed));
+
+  // the short read is dropped.
+  ASSERT_EQ(3UL, part.reads());
+  size_t kept[] = {0, 1, 3};
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(part.has_quality(i));
+    EXPECT_EQ(expected_seq(kept[i]).size(), part.length(i));
+    EXPECT_EQ(expected_seq(kept[i]), part.sequence(i));
+    EXPECT_EQ(expected_qual(kept[i]), part.quality(i));
+  }
+}
+
+TEST_F(ReadPartitionTest, no_quality)
+{
+  // only the reads that start in the valid range, whole.
+  PartitionType::parser_type parser(::bliss::partition::range<size_t>(100, reads[3].first));
+  std::vector<uint64_t> packed;
+  ::fsc::back_emplace_iterator<std::vector<uint64_t> > emplace_iter(packed);
+  for (size_t i = 0; i < reads.size(); ++i) emplace_iter = parser(read(i), emplace_iter);
+
+  PartitionType part;
+  part.assign(std::move(packed));
+
+  ASSERT_EQ(1UL, part.reads());
+  EXPECT_FALSE(part.has_quality(0));
+  EXPECT_EQ(expected_seq(1), part.sequence(0));
+  EXPECT_EQ(std::string(), part.quality(0));
+}
+
+TEST_F(ReadPartitionTest, minimizer)
+{
+  // a read and its reverse complement have the same minimizer, so the same owner.
+  std::string fw = expected_seq(1);
+  std::string rc = reverse_complement(fw);
+  std::string both = fw + "\n" + rc;
+
+  using SeqType = ::bliss::common::Sequence<std::string::const_iterator>;
+  SeqType fw_seq(::bliss::common::SequenceId(0, 0), fw.size(), 0, 0, both.cbegin(), both.cbegin() + fw.size());
+  SeqType rc_seq(::bliss::common::SequenceId(fw.size() + 1, 1), rc.size(), 0, 0, both.cbegin() + fw.size() + 1, both.cend());
+
+  PartitionType::parser_type parser(::bliss::partition::range<size_t>(0, both.size()));
+  std::vector<uint64_t> packed;
+  ::fsc::back_emplace_iterator<std::vector<uint64_t> > emplace_iter(packed);
+  emplace_iter = parser(fw_seq, emplace_iter);
+  emplace_iter = parser(rc_seq, emplace_iter);
+
+  PartitionType part;
+  part.assign(std::move(packed));
+  ASSERT_EQ(2UL, part.reads());
+  EXPECT_EQ(rc, part.sequence(1));
+  EXPECT_EQ(part.minimizer(0), part.minimizer(1));
+  for (int p = 1; p < 10; ++p) {
+    EXPECT_EQ(PartitionType::owner(part.minimizer(0), p), PartitionType::owner(part.minimizer(1), p));
+  }
+
+  // the minimizer is at most the hash of any of the read's M-mers.
+  std::vector<uint8_t> codes(fw.size());
+  ::bliss::common::ASCII2Bulk<::bliss::common::DNA>()(reinterpret_cast<unsigned char const *>(fw.data()), fw.size(), codes.data());
+  uint64_t whole = PartitionType::parser_type::minimizer(codes.data(), codes.size());
+  EXPECT_EQ(whole, part.minimizer(0));
+  for (size_t i = 0; i + 30 <= codes.size(); i += 30) {
+    EXPECT_LE(whole, PartitionType::parser_type::minimizer(codes.data() + i, 30));
+  }
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), PartitionType::parser_type::minimizer(codes.data(), 11));
+}
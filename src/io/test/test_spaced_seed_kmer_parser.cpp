@@ -0,0 +1,134 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include "bliss-config.hpp"
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "common/sequence.hpp"
+#include "io/kmer_parser.hpp"
+#include "containers/fsc_container_utils.hpp"
+
+#include <random>
+#include <vector>
+#include <string>
+
+
+namespace {
+  using SeqType = ::bliss::common::Sequence<std::string::const_iterator>;
+
+  /// 300 random bases, in lines of 60.
+  std::string random_bases(char const * alpha, int const n_chars) {
+    std::string seq;
+    std::default_random_engine generator;
+    std::uniform_int_distribution<int> base_dist(0, n_chars - 1);
+    for (size_t i = 0; i < 300; ++i) {
+      seq.push_back(alpha[base_dist(generator)]);
+      if ((i % 60) == 59) seq.push_back('\n');
+    }
+    return seq;
+  }
+
+  template <typename Parser>
+  std::vector<typename Parser::kmer_type> parse(std::string const & seq) {
+    SeqType read(::bliss::common::SequenceId(0, 0), seq.size(), 0, 0, seq.cbegin(), seq.cend());
+    ::bliss::partition::range<size_t> valid(0, seq.size());
+
+    std::vector<typename Parser::kmer_type> seeds;
+    ::fsc::back_emplace_iterator<std::vector<typename Parser::kmer_type> > iter(seeds);
+    Parser parser(valid);
+    parser(read, iter);
+    return seeds;
+  }
+
+  /// the seeds, 1 character at a time.
+  template <typename KmerType, uint64_t Mask>
+  std::vector<KmerType> expected_seeds(std::string const & seq) {
+    using Alphabet = typename KmerType::KmerAlphabet;
+    std::string bases;
+    for (char c : seq) if (c != '\n') bases.push_back(c);
+
+    size_t span = ::bliss::index::kmer::spaced_seed_span(Mask);
+    std::vector<KmerType> seeds;
+    for (size_t p = 0; p + span <= bases.size(); ++p) {
+      KmerType seed;
+      for (size_t i = 0; i < span; ++i) {
+        if ((Mask >> i) & 1) seed.nextFromChar(Alphabet::FROM_ASCII[static_cast<size_t>(bases[p + i])]);
+      }
+      seeds.push_back(seed);
+    }
+    return seeds;
+  }
+}
+
+
+TEST(SpacedSeedKmerParser, codon_seed)
+{
+  constexpr uint64_t mask = 0xDB;  // 11011011, weight 6 over 8.
+  using KmerType = ::bliss::common::Kmer<6, ::bliss::common::DNA, uint64_t>;
+  using Parser = ::bliss::index::kmer::SpacedSeedKmerParser<KmerType, mask>;
+  static_assert(Parser::window_size == 8, "span of the codon seed");
+
+  std::string seq = random_bases("ACGT", 4);
+  std::vector<KmerType> seeds = parse<Parser>(seq);
+  std::vector<KmerType> expected = expected_seeds<KmerType, mask>(seq);
+
+  ASSERT_EQ(300UL - 8 + 1, seeds.size());
+  EXPECT_EQ(expected, seeds);
+}
+
+TEST(SpacedSeedKmerParser, wide_seed_dna5)
+{
+  // weight 12 over 21, 3 bits per character:  63 bits of window.
+  constexpr uint64_t mask = 0x1A5A5B;
+  using KmerType = ::bliss::common::Kmer<12, ::bliss::common::DNA5, uint64_t>;
+  using Parser = ::bliss::index::kmer::SpacedSeedKmerParser<KmerType, mask>;
+  static_assert(Parser::window_size == 21, "span of the seed");
+
+  std::string seq = random_bases("ACGTN", 5);
+  EXPECT_EQ((expected_seeds<KmerType, mask>(seq)), parse<Parser>(seq));
+}
+
+TEST(SpacedSeedKmerParser, contiguous_mask)
+{
+  // all care positions:  the same as KmerParser.
+  using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+  using Parser = ::bliss::index::kmer::SpacedSeedKmerParser<KmerType, 0x7FFFFFFFULL>;
+
+  std::string seq = random_bases("ACGT", 4);
+  EXPECT_EQ(parse<::bliss::index::kmer::KmerParser<KmerType> >(seq), parse<Parser>(seq));
+}
+
+TEST(SpacedSeedKmerParser, dont_care_error)
+{
+  constexpr uint64_t mask = 0xDB;
+  using KmerType = ::bliss::common::Kmer<6, ::bliss::common::DNA, uint64_t>;
+  using Parser = ::bliss::index::kmer::SpacedSeedKmerParser<KmerType, mask>;
+
+  // a substitution at a don't care position (2) of the only window keeps the seed.
+  std::string seq("ACGTACGT");
+  std::string err("ACTTACGT");
+  std::vector<KmerType> a = parse<Parser>(seq);
+  std::vector<KmerType> b = parse<Parser>(err);
+  ASSERT_EQ(1UL, a.size());
+  EXPECT_EQ(a, b);
+
+  // and at a care position (3) changes it.
+  std::string care_err("ACGAACGT");
+  EXPECT_NE(a, parse<Parser>(care_err));
+}
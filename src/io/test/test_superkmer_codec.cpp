@@ -0,0 +1,113 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+#include "io/superkmer_codec.hpp"
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+
+#include <random>
+#include <algorithm>
+#include <cstdint>  // uint64_t
+#include <vector>
+
+
+template <typename T>
+class SuperKmerCodecTest : public ::testing::Test
+{
+  protected:
+    /// kmers of a random sequence, in order, optionally canonical.  every 100th kmer starts a new read.
+    std::vector<T> reads(bool canonical) {
+      std::default_random_engine generator;
+      std::uniform_int_distribution<int> distribution(0, T::KmerAlphabet::SIZE - 1);
+
+      std::vector<T> out;
+      T km;
+      for (size_t r = 0; r < 50; ++r) {
+        for (unsigned int i = 0; i < T::size; ++i) km.nextFromChar(distribution(generator));
+        for (size_t i = 0; i < 100; ++i) {
+          T rc = km.reverse_complement();
+          out.push_back((canonical && (rc < km)) ? rc : km);
+          km.nextFromChar(distribution(generator));
+        }
+      }
+      return out;
+    }
+
+    /// @return encoded bytes
+    size_t roundtrip(std::vector<T> const & kmers) {
+      std::vector<uint8_t> bytes;
+      size_t nbytes = ::imxx::codec::superkmer::encode(kmers.data(), kmers.size(), bytes);
+      EXPECT_EQ(bytes.size(), nbytes);
+      EXPECT_LE(nbytes, ::imxx::codec::superkmer::max_encoded_bytes<T>(kmers.size()));
+
+      std::vector<T> decoded;
+      size_t n = ::imxx::codec::superkmer::decode(bytes.data(), bytes.size(), decoded);
+      EXPECT_EQ(kmers.size(), n);
+      EXPECT_TRUE((kmers.size() == decoded.size()) && std::equal(kmers.begin(), kmers.end(), decoded.begin()));
+      return nbytes;
+    }
+};
+
+typedef ::testing::Types<
+    ::bliss::common::Kmer<31, bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<21, bliss::common::DNA, uint16_t>,
+    ::bliss::common::Kmer<63, bliss::common::DNA, uint64_t>,
+    ::bliss::common::Kmer<21, bliss::common::DNA5, uint64_t>,
+    ::bliss::common::Kmer<15, bliss::common::DNA16, uint64_t> > SuperKmerCodecTestTypes;
+TYPED_TEST_CASE(SuperKmerCodecTest, SuperKmerCodecTestTypes);
+
+
+TYPED_TEST(SuperKmerCodecTest, forward)
+{
+  // kmers of reads need about 1 byte each.
+  std::vector<TypeParam> kmers = this->reads(false);
+  EXPECT_LT(this->roundtrip(kmers) * 4, kmers.size() * sizeof(TypeParam));
+}
+
+TYPED_TEST(SuperKmerCodecTest, canonical)
+{
+  std::vector<TypeParam> kmers = this->reads(true);
+  EXPECT_LT(this->roundtrip(kmers) * 4, kmers.size() * sizeof(TypeParam));
+}
+
+TYPED_TEST(SuperKmerCodecTest, reversed)
+{
+  // kmers of a read in reverse order use the high end shift.
+  std::vector<TypeParam> kmers = this->reads(false);
+  std::reverse(kmers.begin(), kmers.end());
+  this->roundtrip(kmers);
+}
+
+TYPED_TEST(SuperKmerCodecTest, unordered)
+{
+  // no runs.  also several segments appended to the same buffer.
+  std::vector<TypeParam> kmers = this->reads(true);
+  std::shuffle(kmers.begin(), kmers.end(), std::default_random_engine());
+
+  std::vector<uint8_t> bytes;
+  size_t first = ::imxx::codec::superkmer::encode(kmers.data(), kmers.size() / 2, bytes);
+  ::imxx::codec::superkmer::encode(kmers.data() + kmers.size() / 2, kmers.size() - kmers.size() / 2, bytes);
+  EXPECT_EQ(0UL, ::imxx::codec::superkmer::encode(kmers.data(), 0, bytes));
+
+  std::vector<TypeParam> decoded;
+  EXPECT_EQ(kmers.size() / 2, ::imxx::codec::superkmer::decode(bytes.data(), first, decoded));
+  ::imxx::codec::superkmer::decode(bytes.data() + first, bytes.size() - first, decoded);
+  ASSERT_EQ(kmers.size(), decoded.size());
+  EXPECT_TRUE(std::equal(kmers.begin(), kmers.end(), decoded.begin()));
+}
@@ -19,7 +19,7 @@
  * @ingroup   io
  * @author  Tony Pan <tpan7@gatech.edu>
  *
- * @brief     helper function to replicate file descriptor across all processes on the same node.
+ * @brief     helper function to replicate file descriptor across all processes on the same node, and stream socket helpers.
  * @details   based on information from
  *            http://www.microhowto.info/howto/listen_for_and_receive_udp_datagrams_in_c.html
  *            http://stackoverflow.com/questions/27014955/socket-connect-vs-bind
@@ -45,9 +45,14 @@
 
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <cerrno>
+#include <string>
+#include <sstream>
 
 #include <mxx/comm.hpp>
 
+#include "io/io_exception.hpp"
+
 namespace bliss {
 
   namespace io {
@@ -280,6 +285,78 @@ namespace bliss {
 
 
 
+      /// create a listening stream socket at name (see make_address), for a server that accepts many clients.
+      static int listen_stream(::std::string const & name, int const & backlog = 64) {
+        int socket_fd;
+        if ((socket_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+          perror("server: socket");
+          throw ::bliss::io::IOException("ERROR: unable to create stream socket");
+        }
+
+        socklen_t address_length;
+        struct sockaddr_un address = make_address(name, address_length);
+        if (bind(socket_fd, (const struct sockaddr *) &address, address_length) < 0) {
+          close(socket_fd);
+          perror("server: bind");
+          throw ::bliss::io::IOException("ERROR: unable to bind stream socket to server address");
+        }
+        if (listen(socket_fd, backlog) < 0) {
+          close(socket_fd);
+          perror("server: listen");
+          throw ::bliss::io::IOException("ERROR: unable to listen on stream socket");
+        }
+        return socket_fd;
+      }
+
+      /// connect a stream socket to the server listening at name.  returns -1 if there is no server.
+      static int connect_stream(::std::string const & name) {
+        int socket_fd;
+        if ((socket_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+          perror("client: socket");
+          throw ::bliss::io::IOException("ERROR: unable to create stream socket");
+        }
+
+        socklen_t address_length;
+        struct sockaddr_un address = make_address(name, address_length);
+        if (connect(socket_fd, (const struct sockaddr *) &address, address_length) < 0) {
+          close(socket_fd);
+          return -1;
+        }
+        return socket_fd;
+      }
+
+      /// write all bytes to a stream socket.  returns false if the peer is gone.
+      static bool send_all(int const & socket_fd, void const * data, size_t bytes) {
+        char const * ptr = reinterpret_cast<char const *>(data);
+        while (bytes > 0) {
+          ssize_t sent = send(socket_fd, ptr, bytes, MSG_NOSIGNAL);
+          if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+          }
+          ptr += sent;
+          bytes -= sent;
+        }
+        return true;
+      }
+
+      /// read exactly bytes from a stream socket.  returns false on end of stream or error.
+      static bool recv_all(int const & socket_fd, void * data, size_t bytes) {
+        char * ptr = reinterpret_cast<char *>(data);
+        while (bytes > 0) {
+          ssize_t got = recv(socket_fd, ptr, bytes, 0);
+          if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+          }
+          if (got == 0) return false;
+          ptr += got;
+          bytes -= got;
+        }
+        return true;
+      }
+
+
       /// broadcast fd from rank 0 to all other processes on the same node, log iterations.
       static void broadcast_file_descriptor(int & fd, int const & id,  int const & nprocs, int const & rank) {
 
@@ -27,6 +27,8 @@
 
 #include <iterator>
 #include <algorithm>
+#include <utility>
+#include <type_traits>
 
 namespace bliss
 {
@@ -86,6 +88,130 @@ transform_if(InputIterator start, InputIterator end,
 }
 
 
+
+namespace detail {
+
+/// argument for detecting for_each_segment.
+struct segment_probe {
+	template <typename Iter>
+	void operator()(Iter, Iter) const {}
+};
+
+/// true if Iterator provides for_each_segment(last, f), as ConcatenatingIterator and ContainerConcatenatingIterator do.
+template <typename Iterator>
+struct is_segmented {
+	template <typename U>
+	static auto test(int) -> decltype(::std::declval<U const &>().for_each_segment(::std::declval<U const &>(), segment_probe()), ::std::true_type());
+	template <typename U>
+	static ::std::false_type test(...);
+
+	static constexpr bool value = decltype(test<Iterator>(0))::value;
+};
+
+/// true if Iterator provides copy_to(last, output), as many2one_iterator and one2many_iterator do.
+template <typename Iterator, typename OutputIterator>
+struct is_bulk_copyable {
+	template <typename U>
+	static auto test(int) -> decltype(::std::declval<U const &>().copy_to(::std::declval<U const &>(), ::std::declval<OutputIterator>()), ::std::true_type());
+	template <typename U>
+	static ::std::false_type test(...);
+
+	static constexpr bool value = decltype(test<Iterator>(0))::value;
+};
+
+/// defined after copy, which it calls on each segment.
+template <typename OutputIterator>
+struct copy_segment;
+
+template <typename OutputIterator, typename Transform>
+struct transform_segment {
+	OutputIterator & output;
+	Transform & trans;
+	template <typename Iter>
+	void operator()(Iter b, Iter e) const { output = ::std::transform(b, e, output, trans); }
+};
+
+template <typename Function>
+struct apply_segment {
+	Function & f;
+	template <typename Iter>
+	void operator()(Iter b, Iter e) const { for (; b != e; ++b) f(*b); }   // f may not be assignable, e.g. a lambda.
+};
+
+}  // namespace detail
+
+
+/**
+ * @brief std::copy that, for a segmented (concatenating) iterator, copies each underlying range with bliss::iterator::algorithm::copy.
+ * @details  the per element range boundary checks of the concatenating iterators are replaced by 1 check per range,
+ *           so contiguous ranges of trivially copyable values are copied with memmove.
+ *           many2one and one2many iterators copy in bulk with copy_to, which uses the functor's batch method if present
+ *           (e.g. PackingIterator and UnpackingIterator).  other iterators use std::copy.
+ * @return  output iterator one past the last copied position
+ */
+template <typename InputIterator, typename OutputIterator>
+typename ::std::enable_if<detail::is_segmented<InputIterator>::value, OutputIterator>::type
+copy(InputIterator first, InputIterator last, OutputIterator output) {
+	first.for_each_segment(last, detail::copy_segment<OutputIterator>{output});
+	return output;
+}
+template <typename InputIterator, typename OutputIterator>
+typename ::std::enable_if<!detail::is_segmented<InputIterator>::value &&
+	detail::is_bulk_copyable<InputIterator, OutputIterator>::value, OutputIterator>::type
+copy(InputIterator first, InputIterator last, OutputIterator output) {
+	return first.copy_to(last, output);
+}
+template <typename InputIterator, typename OutputIterator>
+typename ::std::enable_if<!detail::is_segmented<InputIterator>::value &&
+	!detail::is_bulk_copyable<InputIterator, OutputIterator>::value, OutputIterator>::type
+copy(InputIterator first, InputIterator last, OutputIterator output) {
+	return ::std::copy(first, last, output);
+}
+
+namespace detail {
+
+template <typename OutputIterator>
+struct copy_segment {
+	OutputIterator & output;
+	template <typename Iter>
+	void operator()(Iter b, Iter e) const { output = ::bliss::iterator::algorithm::copy(b, e, output); }
+};
+
+}  // namespace detail
+
+/**
+ * @brief std::transform that loops over each underlying range of a segmented iterator.  see copy.
+ * @return  output iterator one past the last written position
+ */
+template <typename InputIterator, typename OutputIterator, typename Transform>
+typename ::std::enable_if<detail::is_segmented<InputIterator>::value, OutputIterator>::type
+transform(InputIterator first, InputIterator last, OutputIterator output, Transform trans) {
+	first.for_each_segment(last, detail::transform_segment<OutputIterator, Transform>{output, trans});
+	return output;
+}
+template <typename InputIterator, typename OutputIterator, typename Transform>
+typename ::std::enable_if<!detail::is_segmented<InputIterator>::value, OutputIterator>::type
+transform(InputIterator first, InputIterator last, OutputIterator output, Transform trans) {
+	return ::std::transform(first, last, output, trans);
+}
+
+/**
+ * @brief std::for_each that loops over each underlying range of a segmented iterator.  see copy.
+ * @return  the function, after it is applied to all elements.
+ */
+template <typename InputIterator, typename Function>
+typename ::std::enable_if<detail::is_segmented<InputIterator>::value, Function>::type
+for_each(InputIterator first, InputIterator last, Function f) {
+	first.for_each_segment(last, detail::apply_segment<Function>{f});
+	return f;
+}
+template <typename InputIterator, typename Function>
+typename ::std::enable_if<!detail::is_segmented<InputIterator>::value, Function>::type
+for_each(InputIterator first, InputIterator last, Function f) {
+	return ::std::for_each(first, last, f);
+}
+
+
 }  // namespace algorithm
 } // iterator
 } // bliss
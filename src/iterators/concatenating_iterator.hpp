@@ -130,11 +130,16 @@ namespace bliss
         ConcatenatingIterator(const type& other)
         : ranges(other.ranges), curr_iter_pos(other.curr_iter_pos)
         {
-          // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
-          curr = ranges[curr_iter_pos].first;
-          for (auto it = other.ranges[curr_iter_pos].first;
-              it != other.curr;
-              ++it, ++curr);
+          // end iterator has no range.
+          if (curr_iter_pos < 0) {
+            curr = other.curr;
+          } else {
+            // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
+            curr = ranges[curr_iter_pos].first;
+            for (auto it = other.ranges[curr_iter_pos].first;
+                it != other.curr;
+                ++it, ++curr);
+          }
         };
 
         /// copy constructor.  respects multi-pass requirement of forward iterator.
@@ -142,11 +147,16 @@ namespace bliss
         {
           ranges = other.ranges;
           curr_iter_pos = other.curr_iter_pos;
-          // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
-          curr = ranges[curr_iter_pos].first;
-          for (auto it = other.ranges[curr_iter_pos].first;
-              it != other.curr;
-              ++it, ++curr);
+          // end iterator has no range.
+          if (curr_iter_pos < 0) {
+            curr = other.curr;
+          } else {
+            // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
+            curr = ranges[curr_iter_pos].first;
+            for (auto it = other.ranges[curr_iter_pos].first;
+                it != other.curr;
+                ++it, ++curr);
+          }
 
           return *this;
         }
@@ -156,15 +166,21 @@ namespace bliss
         {
           curr_iter_pos = other.curr_iter_pos;
 
-          // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
-          int i = 0;
-          for (auto it = other.ranges[curr_iter_pos].first;
-              it != other.curr;
-              ++it, ++i);
-
-          ranges = std::move(other.ranges);
-          curr = ranges[curr_iter_pos].first;
-          for (int j = 0; j < i; ++i, ++curr);
+          // end iterator has no range.
+          if (curr_iter_pos < 0) {
+            ranges = std::move(other.ranges);
+            curr = std::move(other.curr);
+          } else {
+            // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
+            int i = 0;
+            for (auto it = other.ranges[curr_iter_pos].first;
+                it != other.curr;
+                ++it, ++i);
+
+            ranges = std::move(other.ranges);
+            curr = ranges[curr_iter_pos].first;
+            for (int j = 0; j < i; ++j, ++curr);
+          }
 
         };
 
@@ -173,15 +189,21 @@ namespace bliss
         {
           curr_iter_pos = other.curr_iter_pos;
 
-          // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
-          int i = 0;
-          for (auto it = other.ranges[curr_iter_pos].first;
-              it != other.curr;
-              ++it, ++i);
-
-          ranges = std::move(other.ranges);
-          curr = ranges[curr_iter_pos].first;
-          for (int j = 0; j < i; ++i, ++curr);
+          // end iterator has no range.
+          if (curr_iter_pos < 0) {
+            ranges = std::move(other.ranges);
+            curr = std::move(other.curr);
+          } else {
+            // move curr forward the same distance as other.curr - other.starts[curr_iter_pos]
+            int i = 0;
+            for (auto it = other.ranges[curr_iter_pos].first;
+                it != other.curr;
+                ++it, ++i);
+
+            ranges = std::move(other.ranges);
+            curr = ranges[curr_iter_pos].first;
+            for (int j = 0; j < i; ++j, ++curr);
+          }
 
           return *this;
         }
@@ -389,6 +411,27 @@ namespace bliss
           return output;
         }
 
+        /**
+         * @brief call f(begin, end) on each non-empty underlying range between this iterator and last, in order.
+         * @details  the first range starts at this iterator's position, and the last one ends at last's position.
+         *           last must be an end iterator, or an iterator over the same ranges that is not before this one.
+         *           used by the segmented algorithms in iterators/algorithm.hpp, which loop over each range without the
+         *           range boundary checks of operator++.
+         */
+        template <typename F>
+        void for_each_segment(type const & last, F && f) const
+        {
+          if (this->at_end() || (*this == last)) return;
+
+          bool const to_end = last.at_end();
+          int64_t const last_pos = to_end ? (static_cast<int64_t>(ranges.size()) - 1) : last.curr_iter_pos;
+          for (int64_t p = curr_iter_pos; p <= last_pos; ++p) {
+            Iterator b = (p == curr_iter_pos) ? curr : ranges[p].first;
+            Iterator e = ((p == last_pos) && !to_end) ? last.curr : ranges[p].second;
+            if (b != e) f(b, e);
+          }
+        }
+
       protected:
 
         /**
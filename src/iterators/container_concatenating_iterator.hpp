@@ -341,7 +341,42 @@ namespace bliss
           return *i_curr;
         }
 
-
+        /**
+         * @brief call f(begin, end) on each non-empty inner range between this iterator and last, in order.
+         * @details  the first range starts at this iterator's position.  iteration stops at last's position, or at the end
+         *           of this iterator's outer range, whichever is first.  used by the segmented algorithms in iterators/algorithm.hpp,
+         *           which loop over each inner range without the outer iterator checks of operator++.
+         */
+        template <typename F>
+        void for_each_segment(ContainerConcatenatingIterator const & last, F && f) const
+        {
+          if (are_same(o_curr, last.o_curr, i_curr, last.i_curr, o_curr_dereferenceable, last.o_curr_dereferenceable)) return;
+
+          OuterIter o = o_curr;
+          InnerIter b = i_curr;
+          InnerIter e = i_curr_end;
+          bool dereferenceable = o_curr_dereferenceable;
+
+          while (dereferenceable) {
+            bool const at_last = (o == last.o_curr);
+            if (at_last && !last.o_curr_dereferenceable) return;
+
+            // same end conditions as ensure_dereferenceable.
+            bool const at_end = (o == o_end);
+            if (at_last) e = last.i_curr;
+            else if (at_end) e = i_end;
+
+            if (b != e) f(b, e);
+            if (at_last || at_end) return;
+
+            ++o;
+            dereferenceable = (o != o_end) || o_end_dereferenceable;
+            if (dereferenceable) {
+              b = adapter.begin(*o);
+              e = adapter.end(*o);
+            }
+          }
+        }
 
     };
 
@@ -38,6 +38,30 @@ namespace bliss
 namespace iterator
 {
 
+namespace detail
+{
+  /// bulk m->1 via the functor's batch(cur, end, out), which writes the values of all of [cur, end) to out.
+  template<typename Functor, typename Iterator, typename OutputIterator>
+  auto many2one_batch(Functor& f, Iterator cur, const Iterator& end, OutputIterator out, int)
+    -> decltype(f.batch(cur, end, out))
+  {
+    return f.batch(cur, end, out);
+  }
+
+  /// fallback for functors without batch:  call the functor once per output value.
+  template<typename Functor, typename Iterator, typename OutputIterator>
+  OutputIterator many2one_batch(Functor& f, Iterator cur, const Iterator& end, OutputIterator out, long)
+  {
+    while (cur != end)
+    {
+      *out = f(cur, end);
+      ++out;
+    }
+    return out;
+  }
+} // namespace detail
+
+
 template<typename Iterator, typename Functor>
 class _shared_many2one_iterator
   : public _shared_transforming_iterator<Iterator, Functor, Iterator, Iterator>
@@ -70,6 +94,24 @@ public:
     return this->_m;
   }
 
+  /**
+   * @brief  Writes the values from this position up to `last` to `out`.
+   *
+   * Equivalent to std::copy(*this, last, out).  If the functor provides
+   * `batch(cur, end, out)`, the whole base range is handed to it at once,
+   * so it can convert many elements per loop iteration. Otherwise the
+   * functor is called once per value, without the read-ahead bookkeeping
+   * of operator* and operator++.  Used by bliss::iterator::algorithm::copy.
+   *
+   * @return  The output iterator one past the last written position.
+   */
+  template<typename OutputIterator>
+  OutputIterator copy_to(const _shared_many2one_iterator& last, OutputIterator out) const
+  {
+    Functor f(this->_f);
+    return detail::many2one_batch(f, this->_base, last._base, out, 0);
+  }
+
 protected:
   /**********************
    *  Member variables  *
@@ -37,6 +37,30 @@ namespace bliss
 namespace iterator
 {
 
+namespace detail
+{
+  /// bulk 1->m via the functor's batch(value, first, last, out), which writes the values at offsets [first, last) of value to out.
+  template<typename Functor, typename T, typename Diff, typename OutputIterator>
+  auto one2many_batch(Functor& f, const T& value, Diff first, Diff last, OutputIterator out, int)
+    -> decltype(f.batch(value, first, last, out))
+  {
+    return f.batch(value, first, last, out);
+  }
+
+  /// fallback for functors without batch:  call the functor once per offset.
+  template<typename Functor, typename T, typename Diff, typename OutputIterator>
+  OutputIterator one2many_batch(Functor& f, const T& value, Diff first, Diff last, OutputIterator out, long)
+  {
+    for (; first < last; ++first)
+    {
+      *out = f(value, first);
+      ++out;
+    }
+    return out;
+  }
+} // namespace detail
+
+
 template<typename Iterator, typename Functor>
 class _shared_one2many_iterator
   : public _shared_transforming_iterator<Iterator, Functor, Iterator, Iterator>
@@ -111,6 +135,34 @@ public:
     return this->_base != rhs._base || this->_offset != rhs._offset;
   }
 
+  /**
+   * @brief  Writes the values from this position up to `last` to `out`.
+   *
+   * Equivalent to std::copy(*this, last, out).  Each base element is
+   * dereferenced once, and if the functor provides
+   * `batch(value, first, last, out)`, all its values are extracted in one
+   * call.  Otherwise the functor is called once per value.  Used by
+   * bliss::iterator::algorithm::copy.
+   *
+   * @return  The output iterator one past the last written position.
+   */
+  template<typename OutputIterator>
+  OutputIterator copy_to(const _shared_one2many_iterator& last, OutputIterator out) const
+  {
+    Functor f(this->_f);
+    Iterator it = this->_base;
+    difference_type first = this->_offset;
+    for (; it != last._base; ++it, first = 0)
+    {
+      out = detail::one2many_batch(f, *it, first, this->_m, out, 0);
+    }
+    if (first < last._offset)
+    {
+      out = detail::one2many_batch(f, *it, first, last._offset, out, 0);
+    }
+    return out;
+  }
+
 protected:
   /**********************
    *  Member variables  *
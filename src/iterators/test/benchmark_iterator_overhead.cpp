@@ -0,0 +1,328 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * benchmark_iterator_overhead.cpp
+ *   cost of the iterator adaptor stacks of the k-mer parsing pipeline, each against a hand written loop computing
+ *   the same result.  the stacks are built as in KmerParser (io/kmer_parser.hpp) and KmerFileHelper:
+ *     filter_iterator<NotEOL>                           skip end of line characters
+ *     + transform_iterator<ASCII2<DNA> >                encode
+ *     + KmerGenerationIterator                          rolling k-mers
+ *     + ZipIterator with a CountingIterator             k-mer and position, as for position indices
+ *     ContainerConcatenatingIterator                    per thread k-mer vectors as 1 range
+ *     PackingIterator / UnpackingIterator               many2one and one2many, 2 bit packing of encoded chars,
+ *                                                       per element and in bulk (algorithm::copy)
+ *   each test checks that both compute the same value, and reports both times with the BL_TIMER report (BL_BENCHMARK).
+ *   a ratio far above 1 for a stack means the adaptors are not compiled away.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdint>
+#include <utility>
+
+#include "common/alphabets.hpp"
+#include "common/alphabet_traits.hpp"
+#include "common/kmer.hpp"
+#include "common/kmer_iterators.hpp"
+#include "common/packing_iterators.hpp"
+#include "iterators/filter_iterator.hpp"
+#include "iterators/transform_iterator.hpp"
+#include "iterators/zip_iterator.hpp"
+#include "iterators/counting_iterator.hpp"
+#include "iterators/container_concatenating_iterator.hpp"
+#include "iterators/algorithm.hpp"
+#include "utils/file_utils.hpp"
+
+#include "utils/benchmark_utils.hpp"
+
+
+class IteratorOverheadBenchmark : public ::testing::Test
+{
+  protected:
+    using Alphabet = ::bliss::common::DNA;
+    using KmerType = ::bliss::common::Kmer<31, Alphabet, uint64_t>;
+
+    using CharIter = ::std::vector<unsigned char>::const_iterator;
+    using NonEOLIter = ::bliss::iterator::filter_iterator<::bliss::utils::file::NotEOL, CharIter>;
+    using EncodeIter = ::bliss::iterator::transform_iterator<NonEOLIter, ::bliss::common::ASCII2<Alphabet> >;
+    using KmerIter = ::bliss::common::KmerGenerationIterator<EncodeIter, KmerType>;
+
+    /// FASTQ-like sequence:  lines of 100 ACGT characters.
+    static constexpr size_t line_length = 100;
+    static constexpr size_t lines = 100000;
+
+    ::std::vector<unsigned char> seq;
+
+    virtual void SetUp() {
+      ::std::default_random_engine gen(17);
+      ::std::uniform_int_distribution<int> dist(0, 3);
+      static const char bases[] = "ACGT";
+
+      seq.reserve(lines * (line_length + 1));
+      for (size_t l = 0; l < lines; ++l) {
+        for (size_t i = 0; i < line_length; ++i) seq.push_back(bases[dist(gen)]);
+        seq.push_back('\n');
+      }
+    }
+
+    NonEOLIter non_eol_begin() const {
+      return NonEOLIter(::bliss::utils::file::NotEOL(), seq.cbegin(), seq.cend());
+    }
+    NonEOLIter non_eol_end() const {
+      return NonEOLIter(::bliss::utils::file::NotEOL(), seq.cend());
+    }
+    KmerIter kmer_begin() const {
+      return KmerIter(EncodeIter(non_eol_begin(), ::bliss::common::ASCII2<Alphabet>()), true);
+    }
+    KmerIter kmer_end() const {
+      return KmerIter(EncodeIter(non_eol_end(), ::bliss::common::ASCII2<Alphabet>()), false);
+    }
+    size_t kmer_count() const {
+      return lines * line_length - KmerType::size + 1;
+    }
+};
+
+
+TEST_F(IteratorOverheadBenchmark, filter)
+{
+  BL_TIMER_INIT(filter);
+
+  BL_TIMER_START(filter);
+  size_t hand = 0;
+  for (auto it = seq.cbegin(); it != seq.cend(); ++it) {
+    if ((*it != '\n') && (*it != '\r')) hand += *it;
+  }
+  BL_TIMER_END(filter, "hand", seq.size());
+
+  BL_TIMER_START(filter);
+  size_t iter = 0;
+  for (auto it = non_eol_begin(), end = non_eol_end(); it != end; ++it) {
+    iter += *it;
+  }
+  BL_TIMER_END(filter, "filter", seq.size());
+
+  BL_TIMER_REPORT(filter);
+
+  EXPECT_EQ(hand, iter);
+}
+
+TEST_F(IteratorOverheadBenchmark, filter_transform)
+{
+  BL_TIMER_INIT(encode);
+
+  BL_TIMER_START(encode);
+  size_t hand = 0;
+  for (auto it = seq.cbegin(); it != seq.cend(); ++it) {
+    if ((*it != '\n') && (*it != '\r')) hand += Alphabet::FROM_ASCII[*it];
+  }
+  BL_TIMER_END(encode, "hand", seq.size());
+
+  BL_TIMER_START(encode);
+  size_t iter = 0;
+  EncodeIter end(non_eol_end(), ::bliss::common::ASCII2<Alphabet>());
+  for (EncodeIter it(non_eol_begin(), ::bliss::common::ASCII2<Alphabet>()); it != end; ++it) {
+    iter += *it;
+  }
+  BL_TIMER_END(encode, "filter+transform", seq.size());
+
+  BL_TIMER_REPORT(encode);
+
+  EXPECT_EQ(hand, iter);
+}
+
+TEST_F(IteratorOverheadBenchmark, kmer_generation)
+{
+  BL_TIMER_INIT(kmer);
+
+  BL_TIMER_START(kmer);
+  uint64_t hand = 0;
+  size_t hand_count = 0;
+  {
+    KmerType k;
+    size_t valid = 0;
+    for (auto it = seq.cbegin(); it != seq.cend(); ++it) {
+      if ((*it == '\n') || (*it == '\r')) continue;
+      k.nextFromChar(Alphabet::FROM_ASCII[*it]);
+      if (++valid >= KmerType::size) {
+        hand ^= k.getData()[0];
+        ++hand_count;
+      }
+    }
+  }
+  BL_TIMER_END(kmer, "hand", hand_count);
+
+  BL_TIMER_START(kmer);
+  uint64_t iter = 0;
+  size_t iter_count = 0;
+  for (auto it = kmer_begin(), end = kmer_end(); it != end; ++it) {
+    iter ^= (*it).getData()[0];
+    ++iter_count;
+  }
+  BL_TIMER_END(kmer, "kmer_parser", iter_count);
+
+  BL_TIMER_REPORT(kmer);
+
+  EXPECT_EQ(kmer_count(), hand_count);
+  EXPECT_EQ(hand_count, iter_count);
+  EXPECT_EQ(hand, iter);
+}
+
+TEST_F(IteratorOverheadBenchmark, kmer_position_zip)
+{
+  using ZipIter = ::bliss::iterator::ZipIterator<KmerIter, ::bliss::iterator::CountingIterator<size_t> >;
+
+  BL_TIMER_INIT(zip);
+
+  BL_TIMER_START(zip);
+  uint64_t hand = 0;
+  {
+    KmerType k;
+    size_t valid = 0;
+    size_t pos = 0;
+    for (auto it = seq.cbegin(); it != seq.cend(); ++it) {
+      if ((*it == '\n') || (*it == '\r')) continue;
+      k.nextFromChar(Alphabet::FROM_ASCII[*it]);
+      if (++valid >= KmerType::size) {
+        hand ^= k.getData()[0] + pos;
+        ++pos;
+      }
+    }
+  }
+  BL_TIMER_END(zip, "hand", kmer_count());
+
+  BL_TIMER_START(zip);
+  uint64_t iter = 0;
+  ZipIter it(kmer_begin(), ::bliss::iterator::CountingIterator<size_t>(0, 1));
+  ZipIter end(kmer_end(), ::bliss::iterator::CountingIterator<size_t>(kmer_count(), 1));
+  for (; it != end; ++it) {
+    auto v = *it;
+    iter ^= v.first.getData()[0] + v.second;
+  }
+  BL_TIMER_END(zip, "kmer_parser+zip", kmer_count());
+
+  BL_TIMER_REPORT(zip);
+
+  EXPECT_EQ(hand, iter);
+}
+
+TEST_F(IteratorOverheadBenchmark, concatenating)
+{
+  using ConcatIter = ::bliss::iterator::ContainerConcatenatingIterator<::std::vector<::std::vector<uint64_t> >::const_iterator,
+      ::bliss::iterator::ConcatenatingIteratorContainerAdapter<void> >;
+
+  // per thread vectors of uneven sizes, some empty.
+  ::std::vector<::std::vector<uint64_t> > parts(64);
+  size_t total = 0;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    parts[i].resize((i % 5 == 0) ? 0 : (i * 3001));
+    for (size_t j = 0; j < parts[i].size(); ++j) parts[i][j] = i * 1000003 + j;
+    total += parts[i].size();
+  }
+
+  BL_TIMER_INIT(concat);
+
+  BL_TIMER_START(concat);
+  uint64_t hand = 0;
+  for (size_t r = 0; r < 20; ++r) {
+    for (auto const & p : parts) {
+      for (auto v : p) hand += v;
+    }
+  }
+  BL_TIMER_END(concat, "hand", total * 20);
+
+  BL_TIMER_START(concat);
+  uint64_t iter = 0;
+  for (size_t r = 0; r < 20; ++r) {
+    ConcatIter it(::bliss::iterator::ConcatenatingIteratorContainerAdapter<void>(), parts.cbegin(), parts.cend());
+    ConcatIter end(::bliss::iterator::ConcatenatingIteratorContainerAdapter<void>(), parts.cend());
+    for (; it != end; ++it) iter += *it;
+  }
+  BL_TIMER_END(concat, "concatenating", total * 20);
+
+  BL_TIMER_REPORT(concat);
+
+  EXPECT_EQ(hand, iter);
+}
+
+TEST_F(IteratorOverheadBenchmark, pack_unpack)
+{
+  using PackIter = ::bliss::common::PackingIterator<::std::vector<uint8_t>::const_iterator, 2, uint64_t>;
+  using UnpackIter = ::bliss::common::UnpackingIterator<::std::vector<uint64_t>::const_iterator, 2, uint8_t>;
+
+  ::std::vector<uint8_t> codes;
+  codes.reserve(seq.size());
+  for (auto c : seq) {
+    if (c != '\n') codes.push_back(Alphabet::FROM_ASCII[c]);
+  }
+  size_t words = (codes.size() + 31) / 32;
+
+  BL_TIMER_INIT(pack);
+
+  // many2one
+  BL_TIMER_START(pack);
+  ::std::vector<uint64_t> hand(words, 0);
+  for (size_t i = 0; i < codes.size(); ++i) {
+    hand[i / 32] |= static_cast<uint64_t>(codes[i]) << (2 * (i % 32));
+  }
+  BL_TIMER_END(pack, "hand pack", codes.size());
+
+  BL_TIMER_START(pack);
+  ::std::vector<uint64_t> packed;
+  packed.reserve(words);
+  PackIter pend(codes.cend());
+  for (PackIter it(codes.cbegin(), codes.cend()); it != pend; ++it) packed.push_back(*it);
+  BL_TIMER_END(pack, "many2one pack", codes.size());
+
+  BL_TIMER_START(pack);
+  ::std::vector<uint64_t> bulk_packed;
+  bulk_packed.reserve(words);
+  ::bliss::iterator::algorithm::copy(PackIter(codes.cbegin(), codes.cend()), pend, ::std::back_inserter(bulk_packed));
+  BL_TIMER_END(pack, "many2one bulk", codes.size());
+
+  // one2many
+  BL_TIMER_START(pack);
+  uint64_t hand_sum = 0;
+  for (size_t i = 0; i < codes.size(); ++i) {
+    hand_sum += (hand[i / 32] >> (2 * (i % 32))) & 0x3;
+  }
+  BL_TIMER_END(pack, "hand unpack", codes.size());
+
+  BL_TIMER_START(pack);
+  uint64_t iter_sum = 0;
+  UnpackIter uit(packed.cbegin());
+  for (size_t i = 0; i < codes.size(); ++i, ++uit) iter_sum += *uit;
+  BL_TIMER_END(pack, "one2many unpack", codes.size());
+
+  BL_TIMER_START(pack);
+  ::std::vector<uint8_t> unpacked(codes.size());
+  ::bliss::iterator::algorithm::copy(UnpackIter(packed.cbegin()), UnpackIter(packed.cbegin(), codes.size()), unpacked.begin());
+  BL_TIMER_END(pack, "one2many bulk", codes.size());
+
+  BL_TIMER_REPORT(pack);
+
+  ASSERT_EQ(hand.size(), packed.size());
+  EXPECT_TRUE(::std::equal(hand.begin(), hand.end(), packed.begin()));
+  EXPECT_EQ(packed, bulk_packed);
+  EXPECT_EQ(hand_sum, iter_sum);
+  EXPECT_EQ(codes, unpacked);
+}
@@ -23,10 +23,12 @@
 #include <iostream>
 #include <algorithm>
 #include <vector>
+#include <numeric>
 
 // include files to test
 #include "iterators/concatenating_iterator.hpp"
 #include "iterators/container_concatenating_iterator.hpp"
+#include "iterators/algorithm.hpp"
 
 TEST(ConcatenatingIteratorTests, TestConcatenatingString)
 {
@@ -258,6 +260,58 @@ TEST(ConcatenatingIteratorTests, TestEmptyIterator)
 }
 
 
+TEST(ConcatenatingIteratorTests, TestSegmentedAlgorithms)
+{
+  std::string gold = "123443210000bam!";
+  std::string input1 = "1234";
+  std::string input2 = "4321";
+  std::string input3 = "";
+  std::string input4 = "0000bam!";
+
+  bliss::iterator::ConcatenatingIterator<std::string::const_iterator> start;
+  bliss::iterator::ConcatenatingIterator<std::string::const_iterator> end;
+
+  start.addRange(input1.cbegin(), input1.cend());
+  start.addRange(input2.cbegin(), input2.cend());
+  start.addRange(input3.cbegin(), input3.cend());
+  start.addRange(input4.cbegin(), input4.cend());
+
+  std::string out;
+  bliss::iterator::algorithm::copy(start, end, std::back_inserter(out));
+  EXPECT_EQ(gold, out);
+
+  out.clear();
+  bliss::iterator::algorithm::transform(start, end, std::back_inserter(out), [](char c) { return static_cast<char>(c + 1); });
+  std::string gold_plus(gold);
+  for (auto & c : gold_plus) c = static_cast<char>(c + 1);
+  EXPECT_EQ(gold_plus, out);
+
+  size_t count = 0;
+  bliss::iterator::algorithm::for_each(start, end, [&count](char) { ++count; });
+  EXPECT_EQ(gold.size(), count);
+
+  // sub ranges, within 1 range and across ranges.
+  for (size_t i = 0; i <= gold.size(); ++i) {
+    for (size_t j = i; j <= gold.size(); ++j) {
+      auto first = start;
+      for (size_t k = 0; k < i; ++k) ++first;
+      auto last = start;
+      for (size_t k = 0; k < j; ++k) ++last;
+
+      out.clear();
+      bliss::iterator::algorithm::copy(first, last, std::back_inserter(out));
+      EXPECT_EQ(gold.substr(i, j - i), out);
+    }
+  }
+
+  // empty
+  bliss::iterator::ConcatenatingIterator<std::string::const_iterator> empty;
+  out.clear();
+  bliss::iterator::algorithm::copy(empty, end, std::back_inserter(out));
+  EXPECT_EQ(0UL, out.size());
+}
+
+
 class ContainerConcatenatingIteratorTests : public ::testing::Test
 {
 protected:
@@ -343,6 +397,25 @@ protected:
 
     	return same;
     }
+
+    /// segmented algorithms produce the same output as their std versions.
+    template <typename Iter>
+    void compare_segmented(Iter start, Iter end, size_t start_pos, size_t end_pos) {
+    	std::vector<size_t> out;
+    	bliss::iterator::algorithm::copy(start, end, std::back_inserter(out));
+    	EXPECT_TRUE(std::equal(gold.begin() + start_pos, gold.begin() + end_pos, out.begin()));
+    	EXPECT_EQ(end_pos - start_pos, out.size());
+
+    	out.clear();
+    	bliss::iterator::algorithm::transform(start, end, std::back_inserter(out), [](size_t x) { return x * 2; });
+    	std::vector<size_t> trans_gold;
+    	std::transform(start, end, std::back_inserter(trans_gold), [](size_t x) { return x * 2; });
+    	EXPECT_EQ(trans_gold, out);
+
+    	size_t sum = 0;
+    	bliss::iterator::algorithm::for_each(start, end, [&sum](size_t x) { sum += x; });
+    	EXPECT_EQ(std::accumulate(gold.begin() + start_pos, gold.begin() + end_pos, 0UL), sum);
+    }
 };
 
 
@@ -721,6 +794,43 @@ TEST_F(ContainerConcatenatingIteratorTests, ConstructorTest5)
 }
 
 
+TEST_F(ContainerConcatenatingIteratorTests, SegmentedAlgorithms)
+{
+	size_t total = this->cumulative[this->inner_container_count];
+
+	{
+		auto oend = this->outer.cend();
+		Iter end(this->adapter, oend);
+
+		this->compare_segmented(Iter(this->adapter, this->outer.cbegin(), oend), end, 0, total);
+		this->compare_segmented(Iter(this->adapter, oend, oend), end, total, total);
+		this->compare_segmented(Iter(this->adapter, this->outer.cbegin() + 3, this->outer[3].cend(), oend), end, this->cumulative[4], total);
+		this->compare_segmented(Iter(this->adapter, this->outer.cbegin() + 4, this->outer[4].cbegin() + this->counts[4] / 2, oend), end,
+				this->cumulative[4] + this->counts[4] / 2, total);
+	}
 
+	{
+		// end in the middle of an inner container.
+		auto oend = this->outer.cbegin() + 10;
+		auto iend = this->outer[10].cbegin() + this->counts[10] / 2;
+		Iter end(this->adapter, oend, iend);
 
+		this->compare_segmented(Iter(this->adapter, this->outer.cbegin(), oend, iend), end, 0, this->cumulative[10] + this->counts[10] / 2);
+		this->compare_segmented(Iter(this->adapter, this->outer.cbegin() + 4, this->outer[4].cbegin() + this->counts[4] / 2, oend, iend), end,
+				this->cumulative[4] + this->counts[4] / 2, this->cumulative[10] + this->counts[10] / 2);
+		this->compare_segmented(Iter(this->adapter, oend, this->outer[10].cbegin(), oend, iend), end,
+				this->cumulative[10], this->cumulative[10] + this->counts[10] / 2);
+	}
 
+	{
+		// last is an incremented start.
+		Iter start(this->adapter, this->outer.cbegin(), this->outer.cend());
+		Iter last = start;
+		for (size_t i = 0; i < total / 3; ++i, ++last);
+		this->compare_segmented(start, last, 0, total / 3);
+
+		Iter first = start;
+		for (size_t i = 0; i < total / 5; ++i, ++first);
+		this->compare_segmented(first, last, total / 5, total / 3);
+	}
+}
@@ -254,6 +254,12 @@ public:
     return this->_f(*this->_base);
   }
 
+  /// const version, e.g. for ZipIterator.  needs the base iterator and the functor to dereference and call as const.
+  value_type operator*() const
+  {
+    return this->_f(*this->_base);
+  }
+
   /**
    * @brief     Pre-increment operator.
    *
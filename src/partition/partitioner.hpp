@@ -19,7 +19,7 @@
  * @ingroup partition
  * @author	Tony Pan <tpan7@gatech.edu>
  * @brief   contains several class that provide different logic for partitioning a range
- * @details contains block, cyclic, and demand driven (THREAD SAFE) partitioners
+ * @details contains block, cyclic, demand driven (THREAD SAFE), and work stealing (THREAD SAFE) partitioners
 						logic implementation uses comparison to avoid overflows and implicit casting where needed.
 
  */
@@ -28,6 +28,7 @@
 
 #include <stdexcept>
 #include <atomic>
+#include <cstdint>   // uint64_t
 #include <cmath>
 #include "bliss-config.hpp"
 #include <type_traits>
@@ -676,6 +677,162 @@ namespace bliss
     };
 
 
+    /**
+     * @class WorkStealingPartitioner
+     * @brief a partitioner that deals contiguous runs of chunks to the partitions, and lets a partition that runs out steal from the others.
+     * @details   partition p starts with the chunks [p * nChunks / nPartitions, (p+1) * nChunks / nPartitions), and gets them in order,
+     *            so a partition (thread) works on adjacent data as long as it can.  when its own chunks are exhausted, it takes the
+     *            upper half of the remaining chunks of the first non-empty partition after it (cyclically), returns the first of those,
+     *            and keeps the rest as its own.  this balances the load when chunks take uneven time to process,
+     *            e.g. reads with long N runs, or long reads mixed with short ones.
+     *
+     *            each partition's remaining chunks [head, tail) are packed into 1 atomic word.  the owner advances head and thieves
+     *            lower tail, both with compare-and-swap, and a partition refills itself only when empty.
+     *            head only increases and tail only decreases while a partition has chunks, so a stale [head, tail) cannot reappear.
+     *
+     *            THREAD SAFE
+     * @tparam Range  type of the range object to be partitioned.
+     */
+    template<typename Range>
+    class WorkStealingPartitioner : public Partitioner<Range, WorkStealingPartitioner<Range> >
+    {
+
+        friend Partitioner<Range, WorkStealingPartitioner<Range> >;
+
+      protected:
+        /**
+         * @typedef BaseClassType
+         * @brief   the superclass type.
+         */
+        using BaseClassType = Partitioner<Range, WorkStealingPartitioner<Range> >;
+
+        /**
+         * @typedef SizeType
+         */
+        using SizeType = typename BaseClassType::SizeType;
+
+        /**
+         * @typedef RangeValueType
+         * @brief   type for the start/end/overlap
+         */
+        using RangeValueType = typename BaseClassType::RangeValueType;
+
+        /**
+         * @var queues
+         * @brief remaining chunk ids of each partition, [head, tail), with head in the low 32 bits and tail in the high 32 bits.
+         */
+        std::atomic<uint64_t> *queues;
+
+        /// pack a chunk id interval into a queue word
+        static inline uint64_t pack(uint64_t head, uint64_t tail) {
+          return (tail << 32) | head;
+        }
+        /// first chunk id of a queue word
+        static inline size_t head_of(uint64_t q) {
+          return static_cast<size_t>(q & 0xFFFFFFFFULL);
+        }
+        /// end chunk id of a queue word
+        static inline size_t tail_of(uint64_t q) {
+          return static_cast<size_t>(q >> 32);
+        }
+
+
+      public:
+        WorkStealingPartitioner() : BaseClassType(), queues(nullptr) {};
+
+        /**
+         * @brief default destructor.  cleans up the queues.
+         */
+        virtual ~WorkStealingPartitioner() {
+          if (queues) {
+            delete [] queues;
+            queues = nullptr;
+          }
+        }
+
+
+        /**
+         * @brief configures the partitioner with the source range, number of partitions
+         * @note  should be called by single thread.
+         * @param _src          range object to be partitioned.
+         * @param _nPartitions  the number of partitions to divide this range into
+         * @param _non_overlap_size  size of each chunk for the partitioning.
+         * @param _overlap_size   the size of the overlap region.
+         * @return updated non_overlap_size.
+         *
+         */
+        SizeType configure(const Range &_src, const size_t &_nPartitions, const SizeType &_non_overlap_size, const SizeType &_overlap_size = 0) {
+          if (_non_overlap_size <= 0)
+            throw std::invalid_argument("ERROR: partitioner c'tor: non_overlap_size is <= 0");
+
+          this->BaseClassType::configure(_src, _nPartitions, _non_overlap_size, _overlap_size);
+
+          this->nChunks = this->computeNumberOfChunks();
+          if (this->nChunks > 0xFFFFFFFFULL)
+            throw std::invalid_argument("ERROR: work stealing partitioner supports at most 2^32 - 1 chunks.  increase non_overlap_size.");
+
+          if (queues) delete [] queues;
+          queues = new std::atomic<uint64_t>[this->nPartitions];
+
+          resetImpl();
+
+          return this->non_overlap_size;
+        };
+
+
+      protected:
+
+         /**
+         * @brief       get the next chunk for a partition.  its own chunks first, in order, then chunks stolen from other partitions.
+         * @details     ASSUMPTION:  no 2 concurrent callers will be requesting the same partition Id.
+         *
+         *              THREAD SAFE
+         * @param partId   partition id for the sub range.
+         * @return      range of the chunk.  if no chunks are left in any partition, return "end".
+         */
+         inline Range getNextImpl(const size_t& partId) {
+
+          // own chunks first.  thieves may lower tail concurrently.
+          uint64_t q = queues[partId].load(std::memory_order_acquire);
+          while (head_of(q) < tail_of(q)) {
+            if (queues[partId].compare_exchange_weak(q, pack(head_of(q) + 1, tail_of(q)), std::memory_order_acq_rel))
+              return BaseClassType::computeRangeForChunkId(this->src, 0, head_of(q));
+          }
+
+          // own queue is empty.  steal the upper half of the next non-empty one.
+          for (size_t i = 1; i < this->nPartitions; ++i) {
+            size_t victim = (partId + i) % this->nPartitions;
+
+            uint64_t v = queues[victim].load(std::memory_order_acquire);
+            while (head_of(v) < tail_of(v)) {
+              size_t mid = head_of(v) + (tail_of(v) - head_of(v)) / 2;
+              if (queues[victim].compare_exchange_weak(v, pack(head_of(v), mid), std::memory_order_acq_rel)) {
+                // no one modifies an empty queue, so the stolen remainder can be stored directly.
+                queues[partId].store(pack(mid + 1, tail_of(v)), std::memory_order_release);
+                return BaseClassType::computeRangeForChunkId(this->src, 0, mid);
+              }
+            }
+          }
+
+          return this->end;
+        }
+
+        /**
+         * @brief resets the partitioner by dealing contiguous runs of chunk ids to the partitions.
+         * @details this function also serves to initialize the queues.
+         */
+        void resetImpl() {
+          if (queues)
+            for (size_t i = 0; i < this->nPartitions; ++i) {
+              queues[i].store(pack(i * this->nChunks / this->nPartitions, (i + 1) * this->nChunks / this->nPartitions),
+                              std::memory_order_seq_cst);
+            }
+        }
+
+
+    };
+
+
   } /* namespace partition */
 } /* namespace bliss */
 
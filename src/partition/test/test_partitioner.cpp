@@ -28,6 +28,8 @@
 #include <cstdint>  // for uint64_t, etc.
 #include <vector>
 #include <limits>
+#include <algorithm>
+#include <cmath>
 
 #ifdef USE_OPENMP
 #include <omp.h>
@@ -503,6 +505,132 @@ TYPED_TEST_P(PartitionTest, demandPartition_openmp){
 }
 #endif
 
+//test the work stealing partitioning operation.  partition 0 gets its own chunks in order, then steals the rest.
+TYPED_TEST_P(PartitionTest, stealPartition){
+  typedef bliss::partition::range<TypeParam> RangeType;
+  typedef bliss::partition::WorkStealingPartitioner<range<TypeParam> > PartitionerType;
+  typedef decltype(std::declval<RangeType>().size()) SizeType;
+
+  RangeType src, r;
+
+
+  std::vector<TypeParam> starts =
+  { std::numeric_limits<TypeParam>::min(), std::numeric_limits<TypeParam>::lowest(),
+    0, 1, 2,
+    std::numeric_limits<TypeParam>::max()-2, (std::numeric_limits<TypeParam>::max() / 2) + 1};
+
+  std::vector<SizeType> lens =
+  { 0, 1, 2, 8};
+
+  std::vector<size_t> partitionCount =
+  { 1, 2, 4};
+
+  PartitionerType part;
+  for (auto start : starts)
+  {
+    for (auto len : lens)
+    {
+      src = RangeType(start, static_cast<SizeType>(std::numeric_limits<TypeParam>::max() - start) > len ? start + static_cast<TypeParam>(len) : std::numeric_limits<TypeParam>::max());
+
+      for (auto p : partitionCount)
+      {
+        part.configure(src, p, 1);
+
+        size_t nChunks = static_cast<size_t>(std::ceil(static_cast<double>(src.size())));
+        size_t own = nChunks / p;
+
+        // own chunks, in order.
+        std::vector<RangeType> chunks;
+        for (size_t i = 0; i < own; ++i) {
+          r = part.getNext(0);
+          EXP_EQ(TypeParam, static_cast<TypeParam>(src.start + static_cast<TypeParam>(i)), r.start);
+          chunks.push_back(r);
+        }
+
+        // then all the others, stolen.
+        r = part.getNext(0);
+        while (r.size() > 0) {
+          chunks.push_back(r);
+          r = part.getNext(0);
+        }
+
+        // every chunk exactly once, and nothing left for the other partitions.
+        ASSERT_EQ(nChunks, chunks.size());
+        std::sort(chunks.begin(), chunks.end(), [](RangeType const & x, RangeType const & y){ return x.start < y.start; });
+        if (nChunks > 0) {
+          EXP_EQ(TypeParam, src.start, chunks.front().start);
+          EXP_EQ(TypeParam, src.end, chunks.back().end);
+        }
+        for (size_t i = 1; i < chunks.size(); ++i) {
+          EXP_EQ(TypeParam, chunks[i-1].end, chunks[i].start);
+        }
+        for (size_t i = 1; i < p; ++i) {
+          EXPECT_EQ(0UL, static_cast<size_t>(part.getNext(i).size()));
+        }
+      }
+    }
+  }
+}
+
+#ifdef USE_OPENMP
+//test the work stealing partitioning operation. (With openmp threads)
+TYPED_TEST_P(PartitionTest, stealPartition_openmp){
+  typedef bliss::partition::range<TypeParam> RangeType;
+  typedef bliss::partition::WorkStealingPartitioner<range<TypeParam> > PartitionerType;
+  typedef decltype(std::declval<RangeType>().size()) SizeType;
+
+  RangeType src;
+
+
+  std::vector<TypeParam> starts =
+  { std::numeric_limits<TypeParam>::min(), std::numeric_limits<TypeParam>::lowest(),
+    0, 1, 2,
+    std::numeric_limits<TypeParam>::max()-2, (std::numeric_limits<TypeParam>::max() / 2) + 1};
+
+  std::vector<SizeType> lens =
+  { 0, 1, 2, 8, 100};
+
+  //Store the block ranges in a vector
+  std::vector<std::pair<TypeParam, TypeParam>> logRanges;
+
+  PartitionerType part;
+  for (auto start : starts)
+  {
+    for (auto len : lens)
+    {
+      src = RangeType(start, static_cast<SizeType>(std::numeric_limits<TypeParam>::max() - start) >= len ? start + len : std::numeric_limits<TypeParam>::max());
+
+      part.configure(src, omp_get_max_threads(), 1);
+#pragma omp parallel
+      {
+        size_t block = omp_get_thread_num();
+
+        // get chunks until all partitions are exhausted.
+        for (RangeType r = part.getNext(block); r.size() > 0; r = part.getNext(block))
+        {
+#pragma omp critical
+          logRanges.push_back(std::make_pair(r.start, r.end));
+        }
+      }
+      std::sort(logRanges.begin(), logRanges.end());
+
+      //Validate the ranges by checking that they cover src, and the neigbouring chunks are adjacent
+      if (src.size() > 0) {
+        ASSERT_FALSE(logRanges.empty());
+        EXP_EQ(TypeParam, src.start, logRanges.front().first);
+        EXP_EQ(TypeParam, src.end, logRanges.back().second);
+      } else {
+        EXPECT_TRUE(logRanges.empty());
+      }
+      for(auto it = logRanges.begin(); it != logRanges.end() && std::next(it) != logRanges.end(); it++)
+        EXP_EQ(TypeParam, std::get<1>(*it), std::get<0>(*(std::next(it))));
+
+      logRanges.clear();
+    }
+  }
+}
+#endif
+
 // failed partitions due to asserts.
 TYPED_TEST_P(PartitionTest, badPartitionId){
   typedef bliss::partition::range<TypeParam> RangeType;
@@ -547,9 +675,9 @@ TYPED_TEST_P(PartitionTest, badPartitionId){
 
 // now register the test cases
 #ifdef USE_OPENMP
-REGISTER_TYPED_TEST_CASE_P(PartitionTest, badPartitionId, blockPartition, blockPartition_openmp, cyclicPartition, cyclicPartition_openmp, demandPartition, demandPartition_openmp);
+REGISTER_TYPED_TEST_CASE_P(PartitionTest, badPartitionId, blockPartition, blockPartition_openmp, cyclicPartition, cyclicPartition_openmp, demandPartition, demandPartition_openmp, stealPartition, stealPartition_openmp);
 #else
-REGISTER_TYPED_TEST_CASE_P(PartitionTest, badPartitionId, blockPartition, cyclicPartition, demandPartition);
+REGISTER_TYPED_TEST_CASE_P(PartitionTest, badPartitionId, blockPartition, cyclicPartition, demandPartition, stealPartition);
 #endif
 
 
@@ -0,0 +1,370 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    async_log.hpp
+ * @ingroup
+ * @brief   buffered log engine:  per thread ring buffers, drained to 1 file per rank by a background thread.
+ * @details with the printf engine, every message is a write to the shared stdout, and at DEBUG verbosity the ranks
+ *          take turns on it.  here each thread appends fixed size records to its own single producer, single consumer
+ *          ring buffer, without a lock or an allocation, and a flusher thread formats and writes them every few
+ *          milliseconds.  a record that does not fit, because the flusher is behind, is dropped and counted, so the
+ *          caller never waits for I/O.
+ *
+ *          the printf style macros (BL_DEBUGF etc.) store the format string and the arguments, and the flusher formats
+ *          them.  this needs the arguments to be numbers or pointers that are not strings, and the format to be a
+ *          string literal.  with a string argument, whose memory may be gone by then, the message is formatted at the
+ *          call, into the record.  the stream macros (BL_DEBUG etc.) are always formatted at the call.  messages are
+ *          cut at text_bytes.
+ *
+ *          the records of 1 thread are in order.  records of different threads are ordered by time within each drain.
+ *          fatal messages are flushed before the process exits.
+ *
+ *          selected with LOG_ENGINE=ASYNC.  at runtime:
+ *            BL_LOG_FILE      output prefix, files are "<prefix>.<rank>.log".  default "bliss_log".
+ *            BL_LOG_RECORDS   ring buffer capacity per thread, rounded up to a power of 2.  default 4096.
+ *            BL_LOG_FLUSH_MS  flush interval.  default 20.
+ *          the rank is taken from the environment of the MPI launcher (OMPI_COMM_WORLD_RANK, PMI_RANK, ...), or set
+ *          with set_rank() before the first flush.
+ */
+#ifndef SRC_UTILS_ASYNC_LOG_HPP_
+#define SRC_UTILS_ASYNC_LOG_HPP_
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <tuple>
+#include <memory>     // unique_ptr
+#include <new>        // placement new
+#include <algorithm>  // min, max, sort
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <sstream>
+#include <cstdio>     // fopen, fprintf, snprintf
+#include <cstring>    // memcpy
+#include <cstdlib>    // getenv, strtoul
+#include <cstdint>
+
+#include "utils/integer_sequence.hpp"
+
+namespace plog {
+
+class AsyncLog {
+  public:
+    /// message bytes in a record, including the terminating 0, or the bytes of the stored arguments.
+    static constexpr size_t text_bytes = 224;
+
+    struct record {
+        uint64_t time_ns;
+        /// prints fmt with the arguments stored in text.  nullptr if text holds the formatted message.
+        void (*print)(FILE *, char const *, void const *);
+        char const * fmt;
+        int level;
+        alignas(16) char text[text_bytes];
+    };
+
+  protected:
+    /// single producer (the owning thread), single consumer (the drain) ring buffer.
+    struct thread_ring {
+        std::thread::id thread;
+        uint32_t tid;
+        std::vector<record> records;
+        size_t mask;
+        std::atomic<size_t> head;
+        std::atomic<size_t> tail;
+        std::atomic<size_t> dropped;
+
+        thread_ring(std::thread::id const & _thread, uint32_t _tid, size_t capacity) :
+          thread(_thread), tid(_tid), records(capacity), mask(capacity - 1), head(0), tail(0), dropped(0) {}
+    };
+
+    /// last ring used by this thread, tagged with the owning log's serial number.
+    struct thread_cache {
+        uint64_t serial;
+        thread_ring * ring;
+    };
+
+    /// arguments that can be printed after the call returns:  numbers, and pointers other than strings.
+    template <typename... Args>
+    struct deferrable {
+        static constexpr bool value = true;
+    };
+
+    template <typename A, typename... Args>
+    struct deferrable<A, Args...> {
+        using D = typename std::decay<A>::type;
+        using P = typename std::remove_cv<typename std::remove_pointer<D>::type>::type;
+        static constexpr bool value = (std::is_arithmetic<D>::value || std::is_enum<D>::value ||
+            (std::is_pointer<D>::value && !std::is_same<P, char>::value && !std::is_same<P, wchar_t>::value)) &&
+            deferrable<Args...>::value;
+    };
+
+    std::chrono::steady_clock::time_point origin;
+    size_t capacity;
+    uint64_t serial;
+    std::string filename;
+    std::chrono::milliseconds interval;
+
+    /// guards rings, file and rank.  the producers take it only the first time they log.
+    std::mutex lock;
+    std::vector<std::unique_ptr<thread_ring> > rings;
+    FILE * file;
+    int rank;
+
+    std::mutex drain_lock;
+    std::condition_variable wake;
+    bool running;
+    std::thread flusher;
+
+    static uint64_t next_serial() {
+      static std::atomic<uint64_t> counter(0);
+      return ++counter;
+    }
+
+    static size_t env_value(char const * name, size_t const & default_value) {
+      char const * v = std::getenv(name);
+      if (v == nullptr) return default_value;
+      size_t x = std::strtoul(v, nullptr, 10);
+      return (x == 0) ? default_value : x;
+    }
+
+    /// rank from the launcher's environment, or 0.
+    static int env_rank() {
+      char const * names[] = { "OMPI_COMM_WORLD_RANK", "PMI_RANK", "PMIX_RANK", "MV2_COMM_WORLD_RANK", "SLURM_PROCID" };
+      for (char const * n : names) {
+        char const * v = std::getenv(n);
+        if (v != nullptr) return static_cast<int>(std::strtol(v, nullptr, 10));
+      }
+      return 0;
+    }
+
+    static char const * level_name(int const level) {
+      static char const * names[] = { "[fatal]", "[error]", "[warn ]", "[info ]", "[debug]", "[trace]" };
+      return ((level >= 0) && (level < 6)) ? names[level] : "[     ]";
+    }
+
+    template <typename Tuple, size_t... I>
+    static void print_tuple(FILE * fp, char const * fmt, Tuple const & args, ::bliss::utils::seq<size_t, I...>) {
+      fprintf(fp, fmt, std::get<I>(args)...);
+    }
+
+    template <typename... Args>
+    static void print_stored(FILE * fp, char const * fmt, void const * payload) {
+      print_tuple(fp, fmt, *reinterpret_cast<std::tuple<Args...> const *>(payload),
+                  ::bliss::utils::GenSeq<size_t, sizeof...(Args)>());
+    }
+
+    /// the calling thread's ring.  takes the lock only the first time a thread logs into this log.
+    thread_ring & local() {
+      static thread_local thread_cache cache = { 0, nullptr };
+      if (cache.serial == serial) return *(cache.ring);
+
+      std::lock_guard<std::mutex> guard(lock);
+      std::thread::id self = std::this_thread::get_id();
+      thread_ring * r = nullptr;
+      for (auto const & x : rings) {
+        if (x->thread == self) r = x.get();
+      }
+      if (r == nullptr) {
+        rings.emplace_back(new thread_ring(self, static_cast<uint32_t>(rings.size()), capacity));
+        r = rings.back().get();
+      }
+      cache.serial = serial;
+      cache.ring = r;
+      return *r;
+    }
+
+    uint64_t now_ns() const {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    /// the next free record, or nullptr (and counted as dropped) if the ring is full.
+    record * reserve(thread_ring & r) {
+      size_t h = r.head.load(std::memory_order_relaxed);
+      if ((h - r.tail.load(std::memory_order_acquire)) > r.mask) {
+        r.dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      return &(r.records[h & r.mask]);
+    }
+
+    void publish(thread_ring & r) {
+      r.head.store(r.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void flush_loop() {
+      std::unique_lock<std::mutex> guard(drain_lock);
+      while (running) {
+        wake.wait_for(guard, interval);
+        drain();
+      }
+      drain();
+    }
+
+    /// format and write all published records.  caller holds drain_lock.
+    void drain() {
+      std::vector<thread_ring *> snapshot;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto const & r : rings) snapshot.push_back(r.get());
+      }
+
+      // (time, ring, position) of the records to write, in time order.
+      std::vector<std::tuple<uint64_t, uint32_t, size_t> > order;
+      std::vector<size_t> heads(snapshot.size());
+      for (size_t i = 0; i < snapshot.size(); ++i) {
+        heads[i] = snapshot[i]->head.load(std::memory_order_acquire);
+        for (size_t t = snapshot[i]->tail.load(std::memory_order_relaxed); t != heads[i]; ++t) {
+          order.emplace_back(snapshot[i]->records[t & snapshot[i]->mask].time_ns, static_cast<uint32_t>(i), t);
+        }
+      }
+      if (order.empty()) return;
+      std::sort(order.begin(), order.end());
+
+      FILE * fp = output();
+      for (auto const & o : order) {
+        thread_ring const & r = *(snapshot[std::get<1>(o)]);
+        record const & x = r.records[std::get<2>(o) & r.mask];
+        if (fp != nullptr) {
+          fprintf(fp, "%.6f t%u %s ", static_cast<double>(x.time_ns) / 1e9, r.tid, level_name(x.level));
+          if (x.print == nullptr) fputs(x.text, fp);
+          else x.print(fp, x.fmt, x.text);
+          fputc('\n', fp);
+        }
+      }
+      for (size_t i = 0; i < snapshot.size(); ++i) snapshot[i]->tail.store(heads[i], std::memory_order_release);
+      if (fp != nullptr) fflush(fp);
+    }
+
+    /// the rank's file, opened on first use.
+    FILE * output() {
+      std::lock_guard<std::mutex> guard(lock);
+      if (file == nullptr) {
+        std::stringstream ss;
+        ss << filename << "." << rank << ".log";
+        file = fopen(ss.str().c_str(), "w");
+      }
+      return file;
+    }
+
+  public:
+    /**
+     * @param _filename  output prefix.  the file is "<prefix>.<rank>.log".
+     * @param _capacity  records per thread, rounded up to a power of 2.
+     */
+    AsyncLog(std::string const & _filename, size_t const & _capacity, size_t const & flush_ms = 20) :
+      origin(std::chrono::steady_clock::now()), capacity(2), serial(next_serial()), filename(_filename),
+      interval(std::max(flush_ms, static_cast<size_t>(1))), file(nullptr), rank(env_rank()), running(true) {
+      while (capacity < _capacity) capacity <<= 1;
+      flusher = std::thread(&AsyncLog::flush_loop, this);
+    }
+
+    ~AsyncLog() {
+      {
+        std::lock_guard<std::mutex> guard(drain_lock);
+        running = false;
+      }
+      wake.notify_all();
+      flusher.join();
+      if (file != nullptr) fclose(file);
+    }
+
+    AsyncLog(AsyncLog const & other) = delete;
+    AsyncLog& operator=(AsyncLog const & other) = delete;
+
+    /// process wide log used by the logging macros, configured from the environment.
+    static AsyncLog & instance() {
+      static char const * prefix = std::getenv("BL_LOG_FILE");
+      static AsyncLog log((prefix == nullptr) ? "bliss_log" : prefix, env_value("BL_LOG_RECORDS", 1UL << 12),
+                          env_value("BL_LOG_FLUSH_MS", 20));
+      return log;
+    }
+
+    /// rank in the file name, e.g. from the communicator once MPI is initialized.  no effect once the file is open.
+    void set_rank(int const r) {
+      std::lock_guard<std::mutex> guard(lock);
+      rank = r;
+    }
+
+    /// append a formatted message.
+    void write(int const level, char const * msg) {
+      thread_ring & r = local();
+      record * x = reserve(r);
+      if (x == nullptr) return;
+      x->time_ns = now_ns();
+      x->print = nullptr;
+      x->fmt = nullptr;
+      x->level = level;
+      size_t n = std::min(strlen(msg), text_bytes - 1);
+      memcpy(x->text, msg, n);
+      x->text[n] = 0;
+      publish(r);
+    }
+
+    void write(int const level, std::string const & msg) {
+      write(level, msg.c_str());
+    }
+
+    /// append a printf style message.  fmt must be a string literal.  see file description for when it is formatted.
+    template <typename... Args>
+    void writef(int const level, char const * fmt, Args const & ... args) {
+      store(std::integral_constant<bool, deferrable<Args...>::value &&
+                (sizeof(std::tuple<Args...>) <= text_bytes) && (alignof(std::tuple<Args...>) <= 16)>(),
+            level, fmt, args...);
+    }
+
+    /// write all records logged so far.  blocks until they are written.
+    void flush() {
+      std::lock_guard<std::mutex> guard(drain_lock);
+      drain();
+    }
+
+    /// records lost to full ring buffers.
+    size_t dropped() {
+      std::lock_guard<std::mutex> guard(lock);
+      size_t n = 0;
+      for (auto const & r : rings) n += r->dropped.load(std::memory_order_relaxed);
+      return n;
+    }
+
+  protected:
+    template <typename... Args>
+    void store(std::true_type, int const level, char const * fmt, Args const & ... args) {
+      thread_ring & r = local();
+      record * x = reserve(r);
+      if (x == nullptr) return;
+      x->time_ns = now_ns();
+      x->print = &AsyncLog::print_stored<typename std::decay<Args>::type...>;
+      x->fmt = fmt;
+      x->level = level;
+      new (x->text) std::tuple<typename std::decay<Args>::type...>(args...);
+      publish(r);
+    }
+
+    template <typename... Args>
+    void store(std::false_type, int const level, char const * fmt, Args const & ... args) {
+      char buffer[text_bytes];
+      snprintf(buffer, text_bytes, fmt, args...);
+      write(level, buffer);
+    }
+};
+
+} // end namespace plog
+
+#endif /* SRC_UTILS_ASYNC_LOG_HPP_ */
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    benchmark_baseline.hpp
+ * @ingroup
+ * @brief   compares benchmark sink output (see benchmark_sink.hpp) against a stored baseline.
+ * @details the baseline and the current run are files of sink rows, JSON lines or CSV.  rows are matched on
+ *          (title, kind, phase, metric, ranks).  rows with the same key, e.g. from repeated runs, are combined by their
+ *          median.  only the metrics that measure speed or footprint are compared:
+ *
+ *            dur_s                  the max over ranks, lower is better
+ *            elem_per_s             the min over ranks, higher is better
+ *            elem_per_s_per_core    as elem_per_s
+ *            peak_bytes             the max over ranks, lower is better
+ *            phase_peak_bytes       as peak_bytes
+ *
+ *          a compared row is a regression if it is worse than the baseline by more than the tolerance, a fraction of the
+ *          baseline (time_tolerance for time and throughput, mem_tolerance for memory).  durations under min_seconds and
+ *          memory under min_bytes in both runs are too noisy to judge, and are only reported.
+ */
+#ifndef SRC_UTILS_BENCHMARK_BASELINE_HPP_
+#define SRC_UTILS_BENCHMARK_BASELINE_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <algorithm>  // sort, nth_element
+#include <cstdlib>    // strtod
+#include <stdexcept>  // runtime_error
+
+namespace plog {
+
+class BenchBaseline {
+  public:
+    /// 1 row of the sink.
+    struct row {
+        ::std::string title, kind, phase, metric;
+        int ranks;
+        double min, max, mean, stdev;
+
+        row() : ranks(0), min(0), max(0), mean(0), stdev(0) {}
+
+        ::std::string key() const {
+          ::std::stringstream ss;
+          ss << title << " | " << kind << " | " << phase << " | " << metric << " | " << ranks;
+          return ss.str();
+        }
+    };
+
+    /// how a metric is compared.
+    struct policy {
+        bool compared;
+        bool higher_is_better;
+        bool memory;
+        /// 0: min, 1: max over ranks
+        int field;
+    };
+
+    struct options {
+        double time_tolerance;
+        double mem_tolerance;
+        double min_seconds;
+        double min_bytes;
+        options() : time_tolerance(0.10), mem_tolerance(0.05), min_seconds(0.01), min_bytes(1 << 20) {}
+    };
+
+    /// result of 1 key.
+    struct diff {
+        ::std::string key;
+        ::std::string metric;
+        /// true if in both runs and large enough to judge.
+        bool judged;
+        bool in_baseline, in_current;
+        double baseline, current;
+        /// current / baseline, adjusted so that > 1 is worse.  0 if not judged.
+        double slowdown;
+        bool regression;
+    };
+
+    static policy policy_of(::std::string const & metric) {
+      if (metric == "dur_s") return policy{true, false, false, 1};
+      if ((metric == "elem_per_s") || (metric == "elem_per_s_per_core")) return policy{true, true, false, 0};
+      if ((metric == "peak_bytes") || (metric == "phase_peak_bytes")) return policy{true, false, true, 1};
+      return policy{false, false, false, 1};
+    }
+
+  protected:
+    /// parse a JSON string starting at the quote at s[i].  i ends after the closing quote.
+    static ::std::string json_string(::std::string const & s, size_t & i) {
+      ::std::string out;
+      ++i;
+      while ((i < s.size()) && (s[i] != '"')) {
+        if ((s[i] == '\\') && (i + 1 < s.size())) ++i;
+        out.push_back(s[i++]);
+      }
+      ++i;
+      return out;
+    }
+
+    static void set_field(row & r, ::std::string const & name, ::std::string const & value) {
+      if (name == "title") r.title = value;
+      else if (name == "kind") r.kind = value;
+      else if (name == "phase") r.phase = value;
+      else if (name == "metric") r.metric = value;
+      else if (name == "ranks") r.ranks = static_cast<int>(::std::strtol(value.c_str(), nullptr, 10));
+      else if (name == "min") r.min = ::std::strtod(value.c_str(), nullptr);
+      else if (name == "max") r.max = ::std::strtod(value.c_str(), nullptr);
+      else if (name == "mean") r.mean = ::std::strtod(value.c_str(), nullptr);
+      else if (name == "stdev") r.stdev = ::std::strtod(value.c_str(), nullptr);
+    }
+
+    /// 1 flat JSON object, as written by BenchSink.
+    static row parse_json(::std::string const & line) {
+      row r;
+      size_t i = line.find('{');
+      if (i == ::std::string::npos) throw ::std::runtime_error("ERROR: benchmark row is not a JSON object: " + line);
+      ++i;
+      while (i < line.size()) {
+        while ((i < line.size()) && (line[i] != '"') && (line[i] != '}')) ++i;
+        if ((i >= line.size()) || (line[i] == '}')) break;
+        ::std::string name = json_string(line, i);
+        while ((i < line.size()) && ((line[i] == ':') || (line[i] == ' '))) ++i;
+        ::std::string value;
+        if ((i < line.size()) && (line[i] == '"')) value = json_string(line, i);
+        else {
+          size_t e = line.find_first_of(",}", i);
+          if (e == ::std::string::npos) e = line.size();
+          value = line.substr(i, e - i);
+          i = e;
+        }
+        set_field(r, name, value);
+        if ((i < line.size()) && (line[i] == ',')) ++i;
+      }
+      return r;
+    }
+
+    /// split 1 CSV line, with "" quoting.
+    static ::std::vector<::std::string> split_csv(::std::string const & line) {
+      ::std::vector<::std::string> fields(1);
+      bool quoted = false;
+      for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+          if (c == '"') {
+            if ((i + 1 < line.size()) && (line[i + 1] == '"')) { fields.back().push_back('"'); ++i; }
+            else quoted = false;
+          } else fields.back().push_back(c);
+        } else if (c == '"') quoted = true;
+        else if (c == ',') fields.emplace_back();
+        else if (c != '\r') fields.back().push_back(c);
+      }
+      return fields;
+    }
+
+    static double median(::std::vector<double> v) {
+      if (v.empty()) return 0.0;
+      ::std::sort(v.begin(), v.end());
+      size_t const m = v.size() / 2;
+      return (v.size() % 2 == 1) ? v[m] : 0.5 * (v[m - 1] + v[m]);
+    }
+
+  public:
+    /// rows of a sink file, JSON lines or CSV (detected from the first non empty line).  throws if it cannot be read.
+    static ::std::vector<row> read(::std::string const & filename) {
+      ::std::ifstream in(filename);
+      if (!in.is_open()) throw ::std::runtime_error("ERROR: cannot open benchmark file " + filename);
+
+      ::std::vector<row> rows;
+      ::std::vector<::std::string> header;
+      ::std::string line;
+      while (::std::getline(in, line)) {
+        size_t b = line.find_first_not_of(" \t\r");
+        if (b == ::std::string::npos) continue;
+
+        if (line[b] == '{') {
+          rows.emplace_back(parse_json(line));
+        } else if (header.empty()) {
+          header = split_csv(line);
+        } else {
+          ::std::vector<::std::string> f = split_csv(line);
+          if (f == header) continue;  // header repeated by a concatenated file.
+          row r;
+          for (size_t i = 0; i < ::std::min(f.size(), header.size()); ++i) set_field(r, header[i], f[i]);
+          rows.emplace_back(r);
+        }
+      }
+      return rows;
+    }
+
+    /// the compared value of each compared key:  median over the rows of the key.
+    static ::std::map<::std::string, double> summarize(::std::vector<row> const & rows) {
+      ::std::map<::std::string, ::std::vector<double> > values;
+      for (auto const & r : rows) {
+        policy p = policy_of(r.metric);
+        if (!p.compared) continue;
+        values[r.key()].push_back((p.field == 0) ? r.min : r.max);
+      }
+      ::std::map<::std::string, double> out;
+      for (auto const & v : values) out[v.first] = median(v.second);
+      return out;
+    }
+
+    /// compare current against baseline, 1 diff per key in either, sorted by key.
+    static ::std::vector<diff> compare(::std::vector<row> const & baseline, ::std::vector<row> const & current,
+                                       options const & opt = options()) {
+      ::std::map<::std::string, double> base = summarize(baseline);
+      ::std::map<::std::string, double> curr = summarize(current);
+
+      // the metric of each key.
+      ::std::map<::std::string, ::std::string> metrics;
+      for (auto const & r : baseline) metrics[r.key()] = r.metric;
+      for (auto const & r : current) metrics[r.key()] = r.metric;
+
+      ::std::vector<diff> out;
+      for (auto const & km : metrics) {
+        policy p = policy_of(km.second);
+        if (!p.compared) continue;
+
+        diff d;
+        d.key = km.first;
+        d.metric = km.second;
+        auto bi = base.find(km.first);
+        auto ci = curr.find(km.first);
+        d.in_baseline = (bi != base.end());
+        d.in_current = (ci != curr.end());
+        d.baseline = d.in_baseline ? bi->second : 0.0;
+        d.current = d.in_current ? ci->second : 0.0;
+        d.judged = false;
+        d.slowdown = 0.0;
+        d.regression = false;
+
+        if (d.in_baseline && d.in_current) {
+          if (p.memory) d.judged = (::std::max(d.baseline, d.current) >= opt.min_bytes);
+          else if (p.higher_is_better) d.judged = (d.baseline > 0.0);
+          else d.judged = (::std::max(d.baseline, d.current) >= opt.min_seconds);
+        }
+        if (d.judged) {
+          if (p.higher_is_better) d.slowdown = (d.current > 0.0) ? (d.baseline / d.current) : 1.0e9;
+          else d.slowdown = (d.baseline > 0.0) ? (d.current / d.baseline) : 1.0e9;
+          double const tol = p.memory ? opt.mem_tolerance : opt.time_tolerance;
+          d.regression = (d.slowdown > 1.0 + tol);
+        }
+        out.emplace_back(d);
+      }
+      return out;
+    }
+
+    /// a table of the diffs, regressions marked.  with all == false, only regressions and unmatched keys.
+    static ::std::string report(::std::vector<diff> const & diffs, bool const all = false) {
+      ::std::stringstream ss;
+      ss.precision(4);
+      for (auto const & d : diffs) {
+        ::std::string status = d.regression ? "REGRESSION" :
+            (!d.in_baseline ? "new" : (!d.in_current ? "missing" : (d.judged ? ((d.slowdown < 1.0) ? "better" : "ok") : "noise")));
+        if (!all && !d.regression && d.in_baseline && d.in_current) continue;
+        ss << status << "\t" << d.key << "\tbaseline " << d.baseline << "\tcurrent " << d.current;
+        if (d.judged) ss << "\tx" << d.slowdown;
+        ss << "\n";
+      }
+      return ss.str();
+    }
+
+    static size_t count_regressions(::std::vector<diff> const & diffs) {
+      return ::std::count_if(diffs.begin(), diffs.end(), [](diff const & d) { return d.regression; });
+    }
+};
+
+} // end namespace plog
+
+#endif /* SRC_UTILS_BENCHMARK_BASELINE_HPP_ */
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    benchmark_sink.hpp
+ * @ingroup
+ * @brief   machine readable output of the Timer and MemUsage reports.
+ * @details if the environment variable BL_BENCH_FILE is set, every report also appends its statistics to that file,
+ *          1 row per (phase, metric), with the min, max, mean, and stdev over the ranks.  the format is JSON lines
+ *          if the file name ends in .json or .jsonl, and CSV otherwise, with a header row when the file is new.
+ *          rows have the same fields in both formats:
+ *
+ *            title, kind (time or mem), index, phase, metric, ranks, min, max, mean, stdev
+ *
+ *          time metrics are dur_s, cum_s, count, and elem_per_s (count / dur on each rank; bytes/s for phases that
+ *          count bytes).  mem metrics are curr_bytes, peak_bytes, delta_bytes (curr change since the previous mark), and
+ *          phase_peak_bytes (the high-water mark between the previous mark and this one).
+ *          only rank 0 writes, and the file is opened for each report, so output of several runs accumulates.
+ */
+#ifndef SRC_UTILS_BENCHMARK_SINK_HPP_
+#define SRC_UTILS_BENCHMARK_SINK_HPP_
+
+#include <cstdio>     // fopen
+#include <cstdlib>    // getenv
+#include <cmath>      // sqrt
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>  // min, max
+#include <functional> // plus
+
+#include <mxx/reduction.hpp>
+
+namespace plog {
+
+class BenchSink {
+  public:
+    /// statistics of 1 metric over the ranks, per phase.  only valid on rank 0.
+    struct stats {
+        ::std::vector<double> mins, maxs, means, stdevs;
+    };
+
+  protected:
+    static bool is_json(::std::string const & fn) {
+      auto ends_with = [&fn](::std::string const & ext) {
+        return (fn.size() >= ext.size()) && (fn.compare(fn.size() - ext.size(), ext.size(), ext) == 0);
+      };
+      return ends_with(".json") || ends_with(".jsonl");
+    }
+
+    static ::std::string json_string(::std::string const & s) {
+      ::std::stringstream ss;
+      ss << '"';
+      for (char c : s) {
+        if ((c == '"') || (c == '\\')) ss << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) ss << ' ';
+        else ss << c;
+      }
+      ss << '"';
+      return ss.str();
+    }
+
+    static ::std::string csv_string(::std::string const & s) {
+      if (s.find_first_of(",\"\n") == ::std::string::npos) return s;
+      ::std::string out("\"");
+      for (char c : s) {
+        if (c == '"') out.push_back('"');
+        out.push_back(c);
+      }
+      out.push_back('"');
+      return out;
+    }
+
+  public:
+    /// the output file, or empty if disabled.
+    static ::std::string filename() {
+      char const * fn = ::std::getenv("BL_BENCH_FILE");
+      return (fn == nullptr) ? ::std::string() : ::std::string(fn);
+    }
+
+    static bool enabled() {
+      return !filename().empty();
+    }
+
+    /// statistics of local values, as for a single rank.
+    static stats local(::std::vector<double> const & values) {
+      stats s;
+      s.mins = values;
+      s.maxs = values;
+      s.means = values;
+      s.stdevs.assign(values.size(), 0.0);
+      return s;
+    }
+
+    /// statistics over the ranks.  collective.
+    static stats reduce(::std::vector<double> const & values, ::mxx::comm const & comm) {
+      stats s;
+      if (values.size() == 0) return s;
+
+      int p = comm.size();
+      s.mins = ::mxx::reduce(values, 0, [](double const & x, double const & y) { return ::std::min(x, y); }, comm);
+      s.maxs = ::mxx::reduce(values, 0, [](double const & x, double const & y) { return ::std::max(x, y); }, comm);
+      s.means = ::mxx::reduce(values, 0, ::std::plus<double>(), comm);
+      ::std::vector<double> squares(values);
+      ::std::for_each(squares.begin(), squares.end(), [](double &x) { x = x*x; });
+      s.stdevs = ::mxx::reduce(squares, 0, ::std::plus<double>(), comm);
+
+      if (comm.rank() == 0) {
+        ::std::for_each(s.means.begin(), s.means.end(), [&p](double & x) { x /= p; });
+        ::std::transform(s.stdevs.begin(), s.stdevs.end(), s.means.begin(), s.stdevs.begin(),
+                         [&p](double const & x, double const & y) { return ::std::sqrt(::std::max(0.0, x / p - y * y)); });
+      }
+      return s;
+    }
+
+    /// append 1 row per phase for a metric.  call on rank 0 only.  does nothing if disabled.
+    static void append(::std::string const & title, ::std::string const & kind, ::std::vector<std::string> const & names,
+                       ::std::string const & metric, int ranks, stats const & s) {
+      ::std::string fn = filename();
+      if (fn.empty()) return;
+
+      FILE * fp = fopen(fn.c_str(), "a");
+      if (fp == NULL) return;  // benchmark output is best effort.
+
+      bool json = is_json(fn);
+      ::std::stringstream output;
+      output.precision(9);
+
+      if (!json && (ftell(fp) == 0)) output << "title,kind,index,phase,metric,ranks,min,max,mean,stdev\n";
+
+      size_t n = ::std::min(names.size(), s.mins.size());
+      for (size_t i = 0; i < n; ++i) {
+        if (json) {
+          output << "{\"title\":" << json_string(title) << ",\"kind\":" << json_string(kind) << ",\"index\":" << i <<
+              ",\"phase\":" << json_string(names[i]) << ",\"metric\":" << json_string(metric) << ",\"ranks\":" << ranks <<
+              ",\"min\":" << s.mins[i] << ",\"max\":" << s.maxs[i] << ",\"mean\":" << s.means[i] << ",\"stdev\":" << s.stdevs[i] << "}\n";
+        } else {
+          output << csv_string(title) << "," << kind << "," << i << "," << csv_string(names[i]) << "," << metric << "," << ranks <<
+              "," << s.mins[i] << "," << s.maxs[i] << "," << s.means[i] << "," << s.stdevs[i] << "\n";
+        }
+      }
+
+      fputs(output.str().c_str(), fp);
+      fclose(fp);
+    }
+};
+
+} // end namespace plog
+
+#endif /* SRC_UTILS_BENCHMARK_SINK_HPP_ */
@@ -24,6 +24,9 @@
 #define SRC_UTILS_BIT_OPS_HPP_
 
 #include <array>
+#include <cstdint>
+
+#include "utils/cpu_features.hpp"   // BMI2 pext/pdep, and runtime dispatch.
 
 namespace bliss {
 
@@ -54,6 +57,109 @@ namespace bliss {
       constexpr std::array<uint8_t, 16> pop_cnt<DUMMY>::LUT;
 
 
+      //===== packing of 8 bit codes into 2 or 4 bit fields, and DNA16 <-> DNA codes, 1 64 bit word at a time.
+      // BMI2 pext/pdep when available (see utils/cpu_features.hpp), else the same result with shifts and masks.
+      // fields are in the same order as the bytes / nibbles, lowest first, as in PackingIterator and Kmer.
+
+      namespace detail {
+        /// fields of BITS bits in every byte, BITS = 2 or 4.
+        template <unsigned int BITS>
+        struct byte_fields {
+            static_assert(BITS == 2 || BITS == 4, "only 2 and 4 bit fields are supported");
+            static constexpr uint64_t mask = (BITS == 2) ? 0x0303030303030303ULL : 0x0F0F0F0F0F0F0F0FULL;
+        };
+
+#if defined(BL_KERNEL_BMI2)
+        BL_TARGET("bmi2")
+        inline uint64_t pext_bmi2(uint64_t const x, uint64_t const mask) { return _pext_u64(x, mask); }
+        BL_TARGET("bmi2")
+        inline uint64_t pdep_bmi2(uint64_t const x, uint64_t const mask) { return _pdep_u64(x, mask); }
+#endif
+
+        /// pack the low 2 bits of each byte.  shift and or pairs, then pairs of pairs, ...
+        inline uint64_t pack_bytes_2(uint64_t x) {
+          x &= 0x0303030303030303ULL;
+          x = (x | (x >> 6)) & 0x000F000F000F000FULL;
+          x = (x | (x >> 12)) & 0x000000FF000000FFULL;
+          return (x | (x >> 24)) & 0xFFFFULL;
+        }
+        /// pack the low 4 bits of each byte.
+        inline uint64_t pack_bytes_4(uint64_t x) {
+          x &= 0x0F0F0F0F0F0F0F0FULL;
+          x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+          x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+          return (x | (x >> 16)) & 0xFFFFFFFFULL;
+        }
+        /// inverse of pack_bytes_2.
+        inline uint64_t unpack_bytes_2(uint64_t x) {
+          x &= 0xFFFFULL;
+          x = (x | (x << 24)) & 0x000000FF000000FFULL;
+          x = (x | (x << 12)) & 0x000F000F000F000FULL;
+          return (x | (x << 6)) & 0x0303030303030303ULL;
+        }
+        /// inverse of pack_bytes_4.
+        inline uint64_t unpack_bytes_4(uint64_t x) {
+          x &= 0xFFFFFFFFULL;
+          x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+          x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+          return (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        }
+      } // namespace detail
+
+      /// the low BITS bits of each of the 8 bytes of x, packed into the low 8 * BITS bits.
+      template <unsigned int BITS>
+      inline uint64_t pack_bytes(uint64_t const x) {
+#if defined(BL_KERNEL_BMI2)
+        if (::bliss::utils::cpu::use_bmi2()) return detail::pext_bmi2(x, detail::byte_fields<BITS>::mask);
+#endif
+        return (BITS == 2) ? detail::pack_bytes_2(x) : detail::pack_bytes_4(x);
+      }
+
+      /// inverse of pack_bytes:  the low 8 * BITS bits of x, 1 field per byte.
+      template <unsigned int BITS>
+      inline uint64_t unpack_bytes(uint64_t const x) {
+#if defined(BL_KERNEL_BMI2)
+        if (::bliss::utils::cpu::use_bmi2()) return detail::pdep_bmi2(x, detail::byte_fields<BITS>::mask);
+#endif
+        return (BITS == 2) ? detail::unpack_bytes_2(x) : detail::unpack_bytes_4(x);
+      }
+
+      /**
+       * @brief 16 DNA16 codes (4 bit, 1 hot:  A=1, C=2, G=4, T=8) to 16 DNA codes (2 bit:  A=0, C=1, G=2, T=3).
+       * @details  the 2 bit index of each nibble is computed for all nibbles at once, then compressed.
+       *           ambiguous codes, N and gap have no DNA equivalent, and give an unspecified code.
+       */
+      inline uint32_t dna16_to_dna(uint64_t const x) {
+        // index bit 0 is set for C and T, bit 1 for G and T.
+        uint64_t const lo = ((x >> 1) | (x >> 3)) & 0x1111111111111111ULL;
+        uint64_t const hi = ((x >> 2) | (x >> 3)) & 0x1111111111111111ULL;
+        uint64_t const idx = lo | (hi << 1);
+#if defined(BL_KERNEL_BMI2)
+        if (::bliss::utils::cpu::use_bmi2()) return static_cast<uint32_t>(detail::pext_bmi2(idx, 0x3333333333333333ULL));
+#endif
+        return static_cast<uint32_t>(detail::pack_bytes_4((idx | (idx >> 2)) & 0x0F0F0F0F0F0F0F0FULL));
+      }
+
+      /// 16 DNA codes (2 bit) to 16 DNA16 codes (4 bit, 1 hot).  inverse of dna16_to_dna.
+      inline uint64_t dna_to_dna16(uint32_t const x) {
+        uint64_t idx;
+#if defined(BL_KERNEL_BMI2)
+        if (::bliss::utils::cpu::use_bmi2()) idx = detail::pdep_bmi2(x, 0x3333333333333333ULL);
+        else
+#endif
+        {
+          idx = detail::unpack_bytes_4(x);
+          idx = (idx | (idx << 2)) & 0x3333333333333333ULL;
+        }
+        // 1 << index, per nibble.
+        uint64_t const i0 = idx & 0x1111111111111111ULL;
+        uint64_t const i1 = (idx >> 1) & 0x1111111111111111ULL;
+        uint64_t const n0 = i0 ^ 0x1111111111111111ULL;
+        uint64_t const n1 = i1 ^ 0x1111111111111111ULL;
+        return (n1 & n0) | ((n1 & i0) << 1) | ((i1 & n0) << 2) | ((i1 & i0) << 3);
+      }
+
+
     } // namespace bit_ops
 
 
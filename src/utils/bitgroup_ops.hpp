@@ -106,6 +106,7 @@ namespace bliss {
       static constexpr unsigned char BIT_REV_SWAR = 1;   // SIMD Within A Register
       static constexpr unsigned char BIT_REV_SSSE3 = 2;
       static constexpr unsigned char BIT_REV_AVX2 = 4;
+      static constexpr unsigned char BIT_REV_AVX512 = 8;   // AVX512BW.  uses VBMI and GFNI if available.
 
       // TODO: replace all unsigned char SIMD specifiers.
       // for now, this is used only for the generic operator version of reverse.
@@ -140,13 +141,32 @@ namespace bliss {
 #endif
       };
 
+      struct BITREV_AVX512 {
+#if defined(__AVX512BW__)
+    	  using MachineWord = __m512i;
+          static constexpr unsigned char SIMDVal = BIT_REV_AVX512;
+#elif defined(__AVX2__)
+    	  using MachineWord = __m256i;
+          static constexpr unsigned char SIMDVal = BIT_REV_AVX2;
+#elif defined(__SSSE3__)
+    	  using MachineWord = __m128i;
+          static constexpr unsigned char SIMDVal = BIT_REV_SSSE3;
+#else
+    	  using MachineWord = uint64_t;
+          static constexpr unsigned char SIMDVal = BIT_REV_SWAR;
+#endif
+      };
+
       /// automatically choose the most appropriate MachineWord and SIMD type based
       /// on supported simd capability and number of bytes to be reversed.
-      template <size_t BYTES, typename MAX_SIMD = BITREV_AVX2>
+      template <size_t BYTES, typename MAX_SIMD = BITREV_AVX512>
       struct BITREV_AUTO_AGGRESSIVE {
     	  using MachineWord =
+#if defined(__AVX512BW__)
+    			typename ::std::conditional<((BYTES > 32) && (MAX_SIMD::SIMDVal == BIT_REV_AVX512)), __m512i,
+#endif
 #if defined(__AVX2__)
-    			  typename ::std::conditional<((BYTES > 16) && (MAX_SIMD::SIMDVal == BIT_REV_AVX2)), __m256i,
+    			  typename ::std::conditional<((BYTES > 16) && (MAX_SIMD::SIMDVal >= BIT_REV_AVX2)), __m256i,
 #endif
 #if defined(__SSSE3__)
     			    typename ::std::conditional<((BYTES > 8) && (MAX_SIMD::SIMDVal >= BIT_REV_SSSE3)),  __m128i,
@@ -163,24 +183,32 @@ namespace bliss {
 #endif
 #if defined(__AVX2__)
 		          >::type
+#endif
+#if defined(__AVX512BW__)
+		        >::type
 #endif
     	  ;
 
     	  static constexpr unsigned char SIMDVal =
-    			  (BYTES > 16) ?
+    			  (BYTES > 32) ?
     					MAX_SIMD::SIMDVal :
+    					(BYTES > 16) ?
+    					  ((MAX_SIMD::SIMDVal > BIT_REV_AVX2) ? BIT_REV_AVX2 : MAX_SIMD::SIMDVal) :
     					(BYTES > 8) ?
-    					  ((MAX_SIMD::SIMDVal == BIT_REV_AVX2) ? BIT_REV_SSSE3 : MAX_SIMD::SIMDVal) :
+    					  ((MAX_SIMD::SIMDVal > BIT_REV_SSSE3) ? BIT_REV_SSSE3 : MAX_SIMD::SIMDVal) :
     					  BIT_REV_SWAR;
       };
 
       /// automatically choose the most appropriate MachineWord and SIMD type based
       /// on supported simd capability and number of bytes to be reversed.
-      template <size_t BYTES, typename MAX_SIMD = BITREV_AVX2>
+      template <size_t BYTES, typename MAX_SIMD = BITREV_AVX512>
       struct BITREV_AUTO_CONSERVATIVE {
     	  using MachineWord =
+#if defined(__AVX512BW__)
+    			typename ::std::conditional<((BYTES >= 64) && (MAX_SIMD::SIMDVal == BIT_REV_AVX512)), __m512i,
+#endif
 #if defined(__AVX2__)
-    			  typename ::std::conditional<((BYTES >= 32) && (MAX_SIMD::SIMDVal == BIT_REV_AVX2)), __m256i,
+    			  typename ::std::conditional<((BYTES >= 32) && (MAX_SIMD::SIMDVal >= BIT_REV_AVX2)), __m256i,
 #endif
 #if defined(__SSSE3__)
     			    typename ::std::conditional<((BYTES >= 16) && (MAX_SIMD::SIMDVal >= BIT_REV_SSSE3)),  __m128i,
@@ -197,14 +225,19 @@ namespace bliss {
 #endif
 #if defined(__AVX2__)
 		          >::type
+#endif
+#if defined(__AVX512BW__)
+		        >::type
 #endif
     	  ;
 
     	  static constexpr unsigned char SIMDVal =
-    			  (BYTES >= 32) ?
+    			  (BYTES >= 64) ?
     					MAX_SIMD::SIMDVal :
+    					(BYTES >= 32) ?
+    					  ((MAX_SIMD::SIMDVal > BIT_REV_AVX2) ? BIT_REV_AVX2 : MAX_SIMD::SIMDVal) :
     					(BYTES >= 16) ?
-    					  ((MAX_SIMD::SIMDVal == BIT_REV_AVX2) ? BIT_REV_SSSE3 : MAX_SIMD::SIMDVal) :
+    					  ((MAX_SIMD::SIMDVal > BIT_REV_SSSE3) ? BIT_REV_SSSE3 : MAX_SIMD::SIMDVal) :
     					  BIT_REV_SWAR;
       };
 
@@ -2010,6 +2043,366 @@ template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m256i bitgroup_ops<BIT
 
 
 
+#endif
+
+#if defined(__AVX512BW__)
+
+      // 512 bit word operations.  cross-lane moves are done with valignq (AVX512F), which shifts
+      // the concatenation of 2 registers by whole 64 bit elements.  VBMI2 provides the funnel shift.
+
+      /// shift right by SHIFT bits.  1 or 2 valignq, then 1 funnel shift (VBMI2) or 2 shifts and 1 or.
+      template <uint16_t SHIFT>
+      BITS_INLINE __m512i srli(__m512i const & val) {
+        if (SHIFT == 0) return val;
+        if (SHIFT >= 512) return _mm512_setzero_si512();
+
+        constexpr int word_shift = (SHIFT >> 6) & 0x7;   // whole 64 bit elements
+        constexpr int bit64_shift = SHIFT & 0x3F;        // shift within the 64 bit block
+
+        // val is H G F E D C B A (MSB to LSB).  lo is val shifted right by word_shift elements, with 0 filled in.
+        __m512i lo = _mm512_alignr_epi64(_mm512_setzero_si512(), val, word_shift);
+        if (bit64_shift == 0) return lo;
+
+        // hi is val shifted right by one more element.  supplies the bits shifted into each element of lo.
+        __m512i hi = (word_shift == 7) ? _mm512_setzero_si512() :
+            _mm512_alignr_epi64(_mm512_setzero_si512(), val, ((word_shift + 1) & 0x7));
+
+#if defined(__AVX512VBMI2__)
+        return _mm512_shrdi_epi64(lo, hi, bit64_shift);
+#else
+        return _mm512_or_si512(_mm512_srli_epi64(lo, bit64_shift), _mm512_slli_epi64(hi, 64 - bit64_shift));
+#endif
+      }
+
+      /// shift left by SHIFT bits.  1 or 2 valignq, then 1 funnel shift (VBMI2) or 2 shifts and 1 or.
+      template <uint16_t SHIFT>
+      BITS_INLINE __m512i slli(__m512i const & val) {
+        if (SHIFT == 0) return val;
+        if (SHIFT >= 512) return _mm512_setzero_si512();
+
+        constexpr int word_shift = (SHIFT >> 6) & 0x7;   // whole 64 bit elements
+        constexpr int bit64_shift = SHIFT & 0x3F;        // shift within the 64 bit block
+
+        // hi is val shifted left by word_shift elements, with 0 filled in.  (valignq by 8 would be 0, not val)
+        __m512i hi = (word_shift == 0) ? val :
+            _mm512_alignr_epi64(val, _mm512_setzero_si512(), ((8 - word_shift) & 0x7));
+        if (bit64_shift == 0) return hi;
+
+        // lo is val shifted left by one more element.  supplies the bits shifted into each element of hi.
+        __m512i lo = _mm512_alignr_epi64(val, _mm512_setzero_si512(), (7 - word_shift));
+
+#if defined(__AVX512VBMI2__)
+        return _mm512_shldi_epi64(hi, lo, bit64_shift);
+#else
+        return _mm512_or_si512(_mm512_slli_epi64(hi, bit64_shift), _mm512_srli_epi64(lo, 64 - bit64_shift));
+#endif
+      }
+
+      template <>
+      BITS_INLINE __m512i bit_not(__m512i const & u) {
+        return _mm512_ternarylogic_epi64(u, u, u, 0x55);  // truth table for NOT c.
+      }
+
+      template <typename DEST_WORD_TYPE, typename WORD_TYPE>
+      BITS_INLINE typename ::std::enable_if<::std::is_same<DEST_WORD_TYPE, __m512i>::value, __m512i>::type
+      loadu(WORD_TYPE const * u) {
+    	  return _mm512_loadu_si512(reinterpret_cast<void const *>(u));
+      }
+      template <typename SRC_WORD_TYPE, typename WORD_TYPE,
+       typename = typename ::std::enable_if<::std::is_same<SRC_WORD_TYPE, __m512i>::value>::type >
+      BITS_INLINE void storeu(WORD_TYPE * u, __m512i const & val) {
+    	  _mm512_storeu_si512(reinterpret_cast<void *>(u), val);
+      }
+
+      template <>
+      BITS_INLINE __m512i bit_or(__m512i const & u, __m512i const & v) {
+        return _mm512_or_si512(u, v);
+      }
+      template <>
+      BITS_INLINE __m512i bit_and(__m512i const & u, __m512i const & v) {
+        return _mm512_and_si512(u, v);
+      }
+      template <>
+      BITS_INLINE __m512i bit_xor(__m512i const & u, __m512i const & v) {
+        return _mm512_xor_si512(u, v);
+      }
+      template <>
+      BITS_INLINE __m512i zero() {
+        return _mm512_setzero_si512();
+      }
+      template <>
+      BITS_INLINE __m512i bit_max() {
+        return _mm512_set1_epi32(-1);
+      }
+
+      /// partial template specialization for AVX512BW based bit reverse.  this is defined only for bit_group_sizes that are 1, 2, 4, and 8 (actually powers of 2 up to 256bit)
+      /// with VBMI, the 64 bytes are reversed with a single vpermb.  with GFNI, the bits within each byte are reversed with a single affine transform.
+      template <unsigned int BIT_GROUP_SIZE, bool POW2>
+      struct bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2> {
+          static_assert(BIT_GROUP_SIZE > 0, "ERROR: BIT_GROUP_SIZE is 0");
+          static_assert(BIT_GROUP_SIZE < 512, "ERROR: BIT_GROUP_SIZE is greater than number of bits in __m512i");
+          static_assert((BIT_GROUP_SIZE & (BIT_GROUP_SIZE - 1)) == 0, "ERROR: BIT_GROUP_SIZE is has to be powers of 2");
+
+          static const __m512i rev_idx8;
+          static const __m512i rev_idx_lane8;
+          static const __m512i rev_idx16;
+          static const __m512i rev_idx32;
+          static const __m512i rev_idx64;
+          static const __m512i _mask_lo;
+          static const __m512i lut1_lo;
+          static const __m512i lut1_hi;
+          static const __m512i lut2_lo;
+          static const __m512i lut2_hi;
+
+          /// GF(2) affine matrix for reversing the bit groups within a byte.  byte (7 - i) selects the source of output bit i.
+          static constexpr uint64_t gf2_matrix = (BIT_GROUP_SIZE == 1) ? 0x8040201008040201ULL :
+                                                 (BIT_GROUP_SIZE == 2) ? 0x4080102004080102ULL :
+                                                 (BIT_GROUP_SIZE == 4) ? 0x1020408001020408ULL :
+                                                                         0x0102040810204080ULL;  // identity
+
+          static constexpr unsigned int bitsPerGroup = BIT_GROUP_SIZE;
+          static constexpr unsigned char simd_type = BIT_REV_AVX512;
+
+          bitgroup_ops() {}
+
+          static ::std::string toString(__m512i const & v) {
+            uint8_t BLISS_ALIGNED_ARRAY(tmp, 64, 64);
+            _mm512_store_si512((void*)tmp, v);
+            ::std::stringstream ss;
+            for (int i = 63; i >= 0; --i) {
+              ss << std::hex << std::setfill('0') << std::setw(2) << static_cast<size_t>(tmp[i]) << " ";
+            }
+            return ss.str();
+          }
+
+
+          /// reverse function to reverse bits for data types are are not __m512i.  the masked load does not read past len.
+          BITS_INLINE uint16_t reverse(uint8_t * out, uint8_t const * in, size_t const & len, uint16_t const bit_offset = 0) const {
+            if ((len << 3) < BIT_GROUP_SIZE) return bit_offset;
+            assert(len <= 64);
+            assert(((len << 3) % BIT_GROUP_SIZE) == 0);
+            assert(bit_offset == 0);
+
+            if (len == 64) {  // full 64 byte array and BIT_GROUP_SIZE is power of 2, so directly load and store.
+              _mm512_storeu_si512((void*)out, this->reverse( _mm512_loadu_si512((void const *)in) ));
+
+            } else {  // not the full 64 bytes.  reversed bytes end up in the high bytes, so copy those out.
+              __m512i w = this->reverse( _mm512_maskz_loadu_epi8(static_cast<__mmask64>((1ULL << len) - 1), in) );
+
+              uint8_t *tmp = reinterpret_cast<uint8_t*>(&w);
+              memcpy(out, tmp + 64 - len, len);
+            }
+            return 0;
+          }
+
+
+          template <unsigned int BITS = BIT_GROUP_SIZE>
+          BITS_INLINE typename std::enable_if<(BITS <= 8), __m512i>::type
+          reverse(__m512i const & u) const {
+
+            // reverse the bytes
+#if defined(__AVX512VBMI__)
+            __m512i v = _mm512_permutexvar_epi8(rev_idx8, u);      // all 64 bytes in 1 shuffle.   // VBMI
+#else
+            __m512i v = _mm512_shuffle_epi8(u, rev_idx_lane8);      // reverse 16 in each of 128 bit lane   // AVX512BW
+            v = _mm512_shuffle_i64x2(v, v, 0x1B);                   // then reverse the lanes       // AVX512F
+#endif
+            //== now see if we need to shuffle bits.
+            if (BITS == 8) return v;
+
+            return reverse_in_byte(v);
+          }
+
+
+          template <unsigned int BITS = BIT_GROUP_SIZE>
+          BITS_INLINE typename std::enable_if<(BITS > 8) && (BITS < 512), __m512i>::type
+          reverse(__m512i const & u) const {
+            //== reverse the bit groups via 1 permute operation
+            switch (BIT_GROUP_SIZE) {
+              case 16:  return _mm512_permutexvar_epi16(rev_idx16, u);    // AVX512BW
+              case 32:  return _mm512_permutexvar_epi32(rev_idx32, u);    // AVX512F
+              case 64:  return _mm512_permutexvar_epi64(rev_idx64, u);    // AVX512F
+              case 128: return _mm512_shuffle_i64x2(u, u, 0x1B);          // lanes 3 2 1 0 -> 0 1 2 3
+              case 256: return _mm512_shuffle_i64x2(u, u, 0x4E);          // lanes 3 2 1 0 -> 1 0 3 2
+              default:  return u;
+            }
+          }
+
+          template <unsigned int BITS = BIT_GROUP_SIZE>
+          BITS_INLINE typename std::enable_if<(BITS < 8) && ((BITS & (BITS - 1)) == 0), __m512i>::type
+          reverse_bits_in_byte(__m512i const & u) const {
+            return reverse_in_byte(u);
+          }
+
+        protected:
+          /// reverse bit groups within each byte.  BIT_GROUP_SIZE < 8.
+          BITS_INLINE __m512i reverse_in_byte(__m512i const & v) const {
+#if defined(__GFNI__)
+            return _mm512_gf2p8affine_epi64_epi8(v, _mm512_set1_epi64(gf2_matrix), 0);    // GFNI
+#else
+            // lower 4 bits, and upper 4 bits shifted down.  these are the lut indices.
+            __m512i lo = _mm512_and_si512(_mask_lo, v);
+            __m512i hi = _mm512_srli_epi16(_mm512_andnot_si512(_mask_lo, v), 4);
+
+            switch (BIT_GROUP_SIZE) {
+            case 1:
+              // hi and lo are swapped.
+              lo = _mm512_shuffle_epi8(lut1_hi, lo);
+              hi = _mm512_shuffle_epi8(lut1_lo, hi);
+              break;
+            case 2:
+              lo = _mm512_shuffle_epi8(lut2_hi, lo);
+              hi = _mm512_shuffle_epi8(lut2_lo, hi);
+              break;
+            case 4:
+              lo = _mm512_slli_epi16(lo, 4);  // shift lower 4 to upper
+              break;
+            default:
+              break;
+            }
+
+            // recombine
+            return _mm512_or_si512(lo, hi);
+#endif
+          }
+
+      };
+template <unsigned int BIT_GROUP_SIZE, bool POW2> constexpr uint64_t bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::gf2_matrix;
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::rev_idx8 =
+    _mm512_set_epi64(0x0001020304050607, 0x08090A0B0C0D0E0F, 0x1011121314151617, 0x18191A1B1C1D1E1F,
+                     0x2021222324252627, 0x28292A2B2C2D2E2F, 0x3031323334353637, 0x38393A3B3C3D3E3F);
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::rev_idx_lane8 =
+    _mm512_set_epi64(0x0001020304050607, 0x08090A0B0C0D0E0F, 0x0001020304050607, 0x08090A0B0C0D0E0F,
+                     0x0001020304050607, 0x08090A0B0C0D0E0F, 0x0001020304050607, 0x08090A0B0C0D0E0F);
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::rev_idx16 =
+    _mm512_set_epi64(0x0000000100020003, 0x0004000500060007, 0x00080009000A000B, 0x000C000D000E000F,
+                     0x0010001100120013, 0x0014001500160017, 0x00180019001A001B, 0x001C001D001E001F);
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::rev_idx32 =
+    _mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::rev_idx64 =
+    _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::_mask_lo = _mm512_set1_epi32(0x0F0F0F0F);
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::lut1_lo = _mm512_broadcast_i32x4(_mm_setr_epi32(0x0c040800, 0x0e060a02, 0x0d050901, 0x0f070b03));
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::lut1_hi = _mm512_broadcast_i32x4(_mm_setr_epi32(0xc0408000, 0xe060a020, 0xd0509010, 0xf070b030));
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::lut2_lo = _mm512_broadcast_i32x4(_mm_setr_epi32(0x0c080400, 0x0d090501, 0x0e0a0602, 0x0f0b0703));
+template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m512i bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512, POW2>::lut2_hi = _mm512_broadcast_i32x4(_mm_setr_epi32(0xc0804000, 0xd0905010, 0xe0a06020, 0xf0b07030));
+
+      /// partial template specialization for AVX512BW based bit reverse, for bit group size of 3.
+      template <bool POW2>
+      struct bitgroup_ops<3, BIT_REV_AVX512, POW2> {
+
+          static constexpr unsigned int bitsPerGroup = 3;
+          static constexpr unsigned char simd_type = BIT_REV_AVX512;
+
+          bitgroup_ops<1, BIT_REV_AVX512, true> bit_rev_1;
+
+          static const __m512i mask3lo;
+          static const __m512i mask3mid;
+          static const __m512i mask3hi;
+
+
+          bitgroup_ops() {}
+
+
+          static ::std::string toString(__m512i const & v) {
+            uint8_t BLISS_ALIGNED_ARRAY(tmp, 64, 64);
+            _mm512_store_si512((void*)tmp, v);
+            ::std::stringstream ss;
+            for (int i = 63; i >= 0; --i) {
+              ss << std::hex << std::setfill('0') << std::setw(2) << static_cast<size_t>(tmp[i]) << " ";
+            }
+            return ss.str();
+          }
+
+
+          /// reverse function to reverse bits for data types are are not __m512i.
+          /// the masked load zeros the part outside of len, since reverse may involve bits outside of len.
+          BITS_INLINE uint16_t reverse(uint8_t * out, uint8_t const * in, size_t const & len, uint16_t const bit_offset = 0) const {
+            if (len == 0) return bit_offset;
+            assert(len <= 64);
+
+            // enforce bit_offset to be less than 8, since we are ORing the first and last bytes.
+            assert(bit_offset < 8);
+
+            __m512i v = (len == 64) ? _mm512_loadu_si512((void const *)in) :
+                _mm512_maskz_loadu_epi8(static_cast<__mmask64>((1ULL << len) - 1), in);
+
+            v = this->reverse( v, bit_offset );
+
+            // save the first and last byte, then copy the data back, finally OR the first and last byte back.
+            uint8_t first = out[0], last = out[len-1];
+
+            if (len == 64) {
+              _mm512_storeu_si512((void*)out, v);
+            } else {
+              uint8_t * tmp = reinterpret_cast<uint8_t*>(&v);
+              memcpy(out, tmp + (64 - len), len);
+            }
+
+            // or back the old values.
+            out[0] |= first;
+            out[len-1] |= last;
+
+            // return remainder.
+            return ((len << 3) - bit_offset) % 3;
+          }
+
+          BITS_INLINE __m512i reverse(__m512i const & u, uint16_t bit_offset) const {
+            switch (bit_offset % 3) {
+              case 0: return reverse<0>(::std::forward<__m512i const>(u)); break;
+              case 1: return reverse<1>(::std::forward<__m512i const>(u)); break;
+              case 2: return reverse<2>(::std::forward<__m512i const>(u)); break;
+              default: return _mm512_setzero_si512();
+                break;
+            }
+          }
+
+          /// reverse in groups of 3 bits.  NOTE: within the offset or remainder, the middle bit remains,
+          /// while the high and low bits are zeroed during the reversal.  this makes OR'ing with adjacent
+          /// entries simple.
+          template <uint16_t offset = 0>
+          BITS_INLINE __m512i reverse(__m512i const & u) const {
+
+            // get the individual bits.
+            __m512i lo = _mm512_and_si512(u, mask3lo);
+            __m512i mid = _mm512_and_si512(u, mask3mid);
+            __m512i hi = _mm512_and_si512(u, mask3hi);
+
+            __m512i v;
+            // next shift based on the rem bits.  lo and hi trade places, mid stays.  2 cross boundary shifts and 2 ORs
+            // (vpternlogq merges the 3 in 1 instruction).
+            switch (offset % 3) {
+            case 2:
+              // rem == 2:                    mid, hi, lo
+              v = _mm512_ternarylogic_epi64(srli<2>(mid), lo, slli<2>(hi), 0xFE);
+              break;
+            case 1:
+              // rem == 1:                    hi, lo, mid
+              v = _mm512_ternarylogic_epi64(srli<2>(lo), hi, slli<2>(mid), 0xFE);
+              break;
+            default:
+              // rem == 0:  first 3 bits are: lo, mid, hi in order of significant bits
+              v = _mm512_ternarylogic_epi64(srli<2>(hi), mid, slli<2>(lo), 0xFE);
+              break;
+            }
+
+            //========================== then reverse bits in groups of 1.
+            return bit_rev_1.reverse(v);
+          }
+
+
+      };
+      template <bool POW2> const __m512i bitgroup_ops<3, BIT_REV_AVX512, POW2>::mask3lo  =
+        _mm512_setr_epi32(0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492,
+                          0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249);
+      template <bool POW2> const __m512i bitgroup_ops<3, BIT_REV_AVX512, POW2>::mask3mid =
+        _mm512_setr_epi32(0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924,
+                          0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492);
+      template <bool POW2> const __m512i bitgroup_ops<3, BIT_REV_AVX512, POW2>::mask3hi  =
+        _mm512_setr_epi32(0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249,
+                          0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924, 0x49249249, 0x92492492, 0x24924924);
+
+
 #endif
 
       /**
@@ -2021,6 +2414,7 @@ template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m256i bitgroup_ops<BIT
        *            BSWAP |       any        |    <= 8; pow2, 3  |      none        |
        *            SSSE3 |     > 64         |        pow2, 3    |   SSSE3, AVX2    |
        *            AVX2  |     > 128        |        pow2, 3    |      AVX2        |
+       *            AVX512|     > 256        |        pow2, 3    |     AVX512BW     |
        *
        *    if the requirement is not satisfied, then it should fallback to next lowest.
        */
@@ -3379,6 +3773,119 @@ template <unsigned int BIT_GROUP_SIZE, bool POW2> const __m256i bitgroup_ops<BIT
 #endif
 
 
+#ifdef __AVX512BW__
+      /**
+       * @brief
+       * @details   enabled only if BIT_GROUP_SIZE is power of 2, and greater than 0.
+       * @param out
+       * @param in
+       * @param len      number of words.
+       * @param bit_offset
+       * @return
+       */
+      template <unsigned int BIT_GROUP_SIZE, unsigned char MAX_SIMD_TYPE, typename WORD_TYPE,
+          unsigned int WordsInM512 = sizeof(__m512i) / sizeof(WORD_TYPE)>
+      BITS_INLINE typename std::enable_if<(MAX_SIMD_TYPE == BIT_REV_AVX512) &&
+                                          ((BIT_GROUP_SIZE & (BIT_GROUP_SIZE - 1)) == 0), uint16_t>::type
+      reverse(WORD_TYPE * out, WORD_TYPE const * in, size_t const & len, uint16_t bit_offset = 0 ) {
+
+        static_assert(BIT_GROUP_SIZE > 0, "ERROR: BIT_GROUP_SIZE cannot be 0");
+        static_assert(BIT_GROUP_SIZE <= (sizeof(__m256i) << 3), "ERROR: currenly reverse does not support 512 BIT_GRUOP_SIZE for AVX512");
+
+        assert(bit_offset == 0);
+        assert(((len * sizeof(WORD_TYPE) << 3) / BIT_GROUP_SIZE) >= 1);
+
+        size_t rem = len;
+        // pointers
+        __m512i * w = reinterpret_cast<__m512i *>(out + len);
+        __m512i const * u = reinterpret_cast<__m512i const *>(in);
+
+        bitgroup_ops<BIT_GROUP_SIZE, BIT_REV_AVX512> op512;
+
+
+        for (; rem >= WordsInM512; rem -= WordsInM512) {
+          // enough bytes.  do an iteration
+          --w;
+          _mm512_storeu_si512(w, op512.reverse(_mm512_loadu_si512(u)));
+          ++u;
+        }
+        if (rem > 0) {  // 0 < rem < WordsInM512
+          // do another iteration with all the remaining.
+          if (len >= WordsInM512) {  // original length has 64 bytes or more, so avoid memcpy.  duplicate a little work but that's okay.
+            _mm512_storeu_si512(out, op512.reverse(_mm512_loadu_si512(in + len - WordsInM512)));
+          } else {  // original length is less than 64 bytes.  masked load so we don't read past the end.
+            op512.reverse(reinterpret_cast<uint8_t *>(out), reinterpret_cast<uint8_t const *>(in), rem * sizeof(WORD_TYPE));
+          }
+        }
+
+        return 0;  // return remainder.
+      }
+
+      template <unsigned int BIT_GROUP_SIZE, unsigned char MAX_SIMD_TYPE, typename WORD_TYPE,
+          unsigned int WordsInM512 = sizeof(__m512i) / sizeof(WORD_TYPE)>
+      BITS_INLINE typename std::enable_if<(MAX_SIMD_TYPE == BIT_REV_AVX512) &&
+                                          (BIT_GROUP_SIZE == 3), uint16_t>::type
+      reverse(WORD_TYPE * out, WORD_TYPE const * in, size_t const & len, uint16_t bit_offset = 0 ) {
+
+        size_t bytes = len * sizeof(WORD_TYPE);
+
+        memset(out, 0, bytes);  // needed because we bitwise OR.
+
+        size_t rem = bytes;
+        // pointers
+        uint8_t * w = reinterpret_cast<uint8_t *>(out + len);
+        uint8_t const * u = reinterpret_cast<uint8_t const *>(in);
+        uint16_t init_offset = bit_offset;
+
+        bitgroup_ops<3, BIT_REV_AVX512, false> op512;
+
+        for (; rem >= 64; rem -= 64) {
+          // enough bytes.  do an iteration
+          w -= 64;
+          bit_offset = op512.reverse(w, u, 64, bit_offset);
+          u += 64;
+
+          if ((rem > 64) && (bit_offset > 0) ) {  // if there is overlap.  adjust
+            u -= 1;
+            rem += 1;
+            w += 1;
+            bit_offset = static_cast<unsigned short>(8) - bit_offset;
+          } // else no adjustment is needed.
+        }
+        if (rem > 0) {
+          // do another iteration with all the remaining.   note that offset is tied to the current u position, so can't use memcpy-avoiding approach.
+          if (bytes >= 64) {
+            bit_offset = (((bytes - 64) << 3) - init_offset) % BIT_GROUP_SIZE;
+            bit_offset = (bit_offset == 0) ? 0 : (BIT_GROUP_SIZE - bit_offset);
+            bit_offset = op512.reverse(reinterpret_cast<uint8_t *>(out),
+                                       reinterpret_cast<uint8_t const *>(in) + bytes - 64,
+                                       64, bit_offset);
+          } else {
+            // original length is less than 64
+            bit_offset = op512.reverse(reinterpret_cast<uint8_t *>(out),
+                                       reinterpret_cast<uint8_t const *>(in) + bytes - rem,
+                                       rem, bit_offset);
+          }
+        }
+        return bit_offset;
+
+      }
+
+#else
+      template <unsigned int BIT_GROUP_SIZE, unsigned char MAX_SIMD_TYPE, typename WORD_TYPE,
+          unsigned int WordsInM512 = 64 / sizeof(WORD_TYPE)>
+      BITS_INLINE typename std::enable_if<(MAX_SIMD_TYPE == BIT_REV_AVX512), uint16_t>::type
+      reverse(WORD_TYPE * out, WORD_TYPE const * in, size_t const & len, uint16_t bit_offset = 0 ) {
+        // cascade to AVX2 and let the choice of implementation be decided there.
+        return reverse<BIT_GROUP_SIZE, BIT_REV_AVX2>( ::std::forward<WORD_TYPE *>(out),
+                                                      ::std::forward<WORD_TYPE const *>(in),
+                                                       len,
+                                                       bit_offset);
+      }
+
+#endif
+
+
 
 
 
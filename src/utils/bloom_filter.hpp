@@ -0,0 +1,119 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    bloom_filter.hpp
+ * @ingroup utils
+ * @brief   Bloom filter over 64 bit hash values.
+ * @details the bit positions are derived from the input hash by double hashing, so one well mixed hash value
+ *          (see mix64) per key is enough.  the bit array size is a power of 2.
+ *
+ *          filters of the same size and number of hashes can be merged by OR-ing their words, e.g. with an
+ *          allreduce, to get a filter of the union of the keys.
+ *          with b bits per key and the optimal round(b * ln 2) hashes, the false positive rate is about 0.6185^b.
+ */
+#ifndef SRC_UTILS_BLOOM_FILTER_HPP_
+#define SRC_UTILS_BLOOM_FILTER_HPP_
+
+#include <vector>
+#include <cstdint>  // uint8_t, uint64_t
+#include <cmath>    // round
+#include <algorithm>  // fill
+
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace bliss {
+
+  namespace utils {
+
+    /**
+     * @brief Bloom filter.  insert never fails, contains may have false positives but no false negatives.
+     */
+    class bloom_filter {
+
+      protected:
+        std::vector<uint64_t> words;
+        uint64_t mask;
+        uint8_t num_hashes;
+
+      public:
+        bloom_filter() : mask(0), num_hashes(0) {}
+
+        /// optimal number of hashes for a given number of bits per key.
+        static uint8_t optimal_hashes(double bits_per_key) {
+          double k = ::std::round(bits_per_key * 0.6931471805599453);
+          return (k < 1.0) ? 1 : ((k > 16.0) ? 16 : static_cast<uint8_t>(k));
+        }
+
+        /// clear and resize.  nbits is rounded up to a power of 2, at least 64.
+        void resize(size_t nbits, uint8_t nhashes) {
+          size_t b = 64;
+          while (b < nbits) b <<= 1;
+          mask = b - 1;
+          num_hashes = (nhashes < 1) ? 1 : nhashes;
+          words.assign(b >> 6, 0);
+        }
+
+        inline void insert(uint64_t const & hash) {
+          uint64_t h2 = mix64(hash) | 1;
+          uint64_t h = hash;
+          for (uint8_t i = 0; i < num_hashes; ++i, h += h2) {
+            words[(h & mask) >> 6] |= (1ULL << (h & 63));
+          }
+        }
+
+        /// false if the hash value was definitely not inserted.  false for an empty (unsized) filter.
+        inline bool contains(uint64_t const & hash) const {
+          if (words.empty()) return false;
+          uint64_t h2 = mix64(hash) | 1;
+          uint64_t h = hash;
+          for (uint8_t i = 0; i < num_hashes; ++i, h += h2) {
+            if ((words[(h & mask) >> 6] & (1ULL << (h & 63))) == 0) return false;
+          }
+          return true;
+        }
+
+        /// merge a filter of the same size and number of hashes.
+        void merge(bloom_filter const & other) {
+          for (size_t i = 0; i < words.size(); ++i) words[i] |= other.words[i];
+        }
+
+        void clear() {
+          ::std::fill(words.begin(), words.end(), 0);
+        }
+
+        /// true if the filter has not been sized.
+        bool empty() const { return words.empty(); }
+
+        /// release the memory.
+        void reset() {
+          ::std::vector<uint64_t>().swap(words);
+          mask = 0;
+          num_hashes = 0;
+        }
+
+        size_t bit_count() const { return words.size() << 6; }
+
+        /// raw words, e.g. for merging filters from other processes with a bitwise or reduction.
+        std::vector<uint64_t> & get_words() { return words; }
+        std::vector<uint64_t> const & get_words() const { return words; }
+    };
+
+
+  } // namespace utils
+} // namespace bliss
+
+#endif /* SRC_UTILS_BLOOM_FILTER_HPP_ */
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    cache_utils.hpp
+ * @ingroup
+ * @brief   drop the page cache before file io benchmarks.
+ * @details drop_file_cache evicts 1 file's clean pages with posix_fadvise(DONTNEED).  it needs no privilege and is fast,
+ *          so it can run before every timed read.  clear_cache evicts everything by allocating and touching most of
+ *          the free memory, for when the file's pages are not the only ones that matter.  used by utils/clear_cache
+ *          and BenchmarkFileLoader.
+ */
+#ifndef SRC_UTILS_CACHE_UTILS_HPP_
+#define SRC_UTILS_CACHE_UTILS_HPP_
+
+#include <string>
+#include <vector>
+#include <cstring>    // memset
+#include <cstdio>     // printf
+
+#include <fcntl.h>    // open, posix_fadvise
+#include <unistd.h>   // close, fdatasync
+
+#include "utils/memory_usage.hpp"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace bliss {
+  namespace utils {
+
+    namespace cache {
+
+      /// evict the file's pages from the page cache of this node.  returns false if the file cannot be opened.
+      inline bool drop_file_cache(std::string const & filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1) return false;
+
+        // dirty pages are not dropped.  flush them first.
+        fdatasync(fd);
+        int ret = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+        return ret == 0;
+      }
+
+      /**
+       * @brief  clear the disk cache in linux by allocating a bunch of memory.
+       * @details  in 1MB chunks to workaround memory fragmentation preventing allocation.
+       *           can potentially use swap, or if there is not enough physical + swap, be killed.
+       *
+       */
+      inline void clear_cache(bool const verbose = true) {
+        size_t avail = ::plog::MemUsage::get_usable_mem();
+        size_t rem = avail;
+
+        size_t minchunk = 1UL << 24;    // 16MB chunks
+        size_t chunk = minchunk;
+
+        size_t maxchunk = std::min(1UL << 36, (avail >> 4));
+        for ( ;chunk < maxchunk; chunk <<= 1) ;   // keep increasing chunks until larger than 1/16 of avail, or until 1GB.
+
+        std::vector<size_t *> dummy;
+
+        size_t nchunks;
+        size_t j = 0, lj;
+
+#if defined(USE_OPENMP)
+        int max_threads = omp_get_max_threads();
+
+        if (max_threads > 8) max_threads -= 2;
+        else if (max_threads > 4) max_threads -= 1;
+#else
+        int max_threads = 1;
+#endif
+
+        if (verbose) printf("begin clearing %lu bytes using %d threads\n", avail, max_threads);
+        size_t iter_cleared = 0;
+
+        while ((chunk >= minchunk) && (rem > minchunk)) {
+          nchunks = rem / chunk;
+
+          iter_cleared = 0;
+          lj = 0;
+#if defined(USE_OPENMP)
+#pragma omp parallel for num_threads(max_threads) shared(nchunks, chunk, dummy) reduction(+:lj, iter_cleared)
+#endif
+          for (size_t i = 0; i < nchunks; ++i) {
+            // (c|m)alloc/free seems to be optimized out.  using new works.
+            size_t * ptr = new size_t[(chunk / sizeof(size_t))];
+
+            iter_cleared += chunk;
+            memset(ptr, 0, chunk);
+            ptr[0] = i;
+
+#if defined(USE_OPENMP)
+#pragma omp critical
+#endif
+            {
+              dummy.push_back(ptr);
+            }
+
+            ++lj;
+          }
+
+          j += lj;
+
+          rem -= iter_cleared;
+
+          if (verbose) {
+            printf("cleared %lu bytes using %lu chunk %lu bytes. total cleared %lu bytes, rem %lu bytes \n", iter_cleared, nchunks, chunk, avail - rem, rem);
+            fflush(stdout);
+          }
+
+          // reduce the size of the chunk by 4
+          chunk >>= 4;
+
+        }
+        if (verbose) {
+          printf("finished clearing %lu/%lu bytes with %lu remaining\n", avail - rem, avail, rem);
+          fflush(stdout);
+        }
+
+        size_t sum = 0;
+        size_t ii = 0;
+        size_t *ptr;
+        for (; ii < dummy.size(); ++ii) {
+          ptr = dummy[ii];
+
+          if (ptr != nullptr) {
+            sum += ptr[ii >> 10];
+            delete [] ptr;
+            dummy[ii] = nullptr;
+          } else {
+            break;
+          }
+        }
+        if (verbose) printf("disk cache cleared (dummy %lu). %lu blocks %lu bytes\n", sum, j, avail - rem);
+      }
+
+    }
+
+  }
+}
+
+#endif /* SRC_UTILS_CACHE_UTILS_HPP_ */
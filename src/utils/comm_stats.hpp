@@ -0,0 +1,246 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    comm_stats.hpp
+ * @ingroup
+ * @brief   per phase communication volume and load imbalance counters for the all-to-all exchanges.
+ * @details each phase records the local send and receive element counts and bytes, the largest and smallest
+ *          destination bucket, and the time spent in MPI calls versus local work.  the report aggregates them over the
+ *          ranks like the Timer report, and adds the imbalance of each phase:  max / mean of the received elements
+ *          (and of the sent), so 1.0 is perfectly balanced.  a phase that is slow with a high imbalance is skewed, one
+ *          that is slow with a high mpi fraction and low imbalance is bandwidth bound.
+ *
+ *          enabled with ENABLE_COMM_BENCHMARK (BL_BENCHMARK_COMM).  rows also go to the BL_BENCH_FILE sink, kind "comm".
+ */
+#ifndef SRC_UTILS_COMM_STATS_HPP_
+#define SRC_UTILS_COMM_STATS_HPP_
+
+#include "bliss-logger_config.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>  // min, max, min_element, max_element
+#include <numeric>    // accumulate
+#include <sstream>
+#include <iterator>   // ostream_iterator
+#include <cstdio>     // printf
+
+#include <mxx/reduction.hpp>
+
+#include "utils/benchmark_sink.hpp"
+
+namespace plog {
+
+class CommStats {
+  protected:
+    std::vector<std::string> names;
+    std::vector<double> send_elems;
+    std::vector<double> recv_elems;
+    std::vector<double> send_bytes;
+    std::vector<double> recv_bytes;
+    std::vector<double> bucket_max;
+    std::vector<double> bucket_min;
+    std::vector<double> mpi_time;
+    std::vector<double> local_time;
+
+    std::chrono::steady_clock::time_point t1, mpi_t1;
+    std::chrono::duration<double> mpi_span;
+
+    static ::std::vector<double> ratio(::std::vector<double> const & x, ::std::vector<double> const & y) {
+      ::std::vector<double> result(x.size(), 1.0);
+      for (size_t i = 0; i < x.size(); ++i) {
+        if (y[i] > 0.0) result[i] = x[i] / y[i];
+      }
+      return result;
+    }
+
+  public:
+    CommStats() : mpi_span(std::chrono::duration<double>::zero()) {
+      reset();
+    }
+
+    void reset() {
+      names.clear();
+      send_elems.clear();
+      recv_elems.clear();
+      send_bytes.clear();
+      recv_bytes.clear();
+      bucket_max.clear();
+      bucket_min.clear();
+      mpi_time.clear();
+      local_time.clear();
+
+      start();
+    }
+
+    /// start a phase.
+    void start() {
+      t1 = std::chrono::steady_clock::now();
+      mpi_span = std::chrono::duration<double>::zero();
+    }
+    /// bracket the MPI calls of the current phase.
+    void mpi_start() {
+      mpi_t1 = std::chrono::steady_clock::now();
+    }
+    void mpi_end() {
+      mpi_span += std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - mpi_t1);
+    }
+
+    /// end a phase, and start the next.  the buckets are the per destination send counts.
+    void end(::std::string const & name, double const & n_send, double const & n_recv,
+             double const & max_bucket, double const & min_bucket, size_t const & elem_bytes) {
+      std::chrono::duration<double> span =
+          std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - t1);
+
+      names.push_back(name);
+      send_elems.push_back(n_send);
+      recv_elems.push_back(n_recv);
+      send_bytes.push_back(n_send * elem_bytes);
+      recv_bytes.push_back(n_recv * elem_bytes);
+      bucket_max.push_back(max_bucket);
+      bucket_min.push_back(min_bucket);
+      mpi_time.push_back(mpi_span.count());
+      local_time.push_back(::std::max(0.0, span.count() - mpi_span.count()));
+
+      // the next phase starts here.
+      start();
+    }
+
+    /// end a phase from the per rank send and receive counts.
+    template <typename SIZE>
+    void end(::std::string const & name, ::std::vector<SIZE> const & send_counts, ::std::vector<SIZE> const & recv_counts,
+             size_t const & elem_bytes) {
+      double n_send = ::std::accumulate(send_counts.begin(), send_counts.end(), 0.0);
+      double n_recv = ::std::accumulate(recv_counts.begin(), recv_counts.end(), 0.0);
+      double mx = send_counts.empty() ? 0.0 : static_cast<double>(*::std::max_element(send_counts.begin(), send_counts.end()));
+      double mn = send_counts.empty() ? 0.0 : static_cast<double>(*::std::min_element(send_counts.begin(), send_counts.end()));
+      end(name, n_send, n_recv, mx, mn, elem_bytes);
+    }
+
+    void report(::std::string const & title, ::mxx::comm const & comm) {
+      if (names.size() == 0) return;
+
+      int p = comm.size();
+      int rank = comm.rank();
+
+      ::plog::BenchSink::stats sends = ::plog::BenchSink::reduce(send_elems, comm);
+      ::plog::BenchSink::stats recvs = ::plog::BenchSink::reduce(recv_elems, comm);
+      ::plog::BenchSink::stats sbytes = ::plog::BenchSink::reduce(send_bytes, comm);
+      ::plog::BenchSink::stats rbytes = ::plog::BenchSink::reduce(recv_bytes, comm);
+      ::plog::BenchSink::stats bmax = ::plog::BenchSink::reduce(bucket_max, comm);
+      ::plog::BenchSink::stats bmin = ::plog::BenchSink::reduce(bucket_min, comm);
+      ::plog::BenchSink::stats mpi = ::plog::BenchSink::reduce(mpi_time, comm);
+      ::plog::BenchSink::stats local = ::plog::BenchSink::reduce(local_time, comm);
+
+      if (rank != 0) return;
+
+      ::std::vector<double> send_imbalance = ratio(sends.maxs, sends.means);
+      ::std::vector<double> recv_imbalance = ratio(recvs.maxs, recvs.means);
+      ::std::vector<double> total_time(mpi.means.size());
+      ::std::transform(mpi.means.begin(), mpi.means.end(), local.means.begin(), total_time.begin(), ::std::plus<double>());
+      ::std::vector<double> mpi_fraction = ratio(mpi.means, total_time);
+
+      std::stringstream output;
+      std::ostream_iterator<std::string> nit(output, ",");
+      std::ostream_iterator<double> dit(output, ",");
+
+      auto row = [&output, &dit, &title](char const * label, ::std::vector<double> const & v) {
+        output << "[COMM] " << title << "\t" << label << "\t[,";
+        std::copy(v.begin(), v.end(), dit);
+        output << "]" << std::endl;
+      };
+
+      output << std::fixed;
+      output << "[COMM] " << "R " << rank << "/" << p << std::endl;
+
+      output << "[COMM] " << title << "\theader\t[,";
+      std::copy(names.begin(), names.end(), nit);
+      output << "]" << std::endl;
+
+      output.precision(0);
+      row("send_min", sends.mins);
+      row("send_max", sends.maxs);
+      row("recv_min", recvs.mins);
+      row("recv_max", recvs.maxs);
+      row("bucket_max", bmax.maxs);
+      row("bucket_min", bmin.mins);
+      row("recv_bytes_max", rbytes.maxs);
+
+      output.precision(2);
+      row("send_mean", sends.means);
+      row("recv_mean", recvs.means);
+
+      output.precision(3);
+      row("send_imbalance", send_imbalance);
+      row("recv_imbalance", recv_imbalance);
+
+      output.precision(9);
+      row("mpi_s_max", mpi.maxs);
+      row("mpi_s_mean", mpi.means);
+      row("local_s_max", local.maxs);
+      row("local_s_mean", local.means);
+
+      output.precision(3);
+      output << "[COMM] " << title << "\tmpi_fraction\t[,";
+      std::copy(mpi_fraction.begin(), mpi_fraction.end(), dit);
+      output << "]";
+
+      fflush(stdout);
+      printf("%s\n", output.str().c_str());
+      fflush(stdout);
+
+      ::plog::BenchSink::append(title, "comm", names, "send_elems", p, sends);
+      ::plog::BenchSink::append(title, "comm", names, "recv_elems", p, recvs);
+      ::plog::BenchSink::append(title, "comm", names, "send_bytes", p, sbytes);
+      ::plog::BenchSink::append(title, "comm", names, "recv_bytes", p, rbytes);
+      ::plog::BenchSink::append(title, "comm", names, "bucket_max", p, bmax);
+      ::plog::BenchSink::append(title, "comm", names, "bucket_min", p, bmin);
+      ::plog::BenchSink::append(title, "comm", names, "mpi_s", p, mpi);
+      ::plog::BenchSink::append(title, "comm", names, "local_s", p, local);
+
+      // derived from the statistics, so min, max, and mean are the same.
+      ::plog::BenchSink::append(title, "comm", names, "recv_imbalance", p, ::plog::BenchSink::local(recv_imbalance));
+      ::plog::BenchSink::append(title, "comm", names, "send_imbalance", p, ::plog::BenchSink::local(send_imbalance));
+    }
+};
+
+} // end namespace plog
+
+#if BL_BENCHMARK_COMM == 1
+
+#define BL_COMM_INIT(title)      ::plog::CommStats title##_commstats;
+#define BL_COMM_START(title)     do { title##_commstats.start(); } while (0)
+#define BL_COMM_MPI_START(title) do { title##_commstats.mpi_start(); } while (0)
+#define BL_COMM_MPI_END(title)   do { title##_commstats.mpi_end(); } while (0)
+#define BL_COMM_END(title, name, send_counts, recv_counts, elem_bytes) do { title##_commstats.end(name, send_counts, recv_counts, elem_bytes); } while (0)
+#define BL_COMM_END_TOTALS(title, name, n_send, n_recv, max_bucket, min_bucket, elem_bytes) do { title##_commstats.end(name, n_send, n_recv, max_bucket, min_bucket, elem_bytes); } while (0)
+#define BL_COMM_REPORT_MPI_NAMED(title, name, comm) do { title##_commstats.report(name, comm); } while (0)
+
+#else
+
+#define BL_COMM_INIT(title)
+#define BL_COMM_START(title)
+#define BL_COMM_MPI_START(title)
+#define BL_COMM_MPI_END(title)
+#define BL_COMM_END(title, name, send_counts, recv_counts, elem_bytes)
+#define BL_COMM_END_TOTALS(title, name, n_send, n_recv, max_bucket, min_bucket, elem_bytes)
+#define BL_COMM_REPORT_MPI_NAMED(title, name, comm)
+
+#endif
+
+#endif /* SRC_UTILS_COMM_STATS_HPP_ */
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    count_min_sketch.hpp
+ * @ingroup utils
+ * @brief   count-min sketch with 1-byte saturating counters.
+ * @details approximate occurrence counts of values, from their 64 bit hash values.  DEPTH rows of counters,
+ *          each row indexed by a different hash derived from the input hash by double hashing.
+ *          with conservative update, only the counters equal to the current minimum are incremented, which
+ *          reduces the overestimate.  the estimate never undercounts, but saturates at 255.
+ *
+ *          the hash values should be well mixed, as for hyperloglog.  see mix64.
+ */
+#ifndef SRC_UTILS_COUNT_MIN_SKETCH_HPP_
+#define SRC_UTILS_COUNT_MIN_SKETCH_HPP_
+
+#include <vector>
+#include <cstdint>  // uint8_t, uint64_t
+#include <algorithm>  // min, fill
+
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace bliss {
+
+  namespace utils {
+
+    /**
+     * @brief count-min sketch.
+     * @tparam DEPTH  number of rows.  the probability of an overestimate falls exponentially with DEPTH.
+     */
+    template <uint8_t DEPTH = 4>
+    class count_min_sketch {
+        static_assert((DEPTH >= 1) && (DEPTH <= 16), "count-min sketch depth should be between 1 and 16");
+
+      protected:
+        /// counters, row major.  row width is a power of 2.
+        std::vector<uint8_t> counters;
+        uint64_t mask;
+
+        /// position of the counter in row i.
+        inline size_t pos(uint64_t const & h1, uint64_t const & h2, uint8_t i) const {
+          return (static_cast<size_t>(i) * (mask + 1)) + static_cast<size_t>((h1 + i * h2) & mask);
+        }
+
+      public:
+        /// @param width  counters per row.  rounded up to a power of 2.  total memory is DEPTH * width bytes.
+        explicit count_min_sketch(size_t width = 1024) : mask(0) { resize(width); }
+
+        /// change the row width.  clears the counts.
+        void resize(size_t width) {
+          size_t w = 1;
+          while (w < width) w <<= 1;
+          mask = w - 1;
+          counters.assign(w * DEPTH, 0);
+        }
+
+        /// add 1 occurrence of a hash value.  @return the estimated count after the update.
+        inline uint8_t update(uint64_t const & hash) {
+          uint64_t h2 = mix64(hash) | 1;   // odd, so the rows use different positions.
+          uint8_t est = estimate(hash, h2);
+          if (est == 255) return est;
+
+          for (uint8_t i = 0; i < DEPTH; ++i) {
+            uint8_t & c = counters[pos(hash, h2, i)];
+            if (c == est) ++c;
+          }
+          return est + 1;
+        }
+
+        /// estimated count of a hash value.  never less than the true count, unless saturated.
+        inline uint8_t estimate(uint64_t const & hash) const {
+          return estimate(hash, mix64(hash) | 1);
+        }
+
+        void clear() {
+          ::std::fill(counters.begin(), counters.end(), 0);
+        }
+
+        size_t width() const { return mask + 1; }
+
+        /// memory used by the counters, in bytes.
+        size_t size_in_bytes() const { return counters.size(); }
+
+      protected:
+        inline uint8_t estimate(uint64_t const & h1, uint64_t const & h2) const {
+          uint8_t est = 255;
+          for (uint8_t i = 0; i < DEPTH; ++i) {
+            est = ::std::min(est, counters[pos(h1, h2, i)]);
+          }
+          return est;
+        }
+    };
+
+
+  } // namespace utils
+} // namespace bliss
+
+#endif /* SRC_UTILS_COUNT_MIN_SKETCH_HPP_ */
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    cpu_features.hpp
+ * @ingroup utils
+ * @brief   runtime cpu feature detection, for choosing SIMD kernels at run time.
+ * @details by default the SIMD code paths are chosen at compile time via __SSSE3__, __AVX2__, etc (-march=native).
+ *          when configured with USE_SIMD_DISPATCH (cmake), kernels are also compiled for ISAs that are not enabled on the
+ *          command line, via the gcc/clang target attribute, and selected at run time from cpuid.  a binary built for the
+ *          baseline x86-64 can then use AVX2 on the nodes that have it.
+ *
+ *          a kernel for ISA X is written as
+ *
+ *            #if defined(BL_KERNEL_X)
+ *              BL_TARGET("x") size_t kernel_x(...) { intrinsics }
+ *            #endif
+ *
+ *          and called as
+ *
+ *            #if defined(BL_KERNEL_X)
+ *              if (::bliss::utils::cpu::use_x()) i = kernel_x(...);
+ *            #endif
+ *
+ *          use_x() is constexpr true when X is enabled at compile time, so native builds are unchanged.
+ *          the kernels must not pass vector types across the call boundary, and must not use static vector constants,
+ *          whose initialization would be compiled for the baseline ISA.
+ *
+ *          only kernels written this way are dispatched.  bitgroup_ops and the Kmer reverse still use the compile time selection.
+ */
+#ifndef SRC_UTILS_CPU_FEATURES_HPP_
+#define SRC_UTILS_CPU_FEATURES_HPP_
+
+#include "bliss-config.hpp"
+
+#if defined(USE_SIMD_DISPATCH) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__)) && !defined(__INTEL_COMPILER)
+#define BL_SIMD_DISPATCH_ENABLED
+#define BL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BL_TARGET(isa)
+#endif
+
+// kernels that are compiled in, either natively or for runtime dispatch.
+#if defined(__SSSE3__) || defined(BL_SIMD_DISPATCH_ENABLED)
+#define BL_KERNEL_SSSE3
+#endif
+#if defined(__SSE4_2__) || defined(BL_SIMD_DISPATCH_ENABLED)
+#define BL_KERNEL_SSE4_2
+#endif
+#if defined(__AVX2__) || defined(BL_SIMD_DISPATCH_ENABLED)
+#define BL_KERNEL_AVX2
+#endif
+#if defined(__BMI2__) || defined(BL_SIMD_DISPATCH_ENABLED)
+#define BL_KERNEL_BMI2
+#endif
+
+#if defined(BL_KERNEL_SSSE3) || defined(BL_KERNEL_SSE4_2) || defined(BL_KERNEL_AVX2) || defined(BL_KERNEL_BMI2)
+#include <x86intrin.h>   // with gcc >= 4.9 and clang, all intrinsics are declared, and usable in functions with the target attribute.
+#endif
+
+namespace bliss {
+
+  namespace utils {
+
+    namespace cpu {
+
+      /// cpu features, queried once via cpuid.
+      struct features {
+          bool ssse3;
+          bool sse4_2;
+          bool avx2;
+          bool avx512bw;
+          bool bmi2;
+
+          features() :
+#if defined(BL_SIMD_DISPATCH_ENABLED)
+            ssse3(__builtin_cpu_supports("ssse3")),
+            sse4_2(__builtin_cpu_supports("sse4.2")),
+            avx2(__builtin_cpu_supports("avx2")),
+            avx512bw(__builtin_cpu_supports("avx512bw")),
+            bmi2(__builtin_cpu_supports("bmi2"))
+#else
+            ssse3(false), sse4_2(false), avx2(false), avx512bw(false), bmi2(false)
+#endif
+          {
+#if defined(BL_SIMD_DISPATCH_ENABLED)
+            // compile time enabled ISAs are assumed present, the same as the rest of the binary does.
+#if defined(__SSSE3__)
+            ssse3 = true;
+#endif
+#if defined(__SSE4_2__)
+            sse4_2 = true;
+#endif
+#if defined(__AVX2__)
+            avx2 = true;
+#endif
+#if defined(__AVX512BW__)
+            avx512bw = true;
+#endif
+#if defined(__BMI2__)
+            bmi2 = true;
+#endif
+#endif
+          }
+
+          /// the process-wide instance.  thread safe initialization (function local static).
+          static features const & get() {
+            static const features f;
+            return f;
+          }
+      };
+
+      /// true if the SSSE3 kernels should be used.
+#if defined(__SSSE3__)
+      constexpr bool use_ssse3() { return true; }
+#elif defined(BL_SIMD_DISPATCH_ENABLED)
+      inline bool use_ssse3() { return features::get().ssse3; }
+#else
+      constexpr bool use_ssse3() { return false; }
+#endif
+
+      /// true if the SSE4.2 kernels should be used.
+#if defined(__SSE4_2__)
+      constexpr bool use_sse4_2() { return true; }
+#elif defined(BL_SIMD_DISPATCH_ENABLED)
+      inline bool use_sse4_2() { return features::get().sse4_2; }
+#else
+      constexpr bool use_sse4_2() { return false; }
+#endif
+
+      /// true if the AVX2 kernels should be used.
+#if defined(__AVX2__)
+      constexpr bool use_avx2() { return true; }
+#elif defined(BL_SIMD_DISPATCH_ENABLED)
+      inline bool use_avx2() { return features::get().avx2; }
+#else
+      constexpr bool use_avx2() { return false; }
+#endif
+
+      /// true if the BMI2 (pext/pdep) kernels should be used.  note that pext/pdep are microcoded and slow on AMD before Zen 3.
+#if defined(__BMI2__)
+      constexpr bool use_bmi2() { return true; }
+#elif defined(BL_SIMD_DISPATCH_ENABLED)
+      inline bool use_bmi2() { return features::get().bmi2; }
+#else
+      constexpr bool use_bmi2() { return false; }
+#endif
+
+    } // namespace cpu
+
+  } // namespace utils
+
+} // namespace bliss
+
+#endif /* SRC_UTILS_CPU_FEATURES_HPP_ */
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    cuckoo_filter.hpp
+ * @ingroup utils
+ * @brief   cuckoo filter over 64 bit hash values, with optional small counters.
+ * @details each key is a FP_BITS fingerprint in 1 of its 2 buckets of 4 slots.  the second bucket is derived from the
+ *          first and the fingerprint, so entries can be moved without the key.  the slots are bit packed, so a slot is
+ *          FP_BITS + COUNTER_BITS bits, and the bucket count is not rounded to a power of 2.
+ *
+ *          at the default 13 bit fingerprints and the 94% target load, that is about 13.8 bits per key and a false
+ *          positive rate of about 8 / 2^13, i.e. 0.1%.  12 bit fingerprints give 12.8 bits per key and 0.2%.
+ *
+ *          with COUNTER_BITS > 0, inserting a key again increments its counter, up to 2^COUNTER_BITS, and erase
+ *          decrements it.  keys whose fingerprints collide share a counter, so counts are upper bounds.
+ *
+ *          the filter does not grow.  entries that do not fit after max_kicks displacements go to a small stash, so there
+ *          are no false negatives, but lookups slow down as it fills.  size it with resize.
+ *          keys with the same fingerprint and bucket share an entry, so without counters, erasing one also removes the
+ *          other, about as often as a false positive.  erasing a key that was not inserted may remove a colliding key.
+ */
+#ifndef SRC_UTILS_CUCKOO_FILTER_HPP_
+#define SRC_UTILS_CUCKOO_FILTER_HPP_
+
+#include <vector>
+#include <utility>    // pair
+#include <cstdint>    // uint8_t, uint16_t, uint64_t
+#include <cstddef>    // size_t
+#include <cmath>      // ceil, pow
+#include <algorithm>  // fill
+
+#include "utils/hyperloglog.hpp"  // mix64
+
+namespace bliss {
+
+  namespace utils {
+
+    /**
+     * @brief cuckoo filter.  contains may have false positives but no false negatives.
+     * @tparam FP_BITS       fingerprint bits.  the false positive rate is about 8 / 2^FP_BITS.
+     * @tparam COUNTER_BITS  per key counter bits, 0 for presence only.  FP_BITS + COUNTER_BITS <= 16.
+     */
+    template <uint8_t FP_BITS = 13, uint8_t COUNTER_BITS = 0>
+    class cuckoo_filter {
+        static_assert((FP_BITS >= 4) && (FP_BITS + COUNTER_BITS <= 16), "cuckoo_filter needs 4 to 16 bits per slot");
+
+      public:
+        static constexpr uint8_t slots_per_bucket = 4;
+        static constexpr uint8_t slot_bits = FP_BITS + COUNTER_BITS;
+        static constexpr uint8_t bucket_bits = slots_per_bucket * slot_bits;
+        /// largest count of a key.
+        static constexpr uint64_t max_count = 1ULL << COUNTER_BITS;
+        /// fraction of the slots that resize provides for.
+        static constexpr double max_load = 0.94;
+        /// displacements before an entry goes to the stash.
+        static constexpr int max_kicks = 500;
+
+      protected:
+        static constexpr uint64_t slot_mask = (1ULL << slot_bits) - 1;
+        static constexpr uint64_t fp_mask = (1ULL << FP_BITS) - 1;
+        static constexpr uint64_t bucket_mask = (bucket_bits == 64) ? ~0ULL : ((1ULL << bucket_bits) - 1);
+
+        /// packed buckets, plus 1 word so that a bucket can always be read with 2 words.
+        std::vector<uint64_t> words;
+        size_t nbuckets;
+        /// occupied slots plus stash entries.
+        size_t items;
+        /// (one of the 2 buckets, slot value) of the entries that did not fit.
+        std::vector<std::pair<size_t, uint16_t> > stash;
+        /// xorshift state for choosing victims.
+        uint64_t rng;
+
+        inline uint64_t get_bucket(size_t const b) const {
+          size_t bit = b * bucket_bits;
+          size_t w = bit >> 6;
+          unsigned off = bit & 63;
+          uint64_t v = words[w] >> off;
+          if (off + bucket_bits > 64) v |= words[w + 1] << (64 - off);
+          return v & bucket_mask;
+        }
+
+        inline void set_bucket(size_t const b, uint64_t const v) {
+          size_t bit = b * bucket_bits;
+          size_t w = bit >> 6;
+          unsigned off = bit & 63;
+          words[w] = (words[w] & ~(bucket_mask << off)) | (v << off);
+          if (off + bucket_bits > 64) {
+            unsigned hi = off + bucket_bits - 64;
+            words[w + 1] = (words[w + 1] & ~((1ULL << hi) - 1)) | (v >> (64 - off));
+          }
+        }
+
+        static inline uint64_t get_slot(uint64_t const bucket, unsigned const s) {
+          return (bucket >> (s * slot_bits)) & slot_mask;
+        }
+        static inline uint64_t set_slot(uint64_t const bucket, unsigned const s, uint64_t const v) {
+          return (bucket & ~(slot_mask << (s * slot_bits))) | (v << (s * slot_bits));
+        }
+
+        /// nonzero, so that 0 marks an empty slot.  from bits not used much by the bucket index.
+        static inline uint64_t fingerprint(uint64_t const hash) {
+          uint64_t f = (hash >> 40) & fp_mask;
+          return (f == 0) ? 1 : f;
+        }
+
+        /// the other bucket of fp.  (H - b) mod nbuckets is its own inverse, so nbuckets need not be a power of 2.
+        inline size_t alt_bucket(size_t const b, uint64_t const fp) const {
+          return (mix64(fp) % nbuckets + nbuckets - b) % nbuckets;
+        }
+
+        /// slot of fp in bucket b, or -1.
+        inline int find_slot(size_t const b, uint64_t const fp) const {
+          uint64_t v = get_bucket(b);
+          for (unsigned s = 0; s < slots_per_bucket; ++s) {
+            if ((get_slot(v, s) & fp_mask) == fp) return s;
+          }
+          return -1;
+        }
+
+        /// stash entry of fp with bucket b1 or b2, or stash.size().
+        inline size_t find_stash(size_t const b1, size_t const b2, uint64_t const fp) const {
+          size_t i = 0;
+          for (; i < stash.size(); ++i) {
+            if (((stash[i].second & fp_mask) == fp) && ((stash[i].first == b1) || (stash[i].first == b2))) break;
+          }
+          return i;
+        }
+
+        /// put a slot value in an empty slot of bucket b.  false if full.
+        inline bool put(size_t const b, uint64_t const v) {
+          uint64_t bucket = get_bucket(b);
+          for (unsigned s = 0; s < slots_per_bucket; ++s) {
+            if (get_slot(bucket, s) == 0) {
+              set_bucket(b, set_slot(bucket, s, v));
+              return true;
+            }
+          }
+          return false;
+        }
+
+        inline uint64_t next_random() {
+          rng ^= rng << 13;
+          rng ^= rng >> 7;
+          rng ^= rng << 17;
+          return rng;
+        }
+
+        static inline uint64_t increment(uint64_t const v) {
+          return ((v >> FP_BITS) + 1 < max_count) ? (v + (1ULL << FP_BITS)) : v;
+        }
+
+      public:
+        cuckoo_filter() : nbuckets(0), items(0), rng(0x9E3779B97F4A7C15ULL) {}
+
+        /// clear and size for n keys at max_load.
+        void resize(size_t const n) {
+          nbuckets = static_cast<size_t>(::std::ceil(static_cast<double>(n) / (max_load * slots_per_bucket)));
+          if (nbuckets == 0) nbuckets = 1;
+          words.assign(((nbuckets * bucket_bits + 63) >> 6) + 1, 0);
+          items = 0;
+          stash.clear();
+        }
+
+        /**
+         * @brief insert a hash value.  an unsized filter is sized for 1024 keys first.
+         * @return true if its fingerprint was not present, false if it was and only the counter changed.
+         */
+        bool insert(uint64_t const & hash) {
+          if (nbuckets == 0) resize(1024);
+
+          uint64_t fp = fingerprint(hash);
+          size_t b1 = hash % nbuckets;
+          size_t b2 = alt_bucket(b1, fp);
+
+          size_t const bs[2] = {b1, b2};
+          for (int k = 0; k < 2; ++k) {
+            int s = find_slot(bs[k], fp);
+            if (s >= 0) {
+              uint64_t v = get_bucket(bs[k]);
+              set_bucket(bs[k], set_slot(v, s, increment(get_slot(v, s))));
+              return false;
+            }
+          }
+          if (!stash.empty()) {
+            size_t i = find_stash(b1, b2, fp);
+            if (i < stash.size()) {
+              stash[i].second = increment(stash[i].second);
+              return false;
+            }
+          }
+
+          ++items;
+          if (put(b1, fp) || put(b2, fp)) return true;
+
+          // displace a random entry, and move it to its other bucket, until one fits.
+          uint64_t cur = fp;
+          size_t b = (next_random() & 1) ? b1 : b2;
+          for (int k = 0; k < max_kicks; ++k) {
+            unsigned s = next_random() % slots_per_bucket;
+            uint64_t v = get_bucket(b);
+            uint64_t victim = get_slot(v, s);
+            set_bucket(b, set_slot(v, s, cur));
+            cur = victim;
+            b = alt_bucket(b, cur & fp_mask);
+            if (put(b, cur)) return true;
+          }
+          stash.emplace_back(b, static_cast<uint16_t>(cur));
+          return true;
+        }
+
+        /// count of the hash value:  0 if definitely not inserted, else 1, or its counter with COUNTER_BITS > 0.
+        size_t count(uint64_t const & hash) const {
+          if (nbuckets == 0) return 0;
+
+          uint64_t fp = fingerprint(hash);
+          size_t b1 = hash % nbuckets;
+          size_t b2 = alt_bucket(b1, fp);
+
+          int s = find_slot(b1, fp);
+          if (s >= 0) return (get_slot(get_bucket(b1), s) >> FP_BITS) + 1;
+          s = find_slot(b2, fp);
+          if (s >= 0) return (get_slot(get_bucket(b2), s) >> FP_BITS) + 1;
+          if (!stash.empty()) {
+            size_t i = find_stash(b1, b2, fp);
+            if (i < stash.size()) return (stash[i].second >> FP_BITS) + 1;
+          }
+          return 0;
+        }
+
+        /// false if the hash value was definitely not inserted.
+        inline bool contains(uint64_t const & hash) const {
+          return count(hash) > 0;
+        }
+
+        /// decrement the counter of the hash value, and remove its fingerprint at 0.  false if it was not found.
+        bool erase(uint64_t const & hash) {
+          if (nbuckets == 0) return false;
+
+          uint64_t fp = fingerprint(hash);
+          size_t b1 = hash % nbuckets;
+          size_t b2 = alt_bucket(b1, fp);
+
+          size_t const bs[2] = {b1, b2};
+          for (int k = 0; k < 2; ++k) {
+            int s = find_slot(bs[k], fp);
+            if (s >= 0) {
+              uint64_t v = get_bucket(bs[k]);
+              uint64_t x = get_slot(v, s);
+              if ((x >> FP_BITS) > 0) {
+                set_bucket(bs[k], set_slot(v, s, x - (1ULL << FP_BITS)));
+              } else {
+                set_bucket(bs[k], set_slot(v, s, 0));
+                --items;
+              }
+              return true;
+            }
+          }
+          if (!stash.empty()) {
+            size_t i = find_stash(b1, b2, fp);
+            if (i < stash.size()) {
+              if ((stash[i].second >> FP_BITS) > 0) {
+                stash[i].second -= static_cast<uint16_t>(1ULL << FP_BITS);
+              } else {
+                stash[i] = stash.back();
+                stash.pop_back();
+                --items;
+              }
+              return true;
+            }
+          }
+          return false;
+        }
+
+        /// number of distinct fingerprints stored.
+        size_t size() const { return items; }
+
+        /// true if nothing is stored.
+        bool empty() const { return items == 0; }
+
+        /// number of slots.  0 if not sized.
+        size_t capacity() const { return nbuckets * slots_per_bucket; }
+
+        double load_factor() const {
+          return (nbuckets == 0) ? 0.0 : (static_cast<double>(items) / static_cast<double>(capacity()));
+        }
+
+        /// expected false positive rate at the current load:  the chance that 1 of the occupied slots of 2 buckets matches.
+        double false_positive_rate() const {
+          return 1.0 - ::std::pow(1.0 - 1.0 / static_cast<double>(fp_mask), 2.0 * slots_per_bucket * load_factor());
+        }
+
+        /// entries that did not fit in their buckets.
+        size_t stash_size() const { return stash.size(); }
+
+        size_t bit_count() const { return nbuckets * bucket_bits; }
+
+        /// remove all entries, keeping the size.
+        void clear() {
+          ::std::fill(words.begin(), words.end(), 0);
+          items = 0;
+          stash.clear();
+        }
+
+        /// release the memory.
+        void reset() {
+          ::std::vector<uint64_t>().swap(words);
+          ::std::vector<std::pair<size_t, uint16_t> >().swap(stash);
+          nbuckets = 0;
+          items = 0;
+        }
+
+        void swap(cuckoo_filter & other) {
+          words.swap(other.words);
+          stash.swap(other.stash);
+          ::std::swap(nbuckets, other.nbuckets);
+          ::std::swap(items, other.items);
+          ::std::swap(rng, other.rng);
+        }
+    };
+
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr uint8_t cuckoo_filter<FP_BITS, COUNTER_BITS>::slots_per_bucket;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr uint8_t cuckoo_filter<FP_BITS, COUNTER_BITS>::slot_bits;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr uint8_t cuckoo_filter<FP_BITS, COUNTER_BITS>::bucket_bits;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr uint64_t cuckoo_filter<FP_BITS, COUNTER_BITS>::max_count;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr double cuckoo_filter<FP_BITS, COUNTER_BITS>::max_load;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr int cuckoo_filter<FP_BITS, COUNTER_BITS>::max_kicks;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr uint64_t cuckoo_filter<FP_BITS, COUNTER_BITS>::slot_mask;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr uint64_t cuckoo_filter<FP_BITS, COUNTER_BITS>::fp_mask;
+    template <uint8_t FP_BITS, uint8_t COUNTER_BITS>
+    constexpr uint64_t cuckoo_filter<FP_BITS, COUNTER_BITS>::bucket_mask;
+
+  } // namespace utils
+} // namespace bliss
+
+#endif /* SRC_UTILS_CUCKOO_FILTER_HPP_ */
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    event_trace.hpp
+ * @ingroup
+ * @brief   per thread event tracer for the hot loops, with Chrome trace (Perfetto) output.
+ * @details each thread records begin/end pairs into its own fixed size ring buffer, so recording takes no lock and
+ *          allocates nothing, and a long run keeps its most recent events.  a pair becomes 1 complete ("X") event with the
+ *          start and the duration.  with a sampling stride n > 1, only every n-th begin on a thread is recorded.
+ *          the dump writes the events of all threads of the process to 1 JSON file, with the rank as pid, so the
+ *          per-rank files load in Perfetto or chrome://tracing side by side.
+ *
+ *          event names must have static storage (string literals), since only the pointer is recorded.
+ *
+ *          compiled in with ENABLE_TRACE_BENCHMARK (BL_BENCHMARK_TRACE).  at runtime:
+ *            BL_TRACE_FILE    output prefix, files are "<prefix>.<rank>.json".  default "bliss_trace".
+ *            BL_TRACE_EVENTS  ring buffer capacity per thread.  default 65536.
+ *            BL_TRACE_SAMPLE  sampling stride.  default 1, all events.
+ */
+#ifndef SRC_UTILS_EVENT_TRACE_HPP_
+#define SRC_UTILS_EVENT_TRACE_HPP_
+
+#include "bliss-logger_config.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory>     // unique_ptr
+#include <algorithm>  // min, max
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <sstream>
+#include <cstdio>     // fopen
+#include <cstdlib>    // getenv, strtoul
+#include <cstdint>
+
+#include <mxx/comm.hpp>
+
+namespace plog {
+
+class EventTrace {
+  public:
+    struct event {
+        char const * name;
+        uint64_t start_ns;
+        uint64_t dur_ns;
+    };
+
+  protected:
+    struct thread_buffer {
+        std::thread::id thread;
+        uint32_t tid;
+        /// ring buffer.  the oldest event is at next once total exceeds the capacity.
+        std::vector<event> events;
+        size_t next;
+        size_t total;
+        /// open begins, innermost last.  a nullptr name is an unsampled begin.
+        std::vector<event> open;
+        uint64_t begins;
+
+        thread_buffer(std::thread::id const & _thread, uint32_t _tid, size_t capacity) :
+          thread(_thread), tid(_tid), events(capacity), next(0), total(0), begins(0) {
+          open.reserve(16);
+        }
+    };
+
+    /// last buffer used by this thread, tagged with the owning trace's serial number.
+    struct thread_cache {
+        uint64_t serial;
+        thread_buffer * buffer;
+    };
+
+    std::chrono::steady_clock::time_point origin;
+    size_t capacity;
+    uint64_t stride;
+    uint64_t serial;
+
+    std::mutex lock;
+    std::vector<std::unique_ptr<thread_buffer> > buffers;
+
+    static uint64_t next_serial() {
+      static std::atomic<uint64_t> counter(0);
+      return ++counter;
+    }
+
+    static size_t env_value(char const * name, size_t const & default_value) {
+      char const * v = std::getenv(name);
+      if (v == nullptr) return default_value;
+      size_t x = std::strtoul(v, nullptr, 10);
+      return (x == 0) ? default_value : x;
+    }
+
+    /// the calling thread's buffer.  takes the lock only the first time a thread records into this trace.
+    thread_buffer & local() {
+      static thread_local thread_cache cache = { 0, nullptr };
+      if (cache.serial == serial) return *(cache.buffer);
+
+      std::lock_guard<std::mutex> guard(lock);
+      std::thread::id self = std::this_thread::get_id();
+      thread_buffer * b = nullptr;
+      for (auto const & x : buffers) {
+        if (x->thread == self) b = x.get();
+      }
+      if (b == nullptr) {
+        buffers.emplace_back(new thread_buffer(self, static_cast<uint32_t>(buffers.size()), capacity));
+        b = buffers.back().get();
+      }
+      cache.serial = serial;
+      cache.buffer = b;
+      return *b;
+    }
+
+    uint64_t now_ns() const {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    static std::string json_string(char const * s) {
+      std::string out("\"");
+      for (; *s != 0; ++s) {
+        if ((*s == '"') || (*s == '\\')) out.push_back('\\');
+        out.push_back(*s);
+      }
+      out.push_back('"');
+      return out;
+    }
+
+  public:
+    EventTrace(size_t const & _capacity, size_t const & _stride = 1) :
+      origin(std::chrono::steady_clock::now()), capacity(std::max(_capacity, static_cast<size_t>(1))),
+      stride(std::max(_stride, static_cast<size_t>(1))), serial(next_serial()) {}
+
+    EventTrace(EventTrace const & other) = delete;
+    EventTrace& operator=(EventTrace const & other) = delete;
+
+    /// process wide trace used by the BL_TRACE macros, configured from the environment.
+    static EventTrace & instance() {
+      static EventTrace trace(env_value("BL_TRACE_EVENTS", 1UL << 16), env_value("BL_TRACE_SAMPLE", 1));
+      return trace;
+    }
+
+    void begin(char const * name) {
+      thread_buffer & b = local();
+      bool sampled = (b.begins++ % stride) == 0;
+      event e = { sampled ? name : nullptr, now_ns(), 0 };
+      b.open.push_back(e);
+    }
+
+    void end() {
+      thread_buffer & b = local();
+      if (b.open.empty()) return;
+
+      event e = b.open.back();
+      b.open.pop_back();
+      if (e.name == nullptr) return;
+
+      e.dur_ns = now_ns() - e.start_ns;
+      b.events[b.next] = e;
+      b.next = (b.next + 1) % b.events.size();
+      ++b.total;
+    }
+
+    /// number of events held by all threads.
+    size_t size() {
+      std::lock_guard<std::mutex> guard(lock);
+      size_t n = 0;
+      for (auto const & b : buffers) n += std::min(b->total, b->events.size());
+      return n;
+    }
+
+    /// events lost to the ring buffers wrapping around.
+    size_t dropped() {
+      std::lock_guard<std::mutex> guard(lock);
+      size_t n = 0;
+      for (auto const & b : buffers) n += b->total - std::min(b->total, b->events.size());
+      return n;
+    }
+
+    void clear() {
+      std::lock_guard<std::mutex> guard(lock);
+      for (auto const & b : buffers) {
+        b->next = 0;
+        b->total = 0;
+        b->open.clear();
+      }
+    }
+
+    /**
+     * @brief write the events as Chrome trace JSON.  call when no thread is inside a traced region.
+     * @param pid  process id in the trace, the rank.
+     * @return false if the file could not be written.
+     */
+    bool dump(std::string const & filename, int const & pid) {
+      std::lock_guard<std::mutex> guard(lock);
+
+      std::stringstream output;
+      output << std::fixed;
+      output.precision(3);
+
+      output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+      output << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":\"rank " << pid << "\"}}";
+      size_t lost = 0;
+      for (auto const & b : buffers) {
+        output << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << b->tid <<
+            ",\"args\":{\"name\":\"thread " << b->tid << "\"}}";
+
+        size_t n = std::min(b->total, b->events.size());
+        size_t first = (b->total > b->events.size()) ? b->next : 0;
+        lost += b->total - n;
+        for (size_t i = 0; i < n; ++i) {
+          event const & e = b->events[(first + i) % b->events.size()];
+          // chrome trace times are in microseconds.
+          output << ",\n{\"name\":" << json_string(e.name) << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << b->tid <<
+              ",\"ts\":" << (static_cast<double>(e.start_ns) / 1000.0) << ",\"dur\":" << (static_cast<double>(e.dur_ns) / 1000.0) << "}";
+        }
+      }
+      output << "\n],\"otherData\":{\"dropped_events\":" << lost << ",\"sample_stride\":" << stride << "}}\n";
+
+      FILE * fp = fopen(filename.c_str(), "w");
+      if (fp == NULL) return false;
+      bool ok = fputs(output.str().c_str(), fp) >= 0;
+      ok &= (fclose(fp) == 0);
+      return ok;
+    }
+
+    /// dump to "<BL_TRACE_FILE>.<rank>.json".  not collective.
+    bool dump(::mxx::comm const & comm) {
+      char const * prefix = std::getenv("BL_TRACE_FILE");
+      std::stringstream ss;
+      ss << ((prefix == nullptr) ? "bliss_trace" : prefix) << "." << comm.rank() << ".json";
+      return dump(ss.str(), comm.rank());
+    }
+};
+
+/// traces the enclosing scope.
+class trace_scope {
+  public:
+    explicit trace_scope(char const * name) { ::plog::EventTrace::instance().begin(name); }
+    ~trace_scope() { ::plog::EventTrace::instance().end(); }
+
+    trace_scope(trace_scope const & other) = delete;
+    trace_scope& operator=(trace_scope const & other) = delete;
+};
+
+} // end namespace plog
+
+#if BL_BENCHMARK_TRACE == 1
+
+#define BL_TRACE_CONCAT_IMPL(x, y) x##y
+#define BL_TRACE_CONCAT(x, y) BL_TRACE_CONCAT_IMPL(x, y)
+
+#define BL_TRACE_BEGIN(name)      do { ::plog::EventTrace::instance().begin(name); } while (0)
+#define BL_TRACE_END(name)        do { ::plog::EventTrace::instance().end(); } while (0)
+#define BL_TRACE_SCOPE(name)      ::plog::trace_scope BL_TRACE_CONCAT(bl_trace_scope_, __LINE__)(name)
+#define BL_TRACE_DUMP(comm)       do { ::plog::EventTrace::instance().dump(comm); } while (0)
+
+#else
+
+#define BL_TRACE_BEGIN(name)
+#define BL_TRACE_END(name)
+#define BL_TRACE_SCOPE(name)
+#define BL_TRACE_DUMP(comm)
+
+#endif
+
+#endif /* SRC_UTILS_EVENT_TRACE_HPP_ */
@@ -40,6 +40,19 @@ namespace bliss {
           return filename.substr(pos + 1);  // from next char to end.
       }
 
+      /// true if the file name ends in .gz or .bgz (case insensitive).
+      inline bool is_gzip_file(std::string const & filename) {
+        std::string ext = get_file_extension(filename);
+        for (auto & c : ext) c = ::tolower(c);
+        return (ext.compare("gz") == 0) || (ext.compare("bgz") == 0);
+      }
+
+      /// extension of the data format, skipping a trailing .gz or .bgz.  e.g. "fastq" for "reads.fastq.gz".
+      inline std::string get_data_file_extension(std::string const & filename) {
+        if (!is_gzip_file(filename)) return get_file_extension(filename);
+        return get_file_extension(filename.substr(0, filename.find_last_of('.')));
+      }
+
       struct NotEOL {
         template <typename CharType>
         bool operator()(CharType const & x) {
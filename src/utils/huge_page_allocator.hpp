@@ -0,0 +1,184 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    huge_page_allocator.hpp
+ * @ingroup utils
+ * @brief   allocator that backs large allocations with huge pages.
+ * @details random probes into a multi GB hash table miss the DTLB on almost every access with 4K pages.
+ *          allocations of at least 2MB are mmapped, aligned to 2MB, and marked with madvise(MADV_HUGEPAGE)
+ *          so that transparent huge pages can back them.  with HUGETLB = true, MAP_HUGETLB is tried first, which
+ *          needs huge pages reserved by the administrator (vm.nr_hugepages), and falls back to the THP path if that fails.
+ *          smaller allocations use operator new.  on systems other than linux, all allocations use operator new.
+ *
+ *          this is a drop-in replacement for ::std::allocator, including the C++03 members and rebind needed by
+ *          the sparsehash based containers.  pass it as the Alloc template parameter of the ::dsc maps, e.g.
+ *            ::dsc::densehash_map<Kmer, T, MapParams, SpecialKeys, ::bliss::utils::huge_page_allocator<::std::pair<const Kmer, T> > >
+ *          note that the allocator is used for the local storage only.  whether THP is applied also depends on
+ *          /sys/kernel/mm/transparent_hugepage/enabled.
+ */
+#ifndef SRC_UTILS_HUGE_PAGE_ALLOCATOR_HPP_
+#define SRC_UTILS_HUGE_PAGE_ALLOCATOR_HPP_
+
+#include <cstddef>   // size_t, ptrdiff_t
+#include <cstdint>   // uintptr_t
+#include <new>       // bad_alloc, operator new
+#include <limits>
+#include <utility>   // forward
+
+#if defined(__linux__)
+#include <sys/mman.h>  // mmap, madvise
+#endif
+
+namespace bliss {
+
+  namespace utils {
+
+    /**
+     * @brief allocator using (transparent) huge pages for allocations of at least huge_page_size bytes.
+     * @tparam HUGETLB  try explicit huge pages (MAP_HUGETLB) first.
+     */
+    template <typename T, bool HUGETLB = false>
+    class huge_page_allocator {
+      public:
+        using value_type      = T;
+        using pointer         = T*;
+        using const_pointer   = T const *;
+        using reference       = T&;
+        using const_reference = T const &;
+        using size_type       = size_t;
+        using difference_type = ptrdiff_t;
+
+        template <typename U>
+        struct rebind {
+            using other = huge_page_allocator<U, HUGETLB>;
+        };
+
+        /// 2MB pages, the x86-64 default huge page size.  allocations smaller than this use operator new.
+        static constexpr size_t huge_page_size = 2UL * 1024UL * 1024UL;
+
+      protected:
+        static constexpr size_t round_up(size_t bytes) {
+          return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+        }
+
+        static bool use_mmap(size_t bytes) {
+#if defined(__linux__)
+          return bytes >= huge_page_size;
+#else
+          (void)bytes;
+          return false;
+#endif
+        }
+
+#if defined(__linux__)
+        /// map len bytes (a multiple of huge_page_size), aligned to huge_page_size.
+        static void * map_huge(size_t len) {
+#if defined(MAP_HUGETLB)
+          if (HUGETLB) {
+            void * p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) return p;
+          }
+#endif
+          // over allocate, then trim to an aligned range so that whole huge pages can back it.
+          size_t total = len + huge_page_size;
+          void * raw = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+          if (raw == MAP_FAILED) return nullptr;
+
+          uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+          uintptr_t aligned = (start + huge_page_size - 1) & ~(static_cast<uintptr_t>(huge_page_size) - 1);
+          if (aligned > start) ::munmap(raw, aligned - start);
+          size_t tail = (start + total) - (aligned + len);
+          if (tail > 0) ::munmap(reinterpret_cast<void *>(aligned + len), tail);
+
+#if defined(MADV_HUGEPAGE)
+          ::madvise(reinterpret_cast<void *>(aligned), len, MADV_HUGEPAGE);
+#endif
+          return reinterpret_cast<void *>(aligned);
+        }
+#endif
+
+      public:
+        huge_page_allocator() noexcept {}
+        huge_page_allocator(huge_page_allocator const &) noexcept {}
+        template <typename U>
+        huge_page_allocator(huge_page_allocator<U, HUGETLB> const &) noexcept {}
+        ~huge_page_allocator() {}
+
+        pointer address(reference x) const noexcept { return &x; }
+        const_pointer address(const_reference x) const noexcept { return &x; }
+
+        size_type max_size() const noexcept {
+          return ::std::numeric_limits<size_type>::max() / sizeof(T);
+        }
+
+        pointer allocate(size_type n, void const * hint = nullptr) {
+          (void)hint;
+          if (n > max_size()) throw ::std::bad_alloc();
+
+          size_t bytes = n * sizeof(T);
+          if (!use_mmap(bytes)) return static_cast<pointer>(::operator new(bytes));
+
+#if defined(__linux__)
+          void * p = map_huge(round_up(bytes));
+          if (p == nullptr) throw ::std::bad_alloc();
+          return static_cast<pointer>(p);
+#else
+          return nullptr;  // not reached
+#endif
+        }
+
+        void deallocate(pointer p, size_type n) {
+          if (p == nullptr) return;
+
+          size_t bytes = n * sizeof(T);
+          if (!use_mmap(bytes)) {
+            ::operator delete(p);
+            return;
+          }
+#if defined(__linux__)
+          ::munmap(p, round_up(bytes));
+#endif
+        }
+
+        template <typename U, typename... Args>
+        void construct(U * p, Args&&... args) {
+          ::new (static_cast<void *>(p)) U(::std::forward<Args>(args)...);
+        }
+
+        template <typename U>
+        void destroy(U * p) {
+          p->~U();
+        }
+    };
+
+    template <typename T, bool HUGETLB>
+    constexpr size_t huge_page_allocator<T, HUGETLB>::huge_page_size;
+
+    template <typename T, typename U, bool HUGETLB>
+    inline bool operator==(huge_page_allocator<T, HUGETLB> const &, huge_page_allocator<U, HUGETLB> const &) {
+      return true;
+    }
+
+    template <typename T, typename U, bool HUGETLB>
+    inline bool operator!=(huge_page_allocator<T, HUGETLB> const &, huge_page_allocator<U, HUGETLB> const &) {
+      return false;
+    }
+
+  } // namespace utils
+} // namespace bliss
+
+#endif /* SRC_UTILS_HUGE_PAGE_ALLOCATOR_HPP_ */
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    hyperloglog.hpp
+ * @ingroup utils
+ * @brief   HyperLogLog cardinality estimator.
+ * @details estimates the number of distinct values from their 64 bit hash values, using 2^PRECISION 1-byte registers.
+ *          the standard error is about 1.04 / sqrt(2^PRECISION), i.e. 1.6% for the default precision of 12 (4KB).
+ *          small cardinalities are corrected with linear counting.  large range correction is not needed for 64 bit hashes.
+ *
+ *          the hash values should be well mixed.  mix64 can be used to scramble a weak hash (e.g. identity on kmers)
+ *          or one that shares bits with the hash used to distribute the keys.
+ *
+ *          sketches with the same precision can be merged, e.g. across threads or sequential blocks of input.
+ */
+#ifndef SRC_UTILS_HYPERLOGLOG_HPP_
+#define SRC_UTILS_HYPERLOGLOG_HPP_
+
+#include <vector>
+#include <cstdint>  // uint8_t, uint64_t
+#include <cmath>    // log, ldexp
+#include <algorithm>  // max
+
+namespace bliss {
+
+  namespace utils {
+
+    /// murmur3 64 bit finalizer.  bijective, so distinct inputs remain distinct.
+    inline uint64_t mix64(uint64_t h) {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    /**
+     * @brief HyperLogLog sketch.
+     * @tparam PRECISION  number of hash bits used to select a register.  between 4 and 18.
+     */
+    template <uint8_t PRECISION = 12>
+    class hyperloglog {
+        static_assert((PRECISION >= 4) && (PRECISION <= 18), "hyperloglog precision should be between 4 and 18");
+
+      protected:
+        static constexpr size_t num_registers = 1UL << PRECISION;
+        static constexpr uint8_t max_rank = 64 - PRECISION + 1;
+
+        std::vector<uint8_t> registers;
+
+      public:
+        hyperloglog() : registers(num_registers, 0) {}
+
+        /// add a hash value to the sketch
+        inline void update(uint64_t const & hash) {
+          size_t idx = hash >> (64 - PRECISION);
+          uint64_t w = hash << PRECISION;
+
+          // position of the first 1 bit in the remaining bits.
+          uint8_t rank;
+          if (w == 0) rank = max_rank;
+          else {
+#if defined(__GNUC__)
+            rank = static_cast<uint8_t>(__builtin_clzll(w)) + 1;
+#else
+            rank = 1;
+            for (; (w & 0x8000000000000000ULL) == 0; w <<= 1) ++rank;
+#endif
+          }
+          if (rank > registers[idx]) registers[idx] = rank;
+        }
+
+        /// merge another sketch into this one.
+        void merge(hyperloglog const & other) {
+          for (size_t i = 0; i < num_registers; ++i) {
+            registers[i] = ::std::max(registers[i], other.registers[i]);
+          }
+        }
+
+        /// estimate the number of distinct hash values added.
+        double estimate() const {
+          double const m = static_cast<double>(num_registers);
+          double alpha;
+          switch (PRECISION) {
+            case 4: alpha = 0.673; break;
+            case 5: alpha = 0.697; break;
+            case 6: alpha = 0.709; break;
+            default: alpha = 0.7213 / (1.0 + 1.079 / m); break;
+          }
+
+          double sum = 0.0;
+          size_t zeros = 0;
+          for (size_t i = 0; i < num_registers; ++i) {
+            sum += ::std::ldexp(1.0, -static_cast<int>(registers[i]));
+            if (registers[i] == 0) ++zeros;
+          }
+
+          double est = alpha * m * m / sum;
+
+          // small range correction: linear counting.
+          if ((est <= 2.5 * m) && (zeros > 0)) {
+            est = m * ::std::log(m / static_cast<double>(zeros));
+          }
+          return est;
+        }
+
+        void clear() {
+          ::std::fill(registers.begin(), registers.end(), 0);
+        }
+
+        /// raw registers, e.g. for merging sketches from other processes with a max reduction.
+        std::vector<uint8_t> & get_registers() { return registers; }
+        std::vector<uint8_t> const & get_registers() const { return registers; }
+    };
+
+    template <uint8_t PRECISION>
+    constexpr size_t hyperloglog<PRECISION>::num_registers;
+    template <uint8_t PRECISION>
+    constexpr uint8_t hyperloglog<PRECISION>::max_rank;
+
+
+  } // namespace utils
+} // namespace bliss
+
+#endif /* SRC_UTILS_HYPERLOGLOG_HPP_ */
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    kmer_generator.hpp
+ * @ingroup utils
+ * @brief   synthetic k-mer workloads for benchmarks, with the skew and repeats of real data.
+ * @details uniformly random k-mers are nearly all distinct, so they hide the effect of repeats on the hash tables and
+ *          of heavy keys on the distribution.  the generators here are
+ *
+ *            generate_zipf:        draws from a fixed set of distinct k-mers (or integers) with Zipfian multiplicity
+ *                                  (the k-th most frequent value occurs ~ 1/k^s as often as the most frequent one),
+ *                                  plus runs of adjacent duplicates at a given rate.  s = 0 is uniform over the set.
+ *            simulate_reads:       reads sampled from reference sequences, e.g. test/data/test.medium.fasta, from either strand,
+ *                                  with substitution errors.  kmers_from_reads turns them into k-mers, so coverage,
+ *                                  genome repeats, and error k-mers are as for sequencing data.
+ *
+ *          all generators are deterministic for a seed.  give ranks different seeds for different data.
+ *          generate_zipf is used by BenchmarkHashTables, BenchmarkDistributedMaps, and mpi_benchmark_distribute.
+ */
+#ifndef SRC_UTILS_KMER_GENERATOR_HPP_
+#define SRC_UTILS_KMER_GENERATOR_HPP_
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>   // upper_bound
+#include <cmath>       // pow
+#include <cstdint>
+#include <fstream>
+#include <cctype>      // toupper
+#include <type_traits>
+
+namespace bliss
+{
+namespace utils
+{
+
+  /// integers in [0, n) with P(i) proportional to 1 / (i + 1)^s.  uses a cumulative table of n doubles.
+  class zipf_distribution {
+    protected:
+      ::std::vector<double> cdf;
+      ::std::uniform_real_distribution<double> uniform;
+
+    public:
+      zipf_distribution(size_t const n, double const s) : cdf(n), uniform(0.0, 1.0) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+          sum += 1.0 / ::std::pow(static_cast<double>(i + 1), s);
+          cdf[i] = sum;
+        }
+        for (size_t i = 0; i < n; ++i) cdf[i] /= sum;
+      }
+
+      template <typename URNG>
+      size_t operator()(URNG & gen) {
+        size_t i = ::std::upper_bound(cdf.begin(), cdf.end(), uniform(gen)) - cdf.begin();
+        return (i < cdf.size()) ? i : (cdf.size() - 1);
+      }
+  };
+
+
+  /// a uniformly random k-mer.
+  template <typename Kmer, typename URNG>
+  auto random_value(URNG & gen) -> typename ::std::enable_if<(sizeof(typename Kmer::KmerWordType) > 0), Kmer>::type {
+    Kmer k;
+    for (size_t j = 0; j < Kmer::nWords; ++j) {
+      k.getDataRef()[j] = static_cast<typename Kmer::KmerWordType>(gen());
+    }
+    k.sanitize();
+    return k;
+  }
+
+  /// a uniformly random integer.
+  template <typename T, typename URNG>
+  auto random_value(URNG & gen) -> typename ::std::enable_if<::std::is_integral<T>::value, T>::type {
+    return static_cast<T>(gen());
+  }
+
+  /**
+   * @brief values drawn from `distinct` random k-mers or integers with Zipfian multiplicity.  see file description.
+   * @param s               Zipf exponent.  ~1 for genomic repeats, 0 for uniform.
+   * @param duplicate_rate  probability that an element repeats the previous one.
+   * @param seed            seed of the draws.
+   * @param vocab_seed      seed of the distinct values.  ranks should share it, so that the frequent values are the
+   *                        same on all ranks, as in real data.
+   */
+  template <typename T>
+  void generate_zipf(::std::vector<T> & output, size_t const count, size_t const distinct, double const s,
+                     double const duplicate_rate = 0.0, uint64_t const seed = 23, uint64_t const vocab_seed = 23) {
+    output.clear();
+    if ((count == 0) || (distinct == 0)) return;
+    output.reserve(count);
+
+    ::std::mt19937_64 vocab_gen(vocab_seed);
+    ::std::vector<T> vocab(distinct);
+    for (size_t i = 0; i < distinct; ++i) vocab[i] = random_value<T>(vocab_gen);
+
+    ::std::mt19937_64 gen(seed);
+
+    zipf_distribution zipf(distinct, s);
+    ::std::bernoulli_distribution dup(duplicate_rate);
+    for (size_t i = 0; i < count; ++i) {
+      if ((i > 0) && dup(gen)) output.emplace_back(output.back());
+      else output.emplace_back(vocab[zipf(gen)]);
+    }
+  }
+
+
+  /// the sequences of a FASTA file, 1 per record, upper case.  lines of a record are joined.
+  inline ::std::vector<::std::string> load_reference(::std::string const & filename) {
+    ::std::vector<::std::string> seqs;
+    ::std::ifstream in(filename);
+    ::std::string line;
+    while (::std::getline(in, line)) {
+      if (line.empty()) continue;
+      if (line[0] == '>') {
+        seqs.emplace_back();
+        continue;
+      }
+      if (seqs.empty()) seqs.emplace_back();
+      for (char c : line) {
+        if (c == '\r') continue;
+        seqs.back().push_back(static_cast<char>(::std::toupper(static_cast<unsigned char>(c))));
+      }
+    }
+    return seqs;
+  }
+
+  /**
+   * @brief reads of length read_len sampled uniformly from the reference sequences that are long enough.
+   * @details half of the reads are reverse complemented.  each base is substituted with probability error_rate,
+   *          by one of the other 3 bases.  for a seed, the reads differ between error rates only by the errors.
+   *          returns no reads if no sequence is long enough.
+   */
+  inline ::std::vector<::std::string> simulate_reads(::std::vector<::std::string> const & reference, size_t const nreads,
+                                                     size_t const read_len, double const error_rate, uint64_t const seed = 23) {
+    ::std::vector<::std::string> reads;
+
+    // start positions over all long enough sequences, as 1 range.
+    ::std::vector<size_t> seq_idx;
+    ::std::vector<size_t> offsets(1, 0);
+    for (size_t i = 0; i < reference.size(); ++i) {
+      if (reference[i].size() < read_len) continue;
+      seq_idx.emplace_back(i);
+      offsets.emplace_back(offsets.back() + reference[i].size() - read_len + 1);
+    }
+    if ((read_len == 0) || seq_idx.empty()) return reads;
+
+    static const char bases[] = "ACGT";
+    ::std::mt19937_64 gen(seed);
+    ::std::mt19937_64 error_gen(seed + 1);   // separate, so the same seed samples the same reads at any error rate.
+    ::std::uniform_int_distribution<size_t> start(0, offsets.back() - 1);
+    ::std::bernoulli_distribution error(error_rate);
+    ::std::bernoulli_distribution reverse(0.5);
+    ::std::uniform_int_distribution<int> other(1, 3);
+
+    reads.reserve(nreads);
+    for (size_t r = 0; r < nreads; ++r) {
+      size_t pos = start(gen);
+      size_t s = ::std::upper_bound(offsets.begin(), offsets.end(), pos) - offsets.begin() - 1;
+      ::std::string read = reference[seq_idx[s]].substr(pos - offsets[s], read_len);
+
+      if (reverse(gen)) {
+        ::std::reverse(read.begin(), read.end());
+        for (auto & c : read) {
+          switch (c) {
+            case 'A': c = 'T'; break;
+            case 'C': c = 'G'; break;
+            case 'G': c = 'C'; break;
+            case 'T': c = 'A'; break;
+            default: break;
+          }
+        }
+      }
+
+      for (auto & c : read) {
+        if (!error(error_gen)) continue;
+        char const * b = ::std::find(bases, bases + 4, c);
+        c = (b == bases + 4) ? bases[other(error_gen)] : bases[((b - bases) + other(error_gen)) % 4];
+      }
+      reads.emplace_back(::std::move(read));
+    }
+    return reads;
+  }
+
+  /// all k-mers of the reads, in order.  k-mers containing characters outside the k-mer's alphabet are skipped.
+  template <typename Kmer>
+  void kmers_from_reads(::std::vector<::std::string> const & reads, ::std::vector<Kmer> & output) {
+    using Alphabet = typename Kmer::KmerAlphabet;
+    for (auto const & read : reads) {
+      Kmer k;
+      size_t valid = 0;   // length of the current run of valid characters
+      for (char c : read) {
+        uint8_t v = Alphabet::FROM_ASCII[static_cast<unsigned char>(c)];
+        // FROM_ASCII maps unknown characters to a valid value, so check the round trip.
+        if ((v >= Alphabet::SIZE) || (Alphabet::TO_ASCII[v] != ::std::toupper(static_cast<unsigned char>(c)))) {
+          valid = 0;
+          continue;
+        }
+        k.nextFromChar(v);
+        if (++valid >= Kmer::size) output.emplace_back(k);
+      }
+    }
+  }
+
+} // namespace utils
+} // namespace bliss
+
+#endif // SRC_UTILS_KMER_GENERATOR_HPP_
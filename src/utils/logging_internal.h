@@ -119,6 +119,23 @@
 
 
 
+/*********************************************************************
+ *         buffered per thread, written by a background thread        *
+ *********************************************************************/
+
+#elif USE_LOGGER == BLISS_LOGGING_ASYNC
+
+#include <sstream>
+#include "utils/async_log.hpp"
+
+#define PRINT_FATAL(msg)    do { std::stringstream ss; ss << msg; ::plog::AsyncLog::instance().write(0, ss.str()); ::plog::AsyncLog::instance().flush(); exit(EXIT_FAILURE); } while (false)
+#define PRINT_ERROR(msg)    do { std::stringstream ss; ss << msg; ::plog::AsyncLog::instance().write(1, ss.str()); } while (false)
+#define PRINT_WARNING(msg)  do { std::stringstream ss; ss << msg; ::plog::AsyncLog::instance().write(2, ss.str()); } while (false)
+#define PRINT_INFO(msg)     do { std::stringstream ss; ss << msg; ::plog::AsyncLog::instance().write(3, ss.str()); } while (false)
+#define PRINT_DEBUG(msg)    do { std::stringstream ss; ss << msg; ::plog::AsyncLog::instance().write(4, ss.str()); } while (false)
+#define PRINT_TRACE(msg)    do { std::stringstream ss; ss << msg; ::plog::AsyncLog::instance().write(5, ss.str()); } while (false)
+
+
 /*********************************************************************
  *                      use boost::log::trivial                      *
  *********************************************************************/
@@ -307,6 +324,16 @@ void init()
 #define PRINT_TRACEF(msg, ...)   do { printf("[trace] " msg "\n", ##__VA_ARGS__); } while (false)
 
 
+#elif USE_LOGGER == BLISS_LOGGING_ASYNC
+
+// the arguments are stored, and formatted by the flusher thread when possible.
+#define PRINT_FATALF(msg, ...)   do { ::plog::AsyncLog::instance().writef(0, msg, ##__VA_ARGS__); ::plog::AsyncLog::instance().flush(); exit(EXIT_FAILURE); } while (false)
+#define PRINT_ERRORF(msg, ...)   do { ::plog::AsyncLog::instance().writef(1, msg, ##__VA_ARGS__); } while (false)
+#define PRINT_WARNINGF(msg, ...) do { ::plog::AsyncLog::instance().writef(2, msg, ##__VA_ARGS__); } while (false)
+#define PRINT_INFOF(msg, ...)    do { ::plog::AsyncLog::instance().writef(3, msg, ##__VA_ARGS__); } while (false)
+#define PRINT_DEBUGF(msg, ...)   do { ::plog::AsyncLog::instance().writef(4, msg, ##__VA_ARGS__); } while (false)
+#define PRINT_TRACEF(msg, ...)   do { ::plog::AsyncLog::instance().writef(5, msg, ##__VA_ARGS__); } while (false)
+
 #else
 #define BLISS_SPRINTF_BUFFER_SIZE 256
 
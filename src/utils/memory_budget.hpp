@@ -0,0 +1,124 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    memory_budget.hpp
+ * @ingroup utils
+ * @brief   per process memory budget, for splitting large phases into rounds.
+ * @details the budget is a cap on the resident set of the process.  the headroom is the budget less the current
+ *          resident set, so allocations made elsewhere, e.g. the map itself, count against it.
+ *          the default budget is from the BL_MEMORY_BUDGET environment variable, in bytes with an optional
+ *          K, M, or G suffix (powers of 1024).  0 or unset means no budget.
+ *
+ *          the budget is per process.  collective users expect either all ranks or none to have one, not necessarily the same.
+ */
+#ifndef SRC_UTILS_MEMORY_BUDGET_HPP_
+#define SRC_UTILS_MEMORY_BUDGET_HPP_
+
+#include <cstdlib>    // getenv, strtoull
+#include <cstddef>    // size_t
+#include <limits>
+#include <algorithm>  // max
+#include <stdexcept>  // invalid_argument
+#include <string>
+
+#include "getRSS.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>   // malloc_trim
+#endif
+
+namespace bliss {
+
+  namespace utils {
+
+    class memory_budget {
+      protected:
+        /// cap on the resident set, in bytes.  0 means no budget.
+        size_t bytes;
+
+      public:
+        /// parse a byte count with an optional K, M, or G suffix.  null or empty is 0.  throws invalid_argument otherwise.
+        static size_t parse(char const * v) {
+          if ((v == nullptr) || (*v == 0)) return 0;
+
+          char * end = nullptr;
+          unsigned long long n = ::std::strtoull(v, &end, 10);
+          if (end == v) throw ::std::invalid_argument(::std::string("ERROR: memory budget is not a number: ") + v);
+
+          switch (*end) {
+            case 'g': case 'G': n <<= 10;  // fall through
+            case 'm': case 'M': n <<= 10;  // fall through
+            case 'k': case 'K': n <<= 10; ++end; break;
+            default: break;
+          }
+          if (*end != 0) throw ::std::invalid_argument(::std::string("ERROR: memory budget has an unknown suffix: ") + v);
+
+          return static_cast<size_t>(n);
+        }
+
+        /// budget from the BL_MEMORY_BUDGET environment variable, 0 if not set.
+        static size_t from_env() {
+          return parse(::std::getenv("BL_MEMORY_BUDGET"));
+        }
+
+        memory_budget() : bytes(from_env()) {}
+        explicit memory_budget(size_t const _bytes) : bytes(_bytes) {}
+
+        bool limited() const { return bytes > 0; }
+
+        size_t get_bytes() const { return bytes; }
+
+        /// bytes that can still be allocated, i.e. the budget less the current resident set.  max size_t without a budget.
+        size_t available() const {
+          if (!limited()) return ::std::numeric_limits<size_t>::max();
+          size_t used = ::getCurrentRSS();
+          return (used >= bytes) ? 0 : (bytes - used);
+        }
+
+        /// elements of bytes_per_element that fit in the available memory, at least 1 so that callers make progress.
+        size_t max_elements(size_t const bytes_per_element) const {
+          if (!limited() || (bytes_per_element == 0)) return ::std::numeric_limits<size_t>::max();
+          return ::std::max(available() / bytes_per_element, static_cast<size_t>(1));
+        }
+
+        /// rounds needed to process count elements of bytes_per_element each within the available memory.  at least 1.
+        size_t rounds(size_t const count, size_t const bytes_per_element) const {
+          size_t per_round = max_elements(bytes_per_element);
+          if (count <= per_round) return 1;
+          return (count + per_round - 1) / per_round;
+        }
+    };
+
+    /**
+     * @brief  return the free pages of the heap to the operating system, e.g. after a build phase.
+     * @details  freed blocks stay mapped in the allocator's arenas, so the resident set stays at its peak.  glibc's
+     *           malloc_trim releases them.  with other allocators this does nothing.
+     * @return  bytes by which the resident set shrank.
+     */
+    inline size_t trim_heap() {
+      size_t before = ::getCurrentRSS();
+#if defined(__GLIBC__)
+      malloc_trim(0);
+#endif
+      size_t after = ::getCurrentRSS();
+      return (before > after) ? (before - after) : 0;
+    }
+
+  } // namespace utils
+} // namespace bliss
+
+#endif // SRC_UTILS_MEMORY_BUDGET_HPP_
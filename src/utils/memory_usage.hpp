@@ -20,6 +20,13 @@
  * @author  tpan
  * @brief   functions to track memory usage during program execution (for marked functional blocks)
  * @details each "mark" call snapshots the current memory usage and peak memory usage.
+ *          the peak is the process lifetime high-water mark (getrusage), which hides the transient peaks of a later
+ *          phase, e.g. the 2x spike during a rehash.  each mark therefore also records the peak of the phase that
+ *          it closes:  the kernel's VmHWM in /proc/self/status, which is reset at every mark by writing 5 to
+ *          /proc/self/clear_refs (linux 4.0 and later).  where that is not available, the phase peak falls back to
+ *          the lifetime peak, and the report says so.  the reset also lowers ru_maxrss on recent kernels, so the
+ *          lifetime peak is kept here as the running max.  the kernel counter is per process:  with several MemUsage
+ *          objects, a phase peak covers the time since the latest mark of any of them.
  *          relies on http://nadeausoftware.com/articles/2012/07/c_c_tip_how_get_process_resident_set_size_physical_memory_use#GetProcessMemoryInfonbspforpeakandcurrentresidentsetsize
  *
  *          also see http://www.linuxatemyram.com/play.html and
@@ -45,11 +52,14 @@
 #include <string>
 #include <algorithm>  // std::min
 #include <sstream>
+#include <iterator>  // ostream_iterator
 #include <cmath>  // std::sqrt
 
 #include <io/io_exception.hpp>
 #include <mxx/reduction.hpp>
 
+#include "utils/benchmark_sink.hpp"
+
 //http://nadeausoftware.com/articles/2012/07/c_c_tip_how_get_process_resident_set_size_physical_memory_use#GetProcessMemoryInfonbspforpeakandcurrentresidentsetsize
 // note:  reports in bytes.
 #include "getRSS.h"
@@ -112,8 +122,42 @@ class MemUsage {
     std::vector<std::string> names;
     std::vector<double> mem_curr;
     std::vector<double> mem_max;
+    std::vector<double> mem_phase_max;
+
+    /// true if the kernel high-water mark could be reset, so that mem_phase_max is per phase.
+    bool per_phase;
+
+    /// running max of the process peak, since a reset of the high-water mark can lower getPeakRSS.
+    double lifetime_max;
+
+    /// resident set high-water mark of this process, in bytes, from /proc/self/status.  -1 if not available.
+    static double get_hwm() {
+      FILE * status = fopen("/proc/self/status", "r");
+      if (status == NULL) return -1.0;
+
+      char line[256];
+      size_t hwm = 0;
+      bool found = false;
+      while (!found && fgets(line, sizeof(line), status)) {
+        found = (sscanf(line, "VmHWM: %lu kB", &hwm) == 1);
+      }
+      fclose(status);
+      return found ? static_cast<double>(hwm) * 1024.0 : -1.0;
+    }
+
+    /// reset the high-water mark to the current resident set.  false if not supported.
+    static bool reset_hwm() {
+      FILE * refs = fopen("/proc/self/clear_refs", "w");
+      if (refs == NULL) return false;
+      bool ok = (fputs("5", refs) >= 0);
+      ok &= (fclose(refs) == 0);
+      return ok;
+    }
 
   public:
+    MemUsage() : per_phase(false), lifetime_max(0.0) {
+      reset();
+    }
 
     /// return the program usable ram in bytes.
     static size_t get_usable_mem() {
@@ -158,14 +202,26 @@ class MemUsage {
       names.clear();
       mem_curr.clear();
       mem_max.clear();
+      mem_phase_max.clear();
+
+      // the first phase starts here.
+      lifetime_max = ::std::max(lifetime_max, static_cast<double>(::getPeakRSS()));
+      per_phase = reset_hwm();
     }
 
 
 //============ memory_usage start
     void mark(::std::string const & name) {
       names.push_back(name);
-      mem_curr.push_back(::getCurrentRSS());
-      mem_max.push_back(::getPeakRSS());
+      double curr = ::getCurrentRSS();
+      double hwm = per_phase ? get_hwm() : -1.0;
+      lifetime_max = ::std::max(::std::max(lifetime_max, static_cast<double>(::getPeakRSS())), hwm);
+      mem_curr.push_back(curr);
+      mem_max.push_back(lifetime_max);
+      mem_phase_max.push_back((hwm < 0.0) ? lifetime_max : ::std::max(hwm, curr));
+
+      // start the next phase at the current usage.
+      if (per_phase) per_phase = reset_hwm();
     }
     void collective_mark(::std::string const & name, ::mxx::comm const & comm) {
 
@@ -175,7 +231,29 @@ class MemUsage {
 		mark(name);
     }
 
+    /// true if the phase peaks are per phase, not the lifetime peak.
+    bool has_phase_peaks() const { return per_phase; }
+
+    std::vector<double> const & phase_peaks() const { return mem_phase_max; }
+    std::vector<double> const & lifetime_peaks() const { return mem_max; }
+
+    /// change in current usage since the previous mark, in bytes.  the first mark is relative to 0.
+    std::vector<double> deltas() const {
+      std::vector<double> result(mem_curr.size());
+      for (size_t i = 0; i < mem_curr.size(); ++i) {
+        result[i] = (i == 0) ? mem_curr[i] : mem_curr[i] - mem_curr[i - 1];
+      }
+      return result;
+    }
+
     void report(::std::string const & title) {
+        if (::plog::BenchSink::enabled() && (mem_curr.size() > 0)) {
+          ::plog::BenchSink::append(title, "mem", names, "curr_bytes", 1, ::plog::BenchSink::local(mem_curr));
+          ::plog::BenchSink::append(title, "mem", names, "peak_bytes", 1, ::plog::BenchSink::local(mem_max));
+          ::plog::BenchSink::append(title, "mem", names, "delta_bytes", 1, ::plog::BenchSink::local(deltas()));
+          ::plog::BenchSink::append(title, "mem", names, "phase_peak_bytes", 1, ::plog::BenchSink::local(mem_phase_max));
+        }
+
         auto BtoMB = [](double const & x) { return x / (1024.0 * 1024.0); };
 
     	std::stringstream output;
@@ -196,6 +274,10 @@ class MemUsage {
 
         output << "[MEM] " << title << "\tmax\t[,";
         std::transform(mem_max.begin(), mem_max.end(), dit, BtoMB);
+        output << "]" << ::std::endl;
+
+        output << "[MEM] " << title << (per_phase ? "\tphase_max\t[," : "\tphase_max (lifetime)\t[,");
+        std::transform(mem_phase_max.begin(), mem_phase_max.end(), dit, BtoMB);
         output << "]";
 
         // print pending stuff, then print entire string at once (minimizes multiple threads/processes mixing output )
@@ -311,6 +393,24 @@ class MemUsage {
       int p = comm.size();
       int rank = comm.rank();
 
+      // before the stdev computation below squares the local values in place.
+      if ((mem_curr.size() > 0) && ::mxx::any_of(::plog::BenchSink::enabled(), comm)) {
+        ::plog::BenchSink::stats curr = ::plog::BenchSink::reduce(mem_curr, comm);
+        ::plog::BenchSink::stats peak = ::plog::BenchSink::reduce(mem_max, comm);
+        ::plog::BenchSink::stats delta = ::plog::BenchSink::reduce(deltas(), comm);
+        if (rank == 0) {
+          ::plog::BenchSink::append(title, "mem", names, "curr_bytes", p, curr);
+          ::plog::BenchSink::append(title, "mem", names, "peak_bytes", p, peak);
+          ::plog::BenchSink::append(title, "mem", names, "delta_bytes", p, delta);
+        }
+      }
+
+      ::plog::BenchSink::stats phase_peak = ::plog::BenchSink::reduce(mem_phase_max, comm);
+      bool all_per_phase = ::mxx::all_of(per_phase, comm);
+      if ((rank == 0) && (mem_phase_max.size() > 0)) {
+        ::plog::BenchSink::append(title, "mem", names, "phase_peak_bytes", p, phase_peak);
+      }
+
       if (mem_curr.size() > 0) {
     	  curr_mins = ::mxx::reduce(mem_curr, 0,
     			[](double const & x, double const & y) { return ::std::min(x, y); }, comm);
@@ -385,6 +485,14 @@ class MemUsage {
 
           output << "[MEM] " << title << "\tpeak_stdev\t[,";
           std::transform(peak_stdevs.begin(), peak_stdevs.end(), dit, BtoMB);
+          output << "]" << std::endl;
+
+          output << "[MEM] " << title << (all_per_phase ? "\tphase_peak_max\t[," : "\tphase_peak_max (lifetime)\t[,");
+          std::transform(phase_peak.maxs.begin(), phase_peak.maxs.end(), dit, BtoMB);
+          output << "]" << std::endl;
+
+          output << "[MEM] " << title << (all_per_phase ? "\tphase_peak_mean\t[," : "\tphase_peak_mean (lifetime)\t[,");
+          std::transform(phase_peak.means.begin(), phase_peak.means.end(), dit, BtoMB);
           output << "]";
 
 
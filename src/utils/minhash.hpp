@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    minhash.hpp
+ * @ingroup utils
+ * @brief   bottom-s MinHash sketch, for Jaccard similarity of sets.
+ * @details keeps the s smallest distinct 64 bit hash values added.  the Jaccard index of 2 sets is estimated from the
+ *          fraction of the s smallest hashes of the union that are in both sketches.  the standard error is about
+ *          1 / sqrt(s).  the hash values should be well mixed, as for hyperloglog.
+ *
+ *          updates are buffered and folded in s at a time, so an update is a comparison with the current s-th smallest
+ *          hash in the common case.  sketches with the same s can be merged.
+ */
+#ifndef SRC_UTILS_MINHASH_HPP_
+#define SRC_UTILS_MINHASH_HPP_
+
+#include <vector>
+#include <cstdint>    // uint64_t
+#include <cstddef>    // size_t
+#include <limits>
+#include <algorithm>  // sort, unique, merge
+
+namespace bliss {
+
+  namespace utils {
+
+    class bottom_minhash {
+      protected:
+        /// number of hashes kept.
+        size_t s;
+        /// the s smallest distinct hashes folded in so far, ascending.
+        mutable std::vector<uint64_t> hashes;
+        /// updates not folded in yet.
+        mutable std::vector<uint64_t> pending;
+        /// updates at or above this cannot be in the sketch.
+        uint64_t threshold;
+
+        /// fold the pending updates into hashes.
+        void flush() const {
+          if (pending.empty()) return;
+          hashes.insert(hashes.end(), pending.begin(), pending.end());
+          pending.clear();
+          ::std::sort(hashes.begin(), hashes.end());
+          hashes.erase(::std::unique(hashes.begin(), hashes.end()), hashes.end());
+          if (hashes.size() > s) hashes.resize(s);
+        }
+
+        void update_threshold() {
+          threshold = (hashes.size() < s) ? ::std::numeric_limits<uint64_t>::max() : hashes.back();
+        }
+
+      public:
+        explicit bottom_minhash(size_t const _s = 1000) : s(::std::max(_s, static_cast<size_t>(1))),
+            threshold(::std::numeric_limits<uint64_t>::max()) {
+          pending.reserve(s);
+        }
+
+        size_t get_sketch_size() const { return s; }
+
+        /// add a hash value to the sketch
+        inline void update(uint64_t const & hash) {
+          if (hash >= threshold) return;
+          pending.push_back(hash);
+          if (pending.size() >= s) {
+            flush();
+            update_threshold();
+          }
+        }
+
+        /// merge another sketch with the same s into this one.
+        void merge(bottom_minhash const & other) {
+          other.flush();
+          pending.insert(pending.end(), other.hashes.begin(), other.hashes.end());
+          flush();
+          update_threshold();
+        }
+
+        /// the smallest distinct hashes added, at most s, ascending.
+        std::vector<uint64_t> const & get_hashes() const {
+          flush();
+          return hashes;
+        }
+
+        /// replace the content with hashes, e.g. a sketch merged elsewhere.  need not be sorted or distinct.
+        void set_hashes(std::vector<uint64_t> const & h) {
+          hashes.clear();
+          pending.assign(h.begin(), h.end());
+          flush();
+          update_threshold();
+        }
+
+        /// estimate the number of distinct hash values added:  exact below s, else from the s-th smallest hash.
+        double estimate() const {
+          flush();
+          if (hashes.size() < s) return static_cast<double>(hashes.size());
+          double frac = (static_cast<double>(hashes.back()) + 1.0) / 18446744073709551616.0;  // 2^64
+          return static_cast<double>(s - 1) / frac;
+        }
+
+        /// estimate the Jaccard index of the sets added to this and other:  shared hashes among the s smallest of the union.
+        double jaccard(bottom_minhash const & other) const {
+          flush();
+          other.flush();
+          size_t n = ::std::min(s, other.s);
+          size_t total = 0, shared = 0;
+          auto a = hashes.begin();
+          auto b = other.hashes.begin();
+          while ((total < n) && ((a != hashes.end()) || (b != other.hashes.end()))) {
+            if ((b == other.hashes.end()) || ((a != hashes.end()) && (*a < *b))) ++a;
+            else if ((a == hashes.end()) || (*b < *a)) ++b;
+            else { ++shared; ++a; ++b; }
+            ++total;
+          }
+          return (total == 0) ? 0.0 : static_cast<double>(shared) / static_cast<double>(total);
+        }
+
+        void clear() {
+          hashes.clear();
+          pending.clear();
+          update_threshold();
+        }
+    };
+
+  } // namespace utils
+} // namespace bliss
+
+#endif /* SRC_UTILS_MINHASH_HPP_ */
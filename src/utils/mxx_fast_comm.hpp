@@ -29,15 +29,224 @@
 #ifndef SRC_UTILS_MXX_FAST_COMM_HPP_
 #define SRC_UTILS_MXX_FAST_COMM_HPP_
 
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>  // sort, find
+#include <ctime>      // time
+#include <cstdlib>    // getenv, strtoul
+#include <cstdio>     // rename, remove
+#include <functional> // plus
+#include <stdexcept>
+#include <unistd.h>   // getpid
+
 #include "mxx/env.hpp"
 #include "mxx/comm.hpp"
+#include "mxx/collective.hpp"
+#include "mxx/reduction.hpp"
 #include "mxx/benchmark.hpp"
 
 namespace bliss {
 
   namespace mxx {
 
-   bool get_fast_nodes(::mxx::comm const & comm, ::mxx::env const & e, int target_node_count) {
+   /**
+    * @brief bandwidth between nodes, as measured by ::mxx::pairwise_bw_matrix.
+    * @details  nodes are in the order of their first global rank.  bw[i * size() + j] is node i's row entry for node j.
+    */
+   struct bw_profile {
+     std::vector<std::string> hosts;
+     std::vector<double> bw;
+
+     size_t size() const { return hosts.size(); }
+     double operator()(size_t i, size_t j) const { return bw[i * hosts.size() + j]; }
+     std::vector<double> row(size_t i) const {
+       return std::vector<double>(bw.begin() + i * hosts.size(), bw.begin() + (i + 1) * hosts.size());
+     }
+   };
+
+   /// the cache file from the BL_BW_CACHE environment variable.  empty if not set, which disables the cache.
+   inline std::string bw_cache_file_from_env() {
+     char const * v = ::std::getenv("BL_BW_CACHE");
+     return (v == nullptr) ? std::string() : std::string(v);
+   }
+
+   /// cache lifetime in seconds from the BL_BW_CACHE_TTL environment variable.  1 day if not set.
+   inline size_t bw_cache_ttl_from_env() {
+     char const * v = ::std::getenv("BL_BW_CACHE_TTL");
+     return (v == nullptr) ? 86400UL : ::std::strtoul(v, nullptr, 10);
+   }
+
+   /// read a cached profile.  false if the file is missing, malformed, or older than ttl seconds.
+   inline bool read_bw_profile(std::string const & filename, size_t ttl, bw_profile & profile) {
+     std::ifstream in(filename.c_str());
+     if (!in) return false;
+
+     std::string magic;
+     int version = 0;
+     long long stamp = 0;
+     size_t n = 0;
+     if (!(in >> magic >> version >> stamp >> n) || (magic != "BLISSBW") || (version != 1)) return false;
+     long long age = static_cast<long long>(::time(nullptr)) - stamp;
+     if ((age < 0) || (static_cast<unsigned long long>(age) > ttl)) return false;
+
+     profile.hosts.resize(n);
+     for (size_t i = 0; i < n; ++i)
+       if (!(in >> profile.hosts[i])) return false;
+     profile.bw.resize(n * n);
+     for (size_t i = 0; i < n * n; ++i)
+       if (!(in >> profile.bw[i])) return false;
+     return true;
+   }
+
+   /// write a profile with the current time.  throws std::runtime_error if the file cannot be written.
+   inline void write_bw_profile(std::string const & filename, bw_profile const & profile) {
+     // write and rename, so that concurrent jobs never read a partial file.
+     std::stringstream tmp;
+     tmp << filename << ".tmp." << ::time(nullptr) << "." << ::getpid();
+     {
+       std::ofstream out(tmp.str().c_str());
+       out << "BLISSBW 1 " << static_cast<long long>(::time(nullptr)) << " " << profile.size() << "\n";
+       for (auto const & h : profile.hosts) out << h << "\n";
+       out.precision(17);
+       for (size_t i = 0; i < profile.size(); ++i) {
+         for (size_t j = 0; j < profile.size(); ++j) out << profile(i, j) << " ";
+         out << "\n";
+       }
+       if (!out) throw std::runtime_error("ERROR: cannot write the bandwidth profile cache " + tmp.str());
+     }
+     if (::rename(tmp.str().c_str(), filename.c_str()) != 0) {
+       ::remove(tmp.str().c_str());
+       throw std::runtime_error("ERROR: cannot replace the bandwidth profile cache " + filename);
+     }
+   }
+
+   /// index of this rank's node, in the order of the nodes' first global ranks.  collective.
+   inline int node_index(::mxx::hybrid_comm const & hc) {
+     int leader = (hc.local.rank() == 0) ? 1 : 0;
+     int idx = ::mxx::exscan(leader, std::plus<int>(), hc.global);
+     if (hc.global.rank() == 0) idx = 0;
+     // the leader has the lowest global rank on its node, so it has the node's index.
+     return ::mxx::allreduce(hc.local.rank() == 0 ? idx : 0, std::plus<int>(), hc.local);
+   }
+
+   /// host names of the nodes, in node order, on all ranks.  collective.
+   inline std::vector<std::string> node_hosts(::mxx::hybrid_comm const & hc) {
+     char name[MPI_MAX_PROCESSOR_NAME];
+     int len = 0;
+     MPI_Get_processor_name(name, &len);
+
+     std::vector<char> mine;
+     if (hc.local.rank() == 0) {
+       mine.assign(name, name + len);
+       mine.push_back(0);
+     }
+     std::vector<char> all = ::mxx::allgatherv(mine, hc.global);
+
+     std::vector<std::string> hosts;
+     for (auto it = all.begin(); it != all.end(); ) {
+       auto end = std::find(it, all.end(), 0);
+       hosts.emplace_back(it, end);
+       it = (end == all.end()) ? end : end + 1;
+     }
+     return hosts;
+   }
+
+   /**
+    * @brief the pairwise node bandwidth, from the cache file if it has a profile of the same set of hosts that is
+    *        younger than ttl seconds, else measured with ::mxx::pairwise_bw_matrix and written to the cache.  collective.
+    * @details  measuring takes tens of seconds at scale, so jobs on the same nodes share 1 measurement.
+    *           rank 0 reads and writes the cache.  an empty cache_file always measures.
+    */
+   inline bw_profile get_bw_profile(::mxx::hybrid_comm const & hc, std::string const & cache_file = bw_cache_file_from_env(),
+                                    size_t ttl = bw_cache_ttl_from_env()) {
+     bw_profile profile;
+     profile.hosts = node_hosts(hc);
+     size_t const n = profile.size();
+
+     // rank 0 reads the cache, and reorders it to the current node order.
+     std::vector<double> cached;
+     if ((hc.global.rank() == 0) && !cache_file.empty()) {
+       bw_profile c;
+       if (read_bw_profile(cache_file, ttl, c) && (c.size() == n)) {
+         std::vector<size_t> pos(n);
+         bool same = true;
+         for (size_t i = 0; same && (i < n); ++i) {
+           auto it = std::find(c.hosts.begin(), c.hosts.end(), profile.hosts[i]);
+           same = (it != c.hosts.end());
+           if (same) pos[i] = std::distance(c.hosts.begin(), it);
+         }
+         if (same) {
+           cached.resize(n * n);
+           for (size_t i = 0; i < n; ++i)
+             for (size_t j = 0; j < n; ++j) cached[i * n + j] = c(pos[i], pos[j]);
+         }
+       }
+     }
+     cached = ::mxx::allgatherv(cached, hc.global);
+     if (cached.size() == n * n) {
+       profile.bw.swap(cached);
+       return profile;
+     }
+
+     // measure.  the node leaders have the rows.
+     std::vector<double> bw_row = ::mxx::pairwise_bw_matrix(hc);
+     if (hc.local.rank() != 0) bw_row.clear();
+     profile.bw = ::mxx::allgatherv(bw_row, hc.global);
+     if (profile.bw.size() != n * n) throw std::logic_error("ERROR: bandwidth rows do not cover all nodes.");
+
+     if ((hc.global.rank() == 0) && !cache_file.empty()) write_bw_profile(cache_file, profile);
+
+     return profile;
+   }
+
+   /**
+    * @brief a chain of the nodes, from node 0, each followed by the unvisited node it has the fastest link to.
+    * @details  so that neighboring nodes in the chain, e.g. the ranks that exchange partition overlaps, are on fast links.
+    */
+   inline std::vector<size_t> bandwidth_node_order(bw_profile const & profile) {
+     size_t const n = profile.size();
+     std::vector<size_t> order;
+     if (n == 0) return order;
+
+     std::vector<bool> visited(n, false);
+     size_t curr = 0;
+     visited[0] = true;
+     order.push_back(0);
+     for (size_t k = 1; k < n; ++k) {
+       size_t best = n;
+       for (size_t j = 0; j < n; ++j) {
+         if (visited[j]) continue;
+         // the link speed is the slower direction.
+         if ((best == n) || (std::min(profile(curr, j), profile(j, curr)) > std::min(profile(curr, best), profile(best, curr))))
+           best = j;
+       }
+       visited[best] = true;
+       order.push_back(best);
+       curr = best;
+     }
+     return order;
+   }
+
+   /**
+    * @brief a copy of comm with the nodes in bandwidth_node_order.  ranks on a node stay consecutive and in order.  collective.
+    * @param profile  from get_bw_profile on the same communicator.
+    */
+   inline ::mxx::comm reorder_by_bandwidth(::mxx::hybrid_comm const & hc, bw_profile const & profile) {
+     std::vector<size_t> order = bandwidth_node_order(profile);
+     size_t node = node_index(hc);
+     size_t pos = std::distance(order.begin(), std::find(order.begin(), order.end(), node));
+     return hc.global.split(0, static_cast<int>(pos * hc.global.size() + hc.global.rank()));
+   }
+
+   /**
+    * @brief keep the target_node_count nodes with the best bandwidth.  collective.
+    * @details  the bandwidth profile is from get_bw_profile, so the measurement is cached in BL_BW_CACHE when set.
+    * @return  true on the ranks of the kept nodes.
+    */
+   bool get_fast_nodes(::mxx::comm const & comm, ::mxx::env const & e, int target_node_count,
+                       std::string const & cache_file = bw_cache_file_from_env(), size_t ttl = bw_cache_ttl_from_env()) {
      // create shared-mem MPI+MPI hybrid communicator
      ::mxx::hybrid_comm hc(comm);
 
@@ -57,7 +266,8 @@ namespace bliss {
      int n_vote_off = num_nodes - target_node_count;
 
      // split by pairwise bandwidth
-     std::vector<double> bw_row = ::mxx::pairwise_bw_matrix(hc);
+     bw_profile profile = get_bw_profile(hc, cache_file, ttl);
+     std::vector<double> bw_row = profile.row(node_index(hc));
      ::mxx::print_bw_matrix_stats(hc, bw_row);
      bool part = ::mxx::vote_off(hc, n_vote_off, bw_row);
 
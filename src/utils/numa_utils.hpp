@@ -0,0 +1,200 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    numa_utils.hpp
+ * @ingroup utils
+ * @brief   NUMA topology and memory placement, without libnuma.
+ * @details the topology is read from /sys/devices/system/node, and the memory policy is set with the mbind system call.
+ *          on systems without NUMA support (or other than linux) there is 1 node, 0, and the placement calls do nothing
+ *          and return false.
+ *
+ *          placement only applies to pages not yet touched, and is per page, so only the whole pages inside a range are affected.
+ *
+ *          numa_interleaved_allocator spreads large allocations over all nodes, for a table that is probed by threads on all sockets.
+ *          for per-thread tables, first touch by the owning thread already places the pages on its node
+ *          (see ::fsc::thread_partitioned, which keeps the thread to sub-table assignment fixed).
+ */
+#ifndef SRC_UTILS_NUMA_UTILS_HPP_
+#define SRC_UTILS_NUMA_UTILS_HPP_
+
+#include <cstddef>   // size_t
+#include <cstdint>   // uintptr_t
+#include <cstdlib>   // strtol
+#include <string>
+#include <vector>
+#include <fstream>
+
+#if defined(__linux__)
+#include <unistd.h>       // syscall, sysconf
+#include <sys/syscall.h>  // SYS_mbind, SYS_getcpu
+#endif
+
+#include "utils/huge_page_allocator.hpp"
+
+namespace bliss {
+
+  namespace utils {
+
+    namespace numa {
+
+      namespace detail {
+        /// memory policy modes, from linux/mempolicy.h
+        constexpr int mpol_preferred = 1;
+        constexpr int mpol_interleave = 3;
+
+        /// node mask bits passed to mbind.
+        constexpr size_t mask_words = 16;
+
+        inline ::std::string read_line(::std::string const & path) {
+          ::std::ifstream f(path.c_str());
+          ::std::string line;
+          if (f.good()) ::std::getline(f, line);
+          return line;
+        }
+
+        /// set the policy for the whole pages in [p, p + bytes).  false if not supported or the call failed.
+        inline bool set_policy(void * p, size_t bytes, int mode, ::std::vector<int> const & nodes) {
+#if defined(__linux__) && defined(SYS_mbind)
+          unsigned long mask[mask_words] = { 0 };
+          for (int n : nodes) {
+            if ((n < 0) || (static_cast<size_t>(n) >= mask_words * sizeof(unsigned long) * 8)) return false;
+            mask[n / (sizeof(unsigned long) * 8)] |= (1UL << (n % (sizeof(unsigned long) * 8)));
+          }
+
+          uintptr_t page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+          uintptr_t start = (reinterpret_cast<uintptr_t>(p) + page - 1) & ~(page - 1);
+          uintptr_t end = (reinterpret_cast<uintptr_t>(p) + bytes) & ~(page - 1);
+          if (end <= start) return false;
+
+          return ::syscall(SYS_mbind, start, end - start, mode, mask, mask_words * sizeof(unsigned long) * 8, 0) == 0;
+#else
+          (void)p; (void)bytes; (void)mode; (void)nodes;
+          return false;
+#endif
+        }
+      } // namespace detail
+
+
+      /// parse a sysfs cpu or node list, e.g. "0-3,8,10-11".
+      inline ::std::vector<int> parse_list(::std::string const & s) {
+        ::std::vector<int> out;
+        char const * c = s.c_str();
+        while (*c != 0) {
+          char * e;
+          long lo = ::strtol(c, &e, 10);
+          if (e == c) break;
+          long hi = lo;
+          c = e;
+          if (*c == '-') {
+            hi = ::strtol(c + 1, &e, 10);
+            c = e;
+          }
+          for (long i = lo; i <= hi; ++i) out.push_back(static_cast<int>(i));
+          if (*c == ',') ++c;
+          else break;
+        }
+        return out;
+      }
+
+      /// online NUMA nodes.  {0} if the topology is not available.
+      inline ::std::vector<int> nodes() {
+        ::std::vector<int> out = parse_list(detail::read_line("/sys/devices/system/node/online"));
+        if (out.empty()) out.push_back(0);
+        return out;
+      }
+
+      /// cpus of a node.  empty if the topology is not available.
+      inline ::std::vector<int> node_cpus(int node) {
+        return parse_list(detail::read_line("/sys/devices/system/node/node" + ::std::to_string(node) + "/cpulist"));
+      }
+
+      /// node of the cpu the calling thread runs on.  0 if not available.
+      inline int current_node() {
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned cpu = 0, node = 0;
+        if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return static_cast<int>(node);
+#endif
+        return 0;
+      }
+
+      /// interleave the untouched pages of a range over all nodes.  @return false if not supported.
+      inline bool interleave(void * p, size_t bytes) {
+        ::std::vector<int> ns = nodes();
+        if (ns.size() < 2) return false;
+        return detail::set_policy(p, bytes, detail::mpol_interleave, ns);
+      }
+
+      /// place the untouched pages of a range on a node, if it has memory.  @return false if not supported.
+      inline bool prefer(void * p, size_t bytes, int node) {
+        if (nodes().size() < 2) return false;
+        return detail::set_policy(p, bytes, detail::mpol_preferred, ::std::vector<int>(1, node));
+      }
+
+      /// place the untouched pages of a range on the node of the calling thread.  e.g. for a buffer filled by another thread.
+      inline bool prefer_current(void * p, size_t bytes) {
+        return prefer(p, bytes, current_node());
+      }
+
+    } // namespace numa
+
+
+    /**
+     * @brief huge page allocator that also interleaves the large allocations over the NUMA nodes.
+     * @details  for a local table shared by threads on all sockets, e.g. in a rank per node run.  with a single
+     *           node this behaves as huge_page_allocator.
+     */
+    template <typename T, bool HUGETLB = false>
+    class numa_interleaved_allocator : public huge_page_allocator<T, HUGETLB> {
+        using Base = huge_page_allocator<T, HUGETLB>;
+
+      public:
+        using pointer   = typename Base::pointer;
+        using size_type = typename Base::size_type;
+
+        template <typename U>
+        struct rebind {
+            using other = numa_interleaved_allocator<U, HUGETLB>;
+        };
+
+        numa_interleaved_allocator() noexcept {}
+        numa_interleaved_allocator(numa_interleaved_allocator const &) noexcept : Base() {}
+        template <typename U>
+        numa_interleaved_allocator(numa_interleaved_allocator<U, HUGETLB> const &) noexcept {}
+
+        pointer allocate(size_type n, void const * hint = nullptr) {
+          pointer p = Base::allocate(n, hint);
+          // the mapped range is whole huge pages, not yet touched.
+          size_t bytes = n * sizeof(T);
+          if (bytes >= Base::huge_page_size) ::bliss::utils::numa::interleave(p, Base::round_up(bytes));
+          return p;
+        }
+    };
+
+    template <typename T, typename U, bool HUGETLB>
+    inline bool operator==(numa_interleaved_allocator<T, HUGETLB> const &, numa_interleaved_allocator<U, HUGETLB> const &) {
+      return true;
+    }
+
+    template <typename T, typename U, bool HUGETLB>
+    inline bool operator!=(numa_interleaved_allocator<T, HUGETLB> const &, numa_interleaved_allocator<U, HUGETLB> const &) {
+      return false;
+    }
+
+  } // namespace utils
+} // namespace bliss
+
+#endif /* SRC_UTILS_NUMA_UTILS_HPP_ */
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    perf_counters.hpp
+ * @ingroup
+ * @brief   hardware performance counters for the benchmark phases, via the linux perf_event interface.
+ * @details counts cycles, instructions, last level cache misses, branch misses, and dTLB read misses between
+ *          start() and end(name), the same way the Timer times a phase, and reports them with the IPC next to the
+ *          timings.  the counters belong to the thread that created the PerfCounters object, and exclude the kernel.
+ *          when the counters are multiplexed, the counts are scaled by the enabled / running times.
+ *
+ *          an event that cannot be opened (no PMU access in a VM or container, perf_event_paranoid too high, or a
+ *          platform without perf_event) is reported as -1, and nothing else changes.
+ *
+ *          enabled with ENABLE_PERF_BENCHMARK (BL_BENCHMARK_PERF).  rows also go to the BL_BENCH_FILE sink, kind "perf".
+ */
+#ifndef SRC_UTILS_PERF_COUNTERS_HPP_
+#define SRC_UTILS_PERF_COUNTERS_HPP_
+
+#include "bliss-logger_config.hpp"
+
+#include <vector>
+#include <string>
+#include <array>
+#include <algorithm>  // copy
+#include <sstream>
+#include <iterator>   // ostream_iterator
+#include <cstdio>     // printf
+#include <cstring>    // memset
+#include <cstdint>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include <mxx/reduction.hpp>
+
+#include "utils/benchmark_sink.hpp"
+
+namespace plog {
+
+class PerfCounters {
+  public:
+    enum event_id { CYCLES = 0, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, DTLB_MISSES, NUM_EVENTS };
+
+    using counts = ::std::array<double, NUM_EVENTS>;
+
+  protected:
+    ::std::array<int, NUM_EVENTS> fds;
+
+    ::std::vector<::std::string> names;
+    ::std::vector<counts> values;
+    counts last;
+
+    static char const * metric_name(int const & i) {
+      static char const * metrics[NUM_EVENTS] = { "cycles", "instructions", "cache_misses", "branch_misses", "dtlb_misses" };
+      return metrics[i];
+    }
+
+#if defined(__linux__)
+    static int open_event(uint32_t const & type, uint64_t const & config) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(struct perf_event_attr));
+      attr.size = sizeof(struct perf_event_attr);
+      attr.type = type;
+      attr.config = config;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      // this thread, any cpu, no group.  counting starts now.
+      return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    /// current count, scaled for multiplexing.  -1 if not available.
+    double read_event(int const & i) const {
+      if (fds[i] < 0) return -1.0;
+
+      uint64_t buf[3] = { 0, 0, 0 };  // value, time enabled, time running
+      if (::read(fds[i], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) return -1.0;
+      if (buf[2] == 0) return 0.0;
+      return static_cast<double>(buf[0]) * (static_cast<double>(buf[1]) / static_cast<double>(buf[2]));
+    }
+#else
+    double read_event(int const & i) const { return -1.0; }
+#endif
+
+    counts read_all() const {
+      counts c;
+      for (int i = 0; i < NUM_EVENTS; ++i) c[i] = read_event(i);
+      return c;
+    }
+
+    /// 1 metric of all phases.
+    ::std::vector<double> metric(int const & i) const {
+      ::std::vector<double> result;
+      result.reserve(values.size());
+      for (auto const & v : values) result.push_back(v[i]);
+      return result;
+    }
+
+    /// instructions per cycle of each phase, from (possibly summed) instructions and cycles.
+    static ::std::vector<double> ipc(::std::vector<double> const & instructions, ::std::vector<double> const & cycles) {
+      ::std::vector<double> result(cycles.size(), -1.0);
+      for (size_t i = 0; i < cycles.size(); ++i) {
+        if ((cycles[i] > 0.0) && (instructions[i] >= 0.0)) result[i] = instructions[i] / cycles[i];
+      }
+      return result;
+    }
+
+  public:
+    PerfCounters() {
+      fds.fill(-1);
+#if defined(__linux__)
+      fds[CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+      fds[INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+      fds[CACHE_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+      fds[BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+      fds[DTLB_MISSES] = open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                    (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+      reset();
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+      for (int & fd : fds) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+      }
+#endif
+    }
+
+    PerfCounters(PerfCounters const & other) = delete;
+    PerfCounters& operator=(PerfCounters const & other) = delete;
+
+    /// true if the event could be opened.
+    bool available(event_id const & i) const { return fds[i] >= 0; }
+
+    /// true if any event could be opened.
+    bool available() const {
+      for (int i = 0; i < NUM_EVENTS; ++i) {
+        if (fds[i] >= 0) return true;
+      }
+      return false;
+    }
+
+    void reset() {
+      names.clear();
+      values.clear();
+      start();
+    }
+
+    void start() {
+      last = read_all();
+    }
+
+    /// end a phase, and start the next.
+    void end(::std::string const & name) {
+      counts now = read_all();
+      counts delta;
+      for (int i = 0; i < NUM_EVENTS; ++i) {
+        delta[i] = ((now[i] < 0.0) || (last[i] < 0.0)) ? -1.0 : (now[i] - last[i]);
+      }
+      names.push_back(name);
+      values.push_back(delta);
+      last = now;
+    }
+
+    ::std::vector<::std::string> const & get_names() const { return names; }
+    ::std::vector<counts> const & get_values() const { return values; }
+
+    void report(::std::string const & title) {
+      if (names.size() == 0) return;
+
+      std::stringstream output;
+      std::ostream_iterator<std::string> nit(output, ",");
+      std::ostream_iterator<double> dit(output, ",");
+
+      auto row = [&output, &dit, &title](char const * label, ::std::vector<double> const & v) {
+        output << "[PERF] " << title << "\t" << label << "\t[,";
+        std::copy(v.begin(), v.end(), dit);
+        output << "]" << std::endl;
+      };
+
+      output << std::fixed;
+      output << "[PERF] " << title << "\theader\t[,";
+      std::copy(names.begin(), names.end(), nit);
+      output << "]" << std::endl;
+
+      output.precision(0);
+      for (int i = 0; i < NUM_EVENTS; ++i) row(metric_name(i), metric(i));
+
+      ::std::vector<double> ipcs = ipc(metric(INSTRUCTIONS), metric(CYCLES));
+      output.precision(3);
+      output << "[PERF] " << title << "\tipc\t[,";
+      std::copy(ipcs.begin(), ipcs.end(), dit);
+      output << "]";
+
+      fflush(stdout);
+      printf("%s\n", output.str().c_str());
+      fflush(stdout);
+
+      for (int i = 0; i < NUM_EVENTS; ++i) {
+        ::plog::BenchSink::append(title, "perf", names, metric_name(i), 1, ::plog::BenchSink::local(metric(i)));
+      }
+      ::plog::BenchSink::append(title, "perf", names, "ipc", 1, ::plog::BenchSink::local(ipcs));
+    }
+
+    /// collective.  counters that are unavailable on some rank show up as a negative min.
+    void report(::std::string const & title, ::mxx::comm const & comm) {
+      if (names.size() == 0) return;
+
+      int p = comm.size();
+      int rank = comm.rank();
+
+      ::std::vector<::plog::BenchSink::stats> s;
+      for (int i = 0; i < NUM_EVENTS; ++i) s.push_back(::plog::BenchSink::reduce(metric(i), comm));
+
+      // ipc of the whole phase, and the spread of the per rank ipc.
+      ::std::vector<double> ipcs = ipc(metric(INSTRUCTIONS), metric(CYCLES));
+      ::plog::BenchSink::stats ipc_stats = ::plog::BenchSink::reduce(ipcs, comm);
+
+      if (rank != 0) return;
+
+      std::stringstream output;
+      std::ostream_iterator<std::string> nit(output, ",");
+      std::ostream_iterator<double> dit(output, ",");
+
+      auto row = [&output, &dit, &title](::std::string const & label, ::std::vector<double> const & v) {
+        output << "[PERF] " << title << "\t" << label << "\t[,";
+        std::copy(v.begin(), v.end(), dit);
+        output << "]" << std::endl;
+      };
+
+      output << std::fixed;
+      output << "[PERF] " << "R " << rank << "/" << p << std::endl;
+
+      output << "[PERF] " << title << "\theader\t[,";
+      std::copy(names.begin(), names.end(), nit);
+      output << "]" << std::endl;
+
+      output.precision(0);
+      for (int i = 0; i < NUM_EVENTS; ++i) {
+        row(::std::string(metric_name(i)) + "_max", s[i].maxs);
+        row(::std::string(metric_name(i)) + "_mean", s[i].means);
+      }
+
+      output.precision(3);
+      row("ipc_min", ipc_stats.mins);
+      row("ipc_max", ipc_stats.maxs);
+      output << "[PERF] " << title << "\tipc_total\t[,";
+      ::std::vector<double> total_ipc = ipc(s[INSTRUCTIONS].means, s[CYCLES].means);
+      std::copy(total_ipc.begin(), total_ipc.end(), dit);
+      output << "]";
+
+      fflush(stdout);
+      printf("%s\n", output.str().c_str());
+      fflush(stdout);
+
+      for (int i = 0; i < NUM_EVENTS; ++i) {
+        ::plog::BenchSink::append(title, "perf", names, metric_name(i), p, s[i]);
+      }
+      ::plog::BenchSink::append(title, "perf", names, "ipc", p, ipc_stats);
+    }
+};
+
+} // end namespace plog
+
+#if BL_BENCHMARK_PERF == 1
+
+#define BL_PERF_INIT(title)       ::plog::PerfCounters title##_perf;
+#define BL_PERF_RESET(title)      do { title##_perf.reset(); } while (0)
+#define BL_PERF_START(title)      do { title##_perf.start(); } while (0)
+#define BL_PERF_END(title, name)  do { title##_perf.end(name); } while (0)
+#define BL_PERF_REPORT(title)     do { title##_perf.report(#title); } while (0)
+#define BL_PERF_REPORT_NAMED(title, name) do { title##_perf.report(name); } while (0)
+#define BL_PERF_REPORT_MPI(title, comm) do { title##_perf.report(#title, comm); } while (0)
+#define BL_PERF_REPORT_MPI_NAMED(title, name, comm) do { title##_perf.report(name, comm); } while (0)
+
+#else
+
+#define BL_PERF_INIT(title)
+#define BL_PERF_RESET(title)
+#define BL_PERF_START(title)
+#define BL_PERF_END(title, name)
+#define BL_PERF_REPORT(title)
+#define BL_PERF_REPORT_NAMED(title, name)
+#define BL_PERF_REPORT_MPI(title, comm)
+#define BL_PERF_REPORT_MPI_NAMED(title, name, comm)
+
+#endif
+
+#endif /* SRC_UTILS_PERF_COUNTERS_HPP_ */
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    task_pool.hpp
+ * @ingroup utils
+ * @brief   persistent work stealing thread pool for the short parallel loops of the library.
+ * @details an OpenMP parallel region per call wakes (or creates) its threads each time, and per thread buffers declared
+ *          in the region are allocated and freed each time.  with many small rounds, e.g. 1 per query batch, that
+ *          startup dominates.  the pool keeps its threads between calls:  an idle worker spins briefly, then sleeps on
+ *          a condition variable.
+ *
+ *          parallel_for(n, fn, nthreads, grain) splits [0, n) into chunks of grain indices, and gives each of the
+ *          nthreads participants (the calling thread is participant 0) a contiguous share of the chunks.  a participant
+ *          takes chunks from the front of its share, and when it runs out steals half of the remainder of another
+ *          share.  fn(begin, end, tid) is called for each chunk, with the id of the thread that runs it, so per thread
+ *          state indexed by tid needs no synchronization.  the same thread has the same tid in every call.
+ *
+ *          thread_scratch<T>() is a thread local T.  the pool's threads live as long as the pool, so a buffer kept
+ *          there keeps its capacity from one call to the next.
+ *
+ *          calls from inside fn, and calls with 1 thread, run sequentially on the calling thread.  concurrent calls
+ *          from different threads take turns.  an exception thrown by fn is rethrown by parallel_for once all
+ *          participants are done.  ::bliss::utils::task_pool::instance() is the pool of the library.  it starts
+ *          without workers and adds them when a call asks for more threads.
+ */
+#ifndef SRC_UTILS_TASK_POOL_HPP_
+#define SRC_UTILS_TASK_POOL_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>      // unique_ptr
+#include <exception>   // exception_ptr
+#include <algorithm>   // min, max
+#include <type_traits> // remove_reference
+#include <cstdint>     // uint64_t
+#include <cstddef>     // size_t
+
+namespace bliss {
+
+  namespace utils {
+
+    class task_pool {
+
+      protected:
+        /// the unclaimed chunks [lo, hi) of a participant, as (hi << 32) | lo, so the owner and thieves race on 1 word.
+        /// padded so that no 2 shares are on 1 cache line.
+        struct share {
+            ::std::atomic<uint64_t> range;
+            char padding[64 - sizeof(::std::atomic<uint64_t>)];
+            share() : range(0) {}
+        };
+
+        static constexpr uint64_t low_mask = 0xFFFFFFFFULL;
+        /// idle loops of a worker before it sleeps.
+        static constexpr int spin_count = 1 << 10;
+
+        /// workers, tid 1 .. size() - 1.
+        ::std::vector<::std::thread> workers;
+        ::std::unique_ptr<share[]> shares;
+        int nshares;
+        /// workers.size(), readable without the lock.
+        ::std::atomic<int> nworkers;
+
+        /// serializes calls.
+        ::std::mutex submit_mutex;
+
+        /// wakes the workers.
+        ::std::mutex wake_mutex;
+        ::std::condition_variable wake;
+        bool stop;
+
+        /// (round << 8 | participants) of the current call.  participants <= 255.
+        ::std::atomic<uint64_t> round;
+        /// participants of the current call that are not done.
+        ::std::atomic<int> remaining;
+
+        // the current call.  written before round is published, stable until remaining reaches 0.
+        void (*invoke)(void *, size_t, size_t, int);
+        void * context;
+        size_t n;
+        size_t grain;
+        ::std::exception_ptr error;
+        ::std::mutex error_mutex;
+
+        /// true while the thread runs a chunk of some pool.
+        static bool & in_task() {
+          static thread_local bool flag = false;
+          return flag;
+        }
+
+        static uint64_t pack(uint64_t const lo, uint64_t const hi) { return (hi << 32) | lo; }
+
+        /// take the next chunk of share s, from the front.
+        bool take(int const s, size_t & chunk) {
+          uint64_t cur = shares[s].range.load(::std::memory_order_acquire);
+          while ((cur & low_mask) < (cur >> 32)) {
+            if (shares[s].range.compare_exchange_weak(cur, cur + 1, ::std::memory_order_acq_rel)) {
+              chunk = cur & low_mask;
+              return true;
+            }
+          }
+          return false;
+        }
+
+        /// move the back half of share victim into share s, which is empty.
+        bool steal(int const s, int const victim) {
+          uint64_t cur = shares[victim].range.load(::std::memory_order_acquire);
+          while (true) {
+            uint64_t const lo = cur & low_mask, hi = cur >> 32;
+            if (lo >= hi) return false;
+            uint64_t const mid = hi - ::std::max((hi - lo) / 2, static_cast<uint64_t>(1));
+            if (shares[victim].range.compare_exchange_weak(cur, pack(lo, mid), ::std::memory_order_acq_rel)) {
+              shares[s].range.store(pack(mid, hi), ::std::memory_order_release);
+              return true;
+            }
+          }
+        }
+
+        /// run chunks until no participant has any left.
+        void participate(int const tid, int const np) {
+          in_task() = true;
+          try {
+            size_t chunk;
+            while (true) {
+              while (take(tid, chunk)) {
+                size_t const first = chunk * grain;
+                invoke(context, first, ::std::min(first + grain, n), tid);
+              }
+              bool stolen = false;
+              for (int i = 1; (i < np) && !stolen; ++i) {
+                stolen = steal(tid, (tid + i) % np);
+              }
+              if (!stolen) break;
+            }
+          } catch (...) {
+            ::std::lock_guard<::std::mutex> lock(error_mutex);
+            if (!error) error = ::std::current_exception();
+            // leave the remaining chunks of this share to the others.
+          }
+          in_task() = false;
+        }
+
+        /// seen is the last round published before the worker was created.
+        void worker_loop(int const tid, uint64_t seen) {
+          while (true) {
+            uint64_t r = round.load(::std::memory_order_acquire);
+            for (int i = 0; (r == seen) && (i < spin_count); ++i) {
+              ::std::this_thread::yield();
+              r = round.load(::std::memory_order_acquire);
+            }
+            if (r == seen) {
+              ::std::unique_lock<::std::mutex> lock(wake_mutex);
+              wake.wait(lock, [this, seen]() { return stop || (round.load(::std::memory_order_acquire) != seen); });
+              if (stop) return;
+              r = round.load(::std::memory_order_acquire);
+            }
+            seen = r;
+
+            int const np = static_cast<int>(r & 0xFF);
+            if (tid >= np) continue;
+
+            participate(tid, np);
+            remaining.fetch_sub(1, ::std::memory_order_acq_rel);
+          }
+        }
+
+        template <typename F>
+        static void invoke_fn(void * ctx, size_t const first, size_t const last, int const tid) {
+          (*static_cast<F *>(ctx))(first, last, tid);
+        }
+
+      public:
+        /// largest number of threads of a call.
+        static constexpr int max_threads = 255;
+
+        /// a pool of nthreads threads, including the calling thread.
+        explicit task_pool(int const nthreads = 1) :
+          nshares(0), nworkers(0), stop(false), round(0), remaining(0),
+          invoke(nullptr), context(nullptr), n(0), grain(1) {
+          reserve(nthreads);
+        }
+
+        task_pool(task_pool const &) = delete;
+        task_pool & operator=(task_pool const &) = delete;
+
+        ~task_pool() {
+          {
+            ::std::lock_guard<::std::mutex> lock(wake_mutex);
+            stop = true;
+          }
+          wake.notify_all();
+          for (auto & w : workers) w.join();
+        }
+
+        /// the pool of the library.
+        static task_pool & instance() {
+          static task_pool pool;
+          return pool;
+        }
+
+        /// the thread local T of the calling thread, default constructed on first use.
+        template <typename T>
+        static T & thread_scratch() {
+          static thread_local T scratch;
+          return scratch;
+        }
+
+        /// number of threads, including the caller.
+        int size() const {
+          return nworkers.load(::std::memory_order_acquire) + 1;
+        }
+
+        /// have at least nthreads threads, at most max_threads.
+        void reserve(int const nthreads) {
+          ::std::lock_guard<::std::mutex> lock(submit_mutex);
+          grow(nthreads);
+        }
+
+        /**
+         * @brief call fn(begin, end, tid) for chunks of grain indices that cover [0, _n), on nthreads threads.
+         * @details nthreads <= 0 is all threads of the pool.  returns when all chunks are done.  see file description.
+         */
+        template <typename F>
+        void parallel_for(size_t const _n, F && fn, int nthreads = 0, size_t _grain = 1) {
+          if (_n == 0) return;
+          _grain = ::std::max(_grain, static_cast<size_t>(1));
+          // chunk ids are 32 bit.
+          _grain = ::std::max(_grain, (_n + low_mask - 1) / low_mask);
+          size_t const nchunks = (_n + _grain - 1) / _grain;
+
+          if (in_task() || (nthreads == 1) || (nchunks == 1)) {
+            for (size_t first = 0; first < _n; first += _grain) fn(first, ::std::min(first + _grain, _n), 0);
+            return;
+          }
+
+          ::std::lock_guard<::std::mutex> lock(submit_mutex);
+          if (nthreads <= 0) nthreads = static_cast<int>(workers.size()) + 1;
+          grow(nthreads);
+          int const np = static_cast<int>(::std::min(static_cast<size_t>(::std::min(nthreads, max_threads)), nchunks));
+
+          using FT = typename ::std::remove_reference<F>::type;
+          invoke = &invoke_fn<FT>;
+          context = const_cast<void *>(static_cast<void const *>(&fn));
+          n = _n;
+          grain = _grain;
+          error = nullptr;
+          for (int i = 0; i < np; ++i) {
+            shares[i].range.store(pack(nchunks * i / np, nchunks * (i + 1) / np), ::std::memory_order_relaxed);
+          }
+          remaining.store(np - 1, ::std::memory_order_relaxed);
+
+          {
+            ::std::lock_guard<::std::mutex> wl(wake_mutex);
+            uint64_t const r = round.load(::std::memory_order_relaxed);
+            round.store((((r >> 8) + 1) << 8) | static_cast<uint64_t>(np), ::std::memory_order_release);
+          }
+          wake.notify_all();
+
+          participate(0, np);
+          while (remaining.load(::std::memory_order_acquire) != 0) ::std::this_thread::yield();
+
+          if (error) {
+            ::std::exception_ptr e = error;
+            error = nullptr;
+            ::std::rethrow_exception(e);
+          }
+        }
+
+        /// call fn(tid) once for each of tid in [0, nthreads), concurrently.  nthreads <= 0 is all threads of the pool.
+        /// unlike parallel_for, the tid is the index of the call, not necessarily that of the thread that makes it.
+        template <typename F>
+        void run(int nthreads, F && fn) {
+          if (nthreads <= 0) nthreads = in_task() ? 1 : size();
+          parallel_for(static_cast<size_t>(nthreads), [&fn](size_t const first, size_t const last, int const) {
+            for (size_t i = first; i < last; ++i) fn(static_cast<int>(i));
+          }, nthreads, 1);
+        }
+
+      protected:
+        /// add workers up to nthreads.  holds submit_mutex.  no call is in progress, so the workers are idle.
+        void grow(int nthreads) {
+          nthreads = ::std::min(::std::max(nthreads, 1), max_threads);
+          if (nthreads <= nshares) return;
+
+          ::std::unique_ptr<share[]> s(new share[nthreads]);
+          shares.swap(s);
+          nshares = nthreads;
+          for (int t = static_cast<int>(workers.size()) + 1; t < nthreads; ++t) {
+            workers.emplace_back(&task_pool::worker_loop, this, t, round.load(::std::memory_order_acquire));
+          }
+          nworkers.store(static_cast<int>(workers.size()), ::std::memory_order_release);
+        }
+    };
+
+  } // namespace utils
+} // namespace bliss
+
+#endif // SRC_UTILS_TASK_POOL_HPP_
@@ -33,7 +33,7 @@
 #include "utils/test/bit_test_common.hpp"
 
 
-//TESTS: Sequential, SWAR/BSWAP, SSSE3, AVX2 versions of bit reverse.
+//TESTS: Sequential, SWAR/BSWAP, SSSE3, AVX2, AVX512 versions of bit reverse.
 //TESTS: for each, test different input (drawing from a 32 byte array),
 //       different offsets, different bit group sizes, different word types, and different byte array lengths.
 //TESTS: reverse entire array via multiplel SWAR, SSSE3, and AVX2 calls.
@@ -155,6 +155,10 @@ TYPED_TEST_P(BitReverseWordBenchmark, reverse_word)
 #ifdef __AVX2__
   this->template word_test<__m256i, ::bliss::utils::bit_ops::BIT_REV_AVX2>("AVX m256i");
 #endif
+
+#ifdef __AVX512BW__
+  this->template word_test<__m512i, ::bliss::utils::bit_ops::BIT_REV_AVX512>("AVX512 m512i");
+#endif
 }
 
 // now register the test cases
@@ -192,7 +196,7 @@ class BitReverseRemainderBenchmark : public ::testing::Test {
 	::bliss::utils::bit_ops::bitgroup_ops<P2::bitsPerGroup, SIMD_TYPE> op;
 
 
-  	size_t step = (SIMD_TYPE < 2) ? 8 : (SIMD_TYPE == 2) ? 16 : 32;
+  	size_t step = (SIMD_TYPE < 2) ? 8 : (SIMD_TYPE == 2) ? 16 : (SIMD_TYPE == 4) ? 32 : 64;
 	size_t iters = BitReverseBenchmarkHelper<P2::bitsPerGroup>::iters * 16;
 
 	uint8_t BLISS_ALIGNED_ARRAY(out, 224, 32);
@@ -268,6 +272,9 @@ TYPED_TEST_P(BitReverseRemainderBenchmark, reverse_remainder)
 #ifdef __AVX2__
    this->template part_test<__m256i, ::bliss::utils::bit_ops::BIT_REV_AVX2>("avx2");
 #endif
+#ifdef __AVX512BW__
+   this->template part_test<__m512i, ::bliss::utils::bit_ops::BIT_REV_AVX512>("avx512");
+#endif
 }
 
 
@@ -359,6 +366,9 @@ TYPED_TEST_P(BitReverseArrayBenchmark, reverse_short_array)
 #ifdef __AVX2__
    this->template array_test<::bliss::utils::bit_ops::BIT_REV_AVX2>("avx2");
 #endif
+#ifdef __AVX512BW__
+   this->template array_test<::bliss::utils::bit_ops::BIT_REV_AVX512>("avx512");
+#endif
 }
 
 
@@ -449,6 +459,9 @@ TYPED_TEST_P(BitReverseFixedArrayBenchmark, reverse_fixed_array)
 #ifdef __AVX2__
    this->template array_test<::bliss::utils::bit_ops::BITREV_AVX2>("avx2");
 #endif
+#ifdef __AVX512BW__
+   this->template array_test<::bliss::utils::bit_ops::BITREV_AVX512>("avx512");
+#endif
 
 
 }
@@ -518,6 +531,14 @@ TEST(BitReverseInFixedByteArrayBenchmark, rev_byte)
     }
     BL_TIMER_END(bitrev, "avx2", iters);
 
+#ifdef __AVX512BW__
+    BL_TIMER_START(bitrev);
+    for (size_t iter = 0; iter < iters; iter += s) {
+      ::bliss::utils::bit_ops::template reverse_bits_in_byte<1, ::bliss::utils::bit_ops::BITREV_AVX512, 0>(data, data);  // input from 0 to 256. output from 128-256, then 0 to 128
+    }
+    BL_TIMER_END(bitrev, "avx512", iters);
+#endif
+
 
     BL_TIMER_REPORT(bitrev);
 }
@@ -224,6 +224,21 @@ class BitReverseTestHelper {
                         rev_arr, 32, bit_offset);
     }
 #endif
+
+#ifdef __AVX512BW__
+
+    bool is_reverse(__m512i const & orig, __m512i const & rev, uint8_t bit_offset = 0) {
+
+      uint8_t BLISS_ALIGNED_ARRAY(orig_arr, 64, 64);
+      uint8_t  BLISS_ALIGNED_ARRAY(rev_arr, 64, 64);
+
+      _mm512_store_si512((void*)orig_arr, orig);
+      _mm512_store_si512((void*)rev_arr, rev);
+
+      return is_reverse(orig_arr,
+                        rev_arr, 64, bit_offset);
+    }
+#endif
 };
 
 
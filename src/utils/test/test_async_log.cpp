@@ -0,0 +1,126 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_async_log.cpp
+ *   test the deferred and immediate formatting, the ring buffers, and the per-rank output of the buffered log engine.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdio>    // remove
+#include <cstring>   // strcpy
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "utils/async_log.hpp"
+
+namespace {
+  std::vector<std::string> read_lines(std::string const & filename) {
+    std::vector<std::string> lines;
+    std::ifstream ifs(filename);
+    std::string line;
+    while (std::getline(ifs, line)) lines.push_back(line);
+    return lines;
+  }
+
+  bool ends_with(std::string const & s, std::string const & suffix) {
+    return (s.size() >= suffix.size()) && (s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0);
+  }
+}
+
+TEST(AsyncLog, format)
+{
+  std::string prefix("bliss_test_async_log_format");
+  {
+    ::plog::AsyncLog log(prefix, 16, 1000000);
+    log.set_rank(3);
+
+    // numbers are stored and formatted in flush.
+    log.writef(4, "x = %d, y = %.2f, z = %lu", 7, 1.5, 42UL);
+
+    // strings are formatted at the call, since the buffer is reused.
+    char buffer[16];
+    strcpy(buffer, "before");
+    log.writef(1, "msg %s", buffer);
+    strcpy(buffer, "after");
+
+    log.write(2, std::string("stream"));
+    log.flush();
+    EXPECT_EQ(0UL, log.dropped());
+  }
+
+  std::vector<std::string> lines = read_lines(prefix + ".3.log");
+  ASSERT_EQ(3UL, lines.size());
+  EXPECT_TRUE(ends_with(lines[0], "[debug] x = 7, y = 1.50, z = 42"));
+  EXPECT_TRUE(ends_with(lines[1], "[error] msg before"));
+  EXPECT_TRUE(ends_with(lines[2], "[warn ] stream"));
+
+  remove((prefix + ".3.log").c_str());
+}
+
+TEST(AsyncLog, full_ring_drops)
+{
+  std::string prefix("bliss_test_async_log_drop");
+  {
+    // no timed flush during the test.
+    ::plog::AsyncLog log(prefix, 4, 1000000);
+    log.set_rank(0);
+    for (int i = 0; i < 10; ++i) log.writef(3, "record %d", i);
+    EXPECT_EQ(6UL, log.dropped());
+
+    // the space is reused after a flush.
+    log.flush();
+    log.writef(3, "record %d", 10);
+    log.flush();
+  }
+
+  std::vector<std::string> lines = read_lines(prefix + ".0.log");
+  ASSERT_EQ(5UL, lines.size());
+  EXPECT_TRUE(ends_with(lines[0], "record 0"));
+  EXPECT_TRUE(ends_with(lines[3], "record 3"));
+  EXPECT_TRUE(ends_with(lines[4], "record 10"));
+
+  remove((prefix + ".0.log").c_str());
+}
+
+TEST(AsyncLog, threads)
+{
+  std::string prefix("bliss_test_async_log_threads");
+  size_t const nthreads = 4;
+  size_t const per_thread = 1000;
+  {
+    // the background flush drains while the threads log, and the destructor writes the rest.
+    ::plog::AsyncLog log(prefix, 2 * per_thread, 1);
+    log.set_rank(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nthreads; ++t) {
+      threads.emplace_back([&log, t, per_thread]() {
+        for (size_t i = 0; i < per_thread; ++i) log.writef(4, "thread %lu record %lu", t, i);
+      });
+    }
+    for (auto & t : threads) t.join();
+    EXPECT_EQ(0UL, log.dropped());
+  }
+
+  std::vector<std::string> lines = read_lines(prefix + ".0.log");
+  EXPECT_EQ(nthreads * per_thread, lines.size());
+
+  remove((prefix + ".0.log").c_str());
+}
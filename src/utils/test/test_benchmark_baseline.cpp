@@ -0,0 +1,181 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_benchmark_baseline.cpp
+ *   test reading sink files and comparing them against a baseline.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdio>    // remove
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "utils/benchmark_baseline.hpp"
+
+using BB = ::plog::BenchBaseline;
+
+namespace {
+  BB::row make_row(std::string const & phase, std::string const & metric, double min, double max, int ranks = 4) {
+    BB::row r;
+    r.title = "build";
+    r.kind = (metric == "peak_bytes") ? "mem" : "time";
+    r.phase = phase;
+    r.metric = metric;
+    r.ranks = ranks;
+    r.min = min;
+    r.max = max;
+    r.mean = 0.5 * (min + max);
+    return r;
+  }
+
+  BB::diff const * find(std::vector<BB::diff> const & diffs, std::string const & phase, std::string const & metric) {
+    for (auto const & d : diffs) {
+      if ((d.metric == metric) && (d.key.find("| " + phase + " |") != std::string::npos)) return &d;
+    }
+    return nullptr;
+  }
+}
+
+TEST(BenchBaseline, read_json_and_csv)
+{
+  std::string jfn("test_benchmark_baseline.jsonl");
+  {
+    std::ofstream out(jfn);
+    out << "{\"title\":\"a \\\"q\\\"\",\"kind\":\"time\",\"index\":0,\"phase\":\"insert\",\"metric\":\"dur_s\",\"ranks\":4,"
+        << "\"min\":0.5,\"max\":1.5,\"mean\":1,\"stdev\":0.25}\n\n";
+  }
+  std::vector<BB::row> rows = BB::read(jfn);
+  ASSERT_EQ(1UL, rows.size());
+  EXPECT_EQ("a \"q\"", rows[0].title);
+  EXPECT_EQ("insert", rows[0].phase);
+  EXPECT_EQ("dur_s", rows[0].metric);
+  EXPECT_EQ(4, rows[0].ranks);
+  EXPECT_DOUBLE_EQ(0.5, rows[0].min);
+  EXPECT_DOUBLE_EQ(1.5, rows[0].max);
+  EXPECT_DOUBLE_EQ(0.25, rows[0].stdev);
+  std::remove(jfn.c_str());
+
+  std::string cfn("test_benchmark_baseline.csv");
+  {
+    std::ofstream out(cfn);
+    out << "title,kind,index,phase,metric,ranks,min,max,mean,stdev\n"
+        << "\"x,y\",mem,0,find,peak_bytes,2,100,200,150,50\n"
+        << "title,kind,index,phase,metric,ranks,min,max,mean,stdev\n"
+        << "x,time,1,find,dur_s,2,1,2,1.5,0.5\n";
+  }
+  rows = BB::read(cfn);
+  ASSERT_EQ(2UL, rows.size());
+  EXPECT_EQ("x,y", rows[0].title);
+  EXPECT_EQ("peak_bytes", rows[0].metric);
+  EXPECT_DOUBLE_EQ(200, rows[0].max);
+  EXPECT_EQ("dur_s", rows[1].metric);
+  EXPECT_EQ(2, rows[1].ranks);
+  std::remove(cfn.c_str());
+
+  EXPECT_THROW(BB::read("no_such_benchmark_file.jsonl"), std::runtime_error);
+}
+
+TEST(BenchBaseline, median_of_repeats)
+{
+  std::vector<BB::row> rows;
+  rows.push_back(make_row("insert", "dur_s", 0, 1.0));
+  rows.push_back(make_row("insert", "dur_s", 0, 9.0));   // an outlier
+  rows.push_back(make_row("insert", "dur_s", 0, 2.0));
+  rows.push_back(make_row("insert", "elem_per_s", 10.0, 99.0));
+  rows.push_back(make_row("insert", "elem_per_s", 20.0, 99.0));
+  rows.push_back(make_row("insert", "cpu_s", 0, 5.0));   // not compared
+
+  std::map<std::string, double> s = BB::summarize(rows);
+  ASSERT_EQ(2UL, s.size());
+  EXPECT_DOUBLE_EQ(2.0, s[rows[0].key()]);
+  EXPECT_DOUBLE_EQ(15.0, s[rows[3].key()]);
+}
+
+TEST(BenchBaseline, regressions)
+{
+  std::vector<BB::row> base, curr;
+  base.push_back(make_row("insert", "dur_s", 0, 1.0));
+  curr.push_back(make_row("insert", "dur_s", 0, 1.2));      // 20% slower
+  base.push_back(make_row("find", "dur_s", 0, 1.0));
+  curr.push_back(make_row("find", "dur_s", 0, 1.05));       // within 10%
+  base.push_back(make_row("insert", "elem_per_s", 100.0, 0));
+  curr.push_back(make_row("insert", "elem_per_s", 80.0, 0));   // 25% slower
+  base.push_back(make_row("insert", "peak_bytes", 0, 100e6));
+  curr.push_back(make_row("insert", "peak_bytes", 0, 104e6));  // within 5%
+  base.push_back(make_row("find", "peak_bytes", 0, 100e6));
+  curr.push_back(make_row("find", "peak_bytes", 0, 110e6));    // 10% more
+
+  std::vector<BB::diff> diffs = BB::compare(base, curr);
+  ASSERT_EQ(5UL, diffs.size());
+  EXPECT_EQ(3UL, BB::count_regressions(diffs));
+
+  EXPECT_TRUE(find(diffs, "insert", "dur_s")->regression);
+  EXPECT_NEAR(1.2, find(diffs, "insert", "dur_s")->slowdown, 1e-9);
+  EXPECT_FALSE(find(diffs, "find", "dur_s")->regression);
+  EXPECT_TRUE(find(diffs, "insert", "elem_per_s")->regression);
+  EXPECT_NEAR(1.25, find(diffs, "insert", "elem_per_s")->slowdown, 1e-9);
+  EXPECT_FALSE(find(diffs, "insert", "peak_bytes")->regression);
+  EXPECT_TRUE(find(diffs, "find", "peak_bytes")->regression);
+
+  // looser tolerances.
+  BB::options opt;
+  opt.time_tolerance = 0.5;
+  opt.mem_tolerance = 0.5;
+  EXPECT_EQ(0UL, BB::count_regressions(BB::compare(base, curr, opt)));
+
+  // faster is not a regression.
+  EXPECT_EQ(0UL, BB::count_regressions(BB::compare(curr, curr)));
+  std::vector<BB::diff> better = BB::compare(curr, base);
+  EXPECT_EQ(0UL, BB::count_regressions(better));
+  EXPECT_LT(find(better, "insert", "dur_s")->slowdown, 1.0);
+}
+
+TEST(BenchBaseline, noise_and_unmatched)
+{
+  std::vector<BB::row> base, curr;
+  base.push_back(make_row("tiny", "dur_s", 0, 0.001));
+  curr.push_back(make_row("tiny", "dur_s", 0, 0.005));       // 5x, but under min_seconds
+  base.push_back(make_row("small", "peak_bytes", 0, 1000));
+  curr.push_back(make_row("small", "peak_bytes", 0, 5000));  // under min_bytes
+  base.push_back(make_row("gone", "dur_s", 0, 1.0));
+  curr.push_back(make_row("added", "dur_s", 0, 1.0));
+  base.push_back(make_row("insert", "dur_s", 0, 1.0, 4));
+  curr.push_back(make_row("insert", "dur_s", 0, 2.0, 8));    // other rank count:  a different key
+
+  std::vector<BB::diff> diffs = BB::compare(base, curr);
+  EXPECT_EQ(0UL, BB::count_regressions(diffs));
+  EXPECT_FALSE(find(diffs, "tiny", "dur_s")->judged);
+  EXPECT_FALSE(find(diffs, "small", "peak_bytes")->judged);
+
+  BB::diff const * gone = find(diffs, "gone", "dur_s");
+  ASSERT_NE(nullptr, gone);
+  EXPECT_TRUE(gone->in_baseline);
+  EXPECT_FALSE(gone->in_current);
+  BB::diff const * added = find(diffs, "added", "dur_s");
+  ASSERT_NE(nullptr, added);
+  EXPECT_FALSE(added->in_baseline);
+  EXPECT_TRUE(added->in_current);
+
+  std::string rep = BB::report(diffs);
+  EXPECT_NE(std::string::npos, rep.find("missing"));
+  EXPECT_NE(std::string::npos, rep.find("new"));
+  EXPECT_EQ(std::string::npos, rep.find("noise"));
+  EXPECT_NE(std::string::npos, BB::report(diffs, true).find("noise"));
+}
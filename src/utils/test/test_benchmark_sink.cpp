@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_benchmark_sink.cpp
+ *   test the CSV and JSON lines rows appended by the timer and memory reports.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdlib>   // setenv
+#include <cstdio>    // remove
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "utils/timer.hpp"
+#include "utils/memory_usage.hpp"
+
+class BenchSinkTest : public ::testing::Test {
+  protected:
+    std::string filename;
+
+    void use(std::string const & fn) {
+      filename = fn;
+      std::remove(filename.c_str());
+      setenv("BL_BENCH_FILE", filename.c_str(), 1);
+    }
+
+    virtual void TearDown() {
+      unsetenv("BL_BENCH_FILE");
+      std::remove(filename.c_str());
+    }
+
+    std::vector<std::string> lines() const {
+      std::ifstream f(filename);
+      std::vector<std::string> result;
+      std::string line;
+      while (std::getline(f, line)) result.push_back(line);
+      return result;
+    }
+};
+
+TEST_F(BenchSinkTest, disabled)
+{
+  use("test_benchmark_sink_disabled.csv");
+  unsetenv("BL_BENCH_FILE");
+
+  ::plog::Timer t;
+  t.start();
+  t.end("phase", 10);
+  t.report("disabled");
+
+  EXPECT_EQ(0UL, lines().size());
+}
+
+TEST_F(BenchSinkTest, csv)
+{
+  use("test_benchmark_sink.csv");
+
+  ::plog::Timer t;
+  t.start();
+  t.end("read", 100);
+  t.start();
+  t.end("sort,unique", 50);
+  t.report("csv");
+
+  // header, then 4 metrics for each of the 2 phases.
+  std::vector<std::string> rows = lines();
+  ASSERT_EQ(9UL, rows.size());
+  EXPECT_EQ("title,kind,index,phase,metric,ranks,min,max,mean,stdev", rows[0]);
+  EXPECT_EQ(0UL, rows[1].find("csv,time,0,read,dur_s,1,"));
+  EXPECT_EQ(0UL, rows[2].find("csv,time,1,\"sort,unique\",dur_s,1,"));
+  EXPECT_EQ(0UL, rows[5].find("csv,time,0,read,count,1,100,100,100,0"));
+
+  // appends, without a second header.
+  t.report("csv");
+  EXPECT_EQ(17UL, lines().size());
+}
+
+TEST_F(BenchSinkTest, json)
+{
+  use("test_benchmark_sink.json");
+
+  ::plog::MemUsage m;
+  m.mark("begin");
+  std::vector<char> buffer(1 << 24, 1);
+  m.mark("alloc");
+  m.report("json");
+
+  // 4 metrics for each of the 2 marks.
+  std::vector<std::string> rows = lines();
+  ASSERT_EQ(8UL, rows.size());
+  EXPECT_EQ(0UL, rows[0].find("{\"title\":\"json\",\"kind\":\"mem\",\"index\":0,\"phase\":\"begin\",\"metric\":\"curr_bytes\",\"ranks\":1,"));
+  EXPECT_EQ(0UL, rows[5].find("{\"title\":\"json\",\"kind\":\"mem\",\"index\":1,\"phase\":\"alloc\",\"metric\":\"delta_bytes\""));
+  EXPECT_EQ('}', rows[5].back());
+  EXPECT_EQ(1, buffer[12345]);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "utils/bit_ops.hpp"
+
+
+// pack_bytes / unpack_bytes against a loop over the bytes.
+template <unsigned int BITS>
+void check_pack_bytes() {
+  std::mt19937_64 gen(23);
+  for (int t = 0; t < 10000; ++t) {
+    uint64_t x = gen();
+
+    uint64_t packed = 0;
+    for (unsigned int i = 0; i < 8; ++i)
+      packed |= ((x >> (i * 8)) & ((1ULL << BITS) - 1)) << (i * BITS);
+    ASSERT_EQ(packed, ::bliss::utils::bit_ops::pack_bytes<BITS>(x));
+    ASSERT_EQ(packed, (BITS == 2) ? ::bliss::utils::bit_ops::detail::pack_bytes_2(x) :
+                                    ::bliss::utils::bit_ops::detail::pack_bytes_4(x));
+
+    uint64_t unpacked = 0;
+    for (unsigned int i = 0; i < 8; ++i)
+      unpacked |= ((x >> (i * BITS)) & ((1ULL << BITS) - 1)) << (i * 8);
+    ASSERT_EQ(unpacked, ::bliss::utils::bit_ops::unpack_bytes<BITS>(x));
+    ASSERT_EQ(unpacked, (BITS == 2) ? ::bliss::utils::bit_ops::detail::unpack_bytes_2(x) :
+                                      ::bliss::utils::bit_ops::detail::unpack_bytes_4(x));
+
+    ASSERT_EQ(packed, ::bliss::utils::bit_ops::pack_bytes<BITS>(::bliss::utils::bit_ops::unpack_bytes<BITS>(packed)));
+  }
+}
+
+TEST(BitOpsPack, pack_bytes_2)
+{
+  check_pack_bytes<2>();
+}
+
+TEST(BitOpsPack, pack_bytes_4)
+{
+  check_pack_bytes<4>();
+}
+
+TEST(BitOpsPack, dna16_dna)
+{
+  std::mt19937_64 gen(23);
+  for (int t = 0; t < 10000; ++t) {
+    uint32_t dna = static_cast<uint32_t>(gen());
+
+    uint64_t dna16 = 0;
+    for (unsigned int i = 0; i < 16; ++i)
+      dna16 |= (1ULL << ((dna >> (i * 2)) & 0x3)) << (i * 4);
+
+    ASSERT_EQ(dna16, ::bliss::utils::bit_ops::dna_to_dna16(dna));
+    ASSERT_EQ(dna, ::bliss::utils::bit_ops::dna16_to_dna(dna16));
+  }
+}
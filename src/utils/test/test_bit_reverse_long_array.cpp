@@ -65,6 +65,21 @@ TYPED_TEST_P(BitReverseLongArrayTest, reverse_long_array)
         }
 
         EXPECT_TRUE(same);
+
+#ifdef __AVX512BW__
+        memset(out, 0, 128);
+
+        bliss::utils::bit_ops::reverse<TypeParam::bitsPerGroup, bliss::utils::bit_ops::BIT_REV_AVX512>(out, this->helper.input + k, i);
+
+        same = this->is_reverse(this->helper.input + k, out, i);
+
+        if (!same) {
+
+          printf("avx512 array size = %d\n", i);
+        }
+
+        EXPECT_TRUE(same);
+#endif
       }
   }
 }
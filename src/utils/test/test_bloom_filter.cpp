@@ -0,0 +1,93 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cmath>
+
+#include "utils/bloom_filter.hpp"
+
+
+class BloomFilterTest : public ::testing::TestWithParam<size_t> {};
+
+
+// 10 bits per key.  false positive rate should be about 0.8%.
+TEST_P(BloomFilterTest, contains)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::bloom_filter bf;
+  EXPECT_TRUE(bf.empty());
+  EXPECT_FALSE(bf.contains(::bliss::utils::mix64(0)));
+
+  bf.resize(n * 10, ::bliss::utils::bloom_filter::optimal_hashes(10.0));
+  EXPECT_FALSE(bf.empty());
+  for (size_t i = 0; i < n; ++i) {
+    bf.insert(::bliss::utils::mix64(i));
+  }
+
+  // no false negatives
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_TRUE(bf.contains(::bliss::utils::mix64(i)));
+  }
+
+  size_t fp = 0;
+  for (size_t i = n; i < 2 * n; ++i) {
+    if (bf.contains(::bliss::utils::mix64(i))) ++fp;
+  }
+  EXPECT_LT(fp, n / 50 + 2);
+}
+
+TEST_P(BloomFilterTest, merge)
+{
+  size_t n = GetParam();
+
+  // 2 halves, merged, as from 2 processes.
+  ::bliss::utils::bloom_filter first, second;
+  first.resize(n * 8, 6);
+  second.resize(n * 8, 6);
+  for (size_t i = 0; i < n; ++i) {
+    if (i & 1) first.insert(::bliss::utils::mix64(i));
+    else second.insert(::bliss::utils::mix64(i));
+  }
+  first.merge(second);
+
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_TRUE(first.contains(::bliss::utils::mix64(i)));
+  }
+
+  first.clear();
+  EXPECT_FALSE(first.contains(::bliss::utils::mix64(1)));
+  first.reset();
+  EXPECT_TRUE(first.empty());
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, BloomFilterTest, ::testing::Values(
+    10UL, 1000UL, 100000UL
+    ));
+
+TEST(BloomFilter, optimal_hashes)
+{
+  EXPECT_EQ(1, ::bliss::utils::bloom_filter::optimal_hashes(0.5));
+  EXPECT_EQ(7, ::bliss::utils::bloom_filter::optimal_hashes(10.0));
+  EXPECT_EQ(16, ::bliss::utils::bloom_filter::optimal_hashes(100.0));
+
+  ::bliss::utils::bloom_filter bf;
+  bf.resize(100, 3);
+  EXPECT_EQ(128UL, bf.bit_count());
+}
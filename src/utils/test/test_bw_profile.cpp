@@ -0,0 +1,93 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_bw_profile.cpp
+ *   test the bandwidth profile cache file and the bandwidth node order.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>  // remove
+
+#include "bliss-config.hpp"
+#include "utils/mxx_fast_comm.hpp"
+
+TEST(BwProfile, cache_round_trip)
+{
+  std::string name(PROJ_BIN_DIR);
+  name.append("/bw_profile_test.cache");
+
+  ::bliss::mxx::bw_profile p;
+  p.hosts = {"node-a", "node-b", "node-c"};
+  p.bw = {0.0, 1.5, 2.25,
+          1.25, 0.0, 3.0,
+          2.0, 3.5, 0.0};
+  ::bliss::mxx::write_bw_profile(name, p);
+
+  ::bliss::mxx::bw_profile q;
+  ASSERT_TRUE(::bliss::mxx::read_bw_profile(name, 3600, q));
+  EXPECT_EQ(p.hosts, q.hosts);
+  EXPECT_EQ(p.bw, q.bw);
+  EXPECT_EQ(3.0, q(1, 2));
+  EXPECT_EQ(std::vector<double>({2.0, 3.5, 0.0}), q.row(2));
+
+  ::remove(name.c_str());
+  EXPECT_FALSE(::bliss::mxx::read_bw_profile(name, 3600, q));
+}
+
+TEST(BwProfile, stale_or_malformed)
+{
+  std::string name(PROJ_BIN_DIR);
+  name.append("/bw_profile_test_stale.cache");
+
+  ::bliss::mxx::bw_profile q;
+  {
+    // written in 1970.
+    std::ofstream out(name.c_str());
+    out << "BLISSBW 1 100 1\nnode-a\n0\n";
+  }
+  EXPECT_FALSE(::bliss::mxx::read_bw_profile(name, 3600, q));
+  {
+    std::ofstream out(name.c_str());
+    out << "BLISSBW 1 " << ::time(nullptr) << " 2\nnode-a\nnode-b\n0 1 1\n";
+  }
+  EXPECT_FALSE(::bliss::mxx::read_bw_profile(name, 3600, q));
+
+  ::remove(name.c_str());
+}
+
+TEST(BwProfile, node_order)
+{
+  // node 0 is fastest to 2, 2 to 3, then 1 is left.  the link speed is the slower direction.
+  ::bliss::mxx::bw_profile p;
+  p.hosts = {"a", "b", "c", "d"};
+  p.bw = {0, 5, 9, 1,
+          5, 0, 2, 2,
+          9, 2, 0, 8,
+          1, 2, 8, 0};
+  std::vector<size_t> order = ::bliss::mxx::bandwidth_node_order(p);
+  EXPECT_EQ(std::vector<size_t>({0, 2, 3, 1}), order);
+
+  // asymmetric:  0 -> 1 is fast, but 1 -> 0 is slow.
+  p.bw[1 * 4 + 0] = 0.5;
+  order = ::bliss::mxx::bandwidth_node_order(p);
+  EXPECT_EQ(std::vector<size_t>({0, 2, 3, 1}), order);
+}
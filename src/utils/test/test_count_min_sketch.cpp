@@ -0,0 +1,85 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/count_min_sketch.hpp"
+
+
+class CountMinSketchTest : public ::testing::TestWithParam<size_t> {};
+
+
+// value i is added (i % 4) + 1 times.
+TEST_P(CountMinSketchTest, estimate)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::count_min_sketch<4> cms(n);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t r = 0; r <= (i % 4); ++r) {
+      cms.update(::bliss::utils::mix64(i));
+    }
+  }
+
+  // never undercounts.  with width n, some overestimate.
+  size_t over = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t est = cms.estimate(::bliss::utils::mix64(i));
+    ASSERT_GE(est, (i % 4) + 1);
+    if (est > (i % 4) + 1) ++over;
+  }
+  EXPECT_LT(over, n / 10 + 1);
+}
+
+TEST_P(CountMinSketchTest, update)
+{
+  size_t n = GetParam();
+
+  // the updated estimate is returned.  singletons are mostly seen as new.
+  ::bliss::utils::count_min_sketch<4> cms(n * 2);
+  size_t seen = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (cms.update(::bliss::utils::mix64(i)) > 1) ++seen;
+  }
+  EXPECT_LT(seen, n / 20 + 1);
+
+  uint8_t est;
+  for (size_t i = 0; i < n; ++i) {
+    est = cms.estimate(::bliss::utils::mix64(i));
+    ASSERT_EQ(est + 1, cms.update(::bliss::utils::mix64(i)));
+  }
+
+  cms.clear();
+  EXPECT_EQ(0, cms.estimate(::bliss::utils::mix64(0)));
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, CountMinSketchTest, ::testing::Values(
+    10UL, 1000UL, 100000UL
+    ));
+
+TEST(CountMinSketch, saturate)
+{
+  ::bliss::utils::count_min_sketch<2> cms(16);
+  EXPECT_EQ(16UL, cms.width());
+  EXPECT_EQ(32UL, cms.size_in_bytes());
+  for (size_t i = 0; i < 300; ++i) cms.update(12345);
+  EXPECT_EQ(255, cms.estimate(12345));
+  EXPECT_EQ(255, cms.update(12345));
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include "utils/cpu_features.hpp"
+
+
+TEST(CpuFeatures, compile_time_isa_is_used)
+{
+  // an ISA enabled on the command line is always used.
+#if defined(__SSSE3__)
+  EXPECT_TRUE(::bliss::utils::cpu::use_ssse3());
+#endif
+#if defined(__SSE4_2__)
+  EXPECT_TRUE(::bliss::utils::cpu::use_sse4_2());
+#endif
+#if defined(__AVX2__)
+  EXPECT_TRUE(::bliss::utils::cpu::use_avx2());
+#endif
+#if defined(__BMI2__)
+  EXPECT_TRUE(::bliss::utils::cpu::use_bmi2());
+#endif
+}
+
+TEST(CpuFeatures, runtime_matches_cpuid)
+{
+#if defined(BL_SIMD_DISPATCH_ENABLED)
+  // the ISAs imply each other, so use is monotonic.
+  if (::bliss::utils::cpu::use_avx2()) EXPECT_TRUE(::bliss::utils::cpu::use_sse4_2());
+  if (::bliss::utils::cpu::use_sse4_2()) EXPECT_TRUE(::bliss::utils::cpu::use_ssse3());
+
+  EXPECT_EQ(__builtin_cpu_supports("avx2") != 0, ::bliss::utils::cpu::use_avx2());
+  EXPECT_EQ(__builtin_cpu_supports("bmi2") != 0, ::bliss::utils::cpu::use_bmi2());
+#else
+  // without dispatch, only the compile time ISAs are used.
+#if !defined(__AVX2__)
+  EXPECT_FALSE(::bliss::utils::cpu::use_avx2());
+#endif
+#endif
+}
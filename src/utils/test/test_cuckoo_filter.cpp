@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "utils/cuckoo_filter.hpp"
+
+
+class CuckooFilterTest : public ::testing::TestWithParam<size_t> {};
+
+
+// 13 bit fingerprints.  false positive rate should be about 0.1%.
+TEST_P(CuckooFilterTest, contains)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::cuckoo_filter<> cf;
+  EXPECT_TRUE(cf.empty());
+  EXPECT_FALSE(cf.contains(::bliss::utils::mix64(0)));
+
+  cf.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    cf.insert(::bliss::utils::mix64(i));
+  }
+  EXPECT_LE(cf.bit_count(), n * 14 + 64);
+
+  // no false negatives, and reinserting is not new.
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_TRUE(cf.contains(::bliss::utils::mix64(i)));
+    ASSERT_EQ(1UL, cf.count(::bliss::utils::mix64(i)));
+  }
+  size_t before = cf.size();
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_FALSE(cf.insert(::bliss::utils::mix64(i)));
+  }
+  EXPECT_EQ(before, cf.size());
+
+  size_t fp = 0;
+  for (size_t i = n; i < 11 * n; ++i) {
+    if (cf.contains(::bliss::utils::mix64(i))) ++fp;
+  }
+  EXPECT_LT(fp, n / 50 + 2);   // 10n queries, < 0.2%
+}
+
+TEST_P(CuckooFilterTest, erase)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::cuckoo_filter<12> cf;
+  cf.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    cf.insert(::bliss::utils::mix64(i));
+  }
+  // keys that share an entry with an erased key are gone too.  that is about as rare as a false positive.
+  size_t missed = 0;
+  for (size_t i = 0; i < n; i += 2) {
+    if (!cf.erase(::bliss::utils::mix64(i))) ++missed;
+  }
+  EXPECT_LT(missed, n / 200 + 2);
+  size_t fn = 0;
+  for (size_t i = 1; i < n; i += 2) {
+    if (!cf.contains(::bliss::utils::mix64(i))) ++fn;
+  }
+  EXPECT_LT(fn, n / 200 + 2);
+
+  cf.clear();
+  EXPECT_TRUE(cf.empty());
+  EXPECT_FALSE(cf.contains(::bliss::utils::mix64(1)));
+  cf.reset();
+  EXPECT_EQ(0UL, cf.capacity());
+}
+
+TEST_P(CuckooFilterTest, counters)
+{
+  size_t n = GetParam();
+
+  // 3 bit counters, up to 8.
+  ::bliss::utils::cuckoo_filter<13, 3> cf;
+  cf.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j <= i % 10; ++j) cf.insert(::bliss::utils::mix64(i));
+  }
+  EXPECT_LE(n - n / 200, cf.size());   // colliding keys share an entry.
+
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_LE(std::min(i % 10 + 1, 8UL), cf.count(::bliss::utils::mix64(i)));
+  }
+
+  // erase decrements, so shared entries stay.
+  size_t before = cf.size();
+  cf.erase(::bliss::utils::mix64(1));
+  EXPECT_LE(1UL, cf.count(::bliss::utils::mix64(1)));
+  EXPECT_EQ(before, cf.size());
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j <= i % 10; ++j) cf.erase(::bliss::utils::mix64(i));
+  }
+  EXPECT_GT(before, cf.size());
+}
+
+// more keys than it was sized for.  the overflow goes to the stash, with no false negatives.
+TEST_P(CuckooFilterTest, overfull)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::cuckoo_filter<> cf;
+  cf.resize(n * 3 / 4);
+  for (size_t i = 0; i < n; ++i) {
+    cf.insert(::bliss::utils::mix64(i));
+  }
+  EXPECT_LT(0UL, cf.stash_size());
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_TRUE(cf.contains(::bliss::utils::mix64(i)));
+  }
+  for (size_t i = 0; i < n; ++i) {
+    cf.erase(::bliss::utils::mix64(i));
+  }
+  EXPECT_TRUE(cf.empty());
+  EXPECT_EQ(0UL, cf.stash_size());
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, CuckooFilterTest, ::testing::Values(
+    10UL, 1000UL, 100000UL
+    ));
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_event_trace.cpp
+ *   test the ring buffers, sampling, and Chrome trace output of the event tracer.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <cstdio>    // remove
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "utils/event_trace.hpp"
+
+TEST(EventTrace, nested)
+{
+  ::plog::EventTrace trace(16);
+  trace.begin("outer");
+  trace.begin("inner");
+  trace.end();
+  trace.end();
+  // unmatched end is ignored.
+  trace.end();
+
+  EXPECT_EQ(2UL, trace.size());
+  EXPECT_EQ(0UL, trace.dropped());
+}
+
+TEST(EventTrace, ring)
+{
+  ::plog::EventTrace trace(8);
+  for (int i = 0; i < 20; ++i) {
+    trace.begin("loop");
+    trace.end();
+  }
+  EXPECT_EQ(8UL, trace.size());
+  EXPECT_EQ(12UL, trace.dropped());
+
+  trace.clear();
+  EXPECT_EQ(0UL, trace.size());
+}
+
+TEST(EventTrace, sample)
+{
+  ::plog::EventTrace trace(64, 4);
+  for (int i = 0; i < 20; ++i) {
+    trace.begin("loop");
+    trace.end();
+  }
+  EXPECT_EQ(5UL, trace.size());
+}
+
+TEST(EventTrace, threads_and_dump)
+{
+  ::plog::EventTrace trace(64);
+  trace.begin("main");
+  std::thread t([&trace](){
+    trace.begin("worker");
+    trace.end();
+  });
+  t.join();
+  trace.end();
+  EXPECT_EQ(2UL, trace.size());
+
+  std::string filename("test_event_trace.json");
+  ASSERT_TRUE(trace.dump(filename, 3));
+
+  std::ifstream f(filename);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  std::string json = ss.str();
+  std::remove(filename.c_str());
+
+  EXPECT_EQ(0UL, json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, json.find("{\"name\":\"main\",\"ph\":\"X\",\"pid\":3,\"tid\":0,"));
+  EXPECT_NE(std::string::npos, json.find("{\"name\":\"worker\",\"ph\":\"X\",\"pid\":3,\"tid\":1,"));
+  EXPECT_NE(std::string::npos, json.find("\"dropped_events\":0"));
+  EXPECT_EQ('}', json[json.size() - 2]);
+}
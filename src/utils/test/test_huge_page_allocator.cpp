@@ -0,0 +1,69 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <functional>
+
+#include "utils/huge_page_allocator.hpp"
+
+
+template <typename A>
+class HugePageAllocatorTest : public ::testing::Test {};
+
+typedef ::testing::Types<::bliss::utils::huge_page_allocator<uint64_t>,
+    ::bliss::utils::huge_page_allocator<uint64_t, true> > HugePageAllocatorTestTypes;
+TYPED_TEST_CASE(HugePageAllocatorTest, HugePageAllocatorTestTypes);
+
+
+TYPED_TEST(HugePageAllocatorTest, small_and_large)
+{
+  TypeParam alloc;
+  size_t large = 3 * (TypeParam::huge_page_size / sizeof(uint64_t)) + 5;
+
+  for (size_t n : {1UL, 1000UL, large}) {
+    uint64_t * p = alloc.allocate(n);
+    ASSERT_TRUE(p != nullptr);
+#if defined(__linux__)
+    if (n == large) {
+      EXPECT_EQ(0UL, reinterpret_cast<uintptr_t>(p) % TypeParam::huge_page_size);
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) p[i] = i;
+    for (size_t i = 0; i < n; i += 997) EXPECT_EQ(i, p[i]);
+    alloc.deallocate(p, n);
+  }
+}
+
+TYPED_TEST(HugePageAllocatorTest, containers)
+{
+  // vector growth crosses the huge page threshold.
+  std::vector<uint64_t, TypeParam> v;
+  for (uint64_t i = 0; i < (1UL << 20); ++i) v.push_back(i);
+  for (uint64_t i = 0; i < v.size(); i += 1001) EXPECT_EQ(i, v[i]);
+
+  // rebind to node and bucket types.
+  using PairAlloc = typename TypeParam::template rebind<std::pair<const uint64_t, uint64_t> >::other;
+  std::unordered_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PairAlloc> m;
+  for (uint64_t i = 0; i < 300000; ++i) m[i] = i * 2;
+  EXPECT_EQ(300000UL, m.size());
+  EXPECT_EQ(2000UL, m[1000]);
+}
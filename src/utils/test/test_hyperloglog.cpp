@@ -0,0 +1,66 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cmath>
+#include <random>
+
+#include "utils/hyperloglog.hpp"
+
+
+class HyperLogLogTest : public ::testing::TestWithParam<size_t> {};
+
+
+// each distinct value is added 3 times.  with precision 12, standard error is 1.6%, so 6% is about 4 sigma.
+TEST_P(HyperLogLogTest, estimate)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::hyperloglog<12> hll;
+  for (size_t r = 0; r < 3; ++r) {
+    for (size_t i = 0; i < n; ++i) {
+      hll.update(::bliss::utils::mix64(i));
+    }
+  }
+
+  double est = hll.estimate();
+  EXPECT_LT(::std::fabs(est - static_cast<double>(n)), 0.06 * static_cast<double>(n) + 1.0) << "estimate " << est;
+}
+
+TEST_P(HyperLogLogTest, merge)
+{
+  size_t n = GetParam();
+
+  // 2 overlapping halves
+  ::bliss::utils::hyperloglog<12> first, second;
+  for (size_t i = 0; i < (n * 2) / 3; ++i) {
+    first.update(::bliss::utils::mix64(i));
+  }
+  for (size_t i = n / 3; i < n; ++i) {
+    second.update(::bliss::utils::mix64(i));
+  }
+  first.merge(second);
+
+  double est = first.estimate();
+  EXPECT_LT(::std::fabs(est - static_cast<double>(n)), 0.06 * static_cast<double>(n) + 1.0) << "estimate " << est;
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, HyperLogLogTest, ::testing::Values(
+    10UL, 1000UL, 10000UL, 100000UL, 1000000UL
+    ));
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include "bliss-config.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "utils/kmer_generator.hpp"
+
+
+using KmerType = ::bliss::common::Kmer<21, ::bliss::common::DNA, uint64_t>;
+
+
+TEST(KmerGeneratorTest, zipf)
+{
+  std::vector<uint64_t> values;
+  ::bliss::utils::generate_zipf(values, 100000, 1000, 1.0);
+  ASSERT_EQ(100000UL, values.size());
+
+  std::unordered_map<uint64_t, size_t> counts;
+  for (auto v : values) ++counts[v];
+  EXPECT_LE(counts.size(), 1000UL);
+
+  // with s = 1 the most frequent value is about 1 / H(1000) ~ 13% of the draws.
+  std::vector<size_t> freq;
+  for (auto const & c : counts) freq.emplace_back(c.second);
+  std::sort(freq.begin(), freq.end(), std::greater<size_t>());
+  EXPECT_GT(freq[0], 10000UL);
+  EXPECT_LT(freq[0], 17000UL);
+  EXPECT_GT(freq[0], 5 * freq[9]);
+
+  // deterministic for a seed.
+  std::vector<uint64_t> again;
+  ::bliss::utils::generate_zipf(again, 100000, 1000, 1.0);
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), again.begin()));
+}
+
+TEST(KmerGeneratorTest, duplicates)
+{
+  std::vector<KmerType> kmers;
+  ::bliss::utils::generate_zipf(kmers, 100000, 100000, 0.0, 0.3, 7);
+  ASSERT_EQ(100000UL, kmers.size());
+
+  size_t adjacent = 0;
+  for (size_t i = 1; i < kmers.size(); ++i) {
+    if (kmers[i] == kmers[i - 1]) ++adjacent;
+  }
+  EXPECT_GT(adjacent, 28000UL);
+  EXPECT_LT(adjacent, 32000UL);
+}
+
+TEST(KmerGeneratorTest, simulate_reads)
+{
+  std::string filename(PROJ_SRC_DIR);
+  filename.append("/test/data/test.medium.fasta");
+  auto ref = ::bliss::utils::load_reference(filename);
+  ASSERT_GT(ref.size(), 0UL);
+
+  // error free reads are substrings of the reference, or of its reverse complement.
+  auto reads = ::bliss::utils::simulate_reads(ref, 50, 30, 0.0);
+  ASSERT_EQ(50UL, reads.size());
+  for (auto const & r : reads) {
+    ASSERT_EQ(30UL, r.size());
+    std::string rc(r.rbegin(), r.rend());
+    for (auto & c : rc) c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : (c == 'T') ? 'A' : c;
+    bool found = false;
+    for (auto const & s : ref) {
+      if ((s.find(r) != std::string::npos) || (s.find(rc) != std::string::npos)) {
+        found = true;
+        break;
+      }
+    }
+    EXPECT_TRUE(found) << r;
+  }
+
+  // k-mers of reads without other characters.
+  std::vector<KmerType> kmers;
+  ::bliss::utils::kmers_from_reads(reads, kmers);
+  size_t expected = 0;
+  for (auto const & r : reads) {
+    if (r.find_first_not_of("ACGT") == std::string::npos) expected += r.size() - KmerType::size + 1;
+  }
+  EXPECT_LE(expected, kmers.size());
+
+  // errors change about error_rate of the bases.
+  auto clean = ::bliss::utils::simulate_reads(ref, 200, 100, 0.0, 11);
+  auto noisy = ::bliss::utils::simulate_reads(ref, 200, 100, 0.05, 11);
+  size_t diffs = 0;
+  for (size_t i = 0; i < clean.size(); ++i) {
+    for (size_t j = 0; j < clean[i].size(); ++j) diffs += (clean[i][j] != noisy[i][j]);
+  }
+  EXPECT_GT(diffs, 600UL);
+  EXPECT_LT(diffs, 1400UL);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_memory_budget.cpp
+ *   test the budget parsing and the round planning.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+
+#include "utils/memory_budget.hpp"
+
+TEST(MemoryBudget, parse)
+{
+  EXPECT_EQ(0UL, ::bliss::utils::memory_budget::parse(nullptr));
+  EXPECT_EQ(0UL, ::bliss::utils::memory_budget::parse(""));
+  EXPECT_EQ(12345UL, ::bliss::utils::memory_budget::parse("12345"));
+  EXPECT_EQ(3UL << 10, ::bliss::utils::memory_budget::parse("3k"));
+  EXPECT_EQ(5UL << 20, ::bliss::utils::memory_budget::parse("5M"));
+  EXPECT_EQ(2UL << 30, ::bliss::utils::memory_budget::parse("2G"));
+
+  EXPECT_THROW(::bliss::utils::memory_budget::parse("lots"), ::std::invalid_argument);
+  EXPECT_THROW(::bliss::utils::memory_budget::parse("4T"), ::std::invalid_argument);
+  EXPECT_THROW(::bliss::utils::memory_budget::parse("4MB"), ::std::invalid_argument);
+}
+
+TEST(MemoryBudget, unlimited)
+{
+  ::bliss::utils::memory_budget b(0);
+  EXPECT_FALSE(b.limited());
+  EXPECT_EQ(::std::numeric_limits<size_t>::max(), b.available());
+  EXPECT_EQ(::std::numeric_limits<size_t>::max(), b.max_elements(16));
+  EXPECT_EQ(1UL, b.rounds(1UL << 40, 16));
+}
+
+TEST(MemoryBudget, rounds)
+{
+  // below the current usage:  no headroom, 1 element per round.
+  ::bliss::utils::memory_budget none(1);
+  EXPECT_TRUE(none.limited());
+  EXPECT_EQ(0UL, none.available());
+  EXPECT_EQ(1UL, none.max_elements(16));
+  EXPECT_EQ(100UL, none.rounds(100, 16));
+
+  // about 1MB of headroom.  the usage may grow a little between the calls.
+  ::bliss::utils::memory_budget some(::getCurrentRSS() + (1UL << 20));
+  size_t per_round = some.max_elements(1024);
+  EXPECT_LE(per_round, 1024UL);
+  EXPECT_GE(per_round, 512UL);
+  EXPECT_EQ(1UL, some.rounds(per_round / 2, 1024));
+  EXPECT_LE(4UL, some.rounds(4 * 1024, 1024));
+}
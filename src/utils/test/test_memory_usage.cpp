@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_memory_usage.cpp
+ *   test that the per phase peak catches a transient allocation between 2 marks.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <cstring>  // memset
+
+#include "utils/memory_usage.hpp"
+
+TEST(MemUsage, phase_peak)
+{
+  ::plog::MemUsage m;
+  m.mark("begin");
+
+  size_t bytes = 1UL << 26;
+  {
+    // freed before the mark, so only a peak would see it.
+    std::vector<char> spike(bytes);
+    memset(spike.data(), 1, bytes);
+    EXPECT_EQ(1, spike[bytes - 1]);
+  }
+  m.mark("spike");
+  m.mark("after");
+
+  std::vector<double> const & peaks = m.phase_peaks();
+  ASSERT_EQ(3UL, peaks.size());
+
+  // the lifetime peak fallback includes the spike too.
+  EXPECT_GE(peaks[1], peaks[0] + 0.9 * bytes);
+
+  if (m.has_phase_peaks()) {
+    // the phase after the spike does not see it.
+    EXPECT_LT(peaks[2], peaks[1] - 0.5 * bytes);
+  } else {
+    EXPECT_EQ(peaks[1], peaks[2]);
+  }
+
+  // the lifetime peak does not go down.
+  std::vector<double> const & lifetime = m.lifetime_peaks();
+  ASSERT_EQ(3UL, lifetime.size());
+  EXPECT_GE(lifetime[1], peaks[1]);
+  EXPECT_EQ(lifetime[1], lifetime[2]);
+
+  m.report("mem_test");
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "utils/hyperloglog.hpp"  // mix64
+#include "utils/minhash.hpp"
+
+
+class MinHashTest : public ::testing::TestWithParam<size_t> {};
+
+
+// each distinct value is added 3 times.  exact below s.  with s = 1000, standard error is about 3%, so 15% is about 5 sigma.
+TEST_P(MinHashTest, estimate)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::bottom_minhash mh(1000);
+  for (size_t r = 0; r < 3; ++r) {
+    for (size_t i = 0; i < n; ++i) {
+      mh.update(::bliss::utils::mix64(i));
+    }
+  }
+
+  EXPECT_EQ(std::min(n, 1000UL), mh.get_hashes().size());
+  EXPECT_TRUE(std::is_sorted(mh.get_hashes().begin(), mh.get_hashes().end()));
+  double est = mh.estimate();
+  if (n < 1000) EXPECT_EQ(static_cast<double>(n), est);
+  else EXPECT_LT(::std::fabs(est - static_cast<double>(n)), 0.15 * static_cast<double>(n)) << "estimate " << est;
+}
+
+// first has [0, 2n/3), second has [n/3, n), so the Jaccard index is 1/3.
+TEST_P(MinHashTest, jaccard_and_merge)
+{
+  size_t n = GetParam();
+
+  ::bliss::utils::bottom_minhash first(1000), second(1000), all(1000);
+  for (size_t i = 0; i < (n * 2) / 3; ++i) {
+    first.update(::bliss::utils::mix64(i));
+  }
+  for (size_t i = n / 3; i < n; ++i) {
+    second.update(::bliss::utils::mix64(i));
+  }
+  for (size_t i = 0; i < n; ++i) {
+    all.update(::bliss::utils::mix64(i));
+  }
+
+  EXPECT_EQ(1.0, first.jaccard(first));
+  double exact = static_cast<double>((n * 2) / 3 - n / 3) / static_cast<double>(n);
+  EXPECT_LT(::std::fabs(first.jaccard(second) - exact), 0.06) << "jaccard " << first.jaccard(second);
+
+  // the merge is the sketch of the union.
+  first.merge(second);
+  EXPECT_EQ(all.get_hashes(), first.get_hashes());
+
+  ::bliss::utils::bottom_minhash copy(1000);
+  copy.set_hashes(all.get_hashes());
+  EXPECT_EQ(1.0, copy.jaccard(all));
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, MinHashTest, ::testing::Values(
+    10UL, 1000UL, 10000UL, 100000UL, 1000000UL
+    ));
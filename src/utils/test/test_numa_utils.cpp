@@ -0,0 +1,55 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// include google test
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "utils/numa_utils.hpp"
+
+
+TEST(NumaUtils, parse_list)
+{
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), ::bliss::utils::numa::parse_list("0-3,8,10-11"));
+  EXPECT_EQ(std::vector<int>({5}), ::bliss::utils::numa::parse_list("5\n"));
+  EXPECT_TRUE(::bliss::utils::numa::parse_list("").empty());
+}
+
+TEST(NumaUtils, topology)
+{
+  std::vector<int> nodes = ::bliss::utils::numa::nodes();
+  ASSERT_FALSE(nodes.empty());
+
+  int node = ::bliss::utils::numa::current_node();
+  EXPECT_TRUE(std::find(nodes.begin(), nodes.end(), node) != nodes.end());
+}
+
+TEST(NumaUtils, interleaved_allocator)
+{
+  // placement may not be supported here, but allocation has to work either way.
+  std::vector<uint64_t, ::bliss::utils::numa_interleaved_allocator<uint64_t> > v;
+  for (uint64_t i = 0; i < (1UL << 20); ++i) v.push_back(i);
+  for (uint64_t i = 0; i < v.size(); i += 1001) EXPECT_EQ(i, v[i]);
+
+  std::vector<uint64_t> buf;
+  buf.reserve(1UL << 20);
+  ::bliss::utils::numa::prefer_current(buf.data(), buf.capacity() * sizeof(uint64_t));
+  buf.assign(1UL << 20, 7);
+  EXPECT_EQ(7UL, buf.back());
+}
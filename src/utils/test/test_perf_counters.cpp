@@ -0,0 +1,63 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_perf_counters.cpp
+ *   test the phases of the hardware performance counters.  machines without PMU access report -1.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric>
+
+#include "utils/perf_counters.hpp"
+
+TEST(PerfCounters, phases)
+{
+  ::plog::PerfCounters perf;
+
+  perf.start();
+  std::vector<double> x(1 << 16, 1.0);
+  volatile double sum = std::accumulate(x.begin(), x.end(), 0.0);
+  perf.end("sum");
+  perf.end("empty");
+
+  EXPECT_EQ(65536.0, sum);
+  ASSERT_EQ(2UL, perf.get_names().size());
+  ASSERT_EQ(2UL, perf.get_values().size());
+  EXPECT_EQ("sum", perf.get_names()[0]);
+
+  for (int i = 0; i < ::plog::PerfCounters::NUM_EVENTS; ++i) {
+    double v = perf.get_values()[0][i];
+    if (perf.available(static_cast<::plog::PerfCounters::event_id>(i))) {
+      EXPECT_GE(v, 0.0);
+    } else {
+      EXPECT_EQ(-1.0, v);
+    }
+  }
+
+  if (perf.available(::plog::PerfCounters::INSTRUCTIONS)) {
+    // the summing loop retires at least 1 instruction per element.
+    EXPECT_GT(perf.get_values()[0][::plog::PerfCounters::INSTRUCTIONS], 65536.0);
+  }
+
+  perf.report("perf_test");
+
+  perf.reset();
+  EXPECT_EQ(0UL, perf.get_names().size());
+}
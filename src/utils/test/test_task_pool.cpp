@@ -0,0 +1,155 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * test_task_pool.cpp
+ *   test that the pool covers every index once, with stable thread ids, across many short rounds.
+ *
+ */
+
+// include google test
+#include <gtest/gtest.h>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <set>
+#include <mutex>
+#include <stdexcept>
+#include <cstdint>
+
+#include "utils/task_pool.hpp"
+
+
+class TaskPoolTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(TaskPoolTest, covers_once)
+{
+  int const nt = GetParam();
+  ::bliss::utils::task_pool pool(nt);
+  EXPECT_EQ(nt, pool.size());
+
+  for (size_t n : {1UL, 2UL, 7UL, 100UL, 12345UL}) {
+    for (size_t grain : {1UL, 3UL, 64UL}) {
+      std::vector<std::atomic<int> > hits(n);
+      for (auto & h : hits) h.store(0);
+      std::vector<size_t> per_thread(nt, 0);
+
+      pool.parallel_for(n, [&](size_t const first, size_t const last, int const tid) {
+        ASSERT_LT(tid, nt);
+        EXPECT_LE(last - first, grain);
+        for (size_t i = first; i < last; ++i) hits[i].fetch_add(1);
+        per_thread[tid] += last - first;   // tid is exclusive to the thread.
+      }, nt, grain);
+
+      size_t total = 0;
+      for (size_t i = 0; i < n; ++i) ASSERT_EQ(1, hits[i].load()) << "n " << n << " grain " << grain << " i " << i;
+      for (auto c : per_thread) total += c;
+      EXPECT_EQ(n, total);
+    }
+  }
+}
+
+TEST_P(TaskPoolTest, many_rounds)
+{
+  int const nt = GetParam();
+  ::bliss::utils::task_pool pool(nt);
+
+  // short rounds, as in a query loop.  the same threads run them, so their scratch persists.
+  std::mutex m;
+  std::set<std::thread::id> threads;
+  std::vector<size_t> sums(nt, 0);
+  for (size_t r = 0; r < 2000; ++r) {
+    pool.parallel_for(64, [&](size_t const first, size_t const last, int const tid) {
+      std::vector<size_t> & scratch = ::bliss::utils::task_pool::thread_scratch<std::vector<size_t> >();
+      scratch.clear();
+      for (size_t i = first; i < last; ++i) scratch.push_back(i);
+      for (size_t x : scratch) sums[tid] += x;
+
+      std::lock_guard<std::mutex> lock(m);
+      threads.insert(std::this_thread::get_id());
+    });
+  }
+  size_t total = 0;
+  for (auto s : sums) total += s;
+  EXPECT_EQ(2000UL * (63 * 64 / 2), total);
+  EXPECT_LE(threads.size(), static_cast<size_t>(nt));
+}
+
+TEST_P(TaskPoolTest, run_and_nested)
+{
+  int const nt = GetParam();
+  ::bliss::utils::task_pool pool(nt);
+
+  std::vector<int> called(nt, 0);
+  std::atomic<size_t> inner(0);
+  pool.run(nt, [&](int const tid) {
+    ++called[tid];
+    // nested calls run on the calling thread.
+    pool.parallel_for(10, [&](size_t const first, size_t const last, int const t) {
+      EXPECT_EQ(0, t);
+      inner += last - first;
+    });
+  });
+  for (int i = 0; i < nt; ++i) EXPECT_EQ(1, called[i]);
+  EXPECT_EQ(10UL * nt, inner.load());
+}
+
+TEST_P(TaskPoolTest, exception)
+{
+  int const nt = GetParam();
+  ::bliss::utils::task_pool pool(nt);
+
+  EXPECT_THROW(pool.parallel_for(1000, [](size_t const first, size_t const last, int const) {
+    if ((first <= 500) && (500 < last)) throw std::runtime_error("500");
+  }), std::runtime_error);
+
+  // still usable.
+  std::atomic<size_t> count(0);
+  pool.parallel_for(1000, [&](size_t const first, size_t const last, int const) { count += last - first; });
+  EXPECT_EQ(1000UL, count.load());
+}
+
+INSTANTIATE_TEST_CASE_P(Bliss, TaskPoolTest, ::testing::Values(1, 2, 4, 7));
+
+
+TEST(TaskPool, grows)
+{
+  ::bliss::utils::task_pool pool;
+  EXPECT_EQ(1, pool.size());
+
+  std::vector<size_t> per_thread(5, 0);
+  pool.parallel_for(100000, [&](size_t const first, size_t const last, int const tid) {
+    per_thread[tid] += last - first;
+  }, 5, 100);
+  EXPECT_EQ(5, pool.size());
+
+  size_t total = 0;
+  for (auto c : per_thread) total += c;
+  EXPECT_EQ(100000UL, total);
+
+  // concurrent callers take turns.
+  std::atomic<size_t> count(0);
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 3; ++c) {
+    callers.emplace_back([&pool, &count]() {
+      for (int r = 0; r < 100; ++r) {
+        pool.parallel_for(100, [&count](size_t const first, size_t const last, int const) { count += last - first; }, 4);
+      }
+    });
+  }
+  for (auto & t : callers) t.join();
+  EXPECT_EQ(3UL * 100 * 100, count.load());
+}
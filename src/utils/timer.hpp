@@ -40,6 +40,8 @@
 
 #include <mxx/reduction.hpp>
 
+#include "utils/benchmark_sink.hpp"
+
 
 namespace plog {
 
@@ -129,7 +131,23 @@ class Timer {
 
 		end(name, n_elem);
     }
+    /// elements per second for each phase.  0 for phases that took no time.
+    std::vector<double> throughput() const {
+      std::vector<double> result(durations.size(), 0.0);
+      for (size_t i = 0; i < durations.size(); ++i) {
+        if (durations[i] > 0.0) result[i] = counts[i] / durations[i];
+      }
+      return result;
+    }
+
     void report(::std::string const & title) {
+        if (::plog::BenchSink::enabled() && (durations.size() > 0)) {
+          ::plog::BenchSink::append(title, "time", names, "dur_s", 1, ::plog::BenchSink::local(durations));
+          ::plog::BenchSink::append(title, "time", names, "cum_s", 1, ::plog::BenchSink::local(cumulative));
+          ::plog::BenchSink::append(title, "time", names, "count", 1, ::plog::BenchSink::local(counts));
+          ::plog::BenchSink::append(title, "time", names, "elem_per_s", 1, ::plog::BenchSink::local(throughput()));
+        }
+
         std::stringstream output;
 
         std::ostream_iterator<std::string> nit(output, ",");
@@ -269,6 +287,20 @@ class Timer {
       int p = comm.size();
       int rank = comm.rank();
 
+      // before the stdev computation below squares the local values in place.
+      if ((durations.size() > 0) && ::mxx::any_of(::plog::BenchSink::enabled(), comm)) {
+        ::plog::BenchSink::stats dur = ::plog::BenchSink::reduce(durations, comm);
+        ::plog::BenchSink::stats cum = ::plog::BenchSink::reduce(cumulative, comm);
+        ::plog::BenchSink::stats cnt = ::plog::BenchSink::reduce(counts, comm);
+        ::plog::BenchSink::stats tput = ::plog::BenchSink::reduce(throughput(), comm);
+        if (rank == 0) {
+          ::plog::BenchSink::append(title, "time", names, "dur_s", p, dur);
+          ::plog::BenchSink::append(title, "time", names, "cum_s", p, cum);
+          ::plog::BenchSink::append(title, "time", names, "count", p, cnt);
+          ::plog::BenchSink::append(title, "time", names, "elem_per_s", p, tput);
+        }
+      }
+
       if (durations.size() > 0) {
 
     	  dur_mins = ::mxx::reduce(durations, 0,
@@ -24,6 +24,11 @@
 #ifndef TRANSFORM_UTILS_HPP_
 #define TRANSFORM_UTILS_HPP_
 
+#include <utility>      // pair, forward, declval
+#include <vector>
+#include <algorithm>    // transform
+#include <type_traits>  // is_same
+
 namespace bliss {
 
   namespace transform
@@ -46,6 +51,37 @@ namespace bliss {
 
   };
 
+  /// First, then Second.  a transform of Key is compose<First, Second>::template on<Key>.
+  template <template <typename> class First, template <typename> class Second>
+  struct compose {
+      template <typename Key>
+      struct on {
+          First<Key> first;
+          Second<Key> second;
+
+          inline Key operator()(Key const & x) const {
+            return second(first(x));
+          }
+          template <typename VAL>
+          inline ::std::pair<Key, VAL> operator()(std::pair<Key, VAL> const & x) const {
+            return ::std::pair<Key, VAL>(this->operator()(x.first), x.second);
+          }
+          template <typename VAL>
+          inline ::std::pair<const Key, VAL> operator()(std::pair<const Key, VAL> const & x) const {
+            return ::std::pair<const Key, VAL>(this->operator()(x.first), x.second);
+          }
+
+          /// batch version, in place, when Second has one, e.g. the simd kmer canonicalization.
+          template <typename V, typename S = Second<Key> >
+          inline auto transform_inplace(::std::vector<V> & x) const
+            -> decltype(::std::declval<S const &>().transform_inplace(x), void()) {
+            if (!::std::is_same<First<Key>, identity<Key> >::value)
+              ::std::transform(x.begin(), x.end(), x.begin(), first);
+            second.transform_inplace(x);
+          }
+      };
+  };
+
   } // namespace filter
 
 } // namespace bliss
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    BenchmarkAutoIndex.cpp
+ * @ingroup
+ * @brief   builds and queries a canonical k-mer count index whose backend is chosen from the input at runtime.
+ * @details k and the backend are runtime parameters (see common/kmer_dispatch.hpp and index/index_selector.hpp),
+ *          so 1 binary covers what the testKmerIndex-*-DENSEHASH/SORTED/COMPACTCOUNT-COUNT targets do.  with
+ *          -I auto (the default) the parsed k-mers are profiled and the backend is chosen by choose_count_backend.
+ *          -I densehash, sorted, or counting forces 1, e.g. to check the choice.
+ *
+ *          phases are reported as for BenchmarkKmerIndex, under the title "auto_index", so they are in the
+ *          benchmark sink (BL_BENCH_FILE) together with the chosen backend on stdout.
+ */
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+
+#include "utils/logging.h"
+
+#include "common/alphabets.hpp"
+#include "common/kmer.hpp"
+#include "common/kmer_dispatch.hpp"
+#include "io/sequence_iterator.hpp"
+#include "io/kmer_file_helper.hpp"
+#include "index/kmer_index.hpp"
+#include "index/index_selector.hpp"
+#include "utils/benchmark_utils.hpp"
+
+#include "tclap/CmdLine.h"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+
+using KmerSizes = ::bliss::common::kmer_sizes<21, 31, 63>;
+
+
+/// build and query an index of the given type.
+struct build_and_query {
+    template <typename IndexType>
+    int operator()(std::vector<typename IndexType::KmerType> & kmers, std::vector<typename IndexType::KmerType> & query,
+                   mxx::comm const & comm) const {
+      BL_BENCH_INIT(test);
+
+      IndexType idx(comm);
+
+      BL_BENCH_START(test);
+      idx.insert(kmers);
+      BL_BENCH_COLLECTIVE_END(test, "insert", idx.local_size(), comm);
+
+      size_t total = idx.size();
+      if (comm.rank() == 0) printf("distinct k-mers %lu\n", total);
+
+      {
+        auto lquery = query;
+        BL_BENCH_START(test);
+        auto counts = idx.count(lquery);
+        BL_BENCH_COLLECTIVE_END(test, "count", counts.size(), comm);
+      }
+      {
+        auto lquery = query;
+        BL_BENCH_START(test);
+        auto found = idx.find(lquery);
+        BL_BENCH_COLLECTIVE_END(test, "find", found.size(), comm);
+      }
+
+      BL_BENCH_REPORT_MPI_NAMED(test, "auto_index", comm);
+      return 0;
+    }
+};
+
+
+struct run_benchmark {
+    template <typename KmerType>
+    int operator()(std::string const & filename, std::string const & queryname, int const sample_ratio,
+                   std::string const & backend, ::bliss::index::kmer::selector_params const & params,
+                   mxx::comm const & comm) const {
+      using Parser = ::bliss::index::kmer::KmerParser<KmerType>;
+
+      BL_BENCH_INIT(prep);
+
+      std::vector<KmerType> kmers;
+      BL_BENCH_START(prep);
+      ::bliss::io::KmerFileHelper::read_file_posix<Parser, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(filename, kmers, comm);
+      BL_BENCH_COLLECTIVE_END(prep, "read", kmers.size(), comm);
+
+      // every sample_ratio-th k-mer of the query file, from a random start.
+      std::vector<KmerType> query;
+      BL_BENCH_START(prep);
+      {
+        std::vector<KmerType> all;
+        if (queryname == filename) all = kmers;
+        else ::bliss::io::KmerFileHelper::read_file_posix<Parser, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(queryname, all, comm);
+        size_t const stride = std::max(sample_ratio, 1);
+        size_t first = std::default_random_engine(comm.rank())() % stride;
+        for (size_t i = first; i < all.size(); i += stride) query.push_back(all[i]);
+      }
+      BL_BENCH_COLLECTIVE_END(prep, "sample", query.size(), comm);
+
+      // count and find are each 1 pass over the query.
+      BL_BENCH_START(prep);
+      ::bliss::index::kmer::index_profile profile = ::bliss::index::kmer::profile_kmers(kmers, 2 * query.size(), comm);
+      ::bliss::index::kmer::CountBackend b = (backend == "auto") ?
+          ::bliss::index::kmer::choose_count_backend(profile, params) : ::bliss::index::kmer::parse_count_backend(backend);
+      BL_BENCH_COLLECTIVE_END(prep, "profile", kmers.size(), comm);
+
+      if (comm.rank() == 0) {
+        printf("k %u: %lu k-mers, ~%.0f distinct (duplicate rate %.3f), %lu queries, %d ranks\n", KmerType::size,
+               profile.kmers, profile.distinct, profile.duplicate_rate(), profile.queries, profile.ranks);
+        printf("backend %s (%s)\n", ::bliss::index::kmer::to_string(b).c_str(), (backend == "auto") ? "chosen" : "forced");
+      }
+
+      BL_BENCH_REPORT_MPI_NAMED(prep, "auto_index:prep", comm);
+
+      return ::bliss::index::kmer::dispatch_count_backend<KmerType>(b, build_and_query(), kmers, query, comm);
+    }
+};
+
+
+int main(int argc, char** argv) {
+
+  LOG_INIT();
+
+  mxx::env e(argc, argv);
+  mxx::comm comm;
+
+  if (comm.rank() == 0) printf("EXECUTING %s\n", argv[0]);
+
+  std::string filename(PROJ_SRC_DIR);
+  filename.append("/test/data/test.small.fastq");
+  std::string queryname;
+  int sample_ratio = 100;
+  std::string backend("auto");
+  unsigned int kmer_size = ::bliss::common::default_kmer_size<KmerSizes>();
+  ::bliss::index::kmer::selector_params params;
+
+  try {
+    TCLAP::CmdLine cmd("Benchmark a k-mer count index with a backend chosen at runtime", ' ', "0.1");
+
+    TCLAP::ValueArg<std::string> fileArg("F", "file", "FASTQ file path", false, filename, "string", cmd);
+    TCLAP::ValueArg<std::string> queryArg("Q", "query", "FASTQ file path for query. default to same file as index file", false, "", "string", cmd);
+    TCLAP::ValueArg<int> sampleArg("S", "query-sample", "sampling ratio for the query kmers. default=100", false, sample_ratio, "int", cmd);
+    TCLAP::ValueArg<unsigned int> kArg("K", "kmer-size", "k.  compiled for " + ::bliss::common::supported_kmer_sizes<KmerSizes>() + ".  default is the first",
+                                       false, kmer_size, "unsigned int", cmd);
+    TCLAP::ValueArg<std::string> backendArg("I", "index", "backend:  auto, densehash, sorted, or counting. default=auto", false, backend, "string", cmd);
+    TCLAP::ValueArg<double> memArg("M", "memory-per-rank", "densehash bytes per rank above which auto uses the counting map. default=4GB",
+                                   false, params.memory_per_rank, "double", cmd);
+
+    cmd.parse(argc, argv);
+
+    filename = fileArg.getValue();
+    queryname = queryArg.getValue();
+    if (queryname.empty()) queryname = filename;
+    sample_ratio = sampleArg.getValue();
+    kmer_size = kArg.getValue();
+    backend = backendArg.getValue();
+    params.memory_per_rank = memArg.getValue();
+
+    if (backend != "auto") ::bliss::index::kmer::parse_count_backend(backend);  // check early.
+
+  } catch (TCLAP::ArgException &e)  // catch any exceptions
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(-1);
+  } catch (std::invalid_argument const & e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    exit(-1);
+  }
+
+  if (!::bliss::common::is_supported_kmer_size<KmerSizes>(kmer_size)) {
+    if (comm.rank() == 0) std::cerr << "error: k=" << kmer_size << " not compiled in.  available: " << ::bliss::common::supported_kmer_sizes<KmerSizes>() << std::endl;
+    exit(-1);
+  }
+
+  int ret = ::bliss::common::dispatch_kmer_size<KmerSizes, ::bliss::common::DNA, WordType>(kmer_size, run_benchmark(),
+      filename, queryname, sample_ratio, backend, params, comm);
+
+  comm.barrier();
+
+  return ret;
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2016 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    BenchmarkDistributedMaps.cpp
+ * @ingroup
+ * @brief   weak and strong scaling sweep of the distributed maps on synthetic k-mers.
+ * @details for each map type, each number of ranks, and each number of threads, inserts synthetic k-mers
+ *          (Zipfian multiplicity with adjacent repeats, or k-mers of reads simulated from a FASTA reference with errors),
+ *          then finds, counts, and erases a fraction of them.
+ *          the rank counts are sub-communicators of the first ranks of MPI_COMM_WORLD, so 1 job covers the whole
+ *          sweep;  the other ranks wait.
+ *
+ *          weak scaling keeps the k-mers per rank fixed (-n), strong scaling keeps the total fixed (-n times the
+ *          largest rank count).  for every phase the report has the time (max over ranks), the throughput per core
+ *          (elements / time / (ranks * threads)), and the parallel efficiency, i.e. the throughput per core relative
+ *          to that of the smallest configuration of the same map and mode.  rank 0 prints a table, and if
+ *          BL_BENCH_FILE is set the same values go to the benchmark sink, kind "scaling", with the map, mode, and
+ *          threads in the title.
+ */
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <utility>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "containers/distributed_unordered_map.hpp"
+#include "containers/distributed_sorted_map.hpp"
+#include "containers/distributed_densehash_map.hpp"
+
+#include "utils/benchmark_sink.hpp"
+#include "utils/kmer_generator.hpp"
+
+#include "tclap/CmdLine.h"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+
+using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+using ValType = uint32_t;
+
+template <typename Key>
+using HashParams = ::bliss::index::kmer::CanonicalHashMapParams<Key>;
+template <typename Key>
+using SortedParams = ::bliss::index::kmer::CanonicalSortedMapParams<Key>;
+using SpecialKeys = ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true>;
+
+/// phases timed for each configuration.
+static const std::vector<std::string> phase_names = {"insert", "find", "count", "erase"};
+
+
+/// synthetic workload settings.  see utils/kmer_generator.hpp
+struct workload {
+    double zipf_exponent;
+    double duplicate_rate;
+    std::string reference;   // FASTA file to simulate reads from, instead of zipf.
+    std::vector<std::string> ref_seqs;
+    size_t read_length;
+    double error_rate;
+};
+
+/// count k-mers for rank:  zipf over count / 2 distinct k-mers, the same on all ranks, or k-mers of reads simulated from the reference.
+void generate_keys(std::vector<KmerType> & output, size_t const count, int const rank, workload const & w) {
+  if (w.ref_seqs.size() == 0) {
+    ::bliss::utils::generate_zipf(output, count, std::max(count / 2, static_cast<size_t>(1)),
+                                  w.zipf_exponent, w.duplicate_rate, 23 + rank);
+    return;
+  }
+
+  output.clear();
+  size_t per_read = (w.read_length >= KmerType::size) ? (w.read_length - KmerType::size + 1) : 1;
+  for (uint64_t round = 0; output.size() < count; ++round) {
+    size_t before = output.size();
+    auto reads = ::bliss::utils::simulate_reads(w.ref_seqs, (count - output.size() + per_read - 1) / per_read,
+                                                w.read_length, w.error_rate, (23 + rank) * 1000 + round);
+    ::bliss::utils::kmers_from_reads(reads, output);
+    if (output.size() == before) break;   // no usable reads.
+  }
+  output.resize(std::min(output.size(), count));
+}
+
+/// insert input of a counting map:  the keys.
+void make_input(std::vector<KmerType> const & keys, std::vector<KmerType> & input) {
+  input = keys;
+}
+/// insert input of the other maps:  (key, position).
+void make_input(std::vector<KmerType> const & keys, std::vector<std::pair<KmerType, ValType> > & input) {
+  input.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) input[i] = std::make_pair(keys[i], static_cast<ValType>(i));
+}
+
+
+/**
+ * @brief time the phases of 1 map on comm.  collective on comm.
+ * @return max over the ranks of the duration of each phase, in seconds.
+ */
+template <typename MapType, typename InputType>
+std::vector<double> run_phases(size_t const local_count, size_t const query_frac, workload const & w, ::mxx::comm const & comm) {
+  std::vector<double> times;
+
+  std::vector<KmerType> keys;
+  generate_keys(keys, local_count, comm.rank(), w);
+  std::vector<KmerType> query(keys.begin(), keys.begin() + keys.size() / query_frac);
+
+  InputType input;
+  make_input(keys, input);
+  std::vector<KmerType>().swap(keys);
+
+  MapType map(comm);
+
+  auto timed = [&comm, &times](std::function<void()> const & op) {
+    comm.barrier();
+    auto start = std::chrono::high_resolution_clock::now();
+    op();
+    double local = std::chrono::duration_cast<std::chrono::duration<double> >(
+        std::chrono::high_resolution_clock::now() - start).count();
+    times.emplace_back(::mxx::allreduce(local, [](double const & x, double const & y) { return std::max(x, y); }, comm));
+  };
+
+  // the maps reorder their input, so each query phase gets its own copy.  copies are not timed.
+  timed([&map, &input]() { map.insert(input); });
+
+  std::vector<KmerType> q(query);
+  timed([&map, &q]() { map.find(q); });
+
+  q = query;
+  timed([&map, &q]() { map.count(q); });
+
+  q = query;
+  timed([&map, &q]() { map.erase(q); });
+
+  return times;
+}
+
+/// run 1 map type by name.  returns empty if the name is unknown.
+std::vector<double> run_map(std::string const & name, size_t const local_count, size_t const query_frac, workload const & w,
+                            ::mxx::comm const & comm) {
+  using PairInput = std::vector<std::pair<KmerType, ValType> >;
+  using KeyInput = std::vector<KmerType>;
+
+  if (name == "unordered")
+    return run_phases<::dsc::unordered_map<KmerType, ValType, HashParams>, PairInput>(local_count, query_frac, w, comm);
+  if (name == "unordered_multimap")
+    return run_phases<::dsc::unordered_multimap<KmerType, ValType, HashParams>, PairInput>(local_count, query_frac, w, comm);
+  if (name == "unordered_count")
+    return run_phases<::dsc::counting_unordered_map<KmerType, ValType, HashParams>, KeyInput>(local_count, query_frac, w, comm);
+  if (name == "densehash")
+    return run_phases<::dsc::densehash_map<KmerType, ValType, HashParams, SpecialKeys>, PairInput>(local_count, query_frac, w, comm);
+  if (name == "densehash_multimap")
+    return run_phases<::dsc::densehash_multimap<KmerType, ValType, HashParams, SpecialKeys>, PairInput>(local_count, query_frac, w, comm);
+  if (name == "densehash_count")
+    return run_phases<::dsc::counting_densehash_map<KmerType, ValType, HashParams, SpecialKeys>, KeyInput>(local_count, query_frac, w, comm);
+  if (name == "sorted")
+    return run_phases<::dsc::sorted_map<KmerType, ValType, SortedParams>, PairInput>(local_count, query_frac, w, comm);
+  if (name == "sorted_multimap")
+    return run_phases<::dsc::sorted_multimap<KmerType, ValType, SortedParams>, PairInput>(local_count, query_frac, w, comm);
+  if (name == "sorted_count")
+    return run_phases<::dsc::counting_sorted_map<KmerType, ValType, SortedParams>, KeyInput>(local_count, query_frac, w, comm);
+
+  return std::vector<double>();
+}
+
+
+int main(int argc, char** argv) {
+
+  mxx::env e(argc, argv);
+  mxx::comm comm;
+
+  size_t count = 1000000;
+  size_t query_frac = 10;
+  std::vector<std::string> maps = {"unordered", "densehash", "sorted",
+                                   "unordered_count", "densehash_count", "sorted_count",
+                                   "unordered_multimap", "densehash_multimap", "sorted_multimap"};
+  std::vector<int> ranks;
+  std::vector<int> threads = {1};
+  std::vector<std::string> modes = {"weak", "strong"};
+  workload w;
+
+  try {
+    TCLAP::CmdLine cmd("Weak and strong scaling of the distributed maps", ' ', "0.1");
+
+    TCLAP::ValueArg<size_t> countArg("n", "count", "k-mers per rank (weak), or per rank at the largest rank count (strong). default=1000000",
+                                     false, count, "size_t", cmd);
+    TCLAP::ValueArg<size_t> queryArg("q", "query-frac", "1 / fraction of the k-mers used for find, count, and erase. default=10",
+                                     false, query_frac, "size_t", cmd);
+    TCLAP::MultiArg<std::string> mapArg("m", "map", "map type: unordered, densehash, sorted, with suffix _count or _multimap. default is all",
+                                        false, "string", cmd);
+    TCLAP::MultiArg<int> rankArg("p", "ranks", "rank counts to run.  default is powers of 2 up to the job size, and the job size",
+                                 false, "int", cmd);
+    TCLAP::MultiArg<int> threadArg("t", "threads", "thread counts to run. default=1", false, "int", cmd);
+    TCLAP::MultiArg<std::string> modeArg("", "mode", "weak or strong. default is both", false, "string", cmd);
+    TCLAP::ValueArg<double> zipfArg("z", "zipf", "zipf exponent of the k-mer multiplicities. 0 is uniform. default=1.0", false, 1.0, "double", cmd);
+    TCLAP::ValueArg<double> dupArg("d", "duplicate-rate", "fraction of k-mers that repeat the previous one. default=0.01", false, 0.01, "double", cmd);
+    TCLAP::ValueArg<std::string> refArg("R", "reference", "FASTA file to simulate reads from, instead of zipf k-mers", false, "", "string", cmd);
+    TCLAP::ValueArg<size_t> readLenArg("L", "read-length", "simulated read length. default=100", false, 100, "size_t", cmd);
+    TCLAP::ValueArg<double> errorArg("e", "error-rate", "simulated substitution error rate. default=0.01", false, 0.01, "double", cmd);
+
+    cmd.parse(argc, argv);
+
+    count = countArg.getValue();
+    query_frac = std::max(static_cast<size_t>(1), queryArg.getValue());
+    if (mapArg.getValue().size() > 0) maps = mapArg.getValue();
+    ranks = rankArg.getValue();
+    if (threadArg.getValue().size() > 0) threads = threadArg.getValue();
+    if (modeArg.getValue().size() > 0) modes = modeArg.getValue();
+    w.zipf_exponent = zipfArg.getValue();
+    w.duplicate_rate = dupArg.getValue();
+    w.reference = refArg.getValue();
+    w.read_length = readLenArg.getValue();
+    w.error_rate = errorArg.getValue();
+
+  } catch (TCLAP::ArgException &e)  // catch any exceptions
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(-1);
+  }
+
+  if (!w.reference.empty()) w.ref_seqs = ::bliss::utils::load_reference(w.reference);
+
+  if (ranks.size() == 0) {
+    for (int p = 1; p < comm.size(); p <<= 1) ranks.emplace_back(p);
+    ranks.emplace_back(comm.size());
+  }
+  ranks.erase(std::remove_if(ranks.begin(), ranks.end(), [&comm](int p) { return (p < 1) || (p > comm.size()); }), ranks.end());
+  std::sort(ranks.begin(), ranks.end());
+  ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+  std::sort(threads.begin(), threads.end());
+
+  if (comm.rank() == 0) {
+    printf("EXECUTING %s\n", argv[0]);
+    printf("%-20s %-6s %6s %7s %12s %-7s %12s %16s %10s\n",
+           "map", "mode", "ranks", "threads", "total", "phase", "time_s", "elem/s/core", "efficiency");
+  }
+
+  // unknown names are dropped on all ranks, since the ranks outside a configuration do not run the map.
+  maps.erase(std::remove_if(maps.begin(), maps.end(), [&comm](std::string const & name) {
+    bool known = false;
+    for (char const * base : {"unordered", "densehash", "sorted"})
+      for (char const * suffix : {"", "_multimap", "_count"})
+        known |= (name == std::string(base) + suffix);
+    if (!known && (comm.rank() == 0)) printf("unknown map type %s\n", name.c_str());
+    return !known;
+  }), maps.end());
+
+  for (auto const & name : maps) {
+    for (auto const & mode : modes) {
+      bool weak = (mode == "weak");
+
+      // per phase, the throughput per core of the first (smallest) configuration.
+      std::vector<double> baseline;
+
+      for (int p : ranks) {
+        // the first p ranks run the map on sub, the others wait at the barrier.  the maps and the imxx exchanges
+        // run all their collectives on sub, so the 2 groups do not mix.
+        ::mxx::comm sub = comm.split(comm.rank() < p ? 0 : 1);
+
+        for (int t : threads) {
+#if defined(USE_OPENMP)
+          omp_set_num_threads(t);
+#endif
+          size_t local_count = weak ? count : (count * ranks.back() / p);
+
+          std::vector<double> times;
+          if (comm.rank() < p) times = run_map(name, local_count, query_frac, w, sub);
+          comm.barrier();
+
+          if (comm.rank() != 0) continue;
+
+          size_t total = local_count * p;
+          size_t nqueries = (local_count / query_frac) * p;
+          int cores = p * t;
+
+          std::vector<double> per_core(times.size(), 0.0), efficiency(times.size(), 0.0);
+          for (size_t i = 0; i < times.size(); ++i) {
+            double n = static_cast<double>(i == 0 ? total : nqueries);
+            per_core[i] = (times[i] > 0.0) ? (n / times[i] / cores) : 0.0;
+          }
+          if (baseline.size() == 0) baseline = per_core;
+          for (size_t i = 0; i < times.size(); ++i) {
+            efficiency[i] = (baseline[i] > 0.0) ? (per_core[i] / baseline[i]) : 0.0;
+            printf("%-20s %-6s %6d %7d %12lu %-7s %12.6f %16.1f %10.3f\n",
+                   name.c_str(), mode.c_str(), p, t, total, phase_names[i].c_str(), times[i], per_core[i], efficiency[i]);
+          }
+
+          std::stringstream title;
+          title << name << "." << mode << ".t" << t;
+          ::plog::BenchSink::append(title.str(), "scaling", phase_names, "dur_s", p, ::plog::BenchSink::local(times));
+          ::plog::BenchSink::append(title.str(), "scaling", phase_names, "elem_per_s_per_core", p, ::plog::BenchSink::local(per_core));
+          ::plog::BenchSink::append(title.str(), "scaling", phase_names, "efficiency", p, ::plog::BenchSink::local(efficiency));
+        }
+      }
+      // strong scaling with a single rank count is the same as weak.
+      if (ranks.size() == 1) break;
+    }
+  }
+
+  comm.barrier();
+
+  return 0;
+}
@@ -15,11 +15,13 @@
  */
 
 /**
- * @file    test_threads.cpp
+ * @file    BenchmarkFileLoader.cpp
  * @ingroup
  * @author  Tony Pan <tpan7@gatech.edu>
- * @brief
- * @details
+ * @brief   load bandwidth of the parallel file backends.
+ * @details -A selects 1 backend, else all are run.  each is loaded -R times, with the page cache dropped before
+ *          each load per -C, for cold-cache measurements.  GB/s per rank and in aggregate are printed, and
+ *          appended to BL_BENCH_FILE if set.
  *
 
  */
@@ -34,7 +36,11 @@
 
 #include "io/file.hpp"
 
+#include "io/direct_file.hpp"
+
 #include "utils/benchmark_utils.hpp"
+#include "utils/benchmark_sink.hpp"
+#include "utils/cache_utils.hpp"
 #include "utils/exception_handling.hpp"
 
 #include "tclap/CmdLine.h"
@@ -101,14 +107,72 @@ bool validate(const std::string &fileName, const size_t offset,
 
 
 
+/// drop the page cache before each load.  0: keep, 1: evict the file's pages, 2: evict everything.  see utils/cache_utils.hpp
+void drop_cache(const std::string & filename, int const cache_mode, const mxx::comm & _comm) {
+  if (cache_mode == 0) return;
+
+  // 1 process per node.
+  ::mxx::comm node = _comm.split_shared();
+  if (node.rank() == 0) {
+    if (cache_mode == 1) {
+      if (!::bliss::utils::cache::drop_file_cache(filename))
+        std::cout << "WARNING: rank " << _comm.rank() << " could not drop cache of " << filename << std::endl;
+    } else {
+      ::bliss::utils::cache::clear_cache(false);
+    }
+  }
+  _comm.barrier();
+}
+
+/// set overlap exchange for the loaders that have it.
+template <typename FileLoader>
+auto set_overlap_exchange(FileLoader & loader, bool const exchange, int) -> decltype(loader.set_overlap_exchange(exchange), void()) {
+  loader.set_overlap_exchange(exchange);
+}
+template <typename FileLoader>
+void set_overlap_exchange(FileLoader &, bool const, long) {}
+
+
+/**
+ * @brief  report the load bandwidth, per rank and in aggregate (total bytes / slowest rank).  collective.
+ * @details printed by rank 0, and appended to BL_BENCH_FILE with kind "io", see utils/benchmark_sink.hpp.
+ */
+void report_io(std::string const & test, int const run, size_t const bytes, double const seconds, const mxx::comm & _comm) {
+  double rank_gbps = (seconds > 0.0) ? (static_cast<double>(bytes) / seconds * 1.0e-9) : 0.0;
+
+  size_t total_bytes = ::mxx::allreduce(bytes, _comm);
+  double max_seconds = ::mxx::allreduce(seconds, [](double const & x, double const & y) {
+    return (x < y) ? y : x;
+  }, _comm);
+  double aggregate_gbps = (max_seconds > 0.0) ? (static_cast<double>(total_bytes) / max_seconds * 1.0e-9) : 0.0;
+
+  ::plog::BenchSink::stats rank_stats = ::plog::BenchSink::reduce(std::vector<double>(1, rank_gbps), _comm);
+
+  if (_comm.rank() == 0) {
+    printf("IO %s run %d: %lu bytes in %f s.  GB/s per rank min %f mean %f max %f, aggregate %f\n",
+           test.c_str(), run, total_bytes, max_seconds,
+           rank_stats.mins[0], rank_stats.means[0], rank_stats.maxs[0], aggregate_gbps);
+    fflush(stdout);
+
+    std::vector<std::string> names(1, std::string("load"));
+    ::plog::BenchSink::append(test, "io", names, "rank_GB_per_s", _comm.size(), rank_stats);
+    ::plog::BenchSink::append(test, "io", names, "aggregate_GB_per_s", _comm.size(),
+                              ::plog::BenchSink::local(std::vector<double>(1, aggregate_gbps)));
+  }
+}
+
+
   /**
-   * @brief read a file's content and generate kmers, place in a vector as return result.
+   * @brief read a file's content and validate it against fread.
    * @note  static so can be used wihtout instantiating a internal map.
-   * @tparam SeqParser    parser type for extracting sequences.  supports FASTQ and FASTA.   template template parameter, param is iterator
-   * @tparam KmerParser   parser type for generating Kmer.  supports kmer, kmer+pos, kmer+count, kmer+pos/qual.
+   * @tparam FileLoader   parallel file type.
+   * @param cache_mode    drop the page cache before the load.  see drop_cache
+   * @param exchange      get the overlap from the next rank instead of reading it.  partitioned_file only.
+   * @return bytes read and load time in seconds.
    */
   template <typename FileLoader, size_t overlap = 0>
-  static size_t read_file_mpi_direct(const std::string & filename, const mxx::comm & _comm) {
+  static std::pair<size_t, double> read_file_mpi_direct(const std::string & filename, const mxx::comm & _comm,
+                                                        int const cache_mode = 0, bool const exchange = false) {
 
 
     //====  now process the file, one L1 block (block partition by MPI Rank) at a time
@@ -117,7 +181,9 @@ bool validate(const std::string &fileName, const size_t offset,
     partition.valid_range_bytes.start = 0;
     partition.valid_range_bytes.end = 0;
 
+    double seconds = 0.0;
 
+    drop_cache(filename, cache_mode, _comm);
 
     BL_BENCH_INIT(file_direct);
     {  // ensure that fileloader is closed at the end.
@@ -126,13 +192,17 @@ bool validate(const std::string &fileName, const size_t offset,
       BL_BENCH_START(file_direct);
       //==== create file Loader
       FileLoader loader(filename, overlap, _comm);
+      set_overlap_exchange(loader, exchange, 0);
       BL_BENCH_END(file_direct, "open", partition.getRange().size());
 
 
+      _comm.barrier();
       BL_BENCH_START(file_direct);
       //==== create file Loader
+      double t = MPI_Wtime();
       partition = loader.read_file();
-      BL_BENCH_END(file_direct, "load", partition.getRange().size());
+      seconds = MPI_Wtime() - t;
+      BL_BENCH_END(file_direct, "load", partition.data.size());
 
 
 
@@ -168,7 +238,7 @@ bool validate(const std::string &fileName, const size_t offset,
     BL_BENCH_REPORT_MPI(file_direct, _comm.rank(), _comm);
 
 
-    return partition.valid_range_bytes.size();
+    return std::make_pair(partition.data.size(), seconds);
   }
 
 
@@ -194,11 +264,15 @@ bool validate(const std::string &fileName, const size_t offset,
 //
 
 template <typename FileLoader, typename KmerType>
-void testIndexDirect(const mxx::comm& comm, const std::string & filename, std::string test ) {
+void testIndexDirect(const mxx::comm& comm, const std::string & filename, std::string test,
+                     int const repeats = 1, int const cache_mode = 0, bool const exchange = false) {
 
   if (comm.rank() == 0) printf("RANK %d / %d: Testing %s\n", comm.rank(), comm.size(), test.c_str());
 
-  read_file_mpi_direct<FileLoader, KmerType::size>(filename, comm);
+  for (int r = 0; r < repeats; ++r) {
+    std::pair<size_t, double> result = read_file_mpi_direct<FileLoader, KmerType::size>(filename, comm, cache_mode, exchange);
+    report_io(test, r, result.first, result.second, comm);
+  }
 }
 
 /**
@@ -230,6 +304,8 @@ int main(int argc, char** argv) {
 
   int which = -1;
   int nnodes = -1;
+  int repeats = 1;
+  int cache_mode = 0;
 
 
   // Wrap everything in a try block.  Do this every time,
@@ -251,6 +327,8 @@ int main(int argc, char** argv) {
 
     TCLAP::ValueArg<int> algoArg("A", "algo", "Algorithm id.  If absent, all.", false, -1, "int", cmd);
     TCLAP::ValueArg<int> nnodesArg("N", "nnodes", "Number of target nodes.  If absent, all.", false, comm_world.size(), "int", cmd);
+    TCLAP::ValueArg<int> repeatArg("R", "repeat", "Number of loads per algorithm.", false, 1, "int", cmd);
+    TCLAP::ValueArg<int> cacheArg("C", "cache", "Page cache before each load.  0: keep (warm), 1: drop the file's pages, 2: clear all (slow).", false, 0, "int", cmd);
 
 
     // Parse the argv array.
@@ -260,6 +338,8 @@ int main(int argc, char** argv) {
     filename = fileArg.getValue();
     which = algoArg.getValue();
     nnodes = nnodesArg.getValue();
+    repeats = repeatArg.getValue();
+    cache_mode = cacheArg.getValue();
 
     // Do what you intend.
 
@@ -290,41 +370,59 @@ int main(int argc, char** argv) {
 
 	  if (which == -1 || which == 5)
 	  {
-		  testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::mmap_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi mmap");
+		  testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::mmap_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi mmap", repeats, cache_mode);
 		  comm.barrier();
 	  }
 
 	  if (which == -1 || which == 6)
 	  {
-		  testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::stdio_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi stdio");
+		  testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::stdio_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi stdio", repeats, cache_mode);
 		  comm.barrier();
 	  }
 
     if (which == -1 || which == 7)
     {
-      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::posix_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi posix");
+      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::posix_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi posix", repeats, cache_mode);
       comm.barrier();
     }
 
     if (which == -1 || which == 8)
     {
-      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::mmap_file, PARSER_TYPE, bliss::io::parallel::base_shared_fd_file >, KmerType> (comm, filename, "mpi fd mmap");
+      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::mmap_file, PARSER_TYPE, bliss::io::parallel::base_shared_fd_file >, KmerType> (comm, filename, "mpi fd mmap", repeats, cache_mode);
       comm.barrier();
     }
 
     if (which == -1 || which == 9)
     {
-      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::posix_file, PARSER_TYPE, bliss::io::parallel::base_shared_fd_file >, KmerType> (comm, filename, "mpi fd posix");
+      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::posix_file, PARSER_TYPE, bliss::io::parallel::base_shared_fd_file >, KmerType> (comm, filename, "mpi fd posix", repeats, cache_mode);
       comm.barrier();
     }
 
 
 	  if (which == -1 || which == 10)
 	  {
-		  testIndexDirect<bliss::io::parallel::mpiio_file<PARSER_TYPE >, KmerType> (comm, filename, "mpi-io");
+		  testIndexDirect<bliss::io::parallel::mpiio_file<PARSER_TYPE >, KmerType> (comm, filename, "mpi-io", repeats, cache_mode);
 		  comm.barrier();
 	  }
 
+    if (which == -1 || which == 11)
+    {
+      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::posix_file, PARSER_TYPE, bliss::io::parallel::base_node_shared_file >, KmerType> (comm, filename, "mpi node shared posix", repeats, cache_mode);
+      comm.barrier();
+    }
+
+    if (which == -1 || which == 12)
+    {
+      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::direct_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi direct", repeats, cache_mode);
+      comm.barrier();
+    }
+
+    if (which == -1 || which == 13)
+    {
+      testIndexDirect<bliss::io::parallel::partitioned_file<bliss::io::posix_file, PARSER_TYPE >, KmerType> (comm, filename, "mpi posix overlap exchange", repeats, cache_mode, true);
+      comm.barrier();
+    }
+
 
 
   }
@@ -28,6 +28,7 @@
 
 #include "utils/benchmark_utils.hpp"
 #include "utils/transform_utils.hpp"
+#include "utils/kmer_generator.hpp"
 
 // comparison of some hash tables.  note that this is not exhaustive and includes only the well tested ones and my own.  not so much
 // the one-off ones people wrote.
@@ -63,46 +64,21 @@
 
 
 
+/// zipf exponent and adjacent duplicate rate of the generated keys.  see utils/kmer_generator.hpp
+constexpr double input_zipf_exponent = 1.0;
+constexpr double input_duplicate_rate = 0.01;
+
 template <typename Kmer, typename Value>
 void generate_input(std::vector<::std::pair<Kmer, Value> > & output, size_t const count, bool canonical = false) {
-  output.resize(count);
+  // skewed multiplicities over count / 2 distinct k-mers, with runs of repeats.
+  std::vector<Kmer> keys;
+  ::bliss::utils::generate_zipf(keys, count, std::max(count / 2, static_cast<size_t>(1)),
+                                input_zipf_exponent, input_duplicate_rate);
 
-  srand(23);
+  output.resize(count);
   for (size_t i = 0; i < count; ++i) {
-    for (size_t j = 0; j < Kmer::nWords; ++j) {
-      output[i].first.getDataRef()[j] = static_cast<typename Kmer::KmerWordType>(static_cast<long>(rand()) << 32) ^ static_cast<long>(rand());
-    }
-    output[i].first.sanitize();
-    //output[i].second = static_cast<Value>(static_cast<long>(rand()) << 32) ^ static_cast<long>(rand());
+    output[i].first = keys[i];
     output[i].second = i;
-    if (rand() < (1 << 24)) {
-      // make a repeat
-      ++i;
-      if (i < count) {
-        output[i] = output[i-1];
-        //output[i].second = static_cast<Value>(static_cast<long>(rand()) << 32) ^ static_cast<long>(rand());
-        output[i].second = i;
-      }
-    }
-    if (rand() < (1 << 16)) {
-      // make a repeat
-      ++i;
-      if (i < count) {
-
-        output[i] = output[i-1];
-        //output[i].second = static_cast<Value>(static_cast<long>(rand()) << 32) ^ static_cast<long>(rand());
-        output[i].second = i;
-      }
-    }
-    if (rand() < (1 << 8)) {
-      // make a repeat
-      ++i;
-      if (i < count) {
-        output[i] = output[i-1];
-        //output[i].second = static_cast<Value>(static_cast<long>(rand()) << 32) ^ static_cast<long>(rand());
-        output[i].second = i;
-      }
-    }
   }
 
   if (canonical) {
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    BenchmarkJobPacking.cpp
+ * @ingroup
+ * @brief   builds 1 k-mer count index per sample file, many samples at a time on groups of ranks.
+ * @details the ranks are split into groups of -g ranks (see index/job_packing.hpp).  each group builds the index of
+ *          the next sample in the queue, largest file first, optionally saves it to "<prefix>.<sample>", and takes
+ *          another.  with -g 0 the group size is chosen from the median file size and -b bytes per rank.
+ *
+ *          rank 0 prints 1 line per sample (group, ranks, seconds, distinct k-mers), then the wall time and the
+ *          samples per hour.  running with -g equal to the job size is the 1 sample at a time baseline.
+ */
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+#include <sys/stat.h>
+
+#include "common/kmer.hpp"
+#include "common/alphabets.hpp"
+#include "index/kmer_hash.hpp"
+#include "index/kmer_index.hpp"
+#include "index/job_packing.hpp"
+#include "containers/distributed_densehash_map.hpp"
+
+#include "tclap/CmdLine.h"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+#include "mxx/reduction.hpp"
+
+
+using KmerType = ::bliss::common::Kmer<31, ::bliss::common::DNA, uint64_t>;
+using MapType = ::dsc::counting_densehash_map<KmerType, uint32_t, ::bliss::index::kmer::CanonicalHashMapParams<KmerType>,
+    ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true> >;
+using IndexType = ::bliss::index::kmer::CountIndex<MapType>;
+
+/// what a group reports for a sample.  indexed by sample, 0 for the samples of other groups.
+struct sample_result {
+    double seconds;
+    size_t kmers;
+    int group;
+    int ranks;
+};
+
+
+int main(int argc, char** argv) {
+
+  mxx::env e(argc, argv);
+  mxx::comm comm;
+
+  std::vector<std::string> files;
+  int per_group = 0;
+  size_t bytes_per_rank = 256UL << 20;
+  std::string out_prefix;
+  bool fasta = false;
+
+  try {
+    TCLAP::CmdLine cmd("Build 1 count index per sample, on concurrent groups of ranks", ' ', "0.1");
+
+    TCLAP::MultiArg<std::string> fileArg("F", "file", "sample file.  repeat for each sample", true, "string", cmd);
+    TCLAP::ValueArg<int> groupArg("g", "group-size", "ranks per group.  0 chooses from the median sample size and -b. default=0",
+                                  false, per_group, "int", cmd);
+    TCLAP::ValueArg<size_t> bytesArg("b", "bytes-per-rank", "input bytes per rank when choosing the group size. default=256MB",
+                                     false, bytes_per_rank, "size_t", cmd);
+    TCLAP::ValueArg<std::string> outArg("O", "output", "save each index to <prefix>.<sample>", false, "", "string", cmd);
+    TCLAP::SwitchArg fastaArg("A", "fasta", "the samples are FASTA.  default is FASTQ", cmd, false);
+
+    cmd.parse(argc, argv);
+
+    files = fileArg.getValue();
+    per_group = groupArg.getValue();
+    bytes_per_rank = bytesArg.getValue();
+    out_prefix = outArg.getValue();
+    fasta = fastaArg.getValue();
+
+  } catch (TCLAP::ArgException &e)  // catch any exceptions
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(-1);
+  }
+
+  // the queue order needs the same sizes everywhere, so rank 0 reads them.
+  std::vector<size_t> sizes(files.size(), 0);
+  if (comm.rank() == 0) {
+    for (size_t i = 0; i < files.size(); ++i) {
+      struct stat st;
+      if (stat(files[i].c_str(), &st) == 0) sizes[i] = st.st_size;
+    }
+  }
+  MPI_Bcast(sizes.data(), static_cast<int>(sizes.size()), MPI_UINT64_T, 0, comm);
+
+  if (per_group <= 0) {
+    std::vector<size_t> sorted(sizes);
+    std::sort(sorted.begin(), sorted.end());
+    per_group = ::bliss::index::ranks_for_bytes(sorted.empty() ? 0 : sorted[sorted.size() / 2], bytes_per_rank, comm.size());
+  }
+  per_group = std::min(per_group, comm.size());
+
+  ::bliss::index::job_packer packer(comm, per_group);
+
+  if (comm.rank() == 0) {
+    printf("EXECUTING %s:  %lu samples on %d groups of %d ranks\n", argv[0], files.size(), packer.get_num_groups(), per_group);
+  }
+
+  std::vector<sample_result> results(files.size(), sample_result{0.0, 0, 0, 0});
+
+  comm.barrier();
+  auto start = std::chrono::steady_clock::now();
+
+  packer.run(sizes, [&](size_t const s, ::mxx::comm const & group) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    IndexType idx(group);
+    if (fasta)
+      idx.template build_mmap<::bliss::io::FASTAParser, ::bliss::io::SequencesIterator>(files[s], group);
+    else
+      idx.template build_mmap<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(files[s], group);
+    size_t kmers = idx.get_map().size();
+
+    if (!out_prefix.empty()) {
+      std::stringstream ss;
+      ss << out_prefix << "." << s;
+      idx.save(ss.str());
+    }
+
+    std::chrono::duration<double> t = std::chrono::steady_clock::now() - t0;
+    double secs = ::mxx::allreduce(t.count(), [](double x, double y) { return x > y ? x : y; }, group);
+    if (group.rank() == 0) results[s] = sample_result{secs, kmers, packer.get_group_id(), group.size()};
+  });
+
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+  // each sample was filled in by 1 rank.
+  for (auto & r : results) {
+    r.seconds = ::mxx::allreduce(r.seconds, comm);
+    r.kmers = ::mxx::allreduce(r.kmers, comm);
+    r.group = ::mxx::allreduce(r.group, comm);
+    r.ranks = ::mxx::allreduce(r.ranks, comm);
+  }
+
+  if (comm.rank() == 0) {
+    printf("%-8s %-40s %14s %6s %6s %10s %14s\n", "sample", "file", "bytes", "group", "ranks", "time_s", "kmers");
+    for (size_t i = 0; i < files.size(); ++i) {
+      printf("%-8lu %-40s %14lu %6d %6d %10.3f %14lu\n", i, files[i].c_str(), sizes[i],
+             results[i].group, results[i].ranks, results[i].seconds, results[i].kmers);
+    }
+    printf("wall %.3f s, %.1f samples per hour\n", wall.count(),
+           (wall.count() > 0.0) ? (3600.0 * files.size() / wall.count()) : 0.0);
+  }
+
+  return 0;
+}
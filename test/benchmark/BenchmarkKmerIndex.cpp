@@ -41,6 +41,7 @@
 
 #include "common/alphabets.hpp"
 #include "common/kmer.hpp"
+#include "common/kmer_dispatch.hpp"
 #include "common/base_types.hpp"
 #include "utils/kmer_utils.hpp"
 #include "utils/transform_utils.hpp"
@@ -80,6 +81,7 @@
 #define STD 21
 #define MURMUR 22
 #define FARM 23
+#define FOLD 24
 
 #define POS 31
 #define POSQUAL 32
@@ -92,6 +94,10 @@
 #define HASHEDVEC 45
 #define UNORDERED 46
 #define DENSEHASH 47
+#define SOAHASH 48
+#define COMPACTCOUNT 49
+#define CONCURRENTCOUNT 50
+#define MPHFCOUNT 54
 
 #define SINGLE 51
 #define CANONICAL 52
@@ -110,10 +116,13 @@ using Alphabet = bliss::common::DNA5;
 using Alphabet = bliss::common::DNA;
 #endif
 
-#if defined(pK)
-using KmerType = bliss::common::Kmer<pK, Alphabet, WordType>;
+// k values compiled in.  pKLIST (e.g. -DpKLIST=15,21,31) builds 1 binary for all of them, k is chosen with -K.
+#if defined(pKLIST)
+using KmerSizes = bliss::common::kmer_sizes<pKLIST>;
+#elif defined(pK)
+using KmerSizes = bliss::common::kmer_sizes<pK>;
 #else
-using KmerType = bliss::common::Kmer<21, Alphabet, WordType>;
+using KmerSizes = bliss::common::kmer_sizes<21>;
 #endif
 
 //============== index input file format
@@ -186,6 +195,10 @@ using CountType = uint32_t;
 #elif (pStoreHash == MURMUR)
 	template <typename KM>
 	using StoreHash = bliss::kmer::hash::murmur<KM, false>;
+#elif (pStoreHash == FOLD)
+	// with pDistHash == MURMUR:  1 full hash per kmer.
+	template <typename KM>
+	using StoreHash = bliss::kmer::hash::murmur_fold<KM, false>;
 #else //if (pStoreHash == FARM)
 	template <typename KM>
 	using StoreHash = bliss::kmer::hash::farm<KM, false>;
@@ -209,9 +222,11 @@ using CountType = uint32_t;
 
 	// DEFINE THE MAP TYPE base on the type of data to be stored.
 	#if (pINDEX == POS) || (pINDEX == POSQUAL)  // multimap
+		template <typename KmerType>
 		using MapType = ::dsc::sorted_multimap<
 				KmerType, ValType, MapParams>;
 	#elif (pINDEX == COUNT)  // map
+		template <typename KmerType>
 		using MapType = ::dsc::counting_sorted_map<
 				KmerType, ValType, MapParams>;
 	#endif
@@ -232,9 +247,11 @@ using CountType = uint32_t;
 
 	// DEFINE THE MAP TYPE base on the type of data to be stored.
 	#if (pINDEX == POS) || (pINDEX == POSQUAL)  // multimap
+		template <typename KmerType>
 		using MapType = ::dsc::multimap<
 				KmerType, ValType, MapParams>;
 	#elif (pINDEX == COUNT)  // map
+		template <typename KmerType>
 		using MapType = ::dsc::counting_map<
 				KmerType, ValType, MapParams>;
 	#endif
@@ -246,14 +263,17 @@ using CountType = uint32_t;
   #if (pKmerStore == SINGLE)  // single stranded
     template <typename Key>
     using MapParams = ::bliss::index::kmer::SingleStrandHashMapParams<Key, DistHash, StoreHash, DistTrans>;
+    template <typename KmerType>
     using SpecialKeys = ::bliss::kmer::hash::sparsehash::special_keys<KmerType, false>;
   #elif (pKmerStore == CANONICAL)
     template <typename Key>
     using MapParams = ::bliss::index::kmer::CanonicalHashMapParams<Key, DistHash, StoreHash>;
+    template <typename KmerType>
     using SpecialKeys = ::bliss::kmer::hash::sparsehash::special_keys<KmerType, true>;
   #elif (pKmerStore == BIMOLECULE)  // bimolecule
     template <typename Key>
     using MapParams = ::bliss::index::kmer::BimoleculeHashMapParams<Key, DistHash, StoreHash>;
+    template <typename KmerType>
     using SpecialKeys = ::bliss::kmer::hash::sparsehash::special_keys<KmerType, false>;
   #endif
 
@@ -266,6 +286,7 @@ using CountType = uint32_t;
 //
 //   #elif (pMAP == UNORDERED)
     #if (pMAP == UNORDERED)
+      template <typename KmerType>
       using MapType = ::dsc::unordered_multimap<
           KmerType, ValType, MapParams>;
 //    #elif (pMAP == COMPACTVEC)
@@ -275,14 +296,33 @@ using CountType = uint32_t;
 //      using MapType = ::dsc::unordered_multimap_hashvec<
 //          KmerType, ValType, MapParams>;
     #elif (pMAP == DENSEHASH)
+      template <typename KmerType>
       using MapType = ::dsc::densehash_multimap<
-          KmerType, ValType, MapParams, SpecialKeys>;
+          KmerType, ValType, MapParams, SpecialKeys<KmerType> >;
     #endif
   #elif (pINDEX == COUNT)  // map
     #if (pMAP == DENSEHASH)
+      template <typename KmerType>
       using MapType = ::dsc::counting_densehash_map<
-        KmerType, ValType, MapParams, SpecialKeys>;
+        KmerType, ValType, MapParams, SpecialKeys<KmerType> >;
+    #elif (pMAP == SOAHASH)
+      template <typename KmerType>
+      using MapType = ::dsc::counting_soa_hash_map<
+        KmerType, ValType, MapParams, SpecialKeys<KmerType> >;
+    #elif (pMAP == COMPACTCOUNT)
+      template <typename KmerType>
+      using MapType = ::dsc::compact_counting_map<
+        KmerType, ValType, MapParams, SpecialKeys<KmerType> >;
+    #elif (pMAP == CONCURRENTCOUNT)
+      template <typename KmerType>
+      using MapType = ::dsc::concurrent_counting_densehash_map<
+        KmerType, ValType, MapParams, SpecialKeys<KmerType> >;
+    #elif (pMAP == MPHFCOUNT)
+      template <typename KmerType>
+      using MapType = ::dsc::counting_mphf_map<
+        KmerType, ValType, MapParams, SpecialKeys<KmerType> >;
     #else
+      template <typename KmerType>
       using MapType = ::dsc::counting_unordered_map<
         KmerType, ValType, MapParams>;
     #endif
@@ -297,13 +337,16 @@ using CountType = uint32_t;
 //================ FINALLY, the actual index type.
 
 #if (pINDEX == POS)
-	using IndexType = bliss::index::kmer::PositionIndex<MapType>;
+	template <typename KmerType>
+	using KmerIndexType = bliss::index::kmer::PositionIndex<MapType<KmerType> >;
 
 #elif (pINDEX == POSQUAL)
-  using IndexType = bliss::index::kmer::PositionQualityIndex<MapType>;
+  template <typename KmerType>
+  using KmerIndexType = bliss::index::kmer::PositionQualityIndex<MapType<KmerType> >;
 
 #elif (pINDEX == COUNT)  // map
-	using IndexType = bliss::index::kmer::CountIndex<MapType>;
+	template <typename KmerType>
+	using KmerIndexType = bliss::index::kmer::CountIndex<MapType<KmerType> >;
 #endif
 
 
@@ -392,6 +435,137 @@ void sample(std::vector<KmerType> &query, size_t n, unsigned int seed, mxx::comm
 }
 
 
+/// build, save or load, and query the index for 1 k.  called through dispatch_kmer_size.
+struct run_benchmark {
+  template <typename KmerType>
+  int operator()(std::string const & filename, std::string const & queryname, int const sample_ratio, int const reader_algo,
+                 std::string const & save_prefix, std::string const & load_prefix, mxx::comm const & comm) const {
+    using IndexType = KmerIndexType<KmerType>;
+
+    // ================  read and get file
+    IndexType idx(comm);
+
+    BL_BENCH_INIT(test);
+
+    if (comm.rank() == 0) printf("reading query %s via posix\n", queryname.c_str());
+    BL_BENCH_START(test);
+    auto query = readForQuery_posix<IndexType>(queryname, comm);
+    BL_BENCH_COLLECTIVE_END(test, "read_query", query.size(), comm);
+
+    BL_BENCH_START(test);
+    sample(query, query.size() / sample_ratio, comm.rank(), comm);
+    BL_BENCH_COLLECTIVE_END(test, "sample", query.size(), comm);
+
+
+    if (!load_prefix.empty()) {
+	  if (comm.rank() == 0) printf("loading index %s\n", load_prefix.c_str());
+	  BL_BENCH_START(test);
+	  idx.load(load_prefix);
+	  BL_BENCH_COLLECTIVE_END(test, "load", idx.local_size(), comm);
+
+	  size_t total = idx.size();
+	  if (comm.rank() == 0) printf("total size after load is %lu\n", total);
+    } else {
+	  ::std::vector<typename IndexType::KmerParserType::value_type> temp;
+
+	  BL_BENCH_START(test);
+//	  if (reader_algo == 2)
+//	  {
+//		if (comm.rank() == 0) printf("reading %s via fileloader\n", filename.c_str());
+//
+//		idx.read_file<PARSER_TYPE, typename IndexType::KmerParserType>(filename, temp, comm);
+//
+//	  } else
+	  if (reader_algo == 5) {
+		if (comm.rank() == 0) printf("reading %s via mmap\n", filename.c_str());
+		::bliss::io::KmerFileHelper::read_file_mmap<typename IndexType::KmerParserType, PARSER_TYPE, bliss::io::SequencesIterator>(filename, temp, comm);
+
+	  } else if (reader_algo == 7) {
+		if (comm.rank() == 0) printf("reading %s via posix\n", filename.c_str());
+		::bliss::io::KmerFileHelper::read_file_posix<typename IndexType::KmerParserType, PARSER_TYPE, bliss::io::SequencesIterator>(filename, temp, comm);
+
+	  } else if (reader_algo == 10){
+		if (comm.rank() == 0) printf("reading %s via mpiio\n", filename.c_str());
+		::bliss::io::KmerFileHelper::read_file_mpiio<typename IndexType::KmerParserType, PARSER_TYPE, bliss::io::SequencesIterator>(filename, temp, comm);
+	  } else if (reader_algo == 11){
+		if (comm.rank() == 0) printf("reading %s via 1 reader per node\n", filename.c_str());
+		::bliss::io::KmerFileHelper::read_file_node_shared<typename IndexType::KmerParserType, PARSER_TYPE, bliss::io::SequencesIterator>(filename, temp, comm);
+	  } else {
+		throw std::invalid_argument("missing file reader type");
+	  }
+	  BL_BENCH_COLLECTIVE_END(test, "read", temp.size(), comm);
+
+	  size_t total = mxx::allreduce(temp.size(), comm);
+	  if (comm.rank() == 0) printf("total size is %lu\n", total);
+
+	  BL_BENCH_START(test);
+	  idx.insert(temp);
+	  BL_BENCH_COLLECTIVE_END(test, "insert", idx.local_size(), comm);
+
+      total = idx.size();
+      if (comm.rank() == 0) printf("total size after insert/rehash is %lu\n", total);
+    }
+
+    if (!save_prefix.empty()) {
+	  BL_BENCH_START(test);
+	  idx.save(save_prefix);
+	  BL_BENCH_COLLECTIVE_END(test, "save", idx.local_size(), comm);
+    }
+
+    {
+
+	  {
+		  auto lquery = query;
+		  BL_BENCH_START(test);
+		  auto counts = idx.count(lquery);
+		  BL_BENCH_COLLECTIVE_END(test, "count", counts.size(), comm);
+	  }
+	  {
+		  auto lquery = query;
+		  BL_BENCH_START(test);
+		  auto found = idx.find(lquery);
+		  BL_BENCH_COLLECTIVE_END(test, "find", found.size(), comm);
+	  }
+#if 0
+	  // separate test because of it being potentially very slow depending on imbalance.
+	  {
+		  auto lquery = query;
+
+	  BL_BENCH_START(test);
+	  auto found = idx.find_collective(lquery);
+	  BL_BENCH_COLLECTIVE_END(test, "find_collective", found.size(), comm);
+	  }
+	    {
+	      auto lquery = query;
+
+	    BL_BENCH_START(test);
+	    auto found = idx.find_overlap(lquery);
+	    BL_BENCH_COLLECTIVE_END(test, "find_overlap", found.size(), comm);
+	    }
+      // separate test because of it being potentially very slow depending on imbalance.
+      {
+        auto lquery = query;
+
+      BL_BENCH_START(test);
+      auto found = idx.find_sendrecv(lquery);
+      BL_BENCH_COLLECTIVE_END(test, "find_sendrecv", found.size(), comm);
+      }
+#endif
+
+	  BL_BENCH_START(test);
+	  idx.erase(query);
+	  BL_BENCH_COLLECTIVE_END(test, "erase", idx.local_size(), comm);
+
+    }
+
+  
+    BL_BENCH_REPORT_MPI_NAMED(test, "app", comm);
+
+    return 0;
+  }
+};
+
+
 /**
  *
  * @param argc
@@ -428,6 +602,9 @@ int main(int argc, char** argv) {
   int sample_ratio = 100;
 
   int reader_algo = -1;
+  std::string save_prefix;
+  std::string load_prefix;
+  unsigned int kmer_size = ::bliss::common::default_kmer_size<KmerSizes>();
   // Wrap everything in a try block.  Do this every time,
   // because exceptions will be thrown for problems.
   try {
@@ -447,7 +624,7 @@ int main(int argc, char** argv) {
     TCLAP::ValueArg<std::string> queryArg("Q", "query", "FASTQ file path for query. default to same file as index file", false, "", "string", cmd);
 
     TCLAP::ValueArg<int> algoArg("A",
-                                 "algo", "Reader Algorithm id. Fileloader w/o preload = 2, mmap = 5, posix=7, piio = 10. default is 7.",
+                                 "algo", "Reader Algorithm id. Fileloader w/o preload = 2, mmap = 5, posix=7, piio = 10, 1 reader per node = 11. default is 7.",
                                  false, 7, "int", cmd);
 
     TCLAP::ValueArg<int> sampleArg("S",
@@ -455,6 +632,13 @@ int main(int argc, char** argv) {
                                  false, sample_ratio, "int", cmd);
 
 
+    TCLAP::ValueArg<unsigned int> kArg("K", "kmer-size", "k.  compiled for " + ::bliss::common::supported_kmer_sizes<KmerSizes>() + ".  default is the first",
+                                       false, ::bliss::common::default_kmer_size<KmerSizes>(), "unsigned int", cmd);
+
+    TCLAP::ValueArg<std::string> saveArg("", "save", "save the built index to files with this prefix, one per rank", false, "", "string", cmd);
+    TCLAP::ValueArg<std::string> loadArg("", "load", "load a saved index with this prefix instead of building it.  requires the same number of processes", false, "", "string", cmd);
+
+
     // Parse the argv array.
     cmd.parse( argc, argv );
 
@@ -466,6 +650,9 @@ int main(int argc, char** argv) {
     filename = fileArg.getValue();
     reader_algo = algoArg.getValue();
     sample_ratio = sampleArg.getValue();
+    save_prefix = saveArg.getValue();
+    load_prefix = loadArg.getValue();
+    kmer_size = kArg.getValue();
 
     // set the default for query to filename, and reparse
 
@@ -479,115 +666,22 @@ int main(int argc, char** argv) {
     exit(-1);
   }
 
-
-
-
-
-  // ================  read and get file
-  IndexType idx(comm);
-
-  BL_BENCH_INIT(test);
-
-  if (comm.rank() == 0) printf("reading query %s via posix\n", queryname.c_str());
-  BL_BENCH_START(test);
-  auto query = readForQuery_posix<IndexType>(queryname, comm);
-  BL_BENCH_COLLECTIVE_END(test, "read_query", query.size(), comm);
-
-  BL_BENCH_START(test);
-  sample(query, query.size() / sample_ratio, comm.rank(), comm);
-  BL_BENCH_COLLECTIVE_END(test, "sample", query.size(), comm);
-
-
-  {
-	  ::std::vector<typename IndexType::KmerParserType::value_type> temp;
-
-	  BL_BENCH_START(test);
-//	  if (reader_algo == 2)
-//	  {
-//		if (comm.rank() == 0) printf("reading %s via fileloader\n", filename.c_str());
-//
-//		idx.read_file<PARSER_TYPE, typename IndexType::KmerParserType>(filename, temp, comm);
-//
-//	  } else
-	  if (reader_algo == 5) {
-		if (comm.rank() == 0) printf("reading %s via mmap\n", filename.c_str());
-		::bliss::io::KmerFileHelper::read_file_mmap<typename IndexType::KmerParserType, PARSER_TYPE, bliss::io::SequencesIterator>(filename, temp, comm);
-
-	  } else if (reader_algo == 7) {
-		if (comm.rank() == 0) printf("reading %s via posix\n", filename.c_str());
-		::bliss::io::KmerFileHelper::read_file_posix<typename IndexType::KmerParserType, PARSER_TYPE, bliss::io::SequencesIterator>(filename, temp, comm);
-
-	  } else if (reader_algo == 10){
-		if (comm.rank() == 0) printf("reading %s via mpiio\n", filename.c_str());
-		::bliss::io::KmerFileHelper::read_file_mpiio<typename IndexType::KmerParserType, PARSER_TYPE, bliss::io::SequencesIterator>(filename, temp, comm);
-	  } else {
-		throw std::invalid_argument("missing file reader type");
-	  }
-	  BL_BENCH_COLLECTIVE_END(test, "read", temp.size(), comm);
-
-	  size_t total = mxx::allreduce(temp.size(), comm);
-	  if (comm.rank() == 0) printf("total size is %lu\n", total);
-
-	  BL_BENCH_START(test);
-	  idx.insert(temp);
-	  BL_BENCH_COLLECTIVE_END(test, "insert", idx.local_size(), comm);
-
-    total = idx.size();
-    if (comm.rank() == 0) printf("total size after insert/rehash is %lu\n", total);
+  if (!::bliss::common::is_supported_kmer_size<KmerSizes>(kmer_size)) {
+    if (comm.rank() == 0) std::cerr << "error: k=" << kmer_size << " not compiled in.  available: " << ::bliss::common::supported_kmer_sizes<KmerSizes>() << std::endl;
+    exit(-1);
   }
 
-  {
-
-	  {
-		  auto lquery = query;
-		  BL_BENCH_START(test);
-		  auto counts = idx.count(lquery);
-		  BL_BENCH_COLLECTIVE_END(test, "count", counts.size(), comm);
-	  }
-	  {
-		  auto lquery = query;
-		  BL_BENCH_START(test);
-		  auto found = idx.find(lquery);
-		  BL_BENCH_COLLECTIVE_END(test, "find", found.size(), comm);
-	  }
-#if 0
-	  // separate test because of it being potentially very slow depending on imbalance.
-	  {
-		  auto lquery = query;
-
-	  BL_BENCH_START(test);
-	  auto found = idx.find_collective(lquery);
-	  BL_BENCH_COLLECTIVE_END(test, "find_collective", found.size(), comm);
-	  }
-	    {
-	      auto lquery = query;
-
-	    BL_BENCH_START(test);
-	    auto found = idx.find_overlap(lquery);
-	    BL_BENCH_COLLECTIVE_END(test, "find_overlap", found.size(), comm);
-	    }
-    // separate test because of it being potentially very slow depending on imbalance.
-    {
-      auto lquery = query;
 
-    BL_BENCH_START(test);
-    auto found = idx.find_sendrecv(lquery);
-    BL_BENCH_COLLECTIVE_END(test, "find_sendrecv", found.size(), comm);
-    }
-#endif
 
-	  BL_BENCH_START(test);
-	  idx.erase(query);
-	  BL_BENCH_COLLECTIVE_END(test, "erase", idx.local_size(), comm);
 
-  }
 
-  
-  BL_BENCH_REPORT_MPI_NAMED(test, "app", comm);
+  // ================  run for the chosen k
+  int ret = ::bliss::common::dispatch_kmer_size<KmerSizes, Alphabet, WordType>(kmer_size, run_benchmark(),
+      filename, queryname, sample_ratio, reader_algo, save_prefix, load_prefix, comm);
 
 
   // mpi cleanup is automatic
   comm.barrier();
 
-  return 0;
+  return ret;
 }
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    BenchmarkQueryReplay.cpp
+ * @ingroup
+ * @brief   replays a captured query trace against a canonical k-mer count index, and reports latency percentiles.
+ * @details the index is loaded from a saved index (-L, see Index::save) or built from a FASTQ file (-F), with the backend
+ *          of -I.  the trace (-T) is 1 file per rank, captured with Index::set_query_trace, e.g. on a query_server, with
+ *          the same number of ranks and k.  see index/query_trace.hpp.
+ *
+ *          the find rounds of the densehash and sorted backends are also reported per phase, with the rank
+ *          responsible for the tail, see containers/query_latency.hpp.
+ *
+ *          with -Q, a trace is first captured from the k-mers of a FASTQ file, in batches of -B k-mers per rank,
+ *          alternating find and count, so the replay can be tried without a production capture.
+ */
+
+#include "bliss-config.hpp"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdio>
+
+#include "utils/logging.h"
+
+#include "common/alphabets.hpp"
+#include "common/kmer.hpp"
+#include "common/kmer_dispatch.hpp"
+#include "io/sequence_iterator.hpp"
+#include "io/kmer_file_helper.hpp"
+#include "index/kmer_index.hpp"
+#include "index/index_selector.hpp"
+#include "index/query_trace.hpp"
+
+#include "tclap/CmdLine.h"
+
+#include "mxx/env.hpp"
+#include "mxx/comm.hpp"
+
+using KmerSizes = ::bliss::common::kmer_sizes<21, 31, 63>;
+
+
+/// options shared by all k and backends.
+struct replay_options {
+    std::string filename;
+    std::string index_prefix;
+    std::string trace_prefix;
+    std::string queryname;
+    size_t batch;
+};
+
+
+/// load or build an index of the given type, optionally capture a trace, and replay it.
+struct replay {
+    template <typename IndexType>
+    int operator()(replay_options const & opt, mxx::comm const & comm) const {
+      using KmerType = typename IndexType::KmerType;
+      using Parser = ::bliss::index::kmer::KmerParser<KmerType>;
+
+      IndexType idx(comm);
+      if (!opt.index_prefix.empty()) idx.load(opt.index_prefix);
+      else idx.template build_posix<::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(opt.filename, comm);
+
+      size_t total = idx.get_map().size();
+      if (comm.rank() == 0) printf("index: %lu distinct k-mers\n", total);
+
+      if (!opt.queryname.empty()) {
+        std::vector<KmerType> all;
+        ::bliss::io::KmerFileHelper::read_file_posix<Parser, ::bliss::io::FASTQParser, ::bliss::io::SequencesIterator>(opt.queryname, all, comm);
+
+        // same number of batches on all ranks, since find and count are collective.
+        size_t const step = std::max(opt.batch, static_cast<size_t>(1));
+        size_t batches = ::mxx::allreduce((all.size() + step - 1) / step, ::mxx::max<size_t>(), comm);
+
+        idx.set_query_trace(opt.trace_prefix);
+        std::vector<KmerType> query;
+        for (size_t i = 0; i < batches; ++i) {
+          size_t b = std::min(i * step, all.size());
+          size_t e = std::min(b + step, all.size());
+          query.assign(all.begin() + b, all.begin() + e);
+          if (i % 2 == 0) idx.find(query);
+          else idx.count(query);
+        }
+        size_t captured = idx.get_query_trace_batches();
+        idx.set_query_trace("");
+        if (comm.rank() == 0) printf("captured %lu batches of up to %lu k-mers per rank to %s\n", captured, step, opt.trace_prefix.c_str());
+      }
+
+      idx.get_map().set_query_latency(true);
+      std::vector<::bliss::index::query_replay_stats> stats = ::bliss::index::replay_query_trace(idx, opt.trace_prefix, comm);
+      ::fsc::query_latency_stats rounds = idx.get_map().get_query_latency();
+      idx.get_map().set_query_latency(false);
+      if (comm.rank() == 0) {
+        for (auto const & s : stats) {
+          if (s.batches == 0) continue;
+          printf("replay %s: %lu batches, %lu keys, total %.6f s, latency p50 %.6f p90 %.6f p99 %.6f max %.6f s, captured p50 %.6f p99 %.6f s\n",
+                 ::bliss::index::query_trace_op_name(s.op).c_str(), s.batches, s.keys, s.total,
+                 s.p50, s.p90, s.p99, s.max, s.captured_p50, s.captured_p99);
+        }
+        if (rounds.rounds > 0) {
+          printf("find rounds of all ranks: %lu, latency p50 %.6f p90 %.6f p99 %.6f max %.6f s\n",
+                 rounds.rounds, rounds.p50, rounds.p90, rounds.p99, rounds.max);
+          printf("tail rank %d: local work p99 %.6f s, slowest round bucketing %.6f exchange %.6f lookup %.6f reply %.6f s\n",
+                 rounds.tail_rank, rounds.tail_work_p99, rounds.tail_phases[0], rounds.tail_phases[1],
+                 rounds.tail_phases[2], rounds.tail_phases[3]);
+        }
+      }
+      return 0;
+    }
+};
+
+
+struct run_replay {
+    template <typename KmerType>
+    int operator()(replay_options const & opt, ::bliss::index::kmer::CountBackend const & b, mxx::comm const & comm) const {
+      return ::bliss::index::kmer::dispatch_count_backend<KmerType>(b, replay(), opt, comm);
+    }
+};
+
+
+int main(int argc, char** argv) {
+
+  LOG_INIT();
+
+  mxx::env e(argc, argv);
+  mxx::comm comm;
+
+  if (comm.rank() == 0) printf("EXECUTING %s\n", argv[0]);
+
+  replay_options opt;
+  opt.filename.assign(PROJ_SRC_DIR);
+  opt.filename.append("/test/data/test.small.fastq");
+  opt.batch = 10000;
+  std::string backend("densehash");
+  unsigned int kmer_size = ::bliss::common::default_kmer_size<KmerSizes>();
+
+  try {
+    TCLAP::CmdLine cmd("Replay a captured k-mer query trace and report latency percentiles", ' ', "0.1");
+
+    TCLAP::ValueArg<std::string> fileArg("F", "file", "FASTQ file path to build the index from", false, opt.filename, "string", cmd);
+    TCLAP::ValueArg<std::string> loadArg("L", "load", "prefix of a saved index to load instead of building", false, "", "string", cmd);
+    TCLAP::ValueArg<std::string> traceArg("T", "trace", "query trace prefix, 1 file per rank", true, "", "string", cmd);
+    TCLAP::ValueArg<std::string> queryArg("Q", "query", "FASTQ file path to capture a trace from first. default none", false, "", "string", cmd);
+    TCLAP::ValueArg<size_t> batchArg("B", "batch", "k-mers per rank per batch for -Q. default=10000", false, opt.batch, "size_t", cmd);
+    TCLAP::ValueArg<unsigned int> kArg("K", "kmer-size", "k.  compiled for " + ::bliss::common::supported_kmer_sizes<KmerSizes>() + ".  default is the first",
+                                       false, kmer_size, "unsigned int", cmd);
+    TCLAP::ValueArg<std::string> backendArg("I", "index", "backend:  densehash, sorted, or counting.  as saved, for -L. default=densehash", false, backend, "string", cmd);
+
+    cmd.parse(argc, argv);
+
+    opt.filename = fileArg.getValue();
+    opt.index_prefix = loadArg.getValue();
+    opt.trace_prefix = traceArg.getValue();
+    opt.queryname = queryArg.getValue();
+    opt.batch = batchArg.getValue();
+    kmer_size = kArg.getValue();
+    backend = backendArg.getValue();
+
+  } catch (TCLAP::ArgException &e)  // catch any exceptions
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(-1);
+  }
+
+  ::bliss::index::kmer::CountBackend b;
+  try {
+    b = ::bliss::index::kmer::parse_count_backend(backend);
+  } catch (std::invalid_argument const & e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    exit(-1);
+  }
+
+  if (!::bliss::common::is_supported_kmer_size<KmerSizes>(kmer_size)) {
+    if (comm.rank() == 0) std::cerr << "error: k=" << kmer_size << " not compiled in.  available: " << ::bliss::common::supported_kmer_sizes<KmerSizes>() << std::endl;
+    exit(-1);
+  }
+
+  int ret = ::bliss::common::dispatch_kmer_size<KmerSizes, ::bliss::common::DNA, WordType>(kmer_size, run_replay(), opt, b, comm);
+
+  comm.barrier();
+
+  return ret;
+}
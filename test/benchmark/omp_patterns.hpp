@@ -31,7 +31,10 @@
 #include <omp.h>
 #endif
 
+#include <vector>
+
 #include "partition/range.hpp"
+#include "utils/task_pool.hpp"
 typedef bliss::partition::range<size_t> RangeType;
 
 
@@ -299,6 +302,36 @@ OT ParFor(OP &op, const int &nthreads, size_t &_count) {
 }
 
 
+/// the same chunks as MasterSlave, on the persistent task pool.  the per thread results are kept between calls.
+template<typename OP, typename OT>
+OT Pool(OP &op, const int &nthreads, size_t &_count) {
+
+  static std::vector<OT> v;
+  static std::vector<size_t> counts;
+  v.assign(nthreads, 0);
+  counts.assign(nthreads, 0);
+
+  RangeType r = op.getRange();
+  size_t step = op.getChunkSize();
+  size_t nchunks = (r.end - r.start + step - 1) / step;
+
+  bliss::utils::task_pool::instance().parallel_for(nchunks, [&op](size_t first, size_t last, int tid) {
+    for (size_t i = first; i < last; ++i) {
+      op(tid, counts[tid], v[tid]);
+    }
+  }, nthreads, 1);
+
+  OT vo = 0;
+  size_t count = 0;
+  for (int i = 0; i < nthreads; ++i) {
+    vo += v[i];
+    count += counts[i];
+  }
+  _count = count;
+  return vo;
+}
+
+
 template<typename OP, typename OT>
 OT Sequential(OP &op, const int &nthreads, size_t &_count) {
 
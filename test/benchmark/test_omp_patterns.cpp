@@ -183,6 +183,24 @@ int main(int argc, char* argv[])
   if (rank == 0)
     printTiming("PARFOR:\t", rank, nprocs, nthreads, time_span, iter, v, count);
 
+  /// persistent task pool
+#if defined(USE_MPI)
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+  t1 = std::chrono::high_resolution_clock::now();
+  count = 0;
+  for (int i = 0; i < iter; ++i)
+    v = Pool<compute<double>, double>(op, nthreads, count);
+#if defined(USE_MPI)
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+  t2 = std::chrono::high_resolution_clock::now();
+  time_span =
+      std::chrono::duration_cast<std::chrono::duration<double>>(
+          t2 - t1);
+  if (rank == 0)
+    printTiming("POOL:\t", rank, nprocs, nthreads, time_span, iter, v, count);
+
   //// serial for
 #if defined(USE_MPI)
   MPI_Barrier(MPI_COMM_WORLD);
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2015 Georgia Institute of Technology
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * bench_compare.cpp
+ *   compare a benchmark sink file (BL_BENCH_FILE output) against a baseline, see utils/benchmark_baseline.hpp.
+ *   prints the regressions, and exits with 1 if there are any.  used by perf_suite.sh.
+ */
+
+#include <cstdio>
+#include <cstdlib>  // strtod
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#include "tclap/CmdLine.h"
+
+#include "utils/benchmark_baseline.hpp"
+
+
+int main(int argc, char** argv) {
+
+  std::string baseline, current;
+  ::plog::BenchBaseline::options opt;
+  bool all = false;
+
+  try {
+    TCLAP::CmdLine cmd("Compare benchmark results against a baseline", ' ', "0.1");
+
+    TCLAP::UnlabeledValueArg<std::string> baseArg("baseline", "baseline sink file", true, "", "string", cmd);
+    TCLAP::UnlabeledValueArg<std::string> currArg("current", "current sink file", true, "", "string", cmd);
+    TCLAP::ValueArg<double> timeArg("t", "time-tolerance", "allowed slowdown of time and throughput, as a fraction. default=0.10",
+                                    false, opt.time_tolerance, "double", cmd);
+    TCLAP::ValueArg<double> memArg("m", "mem-tolerance", "allowed growth of peak memory, as a fraction. default=0.05",
+                                   false, opt.mem_tolerance, "double", cmd);
+    TCLAP::ValueArg<double> secArg("s", "min-seconds", "shorter durations are not judged. default=0.01",
+                                   false, opt.min_seconds, "double", cmd);
+    TCLAP::ValueArg<double> byteArg("b", "min-bytes", "smaller memory peaks are not judged. default=1MB",
+                                    false, opt.min_bytes, "double", cmd);
+    TCLAP::SwitchArg allArg("a", "all", "print all compared rows, not only the regressions", cmd, false);
+
+    cmd.parse(argc, argv);
+
+    baseline = baseArg.getValue();
+    current = currArg.getValue();
+    opt.time_tolerance = timeArg.getValue();
+    opt.mem_tolerance = memArg.getValue();
+    opt.min_seconds = secArg.getValue();
+    opt.min_bytes = byteArg.getValue();
+    all = allArg.getValue();
+
+  } catch (TCLAP::ArgException &e)  // catch any exceptions
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    exit(2);
+  }
+
+  std::vector<::plog::BenchBaseline::diff> diffs;
+  try {
+    diffs = ::plog::BenchBaseline::compare(::plog::BenchBaseline::read(baseline), ::plog::BenchBaseline::read(current), opt);
+  } catch (std::exception const & e) {
+    std::cerr << e.what() << std::endl;
+    exit(2);
+  }
+
+  std::cout << ::plog::BenchBaseline::report(diffs, all);
+
+  size_t regressions = ::plog::BenchBaseline::count_regressions(diffs);
+  size_t judged = 0;
+  for (auto const & d : diffs) judged += d.judged ? 1 : 0;
+  printf("%lu compared, %lu judged, %lu regressions (time tolerance %.0f%%, memory tolerance %.0f%%)\n",
+         diffs.size(), judged, regressions, opt.time_tolerance * 100.0, opt.mem_tolerance * 100.0);
+
+  return (regressions > 0) ? 1 : 0;
+}
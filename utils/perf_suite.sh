@@ -0,0 +1,183 @@
+#!/bin/bash
+#
+# Copyright 2015 Georgia Institute of Technology
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# perf_suite.sh
+#   end to end performance regression suite.  runs a fixed set of benchmarks with BL_BENCH_FILE set, so that
+#   every phase report is appended to 1 JSON lines file, then compares that file to a stored baseline with
+#   bench_compare (see src/utils/benchmark_baseline.hpp).  exits with 1 if any phase regressed.
+#
+#   the gtest benchmarks do not report to the sink.  for those the whole binary is timed with /usr/bin/time, and
+#   its wall time and peak RSS are written as sink rows (title "suite", phase = binary name).  without GNU time
+#   only the wall time is recorded.
+#
+#   a baseline is only meaningful on the machine it was made on.  make one with --update-baseline.
+#
+# usage:  perf_suite.sh [options]
+#   -b DIR    build directory.  default ./build
+#   -B FILE   baseline.  default DIR/perf/baseline.jsonl
+#   -o FILE   output of this run.  default DIR/perf/current.jsonl
+#   -n NP     MPI ranks.  default 4
+#   -r R      repeats of each run.  the compare uses the median.  default 3
+#   -s        small:  skip the large generated inputs
+#   -t TOL    time tolerance, fraction.  default 0.10
+#   -m TOL    memory tolerance, fraction.  default 0.05
+#   -u, --update-baseline    save this run as the baseline instead of comparing
+#
+
+set -o pipefail
+
+SRC_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=./build
+BASELINE=
+OUTPUT=
+NP=4
+REPEATS=3
+SMALL=0
+UPDATE=0
+TIME_TOL=0.10
+MEM_TOL=0.05
+
+while [ $# -gt 0 ]; do
+  case "$1" in
+    -b) BUILD_DIR=$2; shift ;;
+    -B) BASELINE=$2; shift ;;
+    -o) OUTPUT=$2; shift ;;
+    -n) NP=$2; shift ;;
+    -r) REPEATS=$2; shift ;;
+    -s) SMALL=1 ;;
+    -t) TIME_TOL=$2; shift ;;
+    -m) MEM_TOL=$2; shift ;;
+    -u|--update-baseline) UPDATE=1 ;;
+    -h|--help) sed -n '/^# usage/,/^$/p' "$0"; exit 0 ;;
+    *) echo "unknown option $1" >&2; exit 2 ;;
+  esac
+  shift
+done
+
+BIN=${BUILD_DIR}/bin
+TEST_BIN=${BUILD_DIR}/test
+PERF_DIR=${BUILD_DIR}/perf
+BASELINE=${BASELINE:-${PERF_DIR}/baseline.jsonl}
+OUTPUT=${OUTPUT:-${PERF_DIR}/current.jsonl}
+DATA=${SRC_DIR}/test/data
+LOG=${PERF_DIR}/perf_suite.log
+
+MPIRUN=${MPIRUN:-mpirun}
+TIME=/usr/bin/time
+
+mkdir -p "${PERF_DIR}"
+rm -f "${OUTPUT}"
+: > "${LOG}"
+export BL_BENCH_FILE=${OUTPUT}
+
+FAILED=0
+
+# run a sink instrumented binary.  $1 is the rank count, the rest is the command.
+run_mpi() {
+  local np=$1; shift
+  if [ ! -x "$1" ]; then echo "skip: $1 not built" | tee -a "${LOG}"; return; fi
+  echo "run: np=${np} $*" | tee -a "${LOG}"
+  ${MPIRUN} -np "${np}" "$@" >> "${LOG}" 2>&1 || { echo "FAILED: $*" | tee -a "${LOG}"; FAILED=1; }
+}
+
+# run a binary that does not report to the sink, and append its wall time and peak RSS as sink rows.
+# $1 is the rank count (0 for a serial binary), $2 the phase name, the rest is the command.
+run_timed() {
+  local np=$1 phase=$2; shift 2
+  if [ ! -x "$1" ]; then echo "skip: $1 not built" | tee -a "${LOG}"; return; fi
+  echo "run: np=${np} $*" | tee -a "${LOG}"
+  local tfile=${PERF_DIR}/time.$$
+  local ranks=${np} launch=
+  if [ "${np}" -eq 0 ]; then
+    ranks=1
+  else
+    # per rank peak RSS is not visible from outside, so this is the launcher's.  wall time is that of the job.
+    launch="${MPIRUN} -np ${np}"
+  fi
+  local status secs kb=
+  if [ -x "${TIME}" ]; then
+    ${TIME} -f "%e %M" -o "${tfile}" ${launch} "$@" >> "${LOG}" 2>&1
+    status=$?
+    # %M is in KB.  with -o, a failing command prepends a status line, so take the last line.
+    [ ${status} -eq 0 ] && read -r secs kb < <(tail -n 1 "${tfile}")
+    rm -f "${tfile}"
+  else
+    # no GNU time:  wall time only.
+    local t0=$(date +%s.%N)
+    ${launch} "$@" >> "${LOG}" 2>&1
+    status=$?
+    secs=$(echo "$(date +%s.%N) ${t0}" | awk '{ printf "%.3f", $1 - $2 }')
+  fi
+  if [ ${status} -ne 0 ]; then echo "FAILED: $*" | tee -a "${LOG}"; FAILED=1; return; fi
+
+  echo "{\"title\":\"suite\",\"kind\":\"time\",\"index\":0,\"phase\":\"${phase}\",\"metric\":\"dur_s\",\"ranks\":${ranks},\"min\":${secs},\"max\":${secs},\"mean\":${secs},\"stdev\":0}" >> "${OUTPUT}"
+  if [ -n "${kb}" ]; then
+    local bytes=$(( kb * 1024 ))
+    echo "{\"title\":\"suite\",\"kind\":\"mem\",\"index\":0,\"phase\":\"${phase}\",\"metric\":\"peak_bytes\",\"ranks\":${ranks},\"min\":${bytes},\"max\":${bytes},\"mean\":${bytes},\"stdev\":0}" >> "${OUTPUT}"
+  fi
+}
+
+# inputs.  the large ones are copies of the medium file, made once.
+INPUTS="${DATA}/natural.fastq ${DATA}/test.medium.fastq"
+if [ ${SMALL} -eq 0 ]; then
+  LARGE=${PERF_DIR}/large.fastq
+  if [ ! -f "${LARGE}" ]; then
+    for i in $(seq 1 64); do cat "${DATA}/test.medium.fastq"; done > "${LARGE}"
+  fi
+  INPUTS="${INPUTS} ${LARGE}"
+fi
+
+KMER_INDEX="testKmerIndex-FASTQ-a4-k31-CANONICAL-DENSEHASH-COUNT-dtIDEN-dhFARM-shFARM
+testKmerIndex-FASTQ-a4-k31-CANONICAL-SORTED-COUNT-dtXXXX-dhYYYY-shZZZZ
+testKmerIndex-FASTQ-a4-k31-CANONICAL-DENSEHASH-POS-dtIDEN-dhFARM-shFARM"
+
+for r in $(seq 1 "${REPEATS}"); do
+  echo "=== repeat ${r} of ${REPEATS}" | tee -a "${LOG}"
+
+  for exe in ${KMER_INDEX}; do
+    for f in ${INPUTS}; do
+      run_mpi "${NP}" "${BIN}/${exe}" -F "${f}"
+    done
+  done
+  for f in ${INPUTS}; do
+    run_mpi "${NP}" "${BIN}/benchmark_auto_index" -F "${f}"
+  done
+
+  run_mpi "${NP}" "${BIN}/benchmark_hashtables"
+  run_mpi "${NP}" "${BIN}/benchmark_distributed_maps" -n 1000000
+
+  run_timed 0 benchmark-bliss-io "${TEST_BIN}/benchmark-bliss-io"
+  run_timed 0 benchmark-bliss-utils "${TEST_BIN}/benchmark-bliss-utils"
+  run_timed "${NP}" benchmark-mpi-bliss-io-distribute "${TEST_BIN}/benchmark-mpi-bliss-io-distribute"
+done
+
+if [ ${FAILED} -ne 0 ]; then
+  echo "some benchmarks failed, see ${LOG}"
+  exit 2
+fi
+
+if [ ${UPDATE} -eq 1 ]; then
+  cp "${OUTPUT}" "${BASELINE}"
+  echo "baseline saved to ${BASELINE}"
+  exit 0
+fi
+
+if [ ! -f "${BASELINE}" ]; then
+  echo "no baseline at ${BASELINE}.  run with --update-baseline first."
+  exit 2
+fi
+
+"${BIN}/bench_compare" -t "${TIME_TOL}" -m "${MEM_TOL}" "${BASELINE}" "${OUTPUT}"
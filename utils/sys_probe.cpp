@@ -31,7 +31,11 @@
 #include <sys/sysinfo.h>
 #include <sys/types.h>
 
+#include <string>
+#include <vector>
+
 #include "utils/logging.h"
+#include "utils/numa_utils.hpp"
 
 inline unsigned long get_free_mem() {
 	struct sysinfo memInfo;
@@ -98,6 +102,27 @@ int checkMainMem()
   return 0;
 }
 
+int checkNuma()
+{
+  std::vector<int> nodes = ::bliss::utils::numa::nodes();
+  BL_WARNINGF("%lu NUMA nodes.  main thread on node %d\n", nodes.size(), ::bliss::utils::numa::current_node());
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    std::string path = "/sys/devices/system/node/node" + std::to_string(nodes[i]);
+    std::vector<int> cpus = ::bliss::utils::numa::node_cpus(nodes[i]);
+    std::string cpulist = ::bliss::utils::numa::detail::read_line(path + "/cpulist");
+    std::string mem = ::bliss::utils::numa::detail::read_line(path + "/meminfo");   // first line is MemTotal
+
+    BL_WARNINGF("node %d: %lu cpus [%s]  %s\n", nodes[i], cpus.size(), cpulist.c_str(), mem.c_str());
+
+    USED_BY_LOGGER_ONLY(cpus);
+    USED_BY_LOGGER_ONLY(cpulist);
+    USED_BY_LOGGER_ONLY(mem);
+  }
+
+  return 0;
+}
+
 int checkMPIBuffer()
 {
   BL_WARNINGF("MPI tests not yet implemented\n");
@@ -249,6 +274,7 @@ int main(int argc, char* argv[])
 
   checkNProcs();
   checkMainMem();
+  checkNuma();
   checkFileSystem();
 
   checkMPIBuffer();